@@ -593,27 +593,32 @@ class MakeBundle {
 		}
 	}
 
-	static void WriteSymbol (StreamWriter sw, string name, long size)
+	// Uncompressed assemblies are page aligned, the runtime uses them in place
+	// (mono_image_open_from_data_with_name without copying), so their pages are
+	// demand-loaded from the executable and shared instead of copied to the heap
+	const int page_align_log2 = 12;
+
+	static void WriteSymbol (StreamWriter sw, string name, long size, bool page_align = false)
 	{
 		switch (style){
 		case "linux":
 			sw.WriteLine (
 				".globl {0}\n" +
 				"\t.section .rodata\n" +
-				"\t.p2align 5\n" +
+				"\t.p2align {2}\n" +
 				"\t.type {0}, \"object\"\n" +
 				"\t.size {0}, {1}\n" +
 				"{0}:\n",
-				name, size);
+				name, size, page_align ? page_align_log2 : 5);
 			break;
 		case "osx":
 			sw.WriteLine (
 				"\t.section __TEXT,__text,regular,pure_instructions\n" + 
 				"\t.globl _{0}\n" +
 				"\t.data\n" +
-				"\t.align 4\n" +
+				"\t.align {2}\n" +
 				"_{0}:\n",
-				name, size);
+				name, size, page_align ? page_align_log2 : 4);
 			break;
 		case "windows":
 			string mangled_symbol_name = "";
@@ -625,9 +630,9 @@ class MakeBundle {
 			sw.WriteLine (
 				".globl {0}\n" +
 				"\t.section .rdata,\"dr\"\n" +
-				"\t.align 32\n" +
+				"\t.align {1}\n" +
 				"{0}:\n",
-				mangled_symbol_name);
+				mangled_symbol_name, page_align ? 1 << page_align_log2 : 32);
 			break;
 		}
 	}
@@ -970,7 +975,7 @@ typedef struct {
 				if (!quiet)
 					Console.WriteLine ("   embedding: " + fname);
 
-				WriteSymbol (ts, "assembly_data_" + encoded, stream.Length);
+				WriteSymbol (ts, "assembly_data_" + encoded, stream.Length, !compress);
 			
 				WriteBuffer (ts, stream, buffer);
 
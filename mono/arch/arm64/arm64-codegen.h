@@ -440,6 +440,19 @@ arm_encode_imm7 (int imm, int size)
 #define arm_stlxrx(p, rs, rt, rn) arm_format_stlxr ((p), 0x3, (rs), (rn), (rt))
 #define arm_stlxrw(p, rs, rt, rn) arm_format_stlxr ((p), 0x2, (rs), (rn), (rt))
 
+/* ARMv8.1 LSE atomics, with acquire + release semantics */
+#define arm_format_ldop(p, size, A, R, o3, opc, rs, rt, rn) arm_emit ((p), ((size) << 30) | (0x38 << 24) | ((A) << 23) | ((R) << 22) | (0x1 << 21) | ((rs) << 16) | ((o3) << 15) | ((opc) << 12) | ((rn) << 5) | ((rt) << 0))
+
+#define arm_ldaddalx(p, rs, rt, rn) arm_format_ldop ((p), ARMSIZE_X, 0x1, 0x1, 0x0, 0x0, (rs), (rt), (rn))
+#define arm_ldaddalw(p, rs, rt, rn) arm_format_ldop ((p), ARMSIZE_W, 0x1, 0x1, 0x0, 0x0, (rs), (rt), (rn))
+#define arm_swpalx(p, rs, rt, rn) arm_format_ldop ((p), ARMSIZE_X, 0x1, 0x1, 0x1, 0x0, (rs), (rt), (rn))
+#define arm_swpalw(p, rs, rt, rn) arm_format_ldop ((p), ARMSIZE_W, 0x1, 0x1, 0x1, 0x0, (rs), (rt), (rn))
+
+#define arm_format_cas(p, size, L, o0, rs, rt, rn) arm_emit ((p), ((size) << 30) | (0x8 << 24) | (0x1 << 23) | ((L) << 22) | (0x1 << 21) | ((rs) << 16) | ((o0) << 15) | (0x1f << 10) | ((rn) << 5) | ((rt) << 0))
+
+#define arm_casalx(p, rs, rt, rn) arm_format_cas ((p), ARMSIZE_X, 0x1, 0x1, (rs), (rt), (rn))
+#define arm_casalw(p, rs, rt, rn) arm_format_cas ((p), ARMSIZE_W, 0x1, 0x1, (rs), (rt), (rn))
+
 /* Load/Store SIMD&FP */
 
 /* C6.3.285 STR (immediate, SIMD&FP) */
@@ -0,0 +1,54 @@
+using System;
+
+//
+// Allocation throughput of small objects, arrays and strings that die in the nursery
+//
+public class AllocRate {
+
+	class Node {
+		public Node next;
+		public int value;
+	}
+
+	const int N = 1000000;
+
+	static object sink;
+
+	public static int Main (string[] args) {
+		Bench.Init (args);
+
+		Bench.Run ("alloc-rate/object", N, () => {
+			Node n = null;
+			for (int i = 0; i < N; ++i)
+				n = new Node { value = i };
+			sink = n;
+		});
+
+		Bench.Run ("alloc-rate/list", N, () => {
+			Node head = null;
+			for (int i = 0; i < N; ++i) {
+				head = new Node { next = head, value = i };
+				/* Keep the lists short so the survivors don't dominate */
+				if ((i & 1023) == 0)
+					head = null;
+			}
+			sink = head;
+		});
+
+		Bench.Run ("alloc-rate/array", N, () => {
+			byte[] a = null;
+			for (int i = 0; i < N; ++i)
+				a = new byte [i & 127];
+			sink = a;
+		});
+
+		Bench.Run ("alloc-rate/string", N / 10, () => {
+			string s = null;
+			for (int i = 0; i < N / 10; ++i)
+				s = i.ToString ();
+			sink = s;
+		});
+
+		return 0;
+	}
+}
@@ -0,0 +1,73 @@
+using System;
+using System.Collections.Generic;
+using System.IO;
+
+//
+// Compares two result files written by run-benchmarks.sh and reports every
+// benchmark whose p50 got slower by more than the threshold (10% by default).
+//
+// Usage: compare-benchmarks.exe BASELINE.jsonl CURRENT.jsonl [THRESHOLD_PERCENT]
+//
+// Returns 1 if anything regressed, so it can gate a CI job.
+//
+public class CompareBenchmarks {
+
+	static Dictionary<string, Dictionary<string, string>> Load (string file)
+	{
+		var res = new Dictionary<string, Dictionary<string, string>> ();
+
+		foreach (string line in File.ReadAllLines (file)) {
+			var fields = Bench.ParseLine (line);
+			if (fields == null || !fields.ContainsKey ("benchmark"))
+				continue;
+			res [fields ["benchmark"] + " (" + fields ["mode"] + ")"] = fields;
+		}
+		return res;
+	}
+
+	public static int Main (string[] args) {
+		if (args.Length < 2) {
+			Console.Error.WriteLine ("Usage: compare-benchmarks.exe BASELINE.jsonl CURRENT.jsonl [THRESHOLD_PERCENT]");
+			return 2;
+		}
+
+		double threshold = args.Length > 2 ? Double.Parse (args [2]) : 10;
+		var baseline = Load (args [0]);
+		var current = Load (args [1]);
+		int regressions = 0;
+
+		foreach (var kv in current) {
+			Dictionary<string, string> old;
+			if (!baseline.TryGetValue (kv.Key, out old)) {
+				Console.WriteLine ("{0,-45} new", kv.Key);
+				continue;
+			}
+
+			double before = Double.Parse (old ["p50_ns"]);
+			double after = Double.Parse (kv.Value ["p50_ns"]);
+			double change = before > 0 ? (after - before) * 100 / before : 0;
+			long alloc_before = Int64.Parse (old ["alloc_bytes"]);
+			long alloc_after = Int64.Parse (kv.Value ["alloc_bytes"]);
+
+			string verdict = "";
+			if (change > threshold) {
+				verdict = "REGRESSION";
+				regressions++;
+			} else if (change < -threshold) {
+				verdict = "improvement";
+			}
+			if (alloc_after > alloc_before)
+				verdict += (verdict.Length > 0 ? ", " : "") + "allocates more";
+
+			Console.WriteLine ("{0,-45} {1,14:N0} -> {2,14:N0} ns {3,7:+0.0;-0.0}%  {4}", kv.Key, before, after, change, verdict);
+		}
+
+		foreach (var key in baseline.Keys) {
+			if (!current.ContainsKey (key))
+				Console.WriteLine ("{0,-45} missing", key);
+		}
+
+		Console.WriteLine ("{0} regression(s) above {1}%.", regressions, threshold);
+		return regressions > 0 ? 1 : 0;
+	}
+}
@@ -0,0 +1,71 @@
+using System;
+using System.Runtime.CompilerServices;
+
+//
+// Throwing and catching exceptions, in the same frame and through a deep stack
+//
+public class Exceptions {
+
+	const int N = 10000;
+	const int DEPTH = 50;
+
+	static readonly Exception cached = new InvalidOperationException ();
+	static int caught;
+
+	[MethodImpl (MethodImplOptions.NoInlining)]
+	static void Recurse (int depth)
+	{
+		if (depth == 0)
+			throw cached;
+		Recurse (depth - 1);
+	}
+
+	public static int Main (string[] args) {
+		Bench.Init (args);
+
+		Bench.Run ("exceptions/local", N, () => {
+			for (int i = 0; i < N; ++i) {
+				try {
+					throw cached;
+				} catch (InvalidOperationException) {
+					caught++;
+				}
+			}
+		});
+
+		Bench.Run ("exceptions/new", N, () => {
+			for (int i = 0; i < N; ++i) {
+				try {
+					throw new InvalidOperationException ();
+				} catch (InvalidOperationException) {
+					caught++;
+				}
+			}
+		});
+
+		Bench.Run ("exceptions/deep", N / 10, () => {
+			for (int i = 0; i < N / 10; ++i) {
+				try {
+					Recurse (DEPTH);
+				} catch (InvalidOperationException) {
+					caught++;
+				}
+			}
+		});
+
+		Bench.Run ("exceptions/finally", N / 10, () => {
+			for (int i = 0; i < N / 10; ++i) {
+				try {
+					try {
+						Recurse (DEPTH);
+					} finally {
+						caught++;
+					}
+				} catch (InvalidOperationException) {
+				}
+			}
+		});
+
+		return 0;
+	}
+}
@@ -0,0 +1,76 @@
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+
+//
+// Collector pause times.  Minor collections are measured with a nursery full of
+// garbage and a set of old objects pointing to young ones, major collections with
+// a live heap of a few hundred MB of small objects.
+//
+public class GCPause {
+
+	class Node {
+		public Node left, right;
+		public object payload;
+	}
+
+	static Node old_root;
+	static List<Node> old_list;
+	static object sink;
+
+	static Node MakeTree (int depth)
+	{
+		if (depth == 0)
+			return new Node ();
+		return new Node { left = MakeTree (depth - 1), right = MakeTree (depth - 1) };
+	}
+
+	static long ElapsedNs (long start)
+	{
+		return (long) ((Stopwatch.GetTimestamp () - start) * (1e9 / Stopwatch.Frequency));
+	}
+
+	static void Churn (int n)
+	{
+		for (int i = 0; i < n; ++i)
+			sink = new byte [64];
+	}
+
+	public static int Main (string[] args) {
+		Bench.Init (args);
+
+		old_list = new List<Node> ();
+		for (int i = 0; i < 100000; ++i)
+			old_list.Add (new Node ());
+		GC.Collect ();
+
+		long[] samples = new long [Bench.Iterations];
+		for (int i = 0; i < samples.Length; ++i) {
+			Churn (100000);
+			/* Old to young references the minor collection has to scan */
+			for (int j = 0; j < old_list.Count; j += 10)
+				old_list [j].payload = new object ();
+
+			long start = Stopwatch.GetTimestamp ();
+			GC.Collect (0);
+			samples [i] = ElapsedNs (start);
+		}
+		Bench.Report ("gc-pause/minor", 1, samples, 0);
+
+		old_root = MakeTree (20);
+		GC.Collect ();
+
+		samples = new long [Math.Max (Bench.Iterations / 5, 1)];
+		for (int i = 0; i < samples.Length; ++i) {
+			Churn (100000);
+
+			long start = Stopwatch.GetTimestamp ();
+			GC.Collect ();
+			samples [i] = ElapsedNs (start);
+		}
+		Bench.Report ("gc-pause/major", 1, samples, 0);
+
+		GC.KeepAlive (old_root);
+		return 0;
+	}
+}
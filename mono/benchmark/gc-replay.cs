@@ -0,0 +1,139 @@
+using System;
+using System.Collections.Generic;
+using System.Globalization;
+using System.IO;
+using System.Runtime.InteropServices;
+
+//
+// Re-executes the allocations and pointer stores of a replay trace, written by
+// `sgen-grep-binprot --export-replay` from a binary protocol log, so a program's
+// heap behaviour can be measured under different collector configurations
+// without the program.  tools/sgen/sgen-replay.py runs it with a set of
+// MONO_GC_PARAMS and summarizes the pause times.
+//
+// Usage: gc-replay.exe TRACE [harness options]
+//
+// Objects with references are replayed as object arrays and the others as byte
+// arrays, both of the traced size.  Everything runs on one thread, whatever the
+// number of threads in the traced program.
+//
+public class GCReplay {
+
+	struct Op {
+		public char Kind;
+		public int Obj;
+		public int Arg;
+		public int Value;
+	}
+
+	// Array header: vtable, synchronization, bounds and length
+	static readonly int header_size = 4 * IntPtr.Size;
+
+	static Op[] ops;
+	static object[] roots;
+	static GCHandle[] pins;
+	static int allocs;
+
+	static void Load (string path)
+	{
+		var list = new List<Op> ();
+
+		using (var reader = new StreamReader (path)) {
+			string[] header = reader.ReadLine ().Split (' ');
+			if (header.Length != 4 || header [0] != "sgen-replay" || header [1] != "1")
+				throw new InvalidDataException (path + " is not a replay trace");
+
+			int num_objects = Int32.Parse (header [3], CultureInfo.InvariantCulture);
+			roots = new object [num_objects];
+			pins = new GCHandle [num_objects];
+
+			string line;
+			while ((line = reader.ReadLine ()) != null) {
+				string[] f = line.Split (' ');
+				var op = new Op { Kind = f [0][0], Obj = Int32.Parse (f [1], CultureInfo.InvariantCulture) };
+
+				switch (op.Kind) {
+				case 'a':
+					op.Arg = (int) Math.Min (Int64.Parse (f [2], CultureInfo.InvariantCulture), Int32.MaxValue);
+					op.Value = f [3][0];
+					allocs++;
+					break;
+				case 's':
+					op.Arg = Int32.Parse (f [2], CultureInfo.InvariantCulture);
+					op.Value = f [3] == "-" ? -1 : Int32.Parse (f [3], CultureInfo.InvariantCulture);
+					break;
+				case 'c':
+				case 'f':
+					break;
+				default:
+					throw new InvalidDataException ("Unknown replay event: " + line);
+				}
+				list.Add (op);
+			}
+		}
+		ops = list.ToArray ();
+	}
+
+	static void Reset ()
+	{
+		for (int i = 0; i < pins.Length; ++i) {
+			if (pins [i].IsAllocated)
+				pins [i].Free ();
+		}
+		Array.Clear (roots, 0, roots.Length);
+	}
+
+	static void Replay ()
+	{
+		for (int i = 0; i < ops.Length; ++i) {
+			Op op = ops [i];
+
+			switch (op.Kind) {
+			case 'a': {
+				int payload = Math.Max (op.Arg - header_size, 0);
+				if (op.Value == 'r') {
+					roots [op.Obj] = new object [Math.Max (payload / IntPtr.Size, 1)];
+				} else {
+					byte[] bytes = new byte [payload];
+					roots [op.Obj] = bytes;
+					if (op.Value == 'p')
+						pins [op.Obj] = GCHandle.Alloc (bytes, GCHandleType.Pinned);
+				}
+				break;
+			}
+			case 's': {
+				object[] obj = roots [op.Obj] as object[];
+				if (obj == null)
+					break;
+				int slot = Math.Max (op.Arg - header_size, 0) / IntPtr.Size % obj.Length;
+				obj [slot] = op.Value < 0 ? null : roots [op.Value];
+				break;
+			}
+			case 'c':
+				GC.Collect (op.Obj);
+				break;
+			case 'f':
+				roots [op.Obj] = null;
+				if (pins [op.Obj].IsAllocated)
+					pins [op.Obj].Free ();
+				break;
+			}
+		}
+	}
+
+	public static int Main (string[] args) {
+		if (args.Length < 1) {
+			Console.Error.WriteLine ("Usage: gc-replay.exe TRACE [--iterations N] [--warmup N] [--mode NAME]");
+			return 2;
+		}
+
+		string[] bench_args = new string [args.Length - 1];
+		Array.Copy (args, 1, bench_args, 0, bench_args.Length);
+		Bench.Init (bench_args);
+
+		Load (args [0]);
+		Bench.Run ("gc-replay/" + Path.GetFileNameWithoutExtension (args [0]), allocs, Reset, Replay);
+
+		return 0;
+	}
+}
@@ -0,0 +1,60 @@
+using System;
+
+//
+// Generic virtual and generic interface method calls, which go through the
+// generic virtual method thunks instead of the vtable
+//
+public class GenericVirtual {
+
+	class Base {
+		public virtual T Id<T> (T t) { return t; }
+	}
+
+	class Derived : Base {
+		public override T Id<T> (T t) { return t; }
+	}
+
+	interface IConvert {
+		T Convert<T> (T t);
+	}
+
+	class Converter : IConvert {
+		public T Convert<T> (T t) { return t; }
+	}
+
+	const int N = 10000000;
+
+	static long result;
+	static object result_obj;
+
+	public static int Main (string[] args) {
+		Bench.Init (args);
+
+		Base b = new Derived ();
+		IConvert c = new Converter ();
+		object o = new object ();
+
+		Bench.Run ("generic-virtual/valuetype", N, () => {
+			long sum = 0;
+			for (int i = 0; i < N; ++i)
+				sum += b.Id<int> (i);
+			result = sum;
+		});
+
+		Bench.Run ("generic-virtual/reference", N, () => {
+			object r = null;
+			for (int i = 0; i < N; ++i)
+				r = b.Id<object> (o);
+			result_obj = r;
+		});
+
+		Bench.Run ("generic-virtual/interface", N, () => {
+			long sum = 0;
+			for (int i = 0; i < N; ++i)
+				sum += c.Convert<long> (i);
+			result = sum;
+		});
+
+		return 0;
+	}
+}
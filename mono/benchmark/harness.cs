@@ -0,0 +1,232 @@
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.Globalization;
+using System.Text;
+
+//
+// Shared driver for the benchmarks in this directory.
+//
+// Every benchmark is run for a number of untimed warmup iterations followed by
+// the measured ones, and one line of JSON is printed per benchmark so results
+// can be collected per commit and compared by compare-benchmarks.exe:
+//
+//   {"benchmark":"iface-dispatch/mono","mode":"jit","commit":"...","iterations":50,
+//    "ops":1000000,"p50_ns":...,"p99_ns":...,"mean_ns":...,"min_ns":...,
+//    "alloc_bytes":...,"gen0":...,"gen1":...,"gen2":...}
+//
+// Timings are per iteration, alloc_bytes is the average per iteration and the
+// collection counts are totals over the measured iterations.
+//
+// Options: --warmup N, --iterations N, --mode NAME (recorded as is, e.g. "interp"),
+// --filter SUBSTRING.  The commit is taken from the BENCH_COMMIT environment variable.
+//
+public static class Bench {
+
+	static int warmup = 5;
+	static int iterations = 50;
+	static string mode = "jit";
+	static string filter;
+	static string commit;
+
+	public static void Init (string[] args)
+	{
+		for (int i = 0; i < args.Length; ++i) {
+			string arg = args [i];
+			string val = i + 1 < args.Length ? args [i + 1] : null;
+
+			switch (arg) {
+			case "--warmup":
+				warmup = Int32.Parse (val);
+				++i;
+				break;
+			case "--iterations":
+				iterations = Int32.Parse (val);
+				++i;
+				break;
+			case "--mode":
+				mode = val;
+				++i;
+				break;
+			case "--filter":
+				filter = val;
+				++i;
+				break;
+			default:
+				throw new ArgumentException ("Unknown option: " + arg);
+			}
+		}
+		if (iterations < 1)
+			throw new ArgumentException ("--iterations must be at least 1");
+
+		commit = Environment.GetEnvironmentVariable ("BENCH_COMMIT") ?? "";
+	}
+
+	public static int Iterations {
+		get { return iterations; }
+	}
+
+	public static void Run (string name, long ops, Action body)
+	{
+		Run (name, ops, null, body);
+	}
+
+	//
+	// SETUP runs before every iteration, warmup included, outside of the timed region.
+	// OPS is the number of operations an iteration performs, it is only recorded so
+	// per operation costs can be derived from the results.
+	//
+	public static void Run (string name, long ops, Action setup, Action body)
+	{
+		if (filter != null && name.IndexOf (filter, StringComparison.Ordinal) < 0)
+			return;
+
+		for (int i = 0; i < warmup; ++i) {
+			if (setup != null)
+				setup ();
+			body ();
+		}
+
+		long[] samples = new long [iterations];
+		long allocated = 0;
+		int gen0 = GC.CollectionCount (0);
+		int gen1 = GC.CollectionCount (1);
+		int gen2 = GC.CollectionCount (2);
+
+		for (int i = 0; i < iterations; ++i) {
+			if (setup != null)
+				setup ();
+
+			long before = GC.GetAllocatedBytesForCurrentThread ();
+			long start = Stopwatch.GetTimestamp ();
+			body ();
+			long end = Stopwatch.GetTimestamp ();
+			allocated += GC.GetAllocatedBytesForCurrentThread () - before;
+
+			samples [i] = end - start;
+		}
+
+		gen0 = GC.CollectionCount (0) - gen0;
+		gen1 = GC.CollectionCount (1) - gen1;
+		gen2 = GC.CollectionCount (2) - gen2;
+
+		Report (name, ops, samples, allocated / iterations, gen0, gen1, gen2);
+	}
+
+	//
+	// For benchmarks that take their own measurements, e.g. collector pauses or
+	// process startup, SAMPLES are in nanoseconds.
+	//
+	public static void Report (string name, long ops, long[] samples_ns, long alloc_bytes)
+	{
+		if (filter != null && name.IndexOf (filter, StringComparison.Ordinal) < 0)
+			return;
+
+		long[] ticks = new long [samples_ns.Length];
+		for (int i = 0; i < ticks.Length; ++i)
+			ticks [i] = (long) (samples_ns [i] * (Stopwatch.Frequency / 1e9));
+
+		Report (name, ops, ticks, alloc_bytes, 0, 0, 0);
+	}
+
+	static void Report (string name, long ops, long[] ticks, long alloc_bytes, int gen0, int gen1, int gen2)
+	{
+		double ns_per_tick = 1e9 / Stopwatch.Frequency;
+		long[] sorted = (long[]) ticks.Clone ();
+		Array.Sort (sorted);
+
+		double sum = 0;
+		foreach (long t in sorted)
+			sum += t;
+
+		var sb = new StringBuilder ();
+		sb.Append ('{');
+		Field (sb, "benchmark", name);
+		Field (sb, "mode", mode);
+		Field (sb, "commit", commit);
+		Field (sb, "iterations", sorted.Length);
+		Field (sb, "ops", ops);
+		Field (sb, "p50_ns", (long) (Percentile (sorted, 50) * ns_per_tick));
+		Field (sb, "p99_ns", (long) (Percentile (sorted, 99) * ns_per_tick));
+		Field (sb, "mean_ns", (long) (sum / sorted.Length * ns_per_tick));
+		Field (sb, "min_ns", (long) (sorted [0] * ns_per_tick));
+		Field (sb, "alloc_bytes", alloc_bytes);
+		Field (sb, "gen0", gen0);
+		Field (sb, "gen1", gen1);
+		Field (sb, "gen2", gen2);
+		sb.Length--;
+		sb.Append ('}');
+
+		Console.WriteLine (sb.ToString ());
+	}
+
+	// Nearest rank on the sorted samples
+	static long Percentile (long[] sorted, int p)
+	{
+		int rank = (int) Math.Ceiling (p / 100.0 * sorted.Length);
+		return sorted [Math.Max (rank, 1) - 1];
+	}
+
+	static void Field (StringBuilder sb, string key, string val)
+	{
+		sb.Append ('"').Append (key).Append ("\":\"");
+		foreach (char c in val) {
+			if (c == '"' || c == '\\')
+				sb.Append ('\\');
+			sb.Append (c);
+		}
+		sb.Append ("\",");
+	}
+
+	static void Field (StringBuilder sb, string key, long val)
+	{
+		sb.Append ('"').Append (key).Append ("\":").Append (val.ToString (CultureInfo.InvariantCulture)).Append (',');
+	}
+
+	//
+	// Minimal reader for the lines written above, only used by compare-benchmarks.exe
+	//
+	public static Dictionary<string, string> ParseLine (string line)
+	{
+		var res = new Dictionary<string, string> ();
+		int i = line.IndexOf ('{');
+
+		if (i < 0)
+			return null;
+		++i;
+		while (i < line.Length && line [i] != '}') {
+			string key = ReadToken (line, ref i);
+			if (key == null || i >= line.Length || line [i] != ':')
+				return null;
+			++i;
+			string val = ReadToken (line, ref i);
+			if (val == null)
+				return null;
+			res [key] = val;
+			if (i < line.Length && line [i] == ',')
+				++i;
+		}
+		return res;
+	}
+
+	static string ReadToken (string s, ref int i)
+	{
+		var sb = new StringBuilder ();
+
+		if (i < s.Length && s [i] == '"') {
+			for (++i; i < s.Length && s [i] != '"'; ++i) {
+				if (s [i] == '\\')
+					++i;
+				if (i < s.Length)
+					sb.Append (s [i]);
+			}
+			if (i >= s.Length)
+				return null;
+			++i;
+		} else {
+			for (; i < s.Length && s [i] != ',' && s [i] != '}'; ++i)
+				sb.Append (s [i]);
+		}
+		return sb.ToString ();
+	}
+}
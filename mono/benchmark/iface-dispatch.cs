@@ -0,0 +1,50 @@
+using System;
+
+//
+// Interface calls through monomorphic and megamorphic call sites
+//
+public class IfaceDispatch {
+
+	interface IShape {
+		int Area ();
+	}
+
+	class Square : IShape { public int Area () { return 1; } }
+	class Rect : IShape { public int Area () { return 2; } }
+	class Circle : IShape { public int Area () { return 3; } }
+	class Triangle : IShape { public int Area () { return 4; } }
+	class Hexagon : IShape { public int Area () { return 5; } }
+	class Ellipse : IShape { public int Area () { return 6; } }
+	class Star : IShape { public int Area () { return 7; } }
+	class Line : IShape { public int Area () { return 8; } }
+
+	const int N = 10000000;
+
+	static int result;
+
+	static int Sum (IShape[] shapes, int n)
+	{
+		int sum = 0;
+		for (int i = 0; i < n; ++i)
+			sum += shapes [i & 7].Area ();
+		return sum;
+	}
+
+	public static int Main (string[] args) {
+		Bench.Init (args);
+
+		IShape[] mono = new IShape [8];
+		for (int i = 0; i < mono.Length; ++i)
+			mono [i] = new Square ();
+
+		IShape[] poly = new IShape [] {
+			new Square (), new Rect (), new Circle (), new Triangle (),
+			new Hexagon (), new Ellipse (), new Star (), new Line ()
+		};
+
+		Bench.Run ("iface-dispatch/monomorphic", N, () => result = Sum (mono, N));
+		Bench.Run ("iface-dispatch/megamorphic", N, () => result = Sum (poly, N));
+
+		return 0;
+	}
+}
@@ -0,0 +1,61 @@
+using System;
+
+//
+// Tight loops over locals, arrays and fields.  Mostly interesting when run with
+// --interpreter, run-benchmarks.sh runs it in both modes.
+//
+public class InterpLoops {
+
+	struct Point {
+		public int X, Y;
+	}
+
+	const int N = 1000000;
+
+	static long result;
+
+	public static int Main (string[] args) {
+		Bench.Init (args);
+
+		int[] arr = new int [N];
+		Point[] points = new Point [1024];
+
+		Bench.Run ("interp-loops/arith", N, () => {
+			long sum = 0;
+			for (int i = 0; i < N; ++i)
+				sum += (i * 3) ^ (i >> 2);
+			result = sum;
+		});
+
+		Bench.Run ("interp-loops/array", N, () => {
+			for (int i = 0; i < arr.Length; ++i)
+				arr [i] = i;
+			long sum = 0;
+			for (int i = 0; i < arr.Length; ++i)
+				sum += arr [i];
+			result = sum;
+		});
+
+		Bench.Run ("interp-loops/struct", N, () => {
+			for (int i = 0; i < N; ++i) {
+				points [i & 1023].X += i;
+				points [i & 1023].Y -= i;
+			}
+			result = points [0].X;
+		});
+
+		Bench.Run ("interp-loops/call", N, () => {
+			long sum = 0;
+			for (int i = 0; i < N; ++i)
+				sum += Add (i, 1);
+			result = sum;
+		});
+
+		return 0;
+	}
+
+	static int Add (int a, int b)
+	{
+		return a + b;
+	}
+}
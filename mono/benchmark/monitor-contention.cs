@@ -0,0 +1,59 @@
+using System;
+using System.Threading;
+
+//
+// Monitor enter/exit, uncontended and with every core fighting over the same lock
+//
+public class MonitorContention {
+
+	const int N = 100000;
+
+	static readonly object lock_obj = new object ();
+	static long counter;
+
+	static void Work (int n)
+	{
+		for (int i = 0; i < n; ++i) {
+			lock (lock_obj)
+				counter++;
+		}
+	}
+
+	public static int Main (string[] args) {
+		Bench.Init (args);
+
+		Bench.Run ("monitor/uncontended", N, () => Work (N));
+
+		int threads = Math.Max (Environment.ProcessorCount, 2);
+		int per_thread = N / threads;
+
+		/* Keep the workers alive across iterations so thread creation isn't measured */
+		var start = new Barrier (threads + 1);
+		var done = new Barrier (threads + 1);
+		bool quit = false;
+
+		for (int i = 0; i < threads; ++i) {
+			var t = new Thread (() => {
+				while (true) {
+					start.SignalAndWait ();
+					if (Volatile.Read (ref quit))
+						break;
+					Work (per_thread);
+					done.SignalAndWait ();
+				}
+			});
+			t.IsBackground = true;
+			t.Start ();
+		}
+
+		Bench.Run ("monitor/contended", per_thread * threads, () => {
+			start.SignalAndWait ();
+			done.SignalAndWait ();
+		});
+
+		Volatile.Write (ref quit, true);
+		start.SignalAndWait ();
+
+		return 0;
+	}
+}
@@ -0,0 +1,39 @@
+using System;
+using System.Runtime.InteropServices;
+
+//
+// Managed to native transitions, with blittable arguments and with a string
+// that has to be marshalled
+//
+public class PInvoke {
+
+	[DllImport ("libc")]
+	static extern int abs (int i);
+
+	[DllImport ("libc", CharSet = CharSet.Ansi)]
+	static extern IntPtr strlen (string s);
+
+	const int N = 1000000;
+
+	static long result;
+
+	public static int Main (string[] args) {
+		Bench.Init (args);
+
+		Bench.Run ("pinvoke/blittable", N, () => {
+			long sum = 0;
+			for (int i = 0; i < N; ++i)
+				sum += abs (-i);
+			result = sum;
+		});
+
+		Bench.Run ("pinvoke/string", N / 10, () => {
+			long sum = 0;
+			for (int i = 0; i < N / 10; ++i)
+				sum += (long) strlen ("benchmark");
+			result = sum;
+		});
+
+		return 0;
+	}
+}
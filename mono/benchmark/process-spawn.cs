@@ -0,0 +1,64 @@
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+
+//
+// Latency of starting a trivial process and waiting for it, with an increasing
+// amount of live managed heap.  With fork () the cost grows with the size of
+// the parent's address space, with posix_spawn () it shouldn't.
+//
+public class ProcessSpawn {
+
+	const int chunk_size = 1024 * 1024;
+
+	static List<byte[]> heap = new List<byte[]> ();
+
+	static void GrowHeap (int mb)
+	{
+		while (heap.Count < mb) {
+			byte[] chunk = new byte [chunk_size];
+			/* Touch every page so it is mapped in the parent */
+			for (int i = 0; i < chunk.Length; i += 4096)
+				chunk [i] = 1;
+			heap.Add (chunk);
+		}
+	}
+
+	static long Spawn (ProcessStartInfo info)
+	{
+		long start = Stopwatch.GetTimestamp ();
+		using (var p = Process.Start (info)) {
+			p.WaitForExit ();
+			if (p.ExitCode != 0)
+				throw new Exception (info.FileName + " failed with " + p.ExitCode);
+		}
+		return (long) ((Stopwatch.GetTimestamp () - start) * (1e9 / Stopwatch.Frequency));
+	}
+
+	public static int Main (string[] args) {
+		Bench.Init (args);
+
+		var info = new ProcessStartInfo ("/bin/true") {
+			UseShellExecute = false
+		};
+		int n = Math.Max (Bench.Iterations, 3);
+
+		foreach (int mb in new int [] { 0, 256, 1024, 2048 }) {
+			try {
+				GrowHeap (mb);
+			} catch (OutOfMemoryException) {
+				break;
+			}
+
+			Spawn (info);
+
+			long[] samples = new long [n];
+			for (int i = 0; i < n; ++i)
+				samples [i] = Spawn (info);
+			Bench.Report ("process-spawn/heap-" + mb + "m", 1, samples, 0);
+		}
+
+		GC.KeepAlive (heap);
+		return 0;
+	}
+}
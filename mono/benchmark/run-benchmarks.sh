@@ -0,0 +1,51 @@
+#!/bin/sh
+#
+# Runs every benchmark and appends the results to results/<commit>.jsonl.
+#
+# Usage: run-benchmarks.sh MONO [extra benchmark options]
+#
+# Run it from the directory holding the compiled benchmarks, 'make bench' does.
+#
+# Use compare-benchmarks.exe on two result files to look for regressions.
+#
+
+if test $# -lt 1; then
+	echo "Usage: $0 MONO [--iterations N] [--warmup N] [--filter NAME]"
+	exit 2
+fi
+
+MONO=$1
+shift
+
+if test -z "$BENCH_COMMIT"; then
+	BENCH_COMMIT=`git rev-parse --short HEAD 2>/dev/null || echo unknown`
+	if ! git diff --quiet HEAD 2>/dev/null; then
+		BENCH_COMMIT=$BENCH_COMMIT-dirty
+	fi
+fi
+export BENCH_COMMIT
+
+BENCHMARKS="alloc-rate gc-pause monitor-contention iface-dispatch generic-virtual exceptions pinvoke interp-loops process-spawn startup tls-handshake"
+INTERP_BENCHMARKS="iface-dispatch generic-virtual exceptions interp-loops"
+
+mkdir -p results aot
+OUT=results/$BENCH_COMMIT.jsonl
+rm -f $OUT
+
+# AOT image for the startup benchmark, startup.exe skips the AOT variant if this fails
+cp startup-child.exe aot/
+$MONO --aot aot/startup-child.exe > /dev/null || echo "AOT compilation of startup-child.exe failed"
+
+status=0
+for b in $BENCHMARKS; do
+	echo "$b" 1>&2
+	$MONO $b.exe --mode jit "$@" >> $OUT || status=1
+done
+
+for b in $INTERP_BENCHMARKS; do
+	echo "$b (interp)" 1>&2
+	$MONO --interpreter $b.exe --mode interp "$@" >> $OUT || status=1
+done
+
+echo "Results written to $OUT" 1>&2
+exit $status
@@ -0,0 +1,16 @@
+using System;
+using System.Collections.Generic;
+using System.Linq;
+
+//
+// Launched by startup.exe.  Touches a few commonly used parts of the class
+// libraries so their loading and JIT (or AOT lookup) is part of the measurement.
+//
+public class StartupChild {
+
+	public static int Main (string[] args) {
+		var list = new List<string> { "a", "b", "c" };
+		var dict = list.ToDictionary (s => s, s => s.Length);
+		return dict.Count == 3 ? 0 : 1;
+	}
+}
@@ -0,0 +1,55 @@
+using System;
+using System.Diagnostics;
+using System.IO;
+
+//
+// Wall clock time to run startup-child.exe in a new process, JIT compiled and
+// loading an AOT image.  The AOT variant is skipped when aot/startup-child.exe.so
+// is missing, run-benchmarks.sh creates it.
+//
+public class Startup {
+
+	static long RunChild (string runtime, string args)
+	{
+		var info = new ProcessStartInfo (runtime, args) {
+			UseShellExecute = false
+		};
+
+		long start = Stopwatch.GetTimestamp ();
+		using (var p = Process.Start (info)) {
+			p.WaitForExit ();
+			if (p.ExitCode != 0)
+				throw new Exception ("startup-child.exe failed with " + p.ExitCode);
+		}
+		return (long) ((Stopwatch.GetTimestamp () - start) * (1e9 / Stopwatch.Frequency));
+	}
+
+	static void Measure (string name, string runtime, string args)
+	{
+		/* Process creation is slow enough that a tenth of the iterations gives a stable result */
+		int n = Math.Max (Bench.Iterations / 10, 3);
+
+		RunChild (runtime, args);
+
+		long[] samples = new long [n];
+		for (int i = 0; i < n; ++i)
+			samples [i] = RunChild (runtime, args);
+		Bench.Report (name, 1, samples, 0);
+	}
+
+	public static int Main (string[] args) {
+		Bench.Init (args);
+
+		string runtime = Process.GetCurrentProcess ().MainModule.FileName;
+		string dir = Path.GetDirectoryName (typeof (Startup).Assembly.Location);
+		string child = Path.Combine (dir, "startup-child.exe");
+		string aot_child = Path.Combine (dir, "aot", "startup-child.exe");
+
+		Measure ("startup/jit", runtime, "\"" + child + "\"");
+
+		if (File.Exists (aot_child + ".so"))
+			Measure ("startup/aot", runtime, "\"" + aot_child + "\"");
+
+		return 0;
+	}
+}
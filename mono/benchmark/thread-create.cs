@@ -0,0 +1,37 @@
+using System;
+using System.Diagnostics;
+using System.Threading;
+
+//
+// Measures the latency of creating, starting and joining short lived threads
+//
+public class ThreadCreate {
+
+	static int count;
+
+	static void Run ()
+	{
+		Interlocked.Increment (ref count);
+	}
+
+	public static int Main (string[] args) {
+		int n = 10000;
+
+		if (args.Length > 0)
+			n = Int32.Parse (args [0]);
+
+		Stopwatch sw = Stopwatch.StartNew ();
+
+		for (int i = 0; i < n; ++i) {
+			Thread t = new Thread (Run);
+			t.Start ();
+			t.Join ();
+		}
+
+		sw.Stop ();
+
+		Console.WriteLine ("{0} threads: {1} ms, {2:F2} us per create and join", n, sw.ElapsedMilliseconds, sw.Elapsed.TotalMilliseconds * 1000 / n);
+
+		return count == n ? 0 : 1;
+	}
+}
@@ -0,0 +1,215 @@
+using System;
+using System.Net;
+using System.Net.Sockets;
+using System.Runtime.InteropServices;
+using System.Threading.Tasks;
+
+//
+// TLS handshakes over loopback through the native BTLS entry points, with a
+// cold session cache and resuming the session from the process wide cache, see
+// mono_btls_ssl_set_session_key ().  Both ends create a new context for every
+// connection, like the managed provider does.  Skipped if libmono-btls-shared
+// can't be loaded.
+//
+public class TlsHandshake {
+
+	const string btls = "libmono-btls-shared";
+
+	[DllImport (btls)]
+	static extern IntPtr mono_btls_ssl_ctx_new ();
+
+	[DllImport (btls)]
+	static extern int mono_btls_ssl_ctx_free (IntPtr ctx);
+
+	[DllImport (btls)]
+	static extern void mono_btls_ssl_ctx_enable_session_cache (IntPtr ctx, int is_server);
+
+	[DllImport (btls)]
+	static extern void mono_btls_ssl_ctx_set_max_version (IntPtr ctx, int version);
+
+	[DllImport (btls)]
+	static extern IntPtr mono_btls_ssl_new (IntPtr ctx);
+
+	[DllImport (btls)]
+	static extern void mono_btls_ssl_destroy (IntPtr ssl);
+
+	[DllImport (btls)]
+	static extern int mono_btls_ssl_use_certificate (IntPtr ssl, IntPtr x509);
+
+	[DllImport (btls)]
+	static extern int mono_btls_ssl_use_private_key (IntPtr ssl, IntPtr key);
+
+	[DllImport (btls)]
+	static extern void mono_btls_ssl_set_bio (IntPtr ssl, IntPtr bio);
+
+	[DllImport (btls)]
+	static extern int mono_btls_ssl_accept (IntPtr ssl);
+
+	[DllImport (btls)]
+	static extern int mono_btls_ssl_connect (IntPtr ssl);
+
+	[DllImport (btls)]
+	static extern int mono_btls_ssl_session_reused (IntPtr ssl);
+
+	[DllImport (btls, CharSet = CharSet.Ansi)]
+	static extern int mono_btls_ssl_set_session_key (IntPtr ssl, string key);
+
+	[DllImport (btls)]
+	static extern IntPtr mono_btls_bio_socket_new (int fd);
+
+	[DllImport (btls)]
+	static extern void mono_btls_bio_free (IntPtr bio);
+
+	[DllImport (btls)]
+	static extern IntPtr mono_btls_x509_from_data (byte[] buf, int len, int format);
+
+	[DllImport (btls)]
+	static extern IntPtr mono_btls_key_new ();
+
+	[DllImport (btls)]
+	static extern int mono_btls_key_assign_rsa_private_key (IntPtr key, byte[] der_data, int der_length);
+
+	[DllImport (btls)]
+	static extern void mono_btls_session_cache_flush ();
+
+	const int MONO_BTLS_X509_FORMAT_DER = 1;
+	const int TLS1_2_VERSION = 0x0303;
+
+	// Self-signed localhost certificate and its RSA key, DER encoded
+	const string cert_data =
+		"MIIDCzCCAfOgAwIBAgIUBlS2memU988C9HQzMC3rn4xdr4swDQYJKoZIhvcNAQELBQAwFDES" +
+		"MBAGA1UEAwwJbG9jYWxob3N0MCAXDTI2MTAxNTA3MTAxN1oYDzIxMjYwOTIxMDcxMDE3WjAU" +
+		"MRIwEAYDVQQDDAlsb2NhbGhvc3QwggEiMA0GCSqGSIb3DQEBAQUAA4IBDwAwggEKAoIBAQDc" +
+		"ye93L6hBySb7JM7DRrvSWA8qgIqrssvVLoOLVQG08AfFGlzB2O3bdRBCaw8JT8d7lRzau819" +
+		"3FCdJIefs8wIgNKZblOGB3C7AFm+Ydz5WTl7VpPeL9S3F9a/gtfxtomPQicBy4GMQSBCMHVg" +
+		"fr06RdTCUU0hAF2cKV0IgHNF6ATjAGfQLD+RjFV0Vy3raGld4L7RnN3uOV+SYKv3MJjNB1Wy" +
+		"bh7hE64YIbqZxxva522H4i9HajznpJWqBD9AkC7C4gDRAHUuAXQPJY/s9X8Isd727+FZaj+V" +
+		"fUVz5EC/nsd1/9TNwmDbzliFaYn6KQ+g30ODxaJphvGPSPPIKoXNAgMBAAGjUzBRMB0GA1Ud" +
+		"DgQWBBQlnsYkC+lPA/9H5EnqceRQmwW+3TAfBgNVHSMEGDAWgBQlnsYkC+lPA/9H5EnqceRQ" +
+		"mwW+3TAPBgNVHRMBAf8EBTADAQH/MA0GCSqGSIb3DQEBCwUAA4IBAQB3YoN/g83fPqs20350" +
+		"gfnZyN19Bci4nWy8ZI+IrZ9lGa5rVJSt69ez0M1lz1hCWMUELlaoWnMn7tDZpftVQzcwoGZ+" +
+		"KFzmUq+PSV60ty1DoahnH64lx0LPzKr1rsH7Em/HFjnoD67MmCE5O8RIJPU/EYjvEHDQtzaQ" +
+		"JNX8U6ieRir+zVNUpQ3Drx3LLgddHG90SvmHksEBPJnpMku++ogbpaIjYiNWIR2CzFRi1nTg" +
+		"bK/UAcKTOSYbHtDuVOMLVJ0/1M29WYd/ODntVUOVSH8uF6Rdgh/+5kzljAJ7XOuUBm1Aw3AB" +
+		"jWQ8P/KUlxN76ocK35Xy8l5svZDW46WJVbMC";
+
+	const string key_data =
+		"MIIEowIBAAKCAQEA3Mnvdy+oQckm+yTOw0a70lgPKoCKq7LL1S6Di1UBtPAHxRpcwdjt23UQ" +
+		"QmsPCU/He5Uc2rvNfdxQnSSHn7PMCIDSmW5ThgdwuwBZvmHc+Vk5e1aT3i/UtxfWv4LX8baJ" +
+		"j0InAcuBjEEgQjB1YH69OkXUwlFNIQBdnCldCIBzRegE4wBn0Cw/kYxVdFct62hpXeC+0Zzd" +
+		"7jlfkmCr9zCYzQdVsm4e4ROuGCG6mccb2udth+IvR2o856SVqgQ/QJAuwuIA0QB1LgF0DyWP" +
+		"7PV/CLHe9u/hWWo/lX1Fc+RAv57Hdf/UzcJg285YhWmJ+ikPoN9Dg8WiaYbxj0jzyCqFzQID" +
+		"AQABAoIBACB9Qf+JY+/joENWTBYLNhSYAF9SPABTwU/fq4bDcwquRDkaYyo5TZhndlriXdDn" +
+		"zE8gsaF0VPhKL734A/xvB5KmwOwdV9gXXIeACooL5OmiWhA5Z21LdONJHuuJNFVYIDo+/fYd" +
+		"0rSSBCOz9XRwzKVNulGqh2LYUW4V3h/5UD0pxvQcgI/SQ0EYr9fXvxff50XYq8fdqeW8i/NG" +
+		"JQEK8E6TY+d67llZiBeAuDKuOE5Q10cuao4aKFjdMHWdskCh5bbDRv0NYxbuJ2wWF3SEwB1P" +
+		"QBleF5eQHNmtUB0zspQo0IGs9wLVXMe0hMDl5K81JKQl4pDmHzAfmO3xeuN05UcCgYEA/+6h" +
+		"bPz5mEixk+3h8c815GHRySBHp0V8lyfEU3GlceO04IYjnXL23z6eS1JjanPFvwldjkU6w2Xq" +
+		"CFrpy93Xl3zj/UTSGlzTJ8484TZyTir+46VLsq1j/0VIYTJOjxgYGS9USJkdqVrDHS/ZgC5o" +
+		"ViVNLMsZouEHH5zGLh1k/ksCgYEA3NjrdUwSpqENqbRN00mqVlwWj8d+0QhQ23sY7NOAEH0s" +
+		"0jol0MD38BsUz1u/X1z4ODPfG3d4jj4bjKMjP+ac1TaGe1jrsN+deEFPp9f1bh9bxyLhf7zZ" +
+		"S1t9D54ofwXRgy8mzntS9m7G75I/AGsTDOqMNSp4wRif7gtq1AMcnUcCgYEAo6FBajpPplKL" +
+		"3qWP+RdfQHZeN3ZA+axOnSHavvMBMVDBu29n4+m190PE1ymE0HHWs25cd3LBwF4vhEoEAskC" +
+		"ZyN9bNeMcTh59JBCkkdKS7nnn0p2nHWJYpM8VJBic9CWz7tX6taihT23U7jdGbwSD0noDsSH" +
+		"zoCLGmYUuzUl9gMCgYBkfbweYqA1/CDYcLfdBa8hnsORZwh4m10XkdrUoKSsXBkSC+17IONw" +
+		"+RGuDSR2gzpbcJb7y5AqwW4Nv4nhoNEKX8YvyFVu5UGlH6rcR/NgyZocce3EDy2dEaNFgQUS" +
+		"T5Z3J/RzjkBA7EVPa++JBC/l97AW3R2XV9omGkHg+Q2DLwKBgESgeRoXvQKzuTD1TD6LuDfm" +
+		"j3MdQeuBMQb621yw8PZtJRZhJgWF7G4qVora/RhG8DMjFh66KUxEWb3ws7Dk8f2Httgz5XeQ" +
+		"xrtKYypkVhdRyyJjdxVhpNXzCxBpjjt3n9wsA1JV/hFSnK5A0ksLdwsbu1mdtP1Na4nUoLSy" +
+		"0CMO";
+
+	static TcpListener listener;
+	static IntPtr cert, key;
+	static Socket client_socket, server_socket;
+
+	static void Connect ()
+	{
+		client_socket = new Socket (AddressFamily.InterNetwork, SocketType.Stream, ProtocolType.Tcp);
+		client_socket.NoDelay = true;
+		client_socket.Connect ((IPEndPoint) listener.LocalEndpoint);
+		server_socket = listener.AcceptSocket ();
+		server_socket.NoDelay = true;
+	}
+
+	static void Handshake (Socket socket, bool is_server, string session_key, bool expect_reuse)
+	{
+		IntPtr ctx = mono_btls_ssl_ctx_new ();
+		// TLS 1.3 clients only get the session after the handshake, with the first read
+		mono_btls_ssl_ctx_set_max_version (ctx, TLS1_2_VERSION);
+		if (session_key != null)
+			mono_btls_ssl_ctx_enable_session_cache (ctx, is_server ? 1 : 0);
+		IntPtr ssl = mono_btls_ssl_new (ctx);
+		IntPtr bio = mono_btls_bio_socket_new ((int) socket.Handle);
+
+		try {
+			if (is_server) {
+				mono_btls_ssl_use_certificate (ssl, cert);
+				mono_btls_ssl_use_private_key (ssl, key);
+			} else if (session_key != null) {
+				mono_btls_ssl_set_session_key (ssl, session_key);
+			}
+			mono_btls_ssl_set_bio (ssl, bio);
+
+			int ret = is_server ? mono_btls_ssl_accept (ssl) : mono_btls_ssl_connect (ssl);
+			if (ret != 1)
+				throw new Exception ((is_server ? "Server" : "Client") + " handshake failed: " + ret);
+			if (!is_server && expect_reuse && mono_btls_ssl_session_reused (ssl) != 1)
+				throw new Exception ("The session wasn't resumed");
+		} finally {
+			mono_btls_ssl_destroy (ssl);
+			mono_btls_bio_free (bio);
+			mono_btls_ssl_ctx_free (ctx);
+			socket.Close ();
+		}
+	}
+
+	static void Connection (string session_key, bool expect_reuse)
+	{
+		Socket server = server_socket;
+		var server_task = Task.Run (() => Handshake (server, true, session_key, false));
+		Handshake (client_socket, false, session_key, expect_reuse);
+		server_task.Wait ();
+	}
+
+	static void Run (string name, string session_key, bool resume)
+	{
+		if (resume) {
+			// Put a session into the cache
+			Connect ();
+			Connection (session_key, false);
+		}
+
+		Bench.Run ("tls-handshake/" + name, 1, () => {
+			if (!resume)
+				mono_btls_session_cache_flush ();
+			Connect ();
+		}, () => Connection (session_key, resume));
+	}
+
+	public static int Main (string[] args) {
+		Bench.Init (args);
+
+		try {
+			byte[] cert_bytes = Convert.FromBase64String (cert_data);
+			byte[] key_bytes = Convert.FromBase64String (key_data);
+
+			cert = mono_btls_x509_from_data (cert_bytes, cert_bytes.Length, MONO_BTLS_X509_FORMAT_DER);
+			key = mono_btls_key_new ();
+			if (cert == IntPtr.Zero || mono_btls_key_assign_rsa_private_key (key, key_bytes, key_bytes.Length) != 1)
+				throw new Exception ("Can't load the server certificate");
+		} catch (DllNotFoundException) {
+			Console.Error.WriteLine ("tls-handshake: " + btls + " not found, skipped");
+			return 0;
+		}
+
+		listener = new TcpListener (IPAddress.Loopback, 0);
+		listener.Start ();
+
+		Run ("full", null, false);
+		Run ("full-cache-miss", "localhost:443", false);
+		Run ("resumed", "localhost:443", true);
+
+		listener.Stop ();
+		return 0;
+	}
+}
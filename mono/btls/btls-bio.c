@@ -10,12 +10,25 @@
 #include "btls-bio.h"
 #include "../utils/mono-errno.h"
 #include <errno.h>
+#include <string.h>
 
 struct MonoBtlsBio {
 	const void *instance;
 	MonoBtlsReadFunc read_func;
 	MonoBtlsWriteFunc write_func;
 	MonoBtlsControlFunc control_func;
+
+	/*
+	 * Caller owned buffers, see mono_btls_bio_mono_set_input () and
+	 * mono_btls_bio_mono_set_output ().  While they are set, records are
+	 * read from and written to them without calling back into managed code.
+	 */
+	const uint8_t *in_data;
+	int in_length;
+	int in_pos;
+	uint8_t *out_data;
+	int out_size;
+	int out_length;
 };
 
 #if 0
@@ -38,6 +51,22 @@ mono_read (BIO *bio, char *out, int outl)
 	if (!mono)
 		return -1;
 
+	if (mono->in_data) {
+		int avail = mono->in_length - mono->in_pos;
+
+		if (avail > 0) {
+			ret = avail < outl ? avail : outl;
+			memcpy (out, mono->in_data + mono->in_pos, ret);
+			mono->in_pos += ret;
+			return ret;
+		}
+		if (!mono->read_func) {
+			mono_set_errno (EAGAIN);
+			BIO_set_retry_read (bio);
+			return -1;
+		}
+	}
+
 	ret = mono->read_func (mono->instance, out, outl, &wantMore);
 
 	if (ret < 0) {
@@ -64,6 +93,22 @@ mono_write (BIO *bio, const char *in, int inl)
 	if (!mono)
 		return -1;
 
+	if (mono->out_data) {
+		int avail = mono->out_size - mono->out_length;
+
+		/* Once it's full the caller has to drain it and retry */
+		if (avail <= 0) {
+			mono_set_errno (EAGAIN);
+			BIO_set_retry_write (bio);
+			return -1;
+		}
+		if (inl > avail)
+			inl = avail;
+		memcpy (mono->out_data + mono->out_length, in, inl);
+		mono->out_length += inl;
+		return inl;
+	}
+
 	return mono->write_func (mono->instance, in, inl);
 }
 
@@ -78,7 +123,13 @@ mono_ctrl (BIO *bio, int cmd, long num, void *ptr)
 	// fprintf (stderr, "mono_ctrl: %x - %lx - %p\n", cmd, num, ptr);
 	switch (cmd) {
 		case BIO_CTRL_FLUSH:
+			if (mono->out_data || !mono->control_func)
+				return 1;
 			return (long)mono->control_func (mono->instance, MONO_BTLS_CONTROL_COMMAND_FLUSH, 0);
+		case BIO_CTRL_PENDING:
+			return mono->in_data ? mono->in_length - mono->in_pos : 0;
+		case BIO_CTRL_WPENDING:
+			return mono->out_data ? mono->out_length : 0;
 		default:
 			return -1;
 	}
@@ -154,6 +205,62 @@ mono_btls_bio_mono_initialize (BIO *bio, const void *instance,
 	bio->init = 1;
 }
 
+/*
+ * Let BoringSSL read records straight from the \p length bytes at \p data, which
+ * the caller keeps alive (pinned) until it sets the next input or clears it with
+ * NULL.  Reads past the end call the read callback, if there is one, or ask the
+ * caller to retry.
+ */
+void
+mono_btls_bio_mono_set_input (BIO *bio, const void *data, int length)
+{
+	MonoBtlsBio *monoBio = bio->ptr;
+
+	monoBio->in_data = data;
+	monoBio->in_length = data ? length : 0;
+	monoBio->in_pos = 0;
+}
+
+/* The number of input bytes BoringSSL hasn't consumed yet */
+int
+mono_btls_bio_mono_get_input_remaining (BIO *bio)
+{
+	MonoBtlsBio *monoBio = bio->ptr;
+
+	return monoBio->in_length - monoBio->in_pos;
+}
+
+/*
+ * Collect the records BoringSSL writes in the \p size bytes at \p data, which
+ * the caller keeps alive until it sets the next output or clears it with NULL.
+ * Writes fail with a retry once it is full.
+ */
+void
+mono_btls_bio_mono_set_output (BIO *bio, void *data, int size)
+{
+	MonoBtlsBio *monoBio = bio->ptr;
+
+	monoBio->out_data = data;
+	monoBio->out_size = data ? size : 0;
+	monoBio->out_length = 0;
+}
+
+/* The number of bytes written to the output since it was set */
+int
+mono_btls_bio_mono_get_output_length (BIO *bio)
+{
+	MonoBtlsBio *monoBio = bio->ptr;
+
+	return monoBio->out_length;
+}
+
+BIO *
+mono_btls_bio_socket_new (int fd)
+{
+	/* The managed socket owns the descriptor */
+	return BIO_new_socket (fd, BIO_NOCLOSE);
+}
+
 int
 mono_btls_bio_read (BIO *bio, void *data, int len)
 {
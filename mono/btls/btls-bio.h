@@ -28,6 +28,21 @@ mono_btls_bio_mono_initialize (BIO *bio, const void *instance,
 			      MonoBtlsReadFunc read_func, MonoBtlsWriteFunc write_func,
 			      MonoBtlsControlFunc control_func);
 
+MONO_API void
+mono_btls_bio_mono_set_input (BIO *bio, const void *data, int length);
+
+MONO_API int
+mono_btls_bio_mono_get_input_remaining (BIO *bio);
+
+MONO_API void
+mono_btls_bio_mono_set_output (BIO *bio, void *data, int size);
+
+MONO_API int
+mono_btls_bio_mono_get_output_length (BIO *bio);
+
+MONO_API BIO *
+mono_btls_bio_socket_new (int fd);
+
 MONO_API int
 mono_btls_bio_read (BIO *bio, void *data, int len);
 
@@ -0,0 +1,312 @@
+//
+//  btls-session-cache.c
+//  MonoBtls
+//
+//  Process wide TLS session cache and session ticket keys.
+//
+//  Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//
+
+#include "btls-session-cache.h"
+#include <openssl/cipher.h>
+#include <openssl/digest.h>
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+#include <openssl/x509.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef WIN32
+#include <windows.h>
+typedef SRWLOCK cache_lock_t;
+#define CACHE_LOCK_INITIALIZER SRWLOCK_INIT
+#define cache_lock(l) AcquireSRWLockExclusive (l)
+#define cache_unlock(l) ReleaseSRWLockExclusive (l)
+#else
+#include <pthread.h>
+typedef pthread_mutex_t cache_lock_t;
+#define CACHE_LOCK_INITIALIZER PTHREAD_MUTEX_INITIALIZER
+#define cache_lock(l) pthread_mutex_lock (l)
+#define cache_unlock(l) pthread_mutex_unlock (l)
+#endif
+
+/*
+ * The cache is 4-way set associative: a key can only live in the ways of
+ * the set it hashes to, and the least recently used way of a full set is
+ * evicted.  That keeps lookups to a handful of string compares without any
+ * resizing, and bounds the number of sessions we keep alive.
+ */
+#define CACHE_SETS 64
+#define CACHE_WAYS 4
+
+/* Ticket keys are replaced after this many seconds by default */
+#define TICKET_KEY_LIFETIME (12 * 60 * 60)
+
+typedef struct {
+	char *key;
+	SSL_SESSION *session;
+	uint64_t last_used;
+} CacheEntry;
+
+typedef struct {
+	uint8_t name [16];
+	uint8_t hmac_key [16];
+	uint8_t aes_key [16];
+	time_t created;
+	int valid;
+} TicketKey;
+
+static cache_lock_t cache_lock = CACHE_LOCK_INITIALIZER;
+static CacheEntry cache [CACHE_SETS][CACHE_WAYS];
+static uint64_t cache_clock;
+static int cache_hits, cache_misses, cache_entries;
+
+/* The current key, used to issue tickets, and the one it replaced */
+static TicketKey ticket_keys [2];
+static int ticket_key_lifetime = TICKET_KEY_LIFETIME;
+
+static unsigned int
+hash_key (const char *key)
+{
+	/* FNV-1a */
+	unsigned int hash = 2166136261u;
+
+	for (; *key; key++) {
+		hash ^= (unsigned char)*key;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+/*
+ * Returns the cache key of the sessions of @ssl with @peer, which must be freed
+ * with OPENSSL_free ().  Resuming a session skips certificate validation and
+ * client authentication, so besides @peer the key contains the validation policy
+ * and the SHA-256 of the client certificate.  A client certificate picked by the
+ * certificate selection callback is only known after the handshake, sessions
+ * established with one are then never resumed by a connection that doesn't set
+ * the same certificate up front.
+ */
+char *
+mono_btls_session_cache_make_key (SSL *ssl, const char *peer)
+{
+	X509_VERIFY_PARAM *param = SSL_get0_param (ssl);
+	X509 *cert = SSL_get_certificate (ssl);
+	char identity [EVP_MAX_MD_SIZE * 2 + 1];
+	char *key;
+	int len;
+
+	strcpy (identity, "none");
+	if (cert) {
+		uint8_t digest [EVP_MAX_MD_SIZE];
+		unsigned int digest_len, i;
+
+		if (!X509_digest (cert, EVP_sha256 (), digest, &digest_len))
+			return NULL;
+		for (i = 0; i < digest_len; i++)
+			sprintf (identity + i * 2, "%02x", digest [i]);
+	}
+
+	len = snprintf (NULL, 0, "%s|%d:%lx:%d|%s", peer, SSL_get_verify_mode (ssl),
+			(unsigned long)X509_VERIFY_PARAM_get_flags (param), X509_VERIFY_PARAM_get_depth (param), identity);
+	key = OPENSSL_malloc (len + 1);
+	if (!key)
+		return NULL;
+	snprintf (key, len + 1, "%s|%d:%lx:%d|%s", peer, SSL_get_verify_mode (ssl),
+		  (unsigned long)X509_VERIFY_PARAM_get_flags (param), X509_VERIFY_PARAM_get_depth (param), identity);
+	return key;
+}
+
+static int
+session_expired (SSL_SESSION *session, time_t now)
+{
+	return (long)now >= SSL_SESSION_get_time (session) + SSL_SESSION_get_timeout (session);
+}
+
+static void
+entry_clear (CacheEntry *entry)
+{
+	if (!entry->session)
+		return;
+	SSL_SESSION_free (entry->session);
+	OPENSSL_free (entry->key);
+	entry->session = NULL;
+	entry->key = NULL;
+	cache_entries--;
+}
+
+SSL_SESSION *
+mono_btls_session_cache_lookup (const char *key)
+{
+	CacheEntry *set = cache [hash_key (key) % CACHE_SETS];
+	SSL_SESSION *session = NULL;
+	time_t now = time (NULL);
+	int i;
+
+	cache_lock (&cache_lock);
+	for (i = 0; i < CACHE_WAYS; i++) {
+		CacheEntry *entry = &set [i];
+
+		if (!entry->session || strcmp (entry->key, key))
+			continue;
+		if (session_expired (entry->session, now)) {
+			entry_clear (entry);
+			break;
+		}
+		entry->last_used = ++cache_clock;
+		session = entry->session;
+		SSL_SESSION_up_ref (session);
+		break;
+	}
+	if (session)
+		cache_hits++;
+	else
+		cache_misses++;
+	cache_unlock (&cache_lock);
+
+	return session;
+}
+
+/*
+ * Takes ownership of @session.  A later session for the same key replaces the
+ * earlier one, TLS 1.3 servers hand out a fresh ticket on every resumption.
+ */
+void
+mono_btls_session_cache_add (const char *key, SSL_SESSION *session)
+{
+	CacheEntry *set = cache [hash_key (key) % CACHE_SETS];
+	CacheEntry *victim = NULL;
+	char *key_copy;
+	int i;
+
+	key_copy = OPENSSL_malloc (strlen (key) + 1);
+	if (!key_copy) {
+		SSL_SESSION_free (session);
+		return;
+	}
+	strcpy (key_copy, key);
+
+	cache_lock (&cache_lock);
+	for (i = 0; i < CACHE_WAYS; i++) {
+		CacheEntry *entry = &set [i];
+
+		if (entry->session && !strcmp (entry->key, key)) {
+			victim = entry;
+			break;
+		}
+		if (!victim || (victim->session && (!entry->session || entry->last_used < victim->last_used)))
+			victim = entry;
+	}
+
+	entry_clear (victim);
+	victim->key = key_copy;
+	victim->session = session;
+	victim->last_used = ++cache_clock;
+	cache_entries++;
+	cache_unlock (&cache_lock);
+}
+
+void
+mono_btls_session_cache_flush (void)
+{
+	int i, j;
+
+	cache_lock (&cache_lock);
+	for (i = 0; i < CACHE_SETS; i++) {
+		for (j = 0; j < CACHE_WAYS; j++)
+			entry_clear (&cache [i][j]);
+	}
+	cache_hits = cache_misses = 0;
+	cache_unlock (&cache_lock);
+}
+
+void
+mono_btls_session_cache_get_stats (int *hits, int *misses, int *entries)
+{
+	cache_lock (&cache_lock);
+	*hits = cache_hits;
+	*misses = cache_misses;
+	*entries = cache_entries;
+	cache_unlock (&cache_lock);
+}
+
+void
+mono_btls_session_cache_set_ticket_key_lifetime (int seconds)
+{
+	cache_lock (&cache_lock);
+	ticket_key_lifetime = seconds > 0 ? seconds : TICKET_KEY_LIFETIME;
+	cache_unlock (&cache_lock);
+}
+
+/* Called with the lock held */
+static int
+rotate_ticket_keys (time_t now)
+{
+	TicketKey key;
+
+	if (ticket_keys [0].valid && now - ticket_keys [0].created < ticket_key_lifetime)
+		return 1;
+
+	if (!RAND_bytes (key.name, sizeof (key.name)) ||
+	    !RAND_bytes (key.hmac_key, sizeof (key.hmac_key)) ||
+	    !RAND_bytes (key.aes_key, sizeof (key.aes_key)))
+		return 0;
+	key.created = now;
+	key.valid = 1;
+
+	ticket_keys [1] = ticket_keys [0];
+	ticket_keys [0] = key;
+	return 1;
+}
+
+/*
+ * Issues tickets with the current key and accepts tickets from the current and
+ * the previous one, so every server context in the process can resume sessions
+ * started on any other.  Tickets from the previous key are renewed.
+ */
+int
+mono_btls_session_cache_ticket_key_callback (SSL *ssl, uint8_t *key_name, uint8_t *iv,
+					     EVP_CIPHER_CTX *cipher_ctx, HMAC_CTX *hmac_ctx, int encrypt)
+{
+	time_t now = time (NULL);
+	TicketKey key;
+	int i, ret = 0;
+
+	cache_lock (&cache_lock);
+	if (rotate_ticket_keys (now)) {
+		if (encrypt) {
+			key = ticket_keys [0];
+			ret = 1;
+		} else {
+			for (i = 0; i < 2; i++) {
+				if (!ticket_keys [i].valid || memcmp (ticket_keys [i].name, key_name, sizeof (key.name)))
+					continue;
+				/* The previous key is only good for one more lifetime */
+				if (now - ticket_keys [i].created >= 2 * ticket_key_lifetime)
+					break;
+				key = ticket_keys [i];
+				ret = i == 0 ? 1 : 2;
+				break;
+			}
+		}
+	}
+	cache_unlock (&cache_lock);
+
+	if (!ret)
+		return encrypt ? -1 : 0;
+
+	if (encrypt) {
+		memcpy (key_name, key.name, sizeof (key.name));
+		if (!RAND_bytes (iv, EVP_MAX_IV_LENGTH) ||
+		    !EVP_EncryptInit_ex (cipher_ctx, EVP_aes_128_cbc (), NULL, key.aes_key, iv))
+			ret = -1;
+	} else if (!EVP_DecryptInit_ex (cipher_ctx, EVP_aes_128_cbc (), NULL, key.aes_key, iv)) {
+		ret = -1;
+	}
+
+	if (ret > 0 && !HMAC_Init_ex (hmac_ctx, key.hmac_key, sizeof (key.hmac_key), EVP_sha256 (), NULL))
+		ret = -1;
+
+	OPENSSL_cleanse (&key, sizeof (key));
+	return ret;
+}
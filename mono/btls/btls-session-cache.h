@@ -0,0 +1,45 @@
+//
+//  btls-session-cache.h
+//  MonoBtls
+//
+//  Process wide TLS session cache and session ticket keys.
+//
+//  Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//
+
+#ifndef __btls__btls_session_cache__
+#define __btls__btls_session_cache__
+
+#include <stdio.h>
+#include <openssl/ssl.h>
+#include "btls-util.h"
+
+/*
+ * Client sessions are shared by every MonoBtlsSslCtx in the process and are
+ * keyed by a string the managed side picks (typically "host:port"), since it
+ * creates a new context for every connection.
+ */
+char *
+mono_btls_session_cache_make_key (SSL *ssl, const char *peer);
+
+SSL_SESSION *
+mono_btls_session_cache_lookup (const char *key);
+
+void
+mono_btls_session_cache_add (const char *key, SSL_SESSION *session);
+
+/* Session ticket callback encrypting with the process wide, rotating keys */
+int
+mono_btls_session_cache_ticket_key_callback (SSL *ssl, uint8_t *key_name, uint8_t *iv,
+					     EVP_CIPHER_CTX *cipher_ctx, HMAC_CTX *hmac_ctx, int encrypt);
+
+MONO_API void
+mono_btls_session_cache_flush (void);
+
+MONO_API void
+mono_btls_session_cache_set_ticket_key_lifetime (int seconds);
+
+MONO_API void
+mono_btls_session_cache_get_stats (int *hits, int *misses, int *entries);
+
+#endif /* __btls__btls_session_cache__ */
@@ -7,6 +7,8 @@
 //
 
 #include "btls-ssl-ctx.h"
+#include "btls-ssl.h"
+#include "btls-session-cache.h"
 #include "btls-x509-verify-param.h"
 #include <openssl/bytestring.h>
 #include <string.h>
@@ -317,3 +319,51 @@ mono_btls_ssl_ctx_set_server_name_callback (MonoBtlsSslCtx *ptr, MonoBtlsServerN
 	SSL_CTX_set_tlsext_servername_callback (ptr->ctx, server_name_callback);
 	SSL_CTX_set_tlsext_servername_arg (ptr->ctx, ptr);
 }
+
+static int
+new_session_callback (SSL *ssl, SSL_SESSION *session)
+{
+	const char *peer = mono_btls_ssl_get_session_key (SSL_get_app_data (ssl));
+	char *key;
+
+	if (!peer)
+		return 0;
+
+	key = mono_btls_session_cache_make_key (ssl, peer);
+	if (!key)
+		return 0;
+
+	// Takes ownership of the session.
+	mono_btls_session_cache_add (key, session);
+	OPENSSL_free (key);
+	return 1;
+}
+
+/*
+ * Clients store new sessions in the process wide cache under the key set with
+ * mono_btls_ssl_set_session_key (); servers share the process wide, rotating
+ * session ticket keys and keep a per-context session id cache.
+ */
+void
+mono_btls_ssl_ctx_enable_session_cache (MonoBtlsSslCtx *ctx, int is_server)
+{
+	if (is_server) {
+		SSL_CTX_set_session_cache_mode (ctx->ctx, SSL_SESS_CACHE_SERVER);
+		SSL_CTX_set_tlsext_ticket_key_cb (ctx->ctx, mono_btls_session_cache_ticket_key_callback);
+	} else {
+		SSL_CTX_set_session_cache_mode (ctx->ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL);
+		SSL_CTX_sess_set_new_cb (ctx->ctx, new_session_callback);
+	}
+}
+
+int
+mono_btls_ssl_ctx_set_early_data_enabled (MonoBtlsSslCtx *ctx, int enabled)
+{
+#ifdef SSL_ERROR_EARLY_DATA_REJECTED
+	SSL_CTX_set_early_data_enabled (ctx->ctx, enabled);
+	return 1;
+#else
+	// This BoringSSL predates TLS 1.3 0-RTT.
+	return 0;
+#endif
+}
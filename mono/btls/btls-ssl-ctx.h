@@ -88,4 +88,10 @@ mono_btls_ssl_ctx_set_client_ca_list (MonoBtlsSslCtx *ctx, int count, int *sizes
 MONO_API void
 mono_btls_ssl_ctx_set_server_name_callback (MonoBtlsSslCtx *ctx, MonoBtlsServerNameFunc func);
 
+MONO_API void
+mono_btls_ssl_ctx_enable_session_cache (MonoBtlsSslCtx *ctx, int is_server);
+
+MONO_API int
+mono_btls_ssl_ctx_set_early_data_enabled (MonoBtlsSslCtx *ctx, int enabled);
+
 #endif /* __btls_ssl_ctx__btls_ssl_ctx__ */
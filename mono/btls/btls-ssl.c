@@ -7,11 +7,13 @@
 //
 
 #include "btls-ssl.h"
+#include "btls-session-cache.h"
 #include "btls-x509-verify-param.h"
 
 struct MonoBtlsSsl {
 	MonoBtlsSslCtx *ctx;
 	SSL *ssl;
+	char *session_key;
 };
 
 #define debug_print(ptr,message) \
@@ -35,6 +37,7 @@ mono_btls_ssl_new (MonoBtlsSslCtx *ctx)
 
 	ptr->ctx = mono_btls_ssl_ctx_up_ref (ctx);
 	ptr->ssl = SSL_new (mono_btls_ssl_ctx_get_ctx (ptr->ctx));
+	SSL_set_app_data (ptr->ssl, ptr);
 
 	return ptr;
 }
@@ -51,6 +54,7 @@ mono_btls_ssl_destroy (MonoBtlsSsl *ptr)
 		mono_btls_ssl_ctx_free (ptr->ctx);
 		ptr->ctx = NULL;
 	}
+	free (ptr->session_key);
 	free (ptr);
 }
 
@@ -133,6 +137,102 @@ mono_btls_ssl_write (MonoBtlsSsl *ptr, void *buf, int count)
 	return SSL_write (ptr->ssl, buf, count);
 }
 
+/*
+ * Keep decrypting records into \p buf while BoringSSL still has plaintext or
+ * undelivered input buffered, so a whole batch of records costs a single
+ * transition from managed code.  Returns the number of bytes read, or the
+ * SSL_read () result if nothing could be read.
+ */
+int
+mono_btls_ssl_read_multiple (MonoBtlsSsl *ptr, void *buf, int count)
+{
+	uint8_t *data = buf;
+	int total = 0;
+
+	while (total < count) {
+		int ret = SSL_read (ptr->ssl, data + total, count - total);
+		if (ret <= 0)
+			return total ? total : ret;
+		total += ret;
+
+		if (!SSL_pending (ptr->ssl) && !BIO_pending (SSL_get_rbio (ptr->ssl)))
+			break;
+	}
+
+	return total;
+}
+
+/*
+ * Write the \p count buffers in \p bufs in one call.  Returns the number of
+ * bytes written, or the SSL_write () result if nothing could be written.
+ */
+int
+mono_btls_ssl_write_multiple (MonoBtlsSsl *ptr, const void **bufs, const int *lens, int count)
+{
+	int total = 0;
+	int i;
+
+	for (i = 0; i < count; i++) {
+		int ret;
+
+		if (!lens [i])
+			continue;
+		ret = SSL_write (ptr->ssl, bufs [i], lens [i]);
+		if (ret <= 0)
+			return total ? total : ret;
+		total += ret;
+	}
+
+	return total;
+}
+
+/*
+ * Resume a session from the process wide cache stored under @key, and store
+ * the session this connection ends up with there, see
+ * mono_btls_ssl_ctx_enable_session_cache ().  Must be called before the
+ * handshake, once the verify parameters and the client certificate are set,
+ * they are part of the cache key, see mono_btls_session_cache_make_key ().
+ * Returns 1 if a cached session was found.
+ */
+int
+mono_btls_ssl_set_session_key (MonoBtlsSsl *ptr, const char *key)
+{
+	SSL_SESSION *session;
+	char *cache_key;
+	int ret = 0;
+
+	free (ptr->session_key);
+	ptr->session_key = strdup (key);
+	if (!ptr->session_key)
+		return 0;
+
+	cache_key = mono_btls_session_cache_make_key (ptr->ssl, key);
+	if (!cache_key)
+		return 0;
+
+	session = mono_btls_session_cache_lookup (cache_key);
+	if (session) {
+		ret = SSL_set_session (ptr->ssl, session);
+		SSL_SESSION_free (session);
+	}
+	OPENSSL_free (cache_key);
+
+	debug_printf (ptr, "mono_btls_ssl_set_session_key(): %s - %d\n", key, ret);
+	return ret;
+}
+
+const char *
+mono_btls_ssl_get_session_key (MonoBtlsSsl *ptr)
+{
+	return ptr ? ptr->session_key : NULL;
+}
+
+int
+mono_btls_ssl_session_reused (MonoBtlsSsl *ptr)
+{
+	return SSL_session_reused (ptr->ssl);
+}
+
 int
 mono_btls_ssl_get_version (MonoBtlsSsl *ptr)
 {
@@ -44,6 +44,21 @@ mono_btls_ssl_read (MonoBtlsSsl *ptr, void *buf, int count);
 MONO_API int
 mono_btls_ssl_write (MonoBtlsSsl *ptr, void *buf, int count);
 
+MONO_API int
+mono_btls_ssl_read_multiple (MonoBtlsSsl *ptr, void *buf, int count);
+
+MONO_API int
+mono_btls_ssl_write_multiple (MonoBtlsSsl *ptr, const void **bufs, const int *lens, int count);
+
+MONO_API int
+mono_btls_ssl_set_session_key (MonoBtlsSsl *ptr, const char *key);
+
+const char *
+mono_btls_ssl_get_session_key (MonoBtlsSsl *ptr);
+
+MONO_API int
+mono_btls_ssl_session_reused (MonoBtlsSsl *ptr);
+
 MONO_API int
 mono_btls_ssl_get_version (MonoBtlsSsl *ptr);
 
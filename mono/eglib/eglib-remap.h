@@ -221,6 +221,8 @@
 #define g_string_append_printf monoeg_g_string_append_printf
 #define g_string_append_vprintf monoeg_g_string_append_vprintf
 #define g_string_free monoeg_g_string_free
+#define g_string_free_buffer monoeg_g_string_free_buffer
+#define g_string_init_with_buffer monoeg_g_string_init_with_buffer
 #define g_string_new monoeg_g_string_new
 #define g_string_new_len monoeg_g_string_new_len
 #define g_string_printf monoeg_g_string_printf
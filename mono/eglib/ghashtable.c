@@ -31,32 +31,47 @@
 #include <glib.h>
 #include <eglib-remap.h> // Remove the cast macros and restore the rename macros.
 
-typedef struct _Slot Slot;
+/*
+ * Open addressing with linear probing over a power of two sized table of
+ * inline slots. Each slot caches the hash code of its key, so probes only call
+ * the equal function on a hash match and rehashing never calls the hash
+ * function. Removed slots become tombstones (or empty slots when nothing can
+ * probe past them), which keeps removing the current key while iterating safe.
+ */
 
-struct _Slot {
+typedef struct {
 	gpointer key;
 	gpointer value;
-	Slot    *next;
-};
+	/* SLOT_EMPTY, SLOT_REMOVED or the hash code of key, see slot_hash () */
+	guint hash;
+} Slot;
+
+#define SLOT_EMPTY 0
+#define SLOT_REMOVED 1
+#define SLOT_IS_USED(s) ((s)->hash > SLOT_REMOVED)
 
-static gpointer KEYMARKER_REMOVED = &KEYMARKER_REMOVED;
+/* Must be a power of 2 */
+#define MIN_TABLE_SIZE 8
 
 struct _GHashTable {
 	GHashFunc      hash_func;
 	GEqualFunc     key_equal_func;
 
-	Slot **table;
-	int   table_size;
-	int   in_use;
-	int   threshold;
-	int   last_rehash;
+	/* NULL until the first insertion */
+	Slot *table;
+	/* A power of 2, or 0 */
+	guint table_size;
+	/* 32 - log2 (table_size) */
+	int   hash_shift;
+	guint in_use;
+	/* Number of SLOT_REMOVED slots */
+	guint removed;
 	GDestroyNotify value_destroy_func, key_destroy_func;
 };
 
 typedef struct {
 	GHashTable *ht;
 	int slot_index;
-	Slot *slot;
 } Iter;
 
 static const guint prime_tbl[] = {
@@ -106,6 +121,109 @@ g_spaced_primes_closest (guint x)
 	return calc_prime (x);
 }
 
+static inline guint
+slot_hash (GHashTable *hash, gconstpointer key)
+{
+	guint hashcode = (*hash->hash_func) (key);
+
+	/* Keep clear of the SLOT_EMPTY and SLOT_REMOVED markers */
+	return hashcode > SLOT_REMOVED ? hashcode : hashcode + 2;
+}
+
+static inline guint
+slot_index (GHashTable *hash, guint hashcode)
+{
+	/*
+	 * Fibonacci hashing: the top bits of the product depend on all the bits
+	 * of the hash code, so g_direct_hash () of aligned pointers spreads well.
+	 */
+	return (hashcode * 2654435769u) >> hash->hash_shift;
+}
+
+static int
+find_slot (GHashTable *hash, gconstpointer key, guint hashcode)
+{
+	GEqualFunc equal = hash->key_equal_func;
+	guint mask, i;
+
+	if (!hash->in_use)
+		return -1;
+
+	mask = hash->table_size - 1;
+	for (i = slot_index (hash, hashcode); ; i = (i + 1) & mask) {
+		Slot *s = &hash->table [i];
+
+		if (s->hash == SLOT_EMPTY)
+			return -1;
+		if (s->hash == hashcode && (*equal) (s->key, key))
+			return i;
+	}
+}
+
+/* The smallest table keeping COUNT entries below the 3/4 maximum load factor */
+static guint
+table_size_for (guint count)
+{
+	guint size = MIN_TABLE_SIZE;
+
+	while (count * 4 >= size * 3)
+		size <<= 1;
+	return size;
+}
+
+static void
+resize (GHashTable *hash, guint new_size)
+{
+	Slot *old_table = hash->table;
+	guint old_size = hash->table_size;
+	guint mask = new_size - 1;
+	guint i;
+	int shift = 32;
+
+	for (i = new_size; i > 1; i >>= 1)
+		shift--;
+
+	hash->table = g_new0 (Slot, new_size);
+	hash->table_size = new_size;
+	hash->hash_shift = shift;
+	hash->removed = 0;
+
+	for (i = 0; i < old_size; i++) {
+		Slot *s = &old_table [i];
+		guint j;
+
+		if (!SLOT_IS_USED (s))
+			continue;
+		for (j = slot_index (hash, s->hash); hash->table [j].hash != SLOT_EMPTY; j = (j + 1) & mask)
+			;
+		hash->table [j] = *s;
+	}
+	g_free (old_table);
+}
+
+static void
+clear_slot (GHashTable *hash, guint i)
+{
+	/* Probe sequences stop at the next empty slot anyway */
+	if (hash->table [(i + 1) & (hash->table_size - 1)].hash == SLOT_EMPTY) {
+		hash->table [i].hash = SLOT_EMPTY;
+	} else {
+		hash->table [i].hash = SLOT_REMOVED;
+		hash->removed++;
+	}
+	hash->table [i].key = NULL;
+	hash->table [i].value = NULL;
+	hash->in_use--;
+}
+
+/* Called after bulk removals, never while the caller might be iterating */
+static void
+maybe_shrink (GHashTable *hash)
+{
+	if (hash->table_size > MIN_TABLE_SIZE && hash->in_use * 8 < hash->table_size)
+		resize (hash, table_size_for (hash->in_use));
+}
+
 GHashTable *
 g_hash_table_new (GHashFunc hash_func, GEqualFunc key_equal_func)
 {
@@ -120,10 +238,6 @@ g_hash_table_new (GHashFunc hash_func, GEqualFunc key_equal_func)
 	hash->hash_func = hash_func;
 	hash->key_equal_func = key_equal_func;
 
-	hash->table_size = g_spaced_primes_closest (1);
-	hash->table = g_new0 (Slot *, hash->table_size);
-	hash->last_rehash = hash->table_size;
-	
 	return hash;
 }
 
@@ -141,44 +255,27 @@ g_hash_table_new_full (GHashFunc hash_func, GEqualFunc key_equal_func,
 	return hash;
 }
 
-#if 0
-static void
-dump_hash_table (GHashTable *hash)
-{
-	int i;
-
-	for (i = 0; i < hash->table_size; i++) {
-		Slot *s;
-
-		for (s = hash->table [i]; s != NULL; s = s->next){
-			guint hashcode = (*hash->hash_func) (s->key);
-			guint slot = (hashcode) % hash->table_size;
-			printf ("key %p hash %x on slot %d correct slot %d tb size %d\n", s->key, hashcode, i, slot, hash->table_size);
-		}
-	}
-}
-#endif
-
 #ifdef SANITY_CHECK
 static void
 sanity_check (GHashTable *hash)
 {
-	int i;
+	guint i, in_use = 0, removed = 0;
 
 	for (i = 0; i < hash->table_size; i++) {
-		Slot *s;
-
-		for (s = hash->table [i]; s != NULL; s = s->next){
-			guint hashcode = (*hash->hash_func) (s->key);
-			guint slot = (hashcode) % hash->table_size;
-			if (slot != i) {
-				dump_hashcode_func = 1;
-				hashcode = (*hash->hash_func) (s->key);
-				dump_hashcode_func = 0;
-				g_error ("Key %p (bucket %d) on invalid bucket %d (hashcode %x) (tb size %d)", s->key, slot, i, hashcode, hash->table_size);
-			}
-		}
+		Slot *s = &hash->table [i];
+
+		if (s->hash == SLOT_REMOVED)
+			removed++;
+		if (!SLOT_IS_USED (s))
+			continue;
+		in_use++;
+		if (s->hash != slot_hash (hash, s->key))
+			g_error ("Key %p in slot %d has a stale hash code %x", s->key, i, s->hash);
+		if (find_slot (hash, s->key, s->hash) != i)
+			g_error ("Key %p in slot %d can't be found (tb size %d)", s->key, i, hash->table_size);
 	}
+	if (in_use != hash->in_use || removed != hash->removed)
+		g_error ("Counted %d/%d used/removed slots, expected %d/%d", in_use, removed, hash->in_use, hash->removed);
 }
 #else
 
@@ -186,65 +283,38 @@ sanity_check (GHashTable *hash)
 
 #endif
 
-static void
-do_rehash (GHashTable *hash)
-{
-	int current_size, i;
-	Slot **table;
-
-	/* printf ("Resizing diff=%d slots=%d\n", hash->in_use - hash->last_rehash, hash->table_size); */
-	hash->last_rehash = hash->table_size;
-	current_size = hash->table_size;
-	hash->table_size = g_spaced_primes_closest (hash->in_use);
-	/* printf ("New size: %d\n", hash->table_size); */
-	table = hash->table;
-	hash->table = g_new0 (Slot *, hash->table_size);
-	
-	for (i = 0; i < current_size; i++){
-		Slot *s, *next;
-
-		for (s = table [i]; s != NULL; s = next){
-			guint hashcode = ((*hash->hash_func) (s->key)) % hash->table_size;
-			next = s->next;
-
-			s->next = hash->table [hashcode];
-			hash->table [hashcode] = s;
-		}
-	}
-	g_free (table);
-}
-
-static void
-rehash (GHashTable *hash)
-{
-	int diff = ABS (hash->last_rehash - hash->in_use);
-
-	/* These are the factors to play with to change the rehashing strategy */
-	/* I played with them with a large range, and could not really get */
-	/* something that was too good, maybe the tests are not that great */
-	if (!(diff * 0.75 > hash->table_size * 2))
-		return;
-	do_rehash (hash);
-	sanity_check (hash);
-}
-
 void
 g_hash_table_insert_replace (GHashTable *hash, gpointer key, gpointer value, gboolean replace)
 {
-	guint hashcode;
-	Slot *s;
+	guint hashcode, mask, i;
+	int removed_slot = -1;
 	GEqualFunc equal;
 	
 	g_return_if_fail (hash != NULL);
 	sanity_check (hash);
 
-	equal = hash->key_equal_func;
-	if (hash->in_use >= hash->threshold)
-		rehash (hash);
+	if ((hash->in_use + hash->removed + 1) * 4 > hash->table_size * 3) {
+		/* Mostly tombstones: clean them up, otherwise grow */
+		if (hash->removed > hash->in_use / 2)
+			resize (hash, table_size_for (hash->in_use + 1));
+		else
+			resize (hash, MAX (hash->table_size * 2, MIN_TABLE_SIZE));
+	}
 
-	hashcode = ((*hash->hash_func) (key)) % hash->table_size;
-	for (s = hash->table [hashcode]; s != NULL; s = s->next){
-		if ((*equal) (s->key, key)){
+	equal = hash->key_equal_func;
+	hashcode = slot_hash (hash, key);
+	mask = hash->table_size - 1;
+	for (i = slot_index (hash, hashcode); ; i = (i + 1) & mask) {
+		Slot *s = &hash->table [i];
+
+		if (s->hash == SLOT_EMPTY)
+			break;
+		if (s->hash == SLOT_REMOVED) {
+			if (removed_slot == -1)
+				removed_slot = i;
+			continue;
+		}
+		if (s->hash == hashcode && (*equal) (s->key, key)) {
 			if (replace){
 				if (hash->key_destroy_func != NULL)
 					(*hash->key_destroy_func)(s->key);
@@ -257,11 +327,14 @@ g_hash_table_insert_replace (GHashTable *hash, gpointer key, gpointer value, gbo
 			return;
 		}
 	}
-	s = g_new (Slot, 1);
-	s->key = key;
-	s->value = value;
-	s->next = hash->table [hashcode];
-	hash->table [hashcode] = s;
+
+	if (removed_slot != -1) {
+		i = removed_slot;
+		hash->removed--;
+	}
+	hash->table [i].key = key;
+	hash->table [i].value = value;
+	hash->table [i].hash = hashcode;
 	hash->in_use++;
 	sanity_check (hash);
 }
@@ -319,40 +392,37 @@ g_hash_table_lookup (GHashTable *hash, gconstpointer key)
 gboolean
 g_hash_table_lookup_extended (GHashTable *hash, gconstpointer key, gpointer *orig_key, gpointer *value)
 {
-	GEqualFunc equal;
-	Slot *s;
-	guint hashcode;
+	int i;
 	
 	g_return_val_if_fail (hash != NULL, FALSE);
 	sanity_check (hash);
-	equal = hash->key_equal_func;
 
-	hashcode = ((*hash->hash_func) (key)) % hash->table_size;
-	
-	for (s = hash->table [hashcode]; s != NULL; s = s->next){
-		if ((*equal)(s->key, key)){
-			if (orig_key)
-				*orig_key = s->key;
-			if (value)
-				*value = s->value;
-			return TRUE;
-		}
-	}
-	return FALSE;
+	if (!hash->in_use)
+		return FALSE;
+
+	i = find_slot (hash, key, slot_hash (hash, key));
+	if (i == -1)
+		return FALSE;
+
+	if (orig_key)
+		*orig_key = hash->table [i].key;
+	if (value)
+		*value = hash->table [i].value;
+	return TRUE;
 }
 
 void
 g_hash_table_foreach (GHashTable *hash, GHFunc func, gpointer user_data)
 {
-	int i;
+	guint i;
 	
 	g_return_if_fail (hash != NULL);
 	g_return_if_fail (func != NULL);
 
 	for (i = 0; i < hash->table_size; i++){
-		Slot *s;
+		Slot *s = &hash->table [i];
 
-		for (s = hash->table [i]; s != NULL; s = s->next)
+		if (SLOT_IS_USED (s))
 			(*func)(s->key, s->value, user_data);
 	}
 }
@@ -360,17 +430,16 @@ g_hash_table_foreach (GHashTable *hash, GHFunc func, gpointer user_data)
 gpointer
 g_hash_table_find (GHashTable *hash, GHRFunc predicate, gpointer user_data)
 {
-	int i;
+	guint i;
 	
 	g_return_val_if_fail (hash != NULL, NULL);
 	g_return_val_if_fail (predicate != NULL, NULL);
 
 	for (i = 0; i < hash->table_size; i++){
-		Slot *s;
+		Slot *s = &hash->table [i];
 
-		for (s = hash->table [i]; s != NULL; s = s->next)
-			if ((*predicate)(s->key, s->value, user_data))
-				return s->value;
+		if (SLOT_IS_USED (s) && (*predicate)(s->key, s->value, user_data))
+			return s->value;
 	}
 	return NULL;
 }
@@ -378,134 +447,74 @@ g_hash_table_find (GHashTable *hash, GHRFunc predicate, gpointer user_data)
 void
 g_hash_table_remove_all (GHashTable *hash)
 {
-	int i;
+	guint i;
 	
 	g_return_if_fail (hash != NULL);
 
 	for (i = 0; i < hash->table_size; i++){
-		Slot *s;
-
-		while (hash->table [i]) {
-			s = hash->table [i];
-			g_hash_table_remove (hash, s->key);
-		}
+		Slot *s = &hash->table [i];
+		gpointer key, value;
+
+		if (!SLOT_IS_USED (s))
+			continue;
+		key = s->key;
+		value = s->value;
+		clear_slot (hash, i);
+		if (hash->key_destroy_func != NULL)
+			(*hash->key_destroy_func)(key);
+		if (hash->value_destroy_func != NULL)
+			(*hash->value_destroy_func)(value);
 	}
+	if (hash->table)
+		memset (hash->table, 0, hash->table_size * sizeof (Slot));
+	hash->removed = 0;
 }
 
-gboolean
-g_hash_table_remove (GHashTable *hash, gconstpointer key)
+static gboolean
+remove_internal (GHashTable *hash, gconstpointer key, gboolean notify)
 {
-	GEqualFunc equal;
-	Slot *s, *last;
-	guint hashcode;
+	gpointer orig_key, value;
+	int i;
 	
 	g_return_val_if_fail (hash != NULL, FALSE);
 	sanity_check (hash);
-	equal = hash->key_equal_func;
 
-	hashcode = ((*hash->hash_func)(key)) % hash->table_size;
-	last = NULL;
-	for (s = hash->table [hashcode]; s != NULL; s = s->next){
-		if ((*equal)(s->key, key)){
-			if (hash->key_destroy_func != NULL)
-				(*hash->key_destroy_func)(s->key);
-			if (hash->value_destroy_func != NULL)
-				(*hash->value_destroy_func)(s->value);
-			if (last == NULL)
-				hash->table [hashcode] = s->next;
-			else
-				last->next = s->next;
-			g_free (s);
-			hash->in_use--;
-			sanity_check (hash);
-			return TRUE;
-		}
-		last = s;
+	if (!hash->in_use)
+		return FALSE;
+
+	i = find_slot (hash, key, slot_hash (hash, key));
+	if (i == -1)
+		return FALSE;
+
+	orig_key = hash->table [i].key;
+	value = hash->table [i].value;
+	clear_slot (hash, i);
+	if (notify) {
+		if (hash->key_destroy_func != NULL)
+			(*hash->key_destroy_func)(orig_key);
+		if (hash->value_destroy_func != NULL)
+			(*hash->value_destroy_func)(value);
 	}
 	sanity_check (hash);
-	return FALSE;
+	return TRUE;
 }
 
-guint
-g_hash_table_foreach_remove (GHashTable *hash, GHRFunc func, gpointer user_data)
+gboolean
+g_hash_table_remove (GHashTable *hash, gconstpointer key)
 {
-	int i;
-	int count = 0;
-	
-	g_return_val_if_fail (hash != NULL, 0);
-	g_return_val_if_fail (func != NULL, 0);
-
-	sanity_check (hash);
-	for (i = 0; i < hash->table_size; i++){
-		Slot *s, *last;
-
-		last = NULL;
-		for (s = hash->table [i]; s != NULL; ){
-			if ((*func)(s->key, s->value, user_data)){
-				Slot *n;
-
-				if (hash->key_destroy_func != NULL)
-					(*hash->key_destroy_func)(s->key);
-				if (hash->value_destroy_func != NULL)
-					(*hash->value_destroy_func)(s->value);
-				if (last == NULL){
-					hash->table [i] = s->next;
-					n = s->next;
-				} else  {
-					last->next = s->next;
-					n = last->next;
-				}
-				g_free (s);
-				hash->in_use--;
-				count++;
-				s = n;
-			} else {
-				last = s;
-				s = s->next;
-			}
-		}
-	}
-	sanity_check (hash);
-	if (count > 0)
-		rehash (hash);
-	return count;
+	return remove_internal (hash, key, TRUE);
 }
 
 gboolean
 g_hash_table_steal (GHashTable *hash, gconstpointer key)
 {
-	GEqualFunc equal;
-	Slot *s, *last;
-	guint hashcode;
-	
-	g_return_val_if_fail (hash != NULL, FALSE);
-	sanity_check (hash);
-	equal = hash->key_equal_func;
-	
-	hashcode = ((*hash->hash_func)(key)) % hash->table_size;
-	last = NULL;
-	for (s = hash->table [hashcode]; s != NULL; s = s->next){
-		if ((*equal)(s->key, key)) {
-			if (last == NULL)
-				hash->table [hashcode] = s->next;
-			else
-				last->next = s->next;
-			g_free (s);
-			hash->in_use--;
-			sanity_check (hash);
-			return TRUE;
-		}
-		last = s;
-	}
-	sanity_check (hash);
-	return FALSE;
-	
+	return remove_internal (hash, key, FALSE);
 }
 
-guint
-g_hash_table_foreach_steal (GHashTable *hash, GHRFunc func, gpointer user_data)
+static guint
+foreach_remove_internal (GHashTable *hash, GHRFunc func, gpointer user_data, gboolean notify)
 {
-	int i;
+	guint i;
 	int count = 0;
 	
 	g_return_val_if_fail (hash != NULL, 0);
@@ -513,56 +522,62 @@ g_hash_table_foreach_steal (GHashTable *hash, GHRFunc func, gpointer user_data)
 
 	sanity_check (hash);
 	for (i = 0; i < hash->table_size; i++){
-		Slot *s, *last;
-
-		last = NULL;
-		for (s = hash->table [i]; s != NULL; ){
-			if ((*func)(s->key, s->value, user_data)){
-				Slot *n;
-
-				if (last == NULL){
-					hash->table [i] = s->next;
-					n = s->next;
-				} else  {
-					last->next = s->next;
-					n = last->next;
-				}
-				g_free (s);
-				hash->in_use--;
-				count++;
-				s = n;
-			} else {
-				last = s;
-				s = s->next;
-			}
+		Slot *s = &hash->table [i];
+		gpointer key, value;
+
+		if (!SLOT_IS_USED (s) || !(*func)(s->key, s->value, user_data))
+			continue;
+
+		key = s->key;
+		value = s->value;
+		/* Always a tombstone so the slots after this one keep their place */
+		s->hash = SLOT_REMOVED;
+		s->key = s->value = NULL;
+		hash->removed++;
+		hash->in_use--;
+		count++;
+		if (notify) {
+			if (hash->key_destroy_func != NULL)
+				(*hash->key_destroy_func)(key);
+			if (hash->value_destroy_func != NULL)
+				(*hash->value_destroy_func)(value);
 		}
 	}
 	sanity_check (hash);
 	if (count > 0)
-		rehash (hash);
+		maybe_shrink (hash);
 	return count;
 }
 
+guint
+g_hash_table_foreach_remove (GHashTable *hash, GHRFunc func, gpointer user_data)
+{
+	return foreach_remove_internal (hash, func, user_data, TRUE);
+}
+
+guint
+g_hash_table_foreach_steal (GHashTable *hash, GHRFunc func, gpointer user_data)
+{
+	return foreach_remove_internal (hash, func, user_data, FALSE);
+}
+
 void
 g_hash_table_destroy (GHashTable *hash)
 {
-	int i;
+	guint i;
 
 	if (!hash)
 		return;
 
 	for (i = 0; i < hash->table_size; i++){
-		Slot *s, *next;
-
-		for (s = hash->table [i]; s != NULL; s = next){
-			next = s->next;
-			
-			if (hash->key_destroy_func != NULL)
-				(*hash->key_destroy_func)(s->key);
-			if (hash->value_destroy_func != NULL)
-				(*hash->value_destroy_func)(s->value);
-			g_free (s);
-		}
+		Slot *s = &hash->table [i];
+
+		if (!SLOT_IS_USED (s))
+			continue;
+		if (hash->key_destroy_func != NULL)
+			(*hash->key_destroy_func)(s->key);
+		if (hash->value_destroy_func != NULL)
+			(*hash->value_destroy_func)(s->value);
 	}
 	g_free (hash->table);
 	
@@ -572,22 +587,28 @@ g_hash_table_destroy (GHashTable *hash)
 void
 g_hash_table_print_stats (GHashTable *table)
 {
-	int i, max_chain_index, chain_size, max_chain_size;
-	Slot *node;
+	guint i, mask, probe_len, max_probe_len, total_probe_len;
+	int max_probe_index;
 
-	max_chain_size = 0;
-	max_chain_index = -1;
+	mask = table->table_size - 1;
+	max_probe_len = total_probe_len = 0;
+	max_probe_index = -1;
 	for (i = 0; i < table->table_size; i++) {
-		chain_size = 0;
-		for (node = table->table [i]; node; node = node->next)
-			chain_size ++;
-		if (chain_size > max_chain_size) {
-			max_chain_size = chain_size;
-			max_chain_index = i;
+		Slot *s = &table->table [i];
+
+		if (!SLOT_IS_USED (s))
+			continue;
+		probe_len = ((i - slot_index (table, s->hash)) & mask) + 1;
+		total_probe_len += probe_len;
+		if (probe_len > max_probe_len) {
+			max_probe_len = probe_len;
+			max_probe_index = i;
 		}
 	}
 
-	printf ("Size: %d Table Size: %d Max Chain Length: %d at %d\n", table->in_use, table->table_size, max_chain_size, max_chain_index);
+	printf ("Size: %u Table Size: %u Removed: %u Max Probe Length: %u at %d Avg Probe Length: %.2f\n",
+		table->in_use, table->table_size, table->removed, max_probe_len, max_probe_index,
+		table->in_use ? (double)total_probe_len / table->in_use : 0.0);
 }
 
 void
@@ -605,28 +626,26 @@ gboolean g_hash_table_iter_next (GHashTableIter *it, gpointer *key, gpointer *va
 	Iter *iter = (Iter*)it;
 
 	GHashTable *hash = iter->ht;
+	Slot *s;
 
 	g_assert (iter->slot_index != -2);
 	g_assert (sizeof (Iter) <= sizeof (GHashTableIter));
 
-	if (!iter->slot) {
-		while (TRUE) {
-			iter->slot_index ++;
-			if (iter->slot_index >= hash->table_size) {
-				iter->slot_index = -2;
-				return FALSE;
-			}
-			if (hash->table [iter->slot_index])
-				break;
+	while (TRUE) {
+		iter->slot_index ++;
+		if (iter->slot_index >= (int)hash->table_size) {
+			iter->slot_index = -2;
+			return FALSE;
 		}
-		iter->slot = hash->table [iter->slot_index];
+		if (SLOT_IS_USED (&hash->table [iter->slot_index]))
+			break;
 	}
 
+	s = &hash->table [iter->slot_index];
 	if (key)
-		*key = iter->slot->key;
+		*key = s->key;
 	if (value)
-		*value = iter->slot->value;
-	iter->slot = iter->slot->next;
+		*value = s->value;
 
 	return TRUE;
 }
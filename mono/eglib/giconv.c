@@ -829,6 +829,59 @@ g_utf8_to_ucs4_fast (const gchar *str, glong len, glong *items_written)
 	return outbuf;
 }
 
+/*
+ * Returns the number of leading ASCII bytes of @str, stopping at the first
+ * non-ASCII or NUL byte. Eight bytes are checked at a time.
+ */
+glong
+eg_utf8_ascii_prefix (const gchar *str, glong len)
+{
+	const guint64 ones = (guint64)0x0101010101010101ULL;
+	const guint64 highs = (guint64)0x8080808080808080ULL;
+	glong i = 0;
+	
+	for (; i + 8 <= len; i += 8) {
+		guint64 v;
+		
+		memcpy (&v, str + i, sizeof (v));
+		/* Once the high bits are clear, a borrow into the high bit only comes from a NUL */
+		if ((v & highs) || ((v - ones) & ~v & highs))
+			break;
+	}
+	
+	while (i < len && str [i] != 0 && !((guchar) str [i] & 0x80))
+		i++;
+	
+	return i;
+}
+
+/*
+ * Returns the number of leading ASCII characters of @str, stopping at the first
+ * non-ASCII or NUL character. Four characters are checked at a time.
+ */
+static glong
+utf16_ascii_prefix (const gunichar2 *str, glong len)
+{
+	const guint64 non_ascii = (guint64)0xff80ff80ff80ff80ULL;
+	const guint64 ones = (guint64)0x0001000100010001ULL;
+	const guint64 highs = (guint64)0x8000800080008000ULL;
+	glong i = 0;
+	
+	for (; i + 4 <= len; i += 4) {
+		guint64 v;
+		
+		memcpy (&v, str + i, sizeof (v));
+		/* Once the high bits are clear, a borrow into the high bit only comes from a NUL */
+		if ((v & non_ascii) || ((v - ones) & ~v & highs))
+			break;
+	}
+	
+	while (i < len && str [i] != 0 && str [i] < 0x80)
+		i++;
+	
+	return i;
+}
+
 static gunichar2 *
 eg_utf8_to_utf16_general (const gchar *str, glong len, glong *items_read, glong *items_written, gboolean include_nuls, gboolean replace_invalid_codepoints,	GError **err) 
 {
@@ -837,6 +890,7 @@ eg_utf8_to_utf16_general (const gchar *str, glong len, glong *items_read, glong
 	size_t inleft;
 	char *inptr;
 	gunichar c;
+	glong i, ascii;
 	int u, n;
 	
 	g_return_val_if_fail (str != NULL, NULL);
@@ -854,6 +908,14 @@ eg_utf8_to_utf16_general (const gchar *str, glong len, glong *items_read, glong
 	inleft = len;
 	
 	while (inleft > 0) {
+		/* ASCII runs need no decoding, and take one UTF-16 char per byte */
+		if ((ascii = eg_utf8_ascii_prefix (inptr, inleft)) > 0) {
+			outlen += ascii;
+			inleft -= ascii;
+			inptr += ascii;
+			continue;
+		}
+		
 		if ((n = decode_utf8 (inptr, inleft, &c)) < 0)
 			goto error;
 		
@@ -885,6 +947,14 @@ eg_utf8_to_utf16_general (const gchar *str, glong len, glong *items_read, glong
 	inleft = len;
 	
 	while (inleft > 0) {
+		if ((ascii = eg_utf8_ascii_prefix (inptr, inleft)) > 0) {
+			for (i = 0; i < ascii; i++)
+				*outptr++ = (guchar) inptr [i];
+			inleft -= ascii;
+			inptr += ascii;
+			continue;
+		}
+		
 		if ((n = decode_utf8 (inptr, inleft, &c)) < 0)
 			break;
 		
@@ -1024,6 +1094,7 @@ g_utf16_to_utf8 (const gunichar2 *str, glong len, glong *items_read, glong *item
 	size_t outlen = 0;
 	size_t inleft;
 	gunichar c;
+	glong i, ascii;
 	int n;
 	
 	g_return_val_if_fail (str != NULL, NULL);
@@ -1034,10 +1105,36 @@ g_utf16_to_utf8 (const gunichar2 *str, glong len, glong *items_read, glong *item
 			len++;
 	}
 	
-	inptr = (char *) str;
-	inleft = len * 2;
+	/* Fast path for ASCII strings, which need no decoding */
+	ascii = utf16_ascii_prefix (str, len);
+	if (ascii == len || str [ascii] == 0) {
+		outbuf = g_malloc (ascii + 1);
+		for (i = 0; i < ascii; i++)
+			outbuf [i] = (char) str [i];
+		outbuf [ascii] = '\0';
+		
+		if (items_read)
+			*items_read = ascii;
+		
+		if (items_written)
+			*items_written = ascii;
+		
+		return outbuf;
+	}
+	
+	/* The ASCII prefix was counted above */
+	outlen = ascii;
+	inptr = (char *) (str + ascii);
+	inleft = (len - ascii) * 2;
 	
 	while (inleft > 0) {
+		if ((ascii = utf16_ascii_prefix ((gunichar2 *) inptr, inleft / 2)) > 0) {
+			outlen += ascii;
+			inleft -= ascii * 2;
+			inptr += ascii * 2;
+			continue;
+		}
+		
 		if ((n = decode_utf16 (inptr, inleft, &c)) < 0) {
 			if (n == -2 && inleft > 2) {
 				/* This means that the first UTF-16 char was read, but second failed */
@@ -1082,6 +1179,14 @@ g_utf16_to_utf8 (const gunichar2 *str, glong len, glong *items_read, glong *item
 	inleft = len * 2;
 	
 	while (inleft > 0) {
+		if ((ascii = utf16_ascii_prefix ((gunichar2 *) inptr, inleft / 2)) > 0) {
+			for (i = 0; i < ascii; i++)
+				*outptr++ = (char) ((gunichar2 *) inptr) [i];
+			inleft -= ascii * 2;
+			inptr += ascii * 2;
+			continue;
+		}
+		
 		if ((n = decode_utf16 (inptr, inleft, &c)) < 0)
 			break;
 		else if (c == 0)
@@ -431,6 +431,8 @@ typedef struct {
 	char *str;
 	gsize len;
 	gsize allocated_len;
+	/* Caller provided storage, see g_string_init_with_buffer () */
+	char *fixed_buffer;
 } GString;
 
 GString     *g_string_new           (const gchar *init);
@@ -448,6 +450,21 @@ GString     *g_string_append        (GString *string, const gchar *val);
 GString     *g_string_append_len    (GString *string, const gchar *val, gssize len);
 GString     *g_string_truncate      (GString *string, gsize len);
 GString     *g_string_set_size      (GString *string, gsize len);
+void         g_string_init_with_buffer (GString *string, gchar *buffer, gsize size);
+gchar       *g_string_free_buffer   (GString *string, gboolean free_segment);
+
+/*
+ * A GString on the stack which starts out in a buffer next to it, for building
+ * short-lived strings without allocating:
+ *
+ *	G_STRING_DECLARE_ON_STACK (str, 128);
+ *	g_string_append (str, ...);
+ *	return g_string_free_buffer (str, FALSE);
+ */
+#define G_STRING_DECLARE_ON_STACK(name, size) \
+	GString name##_storage; \
+	gchar name##_buffer [size]; \
+	GString *name = (g_string_init_with_buffer (&name##_storage, name##_buffer, (size)), &name##_storage)
 
 #define g_string_sprintfa g_string_append_printf
 
@@ -960,6 +977,7 @@ G_EXTERN_C // Used by libtest, at least.
 gunichar2 *g_utf8_to_utf16 (const gchar *str, glong len, glong *items_read, glong *items_written, GError **err);
 gunichar2 *eg_utf8_to_utf16_with_nuls (const gchar *str, glong len, glong *items_read, glong *items_written, GError **err);
 gunichar2 *eg_wtf8_to_utf16 (const gchar *str, glong len, glong *items_read, glong *items_written, GError **err);
+glong      eg_utf8_ascii_prefix (const gchar *str, glong len);
 G_EXTERN_C // Used by libtest, at least.
 gchar     *g_utf16_to_utf8 (const gunichar2 *str, glong len, glong *items_read, glong *items_written, GError **err);
 gunichar  *g_utf16_to_ucs4 (const gunichar2 *str, glong len, glong *items_read, glong *items_written, GError **err);
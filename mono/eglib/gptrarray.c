@@ -29,12 +29,17 @@
  */
 #include "config.h"
 #include <stdlib.h>
+#include <string.h>
 #include <glib.h>
 
+/* Small arrays keep their elements in the array itself, saving an allocation */
+#define PTR_ARRAY_INLINE_SIZE 4
+
 typedef struct _GPtrArrayPriv {
 	gpointer *pdata;
 	guint len;
 	guint size;
+	gpointer inline_data [PTR_ARRAY_INLINE_SIZE];
 } GPtrArrayPriv;
 
 static void 
@@ -55,7 +60,12 @@ g_ptr_array_grow(GPtrArrayPriv *array, guint length)
 	}
 
 	array->size = MAX(array->size, 16);
-	array->pdata = g_realloc(array->pdata, array->size * sizeof(gpointer));
+	if (array->pdata == array->inline_data) {
+		array->pdata = g_new (gpointer, array->size);
+		memcpy (array->pdata, array->inline_data, array->len * sizeof (gpointer));
+	} else {
+		array->pdata = g_realloc(array->pdata, array->size * sizeof(gpointer));
+	}
 }
 
 GPtrArray *
@@ -69,9 +79,9 @@ g_ptr_array_sized_new(guint reserved_size)
 {
 	GPtrArrayPriv *array = g_new0(GPtrArrayPriv, 1);
 
-	array->pdata = NULL;
+	array->pdata = array->inline_data;
 	array->len = 0;
-	array->size = 0;
+	array->size = PTR_ARRAY_INLINE_SIZE;
 
 	if(reserved_size > 0) {
 		g_ptr_array_grow(array, reserved_size);
@@ -83,11 +93,16 @@ g_ptr_array_sized_new(guint reserved_size)
 gpointer *
 g_ptr_array_free(GPtrArray *array, gboolean free_seg)
 {
+	GPtrArrayPriv *priv = (GPtrArrayPriv *)array;
 	gpointer *data = NULL;
 	
 	g_return_val_if_fail(array != NULL, NULL);
 
-	if(free_seg) {
+	if (priv->pdata == priv->inline_data) {
+		/* The elements go away with the array, the caller gets a copy */
+		if (!free_seg)
+			data = (gpointer *)g_memdup (priv->inline_data, sizeof (priv->inline_data));
+	} else if(free_seg) {
 		g_free(array->pdata);
 	} else {
 		data = array->pdata;
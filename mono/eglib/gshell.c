@@ -117,22 +117,21 @@ g_shell_parse_argv (const gchar *command_line, gint *argcp, gchar ***argvp, GErr
 	array = g_ptr_array_new();
 	if (split_cmdline (command_line, array, gerror)) {
 		g_ptr_array_add (array, NULL);
-		g_strfreev ((gchar **) array->pdata);
-		g_ptr_array_free (array, FALSE);
+		g_strfreev ((gchar **) g_ptr_array_free (array, FALSE));
 		return FALSE;
 	}
 
 	argc = array->len;
-	argv = (gchar **) array->pdata;
+	/* Small arrays store their elements inline, only the returned copy outlives the array */
+	argv = (gchar **) g_ptr_array_free (array, FALSE);
 
 	if (argc == 1) {
 		g_strfreev (argv);
-		g_ptr_array_free (array, FALSE);
 		return FALSE;
 	}
 
 	if (argcp) {
-		*argcp = array->len - 1;
+		*argcp = argc - 1;
 	}
 
 	if (argvp) {
@@ -141,7 +140,6 @@ g_shell_parse_argv (const gchar *command_line, gint *argcp, gchar ***argvp, GErr
 		g_strfreev (argv);
 	}
 
-	g_ptr_array_free (array, FALSE);
 	return TRUE;
 }
 
@@ -31,10 +31,24 @@
 #include <glib.h>
 
 #define GROW_IF_NECESSARY(s,l) { \
-	if(s->len + l >= s->allocated_len) { \
-		s->allocated_len = (s->allocated_len + l + 16) * 2; \
-		s->str = g_realloc(s->str, s->allocated_len); \
-	} \
+	if(s->len + l >= s->allocated_len) \
+		g_string_grow (s, l); \
+}
+
+static void
+g_string_grow (GString *string, gsize len)
+{
+	gsize allocated_len = (string->allocated_len + len + 16) * 2;
+
+	if (string->str == string->fixed_buffer) {
+		/* Move out of the caller's buffer */
+		gchar *str = g_malloc (allocated_len);
+		memcpy (str, string->str, string->len + 1);
+		string->str = str;
+	} else {
+		string->str = g_realloc (string->str, allocated_len);
+	}
+	string->allocated_len = allocated_len;
 }
 
 GString *
@@ -48,6 +62,7 @@ g_string_new_len (const gchar *init, gssize len)
 		ret->len = len < 0 ? strlen(init) : len;
 	ret->allocated_len = MAX(ret->len + 1, 16);
 	ret->str = g_malloc(ret->allocated_len);
+	ret->fixed_buffer = NULL;
 	if (init)
 		memcpy(ret->str, init, ret->len);
 	ret->str[ret->len] = 0;
@@ -70,10 +85,53 @@ g_string_sized_new (gsize default_size)
 	ret->str [0] = 0;
 	ret->len = 0;
 	ret->allocated_len = default_size;
+	ret->fixed_buffer = NULL;
 
 	return ret;
 }
 
+/**
+ * g_string_init_with_buffer:
+ *
+ * Initialize \p string to an empty string stored in the \p size bytes at
+ * \p buffer, which the caller owns. It moves to the heap if it outgrows
+ * them. Release it with g_string_free_buffer (), not g_string_free ().
+ */
+void
+g_string_init_with_buffer (GString *string, gchar *buffer, gsize size)
+{
+	g_return_if_fail (size > 0);
+
+	string->str = buffer;
+	string->str [0] = 0;
+	string->len = 0;
+	string->allocated_len = size;
+	string->fixed_buffer = buffer;
+}
+
+/**
+ * g_string_free_buffer:
+ *
+ * Release the storage of a string set up with g_string_init_with_buffer ().
+ * \returns the contents in newly allocated memory if \p free_segment is
+ * FALSE, NULL otherwise.
+ */
+gchar *
+g_string_free_buffer (GString *string, gboolean free_segment)
+{
+	gchar *data;
+
+	g_return_val_if_fail (string != NULL, NULL);
+
+	data = string->str;
+	if (data == string->fixed_buffer)
+		data = free_segment ? NULL : (gchar *) g_memdup (data, string->len + 1);
+	else if (free_segment)
+		g_free (data);
+
+	return free_segment ? NULL : data;
+}
+
 gchar *
 g_string_free (GString *string, gboolean free_segment)
 {
@@ -150,31 +208,47 @@ g_string_append_unichar (GString *string, gunichar c)
 void
 g_string_append_printf (GString *string, const gchar *format, ...)
 {
-	char *ret;
 	va_list args;
 	
 	g_return_if_fail (string != NULL);
 	g_return_if_fail (format != NULL);
 
 	va_start (args, format);
-	ret = g_strdup_vprintf (format, args);
+	g_string_append_vprintf (string, format, args);
 	va_end (args);
-	g_string_append (string, ret);
-
-	g_free (ret);
 }
 
 void
 g_string_append_vprintf (GString *string, const gchar *format, va_list args)
 {
-	char *ret;
+	va_list args2;
+	gsize avail;
+	int len;
 
 	g_return_if_fail (string != NULL);
 	g_return_if_fail (format != NULL);
 
-	ret = g_strdup_vprintf (format, args);
-	g_string_append (string, ret);
-	g_free (ret);
+#if defined(_MSC_VER) || defined(__MINGW64_VERSION_MAJOR)
+	args2 = args;
+	len = _vscprintf (format, args2); // vsnprintf () doesn't report the length it needed
+	avail = 0;
+#else
+	/* Format straight into the spare room, and only again if it didn't fit */
+	avail = string->allocated_len - string->len;
+	va_copy (args2, args);
+	len = vsnprintf (string->str + string->len, avail, format, args2);
+	va_end (args2);
+#endif
+	if (len < 0) {
+		string->str [string->len] = 0;
+		return;
+	}
+
+	if ((gsize)len >= avail) {
+		GROW_IF_NECESSARY (string, (gsize)len);
+		len = vsnprintf (string->str + string->len, string->allocated_len - string->len, format, args);
+	}
+	string->len += len;
 }
 
 void
@@ -185,14 +259,12 @@ g_string_printf (GString *string, const gchar *format, ...)
 	g_return_if_fail (string != NULL);
 	g_return_if_fail (format != NULL);
 
-	g_free (string->str);
-	
+	string->len = 0;
+	string->str [0] = 0;
+
 	va_start (args, format);
-	string->str = g_strdup_vprintf (format, args);
+	g_string_append_vprintf (string, format, args);
 	va_end (args);
-
-	string->len = strlen (string->str);
-	string->allocated_len = string->len+1;
 }
 
 GString *
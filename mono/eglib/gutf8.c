@@ -132,6 +132,12 @@ g_utf8_validate (const gchar *str, gssize max_len, const gchar **end)
 	
 	if (max_len < 0) {
 		while (*inptr != 0) {
+			if (*inptr < 0x80) {
+				/* ASCII needs no validation */
+				inptr++;
+				continue;
+			}
+			
 			length = g_utf8_jump_table[*inptr];
 			if (!utf8_validate (inptr, length)) {
 				valid = FALSE;
@@ -142,6 +148,14 @@ g_utf8_validate (const gchar *str, gssize max_len, const gchar **end)
 		}
 	} else {
 		while (n < max_len) {
+			gssize ascii = eg_utf8_ascii_prefix ((gchar *) inptr, max_len - n);
+			
+			/* ASCII runs need no validation */
+			inptr += ascii;
+			n += ascii;
+			if (n == max_len)
+				break;
+			
 			if (*inptr == 0) {
 				/* Note: return FALSE if we encounter nul-byte
 				 * before max_len is reached. */
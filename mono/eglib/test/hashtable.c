@@ -169,6 +169,148 @@ hash_iter (void)
 #endif
 }
 
+static int destroyed_keys, destroyed_values;
+
+static void
+count_key_destroy (gpointer data)
+{
+	destroyed_keys++;
+}
+
+static void
+count_value_destroy (gpointer data)
+{
+	destroyed_values++;
+}
+
+static gboolean
+is_odd (gpointer key, gpointer value, gpointer user_data)
+{
+	return (GPOINTER_TO_UINT (key) & 1) != 0;
+}
+
+static RESULT
+hash_remove (void)
+{
+	GHashTable *hash = g_hash_table_new_full (g_direct_hash, g_direct_equal, count_key_destroy, count_value_destroy);
+	guint i;
+
+	destroyed_keys = destroyed_values = 0;
+	for (i = 1; i <= 10000; i++)
+		g_hash_table_insert (hash, GUINT_TO_POINTER (i), GUINT_TO_POINTER (i));
+
+	for (i = 1; i <= 10000; i += 2) {
+		if (!g_hash_table_remove (hash, GUINT_TO_POINTER (i)))
+			return FAILED ("Could not remove %d", i);
+	}
+	if (g_hash_table_remove (hash, GUINT_TO_POINTER (1)))
+		return FAILED ("Removed 1 twice");
+	if (destroyed_keys != 5000 || destroyed_values != 5000)
+		return FAILED ("Destroy notifiers called %d/%d times", destroyed_keys, destroyed_values);
+	if (g_hash_table_size (hash) != 5000)
+		return FAILED ("Expected 5000 elements, found %d", g_hash_table_size (hash));
+
+	for (i = 1; i <= 10000; i++) {
+		gpointer value = g_hash_table_lookup (hash, GUINT_TO_POINTER (i));
+		if ((i & 1) && value)
+			return FAILED ("Found removed key %d", i);
+		if (!(i & 1) && value != GUINT_TO_POINTER (i))
+			return FAILED ("Lost key %d", i);
+	}
+
+	/* Reuse the removed slots */
+	for (i = 1; i <= 10000; i += 2)
+		g_hash_table_insert (hash, GUINT_TO_POINTER (i), GUINT_TO_POINTER (i));
+	if (g_hash_table_size (hash) != 10000)
+		return FAILED ("Expected 10000 elements, found %d", g_hash_table_size (hash));
+
+	if (g_hash_table_foreach_remove (hash, is_odd, NULL) != 5000)
+		return FAILED ("foreach_remove didn't remove 5000 elements");
+	if (g_hash_table_foreach_steal (hash, is_odd, NULL) != 0)
+		return FAILED ("foreach_steal removed even elements");
+	if (!g_hash_table_steal (hash, GUINT_TO_POINTER (2)) || g_hash_table_lookup (hash, GUINT_TO_POINTER (2)))
+		return FAILED ("Could not steal 2");
+	if (destroyed_keys != 10000)
+		return FAILED ("Destroy notifiers called %d times", destroyed_keys);
+
+	g_hash_table_remove_all (hash);
+	if (g_hash_table_size (hash) != 0 || g_hash_table_lookup (hash, GUINT_TO_POINTER (4)))
+		return FAILED ("remove_all left elements behind");
+	g_hash_table_insert (hash, GUINT_TO_POINTER (4), GUINT_TO_POINTER (4));
+	if (g_hash_table_lookup (hash, GUINT_TO_POINTER (4)) != GUINT_TO_POINTER (4))
+		return FAILED ("Could not insert after remove_all");
+
+	g_hash_table_destroy (hash);
+	return OK;
+}
+
+static RESULT
+hash_iter_remove (void)
+{
+	GHashTable *hash = g_hash_table_new (g_direct_hash, g_direct_equal);
+	GHashTableIter iter;
+	gpointer key;
+	int i, count = 0;
+
+	for (i = 0; i < 1000; i++)
+		g_hash_table_insert (hash, GINT_TO_POINTER (i * 8), GINT_TO_POINTER (i));
+
+	/* Removing the current element must not make the iterator skip any */
+	g_hash_table_iter_init (&iter, hash);
+	while (g_hash_table_iter_next (&iter, &key, NULL)) {
+		g_hash_table_remove (hash, key);
+		count++;
+	}
+	if (count != 1000)
+		return FAILED ("Iterated over %d elements instead of 1000", count);
+	if (g_hash_table_size (hash) != 0)
+		return FAILED ("%d elements left", g_hash_table_size (hash));
+
+	g_hash_table_destroy (hash);
+	return OK;
+}
+
+/* Run with -t to compare the speed of the implementations, see test-both */
+static RESULT
+hash_bench (void)
+{
+	GHashTable *hash = g_hash_table_new (NULL, NULL);
+	GHashTable *str_hash = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	gpointer *ptrs = g_new (gpointer, 100000);
+	int i, found = 0;
+
+	/* Aligned pointers, like most runtime caches use as keys */
+	for (i = 0; i < 100000; i++)
+		ptrs [i] = GUINT_TO_POINTER (0x10000000 + i * 16);
+
+	for (i = 0; i < 100000; i++)
+		g_hash_table_insert (hash, ptrs [i], ptrs [i]);
+	for (i = 0; i < 100000 * 4; i++)
+		found += g_hash_table_lookup (hash, ptrs [i % 100000]) != NULL;
+	for (i = 0; i < 100000; i++)
+		found -= g_hash_table_lookup (hash, GUINT_TO_POINTER (GPOINTER_TO_UINT (ptrs [i]) + 8)) != NULL;
+	for (i = 0; i < 100000; i += 2)
+		g_hash_table_remove (hash, ptrs [i]);
+	if (found != 400000 || g_hash_table_size (hash) != 50000)
+		return FAILED ("Pointer keys: found %d, size %d", found, g_hash_table_size (hash));
+
+	found = 0;
+	for (i = 0; i < 20000; i++)
+		g_hash_table_insert (str_hash, g_strdup_printf ("System.Collections.Generic.List`1::Item%d", i), GINT_TO_POINTER (i + 1));
+	for (i = 0; i < 20000; i++) {
+		char buffer [64];
+		sprintf (buffer, "System.Collections.Generic.List`1::Item%d", i);
+		found += g_hash_table_lookup (str_hash, buffer) == GINT_TO_POINTER (i + 1);
+	}
+	if (found != 20000)
+		return FAILED ("String keys: found %d", found);
+
+	g_hash_table_destroy (str_hash);
+	g_hash_table_destroy (hash);
+	g_free (ptrs);
+	return OK;
+}
+
 static Test hashtable_tests [] = {
 	{"t1", hash_t1},
 	{"t2", hash_t2},
@@ -176,6 +318,9 @@ static Test hashtable_tests [] = {
 	{"default", hash_default},
 	{"null_lookup", hash_null_lookup},
 	{"iter", hash_iter},
+	{"remove", hash_remove},
+	{"iter_remove", hash_iter_remove},
+	{"bench", hash_bench},
 	{NULL, NULL}
 };
 
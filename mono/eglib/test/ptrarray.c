@@ -7,6 +7,7 @@ typedef struct _GPtrArrayPriv {
 	gpointer *pdata;
 	guint len;
 	guint size;
+	gpointer inline_data [4];
 } GPtrArrayPriv;
 
 /* Don't add more than 32 items to this please */
@@ -343,6 +344,35 @@ ptrarray_remove_fast (void)
 	return OK;
 }
 
+static RESULT
+ptrarray_inline (void)
+{
+	GPtrArrayPriv *array = (GPtrArrayPriv *)g_ptr_array_new ();
+	gpointer *data;
+	guint i;
+
+	g_ptr_array_add ((GPtrArray *)array, (gpointer)items[0]);
+	g_ptr_array_add ((GPtrArray *)array, (gpointer)items[1]);
+	if (array->pdata != array->inline_data)
+		return FAILED ("Small arrays should be stored inline");
+
+	data = g_ptr_array_free ((GPtrArray *)array, FALSE);
+	if (data [0] != items[0] || data [1] != items[1])
+		return FAILED ("The returned copy has the wrong elements");
+	g_free (data);
+
+	array = (GPtrArrayPriv *)ptrarray_alloc_and_fill (NULL);
+	if (array->pdata == array->inline_data)
+		return FAILED ("Large arrays should not be stored inline");
+	for (i = 0; i < array->len; i++) {
+		if (array->pdata [i] != items[i])
+			return FAILED ("Item %d was lost when the array grew", i);
+	}
+	g_ptr_array_free ((GPtrArray *)array, TRUE);
+
+	return OK;
+}
+
 static Test ptrarray_tests [] = {
 	{"alloc", ptrarray_alloc},
 	{"for_iterate", ptrarray_for_iterate},
@@ -354,6 +384,7 @@ static Test ptrarray_tests [] = {
 	{"sort", ptrarray_sort},
 	{"remove_fast", ptrarray_remove_fast},
 	{"sort_with_data", ptrarray_sort_with_data},
+	{"inline", ptrarray_inline},
 	{NULL, NULL}
 };
 
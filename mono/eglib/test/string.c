@@ -202,6 +202,99 @@ test_strnlen (void)
 	return NULL;
 }
 
+static RESULT
+test_printf (void)
+{
+	GString *s = g_string_new ("");
+	gint i;
+
+	/* Starts out in the spare room, then has to grow */
+	for (i = 0; i < 100; i++)
+		g_string_append_printf (s, "%d,", i);
+	if (s->len != strlen (s->str) || strncmp (s->str, "0,1,2,", 6) != 0 || strcmp (s->str + s->len - 3, "99,") != 0)
+		return FAILED ("Incorrect string, got: %s", s->str);
+
+	g_string_printf (s, "%s-%d", "abc", 42);
+	if (strcmp (s->str, "abc-42") != 0 || s->len != 6)
+		return FAILED ("Incorrect printf result: %s", s->str);
+
+	g_string_free (s, TRUE);
+	return OK;
+}
+
+static RESULT
+test_buffer (void)
+{
+	gchar buffer [8];
+	GString s;
+	char *ret;
+
+	g_string_init_with_buffer (&s, buffer, sizeof (buffer));
+	g_string_append (&s, "abc");
+	if (s.str != buffer || strcmp (s.str, "abc") != 0)
+		return FAILED ("Short strings should stay in the buffer");
+
+	ret = g_string_free_buffer (&s, FALSE);
+	if (ret == buffer || strcmp (ret, "abc") != 0)
+		return FAILED ("Should return a copy of the buffer, got: %s", ret);
+	g_free (ret);
+
+	g_string_init_with_buffer (&s, buffer, sizeof (buffer));
+	g_string_append (&s, "abc");
+	g_string_append_printf (&s, "%s", "defghijkl");
+	if (s.str == buffer || strcmp (s.str, "abcdefghijkl") != 0)
+		return FAILED ("Long strings should move to the heap, got: %s", s.str);
+
+	ret = g_string_free_buffer (&s, FALSE);
+	if (strcmp (ret, "abcdefghijkl") != 0)
+		return FAILED ("Incorrect result: %s", ret);
+	g_free (ret);
+
+	g_string_init_with_buffer (&s, buffer, sizeof (buffer));
+	g_string_append (&s, "abcdefghijkl");
+	if (g_string_free_buffer (&s, TRUE) != NULL)
+		return FAILED ("Should return NULL when freeing the segment");
+
+	return OK;
+}
+
+/* Build a lot of short-lived type name sized strings, run with -t to compare the two */
+#define SHORT_LIVED_COUNT 100000
+
+static RESULT
+test_short_lived_heap_speed (void)
+{
+	gint i;
+
+	for (i = 0; i < SHORT_LIVED_COUNT; i++) {
+		GString *s = g_string_new ("");
+		g_string_append (s, "System.Collections.Generic.");
+		g_string_append_printf (s, "Dictionary`%d", i);
+		g_string_append_c (s, '<');
+		g_string_append (s, "System.String,System.Object>");
+		g_free (g_string_free (s, FALSE));
+	}
+
+	return OK;
+}
+
+static RESULT
+test_short_lived_buffer_speed (void)
+{
+	gint i;
+
+	for (i = 0; i < SHORT_LIVED_COUNT; i++) {
+		G_STRING_DECLARE_ON_STACK (s, 128);
+		g_string_append (s, "System.Collections.Generic.");
+		g_string_append_printf (s, "Dictionary`%d", i);
+		g_string_append_c (s, '<');
+		g_string_append (s, "System.String,System.Object>");
+		g_free (g_string_free_buffer (s, FALSE));
+	}
+
+	return OK;
+}
+
 static Test string_tests [] = {
 	{"append-speed", test_append_speed},
 	{"append_c-speed", test_append_c_speed},
@@ -211,6 +304,10 @@ static Test string_tests [] = {
 	{"append_len", test_appendlen },
 	{"macros", test_macros },
 	{"strnlen", test_strnlen },
+	{"printf", test_printf },
+	{"buffer", test_buffer },
+	{"short-lived-heap-speed", test_short_lived_heap_speed },
+	{"short-lived-buffer-speed", test_short_lived_buffer_speed },
 	{NULL, NULL}
 };
 
@@ -85,10 +85,13 @@ static RESULT
 test_utf16_to_utf8 (void)
 {
 	const gchar *src0 = "", *src1 = "ABCDE", *src2 = "\xE5\xB9\xB4\x27", *src3 = "\xEF\xBC\xA1", *src4 = "\xEF\xBD\x81", *src5 = "\xF0\x90\x90\x80";
+	const gchar *src6 = "Hello, World!", *src7 = "ABCDEFG\xC3\xA9";
 	gunichar2 str0 [] = {0}, str1 [6], str2 [] = {0x5E74, 39, 0}, str3 [] = {0xFF21, 0}, str4 [] = {0xFF41, 0}, str5 [] = {0xD801, 0xDC00, 0};
+	gunichar2 str6 [14], str7 [] = {'A', 'B', 'C', 'D', 'E', 'F', 'G', 0xE9, 0}, str8 [] = {'A', 'B', 'C', 'D', 'E', 0, 'F'};
 	RESULT result;
 
 	gchar_to_gunichar2 (str1, src1);
+	gchar_to_gunichar2 (str6, src6);
 
 	/* empty string */
 	result = compare_utf16_to_utf8 (src0, str0, 0, 0);
@@ -111,6 +114,18 @@ test_utf16_to_utf8 (void)
 	if (result != OK)
 		return result;
 
+	/* ASCII, then non-ASCII past the first four characters */
+	result = compare_utf16_to_utf8 (src6, str6, 13, 13);
+	if (result != OK)
+		return result;
+	result = compare_utf16_to_utf8 (src7, str7, 8, 9);
+	if (result != OK)
+		return result;
+	/* Stops at an embedded NUL */
+	result = compare_utf16_to_utf8_explicit (src1, str8, 5, 5, 7);
+	if (result != OK)
+		return result;
+
 	return OK;
 }
 
@@ -233,11 +248,18 @@ static RESULT
 test_utf8_to_utf16 (void)
 {
 	const gchar *src0 = "", *src1 = "ABCDE", *src2 = "\xE5\xB9\xB4\x27", *src3 = "\xEF\xBC\xA1", *src4 = "\xEF\xBD\x81";
+	const gchar *src5 = "ABCDEFGHIJ\xE5\xB9\xB4KLMNOPQRST";
 	gunichar2 str0 [] = {0}, str1 [6], str2 [] = {0x5E74, 39, 0}, str3 [] = {0xFF21, 0}, str4 [] = {0xFF41, 0};
+	gunichar2 str5 [] = {'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 0x5E74, 'K', 'L', 'M', 'N', 'O', 'P', 'Q', 'R', 'S', 'T', 0};
 	RESULT result;
 
 	gchar_to_gunichar2 (str1, src1);
 
+	/* ASCII runs around a multi-byte character */
+	result = compare_utf8_to_utf16 (str5, src5, 23, 21);
+	if (result != OK)
+		return result;
+
 	/* empty string */
 	result = compare_utf8_to_utf16 (str0, src0, 0, 0);
 	if (result != OK)
@@ -809,6 +831,19 @@ test_utf8_validate (void)
 		return FAILED ("Expected validWord2 to be valid");
 	if (end != &validWord2 [11])
 		return FAILED ("Expected end parameter to be pointing to validWord2[11]");
+
+	/* An invalid sequence after a long ASCII run, with an explicit length */
+	end = NULL;
+	retVal = g_utf8_validate ("ABCDEFGHIJKLMNOP\xC1\x89", 18, &end);
+	if (retVal != FALSE)
+		return FAILED ("Expected the ASCII prefixed word to be invalid");
+	if (*end != '\xC1')
+		return FAILED ("Expected end parameter to be pointing to the invalid sequence");
+
+	end = NULL;
+	retVal = g_utf8_validate ("ABCDEFGHIJKLMNOPQRSTUVWXYZ", 26, &end);
+	if (retVal != TRUE)
+		return FAILED ("Expected the ASCII word to be valid");
 	return OK;
 }
 
@@ -46,6 +46,9 @@ MONO_API MonoImage*    mono_assembly_load_module_checked (MonoAssembly *assembly
 
 MonoAssembly* mono_assembly_load_with_partial_name_internal (const char *name, MonoImageOpenStatus *status);
 
+void
+mono_assembly_preload_references (MonoImage *image);
+
 
 typedef gboolean (*MonoAssemblyAsmCtxFromPathFunc) (const char *absfname, MonoAssembly *requesting_assembly, gpointer user_data, MonoAssemblyContextKind *out_asmctx);
 
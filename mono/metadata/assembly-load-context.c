@@ -1,38 +1,523 @@
 #include "config.h"
 #include "mono/metadata/domain-internals.h"
+#include "mono/metadata/gc-internals.h"
 #include "mono/metadata/icall-decl.h"
 #include "mono/metadata/loader-internals.h"
 #include "mono/metadata/loaded-images-internals.h"
+#include "mono/metadata/metadata-internals.h"
+#include "mono/metadata/object-internals.h"
+#include "mono/utils/atomic.h"
+#include "mono/utils/mono-counters.h"
 #include "mono/utils/mono-error-internals.h"
+#include "mono/utils/mono-logger-internals.h"
 
 #ifdef ENABLE_NETCORE
 /* MonoAssemblyLoadContext support only in netcore Mono */
 
+/* Number of collectible contexts between PrepareForAssemblyLoadContextRelease () and their release */
+static gint32 alcs_unloading;
+
+static gint32 alcs_released;
+static guint64 alc_code_bytes_freed;
+
 void
-mono_alc_init (MonoAssemblyLoadContext *alc, MonoDomain *domain)
+mono_alc_init (MonoAssemblyLoadContext *alc, MonoDomain *domain, gboolean collectible)
 {
+	static gboolean inited;
+
 	MonoLoadedImages *li = g_new0 (MonoLoadedImages, 1);
 	mono_loaded_images_init (li, alc);
 	alc->domain = domain;
 	alc->loaded_images = li;
+	alc->collectible = collectible;
+	mono_coop_mutex_init (&alc->code_lock);
+
+	/* Called with the alcs lock held */
+	if (collectible && !inited) {
+		mono_counters_register ("Collectible AssemblyLoadContexts released", MONO_COUNTER_RUNTIME | MONO_COUNTER_INT, &alcs_released);
+		mono_counters_register ("Collectible AssemblyLoadContext code bytes freed", MONO_COUNTER_JIT | MONO_COUNTER_ULONG, &alc_code_bytes_freed);
+		inited = TRUE;
+	}
 }
 
 void
 mono_alc_cleanup (MonoAssemblyLoadContext *alc)
 {
 	mono_loaded_images_free (alc->loaded_images);
+	if (alc->code_mp)
+		mono_code_manager_destroy (alc->code_mp);
+	if (alc->collectible_methods)
+		g_ptr_array_free (alc->collectible_methods, TRUE);
+	mono_coop_mutex_destroy (&alc->code_lock);
+}
+
+/*
+ * The lookups below return the collectible context that a class, or one of
+ * its element types or generic arguments, comes from.  If ALC is non-NULL
+ * only that context is looked for.  They don't lock or allocate, they are
+ * called with the world stopped.
+ */
+static MonoAssemblyLoadContext *
+class_collectible_alc (MonoClass *klass, MonoAssemblyLoadContext *alc);
+
+static MonoAssemblyLoadContext *
+ginst_collectible_alc (MonoGenericInst *inst, MonoAssemblyLoadContext *alc);
+
+static MonoAssemblyLoadContext *
+image_collectible_alc (MonoImage *image, MonoAssemblyLoadContext *alc)
+{
+	MonoAssemblyLoadContext *image_alc = mono_image_get_alc (image);
+
+	if (!image_alc || !image_alc->collectible || (alc && image_alc != alc))
+		return NULL;
+	return image_alc;
+}
+
+static MonoAssemblyLoadContext *
+type_collectible_alc (MonoType *type, MonoAssemblyLoadContext *alc)
+{
+	switch (type->type) {
+	case MONO_TYPE_CLASS:
+	case MONO_TYPE_VALUETYPE:
+	case MONO_TYPE_SZARRAY:
+		return class_collectible_alc (type->data.klass, alc);
+	case MONO_TYPE_ARRAY:
+		return class_collectible_alc (type->data.array->eklass, alc);
+	case MONO_TYPE_PTR:
+		return type_collectible_alc (type->data.type, alc);
+	case MONO_TYPE_GENERICINST: {
+		MonoGenericClass *gclass = type->data.generic_class;
+		MonoAssemblyLoadContext *res = class_collectible_alc (gclass->container_class, alc);
+
+		if (!res)
+			res = ginst_collectible_alc (gclass->context.class_inst, alc);
+		return res;
+	}
+	default:
+		return NULL;
+	}
+}
+
+static MonoAssemblyLoadContext *
+ginst_collectible_alc (MonoGenericInst *inst, MonoAssemblyLoadContext *alc)
+{
+	MonoAssemblyLoadContext *res;
+	int i;
+
+	for (i = 0; i < inst->type_argc; ++i) {
+		res = type_collectible_alc (inst->type_argv [i], alc);
+		if (res)
+			return res;
+	}
+	return NULL;
+}
+
+static MonoAssemblyLoadContext *
+class_collectible_alc (MonoClass *klass, MonoAssemblyLoadContext *alc)
+{
+	MonoAssemblyLoadContext *res;
+
+	while (m_class_get_rank (klass))
+		klass = m_class_get_element_class (klass);
+
+	res = image_collectible_alc (m_class_get_image (klass), alc);
+	if (!res && mono_class_is_ginst (klass))
+		res = ginst_collectible_alc (mono_class_get_generic_class (klass)->context.class_inst, alc);
+	return res;
+}
+
+static MonoAssemblyLoadContext *
+method_collectible_alc (MonoMethod *method, MonoAssemblyLoadContext *alc)
+{
+	MonoAssemblyLoadContext *res = class_collectible_alc (method->klass, alc);
+
+	if (!res && method->is_inflated) {
+		MonoGenericInst *method_inst = ((MonoMethodInflated*)method)->context.method_inst;
+
+		if (method_inst)
+			res = ginst_collectible_alc (method_inst, alc);
+	}
+	return res;
+}
+
+gboolean
+mono_alc_owns_class (MonoAssemblyLoadContext *alc, MonoClass *klass)
+{
+	return class_collectible_alc (klass, alc) != NULL;
+}
+
+gboolean
+mono_alc_owns_method (MonoAssemblyLoadContext *alc, MonoMethod *method)
+{
+	return method_collectible_alc (method, alc) != NULL;
+}
+
+gboolean
+mono_alc_owns_generic_inst (MonoAssemblyLoadContext *alc, MonoGenericInst *inst)
+{
+	return ginst_collectible_alc (inst, alc) != NULL;
+}
+
+/**
+ * mono_method_get_collectible_alc:
+ * Return the collectible context whose code the code of \p method belongs to,
+ * or NULL if it's allocated from the domain.
+ */
+MonoAssemblyLoadContext *
+mono_method_get_collectible_alc (MonoMethod *method)
+{
+	MonoAssemblyLoadContext *alc;
+
+	if (method->dynamic)
+		return NULL;
+
+	alc = method_collectible_alc (method, NULL);
+	/* Methods called after their context was found unused are compiled into the domain */
+	if (alc && mono_atomic_load_i32 (&alc->state) >= MONO_ALC_STATE_UNUSED)
+		return NULL;
+	return alc;
+}
+
+/**
+ * mono_alc_begin_collectible_compile:
+ * Called by the JIT before compiling \p method.  If the code of \p method has
+ * to be allocated from a collectible context, return it, and keep it from being
+ * released until mono_alc_end_collectible_compile () is called.
+ */
+MonoAssemblyLoadContext *
+mono_alc_begin_collectible_compile (MonoMethod *method)
+{
+	MonoAssemblyLoadContext *alc = mono_method_get_collectible_alc (method);
+
+	if (alc)
+		mono_atomic_inc_i32 (&alc->pending_compiles);
+	return alc;
+}
+
+void
+mono_alc_end_collectible_compile (MonoAssemblyLoadContext *alc)
+{
+	mono_atomic_dec_i32 (&alc->pending_compiles);
+}
+
+void*
+mono_alc_code_reserve (MonoAssemblyLoadContext *alc, int size)
+{
+	void *res;
+
+	mono_coop_mutex_lock (&alc->code_lock);
+	if (!alc->code_mp)
+		alc->code_mp = mono_code_manager_new ();
+	res = mono_code_manager_reserve (alc->code_mp, size);
+	mono_coop_mutex_unlock (&alc->code_lock);
+	return res;
+}
+
+void
+mono_alc_code_commit (MonoAssemblyLoadContext *alc, void *data, int size, int newsize)
+{
+	mono_coop_mutex_lock (&alc->code_lock);
+	mono_code_manager_commit (alc->code_mp, data, size, newsize);
+	mono_coop_mutex_unlock (&alc->code_lock);
+}
+
+/**
+ * mono_alc_add_collectible_method:
+ * Record that the code of \p method was allocated from \p alc, so the method
+ * is freed before the code.
+ */
+void
+mono_alc_add_collectible_method (MonoAssemblyLoadContext *alc, MonoMethod *method)
+{
+	mono_coop_mutex_lock (&alc->code_lock);
+	if (!alc->collectible_methods)
+		alc->collectible_methods = g_ptr_array_new ();
+	g_ptr_array_add (alc->collectible_methods, method);
+	mono_coop_mutex_unlock (&alc->code_lock);
+}
+
+typedef struct {
+	gpointer addr;
+	gboolean found;
+} CodeLookup;
+
+static int
+find_code_chunk (void *data, int csize, int size, void *user_data)
+{
+	CodeLookup *lookup = (CodeLookup *)user_data;
+
+	if ((guint8*)lookup->addr >= (guint8*)data && (guint8*)lookup->addr < (guint8*)data + csize)
+		lookup->found = TRUE;
+	return lookup->found;
+}
+
+/*
+ * LOCKING: requires the code lock.
+ */
+static gboolean
+alc_code_contains (MonoAssemblyLoadContext *alc, gpointer addr)
+{
+	CodeLookup lookup;
+
+	if (!alc->code_mp || !addr)
+		return FALSE;
+
+	lookup.addr = addr;
+	lookup.found = FALSE;
+	mono_code_manager_foreach (alc->code_mp, find_code_chunk, &lookup);
+	return lookup.found;
+}
+
+typedef struct {
+	MonoAssemblyLoadContext *alc;
+	/* Whether objects of the classes of the context keep it in use, or only delegates into its code */
+	gboolean objects;
+	gboolean in_use;
+} AlcUseCheck;
+
+static int
+find_alc_object (MonoObject *obj, MonoClass *klass, uintptr_t size, uintptr_t num, MonoObject **refs, uintptr_t *offsets, void *data)
+{
+	AlcUseCheck *check = (AlcUseCheck *)data;
+
+	if (check->in_use)
+		return 0;
+
+	if (check->objects && mono_alc_owns_class (check->alc, klass)) {
+		check->in_use = TRUE;
+	} else if (m_class_is_delegate (klass)) {
+		MonoDelegate *del = (MonoDelegate *)obj;
+
+		if (check->objects && del->method && mono_alc_owns_method (check->alc, del->method))
+			check->in_use = TRUE;
+		else if (alc_code_contains (check->alc, del->method_ptr) || alc_code_contains (check->alc, del->invoke_impl))
+			check->in_use = TRUE;
+	}
+	return 0;
+}
+
+static gboolean
+find_alc_frame (gpointer word, gpointer user_data)
+{
+	AlcUseCheck *check = (AlcUseCheck *)user_data;
+
+	check->in_use = alc_code_contains (check->alc, word);
+	return check->in_use;
 }
 
+/*
+ * Whether objects of the classes of ALC, delegates to its methods, or frames
+ * running its code are left.  If OBJECTS is FALSE only delegates and frames
+ * running its code are looked for.  Called with the world stopped after a
+ * major collection.  Stacks are scanned conservatively, so an integer which
+ * happens to look like a code address keeps the context for another collection.
+ */
+static gboolean
+alc_in_use (MonoAssemblyLoadContext *alc, gboolean objects)
+{
+	AlcUseCheck check;
+
+	/* The lock might be held by a stopped thread adding code */
+	if (mono_atomic_load_i32 (&alc->pending_compiles) || mono_coop_mutex_trylock (&alc->code_lock) != 0)
+		return TRUE;
+
+	check.alc = alc;
+	check.objects = objects;
+	check.in_use = FALSE;
+
+	if (mono_gc_walk_heap (0, find_alc_object, &check) != 0)
+		check.in_use = TRUE;
+	else if (!check.in_use && mono_gc_scan_thread_stacks (find_alc_frame, &check) != 0)
+		check.in_use = TRUE;
+
+	mono_coop_mutex_unlock (&alc->code_lock);
+	return check.in_use;
+}
+
+/**
+ * mono_alc_check_unused:
+ * Advance the collectible contexts being unloaded which aren't used anymore,
+ * and wake up the finalizer thread to release them.  Called with the world
+ * stopped, at the end of a major collection.
+ */
+void
+mono_alc_check_unused (void)
+{
+	MonoDomain *domain = mono_get_root_domain ();
+	gboolean notify = FALSE;
+	GSList *l;
+
+	if (!mono_atomic_load_i32 (&alcs_unloading))
+		return;
+
+	/* Try again after the next collection if a stopped thread holds it */
+	if (!domain || mono_coop_mutex_trylock (&domain->alcs_lock) != 0)
+		return;
+
+	for (l = domain->alcs; l; l = l->next) {
+		MonoAssemblyLoadContext *alc = (MonoAssemblyLoadContext *)l->data;
+		gint32 state = mono_atomic_load_i32 (&alc->state);
+
+		if (state == MONO_ALC_STATE_UNLOADING && !alc_in_use (alc, TRUE)) {
+			mono_atomic_store_i32 (&alc->state, MONO_ALC_STATE_UNUSED);
+			notify = TRUE;
+		} else if (state == MONO_ALC_STATE_DETACHED && !alc_in_use (alc, FALSE)) {
+			mono_atomic_store_i32 (&alc->state, MONO_ALC_STATE_CODE_UNUSED);
+			notify = TRUE;
+		} else if (state == MONO_ALC_STATE_REDETACHED && !alc_in_use (alc, FALSE)) {
+			mono_atomic_store_i32 (&alc->state, MONO_ALC_STATE_CODE_UNREACHABLE);
+			notify = TRUE;
+		}
+	}
+
+	mono_coop_mutex_unlock (&domain->alcs_lock);
+
+	if (notify)
+		mono_gc_finalize_notify ();
+}
+
+static void
+alc_detach_vtables (MonoAssemblyLoadContext *alc)
+{
+	MonoDomain *domain = alc->domain;
+	guint i;
+
+	for (i = 0; ; ++i) {
+		MonoVTable *vtable = NULL;
+
+		mono_domain_lock (domain);
+		if (i < domain->class_vtable_array->len)
+			vtable = (MonoVTable *)g_ptr_array_index (domain->class_vtable_array, i);
+		mono_domain_unlock (domain);
+
+		if (!vtable)
+			break;
+		mono_vtable_detach_alc_code (vtable, alc);
+	}
+}
+
+/*
+ * Make the runtime stop handing out the code of ALC: its methods are compiled
+ * into the domain again if they are called.  Frames and delegates which
+ * already run the code keep doing so until the next check.
+ */
+static void
+alc_detach_code (MonoAssemblyLoadContext *alc)
+{
+	MonoRuntimeCallbacks *callbacks = mono_get_runtime_callbacks ();
+	GPtrArray *methods = g_ptr_array_new ();
+	guint i;
+
+	mono_coop_mutex_lock (&alc->code_lock);
+	for (i = 0; alc->collectible_methods && i < alc->collectible_methods->len; ++i)
+		g_ptr_array_add (methods, g_ptr_array_index (alc->collectible_methods, i));
+	mono_coop_mutex_unlock (&alc->code_lock);
+
+	/* Before the vtables, so the trampolines don't find the old code */
+	if (callbacks->detach_alc_code)
+		callbacks->detach_alc_code (alc->domain, alc, methods);
+	alc_detach_vtables (alc);
+
+	g_ptr_array_free (methods, TRUE);
+}
+
+static void
+alc_release_code (MonoAssemblyLoadContext *alc)
+{
+	MonoRuntimeCallbacks *callbacks = mono_get_runtime_callbacks ();
+	MonoCodeManager *code_mp;
+	GPtrArray *methods;
+	int size = 0;
+	guint i;
+
+	mono_coop_mutex_lock (&alc->code_lock);
+	methods = alc->collectible_methods;
+	alc->collectible_methods = NULL;
+	code_mp = alc->code_mp;
+	alc->code_mp = NULL;
+	mono_coop_mutex_unlock (&alc->code_lock);
+
+	if (methods) {
+		for (i = 0; i < methods->len; ++i) {
+			if (callbacks->free_alc_method)
+				callbacks->free_alc_method (alc->domain, (MonoMethod *)g_ptr_array_index (methods, i));
+		}
+		g_ptr_array_free (methods, TRUE);
+	}
+
+	if (code_mp) {
+		size = mono_code_manager_size (code_mp, NULL);
+		mono_code_manager_destroy (code_mp);
+	}
+
+	if (alc->strong_gchandle) {
+		mono_gchandle_free_internal (alc->strong_gchandle);
+		alc->strong_gchandle = 0;
+	}
+
+	mono_atomic_inc_i32 (&alcs_released);
+	mono_atomic_fetch_add_i64 ((gint64*)&alc_code_bytes_freed, size);
+
+	mono_trace (G_LOG_LEVEL_INFO, MONO_TRACE_ASSEMBLY, "Released collectible AssemblyLoadContext %p, freed %d bytes of code.", alc, size);
+}
+
+/**
+ * mono_alc_release_unused:
+ * Free the code of the collectible contexts found unused by
+ * mono_alc_check_unused ().  Called on the finalizer thread.
+ *
+ * The images and the metadata of a released context stay loaded, the domain's
+ * caches keep referring to them.
+ */
+void
+mono_alc_release_unused (void)
+{
+	MonoDomain *domain = mono_get_root_domain ();
+	GSList *alcs = NULL, *l;
+
+	if (!mono_atomic_load_i32 (&alcs_unloading))
+		return;
+
+	mono_coop_mutex_lock (&domain->alcs_lock);
+	for (l = domain->alcs; l; l = l->next) {
+		MonoAssemblyLoadContext *alc = (MonoAssemblyLoadContext *)l->data;
+		gint32 state = mono_atomic_load_i32 (&alc->state);
+
+		if (state == MONO_ALC_STATE_UNUSED || state == MONO_ALC_STATE_CODE_UNUSED || state == MONO_ALC_STATE_CODE_UNREACHABLE)
+			alcs = g_slist_prepend (alcs, alc);
+	}
+	mono_coop_mutex_unlock (&domain->alcs_lock);
+
+	for (l = alcs; l; l = l->next) {
+		MonoAssemblyLoadContext *alc = (MonoAssemblyLoadContext *)l->data;
+		gint32 state = mono_atomic_load_i32 (&alc->state);
+
+		if (state == MONO_ALC_STATE_UNUSED) {
+			alc_detach_code (alc);
+			mono_atomic_store_i32 (&alc->state, MONO_ALC_STATE_DETACHED);
+		} else if (state == MONO_ALC_STATE_CODE_UNUSED) {
+			/*
+			 * A trampoline which was running during the first detach can have
+			 * written the old code into a vtable, IMT or rgctx slot.  Nothing
+			 * can look the old code up anymore, so detach again and free it only
+			 * if the next check still finds nothing running it.
+			 */
+			alc_detach_code (alc);
+			mono_atomic_store_i32 (&alc->state, MONO_ALC_STATE_REDETACHED);
+		} else {
+			alc_release_code (alc);
+			mono_atomic_store_i32 (&alc->state, MONO_ALC_STATE_RELEASED);
+			mono_atomic_dec_i32 (&alcs_unloading);
+		}
+	}
+	g_slist_free (alcs);
+}
 
 gpointer
 ves_icall_System_Runtime_Loader_AssemblyLoadContext_InternalInitializeNativeALC (gpointer this_gchandle_ptr, MonoBoolean is_default_alc, MonoBoolean collectible, MonoError *error)
 {
 	/* If the ALC is collectible, this_gchandle is weak, otherwise it's strong. */
 	uint32_t this_gchandle = (uint32_t)GPOINTER_TO_UINT (this_gchandle_ptr);
-	if (collectible) {
-		mono_error_set_execution_engine (error, "Collectible AssemblyLoadContexts are not yet supported by MonoVM");
-		return NULL;
-	}
 
 	MonoDomain *domain = mono_domain_get ();
 	MonoAssemblyLoadContext *alc = NULL;
@@ -47,4 +532,61 @@ ves_icall_System_Runtime_Loader_AssemblyLoadContext_InternalInitializeNativeALC
 	return alc;
 }
 
+/*
+ * Called by AssemblyLoadContext.Unload () with a strong handle to the managed
+ * object, which is freed when the context is released.  The context is
+ * released once a major collection finds no objects of its classes, delegates
+ * to its methods, or frames running its code.  Objects which are only
+ * referenced from its static fields keep it alive too.
+ */
+void
+ves_icall_System_Runtime_Loader_AssemblyLoadContext_PrepareForAssemblyLoadContextRelease (gpointer alc_pointer, gpointer strong_gchandle_ptr, MonoError *error)
+{
+	MonoAssemblyLoadContext *alc = (MonoAssemblyLoadContext *)alc_pointer;
+
+	g_assert (alc->collectible);
+
+	alc->strong_gchandle = (uint32_t)GPOINTER_TO_UINT (strong_gchandle_ptr);
+	if (mono_atomic_cas_i32 (&alc->state, MONO_ALC_STATE_UNLOADING, MONO_ALC_STATE_ALIVE) == MONO_ALC_STATE_ALIVE)
+		mono_atomic_inc_i32 (&alcs_unloading);
+}
+
+#else
+
+MonoAssemblyLoadContext *
+mono_method_get_collectible_alc (MonoMethod *method)
+{
+	return NULL;
+}
+
+MonoAssemblyLoadContext *
+mono_alc_begin_collectible_compile (MonoMethod *method)
+{
+	return NULL;
+}
+
+void
+mono_alc_end_collectible_compile (MonoAssemblyLoadContext *alc)
+{
+	g_assert_not_reached ();
+}
+
+void*
+mono_alc_code_reserve (MonoAssemblyLoadContext *alc, int size)
+{
+	g_assert_not_reached ();
+}
+
+void
+mono_alc_code_commit (MonoAssemblyLoadContext *alc, void *data, int size, int newsize)
+{
+	g_assert_not_reached ();
+}
+
+void
+mono_alc_add_collectible_method (MonoAssemblyLoadContext *alc, MonoMethod *method)
+{
+	g_assert_not_reached ();
+}
+
 #endif /* ENABLE_NETCORE */
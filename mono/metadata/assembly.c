@@ -44,6 +44,10 @@
 #include <mono/utils/mono-io-portability.h>
 #include <mono/utils/atomic.h>
 #include <mono/utils/mono-os-mutex.h>
+#include <mono/utils/mono-coop-mutex.h>
+#include <mono/utils/mono-proclib.h>
+#include <mono/utils/w32api.h>
+#include <mono/metadata/threads-types.h>
 
 #ifndef HOST_WIN32
 #include <sys/types.h>
@@ -1754,6 +1758,138 @@ mono_assembly_load_references (MonoImage *image, MonoImageOpenStatus *status)
 		*status = MONO_IMAGE_OK;
 }
 
+#define PRELOAD_THREADS_MAX 4
+
+/*
+ * State of the preloading of the references of the entry assembly, see
+ * mono_assembly_preload_references ().
+ */
+static struct {
+	MonoCoopMutex lock;
+	MonoCoopCond cond;
+	/* Paths left to open */
+	GSList *queue;
+	/* Paths queued so far */
+	GHashTable *seen;
+	/* Queued paths plus the ones being opened */
+	gint32 pending;
+	/* The preloaded images, referenced so they stay around until the loader asks for them */
+	GPtrArray *images;
+} preload;
+
+/* LOCKING: Assumes preload.lock is held */
+static void
+preload_queue_references (MonoImage *image)
+{
+	MonoTableInfo *t = &image->tables [MONO_TABLE_ASSEMBLYREF];
+	guint32 cols [MONO_ASSEMBLYREF_SIZE];
+	char *basedir;
+	int i;
+
+	basedir = g_path_get_dirname (image->name);
+
+	for (i = 0; i < t->rows; ++i) {
+		char *filename, *path;
+
+		mono_metadata_decode_row (t, i, cols, MONO_ASSEMBLYREF_SIZE);
+
+		filename = g_strconcat (mono_metadata_string_heap (image, cols [MONO_ASSEMBLYREF_NAME]), ".dll", (const char*)NULL);
+		path = g_build_filename (basedir, filename, (const char*)NULL);
+		g_free (filename);
+
+		if (g_hash_table_lookup (preload.seen, path) || !g_file_test (path, G_FILE_TEST_IS_REGULAR)) {
+			g_free (path);
+			continue;
+		}
+
+		g_hash_table_insert (preload.seen, path, path);
+		preload.queue = g_slist_prepend (preload.queue, path);
+		preload.pending ++;
+	}
+
+	g_free (basedir);
+
+	mono_coop_cond_broadcast (&preload.cond);
+}
+
+static gsize WINAPI
+preload_thread (gpointer unused)
+{
+	mono_coop_mutex_lock (&preload.lock);
+
+	for (;;) {
+		MonoImageOpenStatus status;
+		MonoImage *image;
+		char *path;
+
+		while (!preload.queue && preload.pending > 0)
+			mono_coop_cond_wait (&preload.cond, &preload.lock);
+
+		if (!preload.queue)
+			break;
+
+		path = (char*)preload.queue->data;
+		preload.queue = g_slist_delete_link (preload.queue, preload.queue);
+
+		mono_coop_mutex_unlock (&preload.lock);
+
+		/* This parses the headers and the tables, and registers the image, outside of the images lock */
+		image = mono_image_open_a_lot (mono_domain_default_alc (mono_get_root_domain ()), path, &status, FALSE, FALSE);
+		if (image)
+			mono_trace (G_LOG_LEVEL_INFO, MONO_TRACE_ASSEMBLY, "Preloaded image '%s'.", path);
+
+		mono_coop_mutex_lock (&preload.lock);
+
+		if (image) {
+			g_ptr_array_add (preload.images, image);
+			preload_queue_references (image);
+		}
+
+		if (--preload.pending == 0)
+			mono_coop_cond_broadcast (&preload.cond);
+	}
+
+	mono_coop_mutex_unlock (&preload.lock);
+
+	return 0;
+}
+
+/**
+ * mono_assembly_preload_references:
+ *
+ *   If the MONO_ASSEMBLY_PRELOAD environment variable is set, open the images of the
+ * reference closure of \p image, looked up next to the referencing assembly, on a few
+ * background threads. Loading an assembly then finds its image already parsed and
+ * registered, instead of opening the references one by one as the code reaches them.
+ */
+void
+mono_assembly_preload_references (MonoImage *image)
+{
+	ERROR_DECL (error);
+	int i, threads;
+
+	if (!g_hasenv ("MONO_ASSEMBLY_PRELOAD") || preload.images)
+		return;
+
+	mono_coop_mutex_init (&preload.lock);
+	mono_coop_cond_init (&preload.cond);
+	preload.seen = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	preload.images = g_ptr_array_new ();
+
+	mono_coop_mutex_lock (&preload.lock);
+	preload_queue_references (image);
+	threads = MIN (preload.pending, MIN (mono_cpu_count (), PRELOAD_THREADS_MAX));
+	mono_coop_mutex_unlock (&preload.lock);
+
+	for (i = 0; i < threads; ++i) {
+		if (!mono_thread_create_internal (mono_get_root_domain (), (gpointer)preload_thread, NULL, (MonoThreadCreateFlags)(MONO_THREAD_CREATE_FLAGS_THREADPOOL | MONO_THREAD_CREATE_FLAGS_SMALL_STACK), error)) {
+			mono_trace (G_LOG_LEVEL_INFO, MONO_TRACE_ASSEMBLY, "Could not start an assembly preload thread: %s", mono_error_get_message (error));
+			mono_error_cleanup (error);
+			break;
+		}
+	}
+}
+
 typedef struct AssemblyLoadHook AssemblyLoadHook;
 struct AssemblyLoadHook {
 	AssemblyLoadHook *next;
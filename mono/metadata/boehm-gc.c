@@ -66,6 +66,7 @@ typedef void (*GC_push_other_roots_proc)(void);
 
 static GC_push_other_roots_proc default_push_other_roots;
 static GHashTable *roots;
+static MonoGCCallbacks gc_callbacks;
 
 static void
 mono_push_other_roots(void);
@@ -317,6 +318,12 @@ mono_gc_get_allocated_bytes_for_current_thread (void)
 	return 0;
 }
 
+gboolean
+mono_gc_set_allocation_sample_interval (guint32 interval)
+{
+	return FALSE;
+}
+
 /**
  * mono_gc_get_generation:
  * \param object a managed object
@@ -444,6 +451,30 @@ mono_gc_walk_heap (int flags, MonoGCReferences callback, void *data)
 	return 1;
 }
 
+int
+mono_gc_walk_heap_begin (int flags, MonoGCReferences callback, void *data)
+{
+	return 1;
+}
+
+int
+mono_gc_scan_thread_stacks (MonoGCStackWordFunc func, gpointer user_data)
+{
+	return 1;
+}
+
+mono_bool
+mono_gc_walk_heap_step (int budget_us)
+{
+	return TRUE;
+}
+
+int
+mono_gc_get_recent_events (MonoGCRecentEvent *events, int max_events)
+{
+	return 0;
+}
+
 static gint64 gc_start_time;
 
 static void
@@ -631,6 +662,13 @@ mono_push_other_roots (void)
 		HandleStack* stack = info->handle_stack;
 		if (stack)
 			push_handle_stack (stack);
+		if (gc_callbacks.interp_stack_range_func) {
+			gpointer interp_start, interp_end;
+
+			gc_callbacks.interp_stack_range_func (info->jit_data, &interp_start, &interp_end);
+			if (interp_start)
+				GC_push_all (interp_start, interp_end);
+		}
 	} FOREACH_THREAD_END
 	if (default_push_other_roots)
 		default_push_other_roots ();
@@ -801,6 +839,28 @@ mono_gc_alloc_vector (MonoVTable *vtable, size_t size, uintptr_t max_length)
 	return obj;
 }
 
+MonoArray*
+mono_gc_alloc_uninitialized_vector (MonoVTable *vtable, size_t size, uintptr_t max_length)
+{
+	MonoArray *obj;
+
+	g_assert (!m_class_has_references (vtable->klass));
+
+	/* Atomic memory is not cleared by the collector, only the header is */
+	obj = (MonoArray *)GC_MALLOC_ATOMIC (size);
+	if (G_UNLIKELY (!obj))
+		return NULL;
+
+	memset (obj, 0, MONO_SIZEOF_MONO_ARRAY);
+	obj->obj.vtable = vtable;
+	obj->max_length = max_length;
+
+	if (G_UNLIKELY (mono_profiler_allocations_enabled ()))
+		MONO_PROFILER_RAISE (gc_allocation, (&obj->obj));
+
+	return obj;
+}
+
 MonoArray*
 mono_gc_alloc_array (MonoVTable *vtable, size_t size, uintptr_t max_length, uintptr_t bounds_size)
 {
@@ -856,6 +916,13 @@ mono_gc_alloc_string (MonoVTable *vtable, size_t size, gint32 len)
 	return obj;
 }
 
+/* Strings are atomic memory, which is never cleared anyway */
+MonoString*
+mono_gc_alloc_uninitialized_string (MonoVTable *vtable, size_t size, gint32 len)
+{
+	return mono_gc_alloc_string (vtable, size, len);
+}
+
 MonoObject*
 mono_gc_alloc_mature (MonoVTable *vtable, size_t size)
 {
@@ -1273,6 +1340,12 @@ mono_gc_get_managed_allocator (MonoClass *klass, gboolean for_box, gboolean know
 	return mono_gc_get_managed_allocator_by_type (atype, MANAGED_ALLOCATOR_REGULAR);
 }
 
+gboolean
+mono_gc_can_inline_managed_allocator (void)
+{
+	return FALSE;
+}
+
 MonoMethod*
 mono_gc_get_managed_array_allocator (MonoClass *klass)
 {
@@ -1337,6 +1410,12 @@ mono_gc_get_managed_allocator (MonoClass *klass, gboolean for_box, gboolean know
 	return NULL;
 }
 
+gboolean
+mono_gc_can_inline_managed_allocator (void)
+{
+	return FALSE;
+}
+
 MonoMethod*
 mono_gc_get_managed_array_allocator (MonoClass *klass)
 {
@@ -1501,6 +1580,7 @@ mono_gc_get_bitmap_for_descr (void *descr, int *numbits)
 void
 mono_gc_set_gc_callbacks (MonoGCCallbacks *callbacks)
 {
+	gc_callbacks = *callbacks;
 }
 
 void
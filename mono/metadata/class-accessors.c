@@ -25,7 +25,8 @@ typedef enum {
 	PROP_FIELD_DEF_VALUES = 7, /* MonoFieldDefaultValue* */
 	PROP_DECLSEC_FLAGS = 8, /* guint32 */
 	PROP_WEAK_BITMAP = 9,
-	PROP_DIM_CONFLICTS = 10 /* GSList of MonoMethod* */
+	PROP_DIM_CONFLICTS = 10, /* GSList of MonoMethod* */
+	PROP_IMT_SLOTS = 11 /* guint8* */
 }  InfrequentDataKind;
 
 /* Accessors based on class kind*/
@@ -472,6 +473,29 @@ mono_class_get_dim_conflicts (MonoClass *klass)
 	return info->data;
 }
 
+typedef struct {
+	MonoPropertyBagItem head;
+	guint8 *slots;
+} ImtSlotsData;
+
+guint8*
+mono_class_get_imt_slots (MonoClass *klass)
+{
+	ImtSlotsData *prop = (ImtSlotsData*)mono_property_bag_get (m_class_get_infrequent_data (klass), PROP_IMT_SLOTS);
+	return prop ? prop->slots : NULL;
+}
+
+/* Returns the slots in the bag, which are the ones of another thread if it got there first */
+guint8*
+mono_class_set_imt_slots (MonoClass *klass, guint8 *slots)
+{
+	ImtSlotsData *prop = (ImtSlotsData*)mono_class_alloc (klass, sizeof (ImtSlotsData));
+	prop->head.tag = PROP_IMT_SLOTS;
+	prop->slots = slots;
+	prop = (ImtSlotsData*)mono_property_bag_add (m_class_get_infrequent_data (klass), prop);
+	return prop->slots;
+}
+
 /**
  * mono_class_set_failure:
  * \param klass class in which the failure was detected
@@ -1399,6 +1399,12 @@ mono_class_set_dim_conflicts (MonoClass *klass, GSList *conflicts);
 GSList*
 mono_class_get_dim_conflicts (MonoClass *klass);
 
+guint8*
+mono_class_get_imt_slots (MonoClass *klass);
+
+guint8*
+mono_class_set_imt_slots (MonoClass *klass, guint8 *slots);
+
 MonoMethod *
 mono_class_get_method_from_name_checked (MonoClass *klass, const char *name, int param_count, int flags, MonoError *error);
 
@@ -95,19 +95,24 @@ struct _MonoClass {
 	guint32    type_token;
 	int        vtable_size; /* number of slots */
 
-	guint16     interface_count;
 	guint32     interface_id;        /* unique inderface id (for interfaces) */
 	guint32     max_interface_id;
-	
+
+	/*
+	 * The 16 and 32 bit fields are kept together so the pointers that follow don't
+	 * need padding, this saves 8 bytes per class on 64 bit.
+	 */
+	guint16     interface_count;
 	guint16     interface_offsets_count;
+
+	union _MonoClassSizes sizes;
+
 	MonoClass **interfaces_packed;
 	guint16    *interface_offsets_packed;
 	guint8     *interface_bitmap;
 
 	MonoClass **interfaces;
 
-	union _MonoClassSizes sizes;
-
 	/*
 	 * Field information: Type and location from object base
 	 */
@@ -512,13 +512,11 @@ mono_type_get_name_recurse (MonoType *type, GString *str, gboolean is_recursed,
 char*
 mono_type_get_name_full (MonoType *type, MonoTypeNameFormat format)
 {
-	GString* result;
-
-	result = g_string_new ("");
+	G_STRING_DECLARE_ON_STACK (result, 256);
 
 	mono_type_get_name_recurse (type, result, FALSE, format);
 
-	return g_string_free (result, FALSE);
+	return g_string_free_buffer (result, FALSE);
 }
 
 /**
@@ -3235,6 +3233,56 @@ mono_class_from_name_checked_aux (MonoImage *image, const char* name_space, cons
 	return klass;
 }
 
+typedef struct {
+	const char *name_space;
+	const char *name;
+	guint hash;
+} ClassNameKey;
+
+static guint
+class_name_key_hash (gconstpointer key)
+{
+	return ((const ClassNameKey*)key)->hash;
+}
+
+static gboolean
+class_name_key_equal (gconstpointer a, gconstpointer b)
+{
+	const ClassNameKey *ka = (const ClassNameKey*)a;
+	const ClassNameKey *kb = (const ClassNameKey*)b;
+
+	return ka->hash == kb->hash && !strcmp (ka->name, kb->name) && !strcmp (ka->name_space, kb->name_space);
+}
+
+static void
+class_name_key_init (ClassNameKey *key, const char *name_space, const char *name)
+{
+	key->name_space = name_space;
+	key->name = name;
+	key->hash = (g_str_hash (name_space) * 31) ^ g_str_hash (name);
+}
+
+static void
+class_from_name_cache_add (MonoImage *image, ClassNameKey *key, MonoClass *klass)
+{
+	ClassNameKey *entry;
+
+	mono_image_lock (image);
+
+	if (!image->class_from_name_cache)
+		mono_atomic_store_release (&image->class_from_name_cache, mono_conc_hashtable_new (class_name_key_hash, class_name_key_equal));
+
+	if (!mono_conc_hashtable_lookup (image->class_from_name_cache, key)) {
+		entry = (ClassNameKey*)mono_image_alloc (image, sizeof (ClassNameKey));
+		entry->name_space = mono_image_strdup (image, key->name_space);
+		entry->name = mono_image_strdup (image, key->name);
+		entry->hash = key->hash;
+		mono_conc_hashtable_insert (image->class_from_name_cache, entry, klass);
+	}
+
+	mono_image_unlock (image);
+}
+
 /**
  * mono_class_from_name_checked:
  * \param image The MonoImage where the type is looked up in
@@ -3252,6 +3300,20 @@ mono_class_from_name_checked (MonoImage *image, const char* name_space, const ch
 {
 	MonoClass *klass;
 	GHashTable *visited_images;
+	MonoConcurrentHashTable *cache;
+	ClassNameKey key;
+
+	class_name_key_init (&key, name_space, name);
+
+	/* Dynamic images can replace their classes, so only lookups in normal images are cached */
+	cache = (MonoConcurrentHashTable*)mono_atomic_load_ptr ((gpointer*)&image->class_from_name_cache);
+	if (cache) {
+		klass = (MonoClass*)mono_conc_hashtable_lookup (cache, &key);
+		if (klass) {
+			error_init (error);
+			return klass;
+		}
+	}
 
 	visited_images = g_hash_table_new (g_direct_hash, g_direct_equal);
 
@@ -3259,6 +3321,9 @@ mono_class_from_name_checked (MonoImage *image, const char* name_space, const ch
 
 	g_hash_table_destroy (visited_images);
 
+	if (klass && is_ok (error) && !image_is_dynamic (image))
+		class_from_name_cache_add (image, &key, klass);
+
 	return klass;
 }
 
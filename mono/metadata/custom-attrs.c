@@ -1586,6 +1586,106 @@ mono_custom_attrs_from_index (MonoImage *image, guint32 idx)
 	mono_error_cleanup (error);
 	return result;
 }
+/*
+ * The CustomAttribute table is sorted by parent, so the attributes of a parent are a
+ * range of rows. The index keeps the distinct parents in a flat array, so the range
+ * is found without decoding rows, and the constructor of each row once it has been
+ * resolved and its blob verified, so repeated queries like IsDefined () don't
+ * resolve it again.
+ */
+typedef struct _MonoCustomAttrIndex {
+	/* FALSE if the table is not sorted, the index is not used then */
+	gboolean sorted;
+	guint32 num_parents;
+	/* The distinct parents, sorted */
+	guint32 *parents;
+	/* Row of the first attribute of parents [i], first [num_parents] is the row count */
+	guint32 *first;
+	/* Constructor of each row, NULL until it is resolved */
+	MonoMethod **ctors;
+} MonoCustomAttrIndex;
+
+static MonoCustomAttrIndex*
+custom_attrs_index_get (MonoImage *image)
+{
+	MonoTableInfo *ca = &image->tables [MONO_TABLE_CUSTOMATTRIBUTE];
+	MonoCustomAttrIndex *index;
+	guint32 i, n, rows, parent, prev;
+	gboolean sorted = TRUE;
+
+	index = image->custom_attr_index;
+	if (index)
+		return index;
+
+	rows = ca->rows;
+	n = 0;
+	prev = 0;
+	for (i = 0; i < rows; ++i) {
+		parent = mono_metadata_decode_row_col (ca, i, MONO_CUSTOM_ATTR_PARENT);
+		if (i > 0 && parent < prev)
+			sorted = FALSE;
+		if (i == 0 || parent != prev)
+			n ++;
+		prev = parent;
+	}
+	if (!sorted)
+		n = 0;
+
+	index = (MonoCustomAttrIndex *)g_malloc0 (sizeof (MonoCustomAttrIndex) + (sizeof (MonoMethod*) * rows) + (sizeof (guint32) * (2 * n + 1)));
+	index->sorted = sorted;
+	index->num_parents = n;
+	index->ctors = (MonoMethod **)(index + 1);
+	index->parents = (guint32 *)(index->ctors + rows);
+	index->first = index->parents + n;
+
+	if (sorted) {
+		n = 0;
+		for (i = 0; i < rows; ++i) {
+			parent = mono_metadata_decode_row_col (ca, i, MONO_CUSTOM_ATTR_PARENT);
+			if (i == 0 || parent != index->parents [n - 1]) {
+				index->parents [n] = parent;
+				index->first [n] = i;
+				n ++;
+			}
+		}
+		index->first [n] = rows;
+	}
+
+	if (mono_atomic_cas_ptr ((volatile gpointer *)&image->custom_attr_index, index, NULL) != NULL) {
+		g_free (index);
+		index = image->custom_attr_index;
+	}
+
+	return index;
+}
+
+/*
+ * custom_attrs_index_lookup:
+ *
+ *   Set @first and @count to the range of rows of the attributes of @idx.
+ */
+static void
+custom_attrs_index_lookup (MonoCustomAttrIndex *index, guint32 idx, guint32 *first, guint32 *count)
+{
+	guint32 lo = 0, hi = index->num_parents;
+
+	while (lo < hi) {
+		guint32 mid = lo + (hi - lo) / 2;
+		if (index->parents [mid] < idx)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if (lo < index->num_parents && index->parents [lo] == idx) {
+		*first = index->first [lo];
+		*count = index->first [lo + 1] - index->first [lo];
+	} else {
+		*first = 0;
+		*count = 0;
+	}
+}
+
 /**
  * mono_custom_attrs_from_index_checked:
  * \returns NULL if no attributes are found.  On error returns NULL and sets \p error.
@@ -1593,72 +1693,82 @@ mono_custom_attrs_from_index (MonoImage *image, guint32 idx)
 MonoCustomAttrInfo*
 mono_custom_attrs_from_index_checked (MonoImage *image, guint32 idx, gboolean ignore_missing, MonoError *error)
 {
-	guint32 mtoken, i, len;
+	guint32 mtoken, i, first, len;
 	guint32 cols [MONO_CUSTOM_ATTR_SIZE];
 	MonoTableInfo *ca;
+	MonoCustomAttrIndex *index;
 	MonoCustomAttrInfo *ainfo;
-	GList *tmp, *list = NULL;
 	const char *data;
 	MonoCustomAttrEntry* attr;
 
 	error_init (error);
 
 	ca = &image->tables [MONO_TABLE_CUSTOMATTRIBUTE];
-
-	i = mono_metadata_custom_attrs_from_index (image, idx);
-	if (!i)
+	if (!ca->base || !ca->rows)
 		return NULL;
-	i --;
-	while (i < ca->rows) {
-		if (mono_metadata_decode_row_col (ca, i, MONO_CUSTOM_ATTR_PARENT) != idx)
-			break;
-		list = g_list_prepend (list, GUINT_TO_POINTER (i));
-		++i;
+
+	index = custom_attrs_index_get (image);
+	if (index->sorted) {
+		custom_attrs_index_lookup (index, idx, &first, &len);
+	} else {
+		first = mono_metadata_custom_attrs_from_index (image, idx);
+		if (!first)
+			return NULL;
+		first --;
+		for (len = 0; first + len < ca->rows; ++len) {
+			if (mono_metadata_decode_row_col (ca, first + len, MONO_CUSTOM_ATTR_PARENT) != idx)
+				break;
+		}
 	}
-	len = g_list_length (list);
 	if (!len)
 		return NULL;
 	ainfo = (MonoCustomAttrInfo *)g_malloc0 (MONO_SIZEOF_CUSTOM_ATTR_INFO + sizeof (MonoCustomAttrEntry) * len);
 	ainfo->num_attrs = len;
 	ainfo->image = image;
-	for (i = len, tmp = list; i != 0; --i, tmp = tmp->next) {
-		mono_metadata_decode_row (ca, GPOINTER_TO_UINT (tmp->data), cols, MONO_CUSTOM_ATTR_SIZE);
-		mtoken = cols [MONO_CUSTOM_ATTR_TYPE] >> MONO_CUSTOM_ATTR_TYPE_BITS;
-		switch (cols [MONO_CUSTOM_ATTR_TYPE] & MONO_CUSTOM_ATTR_TYPE_MASK) {
-		case MONO_CUSTOM_ATTR_TYPE_METHODDEF:
-			mtoken |= MONO_TOKEN_METHOD_DEF;
-			break;
-		case MONO_CUSTOM_ATTR_TYPE_MEMBERREF:
-			mtoken |= MONO_TOKEN_MEMBER_REF;
-			break;
-		default:
-			g_error ("Unknown table for custom attr type %08x", cols [MONO_CUSTOM_ATTR_TYPE]);
-			break;
-		}
-		attr = &ainfo->attrs [i - 1];
-		attr->ctor = mono_get_method_checked (image, mtoken, NULL, NULL, error);
+	for (i = 0; i < len; ++i) {
+		guint32 row = first + i;
+
+		mono_metadata_decode_row (ca, row, cols, MONO_CUSTOM_ATTR_SIZE);
+		attr = &ainfo->attrs [i];
+		attr->ctor = index->ctors [row];
 		if (!attr->ctor) {
-			g_warning ("Can't find custom attr constructor image: %s mtoken: 0x%08x due to: %s", image->name, mtoken, mono_error_get_message (error));
-			if (ignore_missing) {
-				mono_error_cleanup (error);
-				error_init (error);
-			} else {
-				g_list_free (list);
+			mtoken = cols [MONO_CUSTOM_ATTR_TYPE] >> MONO_CUSTOM_ATTR_TYPE_BITS;
+			switch (cols [MONO_CUSTOM_ATTR_TYPE] & MONO_CUSTOM_ATTR_TYPE_MASK) {
+			case MONO_CUSTOM_ATTR_TYPE_METHODDEF:
+				mtoken |= MONO_TOKEN_METHOD_DEF;
+				break;
+			case MONO_CUSTOM_ATTR_TYPE_MEMBERREF:
+				mtoken |= MONO_TOKEN_MEMBER_REF;
+				break;
+			default:
+				g_error ("Unknown table for custom attr type %08x", cols [MONO_CUSTOM_ATTR_TYPE]);
+				break;
+			}
+			attr->ctor = mono_get_method_checked (image, mtoken, NULL, NULL, error);
+			if (!attr->ctor) {
+				g_warning ("Can't find custom attr constructor image: %s mtoken: 0x%08x due to: %s", image->name, mtoken, mono_error_get_message (error));
+				if (ignore_missing) {
+					mono_error_cleanup (error);
+					error_init (error);
+				} else {
+					g_free (ainfo);
+					return NULL;
+				}
+			}
+
+			if (!mono_verifier_verify_cattr_blob (image, cols [MONO_CUSTOM_ATTR_VALUE], error)) {
 				g_free (ainfo);
 				return NULL;
 			}
-		}
 
-		if (!mono_verifier_verify_cattr_blob (image, cols [MONO_CUSTOM_ATTR_VALUE], error)) {
-			g_list_free (list);
-			g_free (ainfo);
-			return NULL;
+			/* The row is good, the next lookups can skip the above */
+			if (attr->ctor)
+				index->ctors [row] = attr->ctor;
 		}
 		data = mono_metadata_blob_heap (image, cols [MONO_CUSTOM_ATTR_VALUE]);
 		attr->data_size = mono_metadata_decode_value (data, &data);
 		attr->data = (guchar*)data;
 	}
-	g_list_free (list);
 
 	return ainfo;
 }
@@ -245,11 +245,10 @@ mono_type_get_desc (GString *res, MonoType *type, gboolean include_namespace)
 char*
 mono_type_full_name (MonoType *type)
 {
-	GString *str;
+	G_STRING_DECLARE_ON_STACK (str, 256);
 
-	str = g_string_new ("");
 	mono_type_get_desc (str, type, TRUE);
-	return g_string_free (str, FALSE);
+	return g_string_free_buffer (str, FALSE);
 }
 
 /**
@@ -259,22 +258,18 @@ char*
 mono_signature_get_desc (MonoMethodSignature *sig, gboolean include_namespace)
 {
 	int i;
-	char *result;
-	GString *res;
 
 	if (!sig)
 		return g_strdup ("<invalid signature>");
 
-	res = g_string_new ("");
+	G_STRING_DECLARE_ON_STACK (res, 256);
 
 	for (i = 0; i < sig->param_count; ++i) {
 		if (i > 0)
 			g_string_append_c (res, ',');
 		mono_type_get_desc (res, sig->params [i], include_namespace);
 	}
-	result = res->str;
-	g_string_free (res, FALSE);
-	return result;
+	return g_string_free_buffer (res, FALSE);
 }
 
 char*
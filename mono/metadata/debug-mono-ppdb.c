@@ -37,10 +37,41 @@
 
 #include "debug-mono-ppdb.h"
 
+/* The number of methods whose decoded sequence points are kept per ppdb file */
+#define SEQ_POINT_CACHE_SIZE 1024
+
+/* A sequence point record of a MethodDebugInformation blob */
+typedef struct {
+	int il_offset;
+	/* The start line/column in effect after this record, hidden records keep the previous one */
+	int line, column;
+	int end_line, end_column;
+	/* Index into MethodSeqPoints.docs */
+	int doc;
+	gboolean hidden;
+} SeqPointRecord;
+
+/* The decoded sequence points of a method, ordered by IL offset */
+typedef struct _MethodSeqPoints MethodSeqPoints;
+struct _MethodSeqPoints {
+	MonoMethod *method;
+	SeqPointRecord *records;
+	int n_records;
+	/* The document of the header and of every document record, in order */
+	int *docs;
+	int n_docs;
+	/* Least recently used list */
+	MethodSeqPoints *prev, *next;
+};
+
 struct _MonoPPDBFile {
 	MonoImage *image;
 	GHashTable *doc_hash;
 	GHashTable *method_hash;
+	/* Maps MonoMethod to MethodSeqPoints, protected by the debugger lock */
+	GHashTable *seq_point_hash;
+	/* Most recently used first */
+	MethodSeqPoints *lru_head, *lru_tail;
 };
 
 /* IMAGE_DEBUG_DIRECTORY structure */
@@ -135,6 +166,16 @@ doc_free (gpointer key)
 	g_free (info);
 }
 
+static void
+method_seq_points_free (gpointer data)
+{
+	MethodSeqPoints *msp = (MethodSeqPoints *)data;
+
+	g_free (msp->records);
+	g_free (msp->docs);
+	g_free (msp);
+}
+
 static MonoPPDBFile*
 create_ppdb_file (MonoImage *ppdb_image)
 {
@@ -144,6 +185,7 @@ create_ppdb_file (MonoImage *ppdb_image)
 	ppdb->image = ppdb_image;
 	ppdb->doc_hash = g_hash_table_new_full (NULL, NULL, NULL, (GDestroyNotify) doc_free);
 	ppdb->method_hash = g_hash_table_new_full (NULL, NULL, NULL, (GDestroyNotify) g_free);
+	ppdb->seq_point_hash = g_hash_table_new_full (NULL, NULL, NULL, method_seq_points_free);
 	return ppdb;
 }
 
@@ -248,6 +290,7 @@ mono_ppdb_close (MonoDebugHandle *handle)
 	mono_image_close (ppdb->image);
 	g_hash_table_destroy (ppdb->doc_hash);
 	g_hash_table_destroy (ppdb->method_hash);
+	g_hash_table_destroy (ppdb->seq_point_hash);
 	g_free (ppdb);
 }
 
@@ -352,51 +395,57 @@ get_docname (MonoPPDBFile *ppdb, MonoImage *image, int docidx)
 	return g_strdup (info->source_file);
 }
 
-/**
- * mono_ppdb_lookup_location:
- * \param minfo A \c MonoDebugMethodInfo which can be retrieved by mono_debug_lookup_method().
- * \param offset IL offset within the corresponding method's CIL code.
+/*
+ * decode_method_seq_points:
  *
- * This function is similar to mono_debug_lookup_location(), but we
- * already looked up the method and also already did the
- * native address -> IL offset mapping.
+ *   Decode the sequence points blob of METHOD, or return NULL if it has none.
  */
-MonoDebugSourceLocation *
-mono_ppdb_lookup_location (MonoDebugMethodInfo *minfo, uint32_t offset)
+static MethodSeqPoints*
+decode_method_seq_points (MonoPPDBFile *ppdb, MonoMethod *method)
 {
-	MonoPPDBFile *ppdb = minfo->handle->ppdb;
 	MonoImage *image = ppdb->image;
-	MonoMethod *method = minfo->method;
 	MonoTableInfo *tables = image->tables;
 	guint32 cols [MONO_METHODBODY_SIZE];
 	const char *ptr;
 	const char *end;
-	char *docname;
-	int idx, size, docidx, iloffset, delta_il, delta_lines, delta_cols, start_line, start_col, adv_line, adv_col;
+	int method_idx, size, docidx, iloffset, delta_il, delta_lines, delta_cols, start_line, start_col;
 	gboolean first = TRUE, first_non_hidden = TRUE;
-	MonoDebugSourceLocation *location;
+	GArray *records, *docs;
+	SeqPointRecord rec;
+	MethodSeqPoints *msp;
 
 	if (!method->token)
 		return NULL;
 
-	idx = mono_metadata_token_index (method->token);
+	method_idx = mono_metadata_token_index (method->token);
 
-	mono_metadata_decode_row (&tables [MONO_TABLE_METHODBODY], idx-1, cols, MONO_METHODBODY_SIZE);
+	MonoTableInfo *methodbody_table = &tables [MONO_TABLE_METHODBODY];
+	if (G_UNLIKELY (method_idx - 1 >= methodbody_table->rows)) {
+		char *method_name = mono_method_full_name (method, FALSE);
+		g_error ("Method idx %d is greater than number of rows (%d) in PPDB MethodDebugInformation table, for method %s in '%s'. Likely a malformed PDB file.",
+			   method_idx - 1, methodbody_table->rows, method_name, image->name);
+		g_free (method_name);
+	}
+	mono_metadata_decode_row (methodbody_table, method_idx - 1, cols, MONO_METHODBODY_SIZE);
 
 	docidx = cols [MONO_METHODBODY_DOCUMENT];
 
 	if (!cols [MONO_METHODBODY_SEQ_POINTS])
 		return NULL;
+
 	ptr = mono_metadata_blob_heap (image, cols [MONO_METHODBODY_SEQ_POINTS]);
 	size = mono_metadata_decode_blob_size (ptr, &ptr);
 	end = ptr + size;
 
+	records = g_array_new (FALSE, TRUE, sizeof (SeqPointRecord));
+	docs = g_array_new (FALSE, FALSE, sizeof (int));
+
 	/* Header */
 	/* LocalSignature */
 	mono_metadata_decode_value (ptr, &ptr);
 	if (docidx == 0)
 		docidx = mono_metadata_decode_value (ptr, &ptr);
-	docname = get_docname (ppdb, image, docidx);
+	g_array_append_val (docs, docidx);
 
 	iloffset = 0;
 	start_line = 0;
@@ -404,13 +453,11 @@ mono_ppdb_lookup_location (MonoDebugMethodInfo *minfo, uint32_t offset)
 	while (ptr < end) {
 		delta_il = mono_metadata_decode_value (ptr, &ptr);
 		if (!first && delta_il == 0) {
-			/* document-record */
+			/* subsequent-document-record */
 			docidx = mono_metadata_decode_value (ptr, &ptr);
-			docname = get_docname (ppdb, image, docidx);
+			g_array_append_val (docs, docidx);
 			continue;
 		}
-		if (!first && iloffset + delta_il > offset)
-			break;
 		iloffset += delta_il;
 		first = FALSE;
 
@@ -419,27 +466,154 @@ mono_ppdb_lookup_location (MonoDebugMethodInfo *minfo, uint32_t offset)
 			delta_cols = mono_metadata_decode_value (ptr, &ptr);
 		else
 			delta_cols = mono_metadata_decode_signed_value (ptr, &ptr);
-		if (delta_lines == 0 && delta_cols == 0)
+
+		memset (&rec, 0, sizeof (rec));
+		rec.il_offset = iloffset;
+		rec.doc = docs->len - 1;
+
+		if (delta_lines == 0 && delta_cols == 0) {
 			/* hidden-sequence-point-record */
-			continue;
-		if (first_non_hidden) {
-			start_line = mono_metadata_decode_value (ptr, &ptr);
-			start_col = mono_metadata_decode_value (ptr, &ptr);
+			rec.hidden = TRUE;
 		} else {
-			adv_line = mono_metadata_decode_signed_value (ptr, &ptr);
-			adv_col = mono_metadata_decode_signed_value (ptr, &ptr);
-			start_line += adv_line;
-			start_col += adv_col;
+			if (first_non_hidden) {
+				start_line = mono_metadata_decode_value (ptr, &ptr);
+				start_col = mono_metadata_decode_value (ptr, &ptr);
+			} else {
+				start_line += mono_metadata_decode_signed_value (ptr, &ptr);
+				start_col += mono_metadata_decode_signed_value (ptr, &ptr);
+			}
+			first_non_hidden = FALSE;
+			rec.end_line = start_line + delta_lines;
+			rec.end_column = start_col + delta_cols;
 		}
-		first_non_hidden = FALSE;
+		rec.line = start_line;
+		rec.column = start_col;
+
+		g_array_append_val (records, rec);
+	}
+
+	msp = g_new0 (MethodSeqPoints, 1);
+	msp->method = method;
+	msp->n_records = records->len;
+	msp->records = (SeqPointRecord *)g_array_free (records, FALSE);
+	msp->n_docs = docs->len;
+	msp->docs = (int *)g_array_free (docs, FALSE);
+	return msp;
+}
+
+static void
+lru_unlink (MonoPPDBFile *ppdb, MethodSeqPoints *msp)
+{
+	if (msp->prev)
+		msp->prev->next = msp->next;
+	else
+		ppdb->lru_head = msp->next;
+	if (msp->next)
+		msp->next->prev = msp->prev;
+	else
+		ppdb->lru_tail = msp->prev;
+	msp->prev = msp->next = NULL;
+}
+
+static void
+lru_push_front (MonoPPDBFile *ppdb, MethodSeqPoints *msp)
+{
+	msp->next = ppdb->lru_head;
+	if (ppdb->lru_head)
+		ppdb->lru_head->prev = msp;
+	ppdb->lru_head = msp;
+	if (!ppdb->lru_tail)
+		ppdb->lru_tail = msp;
+}
+
+/*
+ * get_method_seq_points:
+ *
+ *   Return the decoded sequence points of METHOD from the cache, decoding them
+ * if needed, and evicting the least recently used method when the cache is full.
+ * LOCKING: Assumes the debugger lock is held, the result is only valid while it is.
+ */
+static MethodSeqPoints*
+get_method_seq_points (MonoPPDBFile *ppdb, MonoMethod *method)
+{
+	MethodSeqPoints *msp;
+
+	msp = (MethodSeqPoints *)g_hash_table_lookup (ppdb->seq_point_hash, method);
+	if (msp) {
+		if (msp != ppdb->lru_head) {
+			lru_unlink (ppdb, msp);
+			lru_push_front (ppdb, msp);
+		}
+		return msp;
+	}
+
+	msp = decode_method_seq_points (ppdb, method);
+	if (!msp)
+		return NULL;
+
+	if (g_hash_table_size (ppdb->seq_point_hash) >= SEQ_POINT_CACHE_SIZE) {
+		MethodSeqPoints *victim = ppdb->lru_tail;
+
+		lru_unlink (ppdb, victim);
+		g_hash_table_remove (ppdb->seq_point_hash, victim->method);
 	}
+	g_hash_table_insert (ppdb->seq_point_hash, method, msp);
+	lru_push_front (ppdb, msp);
+	return msp;
+}
+
+/**
+ * mono_ppdb_lookup_location:
+ * \param minfo A \c MonoDebugMethodInfo which can be retrieved by mono_debug_lookup_method().
+ * \param offset IL offset within the corresponding method's CIL code.
+ *
+ * This function is similar to mono_debug_lookup_location(), but we
+ * already looked up the method and also already did the
+ * native address -> IL offset mapping.
+ */
+MonoDebugSourceLocation *
+mono_ppdb_lookup_location (MonoDebugMethodInfo *minfo, uint32_t offset)
+{
+	MonoPPDBFile *ppdb = minfo->handle->ppdb;
+	MethodSeqPoints *msp;
+	SeqPointRecord *rec;
+	MonoDebugSourceLocation *location;
+	int lo, hi, docidx;
 
 	location = g_new0 (MonoDebugSourceLocation, 1);
-	location->source_file = docname;
-	location->row = start_line;
-	location->column = start_col;
-	location->il_offset = iloffset;
 
+	mono_debugger_lock ();
+	msp = get_method_seq_points (ppdb, minfo->method);
+	if (!msp) {
+		mono_debugger_unlock ();
+		g_free (location);
+		return NULL;
+	}
+
+	/* The last record at or before OFFSET, the first record always applies */
+	lo = 1;
+	hi = msp->n_records;
+	while (lo < hi) {
+		int mid = lo + (hi - lo) / 2;
+
+		if (msp->records [mid].il_offset <= (int)offset)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if (msp->n_records) {
+		rec = &msp->records [lo - 1];
+		location->row = rec->line;
+		location->column = rec->column;
+		location->il_offset = rec->il_offset;
+		docidx = msp->docs [rec->doc];
+	} else {
+		docidx = msp->docs [0];
+	}
+	mono_debugger_unlock ();
+
+	location->source_file = get_docname (ppdb, ppdb->image, docidx);
 	return location;
 }
 
@@ -454,18 +628,11 @@ mono_ppdb_get_seq_points (MonoDebugMethodInfo *minfo, char **source_file, GPtrAr
 {
 	MonoPPDBFile *ppdb = minfo->handle->ppdb;
 	MonoImage *image = ppdb->image;
-	MonoMethod *method = minfo->method;
-	MonoTableInfo *tables = image->tables;
-	guint32 cols [MONO_METHODBODY_SIZE];
-	const char *ptr;
-	const char *end;
-	MonoDebugSourceInfo *docinfo;
-	int i, method_idx, size, docidx, iloffset, delta_il, delta_lines, delta_cols, start_line, start_col, adv_line, adv_col;
-	gboolean first = TRUE, first_non_hidden = TRUE;
-	GArray *sps;
-	MonoSymSeqPoint sp;
+	MethodSeqPoints *msp;
+	MonoSymSeqPoint *sp;
+	int i, n, n_docs;
+	int *docs, *sp_docs;
 	GPtrArray *sfiles = NULL;
-	GPtrArray *sindexes = NULL;
 
 	if (source_file)
 		*source_file = NULL;
@@ -480,112 +647,63 @@ mono_ppdb_get_seq_points (MonoDebugMethodInfo *minfo, char **source_file, GPtrAr
 
 	if (source_file_list)
 		*source_file_list = sfiles = g_ptr_array_new ();
-	if (source_files)
-		sindexes = g_ptr_array_new ();
 
-	if (!method->token)
+	/* Copy out of the cache, an entry can be evicted once the lock is released */
+	mono_debugger_lock ();
+	msp = get_method_seq_points (ppdb, minfo->method);
+	if (!msp) {
+		mono_debugger_unlock ();
 		return;
-
-	method_idx = mono_metadata_token_index (method->token);
-
-	MonoTableInfo *methodbody_table = &tables [MONO_TABLE_METHODBODY];
-	if (G_UNLIKELY (method_idx - 1 >= methodbody_table->rows)) {
-		char *method_name = mono_method_full_name (method, FALSE);
-		g_error ("Method idx %d is greater than number of rows (%d) in PPDB MethodDebugInformation table, for method %s in '%s'. Likely a malformed PDB file.",
-			   method_idx - 1, methodbody_table->rows, method_name, image->name);
-		g_free (method_name);
 	}
-	mono_metadata_decode_row (methodbody_table, method_idx - 1, cols, MONO_METHODBODY_SIZE);
-
-	docidx = cols [MONO_METHODBODY_DOCUMENT];
-
-	if (!cols [MONO_METHODBODY_SEQ_POINTS])
-		return;
 
-	ptr = mono_metadata_blob_heap (image, cols [MONO_METHODBODY_SEQ_POINTS]);
-	size = mono_metadata_decode_blob_size (ptr, &ptr);
-	end = ptr + size;
-
-	sps = g_array_new (FALSE, TRUE, sizeof (MonoSymSeqPoint));
-
-	/* Header */
-	/* LocalSignature */
-	mono_metadata_decode_value (ptr, &ptr);
-	if (docidx == 0)
-		docidx = mono_metadata_decode_value (ptr, &ptr);
-	docinfo = get_docinfo (ppdb, image, docidx);
-
-	if (sfiles)
-		g_ptr_array_add (sfiles, docinfo);
-
-	if (source_file)
-		*source_file = g_strdup (docinfo->source_file);
+	n = 0;
+	for (i = 0; i < msp->n_records; ++i) {
+		if (!msp->records [i].hidden)
+			n ++;
+	}
+	sp = g_new0 (MonoSymSeqPoint, n);
+	sp_docs = g_new (int, n);
+	n = 0;
+	for (i = 0; i < msp->n_records; ++i) {
+		SeqPointRecord *rec = &msp->records [i];
 
-	iloffset = 0;
-	start_line = 0;
-	start_col = 0;
-	while (ptr < end) {
-		delta_il = mono_metadata_decode_value (ptr, &ptr);
-		if (!first && delta_il == 0) {
-			/* subsequent-document-record */
-			docidx = mono_metadata_decode_value (ptr, &ptr);
-			docinfo = get_docinfo (ppdb, image, docidx);
-			if (sfiles)
-				g_ptr_array_add (sfiles, docinfo);
+		if (rec->hidden)
 			continue;
-		}
-		iloffset += delta_il;
-		first = FALSE;
-
-		delta_lines = mono_metadata_decode_value (ptr, &ptr);
-		if (delta_lines == 0)
-			delta_cols = mono_metadata_decode_value (ptr, &ptr);
-		else
-			delta_cols = mono_metadata_decode_signed_value (ptr, &ptr);
+		sp [n].il_offset = rec->il_offset;
+		sp [n].line = rec->line;
+		sp [n].column = rec->column;
+		sp [n].end_line = rec->end_line;
+		sp [n].end_column = rec->end_column;
+		sp_docs [n] = rec->doc;
+		n ++;
+	}
+	n_docs = msp->n_docs;
+	docs = (int *)g_memdup (msp->docs, n_docs * sizeof (int));
+	mono_debugger_unlock ();
 
-		if (delta_lines == 0 && delta_cols == 0) {
-			/* Hidden sequence point */
-			continue;
-		}
+	if (source_file)
+		*source_file = g_strdup (get_docinfo (ppdb, image, docs [0])->source_file);
 
-		if (first_non_hidden) {
-			start_line = mono_metadata_decode_value (ptr, &ptr);
-			start_col = mono_metadata_decode_value (ptr, &ptr);
-		} else {
-			adv_line = mono_metadata_decode_signed_value (ptr, &ptr);
-			adv_col = mono_metadata_decode_signed_value (ptr, &ptr);
-			start_line += adv_line;
-			start_col += adv_col;
-		}
-		first_non_hidden = FALSE;
-
-		memset (&sp, 0, sizeof (sp));
-		sp.il_offset = iloffset;
-		sp.line = start_line;
-		sp.column = start_col;
-		sp.end_line = start_line + delta_lines;
-		sp.end_column = start_col + delta_cols;
-
-		g_array_append_val (sps, sp);
-		if (source_files)
-			g_ptr_array_add (sindexes, GUINT_TO_POINTER (sfiles->len - 1));
+	if (sfiles) {
+		for (i = 0; i < n_docs; ++i)
+			g_ptr_array_add (sfiles, get_docinfo (ppdb, image, docs [i]));
 	}
 
 	if (n_seq_points) {
-		*n_seq_points = sps->len;
 		g_assert (seq_points);
-		*seq_points = g_new (MonoSymSeqPoint, sps->len);
-		memcpy (*seq_points, sps->data, sps->len * sizeof (MonoSymSeqPoint));
+		*n_seq_points = n;
+		*seq_points = sp;
+		sp = NULL;
 	}
 
 	if (source_files) {
-		*source_files = g_new (int, sps->len);
-		for (i = 0; i < sps->len; ++i)
-			(*source_files)[i] = GPOINTER_TO_INT (g_ptr_array_index (sindexes, i));
-		g_ptr_array_free (sindexes, TRUE);
+		*source_files = sp_docs;
+		sp_docs = NULL;
 	}
 
-	g_array_free (sps, TRUE);
+	g_free (sp);
+	g_free (sp_docs);
+	g_free (docs);
 }
 
 MonoDebugLocalsInfo*
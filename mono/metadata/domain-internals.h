@@ -78,6 +78,7 @@ typedef struct _MonoJitInfoTable MonoJitInfoTable;
 typedef struct _MonoJitInfoTableChunk MonoJitInfoTableChunk;
 
 #define MONO_JIT_INFO_TABLE_CHUNK_SIZE		64
+#define MONO_JIT_INFO_LOOKUP_CACHE_SIZE		512
 
 struct _MonoJitInfoTableChunk
 {
@@ -363,9 +364,9 @@ struct _MonoDomain {
 	 */
 #define MONO_DOMAIN_FIRST_GC_TRACKED env
 	MonoGHashTable     *env;
-	MonoGHashTable     *ldstr_table;
+	MonoConcGHashTable *ldstr_table;
 	/* hashtables for Reflection handles */
-	MonoGHashTable     *type_hash;
+	MonoConcGHashTable *type_hash;
 	MonoConcGHashTable     *refobject_hash;
 	/* maps class -> type initialization exception object */
 	MonoGHashTable    *type_init_exception_hash;
@@ -402,6 +403,9 @@ struct _MonoDomain {
 	MonoJitInfoTable *
 	  volatile          aot_modules;
 	GSList		   *jit_info_free_queue;
+	/* Direct mapped cache of recent jit_info_table lookups, see jit-info.c */
+	MonoJitInfo * volatile jit_info_lookup_cache [MONO_JIT_INFO_LOOKUP_CACHE_SIZE];
+	gint32 volatile jit_info_lookup_cache_gen;
 	/* Used when loading assemblies */
 	gchar **search_path;
 	gchar *private_bin_path;
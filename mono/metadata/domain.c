@@ -37,6 +37,7 @@
 #include <mono/metadata/assembly-internals.h>
 #include <mono/metadata/exception.h>
 #include <mono/metadata/metadata-internals.h>
+#include <mono/metadata/mempool-internals.h>
 #include <mono/metadata/appdomain.h>
 #include <mono/metadata/mono-config.h>
 #include <mono/metadata/mono-hash-internals.h>
@@ -446,7 +447,7 @@ mono_domain_create (void)
 
 	MONO_PROFILER_RAISE (domain_loading, (domain));
 
-	domain->mp = mono_mempool_new ();
+	domain->mp = mono_mempool_new_arena (MONO_JEMALLOC_ARENA_METADATA);
 	domain->code_mp = mono_code_manager_new ();
 	domain->lock_free_mp = lock_free_mempool_new ();
 	domain->env = mono_g_hash_table_new_type_internal ((GHashFunc)mono_string_hash_internal, (GCompareFunc)mono_string_equal_internal, MONO_HASH_KEY_VALUE_GC, MONO_ROOT_SOURCE_DOMAIN, domain, "Domain Environment Variable Table");
@@ -456,7 +457,7 @@ mono_domain_create (void)
 	domain->class_vtable_array = g_ptr_array_new ();
 	domain->proxy_vtable_hash = g_hash_table_new ((GHashFunc)mono_ptrarray_hash, (GCompareFunc)mono_ptrarray_equal);
 	mono_jit_code_hash_init (&domain->jit_code_hash);
-	domain->ldstr_table = mono_g_hash_table_new_type_internal ((GHashFunc)mono_string_hash_internal, (GCompareFunc)mono_string_equal_internal, MONO_HASH_KEY_VALUE_GC, MONO_ROOT_SOURCE_DOMAIN, domain, "Domain String Pool Table");
+	domain->ldstr_table = mono_conc_g_hash_table_new_type ((GHashFunc)mono_string_hash_internal, (GCompareFunc)mono_string_equal_internal, MONO_HASH_KEY_VALUE_GC, MONO_ROOT_SOURCE_DOMAIN, domain, "Domain String Pool Table");
 	domain->num_jit_info_table_duplicates = 0;
 	domain->jit_info_table = mono_jit_info_table_new (domain);
 	domain->jit_info_free_queue = NULL;
@@ -1101,6 +1102,8 @@ mono_domain_free (MonoDomain *domain, gboolean force)
 
 	mono_debug_domain_unload (domain);
 
+	mono_cast_cache_clear ();
+
 	/* must do this early as it accesses fields and types */
 	if (domain->special_static_fields) {
 		mono_alloc_special_static_data_free (domain->special_static_fields);
@@ -1115,7 +1118,7 @@ mono_domain_free (MonoDomain *domain, gboolean force)
 	 * no more such references, or we'll crash if a collection
 	 * occurs.
 	 */
-	mono_g_hash_table_destroy (domain->ldstr_table);
+	mono_conc_g_hash_table_destroy (domain->ldstr_table);
 	domain->ldstr_table = NULL;
 
 	mono_g_hash_table_destroy (domain->env);
@@ -1131,7 +1134,7 @@ mono_domain_free (MonoDomain *domain, gboolean force)
 	}
 
 	if (domain->type_hash) {
-		mono_g_hash_table_destroy (domain->type_hash);
+		mono_conc_g_hash_table_destroy (domain->type_hash);
 		domain->type_hash = NULL;
 	}
 	if (domain->type_init_exception_hash) {
@@ -2059,7 +2062,7 @@ mono_domain_alcs_unlock (MonoDomain *domain)
 
 
 static MonoAssemblyLoadContext *
-create_alc (MonoDomain *domain, gboolean is_default)
+create_alc (MonoDomain *domain, gboolean is_default, gboolean collectible)
 {
 #ifdef ENABLE_NETCORE
 	MonoAssemblyLoadContext *alc = NULL;
@@ -2069,7 +2072,7 @@ create_alc (MonoDomain *domain, gboolean is_default)
 		goto leave;
 
 	alc = g_new0 (MonoAssemblyLoadContext, 1);
-	mono_alc_init (alc, domain);
+	mono_alc_init (alc, domain, collectible);
 
 	domain->alcs = g_slist_prepend (domain->alcs, alc);
 	if (is_default)
@@ -2088,7 +2091,7 @@ mono_domain_create_default_alc (MonoDomain *domain)
 #ifdef ENABLE_NETCORE
 	if (domain->default_alc)
 		return;
-	create_alc (domain, TRUE);
+	create_alc (domain, TRUE, FALSE);
 #endif
 }
 
@@ -2096,8 +2099,8 @@ mono_domain_create_default_alc (MonoDomain *domain)
 MonoAssemblyLoadContext *
 mono_domain_create_individual_alc (MonoDomain *domain, uint32_t this_gchandle, gboolean collectible, MonoError *error)
 {
-	g_assert (!collectible); /* TODO: implement collectible ALCs */
-	MonoAssemblyLoadContext *alc = create_alc (domain, FALSE);
+	MonoAssemblyLoadContext *alc = create_alc (domain, FALSE, collectible);
+	alc->gchandle = this_gchandle;
 	return alc;
 }
 #endif
@@ -96,6 +96,8 @@ enum {
 static int mmap_init_state;
 static MonoCoopMutex named_regions_mutex;
 static GHashTable *named_regions;
+/* MONO_MMAP_* hints added to every view, from MONO_MMAP_OPTIONS */
+static int mmap_hint_flags;
 
 
 static gint64
@@ -112,9 +114,44 @@ align_down_to_page_size (gint64 size)
 	return size & ~(page_size - 1);
 }
 
+/*
+ * MONO_MMAP_OPTIONS is a comma separated list of:
+ *  hugepages: back views with huge pages where the OS can, and shared
+ *   memory with pages from the reserved huge page pool
+ *  populate: fault in views when they are created
+ *  sequential, random: the expected access pattern of views
+ */
+static int
+parse_mmap_options (const char *options)
+{
+	char **opts, **ptr;
+	int flags = 0;
+
+	opts = g_strsplit (options, ",", -1);
+	for (ptr = opts; ptr && *ptr; ptr++) {
+		const char *opt = g_strstrip (*ptr);
+
+		if (!strcmp (opt, "hugepages"))
+			flags |= MONO_MMAP_HUGEPAGES;
+		else if (!strcmp (opt, "populate"))
+			flags |= MONO_MMAP_POPULATE;
+		else if (!strcmp (opt, "sequential"))
+			flags |= MONO_MMAP_SEQUENTIAL;
+		else if (!strcmp (opt, "random"))
+			flags |= MONO_MMAP_RANDOM;
+		else if (*opt)
+			g_warning ("Unknown MONO_MMAP_OPTIONS option '%s'", opt);
+	}
+	g_strfreev (opts);
+
+	return flags;
+}
+
 static void
 file_mmap_init (void)
 {
+	char *options;
+
 retry:	
 	switch (mmap_init_state) {
 	case  0:
@@ -123,6 +160,12 @@ retry:
 		named_regions = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, NULL);
 		mono_coop_mutex_init (&named_regions_mutex);
 
+		options = g_getenv ("MONO_MMAP_OPTIONS");
+		if (options) {
+			mmap_hint_flags = parse_mmap_options (options);
+			g_free (options);
+		}
+
 		mono_atomic_store_release (&mmap_init_state, 2);
 		break;
 
@@ -305,6 +348,64 @@ done:
 }
 
 #define MONO_ANON_FILE_TEMPLATE "/mono.anonmap.XXXXXXXXX"
+
+/* Returns a file descriptor for \p capacity bytes of shared memory, or -1 */
+static int
+create_anonymous_file (const char *c_mapName, gint64 capacity)
+{
+	int fd;
+	char *file_name;
+	const char *tmp_dir;
+	int unused G_GNUC_UNUSED, alloc_size;
+
+#ifdef HAVE_MEMFD_CREATE
+	/* Anonymous memory that never reaches the file system */
+#ifdef MFD_HUGETLB
+	if (mmap_hint_flags & MONO_MMAP_HUGEPAGES) {
+		MONO_ENTER_GC_SAFE;
+		fd = memfd_create (c_mapName, MFD_HUGETLB);
+		/* Fails if the pool is too small or capacity isn't a multiple of the huge page size */
+		if (fd != -1 && ftruncate (fd, (off_t)capacity) == -1) {
+			close (fd);
+			fd = -1;
+		}
+		MONO_EXIT_GC_SAFE;
+		if (fd != -1)
+			return fd;
+	}
+#endif
+	MONO_ENTER_GC_SAFE;
+	fd = memfd_create (c_mapName, 0);
+	MONO_EXIT_GC_SAFE;
+	if (fd != -1) {
+		unused = ftruncate (fd, (off_t)capacity);
+		return fd;
+	}
+#endif
+
+	tmp_dir = g_get_tmp_dir ();
+	alloc_size = strlen (tmp_dir) + strlen (MONO_ANON_FILE_TEMPLATE) + 1;
+	if (alloc_size > 1024) //rather fail that stack overflow
+		return -1;
+	file_name = g_newa (char, alloc_size);
+	strcpy (file_name, tmp_dir);
+	strcat (file_name, MONO_ANON_FILE_TEMPLATE);
+
+	MONO_ENTER_GC_SAFE;
+	fd = mkstemp (file_name);
+	MONO_EXIT_GC_SAFE;
+	if (fd == -1)
+		return -1;
+
+	MONO_ENTER_GC_SAFE;
+	unlink (file_name);
+	MONO_EXIT_GC_SAFE;
+#ifdef HAVE_FTRUNCATE
+	unused = ftruncate (fd, (off_t)capacity);
+#endif
+	return fd;
+}
+
 static void*
 open_memory_map (const char *c_mapName, int mode, gint64 *capacity, int access, int options, int *ioerror)
 {
@@ -337,9 +438,6 @@ open_memory_map (const char *c_mapName, int mode, gint64 *capacity, int access,
 		//XXX should we ftruncate if the file is smaller than capacity?
 	} else {
 		int fd;
-		char *file_name;
-		const char *tmp_dir;
-		int unused G_GNUC_UNUSED, alloc_size;
 
 		if (mode == FILE_MODE_OPEN) {
 			*ioerror = FILE_NOT_FOUND;
@@ -347,31 +445,12 @@ open_memory_map (const char *c_mapName, int mode, gint64 *capacity, int access,
 		}
 		*capacity = align_up_to_page_size (*capacity);
 
-		tmp_dir = g_get_tmp_dir ();
-		alloc_size = strlen (tmp_dir) + strlen (MONO_ANON_FILE_TEMPLATE) + 1;
-		if (alloc_size > 1024) {//rather fail that stack overflow
-			*ioerror = COULD_NOT_MAP_MEMORY;
-			goto done;
-		}
-		file_name = g_newa (char, alloc_size);
-		strcpy (file_name, tmp_dir);
-		strcat (file_name, MONO_ANON_FILE_TEMPLATE);
-
-		MONO_ENTER_GC_SAFE;
-		fd = mkstemp (file_name);
-		MONO_EXIT_GC_SAFE;
+		fd = create_anonymous_file (c_mapName, *capacity);
 		if (fd == -1) {
 			*ioerror = COULD_NOT_MAP_MEMORY;
 			goto done;
 		}
 
-		MONO_ENTER_GC_SAFE;
-		unlink (file_name);
-		MONO_EXIT_GC_SAFE;
-#ifdef HAVE_FTRUNCATE
-		unused = ftruncate (fd, (off_t)*capacity);
-#endif
-
 		handle = g_new0 (MmapHandle, 1);
 		handle->ref_count = 1;
 		handle->capacity = *capacity;
@@ -526,6 +605,8 @@ mono_mmap_map (void *handle, gint64 offset, gint64 *size, int access, void **mma
 	*mmap_handle = NULL;
 	*base_address = NULL;
 
+	file_mmap_init ();
+
 	if (offset > buf.st_size || ((eff_size + offset) > buf.st_size && !is_special_zero_size_file (&buf)))
 		return ACCESS_DENIED;
 	/**
@@ -541,7 +622,7 @@ mono_mmap_map (void *handle, gint64 offset, gint64 *size, int access, void **mma
 	eff_size += (offset - mmap_offset);
 	MONO_ENTER_GC_SAFE;
 	//FIXME translate some interesting errno values
-	res.address = mono_file_map ((size_t)eff_size, access_to_mmap_flags (access), fh->fd, mmap_offset, &res.free_handle);
+	res.address = mono_file_map ((size_t)eff_size, access_to_mmap_flags (access) | mmap_hint_flags, fh->fd, mmap_offset, &res.free_handle);
 	MONO_EXIT_GC_SAFE;
 	res.length = eff_size;
 
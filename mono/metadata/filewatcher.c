@@ -30,6 +30,21 @@
 #include <mono/utils/mono-dl.h>
 #include <mono/utils/mono-io-portability.h>
 #include <mono/metadata/w32error.h>
+#include <mono/utils/mono-threads.h>
+#include <mono/utils/refcount.h>
+#include "icall-decl.h"
+
+#if defined(HAVE_SYS_INOTIFY_H) && !defined(HOST_WIN32)
+#include <sys/inotify.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <limits.h>
+#include <mono/utils/mono-errno.h>
+#include <mono/utils/strenc-internals.h>
+#endif
 
 #ifdef HOST_WIN32
 
@@ -73,6 +88,8 @@ ves_icall_System_IO_FSW_SupportsFSW (void)
 	if (inotify_instance == -1)
 		return  0; /* DefaultWatcher */
 	close (inotify_instance);
+	if (getenv ("MONO_USE_INOTIFY_FSW"))
+		return 7; /* InotifyMonitor */
 	return 6; /* CoreFX */
 #elif HAVE_KQUEUE
 	return 3; /* kqueue */
@@ -186,4 +203,492 @@ ves_icall_System_IO_KqueueMonitor_kevent_notimeout (int *kq_ptr, gpointer change
 
 #endif /* #if HAVE_KQUEUE */
 
+#if defined(HAVE_SYS_INOTIFY_H) && !defined(HOST_WIN32)
+
+/*
+ * Native backend of System.IO.InotifyMonitor.
+ *
+ * A monitor watches a directory, and with RECURSIVE all of its subdirectories,
+ * with a single inotify instance.  Watches are added for new subdirectories as
+ * their creation is reported, and the paths of the watches under a renamed
+ * directory are updated in place, so the tree is only walked once.  Events are
+ * read in batches and handed to managed code as parallel arrays of kinds and
+ * paths relative to the watched directory:
+ *
+ * - consecutive changes of the same file within a batch are reported once,
+ * - a rename within the tree is reported as RENAMED_FROM directly followed by
+ *   RENAMED_TO, a move out of or into the tree as DELETED or CREATED,
+ * - the entries of a directory created in the tree are reported as created
+ *   too, they might have been created before the watch was added,
+ * - if the kernel queue overflowed, an OVERFLOW event with a NULL path tells
+ *   the watcher to rescan.
+ *
+ * Open () returns a monitor holding one reference, which is dropped by
+ * Close (); ReadEvents () must not be called after Close () returned.
+ */
+
+/* Events returned by one ReadEvents () call, at most */
+#define INOTIFY_MONITOR_MAX_BATCH 4096
+
+#define INOTIFY_MONITOR_MASK (IN_CREATE | IN_DELETE | IN_MODIFY | IN_ATTRIB | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR | IN_EXCL_UNLINK)
+
+/* Must match System.IO.InotifyMonitor */
+enum {
+	INOTIFY_MONITOR_CREATED = 1,
+	INOTIFY_MONITOR_DELETED = 2,
+	INOTIFY_MONITOR_CHANGED = 4,
+	INOTIFY_MONITOR_RENAMED_FROM = 8,
+	INOTIFY_MONITOR_RENAMED_TO = 16,
+	INOTIFY_MONITOR_OVERFLOW = 32,
+};
+
+typedef struct {
+	MonoRefCount ref;
+	int fd;
+	int wakeup_pipe [2];
+	gchar *root;
+	gboolean recursive;
+	volatile gboolean closed;
+	/* Watch descriptor -> path of the directory relative to ROOT, "" for ROOT */
+	GHashTable *wds;
+} InotifyMonitor;
+
+typedef struct {
+	/* 0 for events dropped while the batch was processed */
+	gint32 kind;
+	gchar *path;
+} InotifyMonitorEvent;
+
+static void
+inotify_monitor_destroy (gpointer data)
+{
+	InotifyMonitor *monitor = (InotifyMonitor *) data;
+
+	close (monitor->fd);
+	close (monitor->wakeup_pipe [0]);
+	close (monitor->wakeup_pipe [1]);
+	g_hash_table_destroy (monitor->wds);
+	g_free (monitor->root);
+	g_free (monitor);
+}
+
+static void
+inotify_monitor_wakeup (gpointer data)
+{
+	InotifyMonitor *monitor = (InotifyMonitor *) data;
+	char c = 0;
+
+	while (write (monitor->wakeup_pipe [1], &c, 1) == -1 && errno == EINTR)
+		;
+}
+
+static gchar*
+inotify_monitor_join (const gchar *dir, const gchar *name)
+{
+	if (!*dir)
+		return g_strdup (name);
+	if (!*name)
+		return g_strdup (dir);
+	return g_build_filename (dir, name, (const char*)NULL);
+}
+
+/* Returns the index of the new event */
+static guint
+inotify_monitor_push (GArray *events, gint32 kind, gchar *path)
+{
+	InotifyMonitorEvent ev;
+
+	ev.kind = kind;
+	ev.path = path;
+	g_array_append_val (events, ev);
+	return events->len - 1;
+}
+
+/*
+ * Watch the directory PATH, relative to the root of MONITOR, and with a
+ * recursive monitor its subdirectories.  With EVENTS, the entries found are
+ * reported as created.  Returns 0 or the errno of the failure to watch PATH.
+ */
+static int
+inotify_monitor_add_tree (InotifyMonitor *monitor, const gchar *path, GArray *events)
+{
+	gchar *full_path = inotify_monitor_join (monitor->root, path);
+	struct dirent *entry;
+	DIR *dir;
+	int wd;
+
+	wd = inotify_add_watch (monitor->fd, full_path, INOTIFY_MONITOR_MASK);
+	if (wd == -1) {
+		int err = errno;
+		g_free (full_path);
+		return err;
+	}
+	g_hash_table_insert (monitor->wds, GINT_TO_POINTER (wd), g_strdup (path));
+
+	if (!monitor->recursive && !events) {
+		g_free (full_path);
+		return 0;
+	}
+
+	dir = opendir (full_path);
+	g_free (full_path);
+	if (!dir)
+		return 0;
+
+	while ((entry = readdir (dir))) {
+		gchar *child;
+		gboolean is_dir;
+
+		if (!strcmp (entry->d_name, ".") || !strcmp (entry->d_name, ".."))
+			continue;
+
+		child = inotify_monitor_join (path, entry->d_name);
+#ifdef DT_UNKNOWN
+		if (entry->d_type != DT_UNKNOWN) {
+			is_dir = entry->d_type == DT_DIR;
+		} else
+#endif
+		{
+			struct stat buf;
+			is_dir = fstatat (dirfd (dir), entry->d_name, &buf, AT_SYMLINK_NOFOLLOW) == 0 && S_ISDIR (buf.st_mode);
+		}
+
+		if (events)
+			inotify_monitor_push (events, INOTIFY_MONITOR_CREATED, g_strdup (child));
+		if (is_dir && monitor->recursive)
+			inotify_monitor_add_tree (monitor, child, events);
+		g_free (child);
+	}
+	closedir (dir);
+
+	return 0;
+}
+
+static gboolean
+path_in_tree (const gchar *path, const gchar *tree)
+{
+	size_t len = strlen (tree);
+
+	return !strncmp (path, tree, len) && (path [len] == '\0' || path [len] == G_DIR_SEPARATOR);
+}
+
+typedef struct {
+	InotifyMonitor *monitor;
+	const gchar *path;
+} RemoveTreeData;
+
+static gboolean
+remove_tree_func (gpointer key, gpointer value, gpointer user_data)
+{
+	RemoveTreeData *data = (RemoveTreeData *) user_data;
+
+	if (!path_in_tree ((const gchar *) value, data->path))
+		return FALSE;
+	inotify_rm_watch (data->monitor->fd, GPOINTER_TO_INT (key));
+	return TRUE;
+}
+
+/* Stop watching the directory PATH and its subdirectories, after it was moved out of the tree */
+static void
+inotify_monitor_remove_tree (InotifyMonitor *monitor, const gchar *path)
+{
+	RemoveTreeData data;
+
+	data.monitor = monitor;
+	data.path = path;
+	g_hash_table_foreach_remove (monitor->wds, remove_tree_func, &data);
+}
+
+/* Update the paths of the watches under FROM, after it was renamed to TO within the tree */
+static void
+inotify_monitor_rename_tree (InotifyMonitor *monitor, const gchar *from, const gchar *to)
+{
+	GHashTableIter iter;
+	gpointer key, value;
+	GSList *wds = NULL, *l;
+	size_t len = strlen (from);
+
+	g_hash_table_iter_init (&iter, monitor->wds);
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		if (path_in_tree ((const gchar *) value, from))
+			wds = g_slist_prepend (wds, key);
+	}
+
+	for (l = wds; l; l = l->next) {
+		const gchar *path = (const gchar *) g_hash_table_lookup (monitor->wds, l->data);
+		g_hash_table_insert (monitor->wds, l->data, g_strconcat (to, path + len, (const char*)NULL));
+	}
+	g_slist_free (wds);
+}
+
+/*
+ * Turn the inotify events in BUF into EVENTS.  LAST_EVENT maps the paths to the
+ * index of their last event in the batch, MOVES the cookies of the
+ * IN_MOVED_FROM events not yet paired to the index of their event.
+ */
+static void
+inotify_monitor_process (InotifyMonitor *monitor, const char *buf, ssize_t len, GArray *events, GHashTable *last_event, GHashTable *moves)
+{
+	const char *p = buf;
+
+	while (p < buf + len) {
+		const struct inotify_event *ev = (const struct inotify_event *) p;
+		const gchar *dir;
+		gchar *path;
+		gpointer last;
+		guint index;
+
+		p += sizeof (struct inotify_event) + ev->len;
+
+		if (ev->mask & IN_Q_OVERFLOW) {
+			inotify_monitor_push (events, INOTIFY_MONITOR_OVERFLOW, NULL);
+			continue;
+		}
+		if (ev->mask & IN_IGNORED) {
+			g_hash_table_remove (monitor->wds, GINT_TO_POINTER (ev->wd));
+			continue;
+		}
+
+		dir = (const gchar *) g_hash_table_lookup (monitor->wds, GINT_TO_POINTER (ev->wd));
+		if (!dir || !ev->len)
+			continue;
+		path = inotify_monitor_join (dir, ev->name);
+
+		if (ev->mask & (IN_MODIFY | IN_ATTRIB)) {
+			/* Coalesce with the previous change if nothing happened to the file in between */
+			if (g_hash_table_lookup_extended (last_event, path, NULL, &last) &&
+			    (&g_array_index (events, InotifyMonitorEvent, GPOINTER_TO_UINT (last)))->kind == INOTIFY_MONITOR_CHANGED) {
+				g_free (path);
+				continue;
+			}
+			index = inotify_monitor_push (events, INOTIFY_MONITOR_CHANGED, path);
+		} else if (ev->mask & IN_CREATE) {
+			index = inotify_monitor_push (events, INOTIFY_MONITOR_CREATED, path);
+			if ((ev->mask & IN_ISDIR) && monitor->recursive)
+				inotify_monitor_add_tree (monitor, path, events);
+		} else if (ev->mask & IN_DELETE) {
+			index = inotify_monitor_push (events, INOTIFY_MONITOR_DELETED, path);
+		} else if (ev->mask & IN_MOVED_FROM) {
+			/* Reported as deleted unless the IN_MOVED_TO shows up in this batch */
+			index = inotify_monitor_push (events, (ev->mask & IN_ISDIR) ? -INOTIFY_MONITOR_DELETED : INOTIFY_MONITOR_DELETED, path);
+			g_hash_table_insert (moves, GUINT_TO_POINTER (ev->cookie), GUINT_TO_POINTER (index));
+		} else if (ev->mask & IN_MOVED_TO) {
+			gpointer from_index;
+
+			if (g_hash_table_lookup_extended (moves, GUINT_TO_POINTER (ev->cookie), NULL, &from_index)) {
+				InotifyMonitorEvent *from = &g_array_index (events, InotifyMonitorEvent, GPOINTER_TO_UINT (from_index));
+				gchar *from_path = from->path;
+
+				g_hash_table_remove (moves, GUINT_TO_POINTER (ev->cookie));
+				from->kind = 0;
+				from->path = NULL;
+				g_hash_table_remove (last_event, from_path);
+				if (ev->mask & IN_ISDIR)
+					inotify_monitor_rename_tree (monitor, from_path, path);
+				inotify_monitor_push (events, INOTIFY_MONITOR_RENAMED_FROM, from_path);
+				index = inotify_monitor_push (events, INOTIFY_MONITOR_RENAMED_TO, path);
+			} else {
+				index = inotify_monitor_push (events, INOTIFY_MONITOR_CREATED, path);
+				if ((ev->mask & IN_ISDIR) && monitor->recursive)
+					inotify_monitor_add_tree (monitor, path, events);
+			}
+		} else {
+			g_free (path);
+			continue;
+		}
+
+		g_hash_table_insert (last_event, path, GUINT_TO_POINTER (index));
+	}
+}
+
+gpointer
+ves_icall_System_IO_InotifyMonitor_Open (const gunichar2 *path, MonoBoolean recursive, gint32 *error_code, MonoError *error)
+{
+	InotifyMonitor *monitor;
+	gchar *utf8_path;
+	int err;
+
+	utf8_path = mono_unicode_to_external_checked (path, error);
+	return_val_if_nok (error, NULL);
+
+	monitor = g_new0 (InotifyMonitor, 1);
+	mono_refcount_init (monitor, inotify_monitor_destroy);
+	monitor->fd = inotify_init1 (IN_NONBLOCK | IN_CLOEXEC);
+	if (monitor->fd == -1) {
+		*error_code = errno;
+		g_free (utf8_path);
+		g_free (monitor);
+		return NULL;
+	}
+	if (pipe2 (monitor->wakeup_pipe, O_NONBLOCK | O_CLOEXEC) == -1) {
+		*error_code = errno;
+		close (monitor->fd);
+		g_free (utf8_path);
+		g_free (monitor);
+		return NULL;
+	}
+	monitor->root = utf8_path;
+	monitor->recursive = recursive;
+	monitor->wds = g_hash_table_new_full (NULL, NULL, NULL, g_free);
+
+	MONO_ENTER_GC_SAFE;
+	err = inotify_monitor_add_tree (monitor, "", NULL);
+	MONO_EXIT_GC_SAFE;
+	if (err) {
+		*error_code = err;
+		mono_refcount_dec (monitor);
+		return NULL;
+	}
+
+	*error_code = 0;
+	return monitor;
+}
+
+/*
+ * ves_icall_System_IO_InotifyMonitor_ReadEvents:
+ *
+ *   Wait up to TIMEOUT ms for events and return their paths, with their kinds in
+ * KINDS.  Returns an empty array on timeout or thread interruption, and NULL
+ * once the monitor is closed.
+ */
+MonoArrayHandle
+ves_icall_System_IO_InotifyMonitor_ReadEvents (gpointer handle, gint32 timeout, MonoArrayHandleOut kinds, MonoError *error)
+{
+	InotifyMonitor *monitor = (InotifyMonitor *) handle;
+	MonoDomain *domain = mono_domain_get ();
+	MonoArrayHandle paths = NULL_HANDLE_ARRAY;
+	struct pollfd fds [2];
+	GArray *events;
+	GHashTable *last_event, *moves;
+	gboolean interrupted;
+	guint32 i, count;
+	int res;
+	/* Room for at least 256 events with names of the default NAME_MAX */
+	char *buf;
+	const size_t buf_size = 256 * (sizeof (struct inotify_event) + NAME_MAX + 1);
+
+	mono_refcount_inc (monitor);
+
+	events = g_array_new (FALSE, FALSE, sizeof (InotifyMonitorEvent));
+	last_event = g_hash_table_new (g_str_hash, g_str_equal);
+	moves = g_hash_table_new (NULL, NULL);
+	buf = (char *) g_malloc (buf_size);
+
+	mono_thread_info_install_interrupt (inotify_monitor_wakeup, monitor, &interrupted);
+	if (interrupted)
+		goto done;
+
+	fds [0].fd = monitor->fd;
+	fds [0].events = POLLIN;
+	fds [1].fd = monitor->wakeup_pipe [0];
+	fds [1].events = POLLIN;
+
+	MONO_ENTER_GC_SAFE;
+	do {
+		res = poll (fds, 2, timeout);
+	} while (res == -1 && errno == EINTR && !monitor->closed);
+
+	if (res > 0 && (fds [1].revents & POLLIN)) {
+		char c;
+		while (read (monitor->wakeup_pipe [0], &c, 1) == 1)
+			;
+	}
+
+	/* Drain what the kernel has queued so far, to coalesce as much as possible */
+	while (!monitor->closed && res > 0 && events->len < INOTIFY_MONITOR_MAX_BATCH) {
+		ssize_t len = read (monitor->fd, buf, buf_size);
+		if (len <= 0)
+			break;
+		inotify_monitor_process (monitor, buf, len, events, last_event, moves);
+	}
+	MONO_EXIT_GC_SAFE;
+
+	mono_thread_info_uninstall_interrupt (&interrupted);
+
+done:
+	if (monitor->closed)
+		goto leave;
+
+	count = 0;
+	for (i = 0; i < events->len; ++i) {
+		InotifyMonitorEvent *ev = &g_array_index (events, InotifyMonitorEvent, i);
+
+		/* Unpaired IN_MOVED_FROM of a directory, it left the tree */
+		if (ev->kind == -INOTIFY_MONITOR_DELETED) {
+			inotify_monitor_remove_tree (monitor, ev->path);
+			ev->kind = INOTIFY_MONITOR_DELETED;
+		}
+		if (ev->kind)
+			count ++;
+	}
+
+	paths = mono_array_new_handle (domain, mono_get_string_class (), count, error);
+	goto_if_nok (error, leave);
+	MONO_HANDLE_ASSIGN (kinds, mono_array_new_handle (domain, mono_get_int32_class (), count, error));
+	goto_if_nok (error, leave);
+
+	count = 0;
+	for (i = 0; i < events->len; ++i) {
+		InotifyMonitorEvent *ev = &g_array_index (events, InotifyMonitorEvent, i);
+
+		if (!ev->kind)
+			continue;
+		if (ev->path) {
+			MonoStringHandle str = mono_string_new_handle (domain, ev->path, error);
+			goto_if_nok (error, leave);
+			MONO_HANDLE_ARRAY_SETREF (paths, count, str);
+		}
+		MONO_HANDLE_ARRAY_SETVAL (kinds, gint32, count, ev->kind);
+		count ++;
+	}
+
+leave:
+	for (i = 0; i < events->len; ++i)
+		g_free ((&g_array_index (events, InotifyMonitorEvent, i))->path);
+	g_array_free (events, TRUE);
+	g_hash_table_destroy (last_event);
+	g_hash_table_destroy (moves);
+	g_free (buf);
+
+	mono_refcount_dec (monitor);
+
+	if (!is_ok (error))
+		return NULL_HANDLE_ARRAY;
+	return paths;
+}
+
+void
+ves_icall_System_IO_InotifyMonitor_Close (gpointer handle, MonoError *error)
+{
+	InotifyMonitor *monitor = (InotifyMonitor *) handle;
+
+	monitor->closed = TRUE;
+	inotify_monitor_wakeup (monitor);
+	mono_refcount_dec (monitor);
+}
+
+#else
+
+gpointer
+ves_icall_System_IO_InotifyMonitor_Open (const gunichar2 *path, MonoBoolean recursive, gint32 *error_code, MonoError *error)
+{
+	g_assert_not_reached ();
+	return NULL;
+}
+
+MonoArrayHandle
+ves_icall_System_IO_InotifyMonitor_ReadEvents (gpointer handle, gint32 timeout, MonoArrayHandleOut kinds, MonoError *error)
+{
+	g_assert_not_reached ();
+	return NULL_HANDLE_ARRAY;
+}
+
+void
+ves_icall_System_IO_InotifyMonitor_Close (gpointer handle, MonoError *error)
+{
+	g_assert_not_reached ();
+}
+
+#endif /* defined(HAVE_SYS_INOTIFY_H) && !defined(HOST_WIN32) */
+
 #endif /* !ENABLE_NETCORE */
@@ -103,6 +103,15 @@ MonoGCDescriptor mono_gc_make_root_descr_user (MonoGCRootMarkFunc marker);
 /* Return whenever user defined marking functions are supported */
 gboolean mono_gc_user_markers_supported (void);
 
+typedef gboolean (*MonoGCStackWordFunc) (gpointer word, gpointer user_data);
+
+/*
+ * Call FUNC with every word of the stacks and saved registers of the stopped
+ * threads until it returns TRUE.  Has the same restrictions as mono_gc_walk_heap ().
+ * Returns a non-zero value if the GC can't scan stacks.
+ */
+int mono_gc_scan_thread_stacks (MonoGCStackWordFunc func, gpointer user_data);
+
 /* desc is the result from mono_gc_make_descr*. A NULL value means
  * all the words might contain GC pointers.
  * The memory is non-moving and it will be explicitly deallocated.
@@ -139,6 +148,10 @@ mono_gc_alloc_handle_obj (MonoVTable *vtable, gsize size);
 MonoArray*
 mono_gc_alloc_vector (MonoVTable *vtable, size_t size, uintptr_t max_length);
 
+/* Like mono_gc_alloc_vector (), but the elements might not be cleared, VTABLE can't have references */
+MonoArray*
+mono_gc_alloc_uninitialized_vector (MonoVTable *vtable, size_t size, uintptr_t max_length);
+
 MonoArrayHandle
 mono_gc_alloc_handle_vector (MonoVTable *vtable, gsize size, gsize max_length);
 
@@ -151,6 +164,10 @@ mono_gc_alloc_handle_array (MonoVTable *vtable, gsize size, gsize max_length, gs
 MonoString*
 mono_gc_alloc_string (MonoVTable *vtable, size_t size, gint32 len);
 
+/* Like mono_gc_alloc_string (), but the characters might not be cleared, only the terminator is */
+MonoString*
+mono_gc_alloc_uninitialized_string (MonoVTable *vtable, size_t size, gint32 len);
+
 MonoStringHandle
 mono_gc_alloc_handle_string (MonoVTable *vtable, gsize size, gint32 len);
 
@@ -211,6 +228,7 @@ typedef enum {
 
 int mono_gc_get_aligned_size_for_allocator (int size);
 MonoMethod* mono_gc_get_managed_allocator (MonoClass *klass, gboolean for_box, gboolean known_instance_size);
+gboolean mono_gc_can_inline_managed_allocator (void);
 MonoMethod* mono_gc_get_managed_array_allocator (MonoClass *klass);
 MonoMethod *mono_gc_get_managed_allocator_by_type (int atype, ManagedAllocatorVariant variant);
 
@@ -263,6 +281,12 @@ typedef struct {
 	 *   using precise marking by calling mono_gc_scan_object ().
 	 */
 	void (*thread_mark_func) (gpointer user_data, guint8 *stack_start, guint8 *stack_end, gboolean precise, void *gc_data);
+	/*
+	 * Function called with the world stopped to get the part of the interpreter
+	 * stack of a thread that is in use. jit_tls is the JIT TLS data of the thread.
+	 * The range is scanned conservatively, like the native stack.
+	 */
+	void (*interp_stack_range_func) (gpointer jit_tls, gpointer *start, gpointer *end);
 	/*
 	 * Function called for debugging to get the current managed method for
 	 * tracking the provenances of objects.
@@ -313,6 +337,12 @@ int mono_gc_get_los_limit (void);
 
 guint64 mono_gc_get_allocated_bytes_for_current_thread (void);
 
+/*
+ * Have the GC flag one allocation for every INTERVAL bytes allocated by a
+ * thread, on average.  Returns FALSE if the GC doesn't support this.
+ */
+gboolean mono_gc_set_allocation_sample_interval (guint32 interval);
+
 guint8* mono_gc_get_card_table (int *shift_bits, gpointer *card_mask);
 guint8* mono_gc_get_target_card_table (int *shift_bits, target_mgreg_t *card_mask);
 gboolean mono_gc_card_table_nursery_check (void);
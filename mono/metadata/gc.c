@@ -938,6 +938,10 @@ mono_runtime_do_background_work (void)
 	mono_w32process_signal_finished ();
 
 	hazard_free_queue_pump ();
+
+#ifdef ENABLE_NETCORE
+	mono_alc_release_unused ();
+#endif
 }
 
 static gsize WINAPI
@@ -1188,30 +1192,69 @@ ref_list_push (RefQueueEntry **head, RefQueueEntry *value)
 	} while (mono_atomic_cas_ptr ((volatile gpointer *)head, value, current) != current);
 }
 
+/*
+ * Processes the entries of QUEUE as one batch: the list is detached with a
+ * single exchange, the entries whose target is still alive are spliced back
+ * with a single CAS and only then the callbacks of the collected ones run.
+ * Entries added concurrently by mono_gc_reference_queue_add () end up in
+ * the emptied list and are kept.
+ */
 static void
 reference_queue_proccess (MonoReferenceQueue *queue)
 {
-	RefQueueEntry **iter = &queue->queue;
-	RefQueueEntry *entry;
-	while ((entry = *iter)) {
+	RefQueueEntry *entry, *next, *current;
+	RefQueueEntry *alive = NULL, **alive_tail = &alive;
+	RefQueueEntry *dead = NULL;
+
+	entry = (RefQueueEntry *)mono_atomic_xchg_ptr ((volatile gpointer *)&queue->queue, NULL);
+	for (; entry; entry = next) {
+		next = entry->next;
 		if (queue->should_be_deleted || !mono_gchandle_get_target_internal (entry->gchandle)) {
-			mono_gchandle_free_internal ((guint32)entry->gchandle);
-			ref_list_remove_element (iter, entry);
-			queue->callback (entry->user_data);
-			g_free (entry);
+			entry->next = dead;
+			dead = entry;
 		} else {
-			iter = &entry->next;
+			*alive_tail = entry;
+			alive_tail = &entry->next;
 		}
 	}
+
+	if (alive) {
+		do {
+			current = queue->queue;
+			*alive_tail = current;
+			STORE_STORE_FENCE; /*Must make sure the previous store is visible before the CAS. */
+		} while (mono_atomic_cas_ptr ((volatile gpointer *)&queue->queue, alive, current) != current);
+	}
+
+	for (entry = dead; entry; entry = next) {
+		next = entry->next;
+		mono_gchandle_free_internal ((guint32)entry->gchandle);
+		queue->callback (entry->user_data);
+		g_free (entry);
+	}
 }
 
+/* Sum of the collection counts the last time the queues were scanned */
+static int reference_queue_gc_count = -1;
+
 static void
 reference_queue_proccess_all (void)
 {
 	MonoReferenceQueue **iter;
 	MonoReferenceQueue *queue = ref_queues;
-	for (; queue; queue = queue->next)
-		reference_queue_proccess (queue);
+	int gc_count;
+
+	/*
+	 * Targets only go away during a collection, so if there was none since the
+	 * last scan only the queues being deleted need to be looked at.  The count
+	 * is read before scanning so a collection happening meanwhile is not missed.
+	 */
+	gc_count = mono_gc_collection_count (0) + mono_gc_collection_count (mono_gc_max_generation ());
+	if (gc_count != reference_queue_gc_count) {
+		reference_queue_gc_count = gc_count;
+		for (; queue; queue = queue->next)
+			reference_queue_proccess (queue);
+	}
 
 restart:
 	mono_coop_mutex_lock (&reference_queue_mutex);
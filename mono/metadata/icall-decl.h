@@ -23,6 +23,7 @@
 #include "object-forward.h"
 #include "object-internals.h"
 #include "rand.h"
+#include "rwlock.h"
 #include "reflection.h"
 #include "security-core-clr.h"
 #include "security-manager.h"
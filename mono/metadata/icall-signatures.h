@@ -104,6 +104,7 @@
 // mono_icall_sig_object_ptr_int_ptr
 // mono_icall_sig_object_ptr_ptr_int32
 // mono_icall_sig_ptr_object_int32_int32
+// mono_icall_sig_ptr_object_ptr_int32
 // mono_icall_sig_ptr_object_ptr_ptr
 // mono_icall_sig_ptr_ptr_int_ptr
 // mono_icall_sig_ptr_ptr_int32_ptrref
@@ -228,6 +229,7 @@ ICALL_SIG (4, (object, ptr, int, int32))	\
 ICALL_SIG (4, (object, ptr, int, ptr))	    \
 ICALL_SIG (4, (object, ptr, ptr, int32))	\
 ICALL_SIG (4, (ptr, object, int32, int32))	\
+ICALL_SIG (4, (ptr, object, ptr, int32))	\
 ICALL_SIG (4, (ptr, object, ptr, ptr))		\
 ICALL_SIG (4, (ptr, ptr, int, ptr))		\
 ICALL_SIG (4, (ptr, ptr, int32, ptrref))	\
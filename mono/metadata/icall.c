@@ -3588,6 +3588,34 @@ ves_icall_RuntimeMethodInfo_GetGenericArguments (MonoReflectionMethodHandle ref_
 	return res;
 }
 
+/*
+ * reflection_invoke_stub:
+ *
+ *   Return the wrapper which calls M with the arguments of a reflection
+ * invoke, or NULL if M has to go through mono_runtime_invoke_array ().
+ * The wrappers are cached, so after the first call of a method this is a
+ * hash lookup, and all of them share the same runtime invoke wrapper.
+ */
+static MonoMethod*
+reflection_invoke_stub (MonoMethod *m)
+{
+	ERROR_DECL (error);
+	MonoMethod *stub;
+
+	if (!mono_marshal_reflection_invoke_supported (m))
+		return NULL;
+	if (mono_security_core_clr_enabled ())
+		return NULL;
+
+	stub = mono_marshal_get_reflection_invoke (m);
+	/* Fails in full AOT mode, which can't generate wrappers at runtime */
+	if (!mono_compile_method_checked (stub, error)) {
+		mono_error_cleanup (error);
+		return NULL;
+	}
+	return stub;
+}
+
 MonoObject *
 ves_icall_InternalInvoke (MonoReflectionMethod *method, MonoObject *this_arg, MonoArray *params, MonoException **exc) 
 {
@@ -3746,11 +3774,56 @@ ves_icall_InternalInvoke (MonoReflectionMethod *method, MonoObject *this_arg, Mo
 			return (MonoObject*)arr;
 		}
 	}
-	MonoObject *result = mono_runtime_invoke_array_checked (m, obj, params, error);
+
+	MonoObject *result;
+	MonoMethod *stub = reflection_invoke_stub (m);
+	if (stub) {
+		/* The stub unboxes the arguments and takes care of byref ones itself */
+		void *args [2] = { this_arg, params };
+		result = mono_runtime_invoke_checked (stub, NULL, args, error);
+	} else {
+		result = mono_runtime_invoke_array_checked (m, obj, params, error);
+	}
 	mono_error_set_pending_exception (error);
 	return result;
 }
 
+MonoObjectHandle
+ves_icall_RuntimeMethodInfo_CreateInvokeStub (MonoReflectionMethodHandle method, MonoReflectionTypeHandle ref_type, MonoError *error)
+{
+	MonoMethod *m = MONO_HANDLE_GETVAL (method, method);
+	MonoClass *delegate_class = mono_class_from_mono_type_internal (MONO_HANDLE_GETVAL (ref_type, type));
+	MonoMethod *stub;
+
+	mono_class_init_checked (delegate_class, error);
+	return_val_if_nok (error, NULL_HANDLE);
+
+	if (m_class_get_parent (delegate_class) != mono_defaults.multicastdelegate_class) {
+		mono_error_set_argument (error, "delegateType", "Type must derive from Delegate.");
+		return NULL_HANDLE;
+	}
+
+	/* The caller falls back to Invoke () for the methods without a stub */
+	stub = reflection_invoke_stub (m);
+	if (!stub)
+		return NULL_HANDLE;
+
+	MonoMethodSignature *invoke_sig = mono_method_signature_internal (mono_get_delegate_invoke_internal (delegate_class));
+	MonoMethodSignature *stub_sig = mono_method_signature_internal (stub);
+	if (invoke_sig->param_count != 2 || !mono_metadata_type_equal (invoke_sig->ret, stub_sig->ret) ||
+		!mono_metadata_type_equal (invoke_sig->params [0], stub_sig->params [0]) || !mono_metadata_type_equal (invoke_sig->params [1], stub_sig->params [1])) {
+		mono_error_set_argument (error, "delegateType", "The delegate must take an object and an object array and return an object.");
+		return NULL_HANDLE;
+	}
+
+	MonoObjectHandle delegate = mono_object_new_handle (MONO_HANDLE_DOMAIN (ref_type), delegate_class, error);
+	return_val_if_nok (error, NULL_HANDLE);
+
+	mono_delegate_ctor_with_method (delegate, NULL_HANDLE, NULL, stub, error);
+	return_val_if_nok (error, NULL_HANDLE);
+	return delegate;
+}
+
 #ifndef DISABLE_REMOTING
 static void
 internal_execute_field_getter (MonoDomain *domain, MonoObject *this_arg, MonoArray *params, MonoArray **outArgs, MonoError *error)
@@ -45,12 +45,16 @@
 #include <mono/metadata/verify.h>
 #include <mono/metadata/image-internals.h>
 #include <mono/metadata/loaded-images-internals.h>
+#include <mono/metadata/mempool-internals.h>
 #include <mono/metadata/w32process-internals.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>
 #endif
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
 #include <mono/metadata/w32error.h>
 
 #define INVALID_ADDRESS 0xffffffff
@@ -83,6 +87,8 @@ assign_assembly_parent_for_netmodule (MonoImage *image, MonoImage *assemblyImage
 }
 
 static gboolean debug_assembly_unload = FALSE;
+/* Hint the kernel to read in the metadata of mapped images, see image_prefetch_metadata () */
+static gboolean image_prefetch = FALSE;
 
 #define mono_images_storage_lock() do { if (mutex_inited) mono_os_mutex_lock (&images_storage_mutex); } while (0)
 #define mono_images_storage_unlock() do { if (mutex_inited) mono_os_mutex_unlock (&images_storage_mutex); } while (0)
@@ -261,6 +267,7 @@ mono_images_init (void)
 #endif
 
 	debug_assembly_unload = g_hasenv ("MONO_DEBUG_ASSEMBLY_UNLOAD");
+	image_prefetch = g_hasenv ("MONO_IMAGE_PREFETCH");
 
 	install_pe_loader ();
 
@@ -447,6 +454,42 @@ mono_image_load_cli_header (MonoImage *image, MonoCLIImageInfo *iinfo)
 	return TRUE;
 }
 
+static void
+image_prefetch_range (const char *data, guint32 size)
+{
+#if defined(HAVE_MADVISE) && defined(MADV_WILLNEED)
+	gsize pagesize = mono_pagesize ();
+	gsize start = (gsize)data & ~(pagesize - 1);
+	gsize end = (gsize)data + size;
+
+	if (data && size)
+		madvise ((void*)start, end - start, MADV_WILLNEED);
+#endif
+}
+
+/*
+ * image_prefetch_metadata:
+ *
+ *   Ask the kernel to start reading the metadata root, the tables and the string and
+ * blob heaps of a mapped image, which the loader is about to touch all over. This
+ * turns the scattered page faults of the first accesses into readahead, which helps
+ * when the assemblies live on slow storage. Enabled by the MONO_IMAGE_PREFETCH
+ * environment variable.
+ */
+static void
+image_prefetch_metadata (MonoImage *image, guint32 root_size)
+{
+	MonoImageStorage *storage = image->storage;
+
+	if (!image_prefetch || !storage || !storage->raw_data_handle || storage->fileio_used)
+		return;
+
+	image_prefetch_range (image->raw_metadata, root_size);
+	image_prefetch_range (image->heap_tables.data, image->heap_tables.size);
+	image_prefetch_range (image->heap_strings.data, image->heap_strings.size);
+	image_prefetch_range (image->heap_blob.data, image->heap_blob.size);
+}
+
 static gboolean
 load_metadata_ptrs (MonoImage *image, MonoCLIImageInfo *iinfo)
 {
@@ -534,6 +577,8 @@ load_metadata_ptrs (MonoImage *image, MonoCLIImageInfo *iinfo)
 			ptr += 4 - (pad % 4);
 	}
 
+	image_prefetch_metadata (image, ptr - image->raw_metadata);
+
 	i = ((MonoImageLoader*)image->loader)->load_tables (image);
 
 	if (!image->metadata_only) {
@@ -807,7 +852,7 @@ mono_image_init (MonoImage *image)
 	mono_os_mutex_init_recursive (&image->lock);
 	mono_os_mutex_init_recursive (&image->szarray_cache_lock);
 
-	image->mempool = mono_mempool_new_size (INITIAL_IMAGE_SIZE);
+	image->mempool = mono_mempool_new_size_arena (INITIAL_IMAGE_SIZE, MONO_JEMALLOC_ARENA_METADATA);
 	mono_internal_hash_table_init (&image->class_cache,
 				       g_direct_hash,
 				       class_key_extract,
@@ -2284,31 +2329,39 @@ free_hash (GHashTable *hash)
 		g_hash_table_destroy (hash);
 }
 
+static inline void
+free_conc_hash (MonoConcurrentHashTable *hash)
+{
+	if (hash)
+		mono_conc_hashtable_destroy (hash);
+}
+
 void
 mono_wrapper_caches_free (MonoWrapperCaches *cache)
 {
-	free_hash (cache->delegate_invoke_cache);
-	free_hash (cache->delegate_begin_invoke_cache);
-	free_hash (cache->delegate_end_invoke_cache);
-	free_hash (cache->runtime_invoke_signature_cache);
+	free_conc_hash (cache->delegate_invoke_cache);
+	free_conc_hash (cache->delegate_begin_invoke_cache);
+	free_conc_hash (cache->delegate_end_invoke_cache);
+	free_conc_hash (cache->runtime_invoke_signature_cache);
 	
-	free_hash (cache->delegate_abstract_invoke_cache);
+	free_conc_hash (cache->delegate_abstract_invoke_cache);
 
-	free_hash (cache->runtime_invoke_method_cache);
-	free_hash (cache->managed_wrapper_cache);
+	free_conc_hash (cache->runtime_invoke_method_cache);
+	free_conc_hash (cache->managed_wrapper_cache);
 
-	free_hash (cache->native_wrapper_cache);
-	free_hash (cache->native_wrapper_aot_cache);
-	free_hash (cache->native_wrapper_check_cache);
-	free_hash (cache->native_wrapper_aot_check_cache);
+	free_conc_hash (cache->native_wrapper_cache);
+	free_conc_hash (cache->native_wrapper_aot_cache);
+	free_conc_hash (cache->native_wrapper_check_cache);
+	free_conc_hash (cache->native_wrapper_aot_check_cache);
 
-	free_hash (cache->native_func_wrapper_aot_cache);
+	free_conc_hash (cache->native_func_wrapper_aot_cache);
 	free_hash (cache->remoting_invoke_cache);
-	free_hash (cache->synchronized_cache);
-	free_hash (cache->unbox_wrapper_cache);
-	free_hash (cache->cominterop_invoke_cache);
-	free_hash (cache->cominterop_wrapper_cache);
-	free_hash (cache->thunk_invoke_cache);
+	free_conc_hash (cache->synchronized_cache);
+	free_conc_hash (cache->unbox_wrapper_cache);
+	free_conc_hash (cache->cominterop_invoke_cache);
+	free_conc_hash (cache->cominterop_wrapper_cache);
+	free_conc_hash (cache->thunk_invoke_cache);
+	free_conc_hash (cache->reflection_invoke_cache);
 }
 
 static void
@@ -2431,15 +2484,18 @@ mono_image_close_except_pools (MonoImage *image)
 		g_hash_table_foreach (image->name_cache, free_hash_table, NULL);
 		g_hash_table_destroy (image->name_cache);
 	}
+	if (image->class_from_name_cache)
+		mono_conc_hashtable_destroy (image->class_from_name_cache);
+	g_free (image->custom_attr_index);
 
-	free_hash (image->delegate_bound_static_invoke_cache);
-	free_hash (image->ldfld_wrapper_cache);
-	free_hash (image->ldflda_wrapper_cache);
-	free_hash (image->stfld_wrapper_cache);
+	free_conc_hash (image->delegate_bound_static_invoke_cache);
+	free_conc_hash (image->ldfld_wrapper_cache);
+	free_conc_hash (image->ldflda_wrapper_cache);
+	free_conc_hash (image->stfld_wrapper_cache);
 	free_hash (image->isinst_cache);
 	free_hash (image->castclass_cache);
-	free_hash (image->icall_wrapper_cache);
-	free_hash (image->proxy_isinst_cache);
+	free_conc_hash (image->icall_wrapper_cache);
+	free_conc_hash (image->proxy_isinst_cache);
 	if (image->var_gparam_cache)
 		mono_conc_hashtable_destroy (image->var_gparam_cache);
 	if (image->mvar_gparam_cache)
@@ -2447,7 +2503,7 @@ mono_image_close_except_pools (MonoImage *image)
 	free_hash (image->wrapper_param_names);
 	free_hash (image->pinvoke_scopes);
 	free_hash (image->pinvoke_scope_filenames);
-	free_hash (image->native_func_wrapper_cache);
+	free_conc_hash (image->native_func_wrapper_cache);
 	mono_conc_hashtable_destroy (image->typespec_cache);
 	free_hash (image->weak_field_indexes);
 
@@ -3073,9 +3129,12 @@ mono_image_alloc (MonoImage *image, guint size)
 #ifndef DISABLE_PERFCOUNTERS
 	mono_atomic_fetch_add_i32 (&mono_perfcounters->loader_bytes, size);
 #endif
-	mono_image_lock (image);
-	res = mono_mempool_alloc (image->mempool, size);
-	mono_image_unlock (image);
+	res = mono_mempool_alloc_thread_cached (image->mempool, size);
+	if (G_UNLIKELY (!res)) {
+		mono_image_lock (image);
+		res = mono_mempool_alloc_thread_refill (image->mempool, size);
+		mono_image_unlock (image);
+	}
 
 	return res;
 }
@@ -3088,9 +3147,13 @@ mono_image_alloc0 (MonoImage *image, guint size)
 #ifndef DISABLE_PERFCOUNTERS
 	mono_atomic_fetch_add_i32 (&mono_perfcounters->loader_bytes, size);
 #endif
-	mono_image_lock (image);
-	res = mono_mempool_alloc0 (image->mempool, size);
-	mono_image_unlock (image);
+	res = mono_mempool_alloc_thread_cached (image->mempool, size);
+	if (G_UNLIKELY (!res)) {
+		mono_image_lock (image);
+		res = mono_mempool_alloc_thread_refill (image->mempool, size);
+		mono_image_unlock (image);
+	}
+	memset (res, 0, size);
 
 	return res;
 }
@@ -3099,13 +3162,14 @@ char*
 mono_image_strdup (MonoImage *image, const char *s)
 {
 	char *res;
+	size_t len;
 
-#ifndef DISABLE_PERFCOUNTERS
-	mono_atomic_fetch_add_i32 (&mono_perfcounters->loader_bytes, (gint32)strlen (s));
-#endif
-	mono_image_lock (image);
-	res = mono_mempool_strdup (image->mempool, s);
-	mono_image_unlock (image);
+	if (s == NULL)
+		return NULL;
+
+	len = strlen (s) + 1;
+	res = (char *)mono_image_alloc (image, (guint)len);
+	memcpy (res, s, len);
 
 	return res;
 }
@@ -53,6 +53,7 @@ MONO_JIT_ICALL (mono_tls_get_jit_tls) \
 MONO_JIT_ICALL (mono_tls_get_lmf_addr) \
 MONO_JIT_ICALL (mono_tls_get_sgen_thread_info) \
 MONO_JIT_ICALL (mono_tls_get_thread) \
+MONO_JIT_ICALL (mono_tls_get_thread_static_data) \
 	\
 MONO_JIT_ICALL (__emul_fadd)	\
 MONO_JIT_ICALL (__emul_fcmp_ceq)	\
@@ -139,6 +140,8 @@ MONO_JIT_ICALL (mini_llvmonly_resolve_generic_virtual_iface_call) \
 MONO_JIT_ICALL (mini_llvmonly_resolve_iface_call_gsharedvt) \
 MONO_JIT_ICALL (mini_llvmonly_resolve_vcall_gsharedvt) \
 MONO_JIT_ICALL (mini_llvmonly_throw_nullref_exception) \
+MONO_JIT_ICALL (mini_tier_record_receiver) \
+MONO_JIT_ICALL (mini_tier_up) \
 MONO_JIT_ICALL (mono_amd64_resume_unwind)	\
 MONO_JIT_ICALL (mono_amd64_start_gsharedvt_call)	\
 MONO_JIT_ICALL (mono_amd64_throw_corlib_exception)	\
@@ -288,6 +291,7 @@ MONO_JIT_ICALL (mono_string_to_byvalstr) \
 MONO_JIT_ICALL (mono_string_to_byvalwstr) \
 MONO_JIT_ICALL (mono_string_to_utf16_internal) \
 MONO_JIT_ICALL (mono_string_to_utf8str) \
+MONO_JIT_ICALL (mono_string_to_utf8str_buf) \
 MONO_JIT_ICALL (mono_string_utf16_to_builder) \
 MONO_JIT_ICALL (mono_string_utf16_to_builder2) \
 MONO_JIT_ICALL (mono_string_utf8_to_builder) \
@@ -322,6 +326,7 @@ MONO_JIT_ICALL (sdb_single_step_trampoline)	\
 MONO_JIT_ICALL (type_from_handle) \
 MONO_JIT_ICALL (ves_icall_array_new) \
 MONO_JIT_ICALL (ves_icall_array_new_specific) \
+MONO_JIT_ICALL (ves_icall_array_new_uninitialized_specific) \
 MONO_JIT_ICALL (ves_icall_marshal_alloc) \
 MONO_JIT_ICALL (ves_icall_mono_delegate_ctor) \
 MONO_JIT_ICALL (ves_icall_mono_delegate_ctor_interp) \
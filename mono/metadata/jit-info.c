@@ -261,6 +261,59 @@ jit_info_table_find (MonoJitInfoTable *table, MonoThreadHazardPointers *hp, gint
 	return NULL;
 }
 
+/*
+ * Stack walks and exception handling look up the same return addresses over
+ * and over, so the result of a table search is remembered in a small direct
+ * mapped cache in the domain.  Entries validate themselves against the
+ * address, so collisions only cost a search.  Removal bumps
+ * jit_info_lookup_cache_gen and clears the entries pointing to the removed
+ * ji; a lookup which raced with it drops the entry it has just stored.
+ */
+static inline int
+jit_info_lookup_cache_slot (gpointer addr)
+{
+	return ((gsize)addr >> 3) & (MONO_JIT_INFO_LOOKUP_CACHE_SIZE - 1);
+}
+
+static MonoJitInfo*
+jit_info_lookup_cache_find (MonoDomain *domain, MonoThreadHazardPointers *hp, gint8 *addr)
+{
+	MonoJitInfo *ji;
+
+	ji = (MonoJitInfo *)mono_get_hazardous_pointer ((gpointer volatile*)&domain->jit_info_lookup_cache [jit_info_lookup_cache_slot (addr)], hp, JIT_INFO_HAZARD_INDEX);
+	if (ji && !(addr >= (gint8*)ji->code_start && addr < (gint8*)ji->code_start + ji->code_size))
+		ji = NULL;
+	if (hp)
+		mono_hazard_pointer_clear (hp, JIT_INFO_HAZARD_INDEX);
+	return ji;
+}
+
+static void
+jit_info_lookup_cache_add (MonoDomain *domain, gint32 gen, gint8 *addr, MonoJitInfo *ji)
+{
+	MonoJitInfo * volatile *entry = &domain->jit_info_lookup_cache [jit_info_lookup_cache_slot (addr)];
+
+	*entry = ji;
+	mono_memory_barrier ();
+	if (domain->jit_info_lookup_cache_gen != gen)
+		mono_atomic_cas_ptr ((gpointer volatile*)entry, NULL, ji);
+}
+
+/*
+ * LOCKING: domain lock
+ */
+static void
+jit_info_lookup_cache_remove (MonoDomain *domain, MonoJitInfo *ji)
+{
+	int i;
+
+	mono_atomic_inc_i32 (&domain->jit_info_lookup_cache_gen);
+	for (i = 0; i < MONO_JIT_INFO_LOOKUP_CACHE_SIZE; ++i) {
+		if (domain->jit_info_lookup_cache [i] == ji)
+			mono_atomic_cas_ptr ((gpointer volatile*)&domain->jit_info_lookup_cache [i], NULL, ji);
+	}
+}
+
 /*
  * mono_jit_info_table_find_internal:
  *
@@ -277,9 +330,19 @@ mono_jit_info_table_find_internal (MonoDomain *domain, gpointer addr, gboolean t
 	MonoJitInfoTable *table;
 	MonoJitInfo *ji, *module_ji;
 	MonoThreadHazardPointers *hp = mono_hazard_pointer_get ();
+	gint32 cache_gen;
 
 	UnlockedIncrement (&mono_stats.jit_info_table_lookup_count);
 
+	ji = jit_info_lookup_cache_find (domain, hp, (gint8*)addr);
+	if (ji) {
+		if (ji->is_trampoline && !allow_trampolines)
+			return NULL;
+		return ji;
+	}
+	cache_gen = domain->jit_info_lookup_cache_gen;
+	mono_memory_barrier ();
+
 	/* First we have to get the domain's jit_info_table.  This is
 	   complicated by the fact that a writer might substitute a
 	   new table and free the old one.  What the writer guarantees
@@ -291,6 +354,8 @@ mono_jit_info_table_find_internal (MonoDomain *domain, gpointer addr, gboolean t
 	table = (MonoJitInfoTable *)mono_get_hazardous_pointer ((gpointer volatile*)&domain->jit_info_table, hp, JIT_INFO_TABLE_HAZARD_INDEX);
 
 	ji = jit_info_table_find (table, hp, (gint8*)addr);
+	if (ji)
+		jit_info_lookup_cache_add (domain, cache_gen, (gint8*)addr, ji);
 	if (hp)
 		mono_hazard_pointer_clear (hp, JIT_INFO_TABLE_HAZARD_INDEX);
 	if (ji && ji->is_trampoline && !allow_trampolines)
@@ -763,6 +828,7 @@ mono_jit_info_table_remove (MonoDomain *domain, MonoJitInfo *ji)
 	UnlockedIncrement (&mono_stats.jit_info_table_remove_count);
 
 	jit_info_table_remove (table, ji);
+	jit_info_lookup_cache_remove (domain, ji);
 
 	mono_jit_info_free_or_queue (domain, ji);
 
@@ -9,15 +9,54 @@
 #include <mono/metadata/object-forward.h>
 #include <mono/utils/mono-forward.h>
 #include <mono/utils/mono-error.h>
+#include <mono/utils/mono-codeman.h>
+#include <mono/utils/mono-coop-mutex.h>
 
 typedef struct _MonoLoadedImages MonoLoadedImages;
 typedef struct _MonoAssemblyLoadContext MonoAssemblyLoadContext;
 
 #ifdef ENABLE_NETCORE
+/*
+ * Unloading of a collectible context.  The state only moves forward, the
+ * checks run with the world stopped and the rest on the finalizer thread.
+ */
+typedef enum {
+	MONO_ALC_STATE_ALIVE,
+	/* PrepareForAssemblyLoadContextRelease () was called */
+	MONO_ALC_STATE_UNLOADING,
+	/* A major collection found no objects, delegates or frames of the context */
+	MONO_ALC_STATE_UNUSED,
+	/* The runtime doesn't refer to the code anymore, but it might still be running */
+	MONO_ALC_STATE_DETACHED,
+	/* A major collection found no frames or delegates running the code */
+	MONO_ALC_STATE_CODE_UNUSED,
+	/* The slots filled with the old code while it was being detached are reset */
+	MONO_ALC_STATE_REDETACHED,
+	/* A second major collection found nothing running the code after the reset */
+	MONO_ALC_STATE_CODE_UNREACHABLE,
+	/* The code is freed */
+	MONO_ALC_STATE_RELEASED
+} MonoAlcState;
+
 /* FIXME: this probably belongs somewhere else */
 struct _MonoAssemblyLoadContext {
 	MonoDomain *domain;
 	MonoLoadedImages *loaded_images;
+	/* The managed AssemblyLoadContext, weak if the context is collectible */
+	uint32_t gchandle;
+	gboolean collectible;
+	/* Keeps the managed object alive until the context is released */
+	uint32_t strong_gchandle;
+	/* A MonoAlcState */
+	gint32 state;
+	/* The native code of the methods of a collectible context, freed with it */
+	MonoCodeManager *code_mp;
+	/* The methods whose code is in code_mp */
+	GPtrArray *collectible_methods;
+	/* Protects code_mp and collectible_methods */
+	MonoCoopMutex code_lock;
+	/* Number of methods being compiled into code_mp */
+	gint32 pending_compiles;
 #if 0
 	GSList *loaded_assemblies;
 	MonoCoopMutex assemblies_lock;
@@ -33,7 +72,7 @@ void
 mono_set_pinvoke_search_directories (int dir_count, char **dirs);
 
 void
-mono_alc_init (MonoAssemblyLoadContext *alc, MonoDomain *domain);
+mono_alc_init (MonoAssemblyLoadContext *alc, MonoDomain *domain, gboolean collectible);
 
 void
 mono_alc_cleanup (MonoAssemblyLoadContext *alc);
@@ -43,8 +82,42 @@ mono_alc_domain (MonoAssemblyLoadContext *alc)
 {
 	return alc->domain;
 }
+
+/* Whether the class comes from ALC, or has element types or generic arguments from it.  A NULL ALC matches any collectible context */
+gboolean
+mono_alc_owns_class (MonoAssemblyLoadContext *alc, MonoClass *klass);
+
+gboolean
+mono_alc_owns_method (MonoAssemblyLoadContext *alc, MonoMethod *method);
+
+gboolean
+mono_alc_owns_generic_inst (MonoAssemblyLoadContext *alc, MonoGenericInst *inst);
+
+void
+mono_alc_check_unused (void);
+
+void
+mono_alc_release_unused (void);
 #endif /* ENABLE_NETCORE */
 
+MonoAssemblyLoadContext *
+mono_method_get_collectible_alc (MonoMethod *method);
+
+MonoAssemblyLoadContext *
+mono_alc_begin_collectible_compile (MonoMethod *method);
+
+void
+mono_alc_end_collectible_compile (MonoAssemblyLoadContext *alc);
+
+void*
+mono_alc_code_reserve (MonoAssemblyLoadContext *alc, int size);
+
+void
+mono_alc_code_commit (MonoAssemblyLoadContext *alc, void *data, int size, int newsize);
+
+void
+mono_alc_add_collectible_method (MonoAssemblyLoadContext *alc, MonoMethod *method);
+
 MonoLoadedImages *
 mono_alc_get_loaded_images (MonoAssemblyLoadContext *alc);
 
@@ -23,6 +23,8 @@
 
 #include <mono/utils/mono-compiler.h>
 #include <mono/utils/mono-threads.h>
+#include <mono/utils/mono-time.h>
+#include <mono/metadata/profiler-private.h>
 
 #include "lock-tracer.h"
 
@@ -144,7 +146,60 @@ mono_locks_lock_released (RuntimeLocks kind, gpointer lock)
 {
 	add_record (RECORD_LOCK_RELEASED, kind, lock);
 }
-#else
-
-MONO_EMPTY_SOURCE_FILE (lock_tracer);
 #endif /* LOCK_TRACER */
+
+const char*
+mono_locks_get_name (RuntimeLocks kind)
+{
+	switch (kind) {
+	case LoaderLock: return "loader";
+	case ImageDataLock: return "image data";
+	case DomainLock: return "domain";
+	case DomainAssembliesLock: return "domain assemblies";
+	case DomainJitCodeHashLock: return "domain jit code hash";
+	case IcallLock: return "icall";
+	case AssemblyBindingLock: return "assembly binding";
+	case MarshalLock: return "marshal";
+	case ClassesLock: return "classes";
+	case LoaderGlobalDataLock: return "loader global data";
+	case ThreadsLock: return "threads";
+	default: return "invalid";
+	}
+}
+
+/*
+ * Called by mono_locks_os_acquire () and mono_locks_coop_acquire () when the
+ * initial trylock failed. The wait is only timed if a profiler is listening;
+ * the event is raised with the lock held, once it has been acquired.
+ */
+void
+mono_locks_os_acquire_contended (mono_mutex_t *lock, RuntimeLocks kind)
+{
+	gint64 start;
+
+	if (!MONO_PROFILER_ENABLED (runtime_lock_contention)) {
+		mono_os_mutex_lock (lock);
+		return;
+	}
+
+	start = mono_100ns_ticks ();
+	mono_os_mutex_lock (lock);
+
+	MONO_PROFILER_RAISE (runtime_lock_contention, (mono_locks_get_name (kind), lock, (mono_100ns_ticks () - start) * 100));
+}
+
+void
+mono_locks_coop_acquire_contended (MonoCoopMutex *lock, RuntimeLocks kind)
+{
+	gint64 start;
+
+	if (!MONO_PROFILER_ENABLED (runtime_lock_contention)) {
+		mono_coop_mutex_lock (lock);
+		return;
+	}
+
+	start = mono_100ns_ticks ();
+	mono_coop_mutex_lock (lock);
+
+	MONO_PROFILER_RAISE (runtime_lock_contention, (mono_locks_get_name (kind), lock, (mono_100ns_ticks () - start) * 100));
+}
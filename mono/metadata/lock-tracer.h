@@ -42,9 +42,19 @@ void mono_locks_lock_released (RuntimeLocks kind, gpointer lock);
 
 #endif
 
+const char *mono_locks_get_name (RuntimeLocks kind);
+
+void mono_locks_os_acquire_contended (mono_mutex_t *lock, RuntimeLocks kind);
+void mono_locks_coop_acquire_contended (MonoCoopMutex *lock, RuntimeLocks kind);
+
+/*
+ * The uncontended case is a single trylock; only the slow path is timed so
+ * that profilers can report contention on runtime locks.
+ */
 #define mono_locks_os_acquire(LOCK,NAME)	\
 	do {	\
-		mono_os_mutex_lock (LOCK);	\
+		if (G_UNLIKELY (mono_os_mutex_trylock (LOCK) != 0))	\
+			mono_locks_os_acquire_contended ((LOCK), (NAME));	\
 		mono_locks_lock_acquired (NAME, LOCK);	\
 	} while (0)
 
@@ -56,7 +66,8 @@ void mono_locks_lock_released (RuntimeLocks kind, gpointer lock);
 
 #define mono_locks_coop_acquire(LOCK,NAME)	\
 	do {	\
-		mono_coop_mutex_lock (LOCK);	\
+		if (G_UNLIKELY (mono_coop_mutex_trylock (LOCK) != 0))	\
+			mono_locks_coop_acquire_contended ((LOCK), (NAME));	\
 		mono_locks_lock_acquired (NAME, LOCK);	\
 	} while (0)
 
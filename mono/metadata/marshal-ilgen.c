@@ -59,6 +59,9 @@ enum {
 };
 #undef OPDEF
 
+/* Size of the stack buffer native wrappers convert short string arguments into */
+#define STRING_STACK_BUF_SIZE 256
+
 static GENERATE_GET_CLASS_WITH_CACHE (fixed_buffer_attribute, "System.Runtime.CompilerServices", "FixedBufferAttribute");
 static GENERATE_GET_CLASS_WITH_CACHE (date_time, "System", "DateTime");
 static GENERATE_TRY_GET_CLASS_WITH_CACHE (icustom_marshaler, "System.Runtime.InteropServices", "ICustomMarshaler");
@@ -1840,11 +1843,12 @@ gc_safe_transition_builder_cleanup (GCSafeTransitionBuilder *builder)
  * \param method if non-NULL, the pinvoke method to call
  * \param check_exceptions Whenever to check for pending exceptions after the native call
  * \param func_param the function to call is passed as a boxed IntPtr as the first parameter
+ * \param skip_gc_trans don't switch to GC Safe mode around the native call, for SuppressGCTransitionAttribute
  *
  * generates IL code for the pinvoke wrapper, the generated code calls \p func .
  */
 static void
-emit_native_wrapper_ilgen (MonoImage *image, MonoMethodBuilder *mb, MonoMethodSignature *sig, MonoMethodPInvoke *piinfo, MonoMarshalSpec **mspecs, gpointer func, gboolean aot, gboolean check_exceptions, gboolean func_param)
+emit_native_wrapper_ilgen (MonoImage *image, MonoMethodBuilder *mb, MonoMethodSignature *sig, MonoMethodPInvoke *piinfo, MonoMarshalSpec **mspecs, gpointer func, gboolean aot, gboolean check_exceptions, gboolean func_param, gboolean skip_gc_trans)
 {
 	EmitMarshalContext m;
 	MonoMethodSignature *csig;
@@ -1860,6 +1864,9 @@ emit_native_wrapper_ilgen (MonoImage *image, MonoMethodBuilder *mb, MonoMethodSi
 	m.piinfo = piinfo;
 
 	need_gc_safe = gc_safe_transition_builder_init (&gc_safe_transition_builder, mb, func_param);
+	/* COM calls load the function pointer in the transition code */
+	if (skip_gc_trans && (func_param || !MONO_CLASS_IS_IMPORT (mb->method->klass)))
+		need_gc_safe = FALSE;
 
 	/* we copy the signature, so that we can set pinvoke to 0 */
 	if (func_param) {
@@ -4150,6 +4157,113 @@ emit_unbox_wrapper_ilgen (MonoMethodBuilder *mb, MonoMethod *method)
 	mono_mb_emit_byte (mb, CEE_RET);
 }
 
+static void
+emit_reflection_invoke_ilgen (MonoMethodBuilder *mb, MonoMethod *method)
+{
+	MonoMethodSignature *sig = mono_method_signature_internal (method);
+	MonoClass *klass = method->klass;
+	int *byref_locals = NULL;
+	int i, pos;
+
+	if (sig->hasthis) {
+		mono_mb_emit_ldarg (mb, 0);
+		pos = mono_mb_emit_branch (mb, CEE_BRTRUE);
+		mono_mb_emit_exception_full (mb, "System.Reflection", "TargetException", "Non-static method requires a target.");
+		mono_mb_patch_branch (mb, pos);
+	}
+
+	/* The args array can be null for methods without parameters */
+	if (sig->param_count) {
+		mono_mb_emit_ldarg (mb, 1);
+		pos = mono_mb_emit_branch (mb, CEE_BRFALSE);
+		mono_mb_emit_ldarg (mb, 1);
+		mono_mb_emit_byte (mb, CEE_LDLEN);
+		mono_mb_emit_byte (mb, CEE_CONV_I4);
+		mono_mb_emit_icon (mb, sig->param_count);
+		int pos_ok = mono_mb_emit_branch (mb, CEE_BEQ);
+		mono_mb_patch_branch (mb, pos);
+		mono_mb_emit_exception_full (mb, "System.Reflection", "TargetParameterCountException", NULL);
+		mono_mb_patch_branch (mb, pos_ok);
+
+		byref_locals = g_newa (int, sig->param_count);
+	}
+
+	if (sig->hasthis) {
+		mono_mb_emit_ldarg (mb, 0);
+		if (m_class_is_valuetype (klass))
+			mono_mb_emit_op (mb, CEE_UNBOX, klass);
+		else
+			mono_mb_emit_op (mb, CEE_CASTCLASS, klass);
+	}
+
+	for (i = 0; i < sig->param_count; ++i) {
+		MonoType *t = sig->params [i];
+		MonoClass *param_class = mono_class_from_mono_type_internal (t);
+		MonoType *byval_type = m_class_get_byval_arg (param_class);
+		int local = -1;
+
+		if (t->byref) {
+			local = mono_mb_add_local (mb, byval_type);
+			byref_locals [i] = local;
+		} else if (m_class_is_valuetype (param_class) && !mono_class_is_nullable (param_class)) {
+			/* Null value type arguments default to zero, like in mono_runtime_invoke_array () */
+			local = mono_mb_add_local (mb, byval_type);
+		}
+
+		mono_mb_emit_ldarg (mb, 1);
+		mono_mb_emit_icon (mb, i);
+		mono_mb_emit_byte (mb, CEE_LDELEM_REF);
+
+		if (m_class_is_valuetype (param_class) && !mono_class_is_nullable (param_class)) {
+			/* Locals are zero initialized, a null leaves the default value */
+			pos = mono_mb_emit_branch (mb, CEE_BRFALSE);
+			mono_mb_emit_ldarg (mb, 1);
+			mono_mb_emit_icon (mb, i);
+			mono_mb_emit_byte (mb, CEE_LDELEM_REF);
+			mono_mb_emit_op (mb, CEE_UNBOX_ANY, param_class);
+			mono_mb_emit_stloc (mb, local);
+			mono_mb_patch_branch (mb, pos);
+			if (t->byref)
+				mono_mb_emit_ldloc_addr (mb, local);
+			else
+				mono_mb_emit_ldloc (mb, local);
+		} else {
+			mono_mb_emit_op (mb, m_class_is_valuetype (param_class) ? CEE_UNBOX_ANY : CEE_CASTCLASS, param_class);
+			if (t->byref) {
+				mono_mb_emit_stloc (mb, local);
+				mono_mb_emit_ldloc_addr (mb, local);
+			}
+		}
+	}
+
+	if ((method->flags & METHOD_ATTRIBUTE_VIRTUAL) && !(method->flags & METHOD_ATTRIBUTE_FINAL) && !m_class_is_valuetype (klass))
+		mono_mb_emit_op (mb, CEE_CALLVIRT, method);
+	else
+		mono_mb_emit_op (mb, CEE_CALL, method);
+
+	if (MONO_TYPE_IS_VOID (sig->ret))
+		mono_mb_emit_byte (mb, CEE_LDNULL);
+	else if (m_class_is_valuetype (mono_class_from_mono_type_internal (sig->ret)))
+		mono_mb_emit_op (mb, CEE_BOX, mono_class_from_mono_type_internal (sig->ret));
+
+	/* Copy byref arguments back, the callee might have changed them */
+	for (i = 0; i < sig->param_count; ++i) {
+		MonoClass *param_class;
+
+		if (!sig->params [i]->byref)
+			continue;
+		param_class = mono_class_from_mono_type_internal (sig->params [i]);
+		mono_mb_emit_ldarg (mb, 1);
+		mono_mb_emit_icon (mb, i);
+		mono_mb_emit_ldloc (mb, byref_locals [i]);
+		if (m_class_is_valuetype (param_class))
+			mono_mb_emit_op (mb, CEE_BOX, param_class);
+		mono_mb_emit_byte (mb, CEE_STELEM_REF);
+	}
+
+	mono_mb_emit_byte (mb, CEE_RET);
+}
+
 static void
 emit_array_accessor_wrapper_ilgen (MonoMethodBuilder *mb, MonoMethod *method, MonoMethodSignature *sig, MonoGenericContext *ctx)
 {
@@ -4934,6 +5048,8 @@ emit_marshal_string_ilgen (EmitMarshalContext *m, int argnum, MonoType *t,
 		*conv_arg_type = int_type;
 		conv_arg = mono_mb_add_local (mb, int_type);
 
+		m->orig_conv_args [argnum] = 0;
+
 		if (t->byref) {
 			if (t->attrs & PARAM_ATTRIBUTE_OUT)
 				break;
@@ -4947,6 +5063,18 @@ emit_marshal_string_ilgen (EmitMarshalContext *m, int argnum, MonoType *t,
 		if (conv == MONO_MARSHAL_CONV_INVALID) {
 			char *msg = g_strdup_printf ("string marshalling conversion %d not implemented", encoding);
 			mono_mb_emit_exception_marshal_directive (mb, msg);
+		} else if (!t->byref && conv_to_icall (conv, NULL) == MONO_JIT_ICALL_mono_string_to_utf8str) {
+			/* Short strings are converted into a buffer on the stack, see CONV_OUT for the free */
+			m->orig_conv_args [argnum] = mono_mb_add_local (mb, int_type);
+			mono_mb_emit_icon (mb, STRING_STACK_BUF_SIZE);
+			mono_mb_emit_byte (mb, CEE_PREFIX1);
+			mono_mb_emit_byte (mb, CEE_LOCALLOC);
+			mono_mb_emit_stloc (mb, m->orig_conv_args [argnum]);
+
+			mono_mb_emit_ldloc (mb, m->orig_conv_args [argnum]);
+			mono_mb_emit_icon (mb, STRING_STACK_BUF_SIZE);
+			mono_mb_emit_icall (mb, mono_string_to_utf8str_buf);
+			mono_mb_emit_stloc (mb, conv_arg);
 		} else {
 			mono_mb_emit_icall_id (mb, conv_to_icall (conv, NULL));
 
@@ -4996,11 +5124,23 @@ emit_marshal_string_ilgen (EmitMarshalContext *m, int argnum, MonoType *t,
 		}
 
 		if (need_free) {
+			int pos = 0;
+
+			if (m->orig_conv_args [argnum]) {
+				/* The string is in the stack buffer */
+				mono_mb_emit_ldloc (mb, conv_arg);
+				mono_mb_emit_ldloc (mb, m->orig_conv_args [argnum]);
+				pos = mono_mb_emit_branch (mb, CEE_BEQ);
+			}
+
 			mono_mb_emit_ldloc (mb, conv_arg);
 			if (conv == MONO_MARSHAL_CONV_BSTR_STR)
 				mono_mb_emit_icall (mb, mono_free_bstr);
 			else
 				mono_mb_emit_icall (mb, mono_marshal_free);
+
+			if (pos)
+				mono_mb_patch_branch (mb, pos);
 		}
 		break;
 
@@ -6592,6 +6732,7 @@ mono_marshal_ilgen_init (void)
 	cb.emit_array_accessor_wrapper = emit_array_accessor_wrapper_ilgen;
 	cb.emit_generic_array_helper = emit_generic_array_helper_ilgen;
 	cb.emit_thunk_invoke_wrapper = emit_thunk_invoke_wrapper_ilgen;
+	cb.emit_reflection_invoke = emit_reflection_invoke_ilgen;
 	cb.emit_create_string_hack = emit_create_string_hack_ilgen;
 	cb.emit_native_icall_wrapper = emit_native_icall_wrapper_ilgen;
 	cb.emit_icall_wrapper = emit_icall_wrapper_ilgen;
@@ -110,6 +110,7 @@ delegate_hash_table_remove (MonoDelegate *d);
 //used by marshal-ilgen.c
 GENERATE_TRY_GET_CLASS_WITH_CACHE (stringbuilder, "System.Text", "StringBuilder");
 static GENERATE_TRY_GET_CLASS_WITH_CACHE (unmanaged_function_pointer_attribute, "System.Runtime.InteropServices", "UnmanagedFunctionPointerAttribute");
+static GENERATE_TRY_GET_CLASS_WITH_CACHE (suppress_gc_transition_attribute, "System.Runtime.InteropServices", "SuppressGCTransitionAttribute");
 
 static MonoImage*
 get_method_image (MonoMethod *method)
@@ -215,6 +216,7 @@ mono_marshal_init (void)
 		register_icall (mono_string_new_len_wrapper, mono_icall_sig_obj_ptr_int, FALSE);
 		register_icall (ves_icall_mono_string_to_utf8, mono_icall_sig_ptr_obj, FALSE);
 		register_icall (mono_string_to_utf8str, mono_icall_sig_ptr_obj, FALSE);
+		register_icall (mono_string_to_utf8str_buf, mono_icall_sig_ptr_object_ptr_int32, FALSE);
 		register_icall (mono_string_to_ansibstr, mono_icall_sig_ptr_object, FALSE);
 		register_icall (mono_string_builder_to_utf8, mono_icall_sig_ptr_object, FALSE);
 		register_icall (mono_string_builder_to_utf16, mono_icall_sig_ptr_object, FALSE);
@@ -988,6 +990,50 @@ mono_string_to_utf8str_impl (MonoStringHandle s, MonoError *error)
 
 #endif
 
+/*
+ * mono_string_to_utf8str_buf:
+ *
+ *   Same as mono_string_to_utf8str (), but ASCII strings shorter than SIZE are
+ * converted into BUF, a buffer on the stack of the native wrapper, and BUF is
+ * returned. Anything else is allocated as by mono_string_to_utf8str (), and the
+ * wrapper frees it when the result differs from BUF.
+ */
+gpointer
+mono_string_to_utf8str_buf_impl (MonoStringHandle s, char *buf, int size, MonoError *error)
+{
+	int i, len;
+	gboolean ascii = TRUE;
+
+	if (MONO_HANDLE_IS_NULL (s))
+		return NULL;
+
+	len = mono_string_handle_length (s);
+	if (len >= size)
+		return mono_string_to_utf8str_impl (s, error);
+
+	MONO_ENTER_NO_SAFEPOINTS;
+
+	const gunichar2 *chars = mono_string_chars_internal (MONO_HANDLE_RAW (s));
+	for (i = 0; i < len; ++i) {
+		gunichar2 c = chars [i];
+		/* An embedded NUL terminates the string, like in g_utf16_to_utf8 () */
+		if (c == 0)
+			break;
+		if (c >= 0x80) {
+			ascii = FALSE;
+			break;
+		}
+		buf [i] = (char)c;
+	}
+	buf [i] = 0;
+
+	MONO_EXIT_NO_SAFEPOINTS;
+
+	if (!ascii)
+		return mono_string_to_utf8str_impl (s, error);
+	return buf;
+}
+
 gpointer
 mono_string_to_ansibstr_impl (MonoStringHandle string_obj, MonoError *error)
 {
@@ -1429,15 +1475,16 @@ mono_marshal_need_free (MonoType *t, MonoMethodPInvoke *piinfo, MonoMarshalSpec
 
 /*
  * Return the hash table pointed to by VAR, lazily creating it if neccesary.
+ * Lookups in the wrapper caches don't take the marshal lock, inserts and removals do.
  */
-static GHashTable*
-get_cache (GHashTable **var, GHashFunc hash_func, GCompareFunc equal_func)
+static MonoConcurrentHashTable*
+get_cache (MonoConcurrentHashTable **var, GHashFunc hash_func, GCompareFunc equal_func)
 {
 	if (!(*var)) {
 		mono_marshal_lock ();
 		if (!(*var)) {
-			GHashTable *cache = 
-				g_hash_table_new (hash_func, equal_func);
+			MonoConcurrentHashTable *cache = 
+				mono_conc_hashtable_new (hash_func, (GEqualFunc)equal_func);
 			mono_memory_barrier ();
 			*var = cache;
 		}
@@ -1446,21 +1493,16 @@ get_cache (GHashTable **var, GHashFunc hash_func, GCompareFunc equal_func)
 	return *var;
 }
 
-GHashTable*
-mono_marshal_get_cache (GHashTable **var, GHashFunc hash_func, GCompareFunc equal_func)
+MonoConcurrentHashTable*
+mono_marshal_get_cache (MonoConcurrentHashTable **var, GHashFunc hash_func, GCompareFunc equal_func)
 {
 	return get_cache (var, hash_func, equal_func);
 }
 
 MonoMethod*
-mono_marshal_find_in_cache (GHashTable *cache, gpointer key)
+mono_marshal_find_in_cache (MonoConcurrentHashTable *cache, gpointer key)
 {
-	MonoMethod *res;
-
-	mono_marshal_lock ();
-	res = (MonoMethod *)g_hash_table_lookup (cache, key);
-	mono_marshal_unlock ();
-	return res;
+	return (MonoMethod *)mono_conc_hashtable_lookup (cache, key);
 }
 
 /*
@@ -1482,7 +1524,7 @@ mono_mb_create (MonoMethodBuilder *mb, MonoMethodSignature *sig,
 
 /* Create the method from the builder and place it in the cache */
 MonoMethod*
-mono_mb_create_and_cache_full (GHashTable *cache, gpointer key,
+mono_mb_create_and_cache_full (MonoConcurrentHashTable *cache, gpointer key,
 							   MonoMethodBuilder *mb, MonoMethodSignature *sig,
 							   int max_stack, WrapperInfo *info, gboolean *out_found)
 {
@@ -1491,18 +1533,17 @@ mono_mb_create_and_cache_full (GHashTable *cache, gpointer key,
 	if (out_found)
 		*out_found = FALSE;
 
-	mono_marshal_lock ();
-	res = (MonoMethod *)g_hash_table_lookup (cache, key);
-	mono_marshal_unlock ();
+	res = (MonoMethod *)mono_conc_hashtable_lookup (cache, key);
 	if (!res) {
 		MonoMethod *newm;
 		newm = mono_mb_create_method (mb, sig, max_stack);
 		mono_marshal_lock ();
-		res = (MonoMethod *)g_hash_table_lookup (cache, key);
+		res = (MonoMethod *)mono_conc_hashtable_lookup (cache, key);
 		if (!res) {
 			res = newm;
-			g_hash_table_insert (cache, key, res);
+			/* Set the info before publishing the wrapper to the lock-free readers */
 			mono_marshal_set_wrapper_info (res, info);
+			mono_conc_hashtable_insert (cache, key, res);
 			mono_marshal_unlock ();
 		} else {
 			if (out_found)
@@ -1516,7 +1557,7 @@ mono_mb_create_and_cache_full (GHashTable *cache, gpointer key,
 }		
 
 MonoMethod*
-mono_mb_create_and_cache (GHashTable *cache, gpointer key,
+mono_mb_create_and_cache (MonoConcurrentHashTable *cache, gpointer key,
 							   MonoMethodBuilder *mb, MonoMethodSignature *sig,
 							   int max_stack)
 {
@@ -1676,7 +1717,7 @@ get_wrapper_target_class (MonoImage *image)
  * generic method definition.
  */
 static MonoMethod*
-check_generic_wrapper_cache (GHashTable *cache, MonoMethod *orig_method, gpointer key, gpointer def_key)
+check_generic_wrapper_cache (MonoConcurrentHashTable *cache, MonoMethod *orig_method, gpointer key, gpointer def_key)
 {
 	MonoMethod *res;
 	MonoMethod *inst, *def;
@@ -1703,9 +1744,9 @@ check_generic_wrapper_cache (GHashTable *cache, MonoMethod *orig_method, gpointe
 		/* Cache it */
 		mono_memory_barrier ();
 		mono_marshal_lock ();
-		res = (MonoMethod *)g_hash_table_lookup (cache, key);
+		res = (MonoMethod *)mono_conc_hashtable_lookup (cache, key);
 		if (!res) {
-			g_hash_table_insert (cache, key, inst);
+			mono_conc_hashtable_insert (cache, key, inst);
 			res = inst;
 		}
 		mono_marshal_unlock ();
@@ -1715,7 +1756,7 @@ check_generic_wrapper_cache (GHashTable *cache, MonoMethod *orig_method, gpointe
 }
 
 static MonoMethod*
-cache_generic_wrapper (GHashTable *cache, MonoMethod *orig_method, MonoMethod *def, MonoGenericContext *ctx, gpointer key)
+cache_generic_wrapper (MonoConcurrentHashTable *cache, MonoMethod *orig_method, MonoMethod *def, MonoGenericContext *ctx, gpointer key)
 {
 	ERROR_DECL (error);
 	MonoMethod *inst, *res;
@@ -1727,9 +1768,9 @@ cache_generic_wrapper (GHashTable *cache, MonoMethod *orig_method, MonoMethod *d
 	g_assert (mono_error_ok (error)); /* FIXME don't swallow the error */
 	mono_memory_barrier ();
 	mono_marshal_lock ();
-	res = (MonoMethod *)g_hash_table_lookup (cache, key);
+	res = (MonoMethod *)mono_conc_hashtable_lookup (cache, key);
 	if (!res) {
-		g_hash_table_insert (cache, key, inst);
+		mono_conc_hashtable_insert (cache, key, inst);
 		res = inst;
 	}
 	mono_marshal_unlock ();
@@ -1737,7 +1778,7 @@ cache_generic_wrapper (GHashTable *cache, MonoMethod *orig_method, MonoMethod *d
 }
 
 static MonoMethod*
-check_generic_delegate_wrapper_cache (GHashTable *cache, MonoMethod *orig_method, MonoMethod *def_method, MonoGenericContext *ctx)
+check_generic_delegate_wrapper_cache (MonoConcurrentHashTable *cache, MonoMethod *orig_method, MonoMethod *def_method, MonoGenericContext *ctx)
 {
 	ERROR_DECL (error);
 	MonoMethod *res;
@@ -1761,9 +1802,9 @@ check_generic_delegate_wrapper_cache (GHashTable *cache, MonoMethod *orig_method
 		/* Cache it */
 		mono_memory_barrier ();
 		mono_marshal_lock ();
-		res = (MonoMethod *)g_hash_table_lookup (cache, orig_method->klass);
+		res = (MonoMethod *)mono_conc_hashtable_lookup (cache, orig_method->klass);
 		if (!res) {
-			g_hash_table_insert (cache, orig_method->klass, inst);
+			mono_conc_hashtable_insert (cache, orig_method->klass, inst);
 			res = inst;
 		}
 		mono_marshal_unlock ();
@@ -1773,7 +1814,7 @@ check_generic_delegate_wrapper_cache (GHashTable *cache, MonoMethod *orig_method
 }
 
 static MonoMethod*
-cache_generic_delegate_wrapper (GHashTable *cache, MonoMethod *orig_method, MonoMethod *def, MonoGenericContext *ctx)
+cache_generic_delegate_wrapper (MonoConcurrentHashTable *cache, MonoMethod *orig_method, MonoMethod *def, MonoGenericContext *ctx)
 {
 	ERROR_DECL (error);
 	MonoMethod *inst, *res;
@@ -1797,9 +1838,9 @@ cache_generic_delegate_wrapper (GHashTable *cache, MonoMethod *orig_method, Mono
 
 	mono_memory_barrier ();
 	mono_marshal_lock ();
-	res = (MonoMethod *)g_hash_table_lookup (cache, orig_method->klass);
+	res = (MonoMethod *)mono_conc_hashtable_lookup (cache, orig_method->klass);
 	if (!res) {
-		g_hash_table_insert (cache, orig_method->klass, inst);
+		mono_conc_hashtable_insert (cache, orig_method->klass, inst);
 		res = inst;
 	}
 	mono_marshal_unlock ();
@@ -1822,7 +1863,7 @@ mono_marshal_get_delegate_begin_invoke (MonoMethod *method)
 	MonoMethodSignature *sig;
 	MonoMethodBuilder *mb;
 	MonoMethod *res;
-	GHashTable *cache;
+	MonoConcurrentHashTable *cache;
 	char *name;
 	MonoGenericContext *ctx = NULL;
 	MonoMethod *orig_method = NULL;
@@ -2004,7 +2045,7 @@ mono_marshal_get_delegate_end_invoke (MonoMethod *method)
 	MonoMethodSignature *sig;
 	MonoMethodBuilder *mb;
 	MonoMethod *res;
-	GHashTable *cache;
+	MonoConcurrentHashTable *cache;
 	char *name;
 	MonoGenericContext *ctx = NULL;
 	MonoMethod *orig_method = NULL;
@@ -2087,12 +2128,21 @@ signature_pointer_pair_equal (gconstpointer data1, gconstpointer data2)
 	return mono_metadata_signature_equal (pair1->sig, pair2->sig) && (pair1->pointer == pair2->pointer);
 }
 
+typedef struct {
+	gpointer pointer;
+	GSList *stolen;
+} SignaturePointerPairSteal;
+
 static gboolean
-signature_pointer_pair_matches_pointer (gpointer key, gpointer value, gpointer user_data)
+signature_pointer_pair_steal_pointer (gpointer key, gpointer value, gpointer user_data)
 {
 	SignaturePointerPair *pair = (SignaturePointerPair*)key;
+	SignaturePointerPairSteal *steal = (SignaturePointerPairSteal*)user_data;
 
-	return pair->pointer == user_data;
+	if (pair->pointer != steal->pointer)
+		return FALSE;
+	steal->stolen = g_slist_prepend (steal->stolen, pair);
+	return TRUE;
 }
 
 static void
@@ -2134,7 +2184,7 @@ mono_marshal_get_delegate_invoke_internal (MonoMethod *method, gboolean callvirt
 	MonoMethodSignature *sig, *invoke_sig;
 	MonoMethodBuilder *mb;
 	MonoMethod *res;
-	GHashTable *cache;
+	MonoConcurrentHashTable *cache;
 	gpointer cache_key = NULL;
 	SignaturePointerPair key = { NULL, NULL };
 	SignaturePointerPair *new_key;
@@ -2225,19 +2275,24 @@ mono_marshal_get_delegate_invoke_internal (MonoMethod *method, gboolean callvirt
 			return res;
 		cache_key = invoke_sig;
 	} else if (callvirt) {
-		GHashTable **cache_ptr;
+		MonoConcurrentHashTable **cache_ptr;
 
 		cache_ptr = &mono_method_get_wrapper_cache (method)->delegate_abstract_invoke_cache;
 
 		/* We need to cache the signature+method pair */
-		mono_marshal_lock ();
-		if (!*cache_ptr)
-			*cache_ptr = g_hash_table_new_full (signature_pointer_pair_hash, (GEqualFunc)signature_pointer_pair_equal, (GDestroyNotify)free_signature_pointer_pair, NULL);
+		if (!*cache_ptr) {
+			mono_marshal_lock ();
+			if (!*cache_ptr) {
+				MonoConcurrentHashTable *new_cache = mono_conc_hashtable_new_full (signature_pointer_pair_hash, (GEqualFunc)signature_pointer_pair_equal, (GDestroyNotify)free_signature_pointer_pair, NULL);
+				mono_memory_barrier ();
+				*cache_ptr = new_cache;
+			}
+			mono_marshal_unlock ();
+		}
 		cache = *cache_ptr;
 		key.sig = invoke_sig;
 		key.pointer = target_method;
-		res = (MonoMethod *)g_hash_table_lookup (cache, &key);
-		mono_marshal_unlock ();
+		res = mono_marshal_find_in_cache (cache, &key);
 		if (res)
 			return res;
 	} else {
@@ -2532,8 +2587,8 @@ mono_marshal_get_runtime_invoke_full (MonoMethod *method, gboolean virtual_, gbo
 {
 	MonoMethodSignature *sig, *csig, *callsig;
 	MonoMethodBuilder *mb;
-	GHashTable *method_cache = NULL, *sig_cache = NULL;
-	GHashTable **cache_table = NULL;
+	MonoConcurrentHashTable *method_cache = NULL, *sig_cache = NULL;
+	MonoConcurrentHashTable **cache_table = NULL;
 	MonoClass *target_klass;
 	MonoMethod *res = NULL;
 	static MonoMethodSignature *cctor_signature = NULL;
@@ -2607,10 +2662,7 @@ mono_marshal_get_runtime_invoke_full (MonoMethod *method, gboolean virtual_, gbo
 		cache_table = &mono_method_get_wrapper_cache (method)->runtime_invoke_signature_cache;
 		sig_cache = get_cache (cache_table, (GHashFunc) wrapper_cache_signature_key_hash, (GCompareFunc) wrapper_cache_signature_key_equal);
 
-		/* from mono_marshal_find_in_cache */
-		mono_marshal_lock ();
-		res = (MonoMethod *)g_hash_table_lookup (sig_cache, &sig_key);
-		mono_marshal_unlock ();
+		res = mono_marshal_find_in_cache (sig_cache, &sig_key);
 
 		if (res) {
 			g_free (callsig);
@@ -2667,9 +2719,7 @@ mono_marshal_get_runtime_invoke_full (MonoMethod *method, gboolean virtual_, gbo
 		sig_key->valuetype = m_class_is_valuetype (method->klass);
 
 		/* taken from mono_mb_create_and_cache */
-		mono_marshal_lock ();
-		res = (MonoMethod *)g_hash_table_lookup (sig_cache, sig_key);
-		mono_marshal_unlock ();
+		res = mono_marshal_find_in_cache (sig_cache, sig_key);
 
 		info = mono_wrapper_info_create (mb, WRAPPER_SUBTYPE_RUNTIME_INVOKE_NORMAL);
 		info->d.runtime_invoke.sig = callsig;
@@ -2680,11 +2730,11 @@ mono_marshal_get_runtime_invoke_full (MonoMethod *method, gboolean virtual_, gbo
 			newm = mono_mb_create (mb, csig, sig->param_count + 16, info);
 
 			mono_marshal_lock ();
-			res = (MonoMethod *)g_hash_table_lookup (sig_cache, sig_key);
+			res = (MonoMethod *)mono_conc_hashtable_lookup (sig_cache, sig_key);
 			if (!res) {
 				res = newm;
-				g_hash_table_insert (sig_cache, sig_key, res);
-				g_hash_table_insert (method_cache, method_key, res);
+				mono_conc_hashtable_insert (sig_cache, sig_key, res);
+				mono_conc_hashtable_insert (method_cache, method_key, res);
 			} else {
 				mono_free_method (newm);
 				g_free (sig_key);
@@ -2814,8 +2864,8 @@ mono_marshal_get_runtime_invoke_for_sig (MonoMethodSignature *sig)
 	MonoMethodSignature *csig, *callsig;
 	MonoMethodBuilder *mb;
 	MonoImage *image;
-	GHashTable *cache = NULL;
-	GHashTable **cache_table = NULL;
+	MonoConcurrentHashTable *cache = NULL;
+	MonoConcurrentHashTable **cache_table = NULL;
 	MonoMethod *res = NULL;
 	char *name;
 	const char *param_names [16];
@@ -2832,10 +2882,7 @@ mono_marshal_get_runtime_invoke_for_sig (MonoMethodSignature *sig)
 	cache = get_cache (cache_table, (GHashFunc)mono_signature_hash,
 					   (GCompareFunc)runtime_invoke_signature_equal);
 
-	/* from mono_marshal_find_in_cache */
-	mono_marshal_lock ();
-	res = (MonoMethod *)g_hash_table_lookup (cache, callsig);
-	mono_marshal_unlock ();
+	res = mono_marshal_find_in_cache (cache, callsig);
 
 	if (res) {
 		g_free (callsig);
@@ -2871,9 +2918,7 @@ mono_marshal_get_runtime_invoke_for_sig (MonoMethodSignature *sig)
 	get_marshal_cb ()->emit_runtime_invoke_body (mb, param_names, image, NULL, sig, callsig, FALSE, FALSE);
 
 	/* taken from mono_mb_create_and_cache */
-	mono_marshal_lock ();
-	res = (MonoMethod *)g_hash_table_lookup (cache, callsig);
-	mono_marshal_unlock ();
+	res = mono_marshal_find_in_cache (cache, callsig);
 
 	info = mono_wrapper_info_create (mb, WRAPPER_SUBTYPE_RUNTIME_INVOKE_NORMAL);
 	info->d.runtime_invoke.sig = callsig;
@@ -2884,10 +2929,10 @@ mono_marshal_get_runtime_invoke_for_sig (MonoMethodSignature *sig)
 		newm = mono_mb_create (mb, csig, sig->param_count + 16, info);
 
 		mono_marshal_lock ();
-		res = (MonoMethod *)g_hash_table_lookup (cache, callsig);
+		res = (MonoMethod *)mono_conc_hashtable_lookup (cache, callsig);
 		if (!res) {
 			res = newm;
-			g_hash_table_insert (cache, callsig, res);
+			mono_conc_hashtable_insert (cache, callsig, res);
 		} else {
 			mono_free_method (newm);
 		}
@@ -2928,7 +2973,7 @@ mono_marshal_get_icall_wrapper (MonoJitICallInfo *callinfo, gboolean check_excep
 
 	gconstpointer const func = callinfo->func;
 	
-	GHashTable *cache = get_cache (& m_class_get_image (mono_defaults.object_class)->icall_wrapper_cache, mono_aligned_addr_hash, NULL);
+	MonoConcurrentHashTable *cache = get_cache (& m_class_get_image (mono_defaults.object_class)->icall_wrapper_cache, mono_aligned_addr_hash, NULL);
 	if ((res = mono_marshal_find_in_cache (cache, (gpointer) func)))
 		return res;
 
@@ -3401,6 +3446,110 @@ mono_marshal_set_callconv_from_modopt (MonoMethod *method, MonoMethodSignature *
 	}
 }
 
+/*
+ * pinvoke_suppresses_gc_transition:
+ *
+ *   Whenever the pinvoke METHOD is marked with SuppressGCTransitionAttribute, so its
+ * wrapper calls the native function without switching to GC Safe mode. The native
+ * function has to be short and must not block or call back into the runtime.
+ */
+static gboolean
+pinvoke_suppresses_gc_transition (MonoMethod *method)
+{
+	ERROR_DECL (error);
+	MonoClass *attr_klass;
+	MonoCustomAttrInfo *cinfo;
+	gboolean res;
+
+	attr_klass = mono_class_try_get_suppress_gc_transition_attribute_class ();
+	if (!attr_klass)
+		return FALSE;
+
+	cinfo = mono_custom_attrs_from_method_checked (method, error);
+	if (!is_ok (error)) {
+		mono_error_cleanup (error);
+		return FALSE;
+	}
+	if (!cinfo)
+		return FALSE;
+
+	res = mono_custom_attrs_has_attr (cinfo, attr_klass);
+	if (!cinfo->cached)
+		mono_custom_attrs_free (cinfo);
+	return res;
+}
+
+static gboolean
+type_is_direct_pinvoke_blittable (MonoType *t)
+{
+	if (t->byref)
+		return FALSE;
+
+	switch (t->type) {
+	case MONO_TYPE_I1:
+	case MONO_TYPE_U1:
+	case MONO_TYPE_I2:
+	case MONO_TYPE_U2:
+	case MONO_TYPE_I4:
+	case MONO_TYPE_U4:
+	case MONO_TYPE_I8:
+	case MONO_TYPE_U8:
+	case MONO_TYPE_R4:
+	case MONO_TYPE_R8:
+	case MONO_TYPE_I:
+	case MONO_TYPE_U:
+	case MONO_TYPE_PTR:
+	case MONO_TYPE_FNPTR:
+		return TRUE;
+	default:
+		return FALSE;
+	}
+}
+
+/**
+ * mono_marshal_is_direct_pinvoke:
+ *
+ *   Whenever the native wrapper of the pinvoke METHOD comes down to a native call:
+ * the parameters and the return value are passed as is, the last error is not saved
+ * and there is no GC transition. The JIT inlines the wrapper into the callers of
+ * such methods instead of calling it.
+ */
+gboolean
+mono_marshal_is_direct_pinvoke (MonoMethod *method)
+{
+	MonoMethodPInvoke *piinfo = (MonoMethodPInvoke *) method;
+	MonoMethodSignature *sig;
+	MonoMarshalSpec **mspecs;
+	gboolean res = TRUE;
+	int i;
+
+	if (!(method->flags & METHOD_ATTRIBUTE_PINVOKE_IMPL) || MONO_CLASS_IS_IMPORT (method->klass))
+		return FALSE;
+	if (piinfo->piflags & PINVOKE_ATTRIBUTE_SUPPORTS_LAST_ERROR)
+		return FALSE;
+
+	sig = mono_method_signature_internal (method);
+	if (!sig || sig->hasthis || (!MONO_TYPE_IS_VOID (sig->ret) && !type_is_direct_pinvoke_blittable (sig->ret)))
+		return FALSE;
+	for (i = 0; i < sig->param_count; ++i) {
+		if (!type_is_direct_pinvoke_blittable (sig->params [i]))
+			return FALSE;
+	}
+
+	/* MarshalAs could still convert the primitives */
+	mspecs = g_new0 (MonoMarshalSpec*, sig->param_count + 1);
+	mono_method_get_marshal_info (method, mspecs);
+	for (i = sig->param_count; i >= 0; i--) {
+		if (mspecs [i]) {
+			res = FALSE;
+			mono_metadata_free_marshal_spec (mspecs [i]);
+		}
+	}
+	g_free (mspecs);
+
+	return res && pinvoke_suppresses_gc_transition (method);
+}
+
 /**
  * mono_marshal_get_native_wrapper:
  * \param method The \c MonoMethod to wrap.
@@ -3417,7 +3566,7 @@ mono_marshal_get_native_wrapper (MonoMethod *method, gboolean check_exceptions,
 	MonoMethodBuilder *mb;
 	MonoMarshalSpec **mspecs;
 	MonoMethod *res;
-	GHashTable *cache;
+	MonoConcurrentHashTable *cache;
 	gboolean pinvoke = FALSE;
 	gpointer iter;
 	int i;
@@ -3427,7 +3576,7 @@ mono_marshal_get_native_wrapper (MonoMethod *method, gboolean check_exceptions,
 	g_assert (method != NULL);
 	g_assert (mono_method_signature_internal (method)->pinvoke);
 
-	GHashTable **cache_ptr;
+	MonoConcurrentHashTable **cache_ptr;
 
 	MonoType *string_type = m_class_get_byval_arg (mono_defaults.string_class);
 
@@ -3585,7 +3734,7 @@ mono_marshal_get_native_wrapper (MonoMethod *method, gboolean check_exceptions,
 	mspecs = g_new (MonoMarshalSpec*, sig->param_count + 1);
 	mono_method_get_marshal_info (method, mspecs);
 
-	mono_marshal_emit_native_wrapper (get_method_image (mb->method), mb, csig, piinfo, mspecs, piinfo->addr, aot, check_exceptions, FALSE);
+	mono_marshal_emit_native_wrapper (get_method_image (mb->method), mb, csig, piinfo, mspecs, piinfo->addr, aot, check_exceptions, FALSE, pinvoke_suppresses_gc_transition (method));
 	info = mono_wrapper_info_create (mb, WRAPPER_SUBTYPE_PINVOKE);
 	info->d.managed_to_native.method = method;
 
@@ -3622,7 +3771,7 @@ mono_marshal_get_native_func_wrapper (MonoImage *image, MonoMethodSignature *sig
 	SignaturePointerPair key, *new_key;
 	MonoMethodBuilder *mb;
 	MonoMethod *res;
-	GHashTable *cache;
+	MonoConcurrentHashTable *cache;
 	gboolean found;
 	char *name;
 
@@ -3640,7 +3789,7 @@ mono_marshal_get_native_func_wrapper (MonoImage *image, MonoMethodSignature *sig
 	mb = mono_mb_new (mono_defaults.object_class, name, MONO_WRAPPER_MANAGED_TO_NATIVE);
 	mb->method->save_lmf = 1;
 
-	mono_marshal_emit_native_wrapper (image, mb, sig, piinfo, mspecs, func, FALSE, TRUE, FALSE);
+	mono_marshal_emit_native_wrapper (image, mb, sig, piinfo, mspecs, func, FALSE, TRUE, FALSE, FALSE);
 
 	csig = mono_metadata_signature_dup_full (image, sig);
 	csig->pinvoke = 0;
@@ -3670,7 +3819,7 @@ mono_marshal_get_native_func_wrapper_aot (MonoClass *klass)
 	MonoMethodSignature *sig, *csig;
 	MonoMethodBuilder *mb;
 	MonoMethod *res;
-	GHashTable *cache;
+	MonoConcurrentHashTable *cache;
 	char *name;
 	WrapperInfo *info;
 	MonoMethodPInvoke mpiinfo;
@@ -3703,7 +3852,7 @@ mono_marshal_get_native_func_wrapper_aot (MonoClass *klass)
 	mb = mono_mb_new (invoke->klass, name, MONO_WRAPPER_MANAGED_TO_NATIVE);
 	mb->method->save_lmf = 1;
 
-	mono_marshal_emit_native_wrapper (image, mb, sig, piinfo, mspecs, NULL, FALSE, TRUE, TRUE);
+	mono_marshal_emit_native_wrapper (image, mb, sig, piinfo, mspecs, NULL, FALSE, TRUE, TRUE, FALSE);
 
 	info = mono_wrapper_info_create (mb, WRAPPER_SUBTYPE_NATIVE_FUNC_AOT);
 	info->d.managed_to_native.method = invoke;
@@ -3791,7 +3940,7 @@ mono_marshal_get_managed_wrapper (MonoMethod *method, MonoClass *delegate_klass,
 	MonoMethod *res, *invoke;
 	MonoMarshalSpec **mspecs;
 	MonoMethodPInvoke piinfo;
-	GHashTable *cache;
+	MonoConcurrentHashTable *cache;
 	int i;
 	EmitMarshalContext m;
 
@@ -4326,7 +4475,7 @@ mono_marshal_get_synchronized_wrapper (MonoMethod *method)
 	MonoMethodSignature *sig;
 	MonoMethodBuilder *mb;
 	MonoMethod *res;
-	GHashTable *cache;
+	MonoConcurrentHashTable *cache;
 	WrapperInfo *info;
 	MonoGenericContext *ctx = NULL;
 	MonoMethod *orig_method = NULL;
@@ -4426,7 +4575,7 @@ mono_marshal_get_unbox_wrapper (MonoMethod *method)
 	MonoMethodSignature *sig = mono_method_signature_internal (method);
 	MonoMethodBuilder *mb;
 	MonoMethod *res;
-	GHashTable *cache;
+	MonoConcurrentHashTable *cache;
 	WrapperInfo *info;
 
 	cache = get_cache (&mono_method_get_wrapper_cache (method)->unbox_wrapper_cache, mono_aligned_addr_hash, NULL);
@@ -4848,7 +4997,7 @@ mono_marshal_get_array_accessor_wrapper (MonoMethod *method)
 	MonoMethodSignature *sig;
 	MonoMethodBuilder *mb;
 	MonoMethod *res;
-	GHashTable *cache;
+	MonoConcurrentHashTable *cache;
 	MonoGenericContext *ctx = NULL;
 	MonoMethod *orig_method = NULL;
 	WrapperInfo *info;
@@ -6235,7 +6384,7 @@ mono_marshal_get_thunk_invoke_wrapper (MonoMethod *method)
 	MonoMethodSignature *sig, *csig;
 	MonoImage *image;
 	MonoClass *klass;
-	GHashTable *cache;
+	MonoConcurrentHashTable *cache;
 	MonoMethod *res;
 	int i, param_count, sig_size;
 
@@ -6291,21 +6440,122 @@ mono_marshal_get_thunk_invoke_wrapper (MonoMethod *method)
 	return res;
 }
 
+#ifndef ENABLE_ILGEN
 static void
-clear_runtime_invoke_method_cache (GHashTable *table, MonoMethod *method)
+emit_reflection_invoke_noilgen (MonoMethodBuilder *mb, MonoMethod *method)
+{
+}
+#endif
+
+/**
+ * mono_marshal_reflection_invoke_supported:
+ * Whether \p method can be called through a stub returned by
+ * \c mono_marshal_get_reflection_invoke. The others, like constructors or
+ * methods taking pointers, have to go through \c mono_runtime_invoke_array.
+ */
+gboolean
+mono_marshal_reflection_invoke_supported (MonoMethod *method)
+{
+	MonoClass *klass = method->klass;
+	MonoMethodSignature *sig;
+	int i;
+
+	if (method->wrapper_type || method->dynamic || method->string_ctor || method->is_generic)
+		return FALSE;
+	if (mono_class_is_gtd (klass) || mono_class_is_open_constructed_type (m_class_get_byval_arg (klass)))
+		return FALSE;
+	if (m_class_get_rank (klass) || m_class_is_byreflike (klass) || mono_class_is_nullable (klass))
+		return FALSE;
+	/* Calls through proxies need the remoting wrappers */
+	if (mono_class_is_marshalbyref (klass) || mono_class_is_contextbound (klass))
+		return FALSE;
+	if (!strcmp (method->name, ".ctor") || !strcmp (method->name, ".cctor"))
+		return FALSE;
+#ifdef ENABLE_NETCORE
+	/* The stub is cached in the image and would call the freed code of an unloaded context */
+	if (mono_alc_owns_method (NULL, method))
+		return FALSE;
+#endif
+
+	sig = mono_method_signature_internal (method);
+	if (!sig || sig->call_convention == MONO_CALL_VARARG || sig->ret->byref)
+		return FALSE;
+
+	for (i = 0; i <= sig->param_count; ++i) {
+		MonoType *t = i < sig->param_count ? sig->params [i] : sig->ret;
+		MonoClass *param_class;
+
+		if (t->type == MONO_TYPE_PTR || t->type == MONO_TYPE_FNPTR || t->type == MONO_TYPE_TYPEDBYREF)
+			return FALSE;
+		param_class = mono_class_from_mono_type_internal (t);
+		if (m_class_is_byreflike (param_class) || m_class_get_byval_arg (param_class)->type == MONO_TYPE_PTR)
+			return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * mono_marshal_get_reflection_invoke:
+ * Returns a wrapper with the signature <code>object (object, object[])</code>
+ * which calls \p method with its arguments unboxed from the array, writes
+ * byref arguments back into it and returns the boxed result. All the wrappers
+ * share their signature, so they also share a single runtime invoke wrapper.
+ * \p method must be supported by \c mono_marshal_reflection_invoke_supported.
+ */
+MonoMethod *
+mono_marshal_get_reflection_invoke (MonoMethod *method)
+{
+	static MonoMethodSignature *csig;
+	MonoMethodBuilder *mb;
+	MonoMethod *res;
+	MonoConcurrentHashTable *cache;
+	WrapperInfo *info;
+
+	g_assert (mono_marshal_reflection_invoke_supported (method));
+
+	cache = get_cache (&mono_method_get_wrapper_cache (method)->reflection_invoke_cache, mono_aligned_addr_hash, NULL);
+
+	if ((res = mono_marshal_find_in_cache (cache, method)))
+		return res;
+
+	if (!csig) {
+		MonoMethodSignature *tmp_sig = mono_metadata_signature_alloc (mono_defaults.corlib, 2);
+		tmp_sig->ret = mono_get_object_type ();
+		tmp_sig->params [0] = mono_get_object_type ();
+		tmp_sig->params [1] = m_class_get_byval_arg (mono_class_create_array (mono_defaults.object_class, 1));
+		tmp_sig->pinvoke = 0;
+		mono_memory_barrier ();
+		csig = tmp_sig;
+	}
+
+	mb = mono_mb_new (method->klass, method->name, MONO_WRAPPER_OTHER);
+	get_marshal_cb ()->mb_skip_visibility (mb);
+	get_marshal_cb ()->emit_reflection_invoke (mb, method);
+
+	info = mono_wrapper_info_create (mb, WRAPPER_SUBTYPE_REFLECTION_INVOKE);
+	info->d.reflection_invoke.method = method;
+
+	res = mono_mb_create_and_cache_full (cache, method, mb, csig, mono_method_signature_internal (method)->param_count + 16, info, NULL);
+	mono_mb_free (mb);
+
+	return res;
+}
+
+static void
+clear_runtime_invoke_method_cache (MonoConcurrentHashTable *table, MonoMethod *method)
 {
 	MonoWrapperMethodCacheKey hash_key = {method, FALSE, FALSE};
 	/*
 	 * Since we have a small set of possible keys, remove each one separately, thus
 	 * avoiding the traversal of the entire hash table, when using foreach_remove.
 	 */
-	g_hash_table_remove (table, &hash_key);
+	mono_conc_hashtable_remove (table, &hash_key);
 	hash_key.need_direct_wrapper = TRUE;
-	g_hash_table_remove (table, &hash_key);
+	mono_conc_hashtable_remove (table, &hash_key);
 	hash_key.virtual_ = TRUE;
-	g_hash_table_remove (table, &hash_key);
+	mono_conc_hashtable_remove (table, &hash_key);
 	hash_key.need_direct_wrapper = FALSE;
-	g_hash_table_remove (table, &hash_key);
+	mono_conc_hashtable_remove (table, &hash_key);
 }
 
 /*
@@ -6329,11 +6579,19 @@ mono_marshal_free_dynamic_wrappers (MonoMethod *method)
 	 */
 	if (image->wrapper_caches.runtime_invoke_method_cache)
 		clear_runtime_invoke_method_cache (image->wrapper_caches.runtime_invoke_method_cache, method);
-	if (image->wrapper_caches.delegate_abstract_invoke_cache)
-		g_hash_table_foreach_remove (image->wrapper_caches.delegate_abstract_invoke_cache, signature_pointer_pair_matches_pointer, method);
+	if (image->wrapper_caches.delegate_abstract_invoke_cache) {
+		SignaturePointerPairSteal steal = { method, NULL };
+		GSList *l;
+
+		/* The keys are only freed once they are unlinked from the table */
+		mono_conc_hashtable_foreach_steal (image->wrapper_caches.delegate_abstract_invoke_cache, signature_pointer_pair_steal_pointer, &steal);
+		for (l = steal.stolen; l; l = l->next)
+			free_signature_pointer_pair ((SignaturePointerPair*)l->data);
+		g_slist_free (steal.stolen);
+	}
 	// FIXME: Need to clear the caches in other images as well
 	if (image->delegate_bound_static_invoke_cache)
-		g_hash_table_remove (image->delegate_bound_static_invoke_cache, mono_method_signature_internal (method));
+		mono_conc_hashtable_remove (image->delegate_bound_static_invoke_cache, mono_method_signature_internal (method));
 
 	if (marshal_mutex_initialized)
 		mono_marshal_unlock ();
@@ -6350,14 +6608,14 @@ mono_marshal_get_type_object (MonoClass *klass)
 }
 
 void
-mono_marshal_emit_native_wrapper (MonoImage *image, MonoMethodBuilder *mb, MonoMethodSignature *sig, MonoMethodPInvoke *piinfo, MonoMarshalSpec **mspecs, gpointer func, gboolean aot, gboolean check_exceptions, gboolean func_param)
+mono_marshal_emit_native_wrapper (MonoImage *image, MonoMethodBuilder *mb, MonoMethodSignature *sig, MonoMethodPInvoke *piinfo, MonoMarshalSpec **mspecs, gpointer func, gboolean aot, gboolean check_exceptions, gboolean func_param, gboolean skip_gc_trans)
 {
-	get_marshal_cb ()->emit_native_wrapper (image, mb, sig, piinfo, mspecs, func, aot, check_exceptions, func_param);
+	get_marshal_cb ()->emit_native_wrapper (image, mb, sig, piinfo, mspecs, func, aot, check_exceptions, func_param, skip_gc_trans);
 }
 
 #ifndef ENABLE_ILGEN
 static void
-emit_native_wrapper_noilgen (MonoImage *image, MonoMethodBuilder *mb, MonoMethodSignature *sig, MonoMethodPInvoke *piinfo, MonoMarshalSpec **mspecs, gpointer func, gboolean aot, gboolean check_exceptions, gboolean func_param)
+emit_native_wrapper_noilgen (MonoImage *image, MonoMethodBuilder *mb, MonoMethodSignature *sig, MonoMethodPInvoke *piinfo, MonoMarshalSpec **mspecs, gpointer func, gboolean aot, gboolean check_exceptions, gboolean func_param, gboolean skip_gc_trans)
 {
 }
 #endif
@@ -6412,6 +6670,7 @@ install_noilgen (void)
 	cb.emit_array_accessor_wrapper = emit_array_accessor_wrapper_noilgen;
 	cb.emit_generic_array_helper = emit_generic_array_helper_noilgen;
 	cb.emit_thunk_invoke_wrapper = emit_thunk_invoke_wrapper_noilgen;
+	cb.emit_reflection_invoke = emit_reflection_invoke_noilgen;
 	cb.emit_create_string_hack = emit_create_string_hack_noilgen;
 	cb.emit_native_icall_wrapper = emit_native_icall_wrapper_noilgen;
 	cb.emit_icall_wrapper = emit_icall_wrapper_noilgen;
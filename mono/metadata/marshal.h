@@ -20,6 +20,7 @@
 #include <mono/metadata/method-builder.h>
 #include <mono/metadata/remoting.h>
 #include <mono/utils/mono-error.h>
+#include <mono/utils/mono-conc-hashtable.h>
 #include <mono/metadata/icalls.h>
 
 typedef gunichar2 *mono_bstr;
@@ -131,7 +132,8 @@ typedef enum {
 	WRAPPER_SUBTYPE_GSHAREDVT_OUT_SIG,
 	WRAPPER_SUBTYPE_INTERP_IN,
 	WRAPPER_SUBTYPE_INTERP_LMF,
-	WRAPPER_SUBTYPE_AOT_INIT
+	WRAPPER_SUBTYPE_AOT_INIT,
+	WRAPPER_SUBTYPE_REFLECTION_INVOKE
 } WrapperSubtype;
 
 typedef struct {
@@ -210,6 +212,10 @@ typedef struct {
 	MonoMethodSignature *sig;
 } InterpInWrapperInfo;
 
+typedef struct {
+	MonoMethod *method;
+} ReflectionInvokeWrapperInfo;
+
 typedef enum {
 	AOT_INIT_METHOD = 0,
 	AOT_INIT_METHOD_GSHARED_MRGCTX = 1,
@@ -270,6 +276,8 @@ typedef struct {
 		InterpInWrapperInfo interp_in;
 		/* AOT_INIT */
 		AOTInitWrapperInfo aot_init;
+		/* REFLECTION_INVOKE */
+		ReflectionInvokeWrapperInfo reflection_invoke;
 	} d;
 } WrapperInfo;
 
@@ -284,7 +292,7 @@ typedef enum {
 } MonoStelemrefKind;
 
 
-#define MONO_MARSHAL_CALLBACKS_VERSION 4
+#define MONO_MARSHAL_CALLBACKS_VERSION 6
 
 typedef struct {
 	int version;
@@ -309,7 +317,7 @@ typedef struct {
 	void (*emit_virtual_stelemref) (MonoMethodBuilder *mb, const char **param_names, MonoStelemrefKind kind);
 	void (*emit_stelemref) (MonoMethodBuilder *mb);
 	void (*emit_array_address) (MonoMethodBuilder *mb, int rank, int elem_size);
-	void (*emit_native_wrapper) (MonoImage *image, MonoMethodBuilder *mb, MonoMethodSignature *sig, MonoMethodPInvoke *piinfo, MonoMarshalSpec **mspecs, gpointer func, gboolean aot, gboolean check_exceptions, gboolean func_param);
+	void (*emit_native_wrapper) (MonoImage *image, MonoMethodBuilder *mb, MonoMethodSignature *sig, MonoMethodPInvoke *piinfo, MonoMarshalSpec **mspecs, gpointer func, gboolean aot, gboolean check_exceptions, gboolean func_param, gboolean skip_gc_trans);
 	void (*emit_managed_wrapper) (MonoMethodBuilder *mb, MonoMethodSignature *invoke_sig, MonoMarshalSpec **mspecs, EmitMarshalContext* m, MonoMethod *method, uint32_t target_handle);
 	void (*emit_runtime_invoke_body) (MonoMethodBuilder *mb, const char **param_names, MonoImage *image, MonoMethod *method, MonoMethodSignature *sig, MonoMethodSignature *callsig, gboolean virtual_, gboolean need_direct_wrapper);
 	void (*emit_runtime_invoke_dynamic) (MonoMethodBuilder *mb);
@@ -321,6 +329,7 @@ typedef struct {
 	void (*emit_array_accessor_wrapper) (MonoMethodBuilder *mb, MonoMethod *method, MonoMethodSignature *sig, MonoGenericContext *ctx);
 	void (*emit_generic_array_helper) (MonoMethodBuilder *mb, MonoMethod *method, MonoMethodSignature *csig);
 	void (*emit_thunk_invoke_wrapper) (MonoMethodBuilder *mb, MonoMethod *method, MonoMethodSignature *csig);
+	void (*emit_reflection_invoke) (MonoMethodBuilder *mb, MonoMethod *method);
 	void (*emit_create_string_hack) (MonoMethodBuilder *mb, MonoMethodSignature *csig, MonoMethod *res);
 	void (*emit_native_icall_wrapper) (MonoMethodBuilder *mb, MonoMethod *method, MonoMethodSignature *csig, gboolean check_exceptions, gboolean aot, MonoMethodPInvoke *pinfo);
 	void (*emit_icall_wrapper) (MonoMethodBuilder *mb, MonoJitICallInfo *callinfo, MonoMethodSignature *csig2, gboolean check_exceptions);
@@ -444,6 +453,9 @@ mono_marshal_get_aot_init_wrapper_name (MonoAotInitSubtype subtype) MONO_LLVM_IN
 MonoMethod *
 mono_marshal_get_native_wrapper (MonoMethod *method, gboolean check_exceptions, gboolean aot);
 
+gboolean
+mono_marshal_is_direct_pinvoke (MonoMethod *method);
+
 MonoMethod *
 mono_marshal_get_native_func_wrapper (MonoImage *image, MonoMethodSignature *sig, MonoMethodPInvoke *piinfo, MonoMarshalSpec **mspecs, gpointer func);
 
@@ -492,6 +504,12 @@ mono_marshal_get_generic_array_helper (MonoClass *klass, const gchar *name, Mono
 MonoMethod *
 mono_marshal_get_thunk_invoke_wrapper (MonoMethod *method);
 
+gboolean
+mono_marshal_reflection_invoke_supported (MonoMethod *method);
+
+MonoMethod *
+mono_marshal_get_reflection_invoke (MonoMethod *method);
+
 MonoMethod*
 mono_marshal_get_gsharedvt_in_wrapper (void);
 
@@ -636,19 +654,19 @@ mono_signature_no_pinvoke (MonoMethod *method);
 /* Called from cominterop.c/remoting.c */
 
 void
-mono_marshal_emit_native_wrapper (MonoImage *image, MonoMethodBuilder *mb, MonoMethodSignature *sig, MonoMethodPInvoke *piinfo, MonoMarshalSpec **mspecs, gpointer func, gboolean aot, gboolean check_exceptions, gboolean func_param);
+mono_marshal_emit_native_wrapper (MonoImage *image, MonoMethodBuilder *mb, MonoMethodSignature *sig, MonoMethodPInvoke *piinfo, MonoMarshalSpec **mspecs, gpointer func, gboolean aot, gboolean check_exceptions, gboolean func_param, gboolean skip_gc_trans);
 
 void
 mono_marshal_emit_managed_wrapper (MonoMethodBuilder *mb, MonoMethodSignature *invoke_sig, MonoMarshalSpec **mspecs, EmitMarshalContext* m, MonoMethod *method, uint32_t target_handle);
 
-GHashTable*
-mono_marshal_get_cache (GHashTable **var, GHashFunc hash_func, GCompareFunc equal_func);
+MonoConcurrentHashTable*
+mono_marshal_get_cache (MonoConcurrentHashTable **var, GHashFunc hash_func, GCompareFunc equal_func);
 
 MonoMethod*
-mono_marshal_find_in_cache (GHashTable *cache, gpointer key);
+mono_marshal_find_in_cache (MonoConcurrentHashTable *cache, gpointer key);
 
 MonoMethod*
-mono_mb_create_and_cache (GHashTable *cache, gpointer key,
+mono_mb_create_and_cache (MonoConcurrentHashTable *cache, gpointer key,
 						  MonoMethodBuilder *mb, MonoMethodSignature *sig,
 						  int max_stack);
 void
@@ -671,7 +689,7 @@ mono_mb_create (MonoMethodBuilder *mb, MonoMethodSignature *sig,
 				int max_stack, WrapperInfo *info);
 
 MonoMethod*
-mono_mb_create_and_cache_full (GHashTable *cache, gpointer key,
+mono_mb_create_and_cache_full (MonoConcurrentHashTable *cache, gpointer key,
 							   MonoMethodBuilder *mb, MonoMethodSignature *sig,
 							   int max_stack, WrapperInfo *info, gboolean *out_found);
 
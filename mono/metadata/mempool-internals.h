@@ -8,6 +8,7 @@
 #include <glib.h>
 
 #include "mono/utils/mono-compiler.h"
+#include "mono/utils/mono-jemalloc.h"
 #include "mono/metadata/mempool.h"
 
 static inline GList*
@@ -84,4 +85,16 @@ mono_mempool_strdup_printf (MonoMemPool *pool, const char *format, ...) MONO_ATT
 long
 mono_mempool_get_bytes_allocated (void);
 
+MonoMemPool *
+mono_mempool_new_arena (MonoJemallocArena arena);
+
+MonoMemPool *
+mono_mempool_new_size_arena (int initial_size, MonoJemallocArena arena);
+
+gpointer
+mono_mempool_alloc_thread_cached (MonoMemPool *pool, guint size);
+
+gpointer
+mono_mempool_alloc_thread_refill (MonoMemPool *pool, guint size);
+
 #endif
@@ -21,6 +21,7 @@
 #include "mempool.h"
 #include "mempool-internals.h"
 #include "utils/unlocked.h"
+#include "utils/atomic.h"
 
 /*
  * MonoMemPool is for fast allocation of memory. We free
@@ -49,6 +50,14 @@
 #define MONO_MEMPOOL_PREFER_INDIVIDUAL_ALLOCATION_SIZE MONO_MEMPOOL_PAGESIZE
 #endif
 
+// Per-thread bump chunks carved out of shared mempools, see mono_mempool_alloc_thread_cached ()
+#if defined(MONO_KEYWORD_THREAD) && !defined(INDIVIDUAL_ALLOCATIONS)
+#define MEMPOOL_THREAD_CACHE
+#endif
+#define MONO_MEMPOOL_THREAD_CACHE_ENTRIES 8
+#define MONO_MEMPOOL_THREAD_CHUNK_MINSIZE 256
+#define MONO_MEMPOOL_THREAD_CHUNK_MAXSIZE 4096
+
 #ifndef G_LIKELY
 #define G_LIKELY(a) (a)
 #define G_UNLIKELY(a) (a)
@@ -69,6 +78,19 @@ struct _MonoMemPool {
 	// Used in "initial block" only: End of current free space in mempool (ie, the first byte following the end of usable space)
 	guint8 *end;
 
+	// Used in "initial block" only: Unique id of the mempool, thread cache entries refer to the pool by it
+	guint64 id;
+
+	// Used in "initial block" only: Bytes left unused at the end of blocks and thread chunks which were replaced
+	guint32 wasted;
+
+	// Used in "initial block" only: Bytes handed out to thread caches, and the number of chunks this took
+	guint32 thread_cached;
+	guint32 thread_chunks;
+
+	// Used in "initial block" only: jemalloc arena all blocks are allocated from, see mono-jemalloc.h
+	guint32 arena;
+
 	union {
 		// Unused: Imposing floating point memory rules on _MonoMemPool's final field ensures proper alignment of whole header struct
 		double pad;
@@ -80,6 +102,41 @@ struct _MonoMemPool {
 
 static gint64 total_bytes_allocated = 0;
 
+static gint64 next_pool_id = 0;
+
+#ifdef MEMPOOL_THREAD_CACHE
+typedef struct {
+	guint64 pool_id;
+	guint8 *pos;
+	guint8 *end;
+} MonoMemPoolThreadChunk;
+
+// Direct mapped by pool address. An entry whose pool was destroyed can never match again, as pool ids aren't reused.
+static MONO_KEYWORD_THREAD MonoMemPoolThreadChunk thread_chunks [MONO_MEMPOOL_THREAD_CACHE_ENTRIES];
+#endif
+
+static MonoMemPool *
+alloc_block (MonoJemallocArena arena, guint size)
+{
+#ifdef MONO_JEMALLOC_ENABLED
+	if (arena != MONO_JEMALLOC_ARENA_NONE)
+		return (MonoMemPool *)mono_jemalloc_arena_malloc (arena, size);
+#endif
+	return (MonoMemPool *)g_malloc (size);
+}
+
+static void
+free_block (MonoJemallocArena arena, MonoMemPool *block)
+{
+#ifdef MONO_JEMALLOC_ENABLED
+	if (arena != MONO_JEMALLOC_ARENA_NONE) {
+		mono_jemalloc_arena_free (arena, block);
+		return;
+	}
+#endif
+	g_free (block);
+}
+
 /**
  * mono_mempool_new:
  *
@@ -91,6 +148,17 @@ mono_mempool_new (void)
 	return mono_mempool_new_size (MONO_MEMPOOL_PAGESIZE);
 }
 
+/**
+ * mono_mempool_new_arena:
+ * \param arena the jemalloc arena to allocate the blocks of the pool from.
+ * \returns a new memory pool. Without jemalloc, \p arena is ignored.
+ */
+MonoMemPool *
+mono_mempool_new_arena (MonoJemallocArena arena)
+{
+	return mono_mempool_new_size_arena (MONO_MEMPOOL_PAGESIZE, arena);
+}
+
 /**
  * mono_mempool_new_size:
  * \param initial_size the amount of memory to initially reserve for the memory pool.
@@ -98,6 +166,18 @@ mono_mempool_new (void)
  */
 MonoMemPool *
 mono_mempool_new_size (int initial_size)
+{
+	return mono_mempool_new_size_arena (initial_size, MONO_JEMALLOC_ARENA_NONE);
+}
+
+/**
+ * mono_mempool_new_size_arena:
+ * \param initial_size the amount of memory to initially reserve for the memory pool.
+ * \param arena the jemalloc arena to allocate the blocks of the pool from.
+ * \returns a new memory pool. Without jemalloc, \p arena is ignored.
+ */
+MonoMemPool *
+mono_mempool_new_size_arena (int initial_size, MonoJemallocArena arena)
 {
 	MonoMemPool *pool;
 
@@ -109,12 +189,15 @@ mono_mempool_new_size (int initial_size)
 		initial_size = MONO_MEMPOOL_MINSIZE;
 #endif
 
-	pool = (MonoMemPool *)g_malloc (initial_size);
+	pool = alloc_block (arena, initial_size);
 
 	pool->next = NULL;
 	pool->pos = (guint8*)pool + SIZEOF_MEM_POOL; // Start after header
 	pool->end = (guint8*)pool + initial_size;    // End at end of allocated space 
 	pool->d.allocated = pool->size = initial_size;
+	pool->id = mono_atomic_inc_i64 (&next_pool_id);
+	pool->wasted = pool->thread_cached = pool->thread_chunks = 0;
+	pool->arena = arena;
 	UnlockedAdd64 (&total_bytes_allocated, initial_size);
 	return pool;
 }
@@ -129,13 +212,14 @@ void
 mono_mempool_destroy (MonoMemPool *pool)
 {
 	MonoMemPool *p, *n;
+	MonoJemallocArena arena = (MonoJemallocArena)pool->arena;
 
 	UnlockedSubtract64 (&total_bytes_allocated, pool->d.allocated);
 
 	p = pool;
 	while (p) {
 		n = p->next;
-		g_free (p);
+		free_block (arena, p);
 		p = n;
 	}
 }
@@ -186,6 +270,9 @@ mono_mempool_stats (MonoMemPool *pool)
 		g_print ("Total mem allocated: %d\n", pool->d.allocated);
 		g_print ("Num chunks: %d\n", count);
 		g_print ("Free memory: %d\n", still_free);
+		g_print ("Abandoned memory: %d\n", pool->wasted);
+		g_print ("Thread cached memory: %d in %d chunks\n", pool->thread_cached, pool->thread_chunks);
+		g_print ("Fragmentation: %.2f%%\n", pool->d.allocated ? (still_free + pool->wasted) * 100.0 / pool->d.allocated : 0.0);
 	}
 }
 
@@ -282,7 +369,7 @@ gpointer
 		// (In individual allocation mode, the constant will be 0 and this path will always be taken)
 		if (size >= MONO_MEMPOOL_PREFER_INDIVIDUAL_ALLOCATION_SIZE) {
 			guint new_size = SIZEOF_MEM_POOL + size;
-			MonoMemPool *np = (MonoMemPool *)g_malloc (new_size);
+			MonoMemPool *np = alloc_block ((MonoJemallocArena)pool->arena, new_size);
 
 			np->next = pool->next;
 			np->size = new_size;
@@ -294,7 +381,8 @@ gpointer
 		} else {
 			// Notice: any unused memory at the end of the old head becomes simply abandoned in this case until the mempool is freed (see Bugzilla #35136)
 			guint new_size = get_next_size (pool, size);
-			MonoMemPool *np = (MonoMemPool *)g_malloc (new_size);
+			pool->wasted += pool->end - pool->pos;
+			MonoMemPool *np = alloc_block ((MonoJemallocArena)pool->arena, new_size);
 
 			np->next = pool->next;
 			np->size = new_size;
@@ -327,6 +415,84 @@ gpointer
 	return rval;
 }
 
+/**
+ * mono_mempool_alloc_thread_cached:
+ * \param pool the memory pool to use
+ * \param size size of the memory block
+ *
+ * Allocates from the chunk of \p pool cached by the current thread, without taking
+ * the lock which protects \p pool. Meant for pools shared by many threads, like the
+ * ones of images.
+ *
+ * \returns the address of a newly allocated memory block, or NULL if the chunk can't
+ * satisfy the request. The caller should then take the lock of \p pool and call
+ * \c mono_mempool_alloc_thread_refill.
+ */
+gpointer
+mono_mempool_alloc_thread_cached (MonoMemPool *pool, guint size)
+{
+#ifdef MEMPOOL_THREAD_CACHE
+	MonoMemPoolThreadChunk *chunk = &thread_chunks [((gsize)pool >> 4) & (MONO_MEMPOOL_THREAD_CACHE_ENTRIES - 1)];
+	gpointer rval;
+
+	size = ALIGN_SIZE (size);
+	if (G_UNLIKELY (chunk->pool_id != pool->id || (gsize)(chunk->end - chunk->pos) < size))
+		return NULL;
+
+	rval = chunk->pos;
+	chunk->pos += size;
+	return rval;
+#else
+	return NULL;
+#endif
+}
+
+/**
+ * mono_mempool_alloc_thread_refill:
+ *
+ * Slow path of \c mono_mempool_alloc_thread_cached: give the current thread a new
+ * chunk of \p pool and allocate \p size bytes from it. Large requests are allocated
+ * from \p pool directly.
+ *
+ * LOCKING: Must be called holding the lock which protects \p pool.
+ */
+gpointer
+mono_mempool_alloc_thread_refill (MonoMemPool *pool, guint size)
+{
+#ifdef MEMPOOL_THREAD_CACHE
+	MonoMemPoolThreadChunk *chunk = &thread_chunks [((gsize)pool >> 4) & (MONO_MEMPOOL_THREAD_CACHE_ENTRIES - 1)];
+	guint chunk_size;
+	gpointer rval;
+
+	size = ALIGN_SIZE (size);
+	if (size > MONO_MEMPOOL_THREAD_CHUNK_MAXSIZE / 4)
+		return mono_mempool_alloc (pool, size);
+
+	// Small pools get small chunks, so the unused tails don't dominate them
+	chunk_size = ALIGN_SIZE (pool->d.allocated / 32);
+	chunk_size = MAX (chunk_size, MONO_MEMPOOL_THREAD_CHUNK_MINSIZE);
+	chunk_size = MIN (chunk_size, MONO_MEMPOOL_THREAD_CHUNK_MAXSIZE);
+	// Rather take what's left of the current block than abandon it (the last byte can't be handed out)
+	if (pool->end - pool->pos > size + MEM_ALIGN)
+		chunk_size = MIN (chunk_size, pool->end - pool->pos - MEM_ALIGN);
+
+	if (chunk->pool_id == pool->id)
+		pool->wasted += chunk->end - chunk->pos;
+
+	chunk->pos = (guint8*)mono_mempool_alloc (pool, chunk_size);
+	chunk->end = chunk->pos + chunk_size;
+	chunk->pool_id = pool->id;
+	pool->thread_cached += chunk_size;
+	pool->thread_chunks++;
+
+	rval = chunk->pos;
+	chunk->pos += size;
+	return rval;
+#else
+	return mono_mempool_alloc (pool, size);
+#endif
+}
+
 /**
  * mono_mempool_contains_addr:
  *
@@ -239,38 +239,39 @@ struct _MonoAssembly {
 typedef struct {
 	/*
 	 * indexed by MonoMethodSignature 
-	 * Protected by the marshal lock
+	 * Lookups are lock-free, inserts are protected by the marshal lock
 	 */
-	GHashTable *delegate_invoke_cache;
-	GHashTable *delegate_begin_invoke_cache;
-	GHashTable *delegate_end_invoke_cache;
-	GHashTable *runtime_invoke_signature_cache;
-	GHashTable *runtime_invoke_sig_cache;
+	MonoConcurrentHashTable *delegate_invoke_cache;
+	MonoConcurrentHashTable *delegate_begin_invoke_cache;
+	MonoConcurrentHashTable *delegate_end_invoke_cache;
+	MonoConcurrentHashTable *runtime_invoke_signature_cache;
+	MonoConcurrentHashTable *runtime_invoke_sig_cache;
 
 	/*
 	 * indexed by SignaturePointerPair
 	 */
-	GHashTable *delegate_abstract_invoke_cache;
+	MonoConcurrentHashTable *delegate_abstract_invoke_cache;
 
 	/*
 	 * indexed by MonoMethod pointers
-	 * Protected by the marshal lock
+	 * Lookups are lock-free, inserts are protected by the marshal lock
 	 */
-	GHashTable *runtime_invoke_method_cache;
-	GHashTable *managed_wrapper_cache;
-
-	GHashTable *native_wrapper_cache;
-	GHashTable *native_wrapper_aot_cache;
-	GHashTable *native_wrapper_check_cache;
-	GHashTable *native_wrapper_aot_check_cache;
-
-	GHashTable *native_func_wrapper_aot_cache;
-	GHashTable *remoting_invoke_cache;
-	GHashTable *synchronized_cache;
-	GHashTable *unbox_wrapper_cache;
-	GHashTable *cominterop_invoke_cache;
-	GHashTable *cominterop_wrapper_cache; /* LOCKING: marshal lock */
-	GHashTable *thunk_invoke_cache;
+	MonoConcurrentHashTable *runtime_invoke_method_cache;
+	MonoConcurrentHashTable *managed_wrapper_cache;
+
+	MonoConcurrentHashTable *native_wrapper_cache;
+	MonoConcurrentHashTable *native_wrapper_aot_cache;
+	MonoConcurrentHashTable *native_wrapper_check_cache;
+	MonoConcurrentHashTable *native_wrapper_aot_check_cache;
+
+	MonoConcurrentHashTable *native_func_wrapper_aot_cache;
+	GHashTable *remoting_invoke_cache; /* LOCKING: marshal lock */
+	MonoConcurrentHashTable *synchronized_cache;
+	MonoConcurrentHashTable *unbox_wrapper_cache;
+	MonoConcurrentHashTable *cominterop_invoke_cache;
+	MonoConcurrentHashTable *cominterop_wrapper_cache;
+	MonoConcurrentHashTable *thunk_invoke_cache;
+	MonoConcurrentHashTable *reflection_invoke_cache;
 } MonoWrapperCaches;
 
 typedef struct {
@@ -402,7 +403,7 @@ struct _MonoImage {
 	gint16 md_version_major, md_version_minor;
 	char *guid;
 	MonoCLIImageInfo    *image_info;
-	MonoMemPool         *mempool; /*protected by the image lock*/
+	MonoMemPool         *mempool; /*protected by the image lock, mono_image_alloc () also hands out thread cached chunks of it*/
 
 	char                *raw_metadata;
 			    
@@ -486,6 +487,18 @@ struct _MonoImage {
 	 */
 	GHashTable *name_cache;  /*protected by the image lock*/
 
+	/*
+	 * Maps namespace and name pairs to the classes mono_class_from_name_checked ()
+	 * found for them. Lookups are lock free, inserts take the image lock.
+	 */
+	MonoConcurrentHashTable *class_from_name_cache;
+
+	/*
+	 * Index of the CustomAttribute table, built by custom-attrs.c on first use.
+	 * A single allocation.
+	 */
+	struct _MonoCustomAttrIndex *custom_attr_index;
+
 	/*
 	 * Indexed by MonoClass
 	 */
@@ -499,26 +512,26 @@ struct _MonoImage {
 	/*
 	 * indexed by SignaturePointerPair
 	 */
-	GHashTable *delegate_bound_static_invoke_cache;
-	GHashTable *native_func_wrapper_cache;
+	MonoConcurrentHashTable *delegate_bound_static_invoke_cache;
+	MonoConcurrentHashTable *native_func_wrapper_cache;
 
 	/*
 	 * indexed by MonoMethod pointers 
 	 */
 	GHashTable *wrapper_param_names;
-	GHashTable *array_accessor_cache;
+	MonoConcurrentHashTable *array_accessor_cache;
 
 	/*
 	 * indexed by MonoClass pointers
 	 */
-	GHashTable *ldfld_wrapper_cache;
-	GHashTable *ldflda_wrapper_cache;
-	GHashTable *stfld_wrapper_cache;
+	MonoConcurrentHashTable *ldfld_wrapper_cache;
+	MonoConcurrentHashTable *ldflda_wrapper_cache;
+	MonoConcurrentHashTable *stfld_wrapper_cache;
 	GHashTable *isinst_cache;
 
-	GHashTable *icall_wrapper_cache;
+	MonoConcurrentHashTable *icall_wrapper_cache;
 	GHashTable *castclass_cache;
-	GHashTable *proxy_isinst_cache;
+	MonoConcurrentHashTable *proxy_isinst_cache;
 	GHashTable *rgctx_template_hash; /* LOCKING: templates lock */
 
 	/* Contains rarely used fields of runtime structures belonging to this image */
@@ -601,8 +614,8 @@ typedef struct {
 	MonoImage **images;
 
 	// Generic-specific caches
-	GHashTable *ginst_cache, *gmethod_cache, *gsignature_cache;
-	MonoConcurrentHashTable *gclass_cache;
+	GHashTable *gmethod_cache;
+	MonoConcurrentHashTable *gclass_cache, *ginst_cache, *gsignature_cache;
 
 	/* mirror caches of ones already on MonoImage. These ones contain generics */
 	GHashTable *szarray_cache, *array_cache, *ptr_cache;
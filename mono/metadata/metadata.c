@@ -23,6 +23,7 @@
 #include "tokentype.h"
 #include "class-internals.h"
 #include "metadata-internals.h"
+#include "mempool-internals.h"
 #include "verify-internals.h"
 #include "class.h"
 #include "marshal.h"
@@ -1121,6 +1122,27 @@ dword_align (const unsigned char *ptr)
 	return (const unsigned char *) (((gsize) (ptr + 3)) & ~3);
 }
 
+/*
+ * Return the offset of column @col in the rows of a table with @bitfield. Each column
+ * takes one byte more than its 2 bit size field, so this adds up the size fields of the
+ * columns before @col, two and then four at a time, instead of looping over them.
+ */
+static inline guint32
+table_column_offset (guint32 bitfield, guint col)
+{
+	guint32 sizes = bitfield & ((1 << (col * 2)) - 1);
+	guint32 sum;
+
+	sum = (sizes & 0x33333) + ((sizes >> 2) & 0x33333);
+	sum = (sum & 0x0f0f0f) + ((sum >> 4) & 0x0f0f0f);
+	sum = sum + (sum >> 8) + (sum >> 16);
+
+	return col + (sum & 0xff);
+}
+
+/* Size fields of up to 9 columns which are all 2 bytes wide */
+#define TABLE_COLUMNS_16BIT 0x15555
+
 /**
  * mono_metadata_decode_row:
  * \param t table to extract information from.
@@ -1143,6 +1165,13 @@ mono_metadata_decode_row (const MonoTableInfo *t, int idx, guint32 *res, int res
 	
 	g_assert (res_size == count);
 
+	/* Small images have only 2 byte indexes */
+	if ((bitfield & ((1 << (count * 2)) - 1)) == (TABLE_COLUMNS_16BIT & ((1 << (count * 2)) - 1))) {
+		for (i = 0; i < count; i++)
+			res [i] = read16 (data + i * 2);
+		return;
+	}
+
 	for (i = 0; i < count; i++) {
 		int n = mono_metadata_table_size (bitfield, i);
 
@@ -1226,20 +1255,13 @@ guint32
 mono_metadata_decode_row_col (const MonoTableInfo *t, int idx, guint col)
 {
 	guint32 bitfield = t->size_bitfield;
-	int i;
 	const char *data;
-	int n;
 	
 	g_assert (idx < t->rows);
 	g_assert (col < mono_metadata_table_count (bitfield));
-	data = t->base + idx * t->row_size;
+	data = t->base + idx * t->row_size + table_column_offset (bitfield, col);
 
-	n = mono_metadata_table_size (bitfield, 0);
-	for (i = 0; i < col; ++i) {
-		data += n;
-		n = mono_metadata_table_size (bitfield, i + 1);
-	}
-	switch (n) {
+	switch (mono_metadata_table_size (bitfield, col)) {
 	case 1:
 		return *data;
 	case 2:
@@ -2726,9 +2748,9 @@ get_image_set (MonoImage **images, int nimages)
 		for (i = 0; i < nimages; ++i)
 			set->images [i] = images [i];
 		set->gclass_cache = mono_conc_hashtable_new_full (mono_generic_class_hash, mono_generic_class_equal, NULL, (GDestroyNotify)free_generic_class);
-		set->ginst_cache = g_hash_table_new_full (mono_metadata_generic_inst_hash, mono_metadata_generic_inst_equal, NULL, (GDestroyNotify)free_generic_inst);
+		set->ginst_cache = mono_conc_hashtable_new_full (mono_metadata_generic_inst_hash, mono_metadata_generic_inst_equal, NULL, (GDestroyNotify)free_generic_inst);
 		set->gmethod_cache = g_hash_table_new_full (inflated_method_hash, inflated_method_equal, NULL, (GDestroyNotify)free_inflated_method);
-		set->gsignature_cache = g_hash_table_new_full (inflated_signature_hash, inflated_signature_equal, NULL, (GDestroyNotify)free_inflated_signature);
+		set->gsignature_cache = mono_conc_hashtable_new_full (inflated_signature_hash, inflated_signature_equal, NULL, (GDestroyNotify)free_inflated_signature);
 
 		set->szarray_cache = g_hash_table_new_full (mono_aligned_addr_hash, NULL, NULL, NULL);
 		set->array_cache = g_hash_table_new_full (mono_aligned_addr_hash, NULL, NULL, NULL);
@@ -2761,9 +2783,9 @@ delete_image_set (MonoImageSet *set)
 	int i;
 
 	mono_conc_hashtable_destroy (set->gclass_cache);
-	g_hash_table_destroy (set->ginst_cache);
+	mono_conc_hashtable_destroy (set->ginst_cache);
 	g_hash_table_destroy (set->gmethod_cache);
-	g_hash_table_destroy (set->gsignature_cache);
+	mono_conc_hashtable_destroy (set->gsignature_cache);
 
 	g_hash_table_destroy (set->szarray_cache);
 	g_hash_table_destroy (set->array_cache);
@@ -2809,10 +2831,16 @@ mono_image_set_alloc (MonoImageSet *set, guint size)
 {
 	gpointer res;
 
+	if (G_LIKELY (set->mempool)) {
+		res = mono_mempool_alloc_thread_cached (set->mempool, size);
+		if (res)
+			return res;
+	}
+
 	mono_image_set_lock (set);
 	if (!set->mempool)
-		set->mempool = mono_mempool_new_size (INITIAL_IMAGE_SET_SIZE);
-	res = mono_mempool_alloc (set->mempool, size);
+		mono_atomic_store_release (&set->mempool, mono_mempool_new_size_arena (INITIAL_IMAGE_SET_SIZE, MONO_JEMALLOC_ARENA_METADATA));
+	res = mono_mempool_alloc_thread_refill (set->mempool, size);
 	mono_image_set_unlock (set);
 
 	return res;
@@ -2823,11 +2851,8 @@ mono_image_set_alloc0 (MonoImageSet *set, guint size)
 {
 	gpointer res;
 
-	mono_image_set_lock (set);
-	if (!set->mempool)
-		set->mempool = mono_mempool_new_size (INITIAL_IMAGE_SET_SIZE);
-	res = mono_mempool_alloc0 (set->mempool, size);
-	mono_image_set_unlock (set);
+	res = mono_image_set_alloc (set, size);
+	memset (res, 0, size);
 
 	return res;
 }
@@ -2837,11 +2862,14 @@ mono_image_set_strdup (MonoImageSet *set, const char *s)
 {
 	char *res;
 
-	mono_image_set_lock (set);
-	if (!set->mempool)
-		set->mempool = mono_mempool_new_size (INITIAL_IMAGE_SET_SIZE);
-	res = mono_mempool_strdup (set->mempool, s);
-	mono_image_set_unlock (set);
+	size_t len;
+
+	if (s == NULL)
+		return NULL;
+
+	len = strlen (s) + 1;
+	res = (char *)mono_image_set_alloc (set, (guint)len);
+	memcpy (res, s, len);
 
 	return res;
 }
@@ -3093,6 +3121,18 @@ inflated_signature_in_image (gpointer key, gpointer value, gpointer data)
 		(sig->context.method_inst && ginst_in_image (sig->context.method_inst, image));
 }
 
+static gboolean
+steal_inflated_signature_in_image (gpointer key, gpointer value, gpointer data)
+{
+	CleanForImageUserData *user_data = (CleanForImageUserData *)data;
+
+	if (!inflated_signature_in_image (key, value, user_data->image))
+		return FALSE;
+
+	user_data->list = g_slist_prepend (user_data->list, key);
+	return TRUE;
+}
+
 static gboolean
 class_in_image (gpointer key, gpointer value, gpointer data)
 {
@@ -3144,7 +3184,7 @@ check_image_sets (MonoImage *image)
 void
 mono_metadata_clean_for_image (MonoImage *image)
 {
-	CleanForImageUserData ginst_data, gclass_data, amods_data;
+	CleanForImageUserData ginst_data, gclass_data, gsig_data, amods_data;
 	GSList *l, *set_list;
 
 	//check_image_sets (image);
@@ -3153,8 +3193,8 @@ mono_metadata_clean_for_image (MonoImage *image)
 	 * The data structures could reference each other so we delete them in two phases.
 	 * This is required because of the hashing functions in gclass/ginst_cache.
 	 */
-	ginst_data.image = gclass_data.image = image;
-	ginst_data.list = gclass_data.list = NULL;
+	ginst_data.image = gclass_data.image = gsig_data.image = image;
+	ginst_data.list = gclass_data.list = gsig_data.list = NULL;
 	amods_data.image = image;
 	amods_data.list = NULL;
 
@@ -3165,9 +3205,9 @@ mono_metadata_clean_for_image (MonoImage *image)
 
 		mono_image_set_lock (set);
 		mono_conc_hashtable_foreach_steal (set->gclass_cache, steal_gclass_in_image, &gclass_data);
-		g_hash_table_foreach_steal (set->ginst_cache, steal_ginst_in_image, &ginst_data);
+		mono_conc_hashtable_foreach_steal (set->ginst_cache, steal_ginst_in_image, &ginst_data);
 		g_hash_table_foreach_remove (set->gmethod_cache, inflated_method_in_image, image);
-		g_hash_table_foreach_remove (set->gsignature_cache, inflated_signature_in_image, image);
+		mono_conc_hashtable_foreach_steal (set->gsignature_cache, steal_inflated_signature_in_image, &gsig_data);
 
 		g_hash_table_foreach_steal (set->szarray_cache, class_in_image, image);
 		g_hash_table_foreach_steal (set->array_cache, class_in_image, image);
@@ -3184,10 +3224,13 @@ mono_metadata_clean_for_image (MonoImage *image)
 		free_generic_inst ((MonoGenericInst *)l->data);
 	for (l = gclass_data.list; l; l = l->next)
 		free_generic_class ((MonoGenericClass *)l->data);
+	for (l = gsig_data.list; l; l = l->next)
+		free_inflated_signature ((MonoInflatedMethodSignature *)l->data);
 	for (l = amods_data.list; l; l = l->next)
 		free_aggregate_modifiers ((MonoAggregateModContainer *)l->data);
 	g_slist_free (ginst_data.list);
 	g_slist_free (gclass_data.list);
+	g_slist_free (gsig_data.list);
 	/* delete_image_set () modifies the lists so make a copy */
 	set_list = g_slist_copy (image->image_sets);
 	for (l = set_list; l; l = l->next) {
@@ -3271,15 +3314,19 @@ mono_metadata_get_inflated_signature (MonoMethodSignature *sig, MonoGenericConte
 
 	collect_data_free (&data);
 
+	res = (MonoInflatedMethodSignature *)mono_conc_hashtable_lookup (set->gsignature_cache, &helper);
+	if (res)
+		return res->sig;
+
 	mono_image_set_lock (set);
 
-	res = (MonoInflatedMethodSignature *)g_hash_table_lookup (set->gsignature_cache, &helper);
+	res = (MonoInflatedMethodSignature *)mono_conc_hashtable_lookup (set->gsignature_cache, &helper);
 	if (!res) {
 		res = g_new0 (MonoInflatedMethodSignature, 1);
 		res->sig = sig;
 		res->context.class_inst = context->class_inst;
 		res->context.method_inst = context->method_inst;
-		g_hash_table_insert (set->gsignature_cache, res, res);
+		mono_conc_hashtable_insert (set->gsignature_cache, res, res);
 	}
 
 	mono_image_set_unlock (set);
@@ -3406,9 +3453,14 @@ mono_metadata_get_canonical_generic_inst (MonoGenericInst *candidate)
 
 	collect_data_free (&data);
 
+	/* Instantiations are looked up far more often than created, so only creation takes the lock */
+	MonoGenericInst *ginst = (MonoGenericInst *)mono_conc_hashtable_lookup (set->ginst_cache, candidate);
+	if (ginst)
+		return ginst;
+
 	mono_image_set_lock (set);
 
-	MonoGenericInst *ginst = (MonoGenericInst *)g_hash_table_lookup (set->ginst_cache, candidate);
+	ginst = (MonoGenericInst *)mono_conc_hashtable_lookup (set->ginst_cache, candidate);
 	if (!ginst) {
 		int size = MONO_SIZEOF_GENERIC_INST + type_argc * sizeof (MonoType *);
 		ginst = (MonoGenericInst *)mono_image_set_alloc0 (set, size);
@@ -3421,7 +3473,7 @@ mono_metadata_get_canonical_generic_inst (MonoGenericInst *candidate)
 		for (int i = 0; i < type_argc; ++i)
 			ginst->type_argv [i] = mono_metadata_type_dup (NULL, candidate->type_argv [i]);
 
-		g_hash_table_insert (set->ginst_cache, ginst, ginst);
+		mono_conc_hashtable_insert (set->ginst_cache, ginst, ginst);
 	}
 
 	mono_image_set_unlock (set);
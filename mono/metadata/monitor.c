@@ -33,6 +33,9 @@
 #include <mono/utils/atomic.h>
 #include <mono/utils/w32api.h>
 #include <mono/utils/mono-os-wait.h>
+#include <mono/utils/mono-proclib.h>
+#include <mono/utils/mono-tls.h>
+#include <mono/utils/hazard-pointer.h>
 #include "external-only.h"
 
 /*
@@ -88,6 +91,51 @@ static MonoThreadsSync *monitor_freelist;
 static MonitorArray *monitor_allocated;
 static int array_size = 16;
 
+/*
+ * Before a contended thread registers as a waiter on entry_cond, it spins for a while
+ * on the monitor: for short critical sections the owner usually releases the lock
+ * sooner than a sleep/wakeup round trip would take. Each monitor has its own spin
+ * budget, doubled when spinning acquires the lock and halved when it doesn't. Flat
+ * locks are likewise spun on for a little while before they get inflated.
+ *
+ * MONO_MONITOR_SPIN=<iterations> sets the maximum budget, 0 disables spinning.
+ */
+#define MONITOR_SPIN_MIN 16
+#define MONITOR_SPIN_DEFAULT_MAX 1024
+#define MONITOR_SPIN_FLAT_MAX 128
+#define MONITOR_SPIN_YIELD_EVERY 64
+static gint32 monitor_spin_max;
+
+/*
+ * Deflation: once the GC ran, the next time the freelist runs dry the inflated locks
+ * which are neither owned nor waited on are turned back into flat ones (or thin hashes),
+ * and their records are recycled. A record being deflated first gets
+ * MONITOR_OWNER_DEFLATED as its owner, which makes the threads still holding a pointer
+ * to it start over from the lock word. Those threads protect it with a hazard pointer
+ * (MONITOR_HAZARD_INDEX) so it isn't recycled under them.
+ *
+ * MONO_MONITOR_DEFLATE=0 disables deflation.
+ */
+#define MONITOR_OWNER_DEFLATED OWNER_MASK
+#define MONITOR_HAZARD_INDEX 2
+/* Returned by mon_try_enter_inflated () when the lock was deflated under it */
+#define MONITOR_ENTER_DEFLATED (-2)
+static gboolean monitor_deflate_enabled;
+static int monitor_deflate_gc_count;
+
+/*
+ * Each thread keeps a few free records, so inflating a lock usually doesn't need
+ * monitor_mutex. The records which are neither in use nor on the freelist, because
+ * they are cached or waiting to be recycled, have MONITOR_DATA_UNUSED as their data.
+ */
+#define MONITOR_CACHE_SIZE 16
+#define MONITOR_DATA_UNUSED ((void *)(gsize)-1)
+typedef struct {
+	int count;
+	MonoThreadsSync *records [MONITOR_CACHE_SIZE];
+} MonitorCache;
+static MonoNativeTlsKey monitor_cache_key;
+
 /* MonoThreadsSync status helpers */
 
 static inline guint32
@@ -160,17 +208,35 @@ lock_word_set_has_hash (LockWord lw)
 	return nlw;
 }
 
+#ifdef LOCK_WORD_FLAT_HASH
+/* The hash bits of a flat lock word, see monitor.h */
+static inline gsize
+lock_word_get_hash_bits (LockWord lw)
+{
+	return lw.lock_word & ((~(gsize)0 << LOCK_WORD_HASH_SHIFT) | LOCK_WORD_HAS_HASH);
+}
+#endif
+
 static inline gboolean
 lock_word_is_free (LockWord lw)
 {
+#ifdef LOCK_WORD_FLAT_HASH
+	/* A thin hash is a free flat lock */
+	return !(lw.lock_word ^ lock_word_get_hash_bits (lw));
+#else
 	return !lw.lock_word;
+#endif
 }
 
 static inline gboolean
 lock_word_is_flat (LockWord lw)
 {
 	/* Return whether the lock is flat or free */
+#ifdef LOCK_WORD_FLAT_HASH
+	return !(lw.lock_word & LOCK_WORD_INFLATED);
+#else
 	return (lw.lock_word & LOCK_WORD_STATUS_MASK) == LOCK_WORD_FLAT;
+#endif
 }
 
 static inline gint32
@@ -217,7 +283,11 @@ lock_word_decrement_nest (LockWord lw)
 static inline gint32
 lock_word_get_owner (LockWord lw)
 {
+#ifdef LOCK_WORD_FLAT_HASH
+	return (lw.lock_word >> LOCK_WORD_OWNER_SHIFT) & LOCK_WORD_OWNER_MASK;
+#else
 	return lw.lock_word >> LOCK_WORD_OWNER_SHIFT;
+#endif
 }
 
 static inline LockWord
@@ -247,10 +317,71 @@ lock_word_new_flat (gint32 owner)
 	return lw;
 }
 
+/*
+ * Return the flat lock word owned once by @owner (or free if it is 0) that keeps
+ * the hash of @lw, which must be flat.
+ */
+static inline LockWord
+lock_word_new_flat_from (LockWord lw, gint32 owner)
+{
+	LockWord nlw = lock_word_new_flat (owner);
+#ifdef LOCK_WORD_FLAT_HASH
+	nlw.lock_word |= lock_word_get_hash_bits (lw);
+#endif
+	return nlw;
+}
+
 void
 mono_monitor_init (void)
 {
+	char *env;
+
 	mono_os_mutex_init_recursive (&monitor_mutex);
+
+	/* Spinning is pointless if the owner can't run meanwhile */
+	monitor_spin_max = mono_cpu_count () > 1 ? MONITOR_SPIN_DEFAULT_MAX : 0;
+
+	env = g_getenv ("MONO_MONITOR_SPIN");
+	if (env) {
+		monitor_spin_max = MAX (atoi (env), 0);
+		g_free (env);
+	}
+
+	monitor_deflate_enabled = TRUE;
+	env = g_getenv ("MONO_MONITOR_DEFLATE");
+	if (env) {
+		monitor_deflate_enabled = atoi (env) != 0;
+		g_free (env);
+	}
+
+	mono_native_tls_alloc (&monitor_cache_key, NULL);
+}
+
+/*
+ * mono_monitor_thread_detach:
+ *
+ *   Return the records cached by the current thread to the freelist.
+ */
+void
+mono_monitor_thread_detach (void)
+{
+	MonitorCache *cache;
+
+	cache = (MonitorCache *)mono_native_tls_get_value (monitor_cache_key);
+	if (!cache)
+		return;
+
+	mono_monitor_allocator_lock ();
+	while (cache->count > 0) {
+		MonoThreadsSync *mon = cache->records [--cache->count];
+
+		mon->data = monitor_freelist;
+		monitor_freelist = mon;
+	}
+	mono_monitor_allocator_unlock ();
+
+	mono_native_tls_set_value (monitor_cache_key, NULL);
+	g_free (cache);
 }
  
 void
@@ -317,7 +448,7 @@ void
 mono_locks_dump (gboolean include_untaken)
 {
 	int i;
-	int used = 0, on_freelist = 0, to_recycle = 0, total = 0, num_arrays = 0;
+	int used = 0, on_freelist = 0, to_recycle = 0, unused = 0, total = 0, num_arrays = 0;
 	MonoThreadsSync *mon;
 	MonitorArray *marray;
 	for (mon = monitor_freelist; mon; mon = (MonoThreadsSync *)mon->data)
@@ -330,6 +461,8 @@ mono_locks_dump (gboolean include_untaken)
 			if (mon->data == NULL) {
 				if (i < marray->num_monitors - 1)
 					to_recycle++;
+			} else if (mon->data == MONITOR_DATA_UNUSED) {
+				unused++;
 			} else {
 				if (!monitor_is_on_freelist ((MonoThreadsSync *)mon->data)) {
 					MonoObject *holder = (MonoObject *)mono_gchandle_get_target_internal ((guint32)(gsize)mon->data);
@@ -346,8 +479,8 @@ mono_locks_dump (gboolean include_untaken)
 			}
 		}
 	}
-	g_print ("Total locks (in %d array(s)): %d, used: %d, on freelist: %d, to recycle: %d\n",
-		num_arrays, total, used, on_freelist, to_recycle);
+	g_print ("Total locks (in %d array(s)): %d, used: %d, on freelist: %d, to recycle: %d, cached or deflated: %d\n",
+		num_arrays, total, used, on_freelist, to_recycle, unused);
 }
 
 /* LOCKING: this is called with monitor_mutex held */
@@ -372,7 +505,7 @@ mon_finalize (MonoThreadsSync *mon)
 	 */
 	g_assert (mon->wait_list == NULL);
 
-	/* owner and nest are set in mon_new, no need to zero them out */
+	/* owner and nest are set in mon_init, no need to zero them out */
 
 	mon->data = monitor_freelist;
 	monitor_freelist = mon;
@@ -381,20 +514,100 @@ mon_finalize (MonoThreadsSync *mon)
 #endif
 }
 
-/* LOCKING: this is called with monitor_mutex held */
+/* Hazardous free function of the deflated records, monitor_mutex is recursive so this can run under it */
+static void
+mon_deflated_free (gpointer p)
+{
+	mono_monitor_allocator_lock ();
+	mon_finalize ((MonoThreadsSync *)p);
+	mono_monitor_allocator_unlock ();
+}
+
+/*
+ * mon_try_deflate:
+ *
+ *   Turn the inflated lock @mon of @obj back into a flat one, if nobody owns or waits
+ * for it. @mon is recycled once no thread is using it anymore.
+ * LOCKING: this is called with monitor_mutex held
+ */
+static gboolean
+mon_try_deflate (MonoObject *obj, MonoThreadsSync *mon)
+{
+	guint32 old_status, deflated_status;
+	LockWord lw, nlw;
+
+	old_status = mon->status;
+	if (mon_status_get_owner (old_status) != 0 || mon_status_get_entry_count (old_status) != 0)
+		return FALSE;
+
+	/* From here on nobody can take the lock or register as a waiter through @mon */
+	deflated_status = mon_status_set_owner (old_status, MONITOR_OWNER_DEFLATED);
+	if (mono_atomic_cas_i32 ((gint32*)&mon->status, deflated_status, old_status) != old_status)
+		return FALSE;
+
+	/* Threads in Monitor.Wait () released the lock, but will take it again */
+	if (mon->wait_list) {
+		mono_atomic_cas_i32 ((gint32*)&mon->status, old_status, deflated_status);
+		return FALSE;
+	}
+
+	/* A hash code can still be installed concurrently */
+	do {
+		lw.sync = (MonoThreadsSync *)mono_atomic_load_ptr ((gpointer*)&obj->synchronisation);
+		g_assert (lock_word_is_inflated (lw) && lock_word_get_inflated_lock (lw) == mon);
+#ifdef HAVE_MOVING_COLLECTOR
+		if (lock_word_has_hash (lw))
+			nlw = lock_word_new_thin_hash (mon->hash_code);
+		else
+#endif
+			nlw.sync = NULL;
+	} while (mono_atomic_cas_ptr ((gpointer*)&obj->synchronisation, nlw.sync, lw.sync) != lw.sync);
+
+	LOCK_DEBUG (g_message ("%s: Deflated lock %p of object %p", __func__, mon, obj));
+
+	mono_gchandle_free_internal ((guint32)(gsize)mon->data);
+	mon->data = MONITOR_DATA_UNUSED;
+
+	mono_thread_hazardous_try_free (mon, mon_deflated_free);
+	return TRUE;
+}
+
+/*
+ * mon_take_free:
+ *
+ *   Take a record from the freelist, recycling the ones of collected objects,
+ * deflating idle locks, or allocating more records if it is empty.
+ * LOCKING: this is called with monitor_mutex held
+ */
 static MonoThreadsSync *
-mon_new (gsize id)
+mon_take_free (void)
 {
 	MonoThreadsSync *new_;
 
 	if (!monitor_freelist) {
 		MonitorArray *marray;
 		int i;
+		gboolean deflate = FALSE;
+
+		if (monitor_deflate_enabled) {
+			int gc_count = mono_gc_collection_count (0);
+
+			/* Deflate at most once per GC, the locks are likely to stay idle past it */
+			deflate = gc_count != monitor_deflate_gc_count;
+			monitor_deflate_gc_count = gc_count;
+		}
+
 		/* see if any sync block has been collected */
 		new_ = NULL;
 		for (marray = monitor_allocated; marray; marray = marray->next) {
 			for (i = 0; i < marray->num_monitors; ++i) {
-				if (mono_gchandle_get_target_internal ((guint32)(gsize)marray->monitors [i].data) == NULL) {
+				MonoObject *holder;
+
+				if (marray->monitors [i].data == MONITOR_DATA_UNUSED)
+					continue;
+
+				holder = (MonoObject *)mono_gchandle_get_target_internal ((guint32)(gsize)marray->monitors [i].data);
+				if (holder == NULL) {
 					new_ = &marray->monitors [i];
 					if (new_->wait_list) {
 						/* Orphaned events left by aborted threads */
@@ -407,10 +620,12 @@ mon_new (gsize id)
 					mono_gchandle_free_internal ((guint32)(gsize)new_->data);
 					new_->data = monitor_freelist;
 					monitor_freelist = new_;
+				} else if (deflate) {
+					mon_try_deflate (holder, &marray->monitors [i]);
 				}
 			}
 			/* small perf tweak to avoid scanning all the blocks */
-			if (new_)
+			if (monitor_freelist)
 				break;
 		}
 		/* need to allocate a new array of monitors */
@@ -442,27 +657,56 @@ mon_new (gsize id)
 
 	new_ = monitor_freelist;
 	monitor_freelist = (MonoThreadsSync *)new_->data;
+	new_->data = MONITOR_DATA_UNUSED;
 
+	return new_;
+}
+
+static void
+mon_init (MonoThreadsSync *new_, gsize id)
+{
 	new_->status = mon_status_set_owner (0, id);
 	new_->status = mon_status_init_entry_count (new_->status);
 	new_->nest = 1;
 	new_->data = NULL;
+	new_->spin_budget = MIN (MONITOR_SPIN_MIN, monitor_spin_max);
 	
 #ifndef DISABLE_PERFCOUNTERS
 	mono_atomic_inc_i32 (&mono_perfcounters->gc_sync_blocks);
 #endif
-	return new_;
+}
+
+static MonitorCache*
+monitor_cache_get (void)
+{
+	MonitorCache *cache;
+
+	cache = (MonitorCache *)mono_native_tls_get_value (monitor_cache_key);
+	if (!cache) {
+		cache = g_new0 (MonitorCache, 1);
+		mono_native_tls_set_value (monitor_cache_key, cache);
+	}
+	return cache;
 }
 
 static MonoThreadsSync*
 alloc_mon (MonoObject *obj, gint32 id)
 {
+	MonitorCache *cache;
 	MonoThreadsSync *mon;
 
-	mono_monitor_allocator_lock ();
-	mon = mon_new (id);
+	cache = monitor_cache_get ();
+	if (cache->count == 0) {
+		/* Refill half of the cache, so discard_mon () has room too */
+		mono_monitor_allocator_lock ();
+		while (cache->count < MONITOR_CACHE_SIZE / 2)
+			cache->records [cache->count++] = mon_take_free ();
+		mono_monitor_allocator_unlock ();
+	}
+
+	mon = cache->records [--cache->count];
+	mon_init (mon, id);
 	mon->data = (void *)(size_t)mono_gchandle_new_weakref_internal (obj, TRUE);
-	mono_monitor_allocator_unlock ();
 
 	return mon;
 }
@@ -470,8 +714,21 @@ alloc_mon (MonoObject *obj, gint32 id)
 static void
 discard_mon (MonoThreadsSync *mon)
 {
-	mono_monitor_allocator_lock ();
+	MonitorCache *cache = monitor_cache_get ();
+
 	mono_gchandle_free_internal ((guint32)(gsize)mon->data);
+
+	/* @mon was never published, so it can go straight back to the cache */
+	if (cache->count < MONITOR_CACHE_SIZE) {
+		mon->data = MONITOR_DATA_UNUSED;
+		cache->records [cache->count++] = mon;
+#ifndef DISABLE_PERFCOUNTERS
+		mono_atomic_dec_i32 (&mono_perfcounters->gc_sync_blocks);
+#endif
+		return;
+	}
+
+	mono_monitor_allocator_lock ();
 	mon_finalize (mon);
 	mono_monitor_allocator_unlock ();
 }
@@ -497,6 +754,12 @@ mono_monitor_inflate_owned (MonoObject *obj, int id)
 	mon->nest = nest;
 
 	nlw = lock_word_new_inflated (mon);
+#ifdef HAVE_MOVING_COLLECTOR
+	if (lock_word_has_hash (old_lw)) {
+		mon->hash_code = lock_word_get_hash (old_lw);
+		nlw = lock_word_set_has_hash (nlw);
+	}
+#endif
 
 	mono_memory_write_barrier ();
 	tmp_lw.sync = (MonoThreadsSync *)mono_atomic_cas_ptr ((gpointer*)&obj->synchronisation, nlw.sync, old_lw.sync);
@@ -516,8 +779,6 @@ mono_monitor_inflate (MonoObject *obj)
 
 	mon = alloc_mon (obj, 0);
 
-	nlw = lock_word_new_inflated (mon);
-
 	old_lw.sync = obj->synchronisation;
 
 	for (;;) {
@@ -526,14 +787,16 @@ mono_monitor_inflate (MonoObject *obj)
 		if (lock_word_is_inflated (old_lw)) {
 			break;
 		}
+
+		nlw = lock_word_new_inflated (mon);
 #ifdef HAVE_MOVING_COLLECTOR
-		 else if (lock_word_has_hash (old_lw)) {
+		if (lock_word_has_hash (old_lw)) {
 			mon->hash_code = lock_word_get_hash (old_lw);
-			mon->status = mon_status_set_owner (mon->status, 0);
 			nlw = lock_word_set_has_hash (nlw);
 		}
 #endif
-		else if (lock_word_is_free (old_lw)) {
+
+		if (lock_word_is_free (old_lw)) {
 			mon->status = mon_status_set_owner (mon->status, 0);
 			mon->nest = 1;
 		} else {
@@ -555,6 +818,48 @@ mono_monitor_inflate (MonoObject *obj)
 	discard_mon (mon);
 }
 
+/*
+ * mon_get_protected:
+ *
+ *   Return the inflated lock of @obj protected by the MONITOR_HAZARD_INDEX hazard
+ * pointer of @hp, so it isn't recycled by deflation while in use, or NULL if the lock
+ * isn't inflated. @lw is set to the lock word it was read from.
+ */
+static MonoThreadsSync*
+mon_get_protected (MonoObject *obj, MonoThreadHazardPointers *hp, LockWord *lw)
+{
+	MonoThreadsSync *mon;
+	LockWord check_lw;
+
+	for (;;) {
+		lw->sync = (MonoThreadsSync *)mono_atomic_load_ptr ((gpointer*)&obj->synchronisation);
+		if (!lock_word_is_inflated (*lw))
+			return NULL;
+
+		mon = lock_word_get_inflated_lock (*lw);
+		mono_hazard_pointer_set (hp, MONITOR_HAZARD_INDEX, mon);
+		mono_memory_barrier ();
+
+		check_lw.sync = (MonoThreadsSync *)mono_atomic_load_ptr ((gpointer*)&obj->synchronisation);
+		if (lock_word_is_inflated (check_lw) && lock_word_get_inflated_lock (check_lw) == mon)
+			return mon;
+
+		mono_hazard_pointer_clear (hp, MONITOR_HAZARD_INDEX);
+	}
+}
+
+/*
+ * Records are never freed, only recycled, so reading one doesn't need a hazard pointer:
+ * if the lock word of @obj is still @lw after the read, the record still belonged to
+ * @obj when it was read.
+ */
+static inline gboolean
+mon_lock_word_unchanged (MonoObject *obj, LockWord lw)
+{
+	mono_memory_read_barrier ();
+	return obj->synchronisation == lw.sync;
+}
+
 #define MONO_OBJECT_ALIGNMENT_SHIFT	3
 
 int
@@ -565,13 +870,17 @@ mono_object_hash_internal (MonoObject* obj)
 	unsigned int hash;
 	if (!obj)
 		return 0;
+retry:
 	lw.sync = obj->synchronisation;
 
 	LOCK_DEBUG (g_message("%s: (%d) Get hash for object %p; LW = %p", __func__, mono_thread_info_get_small_id (), obj, obj->synchronisation));
 
 	if (lock_word_has_hash (lw)) {
 		if (lock_word_is_inflated (lw)) {
-			return lock_word_get_inflated_lock (lw)->hash_code;
+			hash = lock_word_get_inflated_lock (lw)->hash_code;
+			if (!mon_lock_word_unchanged (obj, lw))
+				goto retry;
+			return hash;
 		} else {
 			return lock_word_get_hash (lw);
 		}
@@ -588,6 +897,17 @@ mono_object_hash_internal (MonoObject* obj)
 	/* clear the top bits as they can be discarded */
 	hash &= ~(LOCK_WORD_STATUS_MASK << (32 - LOCK_WORD_STATUS_BITS));
 #endif
+#ifdef LOCK_WORD_FLAT_HASH
+	if (lock_word_is_flat (lw)) {
+		/* The hash goes next to the flat lock, whoever owns it */
+		LockWord nlw;
+
+		nlw.lock_word = lw.lock_word | lock_word_new_thin_hash (hash).lock_word;
+		if (mono_atomic_cas_ptr ((gpointer*)&obj->synchronisation, nlw.sync, lw.sync) != lw.sync)
+			goto retry;
+		return hash;
+	}
+#else
 	if (lock_word_is_free (lw)) {
 		LockWord old_lw;
 		lw = lock_word_new_thin_hash (hash);
@@ -612,12 +932,29 @@ mono_object_hash_internal (MonoObject* obj)
 			mono_monitor_inflate (obj);
 		lw.sync = obj->synchronisation;
 	}
+#endif
 
-	/* At this point, the lock is inflated */
-	lock_word_get_inflated_lock (lw)->hash_code = hash;
-	lw = lock_word_set_has_hash (lw);
-	mono_memory_write_barrier ();
-	obj->synchronisation = lw.sync;
+	/* At this point, the lock is inflated, unless it got deflated meanwhile */
+	{
+		MonoThreadHazardPointers *hp = mono_hazard_pointer_get ();
+		MonoThreadsSync *mon;
+		LockWord hash_lw;
+
+		mon = mon_get_protected (obj, hp, &lw);
+		if (!mon)
+			goto retry;
+
+		mon->hash_code = hash;
+		hash_lw = lock_word_set_has_hash (lw);
+		mono_memory_write_barrier ();
+		/* Deflation resets the lock word, in which case it has to be hashed again */
+		if (mono_atomic_cas_ptr ((gpointer*)&obj->synchronisation, hash_lw.sync, lw.sync) != lw.sync) {
+			mono_hazard_pointer_clear (hp, MONITOR_HAZARD_INDEX);
+			goto retry;
+		}
+
+		mono_hazard_pointer_clear (hp, MONITOR_HAZARD_INDEX);
+	}
 	return hash;
 #else
 /*
@@ -647,6 +984,7 @@ mono_monitor_ensure_owned (LockWord lw, guint32 id)
 		if (lock_word_get_owner (lw) == id)
 			return TRUE;
 	} else if (lock_word_is_inflated (lw)) {
+		/* A lock we own can't be deflated, while a record that was recycled meanwhile can't be owned by us */
 		if (mon_status_get_owner (lock_word_get_inflated_lock (lw)->status) == id)
 			return TRUE;
 	}
@@ -675,9 +1013,17 @@ mono_monitor_exit_inflated (MonoObject *obj)
 	if (nest == 0) {
 		guint32 new_status, old_status, tmp_status;
 
+		MonoThreadHazardPointers *hp = NULL;
+
 		old_status = mon->status;
 
 		for (;;) {
+			/* Once released, @mon could be deflated before the waiters are signalled */
+			if (mon_status_have_waiters (old_status) && !hp) {
+				hp = mono_hazard_pointer_get ();
+				mono_hazard_pointer_set (hp, MONITOR_HAZARD_INDEX, mon);
+			}
+
 			new_status = mon_status_set_owner (old_status, 0);
 			tmp_status = mono_atomic_cas_i32 ((gint32*)&mon->status, new_status, old_status);
 			if (tmp_status == old_status) {
@@ -690,6 +1036,9 @@ mono_monitor_exit_inflated (MonoObject *obj)
 			}
 			old_status = tmp_status;
 		}
+
+		if (hp)
+			mono_hazard_pointer_clear (hp, MONITOR_HAZARD_INDEX);
 		LOCK_DEBUG (g_message ("%s: (%d) Object %p is now unlocked", __func__, mono_thread_info_get_small_id (), obj));
 	
 		/* object is now unlocked, leave nest==1 so we don't
@@ -712,7 +1061,7 @@ mono_monitor_exit_flat (MonoObject *obj, LockWord old_lw)
 	if (G_UNLIKELY (lock_word_is_nested (old_lw)))
 		new_lw = lock_word_decrement_nest (old_lw);
 	else
-		new_lw.lock_word = 0;
+		new_lw = lock_word_new_flat_from (old_lw, 0);
 
 	tmp_lw.sync = (MonoThreadsSync *)mono_atomic_cas_ptr ((gpointer*)&obj->synchronisation, new_lw.sync, old_lw.sync);
 	if (old_lw.sync != tmp_lw.sync) {
@@ -730,8 +1079,8 @@ mon_add_entry_count (MonoThreadsSync *mon, int val)
 
 	old_status = mon->status;
 	for (;;) {
-		/* The lock is free, we should retry */
-		if (val > 0 && mon_status_get_owner (old_status) == 0)
+		/* The lock is free or being deflated, we should retry */
+		if (val > 0 && (mon_status_get_owner (old_status) == 0 || mon_status_get_owner (old_status) == MONITOR_OWNER_DEFLATED))
 			return FALSE;
 		new_status = mon_status_add_entry_count (old_status, val);
 		tmp_status = mono_atomic_cas_i32 ((gint32*)&mon->status, new_status, old_status);
@@ -744,6 +1093,97 @@ mon_add_entry_count (MonoThreadsSync *mon, int val)
 	return TRUE;
 }
 
+static inline void
+mon_spin_pause (void)
+{
+#if defined(HOST_WIN32)
+	YieldProcessor ();
+#elif defined(__i386__) || defined(__x86_64__)
+	__asm__ __volatile__ ("pause" ::: "memory");
+#elif defined(__aarch64__)
+	__asm__ __volatile__ ("yield" ::: "memory");
+#endif
+}
+
+/*
+ * mon_spin:
+ *
+ *   Spin for up to the budget of @mon, trying to acquire it as soon as it is released.
+ * Returns TRUE if it was acquired.
+ */
+static gboolean
+mon_spin (MonoThreadsSync *mon, guint32 id)
+{
+	guint32 old_status, new_status;
+	gint32 budget, i;
+	gboolean acquired = FALSE;
+
+	budget = mono_atomic_load_i32 (&mon->spin_budget);
+	if (budget <= 0)
+		return FALSE;
+
+	for (i = 0; i < budget; ++i) {
+		old_status = (guint32)mono_atomic_load_i32 ((gint32*)&mon->status);
+		if (mon_status_get_owner (old_status) == MONITOR_OWNER_DEFLATED)
+			break;
+		if (mon_status_get_owner (old_status) == 0) {
+			new_status = mon_status_set_owner (old_status, id);
+			if (mono_atomic_cas_i32 ((gint32*)&mon->status, new_status, old_status) == old_status) {
+				acquired = TRUE;
+				break;
+			}
+		}
+
+		if ((i + 1) % MONITOR_SPIN_YIELD_EVERY == 0)
+			mono_thread_info_yield ();
+		else
+			mon_spin_pause ();
+	}
+
+	if (acquired)
+		budget = MIN (budget * 2, monitor_spin_max);
+	else
+		budget = MAX (budget / 2, MIN (MONITOR_SPIN_MIN, monitor_spin_max));
+	mono_atomic_store_i32 (&mon->spin_budget, budget);
+
+	return acquired;
+}
+
+/*
+ * mono_monitor_spin_flat:
+ *
+ *   Spin for a little while on the flat lock of @obj, which is owned by another thread,
+ * trying to acquire it as soon as it is released, so it doesn't have to be inflated.
+ * Returns TRUE if it was acquired.
+ */
+static gboolean
+mono_monitor_spin_flat (MonoObject *obj, gint32 id)
+{
+	LockWord lw, nlw;
+	gint32 i, budget;
+
+	budget = MIN (monitor_spin_max, MONITOR_SPIN_FLAT_MAX);
+
+	for (i = 0; i < budget; ++i) {
+		lw.sync = (MonoThreadsSync *)mono_atomic_load_ptr ((gpointer*)&obj->synchronisation);
+		if (lock_word_is_free (lw)) {
+			nlw = lock_word_new_flat_from (lw, id);
+			if (mono_atomic_cas_ptr ((gpointer*)&obj->synchronisation, nlw.sync, lw.sync) == lw.sync)
+				return TRUE;
+		} else if (!lock_word_is_flat (lw)) {
+			/* Inflated or hashed meanwhile, it is up to the caller now */
+			return FALSE;
+		}
+
+		if ((i + 1) % MONITOR_SPIN_YIELD_EVERY == 0)
+			mono_thread_info_yield ();
+		else
+			mon_spin_pause ();
+	}
+
+	return FALSE;
+}
+
 static void
 mon_init_cond_var (MonoThreadsSync *mon)
 {
@@ -779,36 +1219,25 @@ signal_monitor (gpointer mon_untyped)
 	mono_coop_mutex_unlock (mon->entry_mutex);
 }
 
-/* If allow_interruption==TRUE, the method will be interrupted if abort or suspend
- * is requested. In this case it returns -1.
- */ 
-static inline gint32 
-mono_monitor_try_enter_inflated (MonoObject *obj, guint32 ms, gboolean allow_interruption, guint32 id)
+/* Same as mono_monitor_try_enter_inflated, for the lock @mon of @obj. Returns
+ * MONITOR_ENTER_DEFLATED if @mon is being deflated.
+ */
+static inline gint32
+mon_try_enter_inflated (MonoObject *obj, MonoThreadsSync *mon, guint32 ms, gboolean allow_interruption, guint32 id)
 {
-	LockWord lw;
-	MonoThreadsSync *mon;
 	gint64 then = 0, now, delta;
 	guint32 waitms;
 	guint32 new_status, old_status, tmp_status;
 	MonoInternalThread *thread;
 	gboolean interrupted, timedout;
 
-	LOCK_DEBUG (g_message("%s: (%d) Trying to lock object %p (%d ms)", __func__, id, obj, ms));
-
-	if (G_UNLIKELY (!obj)) {
-		ERROR_DECL (error);
-		mono_error_set_argument_null (error, "obj", "");
-		mono_error_set_pending_exception (error);
-		return FALSE;
-	}
-
-	lw.sync = obj->synchronisation;
-	mon = lock_word_get_inflated_lock (lw);
 retry:
 	/* This case differs from Dice's case 3 because we don't
-	 * deflate locks or cache unused lock records
+	 * cache unused lock records
 	 */
 	old_status = mon->status;
+	if (G_UNLIKELY (mon_status_get_owner (old_status) == MONITOR_OWNER_DEFLATED))
+		return MONITOR_ENTER_DEFLATED;
 	if (G_LIKELY (mon_status_get_owner (old_status) == 0)) {
 		/* Try to install our ID in the owner field, nest
 		* should have been left at 1 by the previous unlock
@@ -849,6 +1278,12 @@ retry:
 
 	/* Make sure the sync primitives are created */
 	mon_init_cond_var (mon);
+
+	if (mon_spin (mon, id)) {
+		g_assert (mon->nest == 1);
+		MONO_PROFILER_RAISE (monitor_acquired, (obj));
+		return 1;
+	}
 retry_contended:
 	/* a small amount of duplicated code, but it allows us to insert the profiler
 	 * callbacks without impacting the fast path: from here on we don't need to go back to the
@@ -856,9 +1291,11 @@ retry_contended:
 	 * header.
 	 */
 	/* This case differs from Dice's case 3 because we don't
-	 * deflate locks or cache unused lock records
+	 * cache unused lock records
 	 */
 	old_status = mon->status;
+	if (G_UNLIKELY (mon_status_get_owner (old_status) == MONITOR_OWNER_DEFLATED))
+		return MONITOR_ENTER_DEFLATED;
 	if (G_LIKELY (mon_status_get_owner (old_status) == 0)) {
 		/* Try to install our ID in the owner field, nest
 		* should have been left at 1 by the previous unlock
@@ -965,6 +1402,45 @@ retry_contended:
 	}
 }
 
+static inline gint32
+mono_monitor_try_enter_internal (MonoObject *obj, guint32 ms, gboolean allow_interruption);
+
+/* If allow_interruption==TRUE, the method will be interrupted if abort or suspend
+ * is requested. In this case it returns -1.
+ */
+static gint32
+mono_monitor_try_enter_inflated (MonoObject *obj, guint32 ms, gboolean allow_interruption, guint32 id)
+{
+	MonoThreadHazardPointers *hp;
+	MonoThreadsSync *mon;
+	LockWord lw;
+	gint32 res;
+
+	LOCK_DEBUG (g_message("%s: (%d) Trying to lock object %p (%d ms)", __func__, id, obj, ms));
+
+	if (G_UNLIKELY (!obj)) {
+		ERROR_DECL (error);
+		mono_error_set_argument_null (error, "obj", "");
+		mono_error_set_pending_exception (error);
+		return FALSE;
+	}
+
+	hp = mono_hazard_pointer_get ();
+	mon = mon_get_protected (obj, hp, &lw);
+	if (mon) {
+		res = mon_try_enter_inflated (obj, mon, ms, allow_interruption, id);
+		mono_hazard_pointer_clear (hp, MONITOR_HAZARD_INDEX);
+		if (res != MONITOR_ENTER_DEFLATED)
+			return res;
+
+		/* Give the deflating thread a chance to reset the lock word */
+		mono_thread_info_yield ();
+	}
+
+	/* The lock was deflated meanwhile, start over */
+	return mono_monitor_try_enter_internal (obj, ms, allow_interruption);
+}
+
 /*
  * If allow_interruption == TRUE, the method will be interrupted if abort or suspend
  * is requested. In this case it returns -1.
@@ -980,8 +1456,8 @@ mono_monitor_try_enter_internal (MonoObject *obj, guint32 ms, gboolean allow_int
 	lw.sync = obj->synchronisation;
 
 	if (G_LIKELY (lock_word_is_free (lw))) {
-		LockWord nlw = lock_word_new_flat (id);
-		if (mono_atomic_cas_ptr ((gpointer*)&obj->synchronisation, nlw.sync, NULL) == NULL) {
+		LockWord nlw = lock_word_new_flat_from (lw, id);
+		if (mono_atomic_cas_ptr ((gpointer*)&obj->synchronisation, nlw.sync, lw.sync) == lw.sync) {
 			return 1;
 		} else {
 			/* Someone acquired it in the meantime or put a hash */
@@ -1007,6 +1483,8 @@ mono_monitor_try_enter_internal (MonoObject *obj, guint32 ms, gboolean allow_int
 				return 1;
 			}
 		} else {
+			if (ms != 0 && mono_monitor_spin_flat (obj, id))
+				return 1;
 			mono_monitor_inflate (obj);
 			return mono_monitor_try_enter_inflated (obj, ms, allow_interruption, id);
 		}
@@ -1131,13 +1609,19 @@ mono_monitor_get_object_monitor_gchandle (MonoObject *object)
 {
 	LockWord lw;
 
-	lw.sync = object->synchronisation;
+	for (;;) {
+		lw.sync = object->synchronisation;
+
+		if (lock_word_is_inflated (lw)) {
+			MonoThreadsSync *mon = lock_word_get_inflated_lock (lw);
+			guint32 gchandle = (guint32)(gsize)mon->data;
 
-	if (lock_word_is_inflated (lw)) {
-		MonoThreadsSync *mon = lock_word_get_inflated_lock (lw);
-		return (guint32)(gsize)mon->data;
+			if (!mon_lock_word_unchanged (object, lw))
+				continue;
+			return gchandle;
+		}
+		return 0;
 	}
-	return 0;
 }
 
 /*
@@ -1257,12 +1741,17 @@ ves_icall_System_Threading_Monitor_Monitor_test_synchronised (MonoObject *obj)
 
 	LOCK_DEBUG (g_message("%s: (%d) Testing if %p is owned by any thread", __func__, mono_thread_info_get_small_id (), obj));
 
+retry:
 	lw.sync = obj->synchronisation;
 
 	if (lock_word_is_flat (lw)) {
 		return !lock_word_is_free (lw);
 	} else if (lock_word_is_inflated (lw)) {
-		return mon_status_get_owner (lock_word_get_inflated_lock (lw)->status) != 0;
+		guint32 owner = mon_status_get_owner (lock_word_get_inflated_lock (lw)->status);
+
+		if (!mon_lock_word_unchanged (obj, lw))
+			goto retry;
+		return owner != 0 && owner != MONITOR_OWNER_DEFLATED;
 	}
 
 	return FALSE;
@@ -1397,6 +1886,14 @@ ves_icall_System_Threading_Monitor_Monitor_wait (MonoObject *obj, guint32 ms)
 
 	g_assert (regain == 1);
 
+	/* The lock could have been deflated while we weren't on its wait list anymore */
+	lw.sync = obj->synchronisation;
+	if (!lock_word_is_inflated (lw)) {
+		mono_monitor_inflate_owned (obj, id);
+		lw.sync = obj->synchronisation;
+	}
+	mon = lock_word_get_inflated_lock (lw);
+
 	mon->nest = nest;
 
 	LOCK_DEBUG (g_message ("%s: (%d) Regained %p lock %p", __func__, id, obj, mon));
@@ -43,6 +43,8 @@ struct _MonoThreadsSync
 	void *data;
 	MonoCoopMutex *entry_mutex;
 	MonoCoopCond *entry_cond;
+	/* Iterations a contending thread spins before waiting on entry_cond, see mon_spin () */
+	gint32 spin_budget;
 };
 
 /*
@@ -65,11 +67,16 @@ struct _MonoThreadsSync
  *        LOCK_WORD_FAT_HASH:    [sync:30 | status:2]
  *
  * 64-bit
- *            LOCK_WORD_FLAT:    [unused:22 | owner:32 | nest:8 | status:2]
- *       LOCK_WORD_THIN_HASH:    [hash:62 | status:2]
+ *            LOCK_WORD_FLAT:    [hash:32 | owner:22 | nest:8 | status:2]
+ *       LOCK_WORD_THIN_HASH:    [hash:32 | unused:30 | status:2]
  *        LOCK_WORD_INFLATED:    [sync:62 | status:2]
  *        LOCK_WORD_FAT_HASH:    [sync:62 | status:2]
  *
+ * On 64-bit the hash is kept in the upper half of the word, so a flat lock can
+ * be taken on a hashed object and a flat locked object can be hashed without
+ * inflating: a thin hash is a free flat lock with the hash bit set. The owner
+ * is a small thread id, which fits in 22 bits.
+ *
  * In order to save processing time and to have one additional value, the nest
  * count starts from 0 for the lock word (just valid thread ID in the lock word
  * means that the thread holds the lock once, although nest is 0).
@@ -81,6 +88,10 @@ typedef union {
 	MonoThreadsSync *sync;
 } LockWord;
 
+#if SIZEOF_VOID_P == 8
+#define LOCK_WORD_FLAT_HASH 1
+#endif
+
 enum {
 	LOCK_WORD_FLAT = 0,
 	LOCK_WORD_HAS_HASH = 1,
@@ -92,7 +103,13 @@ enum {
 	LOCK_WORD_STATUS_MASK = (1 << LOCK_WORD_STATUS_BITS) - 1,
 	LOCK_WORD_NEST_MASK = ((1 << LOCK_WORD_NEST_BITS) - 1) << LOCK_WORD_STATUS_BITS,
 
+#ifdef LOCK_WORD_FLAT_HASH
+	LOCK_WORD_HASH_SHIFT = 32,
+	LOCK_WORD_OWNER_BITS = 32 - LOCK_WORD_STATUS_BITS - LOCK_WORD_NEST_BITS,
+	LOCK_WORD_OWNER_MASK = (1 << LOCK_WORD_OWNER_BITS) - 1,
+#else
 	LOCK_WORD_HASH_SHIFT = LOCK_WORD_STATUS_BITS,
+#endif
 	LOCK_WORD_NEST_SHIFT = LOCK_WORD_STATUS_BITS,
 	LOCK_WORD_OWNER_SHIFT = LOCK_WORD_STATUS_BITS + LOCK_WORD_NEST_BITS
 };
@@ -106,6 +123,9 @@ mono_monitor_init (void);
 void
 mono_monitor_cleanup (void);
 
+void
+mono_monitor_thread_detach (void);
+
 MonoBoolean
 mono_monitor_enter_internal (MonoObject *obj);
 
@@ -26,6 +26,8 @@ typedef struct {
 	MonoGHashGCType gc_type;
 	void **keys;
 	void **values;
+	/* The mixed hash of each key, so probes and rehashes don't have to call hash_func/equal_func */
+	int *hashes;
 } conc_table;
 
 struct _MonoConcGHashTable {
@@ -51,6 +53,7 @@ conc_table_new (MonoConcGHashTable *hash, int size)
 
 	table->keys = g_new0 (void*, size);
 	table->values = g_new0 (void*, size);
+	table->hashes = g_new0 (int, size);
 	table->table_size = size;
 	table->gc_type = hash->gc_type;
 
@@ -73,6 +76,7 @@ conc_table_free (gpointer ptr)
 
 	g_free (table->keys);
 	g_free (table->values);
+	g_free (table->hashes);
 	g_free (table);
 }
 
@@ -137,15 +141,15 @@ set_value (conc_table *table, int slot, gpointer value)
 }
 
 static MONO_ALWAYS_INLINE void
-insert_one_local (conc_table *table, GHashFunc hash_func, gpointer key, gpointer value)
+insert_one_local (conc_table *table, int hash, gpointer key, gpointer value)
 {
 	int table_mask = table->table_size - 1;
-	int hash = mix_hash (hash_func (key));
 	int i = hash & table_mask;
 
 	while (table->keys [i])
 		i = (i + 1) & table_mask;
 
+	table->hashes [i] = hash;
 	set_key (table, i, key);
 	set_value (table, i, value);
 }
@@ -159,7 +163,7 @@ rehash_table (MonoConcGHashTable *hash_table, int multiplier)
 
 	for (i = 0; i < old_table->table_size; ++i) {
 		if (old_table->keys [i] && !key_is_tombstone (hash_table, old_table->keys [i]))
-			insert_one_local (new_table, hash_table->hash_func, old_table->keys [i], old_table->values [i]);
+			insert_one_local (new_table, old_table->hashes [i], old_table->keys [i], old_table->values [i]);
 	}
 
 	mono_memory_barrier ();
@@ -261,7 +265,11 @@ retry:
 
 		while (table->keys [i]) {
 			gpointer orig_key = table->keys [i];
-			if (!key_is_tombstone (hash_table, orig_key) && equal (key, orig_key)) {
+			/*
+			 * A stale hash can only be seen for a key being inserted concurrently, missing
+			 * it is the same as looking up before the insert.
+			 */
+			if (table->hashes [i] == hash && !key_is_tombstone (hash_table, orig_key) && equal (key, orig_key)) {
 				gpointer value;
 				/* The read of keys must happen before the read of values */
 				mono_memory_barrier ();
@@ -349,6 +357,7 @@ mono_conc_g_hash_table_insert (MonoConcGHashTable *hash_table, gpointer key, gpo
 			gpointer cur_key = table->keys [i];
 			gboolean is_tombstone = FALSE;
 			if (!cur_key || (is_tombstone = key_is_tombstone (hash_table, cur_key))) {
+				table->hashes [i] = hash;
 				set_value (table, i, value);
 
 				/* The write to values must happen after the write to keys */
@@ -373,6 +382,7 @@ mono_conc_g_hash_table_insert (MonoConcGHashTable *hash_table, gpointer key, gpo
 			gpointer cur_key = table->keys [i];
 			gboolean is_tombstone = FALSE;
 			if (!cur_key || (is_tombstone = key_is_tombstone (hash_table, cur_key))) {
+				table->hashes [i] = hash;
 				set_value (table, i, value);
 				/* The write to values must happen after the write to keys */
 				mono_memory_barrier ();
@@ -384,7 +394,7 @@ mono_conc_g_hash_table_insert (MonoConcGHashTable *hash_table, gpointer key, gpo
 
 				return NULL;
 			}
-			if (equal (key, cur_key)) {
+			if (table->hashes [i] == hash && equal (key, cur_key)) {
 				gpointer value = table->values [i];
 				return value;
 			}
@@ -439,7 +449,7 @@ mono_conc_g_hash_table_remove (MonoConcGHashTable *hash_table, gconstpointer key
 				return NULL; /*key not found*/
 			}
 
-			if (!key_is_tombstone (hash_table, cur_key) && equal (key, cur_key)) {
+			if (table->hashes [i] == hash && !key_is_tombstone (hash_table, cur_key) && equal (key, cur_key)) {
 				gpointer value = table->values [i];
 				table->values [i] = NULL;
 				mono_memory_barrier ();
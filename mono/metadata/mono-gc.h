@@ -118,6 +118,51 @@ MONO_API void     mono_gc_finalize_notify    (void);
 MONO_API int    mono_gc_invoke_finalizers (void);
 /* heap walking is only valid in the pre-stop-world event callback */
 MONO_API int    mono_gc_walk_heap        (int flags, MonoGCReferences callback, void *data);
+/* walks the heap in slices, begin has the same restrictions as mono_gc_walk_heap */
+MONO_API int    mono_gc_walk_heap_begin  (int flags, MonoGCReferences callback, void *data);
+MONO_API mono_bool mono_gc_walk_heap_step (int budget_us);
+
+/**
+ * Kinds of events returned by mono_gc_get_recent_events ().
+ */
+typedef enum {
+	/**
+	 * The world was stopped for a collection.
+	 */
+	MONO_GC_RECENT_PAUSE_BEGIN = 0,
+	/**
+	 * The world was restarted. The \c value is the length of the pause.
+	 */
+	MONO_GC_RECENT_PAUSE_END = 1,
+	/**
+	 * Collection phases. The \c value is the time spent in the phase.
+	 */
+	MONO_GC_RECENT_PHASE_PINNING = 2,
+	MONO_GC_RECENT_PHASE_SCAN_ROOTS = 3,
+	MONO_GC_RECENT_PHASE_FINISH_GRAY_STACK = 4,
+	MONO_GC_RECENT_PHASE_SWEEP = 5,
+	/**
+	 * The \c value is the number of bytes promoted by a nursery collection.
+	 */
+	MONO_GC_RECENT_BYTES_PROMOTED = 6,
+	/**
+	 * The \c value is the number of objects pinned by a collection.
+	 */
+	MONO_GC_RECENT_OBJECTS_PINNED = 7,
+} MonoGCRecentEventKind;
+
+/**
+ * Times and timestamps are in 100ns ticks, timestamps are relative to the
+ * initialization of the GC.
+ */
+typedef struct {
+	int64_t timestamp;
+	int64_t value;
+	int32_t kind;
+	int32_t generation;
+} MonoGCRecentEvent;
+
+MONO_API int    mono_gc_get_recent_events (MonoGCRecentEvent *events, int max_events);
 
 MONO_END_DECLS
 
@@ -73,6 +73,12 @@ mono_gc_get_allocated_bytes_for_current_thread (void)
 	return 0;
 }
 
+gboolean
+mono_gc_set_allocation_sample_interval (guint32 interval)
+{
+	return FALSE;
+}
+
 int
 mono_gc_get_generation  (MonoObject *object)
 {
@@ -115,6 +121,30 @@ mono_gc_walk_heap (int flags, MonoGCReferences callback, void *data)
 	return 1;
 }
 
+int
+mono_gc_walk_heap_begin (int flags, MonoGCReferences callback, void *data)
+{
+	return 1;
+}
+
+int
+mono_gc_scan_thread_stacks (MonoGCStackWordFunc func, gpointer user_data)
+{
+	return 1;
+}
+
+mono_bool
+mono_gc_walk_heap_step (int budget_us)
+{
+	return TRUE;
+}
+
+int
+mono_gc_get_recent_events (MonoGCRecentEvent *events, int max_events)
+{
+	return 0;
+}
+
 gboolean
 mono_object_is_alive (MonoObject* o)
 {
@@ -214,6 +244,12 @@ mono_gc_alloc_vector (MonoVTable *vtable, size_t size, uintptr_t max_length)
 	return obj;
 }
 
+MonoArray*
+mono_gc_alloc_uninitialized_vector (MonoVTable *vtable, size_t size, uintptr_t max_length)
+{
+	return mono_gc_alloc_vector (vtable, size, max_length);
+}
+
 MonoArray*
 mono_gc_alloc_array (MonoVTable *vtable, size_t size, uintptr_t max_length, uintptr_t bounds_size)
 {
@@ -240,6 +276,12 @@ mono_gc_alloc_string (MonoVTable *vtable, size_t size, gint32 len)
 	return obj;
 }
 
+MonoString*
+mono_gc_alloc_uninitialized_string (MonoVTable *vtable, size_t size, gint32 len)
+{
+	return mono_gc_alloc_string (vtable, size, len);
+}
+
 MonoObject*
 mono_gc_alloc_mature (MonoVTable *vtable, size_t size)
 {
@@ -338,6 +380,12 @@ mono_gc_get_managed_allocator (MonoClass *klass, gboolean for_box, gboolean know
 	return NULL;
 }
 
+gboolean
+mono_gc_can_inline_managed_allocator (void)
+{
+	return FALSE;
+}
+
 MonoMethod*
 mono_gc_get_managed_array_allocator (MonoClass *klass)
 {
@@ -806,6 +806,10 @@ typedef struct {
 	gpointer (*create_jit_trampoline) (MonoDomain *domain, MonoMethod *method, MonoError *error);
 	/* used to free a dynamic method */
 	void     (*free_method) (MonoDomain *domain, MonoMethod *method);
+	/* used to drop the JIT's references to the code of a collectible AssemblyLoadContext */
+	void     (*detach_alc_code) (MonoDomain *domain, MonoAssemblyLoadContext *alc, GPtrArray *methods);
+	/* used to free a method of a collectible AssemblyLoadContext after its code was detached */
+	void     (*free_alc_method) (MonoDomain *domain, MonoMethod *method);
 	gpointer (*create_remoting_trampoline) (MonoDomain *domain, MonoMethod *method, MonoRemotingTarget target, MonoError *error);
 	gpointer (*create_delegate_trampoline) (MonoDomain *domain, MonoClass *klass);
 	gpointer (*interp_get_remoting_invoke) (MonoMethod *method, gpointer imethod, MonoError *error);
@@ -1776,6 +1780,9 @@ mono_array_new_full_checked (MonoDomain *domain, MonoClass *array_class, uintptr
 MonoArray*
 mono_array_new_specific_checked (MonoVTable *vtable, uintptr_t n, MonoError *error);
 
+MonoArray*
+mono_array_new_uninitialized_specific_checked (MonoVTable *vtable, uintptr_t n, MonoError *error);
+
 MonoArrayHandle
 mono_array_new_specific_handle (MonoVTable *vtable, uintptr_t n, MonoError *error);
 
@@ -1787,6 +1794,10 @@ ICALL_EXPORT
 MonoArray*
 ves_icall_array_new_specific (MonoVTable *vtable, uintptr_t n);
 
+ICALL_EXPORT
+MonoArray*
+ves_icall_array_new_uninitialized_specific (MonoVTable *vtable, uintptr_t n);
+
 #ifndef DISABLE_REMOTING
 MonoRemoteClass*
 mono_remote_class (MonoDomain *domain, MonoStringHandle class_name, MonoClass *proxy_class, MonoError *error);
@@ -1895,6 +1906,11 @@ mono_set_always_build_imt_trampolines (gboolean value);
 void
 mono_vtable_build_imt_slot (MonoVTable* vtable, int imt_slot);
 
+#ifdef ENABLE_NETCORE
+void
+mono_vtable_detach_alc_code (MonoVTable *vtable, MonoAssemblyLoadContext *alc);
+#endif
+
 guint32
 mono_method_get_imt_slot (MonoMethod *method);
 
@@ -2092,6 +2108,9 @@ mono_object_handle_isinst_mbyref (MonoObjectHandle obj, MonoClass *klass, MonoEr
 gboolean
 mono_object_handle_isinst_mbyref_raw (MonoObjectHandle obj, MonoClass *klass, MonoError *error);
 
+void
+mono_cast_cache_clear (void);
+
 MonoStringHandle
 mono_string_new_size_handle (MonoDomain *domain, gint32 len, MonoError *error);
 
@@ -2101,6 +2120,9 @@ mono_string_new_len_checked (MonoDomain *domain, const char *text, guint length,
 MonoString *
 mono_string_new_size_checked (MonoDomain *domain, gint32 len, MonoError *error);
 
+MonoString *
+mono_string_new_size_uninitialized_checked (MonoDomain *domain, gint32 len, MonoError *error);
+
 MonoString*
 mono_ldstr_checked (MonoDomain *domain, MonoImage *image, uint32_t str_index, MonoError *error);
 
@@ -197,20 +197,43 @@ typedef struct
 	MonoCoopCond cond;
 } TypeInitializationLock;
 
-/* for locking access to type_initialization_hash and blocked_thread_hash */
-static MonoCoopMutex type_initialization_section;
+/*
+ * The table of types being initialized is split by vtable, so threads running
+ * unrelated cctors, e.g. during startup, don't serialize on a single lock.
+ * Only a thread which has to wait for a cctor running on another thread takes
+ * blocked_thread_section, to check for deadlocks.
+ */
+#define TYPE_INITIALIZATION_STRIPES 64
+
+typedef struct {
+	/* for locking access to hash */
+	MonoCoopMutex mutex;
+	/* from vtable to lock */
+	GHashTable *hash;
+} TypeInitializationStripe;
+
+static TypeInitializationStripe type_initialization_stripes [TYPE_INITIALIZATION_STRIPES];
+
+/* for locking access to blocked_thread_hash, taken inside the stripe locks */
+static MonoCoopMutex blocked_thread_section;
+
+static inline TypeInitializationStripe *
+type_initialization_stripe (MonoVTable *vtable)
+{
+	return &type_initialization_stripes [((gsize) vtable >> 4) % TYPE_INITIALIZATION_STRIPES];
+}
 
 static inline void
-mono_type_initialization_lock (void)
+mono_type_initialization_lock (TypeInitializationStripe *stripe)
 {
 	/* The critical sections protected by this lock in mono_runtime_class_init_full () can block */
-	mono_coop_mutex_lock (&type_initialization_section);
+	mono_coop_mutex_lock (&stripe->mutex);
 }
 
 static inline void
-mono_type_initialization_unlock (void)
+mono_type_initialization_unlock (TypeInitializationStripe *stripe)
 {
-	mono_coop_mutex_unlock (&type_initialization_section);
+	mono_coop_mutex_unlock (&stripe->mutex);
 }
 
 static void
@@ -227,9 +250,6 @@ mono_type_init_unlock (TypeInitializationLock *lock)
 	mono_coop_mutex_unlock (&lock->mutex);
 }
 
-/* from vtable to lock */
-static GHashTable *type_initialization_hash;
-
 /* from thread id to thread id being waited on */
 static GHashTable *blocked_thread_hash;
 
@@ -277,8 +297,13 @@ mono_thread_get_main (void)
 void
 mono_type_initialization_init (void)
 {
-	mono_coop_mutex_init_recursive (&type_initialization_section);
-	type_initialization_hash = g_hash_table_new (NULL, NULL);
+	int i;
+
+	for (i = 0; i < TYPE_INITIALIZATION_STRIPES; ++i) {
+		mono_coop_mutex_init_recursive (&type_initialization_stripes [i].mutex);
+		type_initialization_stripes [i].hash = g_hash_table_new (NULL, NULL);
+	}
+	mono_coop_mutex_init (&blocked_thread_section);
 	blocked_thread_hash = g_hash_table_new (NULL, NULL);
 	mono_coop_mutex_init (&ldstr_section);
 	mono_register_jit_icall (ves_icall_string_alloc, mono_icall_sig_object_int, FALSE);
@@ -291,9 +316,11 @@ mono_type_initialization_cleanup (void)
 	/* This is causing race conditions with
 	 * mono_release_type_locks
 	 */
-	mono_coop_mutex_destroy (&type_initialization_section);
-	g_hash_table_destroy (type_initialization_hash);
-	type_initialization_hash = NULL;
+	for (int i = 0; i < TYPE_INITIALIZATION_STRIPES; ++i) {
+		mono_coop_mutex_destroy (&type_initialization_stripes [i].mutex);
+		g_hash_table_destroy (type_initialization_stripes [i].hash);
+		type_initialization_stripes [i].hash = NULL;
+	}
 #endif
 	mono_coop_mutex_destroy (&ldstr_section);
 	g_hash_table_destroy (blocked_thread_hash);
@@ -371,7 +398,7 @@ mono_runtime_class_init (MonoVTable *vtable)
 
 /*
  * Returns TRUE if the lock was freed.
- * LOCKING: Caller should hold type_initialization_lock.
+ * LOCKING: Caller should hold the type_initialization_lock of the vtable's stripe.
  */
 static gboolean
 unref_type_lock (TypeInitializationLock *lock)
@@ -434,6 +461,7 @@ mono_runtime_class_init_full (MonoVTable *vtable, MonoError *error)
 	MonoClass *klass;
 	gchar *full_name;
 	MonoDomain *domain = vtable->domain;
+	TypeInitializationStripe *stripe;
 	TypeInitializationLock *lock;
 	MonoNativeThreadId tid;
 	int do_initialization = 0;
@@ -460,16 +488,17 @@ mono_runtime_class_init_full (MonoVTable *vtable, MonoError *error)
 	tid = mono_native_thread_id_get ();
 
 	/*
-	 * Due some preprocessing inside a global lock. If we are the first thread
-	 * trying to initialize this class, create a separate lock+cond var, and
-	 * acquire it before leaving the global lock. The other threads will wait
+	 * Due some preprocessing inside the lock of the vtable's stripe. If we are the
+	 * first thread trying to initialize this class, create a separate lock+cond var,
+	 * and acquire it before leaving the stripe lock. The other threads will wait
 	 * on this cond var.
 	 */
 
-	mono_type_initialization_lock ();
+	stripe = type_initialization_stripe (vtable);
+	mono_type_initialization_lock (stripe);
 	/* double check... */
 	if (vtable->initialized) {
-		mono_type_initialization_unlock ();
+		mono_type_initialization_unlock (stripe);
 		return TRUE;
 	}
 	if (vtable->init_failed) {
@@ -478,11 +507,11 @@ mono_runtime_class_init_full (MonoVTable *vtable, MonoError *error)
 		/* Reset the stack_trace and trace_ips because the exception is reused */
 		exp->stack_trace = NULL;
 		exp->trace_ips = NULL;
-		mono_type_initialization_unlock ();
+		mono_type_initialization_unlock (stripe);
 		mono_error_set_exception_instance (error, exp);
 		return FALSE;
 	}
-	lock = (TypeInitializationLock *)g_hash_table_lookup (type_initialization_hash, vtable);
+	lock = (TypeInitializationLock *)g_hash_table_lookup (stripe->hash, vtable);
 	if (lock == NULL) {
 		/* This thread will get to do the initialization */
 		if (mono_domain_get () != domain) {
@@ -490,7 +519,7 @@ mono_runtime_class_init_full (MonoVTable *vtable, MonoError *error)
 			last_domain = mono_domain_get ();
 			if (!mono_domain_set_fast (domain, FALSE)) {
 				vtable->initialized = 1;
-				mono_type_initialization_unlock ();
+				mono_type_initialization_unlock (stripe);
 				mono_error_set_exception_instance (error, mono_get_exception_appdomain_unloaded ());
 				return FALSE;
 			}
@@ -501,23 +530,30 @@ mono_runtime_class_init_full (MonoVTable *vtable, MonoError *error)
 		lock->initializing_tid = tid;
 		lock->waiting_count = 1;
 		lock->done = FALSE;
-		g_hash_table_insert (type_initialization_hash, vtable, lock);
+		g_hash_table_insert (stripe->hash, vtable, lock);
 		do_initialization = 1;
 	} else {
 		gpointer blocked;
 		TypeInitializationLock *pending_lock;
 
 		if (mono_native_thread_id_equals (lock->initializing_tid, tid)) {
-			mono_type_initialization_unlock ();
+			mono_type_initialization_unlock (stripe);
 			return TRUE;
 		}
-		/* see if the thread doing the initialization is already blocked on this thread */
+		/*
+		 * see if the thread doing the initialization is already blocked on this thread.
+		 * The locks in blocked_thread_hash can be in other stripes, they are kept alive
+		 * by the reference of the thread waiting on them, which removes itself from the
+		 * hash before dropping it.
+		 */
+		mono_coop_mutex_lock (&blocked_thread_section);
 		gboolean is_blocked = TRUE;
 		blocked = GUINT_TO_POINTER (MONO_NATIVE_THREAD_ID_TO_UINT (lock->initializing_tid));
 		while ((pending_lock = (TypeInitializationLock*) g_hash_table_lookup (blocked_thread_hash, blocked))) {
 			if (mono_native_thread_id_equals (pending_lock->initializing_tid, tid)) {
 				if (!pending_lock->done) {
-					mono_type_initialization_unlock ();
+					mono_coop_mutex_unlock (&blocked_thread_section);
+					mono_type_initialization_unlock (stripe);
 					return TRUE;
 				} else {
 					/* the thread doing the initialization is blocked on this thread,
@@ -533,8 +569,9 @@ mono_runtime_class_init_full (MonoVTable *vtable, MonoError *error)
 		/* record the fact that we are waiting on the initializing thread */
 		if (is_blocked)
 			g_hash_table_insert (blocked_thread_hash, GUINT_TO_POINTER (tid), lock);
+		mono_coop_mutex_unlock (&blocked_thread_section);
 	}
-	mono_type_initialization_unlock ();
+	mono_type_initialization_unlock (stripe);
 
 	if (do_initialization) {
 		MonoException *exc = NULL;
@@ -610,17 +647,24 @@ mono_runtime_class_init_full (MonoVTable *vtable, MonoError *error)
 		mono_type_init_unlock (lock);
 	}
 
-	/* Do cleanup and setting vtable->initialized inside the global lock again */
-	mono_type_initialization_lock ();
-	if (!do_initialization)
+	if (!do_initialization) {
+		mono_coop_mutex_lock (&blocked_thread_section);
 		g_hash_table_remove (blocked_thread_hash, GUINT_TO_POINTER (tid));
+		mono_coop_mutex_unlock (&blocked_thread_section);
+	}
+
+	/* Do cleanup and setting vtable->initialized inside the stripe lock again */
+	mono_type_initialization_lock (stripe);
 	gboolean deleted = unref_type_lock (lock);
 	if (deleted)
-		g_hash_table_remove (type_initialization_hash, vtable);
-	/* Have to set this here since we check it inside the global lock */
-	if (do_initialization && !vtable->init_failed)
+		g_hash_table_remove (stripe->hash, vtable);
+	/* Have to set this here since we check it inside the stripe lock */
+	if (do_initialization && !vtable->init_failed) {
+		/* The fast path above and the JIT'd checks read the flag without a lock */
+		mono_memory_barrier ();
 		vtable->initialized = 1;
-	mono_type_initialization_unlock ();
+	}
+	mono_type_initialization_unlock (stripe);
 
 	/* If vtable init fails because of TAE, we don't throw TIE, only the TAE */
 	if (vtable->init_failed && !pending_tae) {
@@ -686,9 +730,13 @@ mono_release_type_locks (MonoInternalThread *thread)
 {
 	MONO_REQ_GC_UNSAFE_MODE;
 
-	mono_type_initialization_lock ();
-	g_hash_table_foreach_remove (type_initialization_hash, release_type_locks, GUINT_TO_POINTER (thread->tid));
-	mono_type_initialization_unlock ();
+	for (int i = 0; i < TYPE_INITIALIZATION_STRIPES; ++i) {
+		TypeInitializationStripe *stripe = &type_initialization_stripes [i];
+
+		mono_type_initialization_lock (stripe);
+		g_hash_table_foreach_remove (stripe->hash, release_type_locks, GUINT_TO_POINTER (thread->tid));
+		mono_type_initialization_unlock (stripe);
+	}
 }
 
 #ifndef DISABLE_REMOTING
@@ -1275,6 +1323,7 @@ mono_method_get_imt_slot (MonoMethod *method)
 	MonoMethodSignature *sig;
 	int hashes_count;
 	guint32 *hashes_start, *hashes;
+	guint32 hashes_buf [16];
 	guint32 a, b, c;
 	int i;
 
@@ -1292,7 +1341,10 @@ mono_method_get_imt_slot (MonoMethod *method)
 
 	sig = mono_method_signature_internal (method);
 	hashes_count = sig->param_count + 4;
-	hashes_start = (guint32 *)g_malloc (hashes_count * sizeof (guint32));
+	if (hashes_count <= G_N_ELEMENTS (hashes_buf))
+		hashes_start = hashes_buf;
+	else
+		hashes_start = (guint32 *)g_malloc (hashes_count * sizeof (guint32));
 	hashes = hashes_start;
 
 	if (! MONO_CLASS_IS_INTERFACE_INTERNAL (method->klass)) {
@@ -1332,7 +1384,8 @@ mono_method_get_imt_slot (MonoMethod *method)
 		break;
 	}
 	
-	g_free (hashes_start);
+	if (hashes_start != hashes_buf)
+		g_free (hashes_start);
 	/* Report the result */
 	return c % MONO_IMT_SIZE;
 }
@@ -1342,11 +1395,46 @@ mono_method_get_imt_slot (MonoMethod *method)
 
 #define DEBUG_IMT 0
 
+/*
+ * interface_imt_slots:
+ *
+ *   Return the IMT slot of each method of IFACE, by method index. Since the IMT
+ * slot of an inflated method is the one of its declaring method, the slots are
+ * computed once on the generic type definition and shared by all of its
+ * instantiations, so building a single IMT slot lazily doesn't have to rehash the
+ * name and signature of every interface method of the class.
+ */
+static guint8*
+interface_imt_slots (MonoClass *iface)
+{
+	MONO_REQ_GC_NEUTRAL_MODE;
+
+	guint8 *slots;
+	int i, mcount;
+
+	if (mono_class_is_ginst (iface))
+		iface = mono_class_get_generic_class (iface)->container_class;
+
+	slots = mono_class_get_imt_slots (iface);
+	if (slots)
+		return slots;
+
+	mono_class_setup_methods (iface);
+	mcount = mono_class_get_method_count (iface);
+	slots = (guint8 *)mono_class_alloc0 (iface, MAX (mcount, 1));
+	for (i = 0; i < mcount; ++i) {
+		MonoMethod *method = mono_class_get_method_by_index (iface, i);
+		if (method)
+			slots [i] = mono_method_get_imt_slot (method);
+	}
+
+	return mono_class_set_imt_slots (iface, slots);
+}
+
 static void
-add_imt_builder_entry (MonoImtBuilderEntry **imt_builder, MonoMethod *method, guint32 *imt_collisions_bitmap, int vtable_slot, int slot_num) {
+add_imt_builder_entry (MonoImtBuilderEntry **imt_builder, MonoMethod *method, guint32 imt_slot, guint32 *imt_collisions_bitmap, int vtable_slot, int slot_num) {
 	MONO_REQ_GC_NEUTRAL_MODE;
 
-	guint32 imt_slot = mono_method_get_imt_slot (method);
 	MonoImtBuilderEntry *entry;
 
 	if (slot_num >= 0 && imt_slot != slot_num) {
@@ -1531,6 +1619,7 @@ build_imt_slots (MonoClass *klass, MonoVTable *vt, MonoDomain *domain, gpointer*
 		mono_class_setup_methods (iface);
 		vt_slot = interface_offset;
 		int mcount = mono_class_get_method_count (iface);
+		guint8 *imt_slots = interface_imt_slots (iface);
 		for (method_slot_in_interface = 0; method_slot_in_interface < mcount; method_slot_in_interface++) {
 			MonoMethod *method;
 
@@ -1541,8 +1630,7 @@ build_imt_slots (MonoClass *klass, MonoVTable *vt, MonoDomain *domain, gpointer*
 				 * avoid inflating methods which will be discarded by 
 				 * add_imt_builder_entry anyway.
 				 */
-				method = mono_class_get_method_by_index (mono_class_get_generic_class (iface)->container_class, method_slot_in_interface);
-				if (mono_method_get_imt_slot (method) != slot_num) {
+				if (imt_slots [method_slot_in_interface] != slot_num) {
 					vt_slot ++;
 					continue;
 				}
@@ -1555,7 +1643,7 @@ build_imt_slots (MonoClass *klass, MonoVTable *vt, MonoDomain *domain, gpointer*
 			}
 
 			if (method->flags & METHOD_ATTRIBUTE_VIRTUAL) {
-				add_imt_builder_entry (imt_builder, method, &imt_collisions_bitmap, vt_slot, slot_num);
+				add_imt_builder_entry (imt_builder, method, imt_slots [method_slot_in_interface], &imt_collisions_bitmap, vt_slot, slot_num);
 				vt_slot ++;
 			}
 		}
@@ -1567,12 +1655,13 @@ build_imt_slots (MonoClass *klass, MonoVTable *vt, MonoDomain *domain, gpointer*
 			MonoClass* iface = (MonoClass *)list_item->data;
 			int method_slot_in_interface;
 			int mcount = mono_class_get_method_count (iface);
+			guint8 *imt_slots = interface_imt_slots (iface);
 			for (method_slot_in_interface = 0; method_slot_in_interface < mcount; method_slot_in_interface++) {
 				MonoMethod *method = mono_class_get_method_by_index (iface, method_slot_in_interface);
 
 				if (method->is_generic)
 					has_generic_virtual = TRUE;
-				add_imt_builder_entry (imt_builder, method, &imt_collisions_bitmap, interface_offset + method_slot_in_interface, slot_num);
+				add_imt_builder_entry (imt_builder, method, imt_slots [method_slot_in_interface], &imt_collisions_bitmap, interface_offset + method_slot_in_interface, slot_num);
 			}
 			interface_offset += mcount;
 		}
@@ -1868,6 +1957,84 @@ mono_method_add_generic_virtual_invocation (MonoDomain *domain, MonoVTable *vtab
 	mono_domain_unlock (domain);
 }
 
+#ifdef ENABLE_NETCORE
+/*
+ * LOCKING: requires the domain lock.
+ */
+static gboolean
+generic_virtual_cases_use_alc (MonoDomain *domain, gpointer *vtable_slot, MonoAssemblyLoadContext *alc)
+{
+	GenericVirtualCase *list;
+
+	if (!domain->generic_virtual_cases)
+		return FALSE;
+
+	for (list = (GenericVirtualCase *)g_hash_table_lookup (domain->generic_virtual_cases, vtable_slot); list; list = list->next) {
+		if (mono_alc_owns_method (alc, list->method))
+			return TRUE;
+	}
+	return FALSE;
+}
+
+/**
+ * mono_vtable_detach_alc_code:
+ * \param vtable a vtable
+ * \param alc a collectible AssemblyLoadContext whose code is going to be freed
+ * Point the slots of \p vtable which can refer to the code of \p alc back to
+ * their trampolines, so the methods are looked up again if they are called
+ * after the code is freed.  For the classes of \p alc these are all the vtable
+ * and IMT slots, for the other classes the slots with generic virtual thunks
+ * dispatching to methods of \p alc.
+ * LOCKING: Takes the loader and domain locks.
+ */
+void
+mono_vtable_detach_alc_code (MonoVTable *vtable, MonoAssemblyLoadContext *alc)
+{
+	MONO_REQ_GC_NEUTRAL_MODE;
+
+	MonoClass *klass = vtable->klass;
+	MonoDomain *domain = vtable->domain;
+	gpointer *imt = (gpointer*)vtable - MONO_IMT_SIZE;
+	gboolean owned = mono_alc_owns_class (alc, klass);
+	int i;
+
+	if (!callbacks.get_vtable_trampoline)
+		return;
+
+	mono_loader_lock ();
+	mono_domain_lock (domain);
+
+	if (!owned && !domain->generic_virtual_cases)
+		goto leave;
+
+	for (i = 0; i < m_class_get_vtable_size (klass); ++i) {
+		if (owned || generic_virtual_cases_use_alc (domain, &vtable->vtable [i], alc)) {
+			if (domain->generic_virtual_cases)
+				g_hash_table_remove (domain->generic_virtual_cases, &vtable->vtable [i]);
+			vtable->vtable [i] = callbacks.get_vtable_trampoline (vtable, i);
+		}
+	}
+
+	if (m_class_get_interface_offsets_count (klass)) {
+		for (i = 0; i < MONO_IMT_SIZE; ++i) {
+			if (owned || generic_virtual_cases_use_alc (domain, &imt [i], alc)) {
+				if (domain->generic_virtual_cases)
+					g_hash_table_remove (domain->generic_virtual_cases, &imt [i]);
+				imt [i] = callbacks.get_imt_trampoline (vtable, i);
+			}
+		}
+	}
+
+	/* Filled lazily again */
+	if (owned)
+		vtable->runtime_generic_context = NULL;
+
+leave:
+	mono_domain_unlock (domain);
+	mono_loader_unlock ();
+}
+#endif
+
 static MonoVTable *mono_class_create_runtime_vtable (MonoDomain *domain, MonoClass *klass, MonoError *error);
 
 /**
@@ -6180,7 +6347,14 @@ mono_array_clone_in_domain (MonoDomain *domain, MonoArrayHandle array_handle, Mo
 	MonoArrayHandle o;
 	if (array_bounds == NULL) {
 		size = mono_array_handle_length (array_handle);
-		o = mono_array_new_full_handle (domain, klass, &size, NULL, error);
+		if (m_class_has_references (klass)) {
+			o = mono_array_new_full_handle (domain, klass, &size, NULL, error);
+		} else {
+			/* Every element is overwritten by the copy below */
+			MonoVTable *vtable = mono_class_vtable_checked (domain, klass, error);
+			goto_if_nok (error, leave);
+			o = MONO_HANDLE_NEW (MonoArray, mono_array_new_uninitialized_specific_checked (vtable, size, error));
+		}
 		goto_if_nok (error, leave);
 		size *= mono_array_element_size (klass);
 	} else {
@@ -6468,8 +6642,8 @@ mono_array_new_specific (MonoVTable *vtable, uintptr_t n)
 	return arr;
 }
 
-MonoArray*
-mono_array_new_specific_checked (MonoVTable *vtable, uintptr_t n, MonoError *error)
+static MonoArray*
+array_new_specific (MonoVTable *vtable, uintptr_t n, gboolean uninitialized, MonoError *error)
 {
 	MONO_REQ_GC_UNSAFE_MODE;
 
@@ -6487,7 +6661,10 @@ mono_array_new_specific_checked (MonoVTable *vtable, uintptr_t n, MonoError *err
 		mono_error_set_out_of_memory (error, "Could not allocate %i bytes", MONO_ARRAY_MAX_SIZE);
 		return NULL;
 	}
-	o = (MonoObject *)mono_gc_alloc_vector (vtable, byte_len, n);
+	if (uninitialized)
+		o = (MonoObject *)mono_gc_alloc_uninitialized_vector (vtable, byte_len, n);
+	else
+		o = (MonoObject *)mono_gc_alloc_vector (vtable, byte_len, n);
 
 	if (G_UNLIKELY (!o)) {
 		mono_error_set_out_of_memory (error, "Could not allocate %zd bytes", (gsize) byte_len);
@@ -6497,6 +6674,25 @@ mono_array_new_specific_checked (MonoVTable *vtable, uintptr_t n, MonoError *err
 	return (MonoArray*)o;
 }
 
+MonoArray*
+mono_array_new_specific_checked (MonoVTable *vtable, uintptr_t n, MonoError *error)
+{
+	return array_new_specific (vtable, n, FALSE, error);
+}
+
+/**
+ * mono_array_new_uninitialized_specific_checked:
+ *
+ *   Same as mono_array_new_specific_checked (), but the elements are not
+ * necessarily cleared, the caller has to initialize all of them.  Arrays whose
+ * elements contain references are always cleared.
+ */
+MonoArray*
+mono_array_new_uninitialized_specific_checked (MonoVTable *vtable, uintptr_t n, MonoError *error)
+{
+	return array_new_specific (vtable, n, !m_class_has_references (vtable->klass), error);
+}
+
 
 MonoArrayHandle
 mono_array_new_specific_handle (MonoVTable *vtable, uintptr_t n, MonoError *error)
@@ -6515,6 +6711,16 @@ ves_icall_array_new_specific (MonoVTable *vtable, uintptr_t n)
 	return arr;
 }
 
+MonoArray*
+ves_icall_array_new_uninitialized_specific (MonoVTable *vtable, uintptr_t n)
+{
+	ERROR_DECL (error);
+	MonoArray *arr = mono_array_new_uninitialized_specific_checked (vtable, n, error);
+	mono_error_set_pending_exception (error);
+
+	return arr;
+}
+
 /**
  * mono_string_empty_wrapper:
  *
@@ -6588,7 +6794,7 @@ mono_string_new_utf16_checked (MonoDomain *domain, const gunichar2 *text, gint32
 	
 	error_init (error);
 	
-	s = mono_string_new_size_checked (domain, len, error);
+	s = mono_string_new_size_uninitialized_checked (domain, len, error);
 	if (s != NULL)
 		memcpy (mono_string_chars_internal (s), text, len * 2);
 
@@ -6629,7 +6835,7 @@ mono_string_new_utf32_checked (MonoDomain *domain, const mono_unichar4 *text, gi
 	
 	gint32 utf16_len = g_utf16_len (utf16_output);
 	
-	s = mono_string_new_size_checked (domain, utf16_len, error);
+	s = mono_string_new_size_uninitialized_checked (domain, utf16_len, error);
 	goto_if_nok (error, exit);
 
 	memcpy (mono_string_chars_internal (s), utf16_output, utf16_len * 2);
@@ -6709,6 +6915,41 @@ mono_string_new_size_checked (MonoDomain *domain, gint32 length, MonoError *erro
 	HANDLE_FUNCTION_RETURN_OBJ (mono_string_new_size_handle (domain, length, error));
 }
 
+/**
+ * mono_string_new_size_uninitialized_checked:
+ *
+ *   Same as mono_string_new_size_checked (), but the characters are not
+ * necessarily cleared, the caller has to write all LENGTH of them.
+ */
+MonoString *
+mono_string_new_size_uninitialized_checked (MonoDomain *domain, gint32 length, MonoError *error)
+{
+	MONO_REQ_GC_UNSAFE_MODE;
+
+	MonoString *s;
+	MonoVTable *vtable;
+	size_t size;
+
+	error_init (error);
+
+	/* check for overflow */
+	if (length < 0 || length > ((SIZE_MAX - G_STRUCT_OFFSET (MonoString, chars) - 8) / 2)) {
+		mono_error_set_out_of_memory (error, "Could not allocate %i bytes", -1);
+		return NULL;
+	}
+
+	size = (G_STRUCT_OFFSET (MonoString, chars) + (((size_t)length + 1) * 2));
+
+	vtable = mono_class_vtable_checked (domain, mono_defaults.string_class, error);
+	return_val_if_nok (error, NULL);
+
+	s = mono_gc_alloc_uninitialized_string (vtable, size, length);
+	if (G_UNLIKELY (!s))
+		mono_error_set_out_of_memory (error, "Could not allocate %" G_GSIZE_FORMAT " bytes", size);
+
+	return s;
+}
+
 /**
  * mono_string_new_len:
  * \param text a pointer to an utf8 string
@@ -7182,6 +7423,92 @@ mono_object_unbox (MonoObject *obj)
 	MONO_EXTERNAL_ONLY_GC_UNSAFE (void*, mono_object_unbox_internal (obj));
 }
 
+/*
+ * Cache of the casts which take the slow path of mono_class_is_assignable_from ():
+ * variant generic interfaces, the generic interfaces of arrays and array covariance.
+ * Each entry is guarded by a sequence counter which is odd while it is written, so
+ * lookups don't take a lock, and a lookup racing with a store just misses.
+ */
+#define CAST_CACHE_SIZE 1024
+
+typedef struct {
+	gint32 seq;
+	gboolean result;
+	MonoVTable *vtable;
+	MonoClass *klass;
+} CastCacheEntry;
+
+static CastCacheEntry cast_cache [CAST_CACHE_SIZE];
+
+static CastCacheEntry*
+cast_cache_entry (MonoVTable *vtable, MonoClass *klass)
+{
+	return &cast_cache [(mono_aligned_addr_hash (vtable) ^ (mono_aligned_addr_hash (klass) * 31)) & (CAST_CACHE_SIZE - 1)];
+}
+
+static gboolean
+cast_cache_lookup (MonoVTable *vtable, MonoClass *klass, gboolean *result)
+{
+	CastCacheEntry *entry = cast_cache_entry (vtable, klass);
+	gint32 seq = mono_atomic_load_i32 (&entry->seq);
+	gboolean found;
+
+	if (seq & 1)
+		return FALSE;
+
+	mono_memory_read_barrier ();
+	found = entry->vtable == vtable && entry->klass == klass;
+	*result = entry->result;
+	mono_memory_read_barrier ();
+
+	return found && mono_atomic_load_i32 (&entry->seq) == seq;
+}
+
+static void
+cast_cache_store (CastCacheEntry *entry, MonoVTable *vtable, MonoClass *klass, gboolean result)
+{
+	gint32 seq = mono_atomic_load_i32 (&entry->seq);
+
+	/* Somebody else is writing the entry, it's only a cache */
+	if ((seq & 1) || mono_atomic_cas_i32 (&entry->seq, seq + 1, seq) != seq)
+		return;
+
+	entry->vtable = vtable;
+	entry->klass = klass;
+	entry->result = result;
+	mono_memory_write_barrier ();
+	mono_atomic_store_i32 (&entry->seq, seq + 2);
+}
+
+/*
+ * mono_cast_cache_clear:
+ *
+ *   Forget all the cached casts, called before the vtables and classes of a domain are
+ * freed, so their memory can't be mistaken for them once reused.
+ */
+void
+mono_cast_cache_clear (void)
+{
+	int i;
+
+	for (i = 0; i < CAST_CACHE_SIZE; ++i)
+		cast_cache_store (&cast_cache [i], NULL, NULL, FALSE);
+}
+
+/* Same as mono_class_is_assignable_from_internal (klass, vt->klass), for the slow cases */
+static gboolean
+vtable_is_assignable_to_cached (MonoVTable *vt, MonoClass *klass)
+{
+	gboolean result;
+
+	if (cast_cache_lookup (vt, klass, &result))
+		return result;
+
+	result = mono_class_is_assignable_from_internal (klass, vt->klass);
+	cast_cache_store (cast_cache_entry (vt, klass), vt, klass, result);
+	return result;
+}
+
 /**
  * mono_object_isinst:
  * \param obj an object
@@ -7245,7 +7572,17 @@ mono_object_handle_isinst (MonoObjectHandle obj, MonoClass *klass, MonoError *er
 
 	MonoObjectHandle result = MONO_HANDLE_NEW (MonoObject, NULL);
 
-	if (!MONO_HANDLE_IS_NULL (obj) && mono_class_is_assignable_from_internal (klass, mono_handle_class (obj)))
+	if (MONO_HANDLE_IS_NULL (obj))
+		return result;
+
+	/* Array covariance */
+	if (m_class_get_rank (klass)) {
+		if (vtable_is_assignable_to_cached (MONO_HANDLE_GETVAL (obj, vtable), klass))
+			MONO_HANDLE_ASSIGN (result, obj);
+		return result;
+	}
+
+	if (mono_class_is_assignable_from_internal (klass, mono_handle_class (obj)))
 		MONO_HANDLE_ASSIGN (result, obj);
 	return result;
 }
@@ -7306,14 +7643,14 @@ mono_object_handle_isinst_mbyref_raw (MonoObjectHandle obj, MonoClass *klass, Mo
 
 		/* casting an array one of the invariant interfaces that must act as such */
 		if (m_class_is_array_special_interface (klass)) {
-			if (mono_class_is_assignable_from_internal (klass, vt->klass)) {
+			if (vtable_is_assignable_to_cached (vt, klass)) {
 				result = TRUE;
 				goto leave;
 			}
 		}
 
 		/*If the above check fails we are in the slow path of possibly raising an exception. So it's ok to it this way.*/
-		else if (mono_class_has_variant_generic_params (klass) && mono_class_is_assignable_from_internal (klass, mono_handle_class (obj))) {
+		else if (mono_class_has_variant_generic_params (klass) && vtable_is_assignable_to_cached (vt, klass)) {
 			result = TRUE;
 			goto leave;
 		}
@@ -7432,10 +7769,9 @@ mono_string_is_interned_lookup (MonoStringHandle str, gboolean insert, MonoError
 {
 	MONO_REQ_GC_UNSAFE_MODE;
 	
-	MonoGHashTable *ldstr_table = MONO_HANDLE_DOMAIN (str)->ldstr_table;
-	ldstr_lock ();
-	MonoString *res = (MonoString *)mono_g_hash_table_lookup (ldstr_table, MONO_HANDLE_RAW (str));
-	ldstr_unlock ();
+	MonoConcGHashTable *ldstr_table = MONO_HANDLE_DOMAIN (str)->ldstr_table;
+	/* Lookups are lock-free, only inserting a new string takes ldstr_lock */
+	MonoString *res = (MonoString *)mono_conc_g_hash_table_lookup (ldstr_table, MONO_HANDLE_RAW (str));
 	if (res)
 		return MONO_HANDLE_NEW (MonoString, res);
 	if (!insert)
@@ -7448,11 +7784,9 @@ mono_string_is_interned_lookup (MonoStringHandle str, gboolean insert, MonoError
 
 	// Try again inside lock.
 	ldstr_lock ();
-	res = (MonoString *)mono_g_hash_table_lookup (ldstr_table, MONO_HANDLE_RAW (str));
+	res = (MonoString *)mono_conc_g_hash_table_insert (ldstr_table, MONO_HANDLE_RAW (s), MONO_HANDLE_RAW (s));
 	if (res)
 		MONO_HANDLE_ASSIGN_RAW (s, res);
-	else
-		mono_g_hash_table_insert_internal (ldstr_table, MONO_HANDLE_RAW (s), MONO_HANDLE_RAW (s));
 	ldstr_unlock ();
 	return s;
 }
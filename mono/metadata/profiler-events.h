@@ -48,6 +48,7 @@ MONO_PROFILER_EVENT_2(domain_name, DomainName, MonoDomain *, domain, const char
 MONO_PROFILER_EVENT_1(jit_begin, JitBegin, MonoMethod *, method)
 MONO_PROFILER_EVENT_1(jit_failed, JitFailed, MonoMethod *, method)
 MONO_PROFILER_EVENT_2(jit_done, JitDone, MonoMethod *, method, MonoJitInfo *, jinfo)
+MONO_PROFILER_EVENT_2(jit_telemetry, JitTelemetry, MonoMethod *, method, const MonoProfilerJitTelemetry *, telemetry)
 MONO_PROFILER_EVENT_2(jit_chunk_created, JitChunkCreated, const mono_byte *, chunk, uintptr_t, size)
 MONO_PROFILER_EVENT_1(jit_chunk_destroyed, JitChunkDestroyed, const mono_byte *, chunk)
 MONO_PROFILER_EVENT_4(jit_code_buffer, JitCodeBuffer, const mono_byte *, buffer, uint64_t, size, MonoProfilerCodeBufferType, type, const void *, data)
@@ -84,6 +85,7 @@ MONO_PROFILER_EVENT_4(exception_clause, ExceptionClause, MonoMethod *, method, u
 
 MONO_PROFILER_EVENT_3(gc_event, GCEvent2, MonoProfilerGCEvent, event, uint32_t, generation, mono_bool, is_serial)
 MONO_PROFILER_EVENT_1(gc_allocation, GCAllocation, MonoObject *, object)
+MONO_PROFILER_EVENT_2(gc_allocation_sampled, GCAllocationSampled, MonoObject *, object, uint64_t, weight)
 MONO_PROFILER_EVENT_2(gc_moves, GCMoves, MonoObject *const *, objects, uint64_t, count)
 MONO_PROFILER_EVENT_1(gc_resize, GCResize, uintptr_t, size)
 MONO_PROFILER_EVENT_3(gc_handle_created, GCHandleCreated, uint32_t, handle, MonoGCHandleType, type, MonoObject *, object)
@@ -99,6 +101,7 @@ MONO_PROFILER_EVENT_3(gc_roots, GCRoots, uint64_t, count, const mono_byte *const
 MONO_PROFILER_EVENT_1(monitor_contention, MonitorContention, MonoObject *, object)
 MONO_PROFILER_EVENT_1(monitor_failed, MonitorFailed, MonoObject *, object)
 MONO_PROFILER_EVENT_1(monitor_acquired, MonitorAcquired, MonoObject *, object)
+MONO_PROFILER_EVENT_3(runtime_lock_contention, RuntimeLockContention, const char *, name, const void *, lock, uint64_t, wait_ns)
 
 MONO_PROFILER_EVENT_1(thread_started, ThreadStarted, uintptr_t, tid)
 MONO_PROFILER_EVENT_1(thread_stopping, ThreadStopping, uintptr_t, tid)
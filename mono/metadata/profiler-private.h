@@ -51,6 +51,7 @@ typedef struct {
 	MonoProfilerHandle profilers;
 
 	gboolean code_coverage;
+	gboolean coverage_hits;
 	mono_mutex_t coverage_mutex;
 	GHashTable *coverage_hash;
 
@@ -60,6 +61,7 @@ typedef struct {
 	guint32 sample_freq;
 
 	gboolean allocations;
+	guint32 allocation_sample_interval;
 
 	gboolean clauses;
 
@@ -151,12 +153,24 @@ mono_profiler_allocations_enabled (void)
 	return mono_profiler_state.allocations;
 }
 
+static inline gboolean
+mono_profiler_allocation_sampling_enabled (void)
+{
+	return mono_profiler_state.allocation_sample_interval != 0;
+}
+
 static inline gboolean
 mono_profiler_clauses_enabled (void)
 {
 	return mono_profiler_state.clauses;
 }
 
+static inline gboolean
+mono_profiler_coverage_hits_enabled (void)
+{
+	return mono_profiler_state.coverage_hits;
+}
+
 #define _MONO_PROFILER_EVENT(name, ...) \
 	ICALL_DECL_EXPORT void mono_profiler_raise_ ## name (__VA_ARGS__);
 #define MONO_PROFILER_EVENT_0(name, type) \
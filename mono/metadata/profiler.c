@@ -264,6 +264,30 @@ mono_profiler_enable_coverage (void)
 	return mono_profiler_state.code_coverage = TRUE;
 }
 
+/**
+ * mono_profiler_enable_coverage_hits:
+ *
+ * Makes code coverage instrumentation only record whether a sequence point was
+ * reached, instead of how many times. The counters reported by
+ * \c mono_profiler_get_coverage_data will then be either 0 or 1. This is much
+ * cheaper than counting, which needs an atomic increment at every sequence
+ * point. Returns \c TRUE if hit recording was enabled, or \c FALSE if the
+ * function was called too late for this to be possible.
+ *
+ * This function is \b not async safe.
+ *
+ * This function may \b only be called from a profiler's init function or prior
+ * to running managed code.
+ */
+mono_bool
+mono_profiler_enable_coverage_hits (void)
+{
+	if (mono_profiler_state.startup_done)
+		return FALSE;
+
+	return mono_profiler_state.coverage_hits = TRUE;
+}
+
 /**
  * mono_profiler_set_coverage_filter_callback:
  *
@@ -572,6 +596,37 @@ mono_profiler_enable_allocations (void)
 	return mono_profiler_state.allocations = TRUE;
 }
 
+/**
+ * mono_profiler_enable_allocation_sampling:
+ *
+ * Enables sampling of GC allocations. Each thread reports one allocation,
+ * through the \c gc_allocation_sampled event, for roughly every \p interval
+ * bytes it allocates. The distance between two samples is randomized so that
+ * allocation patterns don't line up with it. The \c weight argument of the
+ * event is the number of bytes the sample stands for. Unlike
+ * mono_profiler_enable_allocations, this does not disable the managed
+ * allocators, so it is cheap enough to leave on in production. Returns \c TRUE
+ * if allocation sampling was enabled, or \c FALSE if the function was called
+ * too late or the GC doesn't support it.
+ *
+ * This function is \b not async safe.
+ *
+ * This function may \b only be called from a profiler's init function or prior
+ * to running managed code.
+ */
+mono_bool
+mono_profiler_enable_allocation_sampling (uint32_t interval)
+{
+	if (mono_profiler_state.startup_done || !interval)
+		return FALSE;
+
+	if (!mono_gc_set_allocation_sample_interval (interval))
+		return FALSE;
+
+	mono_profiler_state.allocation_sample_interval = interval;
+	return TRUE;
+}
+
 /**
  * mono_profiler_enable_clauses:
  *
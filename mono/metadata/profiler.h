@@ -55,6 +55,7 @@ typedef mono_bool (*MonoProfilerCoverageFilterCallback) (MonoProfiler *prof, Mon
 typedef void (*MonoProfilerCoverageCallback) (MonoProfiler *prof, const MonoProfilerCoverageData *data);
 
 MONO_API mono_bool mono_profiler_enable_coverage (void);
+MONO_API mono_bool mono_profiler_enable_coverage_hits (void);
 MONO_API void mono_profiler_set_coverage_filter_callback (MonoProfilerHandle handle, MonoProfilerCoverageFilterCallback cb);
 MONO_API mono_bool mono_profiler_get_coverage_data (MonoProfilerHandle handle, MonoMethod *method, MonoProfilerCoverageCallback cb);
 
@@ -81,6 +82,7 @@ MONO_API mono_bool mono_profiler_set_sample_mode (MonoProfilerHandle handle, Mon
 MONO_API mono_bool mono_profiler_get_sample_mode (MonoProfilerHandle handle, MonoProfilerSampleMode *mode, uint32_t *freq);
 
 MONO_API mono_bool mono_profiler_enable_allocations (void);
+MONO_API mono_bool mono_profiler_enable_allocation_sampling (uint32_t interval);
 MONO_API mono_bool mono_profiler_enable_clauses (void);
 
 typedef struct _MonoProfilerCallContext MonoProfilerCallContext;
@@ -171,6 +173,25 @@ typedef enum {
 	MONO_GC_EVENT_POST_START_WORLD = 9,
 } MonoProfilerGCEvent;
 
+typedef struct {
+	/*
+	 * Time in nanoseconds spent compiling the method, and the part of it
+	 * spent in IL to IR conversion, SSA optimizations, register allocation
+	 * and native code generation.
+	 */
+	uint64_t total_time;
+	uint64_t method_to_ir_time;
+	uint64_t ssa_time;
+	uint64_t regalloc_time;
+	uint64_t codegen_time;
+	uint32_t il_size;
+	uint32_t native_size;
+	uint32_t inlined_methods;
+	uint32_t inline_failures;
+	/* 0 for quickly compiled code that will be recompiled if hot (--tiered), 1 otherwise. */
+	uint32_t tier;
+} MonoProfilerJitTelemetry;
+
 /*
  * The macros below will generate the majority of the callback API. Refer to
  * mono/metadata/profiler-events.h for a list of callbacks. They are expanded
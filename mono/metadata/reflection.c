@@ -499,12 +499,23 @@ mono_type_get_object_checked (MonoDomain *domain, MonoType *type, MonoError *err
 			return (MonoReflectionType *)vtable->type;
 	}
 
+	/*
+	 * Types without a vtable, byref types and types from dynamic images. Lookups
+	 * are lock free, the locks are only needed to create the object.
+	 */
+	MonoConcGHashTable *type_hash = domain->type_hash;
+	if (type_hash && (res = (MonoReflectionType *)mono_conc_g_hash_table_lookup (type_hash, type)))
+		return res;
+
 	mono_loader_lock (); /*FIXME mono_class_init_internal and mono_class_vtable acquire it*/
 	mono_domain_lock (domain);
-	if (!domain->type_hash)
-		domain->type_hash = mono_g_hash_table_new_type_internal ((GHashFunc)mono_metadata_type_hash, 
-				(GCompareFunc)mono_metadata_type_equal, MONO_HASH_VALUE_GC, MONO_ROOT_SOURCE_DOMAIN, domain, "Domain Reflection Type Table");
-	if ((res = (MonoReflectionType *)mono_g_hash_table_lookup (domain->type_hash, type))) {
+	if (!domain->type_hash) {
+		type_hash = mono_conc_g_hash_table_new_type ((GHashFunc)mono_metadata_type_hash,
+				(GEqualFunc)mono_metadata_type_equal, MONO_HASH_VALUE_GC, MONO_ROOT_SOURCE_DOMAIN, domain, "Domain Reflection Type Table");
+		mono_memory_barrier ();
+		domain->type_hash = type_hash;
+	}
+	if ((res = (MonoReflectionType *)mono_conc_g_hash_table_lookup (domain->type_hash, type))) {
 		mono_domain_unlock (domain);
 		mono_loader_unlock ();
 		return res;
@@ -525,7 +536,7 @@ mono_type_get_object_checked (MonoDomain *domain, MonoType *type, MonoError *err
 			mono_loader_unlock ();
 			return NULL;
 		}
-		mono_g_hash_table_insert_internal (domain->type_hash, type, res);
+		mono_conc_g_hash_table_insert (domain->type_hash, type, res);
 		mono_domain_unlock (domain);
 		mono_loader_unlock ();
 		return res;
@@ -568,7 +579,7 @@ mono_type_get_object_checked (MonoDomain *domain, MonoType *type, MonoError *err
 	}
 
 	res->type = type;
-	mono_g_hash_table_insert_internal (domain->type_hash, type, res);
+	mono_conc_g_hash_table_insert (domain->type_hash, type, res);
 
 	if (type->type == MONO_TYPE_VOID)
 		domain->typeof_void = (MonoObject*)res;
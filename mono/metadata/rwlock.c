@@ -0,0 +1,317 @@
+/**
+ * \file
+ * Runtime reader-writer lock
+ *
+ * Readers announce themselves on a per-CPU counter, each on its own cache line, so
+ * concurrent readers don't bounce a shared counter between cores. A writer first
+ * sets RWLOCK_WRITER, which turns new readers away, and then waits for the counters
+ * to drain. Readers only touch the shared state when a writer is around.
+ *
+ * Waiting is done on futexes on Linux, and on a mutex and condition variable per
+ * lock elsewhere. Waits are not alertable, like the ones of MonoCoopMutex.
+ *
+ * Licensed under the MIT license. See LICENSE file in the project root for full license information.
+ */
+
+#include <config.h>
+#include <glib.h>
+
+#if defined(HAVE_SCHED_GETCPU)
+#include <sched.h>
+#endif
+
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#if defined(SYS_futex)
+#define USE_FUTEX 1
+#endif
+#endif
+
+#include <mono/metadata/rwlock.h>
+#include <mono/utils/atomic.h>
+#include <mono/utils/mono-coop-mutex.h>
+#include <mono/utils/mono-proclib.h>
+#include <mono/utils/mono-threads.h>
+#include <mono/utils/mono-threads-api.h>
+
+#define RWLOCK_CACHE_LINE_SIZE 64
+#define RWLOCK_READERS_MAX 256
+
+enum {
+	/* A writer holds the lock, or is waiting for the readers to drain */
+	RWLOCK_WRITER = 1 << 0,
+	/* Somebody sleeps on state, so the writer has to wake them up on exit */
+	RWLOCK_WAITERS = 1 << 1,
+};
+
+typedef struct {
+	gint32 count;
+	char padding [RWLOCK_CACHE_LINE_SIZE - sizeof (gint32)];
+} MonoRWLockReaders;
+
+struct _MonoRWLock {
+	gint32 state;
+	/* Set by the writer while it waits for the readers to drain */
+	gint32 draining;
+	/* Bumped by the readers leaving while draining is set, the writer sleeps on it */
+	gint32 drain_seq;
+#if !defined(USE_FUTEX)
+	MonoCoopMutex mutex;
+	MonoCoopCond cond;
+#endif
+	/* Power of 2 */
+	gint32 readers_count;
+	MonoRWLockReaders *readers;
+	gpointer readers_alloc;
+};
+
+static void
+rwlock_wait (MonoRWLock *lock, gint32 *addr, gint32 val)
+{
+#if defined(USE_FUTEX)
+	MONO_ENTER_GC_SAFE;
+	/* Spurious returns, EINTR and EAGAIN included, are fine: the callers check again */
+	syscall (SYS_futex, addr, FUTEX_WAIT_PRIVATE, val, NULL, NULL, 0);
+	MONO_EXIT_GC_SAFE;
+#else
+	mono_coop_mutex_lock (&lock->mutex);
+	while (mono_atomic_load_i32 (addr) == val)
+		mono_coop_cond_wait (&lock->cond, &lock->mutex);
+	mono_coop_mutex_unlock (&lock->mutex);
+#endif
+}
+
+static void
+rwlock_wake (MonoRWLock *lock, gint32 *addr, gboolean all)
+{
+#if defined(USE_FUTEX)
+	syscall (SYS_futex, addr, FUTEX_WAKE_PRIVATE, all ? G_MAXINT32 : 1, NULL, NULL, 0);
+#else
+	/* Taking the mutex orders this against the check in rwlock_wait () */
+	mono_coop_mutex_lock (&lock->mutex);
+	mono_coop_cond_broadcast (&lock->cond);
+	mono_coop_mutex_unlock (&lock->mutex);
+#endif
+}
+
+static gint32
+rwlock_reader_slot (MonoRWLock *lock)
+{
+#if defined(HAVE_SCHED_GETCPU)
+	int cpu = sched_getcpu ();
+	if (cpu >= 0)
+		return cpu & (lock->readers_count - 1);
+#endif
+	return mono_thread_info_get_small_id () & (lock->readers_count - 1);
+}
+
+static gint32
+rwlock_readers_sum (MonoRWLock *lock)
+{
+	gint32 i, sum = 0;
+
+	for (i = 0; i < lock->readers_count; ++i)
+		sum += mono_atomic_load_i32 (&lock->readers [i].count);
+
+	return sum;
+}
+
+/* Wait until @state changes, telling the writer holding the lock to wake us up */
+static void
+rwlock_wait_state (MonoRWLock *lock, gint32 state)
+{
+	if (!(state & RWLOCK_WAITERS)) {
+		if (mono_atomic_cas_i32 (&lock->state, state | RWLOCK_WAITERS, state) != state)
+			return;
+		state |= RWLOCK_WAITERS;
+	}
+
+	rwlock_wait (lock, &lock->state, state);
+}
+
+MonoRWLock*
+mono_rwlock_new (void)
+{
+	MonoRWLock *lock;
+	gint32 count;
+
+	lock = g_new0 (MonoRWLock, 1);
+
+	for (count = 1; count < MIN (mono_cpu_count (), RWLOCK_READERS_MAX); count <<= 1)
+		;
+
+	lock->readers_count = count;
+	lock->readers_alloc = g_malloc0 (count * sizeof (MonoRWLockReaders) + RWLOCK_CACHE_LINE_SIZE);
+	lock->readers = (MonoRWLockReaders *)(((gsize)lock->readers_alloc + RWLOCK_CACHE_LINE_SIZE - 1) & ~(gsize)(RWLOCK_CACHE_LINE_SIZE - 1));
+
+#if !defined(USE_FUTEX)
+	mono_coop_mutex_init (&lock->mutex);
+	mono_coop_cond_init (&lock->cond);
+#endif
+
+	return lock;
+}
+
+void
+mono_rwlock_free (MonoRWLock *lock)
+{
+	g_assert (lock->state == 0);
+	g_assert (rwlock_readers_sum (lock) == 0);
+
+#if !defined(USE_FUTEX)
+	mono_coop_cond_destroy (&lock->cond);
+	mono_coop_mutex_destroy (&lock->mutex);
+#endif
+
+	g_free (lock->readers_alloc);
+	g_free (lock);
+}
+
+/*
+ * mono_rwlock_enter_read:
+ *
+ *   Take @lock for reading. Returns the slot to pass to mono_rwlock_exit_read (), as
+ * the thread can migrate to another CPU while it holds the lock.
+ */
+gint32
+mono_rwlock_enter_read (MonoRWLock *lock)
+{
+	for (;;) {
+		gint32 slot, state;
+
+		slot = rwlock_reader_slot (lock);
+		mono_atomic_inc_i32 (&lock->readers [slot].count);
+
+		/* The increment is a full barrier, so either we see the writer or it sees us */
+		state = mono_atomic_load_i32 (&lock->state);
+		if (G_LIKELY (!(state & RWLOCK_WRITER)))
+			return slot;
+
+		/* Let the writer through */
+		mono_rwlock_exit_read (lock, slot);
+
+		while ((state = mono_atomic_load_i32 (&lock->state)) & RWLOCK_WRITER)
+			rwlock_wait_state (lock, state);
+	}
+}
+
+void
+mono_rwlock_exit_read (MonoRWLock *lock, gint32 slot)
+{
+	g_assert (slot >= 0 && slot < lock->readers_count);
+
+	mono_atomic_dec_i32 (&lock->readers [slot].count);
+
+	if (G_UNLIKELY (mono_atomic_load_i32 (&lock->draining))) {
+		mono_atomic_inc_i32 (&lock->drain_seq);
+		rwlock_wake (lock, &lock->drain_seq, FALSE);
+	}
+}
+
+static void
+rwlock_drain_readers (MonoRWLock *lock)
+{
+	mono_atomic_xchg_i32 (&lock->draining, 1);
+
+	for (;;) {
+		gint32 seq = mono_atomic_load_i32 (&lock->drain_seq);
+		if (rwlock_readers_sum (lock) == 0)
+			break;
+		rwlock_wait (lock, &lock->drain_seq, seq);
+	}
+
+	mono_atomic_xchg_i32 (&lock->draining, 0);
+}
+
+gboolean
+mono_rwlock_try_enter_write (MonoRWLock *lock)
+{
+	if (mono_atomic_load_i32 (&lock->state) & RWLOCK_WRITER)
+		return FALSE;
+	if (rwlock_readers_sum (lock) != 0)
+		return FALSE;
+	if (mono_atomic_cas_i32 (&lock->state, RWLOCK_WRITER, 0) != 0)
+		return FALSE;
+
+	if (rwlock_readers_sum (lock) != 0) {
+		/* A reader got in meanwhile */
+		mono_rwlock_exit_write (lock);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+void
+mono_rwlock_enter_write (MonoRWLock *lock)
+{
+	for (;;) {
+		gint32 state = mono_atomic_load_i32 (&lock->state);
+
+		if (!(state & RWLOCK_WRITER)) {
+			if (mono_atomic_cas_i32 (&lock->state, state | RWLOCK_WRITER, state) == state)
+				break;
+			continue;
+		}
+
+		rwlock_wait_state (lock, state);
+	}
+
+	rwlock_drain_readers (lock);
+}
+
+void
+mono_rwlock_exit_write (MonoRWLock *lock)
+{
+	gint32 state;
+
+	state = mono_atomic_xchg_i32 (&lock->state, 0);
+	g_assert (state & RWLOCK_WRITER);
+
+	if (state & RWLOCK_WAITERS)
+		rwlock_wake (lock, &lock->state, TRUE);
+}
+
+gpointer
+ves_icall_System_Threading_ReaderWriterLockSlim_CreateNativeLock (void)
+{
+	return mono_rwlock_new ();
+}
+
+void
+ves_icall_System_Threading_ReaderWriterLockSlim_DestroyNativeLock (gpointer lock)
+{
+	mono_rwlock_free ((MonoRWLock *)lock);
+}
+
+gint32
+ves_icall_System_Threading_ReaderWriterLockSlim_EnterReadNative (gpointer lock)
+{
+	return mono_rwlock_enter_read ((MonoRWLock *)lock);
+}
+
+void
+ves_icall_System_Threading_ReaderWriterLockSlim_EnterWriteNative (gpointer lock)
+{
+	mono_rwlock_enter_write ((MonoRWLock *)lock);
+}
+
+void
+ves_icall_System_Threading_ReaderWriterLockSlim_ExitReadNative (gpointer lock, gint32 slot)
+{
+	mono_rwlock_exit_read ((MonoRWLock *)lock, slot);
+}
+
+void
+ves_icall_System_Threading_ReaderWriterLockSlim_ExitWriteNative (gpointer lock)
+{
+	mono_rwlock_exit_write ((MonoRWLock *)lock);
+}
+
+MonoBoolean
+ves_icall_System_Threading_ReaderWriterLockSlim_TryEnterWriteNative (gpointer lock)
+{
+	return mono_rwlock_try_enter_write ((MonoRWLock *)lock);
+}
@@ -0,0 +1,65 @@
+/**
+ * \file
+ * Runtime reader-writer lock
+ *
+ * Licensed under the MIT license. See LICENSE file in the project root for full license information.
+ */
+
+#ifndef _MONO_METADATA_RWLOCK_H_
+#define _MONO_METADATA_RWLOCK_H_
+
+#include <glib.h>
+#include <mono/metadata/icalls.h>
+
+typedef struct _MonoRWLock MonoRWLock;
+
+MonoRWLock*
+mono_rwlock_new (void);
+
+void
+mono_rwlock_free (MonoRWLock *lock);
+
+gint32
+mono_rwlock_enter_read (MonoRWLock *lock);
+
+void
+mono_rwlock_exit_read (MonoRWLock *lock, gint32 slot);
+
+void
+mono_rwlock_enter_write (MonoRWLock *lock);
+
+gboolean
+mono_rwlock_try_enter_write (MonoRWLock *lock);
+
+void
+mono_rwlock_exit_write (MonoRWLock *lock);
+
+ICALL_EXPORT
+gpointer
+ves_icall_System_Threading_ReaderWriterLockSlim_CreateNativeLock (void);
+
+ICALL_EXPORT
+void
+ves_icall_System_Threading_ReaderWriterLockSlim_DestroyNativeLock (gpointer lock);
+
+ICALL_EXPORT
+gint32
+ves_icall_System_Threading_ReaderWriterLockSlim_EnterReadNative (gpointer lock);
+
+ICALL_EXPORT
+void
+ves_icall_System_Threading_ReaderWriterLockSlim_EnterWriteNative (gpointer lock);
+
+ICALL_EXPORT
+void
+ves_icall_System_Threading_ReaderWriterLockSlim_ExitReadNative (gpointer lock, gint32 slot);
+
+ICALL_EXPORT
+void
+ves_icall_System_Threading_ReaderWriterLockSlim_ExitWriteNative (gpointer lock);
+
+ICALL_EXPORT
+MonoBoolean
+ves_icall_System_Threading_ReaderWriterLockSlim_TryEnterWriteNative (gpointer lock);
+
+#endif /* _MONO_METADATA_RWLOCK_H_ */
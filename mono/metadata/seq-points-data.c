@@ -271,27 +271,181 @@ mono_seq_point_find_by_il_offset (MonoSeqPointInfo* info, int il_offset, SeqPoin
 void
 mono_seq_point_init_next (MonoSeqPointInfo* info, SeqPoint sp, SeqPoint* next)
 {
-	int i;
+	int i, pos, max_index = -1, found = 0;
+	int indexes_buf [16];
+	int *indexes = indexes_buf;
 	guint8* ptr;
 	SeqPointIterator it;
-	GArray* seq_points = g_array_new (FALSE, TRUE, sizeof (SeqPoint));
 	SeqPointInfoInflated info_inflated = seq_point_info_inflate (info);
 
 	g_assert (info_inflated.has_debug_data);
 
+	if (sp.next_len > (int)G_N_ELEMENTS (indexes_buf))
+		indexes = g_new (int, sp.next_len);
+
+	ptr = info_inflated.data + sp.next_offset;
+	for (i = 0; i < sp.next_len; i++) {
+		indexes [i] = decode_var_int (ptr, &ptr);
+		max_index = MAX (max_index, indexes [i]);
+	}
+
+	/* Seq points can only be decoded in order, but there is no need to go past the last successor */
+	pos = 0;
+	mono_seq_point_iterator_init (&it, info);
+	while (pos <= max_index && mono_seq_point_iterator_next (&it)) {
+		for (i = 0; i < sp.next_len; i++) {
+			if (indexes [i] == pos) {
+				memcpy (&next[i], &it.seq_point, sizeof (SeqPoint));
+				found ++;
+			}
+		}
+		pos ++;
+	}
+	g_assert (found == sp.next_len);
+
+	if (indexes != indexes_buf)
+		g_free (indexes);
+}
+
+static int
+seq_point_il_offset_compare (const void *a, const void *b, gpointer user_data)
+{
+	SeqPoint *seq_points = (SeqPoint*)user_data;
+	int ia = *(const int*)a;
+	int ib = *(const int*)b;
+	int il_a = seq_points [ia].il_offset;
+	int il_b = seq_points [ib].il_offset;
+
+	if (il_a != il_b)
+		return il_a < il_b ? -1 : 1;
+	return ia - ib;
+}
+
+MonoSeqPointIndex*
+mono_seq_point_index_new (MonoSeqPointInfo *info)
+{
+	MonoSeqPointIndex *index;
+	SeqPointIterator it;
+	SeqPointInfoInflated info_inflated = seq_point_info_inflate (info);
+	GArray *seq_points = g_array_new (FALSE, FALSE, sizeof (SeqPoint));
+	int i;
+
 	mono_seq_point_iterator_init (&it, info);
 	while (mono_seq_point_iterator_next (&it))
 		g_array_append_vals (seq_points, &it.seq_point, 1);
 
-	ptr = info_inflated.data + sp.next_offset;
-	for (i = 0; i < sp.next_len; i++) {
-		int next_index;
-		next_index = decode_var_int (ptr, &ptr);
-		g_assert (next_index < seq_points->len);
-		memcpy (&next[i], seq_points->data + next_index * sizeof (SeqPoint), sizeof (SeqPoint));
+	index = g_new0 (MonoSeqPointIndex, 1);
+	index->len = seq_points->len;
+	index->has_debug_data = info_inflated.has_debug_data;
+	index->data = info_inflated.data;
+	index->seq_points = (SeqPoint*)g_array_free (seq_points, FALSE);
+	index->max_native_offset = g_new (int, index->len);
+	index->by_il_offset = g_new (int, index->len);
+	for (i = 0; i < index->len; ++i) {
+		int native_offset = index->seq_points [i].native_offset;
+
+		index->max_native_offset [i] = i > 0 ? MAX (index->max_native_offset [i - 1], native_offset) : native_offset;
+		index->by_il_offset [i] = i;
+	}
+	g_qsort_with_data (index->by_il_offset, index->len, sizeof (int), seq_point_il_offset_compare, index->seq_points);
+
+	return index;
+}
+
+void
+mono_seq_point_index_free (gpointer ptr)
+{
+	MonoSeqPointIndex *index = (MonoSeqPointIndex*)ptr;
+
+	g_free (index->seq_points);
+	g_free (index->max_native_offset);
+	g_free (index->by_il_offset);
+	g_free (index);
+}
+
+/*
+ * Index of the first seq point with a native offset greater than NATIVE_OFFSET, or
+ * greater than or equal to it if INCLUSIVE.  Seq points are mostly ordered by native
+ * offset, but the ones in dead code have SEQ_POINT_NATIVE_OFFSET_DEAD_CODE, so this
+ * searches the running maximum of the native offsets, which gives the same answers
+ * as a linear scan.
+ */
+static int
+seq_point_index_search (MonoSeqPointIndex *index, int native_offset, gboolean inclusive)
+{
+	int lo = 0, hi = index->len;
+
+	while (lo < hi) {
+		int mid = lo + (hi - lo) / 2;
+		int max = index->max_native_offset [mid];
+
+		if (max < native_offset || (!inclusive && max == native_offset))
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+gboolean
+mono_seq_point_index_find_prev_by_native_offset (MonoSeqPointIndex *index, int native_offset, SeqPoint *seq_point)
+{
+	int pos = seq_point_index_search (index, native_offset, FALSE);
+
+	if (pos == 0)
+		return FALSE;
+
+	*seq_point = index->seq_points [pos - 1];
+	return TRUE;
+}
+
+gboolean
+mono_seq_point_index_find_next_by_native_offset (MonoSeqPointIndex *index, int native_offset, SeqPoint *seq_point)
+{
+	int pos = seq_point_index_search (index, native_offset, TRUE);
+
+	if (pos == index->len)
+		return FALSE;
+
+	*seq_point = index->seq_points [pos];
+	return TRUE;
+}
+
+gboolean
+mono_seq_point_index_find_by_il_offset (MonoSeqPointIndex *index, int il_offset, SeqPoint *seq_point)
+{
+	int lo = 0, hi = index->len;
+
+	while (lo < hi) {
+		int mid = lo + (hi - lo) / 2;
+
+		if (index->seq_points [index->by_il_offset [mid]].il_offset < il_offset)
+			lo = mid + 1;
+		else
+			hi = mid;
 	}
+	if (lo == index->len || index->seq_points [index->by_il_offset [lo]].il_offset != il_offset)
+		return FALSE;
+
+	*seq_point = index->seq_points [index->by_il_offset [lo]];
+	return TRUE;
+}
 
-	g_array_free (seq_points, TRUE);
+void
+mono_seq_point_index_init_next (MonoSeqPointIndex *index, SeqPoint *sp, SeqPoint *next)
+{
+	guint8 *ptr;
+	int i;
+
+	g_assert (index->has_debug_data);
+
+	ptr = index->data + sp->next_offset;
+	for (i = 0; i < sp->next_len; i++) {
+		int next_index = decode_var_int (ptr, &ptr);
+
+		g_assert (next_index < index->len);
+		next [i] = index->seq_points [next_index];
+	}
 }
 
 gboolean
@@ -78,6 +78,43 @@ mono_seq_point_find_next_by_native_offset (MonoSeqPointInfo* info, int native_of
 gboolean
 mono_seq_point_find_by_il_offset (MonoSeqPointInfo* info, int il_offset, SeqPoint* seq_point);
 
+/*
+ * MonoSeqPointIndex:
+ *
+ *   A decoded copy of a MonoSeqPointInfo, for random access: lookups by native
+ * or IL offset are binary searches and successors are indexed directly.  It references the data of the info it
+ * was created from, so it must not outlive it.
+ */
+typedef struct {
+	int len;
+	gboolean has_debug_data;
+	/* In the order of the info, which is by native offset */
+	SeqPoint *seq_points;
+	/* The largest native offset of seq_points [0 .. i] */
+	int *max_native_offset;
+	/* Indexes into seq_points, sorted by IL offset, then by position */
+	int *by_il_offset;
+	guint8 *data;
+} MonoSeqPointIndex;
+
+MonoSeqPointIndex*
+mono_seq_point_index_new (MonoSeqPointInfo *info);
+
+void
+mono_seq_point_index_free (gpointer index);
+
+gboolean
+mono_seq_point_index_find_prev_by_native_offset (MonoSeqPointIndex *index, int native_offset, SeqPoint *seq_point);
+
+gboolean
+mono_seq_point_index_find_next_by_native_offset (MonoSeqPointIndex *index, int native_offset, SeqPoint *seq_point);
+
+gboolean
+mono_seq_point_index_find_by_il_offset (MonoSeqPointIndex *index, int il_offset, SeqPoint *seq_point);
+
+void
+mono_seq_point_index_init_next (MonoSeqPointIndex *index, SeqPoint *sp, SeqPoint *next);
+
 /*
  * SeqPointData struct and functions
  * This is used to store/load/use sequence point from a file
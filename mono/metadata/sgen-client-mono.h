@@ -74,6 +74,9 @@ extern void mono_sgen_init_stw (void);
 
 enum {
 	INTERNAL_MEM_EPHEMERON_LINK = INTERNAL_MEM_FIRST_CLIENT,
+	INTERNAL_MEM_EPHEMERON_PENDING_TABLE,
+	INTERNAL_MEM_EPHEMERON_PENDING_TABLE_ENTRY,
+	INTERNAL_MEM_EPHEMERON_PENDING,
 	INTERNAL_MEM_MOVED_OBJECT,
 	INTERNAL_MEM_MAX
 };
@@ -120,7 +120,18 @@ emit_nursery_check_ilgen (MonoMethodBuilder *mb, gboolean is_concurrent)
 {
 #ifdef MANAGED_WBARRIER
 	int i, nursery_check_labels [2];
+	int card_table_shift_bits;
+	target_mgreg_t card_table_mask;
+
 	emit_nursery_check (mb, nursery_check_labels, is_concurrent);
+
+	if (!sgen_get_target_card_table_configuration (&card_table_shift_bits, &card_table_mask)) {
+		/* The remembered set doesn't want cards marked from managed code */
+		mono_mb_emit_ldarg (mb, 0);
+		mono_mb_emit_icall (mb, mono_gc_wbarrier_generic_nostore_internal);
+		goto done;
+	}
+
 	/*
 	addr = sgen_cardtable + ((address >> CARD_BITS) & CARD_MASK)
 	*addr = 1;
@@ -159,6 +170,7 @@ emit_nursery_check_ilgen (MonoMethodBuilder *mb, gboolean is_concurrent)
 	mono_mb_emit_icon (mb, 1);
 	mono_mb_emit_byte (mb, CEE_STIND_I1);
 
+done:
 	// return;
 	for (i = 0; i < 2; ++i) {
 		if (nursery_check_labels [i])
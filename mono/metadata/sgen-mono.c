@@ -35,6 +35,7 @@
 #include "utils/mono-logger-internals.h"
 #include "utils/mono-threads-coop.h"
 #include "utils/mono-threads.h"
+#include "utils/mono-time.h"
 #include "metadata/w32handle.h"
 #include "icall-signatures.h"
 
@@ -548,6 +549,8 @@ typedef struct _EphemeronLinkNode EphemeronLinkNode;
 struct _EphemeronLinkNode {
 	EphemeronLinkNode *next;
 	MonoArray *array;
+	/* Whether the entries of the array were scanned during the current collection */
+	gboolean scanned;
 };
 
 typedef struct {
@@ -557,6 +560,25 @@ typedef struct {
 
 static EphemeronLinkNode *ephemeron_list;
 
+/*
+ * An ephemeron entry whose key was not reachable yet when its array was
+ * scanned.  They are chained per key in ephemeron_pending_hash.  When the
+ * collector marks a pending key, sgen_client_object_marked () moves its
+ * entries to ephemeron_ready_list, so each round only visits the entries
+ * whose key just became reachable.
+ */
+typedef struct _EphemeronPending EphemeronPending;
+
+struct _EphemeronPending {
+	EphemeronPending *next;
+	Ephemeron *entry;
+	EphemeronLinkNode *link;
+};
+
+/* key -> EphemeronPending*, only populated during a collection */
+static SgenHashTable ephemeron_pending_hash = SGEN_HASH_TABLE_INIT (INTERNAL_MEM_EPHEMERON_PENDING_TABLE, INTERNAL_MEM_EPHEMERON_PENDING_TABLE_ENTRY, sizeof (EphemeronPending*), mono_aligned_addr_hash, NULL);
+static EphemeronPending *ephemeron_ready_list;
+
 /* LOCKING: requires that the GC lock is held */
 static MONO_PERMIT (need (sgen_gc_locked)) void
 null_ephemerons_for_domain (MonoDomain *domain)
@@ -586,6 +608,16 @@ null_ephemerons_for_domain (MonoDomain *domain)
 	}
 }
 
+static void
+free_pending_ephemerons (EphemeronPending *pending)
+{
+	while (pending) {
+		EphemeronPending *next = pending->next;
+		sgen_free_internal (pending, INTERNAL_MEM_EPHEMERON_PENDING);
+		pending = next;
+	}
+}
+
 /* LOCKING: requires that the GC lock is held */
 void
 sgen_client_clear_unreachable_ephemerons (ScanCopyContext ctx)
@@ -595,10 +627,22 @@ sgen_client_clear_unreachable_ephemerons (ScanCopyContext ctx)
 	EphemeronLinkNode *current = ephemeron_list, *prev = NULL;
 	Ephemeron *cur, *array_end;
 	GCObject *tombstone;
+	GCObject *key;
+	EphemeronPending **pending;
+
+	SGEN_ASSERT (0, !sgen_report_marked_objects && !ephemeron_ready_list, "Why are we clearing ephemerons before marking them is done?");
+
+	/* Whatever is still pending has an unreachable key, which is cleared below */
+	SGEN_HASH_TABLE_FOREACH (&ephemeron_pending_hash, GCObject *, key, EphemeronPending **, pending) {
+		free_pending_ephemerons (*pending);
+	} SGEN_HASH_TABLE_FOREACH_END;
+	sgen_hash_table_clean (&ephemeron_pending_hash);
 
 	while (current) {
 		MonoArray *array = current->array;
 
+		current->scanned = FALSE;
+
 		if (!sgen_is_object_alive_for_current_gen ((GCObject*)array)) {
 			EphemeronLinkNode *tmp = current;
 
@@ -625,7 +669,7 @@ sgen_client_clear_unreachable_ephemerons (ScanCopyContext ctx)
 		tombstone = SGEN_LOAD_VTABLE ((GCObject*)array)->domain->ephemeron_tombstone;
 
 		for (; cur < array_end; ++cur) {
-			GCObject *key = cur->key;
+			key = cur->key;
 
 			if (!key || key == tombstone)
 				continue;
@@ -645,9 +689,60 @@ sgen_client_clear_unreachable_ephemerons (ScanCopyContext ctx)
 	}
 }
 
+/*
+ * Marks the key and value of an ephemeron entry whose key is reachable.
+ * Returns whether the value was not reachable before.
+ */
+static gboolean
+mark_ephemeron (Ephemeron *entry, EphemeronLinkNode *link, CopyOrMarkObjectFunc copy_func, SgenGrayQueue *queue)
+{
+	GCObject *key = entry->key;
+	GCObject *value = entry->value;
+	gboolean marked = FALSE;
+
+	copy_func (&entry->key, queue);
+	if (value) {
+		if (!sgen_is_object_alive_for_current_gen (value)) {
+			marked = TRUE;
+			sgen_binary_protocol_ephemeron_ref (link, key, value);
+		}
+		copy_func (&entry->value, queue);
+	}
+	return marked;
+}
+
+/*
+ * Moves the pending entries of OBJ, if it is an ephemeron key, to the ready list.
+ */
+void
+sgen_client_object_marked (GCObject *obj)
+{
+	EphemeronPending **pending = (EphemeronPending **)sgen_hash_table_lookup (&ephemeron_pending_hash, obj);
+	EphemeronPending *last;
+
+	if (!pending)
+		return;
+
+	SGEN_LOG (5, "Pending ephemeron key %p became reachable", obj);
+
+	for (last = *pending; last->next; last = last->next)
+		;
+	last->next = ephemeron_ready_list;
+	ephemeron_ready_list = *pending;
+	sgen_hash_table_remove (&ephemeron_pending_hash, obj, NULL);
+}
+
 /*
 LOCKING: requires that the GC lock is held
 
+Each ephemeron array is scanned once per collection, as soon as it is found to be
+reachable.  Entries with a reachable key are marked right away, the others are
+queued by key in ephemeron_pending_hash.  While the rounds run, the collector
+reports the objects it marks, which moves the entries of pending keys to the
+ready list, so a round only visits the entries whose key became reachable since
+the previous one.  Objects marked between two series of rounds aren't reported,
+so the first round of a series checks all the pending keys once.
+
 Limitations: We scan all ephemerons on every collection since the current design doesn't allow for a simple nursery/mature split.
 */
 gboolean
@@ -659,9 +754,33 @@ sgen_client_mark_ephemerons (ScanCopyContext ctx)
 	EphemeronLinkNode *current = ephemeron_list;
 	Ephemeron *cur, *array_end;
 	GCObject *tombstone;
+	GCObject *key;
+	EphemeronPending **pending;
+
+	if (!sgen_report_marked_objects) {
+		SGEN_HASH_TABLE_FOREACH (&ephemeron_pending_hash, GCObject *, key, EphemeronPending **, pending) {
+			EphemeronPending *last;
+
+			if (!sgen_is_object_alive_for_current_gen (key))
+				continue;
+
+			for (last = *pending; last->next; last = last->next)
+				;
+			last->next = ephemeron_ready_list;
+			ephemeron_ready_list = *pending;
+			SGEN_HASH_TABLE_FOREACH_REMOVE (TRUE);
+			continue;
+		} SGEN_HASH_TABLE_FOREACH_END;
+
+		sgen_report_marked_objects = TRUE;
+	}
 
 	for (current = ephemeron_list; current; current = current->next) {
 		MonoArray *array = current->array;
+
+		if (current->scanned)
+			continue;
+
 		SGEN_LOG (5, "Ephemeron array at %p", array);
 
 		/*It has to be alive*/
@@ -670,14 +789,19 @@ sgen_client_mark_ephemerons (ScanCopyContext ctx)
 			continue;
 		}
 
+		/*
+		 * The array is only copied once per collection, so the entries
+		 * queued below stay valid until the end of the collection.
+		 */
 		copy_func ((GCObject**)&array, queue);
+		current->scanned = TRUE;
 
 		cur = mono_array_addr_internal (array, Ephemeron, 0);
 		array_end = cur + mono_array_length_internal (array);
 		tombstone = SGEN_LOAD_VTABLE ((GCObject*)array)->domain->ephemeron_tombstone;
 
 		for (; cur < array_end; ++cur) {
-			GCObject *key = cur->key;
+			key = cur->key;
 
 			if (!key || key == tombstone)
 				continue;
@@ -687,20 +811,39 @@ sgen_client_mark_ephemerons (ScanCopyContext ctx)
 				cur->value, cur->value && sgen_is_object_alive_for_current_gen (cur->value) ? "reachable" : "unreachable");
 
 			if (sgen_is_object_alive_for_current_gen (key)) {
-				GCObject *value = cur->value;
-
-				copy_func (&cur->key, queue);
-				if (value) {
-					if (!sgen_is_object_alive_for_current_gen (value)) {
-						nothing_marked = FALSE;
-						sgen_binary_protocol_ephemeron_ref (current, key, value);
-					}
-					copy_func (&cur->value, queue);
+				if (mark_ephemeron (cur, current, copy_func, queue))
+					nothing_marked = FALSE;
+			} else {
+				EphemeronPending *entry = (EphemeronPending *)sgen_alloc_internal (INTERNAL_MEM_EPHEMERON_PENDING);
+				EphemeronPending **head = (EphemeronPending **)sgen_hash_table_lookup (&ephemeron_pending_hash, key);
+
+				entry->entry = cur;
+				entry->link = current;
+				if (head) {
+					entry->next = *head;
+					*head = entry;
+				} else {
+					entry->next = NULL;
+					sgen_hash_table_replace (&ephemeron_pending_hash, key, &entry, NULL);
 				}
 			}
 		}
 	}
 
+	/* Marking the values can add more entries to the ready list */
+	while (ephemeron_ready_list) {
+		EphemeronPending *entry = ephemeron_ready_list;
+
+		ephemeron_ready_list = entry->next;
+		if (mark_ephemeron (entry->entry, entry->link, copy_func, queue))
+			nothing_marked = FALSE;
+		sgen_free_internal (entry, INTERNAL_MEM_EPHEMERON_PENDING);
+	}
+
+	/* Nothing was marked, so the gray stack is empty and no key can be marked anymore in this series */
+	if (nothing_marked)
+		sgen_report_marked_objects = FALSE;
+
 	SGEN_LOG (5, "Ephemeron run finished. Is it done %d", nothing_marked);
 	return nothing_marked;
 }
@@ -718,6 +861,7 @@ mono_gc_ephemeron_array_add (MonoObject *obj)
 		return FALSE;
 	}
 	node->array = (MonoArray*)obj;
+	node->scanned = FALSE;
 	node->next = ephemeron_list;
 	ephemeron_list = node;
 
@@ -829,6 +973,8 @@ sgen_finish_concurrent_work (const char *reason, gboolean stw)
  * structures to know the object size and the reference bitmap: once the domain is
  * unloaded the point to random memory.
  */
+static gboolean walk_heap_slice (gint64 deadline);
+
 void
 mono_gc_clear_domain (MonoDomain * domain)
 {
@@ -841,12 +987,18 @@ mono_gc_clear_domain (MonoDomain * domain)
 
 	sgen_stop_world (0, FALSE);
 
+	walk_heap_slice (0);
+
 	sgen_finish_concurrent_work ("clear domain", FALSE);
 
 	sgen_process_fin_stage_entries ();
 
 	sgen_clear_nursery_fragments ();
 
+	/* Remembered locations might be inside the objects we are about to free */
+	if (sgen_get_remset ()->spill_to_cards)
+		sgen_get_remset ()->spill_to_cards ();
+
 	FOREACH_THREAD_ALL (info) {
 		mono_handle_stack_free_domain (info->client_info.info.handle_stack, domain);
 	} FOREACH_THREAD_END
@@ -915,6 +1067,20 @@ mono_gc_clear_domain (MonoDomain * domain)
  * Allocation
  */
 
+/*
+ * The sample itself is taken by the allocator when the thread refills its
+ * TLAB, but we can only hand the object to the profiler once it's been
+ * initialized.
+ */
+static void
+report_allocation_sample (MonoObject *obj)
+{
+	guint64 weight = sgen_take_allocation_sample ();
+
+	if (weight)
+		MONO_PROFILER_RAISE (gc_allocation_sampled, (obj, weight));
+}
+
 MonoObject*
 mono_gc_alloc_obj (MonoVTable *vtable, size_t size)
 {
@@ -922,6 +1088,8 @@ mono_gc_alloc_obj (MonoVTable *vtable, size_t size)
 
 	if (G_UNLIKELY (mono_profiler_allocations_enabled ()) && obj)
 		MONO_PROFILER_RAISE (gc_allocation, (obj));
+	if (G_UNLIKELY (mono_profiler_allocation_sampling_enabled ()) && obj)
+		report_allocation_sample (obj);
 
 	return obj;
 }
@@ -933,6 +1101,8 @@ mono_gc_alloc_pinned_obj (MonoVTable *vtable, size_t size)
 
 	if (G_UNLIKELY (mono_profiler_allocations_enabled ()) && obj)
 		MONO_PROFILER_RAISE (gc_allocation, (obj));
+	if (G_UNLIKELY (mono_profiler_allocation_sampling_enabled ()) && obj)
+		report_allocation_sample (obj);
 
 	return obj;
 }
@@ -944,6 +1114,8 @@ mono_gc_alloc_mature (MonoVTable *vtable, size_t size)
 
 	if (G_UNLIKELY (mono_profiler_allocations_enabled ()) && obj)
 		MONO_PROFILER_RAISE (gc_allocation, (obj));
+	if (G_UNLIKELY (mono_profiler_allocation_sampling_enabled ()) && obj)
+		report_allocation_sample (obj);
 
 	return obj;
 }
@@ -1095,6 +1267,25 @@ mono_gc_get_managed_allocator (MonoClass *klass, gboolean for_box, gboolean know
 #endif
 }
 
+/*
+ * mono_gc_can_inline_managed_allocator:
+ *
+ *   Return whenever the JIT can inline the allocators returned by
+ * mono_gc_get_managed_allocator () into their callers.  This is only safe if
+ * they mark the allocation with the critical region flag, since the suspend
+ * code can't tell from the ip that a thread is in the middle of an inlined
+ * allocation.
+ */
+gboolean
+mono_gc_can_inline_managed_allocator (void)
+{
+#if defined (MANAGED_ALLOCATION) && defined (MANAGED_ALLOCATOR_CAN_USE_CRITICAL_REGION)
+	return TRUE;
+#else
+	return FALSE;
+#endif
+}
+
 MonoMethod*
 mono_gc_get_managed_array_allocator (MonoClass *klass)
 {
@@ -1332,11 +1523,48 @@ mono_gc_alloc_vector (MonoVTable *vtable, size_t size, uintptr_t max_length)
  done:
 	if (G_UNLIKELY (mono_profiler_allocations_enabled ()))
 		MONO_PROFILER_RAISE (gc_allocation, (&arr->obj));
+	if (G_UNLIKELY (mono_profiler_allocation_sampling_enabled ()))
+		report_allocation_sample (&arr->obj);
 
 	SGEN_ASSERT (6, SGEN_ALIGN_UP (size) == SGEN_ALIGN_UP (sgen_client_par_object_get_size (vtable, (GCObject*)arr)), "Vector has incorrect size.");
 	return arr;
 }
 
+/*
+ * Only large vectors skip the clearing, small ones come from TLABs which are
+ * cleared in bulk when they are created.
+ */
+MonoArray*
+mono_gc_alloc_uninitialized_vector (MonoVTable *vtable, size_t size, uintptr_t max_length)
+{
+	MonoArray *arr;
+
+	if (size <= SGEN_MAX_SMALL_OBJ_SIZE)
+		return mono_gc_alloc_vector (vtable, size, max_length);
+
+	if (!SGEN_CAN_ALIGN_UP (size))
+		return NULL;
+
+	LOCK_GC;
+
+	arr = (MonoArray*)sgen_alloc_large_obj_uninitialized_nolock (vtable, size, MONO_SIZEOF_MONO_ARRAY);
+	if (G_UNLIKELY (!arr)) {
+		UNLOCK_GC;
+		return NULL;
+	}
+
+	arr->max_length = (mono_array_size_t)max_length;
+
+	UNLOCK_GC;
+
+	if (G_UNLIKELY (mono_profiler_allocations_enabled ()))
+		MONO_PROFILER_RAISE (gc_allocation, (&arr->obj));
+	if (G_UNLIKELY (mono_profiler_allocation_sampling_enabled ()))
+		report_allocation_sample (&arr->obj);
+
+	return arr;
+}
+
 MonoArray*
 mono_gc_alloc_array (MonoVTable *vtable, size_t size, uintptr_t max_length, uintptr_t bounds_size)
 {
@@ -1380,6 +1608,8 @@ mono_gc_alloc_array (MonoVTable *vtable, size_t size, uintptr_t max_length, uint
  done:
 	if (G_UNLIKELY (mono_profiler_allocations_enabled ()))
 		MONO_PROFILER_RAISE (gc_allocation, (&arr->obj));
+	if (G_UNLIKELY (mono_profiler_allocation_sampling_enabled ()))
+		report_allocation_sample (&arr->obj);
 
 	SGEN_ASSERT (6, SGEN_ALIGN_UP (size) == SGEN_ALIGN_UP (sgen_client_par_object_get_size (vtable, (GCObject*)arr)), "Array has incorrect size.");
 	return arr;
@@ -1421,6 +1651,44 @@ mono_gc_alloc_string (MonoVTable *vtable, size_t size, gint32 len)
  done:
 	if (G_UNLIKELY (mono_profiler_allocations_enabled ()))
 		MONO_PROFILER_RAISE (gc_allocation, (&str->object));
+	if (G_UNLIKELY (mono_profiler_allocation_sampling_enabled ()))
+		report_allocation_sample (&str->object);
+
+	return str;
+}
+
+/*
+ * Like mono_gc_alloc_uninitialized_vector (), only large strings skip the
+ * clearing.
+ */
+MonoString*
+mono_gc_alloc_uninitialized_string (MonoVTable *vtable, size_t size, gint32 len)
+{
+	MonoString *str;
+
+	if (size <= SGEN_MAX_SMALL_OBJ_SIZE)
+		return mono_gc_alloc_string (vtable, size, len);
+
+	if (!SGEN_CAN_ALIGN_UP (size))
+		return NULL;
+
+	LOCK_GC;
+
+	str = (MonoString*)sgen_alloc_large_obj_uninitialized_nolock (vtable, size, G_STRUCT_OFFSET (MonoString, chars));
+	if (G_UNLIKELY (!str)) {
+		UNLOCK_GC;
+		return NULL;
+	}
+
+	str->length = len;
+	str->chars [len] = 0;
+
+	UNLOCK_GC;
+
+	if (G_UNLIKELY (mono_profiler_allocations_enabled ()))
+		MONO_PROFILER_RAISE (gc_allocation, (&str->object));
+	if (G_UNLIKELY (mono_profiler_allocation_sampling_enabled ()))
+		report_allocation_sample (&str->object);
 
 	return str;
 }
@@ -1994,6 +2262,190 @@ mono_gc_walk_heap (int flags, MonoGCReferences callback, void *data)
 	return 0;
 }
 
+int
+mono_gc_scan_thread_stacks (MonoGCStackWordFunc func, gpointer user_data)
+{
+#ifdef HOST_WASM
+	/* See sgen_client_scan_thread_data () */
+	return 1;
+#endif
+
+	FOREACH_THREAD_EXCLUDE (info, MONO_THREAD_INFO_FLAGS_NO_GC) {
+		gpointer *start, *p;
+
+		if (info->client_info.skip || !mono_thread_info_is_live (info) || !info->client_info.stack_start)
+			continue;
+
+		start = (gpointer*)(mword) ALIGN_TO ((mword)info->client_info.stack_start, SIZEOF_VOID_P);
+#ifdef HOST_WIN32
+		/* Skip the guard page, see sgen_client_scan_thread_data () */
+		MEMORY_BASIC_INFORMATION mem_info;
+		SIZE_T result = VirtualQuery (info->client_info.stack_start, &mem_info, sizeof (mem_info));
+		g_assert (result != 0);
+		if (mem_info.Protect & PAGE_GUARD)
+			start = (gpointer*)(((char*) mem_info.BaseAddress) + mem_info.RegionSize);
+#endif
+
+		for (p = start; p < (gpointer*)info->client_info.info.stack_end; ++p) {
+			if (func (*p, user_data))
+				return 0;
+		}
+		for (p = (gpointer*)&info->client_info.ctx; p < (gpointer*)(&info->client_info.ctx + 1); ++p) {
+			if (func (*p, user_data))
+				return 0;
+		}
+	} FOREACH_THREAD_END
+
+	return 0;
+}
+
+/*
+ * State of the heap walk started by mono_gc_walk_heap_begin ().  Objects in the
+ * major heap and the LOS are neither moved nor freed until the next major
+ * collection or domain unload, which finish the walk before they start.  The
+ * part of the LOS to walk is the suffix of the list that existed when the walk
+ * started, and the set of blocks is fixed when the first slice is walked, once
+ * the sweep has finished.  Protected by the GC lock.
+ */
+static struct {
+	gboolean in_progress;
+	gboolean blocks_fixed;
+	guint32 next_block;
+	guint32 num_blocks;
+	LOSObject *next_los_object;
+	HeapWalkInfo hwi;
+} heap_walk;
+
+/*
+ * Walks the rest of the heap, stopping between two blocks or LOS objects once
+ * `deadline` has passed, unless it's 0.  Returns whether the walk is done.
+ * Must be called with the world stopped.
+ */
+static gboolean
+walk_heap_slice (gint64 deadline)
+{
+	if (!heap_walk.in_progress)
+		return TRUE;
+
+	if (!heap_walk.blocks_fixed) {
+		heap_walk.num_blocks = sgen_major_collector.get_num_block_slots ();
+		heap_walk.blocks_fixed = TRUE;
+	}
+
+	while (heap_walk.next_block < heap_walk.num_blocks) {
+		sgen_major_collector.iterate_block_objects (ITERATE_OBJECTS_SWEEP_ALL, heap_walk.next_block++, walk_references, &heap_walk.hwi);
+		if (deadline && mono_100ns_ticks () >= deadline)
+			return FALSE;
+	}
+
+	while (heap_walk.next_los_object) {
+		LOSObject *obj = heap_walk.next_los_object;
+
+		heap_walk.next_los_object = obj->next;
+		walk_references ((GCObject*)obj->data, sgen_los_object_size (obj), &heap_walk.hwi);
+		if (deadline && mono_100ns_ticks () >= deadline)
+			return FALSE;
+	}
+
+	heap_walk.in_progress = FALSE;
+	return TRUE;
+}
+
+/**
+ * mono_gc_walk_heap_begin:
+ * \param flags flags for future use
+ * \param callback a function pointer called for each object in the heap
+ * \param data a user data pointer that is passed to callback
+ * Like mono_gc_walk_heap, but only walks the nursery right away.  The rest of
+ * the heap is walked in slices by mono_gc_walk_heap_step, so that a big heap
+ * doesn't have to be walked in a single pause.  Every object that is live at
+ * this point is reported at least once, with its references as of the slice it
+ * is walked in.  Major heap and LOS objects are reported once, but nursery
+ * objects promoted into a block that hasn't been walked yet are reported again,
+ * and objects allocated in the meantime can be reported, too.
+ * Starting a major collection finishes the walk, from the GC thread.
+ * Can only be called where mono_gc_walk_heap can.
+ * \returns a non-zero value if the GC doesn't support heap walking in slices
+ */
+int
+mono_gc_walk_heap_begin (int flags, MonoGCReferences callback, void *data)
+{
+	SGEN_ASSERT (0, !heap_walk.in_progress, "Only one heap walk can be in progress at a time");
+
+	/* The finishing pause of a concurrent collection would free objects under us */
+	if (sgen_concurrent_collection_in_progress)
+		return 1;
+
+	heap_walk.hwi.flags = flags;
+	heap_walk.hwi.callback = callback;
+	heap_walk.hwi.data = data;
+
+	sgen_clear_nursery_fragments ();
+	sgen_scan_area_with_callback (sgen_nursery_section->data, sgen_nursery_section->end_data, walk_references, &heap_walk.hwi, FALSE, TRUE);
+
+	heap_walk.blocks_fixed = FALSE;
+	heap_walk.next_block = 0;
+	heap_walk.next_los_object = sgen_los_object_list;
+	heap_walk.in_progress = TRUE;
+
+	return 0;
+}
+
+/**
+ * mono_gc_walk_heap_step:
+ * \param budget_us how long to keep the world stopped for, in microseconds, or 0
+ * to walk the rest of the heap
+ * Stops the world and walks the next slice of the heap walk started by
+ * mono_gc_walk_heap_begin.  The callback is called on the current thread.
+ * Profilers get the stop and start world events of the pause, with generation
+ * 0, but no collection events.
+ * \returns TRUE once the walk is done, including when it was finished by a
+ * major collection
+ */
+mono_bool
+mono_gc_walk_heap_step (int budget_us)
+{
+	gboolean done;
+
+	LOCK_GC;
+
+	if (!heap_walk.in_progress) {
+		UNLOCK_GC;
+		return TRUE;
+	}
+
+	sgen_stop_world (0, FALSE);
+	done = walk_heap_slice (budget_us ? mono_100ns_ticks () + (gint64)budget_us * 10 : 0);
+	sgen_restart_world (0, FALSE);
+
+	UNLOCK_GC;
+
+	return done;
+}
+
+/**
+ * mono_gc_get_recent_events:
+ * \param events array to copy the events to
+ * \param max_events number of entries in \p events
+ * The GC keeps a small ring of compact events about its most recent
+ * collections: pause begin and end, phase times, bytes promoted and
+ * objects pinned.  This copies up to \p max_events of them, oldest first.
+ * It doesn't take any locks, so it can be called at any time, including
+ * from a crash handler.
+ * \returns the number of events copied
+ */
+int
+mono_gc_get_recent_events (MonoGCRecentEvent *events, int max_events)
+{
+	/* The public struct mirrors the SGen one, so we can copy straight into it */
+	g_static_assert (sizeof (MonoGCRecentEvent) == sizeof (SgenRecentEvent));
+	g_static_assert (G_STRUCT_OFFSET (MonoGCRecentEvent, value) == G_STRUCT_OFFSET (SgenRecentEvent, value));
+	g_static_assert (G_STRUCT_OFFSET (MonoGCRecentEvent, generation) == G_STRUCT_OFFSET (SgenRecentEvent, generation));
+	g_static_assert ((int)MONO_GC_RECENT_OBJECTS_PINNED == (int)SGEN_RECENT_OBJECTS_PINNED);
+
+	return sgen_recent_events_copy ((SgenRecentEvent*)events, max_events);
+}
+
 /*
  * Threads
  */
@@ -2247,6 +2699,14 @@ sgen_client_scan_thread_data (void *start_nursery, void *end_nursery, gboolean p
 						start_nursery, end_nursery, PIN_TYPE_STACK);
 				}
 			}
+
+			if (mono_gc_get_gc_callbacks ()->interp_stack_range_func) {
+				gpointer interp_start, interp_end;
+
+				mono_gc_get_gc_callbacks ()->interp_stack_range_func (info->client_info.info.jit_data, &interp_start, &interp_end);
+				if (interp_start)
+					sgen_conservatively_pin_objects_from ((void **)interp_start, (void **)interp_end, start_nursery, end_nursery, PIN_TYPE_STACK);
+			}
 		}
 		if (info->client_info.info.handle_stack) {
 			/*
@@ -2500,6 +2960,13 @@ mono_gc_get_allocated_bytes_for_current_thread (void)
 	return info->total_bytes_allocated + info->tlab_next - info->tlab_start;
 }
 
+gboolean
+mono_gc_set_allocation_sample_interval (guint32 interval)
+{
+	sgen_set_allocation_sample_interval (interval);
+	return TRUE;
+}
+
 gpointer
 sgen_client_default_metadata (void)
 {
@@ -2759,6 +3226,9 @@ sgen_client_description_for_internal_mem_type (int type)
 {
 	switch (type) {
 	case INTERNAL_MEM_EPHEMERON_LINK: return "ephemeron-link";
+	case INTERNAL_MEM_EPHEMERON_PENDING_TABLE: return "ephemeron-pending-table";
+	case INTERNAL_MEM_EPHEMERON_PENDING_TABLE_ENTRY: return "ephemeron-pending-table-entry";
+	case INTERNAL_MEM_EPHEMERON_PENDING: return "ephemeron-pending";
 	case INTERNAL_MEM_MOVED_OBJECT: return "moved-object";
 	default:
 		return NULL;
@@ -2802,11 +3272,11 @@ sgen_client_init (void)
 	mono_thread_callbacks_init ();
 	mono_thread_info_init (sizeof (SgenThreadInfo));
 
-	///* Keep this the default for now */
-	/* Precise marking is broken on all supported targets. Disable until fixed. */
+	/* Precise marking is opt-in with `stack-mark=precise`, see mini-gc.c */
 	conservative_stack_mark = TRUE;
 
 	sgen_register_fixed_internal_mem_type (INTERNAL_MEM_EPHEMERON_LINK, sizeof (EphemeronLinkNode));
+	sgen_register_fixed_internal_mem_type (INTERNAL_MEM_EPHEMERON_PENDING, sizeof (EphemeronPending));
 
 	mono_sgen_init_stw ();
 
@@ -2981,6 +3451,10 @@ sgen_client_binary_protocol_collection_begin (int minor_gc_count, int generation
 
 	MONO_GC_BEGIN (generation);
 
+	/* Objects are about to be moved and freed */
+	if (generation == GENERATION_OLD)
+		walk_heap_slice (0);
+
 	MONO_PROFILER_RAISE (gc_event, (MONO_GC_EVENT_START, generation, generation == GENERATION_OLD && sgen_concurrent_collection_in_progress));
 
 	if (!pseudo_roots_registered) {
@@ -25,8 +25,11 @@
 #include "sgen/sgen-client.h"
 #include "metadata/sgen-bridge-internals.h"
 #include "metadata/gc-internals.h"
+#include "metadata/loader-internals.h"
 #include "utils/mono-threads.h"
 #include "utils/mono-threads-debug.h"
+#include "utils/mono-logger-internals.h"
+#include "utils/mono-time.h"
 
 #define TV_DECLARE SGEN_TV_DECLARE
 #define TV_GETTIME SGEN_TV_GETTIME
@@ -100,6 +103,15 @@ static unsigned long max_pause_usec = 0;
 static guint64 time_stop_world;
 static guint64 time_restart_world;
 
+/* Threads that take longer than this (100ns ticks) to acknowledge a suspend request are reported */
+#define SLOW_THREAD_SUSPEND_TIME	10000
+
+static guint64 time_max_thread_suspend;
+static guint64 stat_slow_thread_suspends;
+/* The thread that was slowest to suspend in the last stop */
+static MonoNativeThreadId slowest_suspend_tid;
+static gint64 slowest_suspend_time;
+
 /* LOCKING: assumes the GC lock is held */
 void
 sgen_client_stop_world (int generation, gboolean serial_collection)
@@ -153,6 +165,12 @@ sgen_client_restart_world (int generation, gboolean serial_collection, gint64 *s
 
 	MONO_PROFILER_RAISE (gc_event, (MONO_GC_EVENT_PRE_START_WORLD, generation, serial_collection));
 
+#ifdef ENABLE_NETCORE
+	/* Needs the stacks of the stopped threads, and a heap without dead objects */
+	if (generation == GENERATION_OLD && !sgen_concurrent_collection_in_progress)
+		mono_alc_check_unused ();
+#endif
+
 	FOREACH_THREAD_ALL (info) {
 		info->client_info.stack_start = NULL;
 		memset (&info->client_info.ctx, 0, sizeof (MonoContext));
@@ -186,6 +204,10 @@ sgen_client_restart_world (int generation, gboolean serial_collection, gint64 *s
 
 	MONO_PROFILER_RAISE (gc_event, (MONO_GC_EVENT_POST_START_WORLD_UNLOCKED, generation, serial_collection));
 
+	/* We can only log once the world runs again */
+	if (slowest_suspend_time >= SLOW_THREAD_SUSPEND_TIME)
+		mono_trace (G_LOG_LEVEL_DEBUG, MONO_TRACE_GC, "GC_SUSPEND: thread %p took %.2fms to suspend", (gpointer) slowest_suspend_tid, slowest_suspend_time / 10000.0f);
+
 	*stw_time = usec;
 }
 
@@ -194,6 +216,8 @@ mono_sgen_init_stw (void)
 {
 	mono_counters_register ("World stop", MONO_COUNTER_GC | MONO_COUNTER_ULONG | MONO_COUNTER_TIME, &time_stop_world);
 	mono_counters_register ("World restart", MONO_COUNTER_GC | MONO_COUNTER_ULONG | MONO_COUNTER_TIME, &time_restart_world);
+	mono_counters_register ("Thread suspend max time", MONO_COUNTER_GC | MONO_COUNTER_ULONG | MONO_COUNTER_TIME, &time_max_thread_suspend);
+	mono_counters_register ("# slow thread suspends", MONO_COUNTER_GC | MONO_COUNTER_ULONG, &stat_slow_thread_suspends);
 }
 
 /* Unified suspend code */
@@ -252,6 +276,9 @@ static void
 sgen_unified_suspend_stop_world (void)
 {
 	int sleep_duration = -1;
+	gint64 suspend_start = mono_100ns_ticks ();
+
+	slowest_suspend_time = 0;
 
 	// we can't lead STW if we promised not to safepoint.
 	g_assert (!mono_thread_info_will_not_safepoint (mono_thread_info_current ()));
@@ -413,6 +440,19 @@ sgen_unified_suspend_stop_world (void)
 
 		stopped_ip = (gpointer) (MONO_CONTEXT_GET_IP (&info->client_info.ctx));
 
+		/* Threads that were blocking were suspended without having to ack */
+		if (info->client_info.info.suspend_ack_time >= suspend_start) {
+			gint64 suspend_time = info->client_info.info.suspend_ack_time - suspend_start;
+
+			time_max_thread_suspend = MAX (time_max_thread_suspend, suspend_time);
+			if (suspend_time >= SLOW_THREAD_SUSPEND_TIME)
+				++stat_slow_thread_suspends;
+			if (suspend_time > slowest_suspend_time) {
+				slowest_suspend_time = suspend_time;
+				slowest_suspend_tid = mono_thread_info_get_tid (info);
+			}
+		}
+
 		sgen_binary_protocol_thread_suspend ((gpointer) mono_thread_info_get_tid (info), stopped_ip);
 
 		THREADS_STW_DEBUG ("[GC-STW-SUSPEND-END] thread %p is suspended, stopped_ip = %p, stack = %p -> %p\n",
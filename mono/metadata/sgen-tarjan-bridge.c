@@ -211,6 +211,12 @@ static ObjectBucket *root_object_bucket;
 static ObjectBucket *cur_object_bucket;
 static int object_data_count;
 
+/*
+ * The buckets are kept from one collection to the next, since the number
+ * of objects reachable from bridges is usually the same ballpark every
+ * time.  Only the buckets a collection didn't get to are freed.
+ */
+
 // Arenas to allocate ScanData from
 static ObjectBucket*
 new_object_bucket (void)
@@ -223,7 +229,9 @@ new_object_bucket (void)
 static void
 object_alloc_init (void)
 {
-	root_object_bucket = cur_object_bucket = new_object_bucket ();
+	if (!root_object_bucket)
+		root_object_bucket = new_object_bucket ();
+	cur_object_bucket = root_object_bucket;
 }
 
 static ScanData*
@@ -235,9 +243,9 @@ retry:
 	/* next_data points to the first free entry */
 	res = cur_object_bucket->next_data;
 	if (res >= &cur_object_bucket->data [NUM_SCAN_ENTRIES]) {
-		ObjectBucket *b = new_object_bucket ();
-		cur_object_bucket->next = b;
-		cur_object_bucket = b;
+		if (!cur_object_bucket->next)
+			cur_object_bucket->next = new_object_bucket ();
+		cur_object_bucket = cur_object_bucket->next;
 		goto retry;
 	}
 	cur_object_bucket->next_data = res + 1;
@@ -248,17 +256,24 @@ retry:
 static void
 free_object_buckets (void)
 {
-	ObjectBucket *cur = root_object_bucket;
+	ObjectBucket *cur;
 
 	object_data_count = 0;
 
+	if (!root_object_bucket)
+		return;
+
+	cur = cur_object_bucket->next;
+	cur_object_bucket->next = NULL;
 	while (cur) {
 		ObjectBucket *tmp = cur->next;
 		sgen_free_internal (cur, INTERNAL_MEM_TARJAN_OBJ_BUCKET);
 		cur = tmp;
 	}
 
-	root_object_bucket = cur_object_bucket = NULL;
+	for (cur = root_object_bucket; cur; cur = cur->next)
+		cur->next_data = &cur->data [0];
+	cur_object_bucket = root_object_bucket;
 }
 
 //ColorData buckets
@@ -288,7 +303,9 @@ new_color_bucket (void)
 static void
 color_alloc_init (void)
 {
-	root_color_bucket = cur_color_bucket = new_color_bucket ();
+	if (!root_color_bucket)
+		root_color_bucket = new_color_bucket ();
+	cur_color_bucket = root_color_bucket;
 }
 
 static ColorData*
@@ -300,16 +317,24 @@ retry:
 	/* next_data points to the first free entry */
 	res = cur_color_bucket->next_data;
 	if (res >= &cur_color_bucket->data [NUM_COLOR_ENTRIES]) {
-		ColorBucket *b = new_color_bucket ();
-		cur_color_bucket->next = b;
-		cur_color_bucket = b;
+		if (!cur_color_bucket->next)
+			cur_color_bucket->next = new_color_bucket ();
+		cur_color_bucket = cur_color_bucket->next;
 		goto retry;
 	}
 	cur_color_bucket->next_data = res + 1;
 	color_data_count++;
+	/* The arrays are empty, but might still hold storage from an earlier collection */
+	res->incoming_colors = 0;
+	res->visited = FALSE;
 	return res;
 }
 
+/*
+ * Like the object buckets, the color buckets that were used are kept, and
+ * so is the storage of their colors' arrays, which is where most of the
+ * small allocations of a collection go.
+ */
 static void
 free_color_buckets (void)
 {
@@ -317,16 +342,31 @@ free_color_buckets (void)
 
 	color_data_count = 0;
 
-	for (cur = root_color_bucket; cur; cur = tmp) {
+	if (!root_color_bucket)
+		return;
+
+	cur = cur_color_bucket->next;
+	cur_color_bucket->next = NULL;
+	for (; cur; cur = tmp) {
 		ColorData *cd;
-		for (cd = &cur->data [0]; cd < cur->next_data; ++cd) {
+		/* Unused this time around, but their arrays may have been used before */
+		for (cd = &cur->data [0]; cd < &cur->data [NUM_COLOR_ENTRIES]; ++cd) {
 			dyn_array_ptr_uninit (&cd->other_colors);
 			dyn_array_ptr_uninit (&cd->bridges);
 		}
 		tmp = cur->next;
 		sgen_free_internal (cur, INTERNAL_MEM_TARJAN_OBJ_BUCKET);
 	}
-	root_color_bucket = cur_color_bucket = NULL;
+
+	for (cur = root_color_bucket; cur; cur = cur->next) {
+		ColorData *cd;
+		for (cd = &cur->data [0]; cd < cur->next_data; ++cd) {
+			dyn_array_ptr_empty (&cd->other_colors);
+			dyn_array_ptr_empty (&cd->bridges);
+		}
+		cur->next_data = &cur->data [0];
+	}
+	cur_color_bucket = root_color_bucket;
 }
 
 
@@ -81,15 +81,25 @@ sgen_process_togglerefs (void)
 		w);
 }
 
-void sgen_client_mark_togglerefs (char *start, char *end, ScanCopyContext ctx)
+int
+sgen_client_get_num_togglerefs (void)
+{
+	return toggleref_array_size;
+}
+
+/*
+ * Marks the strong togglerefs in the slots [FROM, TO) that point into
+ * [START, END).  Doesn't drain the gray queue, so it can be run on the
+ * workers for disjoint ranges.
+ */
+void
+sgen_client_mark_togglerefs_in_range (char *start, char *end, ScanCopyContext ctx, int from, int to)
 {
 	CopyOrMarkObjectFunc copy_func = ctx.ops->copy_or_mark_object;
 	SgenGrayQueue *queue = ctx.queue;
 	int i;
 
-	SGEN_LOG (4, "Marking ToggleRefs %d", toggleref_array_size);
-
-	for (i = 0; i < toggleref_array_size; ++i) {
+	for (i = from; i < to; ++i) {
 		if (toggleref_array [i].strong_ref) {
 			GCObject *object = toggleref_array [i].strong_ref;
 			if ((char*)object >= start && (char*)object < end) {
@@ -98,18 +108,29 @@ void sgen_client_mark_togglerefs (char *start, char *end, ScanCopyContext ctx)
 			}
 		}
 	}
+}
+
+void sgen_client_mark_togglerefs (char *start, char *end, ScanCopyContext ctx)
+{
+	SGEN_LOG (4, "Marking ToggleRefs %d", toggleref_array_size);
+
+	sgen_client_mark_togglerefs_in_range (start, end, ctx, 0, toggleref_array_size);
 	sgen_drain_gray_stack (ctx);
 }
 
-void sgen_client_clear_togglerefs (char *start, char *end, ScanCopyContext ctx)
+/*
+ * Clears the weak togglerefs in the slots [FROM, TO) whose object is dead
+ * and updates the others.  Like sgen_client_mark_togglerefs_in_range (), it
+ * doesn't drain the gray queue.
+ */
+void
+sgen_client_clear_togglerefs_in_range (char *start, char *end, ScanCopyContext ctx, int from, int to)
 {
 	CopyOrMarkObjectFunc copy_func = ctx.ops->copy_or_mark_object;
 	SgenGrayQueue *queue = ctx.queue;
 	int i;
 
-	SGEN_LOG (4, "Clearing ToggleRefs %d", toggleref_array_size);
-
-	for (i = 0; i < toggleref_array_size; ++i) {
+	for (i = from; i < to; ++i) {
 		if (toggleref_array [i].weak_ref) {
 			GCObject *object = toggleref_array [i].weak_ref;
 
@@ -124,6 +145,13 @@ void sgen_client_clear_togglerefs (char *start, char *end, ScanCopyContext ctx)
 			}
 		}
 	}
+}
+
+void sgen_client_clear_togglerefs (char *start, char *end, ScanCopyContext ctx)
+{
+	SGEN_LOG (4, "Clearing ToggleRefs %d", toggleref_array_size);
+
+	sgen_client_clear_togglerefs_in_range (start, end, ctx, 0, toggleref_array_size);
 	sgen_drain_gray_stack (ctx);
 }
 
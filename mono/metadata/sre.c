@@ -3787,9 +3787,10 @@ struct remove_instantiations_user_data
 {
 	MonoClass *klass;
 	MonoError *error;
+	GPtrArray *removed;
 };
 
-static gboolean
+static void
 remove_instantiations_of_and_ensure_contents (gpointer key,
 						  gpointer value,
 						  gpointer user_data)
@@ -3811,9 +3812,9 @@ remove_instantiations_of_and_ensure_contents (gpointer key,
 			if (already_failed)
 				mono_error_cleanup (error);
 		}
-		return TRUE;
-	} else
-		return FALSE;
+		/* The table can't be modified while iterating it */
+		g_ptr_array_add (data->removed, type);
+	}
 }
 
 /**
@@ -3961,8 +3962,12 @@ ves_icall_TypeBuilder_create_runtime_class (MonoReflectionTypeBuilderHandle ref_
 		struct remove_instantiations_user_data data;
 		data.klass = klass;
 		data.error = error;
+		data.removed = g_ptr_array_new ();
 		mono_error_assert_ok (error);
-		mono_g_hash_table_foreach_remove (domain->type_hash, remove_instantiations_of_and_ensure_contents, &data);
+		mono_conc_g_hash_table_foreach (domain->type_hash, remove_instantiations_of_and_ensure_contents, &data);
+		for (guint i = 0; i < data.removed->len; ++i)
+			mono_conc_g_hash_table_remove (domain->type_hash, g_ptr_array_index (data.removed, i));
+		g_ptr_array_free (data.removed, TRUE);
 		goto_if_nok (error, failure);
 	}
 
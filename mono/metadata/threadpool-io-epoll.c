@@ -11,15 +11,47 @@
 #error
 #endif
 
-#define EPOLL_NEVENTS 128
+#ifndef EPOLLONESHOT
+/* it was only defined on android in May 2013 */
+#define EPOLLONESHOT 0x40000000
+#endif
 
-static gint epoll_fd;
-static struct epoll_event *epoll_events;
+/* The size of the events buffer adapts to the load, between these bounds */
+#define EPOLL_NEVENTS_MIN 128
+#define EPOLL_NEVENTS_MAX 4096
+/* Shrink the buffer after this many consecutive waits which used less than 1/8th of it */
+#define EPOLL_NEVENTS_SHRINK_AFTER 64
 
-static gboolean
-epoll_init (gint wakeup_pipe_fd)
+/*
+ * In edge-triggered mode (MONO_ENABLE_AIO=epoll_et), the fds stay registered for
+ * EPOLLIN | EPOLLOUT instead of being re-armed with EPOLLONESHOT after every event.
+ * The backend remembers which operations the selector is interested in, and only
+ * calls epoll_ctl (EPOLL_CTL_MOD) when an operation is added, or when one which just
+ * fired still has jobs waiting: EPOLL_CTL_MOD re-evaluates the readiness of the fd,
+ * so a level that was already reported isn't lost.
+ */
+typedef struct {
+	gint operations;
+	gint fired;
+} EpollFdState;
+
+typedef struct {
+	gint epoll_fd;
+	struct epoll_event *epoll_events;
+	gint epoll_nevents;
+	gint epoll_underused;
+
+	gboolean edge_triggered;
+	/* Maps fd -> EpollFdState, only used in edge-triggered mode */
+	GHashTable *epoll_fds;
+} EpollBackend;
+
+static gpointer
+epoll_init_internal (gint wakeup_pipe_fd, gboolean edge_triggered)
 {
 	struct epoll_event event;
+	gint epoll_fd;
+	EpollBackend *backend;
 
 #ifdef EPOOL_CLOEXEC
 	epoll_fd = epoll_create1 (EPOLL_CLOEXEC);
@@ -34,7 +66,7 @@ epoll_init (gint wakeup_pipe_fd)
 #else
 		g_error ("epoll_init: epoll (256) failed, error (%d) %s\n", errno, g_strerror (errno));
 #endif
-		return FALSE;
+		return NULL;
 	}
 
 	event.events = EPOLLIN;
@@ -42,23 +74,71 @@ epoll_init (gint wakeup_pipe_fd)
 	if (epoll_ctl (epoll_fd, EPOLL_CTL_ADD, event.data.fd, &event) == -1) {
 		g_error ("epoll_init: epoll_ctl () failed, error (%d) %s", errno, g_strerror (errno));
 		close (epoll_fd);
-		return FALSE;
+		return NULL;
 	}
 
-	epoll_events = g_new0 (struct epoll_event, EPOLL_NEVENTS);
+	backend = g_new0 (EpollBackend, 1);
+	backend->epoll_fd = epoll_fd;
+	backend->epoll_nevents = EPOLL_NEVENTS_MIN;
+	backend->epoll_events = g_new0 (struct epoll_event, backend->epoll_nevents);
+	backend->edge_triggered = edge_triggered;
+	if (edge_triggered)
+		backend->epoll_fds = g_hash_table_new_full (NULL, NULL, NULL, g_free);
 
-	return TRUE;
+	return backend;
+}
+
+static gpointer
+epoll_init (gint wakeup_pipe_fd)
+{
+	return epoll_init_internal (wakeup_pipe_fd, FALSE);
+}
+
+static gpointer
+epoll_et_init (gint wakeup_pipe_fd)
+{
+	return epoll_init_internal (wakeup_pipe_fd, TRUE);
 }
 
 static void
-epoll_register_fd (gint fd, gint events, gboolean is_new)
+epoll_et_register_fd (EpollBackend *backend, gint fd, gint events, gboolean is_new)
 {
+	EpollFdState *state;
 	struct epoll_event event;
+	gboolean rearm;
 
-#ifndef EPOLLONESHOT
-/* it was only defined on android in May 2013 */
-#define EPOLLONESHOT 0x40000000
-#endif
+	state = (EpollFdState*)g_hash_table_lookup (backend->epoll_fds, GINT_TO_POINTER (fd));
+	if (!state) {
+		g_assert (is_new);
+		state = g_new0 (EpollFdState, 1);
+		g_hash_table_insert (backend->epoll_fds, GINT_TO_POINTER (fd), state);
+	}
+
+	rearm = is_new || (events & ~state->operations) != 0 || (events & state->fired) != 0;
+
+	state->operations = events;
+	state->fired = 0;
+
+	if (!rearm)
+		return;
+
+	event.data.fd = fd;
+	event.events = EPOLLIN | EPOLLOUT | EPOLLET;
+
+	if (epoll_ctl (backend->epoll_fd, is_new ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, event.data.fd, &event) == -1)
+		g_error ("epoll_register_fd: epoll_ctl(%s) failed, error (%d) %s", is_new ? "EPOLL_CTL_ADD" : "EPOLL_CTL_MOD", errno, g_strerror (errno));
+}
+
+static void
+epoll_register_fd (gpointer backend_data, gint fd, gint events, gboolean is_new)
+{
+	EpollBackend *backend = (EpollBackend*)backend_data;
+	struct epoll_event event;
+
+	if (backend->edge_triggered) {
+		epoll_et_register_fd (backend, fd, events, is_new);
+		return;
+	}
 
 	event.data.fd = fd;
 	event.events = EPOLLONESHOT;
@@ -67,28 +147,64 @@ epoll_register_fd (gint fd, gint events, gboolean is_new)
 	if ((events & EVENT_OUT) != 0)
 		event.events |= EPOLLOUT;
 
-	if (epoll_ctl (epoll_fd, is_new ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, event.data.fd, &event) == -1)
+	if (epoll_ctl (backend->epoll_fd, is_new ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, event.data.fd, &event) == -1)
 		g_error ("epoll_register_fd: epoll_ctl(%s) failed, error (%d) %s", is_new ? "EPOLL_CTL_ADD" : "EPOLL_CTL_MOD", errno, g_strerror (errno));
 }
 
 static void
-epoll_remove_fd (gint fd)
+epoll_remove_fd (gpointer backend_data, gint fd)
 {
-	if (epoll_ctl (epoll_fd, EPOLL_CTL_DEL, fd, NULL) == -1)
+	EpollBackend *backend = (EpollBackend*)backend_data;
+
+	if (backend->edge_triggered)
+		g_hash_table_remove (backend->epoll_fds, GINT_TO_POINTER (fd));
+
+	if (epoll_ctl (backend->epoll_fd, EPOLL_CTL_DEL, fd, NULL) == -1)
 			g_error ("epoll_remove_fd: epoll_ctl (EPOLL_CTL_DEL) failed, error (%d) %s", errno, g_strerror (errno));
 }
 
+/* Grow the events buffer when a wait filled it, and shrink it back after a while at low load */
+static void
+epoll_adapt_nevents (EpollBackend *backend, gint ready)
+{
+	gint nevents = backend->epoll_nevents;
+
+	if (ready == nevents && nevents < EPOLL_NEVENTS_MAX) {
+		nevents *= 2;
+		backend->epoll_underused = 0;
+	} else if (ready < nevents / 8 && nevents > EPOLL_NEVENTS_MIN) {
+		if (++backend->epoll_underused < EPOLL_NEVENTS_SHRINK_AFTER)
+			return;
+		nevents /= 2;
+		backend->epoll_underused = 0;
+	} else {
+		backend->epoll_underused = 0;
+		return;
+	}
+
+	if (nevents == backend->epoll_nevents)
+		return;
+
+	mono_trace (G_LOG_LEVEL_DEBUG, MONO_TRACE_IO_SELECTOR, "io threadpool: epoll events buffer resized from %d to %d", backend->epoll_nevents, nevents);
+
+	g_free (backend->epoll_events);
+	backend->epoll_events = g_new0 (struct epoll_event, nevents);
+	backend->epoll_nevents = nevents;
+}
+
 static gint
-epoll_event_wait (void (*callback) (gint fd, gint events, gpointer user_data), gpointer user_data)
+epoll_event_wait (gpointer backend_data, void (*callback) (gint fd, gint events, gpointer user_data), gpointer user_data)
 {
+	EpollBackend *backend = (EpollBackend*)backend_data;
+	struct epoll_event *epoll_events = backend->epoll_events;
 	gint i, ready;
 
-	memset (epoll_events, 0, sizeof (struct epoll_event) * EPOLL_NEVENTS);
+	memset (epoll_events, 0, sizeof (struct epoll_event) * backend->epoll_nevents);
 
 	mono_thread_info_set_flags (MONO_THREAD_INFO_FLAGS_NO_GC);
 
 	MONO_ENTER_GC_SAFE;
-	ready = epoll_wait (epoll_fd, epoll_events, EPOLL_NEVENTS, -1);
+	ready = epoll_wait (backend->epoll_fd, epoll_events, backend->epoll_nevents, -1);
 	MONO_EXIT_GC_SAFE;
 
 	mono_thread_info_set_flags (MONO_THREAD_INFO_FLAGS_NONE);
@@ -116,9 +232,22 @@ epoll_event_wait (void (*callback) (gint fd, gint events, gpointer user_data), g
 		if (epoll_events [i].events & (EPOLLOUT | EPOLLERR | EPOLLHUP))
 			events |= EVENT_OUT;
 
+		if (backend->edge_triggered) {
+			EpollFdState *state = (EpollFdState*)g_hash_table_lookup (backend->epoll_fds, GINT_TO_POINTER (fd));
+			if (state) {
+				/* An edge for an operation nobody waits on, the next EPOLL_CTL_MOD will report it again */
+				events &= state->operations;
+				state->fired |= events;
+				if (events == 0)
+					continue;
+			}
+		}
+
 		callback (fd, events, user_data);
 	}
 
+	epoll_adapt_nevents (backend, ready);
+
 	return 0;
 }
 
@@ -129,4 +258,11 @@ static ThreadPoolIOBackend backend_epoll = {
 	epoll_event_wait,
 };
 
+static ThreadPoolIOBackend backend_epoll_et = {
+	epoll_et_init,
+	epoll_register_fd,
+	epoll_remove_fd,
+	epoll_event_wait,
+};
+
 #endif
@@ -0,0 +1,320 @@
+/**
+ * \file
+ */
+
+#if defined(HAVE_LINUX_IO_URING_H)
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <poll.h>
+#include <mono/utils/mono-memory-model.h>
+
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+
+#define HAVE_IO_URING 1
+
+#define IO_URING_ENTRIES 256
+
+/*
+ * The selector only needs readiness notifications, so this uses one-shot
+ * IORING_OP_POLL_ADD requests, which behave like EPOLLONESHOT. Unlike epoll, the
+ * (re)registrations don't need a syscall each: they are queued in the submission
+ * ring and submitted together with the wait in io_uring_enter (), and all the
+ * available completions are reaped at once.
+ *
+ * A poll which is replaced or removed might still complete, so each request is
+ * tagged with the generation of its fd, and stale completions are ignored.
+ */
+
+#define IO_URING_TAG_WAKEUP ((guint64)-1)
+#define IO_URING_TAG_REMOVE ((guint64)-2)
+
+#define IO_URING_TAG(fd,gen) (((guint64)(guint32)(gen) << 32) | (guint32)(fd))
+#define IO_URING_TAG_FD(tag) ((gint)(guint32)(tag))
+#define IO_URING_TAG_GEN(tag) ((guint32)((tag) >> 32))
+
+typedef struct {
+	guint32 gen;
+	gboolean armed;
+} IOUringFdState;
+
+typedef struct {
+	gint fd;
+	gint wakeup_fd;
+
+	volatile guint32 *sq_head, *sq_tail, *cq_head, *cq_tail;
+	guint32 sq_mask, cq_mask, sq_entries;
+	guint32 *sq_array;
+	struct io_uring_sqe *sqes;
+	struct io_uring_cqe *cqes;
+	/* Number of sqes filled in since the last io_uring_enter () */
+	guint32 to_submit;
+
+	/* Maps fd -> IOUringFdState, only accessed from the selector thread */
+	GHashTable *fds;
+} IOUringBackend;
+
+static gint
+io_uring_enter_syscall (IOUringBackend *backend, guint32 to_submit, guint32 min_complete, guint32 flags)
+{
+	return (gint)syscall (__NR_io_uring_enter, backend->fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+static void
+io_uring_flush (IOUringBackend *backend)
+{
+	while (backend->to_submit > 0) {
+		gint res = io_uring_enter_syscall (backend, backend->to_submit, 0, 0);
+		if (res == -1) {
+			if (errno == EINTR || errno == EAGAIN || errno == EBUSY)
+				continue;
+			g_error ("io_uring_flush: io_uring_enter () failed, error (%d) %s", errno, g_strerror (errno));
+		}
+		backend->to_submit -= res;
+	}
+}
+
+static struct io_uring_sqe *
+io_uring_get_sqe (IOUringBackend *backend)
+{
+	struct io_uring_sqe *sqe;
+	guint32 tail;
+
+	tail = *backend->sq_tail;
+	if (tail - *backend->sq_head == backend->sq_entries) {
+		/* The ring is full, hand the pending requests to the kernel */
+		io_uring_flush (backend);
+		mono_memory_read_barrier ();
+		g_assert (tail - *backend->sq_head < backend->sq_entries);
+	}
+
+	sqe = &backend->sqes [tail & backend->sq_mask];
+	memset (sqe, 0, sizeof (struct io_uring_sqe));
+	backend->sq_array [tail & backend->sq_mask] = tail & backend->sq_mask;
+	return sqe;
+}
+
+static void
+io_uring_commit_sqe (IOUringBackend *backend)
+{
+	/* The sqe must be visible before the kernel sees the new tail */
+	mono_memory_write_barrier ();
+	*backend->sq_tail = *backend->sq_tail + 1;
+	backend->to_submit ++;
+}
+
+static void
+io_uring_queue_poll (IOUringBackend *backend, gint fd, gint events, guint64 tag)
+{
+	struct io_uring_sqe *sqe = io_uring_get_sqe (backend);
+
+	sqe->opcode = IORING_OP_POLL_ADD;
+	sqe->fd = fd;
+	sqe->poll_events = 0;
+	if ((events & EVENT_IN) != 0)
+		sqe->poll_events |= POLLIN;
+	if ((events & EVENT_OUT) != 0)
+		sqe->poll_events |= POLLOUT;
+	sqe->user_data = tag;
+	io_uring_commit_sqe (backend);
+}
+
+static void
+io_uring_queue_poll_remove (IOUringBackend *backend, guint64 target_tag)
+{
+	struct io_uring_sqe *sqe = io_uring_get_sqe (backend);
+
+	sqe->opcode = IORING_OP_POLL_REMOVE;
+	sqe->fd = -1;
+	sqe->addr = target_tag;
+	sqe->user_data = IO_URING_TAG_REMOVE;
+	io_uring_commit_sqe (backend);
+}
+
+static gpointer
+uring_init (gint wakeup_pipe_fd)
+{
+	IOUringBackend *backend;
+	struct io_uring_params params;
+	guint8 *sq_ring, *cq_ring;
+	gsize sq_ring_size, cq_ring_size;
+
+	backend = g_new0 (IOUringBackend, 1);
+
+	memset (&params, 0, sizeof (params));
+	backend->fd = (gint)syscall (__NR_io_uring_setup, IO_URING_ENTRIES, &params);
+	if (backend->fd == -1) {
+		/* Not supported by the kernel, or disabled, the caller falls back to another backend */
+		mono_trace (G_LOG_LEVEL_INFO, MONO_TRACE_IO_SELECTOR, "io threadpool: io_uring_setup () failed, error (%d) %s", errno, g_strerror (errno));
+		g_free (backend);
+		return NULL;
+	}
+	fcntl (backend->fd, F_SETFD, FD_CLOEXEC);
+
+	sq_ring_size = params.sq_off.array + params.sq_entries * sizeof (guint32);
+	cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof (struct io_uring_cqe);
+
+	sq_ring = (guint8*)mmap (NULL, sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, backend->fd, IORING_OFF_SQ_RING);
+	cq_ring = (guint8*)mmap (NULL, cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, backend->fd, IORING_OFF_CQ_RING);
+	backend->sqes = (struct io_uring_sqe*)mmap (NULL, params.sq_entries * sizeof (struct io_uring_sqe), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, backend->fd, IORING_OFF_SQES);
+	if (sq_ring == MAP_FAILED || cq_ring == MAP_FAILED || (void*)backend->sqes == MAP_FAILED) {
+		mono_trace (G_LOG_LEVEL_INFO, MONO_TRACE_IO_SELECTOR, "io threadpool: io_uring mmap () failed, error (%d) %s", errno, g_strerror (errno));
+		if (sq_ring != MAP_FAILED)
+			munmap (sq_ring, sq_ring_size);
+		if (cq_ring != MAP_FAILED)
+			munmap (cq_ring, cq_ring_size);
+		if ((void*)backend->sqes != MAP_FAILED)
+			munmap (backend->sqes, params.sq_entries * sizeof (struct io_uring_sqe));
+		close (backend->fd);
+		g_free (backend);
+		return NULL;
+	}
+
+	backend->sq_head = (guint32*)(sq_ring + params.sq_off.head);
+	backend->sq_tail = (guint32*)(sq_ring + params.sq_off.tail);
+	backend->sq_mask = *(guint32*)(sq_ring + params.sq_off.ring_mask);
+	backend->sq_entries = *(guint32*)(sq_ring + params.sq_off.ring_entries);
+	backend->sq_array = (guint32*)(sq_ring + params.sq_off.array);
+
+	backend->cq_head = (guint32*)(cq_ring + params.cq_off.head);
+	backend->cq_tail = (guint32*)(cq_ring + params.cq_off.tail);
+	backend->cq_mask = *(guint32*)(cq_ring + params.cq_off.ring_mask);
+	backend->cqes = (struct io_uring_cqe*)(cq_ring + params.cq_off.cqes);
+
+	backend->fds = g_hash_table_new_full (NULL, NULL, NULL, g_free);
+
+	backend->wakeup_fd = wakeup_pipe_fd;
+	io_uring_queue_poll (backend, wakeup_pipe_fd, EVENT_IN, IO_URING_TAG_WAKEUP);
+
+	return backend;
+}
+
+static void
+uring_register_fd (gpointer backend_data, gint fd, gint events, gboolean is_new)
+{
+	IOUringBackend *backend = (IOUringBackend*)backend_data;
+	IOUringFdState *state;
+
+	state = (IOUringFdState*)g_hash_table_lookup (backend->fds, GINT_TO_POINTER (fd));
+	if (!state) {
+		state = g_new0 (IOUringFdState, 1);
+		g_hash_table_insert (backend->fds, GINT_TO_POINTER (fd), state);
+	}
+
+	/* Same as EPOLL_CTL_MOD, the new set of events replaces the pending one */
+	if (state->armed)
+		io_uring_queue_poll_remove (backend, IO_URING_TAG (fd, state->gen));
+	state->gen ++;
+	state->armed = TRUE;
+
+	io_uring_queue_poll (backend, fd, events, IO_URING_TAG (fd, state->gen));
+}
+
+static void
+uring_remove_fd (gpointer backend_data, gint fd)
+{
+	IOUringBackend *backend = (IOUringBackend*)backend_data;
+	IOUringFdState *state;
+
+	state = (IOUringFdState*)g_hash_table_lookup (backend->fds, GINT_TO_POINTER (fd));
+	if (!state)
+		return;
+
+	if (state->armed)
+		io_uring_queue_poll_remove (backend, IO_URING_TAG (fd, state->gen));
+	/* The fd number might be reused, so don't let a late completion reach it */
+	g_hash_table_remove (backend->fds, GINT_TO_POINTER (fd));
+}
+
+static gint
+uring_event_wait (gpointer backend_data, void (*callback) (gint fd, gint events, gpointer user_data), gpointer user_data)
+{
+	IOUringBackend *backend = (IOUringBackend*)backend_data;
+	guint32 head, tail;
+	gint res;
+	gboolean rearm_wakeup = FALSE;
+
+	mono_thread_info_set_flags (MONO_THREAD_INFO_FLAGS_NO_GC);
+
+	/* Submit the queued (re)registrations and wait for a completion with a single syscall */
+	MONO_ENTER_GC_SAFE;
+	res = io_uring_enter_syscall (backend, backend->to_submit, 1, IORING_ENTER_GETEVENTS);
+	MONO_EXIT_GC_SAFE;
+
+	mono_thread_info_set_flags (MONO_THREAD_INFO_FLAGS_NONE);
+
+	if (res == -1) {
+		switch (errno) {
+		case EINTR:
+		case EAGAIN:
+		case EBUSY:
+			break;
+		default:
+			g_error ("uring_event_wait: io_uring_enter () failed, error (%d) %s", errno, g_strerror (errno));
+			return -1;
+		}
+	} else {
+		backend->to_submit -= MIN ((guint32)res, backend->to_submit);
+	}
+
+	head = *backend->cq_head;
+	tail = *backend->cq_tail;
+	mono_memory_read_barrier ();
+
+	for (; head != tail; ++head) {
+		struct io_uring_cqe *cqe = &backend->cqes [head & backend->cq_mask];
+		guint64 tag = cqe->user_data;
+		gint fd, events = 0;
+		IOUringFdState *state;
+
+		if (tag == IO_URING_TAG_REMOVE)
+			continue;
+
+		if (tag == IO_URING_TAG_WAKEUP) {
+			rearm_wakeup = TRUE;
+			callback (backend->wakeup_fd, EVENT_IN, user_data);
+			continue;
+		}
+
+		fd = IO_URING_TAG_FD (tag);
+		state = (IOUringFdState*)g_hash_table_lookup (backend->fds, GINT_TO_POINTER (fd));
+		if (!state || state->gen != IO_URING_TAG_GEN (tag))
+			/* Replaced or removed since */
+			continue;
+		state->armed = FALSE;
+
+		if (cqe->res < 0) {
+			events = EVENT_IN | EVENT_OUT | EVENT_ERR;
+		} else {
+			if (cqe->res & (POLLIN | POLLERR | POLLHUP))
+				events |= EVENT_IN;
+			if (cqe->res & (POLLOUT | POLLERR | POLLHUP))
+				events |= EVENT_OUT;
+			if (cqe->res & POLLNVAL)
+				events |= EVENT_IN | EVENT_OUT | EVENT_ERR;
+		}
+
+		callback (fd, events, user_data);
+	}
+
+	/* Hand the reaped cqes back to the kernel */
+	mono_memory_barrier ();
+	*backend->cq_head = head;
+
+	if (rearm_wakeup)
+		io_uring_queue_poll (backend, backend->wakeup_fd, EVENT_IN, IO_URING_TAG_WAKEUP);
+
+	return 0;
+}
+
+static ThreadPoolIOBackend backend_io_uring = {
+	uring_init,
+	uring_register_fd,
+	uring_remove_fd,
+	uring_event_wait,
+};
+
+#endif
+
+#endif
@@ -20,6 +20,7 @@
 #else
 #include <errno.h>
 #include <fcntl.h>
+#include <mono/metadata/w32file.h>
 #endif
 
 #include <mono/metadata/gc-internals.h>
@@ -30,13 +31,15 @@
 #include <mono/utils/mono-threads.h>
 #include <mono/utils/mono-lazy-init.h>
 #include <mono/utils/mono-logger-internals.h>
+#include <mono/utils/mono-proclib.h>
 #include <mono/utils/w32api.h>
 
+/* Each selector thread has its own instance of the backend, init () returns its state or NULL on failure */
 typedef struct {
-	gboolean (*init) (gint wakeup_pipe_fd);
-	void     (*register_fd) (gint fd, gint events, gboolean is_new);
-	void     (*remove_fd) (gint fd);
-	gint     (*event_wait) (void (*callback) (gint fd, gint events, gpointer user_data), gpointer user_data);
+	gpointer (*init) (gint wakeup_pipe_fd);
+	void     (*register_fd) (gpointer backend_data, gint fd, gint events, gboolean is_new);
+	void     (*remove_fd) (gpointer backend_data, gint fd);
+	gint     (*event_wait) (gpointer backend_data, void (*callback) (gint fd, gint events, gpointer user_data), gpointer user_data);
 } ThreadPoolIOBackend;
 
 /* Keep in sync with System.IOOperation in mcs/class/System/System/IOSelector.cs */
@@ -47,11 +50,14 @@ enum MonoIOOperation {
 };
 
 #include "threadpool-io-epoll.c"
+#include "threadpool-io-uring.c"
 #include "threadpool-io-kqueue.c"
 #include "threadpool-io-poll.c"
 
 #define UPDATES_CAPACITY 128
 
+#define SELECTORS_MAX 64
+
 /* Keep in sync with System.IOSelectorJob in mcs/class/System/System/IOSelector.cs */
 struct _MonoIOSelectorJob {
 	MonoObject object;
@@ -89,26 +95,50 @@ typedef struct {
 	} data;
 } ThreadPoolIOUpdate;
 
+/*
+ * The state of one selector thread. The fds are sharded between the selectors, each
+ * one has its own backend instance, update queue and states table.
+ */
 typedef struct {
 	ThreadPoolIOBackend backend;
+	gpointer backend_data;
 
 	ThreadPoolIOUpdate updates [UPDATES_CAPACITY];
 	gint updates_size;
 	MonoCoopMutex updates_lock;
 	MonoCoopCond updates_cond;
 
+	gboolean running;
+
 #if !defined(HOST_WIN32)
 	gint wakeup_pipes [2];
 #else
 	SOCKET wakeup_pipes [2];
 #endif
-} ThreadPoolIO;
+} ThreadPoolIOSelector;
+
+typedef struct {
+	ThreadPoolIOSelector *selector;
+	MonoGHashTable *states;
+
+	/* The jobs made ready by one event_wait (), they are enqueued as a batch once it returns.
+	 * Allocated with mono_gc_alloc_fixed () so the GC sees them. */
+	MonoObject **ready_jobs;
+	gint ready_jobs_size;
+	gint ready_jobs_capacity;
+} ThreadPoolIOWaitData;
 
 static mono_lazy_init_t io_status = MONO_LAZY_INIT_STATUS_NOT_INITIALIZED;
 
-static gboolean io_selector_running = FALSE;
+static ThreadPoolIOSelector *selectors;
+static gint selectors_count;
 
-static ThreadPoolIO* threadpool_io;
+static ThreadPoolIOSelector*
+get_selector_for_fd (gint fd)
+{
+	/* fds are allocated sequentially, so this spreads them evenly */
+	return &selectors [(guint)fd % (guint)selectors_count];
+}
 
 static MonoIOSelectorJob*
 get_job_for_event (MonoMList **list, gint32 event)
@@ -142,14 +172,14 @@ get_operations_for_jobs (MonoMList *list)
 }
 
 static void
-selector_thread_wakeup (void)
+selector_thread_wakeup (ThreadPoolIOSelector *selector)
 {
 	gchar msg = 'c';
 	gint written;
 
 	for (;;) {
 #if !defined(HOST_WIN32)
-		written = write (threadpool_io->wakeup_pipes [1], &msg, 1);
+		written = write (selector->wakeup_pipes [1], &msg, 1);
 		if (written == 1)
 			break;
 		if (written == -1) {
@@ -157,7 +187,7 @@ selector_thread_wakeup (void)
 			break;
 		}
 #else
-		written = send (threadpool_io->wakeup_pipes [1], &msg, 1, 0);
+		written = send (selector->wakeup_pipes [1], &msg, 1, 0);
 		if (written == 1)
 			break;
 		if (written == SOCKET_ERROR) {
@@ -169,14 +199,14 @@ selector_thread_wakeup (void)
 }
 
 static void
-selector_thread_wakeup_drain_pipes (void)
+selector_thread_wakeup_drain_pipes (ThreadPoolIOSelector *selector)
 {
 	gchar buffer [128];
 	gint received;
 
 	for (;;) {
 #if !defined(HOST_WIN32)
-		received = read (threadpool_io->wakeup_pipes [0], buffer, sizeof (buffer));
+		received = read (selector->wakeup_pipes [0], buffer, sizeof (buffer));
 		if (received == 0)
 			break;
 		if (received == -1) {
@@ -193,7 +223,7 @@ selector_thread_wakeup_drain_pipes (void)
 			break;
 		}
 #else
-		received = recv (threadpool_io->wakeup_pipes [0], buffer, sizeof (buffer), 0);
+		received = recv (selector->wakeup_pipes [0], buffer, sizeof (buffer), 0);
 		if (received == 0)
 			break;
 		if (received == SOCKET_ERROR) {
@@ -254,16 +284,66 @@ filter_jobs_for_domain (gpointer key, gpointer value, gpointer user_data)
 }
 
 static void
-wait_callback (gint fd, gint events, gpointer user_data)
+ready_jobs_append (ThreadPoolIOWaitData *data, MonoObject *job)
+{
+	if (data->ready_jobs_size == data->ready_jobs_capacity) {
+		MonoObject **ready_jobs;
+		gint capacity;
+
+		capacity = data->ready_jobs_capacity * 2;
+		ready_jobs = (MonoObject **)mono_gc_alloc_fixed (capacity * sizeof (MonoObject*), MONO_GC_DESCRIPTOR_NULL, MONO_ROOT_SOURCE_THREAD_POOL, NULL, "Thread Pool I/O Ready Jobs");
+		memcpy (ready_jobs, data->ready_jobs, data->ready_jobs_size * sizeof (MonoObject*));
+
+		mono_gc_free_fixed (data->ready_jobs);
+		data->ready_jobs = ready_jobs;
+		data->ready_jobs_capacity = capacity;
+	}
+
+	data->ready_jobs [data->ready_jobs_size ++] = job;
+}
+
+/* Enqueue @jobs, one batch per run of jobs from the same domain */
+static void
+enqueue_jobs (MonoObject **jobs, gint count)
 {
 	ERROR_DECL (error);
+	gint i, start;
+
+	for (start = 0; start < count; start = i) {
+		MonoDomain *domain = mono_object_domain (jobs [start]);
+
+		for (i = start + 1; i < count; ++i) {
+			if (mono_object_domain (jobs [i]) != domain)
+				break;
+		}
+
+		mono_threadpool_enqueue_work_items (domain, &jobs [start], i - start, error);
+		mono_error_assert_ok (error);
+	}
+}
+
+/* Enqueue the jobs collected by wait_callback () */
+static void
+ready_jobs_flush (ThreadPoolIOWaitData *data)
+{
+	enqueue_jobs (data->ready_jobs, data->ready_jobs_size);
+
+	memset (data->ready_jobs, 0, data->ready_jobs_size * sizeof (MonoObject*));
+	data->ready_jobs_size = 0;
+}
+
+static void
+wait_callback (gint fd, gint events, gpointer user_data)
+{
+	ThreadPoolIOWaitData *data = (ThreadPoolIOWaitData *)user_data;
+	ThreadPoolIOSelector *selector = data->selector;
 
 	if (mono_runtime_is_shutting_down ())
 		return;
 
-	if (fd == threadpool_io->wakeup_pipes [0]) {
+	if (fd == selector->wakeup_pipes [0]) {
 		mono_trace (G_LOG_LEVEL_DEBUG, MONO_TRACE_IO_SELECTOR, "io threadpool: wke");
-		selector_thread_wakeup_drain_pipes ();
+		selector_thread_wakeup_drain_pipes (selector);
 	} else {
 		MonoGHashTable *states;
 		MonoMList *list = NULL;
@@ -271,8 +351,7 @@ wait_callback (gint fd, gint events, gpointer user_data)
 		gboolean remove_fd = FALSE;
 		gint operations;
 
-		g_assert (user_data);
-		states = (MonoGHashTable *)user_data;
+		states = data->states;
 
 		mono_trace (G_LOG_LEVEL_DEBUG, MONO_TRACE_IO_SELECTOR, "io threadpool: cal fd %3d, events = %2s | %2s | %3s",
 			fd, (events & EVENT_IN) ? "RD" : "..", (events & EVENT_OUT) ? "WR" : "..", (events & EVENT_ERR) ? "ERR" : "...");
@@ -282,18 +361,13 @@ wait_callback (gint fd, gint events, gpointer user_data)
 
 		if (list && (events & EVENT_IN) != 0) {
 			MonoIOSelectorJob *job = get_job_for_event (&list, EVENT_IN);
-			if (job) {
-				mono_threadpool_enqueue_work_item (((MonoObject*) job)->vtable->domain, (MonoObject*) job, error);
-				mono_error_assert_ok (error);
-			}
-
+			if (job)
+				ready_jobs_append (data, (MonoObject*) job);
 		}
 		if (list && (events & EVENT_OUT) != 0) {
 			MonoIOSelectorJob *job = get_job_for_event (&list, EVENT_OUT);
-			if (job) {
-				mono_threadpool_enqueue_work_item (((MonoObject*) job)->vtable->domain, (MonoObject*) job, error);
-				mono_error_assert_ok (error);
-			}
+			if (job)
+				ready_jobs_append (data, (MonoObject*) job);
 		}
 
 		remove_fd = (events & EVENT_ERR) == EVENT_ERR;
@@ -305,27 +379,29 @@ wait_callback (gint fd, gint events, gpointer user_data)
 			mono_trace (G_LOG_LEVEL_DEBUG, MONO_TRACE_IO_SELECTOR, "io threadpool: res fd %3d, events = %2s | %2s | %3s",
 				fd, (operations & EVENT_IN) ? "RD" : "..", (operations & EVENT_OUT) ? "WR" : "..", (operations & EVENT_ERR) ? "ERR" : "...");
 
-			threadpool_io->backend.register_fd (fd, operations, FALSE);
+			selector->backend.register_fd (selector->backend_data, fd, operations, FALSE);
 		} else {
 			mono_trace (G_LOG_LEVEL_DEBUG, MONO_TRACE_IO_SELECTOR, "io threadpool: err fd %d", fd);
 
 			mono_g_hash_table_remove (states, GINT_TO_POINTER (fd));
 
-			threadpool_io->backend.remove_fd (fd);
+			selector->backend.remove_fd (selector->backend_data, fd);
 		}
 	}
 }
 
 static void
-selector_thread_interrupt (gpointer unused)
+selector_thread_interrupt (gpointer data)
 {
-	selector_thread_wakeup ();
+	selector_thread_wakeup ((ThreadPoolIOSelector *)data);
 }
 
 static gsize WINAPI
 selector_thread (gpointer data)
 {
 	ERROR_DECL (error);
+	ThreadPoolIOSelector *selector = (ThreadPoolIOSelector *)data;
+	ThreadPoolIOWaitData wait_data;
 	MonoGHashTable *states;
 
 	MonoString *thread_name = mono_string_new_checked (mono_get_root_domain (), "Thread Pool I/O Selector", error);
@@ -334,11 +410,16 @@ selector_thread (gpointer data)
 	mono_error_assert_ok (error);
 
 	if (mono_runtime_is_shutting_down ()) {
-		io_selector_running = FALSE;
+		selector->running = FALSE;
 		return 0;
 	}
 
 	states = mono_g_hash_table_new_type_internal (g_direct_hash, NULL, MONO_HASH_VALUE_GC, MONO_ROOT_SOURCE_THREAD_POOL, NULL, "Thread Pool I/O State Table");
+	wait_data.selector = selector;
+	wait_data.states = states;
+	wait_data.ready_jobs_size = 0;
+	wait_data.ready_jobs_capacity = 64;
+	wait_data.ready_jobs = (MonoObject **)mono_gc_alloc_fixed (wait_data.ready_jobs_capacity * sizeof (MonoObject*), MONO_GC_DESCRIPTOR_NULL, MONO_ROOT_SOURCE_THREAD_POOL, NULL, "Thread Pool I/O Ready Jobs");
 
 	while (!mono_runtime_is_shutting_down ()) {
 		gint i, j;
@@ -348,10 +429,10 @@ selector_thread (gpointer data)
 		if (mono_thread_interruption_checkpoint_bool ())
 			continue;
 
-		mono_coop_mutex_lock (&threadpool_io->updates_lock);
+		mono_coop_mutex_lock (&selector->updates_lock);
 
-		for (i = 0; i < threadpool_io->updates_size; ++i) {
-			ThreadPoolIOUpdate *update = &threadpool_io->updates [i];
+		for (i = 0; i < selector->updates_size; ++i) {
+			ThreadPoolIOUpdate *update = &selector->updates [i];
 
 			switch (update->type) {
 			case UPDATE_EMPTY:
@@ -380,7 +461,7 @@ selector_thread (gpointer data)
 				mono_trace (G_LOG_LEVEL_DEBUG, MONO_TRACE_IO_SELECTOR, "io threadpool: %3s fd %3d, operations = %2s | %2s | %3s",
 					exists ? "mod" : "add", fd, (operations & EVENT_IN) ? "RD" : "..", (operations & EVENT_OUT) ? "WR" : "..", (operations & EVENT_ERR) ? "ERR" : "...");
 
-				threadpool_io->backend.register_fd (fd, operations, !exists);
+				selector->backend.register_fd (selector->backend_data, fd, operations, !exists);
 
 				break;
 			}
@@ -395,8 +476,8 @@ selector_thread (gpointer data)
 				if (mono_g_hash_table_lookup_extended (states, GINT_TO_POINTER (fd), &k, (gpointer*) &list)) {
 					mono_g_hash_table_remove (states, GINT_TO_POINTER (fd));
 
-					for (j = i + 1; j < threadpool_io->updates_size; ++j) {
-						ThreadPoolIOUpdate *update = &threadpool_io->updates [j];
+					for (j = i + 1; j < selector->updates_size; ++j) {
+						ThreadPoolIOUpdate *update = &selector->updates [j];
 						if (update->type == UPDATE_ADD && update->data.add.fd == fd)
 							memset (update, 0, sizeof (ThreadPoolIOUpdate));
 					}
@@ -408,7 +489,7 @@ selector_thread (gpointer data)
 					}
 
 					mono_trace (G_LOG_LEVEL_DEBUG, MONO_TRACE_IO_SELECTOR, "io threadpool: del fd %3d", fd);
-					threadpool_io->backend.remove_fd (fd);
+					selector->backend.remove_fd (selector->backend_data, fd);
 				}
 
 				break;
@@ -425,8 +506,8 @@ selector_thread (gpointer data)
 				user_data.states = states;
 				mono_g_hash_table_foreach (states, filter_jobs_for_domain, &user_data);
 
-				for (j = i + 1; j < threadpool_io->updates_size; ++j) {
-					ThreadPoolIOUpdate *update = &threadpool_io->updates [j];
+				for (j = i + 1; j < selector->updates_size; ++j) {
+					ThreadPoolIOUpdate *update = &selector->updates [j];
 					if (update->type == UPDATE_ADD && mono_object_domain (update->data.add.job) == domain)
 						memset (update, 0, sizeof (ThreadPoolIOUpdate));
 				}
@@ -438,68 +519,73 @@ selector_thread (gpointer data)
 			}
 		}
 
-		mono_coop_cond_broadcast (&threadpool_io->updates_cond);
+		mono_coop_cond_broadcast (&selector->updates_cond);
 
-		if (threadpool_io->updates_size > 0) {
-			threadpool_io->updates_size = 0;
-			memset (&threadpool_io->updates, 0, UPDATES_CAPACITY * sizeof (ThreadPoolIOUpdate));
+		if (selector->updates_size > 0) {
+			selector->updates_size = 0;
+			memset (&selector->updates, 0, UPDATES_CAPACITY * sizeof (ThreadPoolIOUpdate));
 		}
 
-		mono_coop_mutex_unlock (&threadpool_io->updates_lock);
+		mono_coop_mutex_unlock (&selector->updates_lock);
 
 		mono_trace (G_LOG_LEVEL_DEBUG, MONO_TRACE_IO_SELECTOR, "io threadpool: wai");
 
-		mono_thread_info_install_interrupt (selector_thread_interrupt, NULL, &interrupted);
+		mono_thread_info_install_interrupt (selector_thread_interrupt, selector, &interrupted);
 		if (interrupted)
 			continue;
 
-		res = threadpool_io->backend.event_wait (wait_callback, states);
+		res = selector->backend.event_wait (selector->backend_data, wait_callback, &wait_data);
+
+		if (!mono_runtime_is_shutting_down ())
+			ready_jobs_flush (&wait_data);
+
 		if (res == -1)
 			break;
 
 		mono_thread_info_uninstall_interrupt (&interrupted);
 	}
 
+	mono_gc_free_fixed (wait_data.ready_jobs);
 	mono_g_hash_table_destroy (states);
 
-	mono_coop_mutex_lock (&threadpool_io->updates_lock);
+	mono_coop_mutex_lock (&selector->updates_lock);
 
-	io_selector_running = FALSE;
-	mono_coop_cond_broadcast (&threadpool_io->updates_cond);
+	selector->running = FALSE;
+	mono_coop_cond_broadcast (&selector->updates_cond);
 
-	mono_coop_mutex_unlock (&threadpool_io->updates_lock);
+	mono_coop_mutex_unlock (&selector->updates_lock);
 
 	return 0;
 }
 
-/* Locking: threadpool_io->updates_lock must be held */
+/* Locking: selector->updates_lock must be held */
 static ThreadPoolIOUpdate*
-update_get_new (void)
+update_get_new (ThreadPoolIOSelector *selector)
 {
 	ThreadPoolIOUpdate *update = NULL;
-	g_assert (threadpool_io->updates_size <= UPDATES_CAPACITY);
+	g_assert (selector->updates_size <= UPDATES_CAPACITY);
 
-	while (threadpool_io->updates_size == UPDATES_CAPACITY) {
+	while (selector->updates_size == UPDATES_CAPACITY) {
 		/* we wait for updates to be applied in the selector_thread and we loop
 		 * as long as none are available. if it happends too much, then we need
 		 * to increase UPDATES_CAPACITY */
-		mono_coop_cond_wait (&threadpool_io->updates_cond, &threadpool_io->updates_lock);
+		mono_coop_cond_wait (&selector->updates_cond, &selector->updates_lock);
 	}
 
-	g_assert (threadpool_io->updates_size < UPDATES_CAPACITY);
+	g_assert (selector->updates_size < UPDATES_CAPACITY);
 
-	update = &threadpool_io->updates [threadpool_io->updates_size ++];
+	update = &selector->updates [selector->updates_size ++];
 
 	return update;
 }
 
 static void
-wakeup_pipes_init (void)
+wakeup_pipes_init (ThreadPoolIOSelector *selector)
 {
 #if !defined(HOST_WIN32)
-	if (pipe (threadpool_io->wakeup_pipes) == -1)
+	if (pipe (selector->wakeup_pipes) == -1)
 		g_error ("wakeup_pipes_init: pipe () failed, error (%d) %s\n", errno, g_strerror (errno));
-	if (fcntl (threadpool_io->wakeup_pipes [0], F_SETFL, O_NONBLOCK) == -1)
+	if (fcntl (selector->wakeup_pipes [0], F_SETFL, O_NONBLOCK) == -1)
 		g_error ("wakeup_pipes_init: fcntl () failed, error (%d) %s\n", errno, g_strerror (errno));
 #else
 	struct sockaddr_in client;
@@ -510,8 +596,8 @@ wakeup_pipes_init (void)
 
 	server_sock = socket (AF_INET, SOCK_STREAM, IPPROTO_TCP);
 	g_assert (server_sock != INVALID_SOCKET);
-	threadpool_io->wakeup_pipes [1] = socket (AF_INET, SOCK_STREAM, IPPROTO_TCP);
-	g_assert (threadpool_io->wakeup_pipes [1] != INVALID_SOCKET);
+	selector->wakeup_pipes [1] = socket (AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	g_assert (selector->wakeup_pipes [1] != INVALID_SOCKET);
 
 	server.sin_family = AF_INET;
 	server.sin_addr.s_addr = inet_addr ("127.0.0.1");
@@ -530,18 +616,18 @@ wakeup_pipes_init (void)
 		closesocket (server_sock);
 		g_error ("wakeup_pipes_init: listen () failed, error (%d)\n", WSAGetLastError ());
 	}
-	if (connect ((SOCKET) threadpool_io->wakeup_pipes [1], (SOCKADDR*) &server, sizeof (server)) == SOCKET_ERROR) {
+	if (connect ((SOCKET) selector->wakeup_pipes [1], (SOCKADDR*) &server, sizeof (server)) == SOCKET_ERROR) {
 		closesocket (server_sock);
 		g_error ("wakeup_pipes_init: connect () failed, error (%d)\n", WSAGetLastError ());
 	}
 
 	size = sizeof (client);
-	threadpool_io->wakeup_pipes [0] = accept (server_sock, (SOCKADDR *) &client, &size);
-	g_assert (threadpool_io->wakeup_pipes [0] != INVALID_SOCKET);
+	selector->wakeup_pipes [0] = accept (server_sock, (SOCKADDR *) &client, &size);
+	g_assert (selector->wakeup_pipes [0] != INVALID_SOCKET);
 
 	arg = 1;
-	if (ioctlsocket (threadpool_io->wakeup_pipes [0], FIONBIO, &arg) == SOCKET_ERROR) {
-		closesocket (threadpool_io->wakeup_pipes [0]);
+	if (ioctlsocket (selector->wakeup_pipes [0], FIONBIO, &arg) == SOCKET_ERROR) {
+		closesocket (selector->wakeup_pipes [0]);
 		closesocket (server_sock);
 		g_error ("wakeup_pipes_init: ioctlsocket () failed, error (%d)\n", WSAGetLastError ());
 	}
@@ -550,42 +636,346 @@ wakeup_pipes_init (void)
 #endif
 }
 
-static void
-initialize (void)
+static gint
+get_selectors_count (void)
 {
-	g_assert (!threadpool_io);
-	threadpool_io = g_new0 (ThreadPoolIO, 1);
-	g_assert (threadpool_io);
+	char *env;
+	gint count = 1;
+
+	/* MONO_THREADPOOL_IO_SELECTORS=<count>|auto */
+	env = g_getenv ("MONO_THREADPOOL_IO_SELECTORS");
+	if (env) {
+		if (!strcmp (env, "auto"))
+			count = mono_cpu_count ();
+		else
+			count = atoi (env);
+		g_free (env);
+	}
 
-	mono_coop_mutex_init (&threadpool_io->updates_lock);
-	mono_coop_cond_init (&threadpool_io->updates_cond);
-	mono_gc_register_root ((char *)&threadpool_io->updates [0], sizeof (threadpool_io->updates), MONO_GC_DESCRIPTOR_NULL, MONO_ROOT_SOURCE_THREAD_POOL, NULL, "Thread Pool I/O Update List");
+	return CLAMP (count, 1, SELECTORS_MAX);
+}
+
+static void
+selector_init (ThreadPoolIOSelector *selector)
+{
+	mono_coop_mutex_init (&selector->updates_lock);
+	mono_coop_cond_init (&selector->updates_cond);
+	mono_gc_register_root ((char *)&selector->updates [0], sizeof (selector->updates), MONO_GC_DESCRIPTOR_NULL, MONO_ROOT_SOURCE_THREAD_POOL, NULL, "Thread Pool I/O Update List");
 
-	threadpool_io->updates_size = 0;
+	selector->updates_size = 0;
 
-	threadpool_io->backend = backend_poll;
+	selector->backend = backend_poll;
 	if (g_hasenv ("MONO_ENABLE_AIO")) {
 #if defined(HAVE_EPOLL)
-		threadpool_io->backend = backend_epoll;
+		/* MONO_ENABLE_AIO=epoll_et selects the edge-triggered mode */
+		char *aio = g_getenv ("MONO_ENABLE_AIO");
+
+		if (aio && !strcmp (aio, "epoll_et"))
+			selector->backend = backend_epoll_et;
+		else
+			selector->backend = backend_epoll;
+		g_free (aio);
 #elif defined(HAVE_KQUEUE)
-		threadpool_io->backend = backend_kqueue;
+		selector->backend = backend_kqueue;
 #endif
 	}
 
-	wakeup_pipes_init ();
+	wakeup_pipes_init (selector);
+
+	selector->backend_data = NULL;
+#if defined(HAVE_IO_URING)
+	/* MONO_ENABLE_AIO=io_uring, falls back to the default backend if the kernel doesn't support it */
+	{
+		char *aio = g_getenv ("MONO_ENABLE_AIO");
+		gboolean use_io_uring = aio && !strcmp (aio, "io_uring");
+
+		g_free (aio);
+		if (use_io_uring && (selector->backend_data = uring_init (selector->wakeup_pipes [0])))
+			selector->backend = backend_io_uring;
+	}
+#endif
 
-	if (!threadpool_io->backend.init (threadpool_io->wakeup_pipes [0]))
+	if (!selector->backend_data && !(selector->backend_data = selector->backend.init (selector->wakeup_pipes [0])))
 		g_error ("initialize: backend->init () failed");
 
-	mono_coop_mutex_lock (&threadpool_io->updates_lock);
+	mono_coop_mutex_lock (&selector->updates_lock);
 
-	io_selector_running = TRUE;
+	selector->running = TRUE;
 
 	ERROR_DECL (error);
-	if (!mono_thread_create_internal (mono_get_root_domain (), (gpointer)selector_thread, NULL, (MonoThreadCreateFlags)(MONO_THREAD_CREATE_FLAGS_THREADPOOL | MONO_THREAD_CREATE_FLAGS_SMALL_STACK), error))
+	if (!mono_thread_create_internal (mono_get_root_domain (), (gpointer)selector_thread, selector, (MonoThreadCreateFlags)(MONO_THREAD_CREATE_FLAGS_THREADPOOL | MONO_THREAD_CREATE_FLAGS_SMALL_STACK), error))
 		g_error ("initialize: mono_thread_create_internal () failed due to %s", mono_error_get_message (error));
 
-	mono_coop_mutex_unlock (&threadpool_io->updates_lock);
+	mono_coop_mutex_unlock (&selector->updates_lock);
+}
+
+#if !defined(HOST_WIN32)
+
+/*
+ * Asynchronous file I/O: regular files are always readable and writable as far as
+ * poll/epoll are concerned, so they can't go through the selectors. The reads and
+ * writes are instead queued to a small dedicated pool of threads, which take them in
+ * batches, issue them sorted by file and offset with pread/pwrite, and then enqueue
+ * the completed jobs to the threadpool the same way the selectors do.
+ */
+
+#define FILE_IO_THREADS_DEFAULT 4
+#define FILE_IO_THREADS_MAX 64
+#define FILE_IO_BATCH_MAX 32
+#define FILE_IO_REQUESTS_INITIAL_CAPACITY 64
+
+typedef struct {
+	gpointer handle;
+	gpointer buffer;
+	guint32 count;
+	gint64 offset;
+	gboolean write;
+	/* Set to the number of bytes transferred, or to the negated win32 error */
+	gint64 *result;
+	MonoIOSelectorJob *job;
+} ThreadPoolFileIORequest;
+
+typedef struct {
+	/* Allocated with mono_gc_alloc_fixed () so the GC sees the jobs */
+	ThreadPoolFileIORequest *batch;
+	gint batch_size;
+} ThreadPoolFileIOThread;
+
+typedef struct {
+	MonoCoopMutex lock;
+	/* Signalled when requests are queued */
+	MonoCoopCond requests_cond;
+	/* Signalled when a thread is done with a batch */
+	MonoCoopCond batch_done_cond;
+
+	/* Ring buffer, allocated with mono_gc_alloc_fixed () so the GC sees the jobs */
+	ThreadPoolFileIORequest *requests;
+	gint requests_head;
+	gint requests_size;
+	gint requests_capacity;
+
+	ThreadPoolFileIOThread *threads;
+	gint threads_count;
+} ThreadPoolFileIO;
+
+static mono_lazy_init_t file_io_status = MONO_LAZY_INIT_STATUS_NOT_INITIALIZED;
+
+static ThreadPoolFileIO file_io;
+
+static ThreadPoolFileIORequest*
+file_io_requests_alloc (gint capacity)
+{
+	return (ThreadPoolFileIORequest *)mono_gc_alloc_fixed (capacity * sizeof (ThreadPoolFileIORequest), MONO_GC_DESCRIPTOR_NULL, MONO_ROOT_SOURCE_THREAD_POOL, NULL, "Thread Pool I/O File Requests");
+}
+
+/* LOCKING: file_io.lock must be held. */
+static ThreadPoolFileIORequest*
+file_io_requests_get (gint i)
+{
+	return &file_io.requests [(file_io.requests_head + i) % file_io.requests_capacity];
+}
+
+/* LOCKING: file_io.lock must be held. */
+static ThreadPoolFileIORequest*
+file_io_requests_push (void)
+{
+	if (file_io.requests_size == file_io.requests_capacity) {
+		ThreadPoolFileIORequest *requests;
+		gint i;
+
+		requests = file_io_requests_alloc (file_io.requests_capacity * 2);
+		for (i = 0; i < file_io.requests_size; ++i)
+			requests [i] = *file_io_requests_get (i);
+
+		mono_gc_free_fixed (file_io.requests);
+		file_io.requests = requests;
+		file_io.requests_head = 0;
+		file_io.requests_capacity *= 2;
+	}
+
+	return file_io_requests_get (file_io.requests_size ++);
+}
+
+static gint
+file_io_request_compare (gconstpointer a, gconstpointer b)
+{
+	const ThreadPoolFileIORequest *ra = (const ThreadPoolFileIORequest *)a;
+	const ThreadPoolFileIORequest *rb = (const ThreadPoolFileIORequest *)b;
+
+	if (ra->handle != rb->handle)
+		return ra->handle < rb->handle ? -1 : 1;
+	if (ra->offset != rb->offset)
+		return ra->offset < rb->offset ? -1 : 1;
+	return 0;
+}
+
+static gsize WINAPI
+file_io_thread (gpointer data)
+{
+	ERROR_DECL (error);
+	ThreadPoolFileIOThread *thread = (ThreadPoolFileIOThread *)data;
+	MonoObject *jobs [FILE_IO_BATCH_MAX];
+
+	MonoString *thread_name = mono_string_new_checked (mono_get_root_domain (), "Thread Pool I/O File", error);
+	mono_error_assert_ok (error);
+	mono_thread_set_name_internal (mono_thread_internal_current (), thread_name, FALSE, TRUE, error);
+	mono_error_assert_ok (error);
+
+	while (!mono_runtime_is_shutting_down ()) {
+		gint i;
+
+		mono_coop_mutex_lock (&file_io.lock);
+
+		while (file_io.requests_size == 0 && !mono_runtime_is_shutting_down ())
+			mono_coop_cond_timedwait (&file_io.requests_cond, &file_io.lock, 1000);
+
+		for (i = 0; i < FILE_IO_BATCH_MAX && file_io.requests_size > 0; ++i) {
+			ThreadPoolFileIORequest *request = file_io_requests_get (0);
+
+			thread->batch [i] = *request;
+			memset (request, 0, sizeof (ThreadPoolFileIORequest));
+
+			file_io.requests_head = (file_io.requests_head + 1) % file_io.requests_capacity;
+			file_io.requests_size -= 1;
+		}
+		thread->batch_size = i;
+
+		mono_coop_mutex_unlock (&file_io.lock);
+
+		if (thread->batch_size == 0)
+			continue;
+
+		/* Issue the requests on the same file in offset order, which keeps readahead and writeback sequential */
+		qsort (thread->batch, thread->batch_size, sizeof (ThreadPoolFileIORequest), file_io_request_compare);
+
+		for (i = 0; i < thread->batch_size; ++i) {
+			ThreadPoolFileIORequest *request = &thread->batch [i];
+			guint32 transferred;
+			gint32 win32error;
+
+			if (mono_w32file_read_or_write_at (!request->write, request->handle, request->buffer, request->count, request->offset, &transferred, &win32error))
+				*request->result = transferred;
+			else
+				*request->result = - (gint64) win32error;
+
+			jobs [i] = (MonoObject *)request->job;
+		}
+
+		mono_memory_barrier (); /* Ensure the results are visible before the jobs run */
+
+		enqueue_jobs (jobs, thread->batch_size);
+		memset (jobs, 0, thread->batch_size * sizeof (MonoObject*));
+
+		mono_coop_mutex_lock (&file_io.lock);
+		memset (thread->batch, 0, thread->batch_size * sizeof (ThreadPoolFileIORequest));
+		thread->batch_size = 0;
+		mono_coop_cond_broadcast (&file_io.batch_done_cond);
+		mono_coop_mutex_unlock (&file_io.lock);
+	}
+
+	return 0;
+}
+
+static gint
+get_file_io_threads_count (void)
+{
+	char *env;
+	gint count = FILE_IO_THREADS_DEFAULT;
+
+	/* MONO_THREADPOOL_FILE_IO_THREADS=<count> */
+	env = g_getenv ("MONO_THREADPOOL_FILE_IO_THREADS");
+	if (env) {
+		count = atoi (env);
+		g_free (env);
+	}
+
+	return CLAMP (count, 1, FILE_IO_THREADS_MAX);
+}
+
+static void
+file_io_initialize (void)
+{
+	gint i;
+
+	mono_coop_mutex_init (&file_io.lock);
+	mono_coop_cond_init (&file_io.requests_cond);
+	mono_coop_cond_init (&file_io.batch_done_cond);
+
+	file_io.requests_capacity = FILE_IO_REQUESTS_INITIAL_CAPACITY;
+	file_io.requests = file_io_requests_alloc (file_io.requests_capacity);
+
+	file_io.threads_count = get_file_io_threads_count ();
+	file_io.threads = g_new0 (ThreadPoolFileIOThread, file_io.threads_count);
+
+	for (i = 0; i < file_io.threads_count; ++i) {
+		ERROR_DECL (error);
+
+		file_io.threads [i].batch = file_io_requests_alloc (FILE_IO_BATCH_MAX);
+		if (!mono_thread_create_internal (mono_get_root_domain (), (gpointer)file_io_thread, &file_io.threads [i], (MonoThreadCreateFlags)(MONO_THREAD_CREATE_FLAGS_THREADPOOL | MONO_THREAD_CREATE_FLAGS_SMALL_STACK), error))
+			g_error ("file_io_initialize: mono_thread_create_internal () failed due to %s", mono_error_get_message (error));
+	}
+}
+
+/* Whether one of the batches being executed has a job from @domain. LOCKING: file_io.lock must be held. */
+static gboolean
+file_io_domain_in_flight (MonoDomain *domain)
+{
+	gint i, j;
+
+	for (i = 0; i < file_io.threads_count; ++i) {
+		ThreadPoolFileIOThread *thread = &file_io.threads [i];
+
+		for (j = 0; j < thread->batch_size; ++j) {
+			if (mono_object_domain (thread->batch [j].job) == domain)
+				return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+static void
+file_io_remove_domain_jobs (MonoDomain *domain)
+{
+	gint i, size;
+
+	if (!mono_lazy_is_initialized (&file_io_status))
+		return;
+
+	mono_coop_mutex_lock (&file_io.lock);
+
+	/* Drop the requests which haven't been picked up yet, keeping the others in order */
+	for (i = 0, size = 0; i < file_io.requests_size; ++i) {
+		ThreadPoolFileIORequest *request = file_io_requests_get (i);
+
+		if (mono_object_domain (request->job) != domain)
+			*file_io_requests_get (size ++) = *request;
+	}
+	for (i = size; i < file_io.requests_size; ++i)
+		memset (file_io_requests_get (i), 0, sizeof (ThreadPoolFileIORequest));
+	file_io.requests_size = size;
+
+	/* And wait for the ones being executed, so no job of @domain is enqueued once we return */
+	while (file_io_domain_in_flight (domain))
+		mono_coop_cond_wait (&file_io.batch_done_cond, &file_io.lock);
+
+	mono_coop_mutex_unlock (&file_io.lock);
+}
+
+#endif /* !defined(HOST_WIN32) */
+
+static void
+initialize (void)
+{
+	gint i;
+
+	g_assert (!selectors);
+	selectors_count = get_selectors_count ();
+	selectors = g_new0 (ThreadPoolIOSelector, selectors_count);
+	g_assert (selectors);
+
+	for (i = 0; i < selectors_count; ++i)
+		selector_init (&selectors [i]);
 }
 
 static void
@@ -603,6 +993,7 @@ mono_threadpool_io_cleanup (void)
 void
 ves_icall_System_IOSelector_Add (gpointer handle, MonoIOSelectorJob *job)
 {
+	ThreadPoolIOSelector *selector;
 	ThreadPoolIOUpdate *update;
 
 	g_assert (handle);
@@ -617,22 +1008,72 @@ ves_icall_System_IOSelector_Add (gpointer handle, MonoIOSelectorJob *job)
 
 	mono_lazy_initialize (&io_status, initialize);
 
-	mono_coop_mutex_lock (&threadpool_io->updates_lock);
+	selector = get_selector_for_fd (GPOINTER_TO_INT (handle));
+
+	mono_coop_mutex_lock (&selector->updates_lock);
 
-	if (!io_selector_running) {
-		mono_coop_mutex_unlock (&threadpool_io->updates_lock);
+	if (!selector->running) {
+		mono_coop_mutex_unlock (&selector->updates_lock);
 		return;
 	}
 
-	update = update_get_new ();
+	update = update_get_new (selector);
 	update->type = UPDATE_ADD;
 	update->data.add.fd = GPOINTER_TO_INT (handle);
 	update->data.add.job = job;
 	mono_memory_barrier (); /* Ensure this is safely published before we wake up the selector */
 
-	selector_thread_wakeup ();
+	selector_thread_wakeup (selector);
 
-	mono_coop_mutex_unlock (&threadpool_io->updates_lock);
+	mono_coop_mutex_unlock (&selector->updates_lock);
+}
+
+/*
+ * ves_icall_System_IOSelector_AddFile:
+ *
+ *   Read or write @count bytes of the file @handle at @offset asynchronously. Once done,
+ * *@result is set to the number of bytes transferred, or to the negated win32 error, and
+ * @job is enqueued to the threadpool. @buffer and @result must stay valid until then.
+ * Returns FALSE if asynchronous file I/O isn't supported, in which case the caller should
+ * fall back to a synchronous read or write.
+ */
+MonoBoolean
+ves_icall_System_IOSelector_AddFile (gpointer handle, gpointer buffer, gint32 count, gint64 offset, MonoBoolean write, gint64 *result, MonoIOSelectorJob *job)
+{
+#if !defined(HOST_WIN32)
+	ThreadPoolFileIORequest *request;
+
+	g_assert (result);
+	g_assert (job->callback);
+
+	if (count < 0 || offset < 0)
+		return FALSE;
+	if (mono_runtime_is_shutting_down ())
+		return FALSE;
+	if (mono_domain_is_unloading (mono_object_domain (job)))
+		return FALSE;
+
+	mono_lazy_initialize (&file_io_status, file_io_initialize);
+
+	mono_coop_mutex_lock (&file_io.lock);
+
+	request = file_io_requests_push ();
+	request->handle = handle;
+	request->buffer = buffer;
+	request->count = count;
+	request->offset = offset;
+	request->write = write;
+	request->result = result;
+	request->job = job;
+
+	mono_coop_cond_signal (&file_io.requests_cond);
+
+	mono_coop_mutex_unlock (&file_io.lock);
+
+	return TRUE;
+#else
+	return FALSE;
+#endif
 }
 
 void
@@ -644,55 +1085,71 @@ ves_icall_System_IOSelector_Remove (gpointer handle)
 void
 mono_threadpool_io_remove_socket (int fd)
 {
+	ThreadPoolIOSelector *selector;
 	ThreadPoolIOUpdate *update;
 
 	if (!mono_lazy_is_initialized (&io_status))
 		return;
 
-	mono_coop_mutex_lock (&threadpool_io->updates_lock);
+	selector = get_selector_for_fd (fd);
+
+	mono_coop_mutex_lock (&selector->updates_lock);
 
-	if (!io_selector_running) {
-		mono_coop_mutex_unlock (&threadpool_io->updates_lock);
+	if (!selector->running) {
+		mono_coop_mutex_unlock (&selector->updates_lock);
 		return;
 	}
 
-	update = update_get_new ();
+	update = update_get_new (selector);
 	update->type = UPDATE_REMOVE_SOCKET;
 	update->data.remove_socket.fd = fd;
 	mono_memory_barrier (); /* Ensure this is safely published before we wake up the selector */
 
-	selector_thread_wakeup ();
+	selector_thread_wakeup (selector);
 
-	mono_coop_cond_wait (&threadpool_io->updates_cond, &threadpool_io->updates_lock);
+	mono_coop_cond_wait (&selector->updates_cond, &selector->updates_lock);
 
-	mono_coop_mutex_unlock (&threadpool_io->updates_lock);
+	mono_coop_mutex_unlock (&selector->updates_lock);
 }
 
-void
-mono_threadpool_io_remove_domain_jobs (MonoDomain *domain)
+static void
+selector_remove_domain_jobs (ThreadPoolIOSelector *selector, MonoDomain *domain)
 {
 	ThreadPoolIOUpdate *update;
 
-	if (!mono_lazy_is_initialized (&io_status))
-		return;
-
-	mono_coop_mutex_lock (&threadpool_io->updates_lock);
+	mono_coop_mutex_lock (&selector->updates_lock);
 
-	if (!io_selector_running) {
-		mono_coop_mutex_unlock (&threadpool_io->updates_lock);
+	if (!selector->running) {
+		mono_coop_mutex_unlock (&selector->updates_lock);
 		return;
 	}
 
-	update = update_get_new ();
+	update = update_get_new (selector);
 	update->type = UPDATE_REMOVE_DOMAIN;
 	update->data.remove_domain.domain = domain;
 	mono_memory_barrier (); /* Ensure this is safely published before we wake up the selector */
 
-	selector_thread_wakeup ();
+	selector_thread_wakeup (selector);
 
-	mono_coop_cond_wait (&threadpool_io->updates_cond, &threadpool_io->updates_lock);
+	mono_coop_cond_wait (&selector->updates_cond, &selector->updates_lock);
 
-	mono_coop_mutex_unlock (&threadpool_io->updates_lock);
+	mono_coop_mutex_unlock (&selector->updates_lock);
+}
+
+void
+mono_threadpool_io_remove_domain_jobs (MonoDomain *domain)
+{
+	gint i;
+
+#if !defined(HOST_WIN32)
+	file_io_remove_domain_jobs (domain);
+#endif
+
+	if (!mono_lazy_is_initialized (&io_status))
+		return;
+
+	for (i = 0; i < selectors_count; ++i)
+		selector_remove_domain_jobs (&selectors [i], domain);
 }
 
 #else
@@ -703,6 +1160,12 @@ ves_icall_System_IOSelector_Add (gpointer handle, MonoIOSelectorJob *job)
 	g_assert_not_reached ();
 }
 
+MonoBoolean
+ves_icall_System_IOSelector_AddFile (gpointer handle, gpointer buffer, gint32 count, gint64 offset, MonoBoolean write, gint64 *result, MonoIOSelectorJob *job)
+{
+	return FALSE;
+}
+
 void
 ves_icall_System_IOSelector_Remove (gpointer handle)
 {
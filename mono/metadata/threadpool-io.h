@@ -17,6 +17,10 @@ ICALL_EXPORT
 void
 ves_icall_System_IOSelector_Add (gpointer handle, MonoIOSelectorJob *job);
 
+ICALL_EXPORT
+MonoBoolean
+ves_icall_System_IOSelector_AddFile (gpointer handle, gpointer buffer, gint32 count, gint64 offset, MonoBoolean write, gint64 *result, MonoIOSelectorJob *job);
+
 ICALL_EXPORT
 void
 ves_icall_System_IOSelector_Remove (gpointer handle);
@@ -30,11 +30,15 @@
 #include <mono/utils/mono-proclib.h>
 #include <mono/utils/mono-threads.h>
 #include <mono/utils/mono-time.h>
+#include <mono/utils/mono-tls.h>
 #include <mono/utils/mono-rand.h>
 #include <mono/utils/refcount.h>
 #include <mono/utils/w32api.h>
 #include <mono/utils/mono-complex.h> // This header has defines to muck with names, so put it late.
 
+/* Unless configured with --enable-wasm-threadpool, wasm runs threadpool work on the browser's main thread, see threadpool-worker-wasm.c */
+#if !defined (HOST_WASM) || defined (ENABLE_WASM_THREADPOOL)
+
 #define CPU_USAGE_LOW 80
 #define CPU_USAGE_HIGH 95
 
@@ -43,6 +47,25 @@
 
 #define WORKER_CREATION_MAX_PER_SEC 10
 
+/* The latency controller (MONO_THREADPOOL_CONTROLLER=latency) samples more often, and
+ * is allowed to create threads faster, so it can react to a burst of blocking work */
+#define LATENCY_MONITOR_INTERVAL 100 // ms
+#define LATENCY_WORKER_CREATION_MAX_PER_SEC 100
+/* Above this queue wait, threads are injected */
+#define LATENCY_TARGET 50 // ms
+/* Maximum number of threads injected in one round of the monitor */
+#define LATENCY_MAX_INJECTION 16
+/* Number of consecutive idle rounds before giving one thread back */
+#define LATENCY_IDLE_ROUNDS_BEFORE_DECAY 10
+
+#define WORK_ITEM_LOCAL_QUEUES_MAX 128
+
+/* Bounds of the number of iterations an idle worker spins on the work queues before parking */
+#define WORKER_SPIN_MIN 16
+#define WORKER_SPIN_MAX 4096
+/* Yield the processor every that many iterations while spinning */
+#define WORKER_SPIN_YIELD_EVERY 64
+
 /* The exponent to apply to the gain. 1.0 means to use linear gain,
  * higher values will enhance large moves and damp small ones.
  * default: 2.0 */
@@ -124,6 +147,24 @@ __attribute__((aligned(64)))
 #endif
 ;
 
+typedef enum {
+	CONTROLLER_HILL_CLIMBING,
+	CONTROLLER_LATENCY,
+} ThreadPoolController;
+
+/*
+ * The work items are only tokens, the actual items live in the managed ThreadPoolWorkQueue,
+ * which already does LIFO local pop and FIFO steal. A single global count of them was
+ * contended by every worker, so each group of workers has its own local count, padded so
+ * two of them never share a cache line. A worker requesting more work pushes to its own
+ * queue so it picks the item up itself once it's done with the current one, other threads
+ * push to the global injection queue, and idle workers steal from the others.
+ */
+typedef struct {
+	volatile gint32 count;
+	gchar padding [128 - sizeof (gint32)];
+} ThreadPoolWorkItemQueue;
+
 typedef struct {
 	MonoRefCount ref;
 
@@ -134,12 +175,35 @@ typedef struct {
 	MonoCoopSem parked_threads_sem;
 	gint32 parked_threads_count;
 
-	volatile gint32 work_items_count;
+	/* Adapted by worker_spin (), grows when spinning finds work and shrinks when it doesn't */
+	gint32 spin_count;
+	gint32 spinning_count;
+	gint32 spinning_max;
+
+	ThreadPoolWorkItemQueue work_items_global;
+	ThreadPoolWorkItemQueue *work_items_local;
+	gint32 work_items_local_count;
+	gint32 work_items_local_next;
+	/* index + 1 of the local queue of the current worker thread, NULL for other threads */
+	MonoNativeTlsKey work_items_local_key;
 
 	guint32 worker_creation_current_second;
 	guint32 worker_creation_current_count;
+	guint32 worker_creation_max_per_sec;
 	MonoCoopMutex worker_creation_lock;
 
+	ThreadPoolController controller;
+
+	/* The MonoInternalThread of the running workers, sampled by the latency controller */
+	GPtrArray *workers;
+	MonoCoopMutex workers_lock;
+
+	/* Latency controller state */
+	gint64 latency_pending_since; // ms, 0 if no work item is known to be waiting
+	gint32 latency_wait_average; // ms
+	gint32 latency_blocked_reported; // workers which called ReportThreadStatus (FALSE)
+	gint32 latency_idle_rounds;
+
 	gint32 heuristic_completions;
 	gint64 heuristic_sample_start;
 	gint64 heuristic_last_dequeue; // ms
@@ -221,6 +285,12 @@ destroy (gpointer data)
 
 	mono_coop_mutex_destroy (&worker.heuristic_lock);
 
+	mono_coop_mutex_destroy (&worker.workers_lock);
+	g_ptr_array_free (worker.workers, TRUE);
+
+	mono_native_tls_free (worker.work_items_local_key);
+	g_free (worker.work_items_local);
+
 	g_free (worker.cpu_usage_state);
 }
 
@@ -229,6 +299,7 @@ mono_threadpool_worker_init (MonoThreadPoolWorkerCallback callback)
 {
 	ThreadPoolHillClimbing *hc;
 	const char *threads_per_cpu_env;
+	char *controller_env;
 	gint threads_per_cpu;
 	gint threads_count;
 
@@ -239,12 +310,36 @@ mono_threadpool_worker_init (MonoThreadPoolWorkerCallback callback)
 	mono_coop_sem_init (&worker.parked_threads_sem, 0);
 	worker.parked_threads_count = 0;
 
+	worker.spin_count = WORKER_SPIN_MIN * 16;
+	worker.spinning_count = 0;
+	/* Spinning threads burn a cpu each, keep at least half of them for the working threads */
+	worker.spinning_max = MAX (1, mono_cpu_count () / 2);
+
 	worker.worker_creation_current_second = -1;
 	mono_coop_mutex_init (&worker.worker_creation_lock);
 
+	worker.workers = g_ptr_array_new ();
+	mono_coop_mutex_init (&worker.workers_lock);
+
+	/* MONO_THREADPOOL_CONTROLLER=hill_climbing|latency */
+	worker.controller = CONTROLLER_HILL_CLIMBING;
+	if ((controller_env = g_getenv ("MONO_THREADPOOL_CONTROLLER"))) {
+		if (!strcmp (controller_env, "latency"))
+			worker.controller = CONTROLLER_LATENCY;
+		else if (strcmp (controller_env, "hill_climbing") != 0)
+			g_warning ("MONO_THREADPOOL_CONTROLLER: unknown controller '%s', using hill_climbing", controller_env);
+		g_free (controller_env);
+	}
+
+	worker.worker_creation_max_per_sec = worker.controller == CONTROLLER_LATENCY ? LATENCY_WORKER_CREATION_MAX_PER_SEC : WORKER_CREATION_MAX_PER_SEC;
+
 	worker.heuristic_adjustment_interval = 10;
 	mono_coop_mutex_init (&worker.heuristic_lock);
 
+	worker.work_items_local_count = CLAMP (mono_cpu_count (), 1, WORK_ITEM_LOCAL_QUEUES_MAX);
+	worker.work_items_local = g_new0 (ThreadPoolWorkItemQueue, worker.work_items_local_count);
+	mono_native_tls_alloc (&worker.work_items_local_key, NULL);
+
 	mono_rand_open ();
 
 	hc = &worker.heuristic_hill_climbing;
@@ -305,40 +400,133 @@ mono_threadpool_worker_cleanup (void)
 }
 
 static void
-work_item_push (void)
+work_item_queue_push (ThreadPoolWorkItemQueue *queue)
 {
 	gint32 old, new_;
 
 	do {
-		old = mono_atomic_load_i32 (&worker.work_items_count);
+		old = mono_atomic_load_i32 (&queue->count);
 		g_assert (old >= 0);
 
 		new_ = old + 1;
-	} while (mono_atomic_cas_i32 (&worker.work_items_count, new_, old) != old);
+	} while (mono_atomic_cas_i32 (&queue->count, new_, old) != old);
 }
 
 static gboolean
-work_item_try_pop (void)
+work_item_queue_try_pop (ThreadPoolWorkItemQueue *queue)
 {
 	gint32 old, new_;
 
 	do {
-		old = mono_atomic_load_i32 (&worker.work_items_count);
+		old = mono_atomic_load_i32 (&queue->count);
 		g_assert (old >= 0);
 
 		if (old == 0)
 			return FALSE;
 
 		new_ = old - 1;
-	} while (mono_atomic_cas_i32 (&worker.work_items_count, new_, old) != old);
+	} while (mono_atomic_cas_i32 (&queue->count, new_, old) != old);
+
+	return TRUE;
+}
+
+/* return the index of the local queue of the current thread, or -1 if it isn't a worker */
+static gint32
+work_item_local_index (void)
+{
+	return GPOINTER_TO_INT (mono_native_tls_get_value (worker.work_items_local_key)) - 1;
+}
+
+static void
+work_item_local_attach (void)
+{
+	gint32 index;
+
+	index = (mono_atomic_inc_i32 (&worker.work_items_local_next) - 1) % worker.work_items_local_count;
+	if (index < 0)
+		index += worker.work_items_local_count;
+
+	mono_native_tls_set_value (worker.work_items_local_key, GINT_TO_POINTER (index + 1));
+}
+
+static void
+work_item_local_detach (void)
+{
+	mono_native_tls_set_value (worker.work_items_local_key, NULL);
+}
+
+static void
+work_item_push (void)
+{
+	gint32 index;
+
+	index = work_item_local_index ();
+	if (index >= 0)
+		work_item_queue_push (&worker.work_items_local [index]);
+	else
+		work_item_queue_push (&worker.work_items_global);
 
+	if (worker.controller == CONTROLLER_LATENCY && mono_atomic_load_i64 (&worker.latency_pending_since) == 0)
+		mono_atomic_cas_i64 (&worker.latency_pending_since, mono_msec_ticks (), 0);
+}
+
+/* Called after a work item was popped, feeds the time it waited to the latency controller */
+static void
+work_item_popped (void)
+{
+	gint64 pending_since;
+	gint32 wait;
+
+	if (worker.controller != CONTROLLER_LATENCY)
+		return;
+
+	pending_since = mono_atomic_xchg_i64 (&worker.latency_pending_since, 0);
+	if (pending_since == 0)
+		return;
+
+	/* The work items are anonymous, so this is the wait of the oldest one known, which the
+	 * monitor re-arms if more are pending */
+	wait = (gint32) MIN (mono_msec_ticks () - pending_since, G_MAXINT32 / 2);
+	mono_atomic_store_i32 (&worker.latency_wait_average, (mono_atomic_load_i32 (&worker.latency_wait_average) * 7 + wait) / 8);
+}
+
+static gboolean
+work_item_try_pop (void)
+{
+	gint32 index, i;
+
+	index = work_item_local_index ();
+	if (index >= 0 && work_item_queue_try_pop (&worker.work_items_local [index]))
+		goto popped;
+
+	if (work_item_queue_try_pop (&worker.work_items_global))
+		goto popped;
+
+	/* steal, starting with the queue next to ours so the thieves spread out */
+	if (index < 0)
+		index = 0;
+	for (i = 1; i <= worker.work_items_local_count; ++i) {
+		if (work_item_queue_try_pop (&worker.work_items_local [(index + i) % worker.work_items_local_count]))
+			goto popped;
+	}
+
+	return FALSE;
+
+popped:
+	work_item_popped ();
 	return TRUE;
 }
 
 static gint32
 work_item_count (void)
 {
-	return mono_atomic_load_i32 (&worker.work_items_count);
+	gint32 count, i;
+
+	count = mono_atomic_load_i32 (&worker.work_items_global.count);
+	for (i = 0; i < worker.work_items_local_count; ++i)
+		count += mono_atomic_load_i32 (&worker.work_items_local [i].count);
+
+	return count;
 }
 
 static void worker_request (void);
@@ -423,6 +611,55 @@ worker_park (void)
 	return timeout;
 }
 
+/*
+ * Spin on the work queues for a short while before parking: if a work item comes in
+ * meanwhile, this saves the semaphore post in worker_try_unpark () and the context switch
+ * of waking up a parked worker, which can cost more than a fine-grained work item. The
+ * number of iterations adapts to how often spinning pays off. Return TRUE if a work item
+ * was popped.
+ */
+static gboolean
+worker_spin (void)
+{
+	gint32 spin_count, i, old;
+	gboolean found = FALSE;
+
+	if (mono_runtime_is_shutting_down () || worker.suspended)
+		return FALSE;
+
+	do {
+		old = mono_atomic_load_i32 (&worker.spinning_count);
+		if (old >= worker.spinning_max)
+			return FALSE;
+	} while (mono_atomic_cas_i32 (&worker.spinning_count, old + 1, old) != old);
+
+	spin_count = mono_atomic_load_i32 (&worker.spin_count);
+
+	MONO_ENTER_GC_SAFE;
+	for (i = 0; i < spin_count; ++i) {
+		if (work_item_try_pop ()) {
+			found = TRUE;
+			break;
+		}
+		if ((i + 1) % WORKER_SPIN_YIELD_EVERY == 0)
+			mono_thread_info_yield ();
+	}
+	MONO_EXIT_GC_SAFE;
+
+	mono_atomic_dec_i32 (&worker.spinning_count);
+
+	if (found)
+		spin_count = MIN (spin_count * 2, WORKER_SPIN_MAX);
+	else
+		spin_count = MAX (spin_count / 2, WORKER_SPIN_MIN);
+	mono_atomic_store_i32 (&worker.spin_count, spin_count);
+
+	mono_trace (G_LOG_LEVEL_DEBUG, MONO_TRACE_THREADPOOL, "[%p] worker spinning, found work? %s, spin count = %d",
+		GUINT_TO_POINTER (MONO_NATIVE_THREAD_ID_TO_UINT (mono_native_thread_id_get ())), found ? "yes" : "no", spin_count);
+
+	return found;
+}
+
 static gboolean
 worker_try_unpark (void)
 {
@@ -473,6 +710,12 @@ worker_thread (gpointer unused)
 	thread = mono_thread_internal_current ();
 	g_assert (thread);
 
+	work_item_local_attach ();
+
+	mono_coop_mutex_lock (&worker.workers_lock);
+	g_ptr_array_add (worker.workers, thread);
+	mono_coop_mutex_unlock (&worker.workers_lock);
+
 	while (!mono_runtime_is_shutting_down ()) {
 		if (mono_thread_interruption_checkpoint_bool ())
 			continue;
@@ -486,7 +729,7 @@ worker_thread (gpointer unused)
 		if (thread->state & ThreadState_AbortRequested)
 			mono_thread_internal_reset_abort (thread);
 
-		if (!work_item_try_pop ()) {
+		if (!work_item_try_pop () && !worker_spin ()) {
 			gboolean const timeout = worker_park ();
 			if (timeout)
 				break;
@@ -500,6 +743,12 @@ worker_thread (gpointer unused)
 		worker.callback ();
 	}
 
+	mono_coop_mutex_lock (&worker.workers_lock);
+	g_ptr_array_remove_fast (worker.workers, thread);
+	mono_coop_mutex_unlock (&worker.workers_lock);
+
+	work_item_local_detach ();
+
 	COUNTER_ATOMIC (counter, {
 		counter._.working --;
 	});
@@ -538,8 +787,8 @@ worker_try_create (void)
 			worker.worker_creation_current_second = now;
 			worker.worker_creation_current_count = 0;
 		} else {
-			g_assert (worker.worker_creation_current_count <= WORKER_CREATION_MAX_PER_SEC);
-			if (worker.worker_creation_current_count == WORKER_CREATION_MAX_PER_SEC) {
+			g_assert (worker.worker_creation_current_count <= worker.worker_creation_max_per_sec);
+			if (worker.worker_creation_current_count == worker.worker_creation_max_per_sec) {
 				mono_trace (G_LOG_LEVEL_DEBUG, MONO_TRACE_THREADPOOL, "[%p] try create worker, failed: maximum number of worker created per second reached, current count = %d",
 					GUINT_TO_POINTER (MONO_NATIVE_THREAD_ID_TO_UINT (mono_native_thread_id_get ())), worker.worker_creation_current_count);
 				mono_coop_mutex_unlock (&worker.worker_creation_lock);
@@ -666,11 +915,117 @@ monitor_sufficient_delay_since_last_dequeue (void)
 
 static void hill_climbing_force_change (gint16 new_thread_count, ThreadPoolHeuristicStateTransition transition);
 
+/* Number of workers currently blocked, either sampled from their state or as they reported it */
+static gint32
+latency_count_blocked_workers (void)
+{
+	gint32 sampled = 0;
+	guint i;
+
+	mono_coop_mutex_lock (&worker.workers_lock);
+	for (i = 0; i < worker.workers->len; ++i) {
+		MonoInternalThread *thread = (MonoInternalThread *) g_ptr_array_index (worker.workers, i);
+		if (thread->state & ThreadState_WaitSleepJoin)
+			sampled ++;
+	}
+	mono_coop_mutex_unlock (&worker.workers_lock);
+
+	return MAX (sampled, mono_atomic_load_i32 (&worker.latency_blocked_reported));
+}
+
+/*
+ * Instead of the throughput driven hill climbing, inject threads as soon as the work items
+ * wait longer than LATENCY_TARGET, or when workers are blocked while work is pending, which
+ * is what happens during sync-over-async bursts. When idle, the thread count slowly decays
+ * back towards the minimum. Returns the number of threads to wake up or create.
+ */
+static gint32
+latency_controller_adjust (void)
+{
+	ThreadPoolWorkerCounter counter;
+	gint64 now, pending_since;
+	gint32 pending, wait, blocked, inject;
+
+	now = mono_msec_ticks ();
+	pending = work_item_count ();
+
+	pending_since = mono_atomic_load_i64 (&worker.latency_pending_since);
+	if (pending > 0 && pending_since == 0) {
+		/* Some work items are still waiting since the last pop, start measuring from now */
+		mono_atomic_cas_i64 (&worker.latency_pending_since, now, 0);
+		pending_since = now;
+	}
+
+	wait = pending > 0 ? (gint32) MIN (now - pending_since, G_MAXINT32 / 2) : 0;
+	wait = MAX (wait, mono_atomic_load_i32 (&worker.latency_wait_average));
+
+	blocked = pending > 0 ? latency_count_blocked_workers () : 0;
+
+	if (pending == 0) {
+		counter = COUNTER_READ ();
+		if (++worker.latency_idle_rounds >= LATENCY_IDLE_ROUNDS_BEFORE_DECAY && counter._.max_working > worker.limit_worker_min) {
+			COUNTER_ATOMIC (counter, {
+				if (counter._.max_working > worker.limit_worker_min)
+					counter._.max_working --;
+			});
+			worker.latency_idle_rounds = 0;
+		}
+		mono_atomic_store_i32 (&worker.latency_wait_average, mono_atomic_load_i32 (&worker.latency_wait_average) / 2);
+		return 0;
+	}
+
+	worker.latency_idle_rounds = 0;
+
+	if (wait < LATENCY_TARGET && blocked == 0)
+		return 0;
+
+	/* One thread per blocked worker, plus more the longer the work items wait */
+	inject = blocked + wait / LATENCY_TARGET;
+	inject = CLAMP (inject, 1, MIN (LATENCY_MAX_INJECTION, pending));
+
+	COUNTER_ATOMIC (counter, {
+		if (counter._.max_working >= worker.limit_worker_max) {
+			inject = 0;
+			break;
+		}
+		inject = MIN (inject, worker.limit_worker_max - counter._.max_working);
+		counter._.max_working += inject;
+	});
+
+	if (inject > 0)
+		mono_trace (G_LOG_LEVEL_DEBUG, MONO_TRACE_THREADPOOL, "[%p] latency controller, wait = %dms blocked = %d, injecting %d threads, max working = %d",
+			GUINT_TO_POINTER (MONO_NATIVE_THREAD_ID_TO_UINT (mono_native_thread_id_get ())), wait, blocked, inject, counter._.max_working);
+
+	return inject;
+}
+
+static void
+monitor_inject_worker (void)
+{
+	guint i;
+
+	for (i = 0; i < 5; ++i) {
+		if (mono_runtime_is_shutting_down ())
+			break;
+
+		if (worker_try_unpark ()) {
+			mono_trace (G_LOG_LEVEL_DEBUG, MONO_TRACE_THREADPOOL, "[%p] monitor thread, unparked",
+				GUINT_TO_POINTER (MONO_NATIVE_THREAD_ID_TO_UINT (mono_native_thread_id_get ())));
+			break;
+		}
+
+		if (worker_try_create ()) {
+			mono_trace (G_LOG_LEVEL_DEBUG, MONO_TRACE_THREADPOOL, "[%p] monitor thread, created",
+				GUINT_TO_POINTER (MONO_NATIVE_THREAD_ID_TO_UINT (mono_native_thread_id_get ())));
+			break;
+		}
+	}
+}
+
 static gsize WINAPI
 monitor_thread (gpointer unused)
 {
 	MonoInternalThread *internal;
-	guint i;
 
 	if (!mono_refcount_tryinc (&worker))
 		return 0;
@@ -688,7 +1043,7 @@ monitor_thread (gpointer unused)
 	do {
 		ThreadPoolWorkerCounter counter;
 		gboolean limit_worker_max_reached;
-		gint32 interval_left = MONITOR_INTERVAL;
+		gint32 interval_left = worker.controller == CONTROLLER_LATENCY ? LATENCY_MONITOR_INTERVAL : MONITOR_INTERVAL;
 		gint32 awake = 0; /* number of spurious awakes we tolerate before doing a round of rebalancing */
 
 		g_assert (worker.monitor_status != MONITOR_STATUS_NOT_RUNNING);
@@ -718,6 +1073,13 @@ monitor_thread (gpointer unused)
 		if (worker.suspended)
 			continue;
 
+		if (worker.controller == CONTROLLER_LATENCY) {
+			gint32 inject = latency_controller_adjust ();
+			while (inject-- > 0 && !mono_runtime_is_shutting_down ())
+				monitor_inject_worker ();
+			continue;
+		}
+
 		if (work_item_count () == 0)
 			continue;
 
@@ -741,22 +1103,7 @@ monitor_thread (gpointer unused)
 
 		hill_climbing_force_change (counter._.max_working, TRANSITION_STARVATION);
 
-		for (i = 0; i < 5; ++i) {
-			if (mono_runtime_is_shutting_down ())
-				break;
-
-			if (worker_try_unpark ()) {
-				mono_trace (G_LOG_LEVEL_DEBUG, MONO_TRACE_THREADPOOL, "[%p] monitor thread, unparked",
-					GUINT_TO_POINTER (MONO_NATIVE_THREAD_ID_TO_UINT (mono_native_thread_id_get ())));
-				break;
-			}
-
-			if (worker_try_create ()) {
-				mono_trace (G_LOG_LEVEL_DEBUG, MONO_TRACE_THREADPOOL, "[%p] monitor thread, created",
-					GUINT_TO_POINTER (MONO_NATIVE_THREAD_ID_TO_UINT (mono_native_thread_id_get ())));
-				break;
-			}
-		}
+		monitor_inject_worker ();
 	} while (monitor_should_keep_running ());
 
 	// printf ("monitor_thread: stop\n");
@@ -1112,6 +1459,10 @@ heuristic_notify_work_completed (void)
 	mono_atomic_inc_i32 (&worker.heuristic_completions);
 	worker.heuristic_last_dequeue = mono_msec_ticks ();
 
+	/* The latency controller only adjusts from the monitor thread */
+	if (worker.controller == CONTROLLER_LATENCY)
+		return;
+
 	if (heuristic_should_adjust ())
 		heuristic_adjust ();
 }
@@ -1186,6 +1537,20 @@ mono_threadpool_worker_set_max (gint32 value)
 	return TRUE;
 }
 
+void
+mono_threadpool_worker_report_thread_status (gboolean is_working)
+{
+	if (!mono_refcount_tryinc (&worker))
+		return;
+
+	if (is_working)
+		mono_atomic_dec_i32 (&worker.latency_blocked_reported);
+	else
+		mono_atomic_inc_i32 (&worker.latency_blocked_reported);
+
+	mono_refcount_dec (&worker);
+}
+
 void
 mono_threadpool_worker_set_suspended (gboolean suspended)
 {
@@ -1198,3 +1563,5 @@ mono_threadpool_worker_set_suspended (gboolean suspended)
 
 	mono_refcount_dec (&worker);
 }
+
+#endif /* !defined (HOST_WASM) || defined (ENABLE_WASM_THREADPOOL) */
@@ -17,6 +17,9 @@
 #include <mono/metadata/threadpool.h>
 #include <mono/metadata/threadpool-worker.h>
 
+/* With --enable-wasm-threadpool the default worker runs on web workers */
+#ifndef ENABLE_WASM_THREADPOOL
+
 static MonoThreadPoolWorkerCallback tp_cb;
 static gboolean cb_scheduled;
 
@@ -75,3 +78,5 @@ mono_threadpool_worker_notify_completed (void)
 {
 	return FALSE;
 }
+
+#endif /* ENABLE_WASM_THREADPOOL */
@@ -31,6 +31,9 @@ mono_threadpool_worker_get_max (void);
 gboolean
 mono_threadpool_worker_set_max (gint32 value);
 
+void
+mono_threadpool_worker_report_thread_status (gboolean is_working);
+
 void
 mono_threadpool_worker_set_suspended (gboolean suspended);
 
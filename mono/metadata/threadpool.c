@@ -38,6 +38,7 @@
 #include <mono/metadata/threadpool-io.h>
 #include <mono/metadata/w32event.h>
 #include <mono/utils/atomic.h>
+#include <mono/utils/hazard-pointer.h>
 #include <mono/utils/mono-compiler.h>
 #include <mono/utils/mono-complex.h>
 #include <mono/utils/mono-lazy-init.h>
@@ -54,17 +55,43 @@
 // consistency with coreclr https://github.com/dotnet/coreclr/blob/643b09f966e68e06d5f0930755985a01a2a2b096/src/vm/win32threadpool.h#L111
 #define MAX_POSSIBLE_THREADS 0x7fff
 
+/* Keep a worker on the same domain for at most that many jobs in a row */
+#define TPDOMAIN_BURST_MAX 4
+
+#define TPDOMAIN_TABLE_HAZARD_INDEX 0
+#define TPDOMAIN_HAZARD_INDEX 1
+
 typedef struct {
 	MonoDomain *domain;
-	/* Number of outstanding jobs */
+	/* Number of outstanding jobs, updated atomically */
 	gint32 outstanding_request;
-	/* Number of currently executing jobs */
+	/* Number of currently executing jobs, updated atomically */
 	gint32 threadpool_jobs;
 	/* Signalled when threadpool_jobs + outstanding_request is 0 */
 	/* Protected by threadpool.domains_lock */
 	MonoCoopCond cleanup_cond;
+	/* Set, under threadpool.domains_lock, once it is not in threadpool.domains anymore */
+	gboolean removed;
+	/* Set, under threadpool.domains_lock, once it has been handed to the hazard pointer free */
+	gboolean freed;
 } ThreadPoolDomain;
 
+/*
+ * The list of domains is copy-on-write: it is replaced under domains_lock when a domain
+ * is added or removed, and the workers read it with hazard pointers. Dequeuing a job
+ * then only takes atomic operations on the ThreadPoolDomain, which with a single domain
+ * means no lock at all on the hot path.
+ */
+typedef struct {
+	gint32 len;
+	struct {
+		MonoDomain *domain;
+		ThreadPoolDomain *tpdomain;
+	} entries [MONO_ZERO_LEN_ARRAY];
+} ThreadPoolDomainTable;
+
+#define MONO_SIZEOF_TPDOMAIN_TABLE(len) (G_STRUCT_OFFSET (ThreadPoolDomainTable, entries) + (len) * sizeof (((ThreadPoolDomainTable*)NULL)->entries [0]))
+
 typedef union {
 	struct {
 		gint16 starting; /* starting, but not yet in worker_callback */
@@ -76,8 +103,10 @@ typedef union {
 typedef struct {
 	MonoRefCount ref;
 
-	GPtrArray *domains; // ThreadPoolDomain* []
+	ThreadPoolDomainTable * volatile domains;
 	MonoCoopMutex domains_lock;
+	/* Where the workers start looking for a domain with outstanding requests */
+	gint32 domains_cursor;
 
 	ThreadPoolCounter counters;
 
@@ -125,7 +154,7 @@ domains_unlock (void)
 static void
 destroy (gpointer unused)
 {
-	g_ptr_array_free (threadpool.domains, TRUE);
+	g_free (threadpool.domains);
 	mono_coop_mutex_destroy (&threadpool.domains_lock);
 }
 
@@ -139,7 +168,7 @@ initialize (void)
 
 	mono_refcount_init (&threadpool, destroy);
 
-	threadpool.domains = g_ptr_array_new ();
+	threadpool.domains = g_new0 (ThreadPoolDomainTable, 1);
 	mono_coop_mutex_init (&threadpool.domains_lock);
 
 	threadpool.limit_io_min = mono_cpu_count ();
@@ -156,39 +185,74 @@ cleanup (void)
 	mono_refcount_dec (&threadpool);
 }
 
-gboolean
-mono_threadpool_enqueue_work_item (MonoDomain *domain, MonoObject *work_item, MonoError *error)
+static MonoMethod*
+get_unsafe_queue_custom_work_item_method (void)
 {
 	static MonoClass *threadpool_class = NULL;
 	static MonoMethod *unsafe_queue_custom_work_item_method = NULL;
-	MonoDomain *current_domain;
-	MonoBoolean f;
-	gpointer args [2];
-
-	error_init (error);
-	g_assert (work_item);
 
 	if (!threadpool_class)
 		threadpool_class = mono_class_load_from_name (mono_defaults.corlib, "System.Threading", "ThreadPool");
 
 	if (!unsafe_queue_custom_work_item_method) {
+		ERROR_DECL (error);
 		unsafe_queue_custom_work_item_method = mono_class_get_method_from_name_checked (threadpool_class, "UnsafeQueueCustomWorkItem", 2, 0, error);
 		mono_error_assert_ok (error);
 	}
 	g_assert (unsafe_queue_custom_work_item_method);
 
+	return unsafe_queue_custom_work_item_method;
+}
+
+static void
+enqueue_work_items_in_current_domain (MonoMethod *method, MonoObject **work_items, gint count, MonoError *error)
+{
+	MonoBoolean f;
+	gpointer args [2];
+	gint i;
+
 	f = FALSE;
 
-	args [0] = (gpointer) work_item;
-	args [1] = (gpointer) &f;
+	for (i = 0; i < count; ++i) {
+		g_assert (work_items [i]);
+
+		args [0] = (gpointer) work_items [i];
+		args [1] = (gpointer) &f;
+
+		mono_runtime_invoke_checked (method, NULL, args, error);
+		if (!is_ok (error))
+			return;
+	}
+}
+
+/*
+ * mono_threadpool_enqueue_work_items:
+ *
+ *   Enqueue @count work items which all belong to @domain. This only switches to @domain
+ * once for the whole batch, which is what makes it cheaper than calling
+ * mono_threadpool_enqueue_work_item () for each of them.
+ */
+gboolean
+mono_threadpool_enqueue_work_items (MonoDomain *domain, MonoObject **work_items, gint count, MonoError *error)
+{
+	MonoMethod *method;
+	MonoDomain *current_domain;
+
+	error_init (error);
+	g_assert (work_items);
+
+	if (count == 0)
+		return TRUE;
+
+	method = get_unsafe_queue_custom_work_item_method ();
 
 	current_domain = mono_domain_get ();
 	if (current_domain == domain) {
-		mono_runtime_invoke_checked (unsafe_queue_custom_work_item_method, NULL, args, error);
+		enqueue_work_items_in_current_domain (method, work_items, count, error);
 	} else {
 		mono_thread_push_appdomain_ref (domain);
 		if (mono_domain_set_fast (domain, FALSE)) {
-			mono_runtime_invoke_checked (unsafe_queue_custom_work_item_method, NULL, args, error);
+			enqueue_work_items_in_current_domain (method, work_items, count, error);
 			mono_domain_set_fast (current_domain, TRUE);
 		} else {
 			// mono_domain_set_fast failing still leads to success.
@@ -198,17 +262,46 @@ mono_threadpool_enqueue_work_item (MonoDomain *domain, MonoObject *work_item, Mo
 	return is_ok (error);
 }
 
+gboolean
+mono_threadpool_enqueue_work_item (MonoDomain *domain, MonoObject *work_item, MonoError *error)
+{
+	g_assert (work_item);
+
+	return mono_threadpool_enqueue_work_items (domain, &work_item, 1, error);
+}
+
+/* LOCKING: domains_lock must be held. */
+static void
+tpdomain_table_publish (ThreadPoolDomainTable *table)
+{
+	ThreadPoolDomainTable *old_table;
+
+	old_table = threadpool.domains;
+	mono_memory_barrier ();
+	threadpool.domains = table;
+
+	mono_thread_hazardous_try_free (old_table, g_free);
+}
+
 /* LOCKING: domains_lock must be held. */
 static ThreadPoolDomain *
 tpdomain_create (MonoDomain *domain)
 {
+	ThreadPoolDomainTable *old_table, *table;
 	ThreadPoolDomain *tpdomain;
 
 	tpdomain = g_new0 (ThreadPoolDomain, 1);
 	tpdomain->domain = domain;
 	mono_coop_cond_init (&tpdomain->cleanup_cond);
 
-	g_ptr_array_add (threadpool.domains, tpdomain);
+	old_table = threadpool.domains;
+	table = (ThreadPoolDomainTable *)g_malloc0 (MONO_SIZEOF_TPDOMAIN_TABLE (old_table->len + 1));
+	memcpy (table->entries, old_table->entries, old_table->len * sizeof (table->entries [0]));
+	table->entries [old_table->len].domain = domain;
+	table->entries [old_table->len].tpdomain = tpdomain;
+	table->len = old_table->len + 1;
+
+	tpdomain_table_publish (table);
 
 	return tpdomain;
 }
@@ -217,63 +310,259 @@ tpdomain_create (MonoDomain *domain)
 static gboolean
 tpdomain_remove (ThreadPoolDomain *tpdomain)
 {
+	ThreadPoolDomainTable *old_table, *table;
+	gint i, j;
+
 	g_assert (tpdomain);
-	return g_ptr_array_remove (threadpool.domains, tpdomain);
+
+	if (tpdomain->removed)
+		return FALSE;
+
+	old_table = threadpool.domains;
+	table = (ThreadPoolDomainTable *)g_malloc0 (MONO_SIZEOF_TPDOMAIN_TABLE (old_table->len));
+	for (i = 0, j = 0; i < old_table->len; ++i) {
+		if (old_table->entries [i].tpdomain != tpdomain)
+			table->entries [j++] = old_table->entries [i];
+	}
+	g_assert (j == old_table->len - 1);
+	table->len = j;
+
+	tpdomain_table_publish (table);
+
+	tpdomain->removed = TRUE;
+
+	return TRUE;
 }
 
 /* LOCKING: domains_lock must be held */
 static ThreadPoolDomain *
 tpdomain_get (MonoDomain *domain)
 {
+	ThreadPoolDomainTable *table;
 	gint i;
 
 	g_assert (domain);
 
-	for (i = 0; i < threadpool.domains->len; ++i) {
-		ThreadPoolDomain *tpdomain;
-
-		tpdomain = (ThreadPoolDomain *)g_ptr_array_index (threadpool.domains, i);
-		if (tpdomain->domain == domain)
-			return tpdomain;
+	table = threadpool.domains;
+	for (i = 0; i < table->len; ++i) {
+		if (table->entries [i].domain == domain)
+			return table->entries [i].tpdomain;
 	}
 
 	return NULL;
 }
 
 static void
-tpdomain_free (ThreadPoolDomain *tpdomain)
+tpdomain_free (gpointer data)
 {
+	ThreadPoolDomain *tpdomain = (ThreadPoolDomain *)data;
+
+	mono_coop_cond_destroy (&tpdomain->cleanup_cond);
 	g_free (tpdomain);
 }
 
-/* LOCKING: domains_lock must be held */
+static gint32
+tpdomain_pending (ThreadPoolDomain *tpdomain)
+{
+	return mono_atomic_load_i32 (&tpdomain->outstanding_request) + mono_atomic_load_i32 (&tpdomain->threadpool_jobs);
+}
+
+/*
+ * Protect the ThreadPoolDomain at @index in @table, which must be protected by
+ * TPDOMAIN_TABLE_HAZARD_INDEX. Returns FALSE if @table isn't the current one anymore,
+ * in which case the ThreadPoolDomain might have been freed already.
+ */
+static gboolean
+tpdomain_table_protect_entry (MonoThreadHazardPointers *hp, ThreadPoolDomainTable *table, gint index)
+{
+	mono_hazard_pointer_set (hp, TPDOMAIN_HAZARD_INDEX, table->entries [index].tpdomain);
+	mono_memory_barrier ();
+
+	if (threadpool.domains != table) {
+		mono_hazard_pointer_clear (hp, TPDOMAIN_HAZARD_INDEX);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/*
+ * Return the ThreadPoolDomain of @domain protected by TPDOMAIN_HAZARD_INDEX, without taking
+ * domains_lock, or NULL if there is none yet.
+ */
 static ThreadPoolDomain *
-tpdomain_get_next (ThreadPoolDomain *current)
-{
-	ThreadPoolDomain *tpdomain = NULL;
-	gint len;
-
-	len = threadpool.domains->len;
-	if (len > 0) {
-		gint i, current_idx = -1;
-		if (current) {
-			for (i = 0; i < len; ++i) {
-				if (current == g_ptr_array_index (threadpool.domains, i)) {
-					current_idx = i;
-					break;
+tpdomain_get_hazardous (MonoThreadHazardPointers *hp, MonoDomain *domain)
+{
+	ThreadPoolDomainTable *table;
+	ThreadPoolDomain *tpdomain;
+	gint i;
+
+retry:
+	tpdomain = NULL;
+
+	table = (ThreadPoolDomainTable *)mono_get_hazardous_pointer ((gpointer volatile*)&threadpool.domains, hp, TPDOMAIN_TABLE_HAZARD_INDEX);
+
+	for (i = 0; i < table->len; ++i) {
+		if (table->entries [i].domain != domain)
+			continue;
+
+		if (!tpdomain_table_protect_entry (hp, table, i)) {
+			mono_hazard_pointer_clear (hp, TPDOMAIN_TABLE_HAZARD_INDEX);
+			goto retry;
+		}
+
+		tpdomain = table->entries [i].tpdomain;
+		break;
+	}
+
+	mono_hazard_pointer_clear (hp, TPDOMAIN_TABLE_HAZARD_INDEX);
+
+	return tpdomain;
+}
+
+/*
+ * Called when a job of @tpdomain is done, or a claim on it is given up. @tpdomain must be
+ * protected by TPDOMAIN_HAZARD_INDEX. Wakes up mono_threadpool_remove_domain_jobs () once
+ * the domain is idle, and frees @tpdomain if it was removed while jobs were still running.
+ */
+static void
+tpdomain_check_idle (ThreadPoolDomain *tpdomain)
+{
+	gboolean free = FALSE;
+
+	if (tpdomain_pending (tpdomain) > 0)
+		return;
+	if (!tpdomain->removed && !mono_domain_is_unloading (tpdomain->domain))
+		return;
+
+	domains_lock ();
+
+	mono_coop_cond_broadcast (&tpdomain->cleanup_cond);
+
+	if (tpdomain->removed && !tpdomain->freed && tpdomain_pending (tpdomain) == 0)
+		free = tpdomain->freed = TRUE;
+
+	domains_unlock ();
+
+	if (free)
+		mono_thread_hazardous_try_free (tpdomain, tpdomain_free);
+}
+
+/*
+ * Take one of the outstanding requests of @tpdomain, which must be protected by
+ * TPDOMAIN_HAZARD_INDEX. threadpool_jobs is incremented first, so
+ * mono_threadpool_remove_domain_jobs () never sees the domain idle in between.
+ */
+static gboolean
+tpdomain_try_claim (ThreadPoolDomain *tpdomain)
+{
+	gint32 old;
+
+	if (mono_atomic_load_i32 (&tpdomain->outstanding_request) <= 0)
+		return FALSE;
+
+	mono_atomic_inc_i32 (&tpdomain->threadpool_jobs);
+
+	do {
+		old = mono_atomic_load_i32 (&tpdomain->outstanding_request);
+		if (old <= 0) {
+			mono_atomic_dec_i32 (&tpdomain->threadpool_jobs);
+			tpdomain_check_idle (tpdomain);
+			return FALSE;
+		}
+	} while (mono_atomic_cas_i32 (&tpdomain->outstanding_request, old - 1, old) != old);
+
+	return TRUE;
+}
+
+/*
+ * Find a domain with an outstanding request and claim it. With several domains, they are
+ * visited round-robin, but a worker stays on the domain it just ran a job for, for up to
+ * as many jobs as that domain has outstanding requests (capped at TPDOMAIN_BURST_MAX), so
+ * the domains with the largest backlog get proportionally more of the workers and fewer
+ * domain switches. The returned ThreadPoolDomain is kept alive by its threadpool_jobs.
+ */
+static ThreadPoolDomain *
+tpdomain_claim_next (ThreadPoolDomain *previous, gint32 *burst)
+{
+	MonoThreadHazardPointers *hp = mono_hazard_pointer_get ();
+	ThreadPoolDomainTable *table;
+	ThreadPoolDomain *tpdomain;
+	guint32 start;
+	gint i;
+
+retry:
+	tpdomain = NULL;
+
+	table = (ThreadPoolDomainTable *)mono_get_hazardous_pointer ((gpointer volatile*)&threadpool.domains, hp, TPDOMAIN_TABLE_HAZARD_INDEX);
+
+	if (table->len == 1) {
+		/* fast path, the only domain can't be chosen unfairly */
+		if (!tpdomain_table_protect_entry (hp, table, 0))
+			goto restart;
+		if (tpdomain_try_claim (table->entries [0].tpdomain))
+			tpdomain = table->entries [0].tpdomain;
+		mono_hazard_pointer_clear (hp, TPDOMAIN_HAZARD_INDEX);
+	} else if (table->len > 1) {
+		if (previous && *burst > 0) {
+			for (i = 0; i < table->len; ++i) {
+				if (table->entries [i].tpdomain != previous)
+					continue;
+				if (!tpdomain_table_protect_entry (hp, table, i))
+					goto restart;
+				if (tpdomain_try_claim (previous)) {
+					tpdomain = previous;
+					*burst -= 1;
 				}
+				mono_hazard_pointer_clear (hp, TPDOMAIN_HAZARD_INDEX);
+				break;
 			}
 		}
-		for (i = current_idx + 1; i < len + current_idx + 1; ++i) {
-			ThreadPoolDomain *tmp = (ThreadPoolDomain *)g_ptr_array_index (threadpool.domains, i % len);
-			if (tmp->outstanding_request > 0) {
-				tpdomain = tmp;
-				break;
+
+		if (!tpdomain) {
+			start = (guint32) mono_atomic_inc_i32 (&threadpool.domains_cursor);
+			for (i = 0; i < table->len; ++i) {
+				gint index = (start + i) % table->len;
+				ThreadPoolDomain *tmp = table->entries [index].tpdomain;
+
+				if (!tpdomain_table_protect_entry (hp, table, index))
+					goto restart;
+				if (tpdomain_try_claim (tmp)) {
+					tpdomain = tmp;
+					*burst = CLAMP (mono_atomic_load_i32 (&tmp->outstanding_request), 1, TPDOMAIN_BURST_MAX) - 1;
+				}
+				mono_hazard_pointer_clear (hp, TPDOMAIN_HAZARD_INDEX);
+				if (tpdomain)
+					break;
 			}
 		}
 	}
 
+	mono_hazard_pointer_clear (hp, TPDOMAIN_TABLE_HAZARD_INDEX);
 	return tpdomain;
+
+restart:
+	/* the table has been replaced under our feet */
+	mono_hazard_pointer_clear (hp, TPDOMAIN_TABLE_HAZARD_INDEX);
+	goto retry;
+}
+
+/* Called once the job claimed with tpdomain_claim_next () is done */
+static void
+tpdomain_job_done (ThreadPoolDomain *tpdomain)
+{
+	MonoThreadHazardPointers *hp = mono_hazard_pointer_get ();
+
+	/* Our job keeps it alive until the decrement, the hazard pointer after it */
+	mono_hazard_pointer_set (hp, TPDOMAIN_HAZARD_INDEX, tpdomain);
+	mono_memory_barrier ();
+
+	mono_atomic_dec_i32 (&tpdomain->threadpool_jobs);
+	g_assert (mono_atomic_load_i32 (&tpdomain->threadpool_jobs) >= 0);
+
+	tpdomain_check_idle (tpdomain);
+
+	mono_hazard_pointer_clear (hp, TPDOMAIN_HAZARD_INDEX);
 }
 
 static MonoObject*
@@ -292,6 +581,7 @@ worker_callback (void)
 	ThreadPoolDomain *tpdomain, *previous_tpdomain;
 	ThreadPoolCounter counter;
 	MonoInternalThread *thread;
+	gint32 burst = 0;
 
 	if (!mono_refcount_tryinc (&threadpool))
 		return;
@@ -321,36 +611,22 @@ worker_callback (void)
 	 */
 	mono_defaults.threadpool_perform_wait_callback_method->save_lmf = TRUE;
 
-	domains_lock ();
-
 	previous_tpdomain = NULL;
 
 	while (!mono_runtime_is_shutting_down ()) {
 		gboolean retire = FALSE;
 
 		if (thread->state & (ThreadState_AbortRequested | ThreadState_SuspendRequested)) {
-			domains_unlock ();
-			if (mono_thread_interruption_checkpoint_bool ()) {
-				domains_lock ();
+			if (mono_thread_interruption_checkpoint_bool ())
 				continue;
-			}
-			domains_lock ();
 		}
 
-		tpdomain = tpdomain_get_next (previous_tpdomain);
+		tpdomain = tpdomain_claim_next (previous_tpdomain, &burst);
 		if (!tpdomain)
 			break;
 
-		tpdomain->outstanding_request --;
-		g_assert (tpdomain->outstanding_request >= 0);
-
 		mono_trace (G_LOG_LEVEL_DEBUG, MONO_TRACE_THREADPOOL, "[%p] worker running in domain %p (outstanding requests %d)",
-			GUINT_TO_POINTER (MONO_NATIVE_THREAD_ID_TO_UINT (mono_native_thread_id_get ())), tpdomain->domain, tpdomain->outstanding_request);
-
-		g_assert (tpdomain->threadpool_jobs >= 0);
-		tpdomain->threadpool_jobs ++;
-
-		domains_unlock ();
+			GUINT_TO_POINTER (MONO_NATIVE_THREAD_ID_TO_UINT (mono_native_thread_id_get ())), tpdomain->domain, mono_atomic_load_i32 (&tpdomain->outstanding_request));
 
 		MonoString *thread_name = mono_string_new_checked (mono_get_root_domain (), "Thread Pool Worker", error);
 		mono_error_assert_ok (error);
@@ -380,20 +656,8 @@ worker_callback (void)
 		}
 		mono_thread_pop_appdomain_ref ();
 
-		domains_lock ();
-
-		tpdomain->threadpool_jobs --;
-		g_assert (tpdomain->threadpool_jobs >= 0);
-
-		if (tpdomain->outstanding_request + tpdomain->threadpool_jobs == 0 && mono_domain_is_unloading (tpdomain->domain)) {
-			gboolean removed;
-
-			removed = tpdomain_remove (tpdomain);
-			g_assert (removed);
-
-			mono_coop_cond_signal (&tpdomain->cleanup_cond);
-			tpdomain = NULL;
-		}
+		/* tpdomain might be freed after this, it is only compared against afterward */
+		tpdomain_job_done (tpdomain);
 
 		if (retire)
 			break;
@@ -401,8 +665,6 @@ worker_callback (void)
 		previous_tpdomain = tpdomain;
 	}
 
-	domains_unlock ();
-
 	COUNTER_ATOMIC (counter, {
 		counter._.working --;
 	});
@@ -515,7 +777,7 @@ mono_threadpool_remove_domain_jobs (MonoDomain *domain, int timeout)
 {
 	gint64 end = 0;
 	ThreadPoolDomain *tpdomain;
-	gboolean ret;
+	gboolean ret, free = FALSE;
 
 	g_assert (domain);
 	g_assert (timeout >= -1);
@@ -555,7 +817,7 @@ mono_threadpool_remove_domain_jobs (MonoDomain *domain, int timeout)
 
 	ret = TRUE;
 
-	while (tpdomain->outstanding_request + tpdomain->threadpool_jobs > 0) {
+	while (tpdomain_pending (tpdomain) > 0) {
 		if (timeout == -1) {
 			mono_coop_cond_wait (&tpdomain->cleanup_cond, &threadpool.domains_lock);
 		} else {
@@ -576,13 +838,19 @@ mono_threadpool_remove_domain_jobs (MonoDomain *domain, int timeout)
 		}
 	}
 
-	/* Remove from the list the worker threads look at */
+	/* Remove from the list the worker threads look at. If some jobs are still running
+	 * because we timed out, the last one frees it in tpdomain_check_idle () */
 	tpdomain_remove (tpdomain);
 
+	if (!tpdomain->freed && tpdomain_pending (tpdomain) == 0) {
+		tpdomain->freed = TRUE;
+		free = TRUE;
+	}
+
 	domains_unlock ();
 
-	mono_coop_cond_destroy (&tpdomain->cleanup_cond);
-	tpdomain_free (tpdomain);
+	if (free)
+		mono_thread_hazardous_try_free (tpdomain, tpdomain_free);
 
 	mono_refcount_dec (&threadpool);
 
@@ -744,14 +1012,20 @@ ves_icall_System_Threading_ThreadPool_NotifyWorkItemQueued (MonoError *error)
 void
 ves_icall_System_Threading_ThreadPool_ReportThreadStatus (MonoBoolean is_working, MonoError *error)
 {
-	// TODO
-	mono_error_set_not_implemented (error, "");
+	MonoInternalThread *thread = mono_thread_internal_current ();
+
+	/* Only the workers are accounted for by the thread injection controller */
+	if (!thread || !thread->threadpool_thread)
+		return;
+
+	mono_threadpool_worker_report_thread_status (is_working);
 }
 
 MonoBoolean
 ves_icall_System_Threading_ThreadPool_RequestWorkerThread (MonoError *error)
 {
 	MonoDomain *domain;
+	MonoThreadHazardPointers *hp;
 	ThreadPoolDomain *tpdomain;
 	ThreadPoolCounter counter;
 
@@ -764,26 +1038,52 @@ ves_icall_System_Threading_ThreadPool_RequestWorkerThread (MonoError *error)
 		return FALSE;
 	}
 
-	domains_lock ();
+	hp = mono_hazard_pointer_get ();
 
-	tpdomain = tpdomain_get (domain);
-	if (!tpdomain) {
-		/* synchronize with mono_threadpool_remove_domain_jobs */
+	tpdomain = tpdomain_get_hazardous (hp, domain);
+	if (tpdomain) {
+		mono_atomic_inc_i32 (&tpdomain->outstanding_request);
+
+		/* synchronize with mono_threadpool_remove_domain_jobs, which only starts once the
+		 * domain is marked as unloading: if it saw the domain idle, we see it unloading */
 		if (mono_domain_is_unloading (domain)) {
-			domains_unlock ();
+			gint32 old;
+
+			do {
+				old = mono_atomic_load_i32 (&tpdomain->outstanding_request);
+				if (old <= 0)
+					break; /* a worker took it already */
+			} while (mono_atomic_cas_i32 (&tpdomain->outstanding_request, old - 1, old) != old);
+
+			tpdomain_check_idle (tpdomain);
+
+			mono_hazard_pointer_clear (hp, TPDOMAIN_HAZARD_INDEX);
 			mono_refcount_dec (&threadpool);
 			return FALSE;
 		}
 
-		tpdomain = tpdomain_create (domain);
-	}
+		mono_hazard_pointer_clear (hp, TPDOMAIN_HAZARD_INDEX);
+	} else {
+		domains_lock ();
 
-	g_assert (tpdomain);
+		tpdomain = tpdomain_get (domain);
+		if (!tpdomain) {
+			/* synchronize with mono_threadpool_remove_domain_jobs */
+			if (mono_domain_is_unloading (domain)) {
+				domains_unlock ();
+				mono_refcount_dec (&threadpool);
+				return FALSE;
+			}
 
-	tpdomain->outstanding_request ++;
-	g_assert (tpdomain->outstanding_request >= 1);
+			tpdomain = tpdomain_create (domain);
+		}
 
-	domains_unlock ();
+		g_assert (tpdomain);
+
+		mono_atomic_inc_i32 (&tpdomain->outstanding_request);
+
+		domains_unlock ();
+	}
 
 	COUNTER_ATOMIC (counter, {
 		if (counter._.starting == 16) {
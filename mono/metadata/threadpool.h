@@ -33,4 +33,7 @@ mono_threadpool_resume (void);
 gboolean
 mono_threadpool_enqueue_work_item (MonoDomain *domain, MonoObject *work_item, MonoError *error);
 
+gboolean
+mono_threadpool_enqueue_work_items (MonoDomain *domain, MonoObject **work_items, gint count, MonoError *error);
+
 #endif // _MONO_METADATA_THREADPOOL_H_
@@ -851,6 +851,7 @@ mono_thread_attach_internal (MonoThread *thread, gboolean force_attach, gboolean
 	MonoInternalThread *internal;
 	MonoDomain *domain, *root_domain;
 	guint32 gchandle;
+	guint32 offset;
 
 	g_assert (thread);
 
@@ -905,15 +906,18 @@ mono_thread_attach_internal (MonoThread *thread, gboolean force_attach, gboolean
 	mono_g_hash_table_insert_internal (threads, (gpointer)(gsize)(internal->tid), internal);
 
 	/* We have to do this here because mono_thread_start_cb
-	 * requires that root_domain_thread is set up. */
-	if (thread_static_info.offset || thread_static_info.idx > 0) {
-		/* get the current allocated size */
-		guint32 offset = MAKE_SPECIAL_STATIC_OFFSET (thread_static_info.idx, thread_static_info.offset, 0);
-		mono_alloc_static_data (&internal->static_data, offset, (void *) MONO_UINT_TO_NATIVE_THREAD_ID (internal->tid), TRUE);
-	}
+	 * requires that root_domain_thread is set up. The first chunk is
+	 * allocated even if there are no thread statics yet, so static_data
+	 * never changes while the thread is attached and can be cached in TLS
+	 * for the JIT. */
+	/* get the current allocated size */
+	offset = MAKE_SPECIAL_STATIC_OFFSET (thread_static_info.idx, thread_static_info.offset, 0);
+	mono_alloc_static_data (&internal->static_data, offset, (void *) MONO_UINT_TO_NATIVE_THREAD_ID (internal->tid), TRUE);
 
 	mono_threads_unlock ();
 
+	mono_tls_set_thread_static_data (internal->static_data);
+
 	root_domain = mono_get_root_domain ();
 
 	g_assert (!internal->root_domain_thread);
@@ -984,6 +988,8 @@ mono_thread_detach_internal (MonoInternalThread *thread)
 	mono_w32mutex_abandon (thread);
 #endif
 
+	mono_monitor_thread_detach ();
+
 	mono_gchandle_free_internal (thread->abort_state_handle);
 	thread->abort_state_handle = 0;
 
@@ -1056,6 +1062,7 @@ mono_thread_detach_internal (MonoInternalThread *thread)
 
 	mono_thread_pop_appdomain_ref ();
 
+	mono_tls_set_thread_static_data (NULL);
 	mono_free_static_data (thread->static_data);
 	thread->static_data = NULL;
 	ref_stack_destroy (thread->appdomain_refs);
@@ -1110,9 +1117,39 @@ typedef struct {
 	gpointer start_func_arg;
 	gboolean force_attach;
 	gboolean failed;
+	/* Whenever the OS thread can be parked to run another thread once this one finishes */
+	gboolean parkable;
+	/* The stack size asked for, before the platform adjusts it */
+	gsize stack_size;
 	MonoCoopSem registered;
 } StartInfo;
 
+/*
+ * Runtime created threads don't exit right away once they finish running their managed
+ * thread: they park for a while, and the next create_thread () asking for the same stack
+ * size hands its StartInfo to one of them instead of creating an OS thread. This keeps the
+ * stack, the MonoThreadInfo with its small id and the native TLS of the thread around, so
+ * short lived threads only pay for attaching and detaching the managed thread.
+ */
+typedef struct _ParkedThread ParkedThread;
+struct _ParkedThread {
+	ParkedThread *next;
+	MonoNativeThreadId tid;
+	gsize stack_size;
+	gsize stack_size_actual;
+	/* Set by unpark_thread (), the thread is removed from the list by then */
+	StartInfo *start_info;
+	MonoCoopCond cond;
+};
+
+#define PARKED_THREADS_MAX 16
+#define PARKED_THREAD_IDLE_TIMEOUT 2000
+
+/* Protected by parked_threads_mutex */
+static ParkedThread *parked_threads;
+static gint32 parked_threads_count;
+static MonoCoopMutex parked_threads_mutex;
+
 static void
 fire_attach_profiler_events (MonoNativeThreadId tid)
 {
@@ -1137,7 +1174,7 @@ fire_attach_profiler_events (MonoNativeThreadId tid)
 }
 
 static guint32 WINAPI
-start_wrapper_internal (StartInfo *start_info, gsize *stack_ptr)
+start_wrapper_internal (StartInfo *start_info, gsize *stack_ptr, gboolean *attached)
 {
 	ERROR_DECL (error);
 	MonoThreadStart start_func;
@@ -1157,6 +1194,8 @@ start_wrapper_internal (StartInfo *start_info, gsize *stack_ptr)
 
 	THREAD_DEBUG (g_message ("%s: (%" G_GSIZE_FORMAT ") Start wrapper", __func__, mono_native_thread_id_get ()));
 
+	*attached = FALSE;
+
 	if (!mono_thread_attach_internal (thread, start_info->force_attach, FALSE)) {
 		start_info->failed = TRUE;
 
@@ -1170,6 +1209,8 @@ start_wrapper_internal (StartInfo *start_info, gsize *stack_ptr)
 		return 0;
 	}
 
+	*attached = TRUE;
+
 	mono_thread_internal_set_priority (internal, (MonoThreadPriority)internal->priority);
 
 	tid = internal->tid;
@@ -1281,12 +1322,126 @@ start_wrapper_internal (StartInfo *start_info, gsize *stack_ptr)
 	return 0;
 }
 
+/*
+ * park_thread:
+ *
+ *   Called by a runtime created thread once it detached from its managed thread, to wait
+ * for create_thread () to hand it another one. Returns the StartInfo of the new thread, or
+ * NULL if the thread should exit.
+ */
+static StartInfo*
+park_thread (MonoThreadInfo *info, gsize stack_size)
+{
+	ParkedThread parked;
+	ParkedThread **prev;
+	gint64 start, elapsed;
+
+	mono_coop_mutex_lock (&parked_threads_mutex);
+
+	if (shutting_down || parked_threads_count >= PARKED_THREADS_MAX) {
+		mono_coop_mutex_unlock (&parked_threads_mutex);
+		return NULL;
+	}
+
+	/* Threads joining the managed thread which just finished shouldn't wait for us */
+	mono_thread_info_renew_handle ();
+
+	mono_thread_info_clear_self_interrupt ();
+	mono_native_thread_set_name (mono_native_thread_id_get (), NULL);
+
+	memset (&parked, 0, sizeof (parked));
+	parked.tid = mono_native_thread_id_get ();
+	parked.stack_size = stack_size;
+	parked.stack_size_actual = (guint8*)info->stack_end - (guint8*)info->stack_start_limit;
+	mono_coop_cond_init (&parked.cond);
+
+	parked.next = parked_threads;
+	parked_threads = &parked;
+	parked_threads_count ++;
+
+	start = mono_msec_ticks ();
+	while (!parked.start_info && !shutting_down) {
+		elapsed = mono_msec_ticks () - start;
+		if (elapsed >= PARKED_THREAD_IDLE_TIMEOUT)
+			break;
+		mono_coop_cond_timedwait (&parked.cond, &parked_threads_mutex, PARKED_THREAD_IDLE_TIMEOUT - (guint32)elapsed);
+	}
+
+	if (!parked.start_info) {
+		for (prev = &parked_threads; *prev != &parked; prev = &(*prev)->next)
+			;
+		*prev = parked.next;
+		parked_threads_count --;
+	}
+
+	mono_coop_mutex_unlock (&parked_threads_mutex);
+
+	mono_coop_cond_destroy (&parked.cond);
+
+	return parked.start_info;
+}
+
+/*
+ * unpark_thread:
+ *
+ *   Hand @start_info to a parked thread with a stack of @stack_size. Returns FALSE if
+ * there is none, otherwise sets @stack_size and @tid like mono_thread_platform_create_thread ().
+ */
+static gboolean
+unpark_thread (StartInfo *start_info, gsize *stack_size, MonoNativeThreadId *tid)
+{
+	ParkedThread *parked;
+	ParkedThread **prev;
+
+	/* Racy, we don't care about missing a thread which is just parking */
+	if (!UnlockedRead (&parked_threads_count))
+		return FALSE;
+
+	mono_coop_mutex_lock (&parked_threads_mutex);
+
+	for (prev = &parked_threads; (parked = *prev); prev = &parked->next) {
+		if (parked->stack_size == *stack_size)
+			break;
+	}
+
+	if (!parked) {
+		mono_coop_mutex_unlock (&parked_threads_mutex);
+		return FALSE;
+	}
+
+	*prev = parked->next;
+	parked_threads_count --;
+
+	*stack_size = parked->stack_size_actual;
+	*tid = parked->tid;
+
+	parked->start_info = start_info;
+	mono_coop_cond_signal (&parked->cond);
+
+	mono_coop_mutex_unlock (&parked_threads_mutex);
+
+	return TRUE;
+}
+
+static void
+unpark_threads_for_shutdown (void)
+{
+	ParkedThread *parked;
+
+	mono_coop_mutex_lock (&parked_threads_mutex);
+	for (parked = parked_threads; parked; parked = parked->next)
+		mono_coop_cond_signal (&parked->cond);
+	mono_coop_mutex_unlock (&parked_threads_mutex);
+}
+
 static mono_thread_start_return_t WINAPI
 start_wrapper (gpointer data)
 {
 	StartInfo *start_info;
 	MonoThreadInfo *info;
 	gsize res;
+	gsize stack_size;
+	gboolean parkable, attached;
 
 	start_info = (StartInfo*) data;
 	g_assert (start_info);
@@ -1294,8 +1449,16 @@ start_wrapper (gpointer data)
 	info = mono_thread_info_attach ();
 	info->runtime_thread = TRUE;
 
-	/* Run the actual main function of the thread */
-	res = start_wrapper_internal (start_info, (gsize*)info->stack_end);
+	do {
+		parkable = start_info->parkable;
+		stack_size = start_info->stack_size;
+
+		/* Run the actual main function of the thread */
+		res = start_wrapper_internal (start_info, (gsize*)info->stack_end, &attached);
+
+		if (!attached || !parkable)
+			break;
+	} while ((start_info = park_thread (info, stack_size)));
 
 	mono_thread_info_exit (res);
 
@@ -1366,6 +1529,7 @@ create_thread (MonoThread *thread, MonoInternalThread *internal, MonoObject *sta
 	start_info->start_func_arg = start_func_arg;
 	start_info->force_attach = flags & MONO_THREAD_CREATE_FLAGS_FORCE_CREATE;
 	start_info->failed = FALSE;
+	start_info->parkable = !(flags & (MONO_THREAD_CREATE_FLAGS_DEBUGGER | MONO_THREAD_CREATE_FLAGS_FORCE_CREATE));
 	mono_coop_sem_init (&start_info->registered, 0);
 
 	if (flags != MONO_THREAD_CREATE_FLAGS_SMALL_STACK)
@@ -1373,7 +1537,11 @@ create_thread (MonoThread *thread, MonoInternalThread *internal, MonoObject *sta
 	else
 		stack_set_size = 0;
 
-	if (!mono_thread_platform_create_thread (start_wrapper, start_info, &stack_set_size, &tid)) {
+	start_info->stack_size = stack_set_size;
+
+	if (start_info->parkable && unpark_thread (start_info, &stack_set_size, &tid)) {
+		/* Reusing a parked thread, it runs start_wrapper_internal () for us */
+	} else if (!mono_thread_platform_create_thread (start_wrapper, start_info, &stack_set_size, &tid)) {
 		/* The thread couldn't be created, so set an exception */
 		mono_threads_lock ();
 		mono_g_hash_table_remove (threads_starting_up, thread);
@@ -3354,6 +3522,7 @@ void mono_thread_init (MonoThreadStartCB start_cb,
 	mono_os_mutex_init (&interlocked_mutex);
 #endif
 	mono_coop_mutex_init_recursive(&joinable_threads_mutex);
+	mono_coop_mutex_init (&parked_threads_mutex);
 
 	mono_os_event_init (&background_change_event, FALSE);
 	
@@ -3697,6 +3866,9 @@ mono_threads_set_shutting_down (void)
 		MONO_EXIT_GC_SAFE;
 
 		mono_threads_unlock ();
+
+		/* Parked threads exit instead of running another thread */
+		unpark_threads_for_shutdown ();
 	}
 }
 
@@ -6450,12 +6622,9 @@ summarizer_post_dump (SummarizerGlobalState *state, MonoThreadSummary *this_thre
 // responded and then count that the expected number are set. If it is not true,
 // then we wait for them to be unset.
 static void
-summary_timedwait (SummarizerGlobalState *state, int timeout_seconds)
+summary_timedwait (SummarizerGlobalState *state, int timeout_ms)
 {
-	const gint64 milliseconds_in_second = 1000;
-	gint64 timeout_total = milliseconds_in_second * timeout_seconds;
-
-	gint64 end = mono_msec_ticks () + timeout_total;
+	gint64 end = mono_msec_ticks () + timeout_ms;
 
 	while (TRUE) {
 		if (mono_atomic_load_i32 ((volatile gint32 *) &state->nthreads_attached) == state->nthreads)
@@ -6495,10 +6664,14 @@ summarizer_state_term (SummarizerGlobalState *state, gchar **out, gchar *mem, si
 	MonoThreadSummary *threads [MAX_NUM_THREADS];
 	memset (threads, 0, sizeof(threads));
 
+	// Raw summaries only have the frames each thread recorded for itself,
+	// walking stacks and formatting json is left to the next run
+	gboolean raw = mono_summarize_raw_budget () != 0;
+
 	mono_summarize_timeline_phase_log (MonoSummaryManagedStacks);
 	for (int i=0; i < state->nthreads; i++) {
 		threads [i] = summarizer_try_read_thread (state, i);
-		if (!threads [i])
+		if (!threads [i] || raw)
 			continue;
 
 		// We are doing this dump on the controlling thread because this isn't
@@ -6514,19 +6687,25 @@ summarizer_state_term (SummarizerGlobalState *state, gchar **out, gchar *mem, si
 	memset (&writer, 0, sizeof (writer));
 
 	mono_summarize_timeline_phase_log (MonoSummaryStateWriter);
-	mono_summarize_native_state_begin (&writer, mem, provided_size);
+	if (raw) {
+		if (!mono_summarize_raw_write (threads, state->nthreads, controlling) && !state->silent)
+			g_async_safe_printf ("Couldn't write the raw crash summary.\n");
+	} else {
+		mono_summarize_native_state_begin (&writer, mem, provided_size);
+	}
 	for (int i=0; i < state->nthreads; i++) {
 		MonoThreadSummary *thread = threads [i];
 		if (!thread)
 			continue;
 
-		mono_summarize_native_state_add_thread (&writer, thread, thread->ctx, thread == controlling);
+		if (!raw)
+			mono_summarize_native_state_add_thread (&writer, thread, thread->ctx, thread == controlling);
 		// Set non-shared state to notify the waiting thread to clean up
 		// without having to keep our shared state alive
 		mono_atomic_store_i32 (&thread->done, 0x1);
 		mono_os_sem_post (&thread->done_wait);
 	}
-	*out = mono_summarize_native_state_end (&writer);
+	*out = raw ? NULL : mono_summarize_native_state_end (&writer);
 	mono_summarize_timeline_phase_log (MonoSummaryStateWriterDone);
 
 	mono_os_sem_destroy (&state->update);
@@ -6598,8 +6777,9 @@ mono_threads_summarize_execute_internal (MonoContext *ctx, gchar **out, MonoStac
 		if (!state.silent)
 			g_async_safe_printf("Entering thread summarizer pause from 0x%zx\n", MONO_NATIVE_THREAD_ID_TO_UINT (current));
 
-		// Wait up to 2 seconds for all of the other threads to catch up
-		summary_timedwait (&state, 2);
+		// Wait up to 2 seconds, or the raw summary budget, for all of the other threads to catch up
+		int budget = mono_summarize_raw_budget ();
+		summary_timedwait (&state, budget ? budget : 2000);
 
 		if (!state.silent)
 			g_async_safe_printf("Finished thread summarizer pause from 0x%zx.\n", MONO_NATIVE_THREAD_ID_TO_UINT (current));
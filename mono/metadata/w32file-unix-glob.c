@@ -358,6 +358,58 @@ match(const gchar *name, gchar *pat, gchar *patend, gboolean ignorecase)
 	return(*name == EOS);
 }
 
+/*
+ * Translate PATTERN like mono_w32file_unix_glob () does, for matching names one
+ * at a time with mono_w32file_unix_glob_match () while a directory is read.
+ * Returns NULL if the pattern can't match anything.
+ */
+char *
+mono_w32file_unix_glob_compile (const char *pattern)
+{
+	const unsigned char *patnext;
+	int c;
+	gchar *bufnext, *patbuf;
+
+	/* A null pathname is invalid -- POSIX 1003.1 sect. 2.4. */
+	if (*pattern == EOS)
+		return NULL;
+
+	patbuf = g_new (gchar, strlen (pattern) + 1);
+	patnext = (unsigned char *) pattern;
+	bufnext = patbuf;
+
+	/* The translated pattern is never longer than PATTERN */
+	while ((c = *patnext++) != EOS) {
+		if (c == QUOTE) {
+			if ((c = *patnext++) == EOS) {
+				c = QUOTE;
+				--patnext;
+			}
+			*bufnext++ = CHAR(c | M_PROTECT);
+		} else if (c == STAR) {
+			/* collapse adjacent stars to one,
+			 * to avoid exponential behavior
+			 */
+			if (bufnext == patbuf || bufnext[-1] != M_ALL)
+				*bufnext++ = M_ALL;
+		} else if (c == QUESTION) {
+			*bufnext++ = M_ONE;
+		} else {
+			*bufnext++ = CHAR(c);
+		}
+	}
+	*bufnext = EOS;
+
+	return patbuf;
+}
+
+gboolean
+mono_w32file_unix_glob_match (const char *name, const char *compiled, int flags)
+{
+	return match (name, (gchar *) compiled, (gchar *) compiled + strlen (compiled),
+		      flags & W32FILE_UNIX_GLOB_IGNORECASE);
+}
+
 /* Free allocated data belonging to a mono_w32file_unix_glob_t structure. */
 void
 mono_w32file_unix_globfree(mono_w32file_unix_glob_t *pglob)
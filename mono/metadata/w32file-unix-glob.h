@@ -67,4 +67,10 @@ mono_w32file_unix_glob (GDir *dir, const char *, int, mono_w32file_unix_glob_t *
 void
 mono_w32file_unix_globfree (mono_w32file_unix_glob_t *);
 
+char *
+mono_w32file_unix_glob_compile (const char *);
+
+gboolean
+mono_w32file_unix_glob_match (const char *, const char *, int);
+
 #endif /* !__MONO_METADATA_W32FILE_UNIX_GLOB_H__ */
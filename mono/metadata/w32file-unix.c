@@ -97,10 +97,15 @@ typedef struct {
 typedef struct {
 	MonoRefCount ref;
 	MonoCoopMutex mutex;
-	gchar **namelist;
+	/* Read as find_next () goes, so large directories are never held in memory */
+	DIR *dir;
 	gchar *dir_part;
-	gint num;
-	gsize count;
+	/* Compiled with mono_w32file_unix_glob_compile () */
+	gchar *pattern;
+	/* PATTERN without a trailing '.*', or NULL */
+	gchar *pattern_noext;
+	gint glob_flags;
+	gsize num_matches;
 } FindHandle;
 
 /*
@@ -664,197 +669,38 @@ _wapi_dirname (const gchar *filename)
 	return ret;
 }
 
-static GDir*
-_wapi_g_dir_open (const gchar *path, guint flags, GError **gerror)
+static DIR*
+_wapi_opendir (const gchar *path)
 {
-	GDir *ret;
+	DIR *ret;
 
 	MONO_ENTER_GC_SAFE;
-	ret = g_dir_open (path, flags, gerror);
+	ret = opendir (path);
 	MONO_EXIT_GC_SAFE;
-	if (ret == NULL && ((*gerror)->code == G_FILE_ERROR_NOENT || (*gerror)->code == G_FILE_ERROR_NOTDIR || (*gerror)->code == G_FILE_ERROR_NAMETOOLONG) && IS_PORTABILITY_SET) {
+	if (ret == NULL && (errno == ENOENT || errno == ENOTDIR || errno == ENAMETOOLONG) && IS_PORTABILITY_SET) {
+		gint saved_errno = errno;
 		gchar *located_filename = mono_portability_find_file (path, TRUE);
-		GError *tmp_error = NULL;
 
 		if (located_filename == NULL) {
-			return(NULL);
+			mono_set_errno (saved_errno);
+			return NULL;
 		}
 
 		MONO_ENTER_GC_SAFE;
-		ret = g_dir_open (located_filename, flags, &tmp_error);
+		ret = opendir (located_filename);
 		MONO_EXIT_GC_SAFE;
 		g_free (located_filename);
-		if (tmp_error == NULL) {
-			g_clear_error (gerror);
-		}
 	}
 
-	return ret;
-}
-
-static gint
-get_errno_from_g_file_error (gint error)
-{
-	switch (error) {
-#ifdef EACCES
-	case G_FILE_ERROR_ACCES: return EACCES;
-#endif
-#ifdef ENAMETOOLONG
-	case G_FILE_ERROR_NAMETOOLONG: return ENAMETOOLONG;
-#endif
-#ifdef ENOENT
-	case G_FILE_ERROR_NOENT: return ENOENT;
-#endif
-#ifdef ENOTDIR
-	case G_FILE_ERROR_NOTDIR: return ENOTDIR;
-#endif
-#ifdef ENXIO
-	case G_FILE_ERROR_NXIO: return ENXIO;
-#endif
-#ifdef ENODEV
-	case G_FILE_ERROR_NODEV: return ENODEV;
-#endif
-#ifdef EROFS
-	case G_FILE_ERROR_ROFS: return EROFS;
-#endif
-#ifdef ETXTBSY
-	case G_FILE_ERROR_TXTBSY: return ETXTBSY;
-#endif
-#ifdef EFAULT
-	case G_FILE_ERROR_FAULT: return EFAULT;
-#endif
-#ifdef ELOOP
-	case G_FILE_ERROR_LOOP: return ELOOP;
-#endif
-#ifdef ENOSPC
-	case G_FILE_ERROR_NOSPC: return ENOSPC;
-#endif
-#ifdef ENOMEM
-	case G_FILE_ERROR_NOMEM: return ENOMEM;
-#endif
-#ifdef EMFILE
-	case G_FILE_ERROR_MFILE: return EMFILE;
-#endif
-#ifdef ENFILE
-	case G_FILE_ERROR_NFILE: return ENFILE;
-#endif
-#ifdef EBADF
-	case G_FILE_ERROR_BADF: return EBADF;
-#endif
-#ifdef EINVAL
-	case G_FILE_ERROR_INVAL: return EINVAL;
-#endif
-#ifdef EPIPE
-	case G_FILE_ERROR_PIPE: return EPIPE;
-#endif
-#ifdef EAGAIN
-	case G_FILE_ERROR_AGAIN: return EAGAIN;
-#endif
-#ifdef EINTR
-	case G_FILE_ERROR_INTR: return EINTR;
-#endif
-#ifdef EIO
-	case G_FILE_ERROR_IO: return EIO;
-#endif
-#ifdef EPERM
-	case G_FILE_ERROR_PERM: return EPERM;
-#endif
-	case G_FILE_ERROR_FAILED: return ERROR_INVALID_PARAMETER;
-	default:
-		g_assert_not_reached ();
-	}
-}
-
-static gint
-file_compare (gconstpointer a, gconstpointer b)
-{
-	gchar *astr = *(gchar **) a;
-	gchar *bstr = *(gchar **) b;
-
-	return strcmp (astr, bstr);
-}
-
-/* scandir using glib */
-static gint
-_wapi_io_scandir (const gchar *dirname, const gchar *pattern, gchar ***namelist)
-{
-	GError *gerror = NULL;
-	GDir *dir;
-	GPtrArray *names;
-	gint result;
-	mono_w32file_unix_glob_t glob_buf;
-	gint flags = 0, i;
-
-	dir = _wapi_g_dir_open (dirname, 0, &gerror);
-	if (dir == NULL) {
-		/* g_dir_open returns ENOENT on directories on which we don't
+	if (ret == NULL && errno == ENOENT &&
+	    !_wapi_access (path, F_OK) &&
+	    _wapi_access (path, R_OK|X_OK)) {
+		/* opendir returns ENOENT on directories on which we don't
 		 * have read/x permission */
-		gint errnum = get_errno_from_g_file_error (gerror->code);
-		g_error_free (gerror);
-		if (errnum == ENOENT &&
-		    !_wapi_access (dirname, F_OK) &&
-		    _wapi_access (dirname, R_OK|X_OK)) {
-			errnum = EACCES;
-		}
-
-		mono_set_errno (errnum);
-		return -1;
-	}
-
-	if (IS_PORTABILITY_CASE) {
-		flags = W32FILE_UNIX_GLOB_IGNORECASE;
-	}
-
-	result = mono_w32file_unix_glob (dir, pattern, flags, &glob_buf);
-	if (g_str_has_suffix (pattern, ".*")) {
-		/* Special-case the patterns ending in '.*', as
-		 * windows also matches entries with no extension with
-		 * this pattern.
-		 *
-		 * TODO: should this be a MONO_IOMAP option?
-		 */
-		gchar *pattern2 = g_strndup (pattern, strlen (pattern) - 2);
-		gint result2;
-
-		MONO_ENTER_GC_SAFE;
-		g_dir_rewind (dir);
-		MONO_EXIT_GC_SAFE;
-		result2 = mono_w32file_unix_glob (dir, pattern2, flags | W32FILE_UNIX_GLOB_APPEND | W32FILE_UNIX_GLOB_UNIQUE, &glob_buf);
-
-		g_free (pattern2);
-
-		if (result != 0) {
-			result = result2;
-		}
+		mono_set_errno (EACCES);
 	}
 
-	MONO_ENTER_GC_SAFE;
-	g_dir_close (dir);
-	MONO_EXIT_GC_SAFE;
-	if (glob_buf.gl_pathc == 0) {
-		return(0);
-	} else if (result != 0) {
-		return -1;
-	}
-
-	names = g_ptr_array_new ();
-	for (i = 0; i < glob_buf.gl_pathc; i++) {
-		g_ptr_array_add (names, g_strdup (glob_buf.gl_pathv[i]));
-	}
-
-	mono_w32file_unix_globfree (&glob_buf);
-
-	result = names->len;
-	if (result > 0) {
-		g_ptr_array_sort (names, file_compare);
-		g_ptr_array_set_size (names, result + 1);
-
-		*namelist = (gchar **) g_ptr_array_free (names, FALSE);
-	} else {
-		g_ptr_array_free (names, TRUE);
-	}
-
-	return result;
+	return ret;
 }
 
 static gboolean
@@ -2824,6 +2670,78 @@ exit:
 	return ret;
 }
 
+/*
+ * mono_w32file_read_or_write_at:
+ *
+ *   Same as mono_w32file_read_or_write, but at @offset and without moving the file
+ * position, so several of them can run concurrently on the same file. Only supported
+ * for regular files.
+ */
+gboolean
+mono_w32file_read_or_write_at (gboolean read, gpointer handle, gpointer buffer, guint32 numbytes, gint64 offset, guint32 *transferred, gint32 *win32error)
+{
+	FileHandle *filehandle;
+	MonoThreadInfo *info = mono_thread_info_current ();
+	gboolean ret = FALSE;
+	gint res;
+
+	*transferred = 0;
+
+	gboolean const ref = mono_fdhandle_lookup_and_ref (GPOINTER_TO_INT (handle), (MonoFDHandle**) &filehandle);
+	if (!ref) {
+		mono_w32error_set_last (ERROR_INVALID_HANDLE);
+		goto exit;
+	}
+
+	if (((MonoFDHandle*) filehandle)->type != MONO_FDTYPE_FILE || offset < 0) {
+		mono_w32error_set_last (ERROR_INVALID_PARAMETER);
+		goto exit;
+	}
+
+	if (!(filehandle->fileaccess & (read ? GENERIC_READ : GENERIC_WRITE)) && !(filehandle->fileaccess & GENERIC_ALL)) {
+		mono_trace (G_LOG_LEVEL_DEBUG, MONO_TRACE_IO_LAYER_FILE, "%s: fd %d doesn't have %s access: %u", __func__, ((MonoFDHandle*) filehandle)->fd, read ? "GENERIC_READ" : "GENERIC_WRITE", filehandle->fileaccess);
+
+		mono_w32error_set_last (ERROR_ACCESS_DENIED);
+		goto exit;
+	}
+
+	if (!read && lock_while_writing) {
+		if (_wapi_lock_file_region (((MonoFDHandle*) filehandle)->fd, (off_t) offset, numbytes) == FALSE) {
+			/* The error has already been set */
+			goto exit;
+		}
+	}
+
+	do {
+		MONO_ENTER_GC_SAFE;
+		if (read)
+			res = pread (((MonoFDHandle*) filehandle)->fd, buffer, numbytes, (off_t) offset);
+		else
+			res = pwrite (((MonoFDHandle*) filehandle)->fd, buffer, numbytes, (off_t) offset);
+		MONO_EXIT_GC_SAFE;
+	} while (res == -1 && errno == EINTR &&
+		 !mono_thread_info_is_interrupt_state (info));
+
+	if (!read && lock_while_writing)
+		_wapi_unlock_file_region (((MonoFDHandle*) filehandle)->fd, (off_t) offset, numbytes);
+
+	if (res == -1) {
+		mono_trace (G_LOG_LEVEL_DEBUG, MONO_TRACE_IO_LAYER_FILE, "%s: %s of fd %d error: %s", __func__, read ? "pread" : "pwrite", ((MonoFDHandle*) filehandle)->fd, g_strerror (errno));
+		_wapi_set_last_error_from_errno ();
+		goto exit;
+	}
+
+	*transferred = res;
+	ret = TRUE;
+
+exit:
+	if (ref)
+		mono_fdhandle_unref ((MonoFDHandle*) filehandle);
+	if (!ret)
+		*win32error = mono_w32error_get_last ();
+	return ret;
+}
+
 gboolean
 mono_w32file_read (gpointer handle, gpointer buffer, guint32 numbytes, guint32 *bytesread, gint32 *win32error)
 {
@@ -3114,10 +3032,11 @@ findhandle_destroy (gpointer data)
 
 	mono_coop_mutex_destroy (&findhandle->mutex);
 
-	if (findhandle->namelist)
-		g_strfreev (findhandle->namelist);
-	if (findhandle->dir_part)
-		g_free (findhandle->dir_part);
+	if (findhandle->dir)
+		closedir (findhandle->dir);
+	g_free (findhandle->dir_part);
+	g_free (findhandle->pattern);
+	g_free (findhandle->pattern_noext);
 
 	g_free (findhandle);
 }
@@ -3208,8 +3127,8 @@ gpointer
 mono_w32file_find_first (const gunichar2 *pattern, WIN32_FIND_DATA *find_data)
 {
 	FindHandle *findhandle;
-	gchar *utf8_pattern = NULL, *dir_part, *entry_part, **namelist;
-	gint result;
+	gchar *utf8_pattern = NULL, *dir_part, *entry_part;
+	DIR *dir;
 	ERROR_DECL (error);
 	
 	if (pattern == NULL) {
@@ -3268,59 +3187,129 @@ mono_w32file_find_first (const gunichar2 *pattern, WIN32_FIND_DATA *find_data)
 	 * than mess around with regexes.
 	 */
 
-	namelist = NULL;
-	result = _wapi_io_scandir (dir_part, entry_part,
-				   &namelist);
-	
-	if (result == 0) {
-		/* No files, which windows seems to call
-		 * FILE_NOT_FOUND
-		 */
-		mono_w32error_set_last (ERROR_FILE_NOT_FOUND);
-		g_free (utf8_pattern);
-		g_free (entry_part);
-		g_free (dir_part);
-		g_strfreev (namelist);
-		return (INVALID_HANDLE_VALUE);
-	}
-	
-	if (result < 0) {
+	dir = _wapi_opendir (dir_part);
+	if (dir == NULL) {
 		_wapi_set_last_path_error_from_errno (dir_part, NULL);
-		mono_trace (G_LOG_LEVEL_DEBUG, MONO_TRACE_IO_LAYER_FILE, "%s: scandir error: %s", __func__, g_strerror (errno));
+		mono_trace (G_LOG_LEVEL_DEBUG, MONO_TRACE_IO_LAYER_FILE, "%s: opendir error: %s", __func__, g_strerror (errno));
 		g_free (utf8_pattern);
 		g_free (entry_part);
 		g_free (dir_part);
-		g_strfreev (namelist);
 		return (INVALID_HANDLE_VALUE);
 	}
 
-	g_free (utf8_pattern);
-	g_free (entry_part);
-	
-	mono_trace (G_LOG_LEVEL_DEBUG, MONO_TRACE_IO_LAYER_FILE, "%s: Got %d matches", __func__, result);
-
 	findhandle = findhandle_create ();
-	findhandle->namelist = namelist;
+	findhandle->dir = dir;
 	findhandle->dir_part = dir_part;
-	findhandle->num = result;
-	findhandle->count = 0;
+	findhandle->pattern = mono_w32file_unix_glob_compile (entry_part);
+	if (g_str_has_suffix (entry_part, ".*")) {
+		/* Special-case the patterns ending in '.*', as
+		 * windows also matches entries with no extension with
+		 * this pattern.
+		 *
+		 * TODO: should this be a MONO_IOMAP option?
+		 */
+		gchar *pattern_noext = g_strndup (entry_part, strlen (entry_part) - 2);
+		findhandle->pattern_noext = mono_w32file_unix_glob_compile (pattern_noext);
+		g_free (pattern_noext);
+	}
+	if (IS_PORTABILITY_CASE)
+		findhandle->glob_flags = W32FILE_UNIX_GLOB_IGNORECASE;
+
+	g_free (utf8_pattern);
+	g_free (entry_part);
 
 	findhandle_insert (findhandle);
 
 	if (!mono_w32file_find_next ((gpointer) findhandle, find_data)) {
+		/* No files, which windows seems to call
+		 * FILE_NOT_FOUND
+		 */
+		guint32 error = findhandle->num_matches ? ERROR_NO_MORE_FILES : ERROR_FILE_NOT_FOUND;
+
 		mono_w32file_find_close ((gpointer) findhandle);
-		mono_w32error_set_last (ERROR_NO_MORE_FILES);
+		mono_w32error_set_last (error);
 		return INVALID_HANDLE_VALUE;
 	}
 
 	return (gpointer) findhandle;
 }
 
+/*
+ * find_stat:
+ *
+ *   Stat the directory entry ENTRY of FILENAME into BUF, following symlinks,
+ * and set IS_LINK if it is one.  The entry is looked up relative to the open
+ * directory instead of by path, and its type is taken from d_type when the
+ * file system provides it, so every entry costs a single call to fstatat ()
+ * instead of a stat () and an lstat () of the full path.
+ */
+static gint
+find_stat (FindHandle *findhandle, struct dirent *entry, const gchar *filename, struct stat *buf, gboolean *is_link)
+{
+	gint result;
+
+#if defined (HAVE_FSTATAT) && defined (HAVE_DIRFD)
+	int fd = dirfd (findhandle->dir);
+	gboolean known_link = FALSE;
+
+#ifdef DT_UNKNOWN
+	if (entry->d_type != DT_UNKNOWN && entry->d_type != DT_LNK) {
+		*is_link = FALSE;
+		MONO_ENTER_GC_SAFE;
+		result = fstatat (fd, entry->d_name, buf, AT_SYMLINK_NOFOLLOW);
+		MONO_EXIT_GC_SAFE;
+		return result;
+	}
+	known_link = entry->d_type == DT_LNK;
+#endif
+
+	if (!known_link) {
+		MONO_ENTER_GC_SAFE;
+		result = fstatat (fd, entry->d_name, buf, AT_SYMLINK_NOFOLLOW);
+		MONO_EXIT_GC_SAFE;
+		if (result != 0)
+			return result;
+		*is_link = S_ISLNK (buf->st_mode);
+		if (!*is_link)
+			return 0;
+	}
+
+	*is_link = TRUE;
+	MONO_ENTER_GC_SAFE;
+	result = fstatat (fd, entry->d_name, buf, 0);
+	if (result == -1 && errno == ENOENT) {
+		/* Might be a dangling symlink */
+		result = fstatat (fd, entry->d_name, buf, AT_SYMLINK_NOFOLLOW);
+	}
+	MONO_EXIT_GC_SAFE;
+	return result;
+#else
+	struct stat linkbuf;
+
+	result = _wapi_stat (filename, buf);
+	if (result == -1 && errno == ENOENT) {
+		/* Might be a dangling symlink */
+		result = _wapi_lstat (filename, buf);
+	}
+	if (result != 0)
+		return result;
+
+	result = _wapi_lstat (filename, &linkbuf);
+	if (result != 0)
+		return result;
+
+	*is_link = S_ISLNK (linkbuf.st_mode);
+	return 0;
+#endif
+}
+
 gboolean
 mono_w32file_find_next (gpointer handle, WIN32_FIND_DATA *find_data)
 {
 	FindHandle *findhandle;
-	struct stat buf, linkbuf;
+	struct dirent *entry;
+	struct stat buf;
+	gboolean is_link;
 	gint result;
 	gchar *filename;
 	gchar *utf8_filename, *utf8_basename;
@@ -3337,31 +3326,32 @@ mono_w32file_find_next (gpointer handle, WIN32_FIND_DATA *find_data)
 	mono_coop_mutex_lock (&findhandle->mutex);
 
 retry:
-	if (findhandle->count >= findhandle->num) {
+	MONO_ENTER_GC_SAFE;
+	entry = readdir (findhandle->dir);
+	MONO_EXIT_GC_SAFE;
+	if (entry == NULL) {
 		mono_w32error_set_last (ERROR_NO_MORE_FILES);
 		goto cleanup;
 	}
 
-	/* stat next match */
+	if (!strcmp (entry->d_name, ".") || !strcmp (entry->d_name, ".."))
+		goto retry;
+
+	if (!findhandle->pattern)
+		goto retry;
+	if (!mono_w32file_unix_glob_match (entry->d_name, findhandle->pattern, findhandle->glob_flags) &&
+	    !(findhandle->pattern_noext && mono_w32file_unix_glob_match (entry->d_name, findhandle->pattern_noext, findhandle->glob_flags)))
+		goto retry;
 
-	filename = g_build_filename (findhandle->dir_part, findhandle->namelist[findhandle->count ++], NULL);
+	findhandle->num_matches ++;
 
-	result = _wapi_stat (filename, &buf);
-	if (result == -1 && errno == ENOENT) {
-		/* Might be a dangling symlink */
-		result = _wapi_lstat (filename, &buf);
-	}
-	
-	if (result != 0) {
-		mono_trace (G_LOG_LEVEL_DEBUG, MONO_TRACE_IO_LAYER_FILE, "%s: stat failed: %s", __func__, filename);
+	/* stat next match */
 
-		g_free (filename);
-		goto retry;
-	}
+	filename = g_build_filename (findhandle->dir_part, entry->d_name, NULL);
 
-	result = _wapi_lstat (filename, &linkbuf);
+	result = find_stat (findhandle, entry, filename, &buf, &is_link);
 	if (result != 0) {
-		mono_trace (G_LOG_LEVEL_DEBUG, MONO_TRACE_IO_LAYER_FILE, "%s: lstat failed: %s", __func__, filename);
+		mono_trace (G_LOG_LEVEL_DEBUG, MONO_TRACE_IO_LAYER_FILE, "%s: stat failed: %s", __func__, filename);
 
 		g_free (filename);
 		goto retry;
@@ -3389,7 +3379,9 @@ retry:
 	else
 		create_time = buf.st_ctime;
 	
-	find_data->dwFileAttributes = _wapi_stat_to_file_attributes (utf8_filename, &buf, &linkbuf);
+	find_data->dwFileAttributes = _wapi_stat_to_file_attributes (utf8_filename, &buf, NULL);
+	if (is_link)
+		find_data->dwFileAttributes |= FILE_ATTRIBUTE_REPARSE_POINT;
 
 	time_t_to_filetime (create_time, &find_data->ftCreationTime);
 	time_t_to_filetime (buf.st_atime, &find_data->ftLastAccessTime);
@@ -380,6 +380,11 @@ mono_w32file_read (gpointer handle, gpointer buffer, guint32 numbytes, guint32 *
 gboolean
 mono_w32file_write (gpointer handle, gconstpointer buffer, guint32 numbytes, guint32 *byteswritten, gint32 *win32error);
 
+#if !defined(HOST_WIN32)
+gboolean
+mono_w32file_read_or_write_at (gboolean read, gpointer handle, gpointer buffer, guint32 numbytes, gint64 offset, guint32 *transferred, gint32 *win32error);
+#endif
+
 gboolean
 mono_w32file_flush (gpointer handle);
 
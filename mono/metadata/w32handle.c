@@ -21,6 +21,16 @@
 #include "utils/mono-time.h"
 #include "utils/mono-error-internals.h"
 
+#if defined(__linux__)
+#include <errno.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#if defined(SYS_futex)
+#define W32HANDLE_USE_FUTEX 1
+#endif
+#endif
+
 #undef DEBUG_REFS
 
 #define HANDLES_PER_SLOT 240
@@ -38,12 +48,19 @@ static MonoW32HandleSlot *handles_slots_first;
 static MonoW32HandleSlot *handles_slots_last;
 
 /*
- * This is an internal handle which is used for handling waiting for multiple handles.
- * Threads which wait for multiple handles wait on this one handle, and when a handle
- * is signalled, this handle is signalled too.
+ * Threads which wait for multiple handles register a waiter on each of them, and
+ * signalling a handle only wakes the waiters registered on it. The waiter is
+ * refcounted, as the interrupt callback can run after the wait returned.
  */
-static MonoCoopMutex global_signal_mutex;
-static MonoCoopCond global_signal_cond;
+struct _MonoW32HandleWaiter {
+	gint32 ref;
+	/* Set when one of the handles is signalled, the futex word on Linux */
+	gint32 woken;
+#if !defined(W32HANDLE_USE_FUTEX)
+	MonoCoopMutex mutex;
+	MonoCoopCond cond;
+#endif
+};
 
 static MonoCoopMutex scan_mutex;
 
@@ -52,6 +69,9 @@ static gboolean shutting_down;
 static const gchar*
 mono_w32handle_ops_typename (MonoW32Type type);
 
+static void
+mono_w32handle_waiter_wake (MonoW32HandleWaiter *waiter);
+
 const gchar*
 mono_w32handle_get_typename (MonoW32Type type)
 {
@@ -67,12 +87,9 @@ mono_w32handle_set_signal_state (MonoW32Handle *handle_data, gboolean state, gbo
 #endif
 
 	if (state) {
-		/* Tell everyone blocking on a single handle */
+		MonoW32HandleWaiterLink *link;
 
-		/* The condition the global signal cond is waiting on is the signalling of
-		 * _any_ handle. So lock it before setting the signalled state.
-		 */
-		mono_coop_mutex_lock (&global_signal_mutex);
+		/* Tell everyone blocking on a single handle */
 
 		/* This function _must_ be called with
 		 * handle->signal_mutex locked
@@ -84,12 +101,13 @@ mono_w32handle_set_signal_state (MonoW32Handle *handle_data, gboolean state, gbo
 		else
 			mono_coop_cond_signal (&handle_data->signal_cond);
 
-		/* Tell everyone blocking on multiple handles that something
-		 * was signalled
+		/* Tell the ones blocking on multiple handles including
+		 * this one that it was signalled
 		 */
-		mono_coop_cond_broadcast (&global_signal_cond);
-
-		mono_coop_mutex_unlock (&global_signal_mutex);
+		mono_coop_mutex_lock (&handle_data->waiters_mutex);
+		for (link = handle_data->waiters; link; link = link->next)
+			mono_w32handle_waiter_wake (link->waiter);
+		mono_coop_mutex_unlock (&handle_data->waiters_mutex);
 	} else {
 		handle_data->signalled = FALSE;
 	}
@@ -107,26 +125,6 @@ mono_w32handle_set_in_use (MonoW32Handle *handle_data, gboolean in_use)
 	handle_data->in_use = in_use;
 }
 
-static void
-mono_w32handle_lock_signal_mutex (void)
-{
-#ifdef DEBUG
-	g_message ("%s: lock global signal mutex", __func__);
-#endif
-
-	mono_coop_mutex_lock (&global_signal_mutex);
-}
-
-static void
-mono_w32handle_unlock_signal_mutex (void)
-{
-#ifdef DEBUG
-	g_message ("%s: unlock global signal mutex", __func__);
-#endif
-
-	mono_coop_mutex_unlock (&global_signal_mutex);
-}
-
 void
 mono_w32handle_lock (MonoW32Handle *handle_data)
 {
@@ -155,9 +153,6 @@ mono_w32handle_init (void)
 
 	mono_coop_mutex_init (&scan_mutex);
 
-	mono_coop_cond_init (&global_signal_cond);
-	mono_coop_mutex_init (&global_signal_mutex);
-
 	handles_slots_first = handles_slots_last = g_new0 (MonoW32HandleSlot, 1);
 
 	initialized = TRUE;
@@ -232,6 +227,7 @@ retry:
 
 				mono_coop_cond_init (&handle_data->signal_cond);
 				mono_coop_mutex_init (&handle_data->signal_mutex);
+				mono_coop_mutex_init (&handle_data->waiters_mutex);
 
 				if (handle_specific)
 					handle_data->specific = g_memdup (handle_specific, mono_w32handle_ops_typesize (type));
@@ -463,8 +459,11 @@ w32handle_destroy (MonoW32Handle *handle_data)
 
 	mono_trace (G_LOG_LEVEL_DEBUG, MONO_TRACE_IO_LAYER_HANDLE, "%s: destroy %s handle %p", __func__, mono_w32handle_ops_typename (type), handle_data);
 
+	g_assert (!handle_data->waiters);
+
 	mono_coop_mutex_destroy (&handle_data->signal_mutex);
 	mono_coop_cond_destroy (&handle_data->signal_cond);
+	mono_coop_mutex_destroy (&handle_data->waiters_mutex);
 
 	memset (handle_data, 0, sizeof (MonoW32Handle));
 
@@ -680,43 +679,181 @@ mono_w32handle_timedwait_signal_naked (MonoCoopCond *cond, MonoCoopMutex *mutex,
 	return res;
 }
 
+#ifndef HOST_WIN32
+static void
+mono_w32handle_waiter_unref (MonoW32HandleWaiter *waiter)
+{
+	if (mono_atomic_dec_i32 (&waiter->ref) > 0)
+		return;
+
+#if !defined(W32HANDLE_USE_FUTEX)
+	mono_coop_cond_destroy (&waiter->cond);
+	mono_coop_mutex_destroy (&waiter->mutex);
+#endif
+	g_free (waiter);
+}
+
+static MonoW32HandleWaiter*
+mono_w32handle_waiter_new (void)
+{
+	MonoW32HandleWaiter *waiter;
+
+	waiter = g_new0 (MonoW32HandleWaiter, 1);
+	waiter->ref = 1;
+#if !defined(W32HANDLE_USE_FUTEX)
+	mono_coop_mutex_init (&waiter->mutex);
+	mono_coop_cond_init (&waiter->cond);
+#endif
+
+	return waiter;
+}
+#endif /* HOST_WIN32 */
+
 static void
-signal_global (gpointer unused)
+mono_w32handle_waiter_wake (MonoW32HandleWaiter *waiter)
+{
+#if defined(W32HANDLE_USE_FUTEX)
+	if (mono_atomic_xchg_i32 (&waiter->woken, 1) == 0)
+		syscall (SYS_futex, &waiter->woken, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+#elif !defined(HOST_WIN32)
+	mono_coop_mutex_lock (&waiter->mutex);
+	waiter->woken = 1;
+	mono_coop_cond_signal (&waiter->cond);
+	mono_coop_mutex_unlock (&waiter->mutex);
+#endif
+}
+
+#ifndef HOST_WIN32
+static void
+signal_waiter_and_unref (gpointer waiter)
 {
 	/* If we reach here, then interrupt token is set to the flag value, which
 	 * means that the target thread is either
 	 * - before the first CAS in timedwait, which means it won't enter the wait.
 	 * - it is after the first CAS, so it is already waiting, or it will enter
-	 *    the wait, and it will be interrupted by the broadcast. */
-	mono_coop_mutex_lock (&global_signal_mutex);
-	mono_coop_cond_broadcast (&global_signal_cond);
-	mono_coop_mutex_unlock (&global_signal_mutex);
+	 *    the wait, and it will be woken up. */
+	mono_w32handle_waiter_wake ((MonoW32HandleWaiter *)waiter);
+	mono_w32handle_waiter_unref ((MonoW32HandleWaiter *)waiter);
 }
 
 static int
-mono_w32handle_timedwait_signal (guint32 timeout, gboolean poll, gboolean *alerted)
+mono_w32handle_waiter_wait_naked (MonoW32HandleWaiter *waiter, guint32 timeout)
 {
+#if defined(W32HANDLE_USE_FUTEX)
+	struct timespec ts, *tsp = NULL;
 	int res;
 
-	mono_trace (G_LOG_LEVEL_DEBUG, MONO_TRACE_IO_LAYER_HANDLE, "%s: waiting for global", __func__);
+	if (timeout != MONO_INFINITE_WAIT) {
+		ts.tv_sec = timeout / 1000;
+		ts.tv_nsec = (timeout % 1000) * 1000000;
+		tsp = &ts;
+	}
+
+	MONO_ENTER_GC_SAFE;
+	res = syscall (SYS_futex, &waiter->woken, FUTEX_WAIT_PRIVATE, 0, tsp, NULL, 0);
+	MONO_EXIT_GC_SAFE;
+
+	/* Being woken up spuriously, by EINTR or EAGAIN, is fine: the caller checks the handles again */
+	return res == -1 && errno == ETIMEDOUT ? -1 : 0;
+#else
+	int res = 0;
+
+	mono_coop_mutex_lock (&waiter->mutex);
+	if (!waiter->woken)
+		res = mono_coop_cond_timedwait (&waiter->cond, &waiter->mutex, timeout);
+	mono_coop_mutex_unlock (&waiter->mutex);
+
+	return res;
+#endif
+}
+
+static int
+mono_w32handle_waiter_wait (MonoW32HandleWaiter *waiter, guint32 timeout, gboolean poll, gboolean *alerted)
+{
+	int res;
+
+	mono_trace (G_LOG_LEVEL_DEBUG, MONO_TRACE_IO_LAYER_HANDLE, "%s: waiting for multiple handles", __func__);
 
 	if (alerted)
 		*alerted = FALSE;
 
 	if (alerted) {
-		mono_thread_info_install_interrupt (signal_global, NULL, alerted);
-		if (*alerted)
+		mono_atomic_inc_i32 (&waiter->ref);
+		mono_thread_info_install_interrupt (signal_waiter_and_unref, waiter, alerted);
+		if (*alerted) {
+			mono_w32handle_waiter_unref (waiter);
 			return 0;
+		}
 	}
 
-	res = mono_w32handle_timedwait_signal_naked (&global_signal_cond, &global_signal_mutex, timeout, poll, alerted);
+	if (poll && timeout > 100) {
+		/* This is needed when waiting for process handles. Mask the fake
+		 * timeout, this will cause another poll if no handle was signalled */
+		res = mono_w32handle_waiter_wait_naked (waiter, 100);
+		if (res == -1)
+			res = 0;
+	} else {
+		res = mono_w32handle_waiter_wait_naked (waiter, timeout);
+	}
 
-	if (alerted)
+	if (alerted) {
 		mono_thread_info_uninstall_interrupt (alerted);
+		if (!*alerted) {
+			/* if it is alerted, then the waiter is unref'ed in the interrupt callback */
+			mono_w32handle_waiter_unref (waiter);
+		}
+	}
 
 	return res;
 }
 
+/* LOCKING: the handles must be locked */
+static void
+mono_w32handle_waiter_register (MonoW32HandleWaiter *waiter, MonoW32Handle **handles_data, MonoW32HandleWaiterLink *links, gsize nhandles)
+{
+	gint i;
+
+	for (i = 0; i < nhandles; i++) {
+		MonoW32Handle *handle_data = handles_data [i];
+
+		if (!handle_data)
+			continue;
+
+		links [i].waiter = waiter;
+		links [i].prev = NULL;
+
+		mono_coop_mutex_lock (&handle_data->waiters_mutex);
+		links [i].next = handle_data->waiters;
+		if (handle_data->waiters)
+			handle_data->waiters->prev = &links [i];
+		handle_data->waiters = &links [i];
+		mono_coop_mutex_unlock (&handle_data->waiters_mutex);
+	}
+}
+
+static void
+mono_w32handle_waiter_unregister (MonoW32Handle **handles_data, MonoW32HandleWaiterLink *links, gsize nhandles)
+{
+	gint i;
+
+	for (i = 0; i < nhandles; i++) {
+		MonoW32Handle *handle_data = handles_data [i];
+
+		if (!handle_data)
+			continue;
+
+		mono_coop_mutex_lock (&handle_data->waiters_mutex);
+		if (links [i].prev)
+			links [i].prev->next = links [i].next;
+		else
+			handle_data->waiters = links [i].next;
+		if (links [i].next)
+			links [i].next->prev = links [i].prev;
+		mono_coop_mutex_unlock (&handle_data->waiters_mutex);
+	}
+}
+#endif /* HOST_WIN32 */
+
 static void
 signal_handle_and_unref (gpointer handle_duplicate)
 {
@@ -994,6 +1131,9 @@ mono_w32handle_wait_multiple (gpointer *handles, gsize nhandles, gboolean waital
 	gint64 start = 0;
 	MonoW32Handle *handles_data [MONO_W32HANDLE_MAXIMUM_WAIT_OBJECTS];
 	gboolean abandoned [MONO_W32HANDLE_MAXIMUM_WAIT_OBJECTS] = {0};
+	MonoW32HandleWaiterLink links [MONO_W32HANDLE_MAXIMUM_WAIT_OBJECTS];
+	MonoW32HandleWaiter *waiter = NULL;
+	gboolean registered = FALSE;
 
 	if (nhandles == 0)
 		return MONO_W32HANDLE_WAIT_RET_FAILED;
@@ -1048,6 +1188,8 @@ mono_w32handle_wait_multiple (gpointer *handles, gsize nhandles, gboolean waital
 	if (timeout != MONO_INFINITE_WAIT)
 		start = mono_msec_ticks ();
 
+	waiter = mono_w32handle_waiter_new ();
+
 	for (;;) {
 		gsize count, lowest;
 		gboolean signalled;
@@ -1058,6 +1200,11 @@ mono_w32handle_wait_multiple (gpointer *handles, gsize nhandles, gboolean waital
 
 		mono_w32handle_lock_handles (handles_data, nhandles);
 
+		if (registered) {
+			mono_w32handle_waiter_unregister (handles_data, links, nhandles);
+			registered = FALSE;
+		}
+
 		for (i = 0; i < nhandles; i++) {
 			if (!handles_data [i])
 				continue;
@@ -1085,6 +1232,13 @@ mono_w32handle_wait_multiple (gpointer *handles, gsize nhandles, gboolean waital
 			}
 		}
 
+		if (!signalled) {
+			/* Any handle signalled from now on wakes us up */
+			mono_atomic_store_i32 (&waiter->woken, 0);
+			mono_w32handle_waiter_register (waiter, handles_data, links, nhandles);
+			registered = TRUE;
+		}
+
 		mono_w32handle_unlock_handles (handles_data, nhandles);
 
 		if (signalled) {
@@ -1110,54 +1264,25 @@ mono_w32handle_wait_multiple (gpointer *handles, gsize nhandles, gboolean waital
 			}
 		}
 
-		mono_w32handle_lock_signal_mutex ();
-
-		// FIXME These two loops can be just one.
-		if (waitall) {
-			signalled = TRUE;
-			for (i = 0; i < nhandles; ++i) {
-				if (!handles_data [i])
-					continue;
-				if (!mono_w32handle_issignalled (handles_data [i])) {
-					signalled = FALSE;
-					break;
-				}
-			}
-		} else {
-			signalled = FALSE;
-			for (i = 0; i < nhandles; ++i) {
-				if (!handles_data [i])
-					continue;
-				if (mono_w32handle_issignalled (handles_data [i])) {
-					signalled = TRUE;
-					break;
-				}
-			}
-		}
-
+		/* Waking up for a single handle with WaitAll is harmless, we check them all again */
 		waited = 0;
 
-		if (!signalled) {
+		if (!mono_atomic_load_i32 (&waiter->woken)) {
 			if (timeout == MONO_INFINITE_WAIT) {
-				waited = mono_w32handle_timedwait_signal (MONO_INFINITE_WAIT, poll, alertable ? &alerted : NULL);
+				waited = mono_w32handle_waiter_wait (waiter, MONO_INFINITE_WAIT, poll, alertable ? &alerted : NULL);
 			} else {
 				gint64 elapsed;
 
 				elapsed = mono_msec_ticks () - start;
 				if (elapsed > timeout) {
 					ret = MONO_W32HANDLE_WAIT_RET_TIMEOUT;
-
-					mono_w32handle_unlock_signal_mutex ();
-
 					goto done;
 				}
 
-				waited = mono_w32handle_timedwait_signal (timeout - elapsed, poll, alertable ? &alerted : NULL);
+				waited = mono_w32handle_waiter_wait (waiter, timeout - elapsed, poll, alertable ? &alerted : NULL);
 			}
 		}
 
-		mono_w32handle_unlock_signal_mutex ();
-
 		if (alerted) {
 			ret = MONO_W32HANDLE_WAIT_RET_ALERTED;
 			goto done;
@@ -1170,6 +1295,12 @@ mono_w32handle_wait_multiple (gpointer *handles, gsize nhandles, gboolean waital
 	}
 
 done:
+	if (registered)
+		mono_w32handle_waiter_unregister (handles_data, links, nhandles);
+
+	if (waiter)
+		mono_w32handle_waiter_unref (waiter);
+
 	for (i = nhandles - 1; i >= 0; i--) {
 		/* Unref everything we reffed above */
 		if (!handles_data [i])
@@ -32,6 +32,16 @@ typedef enum {
 	MONO_W32TYPE_COUNT
 } MonoW32Type;
 
+typedef struct _MonoW32HandleWaiter MonoW32HandleWaiter;
+
+/* Registration of a thread waiting for multiple handles on one of them */
+typedef struct _MonoW32HandleWaiterLink MonoW32HandleWaiterLink;
+struct _MonoW32HandleWaiterLink {
+	MonoW32HandleWaiterLink *prev;
+	MonoW32HandleWaiterLink *next;
+	MonoW32HandleWaiter *waiter;
+};
+
 typedef struct {
 	MonoW32Type type;
 	guint ref;
@@ -40,6 +50,9 @@ typedef struct {
 	MonoCoopMutex signal_mutex;
 	MonoCoopCond signal_cond;
 	gpointer specific;
+	/* Threads waiting for multiple handles including this one, protected by waiters_mutex */
+	MonoW32HandleWaiterLink *waiters;
+	MonoCoopMutex waiters_mutex;
 } MonoW32Handle;
 
 typedef enum {
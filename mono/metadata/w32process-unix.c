@@ -58,6 +58,12 @@
 #include <dirent.h>
 #endif
 
+/* posix_spawn can only replace fork if it can close the inherited FDs like close_my_fds */
+#if defined (HAVE_POSIX_SPAWN) && defined (HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCLOSEFROM_NP)
+#define USE_POSIX_SPAWN 1
+#include <spawn.h>
+#endif
+
 #include <mono/metadata/object-internals.h>
 #include <mono/metadata/w32process.h>
 #include <mono/metadata/w32process-internals.h>
@@ -1410,11 +1416,11 @@ close_my_fds (void)
 //         http://blog.palominolabs.com/2012/06/19/getting-the-files-being-used-by-a-process-on-mac-os-x/
 //         (I have no idea how this plays out on i/watch/tvOS.)
 //       * On the other BSDs, there's likely a sysctl for this.
-//       * On Solaris, there exists posix_spawn_file_actions_addclosefrom_np,
-//         but that assumes we're using posix_spawn; we aren't, as we do some
-//         complex stuff between fork and exec. There's likely a way to get
-//         the FD list/count though (maybe look at addclosefrom source in
-//         illumos?) or just walk /proc/pid/fd like Linux?
+//       * Where posix_spawn_file_actions_addclosefrom_np exists (glibc,
+//         Solaris), process_spawn is used instead and this isn't called.
+//         Otherwise there's likely a way to get the FD list/count (maybe
+//         look at addclosefrom source in illumos?) or just walk /proc/pid/fd
+//         like Linux?
 #if defined (__linux__)
 	/* Walk the file descriptors in /proc/self/fd/. Linux has no other API,
 	 * as far as I'm aware. Opening a directory won't create an FD. */
@@ -1493,6 +1499,126 @@ fallback:
 		close (i);
 }
 
+/*
+ * process_register:
+ *
+ *   Create the handle of the child PID and add it to the list of processes
+ * waited on by mono_w32process_signal_finished ().  Returns NULL on failure.
+ */
+static gpointer
+process_register (pid_t pid, const char *prog, MonoW32ProcessInfo *process_info)
+{
+	MonoW32Handle *handle_data;
+	MonoW32HandleProcess process_handle;
+	Process *process;
+	gpointer handle;
+
+	memset (&process_handle, 0, sizeof (process_handle));
+	process_handle.pid = pid;
+	process_handle.child = TRUE;
+	process_handle.pname = g_strdup (prog);
+	process_set_defaults (&process_handle);
+
+	/* Add our process into the linked list of processes */
+	process = (Process *) g_malloc0 (sizeof (Process));
+	process->pid = pid;
+	process->handle_count = 1;
+	mono_coop_sem_init (&process->exit_sem, 0);
+
+	process_handle.process = process;
+
+	handle = mono_w32handle_new (MONO_W32TYPE_PROCESS, &process_handle);
+	if (handle == INVALID_HANDLE_VALUE) {
+		g_warning ("%s: error creating process handle", __func__);
+
+		mono_coop_sem_destroy (&process->exit_sem);
+		g_free (process);
+
+		mono_w32error_set_last (ERROR_OUTOFMEMORY);
+		return NULL;
+	}
+
+	if (!mono_w32handle_lookup_and_ref (handle, &handle_data))
+		g_error ("%s: unknown handle %p", __func__, handle);
+
+	if (handle_data->type != MONO_W32TYPE_PROCESS)
+		g_error ("%s: unknown process handle %p", __func__, handle);
+
+	/* Keep the process handle artificially alive until the process
+	 * exits so that the information in the handle isn't lost. */
+	process->handle = mono_w32handle_duplicate (handle_data);
+
+	mono_coop_mutex_lock (&processes_mutex);
+	process->next = processes;
+	mono_memory_barrier ();
+	processes = process;
+	mono_coop_mutex_unlock (&processes_mutex);
+
+	if (process_info != NULL) {
+		process_info->process_handle = handle;
+		process_info->pid = pid;
+	}
+
+	mono_w32handle_unref (handle_data);
+
+	return handle;
+}
+
+#ifdef USE_POSIX_SPAWN
+/*
+ * process_spawn:
+ *
+ *   Start the child with posix_spawn () instead of fork () + execve ().  The C
+ * library implements it with vfork () or clone (CLONE_VM), so unlike fork () it
+ * doesn't copy the page tables of the parent, which makes spawning from a
+ * process with a large heap a lot cheaper.  The file actions do what the fork
+ * child of process_create does: redirect stdio, close the other FDs and chdir.
+ * Returns FALSE if the fork path has to be used, otherwise *PID is set, or is
+ * -1 with *ERR set to the errno of the failure.
+ */
+static gboolean
+process_spawn (char **argv, char **env_strings, const char *dir, int in_fd, int out_fd, int err_fd, pid_t *pid, int *err)
+{
+	posix_spawn_file_actions_t actions;
+	int res;
+
+#ifndef HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCHDIR_NP
+	if (dir != NULL)
+		return FALSE;
+#endif
+
+	if (posix_spawn_file_actions_init (&actions) != 0)
+		return FALSE;
+
+	res = posix_spawn_file_actions_adddup2 (&actions, in_fd, 0);
+	if (res == 0)
+		res = posix_spawn_file_actions_adddup2 (&actions, out_fd, 1);
+	if (res == 0)
+		res = posix_spawn_file_actions_adddup2 (&actions, err_fd, 2);
+	if (res == 0)
+		res = posix_spawn_file_actions_addclosefrom_np (&actions, 3);
+#ifdef HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCHDIR_NP
+	if (res == 0 && dir != NULL)
+		res = posix_spawn_file_actions_addchdir_np (&actions, dir);
+#endif
+	if (res != 0) {
+		posix_spawn_file_actions_destroy (&actions);
+		return FALSE;
+	}
+
+	res = posix_spawn (pid, argv [0], &actions, NULL, argv, env_strings);
+	posix_spawn_file_actions_destroy (&actions);
+
+	if (res != 0) {
+		mono_trace (G_LOG_LEVEL_DEBUG, MONO_TRACE_IO_LAYER_PROCESS, "%s: posix_spawn of %s failed: %s", __func__, argv [0], g_strerror (res));
+		*pid = -1;
+		*err = res;
+	}
+
+	return TRUE;
+}
+#endif
+
 static gboolean
 process_create (const gunichar2 *appname, const gunichar2 *cmdline,
 	const gunichar2 *cwd, StartupHandles *startup_handles, MonoW32ProcessInfo *process_info)
@@ -1508,7 +1634,6 @@ process_create (const gunichar2 *appname, const gunichar2 *cmdline,
 	pid_t pid = 0;
 	int startup_pipe [2] = {-1, -1};
 	int dummy;
-	Process *process;
 	ERROR_DECL (error);
 
 #if HAVE_SIGACTION
@@ -1847,6 +1972,28 @@ process_create (const gunichar2 *appname, const gunichar2 *cmdline,
 			env_strings [i] = g_strdup (environ[i]);
 	}
 
+#ifdef USE_POSIX_SPAWN
+	int spawn_err;
+
+	if (process_spawn (argv, env_strings, dir, in_fd, out_fd, err_fd, &pid, &spawn_err)) {
+		if (pid == -1) {
+			/* Unlike a failing exec in the fork child, this is reported to the caller */
+			mono_w32error_set_last (mono_w32error_unix_to_win32 (spawn_err));
+			ret = FALSE;
+			goto free_strings;
+		}
+
+		handle = process_register (pid, prog, process_info);
+		ret = handle != NULL;
+
+		/* There is no startup pipe, so the child might have exited before it was
+		 * added to the list, in which case its SIGCHLD went unnoticed. */
+		if (ret)
+			mono_w32process_signal_finished ();
+		goto free_strings;
+	}
+#endif
+
 	/* Create a pipe to make sure the child doesn't exit before
 	 * we can add the process to the linked list of processes */
 	if (pipe (startup_pipe) == -1) {
@@ -1906,58 +2053,8 @@ process_create (const gunichar2 *appname, const gunichar2 *cmdline,
 		break;
 	}
 	default: /* Parent */ {
-		MonoW32Handle *handle_data;
-		MonoW32HandleProcess process_handle;
-
-		memset (&process_handle, 0, sizeof (process_handle));
-		process_handle.pid = pid;
-		process_handle.child = TRUE;
-		process_handle.pname = g_strdup (prog);
-		process_set_defaults (&process_handle);
-
-		/* Add our process into the linked list of processes */
-		process = (Process *) g_malloc0 (sizeof (Process));
-		process->pid = pid;
-		process->handle_count = 1;
-		mono_coop_sem_init (&process->exit_sem, 0);
-
-		process_handle.process = process;
-
-		handle = mono_w32handle_new (MONO_W32TYPE_PROCESS, &process_handle);
-		if (handle == INVALID_HANDLE_VALUE) {
-			g_warning ("%s: error creating process handle", __func__);
-
-			mono_coop_sem_destroy (&process->exit_sem);
-			g_free (process);
-
-			mono_w32error_set_last (ERROR_OUTOFMEMORY);
-			ret = FALSE;
-			break;
-		}
-
-		if (!mono_w32handle_lookup_and_ref (handle, &handle_data))
-			g_error ("%s: unknown handle %p", __func__, handle);
-
-		if (handle_data->type != MONO_W32TYPE_PROCESS)
-			g_error ("%s: unknown process handle %p", __func__, handle);
-
-		/* Keep the process handle artificially alive until the process
-		 * exits so that the information in the handle isn't lost. */
-		process->handle = mono_w32handle_duplicate (handle_data);
-
-		mono_coop_mutex_lock (&processes_mutex);
-		process->next = processes;
-		mono_memory_barrier ();
-		processes = process;
-		mono_coop_mutex_unlock (&processes_mutex);
-
-		if (process_info != NULL) {
-			process_info->process_handle = handle;
-			process_info->pid = pid;
-		}
-
-		mono_w32handle_unref (handle_data);
-
+		handle = process_register (pid, prog, process_info);
+		ret = handle != NULL;
 		break;
 	}
 	}
@@ -84,6 +84,12 @@ mono_w32socket_sendto (SOCKET s, const char *buf, int len, int flags, const stru
 int
 mono_w32socket_sendbuffers (SOCKET s, LPWSABUF lpBuffers, guint32 dwBufferCount, guint32 *lpNumberOfBytesRecvd, guint32 lpFlags, gpointer lpOverlapped, gpointer lpCompletionRoutine, gboolean blocking);
 
+int
+mono_w32socket_recvmsgs (SOCKET s, LPWSABUF lpBuffers, guint32 dwBufferCount, gint32 *lengths, int flags, gboolean blocking);
+
+int
+mono_w32socket_sendmsgs (SOCKET s, LPWSABUF lpBuffers, guint32 dwBufferCount, int flags, gboolean blocking);
+
 #if G_HAVE_API_SUPPORT(HAVE_CLASSIC_WINAPI_SUPPORT | HAVE_UWP_WINAPI_SUPPORT)
 
 BOOL
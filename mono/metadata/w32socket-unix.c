@@ -574,8 +574,347 @@ mono_w32socket_sendbuffers (SOCKET sock, WSABUF *buffers, guint32 count, guint32
 	return 0;
 }
 
+/* Upper bound of the datagrams moved by one mono_w32socket_recvmsgs/sendmsgs call */
+#define MMSG_BATCH_MAX	64
+
+/*
+ * mono_w32socket_recvmsgs:
+ *
+ *   Receive up to @count datagrams, one into each of @buffers, and store their sizes
+ * into @lengths. Only the first one is waited for. Returns the number of datagrams
+ * received, or SOCKET_ERROR.
+ */
+int
+mono_w32socket_recvmsgs (SOCKET sock, WSABUF *buffers, guint32 count, gint32 *lengths, int flags, gboolean blocking)
+{
+	SocketHandle *sockethandle;
+	MonoThreadInfo *info;
+	gint ret;
+	guint32 i;
+#if defined(HAVE_RECVMMSG)
+	struct mmsghdr msgs [MMSG_BATCH_MAX];
+	struct iovec iovs [MMSG_BATCH_MAX];
+#endif
+
+	if (!mono_fdhandle_lookup_and_ref(sock, (MonoFDHandle**) &sockethandle)) {
+		mono_w32error_set_last (WSAENOTSOCK);
+		return SOCKET_ERROR;
+	}
+
+	if (((MonoFDHandle*) sockethandle)->type != MONO_FDTYPE_SOCKET) {
+		mono_fdhandle_unref ((MonoFDHandle*) sockethandle);
+		mono_w32error_set_last (WSAENOTSOCK);
+		return SOCKET_ERROR;
+	}
+
+	info = mono_thread_info_current ();
+
+	count = MIN (count, MMSG_BATCH_MAX);
+
+#if defined(HAVE_RECVMMSG)
+	memset (msgs, 0, count * sizeof (struct mmsghdr));
+	for (i = 0; i < count; i++) {
+		iovs [i].iov_base = buffers [i].buf;
+		iovs [i].iov_len = buffers [i].len;
+		msgs [i].msg_hdr.msg_iov = &iovs [i];
+		msgs [i].msg_hdr.msg_iovlen = 1;
+	}
+
+	do {
+		MONO_ENTER_GC_SAFE;
+		ret = recvmmsg (((MonoFDHandle*) sockethandle)->fd, msgs, count, flags | MSG_WAITFORONE, NULL);
+		MONO_EXIT_GC_SAFE;
+	} while (ret == -1 && errno == EINTR && !mono_thread_info_is_interrupt_state (info));
+
+	for (i = 0; ret > 0 && i < ret; i++)
+		lengths [i] = msgs [i].msg_len;
+#else
+	for (i = 0; i < count; i++) {
+		/* Only wait for the first datagram, like MSG_WAITFORONE */
+		do {
+			MONO_ENTER_GC_SAFE;
+			ret = recv (((MonoFDHandle*) sockethandle)->fd, buffers [i].buf, buffers [i].len, i == 0 ? flags : flags | MSG_DONTWAIT);
+			MONO_EXIT_GC_SAFE;
+		} while (ret == -1 && errno == EINTR && !mono_thread_info_is_interrupt_state (info));
+
+		if (ret == -1)
+			break;
+
+		lengths [i] = ret;
+	}
+
+	if (i > 0)
+		ret = i;
+#endif
+
+	if (ret == -1) {
+		gint errnum = errno;
+		mono_trace (G_LOG_LEVEL_DEBUG, MONO_TRACE_IO_LAYER_SOCKET, "%s: recvmmsg error: %s", __func__, g_strerror (errno));
+		mono_w32socket_set_last_error (mono_w32socket_convert_error (errnum));
+		mono_fdhandle_unref ((MonoFDHandle*) sockethandle);
+		return SOCKET_ERROR;
+	}
+
+	mono_fdhandle_unref ((MonoFDHandle*) sockethandle);
+	return ret;
+}
+
+/*
+ * mono_w32socket_sendmsgs:
+ *
+ *   Send each of the @count @buffers as its own datagram. Returns the number of
+ * datagrams sent, or SOCKET_ERROR if none could be.
+ */
+int
+mono_w32socket_sendmsgs (SOCKET sock, WSABUF *buffers, guint32 count, int flags, gboolean blocking)
+{
+	SocketHandle *sockethandle;
+	MonoThreadInfo *info;
+	gint ret;
+	guint32 i;
+#if defined(HAVE_SENDMMSG)
+	struct mmsghdr msgs [MMSG_BATCH_MAX];
+	struct iovec iovs [MMSG_BATCH_MAX];
+#endif
+
+	if (!mono_fdhandle_lookup_and_ref(sock, (MonoFDHandle**) &sockethandle)) {
+		mono_w32error_set_last (WSAENOTSOCK);
+		return SOCKET_ERROR;
+	}
+
+	if (((MonoFDHandle*) sockethandle)->type != MONO_FDTYPE_SOCKET) {
+		mono_fdhandle_unref ((MonoFDHandle*) sockethandle);
+		mono_w32error_set_last (WSAENOTSOCK);
+		return SOCKET_ERROR;
+	}
+
+	info = mono_thread_info_current ();
+
+	count = MIN (count, MMSG_BATCH_MAX);
+
+#if defined(HAVE_SENDMMSG)
+	memset (msgs, 0, count * sizeof (struct mmsghdr));
+	for (i = 0; i < count; i++) {
+		iovs [i].iov_base = buffers [i].buf;
+		iovs [i].iov_len = buffers [i].len;
+		msgs [i].msg_hdr.msg_iov = &iovs [i];
+		msgs [i].msg_hdr.msg_iovlen = 1;
+	}
+
+	do {
+		MONO_ENTER_GC_SAFE;
+		ret = sendmmsg (((MonoFDHandle*) sockethandle)->fd, msgs, count, flags);
+		MONO_EXIT_GC_SAFE;
+	} while (ret == -1 && errno == EINTR && !mono_thread_info_is_interrupt_state (info));
+#else
+	for (i = 0; i < count; i++) {
+		do {
+			MONO_ENTER_GC_SAFE;
+			ret = send (((MonoFDHandle*) sockethandle)->fd, buffers [i].buf, buffers [i].len, flags);
+			MONO_EXIT_GC_SAFE;
+		} while (ret == -1 && errno == EINTR && !mono_thread_info_is_interrupt_state (info));
+
+		if (ret == -1)
+			break;
+	}
+
+	if (i > 0)
+		ret = i;
+#endif
+
+	if (ret == -1) {
+		gint errnum = errno;
+		mono_trace (G_LOG_LEVEL_DEBUG, MONO_TRACE_IO_LAYER_SOCKET, "%s: sendmmsg error: %s", __func__, g_strerror (errno));
+		mono_w32socket_set_last_error (mono_w32socket_convert_error (errnum));
+		mono_fdhandle_unref ((MonoFDHandle*) sockethandle);
+		return SOCKET_ERROR;
+	}
+
+	mono_fdhandle_unref ((MonoFDHandle*) sockethandle);
+	return ret;
+}
+
 #define SF_BUFFER_SIZE	16384
 
+#if defined(HAVE_SENDFILE) && defined(__linux__)
+/* Upper bound of a single sendfile/splice call, the kernel caps it a bit below 2GB anyway */
+#define SF_CHUNK_SIZE	(1 << 30)
+#endif
+
+/*
+ * transmit_file_wait_writable:
+ *
+ *   Called when a send on @fd failed with EAGAIN. Non-blocking sockets are waited on
+ * until they are writable again, while on blocking sockets EAGAIN means the send timeout
+ * expired. Returns FALSE, with errno set, if the transfer should be aborted.
+ */
+static gboolean
+transmit_file_wait_writable (gint fd, MonoThreadInfo *info)
+{
+	mono_pollfd pfd;
+	gint ret;
+
+	MONO_ENTER_GC_SAFE;
+	ret = fcntl (fd, F_GETFL, 0);
+	MONO_EXIT_GC_SAFE;
+	if (ret == -1)
+		return FALSE;
+	if ((ret & O_NONBLOCK) == 0) {
+		mono_set_errno (ETIMEDOUT);
+		return FALSE;
+	}
+
+	pfd.fd = fd;
+	pfd.events = MONO_POLLOUT;
+	pfd.revents = 0;
+	do {
+		MONO_ENTER_GC_SAFE;
+		ret = mono_poll (&pfd, 1, -1);
+		MONO_EXIT_GC_SAFE;
+	} while (ret == -1 && errno == EINTR && !mono_thread_info_is_interrupt_state (info));
+
+	return ret != -1;
+}
+
+#if defined(HAVE_SENDFILE) && defined(__linux__)
+/*
+ * transmit_file_sendfile:
+ *
+ *   Send @file from its current position up to its end to the socket @fd, without copying
+ * it through user space. Returns -1 with errno set on failure, the file position is
+ * advanced past what was sent either way.
+ */
+static gssize
+transmit_file_sendfile (gint fd, gint file, MonoThreadInfo *info)
+{
+	gssize ret;
+
+	for (;;) {
+		MONO_ENTER_GC_SAFE;
+		ret = sendfile (fd, file, NULL, SF_CHUNK_SIZE);
+		MONO_EXIT_GC_SAFE;
+
+		if (ret == 0)
+			return 0;
+		if (ret > 0)
+			continue;
+		if (errno == EINTR && !mono_thread_info_is_interrupt_state (info))
+			continue;
+		if (errno == EAGAIN && transmit_file_wait_writable (fd, info))
+			continue;
+		return -1;
+	}
+}
+#endif
+
+#if defined(HAVE_SPLICE)
+/*
+ * transmit_file_splice:
+ *
+ *   Same as transmit_file_sendfile, for files sendfile doesn't support: the data is moved
+ * into a pipe and from there to the socket, still without copying it through user space.
+ */
+static gssize
+transmit_file_splice (gint fd, gint file, MonoThreadInfo *info)
+{
+	gint pipes [2];
+	gssize ret, in_pipe;
+	gint errnum;
+
+	if (pipe (pipes) == -1)
+		return -1;
+
+	for (;;) {
+		do {
+			MONO_ENTER_GC_SAFE;
+			ret = splice (file, NULL, pipes [1], NULL, SF_CHUNK_SIZE, SPLICE_F_MOVE);
+			MONO_EXIT_GC_SAFE;
+		} while (ret == -1 && errno == EINTR && !mono_thread_info_is_interrupt_state (info));
+
+		if (ret <= 0)
+			break;
+
+		for (in_pipe = ret; in_pipe > 0;) {
+			MONO_ENTER_GC_SAFE;
+			ret = splice (pipes [0], NULL, fd, NULL, in_pipe, SPLICE_F_MOVE | SPLICE_F_MORE);
+			MONO_EXIT_GC_SAFE;
+
+			if (ret > 0)
+				in_pipe -= ret;
+			else if (ret == -1 && errno == EINTR && !mono_thread_info_is_interrupt_state (info))
+				continue;
+			else if (ret == -1 && errno == EAGAIN && transmit_file_wait_writable (fd, info))
+				continue;
+			else
+				break;
+		}
+
+		if (in_pipe > 0) {
+			ret = -1;
+			break;
+		}
+	}
+
+	errnum = errno;
+	close (pipes [0]);
+	close (pipes [1]);
+	mono_set_errno (errnum);
+
+	return ret;
+}
+#endif
+
+/*
+ * transmit_file_copy:
+ *
+ *   Same as transmit_file_sendfile, by reading the file into a buffer and sending it.
+ */
+static gssize
+transmit_file_copy (gint fd, gint file, MonoThreadInfo *info)
+{
+	gpointer buffer;
+	gssize ret, offset;
+
+	buffer = g_malloc (SF_BUFFER_SIZE);
+
+	for (;;) {
+		do {
+			MONO_ENTER_GC_SAFE;
+			ret = read (file, buffer, SF_BUFFER_SIZE);
+			MONO_EXIT_GC_SAFE;
+		} while (ret == -1 && errno == EINTR && !mono_thread_info_is_interrupt_state (info));
+
+		if (ret <= 0)
+			break;
+
+		for (offset = 0; offset < ret;) {
+			gssize sent;
+
+			MONO_ENTER_GC_SAFE;
+			sent = send (fd, (char *)buffer + offset, ret - offset, 0);
+			MONO_EXIT_GC_SAFE;
+
+			if (sent >= 0)
+				offset += sent;
+			else if (errno == EINTR && !mono_thread_info_is_interrupt_state (info))
+				continue;
+			else if (errno == EAGAIN && transmit_file_wait_writable (fd, info))
+				continue;
+			else
+				break;
+		}
+
+		if (offset < ret) {
+			ret = -1;
+			break;
+		}
+	}
+
+	g_free (buffer);
+
+	return ret;
+}
+
 BOOL
 mono_w32socket_transmit_file (SOCKET sock, gpointer file_handle, TRANSMIT_FILE_BUFFERS *buffers, guint32 flags, gboolean blocking)
 {
@@ -583,10 +922,8 @@ mono_w32socket_transmit_file (SOCKET sock, gpointer file_handle, TRANSMIT_FILE_B
 	SocketHandle *sockethandle;
 	gint file;
 	gssize ret;
-#if defined(HAVE_SENDFILE) && (defined(__linux__) || defined(DARWIN))
+#if defined(HAVE_SENDFILE) && defined(DARWIN)
 	struct stat statbuf;
-#else
-	gpointer buffer;
 #endif
 
 	if (!mono_fdhandle_lookup_and_ref(sock, (MonoFDHandle**) &sockethandle)) {
@@ -600,9 +937,13 @@ mono_w32socket_transmit_file (SOCKET sock, gpointer file_handle, TRANSMIT_FILE_B
 		return FALSE;
 	}
 
-	/* Write the header */
+	/* Write the header, MSG_MORE lets the kernel coalesce it with the first part of the file */
 	if (buffers != NULL && buffers->Head != NULL && buffers->HeadLength > 0) {
+#ifdef MSG_MORE
+		ret = mono_w32socket_send (((MonoFDHandle*) sockethandle)->fd, buffers->Head, buffers->HeadLength, MSG_MORE, FALSE);
+#else
 		ret = mono_w32socket_send (((MonoFDHandle*) sockethandle)->fd, buffers->Head, buffers->HeadLength, 0, FALSE);
+#endif
 		if (ret == SOCKET_ERROR) {
 			mono_fdhandle_unref ((MonoFDHandle*) sockethandle);
 			return FALSE;
@@ -613,7 +954,16 @@ mono_w32socket_transmit_file (SOCKET sock, gpointer file_handle, TRANSMIT_FILE_B
 
 	file = GPOINTER_TO_INT (file_handle);
 
-#if defined(HAVE_SENDFILE) && (defined(__linux__) || defined(DARWIN))
+#if defined(HAVE_SENDFILE) && defined(__linux__)
+	ret = transmit_file_sendfile (((MonoFDHandle*) sockethandle)->fd, file, info);
+#if defined(HAVE_SPLICE)
+	/* sendfile only supports files which can be mmapped */
+	if (ret == -1 && (errno == EINVAL || errno == ENOSYS))
+		ret = transmit_file_splice (((MonoFDHandle*) sockethandle)->fd, file, info);
+#endif
+	if (ret == -1 && (errno == EINVAL || errno == ENOSYS))
+		ret = transmit_file_copy (((MonoFDHandle*) sockethandle)->fd, file, info);
+#elif defined(HAVE_SENDFILE) && defined(DARWIN)
 	MONO_ENTER_GC_SAFE;
 	ret = fstat (file, &statbuf);
 	MONO_EXIT_GC_SAFE;
@@ -626,36 +976,13 @@ mono_w32socket_transmit_file (SOCKET sock, gpointer file_handle, TRANSMIT_FILE_B
 
 	do {
 		MONO_ENTER_GC_SAFE;
-#ifdef __linux__
-		ret = sendfile (((MonoFDHandle*) sockethandle)->fd, file, NULL, statbuf.st_size);
-#elif defined(DARWIN)
 		/* TODO: header/tail could be sent in the 5th argument */
 		/* TODO: Might not send the entire file for non-blocking sockets */
 		ret = sendfile (file, ((MonoFDHandle*) sockethandle)->fd, 0, &statbuf.st_size, NULL, 0);
-#endif
 		MONO_EXIT_GC_SAFE;
-	} while (ret != -1 && errno == EINTR && !mono_thread_info_is_interrupt_state (info));
+	} while (ret == -1 && errno == EINTR && !mono_thread_info_is_interrupt_state (info));
 #else
-	buffer = g_malloc (SF_BUFFER_SIZE);
-
-	do {
-		do {
-			MONO_ENTER_GC_SAFE;
-			ret = read (file, buffer, SF_BUFFER_SIZE);
-			MONO_EXIT_GC_SAFE;
-		} while (ret == -1 && errno == EINTR && !mono_thread_info_is_interrupt_state (info));
-
-		if (ret == -1 || ret == 0)
-			break;
-
-		do {
-			MONO_ENTER_GC_SAFE;
-			ret = send (((MonoFDHandle*) sockethandle)->fd, buffer, ret, 0); /* short sends? enclose this in a loop? */
-			MONO_EXIT_GC_SAFE;
-		} while (ret == -1 && errno == EINTR && !mono_thread_info_is_interrupt_state (info));
-	} while (ret != -1 && errno == EINTR && !mono_thread_info_is_interrupt_state (info));
-
-	g_free (buffer);
+	ret = transmit_file_copy (((MonoFDHandle*) sockethandle)->fd, file, info);
 #endif
 
 	if (ret == -1) {
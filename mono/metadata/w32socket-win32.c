@@ -125,6 +125,31 @@ int mono_w32socket_sendbuffers (SOCKET s, WSABUF *lpBuffers, guint32 dwBufferCou
 	return ret;
 }
 
+/* Winsock has no batched datagram calls, receive a single one */
+int mono_w32socket_recvmsgs (SOCKET s, WSABUF *lpBuffers, guint32 dwBufferCount, gint32 *lengths, int flags, gboolean blocking)
+{
+	int ret = SOCKET_ERROR;
+	if (dwBufferCount == 0)
+		return 0;
+	INTERRUPTABLE_SOCKET_CALL (blocking, ret, recv, s, lpBuffers [0].buf, lpBuffers [0].len, flags);
+	if (ret == SOCKET_ERROR)
+		return SOCKET_ERROR;
+	lengths [0] = ret;
+	return 1;
+}
+
+int mono_w32socket_sendmsgs (SOCKET s, WSABUF *lpBuffers, guint32 dwBufferCount, int flags, gboolean blocking)
+{
+	int ret = SOCKET_ERROR;
+	guint32 i;
+	for (i = 0; i < dwBufferCount; i++) {
+		INTERRUPTABLE_SOCKET_CALL (blocking, ret, send, s, lpBuffers [i].buf, lpBuffers [i].len, flags);
+		if (ret == SOCKET_ERROR)
+			return i > 0 ? (int)i : SOCKET_ERROR;
+	}
+	return i;
+}
+
 #if G_HAVE_API_SUPPORT(HAVE_CLASSIC_WINAPI_SUPPORT | HAVE_UWP_WINAPI_SUPPORT)
 static gint
 internal_w32socket_transmit_file (SOCKET sock, gpointer file, TRANSMIT_FILE_BUFFERS *lpTransmitBuffers, guint32 dwReserved, gboolean blocking)
@@ -1422,6 +1422,30 @@ ves_icall_System_Net_Sockets_Socket_Receive_array_internal (gsize sock, WSABUF *
 	return recv;
 }
 
+gint32
+ves_icall_System_Net_Sockets_Socket_ReceiveMessages_internal (gsize sock, WSABUF *buffers, gint32 count, gint32 *lengths, gint32 flags, gint32 *werror, MonoBoolean blocking, MonoError *error)
+{
+	int ret;
+	int recvflags = 0;
+
+	error_init (error);
+	*werror = 0;
+
+	recvflags = convert_socketflags (flags);
+	if (recvflags == -1) {
+		*werror = WSAEOPNOTSUPP;
+		return 0;
+	}
+
+	ret = mono_w32socket_recvmsgs (sock, buffers, count, lengths, recvflags, blocking);
+	if (ret == SOCKET_ERROR) {
+		*werror = mono_w32socket_get_last_error ();
+		return 0;
+	}
+
+	return ret;
+}
+
 gint32
 ves_icall_System_Net_Sockets_Socket_ReceiveFrom_internal (gsize sock, gchar *buffer, gint32 count, gint32 flags, MonoObjectHandleInOut sockaddr, gint32 *werror, MonoBoolean blocking, MonoError *error)
 {
@@ -1522,6 +1546,30 @@ ves_icall_System_Net_Sockets_Socket_Send_array_internal (gsize sock, WSABUF *buf
 	return sent;
 }
 
+gint32
+ves_icall_System_Net_Sockets_Socket_SendMessages_internal (gsize sock, WSABUF *buffers, gint32 count, gint32 flags, gint32 *werror, MonoBoolean blocking, MonoError *error)
+{
+	int ret;
+	int sendflags = 0;
+
+	error_init (error);
+	*werror = 0;
+
+	sendflags = convert_socketflags (flags);
+	if (sendflags == -1) {
+		*werror = WSAEOPNOTSUPP;
+		return 0;
+	}
+
+	ret = mono_w32socket_sendmsgs (sock, buffers, count, sendflags, blocking);
+	if (ret == SOCKET_ERROR) {
+		*werror = mono_w32socket_get_last_error ();
+		return 0;
+	}
+
+	return ret;
+}
+
 gint32
 ves_icall_System_Net_Sockets_Socket_SendTo_internal (gsize sock, gchar *buffer, gint32 count, gint32 flags, MonoObjectHandle sockaddr, gint32 *werror, MonoBoolean blocking, MonoError *error)
 {
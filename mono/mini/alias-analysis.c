@@ -368,10 +368,471 @@ TODO:
 	SRVT of small types can fix cases of mismatch for fields of a different type than the component.
 	Handle aliasing of byrefs in call conventions.
 */
+/*
+ * Scalar replacement of objects allocated by newobj which don't escape the method:
+ * if the object reference is only used as the base of field loads and stores, the
+ * fields are turned into vregs and the allocation is removed.
+ */
+
+enum {
+	SCALAR_INT,
+	SCALAR_LONG,
+	SCALAR_PTR,
+	SCALAR_R8,
+	SCALAR_R4
+};
+
+typedef struct {
+	int offset, size, kind;
+	int vreg;
+	gboolean is_ref;
+} ScalarField;
+
+static gboolean
+get_scalar_access (MonoCompile *cfg, MonoInst *ins, int *size, int *kind)
+{
+	switch (ins->opcode) {
+	case OP_LOADI1_MEMBASE:
+	case OP_LOADU1_MEMBASE:
+	case OP_STOREI1_MEMBASE_REG:
+	case OP_STOREI1_MEMBASE_IMM:
+		*size = 1;
+		*kind = SCALAR_INT;
+		return TRUE;
+	case OP_LOADI2_MEMBASE:
+	case OP_LOADU2_MEMBASE:
+	case OP_STOREI2_MEMBASE_REG:
+	case OP_STOREI2_MEMBASE_IMM:
+		*size = 2;
+		*kind = SCALAR_INT;
+		return TRUE;
+	case OP_LOADI4_MEMBASE:
+	case OP_LOADU4_MEMBASE:
+	case OP_STOREI4_MEMBASE_REG:
+	case OP_STOREI4_MEMBASE_IMM:
+		*size = 4;
+		*kind = SCALAR_INT;
+		return TRUE;
+#if SIZEOF_REGISTER == 8
+	case OP_LOADI8_MEMBASE:
+	case OP_STOREI8_MEMBASE_REG:
+	case OP_STOREI8_MEMBASE_IMM:
+		*size = 8;
+		*kind = SCALAR_LONG;
+		return TRUE;
+#endif
+	case OP_LOAD_MEMBASE:
+	case OP_STORE_MEMBASE_REG:
+	case OP_STORE_MEMBASE_IMM:
+		*size = TARGET_SIZEOF_VOID_P;
+		*kind = SCALAR_PTR;
+		return TRUE;
+	case OP_LOADR8_MEMBASE:
+	case OP_STORER8_MEMBASE_REG:
+		*size = 8;
+		*kind = SCALAR_R8;
+		return TRUE;
+	case OP_LOADR4_MEMBASE:
+	case OP_STORER4_MEMBASE_REG:
+		/* Without r4fp, these convert to/from double */
+		if (!cfg->r4fp)
+			return FALSE;
+		*size = 4;
+		*kind = SCALAR_R4;
+		return TRUE;
+	default:
+		return FALSE;
+	}
+}
+
+static gboolean
+is_scalar_candidate_var (MonoCompile *cfg, int vreg)
+{
+	MonoInst *var = get_vreg_to_inst (cfg, vreg);
+
+	if (!var)
+		return TRUE;
+	if (var->opcode == OP_ARG || var == cfg->ret || var == cfg->vret_addr)
+		return FALSE;
+	return !(var->flags & (MONO_INST_VOLATILE | MONO_INST_INDIRECT));
+}
+
+static gboolean
+bb_in_cycle (MonoCompile *cfg, MonoBasicBlock *target)
+{
+	MonoBasicBlock **stack = g_new (MonoBasicBlock*, cfg->num_bblocks);
+	gboolean *visited = g_new0 (gboolean, cfg->num_bblocks);
+	gboolean found = FALSE;
+	int i, sp = 0;
+
+	for (i = 0; i < target->out_count; ++i)
+		stack [sp++] = target->out_bb [i];
+	while (sp > 0 && !found) {
+		MonoBasicBlock *bb = stack [--sp];
+
+		if (bb == target) {
+			found = TRUE;
+			break;
+		}
+		if (visited [bb->block_num])
+			continue;
+		visited [bb->block_num] = TRUE;
+		for (i = 0; i < bb->out_count; ++i) {
+			if (!visited [bb->out_bb [i]->block_num])
+				stack [sp++] = bb->out_bb [i];
+		}
+	}
+	g_free (stack);
+	g_free (visited);
+	return found;
+}
+
+static gboolean
+call_uses_addrs (GHashTable *addrs, GSList *l)
+{
+	for (; l; l = l->next) {
+		guint32 regpair = (guint32)(gssize)(l->data);
+
+		if (g_hash_table_lookup (addrs, GINT_TO_POINTER (regpair & 0xffffff)))
+			return TRUE;
+	}
+	return FALSE;
+}
+
+static ScalarField*
+record_scalar_access (MonoCompile *cfg, GHashTable *fields, MonoClass *klass, int offset, int size, int kind)
+{
+	ScalarField *field;
+	GHashTableIter iter;
+
+	if (offset < MONO_ABI_SIZEOF (MonoObject) || offset + size > mono_class_instance_size (klass))
+		return NULL;
+
+	field = (ScalarField *)g_hash_table_lookup (fields, GINT_TO_POINTER (offset));
+	if (field)
+		return (field->size == size && field->kind == kind) ? field : NULL;
+
+	/* Overlapping accesses, i.e. explicit layout */
+	g_hash_table_iter_init (&iter, fields);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer*)&field)) {
+		if (offset < field->offset + field->size && field->offset < offset + size)
+			return NULL;
+	}
+
+	field = (ScalarField *)mono_mempool_alloc0 (cfg->mempool, sizeof (ScalarField));
+	field->offset = offset;
+	field->size = size;
+	field->kind = kind;
+	g_hash_table_insert (fields, GINT_TO_POINTER (offset), field);
+	return field;
+}
+
+static void
+emit_scalar_zero (MonoCompile *cfg, MonoInst *ins, ScalarField *field)
+{
+	ins->dreg = field->vreg;
+	switch (field->kind) {
+#if SIZEOF_REGISTER == 8
+	case SCALAR_LONG:
+	case SCALAR_PTR:
+		ins->opcode = OP_I8CONST;
+		ins->type = field->kind == SCALAR_LONG ? STACK_I8 : (field->is_ref ? STACK_OBJ : STACK_PTR);
+		ins->inst_l = 0;
+		break;
+#else
+	case SCALAR_PTR:
+		ins->opcode = OP_ICONST;
+		ins->type = field->is_ref ? STACK_OBJ : STACK_PTR;
+		ins->inst_c0 = 0;
+		break;
+#endif
+	case SCALAR_R8: {
+		double *d = (double *)mono_mempool_alloc0 (cfg->mempool, sizeof (double));
+		ins->opcode = OP_R8CONST;
+		ins->type = STACK_R8;
+		ins->inst_p0 = d;
+		break;
+	}
+	case SCALAR_R4: {
+		float *f = (float *)mono_mempool_alloc0 (cfg->mempool, sizeof (float));
+		ins->opcode = OP_R4CONST;
+		ins->type = STACK_R4;
+		ins->inst_p0 = f;
+		break;
+	}
+	default:
+		ins->opcode = OP_ICONST;
+		ins->type = STACK_I4;
+		ins->inst_c0 = 0;
+		break;
+	}
+}
+
+static int
+scalar_load_op (int opcode, int kind)
+{
+	switch (opcode) {
+	case OP_LOADI1_MEMBASE:
+		return OP_ICONV_TO_I1;
+	case OP_LOADU1_MEMBASE:
+		return OP_ICONV_TO_U1;
+	case OP_LOADI2_MEMBASE:
+		return OP_ICONV_TO_I2;
+	case OP_LOADU2_MEMBASE:
+		return OP_ICONV_TO_U2;
+#if SIZEOF_REGISTER == 8
+	/* The 4 byte loads extend to the full register, the stored vreg might not be */
+	case OP_LOADI4_MEMBASE:
+		return OP_SEXT_I4;
+	case OP_LOADU4_MEMBASE:
+		return OP_ZEXT_I4;
+#endif
+	default:
+		break;
+	}
+	if (kind == SCALAR_R8)
+		return OP_FMOVE;
+	if (kind == SCALAR_R4)
+		return OP_RMOVE;
+	return OP_MOVE;
+}
+
+static gboolean
+scalar_replace_alloc (MonoCompile *cfg, MonoInst *alloc, int *defs)
+{
+	MonoBasicBlock *bb, *alloc_bb = NULL;
+	MonoInst *ins;
+	MonoClass *klass = alloc->klass;
+	GHashTable *addrs, *fields;
+	GHashTableIter iter;
+	ScalarField *field;
+	gboolean changed, res = FALSE;
+	int sregs [MONO_MAX_SRC_REGS];
+	int i, num_sregs, size, kind;
+
+	if (defs [alloc->dreg] != 1 || !is_scalar_candidate_var (cfg, alloc->dreg))
+		return FALSE;
+
+	/* Maps the vregs holding the object or an interior pointer to their offset + 1 */
+	addrs = g_hash_table_new (NULL, NULL);
+	fields = g_hash_table_new (NULL, NULL);
+	g_hash_table_insert (addrs, GINT_TO_POINTER (alloc->dreg), GINT_TO_POINTER (1));
+
+	do {
+		changed = FALSE;
+		for (bb = cfg->bb_entry; bb; bb = bb->next_bb) {
+			MONO_BB_FOR_EACH_INS (bb, ins) {
+				gpointer offset;
+
+				if (ins == alloc)
+					alloc_bb = bb;
+				if (ins->opcode != OP_MOVE && ins->opcode != OP_PADD_IMM)
+					continue;
+				offset = g_hash_table_lookup (addrs, GINT_TO_POINTER (ins->sreg1));
+				if (!offset || g_hash_table_lookup (addrs, GINT_TO_POINTER (ins->dreg)))
+					continue;
+				if (defs [ins->dreg] != 1 || !is_scalar_candidate_var (cfg, ins->dreg))
+					goto fail;
+				if (ins->opcode == OP_PADD_IMM)
+					offset = GINT_TO_POINTER (GPOINTER_TO_INT (offset) + ins->inst_imm);
+				g_hash_table_insert (addrs, GINT_TO_POINTER (ins->dreg), offset);
+				changed = TRUE;
+			}
+		}
+	} while (changed);
+
+	if (!alloc_bb || bb_in_cycle (cfg, alloc_bb))
+		goto fail;
+
+	/* Check that every use of the object is a field access */
+	for (bb = cfg->bb_entry; bb; bb = bb->next_bb) {
+		MONO_BB_FOR_EACH_INS (bb, ins) {
+			gpointer offset;
+
+			if (ins == alloc)
+				continue;
+			if (MONO_IS_CALL (ins)) {
+				MonoCallInst *call = (MonoCallInst *)ins;
+
+				if (call_uses_addrs (addrs, call->out_ireg_args) || call_uses_addrs (addrs, call->out_freg_args))
+					goto fail;
+			}
+
+			switch (ins->opcode) {
+			case OP_MOVE:
+			case OP_PADD_IMM:
+			case OP_NOT_NULL:
+			case OP_CHECK_THIS:
+			case OP_DUMMY_USE:
+				continue;
+			case OP_CARD_TABLE_WBARRIER:
+				if (g_hash_table_lookup (addrs, GINT_TO_POINTER (ins->sreg2)))
+					goto fail;
+				continue;
+			default:
+				break;
+			}
+
+			if (MONO_IS_LOAD_MEMBASE (ins) && (offset = g_hash_table_lookup (addrs, GINT_TO_POINTER (ins->sreg1)))) {
+				if (!get_scalar_access (cfg, ins, &size, &kind))
+					goto fail;
+				field = record_scalar_access (cfg, fields, klass, GPOINTER_TO_INT (offset) - 1 + ins->inst_offset, size, kind);
+				if (!field)
+					goto fail;
+				if (vreg_is_ref (cfg, ins->dreg))
+					field->is_ref = TRUE;
+				continue;
+			}
+			if (MONO_IS_STORE_MEMBASE (ins) && (offset = g_hash_table_lookup (addrs, GINT_TO_POINTER (ins->dreg)))) {
+				if (!get_scalar_access (cfg, ins, &size, &kind))
+					goto fail;
+				field = record_scalar_access (cfg, fields, klass, GPOINTER_TO_INT (offset) - 1 + ins->inst_offset, size, kind);
+				if (!field)
+					goto fail;
+				num_sregs = mono_inst_get_src_registers (ins, sregs);
+				if (num_sregs && g_hash_table_lookup (addrs, GINT_TO_POINTER (ins->sreg1)))
+					goto fail;
+				if (num_sregs && vreg_is_ref (cfg, ins->sreg1))
+					field->is_ref = TRUE;
+				continue;
+			}
+
+			if (MONO_IS_STORE_MEMBASE (ins) && g_hash_table_lookup (addrs, GINT_TO_POINTER (ins->dreg)))
+				goto fail;
+			num_sregs = mono_inst_get_src_registers (ins, sregs);
+			for (i = 0; i < num_sregs; ++i) {
+				if (g_hash_table_lookup (addrs, GINT_TO_POINTER (sregs [i])))
+					goto fail;
+			}
+		}
+	}
+
+	if (cfg->verbose_level > 2) {
+		printf ("Scalar replacing allocation of %s: ", m_class_get_name (klass));
+		mono_print_ins (alloc);
+	}
+
+	/* Allocate the field vregs, zero initialized at the allocation point */
+	g_hash_table_iter_init (&iter, fields);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer*)&field)) {
+		switch (field->kind) {
+		case SCALAR_INT:
+			field->vreg = alloc_ireg (cfg);
+			break;
+		case SCALAR_LONG:
+			field->vreg = alloc_lreg (cfg);
+			break;
+		case SCALAR_PTR:
+			field->vreg = field->is_ref ? alloc_ireg_ref (cfg) : alloc_preg (cfg);
+			break;
+		default:
+			field->vreg = alloc_freg (cfg);
+			break;
+		}
+		MONO_INST_NEW (cfg, ins, OP_NOP);
+		emit_scalar_zero (cfg, ins, field);
+		mono_bblock_insert_after_ins (alloc_bb, alloc, ins);
+	}
+
+	for (bb = cfg->bb_entry; bb; bb = bb->next_bb) {
+		MONO_BB_FOR_EACH_INS (bb, ins) {
+			gpointer offset;
+
+			switch (ins->opcode) {
+			case OP_MOVE:
+			case OP_PADD_IMM:
+			case OP_NOT_NULL:
+			case OP_CHECK_THIS:
+			case OP_DUMMY_USE:
+			case OP_CARD_TABLE_WBARRIER:
+				if (g_hash_table_lookup (addrs, GINT_TO_POINTER (ins->sreg1)))
+					NULLIFY_INS (ins);
+				continue;
+			default:
+				break;
+			}
+
+			if (MONO_IS_LOAD_MEMBASE (ins) && (offset = g_hash_table_lookup (addrs, GINT_TO_POINTER (ins->sreg1)))) {
+				field = (ScalarField *)g_hash_table_lookup (fields, GINT_TO_POINTER (GPOINTER_TO_INT (offset) - 1 + ins->inst_offset));
+				ins->opcode = scalar_load_op (ins->opcode, field->kind);
+				ins->sreg1 = field->vreg;
+				ins->flags &= ~MONO_INST_FAULT;
+				mono_atomic_inc_i32 (&mono_jit_stats.loads_eliminated);
+			} else if (MONO_IS_STORE_MEMBASE (ins) && (offset = g_hash_table_lookup (addrs, GINT_TO_POINTER (ins->dreg)))) {
+				field = (ScalarField *)g_hash_table_lookup (fields, GINT_TO_POINTER (GPOINTER_TO_INT (offset) - 1 + ins->inst_offset));
+				if (mono_inst_get_num_src_registers (ins)) {
+					ins->opcode = field->kind == SCALAR_R8 ? OP_FMOVE : (field->kind == SCALAR_R4 ? OP_RMOVE : OP_MOVE);
+					ins->dreg = field->vreg;
+				} else {
+					target_mgreg_t imm = ins->inst_imm;
+
+					emit_scalar_zero (cfg, ins, field);
+#if SIZEOF_REGISTER == 8
+					if (ins->opcode == OP_I8CONST)
+						ins->inst_l = imm;
+					else
+#endif
+						ins->inst_c0 = imm;
+				}
+				ins->flags &= ~MONO_INST_FAULT;
+				mono_atomic_inc_i32 (&mono_jit_stats.stores_eliminated);
+			}
+		}
+	}
+
+	NULLIFY_INS (alloc);
+	res = TRUE;
+
+fail:
+	g_hash_table_destroy (addrs);
+	g_hash_table_destroy (fields);
+	return res;
+}
+
+static void
+scalar_replace_allocs (MonoCompile *cfg)
+{
+	MonoBasicBlock *bb;
+	MonoInst *ins;
+	GSList *l;
+	int *defs;
+	gboolean changed = FALSE;
+
+	/* The field vregs would have to be volatile inside protected regions */
+	if (cfg->header->num_clauses)
+		return;
+
+	defs = g_new0 (int, cfg->next_vreg);
+	for (bb = cfg->bb_entry; bb; bb = bb->next_bb) {
+		MONO_BB_FOR_EACH_INS (bb, ins) {
+			const char *spec = INS_INFO (ins->opcode);
+
+			if (spec [MONO_INST_DEST] != ' ' && !MONO_IS_STORE_MEMBASE (ins))
+				defs [ins->dreg]++;
+		}
+	}
+
+	for (l = cfg->object_allocs; l; l = l->next) {
+		if (scalar_replace_alloc (cfg, (MonoInst *)l->data, defs))
+			changed = TRUE;
+	}
+	g_free (defs);
+
+	if (changed) {
+		mono_handle_global_vregs (cfg);
+		if (cfg->opt & MONO_OPT_DEADCE)
+			mono_local_deadce (cfg);
+	}
+}
+
 void
 mono_local_alias_analysis (MonoCompile *cfg)
 {
 	int i, restored_vars = 1;
+
+	if (cfg->object_allocs)
+		scalar_replace_allocs (cfg);
+
 	if (!cfg->has_indirection)
 		return;
 
@@ -55,6 +55,7 @@
 #include <mono/utils/mono-time.h>
 #include <mono/utils/mono-mmap.h>
 #include <mono/utils/mono-rand.h>
+#include <mono/utils/mono-proclib.h>
 #include <mono/utils/json.h>
 #include <mono/utils/mono-threads-coop.h>
 #include <mono/profiler/aot.h>
@@ -204,6 +205,9 @@ typedef struct MonoAotOptions {
 	// The name of the assembly for which the AOT module is going to have all deduped methods moved to. 
 	// When set, we are emitting inflated methods only
 	char *dedup_include; 
+	// Set together with dedup_include: the other assemblies are emitted in the same run,
+	// with their dedupable methods skipped, so no .dedup cache files are needed
+	gboolean dedup_auto;
 	gboolean gnu_asm;
 	gboolean try_llvm;
 	gboolean llvm;
@@ -235,6 +239,7 @@ typedef struct MonoAotOptions {
 	gboolean no_opt;
 	char *clangxx;
 	char *depfile;
+	gboolean incremental;
 } MonoAotOptions;
 
 typedef enum {
@@ -257,6 +262,7 @@ typedef struct MonoAotStats {
 	int method_ref_count, method_ref_size;
 	int class_ref_count, class_ref_size;
 	int ginst_count, ginst_size;
+	int outlined_class_inits, outlined_wbarriers;
 } MonoAotStats;
 
 typedef struct GotInfo {
@@ -329,6 +335,10 @@ typedef struct MonoAotCompile {
 	int method_index;
 	char *static_linking_symbol;
 	mono_mutex_t mutex;
+	/* Work queue of the compile threads, protected by mutex */
+	int compile_queue_index;
+	int compile_queue_active;
+	mono_cond_t compile_queue_cond;
 	gboolean gas_line_numbers;
 	/* Whenever to emit an object file directly from llc */
 	gboolean llvm_owriter;
@@ -378,6 +388,8 @@ typedef struct MonoAotCompile {
 	GHashTable *objc_selector_to_index;
 	GList *profile_data;
 	GHashTable *profile_methods;
+	/* Maps methods seen by the AOT profiler to the order they were first executed in, plus one */
+	GHashTable *profile_method_order;
 #ifdef EMIT_WIN32_UNWIND_INFO
 	GList *unwind_info_section_cache;
 #endif
@@ -388,6 +400,8 @@ typedef struct MonoAotCompile {
 	int gc_name_offset;
 	// In this mode, we are emitting dedupable methods that we encounter
 	gboolean dedup_emit_mode;
+	/* Identifies the compiler configuration in incremental mode */
+	char *incremental_key;
 } MonoAotCompile;
 
 typedef struct {
@@ -435,6 +449,12 @@ get_patch_name (int info)
 static int
 emit_aot_image (MonoAotCompile *acfg);
 
+static char*
+get_incremental_key (MonoAotCompile *acfg, const char *aot_options);
+
+static gboolean
+is_aot_image_up_to_date (MonoAotCompile *acfg);
+
 static void 
 mono_flush_method_cache (MonoAotCompile *acfg);
 
@@ -453,6 +473,9 @@ add_gsharedvt_wrappers (MonoAotCompile *acfg, MonoMethodSignature *sig, gboolean
 static void
 add_profile_instances (MonoAotCompile *acfg, ProfileData *data);
 
+static void
+order_methods_by_profile (MonoAotCompile *acfg);
+
 static inline gboolean
 ignore_cfg (MonoCompile *cfg)
 {
@@ -4416,6 +4439,56 @@ cleanup_true:
 	return TRUE;
 }
 
+/*
+ * add_pinvoke_signature_wrappers:
+ *
+ *   Add the marshalling wrappers reachable from the signature of the pinvoke METHOD,
+ * so the runtime finds them in the wrapper caches instead of emitting IL for them.
+ * Delegates passed to or returned from native code need the wrappers used by
+ * mono_ftnptr_to_delegate (), and structs from other images are not covered by the
+ * typedef loop in add_wrappers ().
+ */
+static void
+add_pinvoke_signature_wrappers (MonoAotCompile *acfg, MonoMethod *method)
+{
+	MonoMethodSignature *sig = mono_method_signature_internal (method);
+	int i;
+
+	if (!sig)
+		return;
+
+	for (i = -1; i < sig->param_count; ++i) {
+		MonoType *t = i == -1 ? sig->ret : sig->params [i];
+		MonoClass *klass;
+
+		if (t->type != MONO_TYPE_CLASS && t->type != MONO_TYPE_VALUETYPE && t->type != MONO_TYPE_GENERICINST)
+			continue;
+
+		klass = mono_class_from_mono_type_internal (t);
+		if (mono_class_is_gtd (klass) || mono_class_is_open_constructed_type (m_class_get_byval_arg (klass)))
+			continue;
+
+		if (m_class_is_delegate (klass)) {
+			MonoMethod *invoke, *wrapper;
+
+			if (klass == mono_defaults.delegate_class || klass == mono_defaults.multicastdelegate_class)
+				continue;
+
+			/* Same as in add_wrappers (), for the delegate types which lack the attribute or live elsewhere */
+			invoke = mono_get_delegate_invoke_internal (klass);
+			if (!invoke)
+				continue;
+			wrapper = mono_marshal_get_native_func_wrapper_aot (klass);
+			add_method (acfg, wrapper);
+			add_method (acfg, mono_marshal_get_delegate_invoke_internal (invoke, FALSE, TRUE, wrapper));
+		} else if (m_class_is_valuetype (klass) && !m_class_is_enumtype (klass) &&
+			m_class_get_image (klass) != acfg->image && can_marshal_struct (klass)) {
+			add_method (acfg, mono_marshal_get_struct_to_ptr (klass));
+			add_method (acfg, mono_marshal_get_ptr_to_struct (klass));
+		}
+	}
+}
+
 static void
 add_wrappers (MonoAotCompile *acfg)
 {
@@ -4823,6 +4896,9 @@ add_wrappers (MonoAotCompile *acfg)
 			add_method (acfg, mono_marshal_get_native_wrapper (method, TRUE, TRUE));
 		}
 
+		if (method->flags & METHOD_ATTRIBUTE_PINVOKE_IMPL)
+			add_pinvoke_signature_wrappers (acfg, method);
+
 		if (method->iflags & METHOD_IMPL_ATTRIBUTE_INTERNAL_CALL) {
 			if (acfg->aot_opts.llvm_only) {
 				/* The wrappers have a different signature (hasthis is not set) so need to add this too */
@@ -6551,6 +6627,8 @@ encode_patch (MonoAotCompile *acfg, MonoJumpInfo *patch_info, guint8 *buf, guint
 		break;
 	case MONO_PATCH_INFO_PROFILER_ALLOCATION_COUNT:
 	case MONO_PATCH_INFO_PROFILER_CLAUSE_COUNT:
+	case MONO_PATCH_INFO_PROFILER_METHOD_ENTER_COUNT:
+	case MONO_PATCH_INFO_PROFILER_METHOD_LEAVE_COUNT:
 		break;
 	case MONO_PATCH_INFO_RGCTX_FETCH:
 	case MONO_PATCH_INFO_RGCTX_SLOT_INDEX: {
@@ -7954,7 +8032,10 @@ mono_aot_parse_options (const char *aot_options, MonoAotOptions *opts)
 		} else if (str_begins_with (arg, "interp")) {
 			opts->interp = TRUE;
 		} else if (str_begins_with (arg, "threads=")) {
-			opts->nthreads = atoi (arg + strlen ("threads="));
+			if (!strcmp (arg + strlen ("threads="), "auto"))
+				opts->nthreads = mono_cpu_count ();
+			else
+				opts->nthreads = atoi (arg + strlen ("threads="));
 		} else if (str_begins_with (arg, "static")) {
 			opts->static_link = TRUE;
 			opts->no_dlsym = TRUE;
@@ -8025,6 +8106,9 @@ mono_aot_parse_options (const char *aot_options, MonoAotOptions *opts)
 			opts->dedup = TRUE;
 		} else if (str_begins_with (arg, "dedup-include=")) {
 			opts->dedup_include = g_strdup (arg + strlen ("dedup-include="));
+		} else if (str_begins_with (arg, "dedup-auto=")) {
+			opts->dedup_include = g_strdup (arg + strlen ("dedup-auto="));
+			opts->dedup_auto = TRUE;
 		} else if (str_begins_with (arg, "mtriple=")) {
 			opts->mtriple = g_strdup (arg + strlen ("mtriple="));
 		} else if (str_begins_with (arg, "llvm-path=")) {
@@ -8078,12 +8162,15 @@ mono_aot_parse_options (const char *aot_options, MonoAotOptions *opts)
 			opts->clangxx = g_strdup (arg + strlen ("clangxx="));
 		} else if (str_begins_with (arg, "depfile=")) {
 			opts->depfile = g_strdup (arg + strlen ("depfile="));
+		} else if (!strcmp (arg, "incremental")) {
+			opts->incremental = TRUE;
 		} else if (str_begins_with (arg, "help") || str_begins_with (arg, "?")) {
 			printf ("Supported options for --aot:\n");
 			printf ("    asmonly\n");
 			printf ("    bind-to-runtime-version\n");
 			printf ("    bitcode\n");
 			printf ("    data-outfile=\n");
+			printf ("    dedup-auto=\n");
 			printf ("    direct-icalls\n");
 			printf ("    direct-pinvoke\n");
 			printf ("    dwarfdebug\n");
@@ -8118,7 +8205,7 @@ mono_aot_parse_options (const char *aot_options, MonoAotOptions *opts)
 			printf ("    stats\n");
 			printf ("    temp-path=\n");
 			printf ("    tool-prefix=\n");
-			printf ("    threads=\n");
+			printf ("    threads=[<count>|auto]\n");
 			printf ("    write-symbols\n");
 			printf ("    verbose\n");
 			printf ("    no-opt\n");
@@ -8126,6 +8213,7 @@ mono_aot_parse_options (const char *aot_options, MonoAotOptions *opts)
 			printf ("    llvmllc=\n");
 			printf ("    clangxx=\n");
 			printf ("    depfile=\n");
+			printf ("    incremental\n");
 			printf ("    help/?\n");
 			exit (0);
 		} else {
@@ -8782,6 +8870,8 @@ compile_method (MonoAotCompile *acfg, MonoMethod *method)
 
 	/* Update global stats while holding a lock. */
 	mono_update_jit_stats (cfg);
+	acfg->stats.outlined_class_inits += cfg->stat_outlined_class_inits;
+	acfg->stats.outlined_wbarriers += cfg->stat_outlined_wbarriers;
 
 	/*
 	if (cfg->orig_method->wrapper_type)
@@ -8793,12 +8883,16 @@ compile_method (MonoAotCompile *acfg, MonoMethod *method)
 	mono_atomic_inc_i32 (&acfg->stats.ccount);
 }
  
+/*
+ * The compile threads take methods from acfg->methods in order, including the ones
+ * added while compiling other methods. A thread which finds the queue empty waits
+ * until the other threads are done, since they can still add new methods.
+ */
 static mono_thread_start_return_t WINAPI
 compile_thread_main (gpointer user_data)
 {
-	MonoAotCompile *acfg = ((MonoAotCompile **)user_data) [0];
-	GPtrArray *methods = ((GPtrArray **)user_data) [1];
-	int i;
+	MonoAotCompile *acfg = (MonoAotCompile *)user_data;
+	MonoMethod *method;
 
 	ERROR_DECL (error);
 	MonoInternalThread *internal = mono_thread_internal_current ();
@@ -8807,8 +8901,26 @@ compile_thread_main (gpointer user_data)
 	mono_thread_set_name_internal (internal, str, TRUE, FALSE, error);
 	mono_error_assert_ok (error);
 
-	for (i = 0; i < methods->len; ++i)
-		compile_method (acfg, (MonoMethod *)g_ptr_array_index (methods, i));
+	mono_acfg_lock (acfg);
+	while (TRUE) {
+		if (acfg->compile_queue_index < acfg->methods->len) {
+			method = (MonoMethod *)g_ptr_array_index (acfg->methods, acfg->compile_queue_index);
+			acfg->compile_queue_index ++;
+			acfg->compile_queue_active ++;
+			mono_acfg_unlock (acfg);
+
+			compile_method (acfg, method);
+
+			mono_acfg_lock (acfg);
+			acfg->compile_queue_active --;
+			mono_os_cond_broadcast (&acfg->compile_queue_cond);
+		} else if (acfg->compile_queue_active > 0) {
+			mono_os_cond_wait (&acfg->compile_queue_cond, &acfg->mutex);
+		} else {
+			break;
+		}
+	}
+	mono_acfg_unlock (acfg);
 
 	return 0;
 }
@@ -9783,8 +9895,12 @@ dedup_skip_methods (MonoAotCompile *acfg)
 				cfg->skip = TRUE;
 		}
 
+		// The instance is emitted into the dedup container instead
+		if (dedupable && acfg->aot_opts.dedup_auto && !acfg->dedup_emit_mode)
+			cfg->skip = TRUE;
+
 		// Don't compile anything in this mode
-		if (acfg->aot_opts.dedup_include && !acfg->dedup_emit_mode)
+		if (acfg->aot_opts.dedup_include && !acfg->aot_opts.dedup_auto && !acfg->dedup_emit_mode)
 			cfg->skip = TRUE;
 
 		// Compile everything in this mode
@@ -11791,67 +11907,39 @@ collect_methods (MonoAotCompile *acfg)
 static void
 compile_methods (MonoAotCompile *acfg)
 {
-	int i, methods_len;
+	int i;
 
 	if (acfg->aot_opts.nthreads > 0) {
-		GPtrArray *frag;
-		int len, j;
 		GPtrArray *threads;
 		MonoThreadHandle *thread_handle;
-		gpointer *user_data;
-		MonoMethod **methods;
 
-		methods_len = acfg->methods->len;
-
-		len = acfg->methods->len / acfg->aot_opts.nthreads;
-		g_assert (len > 0);
-		/* 
-		 * Partition the list of methods into fragments, and hand it to threads to
-		 * process.
-		 */
 		threads = g_ptr_array_new ();
-		/* Make a copy since acfg->methods is modified by compile_method () */
-		methods = g_new0 (MonoMethod*, methods_len);
-		//memcpy (methods, g_ptr_array_index (acfg->methods, 0), sizeof (MonoMethod*) * methods_len);
-		for (i = 0; i < methods_len; ++i)
-			methods [i] = (MonoMethod *)g_ptr_array_index (acfg->methods, i);
-		i = 0;
-		while (i < methods_len) {
+		mono_os_cond_init (&acfg->compile_queue_cond);
+		acfg->compile_queue_index = 0;
+		acfg->compile_queue_active = 0;
+
+		for (i = 0; i < acfg->aot_opts.nthreads; ++i) {
 			ERROR_DECL (error);
 			MonoInternalThread *thread;
 
-			frag = g_ptr_array_new ();
-			for (j = 0; j < len; ++j) {
-				if (i < methods_len) {
-					g_ptr_array_add (frag, methods [i]);
-					i ++;
-				}
-			}
-
-			user_data = g_new0 (gpointer, 3);
-			user_data [0] = acfg;
-			user_data [1] = frag;
-			
-			thread = mono_thread_create_internal (mono_domain_get (), (gpointer)compile_thread_main, user_data, MONO_THREAD_CREATE_FLAGS_NONE, error);
+			thread = mono_thread_create_internal (mono_domain_get (), (gpointer)compile_thread_main, acfg, MONO_THREAD_CREATE_FLAGS_NONE, error);
 			mono_error_assert_ok (error);
 
 			thread_handle = mono_threads_open_thread_handle (thread->handle);
 			g_ptr_array_add (threads, thread_handle);
 		}
-		g_free (methods);
 
 		for (i = 0; i < threads->len; ++i) {
 			mono_thread_info_wait_one_handle ((MonoThreadHandle*)g_ptr_array_index (threads, i), MONO_INFINITE_WAIT, FALSE);
 			mono_threads_close_thread_handle ((MonoThreadHandle*)g_ptr_array_index (threads, i));
 		}
+		g_ptr_array_free (threads, TRUE);
+		mono_os_cond_destroy (&acfg->compile_queue_cond);
+		g_assert (acfg->compile_queue_index == acfg->methods->len);
 	} else {
-		methods_len = 0;
-	}
-
-	/* Compile methods added by compile_method () or all methods if nthreads == 0 */
-	for (i = methods_len; i < acfg->methods->len; ++i) {
 		/* This can add new methods to acfg->methods */
-		compile_method (acfg, (MonoMethod *)g_ptr_array_index (acfg->methods, i));
+		for (i = 0; i < acfg->methods->len; ++i)
+			compile_method (acfg, (MonoMethod *)g_ptr_array_index (acfg->methods, i));
 	}
 
 #ifdef ENABLE_LLVM
@@ -12487,6 +12575,19 @@ add_profile_instances (MonoAotCompile *acfg, ProfileData *data)
 	if (!data)
 		return;
 
+	/* Method records are written in the order the methods were first executed, so their ids are increasing */
+	g_hash_table_iter_init (&iter, data->methods);
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		MethodProfileData *mdata = (MethodProfileData*)value;
+		int order;
+
+		if (!mdata->method)
+			continue;
+		order = GPOINTER_TO_INT (g_hash_table_lookup (acfg->profile_method_order, mdata->method));
+		if (!order || mdata->id + 1 < order)
+			g_hash_table_insert (acfg->profile_method_order, mdata->method, GINT_TO_POINTER (mdata->id + 1));
+	}
+
 	if (acfg->aot_opts.profile_only) {
 		/* Add methods referenced by the profile */
 		g_hash_table_iter_init (&iter, data->methods);
@@ -12596,6 +12697,7 @@ acfg_create (MonoAssembly *ass, guint32 opts)
 	acfg->gsharedvt_in_signatures = g_hash_table_new ((GHashFunc)mono_signature_hash, (GEqualFunc)mono_metadata_signature_equal);
 	acfg->gsharedvt_out_signatures = g_hash_table_new ((GHashFunc)mono_signature_hash, (GEqualFunc)mono_metadata_signature_equal);
 	acfg->profile_methods = g_hash_table_new (NULL, NULL);
+	acfg->profile_method_order = g_hash_table_new (NULL, NULL);
 	mono_os_mutex_init_recursive (&acfg->mutex);
 
 	init_got_info (&acfg->got_info);
@@ -12629,6 +12731,7 @@ acfg_free (MonoAotCompile *acfg)
 
 	g_free (acfg->cfgs);
 
+	g_free (acfg->incremental_key);
 	g_free (acfg->static_linking_symbol);
 	g_free (acfg->got_symbol);
 	g_free (acfg->plt_symbol);
@@ -13177,11 +13280,12 @@ mono_compile_deferred_assemblies (guint32 opts, const char *aot_options, gpointe
 
 	// FIXME: allow suffixes?
 	if (!astate->inflated_assembly) {
-		const char* inflate = strstr (aot_options, "dedup-inflate");
-		if (!inflate)
-			return 0;
-		else 
-			g_error ("Error: mono was not given an assembly with the provided inflate name\n");
+		/* The other images reference the deduped methods, so they can't be dropped silently */
+		if (strstr (aot_options, "dedup-include=") || strstr (aot_options, "dedup-auto="))
+			g_error ("Error: mono was not given an assembly with the provided dedup container name\n");
+		*aot_state = NULL;
+		free_aot_state (astate);
+		return 0;
 	}
 
 	// Switch modes
@@ -13301,7 +13405,7 @@ mono_compile_assembly (MonoAssembly *ass, guint32 opts, const char *aot_options,
 	if (is_dedup_dummy && astate && !astate->emit_inflated_methods)
 		return 0; 
 
-	if (acfg->aot_opts.dedup_include && !is_dedup_dummy)
+	if (acfg->aot_opts.dedup_include && !acfg->aot_opts.dedup_auto && !is_dedup_dummy)
 		acfg->dedup_collect_only = TRUE;
 	// end dedup
 
@@ -13309,6 +13413,14 @@ mono_compile_assembly (MonoAssembly *ass, guint32 opts, const char *aot_options,
 		acfg->logfile = fopen (acfg->aot_opts.logfile, "a+");
 	}
 
+	if (acfg->aot_opts.incremental && !acfg->aot_opts.dedup && !acfg->aot_opts.dedup_include) {
+		acfg->incremental_key = get_incremental_key (acfg, aot_options);
+		if (is_aot_image_up_to_date (acfg)) {
+			aot_printf (acfg, "AOT image for '%s' is up to date.\n", image->name);
+			return 0;
+		}
+	}
+
 	if (acfg->aot_opts.data_outfile) {
 		acfg->data_outfile = fopen (acfg->aot_opts.data_outfile, "w+");
 		if (!acfg->data_outfile) {
@@ -13584,13 +13696,50 @@ mono_compile_assembly (MonoAssembly *ass, guint32 opts, const char *aot_options,
 
 	dedup_skip_methods (acfg);
 
-	if (acfg->aot_opts.dedup_include && !is_dedup_dummy)
+	order_methods_by_profile (acfg);
+
+	if (acfg->aot_opts.dedup_include && !acfg->aot_opts.dedup_auto && !is_dedup_dummy)
 		/* We only collected methods from this assembly */
 		return 0;
 
 	return emit_aot_image (acfg);
 }
 
+static int
+compare_method_profile_order (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+	MonoAotCompile *acfg = (MonoAotCompile*)user_data;
+	int index1 = GPOINTER_TO_UINT (*(gpointer*)a);
+	int index2 = GPOINTER_TO_UINT (*(gpointer*)b);
+	guint32 order1 = acfg->cfgs [index1] ? GPOINTER_TO_UINT (g_hash_table_lookup (acfg->profile_method_order, acfg->cfgs [index1]->orig_method)) : 0;
+	guint32 order2 = acfg->cfgs [index2] ? GPOINTER_TO_UINT (g_hash_table_lookup (acfg->profile_method_order, acfg->cfgs [index2]->orig_method)) : 0;
+
+	/* Methods not in the profile go last, in their original order */
+	if (!order1)
+		order1 = G_MAXUINT32;
+	if (!order2)
+		order2 = G_MAXUINT32;
+	if (order1 != order2)
+		return order1 < order2 ? -1 : 1;
+	return index1 - index2;
+}
+
+/*
+ * order_methods_by_profile:
+ *
+ *   Reorder acfg->method_order so the code of the methods which ran during the
+ * profiling session is emitted first, in the order they were first executed. The
+ * code used during startup ends up in contiguous pages, and methods which were
+ * never executed are grouped at the end of the code section.
+ */
+static void
+order_methods_by_profile (MonoAotCompile *acfg)
+{
+	if (!g_hash_table_size (acfg->profile_method_order))
+		return;
+	g_ptr_array_sort_with_data (acfg->method_order, compare_method_profile_order, acfg);
+}
+
 static void
 print_stats (MonoAotCompile *acfg)
 {
@@ -13646,6 +13795,12 @@ print_stats (MonoAotCompile *acfg)
 	aot_printf (acfg, "\tClass ref: %d (%dk)\n", acfg->stats.class_ref_count, acfg->stats.class_ref_size / 1024);
 	aot_printf (acfg, "\tGinst: %d (%dk)\n", acfg->stats.ginst_count, acfg->stats.ginst_size / 1024);
 
+	if (acfg->stats.outlined_class_inits || acfg->stats.outlined_wbarriers) {
+		aot_printf (acfg, "\nOutlined sequences (-O=outline):\n");
+		aot_printf (acfg, "\tClass init checks: %d\n", acfg->stats.outlined_class_inits);
+		aot_printf (acfg, "\tWrite barriers:    %d\n", acfg->stats.outlined_wbarriers);
+	}
+
 	aot_printf (acfg, "\nMethod stats:\n");
 	aot_printf (acfg, "\tNormal:    %d\n", acfg->stats.method_categories [METHOD_CAT_NORMAL]);
 	aot_printf (acfg, "\tInstance:  %d\n", acfg->stats.method_categories [METHOD_CAT_INST]);
@@ -13656,6 +13811,154 @@ print_stats (MonoAotCompile *acfg)
 		mono_dedup_log_stats (acfg);
 }
 
+/*
+ * get_incremental_stamp_name:
+ *
+ *   Return the name of the file recording the inputs of the last compilation in
+ * incremental mode, or NULL if the output file name is not known in advance.
+ */
+static char*
+get_incremental_stamp_name (MonoAotCompile *acfg)
+{
+	if (acfg->aot_opts.outfile)
+		return g_strdup_printf ("%s.incremental", acfg->aot_opts.outfile);
+	if (acfg->aot_opts.asm_only)
+		return NULL;
+	return g_strdup_printf ("%s%s.incremental", acfg->image->name, MONO_SOLIB_EXT);
+}
+
+/*
+ * get_incremental_key:
+ *
+ *   Return a string identifying everything besides the input images which affects
+ * the generated code: the runtime version, the options and the profile data.
+ */
+static char*
+get_incremental_key (MonoAotCompile *acfg, const char *aot_options)
+{
+	GString *s;
+	GList *l;
+	char *build_info;
+
+	build_info = mono_get_runtime_build_info ();
+	s = g_string_new ("");
+	g_string_append_printf (s, "%s|%x|%s", build_info, acfg->opts, aot_options ? aot_options : "");
+	g_free (build_info);
+
+	for (l = acfg->aot_opts.profile_files; l; l = l->next) {
+		struct stat st;
+		const char *fname = (const char*)l->data;
+
+		if (stat (fname, &st) == 0)
+			g_string_append_printf (s, "|%s:%lld:%lld", fname, (long long)st.st_size, (long long)st.st_mtime);
+		else
+			g_string_append_printf (s, "|%s", fname);
+	}
+
+	/* The stamp file is line based */
+	for (int i = 0; i < s->len; ++i) {
+		if (s->str [i] == '\n' || s->str [i] == '\r')
+			s->str [i] = ' ';
+	}
+
+	return g_string_free (s, FALSE);
+}
+
+/*
+ * is_aot_image_up_to_date:
+ *
+ *   Return whenever the output of a previous compilation can be reused, i.e. it was
+ * made with the same configuration, and none of the images it was compiled against,
+ * including ones whose code was inlined into it, changed since then.
+ */
+static gboolean
+is_aot_image_up_to_date (MonoAotCompile *acfg)
+{
+	char *stamp_name;
+	FILE *stamp;
+	char line [4096];
+	gboolean res = FALSE;
+
+	stamp_name = get_incremental_stamp_name (acfg);
+	if (!stamp_name)
+		return FALSE;
+	stamp = fopen (stamp_name, "r");
+	g_free (stamp_name);
+	if (!stamp)
+		return FALSE;
+
+	if (acfg->aot_opts.outfile && !g_file_test (acfg->aot_opts.outfile, G_FILE_TEST_EXISTS))
+		goto done;
+	if (acfg->aot_opts.llvm_outfile && !g_file_test (acfg->aot_opts.llvm_outfile, G_FILE_TEST_EXISTS))
+		goto done;
+	if (acfg->aot_opts.data_outfile && !g_file_test (acfg->aot_opts.data_outfile, G_FILE_TEST_EXISTS))
+		goto done;
+
+	if (!fgets (line, sizeof (line), stamp) || strcmp (g_strchomp (line), acfg->incremental_key))
+		goto done;
+
+	/* The remaining lines are '<guid> <filename>' pairs */
+	while (fgets (line, sizeof (line), stamp)) {
+		MonoImageOpenStatus status;
+		MonoImage *image;
+		char *sep;
+		gboolean matches;
+
+		g_strchomp (line);
+		sep = strchr (line, ' ');
+		if (!sep)
+			goto done;
+		*sep = '\0';
+
+		image = mono_image_open (sep + 1, &status);
+		if (!image)
+			goto done;
+		matches = !strcmp (image->guid, line);
+		mono_image_close (image);
+		if (!matches)
+			goto done;
+	}
+	res = TRUE;
+
+done:
+	fclose (stamp);
+	return res;
+}
+
+static void
+write_incremental_stamp (MonoAotCompile *acfg)
+{
+	char *stamp_name, *tmp_name;
+	FILE *stamp;
+
+	stamp_name = get_incremental_stamp_name (acfg);
+	if (!stamp_name || !acfg->image->filename) {
+		g_free (stamp_name);
+		return;
+	}
+	tmp_name = g_strdup_printf ("%s.tmp", stamp_name);
+
+	stamp = fopen (tmp_name, "w");
+	if (!stamp) {
+		aot_printerrf (acfg, "Unable to create file '%s': %s\n", tmp_name, strerror (errno));
+		goto done;
+	}
+	fprintf (stamp, "%s\n", acfg->incremental_key);
+	fprintf (stamp, "%s %s\n", acfg->image->guid, acfg->image->filename);
+	for (int i = 0; i < acfg->image_table->len; i++) {
+		MonoImage *image = (MonoImage*)g_ptr_array_index (acfg->image_table, i);
+
+		if (image != acfg->image && image->filename)
+			fprintf (stamp, "%s %s\n", image->guid, image->filename);
+	}
+	fclose (stamp);
+	rename (tmp_name, stamp_name);
+
+done:
+	g_free (tmp_name);
+	g_free (stamp_name);
+}
+
 static void
 create_depfile (MonoAotCompile *acfg)
 {
@@ -13907,6 +14210,9 @@ emit_aot_image (MonoAotCompile *acfg)
 	if (acfg->aot_opts.depfile)
 		create_depfile (acfg);
 
+	if (acfg->incremental_key)
+		write_incremental_stamp (acfg);
+
 	if (acfg->aot_opts.dump_json)
 		aot_dump (acfg);
 
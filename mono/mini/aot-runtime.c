@@ -33,6 +33,7 @@
 #endif
 
 #include <errno.h>
+#include <time.h>
 #include <sys/stat.h>
 
 #ifdef HAVE_SYS_WAIT_H
@@ -73,7 +74,7 @@
 
 #ifndef DISABLE_AOT
 
-#ifdef TARGET_OSX
+#if !defined(HOST_WIN32) && defined(HAVE_FORK) && defined(HAVE_EXECV) && defined(HAVE_WAITPID)
 #define ENABLE_AOT_CACHE
 #endif
 
@@ -102,6 +103,10 @@ struct MonoAotModule {
 	GHashTable *method_to_code;
 	/* Maps pointers into the method info to the methods themselves */
 	GHashTable *method_ref_to_method;
+	/* Maps pointers into the blob to the generic insts decoded from them */
+	GHashTable *ginst_cache;
+	/* Maps pointers to MONO_AOT_TYPEREF_GINST class refs to KlassRefCacheEntry structures */
+	GHashTable *ginst_klass_ref_cache;
 	MonoAssemblyName *image_names;
 	char **image_guids;
 	MonoAssembly *assembly;
@@ -110,6 +115,8 @@ struct MonoAotModule {
 	gboolean out_of_date;
 	gboolean plt_inited;
 	int got_initialized;
+	/* Set once bind_amodule_got () ran */
+	gint32 got_bound;
 	guint8 *mem_begin;
 	guint8 *mem_end;
 	guint8 *jit_code_start;
@@ -220,6 +227,11 @@ static gsize aot_code_high_addr = 0;
 /* Stats */
 static gint32 async_jit_info_size;
 
+/* Trampoline statistics */
+static gint32 numerous_trampolines_used [MONO_AOT_TRAMP_NUM];
+static gint32 numerous_trampolines_overflowed;
+static gint32 trampoline_pages_allocated;
+
 #ifdef MONOTOUCH
 #define USE_PAGE_TRAMPOLINES (mono_defaults.corlib->aot_module->use_page_trampolines)
 #else
@@ -433,6 +445,42 @@ decode_generic_inst (MonoAotModule *module, guint8 *buf, guint8 **endbuf, MonoEr
 	return inst;
 }
 
+typedef struct {
+	MonoClass *klass;
+	/* Length of the encoded class ref */
+	guint32 len;
+} KlassRefCacheEntry;
+
+/*
+ * decode_cached_generic_inst:
+ *
+ *   Same as decode_generic_inst (), for generic insts referenced by their offset in
+ * the blob. Those are shared by many class and method refs, so the result is cached.
+ */
+static MonoGenericInst*
+decode_cached_generic_inst (MonoAotModule *module, guint32 offset, MonoError *error)
+{
+	MonoGenericInst *inst;
+	guint8 *p = module->blob + offset;
+
+	amodule_lock (module);
+	inst = module->ginst_cache ? (MonoGenericInst*)g_hash_table_lookup (module->ginst_cache, p) : NULL;
+	amodule_unlock (module);
+	if (inst)
+		return inst;
+
+	inst = decode_generic_inst (module, p, &p, error);
+	if (!inst)
+		return NULL;
+
+	amodule_lock (module);
+	if (!module->ginst_cache)
+		module->ginst_cache = g_hash_table_new (NULL, NULL);
+	g_hash_table_insert (module->ginst_cache, module->blob + offset, inst);
+	amodule_unlock (module);
+	return inst;
+}
+
 static gboolean
 decode_generic_context (MonoAotModule *amodule, MonoGenericContext *ctx, guint8 *buf, guint8 **endbuf, MonoError *error)
 {
@@ -445,15 +493,13 @@ decode_generic_context (MonoAotModule *amodule, MonoGenericContext *ctx, guint8
 
 	if (flags & 1) {
 		offset = decode_value (p, &p);
-		p2 = amodule->blob + offset;
-		ctx->class_inst = decode_generic_inst (amodule, p2, &p2, error);
+		ctx->class_inst = decode_cached_generic_inst (amodule, offset, error);
 		if (!ctx->class_inst)
 			return FALSE;
 	}
 	if (flags & 2) {
 		offset = decode_value (p, &p);
-		p2 = amodule->blob + offset;
-		ctx->method_inst = decode_generic_inst (amodule, p2, &p2, error);
+		ctx->method_inst = decode_cached_generic_inst (amodule, offset, error);
 		if (!ctx->method_inst)
 			return FALSE;
 	}
@@ -507,6 +553,15 @@ decode_klass_ref (MonoAotModule *module, guint8 *buf, guint8 **endbuf, MonoError
 		MonoClass *gclass;
 		MonoGenericContext ctx;
 		MonoType *type;
+		KlassRefCacheEntry *entry;
+
+		amodule_lock (module);
+		entry = module->ginst_klass_ref_cache ? (KlassRefCacheEntry*)g_hash_table_lookup (module->ginst_klass_ref_cache, buf) : NULL;
+		amodule_unlock (module);
+		if (entry) {
+			*endbuf = buf + entry->len;
+			return entry->klass;
+		}
 
 		gclass = decode_klass_ref (module, p, &p, error);
 		if (!gclass)
@@ -515,8 +570,7 @@ decode_klass_ref (MonoAotModule *module, guint8 *buf, guint8 **endbuf, MonoError
 
 		memset (&ctx, 0, sizeof (ctx));
 		guint32 offset = decode_value (p, &p);
-		guint8 *p2 = module->blob + offset;
-		ctx.class_inst = decode_generic_inst (module, p2, &p2, error);
+		ctx.class_inst = decode_cached_generic_inst (module, offset, error);
 		if (!ctx.class_inst)
 			return NULL;
 		type = mono_class_inflate_generic_type_checked (m_class_get_byval_arg (gclass), &ctx, error);
@@ -524,6 +578,15 @@ decode_klass_ref (MonoAotModule *module, guint8 *buf, guint8 **endbuf, MonoError
 			return NULL;
 		klass = mono_class_from_mono_type_internal (type);
 		mono_metadata_free_type (type);
+
+		entry = g_new0 (KlassRefCacheEntry, 1);
+		entry->klass = klass;
+		entry->len = p - buf;
+		amodule_lock (module);
+		if (!module->ginst_klass_ref_cache)
+			module->ginst_klass_ref_cache = g_hash_table_new_full (NULL, NULL, NULL, g_free);
+		g_hash_table_insert (module->ginst_klass_ref_cache, buf, entry);
+		amodule_unlock (module);
 		break;
 	}
 	case MONO_AOT_TYPEREF_VAR: {
@@ -1465,7 +1528,6 @@ decode_resolve_method_ref (MonoAotModule *module, guint8 *buf, guint8 **endbuf,
  * - Add options for controlling the cache size
  * - Handle full cache by deleting old assemblies lru style
  * - Maybe add a threshold after an assembly is AOT compiled
- * - Add options for enabling this for specific main assemblies
  */
 
 /* The cache directory */
@@ -1477,14 +1539,8 @@ static int cache_count;
 /* Whenever to AOT in-process */
 static gboolean in_process;
 
-static void
-collect_assemblies (gpointer data, gpointer user_data)
-{
-	MonoAssembly *ass = (MonoAssembly*)data;
-	GSList **l = (GSList**)user_data;
-
-	*l = g_slist_prepend (*l, ass);
-}
+/* Lock files older than this are assumed to belong to a compiler process which died */
+#define AOT_CACHE_STALE_LOCK_SECONDS (60 * 60)
 
 #define SHA1_DIGEST_LENGTH 20
 
@@ -1492,12 +1548,15 @@ collect_assemblies (gpointer data, gpointer user_data)
  * get_aot_config_hash:
  *
  *   Return a hash for all the version information an AOT module depends on.
+ * The image mvid changes whenever the assembly is rebuilt, and the runtime build
+ * info changes with the runtime version. Dependent assemblies are checked by
+ * load_aot_module () when the image is loaded, so they don't need to be part of
+ * the key, which keeps it stable between runs of the same application.
  */
-static G_GNUC_UNUSED char*
-get_aot_config_hash (MonoAssembly *assembly)
+static char*
+get_aot_config_hash (MonoAssembly *assembly, const char *aot_options)
 {
 	char *build_info;
-	GSList *l, *assembly_list = NULL;
 	GString *s;
 	int i;
 	guint8 digest [SHA1_DIGEST_LENGTH];
@@ -1506,21 +1565,13 @@ get_aot_config_hash (MonoAssembly *assembly)
 	build_info = mono_get_runtime_build_info ();
 
 	s = g_string_new (build_info);
-
-	mono_assembly_foreach (collect_assemblies, &assembly_list);
-
-	/*
-	 * The assembly list includes the current assembly as well, no need
-	 * to add it.
-	 */
-	for (l = assembly_list; l; l = l->next) {
-		MonoAssembly *ass = (MonoAssembly*)l->data;
-
-		g_string_append (s, "_");
-		g_string_append (s, ass->aname.name);
+	g_string_append (s, "_");
+	g_string_append (s, assembly->image->guid);
+	if (aot_options) {
 		g_string_append (s, "_");
-		g_string_append (s, ass->image->guid);
+		g_string_append (s, aot_options);
 	}
+	g_free (build_info);
 
 	for (i = 0; i < s->len; ++i) {
 		if (!isalnum (s->str [i]) && s->str [i] != '-')
@@ -1543,35 +1594,155 @@ get_aot_config_hash (MonoAssembly *assembly)
 static void
 aot_cache_init (void)
 {
+	char *dir;
+
 	if (mono_aot_only)
 		return;
 	enable_aot_cache = TRUE;
-	in_process = TRUE;
+	/* MONO_AOT_CACHE_IN_PROCESS=1 compiles synchronously in the current process, useful for debugging */
+	in_process = g_hasenv ("MONO_AOT_CACHE_IN_PROCESS");
+
+	dir = g_getenv ("MONO_AOT_CACHE_DIR");
+	if (dir) {
+		cache_dir = dir;
+	} else {
+		const char *home = g_get_home_dir ();
+
+		if (!home)
+			return;
+#ifdef TARGET_OSX
+		cache_dir = g_strdup_printf ("%s/Library/Caches/mono/aot-cache", home);
+#else
+		char *xdg_cache = g_getenv ("XDG_CACHE_HOME");
+		if (xdg_cache)
+			cache_dir = g_strdup_printf ("%s/mono/aot-cache", xdg_cache);
+		else
+			cache_dir = g_strdup_printf ("%s/.cache/mono/aot-cache", home);
+		g_free (xdg_cache);
+#endif
+	}
+}
+
+/*
+ * aot_cache_lock:
+ *
+ *   Try to take the per-image compile lock LOCK_FNAME. Return FALSE if another
+ * process is already compiling the image.
+ */
+static gboolean
+aot_cache_lock (const char *lock_fname)
+{
+	struct stat st;
+	int fd;
+
+	fd = open (lock_fname, O_CREAT | O_EXCL | O_WRONLY, 0666);
+	if (fd == -1 && errno == EEXIST && stat (lock_fname, &st) == 0 && time (NULL) - st.st_mtime > AOT_CACHE_STALE_LOCK_SECONDS) {
+		unlink (lock_fname);
+		fd = open (lock_fname, O_CREAT | O_EXCL | O_WRONLY, 0666);
+	}
+	if (fd == -1)
+		return FALSE;
+	close (fd);
+	return TRUE;
+}
+
+/*
+ * aot_cache_compile_in_background:
+ *
+ *   Run the AOT compiler on ASSEMBLY in a new runtime process, without waiting
+ * for it to finish. The image is written to a temporary file and renamed to
+ * FNAME on success, so concurrent runs never see a partial image. On failure,
+ * FAILURE_FNAME is created so later runs don't retry.
+ */
+static void
+aot_cache_compile_in_background (MonoAssembly *assembly, const char *fname, const char *failure_fname, const char *lock_fname, const char *aot_options)
+{
+	char exe [4096];
+	const char *argv [4];
+	char *tmp_fname, *log_fname, *aot_arg;
+	int len, pid, exit_status;
+
+	len = mono_dl_get_executable_path (exe, sizeof (exe));
+	if (len <= 0 || len >= (int)sizeof (exe)) {
+		mono_trace (G_LOG_LEVEL_MESSAGE, MONO_TRACE_AOT, "AOT: unable to determine the runtime executable path.");
+		unlink (lock_fname);
+		return;
+	}
+	exe [len] = '\0';
+
+	/* Everything the children need is computed before forking, they only make async signal safe calls */
+	tmp_fname = g_strdup_printf ("%s.%d.tmp", fname, getpid ());
+	log_fname = g_strdup_printf ("%s.log", fname);
+	aot_arg = g_strdup_printf ("--aot=outfile=%s%s%s", tmp_fname, aot_options ? "," : "", aot_options ? aot_options : "");
+	argv [0] = exe;
+	argv [1] = aot_arg;
+	argv [2] = assembly->image->name;
+	argv [3] = NULL;
+
+	/* Double fork so the compiler is reparented to init and never becomes a zombie of this process */
+	pid = fork ();
+	if (pid == 0) {
+		int log_fd, status;
+
+		if (fork () != 0)
+			_exit (0);
+
+		setsid ();
+		pid = fork ();
+		if (pid == 0) {
+			log_fd = open (log_fname, O_CREAT | O_TRUNC | O_WRONLY, 0666);
+			if (log_fd != -1) {
+				dup2 (log_fd, 1);
+				dup2 (log_fd, 2);
+				close (log_fd);
+			}
+			execv (argv [0], (char**)argv);
+			_exit (127);
+		}
+
+		if (pid > 0 && waitpid (pid, &status, 0) == pid && WIFEXITED (status) && WEXITSTATUS (status) == 0 && rename (tmp_fname, fname) == 0) {
+			unlink (lock_fname);
+			_exit (0);
+		}
+
+		unlink (tmp_fname);
+		close (open (failure_fname, O_CREAT | O_WRONLY, 0666));
+		unlink (lock_fname);
+		_exit (1);
+	} else if (pid > 0) {
+		/* Reap the intermediate child, which exits right away */
+		waitpid (pid, &exit_status, 0);
+		mono_trace (G_LOG_LEVEL_MESSAGE, MONO_TRACE_AOT, "AOT: compiling assembly '%s' in the background, logfile: '%s'.", assembly->image->name, log_fname);
+	} else {
+		mono_trace (G_LOG_LEVEL_MESSAGE, MONO_TRACE_AOT, "AOT: fork failed: %s.", g_strerror (errno));
+		unlink (lock_fname);
+	}
+
+	g_free (tmp_fname);
+	g_free (log_fname);
+	g_free (aot_arg);
 }
 
 /*
  * aot_cache_load_module:
  *
- *   Load the AOT image corresponding to ASSEMBLY from the aot cache, AOTing it if neccessary.
+ *   Load the AOT image corresponding to ASSEMBLY from the aot cache. If it is
+ * not there yet, start compiling it so later runs can use it.
  */
 static MonoDl*
 aot_cache_load_module (MonoAssembly *assembly, char **aot_name)
 {
 	MonoAotCacheConfig *config;
 	GSList *l;
-	char *fname, *tmp2, *aot_options, *failure_fname;
-	const char *home;
+	char *fname, *tmp2, *aot_options, *failure_fname, *lock_fname;
 	MonoDl *module;
 	gboolean res;
-	gint exit_status;
 	char *hash;
-	int pid;
 	gboolean enabled;
-	FILE *failure_file;
 
 	*aot_name = NULL;
 
-	if (image_is_dynamic (assembly->image))
+	if (!cache_dir || image_is_dynamic (assembly->image))
 		return NULL;
 
 	/* Check in the list of assemblies enabled for aot caching */
@@ -1606,27 +1777,22 @@ aot_cache_load_module (MonoAssembly *assembly, char **aot_name)
 	if (!enabled)
 		return NULL;
 
-	if (!cache_dir) {
-		home = g_get_home_dir ();
-		if (!home)
-			return NULL;
-		cache_dir = g_strdup_printf ("%s/Library/Caches/mono/aot-cache", home);
-		if (!g_file_test (cache_dir, (GFileTest)(G_FILE_TEST_EXISTS|G_FILE_TEST_IS_DIR)))
-			g_mkdir_with_parents (cache_dir, 0777);
-	}
+	if (!g_file_test (cache_dir, (GFileTest)(G_FILE_TEST_EXISTS|G_FILE_TEST_IS_DIR)))
+		g_mkdir_with_parents (cache_dir, 0777);
 
 	/*
 	 * The same assembly can be used in multiple configurations, i.e. multiple
-     * versions of the runtime, with multiple versions of dependent assemblies etc.
+	 * versions of the runtime, or multiple builds of the assembly.
 	 * To handle this, we compute a version string containing all this information, hash it,
 	 * and use the hash as a filename suffix.
 	 */
-	hash = get_aot_config_hash (assembly);
+	hash = get_aot_config_hash (assembly, config->aot_options);
 
 	tmp2 = g_strdup_printf ("%s-%s%s", assembly->image->assembly_name, hash, MONO_SOLIB_EXT);
 	fname = g_build_filename (cache_dir, tmp2, NULL);
 	*aot_name = fname;
 	g_free (tmp2);
+	g_free (hash);
 
 	mono_trace (G_LOG_LEVEL_INFO, MONO_TRACE_AOT, "AOT: loading from cache: '%s'.", fname);
 	module = mono_dl_open (fname, MONO_DL_LAZY, NULL);
@@ -1636,7 +1802,7 @@ aot_cache_load_module (MonoAssembly *assembly, char **aot_name)
 		return module;
 	}
 
-	if (mono_is_corlib_image (assembly->image) && !mscorlib_aot_loaded)
+	if (in_process && mono_is_corlib_image (assembly->image) && !mscorlib_aot_loaded)
 		/*
 		 * Can't AOT this during startup, so we AOT it when called later from
 		 * mono_aot_get_method ().
@@ -1648,21 +1814,24 @@ aot_cache_load_module (MonoAssembly *assembly, char **aot_name)
 	/* Only AOT one assembly per run to avoid slowing down execution too much */
 	if (cache_count > 0)
 		return NULL;
-	cache_count ++;
 
 	/* Check for previous failure */
 	failure_fname = g_strdup_printf ("%s.failure", fname);
-	failure_file = fopen (failure_fname, "r");
-	if (failure_file) {
+	if (g_file_test (failure_fname, G_FILE_TEST_EXISTS)) {
 		mono_trace (G_LOG_LEVEL_MESSAGE, MONO_TRACE_AOT, "AOT: assembly '%s' previously failed to compile '%s' ('%s')... ", assembly->image->name, fname, failure_fname);
 		g_free (failure_fname);
 		return NULL;
-	} else {
-		g_free (failure_fname);
-		fclose (failure_file);
 	}
 
-	mono_trace (G_LOG_LEVEL_MESSAGE, MONO_TRACE_AOT, "AOT: compiling assembly '%s', logfile: '%s.log'... ", assembly->image->name, fname);
+	/* Another process might be compiling the same image */
+	lock_fname = g_strdup_printf ("%s.lock", fname);
+	if (!aot_cache_lock (lock_fname)) {
+		mono_trace (G_LOG_LEVEL_INFO, MONO_TRACE_AOT, "AOT: assembly '%s' is being compiled by another process.", assembly->image->name);
+		g_free (failure_fname);
+		g_free (lock_fname);
+		return NULL;
+	}
+	cache_count ++;
 
 	/*
 	 * We need to invoke the AOT compiler here. There are multiple approaches:
@@ -1670,58 +1839,36 @@ aot_cache_load_module (MonoAssembly *assembly, char **aot_name)
 	 * its hard to make the new process load the same set of assemblies.
 	 * - doing it in-process. This exposes the current process to bugs/leaks/side effects of
 	 * the AOT compiler.
-	 * - fork a new process and do the work there.
+	 * - fork a new process and do the work there. This is unsafe, since other threads
+	 * could be holding runtime locks at the time of the fork.
+	 * We spawn a new process by default, since it doesn't slow down the current run,
+	 * and the image is only loaded if it matches the assemblies used by this process.
 	 */
+	module = NULL;
 	if (in_process) {
+		mono_trace (G_LOG_LEVEL_MESSAGE, MONO_TRACE_AOT, "AOT: compiling assembly '%s', logfile: '%s.log'... ", assembly->image->name, fname);
+
 		aot_options = g_strdup_printf ("outfile=%s,internal-logfile=%s.log%s%s", fname, fname, config->aot_options ? "," : "", config->aot_options ? config->aot_options : "");
-		/* Maybe due this in another thread ? */
 		res = mono_compile_assembly (assembly, mono_parse_default_optimizations (NULL), aot_options, NULL);
+		g_free (aot_options);
 		if (res) {
+			FILE *failure_file;
+
 			mono_trace (G_LOG_LEVEL_MESSAGE, MONO_TRACE_AOT, "AOT: compilation failed.");
-			failure_fname = g_strdup_printf ("%s.failure", fname);
 			failure_file = fopen (failure_fname, "a+");
-			fclose (failure_file);
-			g_free (failure_fname);
+			if (failure_file)
+				fclose (failure_file);
 		} else {
 			mono_trace (G_LOG_LEVEL_MESSAGE, MONO_TRACE_AOT, "AOT: compilation succeeded.");
+			module = mono_dl_open (fname, MONO_DL_LAZY, NULL);
 		}
+		unlink (lock_fname);
 	} else {
-		/*
-		 * - Avoid waiting for the aot process to finish ?
-		 *   (less overhead, but multiple processes could aot the same assembly at the same time)
-		 */
-		pid = fork ();
-		if (pid == 0) {
-			FILE *logfile;
-			char *logfile_name;
-
-			/* Child */
-
-			logfile_name = g_strdup_printf ("%s/aot.log", cache_dir);
-			logfile = fopen (logfile_name, "a+");
-			g_free (logfile_name);
-
-			dup2 (fileno (logfile), 1);
-			dup2 (fileno (logfile), 2);
-
-			aot_options = g_strdup_printf ("outfile=%s", fname);
-			res = mono_compile_assembly (assembly, mono_parse_default_optimizations (NULL), aot_options, NULL);
-			if (!res) {
-				exit (1);
-			} else {
-				exit (0);
-			}
-		} else {
-			/* Parent */
-			waitpid (pid, &exit_status, 0);
-			if (!WIFEXITED (exit_status) && (WEXITSTATUS (exit_status) == 0))
-				mono_trace (G_LOG_LEVEL_MESSAGE, MONO_TRACE_AOT, "AOT: failed.");
-			else
-				mono_trace (G_LOG_LEVEL_MESSAGE, MONO_TRACE_AOT, "AOT: succeeded.");
-		}
+		aot_cache_compile_in_background (assembly, fname, failure_fname, lock_fname, config->aot_options);
 	}
 
-	module = mono_dl_open (fname, MONO_DL_LAZY, NULL);
+	g_free (failure_fname);
+	g_free (lock_fname);
 
 	return module;
 }
@@ -1967,6 +2114,43 @@ get_call_table_entry (void *table, int index)
 #endif
 }
 
+/*
+ * get_method_address:
+ *
+ *   Return the address of the native code of the method identified by METHOD_INDEX,
+ * or GINT_TO_POINTER (-1) if it was not compiled. The addresses are computed on
+ * first use, so loading a module doesn't read the whole method address table and
+ * only the entries of the methods which are used are written.
+ */
+static gpointer
+get_method_address (MonoAotModule *amodule, int method_index)
+{
+	gpointer addr = amodule->methods [method_index];
+
+	if (addr)
+		return addr;
+
+	if (amodule->info.llvm_get_method) {
+		gpointer (*get_method) (int) = (gpointer (*)(int))amodule->info.llvm_get_method;
+
+		addr = get_method (method_index);
+	}
+
+	/* method_addresses () contains a table of branches, since the ios linker can update those correctly */
+	if (!addr && amodule->info.method_addresses) {
+		addr = get_call_table_entry (amodule->info.method_addresses, method_index);
+		g_assert (addr);
+		if (addr == amodule->info.method_addresses)
+			addr = NULL;
+	}
+	if (addr == NULL)
+		addr = GINT_TO_POINTER (-1);
+
+	/* Other threads can race to compute the same value */
+	amodule->methods [method_index] = addr;
+	return addr;
+}
+
 /*
  * init_amodule_got:
  *
@@ -2353,29 +2537,8 @@ if (container_assm_name && !container_amodule) {
 	if (mono_is_corlib_image (assembly->image))
 		mscorlib_aot_module = amodule;
 
-	/* Compute method addresses */
+	/* The method addresses are computed lazily by get_method_address () */
 	amodule->methods = (void **)g_malloc0 (amodule->info.nmethods * sizeof (gpointer));
-	for (i = 0; i < amodule->info.nmethods; ++i) {
-		void *addr = NULL;
-
-		if (amodule->info.llvm_get_method) {
-			gpointer (*get_method) (int) = (gpointer (*)(int))amodule->info.llvm_get_method;
-
-			addr = get_method (i);
-		}
-
-		/* method_addresses () contains a table of branches, since the ios linker can update those correctly */
-		if (!addr && amodule->info.method_addresses) {
-			addr = get_call_table_entry (amodule->info.method_addresses, i);
-			g_assert (addr);
-			if (addr == amodule->info.method_addresses)
-				addr = NULL;
-		}
-		if (addr == NULL)
-			amodule->methods [i] = GINT_TO_POINTER (-1);
-		else
-			amodule->methods [i] = addr;
-	}
 
 	if (make_unreadable) {
 #ifndef TARGET_WIN32
@@ -2518,6 +2681,14 @@ mono_aot_init (void)
 
 	mono_install_assembly_load_hook (load_aot_module, NULL);
 	mono_counters_register ("Async JIT info size", MONO_COUNTER_INT|MONO_COUNTER_JIT, &async_jit_info_size);
+	mono_counters_register ("AOT specific trampolines used", MONO_COUNTER_INT|MONO_COUNTER_JIT, &numerous_trampolines_used [MONO_AOT_TRAMP_SPECIFIC]);
+	mono_counters_register ("AOT static rgctx trampolines used", MONO_COUNTER_INT|MONO_COUNTER_JIT, &numerous_trampolines_used [MONO_AOT_TRAMP_STATIC_RGCTX]);
+	mono_counters_register ("AOT imt trampolines used", MONO_COUNTER_INT|MONO_COUNTER_JIT, &numerous_trampolines_used [MONO_AOT_TRAMP_IMT]);
+	mono_counters_register ("AOT gsharedvt arg trampolines used", MONO_COUNTER_INT|MONO_COUNTER_JIT, &numerous_trampolines_used [MONO_AOT_TRAMP_GSHAREDVT_ARG]);
+	mono_counters_register ("AOT ftnptr arg trampolines used", MONO_COUNTER_INT|MONO_COUNTER_JIT, &numerous_trampolines_used [MONO_AOT_TRAMP_FTNPTR_ARG]);
+	mono_counters_register ("AOT unbox arbitrary trampolines used", MONO_COUNTER_INT|MONO_COUNTER_JIT, &numerous_trampolines_used [MONO_AOT_TRAMP_UNBOX_ARBITRARY]);
+	mono_counters_register ("AOT trampolines from other images", MONO_COUNTER_INT|MONO_COUNTER_JIT, &numerous_trampolines_overflowed);
+	mono_counters_register ("AOT trampoline pages", MONO_COUNTER_INT|MONO_COUNTER_JIT, &trampoline_pages_allocated);
 
 	char *lastaot = g_getenv ("MONO_LASTAOT");
 	if (lastaot) {
@@ -2839,8 +3010,8 @@ compute_llvm_code_range (MonoAotModule *amodule, guint8 **code_start, guint8 **c
 	table = (gint32*)p;
 
 	if (fde_count > 0) {
-		*code_start = (guint8 *)amodule->methods [table [0]];
-		*code_end = (guint8*)amodule->methods [table [(fde_count - 1) * 2]] + table [fde_count * 2];
+		*code_start = (guint8 *)get_method_address (amodule, table [0]);
+		*code_end = (guint8*)get_method_address (amodule, table [(fde_count - 1) * 2]) + table [fde_count * 2];
 	} else {
 		*code_start = NULL;
 		*code_end = NULL;
@@ -2936,12 +3107,12 @@ decode_llvm_mono_eh_frame (MonoAotModule *amodule, MonoDomain *domain, MonoJitIn
 
 		/* The table contains method index/fde offset pairs */
 		g_assert (table [(pos * 2)] != -1);
-		code1 = (guint8 *)amodule->methods [table [(pos * 2)]];
+		code1 = (guint8 *)get_method_address (amodule, table [(pos * 2)]);
 		if (pos + 1 == fde_count) {
 			code2 = amodule->llvm_code_end;
 		} else {
 			g_assert (table [(pos + 1) * 2] != -1);
-			code2 = (guint8 *)amodule->methods [table [(pos + 1) * 2]];
+			code2 = (guint8 *)get_method_address (amodule, table [(pos + 1) * 2]);
 		}
 
 		if (code < code1)
@@ -2952,13 +3123,13 @@ decode_llvm_mono_eh_frame (MonoAotModule *amodule, MonoDomain *domain, MonoJitIn
 			break;
 	}
 
-	code_start = (guint8 *)amodule->methods [table [(pos * 2)]];
+	code_start = (guint8 *)get_method_address (amodule, table [(pos * 2)]);
 	if (pos + 1 == fde_count) {
 		/* The +1 entry in the table contains the length of the last method */
 		int len = table [(pos + 1) * 2];
 		code_end = code_start + len;
 	} else {
-		code_end = (guint8 *)amodule->methods [table [(pos + 1) * 2]];
+		code_end = (guint8 *)get_method_address (amodule, table [(pos + 1) * 2]);
 	}
 	if (!code_len)
 		code_len = code_end - code_start;
@@ -3544,10 +3715,12 @@ mono_aot_find_jit_info (MonoDomain *domain, MonoImage *image, gpointer addr)
 		int methods_len = 0;
 
 		for (i = 0; i < nmethods; ++i) {
+			gpointer addr = get_method_address (amodule, i);
+
 			/* Skip the -1 entries to speed up sorting */
-			if (amodule->methods [i] == GINT_TO_POINTER (-1))
+			if (addr == GINT_TO_POINTER (-1))
 				continue;
-			methods [methods_len] = amodule->methods [i];
+			methods [methods_len] = addr;
 			method_indexes [methods_len] = i;
 			methods_len ++;
 		}
@@ -3610,7 +3783,7 @@ mono_aot_find_jit_info (MonoDomain *domain, MonoImage *image, gpointer addr)
 		}
 	}
 
-	code = (guint8 *)amodule->methods [method_index];
+	code = (guint8 *)get_method_address (amodule, method_index);
 	ex_info = &amodule->blob [mono_aot_get_offset (amodule->ex_info_offsets, method_index)];
 
 	if (pos == methods_len - 1) {
@@ -3884,6 +4057,8 @@ decode_patch (MonoAotModule *aot_module, MonoMemPool *mp, MonoJumpInfo *ji, guin
 	case MONO_PATCH_INFO_GC_NURSERY_BITS:
 	case MONO_PATCH_INFO_PROFILER_ALLOCATION_COUNT:
 	case MONO_PATCH_INFO_PROFILER_CLAUSE_COUNT:
+	case MONO_PATCH_INFO_PROFILER_METHOD_ENTER_COUNT:
+	case MONO_PATCH_INFO_PROFILER_METHOD_LEAVE_COUNT:
 		break;
 	case MONO_PATCH_INFO_SPECIFIC_TRAMPOLINE_LAZY_FETCH_ADDR:
 		ji->data.uindex = decode_value (p, &p);
@@ -4079,6 +4254,81 @@ load_patch_info (MonoAotModule *amodule, MonoMemPool *mp, int n_patches,
 	return patches;
 }
 
+static gboolean
+is_eager_bindable_patch (MonoJumpInfoType type)
+{
+	/* Patches which can be resolved without compiling methods or running cctors */
+	switch (type) {
+	case MONO_PATCH_INFO_CLASS:
+	case MONO_PATCH_INFO_IMAGE:
+	case MONO_PATCH_INFO_FIELD:
+	case MONO_PATCH_INFO_VTABLE:
+	case MONO_PATCH_INFO_IID:
+	case MONO_PATCH_INFO_ADJUSTED_IID:
+	case MONO_PATCH_INFO_METHODCONST:
+	case MONO_PATCH_INFO_LDSTR:
+	case MONO_PATCH_INFO_LDTOKEN:
+	case MONO_PATCH_INFO_TYPE_FROM_HANDLE:
+	case MONO_PATCH_INFO_ICALL_ADDR:
+	case MONO_PATCH_INFO_JIT_ICALL_ADDR:
+	case MONO_PATCH_INFO_JIT_ICALL_ADDR_NOCALL:
+		return TRUE;
+	default:
+		return FALSE;
+	}
+}
+
+/*
+ * bind_amodule_got:
+ *
+ *   Resolve the GOT entries of AMODULE listed by is_eager_bindable_patch () in one
+ * pass, instead of one method at a time in init_method (). Enabled by
+ * MONO_DEBUG=aot-eager-binding. Entries which fail to resolve are left alone, so the
+ * error is reported when a method using them is initialized.
+ */
+static void
+bind_amodule_got (MonoAotModule *amodule)
+{
+	MonoMemPool *mp;
+	gpointer *got = amodule->got;
+	int i, nslots, nbound = 0;
+
+	if (!got || amodule->got_bound || mono_atomic_cas_i32 (&amodule->got_bound, 1, 0) != 0)
+		return;
+
+	mp = mono_mempool_new ();
+	nslots = amodule->info.got_size / sizeof (gpointer);
+	for (i = amodule->info.nshared_got_entries; i < nslots; ++i) {
+		ERROR_DECL (error);
+		MonoJumpInfo ji;
+		gpointer addr;
+		guint8 *p;
+
+		if (got [i])
+			continue;
+
+		memset (&ji, 0, sizeof (ji));
+		p = amodule->blob + mono_aot_get_offset (amodule->got_info_offsets, i);
+		ji.type = (MonoJumpInfoType)decode_value (p, &p);
+		if (!is_eager_bindable_patch (ji.type))
+			continue;
+		if (!decode_patch (amodule, mp, &ji, p, &p))
+			continue;
+
+		addr = mono_resolve_patch_target (NULL, mono_get_root_domain (), NULL, &ji, TRUE, error);
+		if (!is_ok (error)) {
+			mono_error_cleanup (error);
+			continue;
+		}
+		mono_memory_barrier ();
+		got [i] = addr;
+		nbound ++;
+	}
+	mono_mempool_destroy (mp);
+
+	mono_trace (G_LOG_LEVEL_DEBUG, MONO_TRACE_AOT, "AOT: bound %d GOT entries of module %s", nbound, amodule->aot_name);
+}
+
 static void
 register_jump_target_got_slot (MonoDomain *domain, MonoMethod *method, gpointer *got_slot)
 {
@@ -4125,6 +4375,9 @@ load_method (MonoDomain *domain, MonoAotModule *amodule, MonoImage *image, MonoM
 		/* Non shared AOT code can't be used in other appdomains */
 		return NULL;
 
+	if (mini_debug_options.aot_eager_binding)
+		bind_amodule_got (amodule);
+
 	if (amodule->out_of_date)
 		return NULL;
 
@@ -4138,12 +4391,12 @@ load_method (MonoDomain *domain, MonoAotModule *amodule, MonoImage *image, MonoM
 
 	if (!code) {
 		if (method_index < amodule->info.nmethods)
-			code = (guint8 *)amodule->methods [method_index];
+			code = (guint8 *)get_method_address (amodule, method_index);
 		else
 			return NULL;
 
 		/* JITted method */
-		if (amodule->methods [method_index] == GINT_TO_POINTER (-1)) {
+		if (code == GINT_TO_POINTER (-1)) {
 			if (mono_trace_is_traced (G_LOG_LEVEL_DEBUG, MONO_TRACE_AOT)) {
 				char *full_name;
 
@@ -4519,7 +4772,7 @@ init_method (MonoAotModule *amodule, guint32 method_index, MonoMethod *method, M
 
 	error_init (error);
 
-	code = (guint8 *)amodule->methods [method_index];
+	code = (guint8 *)get_method_address (amodule, method_index);
 	info = &amodule->blob [mono_aot_get_offset (amodule->method_info_offsets, method_index)];
 
 	p = info;
@@ -5511,6 +5764,12 @@ read_unwind_info (MonoAotModule *amodule, MonoTrampInfo *info, const char *symbo
 #include <mach/mach.h>
 
 static TrampolinePage* trampoline_pages [MONO_AOT_TRAMP_NUM];
+/* Pages allocated as part of a batch which are not used yet */
+static TrampolinePage* spare_trampoline_pages [MONO_AOT_TRAMP_NUM];
+/* The number of pages allocated by the last batch */
+static int trampoline_page_batch [MONO_AOT_TRAMP_NUM];
+
+#define TRAMPOLINE_PAGE_MAX_BATCH 16
 
 static void
 read_page_trampoline_uwinfo (MonoTrampInfo *info, int tramp_type, gboolean is_generic)
@@ -5538,8 +5797,8 @@ get_new_trampoline_from_page (int tramp_type)
 {
 	MonoAotModule *amodule;
 	MonoImage *image;
-	TrampolinePage *page;
-	int count;
+	TrampolinePage *page, *pages, *first;
+	int count, npages, i;
 	void *tpage;
 	vm_address_t addr, taddr;
 	kern_return_t ret;
@@ -5557,6 +5816,20 @@ get_new_trampoline_from_page (int tramp_type)
 		mono_aot_page_unlock ();
 		return code;
 	}
+	/* Use a page left over from an earlier batch */
+	page = spare_trampoline_pages [tramp_type];
+	if (page) {
+		spare_trampoline_pages [tramp_type] = (TrampolinePage*)page->next;
+		page->next = trampoline_pages [tramp_type];
+		trampoline_pages [tramp_type] = page;
+		code = page->trampolines;
+		page->trampolines += specific_trampoline_size;
+		mono_aot_page_unlock ();
+		return code;
+	}
+	/* Allocate pages in geometrically growing batches to reduce the number of vm calls */
+	npages = trampoline_page_batch [tramp_type] ? MIN (trampoline_page_batch [tramp_type] * 2, TRAMPOLINE_PAGE_MAX_BATCH) : 1;
+	trampoline_page_batch [tramp_type] = npages;
 	mono_aot_page_unlock ();
 	/* the trampoline template page is in the mscorlib module */
 	image = mono_defaults.corlib;
@@ -5584,52 +5857,51 @@ get_new_trampoline_from_page (int tramp_type)
 
 	/* avoid the unlikely case of looping forever */
 	count = 40;
-	page = NULL;
-	while (page == NULL && count-- > 0) {
-		MonoTrampInfo *gen_info, *sp_info;
-
+	pages = NULL;
+	while (pages == NULL && count-- > 0) {
 		addr = 0;
-		/* allocate two contiguous pages of memory: the first page will contain the data (like a local constant pool)
+		/* allocate pairs of contiguous pages of memory: the first page of each pair will contain the data (like a local constant pool)
 		 * while the second will contain the trampolines.
 		 */
 		do {
-			ret = vm_allocate (mach_task_self (), &addr, psize * 2, VM_FLAGS_ANYWHERE);
+			ret = vm_allocate (mach_task_self (), &addr, psize * 2 * npages, VM_FLAGS_ANYWHERE);
 		} while (ret == KERN_ABORTED);
 		if (ret != KERN_SUCCESS) {
 			g_error ("Cannot allocate memory for trampolines: %d", ret);
 			break;
 		}
 		/*g_warning ("allocated trampoline double page at %x", addr);*/
-		/* replace the second page with a remapped trampoline page */
-		taddr = addr + psize;
-		vm_deallocate (mach_task_self (), taddr, psize);
-		ret = vm_remap (mach_task_self (), &taddr, psize, 0, FALSE, mach_task_self(), (vm_address_t)tpage, FALSE, &prot, &max_prot, VM_INHERIT_SHARE);
-		if (ret != KERN_SUCCESS) {
-			/* someone else got the page, try again  */
-			vm_deallocate (mach_task_self (), addr, psize);
-			continue;
-		}
-		/*g_warning ("remapped trampoline page at %x", taddr);*/
-
-		mono_aot_page_lock ();
-		page = trampoline_pages [tramp_type];
-		/* some other thread already allocated, so use that to avoid wasting memory */
-		if (page && page->trampolines < page->trampolines_end) {
-			code = page->trampolines;
-			page->trampolines += specific_trampoline_size;
-			mono_aot_page_unlock ();
-			vm_deallocate (mach_task_self (), addr, psize);
+		for (i = 0; i < npages; ++i) {
+			vm_address_t paddr = addr + (i * 2 * psize);
+
+			/* replace the second page with a remapped trampoline page */
+			taddr = paddr + psize;
 			vm_deallocate (mach_task_self (), taddr, psize);
-			return code;
+			ret = vm_remap (mach_task_self (), &taddr, psize, 0, FALSE, mach_task_self(), (vm_address_t)tpage, FALSE, &prot, &max_prot, VM_INHERIT_SHARE);
+			if (ret != KERN_SUCCESS) {
+				/* someone else got the page, give up the rest of the batch */
+				vm_deallocate (mach_task_self (), paddr, psize * 2 * (npages - i));
+				break;
+			}
+			/*g_warning ("remapped trampoline page at %x", taddr);*/
+
+			page = (TrampolinePage*)paddr;
+			page->trampolines = (guint8*)(taddr + amodule->info.tramp_page_code_offsets [tramp_type]);
+			page->trampolines_end = (guint8*)(taddr + psize - 64);
+			page->next = pages;
+			pages = page;
 		}
-		page = (TrampolinePage*)addr;
-		page->next = trampoline_pages [tramp_type];
-		trampoline_pages [tramp_type] = page;
-		page->trampolines = (guint8*)(taddr + amodule->info.tramp_page_code_offsets [tramp_type]);
-		page->trampolines_end = (guint8*)(taddr + psize - 64);
-		code = page->trampolines;
-		page->trampolines += specific_trampoline_size;
-		mono_aot_page_unlock ();
+	}
+	if (!pages) {
+		g_error ("Cannot allocate more trampoline pages: %d", ret);
+		return NULL;
+	}
+
+	for (page = pages; page; page = (TrampolinePage*)page->next) {
+		MonoTrampInfo *gen_info, *sp_info;
+
+		taddr = (vm_address_t)page + psize;
+		trampoline_pages_allocated ++;
 
 		/* Register the generic part at the beggining of the trampoline page */
 		gen_info = mono_tramp_info_create (NULL, (guint8*)taddr, amodule->info.tramp_page_code_offsets [tramp_type], NULL, NULL);
@@ -5643,14 +5915,37 @@ get_new_trampoline_from_page (int tramp_type)
 		 */
 		if (tramp_type != MONO_AOT_TRAMP_SPECIFIC) {
 			/* Register the rest of the page as a single trampoline */
-			sp_info = mono_tramp_info_create (NULL, code, page->trampolines_end - code, NULL, NULL);
+			sp_info = mono_tramp_info_create (NULL, page->trampolines, page->trampolines_end - page->trampolines, NULL, NULL);
 			read_page_trampoline_uwinfo (sp_info, tramp_type, FALSE);
 			mono_aot_tramp_info_register (sp_info, NULL);
 		}
-		return code;
 	}
-	g_error ("Cannot allocate more trampoline pages: %d", ret);
-	return NULL;
+
+	first = pages;
+	mono_aot_page_lock ();
+	/* Queue the rest of the batch */
+	while (pages->next) {
+		page = (TrampolinePage*)pages->next;
+		pages->next = page->next;
+		page->next = spare_trampoline_pages [tramp_type];
+		spare_trampoline_pages [tramp_type] = page;
+	}
+	page = trampoline_pages [tramp_type];
+	if (page && page->trampolines < page->trampolines_end) {
+		/* some other thread already allocated, keep ours for later */
+		first->next = spare_trampoline_pages [tramp_type];
+		spare_trampoline_pages [tramp_type] = first;
+		code = page->trampolines;
+	} else {
+		first->next = trampoline_pages [tramp_type];
+		trampoline_pages [tramp_type] = first;
+		code = first->trampolines;
+		page = first;
+	}
+	page->trampolines += specific_trampoline_size;
+	mono_aot_page_unlock ();
+
+	return code;
 }
 
 #else
@@ -5739,6 +6034,21 @@ get_new_unbox_arbitrary_trampoline_frome_page (gpointer addr)
 	return code;
 }
 
+typedef struct {
+	MonoAotTrampoline tramp_type;
+	MonoAotModule *amodule;
+} FindTrampolineModuleData;
+
+static void
+find_trampoline_module_cb (gpointer key, gpointer value, gpointer user_data)
+{
+	FindTrampolineModuleData *data = (FindTrampolineModuleData*)user_data;
+	MonoAotModule *amodule = (MonoAotModule*)value;
+
+	if (!data->amodule && amodule->trampolines [data->tramp_type] && amodule->trampoline_index [data->tramp_type] < amodule->info.num_trampolines [data->tramp_type])
+		data->amodule = amodule;
+}
+
 /* Return a given kind of trampoline */
 /* FIXME set unwind info for these trampolines */
 static gpointer
@@ -5747,12 +6057,11 @@ get_numerous_trampoline (MonoAotTrampoline tramp_type, int n_got_slots, MonoAotM
 	MonoImage *image;
 	MonoAotModule *amodule = get_mscorlib_aot_module ();
 	int index, tramp_size;
+	static MonoAotModule *overflow_amodule [MONO_AOT_TRAMP_NUM];
 
 	/* Currently, we keep all trampolines in the mscorlib AOT image */
 	image = mono_defaults.corlib;
 
-	*out_amodule = amodule;
-
 	mono_aot_lock ();
 
 #ifdef MONOTOUCH
@@ -5761,13 +6070,33 @@ get_numerous_trampoline (MonoAotTrampoline tramp_type, int n_got_slots, MonoAotM
 #define	MONOTOUCH_TRAMPOLINES_ERROR ""
 #endif
 	if (amodule->trampoline_index [tramp_type] == amodule->info.num_trampolines [tramp_type]) {
-		g_error ("Ran out of trampolines of type %d in '%s' (limit %d)%s\n", 
-				 tramp_type, image ? image->name : MONO_ASSEMBLY_CORLIB_NAME, amodule->info.num_trampolines [tramp_type], MONOTOUCH_TRAMPOLINES_ERROR);
+		/*
+		 * Every full AOT image contains its own set of trampolines, which refer to its own GOT,
+		 * so when mscorlib runs out, continue with the pools of the other loaded images
+		 * instead of aborting.
+		 */
+		amodule = overflow_amodule [tramp_type];
+		if (!amodule || amodule->trampoline_index [tramp_type] == amodule->info.num_trampolines [tramp_type]) {
+			FindTrampolineModuleData data;
+
+			data.tramp_type = tramp_type;
+			data.amodule = NULL;
+			g_hash_table_foreach (aot_modules, find_trampoline_module_cb, &data);
+			amodule = data.amodule;
+			overflow_amodule [tramp_type] = amodule;
+		}
+		if (!amodule)
+			g_error ("Ran out of trampolines of type %d in '%s' (limit %d, %d used in total)%s\n",
+					 tramp_type, image ? image->name : MONO_ASSEMBLY_CORLIB_NAME, get_mscorlib_aot_module ()->info.num_trampolines [tramp_type], numerous_trampolines_used [tramp_type], MONOTOUCH_TRAMPOLINES_ERROR);
+		numerous_trampolines_overflowed ++;
 	}
 	index = amodule->trampoline_index [tramp_type] ++;
+	numerous_trampolines_used [tramp_type] ++;
 
 	mono_aot_unlock ();
 
+	*out_amodule = amodule;
+
 	*got_offset = amodule->info.trampoline_got_offset_base [tramp_type] + (index * n_got_slots);
 
 	tramp_size = amodule->info.trampoline_size [tramp_type];
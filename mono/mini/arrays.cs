@@ -1,5 +1,6 @@
 using System;
 using System.Reflection;
+using System.Runtime.CompilerServices;
 
 /*
  * Regression tests for the mono JIT.
@@ -862,4 +863,239 @@ class Tests
 
 		return r [0];
 	}
+
+	/* Loops which the SIMD pass vectorizes, with trip counts around the vector width */
+	static int[] vec_trip_counts = new int [] { 0, 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 32, 33, 100 };
+
+	[MethodImplAttribute (MethodImplOptions.NoInlining)]
+	static void vec_add (int[] a, int[] b, int[] c, int n) {
+		for (int i = 0; i < n; ++i)
+			c [i] = a [i] + b [i];
+	}
+
+	[MethodImplAttribute (MethodImplOptions.NoInlining)]
+	static void vec_add_from (int[] a, int[] b, int[] c, int start, int n) {
+		for (int i = start; i < n; ++i)
+			c [i] = a [i] + b [i];
+	}
+
+	[MethodImplAttribute (MethodImplOptions.NoInlining)]
+	static void vec_add_ovf (int[] a, int[] b, int[] c, int n) {
+		for (int i = 0; i < n; ++i)
+			c [i] = checked (a [i] + b [i]);
+	}
+
+	[MethodImplAttribute (MethodImplOptions.NoInlining)]
+	static void vec_add_bytes (byte[] a, byte[] b, byte[] c, int n) {
+		for (int i = 0; i < n; ++i)
+			c [i] = (byte)(a [i] + b [i]);
+	}
+
+	[MethodImplAttribute (MethodImplOptions.NoInlining)]
+	static void vec_sub_shorts (short[] a, short[] b, short[] c, int n) {
+		for (int i = 0; i < n; ++i)
+			c [i] = (short)(a [i] - b [i]);
+	}
+
+	[MethodImplAttribute (MethodImplOptions.NoInlining)]
+	static void vec_mul_longs (long[] a, long[] b, long[] c, int n) {
+		for (int i = 0; i < n; ++i)
+			c [i] = a [i] * b [i];
+	}
+
+	[MethodImplAttribute (MethodImplOptions.NoInlining)]
+	static void vec_scale_doubles (double[] a, double[] c, double f, int n) {
+		for (int i = 0; i < n; ++i)
+			c [i] = a [i] * f;
+	}
+
+	[MethodImplAttribute (MethodImplOptions.NoInlining)]
+	static void vec_add_floats (float[] a, float[] b, float[] c, int n) {
+		for (int i = 0; i < n; ++i)
+			c [i] = a [i] + b [i];
+	}
+
+	[MethodImplAttribute (MethodImplOptions.NoInlining)]
+	static void vec_fill (int[] a, int v, int n) {
+		for (int i = 0; i < n; ++i)
+			a [i] = v;
+	}
+
+	[MethodImplAttribute (MethodImplOptions.NoInlining)]
+	static void vec_copy (int[] a, int[] c, int n) {
+		for (int i = 0; i < n; ++i)
+			c [i] = a [i];
+	}
+
+	static int[] vec_ints (int n, int mul) {
+		var a = new int [n];
+		for (int i = 0; i < n; ++i)
+			a [i] = i * mul;
+		return a;
+	}
+
+	public static int test_0_vectorize_trip_counts () {
+		foreach (int n in vec_trip_counts) {
+			/* Longer than the trip count, to check the tail isn't written */
+			var a = vec_ints (n + 5, 3);
+			var b = vec_ints (n + 5, 7);
+			var c = vec_ints (n + 5, -1);
+
+			vec_add (a, b, c, n);
+			for (int i = 0; i < n + 5; ++i) {
+				if (c [i] != (i < n ? i * 10 : -i))
+					return n + 1;
+			}
+
+			vec_fill (c, 42, n);
+			for (int i = 0; i < n + 5; ++i) {
+				if (c [i] != (i < n ? 42 : -i))
+					return 1000 + n;
+			}
+
+			vec_copy (a, c, n);
+			for (int i = 0; i < n + 5; ++i) {
+				if (c [i] != (i < n ? i * 3 : -i))
+					return 2000 + n;
+			}
+		}
+		return 0;
+	}
+
+	public static int test_0_vectorize_start () {
+		var a = vec_ints (20, 1);
+		var b = vec_ints (20, 1);
+		var c = vec_ints (20, -1);
+
+		vec_add_from (a, b, c, 3, 17);
+		for (int i = 0; i < 20; ++i) {
+			if (c [i] != (i >= 3 && i < 17 ? 2 * i : -i))
+				return 1;
+		}
+
+		c = vec_ints (20, -1);
+		try {
+			vec_add_from (a, b, c, -1, 10);
+			return 2;
+		} catch (IndexOutOfRangeException) {
+		}
+		for (int i = 0; i < 20; ++i) {
+			if (c [i] != -i)
+				return 3;
+		}
+		return 0;
+	}
+
+	public static int test_0_vectorize_aliasing () {
+		foreach (int n in vec_trip_counts) {
+			var a = vec_ints (n, 1);
+			var b = vec_ints (n, 2);
+
+			vec_add (a, a, a, n);
+			vec_add (a, b, b, n);
+			for (int i = 0; i < n; ++i) {
+				if (a [i] != 2 * i || b [i] != 4 * i)
+					return n + 1;
+			}
+
+			vec_copy (a, a, n);
+			for (int i = 0; i < n; ++i) {
+				if (a [i] != 2 * i)
+					return 1000 + n;
+			}
+		}
+		return 0;
+	}
+
+	public static int test_0_vectorize_out_of_range () {
+		var a = vec_ints (10, 1);
+		var b = vec_ints (20, 1);
+		var c = vec_ints (20, -1);
+
+		try {
+			vec_add (a, b, c, 13);
+			return 1;
+		} catch (IndexOutOfRangeException) {
+		}
+		/* Every element before the faulting one was written, none after */
+		for (int i = 0; i < 20; ++i) {
+			if (c [i] != (i < 10 ? 2 * i : -i))
+				return 2;
+		}
+		return 0;
+	}
+
+	public static int test_0_vectorize_overflow () {
+		foreach (int n in vec_trip_counts) {
+			if (n < 2)
+				continue;
+			int bad = n / 2;
+			var a = vec_ints (n, 1);
+			var b = vec_ints (n, 1);
+			var c = vec_ints (n, -1);
+
+			a [bad] = int.MaxValue;
+			try {
+				vec_add_ovf (a, b, c, n);
+				return n + 1;
+			} catch (OverflowException) {
+			}
+			for (int i = 0; i < n; ++i) {
+				if (c [i] != (i < bad ? 2 * i : -i))
+					return 1000 + n;
+			}
+		}
+		return 0;
+	}
+
+	public static int test_0_vectorize_element_types () {
+		foreach (int n in vec_trip_counts) {
+			var ba = new byte [n];
+			var bb = new byte [n];
+			var bc = new byte [n];
+			var sa = new short [n];
+			var sb = new short [n];
+			var sc = new short [n];
+			var la = new long [n];
+			var lb = new long [n];
+			var lc = new long [n];
+			var da = new double [n];
+			var dc = new double [n];
+			var fa = new float [n];
+			var fb = new float [n];
+			var fc = new float [n];
+
+			for (int i = 0; i < n; ++i) {
+				ba [i] = (byte)(200 + i);
+				bb [i] = 100;
+				sa [i] = (short)(i - 30000);
+				sb [i] = 5000;
+				la [i] = i + 0x100000000L;
+				lb [i] = 3;
+				da [i] = i;
+				fa [i] = i;
+				fb [i] = 0.5f;
+			}
+
+			vec_add_bytes (ba, bb, bc, n);
+			vec_sub_shorts (sa, sb, sc, n);
+			vec_mul_longs (la, lb, lc, n);
+			vec_scale_doubles (da, dc, 1.5, n);
+			vec_add_floats (fa, fb, fc, n);
+
+			for (int i = 0; i < n; ++i) {
+				if (bc [i] != (byte)(300 + i))
+					return n + 1;
+				if (sc [i] != (short)(i - 35000))
+					return 1000 + n;
+				if (lc [i] != 3 * (i + 0x100000000L))
+					return 2000 + n;
+				if (dc [i] != i * 1.5)
+					return 3000 + n;
+				if (fc [i] != i + 0.5f)
+					return 4000 + n;
+			}
+		}
+		return 0;
+	}
 }
@@ -1477,6 +1477,63 @@ mono_optimize_branches (MonoCompile *cfg)
 	} while (changed && (niterations > 0));
 }
 
+/*
+ * mono_move_cold_bblocks:
+ *
+ *   Move the bblocks marked out_of_line, like throw and ThrowHelper paths, to the
+ * end of the method, keeping their order, so the hot code is laid out densely.
+ * Methods with clauses are left alone since their native try ranges are derived
+ * from the bblock layout.
+ */
+void
+mono_move_cold_bblocks (MonoCompile *cfg)
+{
+	MonoBasicBlock *bb, *prev, *next;
+	MonoBasicBlock *cold = NULL, *cold_last = NULL;
+	MonoInst *ins;
+
+	if (cfg->disable_out_of_line_bblocks || cfg->header->num_clauses)
+		return;
+
+	prev = cfg->bb_entry;
+	for (bb = prev->next_bb; bb; bb = next) {
+		next = bb->next_bb;
+
+		if (!bb->out_of_line || bb == cfg->bb_exit || bb->region != -1) {
+			prev = bb;
+			continue;
+		}
+
+		/* Predecessors falling through keep reaching it */
+		if (!prev->last_ins || !(MONO_IS_BRANCH_OP (prev->last_ins) || prev->last_ins->opcode == OP_NOT_REACHED)) {
+			MONO_INST_NEW (cfg, ins, OP_BR);
+			ins->inst_target_bb = bb;
+			MONO_ADD_INS (prev, ins);
+		}
+
+		/* And so does its own fall through successor */
+		if (next && (!bb->last_ins || !(MONO_IS_BRANCH_OP (bb->last_ins) || bb->last_ins->opcode == OP_NOT_REACHED))) {
+			MONO_INST_NEW (cfg, ins, OP_BR);
+			ins->inst_target_bb = next;
+			MONO_ADD_INS (bb, ins);
+		}
+
+		prev->next_bb = next;
+		bb->next_bb = NULL;
+		if (cold_last)
+			cold_last->next_bb = bb;
+		else
+			cold = bb;
+		cold_last = bb;
+
+		if (cfg->verbose_level > 2)
+			g_print ("moved cold bblock BB%d to the end.\n", bb->block_num);
+	}
+
+	if (cold)
+		prev->next_bb = cold;
+}
+
 #else /* !DISABLE_JIT */
 
 MONO_EMPTY_SOURCE_FILE (branch_opts);
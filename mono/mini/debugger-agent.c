@@ -282,7 +282,7 @@ typedef struct {
 #define HEADER_LENGTH 11
 
 #define MAJOR_VERSION 2
-#define MINOR_VERSION 52
+#define MINOR_VERSION 53
 
 typedef enum {
 	CMD_SET_VM = 1,
@@ -387,7 +387,8 @@ typedef enum {
 typedef enum {
 	CMD_EVENT_REQUEST_SET = 1,
 	CMD_EVENT_REQUEST_CLEAR = 2,
-	CMD_EVENT_REQUEST_CLEAR_ALL_BREAKPOINTS = 3
+	CMD_EVENT_REQUEST_CLEAR_ALL_BREAKPOINTS = 3,
+	CMD_EVENT_REQUEST_GET_TRACE = 4
 } CmdEvent;
 
 typedef enum {
@@ -723,6 +724,7 @@ static gboolean set_set_notification_for_wait_completion_flag (DbgEngineStackFra
 static MonoMethod* get_notify_debugger_of_wait_completion_method (void);
 static void* create_breakpoint_events (GPtrArray *ss_reqs, GPtrArray *bp_reqs, MonoJitInfo *ji, EventKind kind);
 static void process_breakpoint_events (void *_evts, MonoMethod *method, MonoContext *ctx, int il_offset);
+static GSList* filter_breakpoint_events (GSList *events, MonoMethod *method, MonoContext *ctx, int *suspend_policy);
 static int ss_create_init_args (SingleStepReq *ss_req, SingleStepArgs *args);
 static void ss_args_destroy (SingleStepArgs *ss_args);
 
@@ -4545,6 +4547,11 @@ static void
 process_breakpoint_events (void *_evts, MonoMethod *method, MonoContext *ctx, int il_offset)
 {
 	BreakPointEvents *evts = (BreakPointEvents*)_evts;
+
+	/* Conditions, hit counts and tracepoints are evaluated here without a round trip to the client */
+	if (evts->bp_events)
+		evts->bp_events = filter_breakpoint_events (evts->bp_events, method, ctx, &evts->suspend_policy);
+
 	/*
 	 * FIXME: The first event will suspend, so the second will only be sent after the
 	 * resume.
@@ -5919,6 +5926,449 @@ set_interp_var (MonoType *t, gpointer addr, guint8 *val_buf)
 	memcpy (addr, val_buf, size);
 }
 
+/*
+ * Breakpoint modifiers evaluated by the agent when the breakpoint is hit, so the
+ * client is only involved (and the VM only suspended) when they match.
+ */
+
+struct _TraceBuffer {
+	/* The values to record, same encoding as CMD_STACK_FRAME_GET_VALUES */
+	int *positions;
+	int npositions;
+	/* Records are dropped oldest first once there are more than this */
+	int capacity;
+	int dropped;
+	GQueue *records;
+};
+
+typedef struct {
+	int len;
+	guint8 data [MONO_ZERO_LEN_ARRAY];
+} TraceRecord;
+
+/* The frame a breakpoint was hit in, as far as it can be read without unwinding */
+typedef struct {
+	MonoDomain *domain;
+	MonoMethod *method;
+	MonoContext *ctx;
+	MonoDebugMethodJitInfo *jit;
+	MonoMethodSignature *sig;
+	MonoMethodHeader *header;
+	MonoDebugLocalsInfo *locals;
+} BreakpointFrame;
+
+typedef struct {
+	int req_id;
+	int npositions;
+	int *positions;
+} TraceHit;
+
+static TraceBuffer*
+trace_buffer_new (int npositions, int capacity)
+{
+	TraceBuffer *trace = g_new0 (TraceBuffer, 1);
+
+	trace->positions = g_new0 (int, npositions);
+	trace->npositions = npositions;
+	trace->capacity = capacity > 0 ? capacity : 1024;
+	trace->records = g_queue_new ();
+	return trace;
+}
+
+static void
+trace_buffer_free (TraceBuffer *trace)
+{
+	TraceRecord *record;
+
+	while ((record = (TraceRecord *)g_queue_pop_head (trace->records)))
+		g_free (record);
+	g_queue_free (trace->records);
+	g_free (trace->positions);
+	g_free (trace);
+}
+
+static void
+event_request_free (EventRequest *req)
+{
+	int i;
+
+	for (i = 0; i < req->nmodifiers; ++i) {
+		if (req->modifiers [i].kind == MOD_KIND_TRACE && req->modifiers [i].data.trace)
+			trace_buffer_free (req->modifiers [i].data.trace);
+	}
+	g_free (req);
+}
+
+/*
+ * LOCKING: Assumes the loader lock is held.
+ */
+static EventRequest*
+find_event_request (int req_id)
+{
+	int i;
+
+	for (i = 0; i < event_requests->len; ++i) {
+		EventRequest *req = (EventRequest *)g_ptr_array_index (event_requests, i);
+
+		if (req->id == req_id)
+			return req;
+	}
+	return NULL;
+}
+
+static gboolean
+has_agent_modifiers (EventRequest *req)
+{
+	int i;
+
+	for (i = 0; i < req->nmodifiers; ++i) {
+		ModifierKind kind = req->modifiers [i].kind;
+
+		if (kind == MOD_KIND_HIT_COUNT || kind == MOD_KIND_CONDITION || kind == MOD_KIND_TRACE)
+			return TRUE;
+	}
+	return FALSE;
+}
+
+static void
+breakpoint_frame_init (BreakpointFrame *frame, MonoMethod *method, MonoContext *ctx)
+{
+	MonoJitInfo *ji;
+	ERROR_DECL (error);
+
+	memset (frame, 0, sizeof (BreakpointFrame));
+	frame->domain = mono_domain_get ();
+	frame->method = method;
+	frame->ctx = ctx;
+
+	/* Interpreter frames need the full frame machinery, the client evaluates those */
+	ji = mini_jit_info_table_find (frame->domain, (char*)MONO_CONTEXT_GET_IP (ctx), NULL);
+	if (!ji || ji->is_interp)
+		return;
+
+	frame->jit = mono_debug_find_method (method, frame->domain);
+	if (!frame->jit && method->is_inflated)
+		frame->jit = mono_debug_find_method (mono_method_get_declaring_generic_method (method), frame->domain);
+	if (!frame->jit)
+		return;
+
+	frame->sig = mono_method_signature_internal (method);
+	frame->header = mono_method_get_header_checked (method, error);
+	mono_error_cleanup (error);
+	frame->locals = mono_debug_lookup_locals (method);
+}
+
+static void
+breakpoint_frame_cleanup (BreakpointFrame *frame)
+{
+	if (frame->jit)
+		mono_debug_free_method_jit_info (frame->jit);
+	if (frame->header)
+		mono_metadata_free_mh (frame->header);
+	if (frame->locals)
+		mono_debug_free_locals (frame->locals);
+}
+
+/*
+ * breakpoint_frame_get_var:
+ *
+ *   Return the type and location of the argument or local at POS, or FALSE if
+ * it can't be read from the registers and stack slots of the frame alone.
+ */
+static gboolean
+breakpoint_frame_get_var (BreakpointFrame *frame, int pos, MonoType **type, MonoDebugVarInfo **var)
+{
+	guint32 flags;
+
+	if (!frame->jit)
+		return FALSE;
+
+	if (pos < 0) {
+		pos = - pos - 1;
+		if (pos >= frame->jit->num_params || pos >= frame->sig->param_count)
+			return FALSE;
+		*type = frame->sig->params [pos];
+		*var = &frame->jit->params [pos];
+	} else {
+		if (frame->locals) {
+			if (pos >= frame->locals->num_locals)
+				return FALSE;
+			pos = frame->locals->locals [pos].index;
+		}
+		if (!frame->header || pos >= frame->jit->num_locals || pos >= frame->header->num_locals)
+			return FALSE;
+		*type = frame->header->locals [pos];
+		*var = &frame->jit->locals [pos];
+	}
+
+	flags = (*var)->index & MONO_DEBUG_VAR_ADDRESS_MODE_FLAGS;
+	switch (flags) {
+	case MONO_DEBUG_VAR_ADDRESS_MODE_REGISTER:
+	case MONO_DEBUG_VAR_ADDRESS_MODE_REGOFFSET:
+	case MONO_DEBUG_VAR_ADDRESS_MODE_REGOFFSET_INDIR:
+	case MONO_DEBUG_VAR_ADDRESS_MODE_VTADDR:
+		return TRUE;
+	default:
+		return FALSE;
+	}
+}
+
+/*
+ * breakpoint_frame_get_int_value:
+ *
+ *   Read the argument or local at POS as an integer. Only integral types,
+ * enums and references (compared by address, for null checks) are supported.
+ */
+static gboolean
+breakpoint_frame_get_int_value (BreakpointFrame *frame, int pos, gint64 *value)
+{
+	MonoType *t;
+	MonoDebugVarInfo *var;
+	host_mgreg_t reg_val;
+	guint8 *addr;
+	int reg;
+
+	if (!breakpoint_frame_get_var (frame, pos, &t, &var) || t->byref)
+		return FALSE;
+
+	reg = var->index & ~MONO_DEBUG_VAR_ADDRESS_MODE_FLAGS;
+	switch (var->index & MONO_DEBUG_VAR_ADDRESS_MODE_FLAGS) {
+	case MONO_DEBUG_VAR_ADDRESS_MODE_REGISTER:
+		reg_val = mono_arch_context_get_int_reg (frame->ctx, reg);
+		addr = (guint8*)&reg_val;
+		break;
+	case MONO_DEBUG_VAR_ADDRESS_MODE_REGOFFSET:
+		addr = (guint8 *)mono_arch_context_get_int_reg (frame->ctx, reg) + (gint32)var->offset;
+		break;
+	default:
+		addr = (guint8 *)mono_arch_context_get_int_reg (frame->ctx, reg) + (gint32)var->offset;
+		addr = (guint8 *)*(gpointer*)addr;
+		if (!addr)
+			return FALSE;
+		break;
+	}
+
+	if (MONO_TYPE_IS_REFERENCE (t)) {
+		*value = (gint64)(gsize)*(gpointer*)addr;
+		return TRUE;
+	}
+
+	t = mini_get_underlying_type (t);
+	switch (t->type) {
+	case MONO_TYPE_BOOLEAN:
+	case MONO_TYPE_U1:
+		*value = *(guint8*)addr;
+		break;
+	case MONO_TYPE_I1:
+		*value = *(gint8*)addr;
+		break;
+	case MONO_TYPE_CHAR:
+	case MONO_TYPE_U2:
+		*value = *(guint16*)addr;
+		break;
+	case MONO_TYPE_I2:
+		*value = *(gint16*)addr;
+		break;
+	case MONO_TYPE_U4:
+		*value = *(guint32*)addr;
+		break;
+	case MONO_TYPE_I4:
+		*value = *(gint32*)addr;
+		break;
+	case MONO_TYPE_I8:
+	case MONO_TYPE_U8:
+		*value = *(gint64*)addr;
+		break;
+	case MONO_TYPE_I:
+	case MONO_TYPE_U:
+	case MONO_TYPE_PTR:
+		*value = (gint64)*(gssize*)addr;
+		break;
+	default:
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static gboolean
+condition_matches (BreakpointFrame *frame, Modifier *mod)
+{
+	gint64 value, target = mod->data.condition.value;
+
+	/* Let the client see hits it could evaluate itself */
+	if (!breakpoint_frame_get_int_value (frame, mod->data.condition.pos, &value))
+		return TRUE;
+
+	switch (mod->data.condition.op) {
+	case CONDITION_OP_EQ: return value == target;
+	case CONDITION_OP_NE: return value != target;
+	case CONDITION_OP_LT: return value < target;
+	case CONDITION_OP_LE: return value <= target;
+	case CONDITION_OP_GT: return value > target;
+	case CONDITION_OP_GE: return value >= target;
+	default: return TRUE;
+	}
+}
+
+static gboolean
+hit_count_matches (Modifier *mod)
+{
+	int hits = ++mod->data.hit_count.hits;
+	int count = mod->data.hit_count.count;
+
+	switch (mod->data.hit_count.op) {
+	case HIT_COUNT_EQUAL: return hits == count;
+	case HIT_COUNT_GREATER_OR_EQUAL: return hits >= count;
+	case HIT_COUNT_MULTIPLE_OF: return count > 0 && hits % count == 0;
+	default: return TRUE;
+	}
+}
+
+/*
+ * record_trace:
+ *
+ *   Record the current thread, a timestamp and the values requested by the
+ * tracepoint in HIT into its trace buffer, without suspending anything.
+ */
+static void
+record_trace (TraceHit *hit, BreakpointFrame *frame)
+{
+	Buffer buf;
+	EventRequest *req;
+	TraceRecord *record;
+	MonoType *t;
+	MonoDebugVarInfo *var;
+	gboolean readable = TRUE;
+	int i;
+
+	for (i = 0; i < hit->npositions; ++i) {
+		if (!breakpoint_frame_get_var (frame, hit->positions [i], &t, &var))
+			readable = FALSE;
+	}
+
+	buffer_init (&buf, 128);
+	buffer_add_objid (&buf, (MonoObject*)mono_thread_current ());
+	buffer_add_long (&buf, mono_100ns_ticks ());
+	buffer_add_byte (&buf, readable);
+	if (readable) {
+		buffer_add_int (&buf, hit->npositions);
+		for (i = 0; i < hit->npositions; ++i) {
+			breakpoint_frame_get_var (frame, hit->positions [i], &t, &var);
+			add_var (&buf, frame->jit, t, var, frame->ctx, frame->domain, FALSE);
+		}
+	}
+
+	record = (TraceRecord *)g_malloc (G_STRUCT_OFFSET (TraceRecord, data) + buffer_len (&buf));
+	record->len = buffer_len (&buf);
+	memcpy (record->data, buf.buf, record->len);
+	buffer_free (&buf);
+
+	mono_loader_lock ();
+	req = find_event_request (hit->req_id);
+	for (i = 0; req && i < req->nmodifiers; ++i) {
+		TraceBuffer *trace = req->modifiers [i].data.trace;
+
+		if (req->modifiers [i].kind != MOD_KIND_TRACE)
+			continue;
+		if (trace->records->length >= (guint)trace->capacity) {
+			g_free (g_queue_pop_head (trace->records));
+			trace->dropped ++;
+		}
+		g_queue_push_tail (trace->records, record);
+		record = NULL;
+		break;
+	}
+	mono_loader_unlock ();
+
+	/* The request was cleared in the meantime */
+	g_free (record);
+}
+
+/*
+ * filter_breakpoint_events:
+ *
+ *   Apply the MOD_KIND_CONDITION, MOD_KIND_HIT_COUNT and MOD_KIND_TRACE modifiers
+ * of the breakpoint requests in EVENTS, which need the frame of the hit. Return
+ * the requests which still need to be reported to the client, and their suspend
+ * policy in SUSPEND_POLICY. Tracepoints are recorded and never reported.
+ */
+static GSList*
+filter_breakpoint_events (GSList *events, MonoMethod *method, MonoContext *ctx, int *suspend_policy)
+{
+	BreakpointFrame frame;
+	GSList *l, *res = NULL, *traces = NULL;
+	gboolean needed = FALSE;
+	int i;
+
+	mono_loader_lock ();
+	for (l = events; l; l = l->next) {
+		EventRequest *req = find_event_request (GPOINTER_TO_INT (l->data));
+
+		if (req && has_agent_modifiers (req))
+			needed = TRUE;
+	}
+	mono_loader_unlock ();
+
+	if (!needed)
+		return events;
+
+	breakpoint_frame_init (&frame, method, ctx);
+
+	*suspend_policy = SUSPEND_POLICY_NONE;
+	mono_loader_lock ();
+	for (l = events; l; l = l->next) {
+		EventRequest *req = find_event_request (GPOINTER_TO_INT (l->data));
+		Modifier *trace = NULL;
+		gboolean filtered = FALSE;
+
+		if (!req)
+			continue;
+
+		/* Hit counts only count the hits that satisfy the conditions */
+		for (i = 0; i < req->nmodifiers && !filtered; ++i) {
+			if (req->modifiers [i].kind == MOD_KIND_CONDITION && !condition_matches (&frame, &req->modifiers [i]))
+				filtered = TRUE;
+		}
+		for (i = 0; i < req->nmodifiers && !filtered; ++i) {
+			Modifier *mod = &req->modifiers [i];
+
+			if (mod->kind == MOD_KIND_HIT_COUNT && !hit_count_matches (mod))
+				filtered = TRUE;
+			else if (mod->kind == MOD_KIND_TRACE)
+				trace = mod;
+		}
+		if (filtered)
+			continue;
+
+		if (trace) {
+			TraceHit *hit = g_new0 (TraceHit, 1);
+
+			hit->req_id = req->id;
+			hit->npositions = trace->data.trace->npositions;
+			hit->positions = (int *)g_memdup (trace->data.trace->positions, hit->npositions * sizeof (int));
+			traces = g_slist_prepend (traces, hit);
+		} else {
+			*suspend_policy = MAX (*suspend_policy, req->suspend_policy);
+			res = g_slist_append (res, l->data);
+		}
+	}
+	mono_loader_unlock ();
+
+	/* Values are read outside the loader lock, since object ids take other locks */
+	for (l = traces; l; l = l->next) {
+		TraceHit *hit = (TraceHit *)l->data;
+
+		record_trace (hit, &frame);
+		g_free (hit->positions);
+		g_free (hit);
+	}
+	g_slist_free (traces);
+
+	breakpoint_frame_cleanup (&frame);
+	g_slist_free (events);
+	return res;
+}
+
 static void
 clear_event_request (int req_id, int etype)
 {
@@ -5939,7 +6389,7 @@ clear_event_request (int req_id, int etype)
 			if (req->event_kind == EVENT_KIND_METHOD_EXIT)
 				mono_de_clear_breakpoint ((MonoBreakpoint *)req->info);
 			g_ptr_array_remove_index_fast (event_requests, i);
-			g_free (req);
+			event_request_free (req);
 			break;
 		}
 	}
@@ -7031,7 +7481,7 @@ event_commands (int command, guint8 *p, guint8 *end, Buffer *buf)
 
 				err = get_object (id, (MonoObject**)&req->modifiers [i].data.thread);
 				if (err != ERR_NONE) {
-					g_free (req);
+					event_request_free (req);
 					return err;
 				}
 			} else if (mod == MOD_KIND_EXCEPTION_ONLY) {
@@ -7050,7 +7500,7 @@ event_commands (int command, guint8 *p, guint8 *end, Buffer *buf)
 					req->modifiers [i].data.exc_class = exc_class;
 
 					if (!mono_class_is_assignable_from_internal (mono_defaults.exception_class, exc_class)) {
-						g_free (req);
+						event_request_free (req);
 						return ERR_INVALID_ARGUMENT;
 					}
 				}
@@ -7095,8 +7545,27 @@ event_commands (int command, guint8 *p, guint8 *end, Buffer *buf)
 					if (s)
 						g_hash_table_insert (modifier->data.type_names, s, s);
 				}
+			} else if (mod == MOD_KIND_HIT_COUNT && event_kind == EVENT_KIND_BREAKPOINT) {
+				req->modifiers [i].data.hit_count.op = (HitCountOp)decode_byte (p, &p, end);
+				req->modifiers [i].data.hit_count.count = decode_int (p, &p, end);
+			} else if (mod == MOD_KIND_CONDITION && event_kind == EVENT_KIND_BREAKPOINT) {
+				req->modifiers [i].data.condition.pos = decode_int (p, &p, end);
+				req->modifiers [i].data.condition.op = (ConditionOp)decode_byte (p, &p, end);
+				req->modifiers [i].data.condition.value = (gint64)decode_long (p, &p, end);
+			} else if (mod == MOD_KIND_TRACE && event_kind == EVENT_KIND_BREAKPOINT) {
+				int capacity = decode_int (p, &p, end);
+				int n = decode_int (p, &p, end);
+				int j;
+
+				if (n < 0) {
+					event_request_free (req);
+					return ERR_INVALID_ARGUMENT;
+				}
+				req->modifiers [i].data.trace = trace_buffer_new (n, capacity);
+				for (j = 0; j < n; ++j)
+					req->modifiers [i].data.trace->positions [j] = decode_int (p, &p, end);
 			} else {
-				g_free (req);
+				event_request_free (req);
 				return ERR_NOT_IMPLEMENTED;
 			}
 		}
@@ -7106,7 +7575,7 @@ event_commands (int command, guint8 *p, guint8 *end, Buffer *buf)
 
 			req->info = mono_de_set_breakpoint (method, location, req, error);
 			if (!mono_error_ok (error)) {
-				g_free (req);
+				event_request_free (req);
 				DEBUG_PRINTF (1, "[dbg] Failed to set breakpoint: %s\n", mono_error_get_message (error));
 				mono_error_cleanup (error);
 				return ERR_NO_SEQ_POINT_AT_IL_OFFSET;
@@ -7116,13 +7585,13 @@ event_commands (int command, guint8 *p, guint8 *end, Buffer *buf)
 
 			err = get_object (step_thread_id, (MonoObject**)&step_thread);
 			if (err != ERR_NONE) {
-				g_free (req);
+				event_request_free (req);
 				return err;
 			}
 
 			err = (ErrorCode)mono_de_ss_create (THREAD_TO_INTERNAL (step_thread), size, depth, filter, req);
 			if (err != ERR_NONE) {
-				g_free (req);
+				event_request_free (req);
 				return err;
 			}
 		} else if (req->event_kind == EVENT_KIND_METHOD_ENTRY) {
@@ -7133,7 +7602,7 @@ event_commands (int command, guint8 *p, guint8 *end, Buffer *buf)
 		} else if (req->event_kind == EVENT_KIND_TYPE_LOAD) {
 		} else {
 			if (req->nmodifiers) {
-				g_free (req);
+				event_request_free (req);
 				return ERR_NOT_IMPLEMENTED;
 			}
 		}
@@ -7179,6 +7648,34 @@ event_commands (int command, guint8 *p, guint8 *end, Buffer *buf)
 		mono_loader_unlock ();
 		break;
 	}
+	case CMD_EVENT_REQUEST_GET_TRACE: {
+		int req_id = decode_int (p, &p, end);
+		EventRequest *req;
+		TraceBuffer *trace = NULL;
+		TraceRecord *record;
+		int i;
+
+		/* Return and clear the records collected by a MOD_KIND_TRACE breakpoint */
+		mono_loader_lock ();
+		req = find_event_request (req_id);
+		for (i = 0; req && i < req->nmodifiers; ++i) {
+			if (req->modifiers [i].kind == MOD_KIND_TRACE)
+				trace = req->modifiers [i].data.trace;
+		}
+		if (!trace) {
+			mono_loader_unlock ();
+			return ERR_INVALID_ARGUMENT;
+		}
+		buffer_add_int (buf, trace->dropped);
+		buffer_add_int (buf, trace->records->length);
+		while ((record = (TraceRecord *)g_queue_pop_head (trace->records))) {
+			buffer_add_data (buf, record->data, record->len);
+			g_free (record);
+		}
+		trace->dropped = 0;
+		mono_loader_unlock ();
+		break;
+	}
 	case CMD_EVENT_REQUEST_CLEAR_ALL_BREAKPOINTS: {
 		int i;
 
@@ -7191,7 +7688,7 @@ event_commands (int command, guint8 *p, guint8 *end, Buffer *buf)
 				mono_de_clear_breakpoint ((MonoBreakpoint *)req->info);
 
 				g_ptr_array_remove_index_fast (event_requests, i);
-				g_free (req);
+				event_request_free (req);
 			} else {
 				i ++;
 			}
@@ -9438,7 +9935,8 @@ static const char* thread_cmds_str[] = {
 static const char* event_cmds_str[] = {
 	"REQUEST_SET",
 	"REQUEST_CLEAR",
-	"REQUEST_CLEAR_ALL_BREAKPOINTS"
+	"REQUEST_CLEAR_ALL_BREAKPOINTS",
+	"REQUEST_GET_TRACE"
 };
 
 static const char* appdomain_cmds_str[] = {
@@ -46,9 +46,31 @@ typedef enum {
 	MOD_KIND_ASSEMBLY_ONLY = 11,
 	MOD_KIND_SOURCE_FILE_ONLY = 12,
 	MOD_KIND_TYPE_NAME_ONLY = 13,
-	MOD_KIND_NONE = 14
+	MOD_KIND_NONE = 14,
+	MOD_KIND_HIT_COUNT = 15,
+	MOD_KIND_CONDITION = 16,
+	MOD_KIND_TRACE = 17
 } ModifierKind;
 
+/* For kind == MOD_KIND_HIT_COUNT */
+typedef enum {
+	HIT_COUNT_EQUAL = 0,
+	HIT_COUNT_GREATER_OR_EQUAL = 1,
+	HIT_COUNT_MULTIPLE_OF = 2
+} HitCountOp;
+
+/* For kind == MOD_KIND_CONDITION */
+typedef enum {
+	CONDITION_OP_EQ = 0,
+	CONDITION_OP_NE = 1,
+	CONDITION_OP_LT = 2,
+	CONDITION_OP_LE = 3,
+	CONDITION_OP_GT = 4,
+	CONDITION_OP_GE = 5
+} ConditionOp;
+
+typedef struct _TraceBuffer TraceBuffer;
+
 typedef enum {
 	STEP_DEPTH_INTO = 0,
 	STEP_DEPTH_OVER = 1,
@@ -78,6 +100,17 @@ typedef struct {
 		GHashTable *source_files; /* For kind == MONO_KIND_SOURCE_FILE_ONLY */
 		GHashTable *type_names; /* For kind == MONO_KIND_TYPE_NAME_ONLY */
 		StepFilter filter; /* For kind == MOD_KIND_STEP */
+		struct {
+			HitCountOp op;
+			int count, hits;
+		} hit_count; /* For kind == MOD_KIND_HIT_COUNT */
+		struct {
+			/* Same encoding as CMD_STACK_FRAME_GET_VALUES, negative values are arguments */
+			int pos;
+			ConditionOp op;
+			gint64 value;
+		} condition; /* For kind == MOD_KIND_CONDITION */
+		TraceBuffer *trace; /* For kind == MOD_KIND_TRACE */
 	} data;
 	gboolean caught, uncaught, subclasses; /* For kind == MOD_KIND_EXCEPTION_ONLY */
 } Modifier;
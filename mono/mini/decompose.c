@@ -1575,7 +1575,9 @@ mono_decompose_array_access_opts (MonoCompile *cfg)
 						MONO_INST_NEW (cfg, iargs [1], OP_MOVE);
 						iargs [1]->dreg = ins->sreg1;
 
-						if (managed_alloc)
+						if (ins->flags & MONO_INST_UNINIT)
+							dest = mono_emit_jit_icall (cfg, ves_icall_array_new_uninitialized_specific, iargs);
+						else if (managed_alloc)
 							dest = mono_emit_method_call (cfg, managed_alloc, iargs, NULL);
 						else
 							dest = mono_emit_jit_icall (cfg, ves_icall_array_new_specific, iargs);
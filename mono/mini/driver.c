@@ -132,7 +132,7 @@ static const gint16 opt_names [] = {
 	MONO_OPT_AOT | \
 	MONO_OPT_FLOAT32)
 
-#define EXCLUDED_FROM_ALL (MONO_OPT_SHARED | MONO_OPT_PRECOMP | MONO_OPT_UNSAFE | MONO_OPT_GSHAREDVT)
+#define EXCLUDED_FROM_ALL (MONO_OPT_SHARED | MONO_OPT_PRECOMP | MONO_OPT_UNSAFE | MONO_OPT_GSHAREDVT | MONO_OPT_OUTLINE)
 
 static char *mono_parse_options (const char *options, int *ref_argc, char **ref_argv [], gboolean prepend);
 static char *mono_parse_response_options (const char *options, int *ref_argc, char **ref_argv [], gboolean prepend);
@@ -1276,6 +1276,9 @@ mono_jit_exec_internal (MonoDomain *domain, MonoAssembly *assembly, int argc, ch
 	ERROR_DECL (error);
 	MonoImage *image = mono_assembly_get_image_internal (assembly);
 
+	mono_assembly_preload_references (image);
+	mini_startup_trace_start ();
+
     // We need to ensure that any module cctor for this image
     // is run *before* we invoke the entry point
     // For more information, see https://blogs.msdn.microsoft.com/junfeng/2005/11/19/module-initializer-a-k-a-module-constructor/
@@ -1549,6 +1552,7 @@ mini_usage (void)
 		"    --profile[=profiler]   Runs in profiling mode with the specified profiler module\n"
 		"    --trace[=EXPR]         Enable tracing, use --help-trace for details\n"
 		"    --jitmap               Output a jit method map to /tmp/perf-PID.map\n"
+		"    --jitdump              Output a perf jitdump file to /tmp/jit-PID.dump\n"
 		"    --help-devel           Shows more options available to developers\n"
 		"\n"
 		"Runtime:\n"
@@ -1563,6 +1567,16 @@ mini_usage (void)
 		"    --attach=OPTIONS       Pass OPTIONS to the attach agent in the runtime.\n"
 		"                           Currently the only supported option is 'disable'.\n"
 		"    --llvm, --nollvm       Controls whenever the runtime uses LLVM to compile code.\n"
+		"    --tiered[=CALLS]       Compile methods cheaply first, and with all optimizations\n"
+		"                           once they have been called CALLS times (default 1000).\n"
+		"    --tiered-llvm          Like --tiered, but recompile the hot methods using LLVM.\n"
+		"    --jit-threads=N        Use N threads to recompile hot methods in the background\n"
+		"                           (default 1).\n"
+		"    --jit-startup-trace=FILE[,SECONDS]  Record the methods JITted in the first SECONDS\n"
+		"                           (default 10) into FILE, or if FILE exists, JIT them ahead\n"
+		"                           of use on --jit-threads background threads.\n"
+		"    --gsharedvt-specialize=N  JIT code specialized for value type instantiations once\n"
+		"                           their gsharedvt AOT code was looked up N times (default 0, off).\n"
 	        "    --gc=[sgen,boehm]      Select SGen or Boehm GC (runs mono or mono-sgen)\n"
 #ifdef TARGET_OSX
 		"    --arch=[32,64]         Select architecture (runs mono32 or mono64)\n"
@@ -2228,6 +2242,8 @@ mono_main (int argc, char* argv[])
 			forced_version = &argv [i][10];
 		} else if (strcmp (argv [i], "--jitmap") == 0) {
 			mono_enable_jit_map ();
+		} else if (strcmp (argv [i], "--jitdump") == 0) {
+			mono_enable_jitdump ();
 		} else if (strcmp (argv [i], "--profile") == 0) {
 			mini_add_profiler_argument (NULL);
 		} else if (strncmp (argv [i], "--profile=", 10) == 0) {
@@ -2351,6 +2367,52 @@ mono_main (int argc, char* argv[])
 		} else if (strncmp (argv [i], "--interp=", 9) == 0) {
 			mono_runtime_set_execution_mode_full (MONO_EE_MODE_INTERP, FALSE);
 			mono_interp_opts_string = argv [i] + 9;
+		} else if (strcmp (argv [i], "--tiered") == 0) {
+			mono_tiered_compilation = TRUE;
+		} else if (strcmp (argv [i], "--tiered-llvm") == 0) {
+			mono_tiered_compilation = TRUE;
+#ifndef MONO_ARCH_LLVM_SUPPORTED
+			fprintf (stderr, "Mono Warning: --tiered-llvm not supported on this platform, hot methods will be recompiled by the JIT.\n");
+#elif !defined(ENABLE_LLVM)
+			fprintf (stderr, "Mono Warning: --tiered-llvm not enabled in this runtime, hot methods will be recompiled by the JIT.\n");
+#else
+			mono_tier_up_llvm = TRUE;
+#endif
+		} else if (strncmp (argv [i], "--tiered=", 9) == 0) {
+			mono_tiered_compilation = TRUE;
+			mono_tier_up_threshold = atoi (argv [i] + 9);
+			if (mono_tier_up_threshold <= 0) {
+				fprintf (stderr, "Invalid --tiered call count `%s'\n", argv [i] + 9);
+				return 1;
+			}
+		} else if (strncmp (argv [i], "--jit-threads=", 14) == 0) {
+			char *end;
+			long threads = strtol (argv [i] + 14, &end, 10);
+
+			if (end == argv [i] + 14 || *end || threads <= 0 || threads > G_MAXINT32) {
+				fprintf (stderr, "Invalid --jit-threads count `%s'\n", argv [i] + 14);
+				return 1;
+			}
+			mono_jit_worker_threads = (int)threads;
+		} else if (strncmp (argv [i], "--jit-startup-trace=", 20) == 0) {
+			char *seconds;
+
+			mono_jit_startup_trace_file = g_strdup (argv [i] + 20);
+			seconds = strrchr (mono_jit_startup_trace_file, ',');
+			if (seconds) {
+				*seconds = '\0';
+				mono_jit_startup_trace_seconds = atoi (seconds + 1);
+				if (mono_jit_startup_trace_seconds <= 0) {
+					fprintf (stderr, "Invalid --jit-startup-trace time `%s'\n", seconds + 1);
+					return 1;
+				}
+			}
+		} else if (strncmp (argv [i], "--gsharedvt-specialize=", 23) == 0) {
+			mono_gsharedvt_specialize_threshold = atoi (argv [i] + 23);
+			if (mono_gsharedvt_specialize_threshold < 0) {
+				fprintf (stderr, "Invalid --gsharedvt-specialize count `%s'\n", argv [i] + 23);
+				return 1;
+			}
 		} else if (strcmp (argv [i], "--print-icall-table") == 0) {
 #ifdef ENABLE_ICALL_SYMBOL_MAP
 			print_icall_table ();
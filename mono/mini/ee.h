@@ -15,7 +15,7 @@
 #ifndef __MONO_EE_H__
 #define __MONO_EE_H__
 
-#define MONO_EE_API_VERSION 0xc
+#define MONO_EE_API_VERSION 0xd
 
 typedef struct _MonoInterpStackIter MonoInterpStackIter;
 
@@ -56,6 +56,8 @@ typedef gpointer MonoInterpFrameHandle;
 	MONO_EE_CALLBACK (MonoInterpFrameHandle, frame_get_parent, (MonoInterpFrameHandle frame)) \
 	MONO_EE_CALLBACK (void, start_single_stepping, (void)) \
 	MONO_EE_CALLBACK (void, stop_single_stepping, (void)) \
+	MONO_EE_CALLBACK (void, free_context, (gpointer context)) \
+	MONO_EE_CALLBACK (void, get_stack_range, (gpointer context, gpointer *start, gpointer *end)) \
 
 typedef struct _MonoEECallbacks {
 
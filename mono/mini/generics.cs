@@ -234,6 +234,28 @@ class Tests
 		return 0;
 	}
 
+	static int BoxIsInstUnbox<T> (T value) {
+		if (value is int)
+			return (int)(object)value;
+		return -1;
+	}
+
+	static T BoxUnbox<T> (T value) {
+		return (T)(object)value;
+	}
+
+	public static int test_0_box_isinst_unbox_optimizations () {
+		if (BoxIsInstUnbox<int> (42) != 42)
+			return 1;
+		if (BoxIsInstUnbox<long> (42) != -1)
+			return 2;
+		if (BoxIsInstUnbox<string> ("42") != -1)
+			return 3;
+		if (BoxUnbox<double> (1.5) != 1.5)
+			return 4;
+		return 0;
+	}
+
 	[Category ("!FULLAOT")]
 	public static int test_0_generic_get_value_optimization_int () {
 		int[] x = new int[] {100, 200};
@@ -81,6 +81,18 @@ stub_stop_single_stepping (void)
 {
 }
 
+static void
+stub_free_context (gpointer context)
+{
+	g_assert_not_reached ();
+}
+
+static void
+stub_get_stack_range (gpointer context, gpointer *start, gpointer *end)
+{
+	g_assert_not_reached ();
+}
+
 static void
 stub_set_resume_state (MonoJitTlsData *jit_tls, MonoException *ex, MonoJitExceptionInfo *ei, MonoInterpFrameHandle interp_frame, gpointer handler_ip)
 {
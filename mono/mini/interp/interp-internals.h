@@ -39,7 +39,11 @@ enum {
 };
 
 enum {
-	INTERP_OPT_INLINE = 1
+	INTERP_OPT_INLINE = 1,
+	INTERP_OPT_CPROP = 2,
+	INTERP_OPT_SUPER_INSTRUCTIONS = 4,
+	INTERP_OPT_TIERING = 8,
+	INTERP_OPT_JITERPRETER = 16
 };
 
 #if SIZEOF_VOID_P == 4
@@ -115,9 +119,11 @@ typedef struct _InterpMethod
 	guint32 *exvar_offsets;
 	unsigned int param_count;
 	unsigned int hasthis;
-	gpointer jit_wrapper;
-	gpointer jit_addr;
-	MonoMethodSignature *jit_sig;
+	gpointer jit_call_info;
+	/* Hotness counters used to decide when to tier up to JIT code */
+	gint32 call_count;
+	gint32 backedge_count;
+	gboolean tier_up_failed;
 	gpointer jit_entry;
 	gpointer llvmonly_unbox_entry;
 	MonoType *rtype;
@@ -127,6 +133,30 @@ typedef struct _InterpMethod
 	MonoProfilerCallInstrumentationFlags prof_flags;
 } InterpMethod;
 
+#define INTERP_STACK_SIZE (256 * 1024)
+
+typedef struct _InterpStackFrameHeader InterpStackFrameHeader;
+struct _InterpStackFrameHeader {
+	InterpStackFrameHeader *prev;
+	/* Address on the C stack of the interp_exec_method_full () activation owning the frame */
+	gpointer c_frame;
+};
+
+#define INTERP_INLINE_CACHE_SIZE 4
+
+typedef struct {
+	MonoVTable *vtable;
+	InterpMethod *target_imethod;
+} InterpInlineCacheEntry;
+
+/*
+ * Per call site cache of the targets of a virtual call, stored in the data items of
+ * the caller. Entries are only ever added, up to INTERP_INLINE_CACHE_SIZE vtables.
+ */
+typedef struct {
+	InterpInlineCacheEntry *entries [INTERP_INLINE_CACHE_SIZE];
+} InterpInlineCache;
+
 struct _InterpFrame {
 	InterpFrame *parent; /* parent */
 	InterpMethod  *imethod; /* parent */
@@ -158,12 +188,36 @@ typedef struct {
 	guint16 *handler_ip;
 	/* Clause that we are resuming to */
 	MonoJitExceptionInfo *handler_ei;
+	/* Stack the frames of interpreted methods are allocated from, see interp_stack_alloc () */
+	guint8 *stack_start;
+	guint8 *stack_end;
+	guint8 *stack_pointer;
+	/* Most recent allocation in the stack */
+	struct _InterpStackFrameHeader *stack_last;
 } ThreadContext;
 
 typedef struct {
 	gint64 transform_time;
+	gint32 transformed_methods;
 	gint32 inlined_methods;
+	/* Inlining aborted while transforming the callee */
 	gint32 inline_failures;
+	/* Callees rejected by interp_method_check_inlining (), by reason */
+	gint32 inline_fail_recursive;
+	gint32 inline_fail_no_header;
+	gint32 inline_fail_attributes;
+	gint32 inline_fail_clauses;
+	gint32 inline_fail_too_large;
+	gint32 inline_fail_cctor;
+	gint32 inline_fail_wrapper;
+	gint32 inline_fail_magic_type;
+	gint32 const_propagations;
+	gint32 copy_propagations;
+	gint32 killed_instructions;
+	gint32 super_instructions;
+	gint32 tiered_up_methods;
+	gint32 code_cache_hits;
+	gint32 jiterp_traces;
 } MonoInterpStats;
 
 extern MonoInterpStats mono_interp_stats;
@@ -171,6 +225,8 @@ extern MonoInterpStats mono_interp_stats;
 extern int mono_interp_traceopt;
 extern int mono_interp_opt;
 extern GSList *mono_interp_jit_classes;
+/* Directory of the transformed code cache, NULL if disabled */
+extern char *mono_interp_code_cache_dir;
 
 void
 mono_interp_transform_method (InterpMethod *imethod, ThreadContext *context, MonoError *error);
@@ -57,10 +57,12 @@
 #include <mono/metadata/mono-debug.h>
 #include <mono/metadata/gc-internals.h>
 #include <mono/utils/atomic.h>
+#include <mono/utils/unlocked.h>
 
 #include "interp.h"
 #include "interp-internals.h"
 #include "mintops.h"
+#include "jiterpreter.h"
 
 #include <mono/mini/mini.h>
 #include <mono/mini/mini-runtime.h>
@@ -121,8 +123,18 @@ init_frame (InterpFrame *frame, InterpFrame *parent_frame, InterpMethod *rmethod
  * Used for testing.
  */
 GSList *mono_interp_jit_classes;
+/* Directory for caching transformed code, see interp_code_cache_load () */
+char *mono_interp_code_cache_dir;
 /* Optimizations enabled with interpreter */
-int mono_interp_opt = INTERP_OPT_INLINE;
+int mono_interp_opt = INTERP_OPT_INLINE | INTERP_OPT_CPROP | INTERP_OPT_SUPER_INSTRUCTIONS
+#ifdef INTERP_ENABLE_JITERPRETER
+	| INTERP_OPT_JITERPRETER
+#endif
+	;
+/* Number of calls and backward branches after which a method is tiered up to JIT code */
+static int mono_interp_tier_threshold = 1000;
+/* Number of iterations after which a loop is compiled to a WebAssembly trace */
+static int mono_interp_jiterp_threshold = 500;
 /* If TRUE, interpreted code will be interrupted at function entry/backward branches */
 static gboolean ss_enabled;
 
@@ -136,7 +148,10 @@ typedef void (*ICallMethod) (InterpFrame *frame);
 static MonoNativeTlsKey thread_context_id;
 
 #define DEBUG_INTERP 0
+/* Count executed opcodes, can be enabled with CFLAGS=-DCOUNT_OPS=1 */
+#ifndef COUNT_OPS
 #define COUNT_OPS 0
+#endif
 #if DEBUG_INTERP
 int mono_interp_traceopt = 2;
 /* If true, then we output the opcodes as we interpret them */
@@ -284,6 +299,85 @@ get_context (void)
 	return context;
 }
 
+static void
+interp_free_context (gpointer ctx)
+{
+	ThreadContext *context = (ThreadContext*)ctx;
+
+	g_free (context->stack_start);
+	g_free (context);
+}
+
+/*
+ * Returns the part of the interpreter stack of CONTEXT that is in use. The frames
+ * hold object references, the GC scans this range conservatively, like the C stack,
+ * with the world stopped.
+ */
+static void
+interp_get_stack_range (gpointer ctx, gpointer *start, gpointer *end)
+{
+	ThreadContext *context = (ThreadContext*)ctx;
+	guint8 *stack_start = context->stack_start;
+	guint8 *stack_pointer = context->stack_pointer;
+
+	if (stack_start && stack_pointer >= stack_start) {
+		*start = stack_start;
+		*end = stack_pointer;
+	} else {
+		*start = *end = NULL;
+	}
+}
+
+/*
+ * Allocates SIZE bytes for the frame of the interp_exec_method_full () activation at
+ * C_FRAME from the interpreter stack of CONTEXT. Returns NULL once the stack is
+ * exhausted, the caller then falls back to the C stack. The frames are released by
+ * interp_stack_free (), but native exception handling can unwind activations without
+ * running it. Those are detected and released here by their C stack address, which
+ * is at or below C_FRAME, while the ones of the live activations are above it, since
+ * the C stack grows down.
+ */
+static inline gpointer
+interp_stack_alloc (ThreadContext *context, gpointer c_frame, int size)
+{
+	InterpStackFrameHeader *header;
+
+	if (G_UNLIKELY (!context->stack_start)) {
+		/* Allocated on first use, most threads never run interpreted code */
+		guint8 *stack = (guint8*)g_malloc (INTERP_STACK_SIZE);
+		context->stack_pointer = stack;
+		context->stack_end = stack + INTERP_STACK_SIZE;
+		mono_memory_barrier ();
+		context->stack_start = stack;
+	}
+
+	while (context->stack_last && (gsize)context->stack_last->c_frame <= (gsize)c_frame) {
+		context->stack_pointer = (guint8*)context->stack_last;
+		context->stack_last = context->stack_last->prev;
+	}
+
+	size = ALIGN_TO (sizeof (InterpStackFrameHeader) + size, MINT_VT_ALIGNMENT);
+	if (context->stack_pointer + size > context->stack_end)
+		return NULL;
+
+	header = (InterpStackFrameHeader*)context->stack_pointer;
+	header->prev = context->stack_last;
+	header->c_frame = c_frame;
+	context->stack_last = header;
+	context->stack_pointer += size;
+	return header + 1;
+}
+
+/* Releases the frame DATA returned by interp_stack_alloc () together with everything allocated after it */
+static inline void
+interp_stack_free (ThreadContext *context, gpointer data)
+{
+	InterpStackFrameHeader *header = (InterpStackFrameHeader*)data - 1;
+
+	context->stack_pointer = (guint8*)header;
+	context->stack_last = header->prev;
+}
+
 static MONO_NEVER_INLINE void
 ves_real_abort (int line, MonoMethod *mh,
 		const unsigned short *ip, stackval *stack, stackval *sp)
@@ -623,6 +717,61 @@ get_virtual_method_fast (InterpMethod *imethod, MonoVTable *vtable, int offset)
 	}
 }
 
+static MONO_NEVER_INLINE InterpMethod*
+get_virtual_method_cached_slow (InterpInlineCache *cache, InterpMethod *imethod, MonoVTable *vtable, int offset)
+{
+	InterpMethod *target_imethod = get_virtual_method_fast (imethod, vtable, offset);
+	InterpInlineCacheEntry *entry;
+	int i;
+
+#ifndef DISABLE_REMOTING
+	if (mono_class_is_transparent_proxy (vtable->klass))
+		return target_imethod;
+#endif
+
+	/* Megamorphic call site, entries are never removed so don't take the lock */
+	if (cache->entries [INTERP_INLINE_CACHE_SIZE - 1])
+		return target_imethod;
+
+	mono_domain_lock (vtable->domain);
+	for (i = 0; i < INTERP_INLINE_CACHE_SIZE; i++) {
+		if (!cache->entries [i])
+			break;
+		if (cache->entries [i]->vtable == vtable)
+			break;
+	}
+	if (i < INTERP_INLINE_CACHE_SIZE && !cache->entries [i]) {
+		entry = (InterpInlineCacheEntry*) mono_mempool_alloc (vtable->domain->mp, sizeof (InterpInlineCacheEntry));
+		entry->vtable = vtable;
+		entry->target_imethod = target_imethod;
+		mono_memory_barrier ();
+		cache->entries [i] = entry;
+	}
+	mono_domain_unlock (vtable->domain);
+
+	return target_imethod;
+}
+
+/*
+ * Same as get_virtual_method_fast, but first checks the inline cache of the call site.
+ * Once the cache is full, the call site is megamorphic and new vtables go through
+ * the method table of the vtable.
+ */
+static inline InterpMethod*
+get_virtual_method_cached (InterpInlineCache *cache, InterpMethod *imethod, MonoVTable *vtable, int offset)
+{
+	int i;
+
+	for (i = 0; i < INTERP_INLINE_CACHE_SIZE; i++) {
+		InterpInlineCacheEntry *entry = cache->entries [i];
+		if (!entry)
+			break;
+		if (entry->vtable == vtable)
+			return entry->target_imethod;
+	}
+	return get_virtual_method_cached_slow (cache, imethod, vtable, offset);
+}
+
 static void inline
 stackval_from_data (MonoType *type_, stackval *result, void *data, gboolean pinvoke)
 {
@@ -2104,79 +2253,67 @@ jit_call_cb (gpointer arg)
 	}
 }
 
-static MONO_NEVER_INLINE stackval *
-do_jit_call (stackval *sp, unsigned char *vt_sp, ThreadContext *context, InterpFrame *frame, InterpMethod *rmethod, MonoError *error)
+/*
+ * Everything do_jit_call needs to know about the callee, computed on the first call so
+ * the transition itself doesn't need to look at the signature.
+ */
+typedef struct {
+	gpointer addr;
+	gpointer wrapper;
+	/* Number of stackvals holding the arguments, including this */
+	int num_args;
+	/* Number of arguments received by the wrapper */
+	int pindex;
+	gboolean hasthis;
+	/* MINT_TYPE_* of the return value, -1 if void */
+	int ret_mt;
+	/* For each argument, whether its stackval holds a pointer to the value instead of the value */
+	guint8 *arg_is_ref;
+} JitCallInfo;
+
+static JitCallInfo*
+init_jit_call_info (InterpMethod *rmethod, MonoError *error)
 {
-	MonoMethodSignature *sig;
-	MonoFtnDesc ftndesc;
-	guint8 res_buf [256];
-	MonoType *type;
-	MonoLMFExt ext;
-
-	//printf ("jit_call: %s\n", mono_method_full_name (rmethod->method, 1));
-
-	/*
-	 * Call JITted code through a gsharedvt_out wrapper. These wrappers receive every argument
-	 * by ref and return a return value using an explicit return value argument.
-	 */
-	if (!rmethod->jit_wrapper) {
-		MonoMethod *method = rmethod->method;
-
-		sig = mono_method_signature_internal (method);
-		g_assert (sig);
-
-		MonoMethod *wrapper = mini_get_gsharedvt_out_sig_wrapper (sig);
-		//printf ("J: %s %s\n", mono_method_full_name (method, 1), mono_method_full_name (wrapper, 1));
+	MonoMethod *method = rmethod->method;
+	MonoMethodSignature *sig = mono_method_signature_internal (method);
+	JitCallInfo *cinfo;
+	int i;
 
-		gpointer jit_wrapper = mono_jit_compile_method_jit_only (wrapper, error);
-		mono_error_assert_ok (error);
+	g_assert (sig);
 
-		gpointer addr = mono_jit_compile_method_jit_only (method, error);
-		return_val_if_nok (error, NULL);
-		g_assert (addr);
+	MonoMethod *wrapper = mini_get_gsharedvt_out_sig_wrapper (sig);
+	//printf ("J: %s %s\n", mono_method_full_name (method, 1), mono_method_full_name (wrapper, 1));
 
-		rmethod->jit_addr = addr;
-		rmethod->jit_sig = sig;
-		mono_memory_barrier ();
-		rmethod->jit_wrapper = jit_wrapper;
+	gpointer jit_wrapper = mono_jit_compile_method_jit_only (wrapper, error);
+	mono_error_assert_ok (error);
 
+	gpointer addr = mono_jit_compile_method_jit_only (method, error);
+	return_val_if_nok (error, NULL);
+	g_assert (addr);
+
+	cinfo = (JitCallInfo*)mono_domain_alloc0 (rmethod->domain, sizeof (JitCallInfo));
+	cinfo->addr = addr;
+	cinfo->wrapper = jit_wrapper;
+	cinfo->hasthis = sig->hasthis;
+	cinfo->num_args = sig->param_count + sig->hasthis;
+	cinfo->pindex = cinfo->num_args;
+	cinfo->arg_is_ref = (guint8*)mono_domain_alloc0 (rmethod->domain, cinfo->num_args + 1);
+
+	if (rmethod->rtype->type == MONO_TYPE_VOID) {
+		cinfo->ret_mt = -1;
 	} else {
-		sig = rmethod->jit_sig;
+		cinfo->ret_mt = mint_type (rmethod->rtype);
+		cinfo->pindex++;
 	}
+	g_assert (cinfo->pindex <= 32);
 
-	sp -= sig->param_count;
 	if (sig->hasthis)
-		--sp;
-
-	ftndesc.addr = rmethod->jit_addr;
-	ftndesc.arg = NULL;
-
-	// FIXME: Optimize this
-
-	gpointer args [32];
-	int pindex = 0;
-	int stack_index = 0;
-	if (rmethod->hasthis) {
-		args [pindex ++] = sp [0].data.p;
-		stack_index ++;
-	}
-	type = rmethod->rtype;
-	if (type->type != MONO_TYPE_VOID) {
-		if (MONO_TYPE_ISSTRUCT (type))
-			args [pindex ++] = vt_sp;
-		else
-			args [pindex ++] = res_buf;
-	}
-	for (int i = 0; i < rmethod->param_count; ++i) {
+		cinfo->arg_is_ref [0] = TRUE;
+	for (i = 0; i < sig->param_count; ++i) {
 		MonoType *t = rmethod->param_types [i];
-		stackval *sval = &sp [stack_index + i];
-		if (sig->params [i]->byref) {
-			args [pindex ++] = sval->data.p;
-		} else if (MONO_TYPE_ISSTRUCT (t)) {
-			args [pindex ++] = sval->data.p;
-		} else if (MONO_TYPE_IS_REFERENCE (t)) {
-			args [pindex ++] = &sval->data.p;
-		} else {
+		if (sig->params [i]->byref || MONO_TYPE_ISSTRUCT (t)) {
+			cinfo->arg_is_ref [i + sig->hasthis] = TRUE;
+		} else if (!MONO_TYPE_IS_REFERENCE (t)) {
 			switch (t->type) {
 			case MONO_TYPE_I1:
 			case MONO_TYPE_U1:
@@ -2185,24 +2322,15 @@ do_jit_call (stackval *sp, unsigned char *vt_sp, ThreadContext *context, InterpF
 			case MONO_TYPE_I4:
 			case MONO_TYPE_U4:
 			case MONO_TYPE_VALUETYPE:
-				args [pindex ++] = &sval->data.i;
-				break;
 			case MONO_TYPE_PTR:
 			case MONO_TYPE_FNPTR:
 			case MONO_TYPE_I:
 			case MONO_TYPE_U:
 			case MONO_TYPE_OBJECT:
-				args [pindex ++] = &sval->data.p;
-				break;
 			case MONO_TYPE_I8:
 			case MONO_TYPE_U8:
-				args [pindex ++] = &sval->data.l;
-				break;
 			case MONO_TYPE_R4:
-				args [pindex ++] = &sval->data.f_r4;
-				break;
 			case MONO_TYPE_R8:
-				args [pindex ++] = &sval->data.f;
 				break;
 			default:
 				printf ("%s\n", mono_type_full_name (t));
@@ -2211,11 +2339,57 @@ do_jit_call (stackval *sp, unsigned char *vt_sp, ThreadContext *context, InterpF
 		}
 	}
 
+	return cinfo;
+}
+
+static MONO_NEVER_INLINE stackval *
+do_jit_call (stackval *sp, unsigned char *vt_sp, ThreadContext *context, InterpFrame *frame, InterpMethod *rmethod, MonoError *error)
+{
+	JitCallInfo *cinfo;
+	MonoFtnDesc ftndesc;
+	guint8 res_buf [256];
+	MonoLMFExt ext;
+
+	//printf ("jit_call: %s\n", mono_method_full_name (rmethod->method, 1));
+
+	/*
+	 * Call JITted code through a gsharedvt_out wrapper. These wrappers receive every argument
+	 * by ref and return a return value using an explicit return value argument.
+	 */
+	cinfo = (JitCallInfo*)rmethod->jit_call_info;
+	if (!cinfo) {
+		cinfo = init_jit_call_info (rmethod, error);
+		return_val_if_nok (error, NULL);
+		mono_memory_barrier ();
+		rmethod->jit_call_info = cinfo;
+	}
+
+	sp -= cinfo->num_args;
+
+	ftndesc.addr = cinfo->addr;
+	ftndesc.arg = NULL;
+
+	/*
+	 * All the members of stackval.data start at the stackval, so the stackval itself
+	 * serves as the address of any value stored in it.
+	 */
+	gpointer args [32];
+	int pindex = 0;
+	int i = 0;
+	if (cinfo->hasthis) {
+		args [pindex ++] = sp [0].data.p;
+		i ++;
+	}
+	if (cinfo->ret_mt != -1)
+		args [pindex ++] = cinfo->ret_mt == MINT_TYPE_VT ? (gpointer)vt_sp : (gpointer)res_buf;
+	for (; i < cinfo->num_args; ++i)
+		args [pindex ++] = cinfo->arg_is_ref [i] ? sp [i].data.p : (gpointer)&sp [i].data;
+
 	interp_push_lmf (&ext, frame);
 
 	JitCallCbData cb_data;
 	memset (&cb_data, 0, sizeof (cb_data));
-	cb_data.jit_wrapper = rmethod->jit_wrapper;
+	cb_data.jit_wrapper = cinfo->wrapper;
 	cb_data.pindex = pindex;
 	cb_data.args = args;
 	cb_data.ftndesc = &ftndesc;
@@ -2236,64 +2410,42 @@ do_jit_call (stackval *sp, unsigned char *vt_sp, ThreadContext *context, InterpF
 		interp_pop_lmf (&ext);
 	}
 
-	MonoType *rtype = rmethod->rtype;
-	switch (rtype->type) {
-	case MONO_TYPE_VOID:
-	case MONO_TYPE_OBJECT:
-	case MONO_TYPE_STRING:
-	case MONO_TYPE_CLASS:
-	case MONO_TYPE_ARRAY:
-	case MONO_TYPE_SZARRAY:
-	case MONO_TYPE_I:
-	case MONO_TYPE_U:
-	case MONO_TYPE_PTR:
-		sp->data.p = *(gpointer*)res_buf;
+	switch (cinfo->ret_mt) {
+	case -1:
 		break;
-	case MONO_TYPE_I1:
+	case MINT_TYPE_I1:
 		sp->data.i = *(gint8*)res_buf;
 		break;
-	case MONO_TYPE_U1:
+	case MINT_TYPE_U1:
 		sp->data.i = *(guint8*)res_buf;
 		break;
-	case MONO_TYPE_I2:
+	case MINT_TYPE_I2:
 		sp->data.i = *(gint16*)res_buf;
 		break;
-	case MONO_TYPE_U2:
+	case MINT_TYPE_U2:
 		sp->data.i = *(guint16*)res_buf;
 		break;
-	case MONO_TYPE_I4:
+	case MINT_TYPE_I4:
 		sp->data.i = *(gint32*)res_buf;
 		break;
-	case MONO_TYPE_U4:
-		sp->data.i = *(guint32*)res_buf;
-		break;
-	case MONO_TYPE_I8:
+	case MINT_TYPE_I8:
 		sp->data.l = *(gint64*)res_buf;
 		break;
-	case MONO_TYPE_U8:
-		sp->data.l = *(guint64*)res_buf;
-		break;
-	case MONO_TYPE_R4:
+	case MINT_TYPE_R4:
 		sp->data.f_r4 = *(float*)res_buf;
 		break;
-	case MONO_TYPE_R8:
+	case MINT_TYPE_R8:
 		sp->data.f = *(double*)res_buf;
 		break;
-	case MONO_TYPE_TYPEDBYREF:
-	case MONO_TYPE_VALUETYPE:
+	case MINT_TYPE_O:
+	case MINT_TYPE_P:
+		sp->data.p = *(gpointer*)res_buf;
+		break;
+	case MINT_TYPE_VT:
 		/* The result was written to vt_sp */
 		sp->data.p = vt_sp;
 		break;
-	case MONO_TYPE_GENERICINST:
-		if (MONO_TYPE_IS_REFERENCE (rtype)) {
-			sp->data.p = *(gpointer*)res_buf;
-		} else {
-			/* The result was written to vt_sp */
-			sp->data.p = vt_sp;
-		}
-		break;
 	default:
-		g_print ("%s\n", mono_type_full_name (rtype));
 		g_assert_not_reached ();
 		break;
 	}
@@ -2301,6 +2453,71 @@ do_jit_call (stackval *sp, unsigned char *vt_sp, ThreadContext *context, InterpF
 	return sp;
 }
 
+static gboolean
+tier_up_supported (InterpMethod *imethod)
+{
+	MonoMethod *method = imethod->method;
+	MonoMethodSignature *sig = mono_method_signature_internal (method);
+	GSList *l;
+
+	/* These match the restrictions of jit_call_supported () in transform.c */
+	if (mono_aot_only || !sig || sig->param_count > 6 || sig->pinvoke || sig->call_convention == MONO_CALL_VARARG)
+		return FALSE;
+	if ((method->flags & METHOD_ATTRIBUTE_PINVOKE_IMPL) ||
+			(method->iflags & (METHOD_IMPL_ATTRIBUTE_INTERNAL_CALL | METHOD_IMPL_ATTRIBUTE_RUNTIME | METHOD_IMPL_ATTRIBUTE_SYNCHRONIZED)))
+		return FALSE;
+	if (method->is_inflated || method->string_ctor || method->dynamic || method->wrapper_type != MONO_WRAPPER_NONE)
+		return FALSE;
+	/* Profilers expect the enter/leave events of the interpreter */
+	if (imethod->prof_flags)
+		return FALSE;
+	for (l = mono_interp_only_classes; l; l = l->next) {
+		if (!strcmp (m_class_get_name (method->klass), (const char*)l->data))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+/*
+ * Compiles IMETHOD with the JIT, so it can be called through do_jit_call () from now
+ * on. Returns FALSE if the method has to stay interpreted.
+ */
+static MONO_NEVER_INLINE gboolean
+tier_up_method (InterpMethod *imethod)
+{
+	ERROR_DECL (error);
+	JitCallInfo *cinfo;
+
+	if (imethod->tier_up_failed)
+		return FALSE;
+	if (!tier_up_supported (imethod)) {
+		imethod->tier_up_failed = TRUE;
+		return FALSE;
+	}
+
+	cinfo = init_jit_call_info (imethod, error);
+	if (!is_ok (error)) {
+		mono_error_cleanup (error);
+		imethod->tier_up_failed = TRUE;
+		return FALSE;
+	}
+	mono_memory_barrier ();
+	imethod->jit_call_info = cinfo;
+	UnlockedIncrement (&mono_interp_stats.tiered_up_methods);
+	return TRUE;
+}
+
+/* Called on entry to IMETHOD, returns whether the call should go to JIT code instead */
+static inline gboolean
+tier_up_check (InterpMethod *imethod)
+{
+	if (imethod->jit_call_info)
+		return TRUE;
+	if (G_LIKELY (++imethod->call_count + imethod->backedge_count < mono_interp_tier_threshold))
+		return FALSE;
+	return tier_up_method (imethod);
+}
+
 static MONO_NEVER_INLINE void
 do_debugger_tramp (void (*tramp) (void), InterpFrame *frame)
 {
@@ -2826,9 +3043,76 @@ interp_create_method_pointer (MonoMethod *method, gboolean compile, MonoError *e
 }
 
 #if COUNT_OPS
-static int opcode_counts[512];
+static gint32 opcode_counts [MINT_LASTOP];
+/* Number of times an opcode was executed right after another, indexed by [prev][op] */
+static gint32 opcode_pair_counts [MINT_LASTOP][MINT_LASTOP];
+static guint16 prev_opcode;
+
+#define COUNT_OP(op) do { \
+	opcode_counts [op]++; \
+	opcode_pair_counts [prev_opcode][op]++; \
+	prev_opcode = (op); \
+} while (0)
 
-#define COUNT_OP(op) opcode_counts[op]++
+#define OP_COUNT_TOP 50
+
+static int
+compare_op_counts (const void *a, const void *b)
+{
+	int ca = *(int*)*(const gpointer*)a;
+	int cb = *(int*)*(const gpointer*)b;
+	return cb - ca;
+}
+
+/*
+ * Prints the most executed opcodes and opcode pairs, the candidates for new
+ * super instructions.
+ */
+static void
+interp_print_op_count (void)
+{
+	GPtrArray *counts = g_ptr_array_new ();
+	int i, j;
+
+	for (i = 0; i < MINT_LASTOP; i++)
+		if (opcode_counts [i])
+			g_ptr_array_add (counts, &opcode_counts [i]);
+	g_ptr_array_sort (counts, compare_op_counts);
+	g_print ("Opcode counts:\n");
+	for (i = 0; i < counts->len && i < OP_COUNT_TOP; i++) {
+		int *c = (int*)g_ptr_array_index (counts, i);
+		g_print ("%12d %s\n", *c, mono_interp_opname [c - opcode_counts]);
+	}
+	g_ptr_array_set_size (counts, 0);
+
+	for (i = 0; i < MINT_LASTOP; i++)
+		for (j = 0; j < MINT_LASTOP; j++)
+			if (opcode_pair_counts [i][j])
+				g_ptr_array_add (counts, &opcode_pair_counts [i][j]);
+	g_ptr_array_sort (counts, compare_op_counts);
+	g_print ("Opcode pair counts:\n");
+	for (i = 0; i < counts->len && i < OP_COUNT_TOP; i++) {
+		int *c = (int*)g_ptr_array_index (counts, i);
+		int index = c - &opcode_pair_counts [0][0];
+		g_print ("%12d %s -> %s\n", *c, mono_interp_opname [index / MINT_LASTOP], mono_interp_opname [index % MINT_LASTOP]);
+	}
+	g_ptr_array_free (counts, TRUE);
+}
+
+/*
+ * Export the opcode counts through mono-counters, so they are also reported by
+ * --stats and sampled by the log profiler.
+ */
+static void
+register_op_counts (void)
+{
+	int i;
+
+	for (i = 0; i < MINT_LASTOP; i++) {
+		char *name = g_strdup_printf ("Executed %s", mono_interp_opname [i]);
+		mono_counters_register (name, MONO_COUNTER_INTERP | MONO_COUNTER_INT, &opcode_counts [i]);
+	}
+}
 #else
 #define COUNT_OP(op) 
 #endif
@@ -2925,6 +3209,8 @@ interp_exec_method_full (InterpFrame *frame, ThreadContext *context, FrameClause
 	int i32;
 	unsigned char *vt_sp;
 	unsigned char *locals = NULL;
+	/* First allocation of this activation from the interpreter stack */
+	gpointer stack_frame = NULL;
 	// See the comment about GC safety above
 	MonoObject *o = NULL;
 	MonoClass *c;
@@ -2954,15 +3240,34 @@ interp_exec_method_full (InterpFrame *frame, ThreadContext *context, FrameClause
 		EXCEPTION_CHECKPOINT;
 	}
 
+	if (G_UNLIKELY (mono_interp_opt & INTERP_OPT_TIERING) && !clause_args && tier_up_check (imethod)) {
+		stackval *ret_sp;
+
+		/* Pass the parent to the LMF, this frame never started executing */
+		MONO_API_ERROR_INIT (error);
+		ret_sp = do_jit_call (frame->stack_args + imethod->param_count + imethod->hasthis, (unsigned char*)frame->retval->data.p, context, frame->parent, imethod, error);
+		if (!is_ok (error)) {
+			MonoException *ex = mono_error_convert_to_exception (error);
+			THROW_EX (ex, NULL);
+		}
+		if (imethod->rtype->type != MONO_TYPE_VOID)
+			*frame->retval = *ret_sp;
+		goto exit_frame;
+	}
+
+	if (!clause_args || clause_args->base_frame) {
+		frame->args = (char*)interp_stack_alloc (context, &child_frame, imethod->alloca_size);
+		if (!frame->args)
+			frame->args = g_newa (char, imethod->alloca_size);
+		else
+			stack_frame = frame->args;
+	}
 	if (!clause_args) {
-		frame->args = g_newa (char, imethod->alloca_size);
 		ip = imethod->code;
 	} else {
 		ip = clause_args->start_with_ip;
-		if (clause_args->base_frame) {
-			frame->args = g_newa (char, imethod->alloca_size);
+		if (clause_args->base_frame)
 			memcpy (frame->args, clause_args->base_frame->args, imethod->alloca_size);
-		}
 	}
 	sp = frame->stack = (stackval *) (char *) frame->args;
 	vt_sp = (unsigned char *) sp + imethod->stack_size;
@@ -3145,7 +3450,11 @@ interp_exec_method_full (InterpFrame *frame, ThreadContext *context, FrameClause
 			 * than the callee stack frame (at the interp level)
 			 */
 			if (realloc_frame) {
-				frame->args = g_newa (char, imethod->alloca_size);
+				frame->args = (char*)interp_stack_alloc (context, &child_frame, imethod->alloca_size);
+				if (!frame->args)
+					frame->args = g_newa (char, imethod->alloca_size);
+				else if (!stack_frame)
+					stack_frame = frame->args;
 				memset (frame->args, 0, imethod->alloca_size);
 				sp = frame->stack = (stackval *) frame->args;
 			}
@@ -3280,6 +3589,7 @@ interp_exec_method_full (InterpFrame *frame, ThreadContext *context, FrameClause
 			MonoClass *this_class;
 			gboolean is_void = *ip == MINT_VCALLVIRT_FAST;
 			InterpMethod *target_imethod;
+			InterpInlineCache *cache;
 			stackval *endsp = sp;
 			int slot;
 
@@ -3289,7 +3599,8 @@ interp_exec_method_full (InterpFrame *frame, ThreadContext *context, FrameClause
 
 			target_imethod = (InterpMethod*)imethod->data_items [* (guint16 *)(ip + 1)];
 			slot = *(gint16*)(ip + 2);
-			ip += 3;
+			cache = (InterpInlineCache*)imethod->data_items [* (guint16 *)(ip + 3)];
+			ip += 4;
 			sp->data.p = vt_sp;
 			child_frame.retval = sp;
 
@@ -3300,7 +3611,7 @@ interp_exec_method_full (InterpFrame *frame, ThreadContext *context, FrameClause
 			this_arg = (MonoObject*)sp->data.p;
 			this_class = this_arg->vtable->klass;
 
-			child_frame.imethod = get_virtual_method_fast (target_imethod, this_arg->vtable, slot);
+			child_frame.imethod = get_virtual_method_cached (cache, target_imethod, this_arg->vtable, slot);
 			if (m_class_is_valuetype (this_class) && m_class_is_valuetype (child_frame.imethod->method->klass)) {
 				/* unbox */
 				gpointer unboxed = mono_object_unbox_internal (this_arg);
@@ -4694,6 +5005,25 @@ interp_exec_method_full (InterpFrame *frame, ThreadContext *context, FrameClause
 			EXCEPTION_CHECKPOINT;
 			++ip;
 			MINT_IN_BREAK;
+		MINT_IN_CASE(MINT_TIER_BACKEDGE)
+			/* The method is only tiered up on its next call */
+			++imethod->backedge_count;
+			++ip;
+			MINT_IN_BREAK;
+		MINT_IN_CASE(MINT_JITERP_ENTER) {
+#ifdef INTERP_ENABLE_JITERPRETER
+			InterpTrace *trace = (InterpTrace*)imethod->data_items [ip [1]];
+			if (G_UNLIKELY (!trace->func) && !trace->failed && ++trace->hit_count >= mono_interp_jiterp_threshold)
+				mono_interp_jiterp_compile_trace (imethod, ip, trace);
+			if (trace->func) {
+				/* The evaluation stack is empty at the start of a trace */
+				ip += trace->func (locals, frame->stack_args);
+				MINT_IN_BREAK;
+			}
+#endif
+			ip += 2;
+			MINT_IN_BREAK;
+		}
 		MINT_IN_CASE(MINT_SAFEPOINT)
 			/* Do synchronous checking of abort requests */
 			EXCEPTION_CHECKPOINT;
@@ -6248,6 +6578,114 @@ interp_exec_method_full (InterpFrame *frame, ThreadContext *context, FrameClause
 		MINT_IN_CASE(MINT_STLOC_NP_I4) STLOC_NP(i, gint32); MINT_IN_BREAK;
 		MINT_IN_CASE(MINT_STLOC_NP_O) STLOC_NP(p, gpointer); MINT_IN_BREAK;
 
+#define MOVLOC(argtype) \
+	* (argtype *)(locals + * (guint16 *)(ip + 2)) = * (argtype *)(locals + * (guint16 *)(ip + 1)); \
+	ip += 3;
+
+		MINT_IN_CASE(MINT_MOVLOC_1) MOVLOC(guint8); MINT_IN_BREAK;
+		MINT_IN_CASE(MINT_MOVLOC_2) MOVLOC(guint16); MINT_IN_BREAK;
+		MINT_IN_CASE(MINT_MOVLOC_4) MOVLOC(guint32); MINT_IN_BREAK;
+		MINT_IN_CASE(MINT_MOVLOC_8) MOVLOC(guint64); MINT_IN_BREAK;
+
+		MINT_IN_CASE(MINT_ADD_I4_IMM_LOC)
+			* (gint32 *)(locals + * (guint16 *)(ip + 2)) = * (gint32 *)(locals + * (guint16 *)(ip + 1)) + * (gint16 *)(ip + 3);
+			ip += 4;
+			MINT_IN_BREAK;
+
+#define LDARGFLD(datamem, fieldtype) \
+	o = frame->stack_args [* (guint16 *)(ip + 1)].data.o; \
+	if (!o) \
+		THROW_EX (mono_get_exception_null_reference (), ip); \
+	sp->data.datamem = * (fieldtype *)((char *)o + * (guint16 *)(ip + 2)); \
+	ip += 3; \
+	++sp;
+
+		MINT_IN_CASE(MINT_LDARGFLD_I1) LDARGFLD(i, gint8); MINT_IN_BREAK;
+		MINT_IN_CASE(MINT_LDARGFLD_U1) LDARGFLD(i, guint8); MINT_IN_BREAK;
+		MINT_IN_CASE(MINT_LDARGFLD_I2) LDARGFLD(i, gint16); MINT_IN_BREAK;
+		MINT_IN_CASE(MINT_LDARGFLD_U2) LDARGFLD(i, guint16); MINT_IN_BREAK;
+		MINT_IN_CASE(MINT_LDARGFLD_I4) LDARGFLD(i, gint32); MINT_IN_BREAK;
+		MINT_IN_CASE(MINT_LDARGFLD_I8) LDARGFLD(l, gint64); MINT_IN_BREAK;
+		MINT_IN_CASE(MINT_LDARGFLD_R4) LDARGFLD(f_r4, float); MINT_IN_BREAK;
+		MINT_IN_CASE(MINT_LDARGFLD_R8) LDARGFLD(f, double); MINT_IN_BREAK;
+		MINT_IN_CASE(MINT_LDARGFLD_O) LDARGFLD(p, gpointer); MINT_IN_BREAK;
+		MINT_IN_CASE(MINT_LDARGFLD_P) LDARGFLD(p, gpointer); MINT_IN_BREAK;
+
+#define CONDBR_LOC_S(cond) \
+	if (cond) \
+		ip += * (gint16 *)(ip + 1); \
+	else \
+		ip += 4;
+#define BRELOP_LOC_S(op) \
+	CONDBR_LOC_S(* (gint32 *)(locals + * (guint16 *)(ip + 2)) op * (gint32 *)(locals + * (guint16 *)(ip + 3)))
+#define BRELOP_LOC_IMM_S(op) \
+	CONDBR_LOC_S(* (gint32 *)(locals + * (guint16 *)(ip + 2)) op * (gint16 *)(ip + 3))
+
+		MINT_IN_CASE(MINT_BEQ_I4_LOC_S) BRELOP_LOC_S(==); MINT_IN_BREAK;
+		MINT_IN_CASE(MINT_BGE_I4_LOC_S) BRELOP_LOC_S(>=); MINT_IN_BREAK;
+		MINT_IN_CASE(MINT_BGT_I4_LOC_S) BRELOP_LOC_S(>); MINT_IN_BREAK;
+		MINT_IN_CASE(MINT_BLT_I4_LOC_S) BRELOP_LOC_S(<); MINT_IN_BREAK;
+		MINT_IN_CASE(MINT_BLE_I4_LOC_S) BRELOP_LOC_S(<=); MINT_IN_BREAK;
+		MINT_IN_CASE(MINT_BNE_UN_I4_LOC_S) BRELOP_LOC_S(!=); MINT_IN_BREAK;
+		MINT_IN_CASE(MINT_BEQ_I4_LOC_IMM_S) BRELOP_LOC_IMM_S(==); MINT_IN_BREAK;
+		MINT_IN_CASE(MINT_BGE_I4_LOC_IMM_S) BRELOP_LOC_IMM_S(>=); MINT_IN_BREAK;
+		MINT_IN_CASE(MINT_BGT_I4_LOC_IMM_S) BRELOP_LOC_IMM_S(>); MINT_IN_BREAK;
+		MINT_IN_CASE(MINT_BLT_I4_LOC_IMM_S) BRELOP_LOC_IMM_S(<); MINT_IN_BREAK;
+		MINT_IN_CASE(MINT_BLE_I4_LOC_IMM_S) BRELOP_LOC_IMM_S(<=); MINT_IN_BREAK;
+		MINT_IN_CASE(MINT_BNE_UN_I4_LOC_IMM_S) BRELOP_LOC_IMM_S(!=); MINT_IN_BREAK;
+
+/*
+ * The operands are 16 byte values on the vt stack, the result overwrites the first
+ * operand. Integer elements use unsigned types since the operations wrap around.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#define SIMD_V128_BINOP(etype, op) do { \
+	typedef etype v128 __attribute__ ((vector_size (16))); \
+	v128 v1, v2; \
+	memcpy (&v1, sp [-2].data.p, 16); \
+	memcpy (&v2, sp [-1].data.p, 16); \
+	v1 = v1 op v2; \
+	memcpy (sp [-2].data.p, &v1, 16); \
+	--sp; \
+	vt_sp -= 16; \
+	++ip; \
+} while (0)
+#else
+#define SIMD_V128_BINOP(etype, op) do { \
+	etype *v1 = (etype*)sp [-2].data.p; \
+	etype *v2 = (etype*)sp [-1].data.p; \
+	for (int __i = 0; __i < 16 / sizeof (etype); __i++) \
+		v1 [__i] = v1 [__i] op v2 [__i]; \
+	--sp; \
+	vt_sp -= 16; \
+	++ip; \
+} while (0)
+#endif
+
+		MINT_IN_CASE(MINT_SIMD_V128_ADD_I1) SIMD_V128_BINOP(guint8, +); MINT_IN_BREAK;
+		MINT_IN_CASE(MINT_SIMD_V128_ADD_I2) SIMD_V128_BINOP(guint16, +); MINT_IN_BREAK;
+		MINT_IN_CASE(MINT_SIMD_V128_ADD_I4) SIMD_V128_BINOP(guint32, +); MINT_IN_BREAK;
+		MINT_IN_CASE(MINT_SIMD_V128_ADD_I8) SIMD_V128_BINOP(guint64, +); MINT_IN_BREAK;
+		MINT_IN_CASE(MINT_SIMD_V128_ADD_R4) SIMD_V128_BINOP(float, +); MINT_IN_BREAK;
+		MINT_IN_CASE(MINT_SIMD_V128_ADD_R8) SIMD_V128_BINOP(double, +); MINT_IN_BREAK;
+		MINT_IN_CASE(MINT_SIMD_V128_SUB_I1) SIMD_V128_BINOP(guint8, -); MINT_IN_BREAK;
+		MINT_IN_CASE(MINT_SIMD_V128_SUB_I2) SIMD_V128_BINOP(guint16, -); MINT_IN_BREAK;
+		MINT_IN_CASE(MINT_SIMD_V128_SUB_I4) SIMD_V128_BINOP(guint32, -); MINT_IN_BREAK;
+		MINT_IN_CASE(MINT_SIMD_V128_SUB_I8) SIMD_V128_BINOP(guint64, -); MINT_IN_BREAK;
+		MINT_IN_CASE(MINT_SIMD_V128_SUB_R4) SIMD_V128_BINOP(float, -); MINT_IN_BREAK;
+		MINT_IN_CASE(MINT_SIMD_V128_SUB_R8) SIMD_V128_BINOP(double, -); MINT_IN_BREAK;
+		MINT_IN_CASE(MINT_SIMD_V128_MUL_I1) SIMD_V128_BINOP(guint8, *); MINT_IN_BREAK;
+		MINT_IN_CASE(MINT_SIMD_V128_MUL_I2) SIMD_V128_BINOP(guint16, *); MINT_IN_BREAK;
+		MINT_IN_CASE(MINT_SIMD_V128_MUL_I4) SIMD_V128_BINOP(guint32, *); MINT_IN_BREAK;
+		MINT_IN_CASE(MINT_SIMD_V128_MUL_I8) SIMD_V128_BINOP(guint64, *); MINT_IN_BREAK;
+		MINT_IN_CASE(MINT_SIMD_V128_MUL_R4) SIMD_V128_BINOP(float, *); MINT_IN_BREAK;
+		MINT_IN_CASE(MINT_SIMD_V128_MUL_R8) SIMD_V128_BINOP(double, *); MINT_IN_BREAK;
+		MINT_IN_CASE(MINT_SIMD_V128_DIV_R4) SIMD_V128_BINOP(float, /); MINT_IN_BREAK;
+		MINT_IN_CASE(MINT_SIMD_V128_DIV_R8) SIMD_V128_BINOP(double, /); MINT_IN_BREAK;
+		MINT_IN_CASE(MINT_SIMD_V128_AND) SIMD_V128_BINOP(guint64, &); MINT_IN_BREAK;
+		MINT_IN_CASE(MINT_SIMD_V128_OR) SIMD_V128_BINOP(guint64, |); MINT_IN_BREAK;
+		MINT_IN_CASE(MINT_SIMD_V128_XOR) SIMD_V128_BINOP(guint64, ^); MINT_IN_BREAK;
+
 		MINT_IN_CASE(MINT_STLOC_VT)
 			i32 = READ32(ip + 2);
 			--sp;
@@ -6503,6 +6941,9 @@ exit_frame:
 	} else if (frame->ex && imethod->prof_flags & MONO_PROFILER_CALL_INSTRUMENTATION_EXCEPTION_LEAVE)
 		MONO_PROFILER_RAISE (method_exception_leave, (imethod->method, &frame->ex->object));
 
+	if (stack_frame)
+		interp_stack_free (context, stack_frame);
+
 	DEBUG_LEAVE ();
 }
 
@@ -6524,6 +6965,20 @@ interp_parse_options (const char *options)
 			mono_interp_only_classes = g_slist_prepend (mono_interp_only_classes, arg + strlen ("interp-only="));
 		if (strncmp (arg, "-inline", 7) == 0)
 			mono_interp_opt &= ~INTERP_OPT_INLINE;
+		if (strncmp (arg, "-cprop", 6) == 0)
+			mono_interp_opt &= ~INTERP_OPT_CPROP;
+		if (strncmp (arg, "-super", 6) == 0)
+			mono_interp_opt &= ~INTERP_OPT_SUPER_INSTRUCTIONS;
+		if (strncmp (arg, "tiering-threshold=", 18) == 0)
+			mono_interp_tier_threshold = atoi (arg + 18);
+		else if (strncmp (arg, "tiering", 7) == 0)
+			mono_interp_opt |= INTERP_OPT_TIERING;
+		if (strncmp (arg, "-jiterpreter", 12) == 0)
+			mono_interp_opt &= ~INTERP_OPT_JITERPRETER;
+		if (strncmp (arg, "jiterpreter-threshold=", 22) == 0)
+			mono_interp_jiterp_threshold = atoi (arg + 22);
+		if (strncmp (arg, "code-cache=", 11) == 0)
+			mono_interp_code_cache_dir = g_strdup (arg + 11);
 	}
 }
 
@@ -6793,9 +7248,28 @@ static void
 register_interp_stats (void)
 {
 	mono_counters_init ();
+	mono_counters_register ("Methods transformed", MONO_COUNTER_INTERP | MONO_COUNTER_INT, &mono_interp_stats.transformed_methods);
 	mono_counters_register ("Total transform time", MONO_COUNTER_INTERP | MONO_COUNTER_LONG | MONO_COUNTER_TIME, &mono_interp_stats.transform_time);
 	mono_counters_register ("Methods inlined", MONO_COUNTER_INTERP | MONO_COUNTER_INT, &mono_interp_stats.inlined_methods);
 	mono_counters_register ("Inline failures", MONO_COUNTER_INTERP | MONO_COUNTER_INT, &mono_interp_stats.inline_failures);
+	mono_counters_register ("Inline rejected: recursive", MONO_COUNTER_INTERP | MONO_COUNTER_INT, &mono_interp_stats.inline_fail_recursive);
+	mono_counters_register ("Inline rejected: no header", MONO_COUNTER_INTERP | MONO_COUNTER_INT, &mono_interp_stats.inline_fail_no_header);
+	mono_counters_register ("Inline rejected: attributes", MONO_COUNTER_INTERP | MONO_COUNTER_INT, &mono_interp_stats.inline_fail_attributes);
+	mono_counters_register ("Inline rejected: clauses", MONO_COUNTER_INTERP | MONO_COUNTER_INT, &mono_interp_stats.inline_fail_clauses);
+	mono_counters_register ("Inline rejected: too large", MONO_COUNTER_INTERP | MONO_COUNTER_INT, &mono_interp_stats.inline_fail_too_large);
+	mono_counters_register ("Inline rejected: cctor", MONO_COUNTER_INTERP | MONO_COUNTER_INT, &mono_interp_stats.inline_fail_cctor);
+	mono_counters_register ("Inline rejected: wrapper", MONO_COUNTER_INTERP | MONO_COUNTER_INT, &mono_interp_stats.inline_fail_wrapper);
+	mono_counters_register ("Inline rejected: magic type", MONO_COUNTER_INTERP | MONO_COUNTER_INT, &mono_interp_stats.inline_fail_magic_type);
+	mono_counters_register ("Const propagations", MONO_COUNTER_INTERP | MONO_COUNTER_INT, &mono_interp_stats.const_propagations);
+	mono_counters_register ("Copy propagations", MONO_COUNTER_INTERP | MONO_COUNTER_INT, &mono_interp_stats.copy_propagations);
+	mono_counters_register ("Killed instructions", MONO_COUNTER_INTERP | MONO_COUNTER_INT, &mono_interp_stats.killed_instructions);
+	mono_counters_register ("Super instructions", MONO_COUNTER_INTERP | MONO_COUNTER_INT, &mono_interp_stats.super_instructions);
+	mono_counters_register ("Methods tiered up", MONO_COUNTER_INTERP | MONO_COUNTER_INT, &mono_interp_stats.tiered_up_methods);
+	mono_counters_register ("Code cache hits", MONO_COUNTER_INTERP | MONO_COUNTER_INT, &mono_interp_stats.code_cache_hits);
+	mono_counters_register ("Traces compiled to wasm", MONO_COUNTER_INTERP | MONO_COUNTER_INT, &mono_interp_stats.jiterp_traces);
+#if COUNT_OPS
+	register_op_counts ();
+#endif
 }
 
 #undef MONO_EE_CALLBACK
@@ -6817,8 +7291,11 @@ mono_ee_interp_init (const char *opts)
 
 	interp_parse_options (opts);
 	if (mini_get_debug_options ()->mdb_optimizations)
-		mono_interp_opt &= ~INTERP_OPT_INLINE;
+		mono_interp_opt &= ~(INTERP_OPT_INLINE | INTERP_OPT_CPROP | INTERP_OPT_SUPER_INSTRUCTIONS | INTERP_OPT_TIERING | INTERP_OPT_JITERPRETER);
 	mono_interp_transform_init ();
+#if COUNT_OPS
+	atexit (interp_print_op_count);
+#endif
 
 	mini_install_interp_callbacks (&mono_interp_callbacks);
 
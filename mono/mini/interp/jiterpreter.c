@@ -0,0 +1,836 @@
+/**
+ * \file
+ * Compilation of hot interpreter traces to WebAssembly
+ *
+ * On wasm the interpreter can't tier up to JIT code, so instead the straight line code
+ * starting at hot loop headers is translated from interpreter instructions into small
+ * WebAssembly modules at runtime. A trace starts at a MINT_JITERP_ENTER instruction,
+ * where the evaluation stack is empty, and the interpreter calls it through the function
+ * table once it is compiled:
+ *
+ * - The evaluation stack is modelled by the wasm operand stack, locals and arguments are
+ *   accessed in linear memory through the pointers passed to the trace.
+ * - Branches back to the start of the trace become a wasm loop, so a whole loop can run
+ *   without returning to the interpreter. Forward branches are followed, other branches
+ *   and the first unsupported instruction leave the trace.
+ * - The trace returns the offset of the instruction the interpreter continues from, so it
+ *   may only be left where the evaluation stack is empty.
+ * - Safepoints and checkpoints poll the same flags as the interpreter, and leave the
+ *   trace at the safepoint so the interpreter handles the request.
+ *
+ * Licensed under the MIT license. See LICENSE file in the project root for full license information.
+ */
+
+#include "config.h"
+#include <string.h>
+#include <mono/metadata/threads-types.h>
+#include <mono/utils/mono-threads-coop.h>
+#include <mono/utils/unlocked.h>
+#include <mono/mini/mini.h>
+
+#include "mintops.h"
+#include "jiterpreter.h"
+
+/* Longer traces are cut, which also keeps modules below the 4KB browsers compile synchronously */
+#define TRACE_MAX_OPS 256
+#define TRACE_MAX_STACK 16
+#define TRACE_MAX_MODULE_SIZE 4096
+/* Traces which don't loop have to be at least this long to pay for the call */
+#define TRACE_MIN_OPS 16
+
+enum {
+	WASM_TYPE_I32 = 0x7f,
+	WASM_TYPE_I64 = 0x7e,
+	WASM_TYPE_F64 = 0x7c,
+	WASM_TYPE_VOID = 0x40,
+	WASM_TYPE_FUNC = 0x60
+};
+
+enum {
+	WASM_OP_UNREACHABLE = 0x00,
+	WASM_OP_LOOP = 0x03,
+	WASM_OP_IF = 0x04,
+	WASM_OP_END = 0x0b,
+	WASM_OP_BR = 0x0c,
+	WASM_OP_BR_IF = 0x0d,
+	WASM_OP_RETURN = 0x0f,
+	WASM_OP_DROP = 0x1a,
+	WASM_OP_LOCAL_GET = 0x20,
+	WASM_OP_LOCAL_SET = 0x21,
+	WASM_OP_LOCAL_TEE = 0x22,
+	WASM_OP_I32_LOAD = 0x28,
+	WASM_OP_I64_LOAD = 0x29,
+	WASM_OP_F64_LOAD = 0x2b,
+	WASM_OP_I32_STORE = 0x36,
+	WASM_OP_I64_STORE = 0x37,
+	WASM_OP_F64_STORE = 0x39,
+	WASM_OP_I32_CONST = 0x41,
+	WASM_OP_I64_CONST = 0x42,
+	WASM_OP_F64_CONST = 0x44,
+	WASM_OP_I32_EQZ = 0x45,
+	WASM_OP_I32_EQ = 0x46,
+	WASM_OP_I32_NE = 0x47,
+	WASM_OP_I32_LT_S = 0x48,
+	WASM_OP_I32_GT_S = 0x4a,
+	WASM_OP_I32_LE_S = 0x4c,
+	WASM_OP_I32_GE_S = 0x4e,
+	WASM_OP_I32_ADD = 0x6a,
+	WASM_OP_I32_SUB = 0x6b,
+	WASM_OP_I32_MUL = 0x6c,
+	WASM_OP_I32_AND = 0x71,
+	WASM_OP_I32_OR = 0x72,
+	WASM_OP_I32_XOR = 0x73,
+	WASM_OP_I32_SHL = 0x74,
+	WASM_OP_I32_SHR_S = 0x75,
+	WASM_OP_I32_SHR_U = 0x76,
+	WASM_OP_I64_ADD = 0x7c,
+	WASM_OP_I64_SUB = 0x7d,
+	WASM_OP_I64_MUL = 0x7e,
+	WASM_OP_I64_AND = 0x83,
+	WASM_OP_I64_OR = 0x84,
+	WASM_OP_I64_XOR = 0x85,
+	WASM_OP_I64_SHL = 0x86,
+	WASM_OP_I64_SHR_S = 0x87,
+	WASM_OP_I64_SHR_U = 0x88,
+	WASM_OP_F64_ADD = 0xa0,
+	WASM_OP_F64_SUB = 0xa1,
+	WASM_OP_F64_MUL = 0xa2,
+	WASM_OP_I32_WRAP_I64 = 0xa7,
+	WASM_OP_I64_EXTEND_I32_S = 0xac,
+	WASM_OP_I64_EXTEND_I32_U = 0xad,
+	WASM_OP_F64_CONVERT_I32_S = 0xb7
+};
+
+/* Function locals, the two parameters are followed by one scratch local per type */
+enum {
+	LOCAL_LOCALS,
+	LOCAL_ARGS,
+	LOCAL_TMP_I32,
+	LOCAL_TMP_I64,
+	LOCAL_TMP_F64
+};
+
+typedef struct {
+	GByteArray *code;
+	const guint16 *start;
+	guint8 stack [TRACE_MAX_STACK];
+	int sp;
+	/* Whether the trace branches back to its start */
+	gboolean loops;
+} TraceGen;
+
+static void
+emit_byte (GByteArray *buf, guint8 b)
+{
+	g_byte_array_append (buf, &b, 1);
+}
+
+static void
+emit_uleb (GByteArray *buf, guint32 value)
+{
+	do {
+		guint8 b = value & 0x7f;
+		value >>= 7;
+		if (value)
+			b |= 0x80;
+		emit_byte (buf, b);
+	} while (value);
+}
+
+static void
+emit_sleb (GByteArray *buf, gint64 value)
+{
+	gboolean more;
+
+	do {
+		guint8 b = value & 0x7f;
+		/* Arithmetic shift */
+		value >>= 7;
+		more = !((value == 0 && !(b & 0x40)) || (value == -1 && (b & 0x40)));
+		if (more)
+			b |= 0x80;
+		emit_byte (buf, b);
+	} while (more);
+}
+
+static void
+emit_name (GByteArray *buf, const char *name)
+{
+	emit_uleb (buf, strlen (name));
+	g_byte_array_append (buf, (const guint8*)name, strlen (name));
+}
+
+static void
+emit_section (GByteArray *buf, guint8 id, GByteArray *contents)
+{
+	emit_byte (buf, id);
+	emit_uleb (buf, contents->len);
+	g_byte_array_append (buf, contents->data, contents->len);
+	g_byte_array_set_size (contents, 0);
+}
+
+static int
+load_op_for_type (guint8 type)
+{
+	return type == WASM_TYPE_I32 ? WASM_OP_I32_LOAD : type == WASM_TYPE_I64 ? WASM_OP_I64_LOAD : WASM_OP_F64_LOAD;
+}
+
+static int
+store_op_for_type (guint8 type)
+{
+	return type == WASM_TYPE_I32 ? WASM_OP_I32_STORE : type == WASM_TYPE_I64 ? WASM_OP_I64_STORE : WASM_OP_F64_STORE;
+}
+
+static int
+tmp_local_for_type (guint8 type)
+{
+	return type == WASM_TYPE_I32 ? LOCAL_TMP_I32 : type == WASM_TYPE_I64 ? LOCAL_TMP_I64 : LOCAL_TMP_F64;
+}
+
+static void
+emit_memarg (GByteArray *buf, guint8 type, guint32 offset)
+{
+	/* The alignment is only a hint, locals are not always naturally aligned */
+	emit_uleb (buf, type == WASM_TYPE_I32 ? 2 : 3);
+	emit_uleb (buf, offset);
+}
+
+/* Pushes the value of type TYPE at BASE + OFFSET, BASE is a wasm local */
+static void
+emit_load (TraceGen *g, int base, guint32 offset, guint8 type)
+{
+	emit_byte (g->code, WASM_OP_LOCAL_GET);
+	emit_uleb (g->code, base);
+	emit_byte (g->code, load_op_for_type (type));
+	emit_memarg (g->code, type, offset);
+}
+
+/* Stores the value on top of the operand stack to BASE + OFFSET, leaving it there if KEEP is set */
+static void
+emit_store (TraceGen *g, int base, guint32 offset, guint8 type, gboolean keep)
+{
+	emit_byte (g->code, keep ? WASM_OP_LOCAL_TEE : WASM_OP_LOCAL_SET);
+	emit_uleb (g->code, tmp_local_for_type (type));
+	emit_byte (g->code, WASM_OP_LOCAL_GET);
+	emit_uleb (g->code, base);
+	emit_byte (g->code, WASM_OP_LOCAL_GET);
+	emit_uleb (g->code, tmp_local_for_type (type));
+	emit_byte (g->code, store_op_for_type (type));
+	emit_memarg (g->code, type, offset);
+}
+
+static void
+emit_i32_const (TraceGen *g, gint32 value)
+{
+	emit_byte (g->code, WASM_OP_I32_CONST);
+	emit_sleb (g->code, value);
+}
+
+/* Leaves the trace, continuing at OFFSET in the interpreter */
+static void
+emit_exit (TraceGen *g, int offset)
+{
+	emit_i32_const (g, offset);
+	emit_byte (g->code, WASM_OP_RETURN);
+}
+
+/* Consumes the i32 condition on the operand stack, taking the branch to TARGET if it is true */
+static void
+emit_cond_branch (TraceGen *g, int target)
+{
+	if (target == 0) {
+		/* The loop is the innermost block */
+		emit_byte (g->code, WASM_OP_BR_IF);
+		emit_uleb (g->code, 0);
+		g->loops = TRUE;
+	} else {
+		emit_byte (g->code, WASM_OP_IF);
+		emit_byte (g->code, WASM_TYPE_VOID);
+		emit_exit (g, target);
+		emit_byte (g->code, WASM_OP_END);
+	}
+}
+
+static void
+emit_poll (TraceGen *g, int offset, gboolean safepoint)
+{
+	emit_i32_const (g, (gint32)(gsize)mono_thread_interruption_request_flag ());
+	emit_byte (g->code, WASM_OP_I32_LOAD);
+	emit_memarg (g->code, WASM_TYPE_I32, 0);
+	if (safepoint) {
+		emit_i32_const (g, (gint32)(gsize)&mono_polling_required);
+		emit_byte (g->code, WASM_OP_I32_LOAD);
+		emit_memarg (g->code, WASM_TYPE_I32, 0);
+		emit_byte (g->code, WASM_OP_I32_OR);
+	}
+	emit_cond_branch (g, offset);
+}
+
+static gboolean
+stack_has (TraceGen *g, guint8 t1, guint8 t2)
+{
+	if (t2)
+		return g->sp >= 2 && g->stack [g->sp - 2] == t1 && g->stack [g->sp - 1] == t2;
+	return g->sp >= 1 && g->stack [g->sp - 1] == t1;
+}
+
+static gboolean
+binop (TraceGen *g, guint8 type, guint8 result, int op)
+{
+	if (!stack_has (g, type, type))
+		return FALSE;
+	emit_byte (g->code, op);
+	g->sp -= 2;
+	g->stack [g->sp++] = result;
+	return TRUE;
+}
+
+static gboolean
+shiftop (TraceGen *g, guint8 type, int op)
+{
+	if (!stack_has (g, type, WASM_TYPE_I32))
+		return FALSE;
+	if (type == WASM_TYPE_I64)
+		emit_byte (g->code, WASM_OP_I64_EXTEND_I32_U);
+	emit_byte (g->code, op);
+	g->sp--;
+	return TRUE;
+}
+
+static gboolean
+unop (TraceGen *g, guint8 type, guint8 result, int op)
+{
+	if (!stack_has (g, type, 0))
+		return FALSE;
+	emit_byte (g->code, op);
+	g->stack [g->sp - 1] = result;
+	return TRUE;
+}
+
+static gboolean
+push (TraceGen *g, guint8 type)
+{
+	if (g->sp == TRACE_MAX_STACK)
+		return FALSE;
+	g->stack [g->sp++] = type;
+	return TRUE;
+}
+
+static gboolean
+ldloc (TraceGen *g, int base, guint32 offset, guint8 type)
+{
+	if (!push (g, type))
+		return FALSE;
+	emit_load (g, base, offset, type);
+	return TRUE;
+}
+
+static gboolean
+stloc (TraceGen *g, int base, guint32 offset, guint8 type)
+{
+	if (!stack_has (g, type, 0))
+		return FALSE;
+	emit_store (g, base, offset, type, FALSE);
+	g->sp--;
+	return TRUE;
+}
+
+static gboolean
+ldc (TraceGen *g, guint8 type, gint64 value)
+{
+	if (!push (g, type))
+		return FALSE;
+	emit_byte (g->code, type == WASM_TYPE_I32 ? WASM_OP_I32_CONST : WASM_OP_I64_CONST);
+	emit_sleb (g->code, value);
+	return TRUE;
+}
+
+/* Compares the two i32 values on top of the stack with OP and branches to TARGET */
+static gboolean
+relop_branch (TraceGen *g, int op, int target)
+{
+	if (!stack_has (g, WASM_TYPE_I32, WASM_TYPE_I32) || g->sp != 2)
+		return FALSE;
+	emit_byte (g->code, op);
+	g->sp -= 2;
+	emit_cond_branch (g, target);
+	return TRUE;
+}
+
+static gboolean
+zero_branch (TraceGen *g, gboolean if_true, int target)
+{
+	if (!stack_has (g, WASM_TYPE_I32, 0) || g->sp != 1)
+		return FALSE;
+	if (!if_true)
+		emit_byte (g->code, WASM_OP_I32_EQZ);
+	g->sp--;
+	emit_cond_branch (g, target);
+	return TRUE;
+}
+
+/* Compares local LOC with either local or constant RHS and branches to TARGET */
+static gboolean
+loc_branch (TraceGen *g, int op, guint16 loc, guint16 rhs, gboolean imm, int target)
+{
+	if (g->sp)
+		return FALSE;
+	emit_load (g, LOCAL_LOCALS, loc, WASM_TYPE_I32);
+	if (imm)
+		emit_i32_const (g, (gint16)rhs);
+	else
+		emit_load (g, LOCAL_LOCALS, rhs, WASM_TYPE_I32);
+	emit_byte (g->code, op);
+	emit_cond_branch (g, target);
+	return TRUE;
+}
+
+static int
+relop_for_branch (int opcode)
+{
+	switch (opcode) {
+	case MINT_BEQ_I4: case MINT_BEQ_I4_S: case MINT_BEQ_I4_LOC_S: case MINT_BEQ_I4_LOC_IMM_S:
+		return WASM_OP_I32_EQ;
+	case MINT_BNE_UN_I4: case MINT_BNE_UN_I4_S: case MINT_BNE_UN_I4_LOC_S: case MINT_BNE_UN_I4_LOC_IMM_S:
+		return WASM_OP_I32_NE;
+	case MINT_BLT_I4: case MINT_BLT_I4_S: case MINT_BLT_I4_LOC_S: case MINT_BLT_I4_LOC_IMM_S:
+		return WASM_OP_I32_LT_S;
+	case MINT_BLE_I4: case MINT_BLE_I4_S: case MINT_BLE_I4_LOC_S: case MINT_BLE_I4_LOC_IMM_S:
+		return WASM_OP_I32_LE_S;
+	case MINT_BGT_I4: case MINT_BGT_I4_S: case MINT_BGT_I4_LOC_S: case MINT_BGT_I4_LOC_IMM_S:
+		return WASM_OP_I32_GT_S;
+	case MINT_BGE_I4: case MINT_BGE_I4_S: case MINT_BGE_I4_LOC_S: case MINT_BGE_I4_LOC_IMM_S:
+		return WASM_OP_I32_GE_S;
+	default:
+		return -1;
+	}
+}
+
+/*
+ * Emits the instruction at *IP and advances it. Returns FALSE without emitting anything
+ * if the instruction is not supported in the current state, and sets *ENDED if control
+ * doesn't continue after it.
+ */
+static gboolean
+emit_ins (TraceGen *g, const guint16 **ipp, gboolean *ended)
+{
+	const guint16 *ip = *ipp;
+	int offset = ip - g->start;
+	int opcode = *ip;
+	int target;
+	gint64 l;
+	gboolean ok = TRUE;
+
+	switch (opcode) {
+	case MINT_NOP:
+	case MINT_JITERP_ENTER:
+	case MINT_TIER_BACKEDGE:
+		break;
+	case MINT_CHECKPOINT:
+	case MINT_SAFEPOINT:
+		if (g->sp)
+			return FALSE;
+		emit_poll (g, offset, opcode == MINT_SAFEPOINT);
+		break;
+
+	case MINT_LDC_I4_M1: case MINT_LDC_I4_0: case MINT_LDC_I4_1: case MINT_LDC_I4_2:
+	case MINT_LDC_I4_3: case MINT_LDC_I4_4: case MINT_LDC_I4_5: case MINT_LDC_I4_6:
+	case MINT_LDC_I4_7: case MINT_LDC_I4_8:
+		if (!ldc (g, WASM_TYPE_I32, opcode - MINT_LDC_I4_0))
+			return FALSE;
+		break;
+	case MINT_LDC_I4_S:
+		if (!ldc (g, WASM_TYPE_I32, (gint16)ip [1]))
+			return FALSE;
+		break;
+	case MINT_LDC_I4:
+		if (!ldc (g, WASM_TYPE_I32, (gint32)READ32 (ip + 1)))
+			return FALSE;
+		break;
+	case MINT_LDC_I8_S:
+		if (!ldc (g, WASM_TYPE_I64, (gint16)ip [1]))
+			return FALSE;
+		break;
+	case MINT_LDC_I8:
+		if (!ldc (g, WASM_TYPE_I64, (gint64)READ64 (ip + 1)))
+			return FALSE;
+		break;
+	case MINT_LDC_R8:
+		if (!push (g, WASM_TYPE_F64))
+			return FALSE;
+		/* The operand is the bit pattern, stored in the byte order of the host like wasm */
+		l = (gint64)READ64 (ip + 1);
+		emit_byte (g->code, WASM_OP_F64_CONST);
+		g_byte_array_append (g->code, (const guint8*)&l, sizeof (l));
+		break;
+	case MINT_DUP:
+		if (!g->sp || !push (g, g->stack [g->sp - 1]))
+			return FALSE;
+		emit_byte (g->code, WASM_OP_LOCAL_TEE);
+		emit_uleb (g->code, tmp_local_for_type (g->stack [g->sp - 1]));
+		emit_byte (g->code, WASM_OP_LOCAL_GET);
+		emit_uleb (g->code, tmp_local_for_type (g->stack [g->sp - 1]));
+		break;
+	case MINT_POP:
+		/* Only the plain pop of the top of the stack */
+		if (ip [1] || !g->sp)
+			return FALSE;
+		emit_byte (g->code, WASM_OP_DROP);
+		g->sp--;
+		break;
+
+	case MINT_LDLOC_I4:
+		if (!ldloc (g, LOCAL_LOCALS, ip [1], WASM_TYPE_I32))
+			return FALSE;
+		break;
+	case MINT_LDLOC_I8:
+		if (!ldloc (g, LOCAL_LOCALS, ip [1], WASM_TYPE_I64))
+			return FALSE;
+		break;
+	case MINT_LDLOC_R8:
+		if (!ldloc (g, LOCAL_LOCALS, ip [1], WASM_TYPE_F64))
+			return FALSE;
+		break;
+	case MINT_STLOC_I4:
+		if (!stloc (g, LOCAL_LOCALS, ip [1], WASM_TYPE_I32))
+			return FALSE;
+		break;
+	case MINT_STLOC_I8:
+		if (!stloc (g, LOCAL_LOCALS, ip [1], WASM_TYPE_I64))
+			return FALSE;
+		break;
+	case MINT_STLOC_R8:
+		if (!stloc (g, LOCAL_LOCALS, ip [1], WASM_TYPE_F64))
+			return FALSE;
+		break;
+	case MINT_STLOC_NP_I4:
+		if (!stack_has (g, WASM_TYPE_I32, 0))
+			return FALSE;
+		emit_store (g, LOCAL_LOCALS, ip [1], WASM_TYPE_I32, TRUE);
+		break;
+	case MINT_LDARG_I4:
+		if (!ldloc (g, LOCAL_ARGS, ip [1] * sizeof (stackval), WASM_TYPE_I32))
+			return FALSE;
+		break;
+	case MINT_LDARG_I8:
+		if (!ldloc (g, LOCAL_ARGS, ip [1] * sizeof (stackval), WASM_TYPE_I64))
+			return FALSE;
+		break;
+	case MINT_STARG_I4:
+		if (!stloc (g, LOCAL_ARGS, ip [1] * sizeof (stackval), WASM_TYPE_I32))
+			return FALSE;
+		break;
+	case MINT_STARG_I8:
+		if (!stloc (g, LOCAL_ARGS, ip [1] * sizeof (stackval), WASM_TYPE_I64))
+			return FALSE;
+		break;
+	case MINT_MOVLOC_4:
+	case MINT_MOVLOC_8: {
+		guint8 type = opcode == MINT_MOVLOC_4 ? WASM_TYPE_I32 : WASM_TYPE_I64;
+		emit_byte (g->code, WASM_OP_LOCAL_GET);
+		emit_uleb (g->code, LOCAL_LOCALS);
+		emit_load (g, LOCAL_LOCALS, ip [1], type);
+		emit_byte (g->code, store_op_for_type (type));
+		emit_memarg (g->code, type, ip [2]);
+		break;
+	}
+	case MINT_ADD_I4_IMM_LOC:
+		emit_byte (g->code, WASM_OP_LOCAL_GET);
+		emit_uleb (g->code, LOCAL_LOCALS);
+		emit_load (g, LOCAL_LOCALS, ip [1], WASM_TYPE_I32);
+		emit_i32_const (g, (gint16)ip [3]);
+		emit_byte (g->code, WASM_OP_I32_ADD);
+		emit_byte (g->code, WASM_OP_I32_STORE);
+		emit_memarg (g->code, WASM_TYPE_I32, ip [2]);
+		break;
+
+	case MINT_ADD_I4:
+		ok = binop (g, WASM_TYPE_I32, WASM_TYPE_I32, WASM_OP_I32_ADD);
+		break;
+	case MINT_SUB_I4:
+		ok = binop (g, WASM_TYPE_I32, WASM_TYPE_I32, WASM_OP_I32_SUB);
+		break;
+	case MINT_MUL_I4:
+		ok = binop (g, WASM_TYPE_I32, WASM_TYPE_I32, WASM_OP_I32_MUL);
+		break;
+	case MINT_AND_I4:
+		ok = binop (g, WASM_TYPE_I32, WASM_TYPE_I32, WASM_OP_I32_AND);
+		break;
+	case MINT_OR_I4:
+		ok = binop (g, WASM_TYPE_I32, WASM_TYPE_I32, WASM_OP_I32_OR);
+		break;
+	case MINT_XOR_I4:
+		ok = binop (g, WASM_TYPE_I32, WASM_TYPE_I32, WASM_OP_I32_XOR);
+		break;
+	case MINT_ADD_I8:
+		ok = binop (g, WASM_TYPE_I64, WASM_TYPE_I64, WASM_OP_I64_ADD);
+		break;
+	case MINT_SUB_I8:
+		ok = binop (g, WASM_TYPE_I64, WASM_TYPE_I64, WASM_OP_I64_SUB);
+		break;
+	case MINT_MUL_I8:
+		ok = binop (g, WASM_TYPE_I64, WASM_TYPE_I64, WASM_OP_I64_MUL);
+		break;
+	case MINT_AND_I8:
+		ok = binop (g, WASM_TYPE_I64, WASM_TYPE_I64, WASM_OP_I64_AND);
+		break;
+	case MINT_OR_I8:
+		ok = binop (g, WASM_TYPE_I64, WASM_TYPE_I64, WASM_OP_I64_OR);
+		break;
+	case MINT_XOR_I8:
+		ok = binop (g, WASM_TYPE_I64, WASM_TYPE_I64, WASM_OP_I64_XOR);
+		break;
+	case MINT_ADD_R8:
+		ok = binop (g, WASM_TYPE_F64, WASM_TYPE_F64, WASM_OP_F64_ADD);
+		break;
+	case MINT_SUB_R8:
+		ok = binop (g, WASM_TYPE_F64, WASM_TYPE_F64, WASM_OP_F64_SUB);
+		break;
+	case MINT_MUL_R8:
+		ok = binop (g, WASM_TYPE_F64, WASM_TYPE_F64, WASM_OP_F64_MUL);
+		break;
+	case MINT_CEQ_I4:
+		ok = binop (g, WASM_TYPE_I32, WASM_TYPE_I32, WASM_OP_I32_EQ);
+		break;
+	case MINT_CGT_I4:
+		ok = binop (g, WASM_TYPE_I32, WASM_TYPE_I32, WASM_OP_I32_GT_S);
+		break;
+	case MINT_CLT_I4:
+		ok = binop (g, WASM_TYPE_I32, WASM_TYPE_I32, WASM_OP_I32_LT_S);
+		break;
+	case MINT_SHL_I4:
+		ok = shiftop (g, WASM_TYPE_I32, WASM_OP_I32_SHL);
+		break;
+	case MINT_SHR_I4:
+		ok = shiftop (g, WASM_TYPE_I32, WASM_OP_I32_SHR_S);
+		break;
+	case MINT_SHR_UN_I4:
+		ok = shiftop (g, WASM_TYPE_I32, WASM_OP_I32_SHR_U);
+		break;
+	case MINT_SHL_I8:
+		ok = shiftop (g, WASM_TYPE_I64, WASM_OP_I64_SHL);
+		break;
+	case MINT_SHR_I8:
+		ok = shiftop (g, WASM_TYPE_I64, WASM_OP_I64_SHR_S);
+		break;
+	case MINT_SHR_UN_I8:
+		ok = shiftop (g, WASM_TYPE_I64, WASM_OP_I64_SHR_U);
+		break;
+	case MINT_CONV_I8_I4:
+		ok = unop (g, WASM_TYPE_I32, WASM_TYPE_I64, WASM_OP_I64_EXTEND_I32_S);
+		break;
+	case MINT_CONV_I4_I8:
+		ok = unop (g, WASM_TYPE_I64, WASM_TYPE_I32, WASM_OP_I32_WRAP_I64);
+		break;
+	case MINT_CONV_R8_I4:
+		ok = unop (g, WASM_TYPE_I32, WASM_TYPE_F64, WASM_OP_F64_CONVERT_I32_S);
+		break;
+
+	case MINT_ADD1_I4:
+	case MINT_SUB1_I4:
+		if (!stack_has (g, WASM_TYPE_I32, 0))
+			return FALSE;
+		emit_i32_const (g, 1);
+		emit_byte (g->code, opcode == MINT_ADD1_I4 ? WASM_OP_I32_ADD : WASM_OP_I32_SUB);
+		break;
+	case MINT_ADD1_I8:
+	case MINT_SUB1_I8:
+		if (!stack_has (g, WASM_TYPE_I64, 0))
+			return FALSE;
+		emit_byte (g->code, WASM_OP_I64_CONST);
+		emit_sleb (g->code, 1);
+		emit_byte (g->code, opcode == MINT_ADD1_I8 ? WASM_OP_I64_ADD : WASM_OP_I64_SUB);
+		break;
+	case MINT_NEG_I4:
+		if (!stack_has (g, WASM_TYPE_I32, 0))
+			return FALSE;
+		emit_byte (g->code, WASM_OP_LOCAL_SET);
+		emit_uleb (g->code, LOCAL_TMP_I32);
+		emit_i32_const (g, 0);
+		emit_byte (g->code, WASM_OP_LOCAL_GET);
+		emit_uleb (g->code, LOCAL_TMP_I32);
+		emit_byte (g->code, WASM_OP_I32_SUB);
+		break;
+
+	case MINT_BR_S:
+	case MINT_BR:
+		target = offset + (opcode == MINT_BR_S ? (gint16)ip [1] : (gint32)READ32 (ip + 1));
+		if (g->sp)
+			return FALSE;
+		if (target > offset) {
+			/* Follow the branch, the trace stays linear */
+			*ipp = g->start + target;
+			return TRUE;
+		}
+		if (target == 0) {
+			emit_byte (g->code, WASM_OP_BR);
+			emit_uleb (g->code, 0);
+			g->loops = TRUE;
+		} else {
+			emit_exit (g, target);
+		}
+		*ended = TRUE;
+		break;
+	case MINT_BRTRUE_I4_S:
+	case MINT_BRFALSE_I4_S:
+		if (!zero_branch (g, opcode == MINT_BRTRUE_I4_S, offset + (gint16)ip [1]))
+			return FALSE;
+		break;
+	case MINT_BRTRUE_I4:
+	case MINT_BRFALSE_I4:
+		if (!zero_branch (g, opcode == MINT_BRTRUE_I4, offset + (gint32)READ32 (ip + 1)))
+			return FALSE;
+		break;
+	case MINT_BEQ_I4_S: case MINT_BNE_UN_I4_S: case MINT_BLT_I4_S:
+	case MINT_BLE_I4_S: case MINT_BGT_I4_S: case MINT_BGE_I4_S:
+		if (!relop_branch (g, relop_for_branch (opcode), offset + (gint16)ip [1]))
+			return FALSE;
+		break;
+	case MINT_BEQ_I4: case MINT_BNE_UN_I4: case MINT_BLT_I4:
+	case MINT_BLE_I4: case MINT_BGT_I4: case MINT_BGE_I4:
+		if (!relop_branch (g, relop_for_branch (opcode), offset + (gint32)READ32 (ip + 1)))
+			return FALSE;
+		break;
+	case MINT_BEQ_I4_LOC_S: case MINT_BNE_UN_I4_LOC_S: case MINT_BLT_I4_LOC_S:
+	case MINT_BLE_I4_LOC_S: case MINT_BGT_I4_LOC_S: case MINT_BGE_I4_LOC_S:
+		if (!loc_branch (g, relop_for_branch (opcode), ip [2], ip [3], FALSE, offset + (gint16)ip [1]))
+			return FALSE;
+		break;
+	case MINT_BEQ_I4_LOC_IMM_S: case MINT_BNE_UN_I4_LOC_IMM_S: case MINT_BLT_I4_LOC_IMM_S:
+	case MINT_BLE_I4_LOC_IMM_S: case MINT_BGT_I4_LOC_IMM_S: case MINT_BGE_I4_LOC_IMM_S:
+		if (!loc_branch (g, relop_for_branch (opcode), ip [2], ip [3], TRUE, offset + (gint16)ip [1]))
+			return FALSE;
+		break;
+	default:
+		return FALSE;
+	}
+
+	if (!ok)
+		return FALSE;
+	*ipp = ip + mono_interp_oplen [opcode];
+	return TRUE;
+}
+
+gboolean
+mono_interp_jiterp_generate_module (const guint16 *start, GByteArray *module)
+{
+	static const guint8 header [] = { 0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00 };
+	GByteArray *section, *body;
+	TraceGen g;
+	const guint16 *ip = start;
+	const guint16 *exit_ip = start;
+	guint exit_len;
+	int num_ops = 0, exit_ops = 0;
+	gboolean ended = FALSE;
+
+	memset (&g, 0, sizeof (g));
+	g.start = start;
+	g.code = body = g_byte_array_new ();
+
+	/* Three scratch locals, one of each type */
+	emit_uleb (body, 3);
+	emit_uleb (body, 1);
+	emit_byte (body, WASM_TYPE_I32);
+	emit_uleb (body, 1);
+	emit_byte (body, WASM_TYPE_I64);
+	emit_uleb (body, 1);
+	emit_byte (body, WASM_TYPE_F64);
+
+	emit_byte (body, WASM_OP_LOOP);
+	emit_byte (body, WASM_TYPE_VOID);
+	exit_len = body->len;
+
+	while (num_ops < TRACE_MAX_OPS && !ended) {
+		/* The trace can only be left where the evaluation stack is empty */
+		if (!g.sp) {
+			exit_ip = ip;
+			exit_len = body->len;
+			exit_ops = num_ops;
+		}
+		if (!emit_ins (&g, &ip, &ended))
+			break;
+		num_ops++;
+	}
+
+	if (!ended) {
+		g_byte_array_set_size (body, exit_len);
+		num_ops = exit_ops;
+		emit_exit (&g, exit_ip - start);
+	}
+	emit_byte (body, WASM_OP_END);
+	/* Control never leaves the loop at the end */
+	emit_byte (body, WASM_OP_UNREACHABLE);
+	emit_byte (body, WASM_OP_END);
+
+	if (!(g.loops || num_ops >= TRACE_MIN_OPS)) {
+		g_byte_array_free (body, TRUE);
+		return FALSE;
+	}
+
+	section = g_byte_array_new ();
+	g_byte_array_append (module, header, sizeof (header));
+
+	/* (func (param i32 i32) (result i32)) */
+	emit_uleb (section, 1);
+	emit_byte (section, WASM_TYPE_FUNC);
+	emit_uleb (section, 2);
+	emit_byte (section, WASM_TYPE_I32);
+	emit_byte (section, WASM_TYPE_I32);
+	emit_uleb (section, 1);
+	emit_byte (section, WASM_TYPE_I32);
+	emit_section (module, 1, section);
+
+	/* (import "m" "h" (memory 1)) */
+	emit_uleb (section, 1);
+	emit_name (section, "m");
+	emit_name (section, "h");
+	emit_byte (section, 0x02);
+	emit_uleb (section, 0);
+	emit_uleb (section, 1);
+	emit_section (module, 2, section);
+
+	emit_uleb (section, 1);
+	emit_uleb (section, 0);
+	emit_section (module, 3, section);
+
+	/* (export "f" (func 0)) */
+	emit_uleb (section, 1);
+	emit_name (section, "f");
+	emit_byte (section, 0x00);
+	emit_uleb (section, 0);
+	emit_section (module, 7, section);
+
+	emit_uleb (section, 1);
+	emit_uleb (section, body->len);
+	g_byte_array_append (section, body->data, body->len);
+	emit_section (module, 10, section);
+
+	g_byte_array_free (section, TRUE);
+	g_byte_array_free (body, TRUE);
+	return module->len <= TRACE_MAX_MODULE_SIZE;
+}
+
+#ifdef INTERP_ENABLE_JITERPRETER
+
+/* Defined in library_mono.js, returns the index of the trace in the function table or 0 */
+extern int mono_wasm_jiterp_instantiate (const guint8 *module, int len);
+
+void
+mono_interp_jiterp_compile_trace (InterpMethod *imethod, const guint16 *start, InterpTrace *trace)
+{
+	GByteArray *module = g_byte_array_new ();
+	int index = 0;
+
+	if (mono_interp_jiterp_generate_module (start, module))
+		index = mono_wasm_jiterp_instantiate (module->data, module->len);
+	g_byte_array_free (module, TRUE);
+
+	if (!index) {
+		trace->failed = TRUE;
+		return;
+	}
+	trace->func = (InterpTraceFunc)(gsize)index;
+	UnlockedIncrement (&mono_interp_stats.jiterp_traces);
+}
+
+#endif
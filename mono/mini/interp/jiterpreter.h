@@ -0,0 +1,48 @@
+/**
+ * \file
+ * Compilation of hot interpreter traces to WebAssembly
+ *
+ * Licensed under the MIT license. See LICENSE file in the project root for full license information.
+ */
+
+#ifndef __MONO_MINI_INTERP_JITERPRETER_H__
+#define __MONO_MINI_INTERP_JITERPRETER_H__
+
+#include "interp-internals.h"
+
+/*
+ * Traces are compiled into separate modules which are added to the function table of
+ * the main one. With pthreads every worker has its own table, so they would have to be
+ * instantiated on each of them, which isn't supported yet.
+ */
+#if defined (HOST_WASM) && !defined (__EMSCRIPTEN_PTHREADS__)
+#define INTERP_ENABLE_JITERPRETER 1
+#endif
+
+/*
+ * Runs the trace and returns the offset, relative to the start of the trace, of the
+ * instruction the interpreter continues from.
+ */
+typedef int (*InterpTraceFunc) (guchar *locals, stackval *args);
+
+/* Referenced by the MINT_JITERP_ENTER instruction at the start of each trace */
+typedef struct {
+	InterpTraceFunc func;
+	gint32 hit_count;
+	gboolean failed;
+} InterpTrace;
+
+/*
+ * Emits a WebAssembly module exporting the trace starting at START as "f", which has
+ * the InterpTraceFunc signature and imports the memory as "m"."h". Returns FALSE if the
+ * trace is too short to be worth compiling.
+ */
+gboolean
+mono_interp_jiterp_generate_module (const guint16 *start, GByteArray *module);
+
+#ifdef INTERP_ENABLE_JITERPRETER
+void
+mono_interp_jiterp_compile_trace (InterpMethod *imethod, const guint16 *start, InterpTrace *trace);
+#endif
+
+#endif /* __MONO_MINI_INTERP_JITERPRETER_H__ */
@@ -74,6 +74,9 @@ mono_interp_dis_mintop(const guint16 *base, const guint16 *ip)
 	case MintOpShortInt:
 		g_string_append_printf (str, " %d", * (short *)(ip + 1));
 		break;
+	case MintOpTwoShortsAndShortInt:
+		g_string_append_printf (str, " %u,%u,%d", * (guint16 *)(ip + 1), * (guint16 *)(ip + 2), * (short *)(ip + 3));
+		break;
 	case MintOpClassToken:
 	case MintOpMethodToken:
 	case MintOpFieldToken:
@@ -100,6 +103,14 @@ mono_interp_dis_mintop(const guint16 *base, const guint16 *ip)
 		target = ip + * (short *)(ip + 1) - base;
 		g_string_append_printf (str, " IL_%04x", target);
 		break;
+	case MintOpShortBranchTwoShorts:
+		target = ip + * (short *)(ip + 1) - base;
+		g_string_append_printf (str, " IL_%04x %u,%u", target, * (guint16 *)(ip + 2), * (guint16 *)(ip + 3));
+		break;
+	case MintOpShortBranchShortAndShortInt:
+		target = ip + * (short *)(ip + 1) - base;
+		g_string_append_printf (str, " IL_%04x %u,%d", target, * (guint16 *)(ip + 2), * (short *)(ip + 3));
+		break;
 	case MintOpBranch:
 		target = ip + (gint32)READ32 (ip + 1) - base;
 		g_string_append_printf (str, " IL_%04x", target);
@@ -23,7 +23,10 @@ typedef enum
 	MintOpFieldToken,
 	MintOpClassToken,
 	MintOpTwoShorts,
-	MintOpShortAndInt
+	MintOpShortAndInt,
+	MintOpTwoShortsAndShortInt,
+	MintOpShortBranchTwoShorts,
+	MintOpShortBranchShortAndShortInt
 } MintOpArgType;
 
 #define OPDEF(a,b,c,d) \
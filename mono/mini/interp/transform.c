@@ -10,6 +10,7 @@
 #include "config.h"
 #include <string.h>
 #include <mono/metadata/appdomain.h>
+#include <mono/metadata/assembly.h>
 #include <mono/metadata/class-internals.h>
 #include <mono/metadata/debug-helpers.h>
 #include <mono/metadata/exception.h>
@@ -29,6 +30,7 @@
 
 #include "mintops.h"
 #include "interp-internals.h"
+#include "jiterpreter.h"
 #include "interp.h"
 
 #define INTERP_INST_FLAG_SEQ_POINT_NONEMPTY_STACK 1
@@ -124,6 +126,8 @@ typedef struct
 	GPtrArray *relocs;
 	gboolean verbose_level;
 	GArray *line_numbers;
+	/* Code from other methods was inlined */
+	gboolean has_inlined_code;
 } TransformData;
 
 #define STACK_TYPE_I4 0
@@ -285,6 +289,22 @@ static const MagicIntrinsic int_cmpop[] = {
 	{ "op_LessThanOrEqual", {MINT_CLE_P, MINT_CLE_UN_P, MINT_CLE_FP}}
 };
 
+typedef struct {
+	const gchar *op_name;
+	/* Indexed by element type: 1, 2, 4 and 8 byte integers, then R4 and R8 */
+	guint16 insn [6];
+} SimdIntrinsic;
+
+static const SimdIntrinsic v128_binop[] = {
+	{ "op_Addition", {MINT_SIMD_V128_ADD_I1, MINT_SIMD_V128_ADD_I2, MINT_SIMD_V128_ADD_I4, MINT_SIMD_V128_ADD_I8, MINT_SIMD_V128_ADD_R4, MINT_SIMD_V128_ADD_R8}},
+	{ "op_Subtraction", {MINT_SIMD_V128_SUB_I1, MINT_SIMD_V128_SUB_I2, MINT_SIMD_V128_SUB_I4, MINT_SIMD_V128_SUB_I8, MINT_SIMD_V128_SUB_R4, MINT_SIMD_V128_SUB_R8}},
+	{ "op_Multiply", {MINT_SIMD_V128_MUL_I1, MINT_SIMD_V128_MUL_I2, MINT_SIMD_V128_MUL_I4, MINT_SIMD_V128_MUL_I8, MINT_SIMD_V128_MUL_R4, MINT_SIMD_V128_MUL_R8}},
+	{ "op_Division", {MINT_NIY, MINT_NIY, MINT_NIY, MINT_NIY, MINT_SIMD_V128_DIV_R4, MINT_SIMD_V128_DIV_R8}},
+	{ "op_BitwiseAnd", {MINT_SIMD_V128_AND, MINT_SIMD_V128_AND, MINT_SIMD_V128_AND, MINT_SIMD_V128_AND, MINT_SIMD_V128_AND, MINT_SIMD_V128_AND}},
+	{ "op_BitwiseOr", {MINT_SIMD_V128_OR, MINT_SIMD_V128_OR, MINT_SIMD_V128_OR, MINT_SIMD_V128_OR, MINT_SIMD_V128_OR, MINT_SIMD_V128_OR}},
+	{ "op_ExclusiveOr", {MINT_SIMD_V128_XOR, MINT_SIMD_V128_XOR, MINT_SIMD_V128_XOR, MINT_SIMD_V128_XOR, MINT_SIMD_V128_XOR, MINT_SIMD_V128_XOR}}
+};
+
 static gboolean generate_code (TransformData *td, MonoMethod *method, MonoMethodHeader *header, MonoGenericContext *generic_context, MonoError *error);
 
 static InterpInst*
@@ -426,6 +446,8 @@ handle_branch (TransformData *td, int short_op, int long_op, int offset)
 		g_assert_not_reached ();
 	/* Add exception checkpoint or safepoint for backward branches */
 	if (offset < 0) {
+		if (mono_interp_opt & INTERP_OPT_TIERING)
+			interp_add_ins (td, MINT_TIER_BACKEDGE);
 		if (mono_threads_are_safepoints_enabled ())
 			interp_add_ins (td, MINT_SAFEPOINT);
 		else
@@ -772,6 +794,34 @@ load_local (TransformData *td, int n)
 	load_local_general (td, offset, type);
 }
 
+static int
+get_movloc_for_mt (int mt)
+{
+	switch (mt) {
+	case MINT_TYPE_I1:
+	case MINT_TYPE_U1:
+		return MINT_MOVLOC_1;
+	case MINT_TYPE_I2:
+	case MINT_TYPE_U2:
+		return MINT_MOVLOC_2;
+	case MINT_TYPE_I4:
+	case MINT_TYPE_R4:
+		return MINT_MOVLOC_4;
+	case MINT_TYPE_I8:
+	case MINT_TYPE_R8:
+		return MINT_MOVLOC_8;
+	case MINT_TYPE_O:
+	case MINT_TYPE_P:
+#if SIZEOF_VOID_P == 8
+		return MINT_MOVLOC_8;
+#else
+		return MINT_MOVLOC_4;
+#endif
+	default:
+		g_assert_not_reached ();
+	}
+}
+
 static void 
 store_local_general (TransformData *td, int offset, MonoType *type)
 {
@@ -798,8 +848,21 @@ store_local_general (TransformData *td, int offset, MonoType *type)
 			POP_VT(td, size);
 	} else {
 		g_assert (mt < MINT_TYPE_VT);
-		interp_add_ins (td, MINT_STLOC_I1 + (mt - MINT_TYPE_I1));
-		td->last_ins->data [0] = offset; /*FIX for large offset */
+		if (!td->gen_sdb_seq_points &&
+				!td->is_bb_start [td->in_start - td->il_code] && td->last_ins != NULL &&
+				td->last_ins->opcode == MINT_LDLOC_I1 + (mt - MINT_TYPE_I1)) {
+			/* ldloc + stloc of the same type, copy the value without going through the stack */
+			int src_offset = td->last_ins->data [0];
+			int il_offset = td->last_ins->il_offset;
+			interp_remove_ins (td, td->last_ins);
+			interp_add_ins (td, get_movloc_for_mt (mt));
+			td->last_ins->il_offset = il_offset;
+			td->last_ins->data [0] = src_offset;
+			td->last_ins->data [1] = offset;
+		} else {
+			interp_add_ins (td, MINT_STLOC_I1 + (mt - MINT_TYPE_I1));
+			td->last_ins->data [0] = offset; /*FIX for large offset */
+		}
 	}
 	--td->sp;
 }
@@ -1056,6 +1119,58 @@ interp_get_ldind_for_mt (int mt)
 }
 
 /* Return TRUE if call transformation is finished */
+/*
+ * Handles the operators of System.Numerics.Vector<T> when it is 16 bytes in size,
+ * the other methods go through the managed implementation.
+ */
+static gboolean
+interp_handle_vector_t_intrinsics (TransformData *td, MonoMethod *target_method, MonoMethodSignature *csignature)
+{
+	MonoClass *klass = target_method->klass;
+	MonoType *etype = mono_class_get_context (klass)->class_inst->type_argv [0];
+	int i, index;
+
+	if (mono_class_value_size (klass, NULL) != 16)
+		return FALSE;
+
+	switch (etype->type) {
+	case MONO_TYPE_I1: case MONO_TYPE_U1: index = 0; break;
+	case MONO_TYPE_I2: case MONO_TYPE_U2: index = 1; break;
+	case MONO_TYPE_I4: case MONO_TYPE_U4: index = 2; break;
+	case MONO_TYPE_I8: case MONO_TYPE_U8: index = 3; break;
+	case MONO_TYPE_R4: index = 4; break;
+	case MONO_TYPE_R8: index = 5; break;
+	default: return FALSE;
+	}
+
+	if (!strcmp (target_method->name, "get_Count") && csignature->param_count == 0) {
+		int count = 16 / mono_class_value_size (mono_class_from_mono_type_internal (etype), NULL);
+		interp_add_ins (td, MINT_LDC_I4_S);
+		td->last_ins->data [0] = count;
+		PUSH_SIMPLE_TYPE (td, STACK_TYPE_I4);
+		td->ip += 5;
+		return TRUE;
+	}
+
+	/* Only the Vector<T> op Vector<T> overloads */
+	if (csignature->param_count != 2 || csignature->params [0]->type != MONO_TYPE_GENERICINST || csignature->params [1]->type != MONO_TYPE_GENERICINST)
+		return FALSE;
+
+	for (i = 0; i < sizeof (v128_binop) / sizeof (SimdIntrinsic); ++i) {
+		if (!strcmp (v128_binop [i].op_name, target_method->name)) {
+			if (v128_binop [i].insn [index] == MINT_NIY)
+				return FALSE;
+			interp_add_ins (td, v128_binop [i].insn [index]);
+			td->sp -= 1;
+			POP_VT (td, 16);
+			SET_TYPE (td->sp - 1, STACK_TYPE_VT, klass);
+			td->ip += 5;
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
 static gboolean
 interp_handle_intrinsics (TransformData *td, MonoMethod *target_method, MonoClass *constrained_class, MonoMethodSignature *csignature, gboolean readonly, int *op)
 {
@@ -1500,6 +1615,10 @@ interp_handle_intrinsics (TransformData *td, MonoMethod *target_method, MonoClas
 			td->ip += 5;
 			return TRUE;
 		}
+	} else if (!strcmp (klass_name_space, "System.Numerics") && !strcmp (klass_name, "Vector`1") &&
+			(in_corlib || !strcmp (m_class_get_image (target_method->klass)->assembly_name, "System.Numerics.Vectors"))) {
+		if (interp_handle_vector_t_intrinsics (td, target_method, csignature))
+			return TRUE;
 	} else if (in_corlib && !strcmp (klass_name_space, "System.Threading") && !strcmp (klass_name, "Interlocked")) {
 #if ENABLE_NETCORE
 		if (!strcmp (tm, "MemoryBarrier") && csignature->param_count == 0)
@@ -1710,45 +1829,66 @@ interp_method_check_inlining (TransformData *td, MonoMethod *method)
 {
 	MonoMethodHeaderSummary header;
 
-	if (td->method == method)
+	if (td->method == method) {
+		UnlockedIncrement (&mono_interp_stats.inline_fail_recursive);
 		return FALSE;
+	}
 
-	if (!mono_method_get_header_summary (method, &header))
+	if (!mono_method_get_header_summary (method, &header)) {
+		UnlockedIncrement (&mono_interp_stats.inline_fail_no_header);
 		return FALSE;
+	}
 
 	/*runtime, icall and pinvoke are checked by summary call*/
 	if ((method->iflags & METHOD_IMPL_ATTRIBUTE_NOINLINING) ||
 	    (method->iflags & METHOD_IMPL_ATTRIBUTE_SYNCHRONIZED) ||
-	    (mono_class_is_marshalbyref (method->klass)) ||
-	    header.has_clauses)
+	    (mono_class_is_marshalbyref (method->klass))) {
+		UnlockedIncrement (&mono_interp_stats.inline_fail_attributes);
+		return FALSE;
+	}
+
+	if (header.has_clauses) {
+		UnlockedIncrement (&mono_interp_stats.inline_fail_clauses);
 		return FALSE;
+	}
 
-	if (header.code_size >= INLINE_LENGTH_LIMIT)
+	if (header.code_size >= INLINE_LENGTH_LIMIT) {
+		UnlockedIncrement (&mono_interp_stats.inline_fail_too_large);
 		return FALSE;
+	}
 
 	if (mono_class_needs_cctor_run (method->klass, NULL)) {
 		MonoVTable *vtable;
 		ERROR_DECL (error);
-		if (!m_class_get_runtime_info (method->klass))
+		if (!m_class_get_runtime_info (method->klass)) {
 			/* No vtable created yet */
+			UnlockedIncrement (&mono_interp_stats.inline_fail_cctor);
 			return FALSE;
+		}
 		vtable = mono_class_vtable_checked (td->rtm->domain, method->klass, error);
 		if (!is_ok (error)) {
 			mono_error_cleanup (error);
+			UnlockedIncrement (&mono_interp_stats.inline_fail_cctor);
 			return FALSE;
 		}
-		if (!vtable->initialized)
+		if (!vtable->initialized) {
+			UnlockedIncrement (&mono_interp_stats.inline_fail_cctor);
 			return FALSE;
+		}
 	}
 
 	/* We currently access at runtime the wrapper data */
-	if (method->wrapper_type != MONO_WRAPPER_NONE)
+	if (method->wrapper_type != MONO_WRAPPER_NONE) {
+		UnlockedIncrement (&mono_interp_stats.inline_fail_wrapper);
 		return FALSE;
+	}
 
 	/* Our usage of `emit_store_value_as_local ()` for nint, nuint and nfloat
 	 * is kinda hacky, and doesn't work with the inliner */
-	if (mono_class_get_magic_index (method->klass) >= 0)
+	if (mono_class_get_magic_index (method->klass) >= 0) {
+		UnlockedIncrement (&mono_interp_stats.inline_fail_magic_type);
 		return FALSE;
+	}
 
 	return TRUE;
 }
@@ -1835,6 +1975,7 @@ interp_inline_method (TransformData *td, MonoMethod *target_method, MonoMethodHe
 		if (td->verbose_level)
 			g_print ("Inline end method %s.%s\n", m_class_get_name (target_method->klass), target_method->name);
 		UnlockedIncrement (&mono_interp_stats.inlined_methods);
+		td->has_inlined_code = TRUE;
 		// Make sure we have an IR instruction associated with the now removed IL CALL
 		// FIXME This could be prettier. We might be able to make inlining saner now that
 		// that we can easily tweak the instruction list.
@@ -2222,6 +2363,7 @@ interp_transform_call (TransformData *td, MonoMethod *method, MonoMethod *target
 					td->last_ins->data [1] = -2 * MONO_IMT_SIZE + mono_method_get_imt_slot (target_method);
 				else
 					td->last_ins->data [1] = mono_method_get_vtable_slot (target_method);
+				td->last_ins->data [2] = get_data_item_index (td, mono_domain_alloc0 (domain, sizeof (InterpInlineCache)));
 			}
 		}
 	}
@@ -2369,7 +2511,7 @@ get_basic_blocks (TransformData *td)
 }
 
 static void
-interp_save_debug_info (InterpMethod *rtm, MonoMethodHeader *header, TransformData *td, GArray *line_numbers)
+interp_save_debug_info (InterpMethod *rtm, MonoMethodHeader *header, int code_len, GArray *line_numbers)
 {
 	MonoDebugMethodJitInfo *dinfo;
 	int i;
@@ -2387,7 +2529,7 @@ interp_save_debug_info (InterpMethod *rtm, MonoMethodHeader *header, TransformDa
 	dinfo->num_locals = header->num_locals;
 	dinfo->locals = g_new0 (MonoDebugVarInfo, header->num_locals);
 	dinfo->code_start = (guint8*)rtm->code;
-	dinfo->code_size = td->new_code_end - td->new_code;
+	dinfo->code_size = code_len;
 	dinfo->epilogue_begin = 0;
 	dinfo->has_var_info = TRUE;
 	dinfo->num_line_numbers = line_numbers->len;
@@ -2902,6 +3044,351 @@ interp_emit_sfld_access (TransformData *td, MonoClassField *field, MonoClass *fi
 	}
 }
 
+/*
+ * Local constant and copy propagation and dead store elimination, done on the
+ * IR of each bblock. A local is tracked only if it is accessed exclusively
+ * through the ldloc/stloc/movloc opcodes, so its value can't change behind
+ * our back. Stores are only killed if nothing which could branch, throw or
+ * call happens before the local is overwritten.
+ */
+enum {
+	LOCAL_VALUE_NONE,
+	LOCAL_VALUE_I4,
+	LOCAL_VALUE_COPY
+};
+
+typedef struct {
+	/* The last store to the local in this bblock, if the local wasn't read since */
+	InterpInst *def;
+	/* The I4 constant held by the local, or the offset of the local it is a copy of */
+	gint32 value;
+	guint8 kind;
+	/* The local is accessed by address or by the EH code */
+	guint8 indirect;
+	guint8 tracked;
+} LocalValue;
+
+static gboolean
+interp_ins_is_ldc_i4 (InterpInst *ins)
+{
+	return ins->opcode >= MINT_LDC_I4_M1 && ins->opcode <= MINT_LDC_I4;
+}
+
+static gboolean
+interp_ins_is_ldloc (InterpInst *ins)
+{
+	return ins->opcode >= MINT_LDLOC_I1 && ins->opcode <= MINT_LDLOC_P;
+}
+
+static gboolean
+interp_ins_is_stloc (InterpInst *ins)
+{
+	return (ins->opcode >= MINT_STLOC_I1 && ins->opcode <= MINT_STLOC_P) ||
+		ins->opcode == MINT_STLOC_NP_I4 || ins->opcode == MINT_STLOC_NP_O;
+}
+
+static gboolean
+interp_ins_starts_bb (TransformData *td, InterpInst *ins)
+{
+	return ins->il_offset != -1 && td->is_bb_start [ins->il_offset];
+}
+
+// Replaces INS, which loads a local, with a load of the constant CT
+static InterpInst*
+interp_ldloc_to_ldc_i4 (TransformData *td, InterpInst *ins, gint32 ct)
+{
+	InterpInst *new_ins;
+
+	if (ct >= -1 && ct <= 8) {
+		ins->opcode = MINT_LDC_I4_0 + ct;
+		return ins;
+	} else if (ct >= -128 && ct <= 127) {
+		ins->opcode = MINT_LDC_I4_S;
+		ins->data [0] = (guint16)(gint16)ct;
+		return ins;
+	}
+
+	new_ins = interp_new_ins (td, MINT_LDC_I4, mono_interp_oplen [MINT_LDC_I4]);
+	new_ins->il_offset = ins->il_offset;
+	WRITE32_INS (new_ins, 0, &ct);
+	new_ins->prev = ins->prev;
+	new_ins->next = ins->next;
+	if (ins->prev)
+		ins->prev->next = new_ins;
+	else
+		td->first_ins = new_ins;
+	if (ins->next)
+		ins->next->prev = new_ins;
+	else
+		td->last_ins = new_ins;
+	return new_ins;
+}
+
+// Removes the store DEF together with the instruction pushing the stored value, if possible
+static void
+interp_kill_store (TransformData *td, InterpInst *def)
+{
+	InterpInst *prev = def->prev;
+
+	if (interp_ins_starts_bb (td, def))
+		return;
+	if (def->opcode >= MINT_MOVLOC_1 && def->opcode <= MINT_MOVLOC_8) {
+		interp_remove_ins (td, def);
+		UnlockedIncrement (&mono_interp_stats.killed_instructions);
+	} else if (def->opcode == MINT_STLOC_NP_I4 || def->opcode == MINT_STLOC_NP_O) {
+		/* The value stays on the stack */
+		interp_remove_ins (td, def);
+		UnlockedIncrement (&mono_interp_stats.killed_instructions);
+	} else if (prev && !interp_ins_starts_bb (td, prev) &&
+			(interp_ins_is_ldc (prev) || interp_ins_is_ldloc (prev))) {
+		interp_remove_ins (td, prev);
+		interp_remove_ins (td, def);
+		UnlockedAdd (&mono_interp_stats.killed_instructions, 2);
+	}
+}
+
+static void
+interp_cprop (TransformData *td)
+{
+	LocalValue *locals;
+	int *tracked;
+	int num_tracked = 0;
+	InterpInst *ins, *next;
+	int i;
+
+	if (!td->total_locals_size)
+		return;
+
+	locals = (LocalValue*)g_malloc0 (td->total_locals_size * sizeof (LocalValue));
+	tracked = (int*)g_malloc (td->total_locals_size * sizeof (int));
+
+	for (ins = td->first_ins; ins; ins = ins->next) {
+		if (ins->opcode == MINT_LDLOCA_S)
+			locals [ins->data [0]].indirect = TRUE;
+	}
+	for (i = 0; i < td->header->num_clauses; i++)
+		locals [td->rtm->exvar_offsets [i]].indirect = TRUE;
+
+	for (ins = td->first_ins; ins; ins = next) {
+		next = ins->next;
+
+		if (interp_ins_starts_bb (td, ins)) {
+			for (i = 0; i < num_tracked; i++) {
+				locals [tracked [i]].kind = LOCAL_VALUE_NONE;
+				locals [tracked [i]].def = NULL;
+				locals [tracked [i]].tracked = FALSE;
+			}
+			num_tracked = 0;
+		}
+
+		if (interp_ins_is_ldloc (ins)) {
+			LocalValue *local = &locals [ins->data [0]];
+
+			if (local->indirect)
+				continue;
+			if (local->kind == LOCAL_VALUE_COPY) {
+				ins->data [0] = local->value;
+				local = &locals [local->value];
+				UnlockedIncrement (&mono_interp_stats.copy_propagations);
+			} else if (local->kind == LOCAL_VALUE_I4 && ins->opcode == MINT_LDLOC_I4) {
+				ins = interp_ldloc_to_ldc_i4 (td, ins, local->value);
+				UnlockedIncrement (&mono_interp_stats.const_propagations);
+				continue;
+			}
+			local->def = NULL;
+		} else if (interp_ins_is_stloc (ins) || (ins->opcode >= MINT_MOVLOC_1 && ins->opcode <= MINT_MOVLOC_8)) {
+			gboolean is_mov = !interp_ins_is_stloc (ins);
+			int dreg = ins->data [is_mov ? 1 : 0];
+			LocalValue *local = &locals [dreg];
+			LocalValue *src = NULL;
+
+			if (is_mov) {
+				src = &locals [ins->data [0]];
+				if (!src->indirect && src->kind == LOCAL_VALUE_COPY) {
+					ins->data [0] = src->value;
+					src = &locals [src->value];
+					UnlockedIncrement (&mono_interp_stats.copy_propagations);
+				}
+				src->def = NULL;
+				if (ins->data [0] == dreg) {
+					/* Copying the local to itself */
+					interp_remove_ins (td, ins);
+					UnlockedIncrement (&mono_interp_stats.killed_instructions);
+					continue;
+				}
+			}
+			if (local->indirect)
+				continue;
+
+			if (local->def)
+				interp_kill_store (td, local->def);
+			for (i = 0; i < num_tracked; i++) {
+				LocalValue *other = &locals [tracked [i]];
+				if (other->kind == LOCAL_VALUE_COPY && other->value == dreg)
+					other->kind = LOCAL_VALUE_NONE;
+			}
+
+			local->kind = LOCAL_VALUE_NONE;
+			if (is_mov && !src->indirect) {
+				if (src->kind == LOCAL_VALUE_I4) {
+					local->kind = LOCAL_VALUE_I4;
+					local->value = src->value;
+				} else {
+					local->kind = LOCAL_VALUE_COPY;
+					local->value = ins->data [0];
+				}
+			} else if ((ins->opcode == MINT_STLOC_I4 || ins->opcode == MINT_STLOC_NP_I4) &&
+					!interp_ins_starts_bb (td, ins) && ins->prev && interp_ins_is_ldc_i4 (ins->prev)) {
+				local->kind = LOCAL_VALUE_I4;
+				local->value = interp_ldc_i4_get_const (ins->prev);
+			}
+			local->def = ins;
+			if (!local->tracked) {
+				local->tracked = TRUE;
+				tracked [num_tracked++] = dreg;
+			}
+		} else if (!interp_ins_is_ldc (ins) && ins->opcode != MINT_NOP) {
+			/* This could branch, throw or call, so pending stores must stay */
+			for (i = 0; i < num_tracked; i++)
+				locals [tracked [i]].def = NULL;
+		}
+	}
+
+	g_free (tracked);
+	g_free (locals);
+}
+
+static int
+get_loc_branch_for_op (int opcode, gboolean imm)
+{
+	switch (opcode) {
+	case MINT_BEQ_I4_S: return imm ? MINT_BEQ_I4_LOC_IMM_S : MINT_BEQ_I4_LOC_S;
+	case MINT_BGE_I4_S: return imm ? MINT_BGE_I4_LOC_IMM_S : MINT_BGE_I4_LOC_S;
+	case MINT_BGT_I4_S: return imm ? MINT_BGT_I4_LOC_IMM_S : MINT_BGT_I4_LOC_S;
+	case MINT_BLT_I4_S: return imm ? MINT_BLT_I4_LOC_IMM_S : MINT_BLT_I4_LOC_S;
+	case MINT_BLE_I4_S: return imm ? MINT_BLE_I4_LOC_IMM_S : MINT_BLE_I4_LOC_S;
+	case MINT_BNE_UN_I4_S: return imm ? MINT_BNE_UN_I4_LOC_IMM_S : MINT_BNE_UN_I4_LOC_S;
+	default: return -1;
+	}
+}
+
+// Replaces the instructions from FIRST to LAST with a single instruction
+static InterpInst*
+interp_fuse_ins (TransformData *td, InterpInst *first, InterpInst *last, guint16 opcode)
+{
+	InterpInst *new_ins = interp_new_ins (td, opcode, mono_interp_oplen [opcode]);
+
+	new_ins->il_offset = first->il_offset;
+	new_ins->prev = first->prev;
+	new_ins->next = last->next;
+	if (first->prev)
+		first->prev->next = new_ins;
+	else
+		td->first_ins = new_ins;
+	if (last->next)
+		last->next->prev = new_ins;
+	else
+		td->last_ins = new_ins;
+	UnlockedIncrement (&mono_interp_stats.super_instructions);
+	return new_ins;
+}
+
+/*
+ * Fuses the sequences of instructions that show up the most in opcode pair
+ * counts (see COUNT_OPS in interp.c) into super instructions. Only the first
+ * instruction of a sequence can start a bblock.
+ */
+static void
+interp_super_instructions (TransformData *td)
+{
+	InterpInst *ins, *next;
+
+	for (ins = td->first_ins; ins; ins = next) {
+		InterpInst *n1 = ins->next, *n2, *n3, *safepoint = NULL;
+		int br_op;
+
+		next = n1;
+		if (!n1 || interp_ins_starts_bb (td, n1))
+			continue;
+
+		if ((ins->opcode == MINT_LDARG_O || ins->opcode == MINT_LDARG_P) &&
+				n1->opcode >= MINT_LDFLD_I1 && n1->opcode <= MINT_LDFLD_P) {
+			InterpInst *new_ins = interp_fuse_ins (td, ins, n1, MINT_LDARGFLD_I1 + (n1->opcode - MINT_LDFLD_I1));
+			new_ins->data [0] = ins->data [0];
+			new_ins->data [1] = n1->data [0];
+			next = new_ins->next;
+			continue;
+		}
+
+		if (ins->opcode != MINT_LDLOC_I4)
+			continue;
+
+		n2 = n1->next;
+		if (!n2 || interp_ins_starts_bb (td, n2))
+			continue;
+
+		if ((n1->opcode == MINT_ADD1_I4 || n1->opcode == MINT_SUB1_I4) && n2->opcode == MINT_STLOC_I4) {
+			/* i++ */
+			InterpInst *new_ins = interp_fuse_ins (td, ins, n2, MINT_ADD_I4_IMM_LOC);
+			new_ins->data [0] = ins->data [0];
+			new_ins->data [1] = n2->data [0];
+			new_ins->data [2] = (guint16)(gint16)(n1->opcode == MINT_ADD1_I4 ? 1 : -1);
+			next = new_ins->next;
+			continue;
+		}
+
+		if (interp_ins_is_ldc_i4 (n1)) {
+			gint32 ct = interp_ldc_i4_get_const (n1);
+			if (ct < -G_MAXINT16 || ct > G_MAXINT16)
+				continue;
+			n3 = n2->next;
+			if ((n2->opcode == MINT_ADD_I4 || n2->opcode == MINT_SUB_I4) &&
+					n3 && !interp_ins_starts_bb (td, n3) && n3->opcode == MINT_STLOC_I4) {
+				InterpInst *new_ins = interp_fuse_ins (td, ins, n3, MINT_ADD_I4_IMM_LOC);
+				new_ins->data [0] = ins->data [0];
+				new_ins->data [1] = n3->data [0];
+				new_ins->data [2] = (guint16)(gint16)(n2->opcode == MINT_ADD_I4 ? ct : -ct);
+				next = new_ins->next;
+				continue;
+			}
+		} else if (n1->opcode != MINT_LDLOC_I4) {
+			continue;
+		}
+
+		/* Backward branches are preceded by a safepoint, which can run before the loads */
+		if ((n2->opcode == MINT_SAFEPOINT || n2->opcode == MINT_CHECKPOINT) && n2->next &&
+				!interp_ins_starts_bb (td, n2->next)) {
+			safepoint = n2;
+			n2 = n2->next;
+		}
+		br_op = get_loc_branch_for_op (n2->opcode, n1->opcode != MINT_LDLOC_I4);
+		if (br_op != -1) {
+			InterpInst *new_ins;
+			if (safepoint)
+				interp_remove_ins (td, safepoint);
+			new_ins = interp_fuse_ins (td, ins, n2, br_op);
+			new_ins->data [0] = n2->data [0];
+			new_ins->data [1] = ins->data [0];
+			if (n1->opcode == MINT_LDLOC_I4)
+				new_ins->data [2] = n1->data [0];
+			else
+				new_ins->data [2] = (guint16)(gint16)interp_ldc_i4_get_const (n1);
+			if (safepoint) {
+				/* The safepoint takes over the start of the sequence */
+				safepoint->il_offset = new_ins->il_offset;
+				safepoint->prev = new_ins->prev;
+				safepoint->next = new_ins;
+				if (new_ins->prev)
+					new_ins->prev->next = safepoint;
+				else
+					td->first_ins = safepoint;
+				new_ins->prev = safepoint;
+			}
+			next = new_ins->next;
+		}
+	}
+}
+
 static gboolean
 generate_code (TransformData *td, MonoMethod *method, MonoMethodHeader *header, MonoGenericContext *generic_context, MonoError *error)
 {
@@ -3110,6 +3597,16 @@ generate_code (TransformData *td, MonoMethod *method, MonoMethodHeader *header,
 				td->vt_sp, td->max_vt_sp);
 		}
 
+#ifdef INTERP_ENABLE_JITERPRETER
+		/* Loop headers with an empty evaluation stack can start a trace compiled to wasm */
+		if ((mono_interp_opt & INTERP_OPT_JITERPRETER) && (td->is_bb_start [in_offset] & 2) &&
+				td->sp == td->stack && td->method == method && !sym_seq_points) {
+			InterpTrace *trace = (InterpTrace*)mono_domain_alloc0 (domain, sizeof (InterpTrace));
+			interp_add_ins (td, MINT_JITERP_ENTER);
+			td->last_ins->data [0] = get_data_item_index (td, trace);
+		}
+#endif
+
 		if (sym_seq_points && mono_bitset_test_fast (seq_point_locs, td->ip - header->code)) {
 			InterpBasicBlock *cbb = td->offset_to_bb [td->ip - header->code];
 			g_assert (cbb);
@@ -5849,6 +6346,11 @@ generate_code (TransformData *td, MonoMethod *method, MonoMethodHeader *header,
 
 	g_assert (td->ip == end);
 
+	if (!td->inlined_method && !td->gen_sdb_seq_points && (mono_interp_opt & INTERP_OPT_CPROP))
+		interp_cprop (td);
+	if (!td->inlined_method && !td->gen_sdb_seq_points && (mono_interp_opt & INTERP_OPT_SUPER_INSTRUCTIONS))
+		interp_super_instructions (td);
+
 exit_ret:
 	g_free (arg_offsets);
 	g_free (local_offsets);
@@ -5973,6 +6475,7 @@ emit_compacted_instruction (TransformData *td, guint16* start_ip, InterpInst *in
 		}
 	} else if ((opcode >= MINT_BRFALSE_I4_S && opcode <= MINT_BRTRUE_R8_S) ||
 			(opcode >= MINT_BEQ_I4_S && opcode <= MINT_BLT_UN_R8_S) ||
+			(opcode >= MINT_BEQ_I4_LOC_S && opcode <= MINT_BNE_UN_I4_LOC_IMM_S) ||
 			opcode == MINT_BR_S || opcode == MINT_LEAVE_S || opcode == MINT_LEAVE_S_CHECK) {
 		const int br_offset = start_ip - td->new_code;
 		if (ins->data [0] < ins->il_offset) {
@@ -5987,6 +6490,10 @@ emit_compacted_instruction (TransformData *td, guint16* start_ip, InterpInst *in
 			g_ptr_array_add (td->relocs, reloc);
 			*ip++ = 0xdead;
 		}
+		if (opcode >= MINT_BEQ_I4_LOC_S && opcode <= MINT_BNE_UN_I4_LOC_IMM_S) {
+			*ip++ = ins->data [1];
+			*ip++ = ins->data [2];
+		}
 	} else if ((opcode >= MINT_BRFALSE_I4 && opcode <= MINT_BRTRUE_R8) ||
 			(opcode >= MINT_BEQ_I4 && opcode <= MINT_BLT_UN_R8) ||
 			opcode == MINT_BR || opcode == MINT_LEAVE || opcode == MINT_LEAVE_CHECK) {
@@ -6069,6 +6576,242 @@ generate_compacted_code (TransformData *td)
 	g_ptr_array_free (td->relocs, TRUE);
 }
 
+/*
+ * On disk cache of transformed code, enabled with the code-cache=<dir> interpreter
+ * option. Only methods whose code doesn't reference any data items are cached, the
+ * code of those depends only on the IL and on the layout of the classes. The classes
+ * can come from any image reachable through the assembly references of the image of
+ * the method, so an entry records the GUIDs of all of those and is only reused if they
+ * all match, together with the opcode set and the optimizations. Branches are
+ * relative, so the code is stored after relocation.
+ */
+
+#define INTERP_CODE_CACHE_MAGIC 0x544e494d
+#define INTERP_CODE_CACHE_VERSION 2
+
+typedef struct {
+	guint32 magic;
+	guint32 version;
+	guint32 num_opcodes;
+	guint32 opt;
+	char corlib_guid [40];
+	/* Length of the GUIDs of the referenced images, stored after the header */
+	guint32 deps_len;
+	guint32 code_len;
+	guint32 stack_size;
+	guint32 vt_stack_size;
+	guint32 total_locals_size;
+	guint32 num_clauses;
+	guint32 num_line_numbers;
+} InterpCodeCacheHeader;
+
+typedef struct {
+	guint32 try_offset;
+	guint32 try_len;
+	guint32 handler_offset;
+	guint32 handler_len;
+	guint32 filter_offset;
+} InterpCodeCacheClause;
+
+static gboolean
+interp_code_cache_supported (MonoMethod *method, InterpMethod *rtm)
+{
+	if (!mono_interp_code_cache_dir)
+		return FALSE;
+	if (method->wrapper_type != MONO_WRAPPER_NONE || method->is_inflated || method->dynamic || !method->token)
+		return FALSE;
+	if (rtm->prof_flags || mono_jit_trace_calls != NULL || mini_debug_options.gen_sdb_seq_points)
+		return FALSE;
+	return TRUE;
+}
+
+/*
+ * Returns the GUIDs of IMAGE and of all the images it references, directly or not, in
+ * a string which is equal for equal images. Returns NULL if the code of the methods
+ * of IMAGE can't be cached since some of them are missing or dynamic.
+ */
+static char*
+interp_code_cache_image_deps (MonoImage *image)
+{
+	GPtrArray *images = g_ptr_array_new ();
+	GHashTable *seen = g_hash_table_new (NULL, NULL);
+	GString *deps = g_string_new ("");
+	gboolean ok = TRUE;
+	guint i;
+
+	g_ptr_array_add (images, image);
+	g_hash_table_insert (seen, image, image);
+	for (i = 0; ok && i < images->len; i++) {
+		MonoImage *cur = (MonoImage*)g_ptr_array_index (images, i);
+		int j, nrefs = mono_image_get_table_rows (cur, MONO_TABLE_ASSEMBLYREF);
+
+		if (image_is_dynamic (cur)) {
+			ok = FALSE;
+			break;
+		}
+		g_string_append (deps, mono_image_get_guid (cur));
+		g_string_append_c (deps, ';');
+		for (j = 0; j < nrefs; j++) {
+			MonoAssembly *ref;
+
+			mono_assembly_load_reference (cur, j);
+			ref = cur->references [j];
+			if (!ref || ref == REFERENCE_MISSING || !ref->image) {
+				ok = FALSE;
+				break;
+			}
+			if (!g_hash_table_lookup (seen, ref->image)) {
+				g_hash_table_insert (seen, ref->image, ref->image);
+				g_ptr_array_add (images, ref->image);
+			}
+		}
+	}
+
+	g_hash_table_destroy (seen);
+	g_ptr_array_free (images, TRUE);
+	return g_string_free (deps, !ok);
+}
+
+static char*
+interp_code_cache_path (MonoMethod *method)
+{
+	char *name = g_strdup_printf ("%s-%08x.mint", mono_image_get_guid (m_class_get_image (method->klass)), method->token);
+	char *path = g_build_filename (mono_interp_code_cache_dir, name, (const char*)NULL);
+	g_free (name);
+	return path;
+}
+
+static void
+interp_code_cache_init_header (InterpCodeCacheHeader *cheader)
+{
+	memset (cheader, 0, sizeof (InterpCodeCacheHeader));
+	cheader->magic = INTERP_CODE_CACHE_MAGIC;
+	cheader->version = INTERP_CODE_CACHE_VERSION;
+	cheader->num_opcodes = MINT_LASTOP;
+	cheader->opt = mono_interp_opt;
+	g_strlcpy (cheader->corlib_guid, mono_image_get_guid (mono_defaults.corlib), sizeof (cheader->corlib_guid));
+}
+
+static void
+interp_code_cache_save (TransformData *td, MonoMethodHeader *header, const char *deps)
+{
+	InterpMethod *rtm = td->rtm;
+	InterpCodeCacheHeader cheader;
+	GByteArray *buf;
+	char *path;
+	int i;
+
+	if (td->n_data_items || td->has_inlined_code)
+		return;
+
+	interp_code_cache_init_header (&cheader);
+	cheader.deps_len = strlen (deps);
+	cheader.code_len = td->new_code_end - td->new_code;
+	cheader.stack_size = rtm->stack_size;
+	cheader.vt_stack_size = rtm->vt_stack_size;
+	cheader.total_locals_size = rtm->total_locals_size;
+	cheader.num_clauses = header->num_clauses;
+	cheader.num_line_numbers = td->line_numbers->len;
+
+	buf = g_byte_array_new ();
+	g_byte_array_append (buf, (guint8*)&cheader, sizeof (cheader));
+	g_byte_array_append (buf, (const guint8*)deps, cheader.deps_len);
+	g_byte_array_append (buf, (guint8*)td->new_code, cheader.code_len * sizeof (guint16));
+	for (i = 0; i < header->num_clauses; i++) {
+		MonoExceptionClause *c = rtm->clauses + i;
+		InterpCodeCacheClause cc;
+
+		cc.try_offset = c->try_offset;
+		cc.try_len = c->try_len;
+		cc.handler_offset = c->handler_offset;
+		cc.handler_len = c->handler_len;
+		cc.filter_offset = (c->flags & MONO_EXCEPTION_CLAUSE_FILTER) ? c->data.filter_offset : 0;
+		g_byte_array_append (buf, (guint8*)&cc, sizeof (cc));
+	}
+	g_byte_array_append (buf, (guint8*)td->line_numbers->data, td->line_numbers->len * sizeof (MonoDebugLineNumberEntry));
+
+	path = interp_code_cache_path (td->method);
+	/* Failing to write the cache is not an error */
+	g_file_set_contents (path, (const gchar*)buf->data, buf->len, NULL);
+	g_free (path);
+	g_byte_array_free (buf, TRUE);
+}
+
+/*
+ * Fills in the code of RTM from the cache. DEPS are the GUIDs of the images the entry
+ * must have been created with. Returns FALSE if there is no valid entry, the method is
+ * transformed normally then.
+ */
+static gboolean
+interp_code_cache_load (TransformData *td, MonoMethodHeader *header, const char *deps)
+{
+	InterpMethod *rtm = td->rtm;
+	InterpCodeCacheHeader expected, *cheader;
+	InterpCodeCacheClause *clauses;
+	MonoDebugLineNumberEntry *line_numbers;
+	guint16 *code;
+	gchar *contents;
+	gsize len;
+	char *path;
+	int i;
+
+	path = interp_code_cache_path (td->method);
+	if (!g_file_get_contents (path, &contents, &len, NULL)) {
+		g_free (path);
+		return FALSE;
+	}
+	g_free (path);
+
+	interp_code_cache_init_header (&expected);
+	cheader = (InterpCodeCacheHeader*)contents;
+	if (len < sizeof (InterpCodeCacheHeader) ||
+			cheader->magic != expected.magic || cheader->version != expected.version ||
+			cheader->num_opcodes != expected.num_opcodes || cheader->opt != expected.opt ||
+			strcmp (cheader->corlib_guid, expected.corlib_guid) != 0 ||
+			cheader->num_clauses != header->num_clauses ||
+			cheader->deps_len != strlen (deps) ||
+			len != sizeof (InterpCodeCacheHeader) + cheader->deps_len + cheader->code_len * sizeof (guint16) +
+				cheader->num_clauses * sizeof (InterpCodeCacheClause) +
+				cheader->num_line_numbers * sizeof (MonoDebugLineNumberEntry)) {
+		g_free (contents);
+		return FALSE;
+	}
+	if (memcmp (cheader + 1, deps, cheader->deps_len) != 0) {
+		g_free (contents);
+		return FALSE;
+	}
+
+	code = (guint16*)(contents + sizeof (InterpCodeCacheHeader) + cheader->deps_len);
+	td->new_code = (guint16*)mono_domain_alloc0 (rtm->domain, cheader->code_len * sizeof (guint16));
+	memcpy (td->new_code, code, cheader->code_len * sizeof (guint16));
+	td->new_code_end = td->new_code + cheader->code_len;
+
+	rtm->stack_size = cheader->stack_size;
+	rtm->vt_stack_size = cheader->vt_stack_size;
+	rtm->total_locals_size = cheader->total_locals_size;
+
+	clauses = (InterpCodeCacheClause*)(code + cheader->code_len);
+	rtm->clauses = (MonoExceptionClause*)mono_domain_alloc0 (rtm->domain, header->num_clauses * sizeof (MonoExceptionClause));
+	memcpy (rtm->clauses, header->clauses, header->num_clauses * sizeof (MonoExceptionClause));
+	for (i = 0; i < header->num_clauses; i++) {
+		MonoExceptionClause *c = rtm->clauses + i;
+
+		c->try_offset = clauses [i].try_offset;
+		c->try_len = clauses [i].try_len;
+		c->handler_offset = clauses [i].handler_offset;
+		c->handler_len = clauses [i].handler_len;
+		if (c->flags & MONO_EXCEPTION_CLAUSE_FILTER)
+			c->data.filter_offset = clauses [i].filter_offset;
+	}
+
+	line_numbers = (MonoDebugLineNumberEntry*)(clauses + header->num_clauses);
+	g_array_append_vals (td->line_numbers, line_numbers, cheader->num_line_numbers);
+
+	g_free (contents);
+	UnlockedIncrement (&mono_interp_stats.code_cache_hits);
+	return TRUE;
+}
+
 static void
 generate (MonoMethod *method, MonoMethodHeader *header, InterpMethod *rtm, MonoGenericContext *generic_context, MonoError *error)
 {
@@ -6078,6 +6821,7 @@ generate (MonoMethod *method, MonoMethodHeader *header, InterpMethod *rtm, MonoG
 	TransformData *td;
 	static gboolean verbose_method_inited;
 	static char* verbose_method_name;
+	char *code_cache_deps = NULL;
 
 	if (!verbose_method_inited) {
 		verbose_method_name = g_getenv ("MONO_VERBOSE_METHOD");
@@ -6127,52 +6871,63 @@ generate (MonoMethod *method, MonoMethodHeader *header, InterpMethod *rtm, MonoG
 	td->max_stack_height = 0;
 	td->line_numbers = g_array_new (FALSE, TRUE, sizeof (MonoDebugLineNumberEntry));
 
-	generate_code (td, method, header, generic_context, error);
-	goto_if_nok (error, exit);
+	if (!td->verbose_level && interp_code_cache_supported (method, rtm))
+		code_cache_deps = interp_code_cache_image_deps (m_class_get_image (method->klass));
+
+	int code_len;
+	if (code_cache_deps && interp_code_cache_load (td, header, code_cache_deps)) {
+		code_len = td->new_code_end - td->new_code;
+	} else {
+		generate_code (td, method, header, generic_context, error);
+		goto_if_nok (error, exit);
 
-	generate_compacted_code (td);
+		generate_compacted_code (td);
 
-	if (td->verbose_level) {
-		g_print ("Runtime method: %s %p, VT stack size: %d\n", mono_method_full_name (method, TRUE), rtm, td->max_vt_sp);
-		g_print ("Calculated stack size: %d, stated size: %d\n", td->max_stack_height, header->max_stack);
-		dump_mint_code (td->new_code, td->new_code_end);
-	}
+		if (td->verbose_level) {
+			g_print ("Runtime method: %s %p, VT stack size: %d\n", mono_method_full_name (method, TRUE), rtm, td->max_vt_sp);
+			g_print ("Calculated stack size: %d, stated size: %d\n", td->max_stack_height, header->max_stack);
+			dump_mint_code (td->new_code, td->new_code_end);
+		}
 
-	/* Check if we use excessive stack space */
-	if (td->max_stack_height > header->max_stack * 3 && header->max_stack > 16)
-		g_warning ("Excessive stack space usage for method %s, %d/%d", method->name, td->max_stack_height, header->max_stack);
+		/* Check if we use excessive stack space */
+		if (td->max_stack_height > header->max_stack * 3 && header->max_stack > 16)
+			g_warning ("Excessive stack space usage for method %s, %d/%d", method->name, td->max_stack_height, header->max_stack);
+
+		code_len = td->new_code_end - td->new_code;
+
+		rtm->clauses = (MonoExceptionClause*)mono_domain_alloc0 (domain, header->num_clauses * sizeof (MonoExceptionClause));
+		memcpy (rtm->clauses, header->clauses, header->num_clauses * sizeof(MonoExceptionClause));
+		for (i = 0; i < header->num_clauses; i++) {
+			MonoExceptionClause *c = rtm->clauses + i;
+			int end_off = c->try_offset + c->try_len;
+			c->try_offset = get_in_offset (td, c->try_offset);
+			c->try_len = get_in_offset (td, end_off) - c->try_offset;
+			g_assert ((c->try_offset + c->try_len) < code_len);
+			end_off = c->handler_offset + c->handler_len;
+			c->handler_offset = get_in_offset (td, c->handler_offset);
+			c->handler_len = get_in_offset (td, end_off) - c->handler_offset;
+			g_assert (c->handler_len >= 0 && (c->handler_offset + c->handler_len) <= code_len);
+			if (c->flags & MONO_EXCEPTION_CLAUSE_FILTER)
+				c->data.filter_offset = get_in_offset (td, c->data.filter_offset);
+		}
+		rtm->stack_size = (sizeof (stackval)) * (td->max_stack_height + 2); /* + 1 for returns of called functions  + 1 for 0-ing in trace*/
+		rtm->stack_size = ALIGN_TO (rtm->stack_size, MINT_VT_ALIGNMENT);
+		rtm->vt_stack_size = td->max_vt_sp;
+		rtm->total_locals_size = td->total_locals_size;
 
-	int code_len;
-	code_len = td->new_code_end - td->new_code;
+		if (code_cache_deps)
+			interp_code_cache_save (td, header, code_cache_deps);
+	}
 
-	rtm->clauses = (MonoExceptionClause*)mono_domain_alloc0 (domain, header->num_clauses * sizeof (MonoExceptionClause));
-	memcpy (rtm->clauses, header->clauses, header->num_clauses * sizeof(MonoExceptionClause));
 	rtm->code = (gushort*)td->new_code;
 	rtm->init_locals = header->init_locals;
 	rtm->num_clauses = header->num_clauses;
-	for (i = 0; i < header->num_clauses; i++) {
-		MonoExceptionClause *c = rtm->clauses + i;
-		int end_off = c->try_offset + c->try_len;
-		c->try_offset = get_in_offset (td, c->try_offset);
-		c->try_len = get_in_offset (td, end_off) - c->try_offset;
-		g_assert ((c->try_offset + c->try_len) < code_len);
-		end_off = c->handler_offset + c->handler_len;
-		c->handler_offset = get_in_offset (td, c->handler_offset);
-		c->handler_len = get_in_offset (td, end_off) - c->handler_offset;
-		g_assert (c->handler_len >= 0 && (c->handler_offset + c->handler_len) <= code_len);
-		if (c->flags & MONO_EXCEPTION_CLAUSE_FILTER)
-			c->data.filter_offset = get_in_offset (td, c->data.filter_offset);
-	}
-	rtm->stack_size = (sizeof (stackval)) * (td->max_stack_height + 2); /* + 1 for returns of called functions  + 1 for 0-ing in trace*/
-	rtm->stack_size = ALIGN_TO (rtm->stack_size, MINT_VT_ALIGNMENT);
-	rtm->vt_stack_size = td->max_vt_sp;
-	rtm->total_locals_size = td->total_locals_size;
 	rtm->alloca_size = rtm->total_locals_size + rtm->vt_stack_size + rtm->stack_size;
 	rtm->data_items = (gpointer*)mono_domain_alloc0 (domain, td->n_data_items * sizeof (td->data_items [0]));
 	memcpy (rtm->data_items, td->data_items, td->n_data_items * sizeof (td->data_items [0]));
 
 	/* Save debug info */
-	interp_save_debug_info (rtm, header, td, td->line_numbers);
+	interp_save_debug_info (rtm, header, code_len, td->line_numbers);
 
 	/* Create a MonoJitInfo for the interpreted method by creating the interpreter IR as the native code. */
 	int jinfo_len;
@@ -6203,6 +6958,7 @@ generate (MonoMethod *method, MonoMethodHeader *header, InterpMethod *rtm, MonoG
 	save_seq_points (td, jinfo);
 
 exit:
+	g_free (code_cache_deps);
 	g_free (td->in_offsets);
 	g_free (td->data_items);
 	g_free (td->stack);
@@ -6323,6 +7079,7 @@ mono_interp_transform_method (InterpMethod *imethod, ThreadContext *context, Mon
 
 	interp_method_compute_offsets (imethod, signature, header);
 
+	UnlockedIncrement (&mono_interp_stats.transformed_methods);
 	MONO_TIME_TRACK (mono_interp_stats.transform_time, generate (method, header, imethod, generic_context, error));
 
 	mono_metadata_free_mh (header);
@@ -287,6 +287,8 @@ mono_linear_scan2 (MonoCompile *cfg, GList *vars, GList *regs, regmask_t *used_m
 	GList *unhandled, *active, *inactive, *l;
 	MonoMethodVar *vmv;
 	gint32 free_pos [sizeof (regmask_t) * 8];
+	/* Same as free_pos, but only considering the inactive intervals */
+	gint32 inactive_free_pos [sizeof (regmask_t) * 8];
 	gint32 gains [sizeof (regmask_t) * 8];
 	regmask_t used_regs = 0;
 	int n_regs, n_regvars, i;
@@ -371,7 +373,7 @@ mono_linear_scan2 (MonoCompile *cfg, GList *vars, GList *regs, regmask_t *used_m
 
 		/* Find a register for the current interval */
 		for (i = 0; i < n_regs; ++i)
-			free_pos [i] = ((gint32)0x7fffffff);
+			free_pos [i] = inactive_free_pos [i] = ((gint32)0x7fffffff);
 
 		for (l = active; l != NULL; l = l->next) {
 			MonoMethodVar *v = (MonoMethodVar*)l->data;
@@ -389,7 +391,9 @@ mono_linear_scan2 (MonoCompile *cfg, GList *vars, GList *regs, regmask_t *used_m
 			if (v->reg >= 0) {
 				intersect_pos = mono_linterval_get_intersect_pos (current->interval, v->interval);
 				if (intersect_pos != -1) {
-					free_pos [v->reg] = intersect_pos;
+					inactive_free_pos [v->reg] = MIN (inactive_free_pos [v->reg], intersect_pos);
+					if (free_pos [v->reg] > 0)
+						free_pos [v->reg] = MIN (free_pos [v->reg], intersect_pos);
 					LSCAN_DEBUG (printf ("\threg %d becomes free at %d\n", v->reg, intersect_pos));
 				}
 			}
@@ -414,50 +418,44 @@ mono_linear_scan2 (MonoCompile *cfg, GList *vars, GList *regs, regmask_t *used_m
 			gains [current->reg] += current->spill_costs;
 		}
 		else {
+			MonoMethodVar *spill = NULL;
+			GList *spill_pos = NULL;
+
 			/* 
 			 * free_pos [reg] > 0 means there is a register available for parts
 			 * of the interval, so splitting it is possible. This is not yet
 			 * supported, so we spill in this case too.
 			 */
 
-			/* Spill an interval */
-
-			/* FIXME: Optimize the selection of the interval */
+			/*
+			 * Spill the cheapest active interval whose register is free for the whole
+			 * current interval once it's gone, and hand that register to the current
+			 * interval, if that's cheaper than spilling the current one. Spill costs are
+			 * weighted by loop nesting, so this keeps loop variables in registers.
+			 */
+			for (l = active; l != NULL; l = l->next) {
+				MonoMethodVar *v = (MonoMethodVar*)l->data;
 
-			if (active) {
-				GList *min_spill_pos;
-#if 0
-				/* 
-				 * This favors registers with big spill costs, thus larger liveness ranges,
-				 * thus actually leading to worse code size.
-				 */
-				guint32 min_spill_value = G_MAXINT32;
-
-				for (l = active; l != NULL; l = l->next) {
-					vmv = (MonoMethodVar*)l->data;
-
-					if (vmv->spill_costs < min_spill_value) {
-						min_spill_pos = l;
-						min_spill_value = vmv->spill_costs;
-					}
-				}
-#else
-				/* Spill either the first active or the current interval */
-				min_spill_pos = active;
-#endif
-				vmv = (MonoMethodVar*)min_spill_pos->data;
-				if (vmv->spill_costs < current->spill_costs) {
-				//				if (vmv->interval->last_range->to < current->interval->last_range->to) {
-					gains [vmv->reg] -= vmv->spill_costs;
-					vmv->reg = -1;
-					LSCAN_DEBUG (printf ("\tSpilled R%d\n", cfg->varinfo [vmv->idx]->dreg));
-					active = g_list_delete_link (active, min_spill_pos);
+				if (v->reg < 0 || inactive_free_pos [v->reg] < current->interval->last_range->to)
+					continue;
+				if (!spill || v->spill_costs < spill->spill_costs) {
+					spill = v;
+					spill_pos = l;
 				}
-				else
-					LSCAN_DEBUG (printf ("\tSpilled current (cost %d)\n", current->spill_costs));
 			}
-			else
-				LSCAN_DEBUG (printf ("\tSpilled current\n"));
+
+			if (spill && spill->spill_costs < current->spill_costs) {
+				gains [spill->reg] -= spill->spill_costs;
+				current->reg = spill->reg;
+				spill->reg = -1;
+				LSCAN_DEBUG (printf ("\tSpilled R%d, assigned hreg %d to R%d\n", cfg->varinfo [spill->idx]->dreg, current->reg, cfg->varinfo [current->idx]->dreg));
+				active = g_list_delete_link (active, spill_pos);
+
+				active = g_list_append (active, current);
+				gains [current->reg] += current->spill_costs;
+			} else {
+				LSCAN_DEBUG (printf ("\tSpilled current (cost %d)\n", current->spill_costs));
+			}
 		}
 	}
 
@@ -364,7 +364,6 @@ analyze_liveness_bb (MonoCompile *cfg, MonoBasicBlock *bb)
 void
 mono_analyze_liveness (MonoCompile *cfg)
 {
-	MonoBitSet *old_live_out_set;
 	int i, j, max_vars = cfg->num_varinfo;
 	int out_iter;
 	gboolean *in_worklist;
@@ -418,7 +417,6 @@ mono_analyze_liveness (MonoCompile *cfg)
 #endif
 	}
 
-	old_live_out_set = mono_bitset_new (max_vars, 0);
 	in_worklist = g_new0 (gboolean, cfg->num_bblocks + 1);
 
 	worklist = g_new (MonoBasicBlock *, cfg->num_bblocks + 1);
@@ -469,14 +467,8 @@ mono_analyze_liveness (MonoCompile *cfg)
 
 		out_iter ++;
 
-		if (!bb->live_in_set) {
-			/* First pass over this bblock */
-			changed = TRUE;
-		}
-		else {
-			changed = FALSE;
-			mono_bitset_copyto_fast (bb->live_out_set, old_live_out_set);
-		}
+		/* Always propagate on the first pass over this bblock, afterwards only if live_out grew */
+		changed = !bb->live_in_set;
  
 		for (j = 0; j < bb->out_count; j++) {
 			out_bb = bb->out_bb [j];
@@ -484,24 +476,20 @@ mono_analyze_liveness (MonoCompile *cfg)
 			if (!out_bb->live_in_set) {
 				out_bb->live_in_set = mono_bitset_mp_new_noinit (cfg->mempool, bitsize, max_vars);
 
-				mono_bitset_copyto_fast (out_bb->live_out_set, out_bb->live_in_set);
-				mono_bitset_sub_fast (out_bb->live_in_set, out_bb->kill_set);
-				mono_bitset_union_fast (out_bb->live_in_set, out_bb->gen_set);
+				mono_bitset_sub_union (out_bb->live_in_set, out_bb->live_out_set, out_bb->kill_set, out_bb->gen_set);
 			}
 
 			// FIXME: Do this somewhere else
 			if (bb->last_ins && bb->last_ins->opcode == OP_NOT_REACHED) {
 			} else {
-				mono_bitset_union_fast (bb->live_out_set, out_bb->live_in_set);
+				changed |= mono_bitset_union_changed (bb->live_out_set, out_bb->live_in_set);
 			}
 		}
 				
-		if (changed || !mono_bitset_equal (old_live_out_set, bb->live_out_set)) {
+		if (changed) {
 			if (!bb->live_in_set)
 				bb->live_in_set = mono_bitset_mp_new_noinit (cfg->mempool, bitsize, max_vars);
-			mono_bitset_copyto_fast (bb->live_out_set, bb->live_in_set);
-			mono_bitset_sub_fast (bb->live_in_set, bb->kill_set);
-			mono_bitset_union_fast (bb->live_in_set, bb->gen_set);
+			mono_bitset_sub_union (bb->live_in_set, bb->live_out_set, bb->kill_set, bb->gen_set);
 
 			for (j = 0; j < bb->in_count; j++) {
 				MonoBasicBlock *in_bb = bb->in_bb [j];
@@ -535,8 +523,6 @@ mono_analyze_liveness (MonoCompile *cfg)
 		printf ("IT: %d %d.\n", cfg->num_bblocks, out_iter);
 #endif
 
-	mono_bitset_free (old_live_out_set);
-
 	g_free (worklist);
 	g_free (in_worklist);
 
@@ -547,9 +533,7 @@ mono_analyze_liveness (MonoCompile *cfg)
 		if (!bb->live_in_set) {
 			bb->live_in_set = mono_bitset_mp_new (cfg->mempool, bitsize, max_vars);
 
-			mono_bitset_copyto_fast (bb->live_out_set, bb->live_in_set);
-			mono_bitset_sub_fast (bb->live_in_set, bb->kill_set);
-			mono_bitset_union_fast (bb->live_in_set, bb->gen_set);
+			mono_bitset_sub_union (bb->live_in_set, bb->live_out_set, bb->kill_set, bb->gen_set);
 		}
 	}
 
@@ -19,6 +19,35 @@
 #define MAX_INLINE_COPIES 10
 #define MAX_INLINE_COPY_SIZE 10000
 
+#ifdef TARGET_AMD64
+/* SSE2 is always available, so word aligned blocks can be moved 16 bytes at a time */
+#define SIMD_COPY_SIZE 16
+#endif
+
+static gboolean
+use_simd_copies (MonoCompile *cfg, int align)
+{
+#ifdef SIMD_COPY_SIZE
+	/* The LLVM backend needs a vector class for xregs, and does its own memcpy lowering anyway */
+	return (cfg->opt & MONO_OPT_SIMD) && !COMPILE_LLVM (cfg) && align >= TARGET_SIZEOF_VOID_P;
+#else
+	return FALSE;
+#endif
+}
+
+/*
+ * Number of load/store pairs an inline copy of SIZE bytes would take.
+ */
+static int
+inline_copy_count (MonoCompile *cfg, int size, int align)
+{
+#ifdef SIMD_COPY_SIZE
+	if (use_simd_copies (cfg, align))
+		return size / SIMD_COPY_SIZE + (size % SIMD_COPY_SIZE) / align;
+#endif
+	return size / align;
+}
+
 void 
 mini_emit_memset (MonoCompile *cfg, int destreg, int offset, int size, int val, int align)
 {
@@ -77,6 +106,23 @@ mini_emit_memset (MonoCompile *cfg, int destreg, int offset, int size, int val,
 			goto set_4;
 	}
 
+#ifdef SIMD_COPY_SIZE
+	if (use_simd_copies (cfg, align) && size >= SIMD_COPY_SIZE) {
+		MonoInst *ins;
+
+		MONO_INST_NEW (cfg, ins, OP_XZERO);
+		ins->dreg = alloc_xreg (cfg);
+		ins->type = STACK_VTYPE;
+		MONO_ADD_INS (cfg->cbb, ins);
+
+		while (size >= SIMD_COPY_SIZE) {
+			MONO_EMIT_NEW_STORE_MEMBASE (cfg, OP_STOREX_MEMBASE, destreg, offset, ins->dreg);
+			offset += SIMD_COPY_SIZE;
+			size -= SIMD_COPY_SIZE;
+		}
+	}
+#endif
+
 	if (SIZEOF_REGISTER == 8) {
 		while (size >= 8) {
 			MONO_EMIT_NEW_STORE_MEMBASE (cfg, OP_STOREI8_MEMBASE_REG, destreg, offset, val_reg);
@@ -138,6 +184,21 @@ mini_emit_memcpy (MonoCompile *cfg, int destreg, int doffset, int srcreg, int so
 			goto copy_4;
 	}
 
+#ifdef SIMD_COPY_SIZE
+	if (use_simd_copies (cfg, align)) {
+		while (size >= SIMD_COPY_SIZE) {
+			MonoInst *load;
+
+			NEW_LOAD_MEMBASE (cfg, load, OP_LOADX_MEMBASE, alloc_xreg (cfg), srcreg, soffset);
+			load->type = STACK_VTYPE;
+			MONO_ADD_INS (cfg->cbb, load);
+			MONO_EMIT_NEW_STORE_MEMBASE (cfg, OP_STOREX_MEMBASE, destreg, doffset, load->dreg);
+			doffset += SIMD_COPY_SIZE;
+			soffset += SIMD_COPY_SIZE;
+			size -= SIMD_COPY_SIZE;
+		}
+	}
+#endif
 
 	if (SIZEOF_REGISTER == 8) {
 		while (size >= 8) {
@@ -187,7 +248,7 @@ mini_emit_memcpy_internal (MonoCompile *cfg, MonoInst *dest, MonoInst *src, Mono
 	/* FIXME: Optimize the case when src/dest is OP_LDADDR */
 
 	/* We can't do copies at a smaller granule than the provided alignment */
-	if (size_ins || (size / align > MAX_INLINE_COPIES) || !(cfg->opt & MONO_OPT_INTRINS)) {
+	if (size_ins || (inline_copy_count (cfg, size, align) > MAX_INLINE_COPIES) || !(cfg->opt & MONO_OPT_INTRINS)) {
 		MonoInst *iargs [3];
 		iargs [0] = dest;
 		iargs [1] = src;
@@ -207,7 +268,7 @@ mini_emit_memset_internal (MonoCompile *cfg, MonoInst *dest, MonoInst *value_ins
 	/* FIXME: Optimize the case when dest is OP_LDADDR */
 
 	/* We can't do copies at a smaller granule than the provided alignment */
-	if (value_ins || size_ins || value != 0 || (size / align > MAX_INLINE_COPIES) || !(cfg->opt & MONO_OPT_INTRINS)) {
+	if (value_ins || size_ins || value != 0 || (inline_copy_count (cfg, size, align) > MAX_INLINE_COPIES) || !(cfg->opt & MONO_OPT_INTRINS)) {
 		MonoInst *iargs [3];
 		iargs [0] = dest;
 
@@ -92,6 +92,12 @@
 #define INLINE_LENGTH_LIMIT 20
 /* Used to LLVM JIT */
 #define LLVM_JIT_INLINE_LENGTH_LIMIT 100
+/* Scale the limit by this for callees which are hot according to the tier 0 counts */
+#define INLINE_HOT_LIMIT_FACTOR 3
+/* Don't inline callees called this many times less often than the caller at tier 0 */
+#define INLINE_COLD_CALL_RATIO 16
+/* Don't guard virtual calls whose profiled receiver types cover less than this percentage of the calls */
+#define GUARDED_DEVIRT_MIN_SHARE 50
 
 static const gboolean debug_tailcall = FALSE;               // logging
 static const gboolean debug_tailcall_try_all = FALSE;       // consider any call followed by ret
@@ -417,6 +423,7 @@ inline_failure (MonoCompile *cfg, const char *msg)
 {
 	if (cfg->verbose_level >= 2)
 		printf ("inline failed: %s\n", msg);
+	cfg->inline_failure_reason = msg;
 	mono_cfg_set_exception (cfg, MONO_EXCEPTION_INLINE_FAILED);
 }
 
@@ -442,6 +449,7 @@ mini_set_inline_failure (MonoCompile *cfg, const char *msg)
 {
 	if (cfg->verbose_level >= 2)
 		printf ("inline failed: %s\n", msg);
+	cfg->inline_failure_reason = msg;
 	mono_cfg_set_exception (cfg, MONO_EXCEPTION_INLINE_FAILED);
 }
 
@@ -2310,7 +2318,11 @@ mini_emit_write_barrier (MonoCompile *cfg, MonoInst *ptr, MonoInst *value)
 
 	mono_gc_get_nursery (&nursery_shift_bits, &nursery_size);
 
-	if (cfg->backend->have_card_table_wb && !cfg->compile_aot && card_table && nursery_shift_bits > 0 && !COMPILE_LLVM (cfg)) {
+	if (card_table && (cfg->opt & MONO_OPT_OUTLINE)) {
+		/* The write barrier wrapper is shared by all callers, so only the call is emitted */
+		mono_emit_method_call (cfg, mono_gc_get_write_barrier (), &ptr, NULL);
+		cfg->stat_outlined_wbarriers++;
+	} else if (cfg->backend->have_card_table_wb && !cfg->compile_aot && card_table && nursery_shift_bits > 0 && !COMPILE_LLVM (cfg)) {
 		MonoInst *wbarrier;
 
 		MONO_INST_NEW (cfg, wbarrier, OP_CARD_TABLE_WBARRIER);
@@ -2842,7 +2854,11 @@ emit_class_init (MonoCompile *cfg, MonoClass *klass)
 		EMIT_NEW_VTABLECONST (cfg, vtable_arg, vtable);
 	}
 
-	if (!COMPILE_LLVM (cfg) && cfg->backend->have_op_generic_class_init) {
+	if (cfg->opt & MONO_OPT_OUTLINE) {
+		/* mono_generic_class_init () does the initialized check itself */
+		mono_emit_jit_icall (cfg, mono_generic_class_init, &vtable_arg);
+		cfg->stat_outlined_class_inits++;
+	} else if (!COMPILE_LLVM (cfg) && cfg->backend->have_op_generic_class_init) {
 		MonoInst *ins;
 
 		/*
@@ -3167,6 +3183,27 @@ handle_unbox_gsharedvt (MonoCompile *cfg, MonoClass *klass, MonoInst *obj)
 	return ins;
 }
 
+/*
+ * emit_managed_alloc:
+ *
+ *   Emit a call to the managed allocator MANAGED_ALLOC.  If the object size in
+ * ARGS [1] is a constant, the allocator is inlined instead, so the size
+ * computations of its fast path are constant folded for the allocated class.
+ */
+static MonoInst*
+emit_managed_alloc (MonoCompile *cfg, MonoMethod *managed_alloc, MonoInst **args)
+{
+	if ((cfg->opt & MONO_OPT_INLINE) && !(cfg->opt & MONO_OPT_OUTLINE) && !cfg->disable_inline &&
+		!cfg->compile_aot && !COMPILE_LLVM (cfg) && !mini_safepoints_enabled () &&
+		args [1]->opcode == OP_ICONST && mono_gc_can_inline_managed_allocator ()) {
+		int costs = inline_method (cfg, managed_alloc, NULL, args, NULL, cfg->real_offset, TRUE);
+		if (costs > 0)
+			return args [0];
+	}
+
+	return mono_emit_method_call (cfg, managed_alloc, args, NULL);
+}
+
 /*
  * Returns NULL and set the cfg exception on error.
  */
@@ -3214,6 +3251,7 @@ handle_alloc (MonoCompile *cfg, MonoClass *klass, gboolean for_box, int context_
 					g_error ("Invalid size %d for class %s", size, mono_type_get_full_name (klass));
 
 				EMIT_NEW_ICONST (cfg, iargs [1], size);
+				return emit_managed_alloc (cfg, managed_alloc, iargs);
 			}
 			return mono_emit_method_call (cfg, managed_alloc, iargs, NULL);
 		}
@@ -3248,7 +3286,7 @@ handle_alloc (MonoCompile *cfg, MonoClass *klass, gboolean for_box, int context_
 
 			EMIT_NEW_VTABLECONST (cfg, iargs [0], vtable);
 			EMIT_NEW_ICONST (cfg, iargs [1], size);
-			return mono_emit_method_call (cfg, managed_alloc, iargs, NULL);
+			return emit_managed_alloc (cfg, managed_alloc, iargs);
 		}
 		alloc_ftn = MONO_JIT_ICALL_ves_icall_object_new_specific;
 		EMIT_NEW_VTABLECONST (cfg, iargs [0], vtable);
@@ -3605,6 +3643,65 @@ handle_delegate_ctor (MonoCompile *cfg, MonoClass *klass, MonoInst *target, Mono
 	return obj;
 }
 
+/*
+ * get_constant_delegate_target:
+ *
+ *   Return the method a call to the Invoke method of the delegate constant DEL_INS can
+ * call directly instead, or NULL. This happens for delegates stored in initialized
+ * static readonly fields. *TARGET is set to the object to pass as the first argument,
+ * or NULL for open static delegates, which drop the delegate argument.
+ */
+static MonoMethod*
+get_constant_delegate_target (MonoCompile *cfg, MonoMethodSignature *invoke_sig, MonoInst *del_ins, MonoObject **target)
+{
+	MonoDelegate *del;
+	MonoMethod *method;
+	MonoMethodSignature *sig;
+
+	*target = NULL;
+
+	/* Only non moving GCs let object constants into the code, see LDSFLD */
+	if (del_ins->opcode != OP_PCONST || !del_ins->inst_p0 || cfg->compile_aot || cfg->llvm_only || mono_gc_is_moving ())
+		return NULL;
+
+	del = (MonoDelegate *)del_ins->inst_p0;
+	method = del->method;
+	if (!method || ((MonoMulticastDelegate *)del)->delegates)
+		return NULL;
+	if (method->dynamic || method->wrapper_type || (method->iflags & METHOD_IMPL_ATTRIBUTE_SYNCHRONIZED))
+		return NULL;
+#ifndef DISABLE_REMOTING
+	if (del->target && mono_object_is_transparent_proxy (del->target))
+		return NULL;
+#endif
+
+	if (del->target && (method->flags & METHOD_ATTRIBUTE_VIRTUAL))
+		method = mono_object_get_virtual_method_internal (del->target, method);
+	if (!method || mono_method_needs_static_rgctx_invoke (method, FALSE))
+		return NULL;
+
+	sig = mono_method_signature_internal (method);
+	if (!sig)
+		return NULL;
+
+	if (sig->hasthis) {
+		/* Closed instance, valuetype targets would need an unbox */
+		if (!del->target || m_class_is_valuetype (method->klass) || sig->param_count != invoke_sig->param_count)
+			return NULL;
+	} else if (del->target) {
+		/* Closed static, the target is the first argument */
+		if (sig->param_count != invoke_sig->param_count + 1)
+			return NULL;
+	} else {
+		/* Open static */
+		if (sig->param_count != invoke_sig->param_count)
+			return NULL;
+	}
+
+	*target = del->target;
+	return method;
+}
+
 /*
  * handle_constrained_gsharedvt_call:
  *
@@ -3811,6 +3908,22 @@ mono_method_check_inlining (MonoCompile *cfg, MonoMethod *method)
 		limit = llvm_jit_inline_limit;
 	else
 		limit = inline_limit;
+	/*
+	 * When tiering up, the callee's tier 0 calls bound how often the call site ran.
+	 * Only calls are compared, a caller hot because of its loops has few of them.
+	 * Inline larger hot callees, and don't waste code size on cold ones.
+	 */
+	if (cfg->tier_profile && !(method->iflags & METHOD_IMPL_ATTRIBUTE_AGGRESSIVE_INLINING)) {
+		MonoTierInfo *callee = mini_lookup_tier_info (cfg->domain, method);
+
+		if (callee) {
+			if (callee->tiered_up || callee->calls >= cfg->tier_profile->calls)
+				limit *= INLINE_HOT_LIMIT_FACTOR;
+			else if ((gint64)callee->calls * INLINE_COLD_CALL_RATIO < cfg->tier_profile->calls)
+				return FALSE;
+		}
+	}
+
 	if (header.code_size >= limit && !(method->iflags & METHOD_IMPL_ATTRIBUTE_AGGRESSIVE_INLINING))
 		return FALSE;
 
@@ -4403,6 +4516,267 @@ emit_init_local (MonoCompile *cfg, int local, MonoType *type, gboolean init)
 	}
 }
 
+/*
+ * emit_tier_count:
+ *
+ *   Count a call, or a loop iteration if BACKEDGE is set, of tier 0 code, calling
+ * mini_tier_up () once the method is hot. The counter isn't updated atomically, losing some counts to races only
+ * delays the tier up.
+ */
+static void
+emit_tier_count (MonoCompile *cfg, gboolean backedge)
+{
+	MonoBasicBlock *cont_bb;
+	MonoInst *addr, *iargs [1];
+	int count_reg = alloc_ireg (cfg);
+
+	NEW_BBLOCK (cfg, cont_bb);
+
+	EMIT_NEW_PCONST (cfg, addr, backedge ? &cfg->tier_info->backedges : &cfg->tier_info->calls);
+	MONO_EMIT_NEW_LOAD_MEMBASE_OP (cfg, OP_LOADI4_MEMBASE, count_reg, addr->dreg, 0);
+	MONO_EMIT_NEW_BIALU_IMM (cfg, OP_IADD_IMM, count_reg, count_reg, 1);
+	MONO_EMIT_NEW_STORE_MEMBASE (cfg, OP_STOREI4_MEMBASE_REG, addr->dreg, 0, count_reg);
+	MONO_EMIT_NEW_BIALU_IMM (cfg, OP_ICOMPARE_IMM, -1, count_reg, mono_tier_up_threshold);
+	MONO_EMIT_NEW_BRANCH_BLOCK (cfg, OP_IBNE_UN, cont_bb);
+
+	/* void mini_tier_up (MonoTierInfo *info) */
+	EMIT_NEW_PCONST (cfg, iargs [0], cfg->tier_info);
+	mono_emit_jit_icall (cfg, mini_tier_up, iargs);
+
+	MONO_START_BB (cfg, cont_bb);
+}
+
+/*
+ * is_loop_branch:
+ *
+ *   Return whenever IL_OP can close a loop when it branches backwards. leave is not
+ * included: it exits protected regions, the loop around them is closed by a br.
+ */
+static gboolean
+is_loop_branch (MonoOpcodeEnum il_op)
+{
+	switch (il_op) {
+	case MONO_CEE_BR:
+	case MONO_CEE_BR_S:
+	case MONO_CEE_BRTRUE:
+	case MONO_CEE_BRTRUE_S:
+	case MONO_CEE_BRFALSE:
+	case MONO_CEE_BRFALSE_S:
+	/* C# closes for and while loops with a compare and branch */
+	case MONO_CEE_BEQ:
+	case MONO_CEE_BEQ_S:
+	case MONO_CEE_BGE:
+	case MONO_CEE_BGE_S:
+	case MONO_CEE_BGT:
+	case MONO_CEE_BGT_S:
+	case MONO_CEE_BLE:
+	case MONO_CEE_BLE_S:
+	case MONO_CEE_BLT:
+	case MONO_CEE_BLT_S:
+	case MONO_CEE_BNE_UN:
+	case MONO_CEE_BNE_UN_S:
+	case MONO_CEE_BGE_UN:
+	case MONO_CEE_BGE_UN_S:
+	case MONO_CEE_BGT_UN:
+	case MONO_CEE_BGT_UN_S:
+	case MONO_CEE_BLE_UN:
+	case MONO_CEE_BLE_UN_S:
+	case MONO_CEE_BLT_UN:
+	case MONO_CEE_BLT_UN_S:
+		return TRUE;
+	default:
+		return FALSE;
+	}
+}
+
+/*
+ * emit_tier_counter:
+ *
+ *   Emit the call counting of tier 0 code in its own bblocks between START_BB and INIT_BB.
+ */
+static void
+emit_tier_counter (MonoCompile *cfg, MonoBasicBlock *start_bb, MonoBasicBlock *init_bb)
+{
+	MonoBasicBlock *count_bb;
+
+	NEW_BBLOCK (cfg, count_bb);
+	count_bb->real_offset = cfg->real_offset;
+	start_bb->next_bb = count_bb;
+	link_bblock (cfg, start_bb, count_bb);
+	cfg->cbb = count_bb;
+
+	emit_tier_count (cfg, FALSE);
+
+	cfg->cbb->next_bb = init_bb;
+	link_bblock (cfg, cfg->cbb, init_bb);
+}
+
+/*
+ * emit_receiver_profile:
+ *
+ *   Record the vtable of OBJ, the receiver of the virtual call at IL_OFFSET, for
+ * emit_guarded_devirt_call () to use once the method tiers up. Calls with the first
+ * recorded type are counted inline, the rest by mini_tier_record_receiver ().
+ */
+static void
+emit_receiver_profile (MonoCompile *cfg, MonoInst *obj, guint32 il_offset)
+{
+	MonoBasicBlock *end_bb, *record_bb;
+	MonoInst *addr, *vtable, *iargs [2];
+	int first_reg = alloc_preg (cfg);
+	int count_reg = alloc_ireg (cfg);
+
+	NEW_BBLOCK (cfg, end_bb);
+	NEW_BBLOCK (cfg, record_bb);
+
+	EMIT_NEW_LOAD_MEMBASE_FAULT (cfg, vtable, OP_LOAD_MEMBASE, alloc_preg (cfg), obj->dreg, MONO_STRUCT_OFFSET (MonoObject, vtable));
+	EMIT_NEW_PCONST (cfg, addr, mini_tier_get_receivers (cfg->tier_info, il_offset, TRUE));
+	MONO_EMIT_NEW_LOAD_MEMBASE (cfg, first_reg, addr->dreg, MONO_STRUCT_OFFSET (MonoTierReceivers, vtables));
+	MONO_EMIT_NEW_BIALU (cfg, OP_COMPARE, -1, first_reg, vtable->dreg);
+	MONO_EMIT_NEW_BRANCH_BLOCK (cfg, OP_PBNE_UN, record_bb);
+	MONO_EMIT_NEW_LOAD_MEMBASE_OP (cfg, OP_LOADI4_MEMBASE, count_reg, addr->dreg, MONO_STRUCT_OFFSET (MonoTierReceivers, counts));
+	MONO_EMIT_NEW_BIALU_IMM (cfg, OP_IADD_IMM, count_reg, count_reg, 1);
+	MONO_EMIT_NEW_STORE_MEMBASE (cfg, OP_STOREI4_MEMBASE_REG, addr->dreg, MONO_STRUCT_OFFSET (MonoTierReceivers, counts), count_reg);
+	MONO_EMIT_NEW_BRANCH_BLOCK (cfg, OP_BR, end_bb);
+
+	MONO_START_BB (cfg, record_bb);
+	/* void mini_tier_record_receiver (MonoTierReceivers *receivers, MonoVTable *vtable) */
+	iargs [0] = addr;
+	iargs [1] = vtable;
+	mono_emit_jit_icall (cfg, mini_tier_record_receiver, iargs);
+
+	MONO_START_BB (cfg, end_bb);
+}
+
+/*
+ * get_profiled_target:
+ *
+ *   Return the implementation of CMETHOD a virtual call with a receiver of type VTABLE
+ * ends up in, or NULL if it can't be called directly.
+ */
+static MonoMethod*
+get_profiled_target (MonoCompile *cfg, MonoMethod *cmethod, MonoVTable *vtable)
+{
+	ERROR_DECL (error);
+	MonoClass *klass = vtable->klass;
+	MonoMethod *target;
+
+	if (m_class_is_valuetype (klass) || mono_class_is_transparent_proxy (klass) || mono_class_is_marshalbyref (klass))
+		return NULL;
+
+	target = mono_class_get_virtual_method (klass, cmethod, FALSE, error);
+	if (!is_ok (error)) {
+		mono_error_cleanup (error);
+		return NULL;
+	}
+	/* Calls to these would need extra arguments or wrappers */
+	if (!target || (target->flags & (METHOD_ATTRIBUTE_ABSTRACT | METHOD_ATTRIBUTE_PINVOKE_IMPL)) ||
+		(target->iflags & (METHOD_IMPL_ATTRIBUTE_INTERNAL_CALL | METHOD_IMPL_ATTRIBUTE_RUNTIME | METHOD_IMPL_ATTRIBUTE_SYNCHRONIZED)) ||
+		target->is_inflated || mono_class_is_ginst (target->klass) || mono_class_is_gtd (target->klass))
+		return NULL;
+
+	return target;
+}
+
+/*
+ * emit_guarded_devirt_call:
+ *
+ *   Emit the virtual call to CMETHOD at IL_OFFSET as a polymorphic inline cache of the
+ * receiver types recorded by the tier 0 code: a chain of vtable checks, hottest type
+ * first, each guarding a direct call to its implementation. Only the hottest one is
+ * inlined. Other receivers take the virtual call. Return whenever the call was emitted,
+ * setting *RES to its result. Megamorphic call sites are left to the vtable/IMT dispatch.
+ */
+static gboolean
+emit_guarded_devirt_call (MonoCompile *cfg, MonoMethod *cmethod, MonoMethodSignature *fsig, MonoInst **sp,
+						  guchar *ip, guint32 il_offset, int *inline_costs, MonoInst **res)
+{
+	MonoTierReceivers *receivers;
+	MonoBasicBlock *next_bb, *end_bb;
+	MonoVTable *vtables [MONO_TIER_RECEIVER_TYPES];
+	MonoMethod *targets [MONO_TIER_RECEIVER_TYPES];
+	gint32 counts [MONO_TIER_RECEIVER_TYPES];
+	MonoInst *this_ins = sp [0];
+	MonoInst *ins, *store, *rvar = NULL;
+	gint64 total, covered = 0;
+	int i, j, vtable_reg, ntargets = 0;
+
+	receivers = mini_tier_get_receivers (cfg->tier_profile, il_offset, FALSE);
+	if (!receivers)
+		return FALSE;
+
+	total = receivers->others;
+	for (i = 0; i < MONO_TIER_RECEIVER_TYPES; ++i) {
+		MonoVTable *vtable = receivers->vtables [i];
+		gint32 count = receivers->counts [i];
+		MonoMethod *target;
+
+		total += count;
+		if (!vtable || count <= 0 || !(target = get_profiled_target (cfg, cmethod, vtable)))
+			continue;
+		/* Keep them sorted by decreasing count */
+		for (j = ntargets; j > 0 && counts [j - 1] < count; --j) {
+			vtables [j] = vtables [j - 1];
+			targets [j] = targets [j - 1];
+			counts [j] = counts [j - 1];
+		}
+		vtables [j] = vtable;
+		targets [j] = target;
+		counts [j] = count;
+		ntargets ++;
+		covered += count;
+	}
+	if (!ntargets || covered * 100 < total * GUARDED_DEVIRT_MIN_SHARE)
+		return FALSE;
+
+	if (!MONO_TYPE_IS_VOID (fsig->ret))
+		rvar = mono_compile_create_var (cfg, fsig->ret, OP_LOCAL);
+
+	NEW_BBLOCK (cfg, end_bb);
+
+	vtable_reg = alloc_preg (cfg);
+	MONO_EMIT_NEW_LOAD_MEMBASE_FAULT (cfg, vtable_reg, this_ins->dreg, MONO_STRUCT_OFFSET (MonoObject, vtable));
+
+	for (i = 0; i < ntargets; ++i) {
+		int costs = 0;
+
+		NEW_BBLOCK (cfg, next_bb);
+		MONO_EMIT_NEW_BIALU_IMM (cfg, OP_COMPARE_IMM, -1, vtable_reg, (gssize)vtables [i]);
+		MONO_EMIT_NEW_BRANCH_BLOCK (cfg, OP_PBNE_UN, next_bb);
+
+		if (i == 0 && (cfg->opt & MONO_OPT_INLINE) && mono_method_check_inlining (cfg, targets [i]))
+			costs = inline_method (cfg, targets [i], fsig, sp, ip, cfg->real_offset, FALSE);
+		if (costs) {
+			cfg->real_offset += 5;
+			*inline_costs += costs;
+			/* *sp is set by inline_method */
+			ins = sp [0];
+			sp [0] = this_ins;
+		} else {
+			/* The receiver was dereferenced by the vtable check */
+			ins = mini_emit_method_call_full (cfg, targets [i], fsig, FALSE, sp, NULL, NULL, NULL);
+		}
+		if (rvar)
+			EMIT_NEW_TEMPSTORE (cfg, store, rvar->inst_c0, ins);
+		MONO_EMIT_NEW_BRANCH_BLOCK (cfg, OP_BR, end_bb);
+
+		MONO_START_BB (cfg, next_bb);
+	}
+
+	ins = mini_emit_method_call_full (cfg, cmethod, fsig, FALSE, sp, this_ins, NULL, NULL);
+	if (rvar)
+		EMIT_NEW_TEMPSTORE (cfg, store, rvar->inst_c0, ins);
+
+	MONO_START_BB (cfg, end_bb);
+	if (rvar)
+		EMIT_NEW_TEMPLOAD (cfg, ins, rvar->inst_c0);
+	else
+		ins = NULL;
+
+	*res = ins;
+	return TRUE;
+}
+
 int
 mini_inline_method (MonoCompile *cfg, MonoMethod *cmethod, MonoMethodSignature *fsig, MonoInst **sp, guchar *ip, guint real_offset, gboolean inline_always)
 {
@@ -4613,6 +4987,14 @@ inline_method (MonoCompile *cfg, MonoMethod *cmethod, MonoMethodSignature *fsig,
 			const char *msg = mono_error_get_message (&cfg->error);
 			printf ("INLINE ABORTED %s (cost %d) %s\n", mono_method_full_name (cmethod, TRUE), costs, msg ? msg : "");
 		}
+		cfg->stat_inline_failures++;
+		if (cfg->exception_type == MONO_EXCEPTION_INLINE_FAILED && cfg->inline_failure_reason)
+			mono_jit_telemetry_inline_failed (cfg->inline_failure_reason);
+		else if (costs >= 0)
+			mono_jit_telemetry_inline_failed ("too expensive");
+		else
+			mono_jit_telemetry_inline_failed ("error");
+		cfg->inline_failure_reason = NULL;
 		cfg->exception_type = MONO_EXCEPTION_NONE;
 
 		clear_cfg_error (cfg);
@@ -4929,6 +5311,8 @@ il_read_branch_and_target (guchar *ip, guchar *end, guchar first_byte, MonoOpcod
 #define il_read_callvirt(ip, end, token)	(il_read_op_and_token 	   (ip, end, CEE_CALLVIRT, MONO_CEE_CALLVIRT, token))
 #define il_read_initobj(ip, end, token)         (il_read_op_and_token 	   (ip, end, CEE_PREFIX1, MONO_CEE_INITOBJ, token))
 #define il_read_constrained(ip, end, token)     (il_read_op_and_token      (ip, end, CEE_PREFIX1, MONO_CEE_CONSTRAINED_, token))
+#define il_read_unbox_any(ip, end, token)	(il_read_op_and_token 	   (ip, end, CEE_UNBOX_ANY, MONO_CEE_UNBOX_ANY, token))
+#define il_read_isinst(ip, end, token)		(il_read_op_and_token 	   (ip, end, CEE_ISINST, MONO_CEE_ISINST, token))
 
 /*
  * Check that the IL instructions at ip are the array initialization
@@ -5354,6 +5738,36 @@ mono_is_not_supported_tailcall_helper (gboolean value, const char *svalue, MonoM
 
 #define IS_NOT_SUPPORTED_TAILCALL(x) (mono_is_not_supported_tailcall_helper((x), #x, method, cmethod))
 
+/*
+ * tailcall_return_kind:
+ *
+ *   Return the type TYPE is returned as, for comparing caller and callee return
+ * types. Types which only differ in signedness or which are all references are
+ * returned identically, so no conversion would be skipped by a tailcall.
+ */
+static int
+tailcall_return_kind (MonoType *type)
+{
+	type = mini_get_underlying_type (type);
+
+	if (mini_type_is_reference (type))
+		return MONO_TYPE_OBJECT;
+
+	switch (type->type) {
+	case MONO_TYPE_U4:
+		return MONO_TYPE_I4;
+	case MONO_TYPE_U8:
+		return MONO_TYPE_I8;
+	case MONO_TYPE_I:
+	case MONO_TYPE_U:
+	case MONO_TYPE_PTR:
+	case MONO_TYPE_FNPTR:
+		return TARGET_SIZEOF_VOID_P == 8 ? MONO_TYPE_I8 : MONO_TYPE_I4;
+	default:
+		return type->type;
+	}
+}
+
 static gboolean
 is_supported_tailcall (MonoCompile *cfg, const guint8 *ip, MonoMethod *method, MonoMethod *cmethod, MonoMethodSignature *fsig,
 	gboolean virtual_, gboolean extra_arg, gboolean *ptailcall_calli)
@@ -5440,11 +5854,11 @@ is_supported_tailcall (MonoCompile *cfg, const guint8 *ip, MonoMethod *method, M
 	g_assert (caller_signature);
 	g_assert (callee_signature);
 
-	// Require an exact match on return type due to various conversions in emit_move_return_value that would be skipped.
+	// Require a match on return type due to various conversions in emit_move_return_value that would be skipped.
 	// The main troublesome conversions are double <=> float.
 	// CoreCLR allows some conversions here, such as integer truncation.
-	// As well I <=> I[48] and U <=> U[48] would be ok, for matching size.
-	if (IS_NOT_SUPPORTED_TAILCALL (mini_get_underlying_type (caller_signature->ret)->type != mini_get_underlying_type (callee_signature->ret)->type)
+	// Signedness of full width integers, I <=> I[48] for matching size and reference types don't need conversions.
+	if (IS_NOT_SUPPORTED_TAILCALL (tailcall_return_kind (caller_signature->ret) != tailcall_return_kind (callee_signature->ret))
 		|| IS_NOT_SUPPORTED_TAILCALL (!mono_arch_tailcall_supported (cfg, caller_signature, callee_signature, virtual_))) {
 		tailcall_calli = FALSE;
 		tailcall = FALSE;
@@ -6261,9 +6675,13 @@ mono_method_to_ir (MonoCompile *cfg, MonoMethod *method, MonoBasicBlock *start_b
 	if (cfg->method == method)
 		cfg->bb_init = init_localsbb;
 	init_localsbb->real_offset = cfg->real_offset;
-	start_bblock->next_bb = init_localsbb;
 	init_localsbb->next_bb = cfg->cbb;
-	link_bblock (cfg, start_bblock, init_localsbb);
+	if (cfg->tier_info && cfg->method == method) {
+		emit_tier_counter (cfg, start_bblock, init_localsbb);
+	} else {
+		start_bblock->next_bb = init_localsbb;
+		link_bblock (cfg, start_bblock, init_localsbb);
+	}
 	link_bblock (cfg, init_localsbb, cfg->cbb);
 	init_localsbb2 = init_localsbb;
 	cfg->cbb = init_localsbb;
@@ -6494,7 +6912,22 @@ mono_method_to_ir (MonoCompile *cfg, MonoMethod *method, MonoBasicBlock *start_b
 				gpointer counter = &cfg->coverage_info->data [cil_offset].count;
 				cfg->coverage_info->data [cil_offset].cil_code = ip;
 
-				if (mono_arch_opcode_supported (OP_ATOMIC_ADD_I4)) {
+				if (mono_profiler_coverage_hits_enabled ()) {
+					MonoBasicBlock *hit_bb;
+					int hit_reg = alloc_ireg (cfg);
+
+					/*
+					 * Only store once the first time around, so threads running the same
+					 * code don't keep stealing the counter's cache line from each other.
+					 */
+					NEW_BBLOCK (cfg, hit_bb);
+					EMIT_NEW_PCONST (cfg, ins, counter);
+					MONO_EMIT_NEW_LOAD_MEMBASE_OP (cfg, OP_LOADI4_MEMBASE, hit_reg, ins->dreg, 0);
+					MONO_EMIT_NEW_BIALU_IMM (cfg, OP_ICOMPARE_IMM, -1, hit_reg, 0);
+					MONO_EMIT_NEW_BRANCH_BLOCK (cfg, OP_IBNE_UN, hit_bb);
+					MONO_EMIT_NEW_STORE_MEMBASE_IMM (cfg, OP_STOREI4_MEMBASE_IMM, ins->dreg, 0, 1);
+					MONO_START_BB (cfg, hit_bb);
+				} else if (mono_arch_opcode_supported (OP_ATOMIC_ADD_I4)) {
 					MonoInst *one_ins, *load_ins;
 
 					EMIT_NEW_PCONST (cfg, load_ins, counter);
@@ -6554,6 +6987,10 @@ mono_method_to_ir (MonoCompile *cfg, MonoMethod *method, MonoBasicBlock *start_b
 		if (pops >= 0)
 			CHECK_STACK (pops);
 
+		/* Loop iterations count towards tiering up too, separately from calls */
+		if (cfg->tier_info && cfg->method == method && target <= ip && is_loop_branch (il_op))
+			emit_tier_count (cfg, TRUE);
+
 		switch (il_op) {
 		case MONO_CEE_NOP:
 			if (seq_points && !sym_seq_points && sp != stack_start) {
@@ -7091,6 +7528,9 @@ mono_method_to_ir (MonoCompile *cfg, MonoMethod *method, MonoBasicBlock *start_b
 			} else if (fsig->pinvoke) {
 				MonoMethod *wrapper = mono_marshal_get_native_wrapper (cmethod, TRUE, cfg->compile_aot);
 				fsig = mono_method_signature_internal (wrapper);
+				/* The wrapper is just the native call, so inline it like the one of a direct icall */
+				if (!cfg->gen_sdb_seq_points && !cfg->compile_llvm && mono_marshal_is_direct_pinvoke (cmethod))
+					direct_icall = TRUE;
 			} else if (constrained_class) {
 			} else {
 				fsig = mono_method_get_signature_checked (cmethod, image, token, generic_context, &cfg->error);
@@ -7182,6 +7622,31 @@ mono_method_to_ir (MonoCompile *cfg, MonoMethod *method, MonoBasicBlock *start_b
 			if ((m_class_get_parent (cmethod->klass) == mono_defaults.multicastdelegate_class) && !strcmp (cmethod->name, "Invoke"))
 				delegate_invoke = TRUE;
 
+			if (delegate_invoke && (cfg->opt & MONO_OPT_INTRINS)) {
+				MonoObject *delegate_target;
+				MonoMethod *delegate_method = get_constant_delegate_target (cfg, fsig, sp [0], &delegate_target);
+
+				/* Call the target of a constant delegate directly, so it can be inlined too */
+				if (delegate_method) {
+					if (cfg->verbose_level > 2)
+						printf ("<constant delegate invoke opt> %s\n", mono_method_full_name (delegate_method, TRUE));
+
+					if (delegate_target) {
+						EMIT_NEW_PCONST (cfg, sp [0], delegate_target);
+						sp [0]->type = STACK_OBJ;
+						sp [0]->klass = mono_object_class (delegate_target);
+					} else {
+						memmove (sp, sp + 1, fsig->param_count * sizeof (MonoInst*));
+					}
+
+					cmethod = delegate_method;
+					fsig = mono_method_signature_internal (cmethod);
+					n = fsig->param_count + fsig->hasthis;
+					virtual_ = FALSE;
+					delegate_invoke = FALSE;
+				}
+			}
+
 			if ((cfg->opt & MONO_OPT_INTRINS) && (ins = mini_emit_inst_for_sharable_method (cfg, cmethod, fsig, sp))) {
 				if (!MONO_TYPE_IS_VOID (fsig->ret)) {
 					mini_type_to_eval_stack_type ((cfg), fsig->ret, ins);
@@ -7744,6 +8209,18 @@ mono_method_to_ir (MonoCompile *cfg, MonoMethod *method, MonoBasicBlock *start_b
 			/* Common call */
 			if (!(method->iflags & METHOD_IMPL_ATTRIBUTE_AGGRESSIVE_INLINING) && !(cmethod->iflags & METHOD_IMPL_ATTRIBUTE_AGGRESSIVE_INLINING))
 				INLINE_FAILURE ("call");
+
+			/* Profile the receivers of virtual calls at tier 0, and use them when tiering up */
+			if (virtual_ && (cmethod->flags & METHOD_ATTRIBUTE_VIRTUAL) && !MONO_METHOD_IS_FINAL (cmethod) &&
+				cfg->method == method && !cfg->gshared && !tailcall && !imt_arg && !vtable_arg && !fsig->generic_param_count) {
+				if (cfg->tier_info) {
+					emit_receiver_profile (cfg, sp [0], ip - header->code);
+				} else if (cfg->tier_profile && emit_guarded_devirt_call (cfg, cmethod, fsig, sp, ip, ip - header->code, &inline_costs, &ins)) {
+					if (inst_tailcall) // FIXME
+						mono_tailcall_print ("missed tailcall guarded devirt %s -> %s\n", method->name, cmethod->name);
+					goto call_end;
+				}
+			}
 			common_call = TRUE;
 
 call_end:
@@ -8686,6 +9163,13 @@ calli_end:
 
 					alloc = handle_alloc (cfg, cmethod->klass, FALSE, 0);
 					*sp = alloc;
+
+					/* The alias analysis pass may replace the object by its fields if it doesn't escape */
+					if (alloc && !(cfg->opt & MONO_OPT_SHARED) && !m_class_has_finalize (cmethod->klass) && !m_class_has_weak_fields (cmethod->klass) &&
+						!mono_class_is_marshalbyref (cmethod->klass) && !mono_class_is_contextbound (cmethod->klass)) {
+						alloc->klass = cmethod->klass;
+						cfg->object_allocs = g_slist_prepend_mempool (cfg->mempool, cfg->object_allocs, alloc);
+					}
 				}
 				CHECK_CFG_EXCEPTION; /*for handle_alloc*/
 
@@ -8797,6 +9281,30 @@ calli_end:
 				UNVERIFIED;
 			if (target_type_is_incompatible (cfg, m_class_get_byval_arg (klass), val))
 				UNVERIFIED;
+
+			/*
+			 * box T + unbox.any T, generated for (T)(object)val in generic code: the value
+			 * comes back unchanged, so don't allocate.
+			 */
+			guint32 unbox_token;
+
+			if (!mono_class_is_nullable (klass) &&
+			    !mini_is_gsharedvt_klass (klass) &&
+			    next_ip < end && ip_in_bb (cfg, cfg->cbb, next_ip) &&
+			    (ip = il_read_unbox_any (next_ip, end, &unbox_token))) {
+				MonoClass *unbox_klass = mini_get_class (method, unbox_token, generic_context);
+				CHECK_TYPELOAD (unbox_klass);
+
+				if (unbox_klass == klass) {
+					if (cfg->verbose_level > 3)
+						printf ("<box+unbox.any opt>\n");
+					il_op = MONO_CEE_UNBOX_ANY;
+					next_ip = ip;
+					*sp++ = val;
+					break;
+				}
+			}
+
 			/* frequent check in generic code: box (struct), brtrue */
 
 			/*
@@ -8849,20 +9357,54 @@ calli_end:
 			}
 
 			gboolean is_true;
+			guint32 isinst_token;
+			guchar *branch_ip = next_ip;
+			gboolean isinst_fails = FALSE;
+
+			/*
+			 * box + isinst C + brtrue, generated for 'val is C' in generic code. The box is
+			 * never null and its exact class is klass, so the result is known when C is.
+			 */
+			if (!mono_class_is_nullable (klass) &&
+			    !mini_is_gsharedvt_klass (klass) &&
+			    !context_used &&
+			    next_ip < end && ip_in_bb (cfg, cfg->cbb, next_ip) &&
+			    (ip = il_read_isinst (next_ip, end, &isinst_token)) &&
+			    ip_in_bb (cfg, cfg->cbb, ip)) {
+				MonoClass *isinst_klass = mini_get_class (method, isinst_token, generic_context);
+				CHECK_TYPELOAD (isinst_klass);
+
+				if (!mini_class_check_context_used (cfg, isinst_klass) && !mono_class_is_nullable (isinst_klass)) {
+					ERROR_DECL (isinst_error);
+					gboolean assignable = FALSE;
+
+					mono_class_is_assignable_from_checked (isinst_klass, klass, &assignable, isinst_error);
+					if (is_ok (isinst_error)) {
+						branch_ip = ip;
+						isinst_fails = !assignable;
+					}
+					/* Otherwise leave the isinst to fail at runtime */
+					mono_error_cleanup (isinst_error);
+				}
+			}
 
 			// FIXME: LLVM can't handle the inconsistent bb linking
 			if (!mono_class_is_nullable (klass) &&
 				!mini_is_gsharedvt_klass (klass) &&
-				next_ip < end && ip_in_bb (cfg, cfg->cbb, next_ip) &&
-				( (is_true = !!(ip = il_read_brtrue   (next_ip, end, &target))) ||
-				  (is_true = !!(ip = il_read_brtrue_s (next_ip, end, &target))) ||
-					       (ip = il_read_brfalse  (next_ip, end, &target))  ||
-					       (ip = il_read_brfalse_s (next_ip, end, &target)))) {
+				branch_ip < end && ip_in_bb (cfg, cfg->cbb, branch_ip) &&
+				( (is_true = !!(ip = il_read_brtrue   (branch_ip, end, &target))) ||
+				  (is_true = !!(ip = il_read_brtrue_s (branch_ip, end, &target))) ||
+					       (ip = il_read_brfalse  (branch_ip, end, &target))  ||
+					       (ip = il_read_brfalse_s (branch_ip, end, &target)))) {
 
 				int dreg;
 				MonoBasicBlock *true_bb, *false_bb;
 
-				il_op = (MonoOpcodeEnum)next_ip [0];
+				/* A failing isinst leaves null, which inverts the branch */
+				if (isinst_fails)
+					is_true = !is_true;
+
+				il_op = (MonoOpcodeEnum)branch_ip [0];
 				next_ip = ip;
 
 				if (cfg->verbose_level > 3) {
@@ -8971,7 +9513,7 @@ calli_end:
 			gboolean is_special_static;
 			MonoType *ftype;
 			MonoInst *store_val = NULL;
-			MonoInst *thread_ins;
+			MonoInst *static_data_ins;
 
 			is_instance = (il_op == MONO_CEE_LDFLD || il_op == MONO_CEE_LDFLDA || il_op == MONO_CEE_STFLD);
 			if (is_instance) {
@@ -9256,16 +9798,17 @@ calli_end:
 			is_special_static = mono_class_field_is_special_static (field);
 
 			if (is_special_static && ((gsize)addr & 0x80000000) == 0)
-				thread_ins = mono_create_tls_get (cfg, TLS_KEY_THREAD);
+				static_data_ins = mono_create_tls_get (cfg, TLS_KEY_THREAD_STATIC_DATA);
 			else
-				thread_ins = NULL;
+				static_data_ins = NULL;
 
 			/* Generate IR to compute the field address */
-			if (is_special_static && ((gsize)addr & 0x80000000) == 0 && thread_ins && !(cfg->opt & MONO_OPT_SHARED) && !context_used) {
+			if (is_special_static && ((gsize)addr & 0x80000000) == 0 && static_data_ins && !(cfg->opt & MONO_OPT_SHARED) && !context_used) {
 				/*
 				 * Fast access to TLS data
 				 * Inline version of get_thread_static_data () in
-				 * threads.c.
+				 * threads.c, the static_data array of the current thread
+				 * is cached in its own TLS slot.
 				 */
 				guint32 offset;
 				int idx, static_data_reg, array_reg, dreg;
@@ -9273,8 +9816,7 @@ calli_end:
 				if (context_used && cfg->gsharedvt && mini_is_gsharedvt_klass (klass))
 					GSHAREDVT_FAILURE (il_op);
 
-				static_data_reg = alloc_ireg (cfg);
-				MONO_EMIT_NEW_LOAD_MEMBASE (cfg, static_data_reg, thread_ins->dreg, MONO_STRUCT_OFFSET (MonoInternalThread, static_data));
+				static_data_reg = static_data_ins->dreg;
 
 				if (cfg->compile_aot) {
 					int offset_reg, offset2_reg, idx_reg;
@@ -9298,8 +9840,13 @@ calli_end:
 					offset = (gsize)addr & 0x7fffffff;
 					idx = offset & 0x3f;
 
-					array_reg = alloc_ireg (cfg);
-					MONO_EMIT_NEW_LOAD_MEMBASE (cfg, array_reg, static_data_reg, idx * TARGET_SIZEOF_VOID_P);
+					/* The first chunk is the static_data array itself */
+					if (idx == 0) {
+						array_reg = static_data_reg;
+					} else {
+						array_reg = alloc_ireg (cfg);
+						MONO_EMIT_NEW_LOAD_MEMBASE (cfg, array_reg, static_data_reg, idx * TARGET_SIZEOF_VOID_P);
+					}
 					dreg = alloc_ireg (cfg);
 					EMIT_NEW_BIALU_IMM (cfg, ins, OP_ADD_IMM, dreg, array_reg, ((offset >> 6) & 0x1ffffff));
 				}
@@ -9326,8 +9873,10 @@ calli_end:
 					depth, field->offset);
 				*/
 
-				if (mono_class_needs_cctor_run (klass, method))
+				if (mono_class_needs_cctor_run (klass, method) && !g_slist_find (class_inits, klass)) {
 					emit_class_init (cfg, klass);
+					class_inits = g_slist_prepend (class_inits, klass);
+				}
 
 				/*
 				 * The pointer we're computing here is
@@ -9617,7 +10166,7 @@ field_access_end:
 
 			/* 
 			 * we inline/optimize the initialization sequence if possible.
-			 * we should also allocate the array as not cleared, since we spend as much time clearing to 0 as initializing
+			 * large arrays are allocated as not cleared, since we spend as much time clearing to 0 as initializing
 			 * for small sizes open code the memcpy
 			 * ensure the rva field is big enough
 			 */
@@ -9632,6 +10181,10 @@ field_access_end:
 				MonoInst *iargs [3];
 				int add_reg = alloc_ireg_mp (cfg);
 
+				/* The memcpy overwrites every element, initialize_array_data () only handles primitive types */
+				if (ins->opcode == OP_NEWARR && data_size > mono_gc_get_los_limit ())
+					ins->flags |= MONO_INST_UNINIT;
+
 				EMIT_NEW_BIALU_IMM (cfg, iargs [0], OP_PADD_IMM, add_reg, ins->dreg, MONO_STRUCT_OFFSET (MonoArray, vector));
 				if (cfg->compile_aot) {
 					EMIT_NEW_AOTCONST_TOKEN (cfg, iargs [1], MONO_PATCH_INFO_RVA, m_class_get_image (method->klass), GPOINTER_TO_UINT(field_token), STACK_PTR, NULL);
@@ -11128,7 +11681,8 @@ mono_ldptr:
 	/* Add a sequence point for method entry/exit events */
 	if (seq_points && cfg->gen_sdb_seq_points) {
 		NEW_SEQ_POINT (cfg, ins, METHOD_ENTRY_IL_OFFSET, FALSE);
-		MONO_ADD_INS (init_localsbb, ins);
+		/* The profiler enter event might have split init_localsbb */
+		MONO_ADD_INS (cfg->cbb, ins);
 		NEW_SEQ_POINT (cfg, ins, METHOD_EXIT_IL_OFFSET, FALSE);
 		MONO_ADD_INS (cfg->bb_exit, ins);
 	}
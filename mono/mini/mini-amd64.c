@@ -3180,6 +3180,94 @@ emit_call (MonoCompile *cfg, MonoCallInst *call, guint8 *code, MonoJitICallId ji
 	return code;
 }
 
+/* Deeper slots are rare, and their fast path wouldn't fit into 8 bit branches */
+#define MAX_INLINE_RGCTX_FETCH_DEPTH 4
+
+/*
+ * emit_inline_rgctx_fetch:
+ *
+ *   If CALL calls the lazy fetch trampoline of an rgctx slot, emit the fast path of
+ * the trampoline in front of it, so slots which are already filled are loaded without
+ * a call. Returns the branch which needs to be patched to skip the call, or NULL.
+ * The rgctx is in the first argument register, and RAX is clobbered by the call anyway.
+ */
+static guint8*
+emit_inline_rgctx_fetch (MonoCompile *cfg, MonoCallInst *call, guint8 **code_ptr)
+{
+	MonoJumpInfo *jinfo;
+	MonoJumpInfoRgctxEntry *entry;
+	guint8 *code = *code_ptr;
+	guint8 *null_jumps [MAX_INLINE_RGCTX_FETCH_DEPTH + 2];
+	guint8 *done_jump;
+	int i, slot, depth, index, njumps = 0;
+	gboolean mrgctx;
+
+	if (cfg->compile_aot || !call->fptr_is_patch || !cfg->abs_patches)
+		return NULL;
+	jinfo = (MonoJumpInfo *)g_hash_table_lookup (cfg->abs_patches, call->fptr);
+	if (!jinfo || jinfo->type != MONO_PATCH_INFO_RGCTX_FETCH)
+		return NULL;
+	entry = jinfo->data.rgctx_entry;
+	/* The slot of these is only allocated when the patch is resolved */
+	switch (entry->data->type) {
+	case MONO_PATCH_INFO_CLASS:
+	case MONO_PATCH_INFO_METHOD:
+	case MONO_PATCH_INFO_METHODCONST:
+	case MONO_PATCH_INFO_FIELD:
+	case MONO_PATCH_INFO_SIGNATURE:
+		break;
+	default:
+		return NULL;
+	}
+
+	/* Same layout as in mono_arch_create_rgctx_lazy_fetch_trampoline () */
+	slot = mini_get_rgctx_entry_slot (entry);
+	mrgctx = MONO_RGCTX_SLOT_IS_MRGCTX (slot);
+	index = MONO_RGCTX_SLOT_INDEX (slot);
+	if (mrgctx)
+		index += MONO_SIZEOF_METHOD_RUNTIME_GENERIC_CONTEXT / sizeof (target_mgreg_t);
+	for (depth = 0; ; ++depth) {
+		int size = mono_class_rgctx_get_array_size (depth, mrgctx);
+
+		if (index < size - 1)
+			break;
+		index -= size - 1;
+	}
+	if (depth > MAX_INLINE_RGCTX_FETCH_DEPTH)
+		return NULL;
+
+	if (mrgctx) {
+		amd64_mov_reg_reg (code, AMD64_RAX, MONO_AMD64_ARG_REG1, 8);
+	} else {
+		amd64_mov_reg_membase (code, AMD64_RAX, MONO_AMD64_ARG_REG1, MONO_STRUCT_OFFSET (MonoVTable, runtime_generic_context), sizeof (target_mgreg_t));
+		amd64_test_reg_reg (code, AMD64_RAX, AMD64_RAX);
+		null_jumps [njumps ++] = code;
+		amd64_branch8 (code, X86_CC_Z, 0, FALSE);
+	}
+
+	for (i = 0; i < depth; ++i) {
+		if (mrgctx && i == 0)
+			amd64_mov_reg_membase (code, AMD64_RAX, AMD64_RAX, MONO_SIZEOF_METHOD_RUNTIME_GENERIC_CONTEXT, sizeof (target_mgreg_t));
+		else
+			amd64_mov_reg_membase (code, AMD64_RAX, AMD64_RAX, 0, sizeof (target_mgreg_t));
+		amd64_test_reg_reg (code, AMD64_RAX, AMD64_RAX);
+		null_jumps [njumps ++] = code;
+		amd64_branch8 (code, X86_CC_Z, 0, FALSE);
+	}
+
+	amd64_mov_reg_membase (code, AMD64_RAX, AMD64_RAX, sizeof (target_mgreg_t) * (index + 1), sizeof (target_mgreg_t));
+	amd64_test_reg_reg (code, AMD64_RAX, AMD64_RAX);
+	done_jump = code;
+	amd64_branch8 (code, X86_CC_NZ, 0, FALSE);
+
+	/* Empty slots take the call, which fills them */
+	for (i = 0; i < njumps; ++i)
+		amd64_patch (null_jumps [i], code);
+
+	*code_ptr = code;
+	return done_jump;
+}
+
 static int
 store_membase_imm_to_store_membase_reg (int opcode)
 {
@@ -4912,15 +5000,29 @@ mono_arch_output_basic_block (MonoCompile *cfg, MonoBasicBlock *bb)
 		case OP_LCALL:
 		case OP_VCALL:
 		case OP_VCALL2:
-		case OP_VOIDCALL:
+		case OP_VOIDCALL: {
+			guint8 *rgctx_fetch_done;
+
 			call = (MonoCallInst*)ins;
 
+			if (ins->opcode == OP_CALL) {
+				/* A load, test and branch per level */
+				max_len += 12 * (MAX_INLINE_RGCTX_FETCH_DEPTH + 2);
+				code = realloc_code (cfg, max_len);
+				rgctx_fetch_done = emit_inline_rgctx_fetch (cfg, call, &code);
+			} else {
+				rgctx_fetch_done = NULL;
+			}
+
 			code = amd64_handle_varargs_call (cfg, code, call, FALSE);
 			code = emit_call (cfg, call, code, MONO_JIT_ICALL_ZeroIsReserved);
+			if (rgctx_fetch_done)
+				amd64_patch (rgctx_fetch_done, code);
 			ins->flags |= MONO_INST_GC_CALLSITE;
 			ins->backend.pc_offset = code - cfg->native_code;
 			code = emit_move_return_value (cfg, ins, code);
 			break;
+		}
 		case OP_FCALL_REG:
 		case OP_RCALL_REG:
 		case OP_LCALL_REG:
@@ -5570,6 +5672,18 @@ mono_arch_output_basic_block (MonoCompile *cfg, MonoBasicBlock *bb)
 			amd64_alu_reg_reg_size (code, X86_CMP, ins->sreg1, ins->sreg2, 4);
 			amd64_cmov_reg_size (code, X86_CC_LT, FALSE, ins->dreg, ins->sreg2, 4);
 			break;
+		case OP_POPCNT32:
+			amd64_popcnt_reg_reg_size (code, ins->dreg, ins->sreg1, 4);
+			break;
+		case OP_POPCNT64:
+			amd64_popcnt_reg_reg_size (code, ins->dreg, ins->sreg1, 8);
+			break;
+		case OP_LZCNT32:
+			amd64_lzcnt_reg_reg_size (code, ins->dreg, ins->sreg1, 4);
+			break;
+		case OP_LZCNT64:
+			amd64_lzcnt_reg_reg_size (code, ins->dreg, ins->sreg1, 8);
+			break;
 		case OP_LMIN:
 			g_assert (cfg->opt & MONO_OPT_CMOV);
 			g_assert (ins->dreg == ins->sreg1);
@@ -6784,6 +6898,11 @@ mono_arch_output_basic_block (MonoCompile *cfg, MonoBasicBlock *bb)
 			amd64_patch (br[0], code);
 			break;
 		}
+		case OP_GC_SAFE_POINT_PAGE:
+			amd64_mov_reg_imm (code, AMD64_R11, ins->inst_p0);
+			/* The faulting load has to be MONO_ARCH_SAFEPOINT_PAGE_POLL_SIZE bytes long */
+			amd64_mov_reg_membase (code, AMD64_R11, AMD64_R11, 0, 4);
+			break;
 
 		case OP_GC_LIVENESS_DEF:
 		case OP_GC_LIVENESS_USE:
@@ -390,6 +390,10 @@ typedef struct {
 
 #endif
 
+/* JIT code polls the safepoint page with mov r11d, [r11], see OP_GC_SAFE_POINT_PAGE */
+#define MONO_ARCH_HAVE_SAFEPOINT_PAGE 1
+#define MONO_ARCH_SAFEPOINT_PAGE_POLL_SIZE 3
+
 #endif /* !HOST_WIN32 */
 
 #if !defined(__linux__)
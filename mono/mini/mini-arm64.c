@@ -25,6 +25,7 @@
 #include <mono/arch/arm64/arm64-codegen.h>
 #include <mono/utils/mono-mmap.h>
 #include <mono/utils/mono-memory-model.h>
+#include <mono/utils/mono-hwcap.h>
 #include <mono/metadata/abi-details.h>
 
 #include "interp/interp.h"
@@ -56,6 +57,9 @@ static gpointer bp_trampoline;
 
 static gboolean ios_abi;
 
+/* ARMv8.1 LSE atomics */
+static gboolean lse_supported;
+
 static __attribute__ ((__warn_unused_result__)) guint8* emit_load_regset (guint8 *code, guint64 regs, int basereg, int offset);
 
 const char*
@@ -244,6 +248,8 @@ mono_arch_init (void)
 #if defined(TARGET_IOS)
 	ios_abi = TRUE;
 #endif
+
+	lse_supported = mono_hwcap_arm64_has_lse;
 }
 
 void
@@ -3850,6 +3856,14 @@ mono_arch_output_basic_block (MonoCompile *cfg, MonoBasicBlock *bb)
 		case OP_ATOMIC_ADD_I4: {
 			guint8 *buf [16];
 
+			if (lse_supported && !cfg->compile_aot) {
+				/* ldadd returns the old value */
+				arm_ldaddalw (code, sreg2, ARMREG_IP0, sreg1);
+				arm_dmb (code, ARM_DMB_ISH);
+				arm_addx (code, dreg, ARMREG_IP0, sreg2);
+				break;
+			}
+
 			buf [0] = code;
 			arm_ldxrw (code, ARMREG_IP0, sreg1);
 			arm_addx (code, ARMREG_IP0, ARMREG_IP0, sreg2);
@@ -3863,6 +3877,13 @@ mono_arch_output_basic_block (MonoCompile *cfg, MonoBasicBlock *bb)
 		case OP_ATOMIC_ADD_I8: {
 			guint8 *buf [16];
 
+			if (lse_supported && !cfg->compile_aot) {
+				arm_ldaddalx (code, sreg2, ARMREG_IP0, sreg1);
+				arm_dmb (code, ARM_DMB_ISH);
+				arm_addx (code, dreg, ARMREG_IP0, sreg2);
+				break;
+			}
+
 			buf [0] = code;
 			arm_ldxrx (code, ARMREG_IP0, sreg1);
 			arm_addx (code, ARMREG_IP0, ARMREG_IP0, sreg2);
@@ -3876,6 +3897,13 @@ mono_arch_output_basic_block (MonoCompile *cfg, MonoBasicBlock *bb)
 		case OP_ATOMIC_EXCHANGE_I4: {
 			guint8 *buf [16];
 
+			if (lse_supported && !cfg->compile_aot) {
+				arm_swpalw (code, sreg2, ARMREG_IP0, sreg1);
+				arm_dmb (code, ARM_DMB_ISH);
+				arm_movx (code, dreg, ARMREG_IP0);
+				break;
+			}
+
 			buf [0] = code;
 			arm_ldxrw (code, ARMREG_IP0, sreg1);
 			arm_stlxrw (code, ARMREG_IP1, sreg2, sreg1);
@@ -3888,6 +3916,13 @@ mono_arch_output_basic_block (MonoCompile *cfg, MonoBasicBlock *bb)
 		case OP_ATOMIC_EXCHANGE_I8: {
 			guint8 *buf [16];
 
+			if (lse_supported && !cfg->compile_aot) {
+				arm_swpalx (code, sreg2, ARMREG_IP0, sreg1);
+				arm_dmb (code, ARM_DMB_ISH);
+				arm_movx (code, dreg, ARMREG_IP0);
+				break;
+			}
+
 			buf [0] = code;
 			arm_ldxrx (code, ARMREG_IP0, sreg1);
 			arm_stlxrx (code, ARMREG_IP1, sreg2, sreg1);
@@ -3901,6 +3936,15 @@ mono_arch_output_basic_block (MonoCompile *cfg, MonoBasicBlock *bb)
 			guint8 *buf [16];
 
 			/* sreg2 is the value, sreg3 is the comparand */
+			if (lse_supported && !cfg->compile_aot) {
+				/* cas overwrites the comparand with the old value */
+				arm_movx (code, ARMREG_IP0, ins->sreg3);
+				arm_casalw (code, ARMREG_IP0, sreg2, sreg1);
+				arm_dmb (code, ARM_DMB_ISH);
+				arm_movx (code, dreg, ARMREG_IP0);
+				break;
+			}
+
 			buf [0] = code;
 			arm_ldxrw (code, ARMREG_IP0, sreg1);
 			arm_cmpw (code, ARMREG_IP0, ins->sreg3);
@@ -3917,6 +3961,14 @@ mono_arch_output_basic_block (MonoCompile *cfg, MonoBasicBlock *bb)
 		case OP_ATOMIC_CAS_I8: {
 			guint8 *buf [16];
 
+			if (lse_supported && !cfg->compile_aot) {
+				arm_movx (code, ARMREG_IP0, ins->sreg3);
+				arm_casalx (code, ARMREG_IP0, sreg2, sreg1);
+				arm_dmb (code, ARM_DMB_ISH);
+				arm_movx (code, dreg, ARMREG_IP0);
+				break;
+			}
+
 			buf [0] = code;
 			arm_ldxrx (code, ARMREG_IP0, sreg1);
 			arm_cmpx (code, ARMREG_IP0, ins->sreg3);
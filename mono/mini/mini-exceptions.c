@@ -1714,11 +1714,52 @@ mono_summarize_managed_stack (MonoThreadSummary *out)
 	out->is_managed = (out->num_managed_frames != 0);
 }
 
+static gboolean
+summarize_frame_raw (StackFrameInfo *frame, MonoContext *ctx, gpointer data)
+{
+	if (frame->ji && frame->ji->is_trampoline)
+		return TRUE;
+
+	if (frame->ji && frame->ji->async)
+		return FALSE; // Keep unwinding
+
+	gboolean is_managed = (frame->type == FRAME_TYPE_MANAGED || frame->type == FRAME_TYPE_INTERP);
+	MonoMethod *method = NULL;
+	if (frame->ji && frame->type != FRAME_TYPE_TRAMPOLINE)
+		method = jinfo_get_method (frame->ji);
+
+	// Keep the raw IP, it is made portable when the summary is symbolized
+	return summarize_frame_internal (method, MONO_CONTEXT_GET_IP (ctx), frame->native_offset, -1, is_managed, data);
+}
+
+/*
+ * Walk the managed stack of the current thread from its signal handler for a
+ * raw summary. Unlike mono_summarize_managed_stack () this doesn't look up IL
+ * offsets or take any locks.
+ */
+static void
+mono_summarize_raw_managed_stack (MonoThreadSummary *out)
+{
+	MonoSummarizeUserData data;
+	memset (&data, 0, sizeof (MonoSummarizeUserData));
+	data.max_frames = MONO_MAX_SUMMARY_FRAMES;
+	data.frames = out->managed_frames;
+	data.hashes = &out->hashes;
+
+	mono_walk_stack_full (summarize_frame_raw, out->ctx, out->domain, out->jit_tls, out->lmf, MONO_UNWIND_SIGNAL_SAFE, &data, TRUE);
+	out->num_managed_frames = data.num_frames;
+
+	if (data.error != NULL)
+		out->error_msg = data.error;
+	out->is_managed = (out->num_managed_frames != 0);
+}
+
 // Always runs on the dumped thread
 static void 
 mono_summarize_unmanaged_stack (MonoThreadSummary *out)
 {
 	MONO_ARCH_CONTEXT_DEF
+	gboolean raw = mono_summarize_raw_budget () != 0;
 	// 
 	// Summarize unmanaged stack
 	// 
@@ -1731,6 +1772,12 @@ mono_summarize_unmanaged_stack (MonoThreadSummary *out)
 		intptr_t ip = frame_ips [i];
 		MonoFrameSummary *frame = &out->unmanaged_frames [i];
 
+		// dladdr takes a lock, raw summaries resolve modules from the process map later
+		if (raw) {
+			frame->unmanaged_data.ip = ip;
+			continue;
+		}
+
 		int success = mono_get_portable_ip (ip, &frame->unmanaged_data.ip, &frame->unmanaged_data.offset, &frame->unmanaged_data.module, (char *) frame->str_descr);
 		if (!success)
 			continue;
@@ -1753,6 +1800,9 @@ mono_summarize_unmanaged_stack (MonoThreadSummary *out)
 		MONO_INIT_CONTEXT_FROM_FUNC (out->ctx, mono_summarize_unmanaged_stack);
 	}
 
+	if (raw)
+		mono_summarize_raw_managed_stack (out);
+
 	return;
 }
 #endif
@@ -2084,40 +2134,45 @@ build_native_trace (MonoError *error)
 #endif
 }
 
-static void
-remove_wrappers_from_trace (GList **trace_ips_p)
-{
-	GList *trace_ips = *trace_ips_p;
-	GList *p = trace_ips;
-
-	/* jit info, generic info, ip */
-	while (p) {
-		MonoJitInfo *jinfo = (MonoJitInfo*) p->data;
-		GList *next_p = p->next->next->next;
-		/* FIXME Maybe remove more wrapper types */
-		if (jinfo->d.method->wrapper_type == MONO_WRAPPER_OTHER) {
-			trace_ips = g_list_delete_link (trace_ips, p->next->next);
-			trace_ips = g_list_delete_link (trace_ips, p->next);
-			trace_ips = g_list_delete_link (trace_ips, p);
-		}
-		p = next_p;
-	}
+static gboolean
+is_wrapper_trace_entry (GPtrArray *trace_ips, int i)
+{
+	/* ip, generic info, jit info */
+	MonoJitInfo *jinfo = (MonoJitInfo*)g_ptr_array_index (trace_ips, i + 2);
 
-	*trace_ips_p = trace_ips;
+	/* FIXME Maybe remove more wrapper types */
+	return jinfo->d.method->wrapper_type == MONO_WRAPPER_OTHER;
 }
 
-/* This can be called more than once on a MonoException. */
+/*
+ * This can be called more than once on a MonoException.
+ * TRACE_IPS holds TRACE_IP_ENTRY_SIZE words per frame, outermost frame last,
+ * so it can be copied into the managed array as is.
+ */
 static void
-setup_stack_trace (MonoException *mono_ex, GSList **dynamic_methods, GList *trace_ips, gboolean remove_wrappers)
+setup_stack_trace (MonoException *mono_ex, GSList **dynamic_methods, GPtrArray *trace_ips, gboolean remove_wrappers)
 {
 	if (mono_ex) {
-		GList *trace_ips_copy = g_list_copy (trace_ips);
-		if (remove_wrappers)
-			remove_wrappers_from_trace (&trace_ips_copy);
-		trace_ips_copy = g_list_reverse (trace_ips_copy);
 		ERROR_DECL (error);
-		MonoArray *ips_arr = mono_glist_to_array (trace_ips_copy, mono_defaults.int_class, error);
-		mono_error_assert_ok (error);
+		MonoArray *ips_arr = NULL;
+		int i, j, len = trace_ips->len;
+
+		if (remove_wrappers) {
+			for (i = 0; i < trace_ips->len; i += TRACE_IP_ENTRY_SIZE) {
+				if (is_wrapper_trace_entry (trace_ips, i))
+					len -= TRACE_IP_ENTRY_SIZE;
+			}
+		}
+		if (len) {
+			ips_arr = mono_array_new_checked (mono_domain_get (), mono_defaults.int_class, len, error);
+			mono_error_assert_ok (error);
+			for (i = 0, j = 0; i < trace_ips->len; i += TRACE_IP_ENTRY_SIZE) {
+				if (remove_wrappers && is_wrapper_trace_entry (trace_ips, i))
+					continue;
+				memcpy (mono_array_addr_internal (ips_arr, gpointer, j), &g_ptr_array_index (trace_ips, i), TRACE_IP_ENTRY_SIZE * sizeof (gpointer));
+				j += TRACE_IP_ENTRY_SIZE;
+			}
+		}
 		MONO_OBJECT_SETREF_INTERNAL (mono_ex, trace_ips, ips_arr);
 		MONO_OBJECT_SETREF_INTERNAL (mono_ex, native_trace_ips, build_native_trace (error));
 		mono_error_assert_ok (error);
@@ -2149,8 +2204,6 @@ setup_stack_trace (MonoException *mono_ex, GSList **dynamic_methods, GList *trac
 			g_slist_free (*dynamic_methods);
 			*dynamic_methods = NULL;
 		}
-
-		g_list_free (trace_ips_copy);
 	}
 }
 
@@ -2180,7 +2233,7 @@ handle_exception_first_pass (MonoContext *ctx, MonoObject *obj, gint32 *out_filt
 	static int (*call_filter) (MonoContext *, gpointer) = NULL;
 	MonoJitTlsData *jit_tls = mono_tls_get_jit_tls ();
 	MonoLMF *lmf = mono_get_lmf ();
-	GList *trace_ips = NULL;
+	GPtrArray *trace_ips = g_ptr_array_sized_new (16 * TRACE_IP_ENTRY_SIZE);
 	GSList *dynamic_methods = NULL;
 	MonoException *mono_ex;
 	gboolean stack_overflow = FALSE;
@@ -2209,12 +2262,8 @@ handle_exception_first_pass (MonoContext *ctx, MonoObject *obj, gint32 *out_filt
 		if (!mono_ex->caught_in_unmanaged)
 			len -= 1;
 
-		for (i = 0; i < len; i++) {
-			for (int j = 0; j < TRACE_IP_ENTRY_SIZE; ++j) {
-				gpointer p = mono_array_get_internal (initial_trace_ips, gpointer, (i * TRACE_IP_ENTRY_SIZE) + j);
-				trace_ips = g_list_prepend (trace_ips, p);
-			}
-		}
+		for (i = 0; i < len * TRACE_IP_ENTRY_SIZE; i++)
+			g_ptr_array_add (trace_ips, mono_array_get_internal (initial_trace_ips, gpointer, i));
 	}
 
 	// Reset the state because we're making it be caught somewhere
@@ -2257,7 +2306,7 @@ handle_exception_first_pass (MonoContext *ctx, MonoObject *obj, gint32 *out_filt
 		unwind_res = unwinder_unwind_frame (&unwinder, domain, jit_tls, NULL, ctx, &new_ctx, NULL, &lmf, NULL, &frame);
 		if (!unwind_res) {
 			setup_stack_trace (mono_ex, &dynamic_methods, trace_ips, FALSE);
-			g_list_free (trace_ips);
+			g_ptr_array_free (trace_ips, TRUE);
 			return result;
 		}
 
@@ -2299,9 +2348,9 @@ handle_exception_first_pass (MonoContext *ctx, MonoObject *obj, gint32 *out_filt
 		if (method->wrapper_type != MONO_WRAPPER_RUNTIME_INVOKE && mono_ex) {
 			// avoid giant stack traces during a stack overflow
 			if (frame_count < 1000) {
-				trace_ips = g_list_prepend (trace_ips, ip);
-				trace_ips = g_list_prepend (trace_ips, get_generic_info_from_stack_frame (ji, ctx));
-				trace_ips = g_list_prepend (trace_ips, ji);
+				g_ptr_array_add (trace_ips, ip);
+				g_ptr_array_add (trace_ips, get_generic_info_from_stack_frame (ji, ctx));
+				g_ptr_array_add (trace_ips, ji);
 			}
 		}
 
@@ -2399,7 +2448,7 @@ handle_exception_first_pass (MonoContext *ctx, MonoObject *obj, gint32 *out_filt
 					filter_idx ++;
 
 					if (filtered) {
-						g_list_free (trace_ips);
+						g_ptr_array_free (trace_ips, TRUE);
 						/* mono_debugger_agent_handle_exception () needs this */
 						mini_set_abort_threshold (&frame);
 						MONO_CONTEXT_SET_IP (ctx, ei->handler_start);
@@ -2414,7 +2463,7 @@ handle_exception_first_pass (MonoContext *ctx, MonoObject *obj, gint32 *out_filt
 				if (ei->flags == MONO_EXCEPTION_CLAUSE_NONE && mono_object_isinst_checked (ex_obj, catch_class, error)) {
 					/* runtime invokes catch even unhandled exceptions */
 					setup_stack_trace (mono_ex, &dynamic_methods, trace_ips, method->wrapper_type != MONO_WRAPPER_RUNTIME_INVOKE);
-					g_list_free (trace_ips);
+					g_ptr_array_free (trace_ips, TRUE);
 
 					if (out_ji)
 						*out_ji = ji;
@@ -37,16 +37,24 @@ get_provenance_func (void)
 	return provenance;
 }
 
-#if 0
-//#if defined(MONO_ARCH_GC_MAPS_SUPPORTED)
+static void
+interp_stack_range_func (gpointer jit_tls_data, gpointer *start, gpointer *end)
+{
+	MonoJitTlsData *jit_tls = (MonoJitTlsData *)jit_tls_data;
+
+	*start = *end = NULL;
+	if (jit_tls && jit_tls->interp_context)
+		mini_get_interp_callbacks ()->get_stack_range (jit_tls->interp_context, start, end);
+}
+
+#if defined(MONO_ARCH_GC_MAPS_SUPPORTED)
 
-#include <mono/metadata/sgen-conf.h>
+#include <mono/sgen/sgen-conf.h>
 #include <mono/metadata/gc-internals.h>
 #include <mono/utils/mono-counters.h>
 #include <mono/utils/unlocked.h>
 
-//#define SIZEOF_SLOT ((int)sizeof (host_mgreg_t))
-//#define SIZEOF_SLOT ((int)sizeof (target_mgreg_t))
+#define SIZEOF_SLOT ((int)sizeof (target_mgreg_t))
 
 #define GC_BITS_PER_WORD (sizeof (mword) * 8)
 
@@ -715,9 +723,9 @@ get_frame_pointer (MonoContext *ctx, int frame_reg)
 {
 #if defined(TARGET_AMD64)
 		if (frame_reg == AMD64_RSP)
-			return ctx->rsp;
+			return (host_mgreg_t)MONO_CONTEXT_GET_SP (ctx);
 		else if (frame_reg == AMD64_RBP)
-			return ctx->rbp;
+			return (host_mgreg_t)MONO_CONTEXT_GET_BP (ctx);
 #elif defined(TARGET_X86)
 		if (frame_reg == X86_ESP)
 			return ctx->esp;
@@ -961,7 +969,7 @@ conservative_pass (TlsData *tls, guint8 *stack_start, guint8 *stack_end)
 		/* Decode the encoded GC map */
 		map = &map_tmp;
 		memset (map, 0, sizeof (GCMap));
-		decode_gc_map (&emap->encoded [0], map, &p);
+		decode_gc_map (emap->encoded, map, &p);
 		p = (guint8*)ALIGN_TO (p, map->callsite_entry_size);
 		map->callsites.offsets8 = p;
 		p += map->callsite_entry_size * map->ncallsites;
@@ -1616,7 +1624,7 @@ get_vtype_bitmap (MonoType *t, int *numbits)
 {
 	MonoClass *klass = mono_class_from_mono_type_internal (t);
 
-	if (klass->generic_container || mono_class_is_open_constructed_type (t)) {
+	if (mono_class_is_gtd (klass) || mono_class_is_open_constructed_type (t)) {
 		/* FIXME: Generic sharing */
 		return NULL;
 	} else {
@@ -2429,7 +2437,7 @@ create_map (MonoCompile *cfg)
 		//emap->ref_slots = map->ref_slots;
 
 		/* Encoded fixed fields */
-		p = &emap->encoded [0];
+		p = emap->encoded;
 		//emap->encoded_size = encoded_size;
 		memcpy (p, buf, encoded_size);
 		p += encoded_size;
@@ -2514,7 +2522,7 @@ static void
 parse_debug_options (void)
 {
 	char **opts, **ptr;
-	const char *env;
+	char *env;
 
 	env = g_getenv ("MONO_GCMAP_DEBUG");
 	if (!env)
@@ -2536,12 +2544,20 @@ mini_gc_init (void)
 	MonoGCCallbacks cb;
 
 	memset (&cb, 0, sizeof (cb));
-	cb.thread_attach_func = thread_attach_func;
-	cb.thread_detach_func = thread_detach_func;
-	cb.thread_suspend_func = thread_suspend_func;
-	/* Comment this out to disable precise stack marking */
-	cb.thread_mark_func = thread_mark_func;
+	/*
+	 * The stack walks done by these are only worth it if the GC is going to
+	 * make use of them.  Frames without GC maps, like native frames or AOT
+	 * code compiled without the 'gc-maps' option, are still scanned
+	 * conservatively by conservative_pass ().
+	 */
+	if (mono_gc_precise_stack_mark_enabled ()) {
+		cb.thread_attach_func = thread_attach_func;
+		cb.thread_detach_func = thread_detach_func;
+		cb.thread_suspend_func = thread_suspend_func;
+		cb.thread_mark_func = thread_mark_func;
+	}
 	cb.get_provenance_func = get_provenance_func;
+	cb.interp_stack_range_func = interp_stack_range_func;
 	mono_gc_set_gc_callbacks (&cb);
 
 	logfile = mono_gc_get_logfile ();
@@ -2604,6 +2620,7 @@ mini_gc_init (void)
 	MonoGCCallbacks cb;
 	memset (&cb, 0, sizeof (cb));
 	cb.get_provenance_func = get_provenance_func;
+	cb.interp_stack_range_func = interp_stack_range_func;
 	mono_gc_set_gc_callbacks (&cb);
 }
 
@@ -299,6 +299,10 @@ typedef enum {
 	INTRINS_POWF,
 	INTRINS_EXPECT_I8,
 	INTRINS_EXPECT_I1,
+	INTRINS_CTPOP_I32,
+	INTRINS_CTPOP_I64,
+	INTRINS_CTLZ_I32,
+	INTRINS_CTLZ_I64,
 #if defined(TARGET_AMD64) || defined(TARGET_X86)
 	INTRINS_SSE_PMOVMSKB,
 	INTRINS_SSE_PSRLI_W,
@@ -5828,6 +5832,26 @@ process_bb (EmitContext *ctx, MonoBasicBlock *bb)
 			values [ins->dreg] = LLVMBuildCall (builder, get_intrins (ctx, INTRINS_SQRTF), args, 1, dname);
 			break;
 		}
+		case OP_POPCNT32:
+		case OP_POPCNT64: {
+			LLVMValueRef args [1];
+			gboolean is_64 = ins->opcode == OP_POPCNT64;
+
+			args [0] = convert (ctx, lhs, is_64 ? LLVMInt64Type () : LLVMInt32Type ());
+			values [ins->dreg] = LLVMBuildCall (builder, get_intrins (ctx, is_64 ? INTRINS_CTPOP_I64 : INTRINS_CTPOP_I32), args, 1, dname);
+			break;
+		}
+		case OP_LZCNT32:
+		case OP_LZCNT64: {
+			LLVMValueRef args [2];
+			gboolean is_64 = ins->opcode == OP_LZCNT64;
+
+			args [0] = convert (ctx, lhs, is_64 ? LLVMInt64Type () : LLVMInt32Type ());
+			/* lzcnt is defined for 0 */
+			args [1] = LLVMConstInt (LLVMInt1Type (), 0, FALSE);
+			values [ins->dreg] = LLVMBuildCall (builder, get_intrins (ctx, is_64 ? INTRINS_CTLZ_I64 : INTRINS_CTLZ_I32), args, 2, dname);
+			break;
+		}
 		case OP_ABS: {
 			LLVMValueRef args [1];
 
@@ -8157,6 +8181,10 @@ static IntrinsicDesc intrinsics[] = {
 	{INTRINS_POWF, "llvm.pow.f32"},
 	{INTRINS_EXPECT_I8, "llvm.expect.i8"},
 	{INTRINS_EXPECT_I1, "llvm.expect.i1"},
+	{INTRINS_CTPOP_I32, "llvm.ctpop.i32"},
+	{INTRINS_CTPOP_I64, "llvm.ctpop.i64"},
+	{INTRINS_CTLZ_I32, "llvm.ctlz.i32"},
+	{INTRINS_CTLZ_I64, "llvm.ctlz.i64"},
 #if defined(TARGET_AMD64) || defined(TARGET_X86)
 	{INTRINS_SSE_PMOVMSKB, "llvm.x86.sse2.pmovmskb.128"},
 	{INTRINS_SSE_PSRLI_W, "llvm.x86.sse2.psrli.w"},
@@ -8300,6 +8328,24 @@ add_intrinsic (LLVMModuleRef module, int id)
 	case INTRINS_EXPECT_I1:
 		AddFunc2 (module, name, LLVMInt1Type (), LLVMInt1Type (), LLVMInt1Type ());
 		break;
+	case INTRINS_CTPOP_I32: {
+		LLVMTypeRef params [] = { LLVMInt32Type () };
+
+		AddFunc (module, name, LLVMInt32Type (), params, 1);
+		break;
+	}
+	case INTRINS_CTPOP_I64: {
+		LLVMTypeRef params [] = { LLVMInt64Type () };
+
+		AddFunc (module, name, LLVMInt64Type (), params, 1);
+		break;
+	}
+	case INTRINS_CTLZ_I32:
+		AddFunc2 (module, name, LLVMInt32Type (), LLVMInt32Type (), LLVMInt1Type ());
+		break;
+	case INTRINS_CTLZ_I64:
+		AddFunc2 (module, name, LLVMInt64Type (), LLVMInt64Type (), LLVMInt1Type ());
+		break;
 #if defined(TARGET_AMD64) || defined(TARGET_X86)
 	case INTRINS_SSE_PMOVMSKB:
 		/* pmovmskb */
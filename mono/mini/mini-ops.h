@@ -674,6 +674,12 @@ MINI_OP(OP_LMAX, "long_max", LREG, LREG, LREG)
 MINI_OP(OP_RMAX,     "rmax", FREG, FREG, FREG)
 MINI_OP(OP_RPOW,     "rpow", FREG, FREG, FREG)
 
+/* Bit counting, only emitted when the hardware supports them */
+MINI_OP(OP_POPCNT32, "popcnt32", IREG, IREG, NONE)
+MINI_OP(OP_POPCNT64, "popcnt64", LREG, LREG, NONE)
+MINI_OP(OP_LZCNT32,  "lzcnt32", IREG, IREG, NONE)
+MINI_OP(OP_LZCNT64,  "lzcnt64", LREG, LREG, NONE)
+
 /* opcodes most architecture have */
 MINI_OP(OP_ADC,     "adc", IREG, IREG, IREG)
 MINI_OP(OP_ADC_IMM, "adc_imm", IREG, IREG, NONE)
@@ -1110,6 +1116,11 @@ MINI_OP(OP_GC_SPILL_SLOT_LIVENESS_DEF, "gc_spill_slot_liveness_def", NONE, NONE,
 MINI_OP(OP_GC_PARAM_SLOT_LIVENESS_DEF, "gc_param_slot_liveness_def", NONE, NONE, NONE)
 
 MINI_OP(OP_GC_SAFE_POINT, "gc_safe_point", NONE, IREG, NONE)
+/*
+ * Load from the page in inst_p0, which faults while a suspend is requested.
+ * See mono_threads_get_safepoint_page ().
+ */
+MINI_OP(OP_GC_SAFE_POINT_PAGE, "gc_safe_point_page", NONE, NONE, NONE)
 
 /*
  * Check if the class given by sreg1 was inited, if not, call
@@ -1013,7 +1013,9 @@ dump_native_stacktrace (const char *signal, MonoContext *mctx)
 			// So we dump to disk
 			if (!leave && !dump_for_merp) {
 				mono_summarize_timeline_phase_log (MonoSummaryCleanup);
-				mono_crash_dump (output, &hashes);
+				// Raw summaries are already on disk, and become json on the next run
+				if (output)
+					mono_crash_dump (output, &hashes);
 				mono_summarize_timeline_phase_log (MonoSummaryDone);
 				mono_summarize_toggle_assertions (FALSE);
 			}
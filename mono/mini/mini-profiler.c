@@ -73,17 +73,79 @@ can_encode_method_ref (MonoMethod *method)
 	return (method->wrapper_type == MONO_WRAPPER_DYNAMIC_METHOD);
 }
 
+static MonoInst*
+get_call_guard_var (MonoCompile *cfg)
+{
+	if (!cfg->prof_call_guard_var)
+		cfg->prof_call_guard_var = mono_compile_create_var (cfg, m_class_get_byval_arg (mono_defaults.int32_class), OP_LOCAL);
+	return cfg->prof_call_guard_var;
+}
+
+/*
+ * emit_call_guard_init:
+ *
+ *   Read the counts of installed enter and leave callbacks once per invocation.
+ * The enter and leave guards of an invocation test the same value, so they can't
+ * disagree when a profiler toggles its callbacks while the method runs.
+ */
+static void
+emit_call_guard_init (MonoCompile *cfg)
+{
+	MonoInst *ins, *enter_ins, *leave_ins;
+
+	ins = mini_emit_runtime_constant (cfg, MONO_PATCH_INFO_PROFILER_METHOD_ENTER_COUNT, NULL);
+	enter_ins = mini_emit_memory_load (cfg, m_class_get_byval_arg (mono_defaults.int32_class), ins, 0, 0);
+	ins = mini_emit_runtime_constant (cfg, MONO_PATCH_INFO_PROFILER_METHOD_LEAVE_COUNT, NULL);
+	leave_ins = mini_emit_memory_load (cfg, m_class_get_byval_arg (mono_defaults.int32_class), ins, 0, 0);
+	EMIT_NEW_BIALU (cfg, ins, OP_IOR, get_call_guard_var (cfg)->dreg, enter_ins->dreg, leave_ins->dreg);
+}
+
+/*
+ * emit_call_guard:
+ *
+ *   Branch to SKIP_BB when no profiler had an enter or leave callback installed
+ * when the method was entered. Methods instrumented for enter/leave events then
+ * only pay for a few loads and branches until a profiler turns the callbacks on
+ * at runtime.
+ */
+static void
+emit_call_guard (MonoCompile *cfg, MonoBasicBlock *skip_bb)
+{
+	MonoInst *ins;
+
+	EMIT_NEW_BIALU_IMM (cfg, ins, OP_ICOMPARE_IMM, -1, get_call_guard_var (cfg)->dreg, 0);
+	MONO_EMIT_NEW_BRANCH_BLOCK (cfg, OP_IBEQ, skip_bb);
+}
+
+/*
+ * mini_profiler_emit_enter:
+ *
+ *   Called with cfg->cbb set to the init bblock, at the end of the IR generation.
+ */
 void
 mini_profiler_emit_enter (MonoCompile *cfg)
 {
 	gboolean trace = mono_jit_trace_calls != NULL && mono_trace_eval (cfg->method);
 
+	/* The leave guards need the value even when the enter event isn't instrumented */
+	if (cfg->prof_call_guard_var)
+		emit_call_guard_init (cfg);
+
 	if ((!MONO_CFG_PROFILE (cfg, ENTER) || cfg->current_method != cfg->method || (cfg->compile_aot && !can_encode_method_ref (cfg->method))) && !trace)
 		return;
 
 	if (cfg->current_method != cfg->method)
 		return;
 
+	MonoBasicBlock *init_bb = cfg->cbb, *next_bb = cfg->cbb->next_bb, *skip_bb = NULL;
+
+	if (!trace) {
+		if (!cfg->prof_call_guard_var)
+			emit_call_guard_init (cfg);
+		NEW_BBLOCK (cfg, skip_bb);
+		emit_call_guard (cfg, skip_bb);
+	}
+
 	MonoInst *iargs [2];
 
 	EMIT_NEW_METHODCONST (cfg, iargs [0], cfg->method);
@@ -98,6 +160,14 @@ mini_profiler_emit_enter (MonoCompile *cfg)
 		mono_emit_jit_icall (cfg, mono_trace_enter_method, iargs);
 	else
 		mono_emit_jit_icall (cfg, mono_profiler_raise_method_enter, iargs);
+
+	if (skip_bb) {
+		/* The init bblock fell through to the method body, continue from SKIP_BB instead */
+		MONO_START_BB (cfg, skip_bb);
+		skip_bb->next_bb = next_bb;
+		mono_unlink_bblock (cfg, init_bb, next_bb);
+		mono_link_bblock (cfg, skip_bb, next_bb);
+	}
 }
 
 void
@@ -108,6 +178,13 @@ mini_profiler_emit_leave (MonoCompile *cfg, MonoInst *ret)
 	if (!MONO_CFG_PROFILE (cfg, LEAVE) || cfg->current_method != cfg->method || (cfg->compile_aot && !can_encode_method_ref (cfg->method)))
 		return;
 
+	MonoBasicBlock *skip_bb = NULL;
+
+	if (!trace) {
+		NEW_BBLOCK (cfg, skip_bb);
+		emit_call_guard (cfg, skip_bb);
+	}
+
 	MonoInst *iargs [2];
 
 	EMIT_NEW_METHODCONST (cfg, iargs [0], cfg->method);
@@ -122,6 +199,9 @@ mini_profiler_emit_leave (MonoCompile *cfg, MonoInst *ret)
 		mono_emit_jit_icall (cfg, mono_trace_leave_method, iargs);
 	else
 		mono_emit_jit_icall (cfg, mono_profiler_raise_method_leave, iargs);
+
+	if (skip_bb)
+		MONO_START_BB (cfg, skip_bb);
 }
 
 void
@@ -26,6 +26,13 @@
 #ifdef HAVE_SIGNAL_H
 #include <signal.h>
 #endif
+#ifdef __linux__
+/* For the perf jitdump support */
+#include <elf.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/mman.h>
+#endif
 
 #include <mono/utils/memcheck.h>
 
@@ -45,6 +52,7 @@
 #include <mono/metadata/mono-config.h>
 #include <mono/metadata/environment.h>
 #include <mono/metadata/mono-debug.h>
+#include <mono/metadata/debug-internals.h>
 #include <mono/metadata/gc-internals.h>
 #include <mono/metadata/threads-types.h>
 #include <mono/metadata/mempool-internals.h>
@@ -54,6 +62,7 @@
 #include <mono/metadata/monitor.h>
 #include <mono/metadata/icall-internals.h>
 #include <mono/metadata/loader-internals.h>
+#include <mono/metadata/image-internals.h>
 #define MONO_MATH_DECLARE_ALL 1
 #include <mono/utils/mono-math.h>
 #include <mono/utils/mono-compiler.h>
@@ -71,6 +80,9 @@
 #include <mono/utils/checked-build.h>
 #include <mono/utils/mono-compiler.h>
 #include <mono/utils/mono-proclib.h>
+#include <mono/utils/mono-state.h>
+#include <mono/utils/mono-time.h>
+#include <mono/utils/w32api.h>
 #include <mono/metadata/w32handle.h>
 #include <mono/metadata/threadpool.h>
 
@@ -128,6 +140,20 @@ gboolean mono_use_llvm = FALSE;
 gboolean mono_use_interpreter = FALSE;
 const char *mono_interp_opts_string = NULL;
 
+/* Whenever methods are compiled at tier 0 first, see mini_tier_up () */
+gboolean mono_tiered_compilation = FALSE;
+int mono_tier_up_threshold = 1000;
+/* Whenever hot methods are recompiled using LLVM, the rest of the code is compiled by the JIT */
+gboolean mono_tier_up_llvm = FALSE;
+/* Threads recompiling hot methods in the background, 0 to do it on the thread that got them hot */
+int mono_jit_worker_threads = 1;
+/* Instantiations whose gsharedvt AOT code was looked up this many times are JITted instead, 0 disables it */
+int mono_gsharedvt_specialize_threshold = 0;
+/* File the methods JITted at startup are recorded into, or precompiled from, see mini_startup_trace_start () */
+char *mono_jit_startup_trace_file = NULL;
+/* How long after the start of Main () the JITted methods are recorded */
+int mono_jit_startup_trace_seconds = 10;
+
 #define mono_jit_lock() mono_os_mutex_lock (&jit_mutex)
 #define mono_jit_unlock() mono_os_mutex_unlock (&jit_mutex)
 static mono_mutex_t jit_mutex;
@@ -947,7 +973,9 @@ free_jit_tls_data (MonoJitTlsData *jit_tls)
 	mono_free_altstack (jit_tls);
 
 	g_free (jit_tls->first_lmf);
-	g_free (jit_tls->interp_context);
+	if (jit_tls->interp_context)
+		mini_get_interp_callbacks ()->free_context (jit_tls->interp_context);
+	mono_unwind_cache_free (jit_tls->unwind_cache);
 	g_free (jit_tls);
 }
 
@@ -1239,6 +1267,8 @@ mono_patch_info_hash (gconstpointer data)
 	case MONO_PATCH_INFO_AOT_MODULE:
 	case MONO_PATCH_INFO_PROFILER_ALLOCATION_COUNT:
 	case MONO_PATCH_INFO_PROFILER_CLAUSE_COUNT:
+	case MONO_PATCH_INFO_PROFILER_METHOD_ENTER_COUNT:
+	case MONO_PATCH_INFO_PROFILER_METHOD_LEAVE_COUNT:
 		return hash;
 	case MONO_PATCH_INFO_SPECIFIC_TRAMPOLINE_LAZY_FETCH_ADDR:
 		return hash | ji->data.uindex;
@@ -1649,6 +1679,14 @@ mono_resolve_patch_target (MonoMethod *method, MonoDomain *domain, guint8 *code,
 		target = (gpointer) &mono_profiler_state.exception_clause_count;
 		break;
 	}
+	case MONO_PATCH_INFO_PROFILER_METHOD_ENTER_COUNT: {
+		target = (gpointer) &mono_profiler_state.method_enter_count;
+		break;
+	}
+	case MONO_PATCH_INFO_PROFILER_METHOD_LEAVE_COUNT: {
+		target = (gpointer) &mono_profiler_state.method_leave_count;
+		break;
+	}
 	default:
 		g_assert_not_reached ();
 	}
@@ -1854,6 +1892,266 @@ mini_get_class (MonoMethod *method, guint32 token, MonoGenericContext *context)
 #if ENABLE_JIT_MAP
 static FILE* perf_map_file;
 
+/*
+ * Support for the perf jitdump format, see tools/perf/Documentation/jitdump-specification.txt
+ * in the linux tree. Unlike the map file, it carries the code bytes and the line info, so
+ * 'perf inject --jit' can build an ELF image for every method and annotate it.
+ */
+#define JITDUMP_MAGIC 0x4A695444
+#define JITDUMP_VERSION 1
+#define JITDUMP_BUFFER_SIZE (256 * 1024)
+
+enum {
+	JIT_CODE_LOAD = 0,
+	JIT_CODE_MOVE = 1,
+	JIT_CODE_DEBUG_INFO = 2,
+	JIT_CODE_CLOSE = 3
+};
+
+typedef struct {
+	guint32 magic;
+	guint32 version;
+	guint32 total_size;
+	guint32 elf_mach;
+	guint32 pad1;
+	guint32 pid;
+	guint64 timestamp;
+	guint64 flags;
+} JitdumpFileHeader;
+
+typedef struct {
+	guint32 id;
+	guint32 total_size;
+	guint64 timestamp;
+} JitdumpRecordHeader;
+
+typedef struct {
+	JitdumpRecordHeader header;
+	guint32 pid;
+	guint32 tid;
+	guint64 vma;
+	guint64 code_addr;
+	guint64 code_size;
+	guint64 code_index;
+	/* Followed by the NUL terminated name and the code bytes */
+} JitdumpCodeLoad;
+
+typedef struct {
+	JitdumpRecordHeader header;
+	guint64 code_addr;
+	guint64 nr_entry;
+	/* Followed by nr_entry JitdumpDebugEntry */
+} JitdumpDebugInfo;
+
+typedef struct {
+	guint64 addr;
+	guint32 line;
+	guint32 discrim;
+	/* Followed by the NUL terminated file name */
+} JitdumpDebugEntry;
+
+static FILE *jitdump_file;
+static void *jitdump_marker;
+static guint64 jitdump_code_index;
+static mono_mutex_t jitdump_mutex;
+
+static guint64
+jitdump_timestamp (void)
+{
+	struct timespec ts;
+
+	/* perf record -k mono */
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return (guint64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static guint32
+jitdump_elf_mach (void)
+{
+#if defined(TARGET_AMD64)
+	return EM_X86_64;
+#elif defined(TARGET_X86)
+	return EM_386;
+#elif defined(TARGET_ARM64)
+	return EM_AARCH64;
+#elif defined(TARGET_ARM)
+	return EM_ARM;
+#elif defined(TARGET_POWERPC)
+	return TARGET_SIZEOF_VOID_P == 8 ? EM_PPC64 : EM_PPC;
+#elif defined(TARGET_S390X)
+	return EM_S390;
+#elif defined(TARGET_MIPS)
+	return EM_MIPS;
+#else
+	return EM_NONE;
+#endif
+}
+
+void
+mono_enable_jitdump (void)
+{
+	JitdumpFileHeader header;
+	char name [64];
+	long page_size;
+	int fd;
+
+	if (jitdump_file)
+		return;
+
+	g_snprintf (name, sizeof (name), "/tmp/jit-%d.dump", getpid ());
+	unlink (name);
+	fd = open (name, O_CREAT | O_TRUNC | O_RDWR, 0666);
+	if (fd == -1)
+		return;
+
+	/* perf record finds the file through this executable mapping */
+	page_size = sysconf (_SC_PAGESIZE);
+	jitdump_marker = mmap (NULL, page_size, PROT_READ | PROT_EXEC, MAP_PRIVATE, fd, 0);
+	if (jitdump_marker == MAP_FAILED) {
+		jitdump_marker = NULL;
+		close (fd);
+		return;
+	}
+
+	jitdump_file = fdopen (fd, "w");
+	if (!jitdump_file) {
+		munmap (jitdump_marker, page_size);
+		jitdump_marker = NULL;
+		close (fd);
+		return;
+	}
+	/* Records are written from the JIT threads, keep them off the syscall path */
+	setvbuf (jitdump_file, NULL, _IOFBF, JITDUMP_BUFFER_SIZE);
+
+	mono_os_mutex_init (&jitdump_mutex);
+
+	memset (&header, 0, sizeof (header));
+	header.magic = JITDUMP_MAGIC;
+	header.version = JITDUMP_VERSION;
+	header.total_size = sizeof (header);
+	header.elf_mach = jitdump_elf_mach ();
+	header.pid = getpid ();
+	header.timestamp = jitdump_timestamp ();
+	fwrite (&header, sizeof (header), 1, jitdump_file);
+}
+
+/*
+ * jitdump_emit_debug_info:
+ *
+ *   Write the line number table of @jinfo, it has to precede the JIT_CODE_LOAD record
+ * of the method. Only available when the debugger support is enabled with --debug.
+ */
+static void
+jitdump_emit_debug_info (MonoJitInfo *jinfo, MonoMethod *method)
+{
+	MonoDebugMethodInfo *minfo;
+	MonoDebugMethodJitInfo *jit;
+	MonoDebugSourceLocation **locs;
+	JitdumpDebugInfo rec;
+	JitdumpDebugEntry entry;
+	guint32 total_size, nr_entry = 0;
+	int i;
+
+	if (!mono_debug_enabled ())
+		return;
+	minfo = mono_debug_lookup_method (method);
+	if (!minfo)
+		return;
+	jit = mono_debug_find_method (method, mono_domain_get ());
+	if (!jit)
+		return;
+
+	locs = g_new0 (MonoDebugSourceLocation*, jit->num_line_numbers);
+	total_size = sizeof (rec);
+	for (i = 0; i < jit->num_line_numbers; ++i) {
+		MonoDebugSourceLocation *loc = mono_debug_method_lookup_location (minfo, jit->line_numbers [i].il_offset);
+		if (!loc)
+			continue;
+		if (!loc->source_file) {
+			mono_debug_free_source_location (loc);
+			continue;
+		}
+		locs [i] = loc;
+		total_size += sizeof (entry) + strlen (loc->source_file) + 1;
+		nr_entry ++;
+	}
+
+	if (nr_entry) {
+		memset (&rec, 0, sizeof (rec));
+		rec.header.id = JIT_CODE_DEBUG_INFO;
+		rec.header.total_size = total_size;
+		rec.header.timestamp = jitdump_timestamp ();
+		rec.code_addr = (guint64)(gsize)jinfo->code_start;
+		rec.nr_entry = nr_entry;
+		fwrite (&rec, sizeof (rec), 1, jitdump_file);
+
+		for (i = 0; i < jit->num_line_numbers; ++i) {
+			if (!locs [i])
+				continue;
+			entry.addr = (guint64)(gsize)jinfo->code_start + jit->line_numbers [i].native_offset;
+			entry.line = locs [i]->row;
+			entry.discrim = 0;
+			fwrite (&entry, sizeof (entry), 1, jitdump_file);
+			fwrite (locs [i]->source_file, strlen (locs [i]->source_file) + 1, 1, jitdump_file);
+		}
+	}
+
+	for (i = 0; i < jit->num_line_numbers; ++i) {
+		if (locs [i])
+			mono_debug_free_source_location (locs [i]);
+	}
+	g_free (locs);
+	mono_debug_free_method_jit_info (jit);
+}
+
+/* Needs jitdump_mutex, and jitdump_file to be checked after taking it */
+static void
+jitdump_emit_code_load (void *start, int size, const char *desc)
+{
+	JitdumpCodeLoad rec;
+	size_t name_len = strlen (desc) + 1;
+
+	memset (&rec, 0, sizeof (rec));
+	rec.header.id = JIT_CODE_LOAD;
+	rec.header.total_size = sizeof (rec) + name_len + size;
+	rec.header.timestamp = jitdump_timestamp ();
+	rec.pid = getpid ();
+	rec.tid = (guint32)mono_native_thread_os_id_get ();
+	rec.vma = (guint64)(gsize)start;
+	rec.code_addr = (guint64)(gsize)start;
+	rec.code_size = size;
+	rec.code_index = jitdump_code_index ++;
+
+	fwrite (&rec, sizeof (rec), 1, jitdump_file);
+	fwrite (desc, name_len, 1, jitdump_file);
+	fwrite (start, size, 1, jitdump_file);
+}
+
+static void
+jitdump_close (void)
+{
+	JitdumpRecordHeader rec;
+
+	if (!jitdump_file)
+		return;
+
+	mono_os_mutex_lock (&jitdump_mutex);
+	if (!jitdump_file) {
+		mono_os_mutex_unlock (&jitdump_mutex);
+		return;
+	}
+	memset (&rec, 0, sizeof (rec));
+	rec.id = JIT_CODE_CLOSE;
+	rec.total_size = sizeof (rec);
+	rec.timestamp = jitdump_timestamp ();
+	fwrite (&rec, sizeof (rec), 1, jitdump_file);
+	fclose (jitdump_file);
+	jitdump_file = NULL;
+	munmap (jitdump_marker, sysconf (_SC_PAGESIZE));
+	jitdump_marker = NULL;
+	mono_os_mutex_unlock (&jitdump_mutex);
+}
+
 void
 mono_enable_jit_map (void)
 {
@@ -1870,14 +2168,31 @@ mono_emit_jit_tramp (void *start, int size, const char *desc)
 {
 	if (perf_map_file)
 		fprintf (perf_map_file, "%llx %x %s\n", (long long unsigned int)(gsize)start, size, desc);
+	if (jitdump_file) {
+		mono_os_mutex_lock (&jitdump_mutex);
+		/* jitdump_close () could have run since the check above */
+		if (jitdump_file)
+			jitdump_emit_code_load (start, size, desc);
+		mono_os_mutex_unlock (&jitdump_mutex);
+	}
 }
 
 void
 mono_emit_jit_map (MonoJitInfo *jinfo)
 {
-	if (perf_map_file) {
-		char *name = mono_method_full_name (jinfo_get_method (jinfo), TRUE);
-		mono_emit_jit_tramp (jinfo->code_start, jinfo->code_size, name);
+	if (perf_map_file || jitdump_file) {
+		MonoMethod *method = jinfo_get_method (jinfo);
+		char *name = mono_method_full_name (method, TRUE);
+		if (perf_map_file)
+			fprintf (perf_map_file, "%llx %x %s\n", (long long unsigned int)(gsize)jinfo->code_start, jinfo->code_size, name);
+		if (jitdump_file) {
+			mono_os_mutex_lock (&jitdump_mutex);
+			if (jitdump_file) {
+				jitdump_emit_debug_info (jinfo, method);
+				jitdump_emit_code_load (jinfo->code_start, jinfo->code_size, name);
+			}
+			mono_os_mutex_unlock (&jitdump_mutex);
+		}
 		g_free (name);
 	}
 }
@@ -1885,7 +2200,7 @@ mono_emit_jit_map (MonoJitInfo *jinfo)
 gboolean
 mono_jit_map_is_enabled (void)
 {
-	return perf_map_file != NULL;
+	return perf_map_file != NULL || jitdump_file != NULL;
 }
 
 #endif
@@ -2261,6 +2576,204 @@ compile_special (MonoMethod *method, MonoDomain *target_domain, MonoError *error
 	return NULL;
 }
 
+#ifdef MONO_USE_AOT_COMPILER
+/*
+ * gsharedvt_should_specialize:
+ *
+ *   Return whenever METHOD should be JITted into code specialized for its
+ * instantiation instead of running the gsharedvt AOT code at CODE. Every lookup
+ * of METHOD finding gsharedvt code counts as a use, since each new call site,
+ * vtable slot and delegate resolves it again. Those that are used often enough
+ * make up for the JIT time by avoiding the gsharedvt overhead.
+ */
+static gboolean
+gsharedvt_should_specialize (MonoDomain *domain, MonoMethod *method, gpointer code)
+{
+	MonoJitDomainInfo *info = domain_jit_info (domain);
+	MonoJitInfo *ji;
+	int count;
+
+	if (!mono_gsharedvt_specialize_threshold || mono_aot_only || !method->is_inflated)
+		return FALSE;
+
+	ji = mini_jit_info_table_find (domain, (char *)mono_get_addr_from_ftnptr (code), NULL);
+	if (!ji || !mini_jit_info_is_gsharedvt (ji))
+		return FALSE;
+
+	mono_domain_lock (domain);
+	if (!info->gsharedvt_lookup_hash)
+		info->gsharedvt_lookup_hash = g_hash_table_new (NULL, NULL);
+	count = GPOINTER_TO_INT (g_hash_table_lookup (info->gsharedvt_lookup_hash, method)) + 1;
+	g_hash_table_insert (info->gsharedvt_lookup_hash, method, GINT_TO_POINTER (count));
+	mono_domain_unlock (domain);
+
+	if (count < mono_gsharedvt_specialize_threshold)
+		return FALSE;
+	mono_atomic_inc_i32 (&mono_jit_stats.methods_gsharedvt_specialized);
+	return TRUE;
+}
+#endif
+
+/*
+ * Startup traces
+ *
+ * A trace lists the methods JITted in the root domain during the first seconds of a
+ * run, in order, one "<token> <image file name>" line each. If the trace file doesn't
+ * exist, it is recorded. Otherwise background threads compile the methods in it ahead
+ * of the main thread, which then finds their code already there. Delete the file to
+ * record it again.
+ */
+static FILE *startup_trace_out;
+static gint64 startup_trace_end;
+static char **startup_trace_lines;
+static gint32 startup_trace_nlines;
+static gint32 startup_trace_next;
+static gint32 startup_trace_precompiled;
+
+static void
+startup_trace_record (MonoMethod *method, MonoDomain *domain)
+{
+	MonoImage *image = m_class_get_image (method->klass);
+
+	if (method->wrapper_type != MONO_WRAPPER_NONE || method->is_inflated || !method->token)
+		return;
+	if (domain != mono_get_root_domain () || image_is_dynamic (image) || !image->filename)
+		return;
+
+	mono_jit_lock ();
+	if (startup_trace_out) {
+		if (mono_msec_ticks () < startup_trace_end) {
+			fprintf (startup_trace_out, "%08x %s\n", method->token, image->filename);
+		} else {
+			fclose (startup_trace_out);
+			startup_trace_out = NULL;
+		}
+	}
+	mono_jit_unlock ();
+}
+
+static void
+startup_trace_precompile (MonoDomain *domain, guint32 token, const char *filename)
+{
+	ERROR_DECL (error);
+	MonoImage *image;
+	MonoMethod *method;
+
+	/* Only precompile methods of assemblies the main thread already loaded */
+	image = mono_image_loaded_internal (mono_domain_default_alc (domain), filename, FALSE);
+	if (!image || !image->assembly)
+		return;
+
+	method = mono_get_method_checked (image, token, NULL, NULL, error);
+	if (!method) {
+		mono_error_cleanup (error);
+		return;
+	}
+	if (mono_class_is_gtd (method->klass) || method->is_generic)
+		return;
+	if (method->iflags & (METHOD_IMPL_ATTRIBUTE_INTERNAL_CALL | METHOD_IMPL_ATTRIBUTE_RUNTIME))
+		return;
+	if (method->flags & (METHOD_ATTRIBUTE_ABSTRACT | METHOD_ATTRIBUTE_PINVOKE_IMPL))
+		return;
+
+	if (lookup_method (domain, method))
+		return;
+	/* The main thread got there first, its code is used */
+	if (wait_or_register_method_to_compile (method, domain))
+		return;
+	/* Without running cctors: the code checks for them, so they still run on first use */
+	if (mono_jit_compile_method_inner (method, domain, mono_get_optimizations_for_method (method, default_opt), (JitFlags)0, error))
+		mono_atomic_inc_i32 (&startup_trace_precompiled);
+	unregister_method_for_compile (method, domain);
+	mono_error_cleanup (error);
+}
+
+static gsize WINAPI
+startup_trace_thread (gpointer arg)
+{
+	ERROR_DECL (error);
+	MonoInternalThread *internal = mono_thread_internal_current ();
+	MonoDomain *domain = mono_get_root_domain ();
+
+	MonoString *thread_name = mono_string_new_checked (domain, "JIT Startup", error);
+	mono_error_assert_ok (error);
+	mono_thread_set_name_internal (internal, thread_name, FALSE, FALSE, error);
+	mono_error_assert_ok (error);
+	/* Ask the runtime to not wait for this thread */
+	internal->state |= ThreadState_Background;
+
+	while (!mono_runtime_is_shutting_down ()) {
+		char *line, *filename;
+		guint32 token;
+		gint32 next;
+
+		next = mono_atomic_inc_i32 (&startup_trace_next) - 1;
+		if (next >= startup_trace_nlines)
+			break;
+		line = startup_trace_lines [next];
+
+		token = strtoul (line, &filename, 16);
+		if (*filename != ' ')
+			continue;
+		startup_trace_precompile (domain, token, filename + 1);
+	}
+
+	return 0;
+}
+
+/*
+ * mini_startup_trace_start:
+ *
+ *   Called before the entry point runs. Start recording the startup trace into
+ * mono_jit_startup_trace_file, or start precompiling the methods in it.
+ */
+void
+mini_startup_trace_start (void)
+{
+	char *contents;
+	int i, nthreads;
+
+	if (!mono_jit_startup_trace_file)
+		return;
+
+	if (!g_file_get_contents (mono_jit_startup_trace_file, &contents, NULL, NULL)) {
+		startup_trace_end = mono_msec_ticks () + (gint64)mono_jit_startup_trace_seconds * 1000;
+		/* Visible to the JIT once the lock is taken in startup_trace_record () */
+		mono_jit_lock ();
+		startup_trace_out = fopen (mono_jit_startup_trace_file, "w");
+		mono_jit_unlock ();
+		if (!startup_trace_out)
+			g_warning ("Could not create the startup trace file '%s'", mono_jit_startup_trace_file);
+		return;
+	}
+
+	startup_trace_lines = g_strsplit (contents, "\n", -1);
+	startup_trace_nlines = g_strv_length (startup_trace_lines);
+	g_free (contents);
+
+	mono_counters_register ("Startup trace methods precompiled", MONO_COUNTER_JIT | MONO_COUNTER_INT, &startup_trace_precompiled);
+
+	nthreads = MAX (mono_jit_worker_threads, 1);
+	for (i = 0; i < nthreads; ++i) {
+		ERROR_DECL (error);
+
+		mono_thread_create_internal (mono_get_root_domain (), (gpointer)startup_trace_thread, NULL, MONO_THREAD_CREATE_FLAGS_NONE, error);
+		/* The main thread just compiles the methods itself */
+		mono_error_cleanup (error);
+	}
+}
+
+static void
+startup_trace_cleanup (void)
+{
+	mono_jit_lock ();
+	if (startup_trace_out) {
+		fclose (startup_trace_out);
+		startup_trace_out = NULL;
+	}
+	mono_jit_unlock ();
+}
+
 static gpointer
 mono_jit_compile_method_with_opt (MonoMethod *method, guint32 opt, gboolean jit_only, MonoError *error)
 {
@@ -2336,7 +2849,7 @@ lookup_start:
 		if (! ((domain != target_domain) && !info->domain_neutral)) {
 			MonoVTable *vtable;
 
-			mono_atomic_inc_i32 (&mono_jit_stats.methods_lookups);
+			mono_sharded_counter_inc (&mono_jit_stats.methods_lookups);
 			vtable = mono_class_vtable_checked (domain, method->klass, error);
 			if (!is_ok (error))
 				return NULL;
@@ -2365,6 +2878,8 @@ lookup_start:
 		mono_class_init_internal (method->klass);
 
 		code = mono_aot_get_method (domain, method, error);
+		if (code && gsharedvt_should_specialize (domain, method, code))
+			code = NULL;
 		if (code) {
 			MonoVTable *vtable;
 
@@ -2430,8 +2945,10 @@ lookup_start:
 
 		if (wait_or_register_method_to_compile (method, target_domain))
 			goto lookup_start;
-		code = mono_jit_compile_method_inner (method, target_domain, opt, error);
+		code = mono_jit_compile_method_inner (method, target_domain, opt, JIT_FLAG_RUN_CCTORS, error);
 		unregister_method_for_compile (method, target_domain);
+		if (code && startup_trace_out)
+			startup_trace_record (method, target_domain);
 	}
 	if (!mono_error_ok (error))
 		return NULL;
@@ -2509,21 +3026,20 @@ invalidated_delegate_trampoline (char *desc)
 #endif
 
 /*
- * mono_jit_free_method:
+ * jit_free_method_code:
  *
- *  Free all memory allocated by the JIT for METHOD.
+ *  Free all memory allocated by the JIT for METHOD, a dynamic method, or, if
+ * ALC_METHOD is set, a method of a collectible AssemblyLoadContext whose code
+ * is allocated from the code manager of the context.
  */
 static void
-mono_jit_free_method (MonoDomain *domain, MonoMethod *method)
+jit_free_method_code (MonoDomain *domain, MonoMethod *method, gboolean alc_method)
 {
 	MonoJitDynamicMethodInfo *ji;
 	gboolean destroy = TRUE, removed;
-	GHashTableIter iter;
-	MonoJumpList *jlist;
+	GSList *l;
 	MonoJitDomainInfo *info = domain_jit_info (domain);
 
-	g_assert (method->dynamic);
-
 	if (mono_use_interpreter) {
 		mono_domain_jit_code_hash_lock (domain);
 		/* InterpMethod is allocated in the domain mempool. We might haven't
@@ -2545,10 +3061,18 @@ mono_jit_free_method (MonoDomain *domain, MonoMethod *method)
 	mono_domain_lock (domain);
 	g_hash_table_remove (info->dynamic_code_hash, method);
 	mono_domain_jit_code_hash_lock (domain);
-	removed = mono_internal_hash_table_remove (&domain->jit_code_hash, method);
-	g_assert (removed);
+	if (alc_method) {
+		/* Detached already, it might have been compiled into the domain again */
+		if (mono_internal_hash_table_lookup (&domain->jit_code_hash, method) == ji->ji)
+			mono_internal_hash_table_remove (&domain->jit_code_hash, method);
+	} else {
+		removed = mono_internal_hash_table_remove (&domain->jit_code_hash, method);
+		g_assert (removed);
+	}
 	mono_domain_jit_code_hash_unlock (domain);
 	g_hash_table_remove (info->jump_trampoline_hash, method);
+	if (ji->ji->seq_points)
+		g_hash_table_remove (info->seq_point_indexes, ji->ji->seq_points);
 	g_hash_table_remove (info->seq_points, method);
 
 	ji->ji->seq_points = NULL;
@@ -2556,11 +3080,20 @@ mono_jit_free_method (MonoDomain *domain, MonoMethod *method)
 	/* requires the domain lock - took above */
 	mono_conc_hashtable_remove (info->runtime_invoke_hash, method);
 
-	/* Remove jump targets in this method */
-	g_hash_table_iter_init (&iter, info->jump_target_hash);
-	while (g_hash_table_iter_next (&iter, NULL, (void**)&jlist)) {
+	/*
+	 * Remove jump targets in this method. Only the lists of the methods it jumps
+	 * to are searched, walking all of them made freeing a method O(methods).
+	 */
+	for (l = ji->jump_targets; l; l = l->next) {
+		MonoMethod *target = (MonoMethod *)l->data;
+		MonoMethod *shared_target = mini_method_to_shared (target);
+		MonoJumpList *jlist = (MonoJumpList *)g_hash_table_lookup (info->jump_target_hash, shared_target ? shared_target : target);
 		GSList *tmp, *remove;
 
+		/* Already patched and removed by mini_patch_jump_sites () */
+		if (!jlist)
+			continue;
+
 		remove = NULL;
 		for (tmp = jlist->list; tmp; tmp = tmp->next) {
 			guint8 *ip = (guint8 *)tmp->data;
@@ -2596,12 +3129,101 @@ mono_jit_free_method (MonoDomain *domain, MonoMethod *method)
 	 * same code address and replace our entry in the table.
 	 */
 	mono_jit_info_table_remove (domain, ji->ji);
+	mono_unwind_cache_invalidate ();
 
-	if (destroy)
+	/* The code of an ALC method is freed with the code manager of the context */
+	if (destroy && !alc_method)
 		mono_code_manager_destroy (ji->code_mp);
+	g_slist_free (ji->jump_targets);
 	g_free (ji);
 }
 
+/*
+ * mono_jit_free_method:
+ *
+ *  Free all memory allocated by the JIT for the dynamic method METHOD.
+ */
+static void
+mono_jit_free_method (MonoDomain *domain, MonoMethod *method)
+{
+	g_assert (method->dynamic);
+
+	jit_free_method_code (domain, method, FALSE);
+}
+
+#ifdef ENABLE_NETCORE
+static gboolean
+delegate_trampoline_info_in_alc (gpointer key, gpointer value, gpointer user_data)
+{
+	MonoClassMethodPair *pair = (MonoClassMethodPair *)key;
+	MonoAssemblyLoadContext *alc = (MonoAssemblyLoadContext *)user_data;
+
+	return mono_alc_owns_class (alc, pair->klass) || (pair->method && mono_alc_owns_method (alc, pair->method));
+}
+
+static gboolean
+mrgctx_in_alc (gpointer key, gpointer value, gpointer user_data)
+{
+	MonoMethodRuntimeGenericContext *mrgctx = (MonoMethodRuntimeGenericContext *)value;
+	MonoAssemblyLoadContext *alc = (MonoAssemblyLoadContext *)user_data;
+
+	return mono_alc_owns_class (alc, mrgctx->class_vtable->klass) || (mrgctx->method_inst && mono_alc_owns_generic_inst (alc, mrgctx->method_inst));
+}
+
+/*
+ * mono_jit_detach_alc_code:
+ *
+ *   Make the lookups of METHODS, whose code is allocated from the collectible
+ * context ALC, fail, so they are compiled again if they are called.  Drop the
+ * cached trampolines and generic contexts which can refer to the code of ALC.
+ * The code itself stays valid until the methods are freed by mono_jit_free_alc_method ().
+ * This can be called again for the same methods.
+ */
+static void
+mono_jit_detach_alc_code (MonoDomain *domain, MonoAssemblyLoadContext *alc, GPtrArray *methods)
+{
+	MonoJitDomainInfo *info = domain_jit_info (domain);
+	guint i;
+
+	mono_domain_lock (domain);
+	for (i = 0; i < methods->len; ++i) {
+		MonoMethod *method = (MonoMethod *)g_ptr_array_index (methods, i);
+		MonoJitDynamicMethodInfo *ji = mono_dynamic_code_hash_lookup (domain, method);
+
+		if (!ji || !ji->ji)
+			continue;
+
+		mono_domain_jit_code_hash_lock (domain);
+		if (mono_internal_hash_table_lookup (&domain->jit_code_hash, method) == ji->ji)
+			mono_internal_hash_table_remove (&domain->jit_code_hash, method);
+		mono_domain_jit_code_hash_unlock (domain);
+		mono_conc_hashtable_remove (info->runtime_invoke_hash, method);
+	}
+
+	g_hash_table_foreach_remove (info->delegate_trampoline_hash, delegate_trampoline_info_in_alc, alc);
+	if (info->mrgctx_hash)
+		g_hash_table_foreach_remove (info->mrgctx_hash, mrgctx_in_alc, alc);
+	if (info->method_rgctx_hash)
+		g_hash_table_foreach_remove (info->method_rgctx_hash, mrgctx_in_alc, alc);
+	mini_remove_alc_static_rgctx_trampolines (domain, alc);
+	mono_domain_unlock (domain);
+}
+
+/*
+ * mono_jit_free_alc_method:
+ *
+ *   Free the memory allocated by the JIT for METHOD, a method of a collectible
+ * context detached by mono_jit_detach_alc_code ().  The caller frees the code.
+ */
+static void
+mono_jit_free_alc_method (MonoDomain *domain, MonoMethod *method)
+{
+	g_assert (!method->dynamic);
+
+	jit_free_method_code (domain, method, TRUE);
+}
+#endif
+
 gpointer
 mono_jit_search_all_backends_for_jit_info (MonoDomain *domain, MonoMethod *method, MonoJitInfo **out_ji)
 {
@@ -2647,7 +3269,7 @@ mono_jit_find_compiled_method_with_jit_info (MonoDomain *domain, MonoMethod *met
 	if (info) {
 		/* We can't use a domain specific method in another domain */
 		if (! ((domain != target_domain) && !info->domain_neutral)) {
-			mono_atomic_inc_i32 (&mono_jit_stats.methods_lookups);
+			mono_sharded_counter_inc (&mono_jit_stats.methods_lookups);
 			if (ji)
 				*ji = info;
 			return info->code_start;
@@ -3270,6 +3892,40 @@ is_addr_implicit_null_check (void *addr)
 	return addr <= GUINT_TO_POINTER (mono_target_pagesize ());
 }
 
+#ifdef MONO_ARCH_HAVE_SAFEPOINT_PAGE
+static void
+safepoint_page_poll_from_signal (void)
+{
+	MonoJitTlsData *jit_tls = mono_tls_get_jit_tls ();
+	MonoContext ctx;
+
+	memcpy (&ctx, &jit_tls->safepoint_ctx, sizeof (MonoContext));
+	mono_threads_state_poll ();
+	mono_restore_context (&ctx);
+}
+
+/*
+ * handle_safepoint_page_fault:
+ *
+ *   A safepoint poll of JIT code faulted because a suspend is requested. Since running
+ * mono_threads_state_poll () inside the signal handler is not safe, make the thread
+ * continue in safepoint_page_poll_from_signal (), which resumes after the poll.
+ * OP_GC_SAFE_POINT_PAGE clobbers the caller saved registers, so the context is enough.
+ */
+static void
+handle_safepoint_page_fault (void *sigctx, MonoContext *mctx, MonoJitTlsData *jit_tls)
+{
+	MonoContext ctx;
+
+	memcpy (&ctx, mctx, sizeof (MonoContext));
+	MONO_CONTEXT_SET_IP (&ctx, (guint8*)MONO_CONTEXT_GET_IP (&ctx) + MONO_ARCH_SAFEPOINT_PAGE_POLL_SIZE);
+	memcpy (&jit_tls->safepoint_ctx, &ctx, sizeof (MonoContext));
+
+	mono_arch_setup_resume_sighandler_ctx (&ctx, (gpointer)safepoint_page_poll_from_signal);
+	mono_monoctx_to_sigctx (&ctx, sigctx);
+}
+#endif
+
 // This function is separate from mono_sigsegv_signal_handler
 // so debug_fault_addr can be seen in debugger stacks.
 #ifdef MONO_SIG_HANDLER_DEBUG
@@ -3311,6 +3967,12 @@ MONO_SIG_HANDLER_FUNC (, mono_sigsegv_signal_handler)
 		mono_aot_handle_pagefault (info->si_addr);
 		return;
 	}
+#ifdef MONO_ARCH_HAVE_SAFEPOINT_PAGE
+	if (jit_tls && mono_threads_is_safepoint_page (info->si_addr)) {
+		handle_safepoint_page_fault (ctx, &mctx, jit_tls);
+		return;
+	}
+#endif
 #endif
 
 	/* The thread might no be registered with the runtime */
@@ -3668,6 +4330,8 @@ mini_parse_debug_option (const char *option)
 		mini_debug_options.llvm_disable_inlining = TRUE;
 	else if (!strcmp (option, "explicit-null-checks"))
 		mini_debug_options.explicit_null_checks = TRUE;
+	else if (!strcmp (option, "aot-eager-binding"))
+		mini_debug_options.aot_eager_binding = TRUE;
 	else if (!strcmp (option, "gen-seq-points"))
 		mini_debug_options.gen_sdb_seq_points = TRUE;
 	else if (!strcmp (option, "gen-compact-seq-points"))
@@ -3707,6 +4371,10 @@ mini_parse_debug_option (const char *option)
 		mini_debug_options.clr_memory_model = TRUE;
 	else if (!strncmp (option, "thread-dump-dir=", 16))
 		mono_set_thread_dump_dir(g_strdup(option + 16));
+#ifndef DISABLE_CRASH_REPORTING
+	else if (!strncmp (option, "crash-summary-budget=", 21))
+		mono_summarize_set_raw_mode (atoi (option + 21));
+#endif
 	else if (!strncmp (option, "aot-skip=", 9)) {
 		mini_debug_options.aot_skip_set = TRUE;
 		mini_debug_options.aot_skip = atoi (option + 9);
@@ -3736,7 +4404,7 @@ mini_parse_debug_options (void)
 			// test-tailcall-require is also accepted but not documented.
 			// empty string is also accepted and ignored as a consequence
 			// of appending ",foo" without checking for empty.
-			fprintf (stderr, "Available options: 'handle-sigint', 'keep-delegates', 'reverse-pinvoke-exceptions', 'collect-pagefault-stats', 'break-on-unverified', 'no-gdb-backtrace', 'suspend-on-native-crash', 'suspend-on-sigsegv', 'suspend-on-exception', 'suspend-on-unhandled', 'dont-free-domains', 'dyn-runtime-invoke', 'gdb', 'explicit-null-checks', 'gen-seq-points', 'no-compact-seq-points', 'single-imm-size', 'init-stacks', 'casts', 'soft-breakpoints', 'check-pinvoke-callconv', 'use-fallback-tls', 'debug-domain-unload', 'partial-sharing', 'align-small-structs', 'native-debugger-break', 'thread-dump-dir=DIR', 'no-verbose-gdb', 'llvm_disable_inlining', 'llvm-disable-self-init', 'clr-memory-model'.\n");
+			fprintf (stderr, "Available options: 'handle-sigint', 'keep-delegates', 'reverse-pinvoke-exceptions', 'collect-pagefault-stats', 'break-on-unverified', 'no-gdb-backtrace', 'suspend-on-native-crash', 'suspend-on-sigsegv', 'suspend-on-exception', 'suspend-on-unhandled', 'dont-free-domains', 'dyn-runtime-invoke', 'gdb', 'explicit-null-checks', 'gen-seq-points', 'no-compact-seq-points', 'single-imm-size', 'init-stacks', 'casts', 'soft-breakpoints', 'check-pinvoke-callconv', 'use-fallback-tls', 'debug-domain-unload', 'partial-sharing', 'align-small-structs', 'native-debugger-break', 'thread-dump-dir=DIR', 'crash-summary-budget=MS', 'no-verbose-gdb', 'llvm_disable_inlining', 'llvm-disable-self-init', 'clr-memory-model', 'aot-eager-binding'.\n");
 			exit (1);
 		}
 	}
@@ -3803,6 +4471,7 @@ register_jit_stats (void)
 	mono_counters_register ("JIT/local_deadce", MONO_COUNTER_JIT | MONO_COUNTER_LONG | MONO_COUNTER_TIME, &mono_jit_stats.jit_local_deadce);
 	mono_counters_register ("JIT/local_alias_analysis", MONO_COUNTER_JIT | MONO_COUNTER_LONG | MONO_COUNTER_TIME, &mono_jit_stats.jit_local_alias_analysis);
 	mono_counters_register ("JIT/if_conversion", MONO_COUNTER_JIT | MONO_COUNTER_LONG | MONO_COUNTER_TIME, &mono_jit_stats.jit_if_conversion);
+	mono_counters_register ("JIT/simd_vectorize_loops", MONO_COUNTER_JIT | MONO_COUNTER_LONG | MONO_COUNTER_TIME, &mono_jit_stats.jit_simd_vectorize_loops);
 	mono_counters_register ("JIT/bb_ordering", MONO_COUNTER_JIT | MONO_COUNTER_LONG | MONO_COUNTER_TIME, &mono_jit_stats.jit_bb_ordering);
 	mono_counters_register ("JIT/compile_dominator_info", MONO_COUNTER_JIT | MONO_COUNTER_LONG | MONO_COUNTER_TIME, &mono_jit_stats.jit_compile_dominator_info);
 	mono_counters_register ("JIT/compute_natural_loops", MONO_COUNTER_JIT | MONO_COUNTER_LONG | MONO_COUNTER_TIME, &mono_jit_stats.jit_compute_natural_loops);
@@ -3810,6 +4479,7 @@ register_jit_stats (void)
 	mono_counters_register ("JIT/ssa_compute", MONO_COUNTER_JIT | MONO_COUNTER_LONG | MONO_COUNTER_TIME, &mono_jit_stats.jit_ssa_compute);
 	mono_counters_register ("JIT/ssa_cprop", MONO_COUNTER_JIT | MONO_COUNTER_LONG | MONO_COUNTER_TIME, &mono_jit_stats.jit_ssa_cprop);
 	mono_counters_register ("JIT/ssa_deadce", MONO_COUNTER_JIT | MONO_COUNTER_LONG | MONO_COUNTER_TIME, &mono_jit_stats.jit_ssa_deadce);
+	mono_counters_register ("JIT/ssa_licm", MONO_COUNTER_JIT | MONO_COUNTER_LONG | MONO_COUNTER_TIME, &mono_jit_stats.jit_ssa_licm);
 	mono_counters_register ("JIT/perform_abc_removal", MONO_COUNTER_JIT | MONO_COUNTER_LONG | MONO_COUNTER_TIME, &mono_jit_stats.jit_perform_abc_removal);
 	mono_counters_register ("JIT/ssa_remove", MONO_COUNTER_JIT | MONO_COUNTER_LONG | MONO_COUNTER_TIME, &mono_jit_stats.jit_ssa_remove);
 	mono_counters_register ("JIT/local_cprop2", MONO_COUNTER_JIT | MONO_COUNTER_LONG | MONO_COUNTER_TIME, &mono_jit_stats.jit_local_cprop2);
@@ -3834,13 +4504,18 @@ register_jit_stats (void)
 	mono_counters_register ("Max basic blocks", MONO_COUNTER_JIT | MONO_COUNTER_INT, &mono_jit_stats.max_basic_blocks);
 	mono_counters_register ("Allocated vars", MONO_COUNTER_JIT | MONO_COUNTER_INT, &mono_jit_stats.allocate_var);
 	mono_counters_register ("Code reallocs", MONO_COUNTER_JIT | MONO_COUNTER_INT, &mono_jit_stats.code_reallocs);
+	mono_counters_register ("Outlined class init checks", MONO_COUNTER_JIT | MONO_COUNTER_INT, &mono_jit_stats.outlined_class_inits);
+	mono_counters_register ("Outlined write barriers", MONO_COUNTER_JIT | MONO_COUNTER_INT, &mono_jit_stats.outlined_wbarriers);
 	mono_counters_register ("Allocated code size", MONO_COUNTER_JIT | MONO_COUNTER_INT, &mono_jit_stats.allocated_code_size);
 	mono_counters_register ("Allocated seq points size", MONO_COUNTER_JIT | MONO_COUNTER_INT, &mono_jit_stats.allocated_seq_points_size);
 	mono_counters_register ("Inlineable methods", MONO_COUNTER_JIT | MONO_COUNTER_INT, &mono_jit_stats.inlineable_methods);
 	mono_counters_register ("Inlined methods", MONO_COUNTER_JIT | MONO_COUNTER_INT, &mono_jit_stats.inlined_methods);
 	mono_counters_register ("Regvars", MONO_COUNTER_JIT | MONO_COUNTER_INT, &mono_jit_stats.regvars);
 	mono_counters_register ("Locals stack size", MONO_COUNTER_JIT | MONO_COUNTER_INT, &mono_jit_stats.locals_stack_size);
-	mono_counters_register ("Method cache lookups", MONO_COUNTER_JIT | MONO_COUNTER_INT, &mono_jit_stats.methods_lookups);
+	mono_counters_register ("Method cache lookups", MONO_COUNTER_JIT | MONO_COUNTER_LONG | MONO_COUNTER_SHARDED, &mono_jit_stats.methods_lookups);
+	mono_counters_register ("Methods tiered up", MONO_COUNTER_JIT | MONO_COUNTER_INT, &mono_jit_stats.methods_tiered_up);
+	mono_counters_register ("Methods tiered up with LLVM", MONO_COUNTER_JIT | MONO_COUNTER_INT, &mono_jit_stats.methods_tiered_up_llvm);
+	mono_counters_register ("Methods specialized instead of gsharedvt", MONO_COUNTER_JIT | MONO_COUNTER_INT, &mono_jit_stats.methods_gsharedvt_specialized);
 	mono_counters_register ("Compiled CIL code size", MONO_COUNTER_JIT | MONO_COUNTER_INT, &mono_jit_stats.cil_code_size);
 	mono_counters_register ("Native code size", MONO_COUNTER_JIT | MONO_COUNTER_INT, &mono_jit_stats.native_code_size);
 	mono_counters_register ("Aliases found", MONO_COUNTER_JIT | MONO_COUNTER_INT, &mono_jit_stats.alias_found);
@@ -3880,6 +4555,7 @@ mini_create_jit_domain_info (MonoDomain *domain)
 	info->llvm_vcall_trampoline_hash = g_hash_table_new (mono_aligned_addr_hash, NULL);
 	info->runtime_invoke_hash = mono_conc_hashtable_new_full (mono_aligned_addr_hash, NULL, NULL, runtime_invoke_info_free);
 	info->seq_points = g_hash_table_new_full (mono_aligned_addr_hash, NULL, NULL, mono_seq_point_info_free);
+	info->seq_point_indexes = g_hash_table_new_full (mono_aligned_addr_hash, NULL, NULL, mono_seq_point_index_free);
 	info->arch_seq_points = g_hash_table_new (mono_aligned_addr_hash, NULL);
 	info->jump_target_hash = g_hash_table_new (NULL, NULL);
 	mono_jit_code_hash_init (&info->interp_code_hash);
@@ -3905,7 +4581,9 @@ static void
 dynamic_method_info_free (gpointer key, gpointer value, gpointer user_data)
 {
 	MonoJitDynamicMethodInfo *di = (MonoJitDynamicMethodInfo *)value;
-	mono_code_manager_destroy (di->code_mp);
+	if (di->code_mp)
+		mono_code_manager_destroy (di->code_mp);
+	g_slist_free (di->jump_targets);
 	g_free (di);
 }
 
@@ -3927,11 +4605,24 @@ free_jit_callee_list (gpointer key, gpointer value, gpointer user_data)
 	g_slist_free ((GSList*)value);
 }
 
+static void
+free_tier_info (gpointer key, gpointer value, gpointer user_data)
+{
+	MonoTierInfo *info = (MonoTierInfo*)value;
+
+	/* The MonoTierInfo itself lives in the domain mempool */
+	if (info->receivers)
+		g_hash_table_destroy (info->receivers);
+}
+
 static void
 mini_free_jit_domain_info (MonoDomain *domain)
 {
 	MonoJitDomainInfo *info = domain_jit_info (domain);
 
+	/* The domain's code is freed after this */
+	mono_unwind_cache_invalidate ();
+
 	g_hash_table_foreach (info->jump_target_hash, delete_jump_list, NULL);
 	g_hash_table_destroy (info->jump_target_hash);
 	if (info->jump_target_got_slot_hash) {
@@ -3952,11 +4643,19 @@ mini_free_jit_domain_info (MonoDomain *domain)
 	g_hash_table_destroy (info->interp_method_pointer_hash);
 	g_hash_table_destroy (info->llvm_vcall_trampoline_hash);
 	mono_conc_hashtable_destroy (info->runtime_invoke_hash);
+	/* Before seq_points, the indexes reference their data */
+	g_hash_table_destroy (info->seq_point_indexes);
 	g_hash_table_destroy (info->seq_points);
 	g_hash_table_destroy (info->arch_seq_points);
 	if (info->agent_info)
 		mini_get_dbg_callbacks ()->free_domain_info (domain);
 	g_hash_table_destroy (info->gsharedvt_arg_tramp_hash);
+	if (info->tier_info_hash) {
+		g_hash_table_foreach (info->tier_info_hash, free_tier_info, NULL);
+		g_hash_table_destroy (info->tier_info_hash);
+	}
+	if (info->gsharedvt_lookup_hash)
+		g_hash_table_destroy (info->gsharedvt_lookup_hash);
 	if (info->llvm_jit_callees) {
 		g_hash_table_foreach (info->llvm_jit_callees, free_jit_callee_list, NULL);
 		g_hash_table_destroy (info->llvm_jit_callees);
@@ -4150,6 +4849,10 @@ mini_init (const char *filename, const char *runtime_version)
 	callbacks.create_jit_trampoline = mono_create_jit_trampoline;
 	callbacks.create_delegate_trampoline = mono_create_delegate_trampoline;
 	callbacks.free_method = mono_jit_free_method;
+#ifdef ENABLE_NETCORE
+	callbacks.detach_alc_code = mono_jit_detach_alc_code;
+	callbacks.free_alc_method = mono_jit_free_alc_method;
+#endif
 #ifndef DISABLE_REMOTING
 	callbacks.create_remoting_trampoline = mono_jit_create_remoting_trampoline;
 #endif
@@ -4183,6 +4886,12 @@ mini_init (const char *filename, const char *runtime_version)
 		mini_parse_debug_options ();
 	}
 
+#ifndef DISABLE_CRASH_REPORTING
+	// Turn the raw summaries of earlier crashes into json reports
+	if (mono_summarize_raw_budget ())
+		mono_summarize_raw_process_pending ();
+#endif
+
 	mono_code_manager_init ();
 
 #ifdef MONO_ARCH_HAVE_CODE_CHUNK_TRACKING
@@ -4235,6 +4944,14 @@ mini_init (const char *filename, const char *runtime_version)
 	}
 	if (mono_use_llvm)
 		mono_llvm_init ();
+	if (mono_tier_up_llvm && !mono_use_llvm) {
+		if (mono_llvm_load (NULL)) {
+			mono_llvm_init ();
+		} else {
+			mono_tier_up_llvm = FALSE;
+			fprintf (stderr, "Mono Warning: llvm support could not be loaded, hot methods will be recompiled by the JIT.\n");
+		}
+	}
 #endif
 
 	mono_trampolines_init ();
@@ -4317,6 +5034,9 @@ mini_init (const char *filename, const char *runtime_version)
 	mono_create_icall_signatures ();
 
 	register_jit_stats ();
+#ifdef MONO_JEMALLOC_ENABLED
+	mono_jemalloc_register_counters ();
+#endif
 
 #define JIT_CALLS_WORK
 #ifdef JIT_CALLS_WORK
@@ -4390,6 +5110,8 @@ register_icalls (void)
 	 * the wrapper would call the icall which would call the wrapper and
 	 * so on.
 	 */
+	register_icall (mini_tier_up, mono_icall_sig_void_ptr, FALSE);
+	register_icall (mini_tier_record_receiver, mono_icall_sig_void_ptr_ptr, TRUE);
 	register_icall (mono_profiler_raise_method_enter, mono_icall_sig_void_ptr_ptr, TRUE);
 	register_icall (mono_profiler_raise_method_leave, mono_icall_sig_void_ptr_ptr, TRUE);
 	register_icall (mono_profiler_raise_method_tail_call, mono_icall_sig_void_ptr_ptr, TRUE);
@@ -4569,6 +5291,7 @@ register_icalls (void)
 	register_icall (ves_icall_object_new_specific, mono_icall_sig_object_ptr, FALSE);
 	register_icall (ves_icall_array_new, mono_icall_sig_object_ptr_ptr_int32, FALSE);
 	register_icall (ves_icall_array_new_specific, mono_icall_sig_object_ptr_int32, FALSE);
+	register_icall (ves_icall_array_new_uninitialized_specific, mono_icall_sig_object_ptr_int32, FALSE);
 	register_icall (ves_icall_runtime_class_init, mono_icall_sig_void_ptr, FALSE);
 	register_icall (mono_ldftn, mono_icall_sig_ptr_ptr, FALSE);
 	register_icall (mono_ldvirtfn, mono_icall_sig_ptr_object_ptr, FALSE);
@@ -4640,6 +5363,7 @@ register_icalls (void)
 	register_icall_no_wrapper (mono_tls_get_domain, mono_icall_sig_ptr);
 	register_icall_no_wrapper (mono_tls_get_sgen_thread_info, mono_icall_sig_ptr);
 	register_icall_no_wrapper (mono_tls_get_lmf_addr, mono_icall_sig_ptr);
+	register_icall_no_wrapper (mono_tls_get_thread_static_data, mono_icall_sig_ptr);
 
 	register_icall_no_wrapper (mono_interp_entry_from_trampoline, mono_icall_sig_void_ptr_ptr);
 	register_icall_no_wrapper (mono_interp_to_native_trampoline, mono_icall_sig_void_ptr_ptr);
@@ -4697,6 +5421,8 @@ print_jit_stats (void)
 		g_print ("JIT info table removes: %" G_GINT32_FORMAT "\n", mono_stats.jit_info_table_remove_count);
 		g_print ("JIT info table lookups: %" G_GINT32_FORMAT "\n", mono_stats.jit_info_table_lookup_count);
 
+		mono_jit_telemetry_print ();
+
 		g_free (mono_jit_stats.max_ratio_method);
 		mono_jit_stats.max_ratio_method = NULL;
 		g_free (mono_jit_stats.biggest_method);
@@ -4735,6 +5461,8 @@ mini_cleanup (MonoDomain *domain)
 	/* This accesses metadata so needs to be called before runtime shutdown */
 	print_jit_stats ();
 
+	startup_trace_cleanup ();
+
 #ifndef MONO_CROSS_COMPILE
 	mono_runtime_cleanup (domain);
 #endif
@@ -4758,7 +5486,7 @@ mini_cleanup (MonoDomain *domain)
 	free_jit_tls_data (mono_tls_get_jit_tls ());
 
 #ifdef ENABLE_LLVM
-	if (mono_use_llvm)
+	if (mono_use_llvm || mono_tier_up_llvm)
 		mono_llvm_cleanup ();
 #endif
 
@@ -4792,6 +5520,10 @@ mini_cleanup (MonoDomain *domain)
 
 	mono_tls_free_keys ();
 
+#if ENABLE_JIT_MAP
+	jitdump_close ();
+#endif
+
 	mono_os_mutex_destroy (&jit_mutex);
 
 	mono_code_manager_cleanup ();
@@ -37,6 +37,8 @@ typedef struct
 	/* Maps MonoMethod to a GPtrArray containing sequence point locations */
 	/* Protected by the domain lock */
 	GHashTable *seq_points;
+	/* Maps MonoSeqPointInfo to a MonoSeqPointIndex, protected by the domain lock */
+	GHashTable *seq_point_indexes;
 	/* Debugger agent data */
 	gpointer agent_info;
 	/* Maps MonoMethod to an arch-specific structure */
@@ -56,6 +58,10 @@ typedef struct
 	GHashTable *method_rgctx_hash;
 	/* Maps gpointer -> InterpMethod */
 	GHashTable *interp_method_pointer_hash;
+	/* Maps MonoMethod -> MonoTierInfo of its tier 0 code, protected by the domain lock */
+	GHashTable *tier_info_hash;
+	/* Maps MonoMethod -> number of lookups which found gsharedvt AOT code, protected by the domain lock */
+	GHashTable *gsharedvt_lookup_hash;
 } MonoJitDomainInfo;
 
 #define domain_jit_info(domain) ((MonoJitDomainInfo*)((domain)->runtime_info))
@@ -138,6 +144,12 @@ struct MonoJitTlsData {
 
 	gpointer interp_context;
 
+	/* Decoded unwind states, see unwind.c */
+	gpointer unwind_cache;
+
+	/* Context to resume at after a fault on the safepoint page */
+	MonoContext safepoint_ctx;
+
 #if defined(TARGET_WIN32)
 	MonoContext stack_restore_ctx;
 #endif
@@ -223,6 +235,10 @@ typedef struct MonoDebugOptions {
 	 * Load AOT JIT info eagerly.
 	 */
 	gboolean load_aot_jit_info_eagerly;
+	/*
+	 * Resolve the GOT entries of an AOT module in one batch when the first method is loaded from it.
+	 */
+	gboolean aot_eager_binding;
 	/*
 	 * Check for pinvoke calling convention mismatches.
 	 */
@@ -371,6 +387,13 @@ extern gboolean mono_do_crash_chaining;
 MONO_API_DATA gboolean mono_use_llvm;
 MONO_API_DATA gboolean mono_use_interpreter;
 extern const char* mono_interp_opts_string;
+extern gboolean mono_tiered_compilation;
+extern int mono_tier_up_threshold;
+extern gboolean mono_tier_up_llvm;
+extern int mono_jit_worker_threads;
+extern char *mono_jit_startup_trace_file;
+extern int mono_jit_startup_trace_seconds;
+extern int mono_gsharedvt_specialize_threshold;
 extern gboolean mono_do_single_method_regression;
 extern guint32 mono_single_method_regression_opt;
 extern MonoMethod *mono_current_single_method;
@@ -503,11 +526,13 @@ gboolean  mono_debug_count                  (void);
 /* maybe enable also for other systems? */
 #define ENABLE_JIT_MAP 1
 void mono_enable_jit_map (void);
+void mono_enable_jitdump (void);
 void mono_emit_jit_map   (MonoJitInfo *jinfo);
 void mono_emit_jit_tramp (void *start, int size, const char *desc);
 gboolean mono_jit_map_is_enabled (void);
 #else
 #define mono_enable_jit_map()
+#define mono_enable_jitdump()
 #define mono_emit_jit_map(ji)
 #define mono_emit_jit_tramp(s,z,d)
 #define mono_jit_map_is_enabled() (0)
@@ -602,5 +627,7 @@ gboolean MONO_SIG_HANDLER_SIGNATURE (mono_chain_signal);
 
 void mini_register_sigterm_handler (void);
 
+void mini_startup_trace_start (void);
+
 #endif /* __MONO_MINI_RUNTIME_H__ */
 
@@ -12,6 +12,7 @@
 #include <mono/metadata/metadata-internals.h>
 #include <mono/metadata/marshal.h>
 #include <mono/metadata/tabledefs.h>
+#include <mono/metadata/loader-internals.h>
 #include <mono/utils/mono-counters.h>
 #include <mono/utils/mono-error-internals.h>
 #include <mono/utils/mono-membar.h>
@@ -142,6 +143,32 @@ mono_create_static_rgctx_trampoline (MonoMethod *m, gpointer addr)
 	return res;
 }
 
+#ifdef ENABLE_NETCORE
+static gboolean
+rgctx_tramp_info_in_alc (gpointer key, gpointer value, gpointer user_data)
+{
+	RgctxTrampInfo *info = (RgctxTrampInfo *)key;
+
+	return mono_alc_owns_method ((MonoAssemblyLoadContext *)user_data, info->m);
+}
+
+/*
+ * mini_remove_alc_static_rgctx_trampolines:
+ *
+ *   Remove the static rgctx trampolines of the methods of the collectible
+ * context ALC from the cache, they branch to code which is going to be freed.
+ * Called with the domain lock held.
+ */
+void
+mini_remove_alc_static_rgctx_trampolines (MonoDomain *domain, MonoAssemblyLoadContext *alc)
+{
+	GHashTable *hash = domain_jit_info (domain)->static_rgctx_trampoline_hash;
+
+	if (hash)
+		g_hash_table_foreach_remove (hash, rgctx_tramp_info_in_alc, alc);
+}
+#endif
+
 #else
 gpointer
 mono_create_static_rgctx_trampoline (MonoMethod *m, gpointer addr)
@@ -152,6 +179,13 @@ mono_create_static_rgctx_trampoline (MonoMethod *m, gpointer addr)
         */
        g_assert_not_reached ();
 }
+
+#ifdef ENABLE_NETCORE
+void
+mini_remove_alc_static_rgctx_trampolines (MonoDomain *domain, MonoAssemblyLoadContext *alc)
+{
+}
+#endif
 #endif
 
 gpointer
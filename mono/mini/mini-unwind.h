@@ -188,6 +188,10 @@ void mono_unwind_init (void);
 
 void mono_unwind_cleanup (void);
 
+void mono_unwind_cache_invalidate (void);
+
+void mono_unwind_cache_free (gpointer cache);
+
 guint32 mono_cache_unwind_info (guint8 *unwind_info, guint32 unwind_info_len);
 
 guint8* mono_get_cached_unwind_info (guint32 index, guint32 *unwind_info_len);
@@ -60,6 +60,8 @@
 #include <mono/utils/dtrace.h>
 #include <mono/utils/mono-threads.h>
 #include <mono/utils/mono-threads-coop.h>
+#include <mono/utils/mono-coop-mutex.h>
+#include <mono/utils/w32api.h>
 #include <mono/utils/unlocked.h>
 #include <mono/utils/mono-time.h>
 
@@ -1890,6 +1892,9 @@ mono_destroy_compile (MonoCompile *cfg)
 
 	mono_metadata_free_mh (cfg->header);
 
+	if (cfg->collectible_alc)
+		mono_alc_end_collectible_compile (cfg->collectible_alc);
+
 	g_hash_table_destroy (cfg->spvars);
 	g_hash_table_destroy (cfg->exvars);
 	g_list_free (cfg->ldstr_list);
@@ -2106,6 +2111,8 @@ mono_postprocess_patches (MonoCompile *cfg)
 			gpointer *table;
 			if (cfg->method->dynamic) {
 				table = (void **)mono_code_manager_reserve (cfg->dynamic_info->code_mp, sizeof (gpointer) * patch_info->data.table->table_size);
+			} else if (cfg->collectible_alc) {
+				table = (void **)mono_alc_code_reserve (cfg->collectible_alc, sizeof (gpointer) * patch_info->data.table->table_size);
 			} else {
 				table = (void **)mono_domain_code_reserve (cfg->domain, sizeof (gpointer) * patch_info->data.table->table_size);
 			}
@@ -2126,6 +2133,8 @@ mono_postprocess_patches (MonoCompile *cfg)
 			unsigned char *ip = cfg->native_code + patch_info->ip.i;
 
 			mini_register_jump_site (cfg->domain, patch_info->data.method, ip);
+			if (cfg->dynamic_info)
+				cfg->dynamic_info->jump_targets = g_slist_prepend (cfg->dynamic_info->jump_targets, patch_info->data.method);
 			break;
 		}
 		default:
@@ -2230,6 +2239,14 @@ mono_codegen (MonoCompile *cfg)
 			code = (guint8 *)mono_domain_code_reserve (code_domain, cfg->code_size + cfg->thunk_area + unwindlen);
 		else
 			code = (guint8 *)mono_code_manager_reserve (cfg->dynamic_info->code_mp, cfg->code_size + cfg->thunk_area + unwindlen);
+	} else if (cfg->collectible_alc) {
+		/* The code is freed with the context, the info is used to free the method before that */
+		cfg->dynamic_info = g_new0 (MonoJitDynamicMethodInfo, 1);
+		mono_domain_lock (cfg->domain);
+		mono_dynamic_code_hash_insert (cfg->domain, cfg->method, cfg->dynamic_info);
+		mono_domain_unlock (cfg->domain);
+
+		code = (guint8 *)mono_alc_code_reserve (cfg->collectible_alc, cfg->code_size + cfg->thunk_area + unwindlen);
 	} else {
 		code = (guint8 *)mono_domain_code_reserve (code_domain, cfg->code_size + cfg->thunk_area + unwindlen);
 	}
@@ -2322,6 +2339,8 @@ mono_codegen (MonoCompile *cfg)
 			mono_domain_code_commit (code_domain, cfg->native_code, cfg->code_size, cfg->code_len);
 		else
 			mono_code_manager_commit (cfg->dynamic_info->code_mp, cfg->native_code, cfg->code_size, cfg->code_len);
+	} else if (cfg->collectible_alc) {
+		mono_alc_code_commit (cfg->collectible_alc, cfg->native_code, cfg->code_size, cfg->code_len);
 	} else {
 		mono_domain_code_commit (code_domain, cfg->native_code, cfg->code_size, cfg->code_len);
 	}
@@ -2467,7 +2486,8 @@ create_jit_info (MonoCompile *cfg, MonoMethod *method_to_compile)
 	else
 		num_clauses = header->num_clauses;
 
-	if (cfg->method->dynamic)
+	/* Freed by mono_jit_free_method () or mono_jit_free_alc_method () */
+	if (cfg->method->dynamic || cfg->collectible_alc)
 		jinfo = (MonoJitInfo *)g_malloc0 (mono_jit_info_size (flags, num_clauses, num_holes));
 	else
 		jinfo = (MonoJitInfo *)mono_domain_alloc0 (cfg->domain, mono_jit_info_size (flags, num_clauses, num_holes));
@@ -2797,7 +2817,7 @@ mono_insert_nop_in_empty_bb (MonoCompile *cfg)
 static void
 insert_safepoint (MonoCompile *cfg, MonoBasicBlock *bblock)
 {
-	MonoInst *poll_addr, *ins;
+	MonoInst *poll_addr = NULL, *ins, *first;
 
 	if (cfg->disable_gc_safe_points)
 		return;
@@ -2806,10 +2826,21 @@ insert_safepoint (MonoCompile *cfg, MonoBasicBlock *bblock)
 		printf ("ADDING SAFE POINT TO BB %d\n", bblock->block_num);
 
 	g_assert (mini_safepoints_enabled ());
-	NEW_AOTCONST (cfg, poll_addr, MONO_PATCH_INFO_GC_SAFE_POINT_FLAG, (gpointer)&mono_polling_required);
 
-	MONO_INST_NEW (cfg, ins, OP_GC_SAFE_POINT);
-	ins->sreg1 = poll_addr->dreg;
+#ifdef MONO_ARCH_HAVE_SAFEPOINT_PAGE
+	if (!cfg->compile_aot && !COMPILE_LLVM (cfg) && mono_threads_get_safepoint_page ()) {
+		/* A load from the safepoint page, which faults while a suspend is requested */
+		MONO_INST_NEW (cfg, ins, OP_GC_SAFE_POINT_PAGE);
+		ins->inst_p0 = mono_threads_get_safepoint_page ();
+	} else
+#endif
+	{
+		NEW_AOTCONST (cfg, poll_addr, MONO_PATCH_INFO_GC_SAFE_POINT_FLAG, (gpointer)&mono_polling_required);
+
+		MONO_INST_NEW (cfg, ins, OP_GC_SAFE_POINT);
+		ins->sreg1 = poll_addr->dreg;
+	}
+	first = poll_addr ? poll_addr : ins;
 
 	if (bblock->flags & BB_EXCEPTION_HANDLER) {
 		MonoInst *eh_op = bblock->code;
@@ -2825,16 +2856,14 @@ insert_safepoint (MonoCompile *cfg, MonoBasicBlock *bblock)
 			}
 		}
 
-		mono_bblock_insert_after_ins (bblock, eh_op, poll_addr);
-		mono_bblock_insert_after_ins (bblock, poll_addr, ins);
+		mono_bblock_insert_after_ins (bblock, eh_op, first);
 	} else if (bblock == cfg->bb_entry) {
-		mono_bblock_insert_after_ins (bblock, bblock->last_ins, poll_addr);
-		mono_bblock_insert_after_ins (bblock, poll_addr, ins);
-
+		mono_bblock_insert_after_ins (bblock, bblock->last_ins, first);
 	} else {
-		mono_bblock_insert_before_ins (bblock, NULL, poll_addr);
-		mono_bblock_insert_after_ins (bblock, poll_addr, ins);
+		mono_bblock_insert_before_ins (bblock, NULL, first);
 	}
+	if (poll_addr)
+		mono_bblock_insert_after_ins (bblock, poll_addr, ins);
 }
 
 /*
@@ -3051,6 +3080,7 @@ mini_method_compile (MonoMethod *method, guint32 opts, MonoDomain *domain, JitFl
 	MonoMethodSignature *sig;
 	MonoCompile *cfg;
 	int i;
+	gint64 phase_start;
 	gboolean try_generic_shared, try_llvm = FALSE;
 	MonoMethod *method_to_compile, *method_to_register;
 	gboolean method_is_gshared = FALSE;
@@ -3132,8 +3162,20 @@ mini_method_compile (MonoMethod *method, guint32 opts, MonoDomain *domain, JitFl
 
 	cfg = g_new0 (MonoCompile, 1);
 	cfg->method = method_to_compile;
-	cfg->mempool = mono_mempool_new ();
+	cfg->mempool = mono_mempool_new_arena (MONO_JEMALLOC_ARENA_JIT);
 	cfg->opt = opts;
+	if (flags & JIT_FLAG_TIER0) {
+		cfg->tier_info = (MonoTierInfo *)mono_domain_alloc0 (domain, sizeof (MonoTierInfo));
+		cfg->tier_info->method = method;
+		cfg->tier_info->domain = domain;
+		cfg->tier_info->opt = opts;
+		cfg->opt &= ~MONO_TIER0_DISABLED_OPTS;
+		cfg->opt |= MONO_TIER0_ENABLED_OPTS;
+	} else if (mono_tiered_compilation) {
+		MonoTierInfo *profile = mini_lookup_tier_info (domain, method);
+		if (profile && profile->tiered_up)
+			cfg->tier_profile = profile;
+	}
 	cfg->run_cctors = run_cctors;
 	cfg->domain = domain;
 	cfg->verbose_level = mini_verbose;
@@ -3233,6 +3275,10 @@ mini_method_compile (MonoMethod *method, guint32 opts, MonoDomain *domain, JitFl
 	}
 	cfg->method_to_register = method_to_register;
 
+	/* The code of the methods of collectible AssemblyLoadContexts is freed when they are unloaded */
+	if (!compile_aot && !try_llvm && !method_to_compile->dynamic && !mono_using_xdebug && !(flags & JIT_FLAG_DISCARD_RESULTS))
+		cfg->collectible_alc = mono_alc_begin_collectible_compile (method_to_compile);
+
 	ERROR_DECL (err);
 	sig = mono_method_signature_checked (cfg->method, err);	
 	if (!sig) {
@@ -3434,7 +3480,9 @@ mini_method_compile (MonoMethod *method, guint32 opts, MonoDomain *domain, JitFl
 	mono_cfg_dump_create_context (cfg);
 	mono_cfg_dump_begin_group (cfg);
 
+	phase_start = mono_time_track_start ();
 	MONO_TIME_TRACK (mono_jit_stats.jit_method_to_ir, i = mono_method_to_ir (cfg, method_to_compile, NULL, NULL, NULL, NULL, 0, FALSE));
+	mono_time_track_end (&cfg->jit_time_method_to_ir, phase_start);
 	mono_cfg_dump_ir (cfg, "method-to-ir");
 
 	if (cfg->gdump_ctx != NULL) {
@@ -3561,6 +3609,13 @@ mini_method_compile (MonoMethod *method, guint32 opts, MonoDomain *domain, JitFl
 		mono_cfg_dump_ir (cfg, "if_conversion");
 	}
 
+#ifdef MONO_ARCH_SIMD_INTRINSICS
+	if ((cfg->opt & MONO_OPT_SIMD) && (cfg->opt & MONO_OPT_LOOP) && !COMPILE_LLVM (cfg)) {
+		MONO_TIME_TRACK (mono_jit_stats.jit_simd_vectorize_loops, mono_simd_vectorize_loops (cfg));
+		mono_cfg_dump_ir (cfg, "simd_vectorize_loops");
+	}
+#endif
+
 	mono_threads_safepoint ();
 
 	MONO_TIME_TRACK (mono_jit_stats.jit_bb_ordering, mono_bb_ordering (cfg));
@@ -3602,6 +3657,8 @@ mini_method_compile (MonoMethod *method, guint32 opts, MonoDomain *domain, JitFl
 	  cfg->disable_ssa = TRUE;
 	*/
 
+	phase_start = mono_time_track_start ();
+
 //#define DEBUGSSA "logic_run"
 //#define DEBUGSSA_CLASS "Tests"
 #ifdef DEBUGSSA
@@ -3653,6 +3710,11 @@ mini_method_compile (MonoMethod *method, guint32 opts, MonoDomain *domain, JitFl
 			mono_cfg_dump_ir (cfg, "ssa_deadce");
 		}
 
+		if (cfg->opt & MONO_OPT_LOOP) {
+			MONO_TIME_TRACK (mono_jit_stats.jit_ssa_licm, mono_ssa_loop_invariant_code_motion (cfg));
+			mono_cfg_dump_ir (cfg, "loop_invariant_code_motion");
+		}
+
 		if ((cfg->flags & (MONO_CFG_HAS_LDELEMA|MONO_CFG_HAS_CHECK_THIS)) && (cfg->opt & MONO_OPT_ABCREM)) {
 			MONO_TIME_TRACK (mono_jit_stats.jit_perform_abc_removal, mono_perform_abc_removal (cfg));
 			mono_cfg_dump_ir (cfg, "perform_abc_removal");
@@ -3676,6 +3738,8 @@ mini_method_compile (MonoMethod *method, guint32 opts, MonoDomain *domain, JitFl
 	}
 #endif
 
+	mono_time_track_end (&cfg->jit_time_ssa, phase_start);
+
 	if (cfg->comp_done & MONO_COMP_SSA && COMPILE_LLVM (cfg)) {
 		mono_ssa_loop_invariant_code_motion (cfg);
 		mono_cfg_dump_ir (cfg, "loop_invariant_code_motion");
@@ -3739,6 +3803,8 @@ mini_method_compile (MonoMethod *method, guint32 opts, MonoDomain *domain, JitFl
 	 */
 	MONO_TIME_TRACK(mono_jit_stats.jit_liveness_handle_exception_clauses2, mono_liveness_handle_exception_clauses (cfg));
 
+	phase_start = mono_time_track_start ();
+
 	if (cfg->opt & MONO_OPT_LINEARS) {
 		GList *vars, *regs, *l;
 		
@@ -3792,8 +3858,15 @@ mini_method_compile (MonoMethod *method, guint32 opts, MonoDomain *domain, JitFl
 		}
 	}
 
+	mono_time_track_end (&cfg->jit_time_regalloc, phase_start);
+
+	if (!COMPILE_LLVM (cfg) && (cfg->opt & MONO_OPT_BRANCH))
+		mono_move_cold_bblocks (cfg);
+
 	mono_insert_branches_between_bblocks (cfg);
 
+	phase_start = mono_time_track_start ();
+
 	if (COMPILE_LLVM (cfg)) {
 #ifdef ENABLE_LLVM
 		char *nm;
@@ -3839,6 +3912,8 @@ mini_method_compile (MonoMethod *method, guint32 opts, MonoDomain *domain, JitFl
 			return cfg;
 	}
 
+	mono_time_track_end (&cfg->jit_time_codegen, phase_start);
+
 	if (COMPILE_LLVM (cfg))
 		mono_atomic_inc_i32 (&mono_jit_stats.methods_with_llvm);
 	else
@@ -3870,8 +3945,12 @@ mini_method_compile (MonoMethod *method, guint32 opts, MonoDomain *domain, JitFl
 		mono_domain_lock (cfg->domain);
 		mono_jit_info_table_add (cfg->domain, cfg->jit_info);
 
-		if (cfg->method->dynamic)
+		if (cfg->method->dynamic) {
 			mono_dynamic_code_hash_lookup (cfg->domain, cfg->method)->ji = cfg->jit_info;
+		} else if (cfg->collectible_alc) {
+			cfg->dynamic_info->ji = cfg->jit_info;
+			mono_alc_add_collectible_method (cfg->collectible_alc, cfg->method);
+		}
 		mono_domain_unlock (cfg->domain);
 	}
 
@@ -4001,15 +4080,161 @@ mono_update_jit_stats (MonoCompile *cfg)
 	mono_jit_stats.inlineable_methods += cfg->stat_inlineable_methods;
 	mono_jit_stats.inlined_methods += cfg->stat_inlined_methods;
 	mono_jit_stats.code_reallocs += cfg->stat_code_reallocs;
+	mono_jit_stats.outlined_class_inits += cfg->stat_outlined_class_inits;
+	mono_jit_stats.outlined_wbarriers += cfg->stat_outlined_wbarriers;
+}
+
+typedef struct {
+	char *name;
+	MonoProfilerJitTelemetry telemetry;
+} JitTelemetryRecord;
+
+/* Protected by the jit lock, only used with --stats */
+static GArray *jit_telemetry_records;
+static GHashTable *jit_telemetry_inline_failures;
+
+/*
+ * mono_jit_telemetry_record:
+ *
+ *   Fill out TELEMETRY for CFG, which took JIT_TIME ticks to compile. The
+ * record is kept for the --stats summary too.
+ */
+void
+mono_jit_telemetry_record (MonoCompile *cfg, gint64 jit_time, MonoProfilerJitTelemetry *telemetry)
+{
+	MonoMethodHeader *header = cfg->header;
+
+	memset (telemetry, 0, sizeof (MonoProfilerJitTelemetry));
+	telemetry->total_time = jit_time * 100;
+	telemetry->method_to_ir_time = cfg->jit_time_method_to_ir * 100;
+	telemetry->ssa_time = cfg->jit_time_ssa * 100;
+	telemetry->regalloc_time = cfg->jit_time_regalloc * 100;
+	telemetry->codegen_time = cfg->jit_time_codegen * 100;
+	telemetry->il_size = header ? header->code_size : 0;
+	telemetry->native_size = cfg->code_len;
+	telemetry->inlined_methods = cfg->stat_inlined_methods;
+	telemetry->inline_failures = cfg->stat_inline_failures;
+	telemetry->tier = cfg->tier_info ? 0 : 1;
+
+	if (!mono_jit_stats.enabled)
+		return;
+
+	JitTelemetryRecord record;
+	record.name = mono_method_get_full_name (cfg->method);
+	record.telemetry = *telemetry;
+
+	mono_jit_lock ();
+	if (!jit_telemetry_records)
+		jit_telemetry_records = g_array_new (FALSE, FALSE, sizeof (JitTelemetryRecord));
+	g_array_append_val (jit_telemetry_records, record);
+	mono_jit_unlock ();
+}
+
+void
+mono_jit_telemetry_inline_failed (const char *reason)
+{
+	if (!mono_jit_stats.enabled)
+		return;
+
+	mono_jit_lock ();
+	if (!jit_telemetry_inline_failures)
+		jit_telemetry_inline_failures = g_hash_table_new (g_str_hash, g_str_equal);
+	int count = GPOINTER_TO_INT (g_hash_table_lookup (jit_telemetry_inline_failures, reason));
+	g_hash_table_insert (jit_telemetry_inline_failures, (gpointer)reason, GINT_TO_POINTER (count + 1));
+	mono_jit_unlock ();
+}
+
+static int
+compare_jit_telemetry_records (const void *a, const void *b)
+{
+	const JitTelemetryRecord *ra = (const JitTelemetryRecord *)a;
+	const JitTelemetryRecord *rb = (const JitTelemetryRecord *)b;
+
+	if (ra->telemetry.total_time == rb->telemetry.total_time)
+		return 0;
+	return ra->telemetry.total_time < rb->telemetry.total_time ? 1 : -1;
+}
+
+static void
+print_inline_failure (gpointer key, gpointer value, gpointer user_data)
+{
+	g_print ("  %-40s %d\n", (const char *)key, GPOINTER_TO_INT (value));
+}
+
+#define JIT_TELEMETRY_TOP_METHODS 20
+
+/*
+ * mono_jit_telemetry_print:
+ *
+ *   Print the methods which took the longest to JIT, and why inlining failed.
+ */
+void
+mono_jit_telemetry_print (void)
+{
+	int i;
+
+	mono_jit_lock ();
+
+	if (jit_telemetry_records && jit_telemetry_records->len) {
+		qsort (jit_telemetry_records->data, jit_telemetry_records->len, sizeof (JitTelemetryRecord), compare_jit_telemetry_records);
+
+		g_print ("\nMethods with the highest JIT time (us: total, method-to-ir, ssa, regalloc, codegen; IL/native size; inlined/failed; tier):\n");
+		for (i = 0; i < MIN (jit_telemetry_records->len, JIT_TELEMETRY_TOP_METHODS); ++i) {
+			JitTelemetryRecord *record = &g_array_index (jit_telemetry_records, JitTelemetryRecord, i);
+			MonoProfilerJitTelemetry *t = &record->telemetry;
+
+			g_print ("  %8" G_GUINT64_FORMAT " %8" G_GUINT64_FORMAT " %8" G_GUINT64_FORMAT " %8" G_GUINT64_FORMAT " %8" G_GUINT64_FORMAT " %6u/%-6u %3u/%-3u %u %s\n",
+				(guint64)(t->total_time / 1000), (guint64)(t->method_to_ir_time / 1000), (guint64)(t->ssa_time / 1000), (guint64)(t->regalloc_time / 1000), (guint64)(t->codegen_time / 1000),
+				t->il_size, t->native_size, t->inlined_methods, t->inline_failures, t->tier, record->name);
+		}
+	}
+
+	if (jit_telemetry_inline_failures && g_hash_table_size (jit_telemetry_inline_failures)) {
+		g_print ("\nInlining failures by reason:\n");
+		g_hash_table_foreach (jit_telemetry_inline_failures, print_inline_failure, NULL);
+	}
+
+	mono_jit_unlock ();
+}
+
+/* Tier ups waiting for a JIT worker, see mini_tier_up () */
+static MonoCoopMutex jit_worker_mutex;
+static MonoCoopCond jit_worker_cond;
+static GQueue jit_worker_queue;
+static gint32 jit_worker_queued;
+static gint32 jit_worker_threads_started;
+
+/*
+ * can_tier:
+ *
+ *   Return whenever METHOD is compiled at tier 0 first, see mini_tier_up ().
+ */
+static gboolean
+can_tier (MonoMethod *method, int opt)
+{
+	if (!mono_tiered_compilation || (opt & MONO_OPT_SHARED))
+		return FALSE;
+	/* Sequence points and the debugger assume a method has one piece of code */
+	if (mini_debug_options.gen_sdb_seq_points || mini_debug_options.mdb_optimizations)
+		return FALSE;
+	if (mono_use_llvm || method->wrapper_type != MONO_WRAPPER_NONE)
+		return FALSE;
+	/* Lookups of these go through the shared or inflated method */
+	if (method->is_inflated || mono_class_is_ginst (method->klass) || mono_class_is_gtd (method->klass))
+		return FALSE;
+	if (method->iflags & METHOD_IMPL_ATTRIBUTE_SYNCHRONIZED)
+		return FALSE;
+	return TRUE;
 }
 
 /*
  * mono_jit_compile_method_inner:
  *
- *   Main entry point for the JIT.
+ *   Main entry point for the JIT. Without JIT_FLAG_RUN_CCTORS in FLAGS, the class of
+ * METHOD is not initialized, and its code checks for it instead.
  */
 gpointer
-mono_jit_compile_method_inner (MonoMethod *method, MonoDomain *target_domain, int opt, MonoError *error)
+mono_jit_compile_method_inner (MonoMethod *method, MonoDomain *target_domain, int opt, JitFlags flags, MonoError *error)
 {
 	MonoCompile *cfg;
 	gpointer code = NULL;
@@ -4018,11 +4243,12 @@ mono_jit_compile_method_inner (MonoMethod *method, MonoDomain *target_domain, in
 	MonoException *ex = NULL;
 	gint64 start;
 	MonoMethod *prof_method, *shared;
+	MonoProfilerJitTelemetry telemetry;
 
 	error_init (error);
 
 	start = mono_time_track_start ();
-	cfg = mini_method_compile (method, opt, target_domain, JIT_FLAG_RUN_CCTORS, 0, -1);
+	cfg = mini_method_compile (method, opt, target_domain, (JitFlags)(flags | (can_tier (method, opt) ? JIT_FLAG_TIER0 : 0)), 0, -1);
 	gint64 jit_time = 0.0;
 	mono_time_track_end (&jit_time, start);
 	UnlockedAdd64 (&mono_jit_stats.jit_time, jit_time);
@@ -4100,6 +4326,8 @@ mono_jit_compile_method_inner (MonoMethod *method, MonoDomain *target_domain, in
 			code = info->code_start;
 			discarded_code ++;
 			discarded_jit_time += jit_time;
+			if (cfg->tier_info && cfg->tier_info->receivers)
+				g_hash_table_destroy (cfg->tier_info->receivers);
 		}
 	}
 	if (code == NULL) {
@@ -4108,6 +4336,13 @@ mono_jit_compile_method_inner (MonoMethod *method, MonoDomain *target_domain, in
 		mono_internal_hash_table_insert (&target_domain->jit_code_hash, cfg->jit_info->d.method, cfg->jit_info);
 		mono_domain_jit_code_hash_unlock (target_domain);
 
+		if (cfg->tier_info) {
+			MonoJitDomainInfo *domain_info = domain_jit_info (target_domain);
+			if (!domain_info->tier_info_hash)
+				domain_info->tier_info_hash = g_hash_table_new (NULL, NULL);
+			g_hash_table_insert (domain_info->tier_info_hash, method, cfg->tier_info);
+		}
+
 		code = cfg->native_code;
 
 		if (cfg->gshared && mono_method_is_generic_sharable (method, FALSE))
@@ -4123,6 +4358,7 @@ mono_jit_compile_method_inner (MonoMethod *method, MonoDomain *target_domain, in
 	 * mono_atomic_inc_i32 operations during JITting.
 	 */
 	mono_update_jit_stats (cfg);
+	mono_jit_telemetry_record (cfg, jit_time, &telemetry);
 
 	mono_destroy_compile (cfg);
 
@@ -4148,8 +4384,9 @@ mono_jit_compile_method_inner (MonoMethod *method, MonoDomain *target_domain, in
 	MONO_PROFILER_RAISE (jit_done, (method, jinfo));
 	if (prof_method != method)
 		MONO_PROFILER_RAISE (jit_done, (prof_method, jinfo));
+	MONO_PROFILER_RAISE (jit_telemetry, (prof_method, &telemetry));
 
-	if (!(method->wrapper_type == MONO_WRAPPER_REMOTING_INVOKE ||
+	if ((flags & JIT_FLAG_RUN_CCTORS) && !(method->wrapper_type == MONO_WRAPPER_REMOTING_INVOKE ||
 		  method->wrapper_type == MONO_WRAPPER_REMOTING_INVOKE_WITH_CHECK ||
 		  method->wrapper_type == MONO_WRAPPER_XDOMAIN_INVOKE)) {
 		if (!mono_runtime_class_init_full (vtable, error))
@@ -4158,6 +4395,207 @@ mono_jit_compile_method_inner (MonoMethod *method, MonoDomain *target_domain, in
 	return code;
 }
 
+/*
+ * tier_up_method:
+ *
+ *   Recompile INFO->method with all optimizations, and make the new code the one that
+ * lookups of the method return from now on. Call sites which were already patched to the
+ * tier 0 code keep calling it: those in hot methods move on when their method tiers up.
+ */
+static void
+tier_up_method (MonoTierInfo *info, JitFlags flags)
+{
+	MonoMethod *method = info->method;
+	MonoDomain *domain = info->domain;
+	MonoCompile *cfg;
+	MonoJitInfo *jinfo, *old_jinfo;
+	MonoVTable *vtable;
+	gpointer code;
+	gint64 start, jit_time = 0;
+	MonoProfilerJitTelemetry telemetry;
+
+	/* LLVM is only worth its compile time for the hot methods, it falls back to the JIT for what it can't handle */
+	if (mono_tier_up_llvm)
+		flags = (JitFlags)(flags | JIT_FLAG_LLVM);
+
+	start = mono_time_track_start ();
+	cfg = mini_method_compile (method, info->opt, domain, flags, 0, -1);
+	mono_time_track_end (&jit_time, start);
+	UnlockedAdd64 (&mono_jit_stats.jit_time, jit_time);
+
+	if (cfg->exception_type != MONO_EXCEPTION_NONE) {
+		/* The tier 0 code works just as well */
+		mono_destroy_compile (cfg);
+		return;
+	}
+	if (cfg->compile_llvm)
+		mono_atomic_inc_i32 (&mono_jit_stats.methods_tiered_up_llvm);
+
+	mono_domain_lock (domain);
+	mono_domain_jit_code_hash_lock (domain);
+	old_jinfo = (MonoJitInfo *)mono_internal_hash_table_lookup (&domain->jit_code_hash, method);
+	if (old_jinfo)
+		mono_internal_hash_table_remove (&domain->jit_code_hash, method);
+	/* The tier 0 code stays in the jit info table, it might still be running */
+	mono_internal_hash_table_insert (&domain->jit_code_hash, method, cfg->jit_info);
+	mono_domain_jit_code_hash_unlock (domain);
+
+	code = cfg->native_code;
+	jinfo = cfg->jit_info;
+
+	mono_update_jit_stats (cfg);
+	mono_jit_telemetry_record (cfg, jit_time, &telemetry);
+	mono_destroy_compile (cfg);
+
+	mini_patch_llvm_jit_callees (domain, method, code);
+#ifndef DISABLE_JIT
+	mono_emit_jit_map (jinfo);
+#endif
+	mono_domain_unlock (domain);
+
+	mini_patch_jump_sites (domain, method, code);
+
+	/* Virtual calls dispatching to the tier 0 code through the method's own vtable */
+	if (old_jinfo && (method->flags & METHOD_ATTRIBUTE_VIRTUAL)) {
+		int slot = mono_method_get_vtable_slot (method);
+
+		vtable = mono_class_try_get_vtable (domain, method->klass);
+		if (vtable && slot >= 0)
+			mono_atomic_cas_ptr (&vtable->vtable [slot], code, old_jinfo->code_start);
+	}
+
+	mono_atomic_inc_i32 (&mono_jit_stats.methods_tiered_up);
+	MONO_PROFILER_RAISE (jit_done, (method, jinfo));
+	MONO_PROFILER_RAISE (jit_telemetry, (method, &telemetry));
+}
+
+static gsize WINAPI
+jit_worker_thread (gpointer arg)
+{
+	ERROR_DECL (error);
+	MonoInternalThread *internal = mono_thread_internal_current ();
+
+	MonoString *thread_name = mono_string_new_checked (mono_get_root_domain (), "JIT Worker", error);
+	mono_error_assert_ok (error);
+	mono_thread_set_name_internal (internal, thread_name, FALSE, FALSE, error);
+	mono_error_assert_ok (error);
+	/* Ask the runtime to not wait for this thread */
+	internal->state |= ThreadState_Background;
+
+	while (!mono_runtime_is_shutting_down ()) {
+		MonoTierInfo *info;
+
+		mono_coop_mutex_lock (&jit_worker_mutex);
+		while (g_queue_is_empty (&jit_worker_queue))
+			mono_coop_cond_wait (&jit_worker_cond, &jit_worker_mutex);
+		info = (MonoTierInfo *)g_queue_pop_head (&jit_worker_queue);
+		mono_coop_mutex_unlock (&jit_worker_mutex);
+
+		/* Don't run cctors here, the code checks for them like AOT code does */
+		tier_up_method (info, (JitFlags)0);
+		mono_atomic_dec_i32 (&jit_worker_queued);
+	}
+
+	return 0;
+}
+
+/*
+ * mini_lookup_tier_info:
+ *
+ *   Return the counts collected by the tier 0 code of METHOD, or NULL if it never ran
+ * tier 0 code in DOMAIN.
+ */
+MonoTierInfo *
+mini_lookup_tier_info (MonoDomain *domain, MonoMethod *method)
+{
+	MonoTierInfo *info = NULL;
+
+	mono_domain_lock (domain);
+	if (domain_jit_info (domain)->tier_info_hash)
+		info = (MonoTierInfo *)g_hash_table_lookup (domain_jit_info (domain)->tier_info_hash, method);
+	mono_domain_unlock (domain);
+	return info;
+}
+
+/*
+ * mini_tier_get_receivers:
+ *
+ *   Return the receiver types the tier 0 code of INFO->method recorded for its virtual call
+ * at IL_OFFSET, allocating them if CREATE is set. That is only done while compiling the
+ * tier 0 code.
+ */
+MonoTierReceivers*
+mini_tier_get_receivers (MonoTierInfo *info, guint32 il_offset, gboolean create)
+{
+	MonoTierReceivers *receivers = NULL;
+
+	if (info->receivers)
+		receivers = (MonoTierReceivers *)g_hash_table_lookup (info->receivers, GUINT_TO_POINTER (il_offset));
+	if (!receivers && create) {
+		if (!info->receivers)
+			info->receivers = g_hash_table_new (NULL, NULL);
+		receivers = (MonoTierReceivers *)mono_domain_alloc0 (info->domain, sizeof (MonoTierReceivers));
+		g_hash_table_insert (info->receivers, GUINT_TO_POINTER (il_offset), receivers);
+	}
+	return receivers;
+}
+
+/*
+ * mini_tier_record_receiver:
+ *
+ *   Called by tier 0 code for the receivers of virtual calls which don't match the first
+ * recorded type. The counts aren't exact, they only need to tell the hot types apart.
+ */
+void
+mini_tier_record_receiver (MonoTierReceivers *receivers, MonoVTable *vtable)
+{
+	int i;
+
+	for (i = 0; i < MONO_TIER_RECEIVER_TYPES; ++i) {
+		if (!receivers->vtables [i])
+			mono_atomic_cas_ptr ((gpointer*)&receivers->vtables [i], vtable, NULL);
+		if (receivers->vtables [i] == vtable) {
+			receivers->counts [i] ++;
+			return;
+		}
+	}
+	receivers->others ++;
+}
+
+/*
+ * mini_tier_up:
+ *
+ *   Called by the tier 0 code of INFO->method once it's hot. The recompilation is handed
+ * to the JIT workers if there are any, so the caller keeps running the tier 0 code in the
+ * meantime.
+ */
+void
+mini_tier_up (MonoTierInfo *info)
+{
+	if (mono_atomic_cas_i32 (&info->tiered_up, 1, 0) != 0)
+		return;
+
+	/* The workers live in the root domain, and other domains could be unloaded under them */
+	if (mono_jit_worker_threads <= 0 || info->domain != mono_get_root_domain ()) {
+		tier_up_method (info, JIT_FLAG_RUN_CCTORS);
+		return;
+	}
+
+	mono_coop_mutex_lock (&jit_worker_mutex);
+	g_queue_push_tail (&jit_worker_queue, info);
+	mono_atomic_inc_i32 (&jit_worker_queued);
+	mono_coop_cond_signal (&jit_worker_cond);
+	mono_coop_mutex_unlock (&jit_worker_mutex);
+
+	if (jit_worker_threads_started < mono_jit_worker_threads && mono_atomic_inc_i32 (&jit_worker_threads_started) <= mono_jit_worker_threads) {
+		ERROR_DECL (error);
+
+		mono_thread_create_internal (mono_get_root_domain (), (gpointer)jit_worker_thread, NULL, MONO_THREAD_CREATE_FLAGS_NONE, error);
+		/* The queued tier ups just wait for another worker, or stay at tier 0 */
+		mono_error_cleanup (error);
+	}
+}
+
 /*
  * mini_get_underlying_type:
  *
@@ -4177,8 +4615,11 @@ mini_jit_init (void)
 	mono_counters_register ("Discarded method code", MONO_COUNTER_JIT | MONO_COUNTER_INT, &discarded_code);
 	mono_counters_register ("Time spent JITting discarded code", MONO_COUNTER_JIT | MONO_COUNTER_LONG | MONO_COUNTER_TIME, &discarded_jit_time);
 	mono_counters_register ("Try holes memory size", MONO_COUNTER_JIT | MONO_COUNTER_INT, &jinfo_try_holes_size);
+	mono_counters_register ("Methods waiting for a JIT worker", MONO_COUNTER_JIT | MONO_COUNTER_INT, &jit_worker_queued);
 
 	mono_os_mutex_init_recursive (&jit_mutex);
+	mono_coop_mutex_init (&jit_worker_mutex);
+	mono_coop_cond_init (&jit_worker_cond);
 #ifndef DISABLE_JIT
 	current_backend = g_new0 (MonoBackend, 1);
 	init_backend (current_backend);
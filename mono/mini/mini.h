@@ -38,6 +38,7 @@
 #include <mono/utils/mono-threads-coop.h>
 #include <mono/utils/mono-tls.h>
 #include <mono/utils/atomic.h>
+#include <mono/utils/mono-counters-internals.h>
 #include <mono/utils/mono-jemalloc.h>
 #include <mono/utils/mono-conc-hashtable.h>
 #include <mono/utils/mono-signal-handler.h>
@@ -156,7 +157,10 @@ typedef struct
 
 typedef struct {
 	MonoJitInfo *ji;
+	/* NULL for the methods of collectible contexts, their code is freed with the context */
 	MonoCodeManager *code_mp;
+	/* Methods whose MonoJumpList has sites in this method's code */
+	GSList *jump_targets;
 } MonoJitDynamicMethodInfo;
 
 /* An extension of MonoGenericParamFull used in generic sharing */
@@ -832,6 +836,7 @@ struct MonoCallArgParm {
 enum {
 	MONO_INST_HAS_METHOD = 1,
 	MONO_INST_INIT       = 1, /* in localloc */
+	MONO_INST_UNINIT     = 1, /* in OP_NEWARR, the elements are initialized right after the allocation */
 	MONO_INST_SINGLE_STEP_LOC = 1, /* in SEQ_POINT */
 	MONO_INST_IS_DEAD    = 2,
 	MONO_INST_TAILCALL   = 4,
@@ -1169,6 +1174,40 @@ enum {
 	MONO_OPT_LAST
 };
 
+/* The optimizations tier 0 code is compiled with, it optimizes for size */
+#define MONO_TIER0_ENABLED_OPTS (MONO_OPT_OUTLINE)
+
+/* The optimizations tier 0 code is compiled without */
+#define MONO_TIER0_DISABLED_OPTS (MONO_OPT_INLINE | MONO_OPT_CONSPROP | MONO_OPT_COPYPROP | MONO_OPT_DEADCE | \
+	MONO_OPT_LINEARS | MONO_OPT_CMOV | MONO_OPT_SCHED | MONO_OPT_LOOP | MONO_OPT_ABCREM | MONO_OPT_SSA | MONO_OPT_ALIAS_ANALYSIS)
+
+/* Number of receiver types recorded per virtual call site of tier 0 code */
+#define MONO_TIER_RECEIVER_TYPES 4
+
+typedef struct {
+	MonoVTable *vtables [MONO_TIER_RECEIVER_TYPES];
+	gint32 counts [MONO_TIER_RECEIVER_TYPES];
+	/* Calls whose receiver type didn't fit */
+	gint32 others;
+} MonoTierReceivers;
+
+/*
+ * Tier 0 code counts its calls and loop iterations in one of these, and mini_tier_up ()
+ * is called with it once either count shows the method is hot.
+ */
+typedef struct {
+	gint32 calls;
+	/* Taken loop back edges, kept apart so calls stay comparable between methods */
+	gint32 backedges;
+	gint32 tiered_up;
+	MonoMethod *method;
+	MonoDomain *domain;
+	/* The optimizations to recompile with */
+	guint32 opt;
+	/* Maps IL offsets of virtual calls to their MonoTierReceivers */
+	GHashTable *receivers;
+} MonoTierInfo;
+
 /*
  * This structure represents a JIT backend.
  */
@@ -1218,6 +1257,8 @@ typedef enum {
 	JIT_FLAG_DISCARD_RESULTS = (1 << 8),
 	/* Whenever to generate code which can work with the interpreter */
 	JIT_FLAG_INTERP = (1 << 9),
+	/* Whenever to generate cheap code which gets recompiled once it's hot */
+	JIT_FLAG_TIER0 = (1 << 10),
 } JitFlags;
 
 /* Bit-fields in the MonoBasicBlock.region */
@@ -1260,6 +1301,8 @@ typedef struct {
 	MonoJumpInfo    *patch_info;
 	MonoJitInfo     *jit_info;
 	MonoJitDynamicMethodInfo *dynamic_info;
+	/* Set if the code is allocated from a collectible AssemblyLoadContext */
+	MonoAssemblyLoadContext *collectible_alc;
 	guint            num_bblocks, max_block_num;
 	guint            locals_start;
 	guint            num_varinfo; /* used items in varinfo */
@@ -1347,6 +1390,14 @@ typedef struct {
 
 	MonoInst *stack_inbalance_var;
 
+	/* Set for tier 0 code */
+	MonoTierInfo *tier_info;
+	/* Set when tiering up, the counts collected by the tier 0 code */
+	MonoTierInfo *tier_profile;
+
+	/* newobj allocations which are candidates for scalar replacement */
+	GSList *object_allocs;
+
 	unsigned char   *cil_start;
 	unsigned char   *native_code;
 	guint            code_size;
@@ -1583,10 +1634,23 @@ typedef struct {
 	int stat_n_regvars;
 	int stat_inlineable_methods;
 	int stat_inlined_methods;
+	int stat_inline_failures;
 	int stat_code_reallocs;
+	int stat_outlined_class_inits;
+	int stat_outlined_wbarriers;
+
+	/* Per method JIT telemetry, in 100ns ticks, see mono_jit_telemetry_record () */
+	gint64 jit_time_method_to_ir;
+	gint64 jit_time_ssa;
+	gint64 jit_time_regalloc;
+	gint64 jit_time_codegen;
+	/* Reason passed to the last inline_failure () call */
+	const char *inline_failure_reason;
 
 	MonoProfilerCallInstrumentationFlags prof_flags;
 	gboolean prof_coverage;
+	/* Tested by the enter/leave guards, set once on method entry */
+	MonoInst *prof_call_guard_var;
 
 	/* For deduplication */
 	gboolean skip;
@@ -1621,11 +1685,13 @@ typedef struct {
 	gint32 methods_compiled;
 	gint32 methods_aot;
 	gint32 methods_aot_llvm;
-	gint32 methods_lookups;
+	MonoShardedCounter methods_lookups;
 	gint32 allocate_var;
 	gint32 cil_code_size;
 	gint32 native_code_size;
 	gint32 code_reallocs;
+	gint32 outlined_class_inits;
+	gint32 outlined_wbarriers;
 	gint32 max_code_size_ratio;
 	gint32 biggest_method_size;
 	gint32 allocated_code_size;
@@ -1645,6 +1711,9 @@ typedef struct {
 	gint32 methods_with_llvm;
 	gint32 methods_without_llvm;
 	gint32 methods_with_interp;
+	gint32 methods_tiered_up;
+	gint32 methods_tiered_up_llvm;
+	gint32 methods_gsharedvt_specialized;
 	char *max_ratio_method;
 	char *biggest_method;
 	gint64 jit_method_to_ir;
@@ -1659,6 +1728,7 @@ typedef struct {
 	gint64 jit_local_deadce;
 	gint64 jit_local_alias_analysis;
 	gint64 jit_if_conversion;
+	gint64 jit_simd_vectorize_loops;
 	gint64 jit_bb_ordering;
 	gint64 jit_compile_dominator_info;
 	gint64 jit_compute_natural_loops;
@@ -1666,6 +1736,7 @@ typedef struct {
 	gint64 jit_ssa_compute;
 	gint64 jit_ssa_cprop;
 	gint64 jit_ssa_deadce;
+	gint64 jit_ssa_licm;
 	gint64 jit_perform_abc_removal;
 	gint64 jit_ssa_remove;
 	gint64 jit_local_cprop2;
@@ -2066,6 +2137,7 @@ void      mono_remove_bblock                (MonoCompile *cfg, MonoBasicBlock *b
 void      mono_nullify_basic_block          (MonoBasicBlock *bb);
 void      mono_merge_basic_blocks           (MonoCompile *cfg, MonoBasicBlock *bb, MonoBasicBlock *bbn);
 void      mono_optimize_branches            (MonoCompile *cfg);
+void      mono_move_cold_bblocks            (MonoCompile *cfg);
 
 void      mono_blockset_print               (MonoCompile *cfg, MonoBitSet *set, const char *name, guint idom);
 void      mono_print_ins_index              (int i, MonoInst *ins);
@@ -2089,7 +2161,11 @@ void      mono_call_add_patch_info          (MonoCompile *cfg, MonoCallInst *cal
 void      mono_add_patch_info               (MonoCompile *cfg, int ip, MonoJumpInfoType type, gconstpointer target) MONO_LLVM_INTERNAL;
 void      mono_add_patch_info_rel           (MonoCompile *cfg, int ip, MonoJumpInfoType type, gconstpointer target, int relocation) MONO_LLVM_INTERNAL;
 void      mono_remove_patch_info            (MonoCompile *cfg, int ip);
-gpointer  mono_jit_compile_method_inner     (MonoMethod *method, MonoDomain *target_domain, int opt, MonoError *error);
+gpointer  mono_jit_compile_method_inner     (MonoMethod *method, MonoDomain *target_domain, int opt, JitFlags flags, MonoError *error);
+void      mini_tier_up                      (MonoTierInfo *info);
+MonoTierInfo *mini_lookup_tier_info         (MonoDomain *domain, MonoMethod *method);
+MonoTierReceivers *mini_tier_get_receivers (MonoTierInfo *info, guint32 il_offset, gboolean create);
+void      mini_tier_record_receiver         (MonoTierReceivers *receivers, MonoVTable *vtable);
 GList    *mono_varlist_insert_sorted        (MonoCompile *cfg, GList *list, MonoMethodVar *mv, int sort_type);
 GList    *mono_varlist_sort                 (MonoCompile *cfg, GList *list, int sort_type);
 void      mono_analyze_liveness             (MonoCompile *cfg);
@@ -2170,6 +2246,9 @@ gpointer          mono_create_monitor_enter_trampoline (void);
 gpointer          mono_create_monitor_enter_v4_trampoline (void);
 gpointer          mono_create_monitor_exit_trampoline (void);
 gpointer          mono_create_static_rgctx_trampoline (MonoMethod *m, gpointer addr);
+#ifdef ENABLE_NETCORE
+void              mini_remove_alc_static_rgctx_trampolines (MonoDomain *domain, MonoAssemblyLoadContext *alc);
+#endif
 gpointer          mono_create_ftnptr_arg_trampoline (gpointer arg, gpointer addr);
 MonoVTable*       mono_find_class_init_trampoline_by_addr (gconstpointer addr);
 guint32           mono_find_rgctx_lazy_fetch_trampoline_by_addr (gconstpointer addr);
@@ -2731,6 +2810,9 @@ gint64 mono_time_track_start (void);
 void mono_time_track_end (gint64 *time, gint64 start);
 
 void mono_update_jit_stats (MonoCompile *cfg);
+void mono_jit_telemetry_record (MonoCompile *cfg, gint64 jit_time, MonoProfilerJitTelemetry *telemetry);
+void mono_jit_telemetry_inline_failed (const char *reason);
+void mono_jit_telemetry_print (void);
 
 gboolean mini_type_is_reference (MonoType *type);
 gboolean mini_type_is_vtype (MonoType *t) MONO_LLVM_INTERNAL;
@@ -2809,6 +2891,7 @@ guint32     mono_arch_cpu_enumerate_simd_versions (void);
 void        mono_simd_simplify_indirection (MonoCompile *cfg);
 void        mono_simd_decompose_intrinsic (MonoCompile *cfg, MonoBasicBlock *bb, MonoInst *ins);
 void        mono_simd_decompose_intrinsics (MonoCompile *cfg);
+void        mono_simd_vectorize_loops (MonoCompile *cfg);
 MonoInst*   mono_emit_simd_intrinsics (MonoCompile *cfg, MonoMethod *cmethod, MonoMethodSignature *fsig, MonoInst **args);
 MonoInst*   mono_emit_simd_field_load (MonoCompile *cfg, MonoClassField *field, MonoInst *addr);
 void        mono_simd_intrinsics_init (void);
@@ -943,6 +943,20 @@ class Tests {
 		return 2;
 	}
 
+	static readonly GetIntDel static_del = new GetIntDel (return4);
+	static readonly GetIntDel instance_del = new GetIntDel (new InstanceDelegateTest () { a = 1337 }.return_field);
+	static readonly GetIntDel multicast_del = (GetIntDel)Delegate.Combine (new GetIntDel (return4), new GetIntDel (new Tests ().return5));
+
+	public static int test_0_readonly_field_delegates () {
+		if (static_del () != 4)
+			return 1;
+		if (instance_del () != 1337)
+			return 2;
+		if (multicast_del () != 5)
+			return 3;
+		return 0;
+	}
+
 	interface IFaceVirtualDel {
 		int return_field ();
 	}
@@ -2050,6 +2064,194 @@ ncells ) {
 		var old = System.Threading.Interlocked.CompareExchange(ref variable_with_constant_address, 1, 0);
 		return old == 0 && variable_with_constant_address == 1 ? 0 : 1;
 	}
+
+	class ScalarPoint {
+		public int X, Y;
+		public object O;
+
+		public ScalarPoint (int x, int y) {
+			X = x;
+			Y = y;
+		}
+	}
+
+	class ScalarHolder {
+		public ScalarPoint P;
+	}
+
+	[StructLayout (LayoutKind.Explicit)]
+	class ScalarOverlap {
+		[FieldOffset (0)] public int I;
+		[FieldOffset (0)] public uint U;
+		[FieldOffset (0)] public short S;
+		[FieldOffset (0)] public byte B;
+		[FieldOffset (4)] public long L;
+	}
+
+	class ScalarWidths {
+		public sbyte SB;
+		public byte UB;
+		public short SS;
+		public ushort US;
+		public int I;
+		public uint U;
+		public long L;
+		public float F;
+		public double D;
+	}
+
+	static ScalarPoint scalar_point;
+
+	[MethodImplAttribute (MethodImplOptions.NoInlining)]
+	static void scalar_modify (ScalarPoint p) {
+		p.X = 10;
+	}
+
+	[MethodImplAttribute (MethodImplOptions.NoInlining)]
+	static ScalarPoint scalar_return (int x) {
+		var p = new ScalarPoint (x, x);
+		p.Y = 2 * x;
+		return p;
+	}
+
+	public static int test_3_scalar_replace_local () {
+		var p = new ScalarPoint (1, 2);
+		return p.X + p.Y;
+	}
+
+	public static int test_0_scalar_replace_zero_init () {
+		var p = new ScalarPoint (0, 0);
+		var w = new ScalarWidths ();
+		if (p.O != null)
+			return 1;
+		if (w.SB != 0 || w.UB != 0 || w.SS != 0 || w.US != 0 || w.I != 0 || w.U != 0 || w.L != 0)
+			return 2;
+		if (w.F != 0.0f || w.D != 0.0)
+			return 3;
+		return 0;
+	}
+
+	public static int test_0_scalar_replace_escape_call () {
+		var p = new ScalarPoint (1, 2);
+		scalar_modify (p);
+		return p.X == 10 ? 0 : 1;
+	}
+
+	public static int test_0_scalar_replace_escape_static () {
+		var p = new ScalarPoint (1, 2);
+		scalar_point = p;
+		p.X = 5;
+		return scalar_point.X == 5 ? 0 : 1;
+	}
+
+	public static int test_0_scalar_replace_escape_field () {
+		var h = new ScalarHolder ();
+		var p = new ScalarPoint (1, 2);
+		h.P = p;
+		p.Y = 7;
+		return h.P.Y == 7 && h.P == p ? 0 : 1;
+	}
+
+	public static int test_0_scalar_replace_escape_object_field () {
+		var outer = new ScalarPoint (1, 2);
+		var inner = new ScalarPoint (3, 4);
+		outer.O = inner;
+		inner.X = 6;
+		return ((ScalarPoint)outer.O).X == 6 ? 0 : 1;
+	}
+
+	public static int test_0_scalar_replace_escape_return () {
+		var p = scalar_return (3);
+		return p.X == 3 && p.Y == 6 ? 0 : 1;
+	}
+
+	public static int test_0_scalar_replace_identity () {
+		var a = new ScalarPoint (1, 1);
+		var b = new ScalarPoint (1, 1);
+		return a != b && a == a ? 0 : 1;
+	}
+
+	public static int test_10_scalar_replace_in_loop () {
+		int sum = 0;
+		ScalarPoint prev = null;
+		for (int i = 0; i < 5; ++i) {
+			var p = new ScalarPoint (i, i);
+			if (p == prev)
+				return -1;
+			sum += p.X;
+			prev = p;
+		}
+		return sum;
+	}
+
+	public static int test_5_scalar_replace_with_handler () {
+		var p = new ScalarPoint (1, 2);
+		try {
+			p.X = 5;
+			throw new Exception ();
+		} catch {
+			return p.X;
+		}
+	}
+
+	public static int test_0_scalar_replace_partial_store () {
+		var o = new ScalarOverlap ();
+		o.I = 0x12345678;
+		o.B = 0xff;
+		if (BitConverter.IsLittleEndian && o.I != 0x123456ff)
+			return 1;
+		o.S = -1;
+		if (BitConverter.IsLittleEndian && o.I != 0x1234ffff)
+			return 2;
+		return 0;
+	}
+
+	public static int test_0_scalar_replace_load_widths () {
+		var o = new ScalarOverlap ();
+		o.I = -1;
+		if (o.B != 0xff)
+			return 1;
+		if (o.S != -1)
+			return 2;
+		if (o.U != 0xffffffff)
+			return 3;
+		o.L = -2;
+		if (o.I != -1)
+			return 4;
+		return 0;
+	}
+
+	public static int test_0_scalar_replace_sign_extension () {
+		var w = new ScalarWidths ();
+		int big = 200, neg = -2;
+		w.SB = (sbyte)big;
+		w.UB = (byte)neg;
+		w.SS = (short)(big * 200);
+		w.US = (ushort)neg;
+		w.I = neg;
+		w.U = (uint)neg;
+		if (w.SB != -56 || w.UB != 254)
+			return 1;
+		if (w.SS != -25536 || w.US != 65534)
+			return 2;
+		long l = w.I;
+		ulong ul = w.U;
+		if (l != -2 || ul != 0xfffffffe)
+			return 3;
+		int[] arr = new int [] { 1, 2, 3 };
+		w.I = 2;
+		if (arr [w.I] != 3)
+			return 4;
+		return 0;
+	}
+
+	public static int test_0_scalar_replace_floats () {
+		var w = new ScalarWidths ();
+		w.F = 1.5f;
+		w.D = w.F * 2;
+		w.L = (long)w.D;
+		return w.L == 3 ? 0 : 1;
+	}
 }
 
 #if __MOBILE__
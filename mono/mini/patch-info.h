@@ -61,6 +61,8 @@ PATCH_INFO(ICALL_ADDR_CALL, "icall_addr_call")
 PATCH_INFO(JIT_ICALL_ADDR_NOCALL, "jit_icall_addr_nocall")
 PATCH_INFO(PROFILER_ALLOCATION_COUNT, "profiler_allocation_count")
 PATCH_INFO(PROFILER_CLAUSE_COUNT, "profiler_clause_count")
+PATCH_INFO(PROFILER_METHOD_ENTER_COUNT, "profiler_method_enter_count")
+PATCH_INFO(PROFILER_METHOD_LEAVE_COUNT, "profiler_method_leave_count")
 /*
  * A MonoFtnDesc for calling amethod.
  * This either points to native code or to an interp entry
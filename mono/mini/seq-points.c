@@ -280,6 +280,38 @@ mono_get_seq_points (MonoDomain *domain, MonoMethod *method)
 	return seq_points;
 }
 
+/*
+ * mono_get_seq_point_index:
+ *
+ *   Return the random access index of INFO, creating it the first time. The
+ * index lives as long as INFO in DOMAIN.
+ */
+MonoSeqPointIndex*
+mono_get_seq_point_index (MonoDomain *domain, MonoSeqPointInfo *info)
+{
+	MonoSeqPointIndex *index, *existing;
+
+	mono_domain_lock (domain);
+	index = (MonoSeqPointIndex *)g_hash_table_lookup (domain_jit_info (domain)->seq_point_indexes, info);
+	mono_domain_unlock (domain);
+	if (index)
+		return index;
+
+	index = mono_seq_point_index_new (info);
+
+	mono_domain_lock (domain);
+	existing = (MonoSeqPointIndex *)g_hash_table_lookup (domain_jit_info (domain)->seq_point_indexes, info);
+	if (!existing)
+		g_hash_table_insert (domain_jit_info (domain)->seq_point_indexes, info, index);
+	mono_domain_unlock (domain);
+
+	if (existing) {
+		mono_seq_point_index_free (index);
+		index = existing;
+	}
+	return index;
+}
+
 /*
  * mono_find_next_seq_point_for_native_offset:
  *
@@ -299,7 +331,7 @@ mono_find_next_seq_point_for_native_offset (MonoDomain *domain, MonoMethod *meth
 	if (info)
 		*info = seq_points;
 
-	return mono_seq_point_find_next_by_native_offset (seq_points, native_offset, seq_point);
+	return mono_seq_point_index_find_next_by_native_offset (mono_get_seq_point_index (domain, seq_points), native_offset, seq_point);
 }
 
 /*
@@ -321,7 +353,7 @@ mono_find_prev_seq_point_for_native_offset (MonoDomain *domain, MonoMethod *meth
 	if (info)
 		*info = seq_points;
 
-	return mono_seq_point_find_prev_by_native_offset (seq_points, native_offset, seq_point);
+	return mono_seq_point_index_find_prev_by_native_offset (mono_get_seq_point_index (domain, seq_points), native_offset, seq_point);
 }
 
 /*
@@ -344,7 +376,7 @@ mono_find_seq_point (MonoDomain *domain, MonoMethod *method, gint32 il_offset, M
 	if (info)
 		*info = seq_points;
 
-	return mono_seq_point_find_by_il_offset (seq_points, il_offset, seq_point);
+	return mono_seq_point_index_find_by_il_offset (mono_get_seq_point_index (domain, seq_points), il_offset, seq_point);
 }
 
 void
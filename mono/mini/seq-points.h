@@ -24,6 +24,9 @@ mono_find_prev_seq_point_for_native_offset (MonoDomain *domain, MonoMethod *meth
 gboolean
 mono_find_seq_point (MonoDomain *domain, MonoMethod *method, gint32 il_offset, MonoSeqPointInfo **info, SeqPoint *seq_point);
 
+MonoSeqPointIndex*
+mono_get_seq_point_index (MonoDomain *domain, MonoSeqPointInfo *info);
+
 void
 mono_bb_deduplicate_op_il_seq_points (MonoCompile *cfg, MonoBasicBlock *bb);
 
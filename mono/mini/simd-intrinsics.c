@@ -14,6 +14,7 @@
 #include "mini.h"
 #include "ir-emit.h"
 #include "mono/utils/bsearch.h"
+#include <mono/utils/mono-hwcap.h>
 #include <mono/metadata/abi-details.h>
 #include <mono/metadata/reflection-internals.h>
 
@@ -2041,6 +2042,66 @@ emit_simd_runtime_intrinsics (MonoCompile *cfg, MonoMethod *cmethod, MonoMethodS
 	return NULL;
 }
 
+/*
+ * emit_hw_intrinsics:
+ *
+ *   Handle the System.Runtime.Intrinsics.X86 classes in corlib. Only the ISAs whose
+ * whole surface is implemented report IsSupported, since the managed fallbacks of the
+ * other methods throw PlatformNotSupportedException. For now, these are the bit
+ * counting classes.
+ */
+static MonoInst*
+emit_hw_intrinsics (MonoCompile *cfg, MonoMethod *cmethod, MonoMethodSignature *fsig, MonoInst **args)
+{
+	MonoClass *klass = cmethod->klass;
+	MonoInst *ins;
+	const char *isa;
+	gboolean is_64 = FALSE, supported = FALSE;
+	int opcode = 0;
+
+	if (m_class_get_nested_in (klass)) {
+		if (strcmp (m_class_get_name (klass), "X64"))
+			return NULL;
+		klass = m_class_get_nested_in (klass);
+		is_64 = TRUE;
+	}
+	if (strcmp (m_class_get_name_space (klass), "System.Runtime.Intrinsics.X86"))
+		return NULL;
+	isa = m_class_get_name (klass);
+
+#ifdef TARGET_AMD64
+	/* AOT code can run on a different cpu */
+	if (!cfg->compile_aot) {
+		if (!strcmp (isa, "Popcnt"))
+			supported = mono_hwcap_x86_has_popcnt;
+		else if (!strcmp (isa, "Lzcnt"))
+			supported = mono_hwcap_x86_has_lzcnt;
+	}
+#endif
+
+	if (!strcmp (cmethod->name, "get_IsSupported") && fsig->param_count == 0) {
+		EMIT_NEW_ICONST (cfg, ins, supported ? 1 : 0);
+		ins->type = STACK_I4;
+		return ins;
+	}
+	if (!supported || fsig->param_count != 1)
+		return NULL;
+
+	if (!strcmp (isa, "Popcnt") && !strcmp (cmethod->name, "PopCount"))
+		opcode = is_64 ? OP_POPCNT64 : OP_POPCNT32;
+	else if (!strcmp (isa, "Lzcnt") && !strcmp (cmethod->name, "LeadingZeroCount"))
+		opcode = is_64 ? OP_LZCNT64 : OP_LZCNT32;
+	if (!opcode)
+		return NULL;
+
+	MONO_INST_NEW (cfg, ins, opcode);
+	ins->dreg = is_64 ? alloc_lreg (cfg) : alloc_ireg (cfg);
+	ins->sreg1 = args [0]->dreg;
+	ins->type = is_64 ? STACK_I8 : STACK_I4;
+	MONO_ADD_INS (cfg->cbb, ins);
+	return ins;
+}
+
 static gboolean
 is_sys_numerics_assembly (MonoAssembly *assembly)
 {
@@ -2059,6 +2120,12 @@ mono_emit_simd_intrinsics (MonoCompile *cfg, MonoMethod *cmethod, MonoMethodSign
 	const char *class_name;
 	MonoInst *simd_inst = NULL;
 
+	if (m_class_get_image (cmethod->klass) == mono_defaults.corlib) {
+		simd_inst = emit_hw_intrinsics (cfg, cmethod, fsig, args);
+		if (simd_inst)
+			return simd_inst;
+	}
+
 	if (is_sys_numerics_assembly (m_class_get_image (cmethod->klass)->assembly)) {
 		simd_inst = emit_sys_numerics_intrinsics (cfg, cmethod, fsig, args);
 		goto on_exit;
@@ -2637,5 +2704,693 @@ on_exit:
 	return simd_inst;
 }
 
+/*
+ * Loop vectorization
+ *
+ * Simple counted loops over primitive arrays, like
+ *
+ *   for (int i = 0; i < n; ++i)
+ *     c [i] = a [i] + b [i];
+ *
+ * are given a vectorized copy which runs before the original loop and processes one
+ * SIMD register worth of elements per iteration. The original loop is kept to handle the
+ * remaining elements, and it also runs in place of the vector loop whenever the vector
+ * loop can't prove that all array accesses are in range, so exceptions are still thrown
+ * by the scalar code.
+ *
+ * Only two bblock loops are handled: a header which compares the induction variable
+ * against a loop invariant bound, and a body whose only side effects are element
+ * accesses indexed by the induction variable. This runs before SSA, so the new code
+ * doesn't have to be kept in SSA form, and before the bblocks are ordered.
+ */
+
+enum {
+	VLOOP_NONE,
+	/* A vector value */
+	VLOOP_VEC,
+	/* The induction variable, sign extended */
+	VLOOP_IDX,
+	/* The address of an array element */
+	VLOOP_ADDR
+};
+
+#define VLOOP_MAX_INS 64
+
+typedef struct {
+	MonoCompile *cfg;
+	MonoBasicBlock *header, *body, *preheader;
+	MonoInst *iv;
+	MonoType *etype;
+	int esize, nelems;
+	/* Invariant array vregs accessed by the body */
+	GSList *arrays;
+	/* Maps the vregs of the body to their vectorized counterparts */
+	int max_vreg;
+	int *vregs;
+	guint8 *kinds;
+	/* Vars defined in the loop */
+	gboolean *loop_defs;
+} VectorLoop;
+
+static gboolean
+vloop_is_invariant (VectorLoop *vl, int vreg)
+{
+	MonoInst *var = get_vreg_to_inst (vl->cfg, vreg);
+
+	return var && var != vl->iv && !(var->flags & (MONO_INST_VOLATILE | MONO_INST_INDIRECT)) && !(vreg < vl->max_vreg && vl->loop_defs [vreg]);
+}
+
+static gboolean
+vloop_is_supported_etype (MonoCompile *cfg, MonoType *t)
+{
+	if (t->byref)
+		return FALSE;
+	switch (t->type) {
+	case MONO_TYPE_I1:
+	case MONO_TYPE_U1:
+	case MONO_TYPE_I2:
+	case MONO_TYPE_U2:
+	case MONO_TYPE_I4:
+	case MONO_TYPE_U4:
+	case MONO_TYPE_R8:
+		return TRUE;
+#if SIZEOF_REGISTER == 8
+	case MONO_TYPE_I8:
+	case MONO_TYPE_U8:
+		return TRUE;
+#endif
+	case MONO_TYPE_R4:
+		/* Otherwise the element loads convert to double */
+		return cfg->r4fp;
+	default:
+		return FALSE;
+	}
+}
+
+static void
+vloop_add_array (VectorLoop *vl, int vreg)
+{
+	if (!g_slist_find (vl->arrays, GINT_TO_POINTER (vreg)))
+		vl->arrays = g_slist_prepend_mempool (vl->cfg->mempool, vl->arrays, GINT_TO_POINTER (vreg));
+}
+
+static int
+emit_vector_expand (MonoCompile *cfg, MonoType *etype, int sreg)
+{
+	MonoInst *ins;
+	int expand_op = mono_type_to_expand_op (etype);
+
+	MONO_INST_NEW (cfg, ins, expand_op);
+	ins->sreg1 = sreg;
+	ins->type = STACK_VTYPE;
+	ins->dreg = alloc_xreg (cfg);
+	MONO_ADD_INS (cfg->cbb, ins);
+
+	if (expand_op == OP_EXPAND_R4)
+		ins->backend.spill_var = mini_get_int_to_float_spill_area (cfg);
+	else if (expand_op == OP_EXPAND_R8)
+		ins->backend.spill_var = get_double_spill_area (cfg);
+
+	return ins->dreg;
+}
+
+static int
+emit_vector_expand_imm (MonoCompile *cfg, MonoType *etype, gint64 imm)
+{
+	MonoInst *ins;
+	int sreg;
+
+	if (imm == 0) {
+		MONO_INST_NEW (cfg, ins, OP_XZERO);
+		ins->type = STACK_VTYPE;
+		ins->dreg = alloc_xreg (cfg);
+		MONO_ADD_INS (cfg->cbb, ins);
+		return ins->dreg;
+	}
+
+	if (etype->type == MONO_TYPE_I8 || etype->type == MONO_TYPE_U8) {
+		sreg = alloc_lreg (cfg);
+		MONO_EMIT_NEW_I8CONST (cfg, sreg, imm);
+	} else {
+		sreg = alloc_ireg (cfg);
+		MONO_EMIT_NEW_ICONST (cfg, sreg, (gint32)imm);
+	}
+	return emit_vector_expand (cfg, etype, sreg);
+}
+
+/*
+ * vloop_get_operand:
+ *
+ *   Return the vector vreg holding the value of the scalar VREG in the vector loop,
+ * emitting a broadcast for loop invariant values, or -1 if the value can't be vectorized.
+ */
+static int
+vloop_get_operand (VectorLoop *vl, int vreg)
+{
+	if (vreg < vl->max_vreg && vl->kinds [vreg] == VLOOP_VEC)
+		return vl->vregs [vreg];
+	if (vloop_is_invariant (vl, vreg))
+		return emit_vector_expand (vl->cfg, vl->etype, vreg);
+	return -1;
+}
+
+static int
+vloop_get_binop (MonoCompile *cfg, int opcode, MonoType *etype)
+{
+	gboolean is_long = etype->type == MONO_TYPE_I8 || etype->type == MONO_TYPE_U8;
+
+	switch (opcode) {
+	case OP_IADD:
+	case OP_ISUB:
+	case OP_IMUL:
+	case OP_IAND:
+	case OP_IOR:
+	case OP_IXOR:
+		if (is_long || etype->type == MONO_TYPE_R4 || etype->type == MONO_TYPE_R8)
+			return -1;
+		break;
+#if SIZEOF_REGISTER == 8
+	case OP_LADD:
+	case OP_LSUB:
+	case OP_LAND:
+	case OP_LOR:
+	case OP_LXOR:
+		if (!is_long)
+			return -1;
+		break;
+#endif
+	case OP_FADD:
+	case OP_FSUB:
+	case OP_FMUL:
+	case OP_FDIV:
+		if (etype->type != MONO_TYPE_R8)
+			return -1;
+		break;
+	case OP_RADD:
+	case OP_RSUB:
+	case OP_RMUL:
+	case OP_RDIV:
+		if (etype->type != MONO_TYPE_R4)
+			return -1;
+		break;
+	default:
+		return -1;
+	}
+
+	switch (opcode) {
+	case OP_IADD:
+	case OP_LADD:
+	case OP_FADD:
+	case OP_RADD:
+		return type_to_padd_op (etype);
+	case OP_ISUB:
+	case OP_LSUB:
+	case OP_FSUB:
+	case OP_RSUB:
+		return type_to_psub_op (etype);
+	case OP_IMUL:
+	case OP_FMUL:
+	case OP_RMUL:
+		/* PMULLD is SSE4.1 */
+		if ((etype->type == MONO_TYPE_I4 || etype->type == MONO_TYPE_U4) && (cfg->compile_aot || !(simd_supported_versions & SIMD_VERSION_SSE41)))
+			return -1;
+		return type_to_pmul_op (etype);
+	case OP_FDIV:
+	case OP_RDIV:
+		return type_to_pdiv_op (etype);
+	case OP_IAND:
+	case OP_LAND:
+		return type_to_pand_op (etype);
+	case OP_IOR:
+	case OP_LOR:
+		return type_to_por_op (etype);
+	case OP_IXOR:
+	case OP_LXOR:
+		return type_to_pxor_op (etype);
+	default:
+		g_assert_not_reached ();
+		return -1;
+	}
+}
+
+static int
+vloop_store_imm_to_reg (int opcode)
+{
+	switch (opcode) {
+	case OP_STOREI1_MEMBASE_IMM:
+		return OP_STOREI1_MEMBASE_REG;
+	case OP_STOREI2_MEMBASE_IMM:
+		return OP_STOREI2_MEMBASE_REG;
+	case OP_STOREI4_MEMBASE_IMM:
+		return OP_STOREI4_MEMBASE_REG;
+	case OP_STOREI8_MEMBASE_IMM:
+		return OP_STOREI8_MEMBASE_REG;
+	default:
+		return -1;
+	}
+}
+
+static gboolean
+vloop_is_index (VectorLoop *vl, int vreg)
+{
+	return vreg == vl->iv->dreg || (vreg < vl->max_vreg && vl->kinds [vreg] == VLOOP_IDX);
+}
+
+static int
+vloop_get_index (VectorLoop *vl, int vreg)
+{
+	return vreg == vl->iv->dreg ? vreg : vl->vregs [vreg];
+}
+
+/*
+ * vloop_emit_body:
+ *
+ *   Emit the vectorized version of the loop body into cfg->cbb. Return FALSE if the body
+ * contains something which can't be vectorized.
+ */
+static gboolean
+vloop_emit_body (VectorLoop *vl)
+{
+	MonoCompile *cfg = vl->cfg;
+	MonoInst *ins, *vins;
+	gboolean incremented = FALSE, stores = FALSE;
+	int count = 0;
+
+	MONO_BB_FOR_EACH_INS (vl->body, ins) {
+		int sregs [MONO_MAX_SRC_REGS];
+		int i, num_sregs, op, sreg1, sreg2;
+
+		if (++count > VLOOP_MAX_INS)
+			return FALSE;
+
+		if (ins->opcode == OP_NOP)
+			continue;
+		if (incremented && ins->opcode != OP_BR)
+			/* The iv is only updated at the end of the body */
+			return FALSE;
+		if (ins->dreg != -1 && !MONO_IS_STORE_MEMBASE (ins) && ins->dreg >= vl->max_vreg)
+			return FALSE;
+
+		switch (ins->opcode) {
+		case OP_BR:
+			continue;
+		case OP_IADD_IMM:
+			if (ins->dreg == vl->iv->dreg && ins->sreg1 == vl->iv->dreg && ins->inst_imm == 1) {
+				incremented = TRUE;
+				continue;
+			}
+			break;
+		case OP_MOVE:
+		case OP_SEXT_I4:
+			if (ins->sreg1 == vl->iv->dreg && !get_vreg_to_inst (cfg, ins->dreg)) {
+				vl->kinds [ins->dreg] = VLOOP_IDX;
+				vl->vregs [ins->dreg] = alloc_preg (cfg);
+				MONO_EMIT_NEW_UNALU (cfg, ins->opcode, vl->vregs [ins->dreg], vl->iv->dreg);
+				continue;
+			}
+			break;
+		case OP_BOUNDS_CHECK:
+			if (!vloop_is_invariant (vl, ins->sreg1) || !vloop_is_index (vl, ins->sreg2) || ins->inst_imm != MONO_STRUCT_OFFSET (MonoArray, max_length))
+				return FALSE;
+			/* The vector loop is only entered if all accesses are in range */
+			vloop_add_array (vl, ins->sreg1);
+			continue;
+		case OP_X86_LEA: {
+			MonoType *t;
+
+			if (!ins->klass || !vloop_is_invariant (vl, ins->sreg1) || !vloop_is_index (vl, ins->sreg2) || ins->inst_imm != MONO_STRUCT_OFFSET (MonoArray, vector))
+				return FALSE;
+			t = mini_get_underlying_type (m_class_get_byval_arg (ins->klass));
+			if (!vloop_is_supported_etype (cfg, t))
+				return FALSE;
+			if (!vl->etype) {
+				vl->etype = t;
+				vl->esize = mono_class_array_element_size (ins->klass);
+				vl->nelems = 16 / vl->esize;
+			} else if (mono_class_array_element_size (ins->klass) != vl->esize || (t->type == MONO_TYPE_R4 || t->type == MONO_TYPE_R8) != (vl->etype->type == MONO_TYPE_R4 || vl->etype->type == MONO_TYPE_R8)) {
+				return FALSE;
+			}
+			if ((1 << ins->backend.shift_amount) != vl->esize)
+				return FALSE;
+			vloop_add_array (vl, ins->sreg1);
+			vl->kinds [ins->dreg] = VLOOP_ADDR;
+			EMIT_NEW_X86_LEA (cfg, vins, ins->sreg1, vloop_get_index (vl, ins->sreg2), ins->backend.shift_amount, ins->inst_imm);
+			vl->vregs [ins->dreg] = vins->dreg;
+			continue;
+		}
+		case OP_ICONV_TO_I1:
+		case OP_ICONV_TO_U1:
+		case OP_ICONV_TO_I2:
+		case OP_ICONV_TO_U2:
+			/* The vector ops wrap around at the element size */
+			if (!vl->etype || vl->esize != ((ins->opcode == OP_ICONV_TO_I1 || ins->opcode == OP_ICONV_TO_U1) ? 1 : 2))
+				return FALSE;
+			/* Fall through */
+		case OP_FMOVE:
+		case OP_RMOVE:
+			if (ins->sreg1 >= vl->max_vreg || vl->kinds [ins->sreg1] != VLOOP_VEC || get_vreg_to_inst (cfg, ins->dreg))
+				return FALSE;
+			vl->kinds [ins->dreg] = VLOOP_VEC;
+			vl->vregs [ins->dreg] = vl->vregs [ins->sreg1];
+			continue;
+		default:
+			break;
+		}
+
+		if (ins->opcode == OP_MOVE) {
+			if (ins->sreg1 >= vl->max_vreg || vl->kinds [ins->sreg1] != VLOOP_VEC || get_vreg_to_inst (cfg, ins->dreg))
+				return FALSE;
+			vl->kinds [ins->dreg] = VLOOP_VEC;
+			vl->vregs [ins->dreg] = vl->vregs [ins->sreg1];
+			continue;
+		}
+
+		if (MONO_IS_LOAD_MEMBASE (ins)) {
+			if (ins->sreg1 >= vl->max_vreg || vl->kinds [ins->sreg1] != VLOOP_ADDR || ins->inst_offset != 0)
+				return FALSE;
+			if (ins->opcode != mono_type_to_load_membase (cfg, vl->etype) || get_vreg_to_inst (cfg, ins->dreg))
+				return FALSE;
+			MONO_INST_NEW (cfg, vins, OP_LOADX_MEMBASE);
+			vins->dreg = alloc_xreg (cfg);
+			vins->sreg1 = vl->vregs [ins->sreg1];
+			vins->type = STACK_VTYPE;
+			MONO_ADD_INS (cfg->cbb, vins);
+			vl->kinds [ins->dreg] = VLOOP_VEC;
+			vl->vregs [ins->dreg] = vins->dreg;
+			continue;
+		}
+
+		if (MONO_IS_STORE_MEMBASE (ins)) {
+			int vreg;
+
+			if (ins->dreg >= vl->max_vreg || vl->kinds [ins->dreg] != VLOOP_ADDR || ins->inst_offset != 0)
+				return FALSE;
+			if (ins->opcode == mono_type_to_store_membase (cfg, vl->etype))
+				vreg = vloop_get_operand (vl, ins->sreg1);
+			else if (vloop_store_imm_to_reg (ins->opcode) == mono_type_to_store_membase (cfg, vl->etype))
+				vreg = emit_vector_expand_imm (cfg, vl->etype, ins->inst_imm);
+			else
+				return FALSE;
+			if (vreg == -1)
+				return FALSE;
+			EMIT_NEW_STORE_MEMBASE (cfg, vins, OP_STOREX_MEMBASE, vl->vregs [ins->dreg], 0, vreg);
+			stores = TRUE;
+			continue;
+		}
+
+		/* Element-wise arithmetic */
+		if (ins->dreg == -1 || get_vreg_to_inst (cfg, ins->dreg))
+			return FALSE;
+		num_sregs = mono_inst_get_src_registers (ins, sregs);
+		for (i = 0; i < num_sregs; ++i) {
+			if (sregs [i] == vl->iv->dreg)
+				return FALSE;
+		}
+		op = mono_op_imm_to_op (ins->opcode);
+		if (!vl->etype || num_sregs != (op == -1 ? 2 : 1))
+			return FALSE;
+		op = vloop_get_binop (cfg, op == -1 ? ins->opcode : op, vl->etype);
+		if (op == -1)
+			return FALSE;
+		sreg1 = vloop_get_operand (vl, ins->sreg1);
+		if (num_sregs == 1)
+			sreg2 = emit_vector_expand_imm (cfg, vl->etype, ins->inst_imm);
+		else
+			sreg2 = vloop_get_operand (vl, ins->sreg2);
+		if (sreg1 == -1 || sreg2 == -1)
+			return FALSE;
+		MONO_INST_NEW (cfg, vins, op);
+		vins->dreg = alloc_xreg (cfg);
+		vins->sreg1 = sreg1;
+		vins->sreg2 = sreg2;
+		vins->type = STACK_VTYPE;
+		MONO_ADD_INS (cfg->cbb, vins);
+		vl->kinds [ins->dreg] = VLOOP_VEC;
+		vl->vregs [ins->dreg] = vins->dreg;
+	}
+
+	return incremented && stores;
+}
+
+static MonoBasicBlock*
+vloop_new_bblock (VectorLoop *vl)
+{
+	MonoBasicBlock *bb;
+
+	NEW_BBLOCK (vl->cfg, bb);
+	bb->region = vl->header->region;
+	bb->real_offset = vl->header->real_offset;
+	return bb;
+}
+
+/*
+ * vloop_emit_branch:
+ *
+ *   End cfg->cbb with a conditional branch to TARGET and continue in a new bblock.
+ */
+static void
+vloop_emit_branch (VectorLoop *vl, int opcode, MonoBasicBlock *target)
+{
+	MonoCompile *cfg = vl->cfg;
+	MonoBasicBlock *next = vloop_new_bblock (vl);
+	MonoInst *ins;
+
+	MONO_INST_NEW (cfg, ins, opcode);
+	ins->inst_true_bb = target;
+	ins->inst_false_bb = next;
+	MONO_ADD_INS (cfg->cbb, ins);
+	mono_link_bblock (cfg, cfg->cbb, target);
+	mono_link_bblock (cfg, cfg->cbb, next);
+	cfg->cbb->next_bb = next;
+	cfg->cbb = next;
+}
+
+static gboolean
+vloop_is_header_ins (VectorLoop *vl, MonoInst *ins)
+{
+	switch (ins->opcode) {
+	case OP_NOP:
+		return TRUE;
+	case OP_ICONST:
+		break;
+	case OP_LDLEN:
+		if (!vloop_is_invariant (vl, ins->sreg1))
+			return FALSE;
+		break;
+	case OP_MOVE:
+	case OP_LCONV_TO_I4:
+		if (ins->sreg1 == vl->iv->dreg || get_vreg_to_inst (vl->cfg, ins->sreg1))
+			return FALSE;
+		break;
+	default:
+		return FALSE;
+	}
+	return !get_vreg_to_inst (vl->cfg, ins->dreg);
+}
+
+static gboolean
+vectorize_loop (MonoCompile *cfg, MonoBasicBlock *header, MonoBasicBlock *body)
+{
+	VectorLoop vl;
+	MonoBasicBlock *preheader, *bb, *prev, *entry, *vbody;
+	MonoInst *ins, *branch, *cmp, *lim;
+	GSList *l;
+	int bound_reg, *hregs, i;
+	gboolean res = FALSE;
+
+	/* Shape */
+	if (header->in_count != 2 || body->in_count != 1 || body->out_count != 1 || body->out_bb [0] != header || header == body)
+		return FALSE;
+	preheader = header->in_bb [0] == body ? header->in_bb [1] : header->in_bb [0];
+	if (preheader == header || preheader == body || !preheader->last_ins)
+		return FALSE;
+	branch = header->last_ins;
+	if (!branch || !(branch->opcode == OP_IBLT && branch->inst_true_bb == body) && !(branch->opcode == OP_IBGE && branch->inst_false_bb == body))
+		return FALSE;
+	cmp = branch->prev;
+	if (!cmp || (cmp->opcode != OP_ICOMPARE && cmp->opcode != OP_ICOMPARE_IMM))
+		return FALSE;
+	if (preheader->last_ins->opcode != OP_BR && !MONO_IS_COND_BRANCH_OP (preheader->last_ins) && preheader->next_bb != header)
+		return FALSE;
+	/* The bblock falling through to the header gets an explicit branch */
+	for (prev = cfg->bb_entry; prev && prev->next_bb != header; prev = prev->next_bb)
+		;
+	if (!prev || (prev->last_ins && (prev->last_ins->opcode == OP_SWITCH || prev->last_ins->opcode == OP_BR_REG)))
+		return FALSE;
+	if (preheader->last_ins->opcode == OP_SWITCH || preheader->last_ins->opcode == OP_BR_REG)
+		return FALSE;
+
+	memset (&vl, 0, sizeof (vl));
+	vl.cfg = cfg;
+	vl.header = header;
+	vl.body = body;
+	vl.preheader = preheader;
+	vl.iv = get_vreg_to_inst (cfg, cmp->sreg1);
+	if (!vl.iv || vl.iv->opcode == OP_ARG || vl.iv->type != STACK_I4 || (vl.iv->flags & (MONO_INST_VOLATILE | MONO_INST_INDIRECT)))
+		return FALSE;
+
+	vl.max_vreg = cfg->next_vreg;
+	vl.vregs = g_new0 (int, vl.max_vreg);
+	vl.kinds = g_new0 (guint8, vl.max_vreg);
+	vl.loop_defs = g_new0 (gboolean, vl.max_vreg);
+	hregs = g_new0 (int, vl.max_vreg);
+
+	/* Vars defined in the loop, the iv can only be incremented by the body */
+	for (bb = header; bb; bb = bb == header ? body : NULL) {
+		MONO_BB_FOR_EACH_INS (bb, ins) {
+			if (ins->dreg != -1 && ins->dreg < vl.max_vreg && !MONO_IS_STORE_MEMBASE (ins) && get_vreg_to_inst (cfg, ins->dreg)) {
+				if (ins->dreg != vl.iv->dreg || bb != body)
+					goto done;
+				vl.loop_defs [ins->dreg] = TRUE;
+			}
+		}
+	}
+
+	if (cmp->opcode == OP_ICOMPARE) {
+		if (cmp->sreg2 == vl.iv->dreg)
+			goto done;
+		if (get_vreg_to_inst (cfg, cmp->sreg2) && !vloop_is_invariant (&vl, cmp->sreg2))
+			goto done;
+	}
+	for (ins = header->code; ins != cmp; ins = ins->next) {
+		if (!vloop_is_header_ins (&vl, ins))
+			goto done;
+	}
+
+	/* The vector loop body, which is a do-while loop */
+	vbody = vloop_new_bblock (&vl);
+	cfg->cbb = vbody;
+	if (!vloop_emit_body (&vl))
+		goto done;
+	lim = mono_compile_create_var (cfg, m_class_get_byval_arg (mono_defaults.int32_class), OP_LOCAL);
+	MONO_EMIT_NEW_BIALU_IMM (cfg, OP_IADD_IMM, vl.iv->dreg, vl.iv->dreg, vl.nelems);
+	MONO_EMIT_NEW_BIALU (cfg, OP_ICOMPARE, -1, vl.iv->dreg, lim->dreg);
+	MONO_INST_NEW (cfg, ins, OP_IBLT);
+	ins->inst_true_bb = vbody;
+	ins->inst_false_bb = header;
+	MONO_ADD_INS (vbody, ins);
+	mono_link_bblock (cfg, vbody, vbody);
+	mono_link_bblock (cfg, vbody, header);
+
+	/* The entry checks, they fall back to the scalar loop */
+	entry = vloop_new_bblock (&vl);
+	cfg->cbb = entry;
+	for (ins = header->code; ins != cmp; ins = ins->next) {
+		MonoInst *copy;
+
+		if (ins->opcode == OP_NOP)
+			continue;
+		MONO_INST_NEW (cfg, copy, ins->opcode);
+		copy->type = ins->type;
+		copy->flags = ins->flags;
+		copy->inst_c0 = ins->inst_c0;
+		copy->inst_imm = ins->inst_imm;
+		copy->sreg1 = (ins->sreg1 != -1 && hregs [ins->sreg1]) ? hregs [ins->sreg1] : ins->sreg1;
+		copy->dreg = hregs [ins->dreg] = alloc_dreg (cfg, (MonoStackType)ins->type);
+		MONO_ADD_INS (cfg->cbb, copy);
+		if (ins->opcode == OP_LDLEN) {
+			cfg->flags |= MONO_CFG_NEEDS_DECOMPOSE;
+			cfg->cbb->needs_decompose = TRUE;
+		}
+	}
+	if (cmp->opcode == OP_ICOMPARE_IMM) {
+		bound_reg = alloc_ireg (cfg);
+		MONO_EMIT_NEW_ICONST (cfg, bound_reg, cmp->inst_imm);
+	} else {
+		bound_reg = hregs [cmp->sreg2] ? hregs [cmp->sreg2] : cmp->sreg2;
+	}
+	/* lim = MIN (bound, length of each array) - (nelems - 1) */
+	MONO_EMIT_NEW_BIALU_IMM (cfg, OP_ISUB_IMM, lim->dreg, bound_reg, vl.nelems - 1);
+	/* 0 <= iv < bound, so the loop runs at least once, and the array accesses below can fault */
+	MONO_EMIT_NEW_BIALU (cfg, OP_ICOMPARE, -1, vl.iv->dreg, bound_reg);
+	vloop_emit_branch (&vl, OP_IBGE, header);
+	MONO_EMIT_NEW_BIALU_IMM (cfg, OP_ICOMPARE_IMM, -1, vl.iv->dreg, 0);
+	vloop_emit_branch (&vl, OP_IBLT, header);
+	for (l = vl.arrays; l; l = l->next) {
+		int len_reg = alloc_ireg (cfg);
+
+		MONO_EMIT_NEW_LOAD_MEMBASE_OP_FAULT (cfg, OP_LOADI4_MEMBASE, len_reg, GPOINTER_TO_INT (l->data), MONO_STRUCT_OFFSET (MonoArray, max_length));
+		MONO_EMIT_NEW_BIALU_IMM (cfg, OP_ISUB_IMM, len_reg, len_reg, vl.nelems - 1);
+		MONO_EMIT_NEW_BIALU (cfg, OP_IMIN, lim->dreg, lim->dreg, len_reg);
+	}
+	MONO_EMIT_NEW_BIALU (cfg, OP_ICOMPARE, -1, vl.iv->dreg, lim->dreg);
+	vloop_emit_branch (&vl, OP_IBGE, header);
+	MONO_INST_NEW (cfg, ins, OP_BR);
+	ins->inst_target_bb = vbody;
+	MONO_ADD_INS (cfg->cbb, ins);
+	mono_link_bblock (cfg, cfg->cbb, vbody);
+
+	/* Link the new code in front of the loop header */
+	if (!prev->last_ins || (prev->last_ins->opcode != OP_BR && !MONO_IS_COND_BRANCH_OP (prev->last_ins))) {
+		for (i = 0; i < prev->out_count; ++i) {
+			if (prev->out_bb [i] == header) {
+				MONO_INST_NEW (cfg, ins, OP_BR);
+				ins->inst_target_bb = header;
+				MONO_ADD_INS (prev, ins);
+				break;
+			}
+		}
+	}
+	prev->next_bb = entry;
+	cfg->cbb->next_bb = vbody;
+	vbody->next_bb = header;
+
+	ins = preheader->last_ins;
+	if (ins->opcode == OP_BR) {
+		g_assert (ins->inst_target_bb == header);
+		ins->inst_target_bb = entry;
+	} else {
+		if (ins->inst_true_bb == header)
+			ins->inst_true_bb = entry;
+		if (ins->inst_false_bb == header)
+			ins->inst_false_bb = entry;
+	}
+	mono_unlink_bblock (cfg, preheader, header);
+	mono_link_bblock (cfg, preheader, entry);
+
+	cfg->uses_simd_intrinsics |= MONO_CFG_USES_SIMD_INTRINSICS;
+	if (cfg->verbose_level > 2)
+		printf ("Vectorized loop BB%d-BB%d, %d elements per iteration.\n", header->block_num, body->block_num, vl.nelems);
+	res = TRUE;
+
+done:
+	g_free (vl.vregs);
+	g_free (vl.kinds);
+	g_free (vl.loop_defs);
+	g_free (hregs);
+	return res;
+}
+
+/*
+ * mono_simd_vectorize_loops:
+ *
+ *   Add vectorized copies of simple loops over arrays, see the comment above.
+ */
+void
+mono_simd_vectorize_loops (MonoCompile *cfg)
+{
+	MonoBasicBlock *bb;
+	GSList *headers = NULL, *l;
+
+	if (!(simd_supported_versions & SIMD_VERSION_SSE2) || !(cfg->opt & MONO_OPT_CMOV))
+		return;
+
+	for (bb = cfg->bb_entry; bb; bb = bb->next_bb) {
+		if (bb->out_count == 2 && bb->in_count == 2)
+			headers = g_slist_prepend (headers, bb);
+	}
+
+	for (l = headers; l; l = l->next) {
+		MonoBasicBlock *header = (MonoBasicBlock *)l->data;
+		int i;
+
+		for (i = 0; i < header->out_count; ++i) {
+			if (vectorize_loop (cfg, header, header->out_bb [i]))
+				break;
+		}
+	}
+	g_slist_free (headers);
+}
+
 #endif /* DISABLE_JIT */
 #endif /* MONO_ARCH_SIMD_INTRINSICS */
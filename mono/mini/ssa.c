@@ -1430,8 +1430,10 @@ mono_ssa_loop_invariant_code_motion (MonoCompile *cfg)
 	int i;
 
 	g_assert (cfg->comp_done & MONO_COMP_SSA);
-	if (!(cfg->comp_done & MONO_COMP_LOOPS) || !(cfg->comp_done & MONO_COMP_SSA_DEF_USE))
+	if (!(cfg->comp_done & MONO_COMP_LOOPS))
 		return;
+	if (!(cfg->comp_done & MONO_COMP_SSA_DEF_USE))
+		mono_ssa_create_def_use (cfg);
 
 	for (bb = cfg->bb_entry->next_bb; bb; bb = bb->next_bb) {
 		GList *lp = bb->loop_blocks;
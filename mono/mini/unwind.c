@@ -10,6 +10,7 @@
 
 #include "mini.h"
 #include "mini-unwind.h"
+#include "mini-runtime.h"
 
 #include <mono/utils/mono-counters.h>
 #include <mono/utils/freebsd-dwarf.h>
@@ -538,6 +539,80 @@ typedef struct {
 	int cfa_reg, cfa_offset;
 } UnwindState;
 
+/*
+ * Stack walks keep unwinding through the same call sites, so the decoded
+ * unwind state at an ip is remembered in a small per thread cache, which
+ * reduces unwinding such frames to a few loads. Entries are keyed by the
+ * unwind info and the ip and are invalidated by bumping unwind_cache_gen when
+ * code is freed.
+ */
+#define UNWIND_CACHE_SIZE 128
+
+typedef struct {
+	guint8 *unwind_info;
+	guint8 *ip;
+	gint32 gen;
+	gint16 cfa_reg;
+	guint8 nsaved;
+	gint32 cfa_offset;
+	guint8 saved_regs [NUM_HW_REGS];
+	gint32 saved_offsets [NUM_HW_REGS];
+} UnwindCacheEntry;
+
+typedef struct {
+	/* Set while an entry is updated, so a signal handler on the same thread doesn't see it half written */
+	gboolean busy;
+	UnwindCacheEntry entries [UNWIND_CACHE_SIZE];
+} UnwindCache;
+
+static gint32 unwind_cache_gen;
+
+static UnwindCache*
+get_unwind_cache (gboolean create)
+{
+	MonoJitTlsData *jit_tls = mono_tls_get_jit_tls ();
+	UnwindCache *cache;
+
+	if (!jit_tls || mono_thread_info_is_async_context ())
+		return NULL;
+	cache = (UnwindCache*)jit_tls->unwind_cache;
+	if (!cache && create) {
+		cache = g_new0 (UnwindCache, 1);
+		jit_tls->unwind_cache = cache;
+	}
+	if (cache && cache->busy)
+		return NULL;
+	return cache;
+}
+
+static inline UnwindCacheEntry*
+unwind_cache_entry (UnwindCache *cache, guint8 *unwind_info, guint8 *ip)
+{
+	return &cache->entries [(((gsize)ip >> 2) ^ ((gsize)unwind_info >> 3)) & (UNWIND_CACHE_SIZE - 1)];
+}
+
+/*
+ * mono_unwind_cache_invalidate:
+ *
+ *   Called when code or its unwind info is freed, since the addresses might be reused.
+ */
+void
+mono_unwind_cache_invalidate (void)
+{
+	mono_atomic_inc_i32 (&unwind_cache_gen);
+}
+
+/*
+ * mono_unwind_cache_free:
+ *
+ *   Free the unwind cache of a thread, CACHE is MonoJitTlsData.unwind_cache.
+ */
+void
+mono_unwind_cache_free (gpointer cache)
+{
+	g_free (cache);
+}
+
 /*
  * Given the state of the current frame as stored in REGS, execute the unwind 
  * operations in unwind_info until the location counter reaches POS. The result is 
@@ -564,8 +639,27 @@ mono_unwind_frame (guint8 *unwind_info, guint32 unwind_info_len,
 	guint8 *cfa_val;
 	UnwindState state_stack [1];
 	int state_stack_pos;
+	UnwindCache *cache;
+	UnwindCacheEntry *entry = NULL;
+	gboolean cacheable = TRUE;
 
 	memset (reg_saved, 0, sizeof (reg_saved));
+
+	cache = get_unwind_cache (FALSE);
+	if (cache) {
+		entry = unwind_cache_entry (cache, unwind_info, ip);
+		if (entry->unwind_info == unwind_info && entry->ip == ip && entry->gen == unwind_cache_gen) {
+			cfa_reg = entry->cfa_reg;
+			cfa_offset = entry->cfa_offset;
+			for (int i = 0; i < entry->nsaved; ++i) {
+				hwreg = entry->saved_regs [i];
+				reg_saved [hwreg] = TRUE;
+				locations [hwreg].loc_type = LOC_OFFSET;
+				locations [hwreg].offset = entry->saved_offsets [i];
+			}
+			goto decoded;
+		}
+	}
 	state_stack [0].cfa_reg = -1;
 	state_stack [0].cfa_offset = 0;
 
@@ -672,6 +766,8 @@ mono_unwind_frame (guint8 *unwind_info, guint32 unwind_info_len,
 					return FALSE;
 				}
 				pos = mark_locations [0] - start_ip;
+				/* The position depends on the method, not just the unwind info */
+				cacheable = FALSE;
 				break;
 			default:
 				mono_runtime_printf_err ("Unwind failure. Illegal value for switch statement, assertion at %s %d\n.", __FILE__, __LINE__);
@@ -685,6 +781,30 @@ mono_unwind_frame (guint8 *unwind_info, guint32 unwind_info_len,
 		}
 	}
 
+	if (cacheable && cfa_reg != -1 && (cache = get_unwind_cache (TRUE))) {
+		int nsaved = 0;
+
+		cache->busy = TRUE;
+		mono_memory_barrier ();
+		entry = unwind_cache_entry (cache, unwind_info, ip);
+		entry->unwind_info = unwind_info;
+		entry->ip = ip;
+		entry->gen = unwind_cache_gen;
+		entry->cfa_reg = cfa_reg;
+		entry->cfa_offset = cfa_offset;
+		for (hwreg = 0; hwreg < NUM_HW_REGS; ++hwreg) {
+			if (reg_saved [hwreg] && locations [hwreg].loc_type == LOC_OFFSET) {
+				entry->saved_regs [nsaved] = hwreg;
+				entry->saved_offsets [nsaved] = locations [hwreg].offset;
+				nsaved ++;
+			}
+		}
+		entry->nsaved = nsaved;
+		mono_memory_barrier ();
+		cache->busy = FALSE;
+	}
+
+ decoded:
 	if (save_locations)
 		memset (save_locations, 0, save_locations_len * sizeof (host_mgreg_t*));
 
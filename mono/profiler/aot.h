@@ -46,7 +46,8 @@ typedef enum {
 	 */
 	AOTPROF_RECORD_GINST,
 	/*
-	 * Contains info about a JITed method.
+	 * Contains info about a JITed method. Method records are written in the order
+	 * the methods were first JITed, the AOT compiler uses it to order the code.
 	 * - int: record id for the containing class (AOTPROF_RECORD_TYPE)
 	 * - int: record id for the generic instance or -1 if N/A (AOTPROF_RECORD_GINST)
 	 * - int: parameter count
@@ -122,6 +122,9 @@ typedef struct {
 
 	//Filter files used by the code coverage mode
 	GPtrArray *cov_filter_files;
+
+	//Only record whether statements ran instead of counting them
+	gboolean hits;
 } ProfilerConfig;
 
 static ProfilerConfig coverage_config;
@@ -930,6 +933,8 @@ parse_arg (const char *arg)
 	// 	coverage_config.use_zip = TRUE;
 	} else if (match_option (arg, "output", &val)) {
 		coverage_config.output_filename = g_strdup (val);
+	} else if (match_option (arg, "hits", NULL)) {
+		coverage_config.hits = TRUE;
 	// } else if (match_option (arg, "covfilter", &val)) {
 	// 	g_error ("not supported");
 	} else if (match_option (arg, "covfilter-file", &val)) {
@@ -1008,6 +1013,7 @@ usage (void)
 	// mono_profiler_printf ("\t                     prefix a + to include the assembly or a - to exclude it");
 	// mono_profiler_printf ("\t                     e.g. covfilter=-mscorlib");
 	mono_profiler_printf ("\tcovfilter-file=FILE  use FILE to generate the list of assemblies to be filtered");
+	mono_profiler_printf ("\thits                 only record whether statements ran, not how often (much faster)");
 	mono_profiler_printf ("\toutput=FILENAME      write the data to file FILENAME (the file is always overwritten)");
 	mono_profiler_printf ("\toutput=+FILENAME     write the data to file FILENAME.pid (the file is always overwritten)");
 	mono_profiler_printf ("\toutput=|PROGRAM      write the data to the stdin of PROGRAM");
@@ -1083,5 +1089,7 @@ mono_profiler_init_coverage (const char *desc)
 	mono_profiler_set_assembly_loaded_callback (handle, assembly_loaded);
 
 	mono_profiler_enable_coverage ();
+	if (coverage_config.hits)
+		mono_profiler_enable_coverage_hits ();
 	mono_profiler_set_coverage_filter_callback (handle, coverage_filter);
 }
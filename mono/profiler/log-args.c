@@ -90,6 +90,11 @@ parse_arg (const char *arg, ProfilerConfig *config)
 			if (compat_args_parsing)
 				config->enable_mask |= PROFLOG_GC_MOVE_EVENTS;
 		}
+	} else if (match_option (arg, "heapshot-streaming", &val)) {
+		char *end;
+		config->hs_slice_ms = val ? strtoul (val, &end, 10) : 0;
+		if (!config->hs_slice_ms)
+			config->hs_slice_ms = 5;
 	} else if (match_option (arg, "heapshot-on-shutdown", NULL)) {
 		config->hs_on_shutdown = TRUE;
 		config->enable_mask |= PROFLOG_HEAPSHOT_ALIAS;
@@ -101,8 +106,38 @@ parse_arg (const char *arg, ProfilerConfig *config)
 		set_sample_freq (config, val);
 		config->sampling_mode = MONO_PROFILER_SAMPLE_MODE_REAL;
 		config->enable_mask |= PROFLOG_SAMPLE_EVENTS;
+	} else if (match_option (arg, "sample-folded", &val)) {
+		if (!val) {
+			mono_profiler_printf_err ("The sample-folded option needs a file name");
+			return;
+		}
+		config->folded_filename = g_strdup (val);
+		if (config->sampling_mode == MONO_PROFILER_SAMPLE_MODE_NONE) {
+			config->sampling_mode = MONO_PROFILER_SAMPLE_MODE_PROCESS;
+			config->enable_mask |= PROFLOG_SAMPLE_EVENTS;
+		}
+	} else if (match_option (arg, "sample-folded-interval", &val)) {
+		char *end;
+		int interval = val ? strtoul (val, &end, 10) : 0;
+		if (interval)
+			config->folded_interval = interval;
+	} else if (match_option (arg, "nettrace", &val)) {
+		if (!val) {
+			mono_profiler_printf_err ("The nettrace option needs a file name");
+			return;
+		}
+		config->nettrace_filename = g_strdup (val);
+		config->enable_mask |= PROFLOG_GC_EVENTS | PROFLOG_JIT_EVENTS | PROFLOG_MONITOR_EVENTS;
+	} else if (match_option (arg, "allocsample", &val)) {
+		char *end;
+		config->alloc_sample_interval = val ? strtoul (val, &end, 10) : 0;
+		if (!config->alloc_sample_interval)
+			config->alloc_sample_interval = 512 * 1024;
 	} else if (match_option (arg, "calls", NULL)) {
 		config->enter_leave = TRUE;
+	} else if (match_option (arg, "calls-ondemand", NULL)) {
+		config->enter_leave = TRUE;
+		config->enter_leave_on_demand = TRUE;
 	} else if (match_option (arg, "nocalls", NULL)) {
 		if (!compat_args_parsing)
 			mono_profiler_printf_err ("Could not parse argument '%s'", arg);
@@ -115,6 +150,12 @@ parse_arg (const char *arg, ProfilerConfig *config)
 	} else if (match_option (arg, "port", &val)) {
 		char *end;
 		config->command_port = strtoul (val, &end, 10);
+	} else if (match_option (arg, "maxqueue", &val)) {
+		char *end;
+		config->max_queued_mb = strtoul (val, &end, 10);
+	} else if (match_option (arg, "lockwait", &val)) {
+		char *end;
+		config->lock_wait_us = strtoul (val, &end, 10);
 	} else if (match_option (arg, "maxframes", &val)) {
 		char *end;
 		int num_frames = strtoul (val, &end, 10);
@@ -176,6 +217,8 @@ load_args_from_env_or_default (ProfilerConfig *config)
 	config->sample_freq = 100;
 	config->max_call_depth = 100;
 	config->num_frames = MAX_FRAMES;
+	config->folded_interval = 10;
+	config->lock_wait_us = 100;
 }
 
 
@@ -324,20 +367,39 @@ usage (void)
 	mono_profiler_printf ("\tsample[-real][=FREQ] enable/disable statistical sampling of threads");
 	mono_profiler_printf ("\t                     FREQ in Hz, 100 by default");
 	mono_profiler_printf ("\t                     the -real variant uses wall clock time instead of process time");
+	mono_profiler_printf ("\tsample-folded=FILE   aggregate samples in process and write them to FILE as");
+	mono_profiler_printf ("\t                     collapsed call stacks with counts instead of logging each of them");
+	mono_profiler_printf ("\t                     implies sample if no sampling option is given");
+	mono_profiler_printf ("\tsample-folded-interval=SEC rewrite the folded samples file every SEC seconds, 10 by default");
+	mono_profiler_printf ("\tnettrace=FILE        also write GC, JIT and monitor contention events to FILE in the");
+	mono_profiler_printf ("\t                     nettrace format read by PerfView and TraceEvent, implies gc,jit,monitor");
+	mono_profiler_printf ("\tallocsample[=BYTES]  record one allocation for every BYTES allocated bytes on average");
+	mono_profiler_printf ("\t                     BYTES is 512k by default, managed allocators are left enabled");
 	mono_profiler_printf ("\theapshot[=MODE]      record heapshot info (by default at each major collection)");
 	mono_profiler_printf ("\t                     MODE: every XXms milliseconds, every YYgc collections, ondemand");
+	mono_profiler_printf ("\theapshot-streaming[=MS] walk the heap for heapshots in pauses of MS milliseconds");
+	mono_profiler_printf ("\t                     MS is 5 by default, the rest of the heap is walked by the first major collection");
 	mono_profiler_printf ("\theapshot-on-shutdown do a heapshot on runtime shutdown");
 	mono_profiler_printf ("\t                     this option is independent of the above option");
 	mono_profiler_printf ("\tcalls                enable recording enter/leave method events (very heavy)");
+	mono_profiler_printf ("\tcalls-ondemand       instrument methods for enter/leave events, but only record them");
+	mono_profiler_printf ("\t                     between the 'calls on' and 'calls off' commands of the command server");
+	mono_profiler_printf ("\t                     use callspec to limit the instrumented methods");
 	mono_profiler_printf ("\tmaxframes=NUM        collect up to NUM stack frames");
+	mono_profiler_printf ("\tlockwait=USEC        with monitor events, also report runtime lock contention (loader, domain,");
+	mono_profiler_printf ("\t                     marshal, ...) when a lock was waited for at least USEC microseconds, 100 by default");
 	mono_profiler_printf ("\tcalldepth=NUM        ignore method events for call chain depth bigger than NUM");
 	mono_profiler_printf ("\toutput=FILENAME      write the data to file FILENAME (the file is always overwritten)");
 	mono_profiler_printf ("\toutput=+FILENAME     write the data to file FILENAME.pid (the file is always overwritten)");
 	mono_profiler_printf ("\toutput=|PROGRAM      write the data to the stdin of PROGRAM");
+	mono_profiler_printf ("\toutput=@HOST:PORT    write the data to a TCP connection to HOST:PORT");
+	mono_profiler_printf ("\toutput=@/PATH        write the data to the Unix domain socket at PATH");
 	mono_profiler_printf ("\t                     %%t is substituted with date and time, %%p with the pid");
 	mono_profiler_printf ("\treport               create a report instead of writing the raw data to a file");
 	mono_profiler_printf ("\tzip                  compress the output data");
 	mono_profiler_printf ("\tport=PORTNUM         use PORTNUM for the listening command server");
+	mono_profiler_printf ("\tmaxqueue=MB          drop allocation, GC, call, exception, monitor and sample events");
+	mono_profiler_printf ("\t                     instead of queueing more than MB megabytes for the writer");
 
 	exit (0);
 }
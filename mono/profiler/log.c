@@ -42,6 +42,7 @@
 #include <mono/utils/mono-mmap.h>
 #include <mono/utils/mono-os-mutex.h>
 #include <mono/utils/mono-os-semaphore.h>
+#include <mono/utils/mono-proclib.h>
 #include <mono/utils/mono-threads.h>
 #include <mono/utils/mono-threads-api.h>
 #include <mono/utils/mono-threads-coop.h>
@@ -49,6 +50,7 @@
 #include <mono/utils/os-event.h>
 #include "log.h"
 #include "helper.h"
+#include "nettrace.h"
 
 #ifdef HAVE_DLFCN_H
 #include <dlfcn.h>
@@ -71,6 +73,8 @@
 #endif
 #ifndef HOST_WIN32
 #include <sys/socket.h>
+#include <sys/un.h>
+#include <netdb.h>
 #endif
 #if defined (HAVE_SYS_ZLIB)
 #include <zlib.h>
@@ -87,7 +91,8 @@
 
 // Statistics for internal profiler data structures.
 static gint32 sample_allocations_ctr,
-              buffer_allocations_ctr;
+              buffer_allocations_ctr,
+              buffer_drops_ctr;
 
 // Statistics for profiler events.
 static gint32 sync_points_ctr,
@@ -157,6 +162,9 @@ struct _LogBuffer {
 	// Bytes allocated for this LogBuffer
 	int size;
 
+	// Whether the buffer has events that later events can refer to, so it can't be dropped
+	gboolean has_metadata;
+
 	// Start of currently unused space in buffer
 	unsigned char* cursor;
 
@@ -185,6 +193,9 @@ typedef struct {
 	// Current call depth for enter/leave events.
 	int call_depth;
 
+	// Value of `call_callbacks_generation` when `call_depth` was last reset.
+	gint32 call_generation;
+
 	// Indicates whether this thread is currently writing to its `buffer`.
 	gboolean busy;
 
@@ -193,6 +204,9 @@ typedef struct {
 
 	// Stored in `buffer_lock_state` to take the exclusive lock.
 	int small_id;
+
+	// Is this thread stopping the world to walk a heapshot slice?
+	gboolean walking_heap;
 } MonoProfilerThread;
 
 // Default value in `profiler_tls` for new threads.
@@ -313,6 +327,10 @@ struct _MonoProfiler {
 
 	int pipe_output;
 	int command_port;
+
+	// Bytes of the buffers in the writer queue, and the limit set by maxqueue
+	volatile gint64 queued_bytes;
+	gint64 max_queued_bytes;
 	int server_socket;
 
 #ifdef HAVE_COMMAND_PIPES
@@ -357,9 +375,17 @@ struct _MonoProfiler {
 	MonoLockFreeAllocator sample_allocator;
 	MonoLockFreeQueue sample_reuse_queue;
 
+	// Only touched by the dumper thread.
+	struct _SampleNode *sample_root;
+	uint64_t last_folded_time;
+
+	// Only touched by the writer thread, and at startup and shutdown.
+	NettraceWriter *nettrace;
+
 	BinaryObject *binary_objects;
 
 	volatile gint32 heapshot_requested;
+	volatile gint32 heapshot_streaming;
 	guint64 gc_count;
 	guint64 last_hs_time;
 	gboolean do_heap_walk;
@@ -539,12 +565,14 @@ init_thread (gboolean add_to_lls)
 	thread->attached = add_to_lls;
 	thread->did_detach = FALSE;
 	thread->call_depth = 0;
+	thread->call_generation = 0;
 	thread->busy = FALSE;
 	thread->ended = FALSE;
 
 	init_buffer_state (thread);
 
 	thread->small_id = mono_thread_info_register_small_id ();
+	thread->walking_heap = FALSE;
 
 	/*
 	 * Some internal profiler threads don't need to be cleaned up
@@ -816,9 +844,35 @@ emit_time (LogBuffer *logbuffer, uint64_t value)
 	g_assert (logbuffer->cursor <= logbuffer->buf_end && "Why are we writing past the buffer end?");
 }
 
+/*
+ * Events that no other event refers to, that can be dropped when the writer
+ * thread doesn't keep up. Everything else, e.g. metadata loads, JIT events
+ * or heapshots, has to make it to the output for the stream to be usable.
+ */
+static gboolean
+is_droppable_event (int event)
+{
+	switch (event & 0xf) {
+	case TYPE_ALLOC:
+	case TYPE_GC:
+	case TYPE_EXCEPTION:
+	case TYPE_MONITOR:
+		return TRUE;
+	case TYPE_METHOD:
+		return (event & 0xf0) != TYPE_JIT;
+	case TYPE_SAMPLE:
+		return (event & 0xf0) == TYPE_SAMPLE_HIT;
+	default:
+		return FALSE;
+	}
+}
+
 static void
 emit_event_time (LogBuffer *logbuffer, int event, uint64_t time)
 {
+	if (!is_droppable_event (event))
+		logbuffer->has_metadata = TRUE;
+
 	emit_byte (logbuffer, event);
 	emit_time (logbuffer, time);
 }
@@ -1056,9 +1110,42 @@ dump_header (void)
 static void
 send_buffer (MonoProfilerThread *thread)
 {
+	LogBuffer *buffer = thread->buffer;
+
+	if (log_profiler.max_queued_bytes) {
+		gint64 size = 0;
+		gboolean droppable = TRUE;
+
+		for (LogBuffer *iter = buffer; iter; iter = iter->next) {
+			size += iter->cursor - iter->buf;
+			droppable &= !iter->has_metadata;
+		}
+
+		/*
+		 * Don't let a writer that can't keep up, e.g. because of a slow
+		 * network sink, pile up memory or stall the threads that produce
+		 * the events.
+		 */
+		if (droppable && mono_atomic_load_i64 (&log_profiler.queued_bytes) + size > log_profiler.max_queued_bytes) {
+			while (buffer) {
+				LogBuffer *next = buffer->next;
+
+				free_buffer (buffer, buffer->size);
+				mono_atomic_inc_i32 (&buffer_drops_ctr);
+				buffer = next;
+			}
+
+			// The methods still need their metadata emitted.
+			if (!thread->methods)
+				return;
+		} else {
+			mono_atomic_add_i64 (&log_profiler.queued_bytes, size);
+		}
+	}
+
 	WriterQueueEntry *entry = mono_lock_free_alloc (&log_profiler.writer_entry_allocator);
 	entry->methods = thread->methods;
-	entry->buffer = thread->buffer;
+	entry->buffer = buffer;
 
 	mono_lock_free_queue_node_init (&entry->node, FALSE);
 
@@ -1136,6 +1223,9 @@ dump_buffer (LogBuffer *buf)
 			fwrite (buf->buf, buf->cursor - buf->buf, 1, log_profiler.file);
 			fflush (log_profiler.file);
 		}
+
+		if (log_profiler.nettrace)
+			nettrace_writer_add_buffer (log_profiler.nettrace, buf->buf, buf->cursor - buf->buf, buf->time_base, buf->ptr_base, buf->method_base, buf->thread_id);
 	}
 
 	free_buffer (buf, buf->size);
@@ -1330,6 +1420,26 @@ gc_root_deregister (MonoProfiler *prof, const mono_byte *start)
 	EXIT_LOG;
 }
 
+static void
+emit_heap_end (void)
+{
+	ENTER_LOG (&heap_ends_ctr, logbuffer,
+		EVENT_SIZE /* event */
+	);
+
+	emit_event (logbuffer, TYPE_HEAP_END | TYPE_HEAP);
+
+	EXIT_LOG;
+}
+
+// Whoever notices first that a streamed heap walk is done ends the heapshot.
+static void
+heapshot_streaming_done (void)
+{
+	if (mono_atomic_cas_i32 (&log_profiler.heapshot_streaming, 0, 1) == 1)
+		emit_heap_end ();
+}
+
 static void
 trigger_heapshot (void)
 {
@@ -1347,12 +1457,31 @@ process_heapshot (void)
 
 #define ALL_GC_EVENTS_MASK (PROFLOG_GC_EVENTS | PROFLOG_GC_MOVE_EVENTS | PROFLOG_GC_ROOT_EVENTS)
 
+static gboolean
+walk_heap_step (int budget_us)
+{
+	MonoProfilerThread *thread = get_thread ();
+	gboolean done;
+
+	thread->walking_heap = TRUE;
+	done = mono_gc_walk_heap_step (budget_us);
+	thread->walking_heap = FALSE;
+
+	return done;
+}
+
 static void
 gc_event (MonoProfiler *profiler, MonoProfilerGCEvent ev, uint32_t generation, gboolean is_serial)
 {
 	gboolean is_major = generation == mono_gc_max_generation ();
 
-	if (ENABLED (PROFLOG_GC_EVENTS)) {
+	/*
+	 * The pauses of a streamed heapshot aren't gen0 collections, so don't log them
+	 * as such. The buffers still have to be locked and flushed around them.
+	 */
+	gboolean heap_walk_pause = get_thread ()->walking_heap;
+
+	if (ENABLED (PROFLOG_GC_EVENTS) && !heap_walk_pause) {
 		ENTER_LOG (&gc_events_ctr, logbuffer,
 			EVENT_SIZE /* event */ +
 			BYTE_SIZE /* gc event */ +
@@ -1368,6 +1497,11 @@ gc_event (MonoProfiler *profiler, MonoProfilerGCEvent ev, uint32_t generation, g
 
 	switch (ev) {
 	case MONO_GC_EVENT_PRE_STOP_WORLD_LOCKED:
+		if (heap_walk_pause) {
+			buffer_lock_excl ();
+			break;
+		}
+
 		switch (log_config.hs_mode) {
 		case MONO_PROFILER_HEAPSHOT_NONE:
 			log_profiler.do_heap_walk = FALSE;
@@ -1392,9 +1526,13 @@ gc_event (MonoProfiler *profiler, MonoProfilerGCEvent ev, uint32_t generation, g
 		 * heapshot_requested is set either because a heapshot was triggered
 		 * manually (through the API or command server) or because we're doing
 		 * a shutdown heapshot. Either way, a manually triggered heapshot
-		 * overrides any decision we made in the switch above.
+		 * overrides any decision we made in the switch above, unless the
+		 * previous heapshot is still being streamed.
 		 */
-		if (is_major && is_serial && mono_atomic_load_i32 (&log_profiler.heapshot_requested)) {
+		if (mono_atomic_load_i32 (&log_profiler.heapshot_streaming)) {
+			log_profiler.do_heap_walk = FALSE;
+			mono_atomic_store_i32 (&log_profiler.heapshot_requested, 0);
+		} else if (is_major && is_serial && mono_atomic_load_i32 (&log_profiler.heapshot_requested)) {
 			log_profiler.do_heap_walk = TRUE;
 		} else if (log_profiler.do_heap_walk && (!is_major || !is_serial)) {
 			/* Do a heap walk later, when we get invoked from the finalizer in serial mode */
@@ -1437,24 +1575,27 @@ gc_event (MonoProfiler *profiler, MonoProfilerGCEvent ev, uint32_t generation, g
 
 		break;
 	case MONO_GC_EVENT_START:
-		if (is_major)
+		if (is_major) {
 			log_profiler.gc_count++;
 
+			// The GC has finished walking the heap for us.
+			heapshot_streaming_done ();
+		}
+
 		break;
 	case MONO_GC_EVENT_PRE_START_WORLD:
 		mono_profiler_set_gc_roots_callback (log_profiler.handle, NULL);
 
 		if (log_profiler.do_heap_walk) {
 			g_assert (is_major && is_serial);
-			mono_gc_walk_heap (0, gc_reference, NULL);
-
-			ENTER_LOG (&heap_ends_ctr, logbuffer,
-				EVENT_SIZE /* event */
-			);
 
-			emit_event (logbuffer, TYPE_HEAP_END | TYPE_HEAP);
-
-			EXIT_LOG;
+			// Leave the rest of the heap to the helper thread.
+			if (log_config.hs_slice_ms && !mono_gc_walk_heap_begin (0, gc_reference, NULL))
+				mono_atomic_store_i32 (&log_profiler.heapshot_streaming, 1);
+			else {
+				mono_gc_walk_heap (0, gc_reference, NULL);
+				emit_heap_end ();
+			}
 
 			log_profiler.do_heap_walk = FALSE;
 			log_profiler.last_hs_time = current_time ();
@@ -1576,6 +1717,12 @@ gc_alloc (MonoProfiler *prof, MonoObject *obj)
 	EXIT_LOG;
 }
 
+static void
+gc_alloc_sampled (MonoProfiler *prof, MonoObject *obj, uint64_t weight)
+{
+	gc_alloc (prof, obj);
+}
+
 static void
 gc_moves (MonoProfiler *prof, MonoObject *const *objects, uint64_t num)
 {
@@ -1913,10 +2060,31 @@ vtable_loaded (MonoProfiler *prof, MonoVTable *vtable)
 	EXIT_LOG;
 }
 
+/*
+ * Incremented after the enter/leave callbacks are toggled with calls-ondemand.
+ * Frames entered before that have no balanced events, so the call depth of a
+ * thread starts over from 0 when it sees a new generation.
+ */
+static volatile gint32 call_callbacks_generation;
+
+static MonoProfilerThread *
+get_call_thread (void)
+{
+	MonoProfilerThread *thread = get_thread ();
+	gint32 generation = mono_atomic_load_i32 (&call_callbacks_generation);
+
+	if (G_UNLIKELY (thread->call_generation != generation)) {
+		thread->call_generation = generation;
+		thread->call_depth = 0;
+	}
+
+	return thread;
+}
+
 static void
 method_enter (MonoProfiler *prof, MonoMethod *method, MonoProfilerCallContext *ctx)
 {
-	if (get_thread ()->call_depth++ <= log_config.max_call_depth) {
+	if (get_call_thread ()->call_depth++ <= log_config.max_call_depth) {
 		ENTER_LOG (&method_entries_ctr, logbuffer,
 			EVENT_SIZE /* event */ +
 			LEB128_SIZE /* method */
@@ -1932,7 +2100,13 @@ method_enter (MonoProfiler *prof, MonoMethod *method, MonoProfilerCallContext *c
 static void
 method_leave (MonoProfiler *prof, MonoMethod *method, MonoProfilerCallContext *ctx)
 {
-	if (--get_thread ()->call_depth <= log_config.max_call_depth) {
+	MonoProfilerThread *thread = get_call_thread ();
+
+	// The method was entered before the callbacks were turned on.
+	if (!thread->call_depth)
+		return;
+
+	if (--thread->call_depth <= log_config.max_call_depth) {
 		ENTER_LOG (&method_exits_ctr, logbuffer,
 			EVENT_SIZE /* event */ +
 			LEB128_SIZE /* method */
@@ -1954,7 +2128,12 @@ tailcall (MonoProfiler *prof, MonoMethod *method, MonoMethod *target)
 static void
 method_exc_leave (MonoProfiler *prof, MonoMethod *method, MonoObject *exc)
 {
-	if (--get_thread ()->call_depth <= log_config.max_call_depth) {
+	MonoProfilerThread *thread = get_call_thread ();
+
+	if (!thread->call_depth)
+		return;
+
+	if (--thread->call_depth <= log_config.max_call_depth) {
 		ENTER_LOG (&method_exception_exits_ctr, logbuffer,
 			EVENT_SIZE /* event */ +
 			LEB128_SIZE /* method */
@@ -1967,6 +2146,25 @@ method_exc_leave (MonoProfiler *prof, MonoMethod *method, MonoObject *exc)
 	}
 }
 
+/*
+ * The JIT skips the calls to the callbacks of instrumented methods while no
+ * enter/leave callbacks are installed, so with calls-ondemand these can be
+ * toggled through the command server at a negligible cost while turned off.
+ */
+static void
+set_call_callbacks (gboolean enable)
+{
+	MonoProfilerHandle handle = log_profiler.handle;
+
+	mono_profiler_set_method_enter_callback (handle, enable ? method_enter : NULL);
+	mono_profiler_set_method_leave_callback (handle, enable ? method_leave : NULL);
+	mono_profiler_set_method_tail_call_callback (handle, enable ? tailcall : NULL);
+	mono_profiler_set_method_exception_leave_callback (handle, enable ? method_exc_leave : NULL);
+
+	// After the callbacks, so no thread keeps counting from the old generation.
+	mono_atomic_inc_i32 (&call_callbacks_generation);
+}
+
 static MonoProfilerCallInstrumentationFlags
 method_filter (MonoProfiler *prof, MonoMethod *method)
 {
@@ -2125,6 +2323,54 @@ monitor_failed (MonoProfiler *prof, MonoObject *object)
 	monitor_event (prof, object, MONO_PROFILER_MONITOR_FAIL);
 }
 
+static void
+runtime_lock_contention (MonoProfiler *prof, const char *name, const void *lock, uint64_t wait_ns)
+{
+	MonoProfilerThread *thread = PROF_TLS_GET ();
+
+	if (wait_ns < (uint64_t) log_config.lock_wait_us * 1000)
+		return;
+
+	/*
+	 * Runtime locks are also taken by threads that have already been torn
+	 * down and by the profiler itself while it is writing an event.
+	 */
+	if (thread == MONO_PROFILER_THREAD_DEAD || (thread != MONO_PROFILER_THREAD_ZERO && thread->busy))
+		return;
+
+	int do_bt = (!log_config.enter_leave && mono_atomic_load_i32 (&log_profiler.runtime_inited) && log_config.num_frames) ? TYPE_MONITOR_BT : 0;
+	FrameData data;
+	size_t name_len = strlen (name) + 1;
+
+	if (do_bt)
+		collect_bt (&data);
+
+	ENTER_LOG (&monitor_events_ctr, logbuffer,
+		EVENT_SIZE /* event */ +
+		BYTE_SIZE /* ev */ +
+		LEB128_SIZE /* lock */ +
+		LEB128_SIZE /* wait */ +
+		name_len /* name */ +
+		(do_bt ? (
+			LEB128_SIZE /* count */ +
+			data.count * (
+				LEB128_SIZE /* method */
+			)
+		) : 0)
+	);
+
+	emit_event (logbuffer, do_bt | TYPE_MONITOR);
+	emit_byte (logbuffer, MONO_PROFILER_MONITOR_RUNTIME_LOCK);
+	emit_ptr (logbuffer, lock);
+	emit_uvalue (logbuffer, wait_ns);
+	emit_string (logbuffer, name, name_len);
+
+	if (do_bt)
+		emit_bt (logbuffer, &data);
+
+	EXIT_LOG;
+}
+
 static void
 thread_start (MonoProfiler *prof, uintptr_t tid)
 {
@@ -2956,6 +3202,11 @@ log_early_shutdown (MonoProfiler *prof)
 {
 	dump_aot_id ();
 
+	if (mono_atomic_load_i32 (&log_profiler.heapshot_streaming)) {
+		walk_heap_step (0);
+		heapshot_streaming_done ();
+	}
+
 	if (log_config.hs_on_shutdown) {
 		mono_atomic_store_i32 (&log_profiler.heapshot_requested, 1);
 		mono_gc_collect (mono_gc_max_generation ());
@@ -3059,6 +3310,9 @@ log_shutdown (MonoProfiler *prof)
 	g_assert (!(state & 0xFFFF) && "Why is the reader count still non-zero?");
 	g_assert (!(state >> 16) && "Why is the exclusive lock still held?");
 
+	if (prof->nettrace)
+		nettrace_writer_close (prof->nettrace);
+
 #if defined (HAVE_SYS_ZLIB)
 	if (prof->gzfile)
 		gzclose (prof->gzfile);
@@ -3212,6 +3466,7 @@ helper_thread (void *arg)
 	MonoProfilerThread *thread = profiler_thread_begin ("Profiler Helper", TRUE);
 
 	GArray *command_sockets = g_array_new (FALSE, FALSE, sizeof (int));
+	guint64 last_periodic = current_time ();
 
 	while (1) {
 		fd_set rfds;
@@ -3229,6 +3484,13 @@ helper_thread (void *arg)
 			add_to_fd_set (&rfds, g_array_index (command_sockets, int, i), &max_fd);
 
 		struct timeval tv = { .tv_sec = 1, .tv_usec = 0 };
+		gboolean streaming = mono_atomic_load_i32 (&log_profiler.heapshot_streaming);
+
+		// Let the program run for twice as long as each heapshot slice takes.
+		if (streaming) {
+			tv.tv_sec = 0;
+			tv.tv_usec = log_config.hs_slice_ms * 2000;
+		}
 
 		// Sleep for 1sec or until a file descriptor has data.
 		if (select (max_fd + 1, &rfds, NULL, NULL, &tv) == -1) {
@@ -3239,14 +3501,21 @@ helper_thread (void *arg)
 			exit (1);
 		}
 
-		if (ENABLED (PROFLOG_COUNTER_EVENTS))
-			counters_and_perfcounters_sample ();
+		if (streaming && walk_heap_step (log_config.hs_slice_ms * 1000))
+			heapshot_streaming_done ();
 
-		buffer_lock_excl ();
+		if (!streaming || (current_time () - last_periodic) / TICKS_PER_MSEC >= 1000) {
+			if (ENABLED (PROFLOG_COUNTER_EVENTS))
+				counters_and_perfcounters_sample ();
 
-		sync_point (SYNC_POINT_PERIODIC);
+			buffer_lock_excl ();
 
-		buffer_unlock_excl ();
+			sync_point (SYNC_POINT_PERIODIC);
+
+			buffer_unlock_excl ();
+
+			last_periodic = current_time ();
+		}
 
 		// Did we get a shutdown or detach signal?
 #ifdef HAVE_COMMAND_PIPES
@@ -3295,6 +3564,10 @@ helper_thread (void *arg)
 
 			if (!strcmp (buf, "heapshot\n"))
 				trigger_heapshot ();
+			else if (log_config.enter_leave_on_demand && !strcmp (buf, "calls on\n"))
+				set_call_callbacks (TRUE);
+			else if (log_config.enter_leave_on_demand && !strcmp (buf, "calls off\n"))
+				set_call_callbacks (FALSE);
 		}
 
 		if (FD_ISSET (log_profiler.server_socket, &rfds)) {
@@ -3430,7 +3703,18 @@ handle_writer_queue_entry (void)
 		}
 
 	no_methods:
-		dump_buffer (entry->buffer);
+		if (entry->buffer) {
+			if (log_profiler.max_queued_bytes) {
+				gint64 size = 0;
+
+				for (LogBuffer *iter = entry->buffer; iter; iter = iter->next)
+					size += iter->cursor - iter->buf;
+
+				mono_atomic_add_i64 (&log_profiler.queued_bytes, -size);
+			}
+
+			dump_buffer (entry->buffer);
+		}
 
 		mono_thread_hazardous_try_free (entry, free_writer_entry);
 
@@ -3475,6 +3759,153 @@ start_writer_thread (void)
 	}
 }
 
+/*
+ * With the sample-folded option, sample hits are folded into a call stack trie by the
+ * dumper thread instead of being written to the log, and the trie is periodically
+ * written to a file in the collapsed stack format used by flame graph tools. Frames
+ * are only symbolized when the file is written.
+ */
+typedef struct _SampleNode SampleNode;
+
+struct _SampleNode {
+	SampleNode *parent;
+	// MonoMethod * for managed frames, the instruction pointer for native code.
+	gpointer key;
+	gboolean native;
+	uint64_t count;
+	char *name;
+	GHashTable *children;
+};
+
+static SampleNode *
+sample_node_child (SampleNode *node, gpointer key, gboolean native)
+{
+	SampleNode *child;
+
+	if (!node->children)
+		node->children = g_hash_table_new (NULL, NULL);
+
+	// Native instruction pointers and methods can't collide, their memory is disjoint.
+	if ((child = (SampleNode *) g_hash_table_lookup (node->children, key)))
+		return child;
+
+	child = g_new0 (SampleNode, 1);
+	child->parent = node;
+	child->key = key;
+	child->native = native;
+
+	// Keep the image alive so the method can be named when the file is written.
+	if (!native)
+		inc_method_ref_count ((MonoMethod *) key);
+
+	g_hash_table_insert (node->children, key, child);
+
+	return child;
+}
+
+static void
+fold_sample_hit (SampleHit *sample)
+{
+	SampleNode *node = log_profiler.sample_root;
+
+	// The frames go from the innermost to the outermost one.
+	for (int i = sample->count - 1; i >= 0; --i)
+		if (sample->frames [i].method)
+			node = sample_node_child (node, sample->frames [i].method, FALSE);
+
+	// Samples taken in native code get a leaf for the instruction pointer.
+	if (!sample->count || !mono_jit_info_table_find (mono_get_root_domain (), (gpointer) sample->ip))
+		node = sample_node_child (node, (gpointer) sample->ip, TRUE);
+
+	node->count++;
+}
+
+static const char *
+sample_node_name (SampleNode *node)
+{
+	if (!node->name) {
+		if (node->native) {
+			const char *sym = symbol_for ((uintptr_t) node->key);
+
+			node->name = sym ? g_strdup (sym) : g_strdup_printf ("[unknown %p]", node->key);
+		} else {
+			node->name = mono_method_full_name ((MonoMethod *) node->key, TRUE);
+		}
+	}
+
+	return node->name;
+}
+
+static void
+write_folded_node (FILE *file, SampleNode *node, GString *path)
+{
+	gsize len = path->len;
+
+	if (node != log_profiler.sample_root) {
+		if (node->parent != log_profiler.sample_root)
+			g_string_append_c (path, ';');
+
+		g_string_append (path, sample_node_name (node));
+
+		if (node->count)
+			fprintf (file, "%s %" PRIu64 "\n", path->str, node->count);
+	}
+
+	if (node->children) {
+		GHashTableIter iter;
+		SampleNode *child;
+
+		g_hash_table_iter_init (&iter, node->children);
+
+		while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &child))
+			write_folded_node (file, child, path);
+	}
+
+	g_string_truncate (path, len);
+}
+
+static void
+write_folded_samples (void)
+{
+	FILE *file = fopen (log_config.folded_filename, "w");
+
+	if (!file) {
+		mono_profiler_printf_err ("Could not create log profiler folded samples file '%s': %s", log_config.folded_filename, g_strerror (errno));
+		return;
+	}
+
+	GString *path = g_string_new (NULL);
+
+	write_folded_node (file, log_profiler.sample_root, path);
+
+	g_string_free (path, TRUE);
+	fclose (file);
+
+	log_profiler.last_folded_time = current_time ();
+}
+
+static void
+free_sample_node (SampleNode *node)
+{
+	if (node->children) {
+		GHashTableIter iter;
+		SampleNode *child;
+
+		g_hash_table_iter_init (&iter, node->children);
+
+		while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &child))
+			free_sample_node (child);
+
+		g_hash_table_destroy (node->children);
+	}
+
+	if (node->key && !node->native)
+		dec_method_ref_count ((MonoMethod *) node->key);
+
+	g_free (node->name);
+	g_free (node);
+}
+
 static void
 reuse_sample_hit (gpointer p)
 {
@@ -3511,6 +3942,12 @@ handle_dumper_queue_entry (void)
 			}
 		}
 
+		if (log_config.folded_filename) {
+			mono_atomic_inc_i32 (&sample_hits_ctr);
+			fold_sample_hit (sample);
+			goto done;
+		}
+
 		ENTER_LOG (&sample_hits_ctr, logbuffer,
 			EVENT_SIZE /* event */ +
 			LEB128_SIZE /* tid */ +
@@ -3542,6 +3979,9 @@ handle_dumper_queue_entry (void)
 
 		EXIT_LOG;
 
+		dump_unmanaged_coderefs ();
+
+	done:
 		for (int i = 0; i < sample->count; ++i) {
 			MonoMethod *method = sample->frames [i].method;
 
@@ -3550,8 +3990,6 @@ handle_dumper_queue_entry (void)
 		}
 
 		mono_thread_hazardous_try_free (sample, reuse_sample_hit);
-
-		dump_unmanaged_coderefs ();
 	}
 
 	return FALSE;
@@ -3576,12 +4014,21 @@ dumper_thread (void *arg)
 
 		handle_dumper_queue_entry ();
 
+		if (log_config.folded_filename && current_time () - log_profiler.last_folded_time >= (uint64_t) log_config.folded_interval * TICKS_PER_SEC)
+			write_folded_samples ();
+
 		profiler_thread_check_detach (thread);
 	}
 
 	/* Drain any remaining entries on shutdown. */
 	while (handle_dumper_queue_entry ());
 
+	if (log_config.folded_filename) {
+		write_folded_samples ();
+		free_sample_node (log_profiler.sample_root);
+		log_profiler.sample_root = NULL;
+	}
+
 	profiler_thread_end (thread, &log_profiler.dumper_thread_exited, TRUE);
 
 	return NULL;
@@ -3751,11 +4198,13 @@ proflog_icall_SetMonitorEvents (MonoBoolean value)
 		mono_profiler_set_monitor_contention_callback (log_profiler.handle, monitor_contention);
 		mono_profiler_set_monitor_acquired_callback (log_profiler.handle, monitor_acquired);
 		mono_profiler_set_monitor_failed_callback (log_profiler.handle, monitor_failed);
+		mono_profiler_set_runtime_lock_contention_callback (log_profiler.handle, runtime_lock_contention);
 	} else {
 		DISABLE (PROFLOG_MONITOR_EVENTS);
 		mono_profiler_set_monitor_contention_callback (log_profiler.handle, NULL);
 		mono_profiler_set_monitor_acquired_callback (log_profiler.handle, NULL);
 		mono_profiler_set_monitor_failed_callback (log_profiler.handle, NULL);
+		mono_profiler_set_runtime_lock_contention_callback (log_profiler.handle, NULL);
 	}
 
 	mono_coop_mutex_unlock (&log_profiler.api_mutex);
@@ -3959,6 +4408,7 @@ runtime_initialized (MonoProfiler *profiler)
 
 	register_counter ("Sample events allocated", &sample_allocations_ctr);
 	register_counter ("Log buffers allocated", &buffer_allocations_ctr);
+	register_counter ("Log buffers dropped", &buffer_drops_ctr);
 
 	register_counter ("Event: Sync points", &sync_points_ctr);
 	register_counter ("Event: AOT IDs", &aot_ids_ctr);
@@ -4074,6 +4524,78 @@ runtime_initialized (MonoProfiler *profiler)
 #undef ADD_ICALL
 }
 
+#ifndef HOST_WIN32
+/*
+ * Connect to the sink of output=@HOST:PORT or output=@/PATH. Writes happen
+ * on the writer thread only, so a slow peer delays the output but not the
+ * application threads, see maxqueue.
+ */
+static int
+connect_output_socket (const char *addr)
+{
+	int fd;
+
+	if (*addr == '/') {
+		struct sockaddr_un sun;
+
+		if (strlen (addr) >= sizeof (sun.sun_path)) {
+			errno = ENAMETOOLONG;
+			return -1;
+		}
+
+		memset (&sun, 0, sizeof (sun));
+		sun.sun_family = AF_UNIX;
+		strcpy (sun.sun_path, addr);
+
+		fd = socket (AF_UNIX, SOCK_STREAM, 0);
+		if (fd == -1)
+			return -1;
+
+		if (connect (fd, (struct sockaddr *) &sun, sizeof (sun)) == -1) {
+			close (fd);
+			return -1;
+		}
+
+		return fd;
+	}
+
+	const char *colon = strrchr (addr, ':');
+	if (!colon) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	char *host = g_strndup (addr, colon - addr);
+	struct addrinfo hints, *res, *ai;
+
+	memset (&hints, 0, sizeof (hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+
+	int ret = getaddrinfo (host, colon + 1, &hints, &res);
+	g_free (host);
+	if (ret) {
+		errno = EHOSTUNREACH;
+		return -1;
+	}
+
+	fd = -1;
+	for (ai = res; ai; ai = ai->ai_next) {
+		fd = socket (ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+		if (fd == -1)
+			continue;
+		if (connect (fd, ai->ai_addr, ai->ai_addrlen) == 0)
+			break;
+		close (fd);
+		fd = -1;
+	}
+
+	freeaddrinfo (res);
+
+	return fd;
+}
+#endif
+
 static void
 create_profiler (const char *args, const char *filename, GPtrArray *filters)
 {
@@ -4081,6 +4603,7 @@ create_profiler (const char *args, const char *filename, GPtrArray *filters)
 
 	log_profiler.args = pstrdup (args);
 	log_profiler.command_port = log_config.command_port;
+	log_profiler.max_queued_bytes = (gint64) log_config.max_queued_mb * 1024 * 1024;
 
 	//If filename begin with +, append the pid at the end
 	if (filename && *filename == '+')
@@ -4105,6 +4628,12 @@ create_profiler (const char *args, const char *filename, GPtrArray *filters)
 	if (*nf == '|') {
 		log_profiler.file = popen (nf + 1, "w");
 		log_profiler.pipe_output = 1;
+#ifndef HOST_WIN32
+	} else if (*nf == '@') {
+		int fd = connect_output_socket (nf + 1);
+		if (fd != -1)
+			log_profiler.file = fdopen (fd, "w");
+#endif
 	} else if (*nf == '#') {
 		int fd = strtol (nf + 1, NULL, 10);
 		log_profiler.file = fdopen (fd, "a");
@@ -4145,6 +4674,18 @@ create_profiler (const char *args, const char *filename, GPtrArray *filters)
 	log_profiler.method_table = mono_conc_hashtable_new (NULL, NULL);
 
 	log_profiler.startup_time = current_time ();
+
+	if (log_config.folded_filename) {
+		log_profiler.sample_root = g_new0 (SampleNode, 1);
+		log_profiler.last_folded_time = log_profiler.startup_time;
+	}
+
+	if (log_config.nettrace_filename) {
+		log_profiler.nettrace = nettrace_writer_open (log_config.nettrace_filename, log_profiler.startup_time, process_id (), mono_cpu_count ());
+
+		if (!log_profiler.nettrace)
+			mono_profiler_printf_err ("Could not create log profiler nettrace file '%s': %s", log_config.nettrace_filename, g_strerror (errno));
+	}
 }
 
 MONO_API void
@@ -4229,6 +4770,7 @@ mono_profiler_init_log (const char *desc)
 		mono_profiler_set_monitor_contention_callback (handle, monitor_contention);
 		mono_profiler_set_monitor_acquired_callback (handle, monitor_acquired);
 		mono_profiler_set_monitor_failed_callback (handle, monitor_failed);
+		mono_profiler_set_runtime_lock_contention_callback (handle, runtime_lock_contention);
 	}
 
 	if (ENABLED (PROFLOG_GC_EVENTS))
@@ -4236,6 +4778,8 @@ mono_profiler_init_log (const char *desc)
 
 	if (ENABLED (PROFLOG_GC_ALLOCATION_EVENTS))
 		mono_profiler_set_gc_allocation_callback (handle, gc_alloc);
+	else if (log_config.alloc_sample_interval && mono_profiler_enable_allocation_sampling (log_config.alloc_sample_interval))
+		mono_profiler_set_gc_allocation_sampled_callback (handle, gc_alloc_sampled);
 
 	if (ENABLED (PROFLOG_GC_MOVE_EVENTS))
 		mono_profiler_set_gc_moves_callback (handle, gc_moves);
@@ -4261,14 +4805,15 @@ mono_profiler_init_log (const char *desc)
 	if (ENABLED (PROFLOG_JIT_EVENTS))
 		mono_profiler_set_jit_code_buffer_callback (handle, code_buffer_new);
 
-	if (log_config.enter_leave) {
-		mono_profiler_set_method_enter_callback (handle, method_enter);
-		mono_profiler_set_method_leave_callback (handle, method_leave);
-		mono_profiler_set_method_tail_call_callback (handle, tailcall);
-		mono_profiler_set_method_exception_leave_callback (handle, method_exc_leave);
-	}
+	if (log_config.enter_leave && !log_config.enter_leave_on_demand)
+		set_call_callbacks (TRUE);
 
-	mono_profiler_enable_allocations ();
+	/*
+	 * Instrumenting the allocations disables the managed allocators, which is
+	 * what allocation sampling is meant to avoid.
+	 */
+	if (!log_config.alloc_sample_interval || ENABLED (PROFLOG_GC_ALLOCATION_EVENTS))
+		mono_profiler_enable_allocations ();
 	mono_profiler_enable_clauses ();
 	mono_profiler_enable_sampling (handle);
 
@@ -9,7 +9,7 @@
 #define LOG_HEADER_ID 0x4D505A01
 #define LOG_VERSION_MAJOR 3
 #define LOG_VERSION_MINOR 0
-#define LOG_DATA_VERSION 17
+#define LOG_DATA_VERSION 18
 
 /*
  * Changes in major/minor versions:
@@ -86,6 +86,7 @@
                added TYPE_AOT_ID
                removed TYPE_SAMPLE_UBIN
  * version 17: MONO_PROFILER_CODE_BUFFER_{METHOD_TRAMPOLINE,MONITOR} are no longer produced
+ * version 18: added MONO_PROFILER_MONITOR_RUNTIME_LOCK to TYPE_MONITOR
  */
 
 /*
@@ -265,7 +266,12 @@
  * type: TYPE_MONITOR
  * exinfo: zero or TYPE_MONITOR_BT
  * [type: byte] MonoProfilerMonitorEvent enum value
- * [object: sleb128] the lock object as a difference from obj_base
+ * if type == MONO_PROFILER_MONITOR_RUNTIME_LOCK
+ * 	[lock: sleb128] pointer to the runtime lock as a difference from ptr_base
+ * 	[wait: uleb128] time in nanoseconds the thread waited for the lock
+ * 	[name: string] name of the runtime lock
+ * else
+ * 	[object: sleb128] the lock object as a difference from obj_base
  * If exinfo == TYPE_MONITOR_BT, a backtrace follows.
  *
  * type heap format
@@ -428,6 +434,7 @@ typedef enum {
 	MONO_PROFILER_MONITOR_CONTENTION = 1,
 	MONO_PROFILER_MONITOR_DONE = 2,
 	MONO_PROFILER_MONITOR_FAIL = 3,
+	MONO_PROFILER_MONITOR_RUNTIME_LOCK = 4,
 } MonoProfilerMonitorEvent;
 
 enum {
@@ -476,6 +483,9 @@ typedef struct {
 	// Whether to do method prologue/epilogue instrumentation. Only used at startup.
 	gboolean enter_leave;
 
+	// Only record enter/leave events while turned on through the command server.
+	gboolean enter_leave_on_demand;
+
 	//Emit a report at the end of execution
 	gboolean do_report;
 
@@ -500,12 +510,19 @@ typedef struct {
 	// Whether to do a heapshot on shutdown.
 	gboolean hs_on_shutdown;
 
+	// Walk the heap for heapshots in pauses of this many milliseconds instead of a single one.
+	int hs_slice_ms;
+
 	// Sample frequency in Hertz. Only used at startup.
 	int sample_freq;
 
 	// Maximum number of frames to collect. Can be changed at runtime.
 	int num_frames;
 
+	// Minimum time in microseconds a thread has to wait for a runtime lock for the
+	// contention to be reported. Can be changed at runtime.
+	int lock_wait_us;
+
 	// Max depth to record enter/leave events. Can be changed at runtime.
 	int max_call_depth;
 
@@ -515,12 +532,28 @@ typedef struct {
 	// Port to listen for profiling commands (e.g. "heapshot" for on-demand heapshot).
 	int command_port;
 
+	// Size in megabytes of the buffers waiting to be written above which events that
+	// no other event depends on are dropped, 0 for no limit. Only used at startup.
+	int max_queued_mb;
+
+	// Report one allocation for this many allocated bytes instead of all of them. Only used at startup.
+	int alloc_sample_interval;
+
 	// Maximum number of SampleHit structures. We'll drop samples if this number is not sufficient.
 	int max_allocated_sample_hits;
 
 	// Sample mode. Only used at startup.
 	MonoProfilerSampleMode sampling_mode;
 
+	// Fold samples into call stacks written to this file instead of logging them. Only used at startup.
+	const char *folded_filename;
+
+	// Rewrite the folded samples file every this many seconds.
+	int folded_interval;
+
+	// Also write GC, JIT and contention events to this nettrace file. Only used at startup.
+	const char *nettrace_filename;
+
 	// Callspec config - which methods are to be instrumented
 	MonoCallSpec callspec;
 } ProfilerConfig;
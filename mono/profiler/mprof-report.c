@@ -29,7 +29,8 @@
 #include <mono/metadata/debug-helpers.h>
 #include <mono/utils/mono-counters.h>
 
-#define HASH_SIZE 9371
+/* The tables of classes, vtables, methods and backtraces grow with the log */
+#define INITIAL_HASH_SIZE 4096
 #define SMALL_HASH_SIZE 31
 
 /* Version < 14 root type enum */
@@ -59,6 +60,37 @@ static int num_tracked_objects = 0;
 static uintptr_t thread_filter = 0;
 static uint64_t find_size = 0;
 static const char* find_name = NULL;
+/*
+ * Double @table, a chained hash table of @type with @size slots, once it holds
+ * @count entries. @hash computes the hash of the entry e.
+ */
+#define GROW_HASH(type,table,size,count,hash) do {	\
+	if ((count) >= (size)) {	\
+		int new_size = (size) ? (size) * 2 : INITIAL_HASH_SIZE;	\
+		type **new_table = (type **) g_calloc (sizeof (type *), new_size);	\
+		for (int i = 0; i < (size); ++i) {	\
+			type *e = (table) [i];	\
+			while (e) {	\
+				type *next = e->next;	\
+				unsigned int s = (hash) & (new_size - 1);	\
+				e->next = new_table [s];	\
+				new_table [s] = e;	\
+				e = next;	\
+			}	\
+		}	\
+		g_free (table);	\
+		(table) = new_table;	\
+		(size) = new_size;	\
+	}	\
+} while (0)
+
+static unsigned int
+hash_ptr (intptr_t p)
+{
+	/* Mix all the bits in, runtime structures are spread over the whole address space */
+	return (unsigned int) ((((uint64_t) p >> 3) * 0x9E3779B97F4A7C15ULL) >> 32);
+}
+
 static uint64_t time_from = 0;
 static uint64_t time_to = 0xffffffffffffffffULL;
 static int use_time_filter = 0;
@@ -587,15 +619,16 @@ struct _ClassDesc {
 	TraceDesc traces;
 };
 
-static ClassDesc* class_hash [HASH_SIZE] = {0};
+static ClassDesc** class_hash = NULL;
+static int class_hash_size = 0;
 static int num_classes = 0;
 
 static ClassDesc*
 add_class (intptr_t klass, const char *name)
 {
-	int slot = ((klass >> 2) & 0xffff) % HASH_SIZE;
+	int slot;
 	ClassDesc *cd;
-	cd = class_hash [slot];
+	cd = class_hash_size ? class_hash [hash_ptr (klass) & (class_hash_size - 1)] : NULL;
 	while (cd && cd->klass != klass)
 		cd = cd->next;
 	/* we resolved an unknown class (unless we had the code unloaded) */
@@ -605,6 +638,8 @@ add_class (intptr_t klass, const char *name)
 		cd->name = pstrdup (name);
 		return cd;
 	}
+	GROW_HASH (ClassDesc, class_hash, class_hash_size, num_classes, hash_ptr (e->klass));
+	slot = hash_ptr (klass) & (class_hash_size - 1);
 	cd = (ClassDesc *) g_calloc (sizeof (ClassDesc), 1);
 	cd->klass = klass;
 	cd->name = pstrdup (name);
@@ -622,8 +657,7 @@ add_class (intptr_t klass, const char *name)
 static ClassDesc *
 lookup_class (intptr_t klass)
 {
-	int slot = ((klass >> 2) & 0xffff) % HASH_SIZE;
-	ClassDesc *cd = class_hash [slot];
+	ClassDesc *cd = class_hash_size ? class_hash [hash_ptr (klass) & (class_hash_size - 1)] : NULL;
 	while (cd && cd->klass != klass)
 		cd = cd->next;
 	if (!cd) {
@@ -641,14 +675,16 @@ struct _VTableDesc {
 	ClassDesc *klass;
 };
 
-static VTableDesc* vtable_hash [HASH_SIZE] = {0};
+static VTableDesc** vtable_hash = NULL;
+static int vtable_hash_size = 0;
+static int num_vtables = 0;
 
 static VTableDesc*
 add_vtable (intptr_t vtable, intptr_t klass)
 {
-	int slot = ((vtable >> 2) & 0xffff) % HASH_SIZE;
+	int slot;
 
-	VTableDesc *vt = vtable_hash [slot];
+	VTableDesc *vt = vtable_hash_size ? vtable_hash [hash_ptr (vtable) & (vtable_hash_size - 1)] : NULL;
 
 	while (vt && vt->vtable != vtable)
 		vt = vt->next;
@@ -656,6 +692,9 @@ add_vtable (intptr_t vtable, intptr_t klass)
 	if (vt)
 		return vt;
 
+	GROW_HASH (VTableDesc, vtable_hash, vtable_hash_size, num_vtables, hash_ptr (e->vtable));
+	slot = hash_ptr (vtable) & (vtable_hash_size - 1);
+
 	vt = (VTableDesc *) g_calloc (sizeof (VTableDesc), 1);
 
 	vt->vtable = vtable;
@@ -663,6 +702,7 @@ add_vtable (intptr_t vtable, intptr_t klass)
 	vt->next = vtable_hash [slot];
 
 	vtable_hash [slot] = vt;
+	num_vtables++;
 
 	return vt;
 }
@@ -670,8 +710,7 @@ add_vtable (intptr_t vtable, intptr_t klass)
 static VTableDesc *
 lookup_vtable (intptr_t vtable)
 {
-	int slot = ((vtable >> 2) & 0xffff) % HASH_SIZE;
-	VTableDesc *vt = vtable_hash [slot];
+	VTableDesc *vt = vtable_hash_size ? vtable_hash [hash_ptr (vtable) & (vtable_hash_size - 1)] : NULL;
 
 	while (vt && vt->vtable != vtable)
 		vt = vt->next;
@@ -699,15 +738,16 @@ struct _MethodDesc {
 	TraceDesc traces;
 };
 
-static MethodDesc* method_hash [HASH_SIZE] = {0};
+static MethodDesc** method_hash = NULL;
+static int method_hash_size = 0;
 static int num_methods = 0;
 
 static MethodDesc*
 add_method (intptr_t method, const char *name, intptr_t code, int len)
 {
-	int slot = ((method >> 2) & 0xffff) % HASH_SIZE;
+	int slot;
 	MethodDesc *cd;
-	cd = method_hash [slot];
+	cd = method_hash_size ? method_hash [hash_ptr (method) & (method_hash_size - 1)] : NULL;
 	while (cd && cd->method != method)
 		cd = cd->next;
 	/* we resolved an unknown method (unless we had the code unloaded) */
@@ -719,6 +759,8 @@ add_method (intptr_t method, const char *name, intptr_t code, int len)
 		cd->name = pstrdup (name);
 		return cd;
 	}
+	GROW_HASH (MethodDesc, method_hash, method_hash_size, num_methods, hash_ptr (e->method));
+	slot = hash_ptr (method) & (method_hash_size - 1);
 	cd = (MethodDesc *) g_calloc (sizeof (MethodDesc), 1);
 	cd->method = method;
 	cd->name = pstrdup (name);
@@ -738,8 +780,7 @@ add_method (intptr_t method, const char *name, intptr_t code, int len)
 static MethodDesc *
 lookup_method (intptr_t method)
 {
-	int slot = ((method >> 2) & 0xffff) % HASH_SIZE;
-	MethodDesc *cd = method_hash [slot];
+	MethodDesc *cd = method_hash_size ? method_hash [hash_ptr (method) & (method_hash_size - 1)] : NULL;
 	while (cd && cd->method != method)
 		cd = cd->next;
 	if (!cd) {
@@ -768,22 +809,56 @@ add_stat_sample (int type, uintptr_t ip) {
 	stat_sample_desc [num_stat_samples++] = type;
 }
 
+static MethodDesc **methods_by_ip = NULL;
+static int num_methods_by_ip = 0;
+
+static int
+compare_method_code (const void *a, const void *b)
+{
+	MethodDesc *const *A = (MethodDesc *const *)a;
+	MethodDesc *const *B = (MethodDesc *const *)b;
+	if ((uintptr_t)(*A)->code == (uintptr_t)(*B)->code)
+		return 0;
+	return (uintptr_t)(*A)->code < (uintptr_t)(*B)->code ? -1 : 1;
+}
+
+/*
+ * Only used once the whole log is decoded, so the methods are sorted by code
+ * address on the first call and looked up with a binary search afterwards.
+ */
 static MethodDesc*
 lookup_method_by_ip (uintptr_t ip)
 {
-	int i;
+	int i, lo, hi;
 	MethodDesc* m;
-	/* dumb */
-	for (i = 0; i < HASH_SIZE; ++i) {
-		m = method_hash [i];
-		while (m) {
-			//printf ("checking %p against %p-%p\n", (void*)ip, (void*)(m->code), (void*)(m->code + m->len));
-			if (ip >= (uintptr_t)m->code && ip < (uintptr_t)m->code + m->len) {
-				return m;
+
+	if (!methods_by_ip) {
+		methods_by_ip = (MethodDesc **) g_malloc ((num_methods + 1) * sizeof (void*));
+		for (i = 0; i < method_hash_size; ++i) {
+			for (m = method_hash [i]; m; m = m->next) {
+				if (m->code && m->len)
+					methods_by_ip [num_methods_by_ip++] = m;
 			}
-			m = m->next;
 		}
+		qsort (methods_by_ip, num_methods_by_ip, sizeof (void*), compare_method_code);
+	}
+
+	/* Find the last method starting at or before ip */
+	lo = 0;
+	hi = num_methods_by_ip;
+	while (lo < hi) {
+		int mid = lo + (hi - lo) / 2;
+		if ((uintptr_t)methods_by_ip [mid]->code <= ip)
+			lo = mid + 1;
+		else
+			hi = mid;
 	}
+	if (!lo)
+		return NULL;
+	m = methods_by_ip [lo - 1];
+	//printf ("checking %p against %p-%p\n", (void*)ip, (void*)(m->code), (void*)(m->code + m->len));
+	if (ip < (uintptr_t)m->code + m->len)
+		return m;
 	return NULL;
 }
 
@@ -990,6 +1065,87 @@ sym_percent (uintptr_t sample_hits)
 	return pc >= 0.1;
 }
 
+static int
+compare_uintptr (const void *a, const void *b)
+{
+	uintptr_t A = *(const uintptr_t *)a;
+	uintptr_t B = *(const uintptr_t *)b;
+	if (A == B)
+		return 0;
+	return A < B ? -1 : 1;
+}
+
+/* Number of distinct values in the sorted ITEMS */
+static int
+count_distinct (uintptr_t *items, int count)
+{
+	int i, distinct = 0;
+	for (i = 0; i < count; ++i) {
+		if (!i || items [i] != items [i - 1])
+			distinct++;
+	}
+	return distinct;
+}
+
+#define CODE_LOCALITY_PAGE_SHIFT 12
+#define CODE_LOCALITY_LARGE_PAGE_SHIFT 21
+#define CODE_LOCALITY_HOT_PERCENT 90
+
+/*
+ * Reports how the code of the hottest methods, the ones getting
+ * CODE_LOCALITY_HOT_PERCENT of the managed hits, is spread over pages,
+ * compared to the pages it would use if it was contiguous.
+ * METHODS is sorted by hits.
+ */
+static void
+dump_code_locality (MethodDesc **methods, int count, int managed_hits)
+{
+	int i, hot = 0, hits = 0, npages = 0, nlarge = 0;
+	uintptr_t j;
+	uint64_t code_size = 0;
+	uintptr_t *pages = NULL, *large_pages = NULL;
+
+	for (i = 0; i < count && hits * 100.0 < managed_hits * CODE_LOCALITY_HOT_PERCENT; ++i) {
+		MethodDesc *m = methods [i];
+		uintptr_t first, last;
+		hits += m->sample_hits;
+		if (!m->code || m->len <= 0)
+			continue;
+		hot++;
+		code_size += m->len;
+		first = (uintptr_t)m->code >> CODE_LOCALITY_PAGE_SHIFT;
+		last = ((uintptr_t)m->code + m->len - 1) >> CODE_LOCALITY_PAGE_SHIFT;
+		pages = (uintptr_t *) g_realloc (pages, (npages + last - first + 1) * sizeof (uintptr_t));
+		for (j = 0; j <= last - first; ++j)
+			pages [npages++] = first + j;
+		first = (uintptr_t)m->code >> CODE_LOCALITY_LARGE_PAGE_SHIFT;
+		last = ((uintptr_t)m->code + m->len - 1) >> CODE_LOCALITY_LARGE_PAGE_SHIFT;
+		large_pages = (uintptr_t *) g_realloc (large_pages, (nlarge + last - first + 1) * sizeof (uintptr_t));
+		for (j = 0; j <= last - first; ++j)
+			large_pages [nlarge++] = first + j;
+	}
+	if (!hot)
+		return;
+
+	qsort (pages, npages, sizeof (uintptr_t), compare_uintptr);
+	qsort (large_pages, nlarge, sizeof (uintptr_t), compare_uintptr);
+	npages = count_distinct (pages, npages);
+	nlarge = count_distinct (large_pages, nlarge);
+
+	fprintf (outfile, "\nCode locality of the methods with %d%% of the managed hits\n", CODE_LOCALITY_HOT_PERCENT);
+	fprintf (outfile, "	Methods: %d, code size: %llu bytes\n", hot, (unsigned long long) code_size);
+	fprintf (outfile, "	%d KB pages touched: %d (%llu if contiguous), %.2f methods per page\n",
+		1 << (CODE_LOCALITY_PAGE_SHIFT - 10), npages,
+		(unsigned long long) ((code_size + (1 << CODE_LOCALITY_PAGE_SHIFT) - 1) >> CODE_LOCALITY_PAGE_SHIFT),
+		(double) hot / npages);
+	fprintf (outfile, "	%d MB regions touched: %d (%llu if contiguous)\n",
+		1 << (CODE_LOCALITY_LARGE_PAGE_SHIFT - 20), nlarge,
+		(unsigned long long) ((code_size + (1 << CODE_LOCALITY_LARGE_PAGE_SHIFT) - 1) >> CODE_LOCALITY_LARGE_PAGE_SHIFT));
+
+	g_free (pages);
+	g_free (large_pages);
+}
+
 static void
 dump_samples (void)
 {
@@ -1077,6 +1233,7 @@ dump_samples (void)
 			continue;
 		}
 	}
+	dump_code_locality (cachedm, count, num_stat_samples - unmanaged_hits);
 }
 
 typedef struct _HeapClassDesc HeapClassDesc;
@@ -1171,11 +1328,23 @@ struct _HeapShot {
 	uintptr_t *roots;
 	uintptr_t *roots_extra;
 	int *roots_types;
+	/* objects of at most HEAP_SHOT_SMALL_OBJECT_WORDS pointers */
+	uint64_t small_count;
+	uint64_t small_size;
+	/* non-null references between objects and the span of the object addresses */
+	uint64_t ref_count;
+	uintptr_t min_addr;
+	uintptr_t max_addr;
 };
 
 static HeapShot *heap_shots = NULL;
 static int num_heap_shots = 0;
 
+/* Pointer size of the profiled process, an object header is two pointers */
+static int heap_shot_ptr_size = sizeof (void*);
+
+#define HEAP_SHOT_SMALL_OBJECT_WORDS 4
+
 static HeapShot*
 new_heap_shot (uint64_t timestamp)
 {
@@ -1266,6 +1435,10 @@ add_heap_shot_class (HeapShot *hs, ClassDesc *klass, uint64_t size)
 	}
 	res = NULL;
 	hs->class_count += add_heap_hashed (hs->class_hash, &res, hs->hash_size, klass, size, 1);
+	if (size <= HEAP_SHOT_SMALL_OBJECT_WORDS * heap_shot_ptr_size) {
+		hs->small_count++;
+		hs->small_size += size;
+	}
 	//if (res->count == 1)
 	//	printf ("added heap class: %s\n", res->klass->name);
 	return res;
@@ -1487,7 +1660,8 @@ struct _BackTrace {
 	MethodDesc *methods [1];
 };
 
-static BackTrace *backtrace_hash [HASH_SIZE];
+static BackTrace **backtrace_hash = NULL;
+static int backtrace_hash_size = 0;
 static BackTrace **backtraces = NULL;
 static int num_backtraces = 0;
 static int next_backtrace = 0;
@@ -1519,13 +1693,15 @@ static BackTrace*
 add_backtrace (int count, MethodDesc **methods)
 {
 	int hash = hash_backtrace (count, methods);
-	int slot = (hash & 0xffff) % HASH_SIZE;
-	BackTrace *bt = backtrace_hash [slot];
+	int slot;
+	BackTrace *bt = backtrace_hash_size ? backtrace_hash [hash_ptr (hash) & (backtrace_hash_size - 1)] : NULL;
 	while (bt) {
 		if (bt->hash == hash && compare_backtrace (bt, count, methods))
 			return bt;
 		bt = bt->next;
 	}
+	GROW_HASH (BackTrace, backtrace_hash, backtrace_hash_size, next_backtrace, hash_ptr (e->hash));
+	slot = hash_ptr (hash) & (backtrace_hash_size - 1);
 	bt = (BackTrace *) g_malloc (sizeof (BackTrace) + ((count - 1) * sizeof (void*)));
 	bt->next = backtrace_hash [slot];
 	backtrace_hash [slot] = bt;
@@ -1805,6 +1981,19 @@ add_trace_methods (MethodDesc **methods, int count, TraceDesc *trace, uint64_t v
 	return bt;
 }
 
+/*
+ * A streamed heapshot is started by the thread doing the major collection,
+ * but most of its objects and its end event come from the profiler's helper
+ * thread.
+ */
+static ThreadContext *heap_shot_thread;
+
+static ThreadContext *
+heap_shot_owner (ThreadContext *thread)
+{
+	return thread->current_heap_shot || !heap_shot_thread ? thread : heap_shot_thread;
+}
+
 static void
 thread_add_root (ThreadContext *ctx, uintptr_t obj, int root_type, uintptr_t extra_info)
 {
@@ -1952,10 +2141,13 @@ clause_name (int type)
 static uint64_t monitor_contention;
 static uint64_t monitor_failed;
 static uint64_t monitor_acquired;
+static uint64_t runtime_lock_contention;
 
 struct _MonitorDesc {
 	MonitorDesc *next;
 	uintptr_t objid;
+	/* Only set for runtime locks, objid is the address of the lock then */
+	char *name;
 	uintptr_t contentions;
 	uint64_t wait_time;
 	uint64_t max_wait_time;
@@ -1989,6 +2181,7 @@ monitor_ev_name (int ev)
 	case MONO_PROFILER_MONITOR_CONTENTION: return "contended";
 	case MONO_PROFILER_MONITOR_DONE: return "acquired";
 	case MONO_PROFILER_MONITOR_FAIL: return "not taken";
+	case MONO_PROFILER_MONITOR_RUNTIME_LOCK: return "runtime lock contended";
 	default: return "invalid";
 	}
 }
@@ -2607,16 +2800,22 @@ decode_buffer (ProfContext *ctx)
 					cd = vt->klass;
 				} else
 					cd = lookup_class (ptr_base + ptrdiff);
+				HeapShot *hs = heap_shot_owner (thread)->current_heap_shot;
+				hs->ref_count += num;
 				if (size) {
-					HeapClassDesc *hcd = add_heap_shot_class (thread->current_heap_shot, cd, size);
+					HeapClassDesc *hcd = add_heap_shot_class (hs, cd, size);
+					if (!hs->min_addr || OBJ_ADDR (objdiff) < hs->min_addr)
+						hs->min_addr = OBJ_ADDR (objdiff);
+					if (OBJ_ADDR (objdiff) + size > hs->max_addr)
+						hs->max_addr = OBJ_ADDR (objdiff) + size;
 					if (collect_traces) {
 						ho = alloc_heap_obj (OBJ_ADDR (objdiff), hcd, num);
-						add_heap_shot_obj (thread->current_heap_shot, ho);
+						add_heap_shot_obj (hs, ho);
 						ref_offset = 0;
 					}
 				} else {
 					if (collect_traces)
-						ho = heap_shot_obj_add_refs (thread->current_heap_shot, OBJ_ADDR (objdiff), num, &ref_offset);
+						ho = heap_shot_obj_add_refs (hs, OBJ_ADDR (objdiff), num, &ref_offset);
 				}
 				for (i = 0; i < num; ++i) {
 					/* FIXME: use object distance to measure how good
@@ -2702,29 +2901,31 @@ decode_buffer (ProfContext *ctx)
 				time_base += tdiff;
 				if (debug)
 					fprintf (outfile, "heap shot end\n");
+				ThreadContext *owner = heap_shot_owner (thread);
 				if (collect_traces) {
-					HeapShot *hs = thread->current_heap_shot;
-					if (hs && thread->num_roots) {
+					HeapShot *hs = owner->current_heap_shot;
+					if (hs && owner->num_roots) {
 						/* transfer the root ownershipt to the heapshot */
-						hs->num_roots = thread->num_roots;
-						hs->roots = thread->roots;
-						hs->roots_extra = thread->roots_extra;
-						hs->roots_types = thread->roots_types;
+						hs->num_roots = owner->num_roots;
+						hs->roots = owner->roots;
+						hs->roots_extra = owner->roots_extra;
+						hs->roots_types = owner->roots_types;
 					} else {
-						g_free (thread->roots);
-						g_free (thread->roots_extra);
-						g_free (thread->roots_types);
+						g_free (owner->roots);
+						g_free (owner->roots_extra);
+						g_free (owner->roots_types);
 					}
-					thread->num_roots = 0;
-					thread->size_roots = 0;
-					thread->roots = NULL;
-					thread->roots_extra = NULL;
-					thread->roots_types = NULL;
+					owner->num_roots = 0;
+					owner->size_roots = 0;
+					owner->roots = NULL;
+					owner->roots_extra = NULL;
+					owner->roots_types = NULL;
 					heap_shot_resolve_reverse_refs (hs);
 					heap_shot_mark_objects (hs);
 					heap_shot_free_objects (hs);
 				}
-				thread->current_heap_shot = NULL;
+				owner->current_heap_shot = NULL;
+				heap_shot_thread = NULL;
 			} else if (subtype == TYPE_HEAP_START) {
 				uint64_t tdiff = decode_uleb128 (p + 1, &p);
 				LOG_TIME (time_base, tdiff);
@@ -2732,6 +2933,7 @@ decode_buffer (ProfContext *ctx)
 				if (debug)
 					fprintf (outfile, "heap shot start\n");
 				thread->current_heap_shot = new_heap_shot (time_base);
+				heap_shot_thread = thread;
 			}
 			break;
 		}
@@ -2743,7 +2945,19 @@ decode_buffer (ProfContext *ctx)
 			uint64_t tdiff = decode_uleb128 (p + 1, &p);
 			if (ctx->data_version > 13)
 				event = *p++;
-			intptr_t objdiff = decode_sleb128 (p, &p);
+			intptr_t objdiff = 0;
+			uintptr_t lock_addr = 0;
+			uint64_t lock_wait = 0;
+			const char *lock_name = NULL;
+			if (event == MONO_PROFILER_MONITOR_RUNTIME_LOCK) {
+				lock_addr = ptr_base + decode_sleb128 (p, &p);
+				lock_wait = decode_uleb128 (p, &p);
+				lock_name = (const char *)p;
+				while (*p) p++;
+				p++;
+			} else {
+				objdiff = decode_sleb128 (p, &p);
+			}
 			MethodDesc* sframes [8];
 			MethodDesc** frames = sframes;
 			int record;
@@ -2753,8 +2967,18 @@ decode_buffer (ProfContext *ctx)
 			record = (!thread_filter || thread_filter == thread->thread_id);
 			if (!(time_base >= time_from && time_base < time_to))
 				record = 0;
-			MonitorDesc *mdesc = lookup_monitor (OBJ_ADDR (objdiff));
-			if (event == MONO_PROFILER_MONITOR_CONTENTION) {
+			MonitorDesc *mdesc = lock_name ? lookup_monitor (lock_addr) : lookup_monitor (OBJ_ADDR (objdiff));
+			if (lock_name && !mdesc->name)
+				mdesc->name = pstrdup (lock_name);
+			if (event == MONO_PROFILER_MONITOR_RUNTIME_LOCK) {
+				if (record) {
+					runtime_lock_contention++;
+					mdesc->contentions++;
+					if (lock_wait > mdesc->max_wait_time)
+						mdesc->max_wait_time = lock_wait;
+					mdesc->wait_time += lock_wait;
+				}
+			} else if (event == MONO_PROFILER_MONITOR_CONTENTION) {
 				if (record) {
 					monitor_contention++;
 					mdesc->contentions++;
@@ -2793,14 +3017,18 @@ decode_buffer (ProfContext *ctx)
 					fprintf (outfile, "Cannot load backtrace\n");
 					return 0;
 				}
-				if (record && event == MONO_PROFILER_MONITOR_CONTENTION)
+				if (record && (event == MONO_PROFILER_MONITOR_CONTENTION || event == MONO_PROFILER_MONITOR_RUNTIME_LOCK))
 					add_trace_methods (frames, num_bt, &mdesc->traces, 1);
 			} else {
 				if (record)
 					add_trace_thread (thread, &mdesc->traces, 1);
 			}
-			if (debug)
-				fprintf (outfile, "monitor %s for object %p\n", monitor_ev_name (event), (void*)OBJ_ADDR (objdiff));
+			if (debug) {
+				if (lock_name)
+					fprintf (outfile, "monitor %s for %s lock %p (%llu ns)\n", monitor_ev_name (event), lock_name, (void*)lock_addr, (unsigned long long) lock_wait);
+				else
+					fprintf (outfile, "monitor %s for object %p\n", monitor_ev_name (event), (void*)OBJ_ADDR (objdiff));
+			}
 			if (frames != sframes)
 				g_free (frames);
 			break;
@@ -3248,8 +3476,9 @@ load_file (char *name)
 	if (ctx->data_version > LOG_DATA_VERSION)
 		return NULL;
 	/* reading 64 bit files on 32 bit systems not supported yet */
-	if (*p++ > sizeof (void*))
+	if (*p > sizeof (void*))
 		return NULL;
+	heap_shot_ptr_size = *p++;
 	ctx->startup_time = read_int64 (p);
 	p += 8;
 	// nanoseconds startup time
@@ -3425,7 +3654,10 @@ dump_monitors (void)
 	fprintf (outfile, "\nMonitor lock summary\n");
 	for (i = 0; i < num_monitors; ++i) {
 		MonitorDesc *mdesc = monitors [i];
-		fprintf (outfile, "\tLock object %p: %d contentions\n", (void*)mdesc->objid, (int)mdesc->contentions);
+		if (mdesc->name)
+			fprintf (outfile, "\tRuntime %s lock %p: %d contentions\n", mdesc->name, (void*)mdesc->objid, (int)mdesc->contentions);
+		else
+			fprintf (outfile, "\tLock object %p: %d contentions\n", (void*)mdesc->objid, (int)mdesc->contentions);
 		fprintf (outfile, "\t\t%.6f secs total wait time, %.6f max, %.6f average\n",
 			mdesc->wait_time/1000000000.0, mdesc->max_wait_time/1000000000.0, mdesc->wait_time/1000000000.0/mdesc->contentions);
 		dump_traces (&mdesc->traces, "contentions");
@@ -3433,6 +3665,8 @@ dump_monitors (void)
 	fprintf (outfile, "\tLock contentions: %llu\n", (unsigned long long) monitor_contention);
 	fprintf (outfile, "\tLock acquired: %llu\n", (unsigned long long) monitor_acquired);
 	fprintf (outfile, "\tLock failures: %llu\n", (unsigned long long) monitor_failed);
+	if (runtime_lock_contention)
+		fprintf (outfile, "\tRuntime lock contentions: %llu\n", (unsigned long long) runtime_lock_contention);
 }
 
 static void
@@ -3473,8 +3707,7 @@ dump_jit (void)
 	int compiled_methods = 0;
 	MethodDesc* m;
 	fprintf (outfile, "\nJIT summary\n");
-	for (i = 0; i < HASH_SIZE; ++i) {
-		m = method_hash [i];
+	for (i = 0; i < method_hash_size; ++i) {
 		for (m = method_hash [i]; m; m = m->next) {
 			if (!m->code || m->ignore_jit)
 				continue;
@@ -3498,7 +3731,7 @@ dump_allocations (void)
 	ClassDesc **classes = (ClassDesc **) g_malloc (num_classes * sizeof (void*));
 	ClassDesc *cd;
 	c = 0;
-	for (i = 0; i < HASH_SIZE; ++i) {
+	for (i = 0; i < class_hash_size; ++i) {
 		cd = class_hash [i];
 		while (cd) {
 			classes [c++] = cd;
@@ -3597,7 +3830,7 @@ dump_methods (void)
 	MethodDesc **methods = (MethodDesc **) g_malloc (num_methods * sizeof (void*));
 	MethodDesc *cd;
 	c = 0;
-	for (i = 0; i < HASH_SIZE; ++i) {
+	for (i = 0; i < method_hash_size; ++i) {
 		cd = method_hash [i];
 		while (cd) {
 			cd->total_time = cd->self_time + cd->callee_time;
@@ -3706,6 +3939,33 @@ heap_shot_summary (HeapShot *hs, int hs_num, HeapShot *last_hs)
 		(unsigned long long) (size),
 		(unsigned long long) (count),
 		ccount, hs->num_roots);
+	if (size) {
+		/*
+		 * How much of the heap is object headers (vtable and sync words), and what a
+		 * single word header would save, to size up a compact object layout.
+		 */
+		uint64_t header_size = count * 2 * heap_shot_ptr_size;
+		fprintf (outfile, "	Object headers: %llu bytes (%.1f%%), objects of at most %d bytes: %llu (%llu bytes), a one word header would save %llu bytes (%.1f%%)\n",
+			(unsigned long long) (header_size),
+			header_size * 100.0 / size,
+			HEAP_SHOT_SMALL_OBJECT_WORDS * heap_shot_ptr_size,
+			(unsigned long long) (hs->small_count),
+			(unsigned long long) (hs->small_size),
+			(unsigned long long) (header_size / 2),
+			header_size * 50.0 / size);
+		/*
+		 * Only non-null references are reported, so this is a lower bound of
+		 * what 32 bit references would save.  The address span tells whether
+		 * the objects would fit in 32 GB at the current heap layout.
+		 */
+		if (heap_shot_ptr_size == 8)
+			fprintf (outfile, "	References: %llu non-null (%llu bytes), 32 bit references would save at least %llu bytes (%.1f%%), objects span %.2f GB\n",
+				(unsigned long long) (hs->ref_count),
+				(unsigned long long) (hs->ref_count * 8),
+				(unsigned long long) (hs->ref_count * 4),
+				hs->ref_count * 400.0 / size,
+				(hs->max_addr - hs->min_addr) / (1024.0 * 1024.0 * 1024.0));
+	}
 	if (!verbose && ccount > 30)
 		ccount = 30;
 	fprintf (outfile, "\t%10s %10s %8s Class name\n", "Bytes", "Count", "Average");
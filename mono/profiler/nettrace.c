@@ -0,0 +1,862 @@
+/*
+ * nettrace.c: nettrace output for the log profiler
+ *
+ * Licensed under the MIT license. See LICENSE file in the project root for full license information.
+ */
+
+/*
+ * With the nettrace=FILE option, the log profiler mirrors part of its event
+ * stream into a nettrace file, the format that EventPipe writes and that
+ * PerfView, TraceEvent and dotnet-trace read. Log buffers are decoded on the
+ * writer thread as they are dumped, and the events that have a counterpart in
+ * the Microsoft-Windows-DotNETRuntime provider are re-encoded:
+ *
+ *	TYPE_GC_EVENT	GCStart_V2, GCEnd_V1, GCSuspendEEBegin_V1,
+ *			GCSuspendEEEnd_V1, GCRestartEEBegin_V1, GCRestartEEEnd_V1
+ *	TYPE_JIT	MethodLoadVerbose_V1
+ *	TYPE_MONITOR	ContentionStart_V1, ContentionStop
+ *
+ * Everything else is skipped. Exceptions are not mapped because the log
+ * stream only carries the exception object, not its type name or message.
+ *
+ * Events are written uncompressed and without stacks, in event blocks that
+ * are not sorted by time; readers sort them per thread using the sequence
+ * numbers. Timestamps are the log profiler's nanosecond clock, which the
+ * trace header declares as the QPC frequency.
+ *
+ * A writer is not thread safe: it must only be used from the log profiler's
+ * writer thread, or after that thread has exited.
+ */
+
+#include <config.h>
+#include <mono/metadata/profiler.h>
+#include <mono/utils/mono-counters.h>
+#include "log.h"
+#include "nettrace.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define NETTRACE_PROVIDER "Microsoft-Windows-DotNETRuntime"
+
+// Flush the pending event block once it grows past this size.
+#define NETTRACE_BLOCK_SIZE (64 * 1024)
+
+// Size of an uncompressed event header, including the leading size field.
+#define NETTRACE_EVENT_HEADER_SIZE 80
+
+// Size of the header at the start of each block's content.
+#define NETTRACE_BLOCK_HEADER_SIZE 20
+
+#define NETTRACE_KEYWORD_GC 0x1
+#define NETTRACE_KEYWORD_JIT 0x10
+#define NETTRACE_KEYWORD_CONTENTION 0x4000
+
+#define NETTRACE_LEVEL_INFORMATIONAL 4
+
+#define NETTRACE_CLR_INSTANCE_ID 0
+
+// MethodFlags bit for jitted code in MethodLoadVerbose.
+#define NETTRACE_METHOD_FLAG_JITTED 0x8
+
+// Reason value for GCSuspendEEBegin.
+#define NETTRACE_SUSPEND_FOR_GC 1
+
+/* FastSerialization tags. */
+enum {
+	TAG_NULL_REFERENCE = 1,
+	TAG_BEGIN_PRIVATE_OBJECT = 5,
+	TAG_END_OBJECT = 6,
+};
+
+/* System.TypeCode values used in event metadata. */
+enum {
+	TYPE_CODE_BYTE = 6,
+	TYPE_CODE_UINT16 = 8,
+	TYPE_CODE_UINT32 = 10,
+	TYPE_CODE_UINT64 = 12,
+	TYPE_CODE_STRING = 18,
+};
+
+/* Metadata ids of the events we write, in the order of event_descs. */
+enum {
+	META_GC_START = 1,
+	META_GC_END,
+	META_GC_SUSPEND_BEGIN,
+	META_GC_SUSPEND_END,
+	META_GC_RESTART_BEGIN,
+	META_GC_RESTART_END,
+	META_METHOD_LOAD,
+	META_CONTENTION_START,
+	META_CONTENTION_STOP,
+};
+
+typedef struct {
+	int type;
+	const char *name;
+} NettraceField;
+
+typedef struct {
+	int id;
+	const char *name;
+	uint64_t keywords;
+	int version;
+	NettraceField fields [11];
+} NettraceEventDesc;
+
+#define CLR_INSTANCE_FIELD { TYPE_CODE_UINT16, "ClrInstanceID" }
+
+static const NettraceEventDesc event_descs [] = {
+	{ 1, "GCStart", NETTRACE_KEYWORD_GC, 2, {
+		{ TYPE_CODE_UINT32, "Count" },
+		{ TYPE_CODE_UINT32, "Depth" },
+		{ TYPE_CODE_UINT32, "Reason" },
+		{ TYPE_CODE_UINT32, "Type" },
+		CLR_INSTANCE_FIELD,
+		{ TYPE_CODE_UINT64, "ClientSequenceNumber" },
+	} },
+	{ 2, "GCEnd", NETTRACE_KEYWORD_GC, 1, {
+		{ TYPE_CODE_UINT32, "Count" },
+		{ TYPE_CODE_UINT32, "Depth" },
+		CLR_INSTANCE_FIELD,
+	} },
+	{ 9, "GCSuspendEEBegin", NETTRACE_KEYWORD_GC, 1, {
+		{ TYPE_CODE_UINT32, "Reason" },
+		{ TYPE_CODE_UINT32, "Count" },
+		CLR_INSTANCE_FIELD,
+	} },
+	{ 8, "GCSuspendEEEnd", NETTRACE_KEYWORD_GC, 1, {
+		CLR_INSTANCE_FIELD,
+	} },
+	{ 7, "GCRestartEEBegin", NETTRACE_KEYWORD_GC, 1, {
+		CLR_INSTANCE_FIELD,
+	} },
+	{ 3, "GCRestartEEEnd", NETTRACE_KEYWORD_GC, 1, {
+		CLR_INSTANCE_FIELD,
+	} },
+	{ 143, "MethodLoadVerbose", NETTRACE_KEYWORD_JIT, 1, {
+		{ TYPE_CODE_UINT64, "MethodID" },
+		{ TYPE_CODE_UINT64, "ModuleID" },
+		{ TYPE_CODE_UINT64, "MethodStartAddress" },
+		{ TYPE_CODE_UINT32, "MethodSize" },
+		{ TYPE_CODE_UINT32, "MethodToken" },
+		{ TYPE_CODE_UINT32, "MethodFlags" },
+		{ TYPE_CODE_STRING, "MethodNamespace" },
+		{ TYPE_CODE_STRING, "MethodName" },
+		{ TYPE_CODE_STRING, "MethodSignature" },
+		CLR_INSTANCE_FIELD,
+	} },
+	{ 81, "ContentionStart", NETTRACE_KEYWORD_CONTENTION, 1, {
+		{ TYPE_CODE_BYTE, "ContentionFlags" },
+		CLR_INSTANCE_FIELD,
+	} },
+	{ 91, "ContentionStop", NETTRACE_KEYWORD_CONTENTION, 0, {
+		{ TYPE_CODE_BYTE, "ContentionFlags" },
+		CLR_INSTANCE_FIELD,
+	} },
+};
+
+struct _NettraceWriter {
+	FILE *file;
+
+	// Bytes written to the file so far, used to align block contents.
+	uint64_t offset;
+
+	// Content of the event block being filled, without its header.
+	GByteArray *block;
+	uint64_t block_min_time;
+	uint64_t block_max_time;
+
+	uint64_t sync_time;
+
+	// Thread id -> last sequence number used for that thread.
+	GHashTable *sequence_numbers;
+
+	uint32_t gc_count;
+};
+
+static void
+append_u8 (GByteArray *buf, uint8_t value)
+{
+	g_byte_array_append (buf, &value, sizeof (value));
+}
+
+static void
+append_u16 (GByteArray *buf, uint16_t value)
+{
+	value = GUINT16_TO_LE (value);
+	g_byte_array_append (buf, (const guint8 *) &value, sizeof (value));
+}
+
+static void
+append_u32 (GByteArray *buf, uint32_t value)
+{
+	value = GUINT32_TO_LE (value);
+	g_byte_array_append (buf, (const guint8 *) &value, sizeof (value));
+}
+
+static void
+append_u64 (GByteArray *buf, uint64_t value)
+{
+	value = GUINT64_TO_LE (value);
+	g_byte_array_append (buf, (const guint8 *) &value, sizeof (value));
+}
+
+static void
+append_zeros (GByteArray *buf, guint count)
+{
+	for (guint i = 0; i < count; i++)
+		append_u8 (buf, 0);
+}
+
+/* Appends str as a NUL terminated UTF-16 string, the only string encoding nettrace uses. */
+static void
+append_utf16 (GByteArray *buf, const char *str, glong len)
+{
+	glong written = 0;
+	gunichar2 *utf16 = g_utf8_to_utf16 (str, len, NULL, &written, NULL);
+
+	for (glong i = 0; utf16 && i < written; i++)
+		append_u16 (buf, utf16 [i]);
+
+	append_u16 (buf, 0);
+
+	g_free (utf16);
+}
+
+/* A serialized type: an object with a null type whose payload is the type's version and name. */
+static void
+append_type (GByteArray *buf, const char *name, int version, int min_reader_version)
+{
+	append_u8 (buf, TAG_BEGIN_PRIVATE_OBJECT);
+	append_u8 (buf, TAG_NULL_REFERENCE);
+	append_u32 (buf, version);
+	append_u32 (buf, min_reader_version);
+	append_u32 (buf, strlen (name));
+	g_byte_array_append (buf, (const guint8 *) name, strlen (name));
+	append_u8 (buf, TAG_END_OBJECT);
+}
+
+static void
+write_data (NettraceWriter *writer, GByteArray *buf)
+{
+	fwrite (buf->data, buf->len, 1, writer->file);
+	writer->offset += buf->len;
+}
+
+/*
+ * Writes a block object. The block content has to start at a 4 byte aligned
+ * file offset, so padding goes between the size field and the content.
+ */
+static void
+write_block (NettraceWriter *writer, const char *name, GByteArray *content, uint64_t min_time, uint64_t max_time)
+{
+	GByteArray *obj = g_byte_array_new ();
+
+	append_u8 (obj, TAG_BEGIN_PRIVATE_OBJECT);
+	append_type (obj, name, 2, 2);
+	append_u32 (obj, NETTRACE_BLOCK_HEADER_SIZE + content->len);
+
+	while ((writer->offset + obj->len) % 4)
+		append_u8 (obj, 0);
+
+	append_u16 (obj, NETTRACE_BLOCK_HEADER_SIZE);
+	append_u16 (obj, 0); // flags: no header compression
+	append_u64 (obj, min_time);
+	append_u64 (obj, max_time);
+	g_byte_array_append (obj, content->data, content->len);
+	append_u8 (obj, TAG_END_OBJECT);
+
+	write_data (writer, obj);
+	g_byte_array_free (obj, TRUE);
+}
+
+static void
+append_event (GByteArray *buf, uint32_t metadata_id, uint32_t sequence_number, uint64_t thread_id, uint64_t time, GByteArray *payload)
+{
+	guint padding = (4 - payload->len % 4) % 4;
+
+	append_u32 (buf, NETTRACE_EVENT_HEADER_SIZE - sizeof (uint32_t) + payload->len + padding);
+	append_u32 (buf, metadata_id);
+	append_u32 (buf, sequence_number);
+	append_u64 (buf, thread_id);
+	append_u64 (buf, thread_id); // capture thread
+	append_u32 (buf, 0); // processor number
+	append_u32 (buf, 0); // stack id, no stack
+	append_u64 (buf, time);
+	append_zeros (buf, 16); // activity id
+	append_zeros (buf, 16); // related activity id
+	append_u32 (buf, payload->len);
+	g_byte_array_append (buf, payload->data, payload->len);
+	append_zeros (buf, padding);
+}
+
+static void
+write_metadata (NettraceWriter *writer)
+{
+	GByteArray *content = g_byte_array_new ();
+	GByteArray *payload = g_byte_array_new ();
+
+	for (guint i = 0; i < G_N_ELEMENTS (event_descs); i++) {
+		const NettraceEventDesc *desc = &event_descs [i];
+		guint nfields = 0;
+
+		while (nfields < G_N_ELEMENTS (desc->fields) && desc->fields [nfields].name)
+			nfields++;
+
+		g_byte_array_set_size (payload, 0);
+		append_u32 (payload, i + 1);
+		append_utf16 (payload, NETTRACE_PROVIDER, -1);
+		append_u32 (payload, desc->id);
+		append_utf16 (payload, desc->name, -1);
+		append_u64 (payload, desc->keywords);
+		append_u32 (payload, desc->version);
+		append_u32 (payload, NETTRACE_LEVEL_INFORMATIONAL);
+		append_u32 (payload, nfields);
+
+		for (guint j = 0; j < nfields; j++) {
+			append_u32 (payload, desc->fields [j].type);
+			append_utf16 (payload, desc->fields [j].name, -1);
+		}
+
+		append_event (content, 0, 0, 0, writer->sync_time, payload);
+	}
+
+	write_block (writer, "MetadataBlock", content, writer->sync_time, writer->sync_time);
+
+	g_byte_array_free (payload, TRUE);
+	g_byte_array_free (content, TRUE);
+}
+
+static void
+flush_events (NettraceWriter *writer)
+{
+	if (!writer->block->len)
+		return;
+
+	write_block (writer, "EventBlock", writer->block, writer->block_min_time, writer->block_max_time);
+	g_byte_array_set_size (writer->block, 0);
+}
+
+static void
+write_event (NettraceWriter *writer, uint32_t metadata_id, uintptr_t thread_id, uint64_t time, GByteArray *payload)
+{
+	uint32_t seq = GPOINTER_TO_UINT (g_hash_table_lookup (writer->sequence_numbers, (gpointer) thread_id)) + 1;
+
+	g_hash_table_insert (writer->sequence_numbers, (gpointer) thread_id, GUINT_TO_POINTER (seq));
+
+	if (!writer->block->len || time < writer->block_min_time)
+		writer->block_min_time = time;
+	if (!writer->block->len || time > writer->block_max_time)
+		writer->block_max_time = time;
+
+	append_event (writer->block, metadata_id, seq, thread_id, time, payload);
+
+	if (writer->block->len >= NETTRACE_BLOCK_SIZE)
+		flush_events (writer);
+}
+
+NettraceWriter *
+nettrace_writer_open (const char *filename, uint64_t sync_time, int pid, int processors)
+{
+	FILE *file = fopen (filename, "wb");
+
+	if (!file)
+		return NULL;
+
+	NettraceWriter *writer = g_new0 (NettraceWriter, 1);
+
+	writer->file = file;
+	writer->block = g_byte_array_new ();
+	writer->sync_time = sync_time;
+	writer->sequence_numbers = g_hash_table_new (NULL, NULL);
+
+	GByteArray *buf = g_byte_array_new ();
+	const char *serializer = "!FastSerialization.1";
+	time_t now = time (NULL);
+	struct tm *tm = gmtime (&now);
+
+	g_byte_array_append (buf, (const guint8 *) "Nettrace", 8);
+	append_u32 (buf, strlen (serializer));
+	g_byte_array_append (buf, (const guint8 *) serializer, strlen (serializer));
+
+	append_u8 (buf, TAG_BEGIN_PRIVATE_OBJECT);
+	append_type (buf, "Trace", 4, 4);
+	// Sync time as a SYSTEMTIME in UTC.
+	append_u16 (buf, tm->tm_year + 1900);
+	append_u16 (buf, tm->tm_mon + 1);
+	append_u16 (buf, tm->tm_wday);
+	append_u16 (buf, tm->tm_mday);
+	append_u16 (buf, tm->tm_hour);
+	append_u16 (buf, tm->tm_min);
+	append_u16 (buf, tm->tm_sec);
+	append_u16 (buf, 0);
+	append_u64 (buf, sync_time);
+	append_u64 (buf, 1000000000); // timestamps are in nanoseconds
+	append_u32 (buf, sizeof (gpointer));
+	append_u32 (buf, pid);
+	append_u32 (buf, processors);
+	append_u32 (buf, 0); // expected CPU sampling rate
+	append_u8 (buf, TAG_END_OBJECT);
+
+	write_data (writer, buf);
+	g_byte_array_free (buf, TRUE);
+
+	write_metadata (writer);
+
+	return writer;
+}
+
+static uint64_t
+decode_uleb128 (const uint8_t *buf, const uint8_t **endbuf)
+{
+	uint64_t res = 0;
+	int shift = 0;
+
+	while (1) {
+		uint8_t b = *buf++;
+		res |= (((uint64_t) (b & 0x7f)) << shift);
+
+		if (!(b & 0x80))
+			break;
+
+		shift += 7;
+	}
+
+	*endbuf = buf;
+
+	return res;
+}
+
+static intptr_t
+decode_sleb128 (const uint8_t *buf, const uint8_t **endbuf)
+{
+	intptr_t res = 0;
+	int shift = 0;
+
+	while (1) {
+		uint8_t b = *buf++;
+		res |= (((intptr_t) (b & 0x7f)) << shift);
+		shift += 7;
+
+		if (!(b & 0x80)) {
+			if (shift < (int) sizeof (intptr_t) * 8 && (b & 0x40))
+				res |= - ((intptr_t) 1 << shift);
+
+			break;
+		}
+	}
+
+	*endbuf = buf;
+
+	return res;
+}
+
+static const char *
+skip_string (const uint8_t *p)
+{
+	const char *str = (const char *) p;
+
+	return str + strlen (str) + 1;
+}
+
+static const uint8_t *
+skip_backtrace (const uint8_t *p, uintptr_t *method)
+{
+	uint64_t count = decode_uleb128 (p, &p);
+
+	for (uint64_t i = 0; i < count; i++)
+		*method += decode_sleb128 (p, &p);
+
+	return p;
+}
+
+static void
+write_gc_event (NettraceWriter *writer, uintptr_t thread_id, uint64_t time, int ev, int generation)
+{
+	GByteArray *payload = g_byte_array_new ();
+	uint32_t id;
+
+	switch (ev) {
+	case MONO_GC_EVENT_START:
+		id = META_GC_START;
+		append_u32 (payload, ++writer->gc_count);
+		append_u32 (payload, generation);
+		append_u32 (payload, 0); // reason: small object allocation
+		append_u32 (payload, 0); // type: non-concurrent
+		append_u16 (payload, NETTRACE_CLR_INSTANCE_ID);
+		append_u64 (payload, 0); // client sequence number
+		break;
+	case MONO_GC_EVENT_END:
+		id = META_GC_END;
+		append_u32 (payload, writer->gc_count);
+		append_u32 (payload, generation);
+		append_u16 (payload, NETTRACE_CLR_INSTANCE_ID);
+		break;
+	case MONO_GC_EVENT_PRE_STOP_WORLD:
+		id = META_GC_SUSPEND_BEGIN;
+		append_u32 (payload, NETTRACE_SUSPEND_FOR_GC);
+		append_u32 (payload, writer->gc_count);
+		append_u16 (payload, NETTRACE_CLR_INSTANCE_ID);
+		break;
+	case MONO_GC_EVENT_POST_STOP_WORLD:
+		id = META_GC_SUSPEND_END;
+		append_u16 (payload, NETTRACE_CLR_INSTANCE_ID);
+		break;
+	case MONO_GC_EVENT_PRE_START_WORLD:
+		id = META_GC_RESTART_BEGIN;
+		append_u16 (payload, NETTRACE_CLR_INSTANCE_ID);
+		break;
+	case MONO_GC_EVENT_POST_START_WORLD:
+		id = META_GC_RESTART_END;
+		append_u16 (payload, NETTRACE_CLR_INSTANCE_ID);
+		break;
+	default:
+		g_byte_array_free (payload, TRUE);
+		return;
+	}
+
+	write_event (writer, id, thread_id, time, payload);
+	g_byte_array_free (payload, TRUE);
+}
+
+/*
+ * name is the full method name from mono_method_full_name (), e.g.
+ * "System.String:Concat (string,string)", which is split into the namespace
+ * (the class name), method name and signature fields.
+ */
+static void
+write_method_load (NettraceWriter *writer, uintptr_t thread_id, uint64_t time, uintptr_t method, uintptr_t code, uint64_t size, const char *name)
+{
+	GByteArray *payload = g_byte_array_new ();
+	const char *sig = NULL;
+
+	for (const char *s = strstr (name, " ("); s; s = strstr (s + 1, " ("))
+		sig = s;
+
+	const char *name_end = sig ? sig : name + strlen (name);
+	const char *colon = name_end;
+
+	while (colon > name && *colon != ':')
+		colon--;
+
+	append_u64 (payload, method);
+	append_u64 (payload, 0); // module id
+	append_u64 (payload, code);
+	append_u32 (payload, size);
+	append_u32 (payload, 0); // method token
+	append_u32 (payload, NETTRACE_METHOD_FLAG_JITTED);
+
+	if (*colon == ':') {
+		append_utf16 (payload, name, colon - name);
+		append_utf16 (payload, colon + 1, name_end - colon - 1);
+	} else {
+		append_utf16 (payload, "", -1);
+		append_utf16 (payload, name, name_end - name);
+	}
+
+	append_utf16 (payload, sig ? sig + 1 : "", -1);
+	append_u16 (payload, NETTRACE_CLR_INSTANCE_ID);
+
+	write_event (writer, META_METHOD_LOAD, thread_id, time, payload);
+	g_byte_array_free (payload, TRUE);
+}
+
+static void
+write_contention (NettraceWriter *writer, uintptr_t thread_id, uint64_t time, uint32_t id)
+{
+	GByteArray *payload = g_byte_array_new ();
+
+	append_u8 (payload, 0); // flags: managed
+	append_u16 (payload, NETTRACE_CLR_INSTANCE_ID);
+
+	write_event (writer, id, thread_id, time, payload);
+	g_byte_array_free (payload, TRUE);
+}
+
+/*
+ * Decodes one log buffer (see the buffer format in log.h) and writes the
+ * events that map to runtime provider events. Every event has to be walked,
+ * since the time and method fields are deltas from the previous event.
+ */
+void
+nettrace_writer_add_buffer (NettraceWriter *writer, const uint8_t *data, size_t size, uint64_t time_base, uintptr_t ptr_base, uintptr_t method_base, uintptr_t thread_id)
+{
+	const uint8_t *p = data;
+	const uint8_t *end = data + size;
+	uint64_t time = time_base;
+	uintptr_t method = method_base;
+
+	while (p < end) {
+		int event = *p++;
+		int type = event & 0xf;
+		int subtype = event & 0xf0;
+
+		time += decode_uleb128 (p, &p);
+
+		switch (type) {
+		case TYPE_ALLOC:
+			decode_sleb128 (p, &p); // vtable
+			decode_sleb128 (p, &p); // object
+			decode_uleb128 (p, &p); // size
+			if (subtype == TYPE_ALLOC_BT)
+				p = skip_backtrace (p, &method);
+			break;
+		case TYPE_GC:
+			switch (subtype) {
+			case TYPE_GC_RESIZE:
+				decode_uleb128 (p, &p);
+				break;
+			case TYPE_GC_EVENT: {
+				int ev = *p++;
+				int generation = *p++;
+
+				write_gc_event (writer, thread_id, time, ev, generation);
+				break;
+			}
+			case TYPE_GC_MOVE: {
+				uint64_t num = decode_uleb128 (p, &p);
+
+				for (uint64_t i = 0; i < num; i++)
+					decode_sleb128 (p, &p);
+				break;
+			}
+			case TYPE_GC_HANDLE_CREATED:
+			case TYPE_GC_HANDLE_CREATED_BT:
+				decode_uleb128 (p, &p); // handle type
+				decode_uleb128 (p, &p); // handle
+				decode_sleb128 (p, &p); // object
+				if (subtype == TYPE_GC_HANDLE_CREATED_BT)
+					p = skip_backtrace (p, &method);
+				break;
+			case TYPE_GC_HANDLE_DESTROYED:
+			case TYPE_GC_HANDLE_DESTROYED_BT:
+				decode_uleb128 (p, &p); // handle type
+				decode_uleb128 (p, &p); // handle
+				if (subtype == TYPE_GC_HANDLE_DESTROYED_BT)
+					p = skip_backtrace (p, &method);
+				break;
+			case TYPE_GC_FINALIZE_START:
+			case TYPE_GC_FINALIZE_END:
+				break;
+			case TYPE_GC_FINALIZE_OBJECT_START:
+			case TYPE_GC_FINALIZE_OBJECT_END:
+				decode_sleb128 (p, &p);
+				break;
+			default:
+				return;
+			}
+			break;
+		case TYPE_METADATA: {
+			int mtype = *p++;
+
+			decode_sleb128 (p, &p); // pointer
+
+			switch (mtype) {
+			case TYPE_CLASS:
+			case TYPE_ASSEMBLY:
+				decode_sleb128 (p, &p); // image
+				p = (const uint8_t *) skip_string (p);
+				break;
+			case TYPE_IMAGE:
+				p = (const uint8_t *) skip_string (p); // name
+				p = (const uint8_t *) skip_string (p); // mvid
+				break;
+			case TYPE_DOMAIN:
+			case TYPE_THREAD:
+				if (!subtype)
+					p = (const uint8_t *) skip_string (p);
+				break;
+			case TYPE_CONTEXT:
+				decode_sleb128 (p, &p); // domain
+				break;
+			case TYPE_VTABLE:
+				decode_sleb128 (p, &p); // domain
+				decode_sleb128 (p, &p); // class
+				break;
+			default:
+				return;
+			}
+			break;
+		}
+		case TYPE_METHOD:
+			method += decode_sleb128 (p, &p);
+
+			if (subtype == TYPE_JIT) {
+				uintptr_t code = ptr_base + decode_sleb128 (p, &p);
+				uint64_t code_size = decode_uleb128 (p, &p);
+				const char *name = (const char *) p;
+
+				p = (const uint8_t *) skip_string (p);
+				write_method_load (writer, thread_id, time, method, code, code_size, name);
+			}
+			break;
+		case TYPE_EXCEPTION:
+			if ((event & 0x70) == TYPE_CLAUSE) {
+				p++; // clause type
+				decode_uleb128 (p, &p); // clause index
+				method += decode_sleb128 (p, &p);
+				decode_sleb128 (p, &p); // object
+			} else {
+				decode_sleb128 (p, &p); // object
+				if (event & TYPE_THROW_BT)
+					p = skip_backtrace (p, &method);
+			}
+			break;
+		case TYPE_MONITOR: {
+			int ev = *p++;
+
+			if (ev == MONO_PROFILER_MONITOR_RUNTIME_LOCK) {
+				decode_sleb128 (p, &p); // lock
+				decode_uleb128 (p, &p); // wait time
+				p = (const uint8_t *) skip_string (p);
+			} else {
+				decode_sleb128 (p, &p); // object
+
+				if (ev == MONO_PROFILER_MONITOR_CONTENTION)
+					write_contention (writer, thread_id, time, META_CONTENTION_START);
+				else
+					write_contention (writer, thread_id, time, META_CONTENTION_STOP);
+			}
+
+			if (event & TYPE_MONITOR_BT)
+				p = skip_backtrace (p, &method);
+			break;
+		}
+		case TYPE_HEAP:
+			switch (subtype) {
+			case TYPE_HEAP_START:
+			case TYPE_HEAP_END:
+				break;
+			case TYPE_HEAP_OBJECT: {
+				decode_sleb128 (p, &p); // object
+				decode_sleb128 (p, &p); // vtable
+				decode_uleb128 (p, &p); // size
+				p++; // generation
+
+				uint64_t num = decode_uleb128 (p, &p);
+
+				for (uint64_t i = 0; i < num; i++) {
+					decode_uleb128 (p, &p); // offset
+					decode_sleb128 (p, &p); // reference
+				}
+				break;
+			}
+			case TYPE_HEAP_ROOT: {
+				uint64_t num = decode_uleb128 (p, &p);
+
+				for (uint64_t i = 0; i < num; i++) {
+					decode_sleb128 (p, &p); // address
+					decode_sleb128 (p, &p); // object
+				}
+				break;
+			}
+			case TYPE_HEAP_ROOT_REGISTER:
+				decode_sleb128 (p, &p); // start
+				decode_uleb128 (p, &p); // size
+				p++; // source
+				decode_sleb128 (p, &p); // key
+				p = (const uint8_t *) skip_string (p);
+				break;
+			case TYPE_HEAP_ROOT_UNREGISTER:
+				decode_sleb128 (p, &p);
+				break;
+			default:
+				return;
+			}
+			break;
+		case TYPE_SAMPLE:
+			switch (subtype) {
+			case TYPE_SAMPLE_HIT: {
+				decode_sleb128 (p, &p); // thread
+
+				uint64_t count = decode_uleb128 (p, &p);
+
+				for (uint64_t i = 0; i < count; i++)
+					decode_sleb128 (p, &p);
+
+				p = skip_backtrace (p, &method);
+				break;
+			}
+			case TYPE_SAMPLE_USYM:
+				decode_sleb128 (p, &p); // address
+				decode_uleb128 (p, &p); // size
+				p = (const uint8_t *) skip_string (p);
+				break;
+			case TYPE_SAMPLE_COUNTERS_DESC: {
+				uint64_t len = decode_uleb128 (p, &p);
+
+				for (uint64_t i = 0; i < len; i++) {
+					if (decode_uleb128 (p, &p) == MONO_COUNTER_PERFCOUNTERS)
+						p = (const uint8_t *) skip_string (p);
+
+					p = (const uint8_t *) skip_string (p);
+					decode_uleb128 (p, &p); // type
+					decode_uleb128 (p, &p); // unit
+					decode_uleb128 (p, &p); // variance
+					decode_uleb128 (p, &p); // index
+				}
+				break;
+			}
+			case TYPE_SAMPLE_COUNTERS:
+				while (decode_uleb128 (p, &p)) {
+					uint64_t counter_type = decode_uleb128 (p, &p);
+
+					if (counter_type == MONO_COUNTER_DOUBLE) {
+						p += sizeof (double);
+					} else if (counter_type == MONO_COUNTER_STRING) {
+						if (*p++)
+							p = (const uint8_t *) skip_string (p);
+					} else {
+						decode_uleb128 (p, &p);
+					}
+				}
+				break;
+			default:
+				return;
+			}
+			break;
+		case TYPE_RUNTIME:
+			if (subtype == TYPE_JITHELPER) {
+				int buffer_type = *p++;
+
+				decode_sleb128 (p, &p); // address
+				decode_uleb128 (p, &p); // size
+				if (buffer_type == MONO_PROFILER_CODE_BUFFER_SPECIFIC_TRAMPOLINE)
+					p = (const uint8_t *) skip_string (p);
+			} else
+				return;
+			break;
+		case TYPE_META:
+			if (subtype == TYPE_SYNC_POINT)
+				p++;
+			else if (subtype == TYPE_AOT_ID)
+				p = (const uint8_t *) skip_string (p);
+			else
+				return;
+			break;
+		default:
+			// We can't find the next event after one we don't know.
+			return;
+		}
+	}
+}
+
+void
+nettrace_writer_close (NettraceWriter *writer)
+{
+	GByteArray *buf = g_byte_array_new ();
+
+	flush_events (writer);
+
+	append_u8 (buf, TAG_NULL_REFERENCE);
+	write_data (writer, buf);
+	g_byte_array_free (buf, TRUE);
+
+	fclose (writer->file);
+
+	g_hash_table_destroy (writer->sequence_numbers);
+	g_byte_array_free (writer->block, TRUE);
+	g_free (writer);
+}
@@ -0,0 +1,12 @@
+#ifndef __MONO_PROFNETTRACE_H__
+#define __MONO_PROFNETTRACE_H__
+
+#include <glib.h>
+
+typedef struct _NettraceWriter NettraceWriter;
+
+NettraceWriter *nettrace_writer_open (const char *filename, uint64_t sync_time, int pid, int processors);
+void nettrace_writer_add_buffer (NettraceWriter *writer, const uint8_t *data, size_t size, uint64_t time_base, uintptr_t ptr_base, uintptr_t method_base, uintptr_t thread_id);
+void nettrace_writer_close (NettraceWriter *writer);
+
+#endif
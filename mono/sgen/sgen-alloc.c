@@ -30,6 +30,7 @@
 #ifdef HAVE_SGEN_GC
 
 #include <string.h>
+#include <math.h>
 
 #include "mono/sgen/sgen-gc.h"
 #include "mono/sgen/sgen-protocol.h"
@@ -63,10 +64,77 @@ static guint64 stat_bytes_alloced_los = 0;
 #define TLAB_TEMP_END	(__thread_info__->tlab_temp_end)
 #define TLAB_REAL_END	(__thread_info__->tlab_real_end)
 
+/*
+ * Allocation sampling.  The allocated bytes are only counted here, on the
+ * slow path, where a whole TLAB is accounted for when it's handed out, so the
+ * managed allocators don't have to know about it.  The distances between
+ * samples are drawn from an exponential distribution with the interval as
+ * mean, which makes every allocated byte equally likely to be sampled.  The
+ * allocation that crosses the threshold is the sample, and it stands for all
+ * the bytes counted since the previous one.
+ */
+static size_t alloc_sample_interval;
+
+void
+sgen_set_allocation_sample_interval (size_t interval)
+{
+	alloc_sample_interval = interval;
+}
+
+static void
+draw_next_allocation_sample (SgenThreadInfo *info)
+{
+	guint64 x = info->alloc_sample_seed;
+	double u;
+
+	if (!x)
+		x = ((guint64)(gsize)info * 0x9e3779b97f4a7c15ULL) | 1;
+	/* xorshift64 */
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+	info->alloc_sample_seed = x;
+
+	/* Uniform in (0, 1] */
+	u = ((x >> 11) + 1) * (1.0 / 9007199254740992.0);
+	info->alloc_sample_next = (gint64)(-log (u) * alloc_sample_interval) + 1;
+}
+
 static void
 increment_thread_allocation_counter (size_t byte_size)
 {
-	mono_thread_info_current ()->total_bytes_allocated += byte_size;
+	SgenThreadInfo *info = mono_thread_info_current ();
+
+	info->total_bytes_allocated += byte_size;
+
+	if (G_UNLIKELY (alloc_sample_interval)) {
+		if (!info->alloc_sample_next)
+			draw_next_allocation_sample (info);
+		info->alloc_sample_bytes += byte_size;
+		if (info->alloc_sample_bytes >= info->alloc_sample_next) {
+			info->alloc_sample_pending += info->alloc_sample_bytes;
+			info->alloc_sample_bytes = 0;
+			draw_next_allocation_sample (info);
+		}
+	}
+}
+
+/*
+ * Returns the weight of the sample taken by the current thread's last
+ * allocation, or 0 if it wasn't sampled.
+ */
+guint64
+sgen_take_allocation_sample (void)
+{
+	SgenThreadInfo *info = mono_thread_info_current ();
+	guint64 weight;
+
+	if (G_LIKELY (!info || !info->alloc_sample_pending))
+		return 0;
+
+	weight = info->alloc_sample_pending;
+	info->alloc_sample_pending = 0;
+	return weight;
 }
 
 static GCObject*
@@ -94,6 +162,19 @@ alloc_degraded (GCVTable vtable, size_t size, gboolean for_mature)
 	return p;
 }
 
+/*
+ * Each refill doubles the size of the thread's next TLAB, up to
+ * SGEN_MAX_TLAB_SIZE, and sgen_clear_tlabs () halves it again, so threads
+ * that allocate a lot take fewer trips to the fragment allocator.
+ */
+static size_t
+next_tlab_size (SgenThreadInfo *info)
+{
+	size_t size = MAX (info->tlab_refill_size, sgen_tlab_size);
+	info->tlab_refill_size = (guint32)MIN (size * 2, MAX (SGEN_MAX_TLAB_SIZE, sgen_tlab_size));
+	return size;
+}
+
 static void
 zero_tlab_if_necessary (void *p, size_t size)
 {
@@ -262,16 +343,17 @@ sgen_alloc_obj_nolock (GCVTable vtable, size_t size)
 				zero_tlab_if_necessary (p, size);
 			} else {
 				size_t alloc_size = 0;
+				size_t tlab_size = next_tlab_size (__thread_info__);
 				if (TLAB_START)
 					SGEN_LOG (3, "Retire TLAB: %p-%p [%ld]", TLAB_START, TLAB_REAL_END, (long)(TLAB_REAL_END - TLAB_NEXT - size));
 				sgen_nursery_retire_region (p, available_in_tlab);
 
-				p = (void **)sgen_nursery_alloc_range (sgen_tlab_size, size, &alloc_size);
+				p = (void **)sgen_nursery_alloc_range (tlab_size, size, &alloc_size);
 				if (!p) {
 					/* See comment above in similar case. */
 					sgen_ensure_free_space (sgen_tlab_size, GENERATION_NURSERY);
 					if (!sgen_degraded_mode)
-						p = (void **)sgen_nursery_alloc_range (sgen_tlab_size, size, &alloc_size);
+						p = (void **)sgen_nursery_alloc_range (tlab_size, size, &alloc_size);
 				}
 				if (!p)
 					return alloc_degraded (vtable, size, TRUE);
@@ -312,6 +394,34 @@ sgen_alloc_obj_nolock (GCVTable vtable, size_t size)
 	return (GCObject*)p;
 }
 
+/*
+ * sgen_alloc_large_obj_uninitialized_nolock:
+ *
+ *   Allocate a large object without references, clearing only its first
+ * HEADER_SIZE bytes, for clients which overwrite the rest right away.  Small
+ * objects gain nothing from this since TLABs are cleared in bulk.
+ */
+GCObject*
+sgen_alloc_large_obj_uninitialized_nolock (GCVTable vtable, size_t size, size_t header_size)
+{
+	void **p;
+
+	SGEN_ASSERT (0, size > SGEN_MAX_SMALL_OBJ_SIZE, "Only large objects are allocated uninitialized");
+
+	if (G_UNLIKELY (sgen_has_per_allocation_action))
+		return sgen_alloc_obj_nolock (vtable, size);
+
+	HEAVY_STAT (++stat_objects_alloced);
+	HEAVY_STAT (stat_bytes_alloced_los += size);
+
+	size = ALIGN_UP (size);
+	p = (void **)sgen_los_alloc_large_uninitialized (vtable, size, header_size);
+	if (p)
+		increment_thread_allocation_counter (size);
+
+	return (GCObject*)p;
+}
+
 GCObject*
 sgen_try_alloc_obj_nolock (GCVTable vtable, size_t size)
 {
@@ -376,7 +486,7 @@ sgen_try_alloc_obj_nolock (GCVTable vtable, size_t size)
 			size_t alloc_size = 0;
 
 			sgen_nursery_retire_region (p, available_in_tlab);
-			new_next = (char *)sgen_nursery_alloc_range (sgen_tlab_size, size, &alloc_size);
+			new_next = (char *)sgen_nursery_alloc_range (next_tlab_size (__thread_info__), size, &alloc_size);
 			p = (void**)new_next;
 			if (!p)
 				return NULL;
@@ -457,12 +567,25 @@ GCObject*
 sgen_alloc_obj_pinned (GCVTable vtable, size_t size)
 {
 	GCObject *p;
-
+	TLAB_ACCESS_INIT;
 
 	if (!SGEN_CAN_ALIGN_UP (size))
 		return NULL;
 	size = ALIGN_UP (size);
 
+	/* Small pinned objects come from a block the thread owns, if it has a suitable one */
+	if (size <= SGEN_MAX_SMALL_OBJ_SIZE && sgen_major_collector.alloc_small_pinned_obj_local) {
+		ENTER_CRITICAL_REGION;
+		p = sgen_major_collector.alloc_small_pinned_obj_local (__thread_info__, vtable, size, SGEN_VTABLE_HAS_REFERENCES (vtable));
+		EXIT_CRITICAL_REGION;
+		if (p) {
+			SGEN_LOG (6, "Allocated pinned object %p, vtable: %p (%s), size: %zd", p, vtable, sgen_client_vtable_get_name (vtable), size);
+			increment_thread_allocation_counter (size);
+			sgen_binary_protocol_alloc_pinned (p, vtable, size, sgen_client_get_provenance ());
+			return p;
+		}
+	}
+
 	LOCK_GC;
 
 	if (size > SGEN_MAX_SMALL_OBJ_SIZE) {
@@ -514,6 +637,7 @@ sgen_clear_tlabs (void)
 		info->tlab_next = NULL;
 		info->tlab_temp_end = NULL;
 		info->tlab_real_end = NULL;
+		info->tlab_refill_size /= 2;
 	} FOREACH_THREAD_END
 }
 
@@ -37,9 +37,19 @@
 #endif
 #include <sys/types.h>
 
+#if defined(__GNUC__) && defined(__SSE2__) && (defined(__x86_64__) || defined(__i386__))
+#include <emmintrin.h>
+#define SGEN_CARD_SCAN_SSE2 1
+#elif defined(__GNUC__) && defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define SGEN_CARD_SCAN_NEON 1
+#endif
+
 guint8 *sgen_cardtable;
 
 static gboolean need_mod_union;
+/* Whether managed code may mark cards itself instead of calling the barrier */
+static gboolean inline_barriers = TRUE;
 
 #ifdef HEAVY_STATISTICS
 guint64 marked_cards;
@@ -66,35 +76,24 @@ sgen_card_table_wbarrier_set_field (GCObject *obj, gpointer field_ptr, GCObject*
 	sgen_dummy_use (value);
 }
 
+/*
+ * Copy the references in bulk and then mark all the cards they were copied to, like
+ * the value copy does, instead of testing every reference for the nursery. A dirty
+ * card that doesn't point to the nursery only costs some extra scanning at the next
+ * collection, while the per-element loop was the bottleneck of Array.Copy.
+ */
 static void
 sgen_card_table_wbarrier_arrayref_copy (gpointer dest_ptr, gpointer src_ptr, int count)
 {
-	gpointer *dest = (gpointer *)dest_ptr;
-	gpointer *src = (gpointer *)src_ptr;
+	size_t size = count * sizeof (gpointer);
 
-	/*overlapping that required backward copying*/
-	if (src < dest && (src + count) > dest) {
-		gpointer *start = dest;
-		dest += count - 1;
-		src += count - 1;
+	TLAB_ACCESS_INIT;
+	ENTER_CRITICAL_REGION;
 
-		for (; dest >= start; --src, --dest) {
-			gpointer value = *src;
-			SGEN_UPDATE_REFERENCE_ALLOW_NULL (dest, value);
-			if (need_mod_union || sgen_ptr_in_nursery (value))
-				sgen_card_table_mark_address ((mword)dest);
-			sgen_dummy_use (value);
-		}
-	} else {
-		gpointer *end = dest + count;
-		for (; dest < end; ++src, ++dest) {
-			gpointer value = *src;
-			SGEN_UPDATE_REFERENCE_ALLOW_NULL (dest, value);
-			if (need_mod_union || sgen_ptr_in_nursery (value))
-				sgen_card_table_mark_address ((mword)dest);
-			sgen_dummy_use (value);
-		}
-	}	
+	mono_gc_memmove_aligned (dest_ptr, src_ptr, size);
+	sgen_card_table_mark_range ((mword)dest_ptr, size);
+
+	EXIT_CRITICAL_REGION;
 }
 
 static void
@@ -186,17 +185,9 @@ sgen_card_table_region_begin_scanning (mword start, mword size)
 static gboolean
 sgen_card_table_region_begin_scanning (mword start, mword size)
 {
-	gboolean res = FALSE;
 	guint8 *card = sgen_card_table_get_card_address (start);
 	guint8 *end = card + sgen_card_table_number_of_cards_in_range (start, size);
-
-	/*XXX this can be improved to work on words and have a branchless body */
-	while (card != end) {
-		if (*card++) {
-			res = TRUE;
-			break;
-		}
-	}
+	gboolean res = sgen_find_next_card (card, end) != end;
 
 	memset (sgen_card_table_get_card_address (start), 0, size >> CARD_BITS);
 
@@ -262,12 +253,7 @@ sgen_card_table_is_range_marked (guint8 *cards, mword address, mword size)
 	guint8 *end = cards + sgen_card_table_number_of_cards_in_range (address, size);
 
 	/*This is safe since this function is only called by code that only passes continuous card blocks*/
-	while (cards != end) {
-		if (*cards++)
-			return TRUE;
-	}
-	return FALSE;
-
+	return sgen_find_next_card (cards, end) != end;
 }
 
 static void
@@ -355,18 +341,25 @@ sgen_card_table_update_mod_union (guint8 *dest, char *obj, mword obj_size, size_
 		*out_num_cards = num_cards;
 }
 
+/* Number of mod union cards cleaned by precleaning since the last reset */
+static volatile gint32 precleaned_cards;
+
 /* Preclean cards and saves the cards that need to be scanned afterwards in cards_preclean */
 void
 sgen_card_table_preclean_mod_union (guint8 *cards, guint8 *cards_preclean, size_t num_cards)
 {
 	size_t i;
+	gint32 cleaned = 0;
 
 	memcpy (cards_preclean, cards, num_cards);
 	for (i = 0; i < num_cards; i++) {
 		if (cards_preclean [i]) {
 			cards [i] = 0;
+			++cleaned;
 		}
 	}
+	if (cleaned)
+		mono_atomic_add_i32 (&precleaned_cards, cleaned);
 	/*
 	 * When precleaning we need to make sure the card cleaning
 	 * takes place before the object is scanned. If we don't
@@ -378,6 +371,13 @@ sgen_card_table_preclean_mod_union (guint8 *cards, guint8 *cards_preclean, size_
 	mono_memory_barrier ();
 }
 
+/* Returns the number of cards precleaned since the last call. */
+gint32
+sgen_card_table_get_and_reset_precleaned_cards (void)
+{
+	return mono_atomic_xchg_i32 (&precleaned_cards, 0);
+}
+
 #ifdef SGEN_HAVE_OVERLAPPING_CARDS
 
 static void
@@ -490,10 +490,16 @@ sgen_get_target_card_table_configuration (int *shift_bits, target_mgreg_t *mask)
 	*mask = 0;
 #endif
 
-	return sgen_cardtable;
+	return inline_barriers ? sgen_cardtable : NULL;
 #endif
 }
 
+void
+sgen_card_table_set_inline_barriers (gboolean enabled)
+{
+	inline_barriers = enabled;
+}
+
 #if 0
 void
 sgen_card_table_dump_obj_card (GCObject *object, size_t size, void *dummy)
@@ -541,6 +547,30 @@ find_card_offset (mword card)
 #endif
 }
 
+#if defined(SGEN_CARD_SCAN_SSE2) || defined(SGEN_CARD_SCAN_NEON)
+/*
+ * Cards are mostly clean on large heaps, so we first skip over clean runs a
+ * vector block at a time, which with 512 byte cards covers 32KB of heap.
+ */
+#define CARD_SCAN_VECTOR_BLOCK 64
+
+static inline gboolean
+card_block_is_clean (guint8 *cards)
+{
+#ifdef SGEN_CARD_SCAN_SSE2
+	__m128i v = _mm_or_si128 (
+		_mm_or_si128 (_mm_loadu_si128 ((__m128i*)cards), _mm_loadu_si128 ((__m128i*)(cards + 16))),
+		_mm_or_si128 (_mm_loadu_si128 ((__m128i*)(cards + 32)), _mm_loadu_si128 ((__m128i*)(cards + 48))));
+	return _mm_movemask_epi8 (_mm_cmpeq_epi8 (v, _mm_setzero_si128 ())) == 0xffff;
+#else
+	uint8x16_t v = vorrq_u8 (
+		vorrq_u8 (vld1q_u8 (cards), vld1q_u8 (cards + 16)),
+		vorrq_u8 (vld1q_u8 (cards + 32), vld1q_u8 (cards + 48)));
+	return vmaxvq_u8 (v) == 0;
+#endif
+}
+#endif
+
 guint8*
 sgen_find_next_card (guint8 *card_data, guint8 *end)
 {
@@ -556,6 +586,11 @@ sgen_find_next_card (guint8 *card_data, guint8 *end)
 	if (card_data == end)
 		return end;
 
+#ifdef CARD_SCAN_VECTOR_BLOCK
+	while (end - card_data >= CARD_SCAN_VECTOR_BLOCK && card_block_is_clean (card_data))
+		card_data += CARD_SCAN_VECTOR_BLOCK;
+#endif
+
 	cards = (mword*)card_data;
 	cards_end = (mword*)((mword)end & ~MWORD_MASK);
 	while (cards < cards_end) {
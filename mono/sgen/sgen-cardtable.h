@@ -26,11 +26,13 @@ void sgen_card_table_free_mod_union (guint8 *mod_union, char *obj, mword obj_siz
 void sgen_card_table_update_mod_union_from_cards (guint8 *dest, guint8 *start_card, size_t num_cards);
 void sgen_card_table_update_mod_union (guint8 *dest, char *obj, mword obj_size, size_t *out_num_cards);
 void sgen_card_table_preclean_mod_union (guint8 *cards, guint8 *cards_preclean, size_t num_cards);
+gint32 sgen_card_table_get_and_reset_precleaned_cards (void);
 
 guint8* sgen_get_card_table_configuration (int *shift_bits, gpointer *mask);
 guint8* sgen_get_target_card_table_configuration (int *shift_bits, target_mgreg_t *mask);
 
 void sgen_card_table_init (SgenRememberedSet *remset);
+void sgen_card_table_set_inline_barriers (gboolean enabled);
 
 /*How many bytes a single card covers*/
 #define CARD_BITS 9
@@ -72,6 +72,14 @@ void sgen_client_finalize_notify (void);
 gboolean sgen_client_mark_ephemerons (ScanCopyContext ctx)
     MONO_PERMIT (need (sgen_gc_locked));
 
+/*
+ * Called with the address OBJ had before the collection, when the serial
+ * collector marks or copies it, while `sgen_report_marked_objects` is set.
+ * Can be called more than once for the same object.
+ */
+void sgen_client_object_marked (GCObject *obj)
+    MONO_PERMIT (need (sgen_gc_locked));
+
 /*
  * Clear ephemeron pairs with unreachable keys.
  * We pass the copy func so we can figure out if an array was promoted or not.
@@ -213,6 +221,14 @@ void sgen_client_bridge_register_finalized_object (GCObject *object);
 void sgen_client_mark_togglerefs (char *start, char *end, ScanCopyContext ctx);
 void sgen_client_clear_togglerefs (char *start, char *end, ScanCopyContext ctx);
 
+/*
+ * Variants of the above that only process the toggleref slots [from, to) and don't drain
+ * the gray queue, so the slots can be split across the workers.
+ */
+int sgen_client_get_num_togglerefs (void);
+void sgen_client_mark_togglerefs_in_range (char *start, char *end, ScanCopyContext ctx, int from, int to);
+void sgen_client_clear_togglerefs_in_range (char *start, char *end, ScanCopyContext ctx, int from, int to);
+
 /*
  * Called to handle `MONO_GC_PARAMS` and `MONO_GC_DEBUG` options.  The `handle` functions
  * must return TRUE if they have recognized and processed the option, FALSE otherwise.
@@ -123,6 +123,13 @@ typedef target_mword SgenDescriptor;
 #define DEFAULT_SWEEP_MODE SGEN_SWEEP_CONCURRENT
 #endif
 
+#if defined (HOST_WASM) && defined (ENABLE_WASM_THREADPOOL) && !defined (DISABLE_SGEN_MAJOR_MARKSWEEP_CONC)
+/* The experimental wasm threadpool build marks the nursery in parallel on web workers */
+#define DEFAULT_MINOR SGEN_MINOR_SIMPLE_PARALLEL
+#else
+#define DEFAULT_MINOR SGEN_MINOR_SIMPLE
+#endif
+
 
 
 /*
@@ -174,6 +181,12 @@ typedef target_mword SgenDescriptor;
 */
 #define SGEN_MAX_NURSERY_WASTE 512
 
+/*
+ * Threads that keep refilling their TLAB get bigger ones, up to this size.
+ * Every collection halves them again.
+ */
+#define SGEN_MAX_TLAB_SIZE (1024 * 32)
+
 
 /*
  * Max nursery size that we support.
@@ -234,6 +247,13 @@ typedef target_mword SgenDescriptor;
 #define SGEN_CEMENT_HASH(hv)	(((hv) ^ ((hv) >> SGEN_CEMENT_HASH_SHIFT)) & (SGEN_CEMENT_HASH_SIZE - 1))
 #define SGEN_CEMENT_THRESHOLD	1000
 
+/*
+ * Number of free GC handle slots each thread can hold on to per handle
+ * type.  Slots are reserved from, and returned to, the shared handle table
+ * half a cache at a time.
+ */
+#define SGEN_GCHANDLE_CACHE_SIZE	32
+
 /*
  * Default values for the nursery size
  */
@@ -258,4 +278,10 @@ typedef target_mword SgenDescriptor;
  */
 #define SGEN_PARALLEL_MINOR_MIN_NURSERY_SIZE (1 << 24)
 
+/*
+ * Number of entries in the always-on ring of recent GC events.  Must be a
+ * power of two.
+ */
+#define SGEN_RECENT_EVENTS_SIZE	256
+
 #endif
@@ -74,6 +74,7 @@ copy_object_no_checks (GCObject *obj, SgenGrayQueue *queue)
 		/* FIXME: Is this path ever tested? */
 		collector_pin_object (obj, queue);
 		sgen_set_pinned_from_failed_allocation (objsize);
+		SGEN_REPORT_MARKED_OBJECT (obj);
 		return obj;
 	}
 
@@ -81,6 +82,7 @@ copy_object_no_checks (GCObject *obj, SgenGrayQueue *queue)
 
 	/* set the forwarding pointer */
 	SGEN_FORWARD_OBJECT (obj, destination);
+	SGEN_REPORT_MARKED_OBJECT (obj);
 
 	if (has_references) {
 		SGEN_LOG (9, "Enqueuing gray object %p (%s)", destination, sgen_client_vtable_get_name (vt));
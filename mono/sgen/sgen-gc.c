@@ -181,6 +181,7 @@
 
 #include "mono/sgen/sgen-gc.h"
 #include "mono/sgen/sgen-cardtable.h"
+#include "mono/sgen/sgen-ssb.h"
 #include "mono/sgen/sgen-protocol.h"
 #include "mono/sgen/sgen-memory-governor.h"
 #include "mono/sgen/sgen-hash-table.h"
@@ -192,6 +193,7 @@
 #include "mono/utils/mono-proclib.h"
 #include "mono/utils/mono-memory-model.h"
 #include "mono/utils/hazard-pointer.h"
+#include "mono/utils/mono-numa.h"
 
 #include <mono/utils/memcheck.h>
 #include <mono/utils/mono-mmap-internals.h>
@@ -238,6 +240,23 @@ static gboolean do_dump_nursery_content = FALSE;
 static gboolean enable_nursery_canaries = FALSE;
 
 static gboolean precleaning_enabled = TRUE;
+/*
+ * Precleaning is repeated until a round finds fewer than this many dirty
+ * cards, or until we did `max_preclean_rounds` rounds, so that the finishing
+ * pause only has to rescan what was dirtied during the last round.
+ */
+#define PRECLEAN_CONVERGED_CARDS	1024
+static int max_preclean_rounds = 4;
+static int preclean_rounds;
+static gboolean preclean_round_pending;
+#if !defined(DISABLE_SGEN_MAJOR_MARKSWEEP_CONC) && !defined(HOST_WASM)
+static gboolean concurrent_los_sweep = TRUE;
+#else
+static gboolean concurrent_los_sweep = FALSE;
+#endif
+/* If set, the nursery is spread across NUMA nodes and workers are pinned to them */
+gboolean sgen_numa_enabled = FALSE;
+gboolean sgen_report_marked_objects = FALSE;
 static gboolean dynamic_nursery = FALSE;
 static size_t min_nursery_size = 0;
 static size_t max_nursery_size = 0;
@@ -291,6 +310,46 @@ static guint64 time_major_free_bigobjs = 0;
 static guint64 time_major_los_sweep = 0;
 static guint64 time_major_sweep = 0;
 static guint64 time_major_fragment_creation = 0;
+static guint64 stat_major_preclean_rounds = 0;
+
+/*
+ * Latency histograms of the phases of collection pauses, so that we can
+ * tell which phase is behind long pauses and not only how long they are
+ * in total.  Each phase of each pause is counted in one bucket.
+ */
+typedef enum {
+	PAUSE_PHASE_SUSPEND,
+	PAUSE_PHASE_PINNING,
+	PAUSE_PHASE_SCAN_REMSETS,
+	PAUSE_PHASE_DRAIN_GRAY_STACK,
+	PAUSE_PHASE_FINALIZATION,
+	PAUSE_PHASE_WEAK_LINKS,
+	PAUSE_PHASE_FRAGMENT_CREATION,
+	PAUSE_PHASE_RESTART,
+	PAUSE_PHASE_NUM
+} PausePhase;
+
+static const char *pause_phase_names [PAUSE_PHASE_NUM] = {
+	"suspend", "pinning", "scan remsets", "drain gray stack", "finalization", "weak links", "fragment creation", "restart"
+};
+
+#define PAUSE_HISTOGRAM_BUCKETS	6
+/* Upper bounds of all but the last bucket, in 100ns ticks */
+static const gint64 pause_histogram_limits [PAUSE_HISTOGRAM_BUCKETS - 1] = { 100, 1000, 10000, 50000, 200000 };
+static const char *pause_histogram_names [PAUSE_HISTOGRAM_BUCKETS] = { "<10us", "<100us", "<1ms", "<5ms", "<20ms", ">=20ms" };
+
+static guint64 pause_histograms [GENERATION_MAX][PAUSE_PHASE_NUM][PAUSE_HISTOGRAM_BUCKETS];
+
+/* LOCKING: assumes the GC lock is held */
+static void
+pause_phase_record (int generation, PausePhase phase, gint64 ticks)
+{
+	int bucket = 0;
+
+	while (bucket < PAUSE_HISTOGRAM_BUCKETS - 1 && ticks >= pause_histogram_limits [bucket])
+		++bucket;
+	++pause_histograms [generation][phase][bucket];
+}
 
 static guint64 time_max = 0;
 
@@ -340,6 +399,7 @@ sgen_nursery_canaries_enabled (void)
 typedef enum {
 	SGEN_MAJOR_DEFAULT,
 	SGEN_MAJOR_SERIAL,
+	SGEN_MAJOR_REGIONS,
 	SGEN_MAJOR_CONCURRENT,
 	SGEN_MAJOR_CONCURRENT_PARALLEL
 } SgenMajor;
@@ -426,7 +486,9 @@ static mword objects_pinned;
 static void scan_from_registered_roots (char *addr_start, char *addr_end, int root_type, ScanCopyContext ctx);
 
 static void pin_from_roots (void *start_nursery, void *end_nursery, ScanCopyContext ctx);
-static void finish_gray_stack (int generation, ScanCopyContext ctx);
+static void finish_gray_stack (int generation, ScanCopyContext ctx, SgenObjectOperations *object_ops_par);
+static gboolean null_links (int generation, ScanCopyContext ctx, SgenObjectOperations *object_ops_par, gboolean track);
+static void process_togglerefs (int generation, char *start, char *end, ScanCopyContext ctx, SgenObjectOperations *object_ops_par, gboolean clear);
 
 
 SgenMajorCollector sgen_major_collector;
@@ -964,6 +1026,16 @@ sgen_update_heap_boundaries (mword low, mword high)
 	} while (SGEN_CAS_PTR ((gpointer*)&highest_heap_address, (gpointer)high, (gpointer)old) != (gpointer)old);
 }
 
+/*
+ * Whether PTR lies between the lowest and highest address the heap was ever
+ * given.  Cheap, but other memory can be mapped in between.
+ */
+gboolean
+sgen_ptr_in_heap_boundaries (gpointer ptr)
+{
+	return (mword)ptr >= lowest_heap_address && (mword)ptr < highest_heap_address;
+}
+
 /*
  * Allocate and setup the data structures needed to be able to allocate objects
  * in the nursery. The nursery is stored in sgen_nursery_section.
@@ -1073,7 +1145,7 @@ sgen_generation_name (int generation)
 }
 
 static void
-finish_gray_stack (int generation, ScanCopyContext ctx)
+finish_gray_stack (int generation, ScanCopyContext ctx, SgenObjectOperations *object_ops_par)
 {
 	TV_DECLARE (atv);
 	TV_DECLARE (btv);
@@ -1096,8 +1168,10 @@ finish_gray_stack (int generation, ScanCopyContext ctx)
 	 *   To achieve better cache locality and cache usage, we drain the gray stack 
 	 * frequently, after each object is copied, and just finish the work here.
 	 */
+	TV_GETTIME (btv);
 	sgen_drain_gray_stack (ctx);
 	TV_GETTIME (atv);
+	pause_phase_record (generation, PAUSE_PHASE_DRAIN_GRAY_STACK, TV_ELAPSED (btv, atv));
 	SGEN_LOG (2, "%s generation done", generation_name (generation));
 
 	/*
@@ -1114,7 +1188,7 @@ finish_gray_stack (int generation, ScanCopyContext ctx)
 	 * Mark all strong toggleref objects. This must be done before we walk ephemerons or finalizers
 	 * to ensure they see the full set of live objects.
 	 */
-	sgen_client_mark_togglerefs (start_addr, end_addr, ctx);
+	process_togglerefs (generation, start_addr, end_addr, ctx, object_ops_par, FALSE);
 
 	/*
 	 * Walk the ephemeron tables marking all values with reachable keys. This must be completely done
@@ -1160,9 +1234,7 @@ finish_gray_stack (int generation, ScanCopyContext ctx)
 	We must clear weak links that don't track resurrection before processing object ready for
 	finalization so they can be cleared before that.
 	*/
-	sgen_null_link_in_range (generation, ctx, FALSE);
-	if (generation == GENERATION_OLD)
-		sgen_null_link_in_range (GENERATION_NURSERY, ctx, FALSE);
+	null_links (generation, ctx, object_ops_par, FALSE);
 
 
 	/* walk the finalization queue and move also the objects that need to be
@@ -1194,9 +1266,10 @@ finish_gray_stack (int generation, ScanCopyContext ctx)
 	 * This is semantically more inline with what users expect and it allows for
 	 * user finalizers to correctly interact with TR objects.
 	*/
-	sgen_client_clear_togglerefs (start_addr, end_addr, ctx);
+	process_togglerefs (generation, start_addr, end_addr, ctx, object_ops_par, TRUE);
 
 	TV_GETTIME (btv);
+	pause_phase_record (generation, PAUSE_PHASE_FINALIZATION, TV_ELAPSED (atv, btv));
 	SGEN_LOG (2, "Finalize queue handling scan for %s generation: %lld usecs %d ephemeron rounds", generation_name (generation), (long long)TV_ELAPSED (atv, btv), ephemeron_rounds);
 
 	/*
@@ -1208,17 +1281,14 @@ finish_gray_stack (int generation, ScanCopyContext ctx)
 	 * called.
 	 */
 	g_assert (sgen_gray_object_queue_is_empty (queue));
-	for (;;) {
-		sgen_null_link_in_range (generation, ctx, TRUE);
-		if (generation == GENERATION_OLD)
-			sgen_null_link_in_range (GENERATION_NURSERY, ctx, TRUE);
-		if (sgen_gray_object_queue_is_empty (queue))
-			break;
+	while (null_links (generation, ctx, object_ops_par, TRUE))
 		sgen_drain_gray_stack (ctx);
-	}
 
 	g_assert (sgen_gray_object_queue_is_empty (queue));
 
+	TV_GETTIME (atv);
+	pause_phase_record (generation, PAUSE_PHASE_WEAK_LINKS, TV_ELAPSED (btv, atv));
+
 	sgen_binary_protocol_finish_gray_stack_end (sgen_timestamp (), generation);
 }
 
@@ -1284,6 +1354,18 @@ init_stats (void)
 	mono_counters_register ("Major LOS sweep", MONO_COUNTER_GC | MONO_COUNTER_ULONG | MONO_COUNTER_TIME, &time_major_los_sweep);
 	mono_counters_register ("Major sweep", MONO_COUNTER_GC | MONO_COUNTER_ULONG | MONO_COUNTER_TIME, &time_major_sweep);
 	mono_counters_register ("Major fragment creation", MONO_COUNTER_GC | MONO_COUNTER_ULONG | MONO_COUNTER_TIME, &time_major_fragment_creation);
+	mono_counters_register ("Major preclean rounds", MONO_COUNTER_GC | MONO_COUNTER_ULONG, &stat_major_preclean_rounds);
+
+	for (int gen = 0; gen < GENERATION_MAX; gen++) {
+		for (int phase = 0; phase < PAUSE_PHASE_NUM; phase++) {
+			for (int bucket = 0; bucket < PAUSE_HISTOGRAM_BUCKETS; bucket++) {
+				/* The counters copy the name */
+				char *name = g_strdup_printf ("%s pause %s %s", gen == GENERATION_NURSERY ? "Minor" : "Major", pause_phase_names [phase], pause_histogram_names [bucket]);
+				mono_counters_register (name, MONO_COUNTER_GC | MONO_COUNTER_ULONG, &pause_histograms [gen][phase][bucket]);
+				g_free (name);
+			}
+		}
+	}
 
 	mono_counters_register ("Number of pinned objects", MONO_COUNTER_GC | MONO_COUNTER_ULONG, &stat_pinned_objects);
 
@@ -1359,10 +1441,17 @@ typedef struct {
 
 typedef struct {
 	ScanJob scan_job;
-	int job_index, job_split_count;
-	int data;
+	SgenCardTableScanSplit *split;
 } ParallelScanJob;
 
+/*
+ * One cursor per group of parallel card table scan jobs. Each is reset right
+ * before its jobs are enqueued, when no job of that group can be running.
+ */
+static SgenCardTableScanSplit remset_major_split, remset_los_split;
+static SgenCardTableScanSplit mod_union_major_split, mod_union_los_split;
+static SgenCardTableScanSplit preclean_major_split, preclean_los_split;
+
 static ScanCopyContext
 scan_copy_context_for_scan_job (void *worker_data_untyped, ScanJob *job)
 {
@@ -1381,6 +1470,153 @@ scan_copy_context_for_scan_job (void *worker_data_untyped, ScanJob *job)
 	return CONTEXT_FROM_OBJECT_OPERATIONS (job->ops, sgen_workers_get_job_gray_queue (worker_data, job->gc_thread_gray_queue));
 }
 
+typedef struct {
+	ScanJob scan_job;
+	int generation;
+	gboolean track;
+	guint32 begin, end;
+} NullLinksJob;
+
+/*
+ * Weak links are only split across the workers if there are enough of them
+ * to be worth waking the workers up for.
+ */
+#define NULL_LINKS_PARALLEL_MIN_SLOTS	(64 * 1024)
+
+static volatile gboolean null_links_updated;
+
+static void
+job_null_links (void *worker_data_untyped, SgenThreadPoolJob *job)
+{
+	NullLinksJob *job_data = (NullLinksJob*)job;
+	ScanCopyContext ctx = scan_copy_context_for_scan_job (worker_data_untyped, &job_data->scan_job);
+	gboolean updated;
+
+	updated = sgen_null_link_in_slot_range (job_data->generation, ctx, job_data->track, job_data->begin, job_data->end);
+	if (job_data->generation == GENERATION_OLD)
+		updated |= sgen_null_link_in_slot_range (GENERATION_NURSERY, ctx, job_data->track, job_data->begin, job_data->end);
+
+	if (updated)
+		null_links_updated = TRUE;
+}
+
+/*
+ * Clears or updates the weak links of `generation` that don't (or, if
+ * `track`, do) track resurrection.  Returns whether the links have to be
+ * processed again once the gray stack is drained: in the serial case, if
+ * marking left gray work; in the parallel case, where the workers drain
+ * their gray work themselves, if a link was updated to a copied object.
+ * An object that was only marked in place is already live on the next pass,
+ * so it doesn't need one.
+ */
+static gboolean
+null_links (int generation, ScanCopyContext ctx, SgenObjectOperations *object_ops_par, gboolean track)
+{
+	guint32 num_slots = sgen_gchandle_get_num_slots (track ? HANDLE_WEAK_TRACK : HANDLE_WEAK);
+	guint32 slots_per_job;
+	int i, split_count;
+
+	if (!object_ops_par || num_slots < NULL_LINKS_PARALLEL_MIN_SLOTS) {
+		sgen_null_link_in_range (generation, ctx, track);
+		if (generation == GENERATION_OLD)
+			sgen_null_link_in_range (GENERATION_NURSERY, ctx, track);
+		return !sgen_gray_object_queue_is_empty (ctx.queue);
+	}
+
+	SGEN_ASSERT (0, sgen_gray_object_queue_is_empty (ctx.queue), "Why do we have gray work before processing weak links?");
+
+	split_count = sgen_workers_get_job_split_count (generation);
+	slots_per_job = (num_slots + split_count - 1) / split_count;
+	null_links_updated = FALSE;
+
+	for (i = 0; i < split_count; i++) {
+		NullLinksJob *nlj = (NullLinksJob*)sgen_thread_pool_job_alloc ("null links", job_null_links, sizeof (NullLinksJob));
+		nlj->scan_job.ops = NULL;
+		nlj->scan_job.gc_thread_gray_queue = ctx.queue;
+		nlj->generation = generation;
+		nlj->track = track;
+		nlj->begin = i * slots_per_job;
+		nlj->end = MIN (num_slots, (i + 1) * slots_per_job);
+		sgen_workers_enqueue_job (generation, &nlj->scan_job.job, TRUE);
+	}
+
+	sgen_workers_start_all_workers (generation, ctx.ops, object_ops_par, NULL);
+	sgen_workers_join (generation);
+
+	if (!track)
+		sgen_null_weak_fields (ctx);
+
+	return null_links_updated || !sgen_gray_object_queue_is_empty (ctx.queue);
+}
+
+typedef struct {
+	ScanJob scan_job;
+	char *heap_start;
+	char *heap_end;
+	gboolean clear;
+	int begin, end;
+} TogglerefsJob;
+
+/* Same as for weak links, only worth it for a large number of togglerefs */
+#define TOGGLEREFS_PARALLEL_MIN_SLOTS	(16 * 1024)
+
+static void
+job_process_togglerefs (void *worker_data_untyped, SgenThreadPoolJob *job)
+{
+	TogglerefsJob *job_data = (TogglerefsJob*)job;
+	ScanCopyContext ctx = scan_copy_context_for_scan_job (worker_data_untyped, &job_data->scan_job);
+
+	if (job_data->clear)
+		sgen_client_clear_togglerefs_in_range (job_data->heap_start, job_data->heap_end, ctx, job_data->begin, job_data->end);
+	else
+		sgen_client_mark_togglerefs_in_range (job_data->heap_start, job_data->heap_end, ctx, job_data->begin, job_data->end);
+}
+
+/*
+ * Marks the strong togglerefs or, if `clear`, clears the dead weak ones,
+ * splitting the toggleref slots across the workers when there are many.
+ * The gray stack is drained on return.
+ */
+static void
+process_togglerefs (int generation, char *start, char *end, ScanCopyContext ctx, SgenObjectOperations *object_ops_par, gboolean clear)
+{
+	int num_slots = sgen_client_get_num_togglerefs ();
+	int i, split_count, slots_per_job;
+
+	if (!object_ops_par || num_slots < TOGGLEREFS_PARALLEL_MIN_SLOTS) {
+		if (clear)
+			sgen_client_clear_togglerefs (start, end, ctx);
+		else
+			sgen_client_mark_togglerefs (start, end, ctx);
+		return;
+	}
+
+	SGEN_LOG (4, "%s ToggleRefs %d on the workers", clear ? "Clearing" : "Marking", num_slots);
+
+	/* The workers drain their own queues, ours has to be empty when they finish */
+	sgen_drain_gray_stack (ctx);
+
+	split_count = sgen_workers_get_job_split_count (generation);
+	slots_per_job = (num_slots + split_count - 1) / split_count;
+
+	for (i = 0; i < split_count; i++) {
+		TogglerefsJob *tj = (TogglerefsJob*)sgen_thread_pool_job_alloc (clear ? "clear togglerefs" : "mark togglerefs", job_process_togglerefs, sizeof (TogglerefsJob));
+		tj->scan_job.ops = NULL;
+		tj->scan_job.gc_thread_gray_queue = ctx.queue;
+		tj->heap_start = start;
+		tj->heap_end = end;
+		tj->clear = clear;
+		tj->begin = i * slots_per_job;
+		tj->end = MIN (num_slots, (i + 1) * slots_per_job);
+		sgen_workers_enqueue_job (generation, &tj->scan_job.job, TRUE);
+	}
+
+	sgen_workers_start_all_workers (generation, ctx.ops, object_ops_par, NULL);
+	sgen_workers_join (generation);
+
+	sgen_drain_gray_stack (ctx);
+}
+
 typedef struct {
 	ScanJob scan_job;
 	char *heap_start;
@@ -1435,6 +1671,15 @@ job_scan_wbroots (void *worker_data_untyped, SgenThreadPoolJob *job)
 	sgen_wbroots_scan_card_table (ctx);
 }
 
+static void
+job_scan_store_remsets (void *worker_data_untyped, SgenThreadPoolJob *job)
+{
+	ScanJob *job_data = (ScanJob*)job;
+	ScanCopyContext ctx = scan_copy_context_for_scan_job (worker_data_untyped, job_data);
+
+	remset.scan_remsets (ctx);
+}
+
 static void
 job_scan_major_card_table (void *worker_data_untyped, SgenThreadPoolJob *job)
 {
@@ -1444,7 +1689,7 @@ job_scan_major_card_table (void *worker_data_untyped, SgenThreadPoolJob *job)
 	ScanCopyContext ctx = scan_copy_context_for_scan_job (worker_data_untyped, (ScanJob*)job_data);
 
 	SGEN_TV_GETTIME (atv);
-	sgen_major_collector.scan_card_table (CARDTABLE_SCAN_GLOBAL, ctx, job_data->job_index, job_data->job_split_count, job_data->data);
+	sgen_major_collector.scan_card_table (CARDTABLE_SCAN_GLOBAL, ctx, job_data->split);
 	SGEN_TV_GETTIME (btv);
 	time_minor_scan_major_blocks += SGEN_TV_ELAPSED (atv, btv);
 
@@ -1461,7 +1706,7 @@ job_scan_los_card_table (void *worker_data_untyped, SgenThreadPoolJob *job)
 	ScanCopyContext ctx = scan_copy_context_for_scan_job (worker_data_untyped, (ScanJob*)job_data);
 
 	SGEN_TV_GETTIME (atv);
-	sgen_los_scan_card_table (CARDTABLE_SCAN_GLOBAL, ctx, job_data->job_index, job_data->job_split_count);
+	sgen_los_scan_card_table (CARDTABLE_SCAN_GLOBAL, ctx, job_data->split);
 	SGEN_TV_GETTIME (btv);
 	time_minor_scan_los += SGEN_TV_ELAPSED (atv, btv);
 
@@ -1479,7 +1724,7 @@ job_scan_major_mod_union_card_table (void *worker_data_untyped, SgenThreadPoolJo
 
 	g_assert (sgen_concurrent_collection_in_progress);
 	SGEN_TV_GETTIME (atv);
-	sgen_major_collector.scan_card_table (CARDTABLE_SCAN_MOD_UNION, ctx, job_data->job_index, job_data->job_split_count, job_data->data);
+	sgen_major_collector.scan_card_table (CARDTABLE_SCAN_MOD_UNION, ctx, job_data->split);
 	SGEN_TV_GETTIME (btv);
 	time_major_scan_mod_union_blocks += SGEN_TV_ELAPSED (atv, btv);
 
@@ -1497,7 +1742,7 @@ job_scan_los_mod_union_card_table (void *worker_data_untyped, SgenThreadPoolJob
 
 	g_assert (sgen_concurrent_collection_in_progress);
 	SGEN_TV_GETTIME (atv);
-	sgen_los_scan_card_table (CARDTABLE_SCAN_MOD_UNION, ctx, job_data->job_index, job_data->job_split_count);
+	sgen_los_scan_card_table (CARDTABLE_SCAN_MOD_UNION, ctx, job_data->split);
 	SGEN_TV_GETTIME (btv);
 	time_major_scan_mod_union_los += SGEN_TV_ELAPSED (atv, btv);
 
@@ -1515,7 +1760,7 @@ job_major_mod_union_preclean (void *worker_data_untyped, SgenThreadPoolJob *job)
 
 	g_assert (sgen_concurrent_collection_in_progress);
 	SGEN_TV_GETTIME (atv);
-	sgen_major_collector.scan_card_table (CARDTABLE_SCAN_MOD_UNION_PRECLEAN, ctx, job_data->job_index, job_data->job_split_count, job_data->data);
+	sgen_major_collector.scan_card_table (CARDTABLE_SCAN_MOD_UNION_PRECLEAN, ctx, job_data->split);
 	SGEN_TV_GETTIME (btv);
 
 	g_assert (worker_data_untyped);
@@ -1532,7 +1777,7 @@ job_los_mod_union_preclean (void *worker_data_untyped, SgenThreadPoolJob *job)
 
 	g_assert (sgen_concurrent_collection_in_progress);
 	SGEN_TV_GETTIME (atv);
-	sgen_los_scan_card_table (CARDTABLE_SCAN_MOD_UNION_PRECLEAN, ctx, job_data->job_index, job_data->job_split_count);
+	sgen_los_scan_card_table (CARDTABLE_SCAN_MOD_UNION_PRECLEAN, ctx, job_data->split);
 	SGEN_TV_GETTIME (btv);
 
 	g_assert (worker_data_untyped);
@@ -1555,24 +1800,24 @@ workers_finish_callback (void)
 {
 	ParallelScanJob *psj;
 	ScanJob *sj;
-	size_t num_major_sections = sgen_major_collector.get_num_major_sections ();
 	int split_count = sgen_workers_get_job_split_count (GENERATION_OLD);
 	int i;
+
+	sgen_card_table_scan_split_reset (&preclean_major_split);
+	sgen_card_table_scan_split_reset (&preclean_los_split);
+
 	/* Mod union preclean jobs */
 	for (i = 0; i < split_count; i++) {
 		psj = (ParallelScanJob*)sgen_thread_pool_job_alloc ("preclean major mod union cardtable", job_major_mod_union_preclean, sizeof (ParallelScanJob));
 		psj->scan_job.gc_thread_gray_queue = NULL;
-		psj->job_index = i;
-		psj->job_split_count = split_count;
-		psj->data = num_major_sections / split_count;
+		psj->split = &preclean_major_split;
 		sgen_workers_enqueue_job (GENERATION_OLD, &psj->scan_job.job, TRUE);
 	}
 
 	for (i = 0; i < split_count; i++) {
 		psj = (ParallelScanJob*)sgen_thread_pool_job_alloc ("preclean los mod union cardtable", job_los_mod_union_preclean, sizeof (ParallelScanJob));
 		psj->scan_job.gc_thread_gray_queue = NULL;
-		psj->job_index = i;
-		psj->job_split_count = split_count;
+		psj->split = &preclean_los_split;
 		sgen_workers_enqueue_job (GENERATION_OLD, &psj->scan_job.job, TRUE);
 	}
 
@@ -1591,30 +1836,36 @@ static void
 enqueue_scan_remembered_set_jobs (SgenGrayQueue *gc_thread_gray_queue, SgenObjectOperations *ops, gboolean enqueue)
 {
 	int i, split_count = sgen_workers_get_job_split_count (GENERATION_NURSERY);
-	size_t num_major_sections = sgen_major_collector.get_num_major_sections ();
 	ScanJob *sj;
 
+	sgen_card_table_scan_split_reset (&remset_major_split);
+	sgen_card_table_scan_split_reset (&remset_los_split);
+
 	sj = (ScanJob*)sgen_thread_pool_job_alloc ("scan wbroots", job_scan_wbroots, sizeof (ScanJob));
 	sj->ops = ops;
 	sj->gc_thread_gray_queue = gc_thread_gray_queue;
 	sgen_workers_enqueue_job (GENERATION_NURSERY, &sj->job, enqueue);
 
+	if (remset.scan_remsets) {
+		sj = (ScanJob*)sgen_thread_pool_job_alloc ("scan store remsets", job_scan_store_remsets, sizeof (ScanJob));
+		sj->ops = ops;
+		sj->gc_thread_gray_queue = gc_thread_gray_queue;
+		sgen_workers_enqueue_job (GENERATION_NURSERY, &sj->job, enqueue);
+	}
+
 	for (i = 0; i < split_count; i++) {
 		ParallelScanJob *psj;
 
 		psj = (ParallelScanJob*)sgen_thread_pool_job_alloc ("scan major remsets", job_scan_major_card_table, sizeof (ParallelScanJob));
 		psj->scan_job.ops = ops;
 		psj->scan_job.gc_thread_gray_queue = gc_thread_gray_queue;
-		psj->job_index = i;
-		psj->job_split_count = split_count;
-		psj->data = num_major_sections / split_count;
+		psj->split = &remset_major_split;
 		sgen_workers_enqueue_job (GENERATION_NURSERY, &psj->scan_job.job, enqueue);
 
 		psj = (ParallelScanJob*)sgen_thread_pool_job_alloc ("scan LOS remsets", job_scan_los_card_table, sizeof (ParallelScanJob));
 		psj->scan_job.ops = ops;
 		psj->scan_job.gc_thread_gray_queue = gc_thread_gray_queue;
-		psj->job_index = i;
-		psj->job_split_count = split_count;
+		psj->split = &remset_los_split;
 		sgen_workers_enqueue_job (GENERATION_NURSERY, &psj->scan_job.job, enqueue);
 	}
 }
@@ -1690,7 +1941,9 @@ collect_nursery (const char *reason, gboolean is_overflow, SgenGrayQueue *unpin_
 	SGEN_TV_DECLARE (last_minor_collection_end_tv);
 	guint64 major_scan_start = time_minor_scan_major_blocks;
 	guint64 los_scan_start = time_minor_scan_los;
+	guint64 remset_scan_start = time_minor_scan_remsets;
 	guint64 finish_gray_start = time_minor_finish_gray_stack;
+	mword promoted_start = sgen_total_promoted_size;
 
 	if (disable_minor_collections)
 		return TRUE;
@@ -1772,6 +2025,9 @@ collect_nursery (const char *reason, gboolean is_overflow, SgenGrayQueue *unpin_
 
 	TV_GETTIME (atv);
 	time_minor_pinning += TV_ELAPSED (btv, atv);
+	sgen_recent_event (SGEN_RECENT_PHASE_PINNING, GENERATION_NURSERY, TV_ELAPSED (btv, atv));
+	pause_phase_record (GENERATION_NURSERY, PAUSE_PHASE_PINNING, TV_ELAPSED (btv, atv));
+	sgen_recent_event (SGEN_RECENT_OBJECTS_PINNED, GENERATION_NURSERY, sgen_get_pinned_count ());
 	SGEN_LOG (2, "Finding pinned pointers: %zd in %lld usecs", sgen_get_pinned_count (), (long long)TV_ELAPSED (btv, atv));
 	SGEN_LOG (4, "Start scan with %zd pinned objects", sgen_get_pinned_count ());
 	sgen_client_pinning_end ();
@@ -1800,11 +2056,13 @@ collect_nursery (const char *reason, gboolean is_overflow, SgenGrayQueue *unpin_
 
 	TV_GETTIME (btv);
 	time_minor_scan_roots += TV_ELAPSED (atv, btv);
+	sgen_recent_event (SGEN_RECENT_PHASE_SCAN_ROOTS, GENERATION_NURSERY, TV_ELAPSED (atv, btv));
 
-	finish_gray_stack (GENERATION_NURSERY, ctx);
+	finish_gray_stack (GENERATION_NURSERY, ctx, object_ops_par);
 
 	TV_GETTIME (atv);
 	time_minor_finish_gray_stack += TV_ELAPSED (btv, atv);
+	sgen_recent_event (SGEN_RECENT_PHASE_FINISH_GRAY_STACK, GENERATION_NURSERY, TV_ELAPSED (btv, atv));
 	sgen_client_binary_protocol_mark_end (GENERATION_NURSERY);
 
 	if (objects_pinned) {
@@ -1820,7 +2078,10 @@ collect_nursery (const char *reason, gboolean is_overflow, SgenGrayQueue *unpin_
 		sgen_check_remset_consistency ();
 
 
-	if (sgen_max_pause_time) {
+	if (sgen_memgov_has_pause_target ()) {
+		TV_GETTIME (btv);
+		sgen_memgov_resize_nursery_for_pause_target (TV_ELAPSED (last_minor_collection_start_tv, btv));
+	} else if (sgen_max_pause_time) {
 		int duration;
 
 		TV_GETTIME (btv);
@@ -1854,6 +2115,7 @@ collect_nursery (const char *reason, gboolean is_overflow, SgenGrayQueue *unpin_
 	sgen_client_binary_protocol_reclaim_end (GENERATION_NURSERY);
 	TV_GETTIME (btv);
 	time_minor_fragment_creation += TV_ELAPSED (atv, btv);
+	pause_phase_record (GENERATION_NURSERY, PAUSE_PHASE_FRAGMENT_CREATION, TV_ELAPSED (atv, btv));
 	SGEN_LOG (2, "Fragment creation: %lld usecs, %lu bytes available", (long long)TV_ELAPSED (atv, btv), (unsigned long)fragment_total);
 
 	if (remset_consistency_checks)
@@ -1898,6 +2160,10 @@ collect_nursery (const char *reason, gboolean is_overflow, SgenGrayQueue *unpin_
 			time_minor_finish_gray_stack - finish_gray_start);
 
 	sgen_binary_protocol_collection_end (mono_atomic_load_i32 (&mono_gc_stats.minor_gc_count) - 1, GENERATION_NURSERY, 0, 0);
+	sgen_recent_event (SGEN_RECENT_BYTES_PROMOTED, GENERATION_NURSERY, sgen_total_promoted_size - promoted_start);
+	/* With the parallel minor this is the time summed over all the workers */
+	pause_phase_record (GENERATION_NURSERY, PAUSE_PHASE_SCAN_REMSETS,
+			time_minor_scan_remsets - remset_scan_start + time_minor_scan_major_blocks - major_scan_start + time_minor_scan_los - los_scan_start);
 
 	if (check_nursery_objects_pinned && !sgen_minor_collector.is_split)
 		sgen_check_nursery_objects_pinned (unpin_queue != NULL);
@@ -2029,6 +2295,9 @@ major_copy_or_mark_from_roots (SgenGrayQueue *gc_thread_gray_queue, size_t *old_
 
 	TV_GETTIME (btv);
 	time_major_pinning += TV_ELAPSED (atv, btv);
+	sgen_recent_event (SGEN_RECENT_PHASE_PINNING, GENERATION_OLD, TV_ELAPSED (atv, btv));
+	pause_phase_record (GENERATION_OLD, PAUSE_PHASE_PINNING, TV_ELAPSED (atv, btv));
+	sgen_recent_event (SGEN_RECENT_OBJECTS_PINNED, GENERATION_OLD, sgen_get_pinned_count ());
 	SGEN_LOG (2, "Finding pinned pointers: %zd in %lld usecs", sgen_get_pinned_count (), (long long)TV_ELAPSED (atv, btv));
 	SGEN_LOG (4, "Start scan with %zd pinned objects", sgen_get_pinned_count ());
 	sgen_client_pinning_end ();
@@ -2067,6 +2336,7 @@ major_copy_or_mark_from_roots (SgenGrayQueue *gc_thread_gray_queue, size_t *old_
 
 	TV_GETTIME (btv);
 	time_major_scan_roots += TV_ELAPSED (atv, btv);
+	sgen_recent_event (SGEN_RECENT_PHASE_SCAN_ROOTS, GENERATION_OLD, TV_ELAPSED (atv, btv));
 
 	/*
 	 * We start the concurrent worker after pinning and after we scanned the roots
@@ -2074,7 +2344,8 @@ major_copy_or_mark_from_roots (SgenGrayQueue *gc_thread_gray_queue, size_t *old_
 	 * the roots.
 	 */
 	if (mode == COPY_OR_MARK_FROM_ROOTS_START_CONCURRENT) {
-		sgen_workers_set_num_active_workers (GENERATION_OLD, 1);
+		/* Only the parallel collector can mark with more than one worker */
+		sgen_workers_set_num_active_workers (GENERATION_OLD, object_ops_par ? sgen_memgov_get_concurrent_mark_workers () : 1);
 		gray_queue_redirect (gc_thread_gray_queue);
 		if (precleaning_enabled) {
 			sgen_workers_start_all_workers (GENERATION_OLD, object_ops_nopar, object_ops_par, workers_finish_callback);
@@ -2085,30 +2356,30 @@ major_copy_or_mark_from_roots (SgenGrayQueue *gc_thread_gray_queue, size_t *old_
 
 	if (mode == COPY_OR_MARK_FROM_ROOTS_FINISH_CONCURRENT) {
 		int i, split_count = sgen_workers_get_job_split_count (GENERATION_OLD);
-		size_t num_major_sections = sgen_major_collector.get_num_major_sections ();
 		gboolean parallel = object_ops_par != NULL;
 
+		TV_GETTIME (atv);
+
 		/* If we're not parallel we finish the collection on the gc thread */
 		if (parallel)
 			gray_queue_redirect (gc_thread_gray_queue);
 
 		/* Mod union card table */
+		sgen_card_table_scan_split_reset (&mod_union_major_split);
+		sgen_card_table_scan_split_reset (&mod_union_los_split);
 		for (i = 0; i < split_count; i++) {
 			ParallelScanJob *psj;
 
 			psj = (ParallelScanJob*)sgen_thread_pool_job_alloc ("scan mod union cardtable", job_scan_major_mod_union_card_table, sizeof (ParallelScanJob));
 			psj->scan_job.ops = parallel ? NULL : object_ops_nopar;
 			psj->scan_job.gc_thread_gray_queue = gc_thread_gray_queue;
-			psj->job_index = i;
-			psj->job_split_count = split_count;
-			psj->data = num_major_sections / split_count;
+			psj->split = &mod_union_major_split;
 			sgen_workers_enqueue_job (GENERATION_OLD, &psj->scan_job.job, parallel);
 
 			psj = (ParallelScanJob*)sgen_thread_pool_job_alloc ("scan LOS mod union cardtable", job_scan_los_mod_union_card_table, sizeof (ParallelScanJob));
 			psj->scan_job.ops = parallel ? NULL : object_ops_nopar;
 			psj->scan_job.gc_thread_gray_queue = gc_thread_gray_queue;
-			psj->job_index = i;
-			psj->job_split_count = split_count;
+			psj->split = &mod_union_los_split;
 			sgen_workers_enqueue_job (GENERATION_OLD, &psj->scan_job.job, parallel);
 		}
 
@@ -2124,6 +2395,9 @@ major_copy_or_mark_from_roots (SgenGrayQueue *gc_thread_gray_queue, size_t *old_
 			sgen_workers_start_all_workers (GENERATION_OLD, object_ops_nopar, object_ops_par, NULL);
 			sgen_workers_join (GENERATION_OLD);
 		}
+
+		TV_GETTIME (btv);
+		pause_phase_record (GENERATION_OLD, PAUSE_PHASE_SCAN_REMSETS, TV_ELAPSED (atv, btv));
 	}
 
 	sgen_pin_stats_report ();
@@ -2189,7 +2463,7 @@ static void
 major_finish_collection (SgenGrayQueue *gc_thread_gray_queue, const char *reason, gboolean is_overflow, size_t old_next_pin_slot, gboolean forced)
 {
 	ScannedObjectCounts counts;
-	SgenObjectOperations *object_ops_nopar;
+	SgenObjectOperations *object_ops_nopar, *object_ops_par = NULL;
 	mword fragment_total;
 	TV_DECLARE (atv);
 	TV_DECLARE (btv);
@@ -2198,8 +2472,6 @@ major_finish_collection (SgenGrayQueue *gc_thread_gray_queue, const char *reason
 	guint64 finish_gray_start = time_major_finish_gray_stack;
 
 	if (sgen_concurrent_collection_in_progress) {
-		SgenObjectOperations *object_ops_par = NULL;
-
 		object_ops_nopar = &sgen_major_collector.major_ops_concurrent_finish;
 		if (sgen_major_collector.is_parallel)
 			object_ops_par = &sgen_major_collector.major_ops_conc_par_finish;
@@ -2216,9 +2488,10 @@ major_finish_collection (SgenGrayQueue *gc_thread_gray_queue, const char *reason
 	sgen_workers_assert_gray_queue_is_empty (GENERATION_OLD);
 
 	TV_GETTIME (btv);
-	finish_gray_stack (GENERATION_OLD, CONTEXT_FROM_OBJECT_OPERATIONS (object_ops_nopar, gc_thread_gray_queue));
+	finish_gray_stack (GENERATION_OLD, CONTEXT_FROM_OBJECT_OPERATIONS (object_ops_nopar, gc_thread_gray_queue), object_ops_par);
 	TV_GETTIME (atv);
 	time_major_finish_gray_stack += TV_ELAPSED (btv, atv);
+	sgen_recent_event (SGEN_RECENT_PHASE_FINISH_GRAY_STACK, GENERATION_OLD, TV_ELAPSED (btv, atv));
 
 	SGEN_ASSERT (0, sgen_workers_all_done (), "Can't have workers working after joining");
 
@@ -2280,6 +2553,7 @@ major_finish_collection (SgenGrayQueue *gc_thread_gray_queue, const char *reason
 
 	TV_GETTIME (btv);
 	time_major_fragment_creation += TV_ELAPSED (atv, btv);
+	pause_phase_record (GENERATION_OLD, PAUSE_PHASE_FRAGMENT_CREATION, TV_ELAPSED (atv, btv));
 
 	sgen_binary_protocol_sweep_begin (GENERATION_OLD, !sgen_major_collector.sweeps_lazily);
 	sgen_memgov_major_pre_sweep ();
@@ -2298,6 +2572,7 @@ major_finish_collection (SgenGrayQueue *gc_thread_gray_queue, const char *reason
 
 	TV_GETTIME (atv);
 	time_major_sweep += TV_ELAPSED (btv, atv);
+	sgen_recent_event (SGEN_RECENT_PHASE_SWEEP, GENERATION_OLD, TV_ELAPSED (btv, atv));
 
 	sgen_debug_dump_heap ("major", mono_atomic_load_i32 (&mono_gc_stats.major_gc_count) - 1, reason);
 
@@ -2386,6 +2661,10 @@ major_start_concurrent_collection (const char *reason)
 	num_objects_marked = sgen_major_collector.get_and_reset_num_major_objects_marked ();
 	g_assert (num_objects_marked == 0);
 
+	sgen_card_table_get_and_reset_precleaned_cards ();
+	preclean_rounds = 0;
+	preclean_round_pending = FALSE;
+
 	sgen_binary_protocol_concurrent_start ();
 
 	init_gray_queue (&gc_thread_gray_queue);
@@ -2407,7 +2686,36 @@ major_start_concurrent_collection (const char *reason)
 static gboolean
 major_should_finish_concurrent_collection (void)
 {
-	return sgen_workers_all_done ();
+	if (!sgen_workers_all_done ())
+		return FALSE;
+
+	/*
+	 * Marking and the last preclean round are done.  If that round still had
+	 * a lot of cards to clean, the mutator is dirtying them faster than the
+	 * finishing pause would like, so do another round concurrently.
+	 */
+	if (precleaning_enabled && !preclean_round_pending && preclean_rounds + 1 < max_preclean_rounds) {
+		if (sgen_card_table_get_and_reset_precleaned_cards () >= PRECLEAN_CONVERGED_CARDS) {
+			preclean_round_pending = TRUE;
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+/*
+ * Restarts the workers, which are idle, on another round of precleaning.  The
+ * world must be stopped and the mod union updated from the card table.
+ */
+static void
+major_restart_precleaning (void)
+{
+	preclean_round_pending = FALSE;
+	++preclean_rounds;
+	++stat_major_preclean_rounds;
+
+	sgen_workers_restart_finished_workers (GENERATION_OLD, workers_finish_callback);
 }
 
 static void
@@ -2438,6 +2746,8 @@ major_finish_concurrent_collection (gboolean forced)
 
 	sgen_binary_protocol_concurrent_finish ();
 
+	preclean_round_pending = FALSE;
+
 	/*
 	 * We need to stop all workers since we're updating the cardtable below.
 	 * The workers will be resumed with a finishing pause context to avoid
@@ -2545,6 +2855,9 @@ sgen_perform_collection_inner (size_t requested_size, int generation_to_collect,
 			overflow_generation_to_collect = GENERATION_OLD;
 			overflow_reason = "Minor overflow";
 		}
+
+		if (preclean_round_pending)
+			major_restart_precleaning ();
 	} else if (finish_concurrent) {
 		major_finish_concurrent_collection (forced_serial);
 		oldest_generation_collected = GENERATION_OLD;
@@ -2723,6 +3036,9 @@ sgen_set_suspend_finalizers (void)
 	sgen_suspend_finalizers = TRUE;
 }
 
+/* Number of finalizable objects dequeued with one acquisition of the GC lock */
+#define FINALIZER_BATCH_SIZE	16
+
 int
 sgen_gc_invoke_finalizers (void)
 {
@@ -2730,40 +3046,43 @@ sgen_gc_invoke_finalizers (void)
 
 	g_assert (!pending_unqueued_finalizer);
 
-	/* FIXME: batch to reduce lock contention */
 	while (sgen_have_pending_finalizers ()) {
-		GCObject *obj;
+		/* The objects are on the stack so they are pinned */
+		GCObject *objs [FINALIZER_BATCH_SIZE];
+		int i, num = 0;
 
 		LOCK_GC;
 
 		/*
 		 * We need to set `pending_unqueued_finalizer` before dequeing the
-		 * finalizable object.
+		 * finalizable objects.
 		 */
-		if (!sgen_pointer_queue_is_empty (&fin_ready_queue)) {
+		if (!sgen_pointer_queue_is_empty (&fin_ready_queue) || !sgen_pointer_queue_is_empty (&critical_fin_queue)) {
 			pending_unqueued_finalizer = TRUE;
 			mono_memory_write_barrier ();
-			obj = (GCObject *)sgen_pointer_queue_pop (&fin_ready_queue);
-		} else if (!sgen_pointer_queue_is_empty (&critical_fin_queue)) {
-			pending_unqueued_finalizer = TRUE;
-			mono_memory_write_barrier ();
-			obj = (GCObject *)sgen_pointer_queue_pop (&critical_fin_queue);
-		} else {
-			obj = NULL;
+		}
+		while (num < FINALIZER_BATCH_SIZE && !sgen_pointer_queue_is_empty (&fin_ready_queue))
+			objs [num++] = (GCObject *)sgen_pointer_queue_pop (&fin_ready_queue);
+		/* Critical finalizers run after the normal ones */
+		if (!num) {
+			while (num < FINALIZER_BATCH_SIZE && !sgen_pointer_queue_is_empty (&critical_fin_queue))
+				objs [num++] = (GCObject *)sgen_pointer_queue_pop (&critical_fin_queue);
 		}
 
-		if (obj)
-			SGEN_LOG (7, "Finalizing object %p (%s)", obj, sgen_client_vtable_get_name (SGEN_LOAD_VTABLE (obj)));
+		for (i = 0; i < num; ++i)
+			SGEN_LOG (7, "Finalizing object %p (%s)", objs [i], sgen_client_vtable_get_name (SGEN_LOAD_VTABLE (objs [i])));
 
 		UNLOCK_GC;
 
-		if (!obj)
+		if (!num)
 			break;
 
-		count++;
-		/* the object is on the stack so it is pinned */
-		/*g_print ("Calling finalizer for object: %p (%s)\n", obj, sgen_client_object_safe_name (obj));*/
-		sgen_client_run_finalize (obj);
+		count += num;
+		for (i = 0; i < num; ++i) {
+			/*g_print ("Calling finalizer for object: %p (%s)\n", objs [i], sgen_client_object_safe_name (objs [i]));*/
+			sgen_client_run_finalize (objs [i]);
+			objs [i] = NULL;
+		}
 	}
 
 	if (pending_unqueued_finalizer) {
@@ -2960,6 +3279,8 @@ sgen_thread_attach (SgenThreadInfo* info)
 void
 sgen_thread_detach_with_lock (SgenThreadInfo *p)
 {
+	sgen_ssb_thread_detach (p);
+	sgen_gchandle_thread_detach (p);
 	sgen_client_thread_detach_with_lock (p);
 }
 
@@ -3172,6 +3493,8 @@ parse_sgen_major (const char *opt)
 
 	if (!strcmp (opt, "marksweep")) {
 		return SGEN_MAJOR_SERIAL;
+	} else if (!strcmp (opt, "regions")) {
+		return SGEN_MAJOR_REGIONS;
 	} else if (!strcmp (opt, "marksweep-conc")) {
 		return SGEN_MAJOR_CONCURRENT;
 	} else if (!strcmp (opt, "marksweep-conc-par")) {
@@ -3204,8 +3527,10 @@ parse_sgen_mode (const char *opt)
 static void
 init_sgen_minor (SgenMinor minor)
 {
+	if (minor == SGEN_MINOR_DEFAULT)
+		minor = DEFAULT_MINOR;
+
 	switch (minor) {
-	case SGEN_MINOR_DEFAULT:
 	case SGEN_MINOR_SIMPLE:
 		sgen_simple_nursery_init (&sgen_minor_collector, FALSE);
 		break;
@@ -3238,6 +3563,9 @@ init_sgen_major (SgenMajor major)
 	case SGEN_MAJOR_SERIAL:
 		sgen_marksweep_init (&sgen_major_collector);
 		break;
+	case SGEN_MAJOR_REGIONS:
+		sgen_marksweep_regions_init (&sgen_major_collector);
+		break;
 #ifdef DISABLE_SGEN_MAJOR_MARKSWEEP_CONC
 	case SGEN_MAJOR_CONCURRENT:
 	case SGEN_MAJOR_CONCURRENT_PARALLEL:
@@ -3323,6 +3651,7 @@ sgen_gc_init (void)
 	gboolean debug_print_allowance = FALSE;
 	double allowance_ratio = 0, save_target = 0;
 	gboolean cement_enabled = TRUE;
+	gboolean store_remset = FALSE;
 
 	do {
 		result = mono_atomic_cas_i32 (&gc_initialized, -1, 0);
@@ -3424,6 +3753,20 @@ sgen_gc_init (void)
 				}
 				continue;
 			}
+			if (g_str_has_prefix (opt, "pause-target=")) {
+				char *end;
+				long target;
+				opt = strchr (opt, '=') + 1;
+				target = strtol (opt, &end, 10);
+				if (target > 0 && (!*end || !strcmp (end, "ms"))) {
+					sgen_memgov_set_pause_target ((int)target);
+					if (!sgen_minor_collector.is_split)
+						dynamic_nursery = TRUE;
+				} else {
+					sgen_env_var_error (MONO_GC_PARAMS_NAME, "Ignoring.", "`pause-target` must be a positive number of milliseconds.");
+				}
+				continue;
+			}
 			if (g_str_has_prefix (opt, "max-heap-size=")) {
 				size_t page_size = mono_pagesize ();
 				size_t max_heap_candidate = 0;
@@ -3497,6 +3840,21 @@ sgen_gc_init (void)
 				continue;
 			}
 
+			if (g_str_has_prefix (opt, "wbarrier=")) {
+				opt = strchr (opt, '=') + 1;
+				if (!strcmp (opt, "cardtable")) {
+					store_remset = FALSE;
+				} else if (!strcmp (opt, "remset")) {
+					if (sgen_major_collector.is_concurrent)
+						sgen_env_var_error (MONO_GC_PARAMS_NAME, "Using `cardtable`.", "`remset` write barrier requires a non-concurrent major collector.");
+					else
+						store_remset = TRUE;
+				} else {
+					sgen_env_var_error (MONO_GC_PARAMS_NAME, "Using `cardtable`.", "Unknown write barrier `%s`.", opt);
+				}
+				continue;
+			}
+
 			if (!strcmp (opt, "cementing")) {
 				cement_enabled = TRUE;
 				continue;
@@ -3514,6 +3872,42 @@ sgen_gc_init (void)
 				precleaning_enabled = FALSE;
 				continue;
 			}
+			if (g_str_has_prefix (opt, "preclean-rounds=")) {
+				char *end;
+				long rounds;
+				opt = strchr (opt, '=') + 1;
+				rounds = strtol (opt, &end, 10);
+				if (rounds > 0 && !*end)
+					max_preclean_rounds = (int)rounds;
+				else
+					sgen_env_var_error (MONO_GC_PARAMS_NAME, "Ignoring.", "`preclean-rounds` must be a positive integer.");
+				continue;
+			}
+
+			if (!strcmp (opt, "concurrent-los-sweep")) {
+#if !defined(DISABLE_SGEN_MAJOR_MARKSWEEP_CONC) && !defined(HOST_WASM)
+				concurrent_los_sweep = TRUE;
+#else
+				sgen_env_var_error (MONO_GC_PARAMS_NAME, "Ignoring.", "concurrent-los-sweep requires concurrent sweep support.");
+#endif
+				continue;
+			}
+			if (!strcmp (opt, "no-concurrent-los-sweep")) {
+				concurrent_los_sweep = FALSE;
+				continue;
+			}
+
+			if (!strcmp (opt, "numa")) {
+				if (mono_numa_get_node_count () > 1)
+					sgen_numa_enabled = TRUE;
+				else
+					sgen_env_var_error (MONO_GC_PARAMS_NAME, "Ignoring.", "numa requires more than one NUMA node.");
+				continue;
+			}
+			if (!strcmp (opt, "no-numa")) {
+				sgen_numa_enabled = FALSE;
+				continue;
+			}
 
 			if (!strcmp (opt, "dynamic-nursery")) {
 				if (sgen_minor_collector.is_split)
@@ -3547,11 +3941,15 @@ sgen_gc_init (void)
 			fprintf (stderr, "  soft-heap-limit=n (where N is an integer, possibly with a k, m or a g suffix)\n");
 			fprintf (stderr, "  mode=MODE (where MODE is 'balanced', 'throughput' or 'pause[:N]' and N is maximum pause in milliseconds)\n");
 			fprintf (stderr, "  nursery-size=N (where N is an integer, possibly with a k, m or a g suffix)\n");
-			fprintf (stderr, "  major=COLLECTOR (where COLLECTOR is `marksweep', `marksweep-conc', `marksweep-par')\n");
+			fprintf (stderr, "  pause-target=N (where N is the targeted pause time in milliseconds, optionally with a `ms' suffix)\n");
+			fprintf (stderr, "  major=COLLECTOR (where COLLECTOR is `marksweep', `marksweep-conc', `marksweep-par' or `regions')\n");
 			fprintf (stderr, "  minor=COLLECTOR (where COLLECTOR is `simple' or `split')\n");
 			fprintf (stderr, "  wbarrier=WBARRIER (where WBARRIER is `remset' or `cardtable')\n");
 			fprintf (stderr, "  [no-]cementing\n");
 			fprintf (stderr, "  [no-]dynamic-nursery\n");
+			fprintf (stderr, "  [no-]numa\n");
+			fprintf (stderr, "  [no-]concurrent-los-sweep\n");
+			fprintf (stderr, "  preclean-rounds=N (where N is the maximum number of mod union precleaning rounds)\n");
 			if (sgen_major_collector.print_gc_param_usage)
 				sgen_major_collector.print_gc_param_usage ();
 			if (sgen_minor_collector.print_gc_param_usage)
@@ -3733,13 +4131,18 @@ sgen_gc_init (void)
 	if (sgen_major_collector.post_param_init)
 		sgen_major_collector.post_param_init (&sgen_major_collector);
 
+	sgen_los_init (concurrent_los_sweep);
+
 	sgen_thread_pool_start ();
 
 	sgen_memgov_init (max_heap, soft_limit, debug_print_allowance, allowance_ratio, save_target);
 
 	memset (&remset, 0, sizeof (remset));
 
-	sgen_card_table_init (&remset);
+	if (store_remset)
+		sgen_ssb_init (&remset);
+	else
+		sgen_card_table_init (&remset);
 
 	sgen_register_root (NULL, 0, sgen_make_user_root_descriptor (sgen_mark_normal_gc_handles), ROOT_TYPE_NORMAL, MONO_ROOT_SOURCE_GC_HANDLE, NULL, "GC Handles (SGen, Normal)");
 
@@ -3816,12 +4219,18 @@ void
 sgen_stop_world (int generation, gboolean serial_collection)
 {
 	long long major_total = -1, major_marked = -1, los_total = -1, los_marked = -1;
+	SGEN_TV_DECLARE (suspend_start);
+	SGEN_TV_DECLARE (suspend_end);
 
 	SGEN_ASSERT (0, !world_is_stopped, "Why are we stopping a stopped world?");
 
 	sgen_binary_protocol_world_stopping (generation, sgen_timestamp (), (gpointer) (gsize) mono_native_thread_id_get ());
+	sgen_recent_event (SGEN_RECENT_PAUSE_BEGIN, generation, 0);
 
+	SGEN_TV_GETTIME (suspend_start);
 	sgen_client_stop_world (generation, serial_collection);
+	SGEN_TV_GETTIME (suspend_end);
+	pause_phase_record (generation, PAUSE_PHASE_SUSPEND, SGEN_TV_ELAPSED (suspend_start, suspend_end));
 
 	world_is_stopped = TRUE;
 
@@ -3836,6 +4245,8 @@ sgen_restart_world (int generation, gboolean serial_collection)
 {
 	long long major_total = -1, major_marked = -1, los_total = -1, los_marked = -1;
 	gint64 stw_time;
+	SGEN_TV_DECLARE (restart_start);
+	SGEN_TV_DECLARE (restart_end);
 
 	SGEN_ASSERT (0, world_is_stopped, "Why are we restarting a running world?");
 
@@ -3845,9 +4256,13 @@ sgen_restart_world (int generation, gboolean serial_collection)
 
 	world_is_stopped = FALSE;
 
+	SGEN_TV_GETTIME (restart_start);
 	sgen_client_restart_world (generation, serial_collection, &stw_time);
+	SGEN_TV_GETTIME (restart_end);
+	pause_phase_record (generation, PAUSE_PHASE_RESTART, SGEN_TV_ELAPSED (restart_start, restart_end));
 
 	sgen_binary_protocol_world_restarted (generation, sgen_timestamp ());
+	sgen_recent_event (SGEN_RECENT_PAUSE_END, generation, stw_time);
 
 	if (sgen_client_bridge_need_processing ())
 		sgen_client_bridge_processing_finish (generation);
@@ -157,6 +157,14 @@ extern FILE* sgen_gc_debug_file;
 
 extern int sgen_current_collection_generation;
 
+/*
+ * Set by the client while it wants to be told about the objects marked or
+ * copied by the serial collectors, see sgen_client_object_marked ().
+ */
+extern gboolean sgen_report_marked_objects;
+
+#define SGEN_REPORT_MARKED_OBJECT(obj) do {					if (G_UNLIKELY (sgen_report_marked_objects))				sgen_client_object_marked ((obj));		} while (0)
+
 extern unsigned int sgen_global_stop_count;
 
 #define SGEN_ALIGN_UP_TO(val,align)	(((val) + (align - 1)) & ~(align - 1))
@@ -299,6 +307,7 @@ void sgen_gc_init (void)
 void sgen_os_init (void);
 
 void sgen_update_heap_boundaries (mword low, mword high);
+gboolean sgen_ptr_in_heap_boundaries (gpointer ptr);
 
 void sgen_check_section_scan_starts (GCMemSection *section);
 
@@ -345,6 +354,7 @@ enum {
 	INTERNAL_MEM_TEMPORARY,
 	INTERNAL_MEM_LOG_ENTRY,
 	INTERNAL_MEM_COMPLEX_DESCRIPTORS,
+	INTERNAL_MEM_STORE_REMSET,
 	INTERNAL_MEM_FIRST_CLIENT
 };
 
@@ -417,6 +427,27 @@ struct _SgenThreadInfo {
 
 	/* Total bytes allocated by this thread in its lifetime so far. */
 	gint64 total_bytes_allocated;
+	/* Size of the next TLAB this thread asks for, see sgen-alloc.c */
+	guint32 tlab_refill_size;
+
+	/* Allocation sampling state, see sgen-alloc.c */
+	gint64 alloc_sample_bytes;
+	gint64 alloc_sample_next;
+	guint64 alloc_sample_pending;
+	guint64 alloc_sample_seed;
+
+	/* Store buffer of the SSB remembered set, see sgen-ssb.c */
+	gpointer *store_remset_buffer;
+	gpointer *store_remset_scanned;
+	gpointer *store_remset_next;
+	gpointer *store_remset_end;
+
+	/* Pinned major block this thread allocates from without the GC lock, see sgen-marksweep.c */
+	gpointer pinned_alloc_block;
+
+	/* Free GC handle slots reserved by this thread, see sgen-gchandles.c */
+	guint32 gchandle_cache [HANDLE_TYPE_MAX][SGEN_GCHANDLE_CACHE_SIZE];
+	int gchandle_cache_count [HANDLE_TYPE_MAX];
 };
 
 gboolean sgen_is_worker_thread (MonoNativeThreadId thread);
@@ -487,9 +518,16 @@ struct _SgenFragment {
 	SgenFragment *next_in_order; /* We use a different entry for all active fragments so we can avoid SMR. */
 };
 
+#define SGEN_FRAGMENT_SIZE_BINS	(sizeof (mword) * 8)
+
 typedef struct {
 	SgenFragment *alloc_head; /* List head to be used when allocating memory. Walk with fragment_next. */
 	SgenFragment *region_head; /* List head of the region used by this allocator. Walk with next_in_order. */
+	/*
+	 * size_bins [i] is a fragment on the alloc list such that none before it
+	 * has 2^i bytes or more free.  Allocation starts walking from there.
+	 */
+	SgenFragment *size_bins [SGEN_FRAGMENT_SIZE_BINS];
 } SgenFragmentAllocator;
 
 void sgen_fragment_allocator_add (SgenFragmentAllocator *allocator, char *start, char *end);
@@ -632,6 +670,28 @@ typedef enum {
 	CARDTABLE_SCAN_MOD_UNION_PRECLEAN = CARDTABLE_SCAN_MOD_UNION | 2,
 } CardTableScanType;
 
+/*
+ * Shared cursor for a card table scan that is split across several parallel
+ * jobs. Rather than handing each job a fixed slice of the heap up front, the
+ * jobs keep claiming fixed-size chunks from the cursor until it runs past the
+ * end, so a worker that got a clean slice helps out with the dirty ones.
+ */
+typedef struct {
+	volatile gint32 next_chunk;
+} SgenCardTableScanSplit;
+
+static inline void
+sgen_card_table_scan_split_reset (SgenCardTableScanSplit *split)
+{
+	split->next_chunk = 0;
+}
+
+static inline int
+sgen_card_table_scan_split_claim (SgenCardTableScanSplit *split)
+{
+	return mono_atomic_inc_i32 (&split->next_chunk) - 1;
+}
+
 typedef struct _SgenMajorCollector SgenMajorCollector;
 struct _SgenMajorCollector {
 	size_t section_size;
@@ -643,6 +703,7 @@ struct _SgenMajorCollector {
 	void* (*alloc_heap) (mword nursery_size, mword nursery_align);
 	gboolean (*is_object_live) (GCObject *obj);
 	GCObject* (*alloc_small_pinned_obj) (GCVTable vtable, size_t size, gboolean has_references);
+	GCObject* (*alloc_small_pinned_obj_local) (SgenThreadInfo *info, GCVTable vtable, size_t size, gboolean has_references);
 	GCObject* (*alloc_degraded) (GCVTable vtable, size_t size);
 
 	SgenObjectOperations major_ops_serial;
@@ -660,11 +721,18 @@ struct _SgenMajorCollector {
 	 * debugging.  Can assume the world is stopped.
 	 */
 	void (*iterate_objects) (IterateObjectsFlags flags, IterateObjectCallbackFunc callback, void *data);
+	/*
+	 * For walking the heap in slices: `iterate_block_objects` is `iterate_objects` for
+	 * a single entry of the block array, which has `get_num_block_slots` entries.
+	 * Entries are only appended to the array between major collections.
+	 */
+	guint32 (*get_num_block_slots) (void);
+	void (*iterate_block_objects) (IterateObjectsFlags flags, guint32 index, IterateObjectCallbackFunc callback, void *data);
 
 	void (*free_non_pinned_object) (GCObject *obj, size_t size);
 	void (*pin_objects) (SgenGrayQueue *queue);
 	void (*pin_major_object) (GCObject *obj, SgenGrayQueue *queue);
-	void (*scan_card_table) (CardTableScanType scan_type, ScanCopyContext ctx, int job_index, int job_split_count, int block_count);
+	void (*scan_card_table) (CardTableScanType scan_type, ScanCopyContext ctx, SgenCardTableScanSplit *split);
 	void (*iterate_live_block_ranges) (sgen_cardtable_block_callback callback);
 	void (*iterate_block_ranges) (sgen_cardtable_block_callback callback);
 	void (*update_cardtable_mod_union) (void);
@@ -699,6 +767,7 @@ struct _SgenMajorCollector {
 extern SgenMajorCollector sgen_major_collector;
 
 void sgen_marksweep_init (SgenMajorCollector *collector);
+void sgen_marksweep_regions_init (SgenMajorCollector *collector);
 void sgen_marksweep_conc_init (SgenMajorCollector *collector);
 void sgen_marksweep_conc_par_init (SgenMajorCollector *collector);
 SgenMajorCollector* sgen_get_major_collector (void);
@@ -715,8 +784,12 @@ typedef struct _SgenRememberedSet {
 	void (*wbarrier_range_copy) (gpointer dest, gconstpointer src, int count);
 
 	void (*start_scan_remsets) (void);
+	/* Scans remembered locations that are not on the card table, may be NULL */
+	void (*scan_remsets) (ScanCopyContext ctx);
 
 	void (*clear_cards) (void);
+	/* Moves everything remembered outside the card table onto it, may be NULL */
+	void (*spill_to_cards) (void);
 
 	gboolean (*find_address) (char *addr);
 	gboolean (*find_address_with_cards) (char *cards_start, guint8 *cards, char *addr);
@@ -834,6 +907,10 @@ void sgen_finalize_in_range (int generation, ScanCopyContext ctx)
 	MONO_PERMIT (need (sgen_gc_locked));
 void sgen_null_link_in_range (int generation, ScanCopyContext ctx, gboolean track)
 	MONO_PERMIT (need (sgen_gc_locked, sgen_world_stopped));
+gboolean sgen_null_link_in_slot_range (int generation, ScanCopyContext ctx, gboolean track, guint32 begin, guint32 end)
+	MONO_PERMIT (need (sgen_gc_locked, sgen_world_stopped));
+void sgen_null_weak_fields (ScanCopyContext ctx)
+	MONO_PERMIT (need (sgen_gc_locked, sgen_world_stopped));
 void sgen_process_fin_stage_entries (void)
 	MONO_PERMIT (need (sgen_gc_locked));
 gboolean sgen_have_pending_finalizers (void);
@@ -909,11 +986,15 @@ extern mword sgen_los_memory_usage_total;
 void sgen_los_free_object (LOSObject *obj);
 void* sgen_los_alloc_large_inner (GCVTable vtable, size_t size)
 	MONO_PERMIT (need (sgen_gc_locked, sgen_stop_world));
+void* sgen_los_alloc_large_uninitialized (GCVTable vtable, size_t size, size_t header_size)
+	MONO_PERMIT (need (sgen_gc_locked, sgen_stop_world));
 void sgen_los_sweep (void);
+void sgen_los_finish_sweep (void);
+void sgen_los_init (gboolean concurrent_sweep);
 gboolean sgen_ptr_is_in_los (char *ptr, char **start);
 void sgen_los_iterate_objects (IterateObjectCallbackFunc cb, void *user_data);
 void sgen_los_iterate_live_block_ranges (sgen_cardtable_block_callback callback);
-void sgen_los_scan_card_table (CardTableScanType scan_type, ScanCopyContext ctx, int job_index, int job_split_count);
+void sgen_los_scan_card_table (CardTableScanType scan_type, ScanCopyContext ctx, SgenCardTableScanSplit *split);
 void sgen_los_update_cardtable_mod_union (void);
 void sgen_los_count_cards (long long *num_total_cards, long long *num_marked_cards);
 gboolean sgen_los_is_valid_object (char *object);
@@ -949,6 +1030,8 @@ GCObject* sgen_alloc_for_promotion (GCObject *obj, size_t objsize, gboolean has_
 GCObject* sgen_alloc_obj_nolock (GCVTable vtable, size_t size)
 	MONO_PERMIT (need (sgen_gc_locked, sgen_stop_world));
 GCObject* sgen_try_alloc_obj_nolock (GCVTable vtable, size_t size);
+GCObject* sgen_alloc_large_obj_uninitialized_nolock (GCVTable vtable, size_t size, size_t header_size)
+	MONO_PERMIT (need (sgen_gc_locked, sgen_stop_world));
 
 /* Threads */
 
@@ -1024,8 +1107,10 @@ typedef gpointer (*SgenGCHandleIterateCallback) (gpointer hidden, GCHandleType h
 
 guint32 sgen_gchandle_new (GCObject *obj, gboolean pinned);
 guint32 sgen_gchandle_new_weakref (GCObject *obj, gboolean track_resurrection);
+void sgen_gchandle_new_bulk (GCHandleType handle_type, GCObject **objs, guint32 *gchandles, int count);
 void sgen_gchandle_iterate (GCHandleType handle_type, int max_generation, SgenGCHandleIterateCallback callback, gpointer user)
 	MONO_PERMIT (need (sgen_world_stopped));
+guint32 sgen_gchandle_get_num_slots (GCHandleType handle_type);
 void sgen_gchandle_set_target (guint32 gchandle, GCObject *obj);
 void sgen_mark_normal_gc_handles (void *addr, SgenUserMarkFunc mark_func, void *gc_data)
 	MONO_PERMIT (need (sgen_world_stopped));
@@ -1034,6 +1119,8 @@ void sgen_gc_handles_report_roots (SgenUserReportRootFunc mark_func, void *gc_da
 gpointer sgen_gchandle_get_metadata (guint32 gchandle);
 GCObject *sgen_gchandle_get_target (guint32 gchandle);
 void sgen_gchandle_free (guint32 gchandle);
+void sgen_gchandle_free_bulk (guint32 *gchandles, int count);
+void sgen_gchandle_thread_detach (SgenThreadInfo *info);
 
 /* Other globals */
 
@@ -1046,6 +1133,7 @@ extern int default_nursery_size;
 extern guint32 sgen_tlab_size;
 extern NurseryClearPolicy sgen_nursery_clear_policy;
 extern gboolean sgen_try_free_some_memory;
+extern gboolean sgen_numa_enabled;
 extern mword sgen_total_promoted_size;
 extern mword sgen_total_allocated_major;
 extern volatile gboolean sgen_suspend_finalizers;
@@ -1083,6 +1171,9 @@ GCObject* sgen_alloc_obj_pinned (GCVTable vtable, size_t size)
 GCObject* sgen_alloc_obj_mature (GCVTable vtable, size_t size)
 	MONO_PERMIT (need (sgen_lock_gc, sgen_stop_world));
 
+void sgen_set_allocation_sample_interval (size_t interval);
+guint64 sgen_take_allocation_sample (void);
+
 /* Debug support */
 
 void sgen_check_remset_consistency (void);
@@ -159,25 +159,101 @@ sgen_gc_handles_report_roots (SgenUserReportRootFunc report_func, void *gc_data)
 	} SGEN_ARRAY_LIST_END_FOREACH_SLOT;
 }
 
+/*
+ * Per-thread handle slot caches.
+ *
+ * Allocating from the shared table means scanning for a free slot and racing
+ * other allocators for it with a CAS, and every allocation bumps the shared
+ * `slot_hint`.  Handles that come and go at a high rate, like the pinned
+ * handles of I/O buffers, turn that into a point of contention.
+ *
+ * Each thread therefore keeps a small stack of free slot indices per handle
+ * type.  A cached slot stays occupied in the table, holding the same entry as
+ * a handle to NULL, so neither other allocators nor the collector touch it,
+ * and only the owning thread hands it out again.  Freed handles go onto the
+ * cache of the thread that frees them.  Caches are refilled from, and spilled
+ * back to, the table half a cache at a time.
+ *
+ * Weak field handles are allocated by the GC itself and aren't cached.
+ */
+
+static inline gpointer
+cached_slot_entry (GCHandleType type)
+{
+	return MONO_GC_HANDLE_METADATA_POINTER (sgen_client_default_metadata (), GC_HANDLE_TYPE_IS_WEAK (type));
+}
+
+static SgenThreadInfo*
+handle_cache_for_type (GCHandleType type)
+{
+	if (type == HANDLE_WEAK_FIELDS)
+		return NULL;
+	return mono_thread_info_current ();
+}
+
+static void
+refill_handle_cache (SgenThreadInfo *info, HandleData *handles)
+{
+	guint32 *cache = info->gchandle_cache [handles->type];
+	int i;
+
+	for (i = 0; i < SGEN_GCHANDLE_CACHE_SIZE / 2; ++i)
+		cache [i] = sgen_array_list_add (&handles->entries_array, NULL, handles->type, TRUE);
+	info->gchandle_cache_count [handles->type] = i;
+}
+
+/* Returns all but `keep` of the thread's cached slots to the table. */
+static void
+spill_handle_cache (SgenThreadInfo *info, HandleData *handles, int keep)
+{
+	guint32 *cache = info->gchandle_cache [handles->type];
+	int *count = &info->gchandle_cache_count [handles->type];
+
+	while (*count > keep) {
+		volatile gpointer *slot = sgen_array_list_get_slot (&handles->entries_array, cache [--*count]);
+		protocol_gchandle_update (handles->type, (gpointer)slot, *slot, NULL);
+		*slot = NULL;
+	}
+}
+
 static guint32
-alloc_handle (HandleData *handles, GCObject *obj, gboolean track)
+alloc_handle_with_cache (SgenThreadInfo *info, HandleData *handles, GCObject *obj)
 {
 	guint32 res, index;
 	SgenArrayList *array = &handles->entries_array;
 
-	/*
-	 * If a GC happens shortly after a new bucket is allocated, the entire
-	 * bucket could be scanned even though it's mostly empty. To avoid this,
-	 * we track the maximum index seen so far, so that we can skip the empty
-	 * slots.
-	 *
-	 * Note that we update `next_slot` before we even try occupying the
-	 * slot.  If we did it the other way around and a GC happened in
-	 * between, the GC wouldn't know that the slot was occupied.  This is
-	 * not a huge deal since `obj` is on the stack and thus pinned anyway,
-	 * but hopefully some day it won't be anymore.
-	 */
-	index = sgen_array_list_add (array, obj, handles->type, TRUE);
+	if (info) {
+		int *count = &info->gchandle_cache_count [handles->type];
+		volatile gpointer *slot;
+		gpointer entry;
+
+		if (!*count)
+			refill_handle_cache (info, handles);
+		index = info->gchandle_cache [handles->type][--*count];
+
+		/* The slot is ours, so there's nobody to race with */
+		slot = sgen_array_list_get_slot (array, index);
+		if (obj)
+			entry = MONO_GC_HANDLE_OBJECT_POINTER (obj, GC_HANDLE_TYPE_IS_WEAK (handles->type));
+		else
+			entry = cached_slot_entry ((GCHandleType)handles->type);
+		protocol_gchandle_update (handles->type, (gpointer)slot, *slot, entry);
+		*slot = entry;
+	} else {
+		/*
+		 * If a GC happens shortly after a new bucket is allocated, the entire
+		 * bucket could be scanned even though it's mostly empty. To avoid this,
+		 * we track the maximum index seen so far, so that we can skip the empty
+		 * slots.
+		 *
+		 * Note that we update `next_slot` before we even try occupying the
+		 * slot.  If we did it the other way around and a GC happened in
+		 * between, the GC wouldn't know that the slot was occupied.  This is
+		 * not a huge deal since `obj` is on the stack and thus pinned anyway,
+		 * but hopefully some day it won't be anymore.
+		 */
+		index = sgen_array_list_add (array, obj, handles->type, TRUE);
+	}
 #ifdef HEAVY_STATISTICS
 	mono_atomic_inc_i32 ((volatile gint32 *)&stat_gc_handles_allocated);
 	if (stat_gc_handles_allocated > stat_gc_handles_max_allocated)
@@ -190,12 +266,37 @@ alloc_handle (HandleData *handles, GCObject *obj, gboolean track)
 	return res;
 }
 
+static guint32
+alloc_handle (HandleData *handles, GCObject *obj, gboolean track)
+{
+	return alloc_handle_with_cache (handle_cache_for_type ((GCHandleType)handles->type), handles, obj);
+}
+
 static gboolean
 object_older_than (GCObject *object, int generation)
 {
 	return generation == GENERATION_NURSERY && !sgen_ptr_in_nursery (object);
 }
 
+static inline void
+iterate_slot (volatile gpointer *slot, GCHandleType handle_type, int max_generation, SgenGCHandleIterateCallback callback, gpointer user)
+{
+	gpointer hidden, result, occupied;
+
+	hidden = *slot;
+	occupied = (gpointer) MONO_GC_HANDLE_OCCUPIED (hidden);
+	g_assert (hidden ? !!occupied : !occupied);
+	if (!occupied)
+		return;
+	result = callback (hidden, handle_type, max_generation, user);
+	if (result)
+		SGEN_ASSERT (0, MONO_GC_HANDLE_OCCUPIED (result), "Why did the callback return an unoccupied entry?");
+	else
+		HEAVY_STAT (mono_atomic_dec_i32 ((volatile gint32 *)&stat_gc_handles_allocated));
+	protocol_gchandle_update (handle_type, (gpointer)slot, hidden, result);
+	*slot = result;
+}
+
 /*
  * Maps a function over all GC handles.
  * This assumes that the world is stopped!
@@ -205,7 +306,6 @@ sgen_gchandle_iterate (GCHandleType handle_type, int max_generation, SgenGCHandl
 {
 	HandleData *handle_data = gc_handles_for_type (handle_type);
 	SgenArrayList *array = &handle_data->entries_array;
-	gpointer hidden, result, occupied;
 	volatile gpointer *slot;
 
 	/* If a new bucket has been allocated, but the capacity has not yet been
@@ -213,21 +313,34 @@ sgen_gchandle_iterate (GCHandleType handle_type, int max_generation, SgenGCHandl
 	 * world is stopped, so we shouldn't miss any handles during iteration.
 	 */
 	SGEN_ARRAY_LIST_FOREACH_SLOT (array, slot) {
-		hidden = *slot;
-		occupied = (gpointer) MONO_GC_HANDLE_OCCUPIED (hidden);
-		g_assert (hidden ? !!occupied : !occupied);
-		if (!occupied)
-			continue;
-		result = callback (hidden, handle_type, max_generation, user);
-		if (result)
-			SGEN_ASSERT (0, MONO_GC_HANDLE_OCCUPIED (result), "Why did the callback return an unoccupied entry?");
-		else
-			HEAVY_STAT (mono_atomic_dec_i32 ((volatile gint32 *)&stat_gc_handles_allocated));
-		protocol_gchandle_update (handle_type, (gpointer)slot, hidden, result);
-		*slot = result;
+		iterate_slot (slot, handle_type, max_generation, callback, user);
 	} SGEN_ARRAY_LIST_END_FOREACH_SLOT;
 }
 
+/*
+ * Like `sgen_gchandle_iterate ()`, but only for the slots in [begin, end).
+ * Disjoint ranges can be iterated in parallel.
+ */
+static void
+gchandle_iterate_range (GCHandleType handle_type, int max_generation, guint32 begin, guint32 end, SgenGCHandleIterateCallback callback, gpointer user)
+{
+	HandleData *handle_data = gc_handles_for_type (handle_type);
+	SgenArrayList *array = &handle_data->entries_array;
+	volatile gpointer *slot;
+	guint32 index;
+
+	end = MIN (end, array->next_slot);
+	SGEN_ARRAY_LIST_FOREACH_SLOT_RANGE (array, begin, end, slot, index) {
+		iterate_slot (slot, handle_type, max_generation, callback, user);
+	} SGEN_ARRAY_LIST_END_FOREACH_SLOT_RANGE;
+}
+
+guint32
+sgen_gchandle_get_num_slots (GCHandleType handle_type)
+{
+	return gc_handles_for_type (handle_type)->entries_array.next_slot;
+}
+
 guint32
 sgen_gchandle_new (GCObject *obj, gboolean pinned)
 {
@@ -240,6 +353,22 @@ sgen_gchandle_new_weakref (GCObject *obj, gboolean track_resurrection)
 	return alloc_handle (gc_handles_for_type (track_resurrection ? HANDLE_WEAK_TRACK : HANDLE_WEAK), obj, track_resurrection);
 }
 
+/*
+ * Allocates `count` handles of type `handle_type`, one for each of `objs`,
+ * into `gchandles`.
+ */
+void
+sgen_gchandle_new_bulk (GCHandleType handle_type, GCObject **objs, guint32 *gchandles, int count)
+{
+	HandleData *handles = gc_handles_for_type (handle_type);
+	SgenThreadInfo *info = handle_cache_for_type (handle_type);
+	int i;
+
+	SGEN_ASSERT (0, handles, "Invalid GC handle type");
+	for (i = 0; i < count; ++i)
+		gchandles [i] = alloc_handle_with_cache (info, handles, objs [i]);
+}
+
 static GCObject *
 link_get (volatile gpointer *link_addr, gboolean is_weak)
 {
@@ -362,8 +491,8 @@ sgen_gchandle_get_metadata (guint32 gchandle)
 	return mono_gchandle_slot_metadata (slot, MONO_GC_HANDLE_TYPE_IS_WEAK (type));
 }
 
-void
-sgen_gchandle_free (guint32 gchandle)
+static void
+free_handle (SgenThreadInfo *info, guint32 gchandle)
 {
 	if (!gchandle)
 		return;
@@ -380,8 +509,19 @@ sgen_gchandle_free (guint32 gchandle)
 	entry = *slot;
 
 	if (index < handles->entries_array.capacity && MONO_GC_HANDLE_OCCUPIED (entry)) {
-		*slot = NULL;
-		protocol_gchandle_update (handles->type, (gpointer)slot, entry, NULL);
+		if (info && type != HANDLE_WEAK_FIELDS) {
+			int *count = &info->gchandle_cache_count [type];
+			gpointer cached = cached_slot_entry (type);
+
+			if (*count == SGEN_GCHANDLE_CACHE_SIZE)
+				spill_handle_cache (info, handles, SGEN_GCHANDLE_CACHE_SIZE / 2);
+			protocol_gchandle_update (handles->type, (gpointer)slot, entry, cached);
+			*slot = cached;
+			info->gchandle_cache [type][(*count)++] = index;
+		} else {
+			*slot = NULL;
+			protocol_gchandle_update (handles->type, (gpointer)slot, entry, NULL);
+		}
 		HEAVY_STAT (mono_atomic_dec_i32 ((volatile gint32 *)&stat_gc_handles_allocated));
 	} else {
 		/* print a warning? */
@@ -389,6 +529,40 @@ sgen_gchandle_free (guint32 gchandle)
 	sgen_client_gchandle_destroyed ((GCHandleType)handles->type, gchandle);
 }
 
+void
+sgen_gchandle_free (guint32 gchandle)
+{
+	free_handle (mono_thread_info_current (), gchandle);
+}
+
+void
+sgen_gchandle_free_bulk (guint32 *gchandles, int count)
+{
+	SgenThreadInfo *info = mono_thread_info_current ();
+	int i;
+
+	for (i = 0; i < count; ++i)
+		free_handle (info, gchandles [i]);
+}
+
+/* Returns the thread's cached handle slots to the table. */
+void
+sgen_gchandle_thread_detach (SgenThreadInfo *info)
+{
+	guint type;
+
+	for (type = HANDLE_TYPE_MIN; type < HANDLE_TYPE_MAX; ++type) {
+		if (info->gchandle_cache_count [type])
+			spill_handle_cache (info, gc_handles_for_type ((GCHandleType)type), 0);
+	}
+}
+
+typedef struct {
+	ScanCopyContext ctx;
+	/* Whether a link was updated to point to a copied object */
+	gboolean updated;
+} NullLinkClosure;
+
 /*
  * Returns whether to remove the link from its hash.
  */
@@ -396,7 +570,7 @@ static gpointer
 null_link_if_necessary (gpointer hidden, GCHandleType handle_type, int max_generation, gpointer user)
 {
 	const gboolean is_weak = GC_HANDLE_TYPE_IS_WEAK (handle_type);
-	ScanCopyContext *ctx = (ScanCopyContext *)user;
+	NullLinkClosure *closure = (NullLinkClosure *)user;
 	GCObject *obj;
 	GCObject *copy;
 
@@ -417,9 +591,11 @@ null_link_if_necessary (gpointer hidden, GCHandleType handle_type, int max_gener
 		return MONO_GC_HANDLE_METADATA_POINTER (sgen_client_metadata_for_object (obj), is_weak);
 
 	copy = obj;
-	ctx->ops->copy_or_mark_object (&copy, ctx->queue);
+	closure->ctx.ops->copy_or_mark_object (&copy, closure->ctx.queue);
 	SGEN_ASSERT (0, copy, "Why couldn't we copy the object?");
 	/* Update link if object was moved. */
+	if (copy != obj)
+		closure->updated = TRUE;
 	return MONO_GC_HANDLE_OBJECT_POINTER (copy, is_weak);
 }
 
@@ -464,11 +640,34 @@ scan_for_weak (gpointer hidden, GCHandleType handle_type, int max_generation, gp
 void
 sgen_null_link_in_range (int generation, ScanCopyContext ctx, gboolean track)
 {
-	sgen_gchandle_iterate (track ? HANDLE_WEAK_TRACK : HANDLE_WEAK, generation, null_link_if_necessary, &ctx);
+	NullLinkClosure closure = { ctx, FALSE };
+
+	sgen_gchandle_iterate (track ? HANDLE_WEAK_TRACK : HANDLE_WEAK, generation, null_link_if_necessary, &closure);
 
 	//we're always called for gen zero. !track means short ref
 	if (generation == 0 && !track)
-		sgen_gchandle_iterate (HANDLE_WEAK_FIELDS, generation, scan_for_weak, &ctx);
+		sgen_null_weak_fields (ctx);
+}
+
+/*
+ * Processes the weak links in the slots [begin, end) of the `track` handle
+ * type.  The weak fields handles are not included, see
+ * `sgen_null_weak_fields ()`.  Returns whether any link was updated to
+ * point to a copied object.
+ */
+gboolean
+sgen_null_link_in_slot_range (int generation, ScanCopyContext ctx, gboolean track, guint32 begin, guint32 end)
+{
+	NullLinkClosure closure = { ctx, FALSE };
+
+	gchandle_iterate_range (track ? HANDLE_WEAK_TRACK : HANDLE_WEAK, generation, begin, end, null_link_if_necessary, &closure);
+	return closure.updated;
+}
+
+void
+sgen_null_weak_fields (ScanCopyContext ctx)
+{
+	sgen_gchandle_iterate (HANDLE_WEAK_FIELDS, GENERATION_NURSERY, scan_for_weak, &ctx);
 }
 
 typedef struct {
@@ -161,6 +161,7 @@ description_for_type (int type)
 	case INTERNAL_MEM_TEMPORARY: return "temporary";
 	case INTERNAL_MEM_LOG_ENTRY: return "log-entry";
 	case INTERNAL_MEM_COMPLEX_DESCRIPTORS: return "complex-descriptors";
+	case INTERNAL_MEM_STORE_REMSET: return "store-remset";
 	default: {
 		const char *description = sgen_client_description_for_internal_mem_type (type);
 		SGEN_ASSERT (0, description, "Unknown internal mem type");
@@ -30,6 +30,7 @@
 #include "mono/sgen/sgen-cardtable.h"
 #include "mono/sgen/sgen-memory-governor.h"
 #include "mono/sgen/sgen-client.h"
+#include "mono/sgen/sgen-thread-pool.h"
 
 #define LOS_SECTION_SIZE	(1024 * 1024)
 
@@ -75,6 +76,33 @@ static LOSFreeChunks *los_fast_free_lists [LOS_NUM_FAST_SIZES]; /* 0 is for larg
 static mword los_num_objects = 0;
 static int los_num_sections = 0;
 
+/*
+ * The pause of a major collection only unlinks the dead objects from
+ * `sgen_los_object_list` and queues them on `los_objects_to_free`.  Giving
+ * their memory back and rebuilding the free lists is done by the sweep job,
+ * on a thread pool context with a thread of its own when sweeping
+ * concurrently, so it doesn't hold up the GC workers.  `los_lock` protects
+ * the sections and the free lists from the mutator while it runs.  The
+ * mutator only waits for the job when an allocation fails, since the space
+ * it needs might not have been released yet.
+ */
+static gboolean los_concurrent_sweep = FALSE;
+static int los_sweep_pool_context = -1;
+static LOSObject *los_objects_to_free = NULL;
+static SgenThreadPoolJob * volatile los_sweep_job = NULL;
+static mono_mutex_t los_lock;
+
+/*
+ * Sections that became empty are kept around, up to a limit, so transient
+ * large objects don't have to map and unmap a section each time.  Cached
+ * sections are not accounted as heap memory.  Protected by `los_lock`.
+ */
+#define LOS_SECTION_CACHE_SIZE	8
+
+static LOSSection *los_section_cache = NULL;
+static int los_num_cached_sections = 0;
+static guint64 stat_los_sections_reused = 0;
+
 //#define USE_MALLOC
 //#define LOS_CONSISTENCY_CHECK
 //#define LOS_DUMMY
@@ -216,6 +244,43 @@ randomize_los_object_start (gpointer addr, size_t obj_size, size_t alloced_size,
 
 }
 
+static LOSSection*
+alloc_los_section (void)
+{
+	LOSSection *section;
+
+	if (!sgen_memgov_try_alloc_space (LOS_SECTION_SIZE, SPACE_LOS))
+		return NULL;
+
+	if (los_section_cache) {
+		section = los_section_cache;
+		los_section_cache = section->next;
+		--los_num_cached_sections;
+		++stat_los_sections_reused;
+		return section;
+	}
+
+	section = (LOSSection *)sgen_alloc_os_memory_aligned (LOS_SECTION_SIZE, LOS_SECTION_SIZE, (SgenAllocFlags)(SGEN_ALLOC_HEAP | SGEN_ALLOC_ACTIVATE), NULL, MONO_MEM_ACCOUNT_SGEN_LOS);
+	if (!section)
+		sgen_memgov_release_space (LOS_SECTION_SIZE, SPACE_LOS);
+	return section;
+}
+
+static void
+release_los_section (LOSSection *section)
+{
+	sgen_memgov_release_space (LOS_SECTION_SIZE, SPACE_LOS);
+
+	if (los_num_cached_sections < LOS_SECTION_CACHE_SIZE) {
+		section->next = los_section_cache;
+		los_section_cache = section;
+		++los_num_cached_sections;
+		return;
+	}
+
+	sgen_free_os_memory (section, LOS_SECTION_SIZE, SGEN_ALLOC_HEAP, MONO_MEM_ACCOUNT_SGEN_LOS);
+}
+
 static LOSObject*
 get_los_section_memory (size_t size)
 {
@@ -249,11 +314,7 @@ get_los_section_memory (size_t size)
 		return randomize_los_object_start (free_chunks, obj_size, size, LOS_CHUNK_SIZE);
 	}
 
-	if (!sgen_memgov_try_alloc_space (LOS_SECTION_SIZE, SPACE_LOS))
-		return NULL;
-
-	section = (LOSSection *)sgen_alloc_os_memory_aligned (LOS_SECTION_SIZE, LOS_SECTION_SIZE, (SgenAllocFlags)(SGEN_ALLOC_HEAP | SGEN_ALLOC_ACTIVATE), NULL, MONO_MEM_ACCOUNT_SGEN_LOS);
-
+	section = alloc_los_section ();
 	if (!section)
 		return NULL;
 
@@ -309,8 +370,12 @@ free_los_section_memory (LOSObject *obj, size_t size)
 	add_free_chunk ((LOSFreeChunks*)SGEN_ALIGN_DOWN_TO ((mword)obj, LOS_CHUNK_SIZE), size);
 }
 
-void
-sgen_los_free_object (LOSObject *obj)
+/*
+ * Gives the memory of an object that is no longer on `sgen_los_object_list`
+ * back.  This can run on the sweep thread, concurrently with allocations.
+ */
+static void
+release_los_object (LOSObject *obj)
 {
 	if (obj->cardtable_mod_union)
 		sgen_card_table_free_mod_union (obj->cardtable_mod_union, (char*)obj->data, sgen_los_object_size (obj));
@@ -320,9 +385,6 @@ sgen_los_free_object (LOSObject *obj)
 	SGEN_LOG (4, "Freed large object %p, size %lu", obj->data, (unsigned long)size);
 	sgen_binary_protocol_empty (obj->data, size);
 
-	sgen_los_memory_usage -= size;
-	los_num_objects--;
-
 #ifdef USE_MALLOC
 	g_free (obj);
 #else
@@ -331,26 +393,42 @@ sgen_los_free_object (LOSObject *obj)
 		size += sizeof (LOSObject);
 		size = SGEN_ALIGN_UP_TO (size, pagesize);
 		sgen_free_os_memory ((gpointer)SGEN_ALIGN_DOWN_TO ((mword)obj, pagesize), size, SGEN_ALLOC_HEAP, MONO_MEM_ACCOUNT_SGEN_LOS);
-		sgen_los_memory_usage_total -= size;
+		SGEN_ATOMIC_ADD_P (sgen_los_memory_usage_total, -(gssize)size);
 		sgen_memgov_release_space (size, SPACE_LOS);
 	} else {
+		mono_os_mutex_lock (&los_lock);
 		free_los_section_memory (obj, size + sizeof (LOSObject));
 #ifdef LOS_CONSISTENCY_CHECKS
 		los_consistency_check ();
 #endif
+		mono_os_mutex_unlock (&los_lock);
 	}
 #endif
 #endif
 }
 
+void
+sgen_los_free_object (LOSObject *obj)
+{
+#ifndef LOS_DUMMY
+	sgen_los_memory_usage -= sgen_los_object_size (obj);
+	los_num_objects--;
+#endif
+
+	release_los_object (obj);
+}
+
 /*
  * Objects with size >= MAX_SMALL_SIZE are allocated in the large object space.
  * They are currently kept track of with a linked list.
  * They don't move, so there is no need to pin them during collection
  * and we avoid the memcpy overhead.
+ *
+ * Only the first CLEAR_SIZE bytes of the object are cleared, memory fresh from
+ * the OS is zeroed anyway.
  */
-void*
-sgen_los_alloc_large_inner (GCVTable vtable, size_t size)
+static void*
+los_alloc_large (GCVTable vtable, size_t size, size_t clear_size)
 {
 	LOSObject *obj = NULL;
 	void **vtslot;
@@ -379,9 +457,10 @@ sgen_los_alloc_large_inner (GCVTable vtable, size_t size)
 #else
 	sgen_ensure_free_space (size, GENERATION_OLD);
 
+ retry:
 #ifdef USE_MALLOC
 	obj = g_malloc (size + sizeof (LOSObject));
-	memset (obj, 0, size + sizeof (LOSObject));
+	memset (obj, 0, clear_size + sizeof (LOSObject));
 #else
 	if (size > LOS_SECTION_OBJECT_LIMIT) {
 		size_t obj_size = size + sizeof (LOSObject);
@@ -390,16 +469,23 @@ sgen_los_alloc_large_inner (GCVTable vtable, size_t size)
 		if (sgen_memgov_try_alloc_space (alloc_size, SPACE_LOS)) {
 			obj = (LOSObject *)sgen_alloc_os_memory (alloc_size, (SgenAllocFlags)(SGEN_ALLOC_HEAP | SGEN_ALLOC_ACTIVATE), NULL, MONO_MEM_ACCOUNT_SGEN_LOS);
 			if (obj) {
-				sgen_los_memory_usage_total += alloc_size;
+				SGEN_ATOMIC_ADD_P (sgen_los_memory_usage_total, alloc_size);
 				obj = randomize_los_object_start (obj, obj_size, alloc_size, pagesize);
 			}
 		}
 	} else {
+		mono_os_mutex_lock (&los_lock);
 		obj = get_los_section_memory (size + sizeof (LOSObject));
+		mono_os_mutex_unlock (&los_lock);
 		if (obj)
-			memset (obj, 0, size + sizeof (LOSObject));
+			memset (obj, 0, clear_size + sizeof (LOSObject));
 	}
 #endif
+	/* The space we need might still be held by objects the sweep hasn't released yet */
+	if (!obj && los_sweep_job) {
+		sgen_los_finish_sweep ();
+		goto retry;
+	}
 #endif
 	if (!obj)
 		return NULL;
@@ -427,46 +513,49 @@ sgen_los_alloc_large_inner (GCVTable vtable, size_t size)
 	return obj->data;
 }
 
+void*
+sgen_los_alloc_large_inner (GCVTable vtable, size_t size)
+{
+	return los_alloc_large (vtable, size, size);
+}
+
+/*
+ * Allocate a large object whose data after the first HEADER_SIZE bytes is not
+ * cleared.  It must not have references, the GC doesn't scan it, so the stale
+ * data is only visible to the client, which is going to overwrite it.
+ */
+void*
+sgen_los_alloc_large_uninitialized (GCVTable vtable, size_t size, size_t header_size)
+{
+	SGEN_ASSERT (0, !SGEN_VTABLE_HAS_REFERENCES (vtable), "Uninitialized large objects can't have references");
+	return los_alloc_large (vtable, size, header_size);
+}
+
 static void sgen_los_unpin_object (GCObject *data);
 
-void
-sgen_los_sweep (void)
+/*
+ * Releases the memory of the objects the last sweep found dead, frees
+ * sections that became empty and rebuilds the free lists from the chunk
+ * maps, which coalesces adjacent free chunks within each section.
+ */
+static void
+los_sweep_job_func (void *thread_data_untyped, SgenThreadPoolJob *job)
 {
-	LOSObject *bigobj, *prevbo;
+	LOSObject *obj;
 	LOSSection *section, *prev;
 	int i;
 	int num_sections = 0;
 
-	/* sweep the big objects list */
-	prevbo = NULL;
-	for (bigobj = sgen_los_object_list; bigobj;) {
-		SGEN_ASSERT (0, !SGEN_OBJECT_IS_PINNED (bigobj->data), "Who pinned a LOS object?");
-
-		if (sgen_los_object_is_pinned (bigobj->data)) {
-			if (bigobj->cardtable_mod_union) {
-				mword obj_size = sgen_los_object_size (bigobj);
-				mword num_cards = sgen_card_table_number_of_cards_in_range ((mword) bigobj->data, obj_size);
-				memset (bigobj->cardtable_mod_union, 0, num_cards);
-			}
-
-			sgen_los_unpin_object (bigobj->data);
-			sgen_update_heap_boundaries ((mword)bigobj->data, (mword)bigobj->data + sgen_los_object_size (bigobj));
-		} else {
-			LOSObject *to_free;
-			/* not referenced anywhere, so we can free it */
-			if (prevbo)
-				prevbo->next = bigobj->next;
-			else
-				sgen_los_object_list = bigobj->next;
-			to_free = bigobj;
-			bigobj = bigobj->next;
-			sgen_los_free_object (to_free);
-			continue;
-		}
-		prevbo = bigobj;
-		bigobj = bigobj->next;
+	obj = los_objects_to_free;
+	los_objects_to_free = NULL;
+	while (obj) {
+		LOSObject *next = obj->next;
+		release_los_object (obj);
+		obj = next;
 	}
 
+	mono_os_mutex_lock (&los_lock);
+
 	/* Try to free memory */
 	for (i = 0; i < LOS_NUM_FAST_SIZES; ++i)
 		los_fast_free_lists [i] = NULL;
@@ -480,11 +569,10 @@ sgen_los_sweep (void)
 				prev->next = next;
 			else
 				los_sections = next;
-			sgen_free_os_memory (section, LOS_SECTION_SIZE, SGEN_ALLOC_HEAP, MONO_MEM_ACCOUNT_SGEN_LOS);
-			sgen_memgov_release_space (LOS_SECTION_SIZE, SPACE_LOS);
+			release_los_section (section);
 			section = next;
 			--los_num_sections;
-			sgen_los_memory_usage_total -= LOS_SECTION_SIZE;
+			SGEN_ATOMIC_ADD_P (sgen_los_memory_usage_total, -(gssize)LOS_SECTION_SIZE);
 			continue;
 		}
 
@@ -504,10 +592,6 @@ sgen_los_sweep (void)
 		++num_sections;
 	}
 
-#ifdef LOS_CONSISTENCY_CHECK
-	los_consistency_check ();
-#endif
-
 	/*
 	g_print ("LOS sections: %d  objects: %d  usage: %d\n", num_sections, los_num_objects, sgen_los_memory_usage);
 	for (i = 0; i < LOS_NUM_FAST_SIZES; ++i) {
@@ -520,6 +604,90 @@ sgen_los_sweep (void)
 	*/
 
 	g_assert (los_num_sections == num_sections);
+
+	mono_os_mutex_unlock (&los_lock);
+
+	los_sweep_job = NULL;
+}
+
+void
+sgen_los_sweep (void)
+{
+	LOSObject *bigobj, *prevbo;
+
+	sgen_los_finish_sweep ();
+	SGEN_ASSERT (0, !los_objects_to_free, "Why are there still objects to free from the last sweep?");
+
+	/* sweep the big objects list */
+	prevbo = NULL;
+	for (bigobj = sgen_los_object_list; bigobj;) {
+		SGEN_ASSERT (0, !SGEN_OBJECT_IS_PINNED (bigobj->data), "Who pinned a LOS object?");
+
+		if (sgen_los_object_is_pinned (bigobj->data)) {
+			if (bigobj->cardtable_mod_union) {
+				mword obj_size = sgen_los_object_size (bigobj);
+				mword num_cards = sgen_card_table_number_of_cards_in_range ((mword) bigobj->data, obj_size);
+				memset (bigobj->cardtable_mod_union, 0, num_cards);
+			}
+
+			sgen_los_unpin_object (bigobj->data);
+			sgen_update_heap_boundaries ((mword)bigobj->data, (mword)bigobj->data + sgen_los_object_size (bigobj));
+		} else {
+			LOSObject *to_free;
+			/* not referenced anywhere, so we can free it */
+			if (prevbo)
+				prevbo->next = bigobj->next;
+			else
+				sgen_los_object_list = bigobj->next;
+			to_free = bigobj;
+			bigobj = bigobj->next;
+#ifndef LOS_DUMMY
+			sgen_los_memory_usage -= sgen_los_object_size (to_free);
+			los_num_objects--;
+#endif
+			to_free->next = los_objects_to_free;
+			los_objects_to_free = to_free;
+			continue;
+		}
+		prevbo = bigobj;
+		bigobj = bigobj->next;
+	}
+
+	if (los_concurrent_sweep) {
+		los_sweep_job = sgen_thread_pool_job_alloc ("los sweep", los_sweep_job_func, sizeof (SgenThreadPoolJob));
+		sgen_thread_pool_job_enqueue (los_sweep_pool_context, los_sweep_job);
+	} else {
+		los_sweep_job_func (NULL, NULL);
+	}
+}
+
+/*
+ * Waits for the memory of the objects found dead by the last sweep to be
+ * released.
+ */
+void
+sgen_los_finish_sweep (void)
+{
+	SgenThreadPoolJob *job = los_sweep_job;
+	if (job)
+		sgen_thread_pool_job_wait (los_sweep_pool_context, job);
+	SGEN_ASSERT (0, !los_sweep_job, "Why did the LOS sweep job not null itself?");
+
+#ifdef LOS_CONSISTENCY_CHECK
+	los_consistency_check ();
+#endif
+}
+
+void
+sgen_los_init (gboolean concurrent_sweep)
+{
+	mono_os_mutex_init (&los_lock);
+
+	los_concurrent_sweep = concurrent_sweep;
+	if (los_concurrent_sweep)
+		los_sweep_pool_context = sgen_thread_pool_create_dedicated_context ();
+
+	mono_counters_register ("# LOS sections reused", MONO_COUNTER_GC | MONO_COUNTER_ULONG, &stat_los_sections_reused);
 }
 
 gboolean
@@ -624,18 +792,32 @@ get_cardtable_mod_union_for_object (LOSObject *obj)
 	return other;
 }
 
+/* Number of consecutive LOS objects a card table scan job claims at a time. */
+#define LOS_CARD_SCAN_CHUNK_OBJECTS	8
+
 void
-sgen_los_scan_card_table (CardTableScanType scan_type, ScanCopyContext ctx, int job_index, int job_split_count)
+sgen_los_scan_card_table (CardTableScanType scan_type, ScanCopyContext ctx, SgenCardTableScanSplit *split)
 {
 	LOSObject *obj;
 	int i = 0;
+	int chunk_end = 0;
 
 	sgen_binary_protocol_los_card_table_scan_start (sgen_timestamp (), scan_type & CARDTABLE_SCAN_MOD_UNION);
+	/*
+	 * Walk the list once, claiming a new chunk each time we run out of the
+	 * current one and skipping ahead to it. Chunks are handed out in
+	 * increasing order, so we never have to go back.
+	 */
 	for (obj = sgen_los_object_list; obj; obj = obj->next, i++) {
 		mword num_cards = 0;
 		guint8 *cards;
 
-		if (i % job_split_count != job_index)
+		if (i >= chunk_end) {
+			int chunk = sgen_card_table_scan_split_claim (split);
+			chunk_end = (chunk + 1) * LOS_CARD_SCAN_CHUNK_OBJECTS;
+		}
+
+		if (i < chunk_end - LOS_CARD_SCAN_CHUNK_OBJECTS)
 			continue;
 
 		if (!SGEN_OBJECT_HAS_REFERENCES (obj->data))
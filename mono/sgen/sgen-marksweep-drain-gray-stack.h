@@ -96,6 +96,7 @@ COPY_OR_MARK_FUNCTION_NAME (GCObject **ptr, GCObject *obj, SgenGrayQueue *queue)
 				block = MS_BLOCK_FOR_OBJ (obj);
 				size_index = block->obj_size_index;
 				evacuate_block_obj_sizes [size_index] = FALSE;
+				evacuate_regions = FALSE;
 				MS_MARK_OBJECT_AND_ENQUEUE (obj, sgen_obj_get_descriptor (obj), block, queue);
 				return FALSE;
 			}
@@ -197,10 +198,12 @@ COPY_OR_MARK_FUNCTION_NAME (GCObject **ptr, GCObject *obj, SgenGrayQueue *queue)
 #ifdef COPY_OR_MARK_PARALLEL
 			first = sgen_los_pin_object_par (obj);
 #else
-			if (sgen_los_object_is_pinned (obj))
+			if (sgen_los_object_is_pinned (obj)) {
 				first = FALSE;
-			else
+			} else {
 				sgen_los_pin_object (obj);
+				SGEN_REPORT_MARKED_OBJECT (obj);
+			}
 #endif
 
 			if (first) {
@@ -112,6 +112,7 @@ struct _MSBlockInfo {
 	unsigned int has_references : 1;
 	unsigned int has_pinned : 1;	/* means cannot evacuate */
 	unsigned int is_to_space : 1;
+	unsigned int is_region_evacuating : 1;	/* evacuated as part of a sparse region */
 	void ** volatile free_list;
 	MSBlockInfo * volatile next_free;
 	guint8 * volatile cardtable_mod_union;
@@ -179,6 +180,27 @@ static int fast_block_obj_size_indexes [MS_NUM_FAST_BLOCK_OBJ_SIZE_INDEXES];
 static gboolean *evacuate_block_obj_sizes;
 static float evacuation_threshold = 0.666f;
 
+/*
+ * Region compaction.  A region is the naturally aligned contingent of
+ * MS_BLOCK_ALLOC_NUM blocks we get from the OS in one go.  Evacuation per
+ * block object size can't give such a contingent back as long as a few
+ * blocks of other sizes keep it alive, so at the start of a major collection
+ * we also pick the sparsest regions and evacuate all their blocks,
+ * regardless of object size, until we hit the per-collection byte limit.
+ * The emptied regions are then released by `major_free_swept_blocks ()`.
+ */
+#define MS_REGION_SIZE			((mword)ms_block_size * MS_BLOCK_ALLOC_NUM)
+#define MS_REGION_FOR_BLOCK(b)		((mword)(b) & ~(MS_REGION_SIZE - 1))
+
+static gboolean region_compaction = FALSE;
+static float region_evacuation_threshold = 0.25f;
+static size_t region_evacuation_limit = 16 * 1024 * 1024;
+static gboolean evacuate_regions;
+
+/* Empty blocks we keep out of `empty_blocks` while their region is evacuated */
+static void *region_reserved_blocks = NULL;
+static size_t num_region_reserved_blocks = 0;
+
 static gboolean lazy_sweep = TRUE;
 
 enum {
@@ -280,6 +302,8 @@ static guint64 stat_major_blocks_freed_ideal = 0;
 static guint64 stat_major_blocks_freed_less_ideal = 0;
 static guint64 stat_major_blocks_freed_individual = 0;
 static guint64 stat_major_blocks_alloced_less_ideal = 0;
+static guint64 stat_major_regions_evacuated = 0;
+static guint64 stat_major_region_bytes_evacuated = 0;
 
 #ifdef SGEN_COUNT_NUMBER_OF_MAJOR_OBJECTS_MARKED
 static guint64 num_major_objects_marked = 0;
@@ -364,7 +388,7 @@ ms_get_empty_block (void)
 		 */
 		int alloc_num = MS_BLOCK_ALLOC_NUM;
 		for (;;) {
-			p = (char *)sgen_alloc_os_memory_aligned (ms_block_size * alloc_num, ms_block_size,
+			p = (char *)sgen_alloc_os_memory_aligned (ms_block_size * alloc_num, region_compaction ? ms_block_size * alloc_num : ms_block_size,
 				(SgenAllocFlags)(SGEN_ALLOC_HEAP | SGEN_ALLOC_ACTIVATE),
 				alloc_num == 1 ? "major heap section" : NULL, MONO_MEM_ACCOUNT_SGEN_MARKSWEEP);
 			if (p)
@@ -571,6 +595,13 @@ ms_alloc_block (int size_index, gboolean pinned, gboolean has_references)
 	info->is_to_space = (sgen_get_current_collection_generation () == GENERATION_OLD) || sgen_get_concurrent_collection_in_progress ();
 	info->state = info->is_to_space ? BLOCK_STATE_MARKING : BLOCK_STATE_SWEPT;
 	SGEN_ASSERT (6, !sweep_in_progress () || info->state == BLOCK_STATE_SWEPT, "How do we add a new block to be swept while sweeping?");
+	info->is_region_evacuating = FALSE;
+	/*
+	 * Region selection goes by `nused`, which is only computed by the sweep.  New
+	 * blocks fill up with promoted objects, so treat them as full until then.
+	 */
+	if (region_compaction)
+		info->nused = count;
 	info->cardtable_mod_union = NULL;
 
 	update_heap_boundaries_for_block (info);
@@ -810,6 +841,35 @@ major_free_non_pinned_object (GCObject *obj, size_t size)
 	free_object (obj, size, FALSE);
 }
 
+/*
+ * Gives the pinned block `obj` was allocated from to the current thread, so
+ * that its next pinned allocations of the same kind don't need the GC lock.
+ * The thread's previous block goes back on the free list.  Must be called
+ * with the GC lock held.
+ */
+static void
+own_pinned_block (GCObject *obj, size_t size, gboolean has_references)
+{
+	SgenThreadInfo *info = mono_thread_info_current ();
+	int size_index = MS_BLOCK_OBJ_SIZE_INDEX (size);
+	MSBlockInfo * volatile *free_blocks = FREE_BLOCKS (TRUE, has_references);
+	MSBlockInfo *block = MS_BLOCK_FOR_OBJ (obj);
+	MSBlockInfo *old;
+
+	if (!info || !block->free_list)
+		return;
+
+	/* Sweep might be adding blocks concurrently, so we can only take the head */
+	if (free_blocks [size_index] != block || SGEN_CAS_PTR ((volatile gpointer *)&free_blocks [size_index], block->next_free, block) != block)
+		return;
+	block->next_free = NULL;
+
+	old = (MSBlockInfo *)info->pinned_alloc_block;
+	if (old)
+		add_free_block (FREE_BLOCKS (TRUE, old->has_references), MS_BLOCK_OBJ_SIZE_INDEX (old->obj_size), old);
+	info->pinned_alloc_block = block;
+}
+
 /* size is a multiple of SGEN_ALLOC_ALIGN */
 static GCObject*
 major_alloc_small_pinned_obj (GCVTable vtable, size_t size, gboolean has_references)
@@ -824,9 +884,41 @@ major_alloc_small_pinned_obj (GCVTable vtable, size_t size, gboolean has_referen
 		sgen_perform_collection (0, GENERATION_OLD, "pinned alloc failure", TRUE, TRUE);
 		res = alloc_obj (vtable, size, TRUE, has_references);
 	 }
+	 if (res)
+		own_pinned_block ((GCObject *)res, size, has_references);
 	 return (GCObject *)res;
 }
 
+/*
+ * Allocates from the thread's own pinned block, without the GC lock.  Nobody
+ * else touches the free list of an owned block while the world is running:
+ * free lists are only rebuilt by sweep, which disowns all blocks while the
+ * world is stopped, and the caller's critical region makes sure the world
+ * isn't stopped halfway through here.  An owned block always has free slots,
+ * it's disowned as soon as it's full.
+ */
+static GCObject*
+major_alloc_small_pinned_obj_local (SgenThreadInfo *info, GCVTable vtable, size_t size, gboolean has_references)
+{
+	MSBlockInfo *block = (MSBlockInfo *)info->pinned_alloc_block;
+	void **obj;
+
+	if (!block || block->obj_size != block_obj_sizes [MS_BLOCK_OBJ_SIZE_INDEX (size)] || !block->has_references != !has_references)
+		return NULL;
+
+	obj = block->free_list;
+	block->free_list = (void **)*obj;
+	if (!block->free_list)
+		info->pinned_alloc_block = NULL;
+
+	/* FIXME: assumes object layout */
+	*(GCVTable*)obj = vtable;
+
+	sgen_total_allocated_major += block->obj_size;
+
+	return (GCObject *)obj;
+}
+
 static void
 free_pinned_object (GCObject *obj, size_t size)
 {
@@ -948,35 +1040,56 @@ major_finish_sweep_checking (void)
 	SGEN_ASSERT (0, sweep_state == SWEEP_STATE_SWEPT, "How is the sweep job done but we're not swept?");
 }
 
+static void
+iterate_block_objects (MSBlockInfo *block, IterateObjectsFlags flags, IterateObjectCallbackFunc callback, void *data)
+{
+	int count = MS_BLOCK_FREE / block->obj_size;
+	int i;
+
+	if (block->pinned && !(flags & ITERATE_OBJECTS_PINNED))
+		return;
+	if (!block->pinned && !(flags & ITERATE_OBJECTS_NON_PINNED))
+		return;
+	if ((flags & ITERATE_OBJECTS_SWEEP) && lazy_sweep && !block_is_swept_or_marking (block)) {
+		sweep_block (block);
+		SGEN_ASSERT (6, block->state == BLOCK_STATE_SWEPT, "Block must be swept after sweeping");
+	}
+
+	for (i = 0; i < count; ++i) {
+		void **obj = (void**) MS_BLOCK_OBJ (block, i);
+		if (MS_OBJ_ALLOCED (obj, block))
+			callback ((GCObject*)obj, block->obj_size, data);
+	}
+}
+
 static void
 major_iterate_objects (IterateObjectsFlags flags, IterateObjectCallbackFunc callback, void *data)
 {
-	gboolean sweep = flags & ITERATE_OBJECTS_SWEEP;
-	gboolean non_pinned = flags & ITERATE_OBJECTS_NON_PINNED;
-	gboolean pinned = flags & ITERATE_OBJECTS_PINNED;
 	MSBlockInfo *block;
 
 	/* No actual sweeping will take place if we are in the middle of a major collection. */
 	major_finish_sweep_checking ();
 	FOREACH_BLOCK_NO_LOCK (block) {
-		int count = MS_BLOCK_FREE / block->obj_size;
-		int i;
+		iterate_block_objects (block, flags, callback, data);
+	} END_FOREACH_BLOCK_NO_LOCK;
+}
 
-		if (block->pinned && !pinned)
-			continue;
-		if (!block->pinned && !non_pinned)
-			continue;
-		if (sweep && lazy_sweep && !block_is_swept_or_marking (block)) {
-			sweep_block (block);
-			SGEN_ASSERT (6, block->state == BLOCK_STATE_SWEPT, "Block must be swept after sweeping");
-		}
+static guint32
+major_get_num_block_slots (void)
+{
+	major_finish_sweep_checking ();
+	return allocated_blocks.next_slot;
+}
 
-		for (i = 0; i < count; ++i) {
-			void **obj = (void**) MS_BLOCK_OBJ (block, i);
-			if (MS_OBJ_ALLOCED (obj, block))
-				callback ((GCObject*)obj, block->obj_size, data);
-		}
-	} END_FOREACH_BLOCK_NO_LOCK;
+static void
+major_iterate_block_objects (IterateObjectsFlags flags, guint32 index, IterateObjectCallbackFunc callback, void *data)
+{
+	MSBlockInfo *block;
+
+	major_finish_sweep_checking ();
+	block = BLOCK_UNTAG (*sgen_array_list_get_slot (&allocated_blocks, index));
+	if (block)
+		iterate_block_objects (block, flags, callback, data);
 }
 
 static gboolean
@@ -1156,7 +1269,7 @@ mark_mod_union_card (GCObject *obj, void **ptr, GCObject *value_obj)
 static inline gboolean
 major_block_is_evacuating (MSBlockInfo *block)
 {
-	if (evacuate_block_obj_sizes [block->obj_size_index] &&
+	if ((evacuate_block_obj_sizes [block->obj_size_index] || (evacuate_regions && block->is_region_evacuating)) &&
 			!block->has_pinned &&
 			!block->is_to_space)
 		return TRUE;
@@ -1172,6 +1285,7 @@ major_block_is_evacuating (MSBlockInfo *block)
 			if (sgen_gc_descr_has_references (desc))			\
 				GRAY_OBJECT_ENQUEUE_SERIAL ((queue), (obj), (desc)); \
 			sgen_binary_protocol_mark ((obj), (gpointer)SGEN_LOAD_VTABLE ((obj)), sgen_safe_object_get_size ((obj))); \
+			SGEN_REPORT_MARKED_OBJECT ((obj));		\
 			INC_NUM_MAJOR_OBJECTS_MARKED ();		\
 		}							\
 	} while (0)
@@ -1312,6 +1426,10 @@ static inline gboolean
 major_is_evacuating (void)
 {
 	int i;
+
+	if (evacuate_regions)
+		return TRUE;
+
 	for (i = 0; i < num_block_obj_sizes; ++i) {
 		if (evacuate_block_obj_sizes [i]) {
 			return TRUE;
@@ -1618,6 +1736,17 @@ sweep_start (void)
 			free_blocks [j] = NULL;
 	}
 
+	/*
+	 * Threads lose their pinned blocks here, since sweep is about to rebuild the
+	 * free lists they allocate from.  Sweeping then puts each such block with free
+	 * slots back on the free lists, and a thread only owns one again once it takes
+	 * it off them after a locked allocation, see own_pinned_block ().  The blocks
+	 * of threads that have since detached come back this way, too.
+	 */
+	FOREACH_THREAD_ALL (info) {
+		info->pinned_alloc_block = NULL;
+	} FOREACH_THREAD_END
+
 	sgen_workers_foreach (GENERATION_NURSERY, sgen_worker_clear_free_block_lists);
 	sgen_workers_foreach (GENERATION_OLD, sgen_worker_clear_free_block_lists);
 
@@ -1700,6 +1829,7 @@ ensure_block_is_checked_for_sweeping (guint32 block_index, gboolean wait, gboole
 	block->has_pinned = block->pinned;
 
 	block->is_to_space = FALSE;
+	block->is_region_evacuating = FALSE;
 
 	count = MS_BLOCK_FREE / block->obj_size;
 
@@ -1866,6 +1996,24 @@ sweep_finish (void)
 		used_slots_size += sweep_slots_used [i] * block_obj_sizes [i];
 	}
 
+	/*
+	 * All blocks of the evacuated regions are free now, unless something was
+	 * pinned, so they can go back into circulation next to the empty blocks.
+	 */
+	evacuate_regions = FALSE;
+	while (region_reserved_blocks) {
+		void *block = region_reserved_blocks;
+		void *empty;
+
+		region_reserved_blocks = *(void**)block;
+		do {
+			empty = empty_blocks;
+			*(void**)block = empty;
+		} while (SGEN_CAS_PTR (&empty_blocks, block, empty) != empty);
+	}
+	SGEN_ATOMIC_ADD_P (num_empty_blocks, num_region_reserved_blocks);
+	num_region_reserved_blocks = 0;
+
 	sgen_memgov_major_post_sweep (used_slots_size);
 
 	set_sweep_state (SWEEP_STATE_SWEPT, SWEEP_STATE_COMPACTING);
@@ -2078,6 +2226,175 @@ sgen_evacuation_freelist_blocks (MSBlockInfo * volatile *block_list, int size_in
 	sgen_free_internal_dynamic (evacuated_blocks, sizeof (MSBlockInfo*) * num_blocks, INTERNAL_MEM_TEMPORARY);
 }
 
+typedef struct {
+	mword start;
+	size_t used_bytes;
+	gboolean selected;
+} MSRegionInfo;
+
+static int
+region_usage_comparer (const void *r1, const void *r2)
+{
+	size_t used1 = ((const MSRegionInfo*)r1)->used_bytes;
+	size_t used2 = ((const MSRegionInfo*)r2)->used_bytes;
+
+	return used1 < used2 ? -1 : (used1 > used2 ? 1 : 0);
+}
+
+static int
+region_start_comparer (const void *r1, const void *r2)
+{
+	mword start1 = ((const MSRegionInfo*)r1)->start;
+	mword start2 = ((const MSRegionInfo*)r2)->start;
+
+	return start1 < start2 ? -1 : (start1 > start2 ? 1 : 0);
+}
+
+static MSRegionInfo*
+region_lookup (MSRegionInfo *regions, size_t num_regions, mword start)
+{
+	size_t low = 0, high = num_regions;
+
+	while (low < high) {
+		size_t mid = low + (high - low) / 2;
+		if (regions [mid].start == start)
+			return &regions [mid];
+		if (regions [mid].start < start)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	return NULL;
+}
+
+static void
+filter_region_blocks_from_free_list (MSBlockInfo * volatile *block_list)
+{
+	MSBlockInfo *info;
+	MSBlockInfo * volatile *prev = block_list;
+
+	for (info = *block_list; info != NULL; info = info->next_free) {
+		if (info->is_region_evacuating)
+			continue;
+		*prev = info;
+		prev = &info->next_free;
+	}
+	*prev = NULL;
+}
+
+/*
+ * Called with the world stopped and all blocks swept, from the start of a major
+ * collection.  Picks the sparsest regions and flags their blocks for evacuation.
+ */
+static void
+major_select_evacuation_regions (void)
+{
+	MSRegionInfo *regions;
+	MSBlockInfo *block;
+	size_t num_regions = 0, max_regions = num_major_sections;
+	size_t i, j, evacuated_bytes = 0, num_selected = 0;
+	int type, size_index;
+	void *empty, **prev;
+
+	evacuate_regions = FALSE;
+	if (!max_regions)
+		return;
+
+	regions = (MSRegionInfo*)sgen_alloc_internal_dynamic (sizeof (MSRegionInfo) * max_regions, INTERNAL_MEM_MS_BLOCK_INFO_SORT, FALSE);
+	if (!regions)
+		return;
+
+	/*
+	 * Accumulate the live bytes per region.  Pinned allocation blocks can't be
+	 * evacuated, so their regions are out of the question.
+	 */
+	FOREACH_BLOCK_NO_LOCK (block) {
+		SGEN_ASSERT (0, num_regions < max_regions, "More blocks than major sections?");
+		regions [num_regions].start = MS_REGION_FOR_BLOCK (block);
+		regions [num_regions].used_bytes = (size_t)block->nused * block->obj_size;
+		regions [num_regions].selected = !block->pinned;
+		++num_regions;
+	} END_FOREACH_BLOCK_NO_LOCK;
+
+	sgen_qsort (regions, num_regions, sizeof (MSRegionInfo), region_start_comparer);
+
+	/* Merge the entries of blocks in the same region */
+	for (i = 0, j = 0; i < num_regions; ++i) {
+		if (j > 0 && regions [j - 1].start == regions [i].start) {
+			regions [j - 1].used_bytes += regions [i].used_bytes;
+			regions [j - 1].selected &= regions [i].selected;
+		} else {
+			regions [j++] = regions [i];
+		}
+	}
+	num_regions = j;
+
+	sgen_qsort (regions, num_regions, sizeof (MSRegionInfo), region_usage_comparer);
+
+	for (i = 0; i < num_regions; ++i) {
+		MSRegionInfo *region = &regions [i];
+
+		if (!region->selected)
+			continue;
+		if (region->used_bytes >= region_evacuation_threshold * MS_REGION_SIZE ||
+				evacuated_bytes + region->used_bytes > region_evacuation_limit) {
+			region->selected = FALSE;
+			continue;
+		}
+		evacuated_bytes += region->used_bytes;
+		++num_selected;
+	}
+
+	if (!num_selected)
+		goto done;
+
+	sgen_qsort (regions, num_regions, sizeof (MSRegionInfo), region_start_comparer);
+
+	FOREACH_BLOCK_NO_LOCK (block) {
+		MSRegionInfo *region = region_lookup (regions, num_regions, MS_REGION_FOR_BLOCK (block));
+		if (region && region->selected) {
+			block->is_region_evacuating = TRUE;
+			block->is_to_space = FALSE;
+		}
+	} END_FOREACH_BLOCK_NO_LOCK;
+
+	/* Objects must not be evacuated into blocks that are being evacuated */
+	for (type = 0; type < MS_BLOCK_TYPE_MAX; ++type) {
+		if (type & MS_BLOCK_FLAG_PINNED)
+			continue;
+		for (size_index = 0; size_index < num_block_obj_sizes; ++size_index)
+			filter_region_blocks_from_free_list (&free_block_lists [type][size_index]);
+	}
+	sgen_workers_foreach (GENERATION_NURSERY, sgen_worker_clear_free_block_lists);
+	sgen_workers_foreach (GENERATION_OLD, sgen_worker_clear_free_block_lists);
+
+	/*
+	 * Nor into new blocks carved out of those regions, so hold back their empty
+	 * blocks until the sweep is done.  Nobody else can touch `empty_blocks` now.
+	 */
+	SGEN_ASSERT (0, !region_reserved_blocks, "Region blocks still reserved from the last collection?");
+	prev = &empty_blocks;
+	for (empty = empty_blocks; empty; empty = *prev) {
+		MSRegionInfo *region = region_lookup (regions, num_regions, MS_REGION_FOR_BLOCK (empty));
+		if (region && region->selected) {
+			*prev = *(void**)empty;
+			*(void**)empty = region_reserved_blocks;
+			region_reserved_blocks = empty;
+			++num_region_reserved_blocks;
+		} else {
+			prev = (void**)empty;
+		}
+	}
+	SGEN_ATOMIC_ADD_P (num_empty_blocks, -(gssize)num_region_reserved_blocks);
+
+	evacuate_regions = TRUE;
+	stat_major_regions_evacuated += num_selected;
+	stat_major_region_bytes_evacuated += evacuated_bytes;
+
+ done:
+	sgen_free_internal_dynamic (regions, sizeof (MSRegionInfo) * max_regions, INTERNAL_MEM_MS_BLOCK_INFO_SORT);
+}
+
 static void
 major_start_major_collection (void)
 {
@@ -2134,6 +2451,9 @@ major_start_major_collection (void)
 	if (lazy_sweep && !concurrent_sweep)
 		sgen_binary_protocol_sweep_end (GENERATION_OLD, TRUE);
 
+	if (region_compaction)
+		major_select_evacuation_regions ();
+
 	set_sweep_state (SWEEP_STATE_NEED_SWEEPING, SWEEP_STATE_SWEPT);
 }
 
@@ -2404,6 +2724,30 @@ major_handle_gc_param (const char *opt)
 	} else if (!strcmp (opt, "no-concurrent-sweep")) {
 		concurrent_sweep = FALSE;
 		return TRUE;
+	} else if (!strcmp (opt, "region-compaction")) {
+		region_compaction = TRUE;
+		return TRUE;
+	} else if (!strcmp (opt, "no-region-compaction")) {
+		region_compaction = FALSE;
+		return TRUE;
+	} else if (g_str_has_prefix (opt, "region-evacuation-threshold=")) {
+		const char *arg = strchr (opt, '=') + 1;
+		int percentage = atoi (arg);
+		if (percentage < 0 || percentage > 100) {
+			fprintf (stderr, "region-evacuation-threshold must be an integer in the range 0-100.\n");
+			exit (1);
+		}
+		region_evacuation_threshold = (float)percentage / 100.0f;
+		return TRUE;
+	} else if (g_str_has_prefix (opt, "region-evacuation-limit=")) {
+		const char *arg = strchr (opt, '=') + 1;
+		size_t limit;
+		if (!mono_gc_parse_environment_string_extract_number (arg, &limit)) {
+			fprintf (stderr, "region-evacuation-limit must be an integer, possibly with a k, m or a g suffix.\n");
+			exit (1);
+		}
+		region_evacuation_limit = limit;
+		return TRUE;
 	}
 
 	return FALSE;
@@ -2417,6 +2761,9 @@ major_print_gc_param_usage (void)
 			"  evacuation-threshold=P (where P is a percentage, an integer in 0-100)\n"
 			"  (no-)lazy-sweep\n"
 			"  (no-)concurrent-sweep\n"
+			"  (no-)region-compaction\n"
+			"  region-evacuation-threshold=P (where P is a percentage, an integer in 0-100)\n"
+			"  region-evacuation-limit=N (where N is an integer, possibly with a k, m or a g suffix)\n"
 			);
 }
 
@@ -2636,34 +2983,20 @@ scan_card_table_for_block (MSBlockInfo *block, CardTableScanType scan_type, Scan
 	}
 }
 
+/*
+ * Number of blocks a card table scan job claims at a time. Small enough that
+ * the dirty parts of the heap get spread over all the workers, large enough
+ * that the jobs don't contend on the shared cursor.
+ */
+#define MS_CARD_SCAN_CHUNK_BLOCKS	32
+
 static void
-major_scan_card_table (CardTableScanType scan_type, ScanCopyContext ctx, int job_index, int job_split_count, int block_count)
+major_scan_card_table_range (CardTableScanType scan_type, ScanCopyContext ctx, int first_block, int last_block, gboolean was_sweeping)
 {
 	MSBlockInfo *block;
-	gboolean has_references, was_sweeping, skip_scan;
-	int first_block, last_block, index;
-
-	/*
-	 * The last_block's index is at least (num_major_sections - 1) since we
-	 * can have nulls in the allocated_blocks list. The last worker will
-	 * scan the left-overs of the list. We expect few null entries in the
-	 * allocated_blocks list, therefore using num_major_sections for computing
-	 * block_count shouldn't affect work distribution.
-	 */
-	first_block = block_count * job_index;
-	if (job_index == job_split_count - 1)
-		last_block = allocated_blocks.next_slot;
-	else
-		last_block = block_count * (job_index + 1);
-
-	if (!concurrent_mark)
-		g_assert (scan_type == CARDTABLE_SCAN_GLOBAL);
-
-	if (scan_type != CARDTABLE_SCAN_GLOBAL)
-		SGEN_ASSERT (0, !sweep_in_progress (), "Sweep should be finished when we scan mod union card table");
-	was_sweeping = sweep_in_progress ();
+	gboolean has_references, skip_scan;
+	int index;
 
-	sgen_binary_protocol_major_card_table_scan_start (sgen_timestamp (), scan_type & CARDTABLE_SCAN_MOD_UNION);
 	FOREACH_BLOCK_RANGE_HAS_REFERENCES_NO_LOCK (block, first_block, last_block, index, has_references) {
 #ifdef PREFETCH_CARDS
 		int prefetch_index = index + 6;
@@ -2710,6 +3043,38 @@ major_scan_card_table (CardTableScanType scan_type, ScanCopyContext ctx, int job
 		if (!skip_scan)
 			scan_card_table_for_block (block, scan_type, ctx);
 	} END_FOREACH_BLOCK_RANGE_NO_LOCK;
+}
+
+static void
+major_scan_card_table (CardTableScanType scan_type, ScanCopyContext ctx, SgenCardTableScanSplit *split)
+{
+	gboolean was_sweeping;
+	int chunk;
+
+	if (!concurrent_mark)
+		g_assert (scan_type == CARDTABLE_SCAN_GLOBAL);
+
+	if (scan_type != CARDTABLE_SCAN_GLOBAL)
+		SGEN_ASSERT (0, !sweep_in_progress (), "Sweep should be finished when we scan mod union card table");
+	was_sweeping = sweep_in_progress ();
+
+	sgen_binary_protocol_major_card_table_scan_start (sgen_timestamp (), scan_type & CARDTABLE_SCAN_MOD_UNION);
+	/*
+	 * Keep claiming chunks until we're past the end of allocated_blocks. The
+	 * end is read again for every chunk, so chunks claimed late also cover
+	 * blocks appended while the scan was running.
+	 */
+	for (;;) {
+		int first_block, last_block;
+		int next_slot = (int)allocated_blocks.next_slot;
+
+		chunk = sgen_card_table_scan_split_claim (split);
+		first_block = chunk * MS_CARD_SCAN_CHUNK_BLOCKS;
+		if (first_block >= next_slot)
+			break;
+		last_block = MIN (first_block + MS_CARD_SCAN_CHUNK_BLOCKS, next_slot);
+		major_scan_card_table_range (scan_type, ctx, first_block, last_block, was_sweeping);
+	}
 	sgen_binary_protocol_major_card_table_scan_end (sgen_timestamp (), scan_type & CARDTABLE_SCAN_MOD_UNION);
 }
 
@@ -2869,6 +3234,8 @@ sgen_marksweep_init_internal (SgenMajorCollector *collector, gboolean is_concurr
 	mono_counters_register ("# major blocks freed less ideally", MONO_COUNTER_GC | MONO_COUNTER_ULONG, &stat_major_blocks_freed_less_ideal);
 	mono_counters_register ("# major blocks freed individually", MONO_COUNTER_GC | MONO_COUNTER_ULONG, &stat_major_blocks_freed_individual);
 	mono_counters_register ("# major blocks allocated less ideally", MONO_COUNTER_GC | MONO_COUNTER_ULONG, &stat_major_blocks_alloced_less_ideal);
+	mono_counters_register ("# major regions evacuated", MONO_COUNTER_GC | MONO_COUNTER_ULONG, &stat_major_regions_evacuated);
+	mono_counters_register ("# major region bytes evacuated", MONO_COUNTER_GC | MONO_COUNTER_ULONG, &stat_major_region_bytes_evacuated);
 
 	collector->section_size = ms_block_size;
 
@@ -2881,12 +3248,15 @@ sgen_marksweep_init_internal (SgenMajorCollector *collector, gboolean is_concurr
 	collector->alloc_heap = major_alloc_heap;
 	collector->is_object_live = major_is_object_live;
 	collector->alloc_small_pinned_obj = major_alloc_small_pinned_obj;
+	collector->alloc_small_pinned_obj_local = major_alloc_small_pinned_obj_local;
 	collector->alloc_degraded = major_alloc_degraded;
 
 	collector->alloc_object = major_alloc_object;
 	collector->alloc_object_par = major_alloc_object_par;
 	collector->free_pinned_object = free_pinned_object;
 	collector->iterate_objects = major_iterate_objects;
+	collector->get_num_block_slots = major_get_num_block_slots;
+	collector->iterate_block_objects = major_iterate_block_objects;
 	collector->free_non_pinned_object = major_free_non_pinned_object;
 	collector->pin_objects = major_pin_objects;
 	collector->pin_major_object = pin_major_object;
@@ -3002,6 +3372,13 @@ sgen_marksweep_init (SgenMajorCollector *collector)
 	sgen_marksweep_init_internal (collector, FALSE, FALSE);
 }
 
+void
+sgen_marksweep_regions_init (SgenMajorCollector *collector)
+{
+	sgen_marksweep_init_internal (collector, FALSE, FALSE);
+	region_compaction = TRUE;
+}
+
 #ifndef DISABLE_SGEN_MAJOR_MARKSWEEP_CONC
 void
 sgen_marksweep_conc_init (SgenMajorCollector *collector)
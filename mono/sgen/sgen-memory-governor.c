@@ -73,6 +73,23 @@ static mword last_used_slots_size = 0;
 
 static mword sgen_memgov_available_free_space (void);
 
+/*
+ * Pause time target, in SGEN_TV units, or 0 if we don't have one. With a
+ * target set we keep decaying averages of the nursery and major pauses and
+ * use them to steer the nursery size, the major collection trigger and the
+ * number of workers doing concurrent marking.
+ */
+static gint64 pause_target = 0;
+static gint64 minor_pause_avg = 0;
+static gint64 major_pause_avg = 0;
+/* Scales the allowance from the heap growth ratio, between PAUSE_MIN_ALLOWANCE_FACTOR and 1 */
+static double pause_allowance_factor = 1.0;
+static int pause_concurrent_workers = 1;
+
+#define PAUSE_AVERAGE_WEIGHT		0.25
+#define PAUSE_MIN_ALLOWANCE_FACTOR	0.25
+#define PAUSE_AVERAGE(avg,sample)	((avg) ? (gint64)((avg) * (1 - PAUSE_AVERAGE_WEIGHT) + (sample) * PAUSE_AVERAGE_WEIGHT) : (sample))
+
 
 /* GC trigger heuristics. */
 
@@ -98,6 +115,13 @@ sgen_memgov_calculate_minor_collection_allowance (void)
 
 	allowance = MAX (allowance_target, MIN_MINOR_COLLECTION_ALLOWANCE);
 
+	/*
+	 * Less heap growth between major collections means less to mark and sweep, and
+	 * for the concurrent collector less mutator work to catch up on when finishing.
+	 */
+	if (pause_target)
+		allowance = MAX ((mword)(allowance * pause_allowance_factor), MIN_MINOR_COLLECTION_ALLOWANCE);
+
 	/*
 	 * For the concurrent collector, we decrease the allowance relative to the memory
 	 * growth during the M&S phase, survival rate of the collection and the allowance
@@ -284,6 +308,7 @@ sgen_memgov_major_collection_end (gboolean forced, gboolean concurrent, const ch
 	total_allocated_major_end = sgen_total_allocated_major;
 	if (forced) {
 		sgen_get_major_collector ()->finish_sweeping ();
+		sgen_los_finish_sweep ();
 		sgen_memgov_calculate_minor_collection_allowance ();
 	}
 }
@@ -346,9 +371,77 @@ sgen_output_log_entry (SgenLogEntry *entry, gint64 stw_time, int generation)
 	}
 }
 
+static void
+update_pause_target_tuning (int generation, gint64 stw_time)
+{
+	if (generation == GENERATION_NURSERY) {
+		minor_pause_avg = PAUSE_AVERAGE (minor_pause_avg, stw_time);
+		return;
+	}
+
+	/*
+	 * The pause starting a concurrent collection only scans the roots, it doesn't
+	 * tell us anything about the finishing pause.
+	 */
+	if (sgen_get_concurrent_collection_in_progress ())
+		return;
+
+	major_pause_avg = PAUSE_AVERAGE (major_pause_avg, stw_time);
+	if (major_pause_avg > pause_target) {
+		pause_allowance_factor = MAX (pause_allowance_factor * 0.75, PAUSE_MIN_ALLOWANCE_FACTOR);
+		if (pause_concurrent_workers < sgen_workers_get_num_workers (GENERATION_OLD))
+			pause_concurrent_workers++;
+	} else if (major_pause_avg < pause_target / 2) {
+		pause_allowance_factor = MIN (pause_allowance_factor * 1.25, 1.0);
+		if (pause_concurrent_workers > 1)
+			pause_concurrent_workers--;
+	}
+
+	if (debug_print_allowance)
+		SGEN_LOG (0, "Pause target: major pause average %.2fms, allowance factor %.2f, concurrent workers %d",
+				major_pause_avg / 10000.0f, pause_allowance_factor, pause_concurrent_workers);
+}
+
+void
+sgen_memgov_set_pause_target (int target_ms)
+{
+	pause_target = (gint64)target_ms * 10000;
+}
+
+gboolean
+sgen_memgov_has_pause_target (void)
+{
+	return pause_target != 0;
+}
+
+/*
+ * Called at the end of a nursery collection, with its duration so far.  We
+ * shrink the nursery when we're over the target and only let it grow when
+ * we're comfortably below, so it settles somewhere in between.
+ */
+void
+sgen_memgov_resize_nursery_for_pause_target (gint64 duration)
+{
+	gint64 estimate = minor_pause_avg ? (minor_pause_avg + duration) / 2 : duration;
+
+	if (estimate > pause_target)
+		sgen_resize_nursery (TRUE);
+	else if (estimate < pause_target / 2)
+		sgen_resize_nursery (FALSE);
+}
+
+int
+sgen_memgov_get_concurrent_mark_workers (void)
+{
+	return pause_target ? pause_concurrent_workers : 1;
+}
+
 void
 sgen_memgov_collection_end (int generation, gint64 stw_time)
 {
+	if (pause_target)
+		update_pause_target_tuning (generation, stw_time);
+
 	/*
 	 * At this moment the world has been restarted which means we can log all pending entries
 	 * without risking deadlocks.
@@ -27,6 +27,12 @@ void sgen_memgov_collection_end (int generation, gint64 stw);
 
 gboolean sgen_need_major_collection (mword space_needed, gboolean *forced);
 
+/* Pause time target tuning */
+void sgen_memgov_set_pause_target (int target_ms);
+gboolean sgen_memgov_has_pause_target (void);
+void sgen_memgov_resize_nursery_for_pause_target (gint64 duration);
+int sgen_memgov_get_concurrent_mark_workers (void);
+
 
 typedef enum {
 	SGEN_ALLOC_INTERNAL = 0,
@@ -56,6 +56,7 @@
 #include "mono/sgen/sgen-pinning.h"
 #include "mono/sgen/sgen-client.h"
 #include "mono/utils/mono-membar.h"
+#include "mono/utils/mono-numa.h"
 
 /* Enable it so nursery allocation diagnostic data is collected */
 //#define NALLOC_DEBUG 1
@@ -63,6 +64,22 @@
 /* The mutator allocs from here. */
 static SgenFragmentAllocator mutator_allocator;
 
+/*
+ * With NUMA enabled the nursery is made of granules that are assigned to the
+ * nodes round robin, so any prefix of the nursery is spread evenly.  No
+ * fragment crosses a granule boundary, which lets TLABs be handed out from
+ * fragments on the allocating thread's node first.
+ */
+#define NURSERY_NUMA_GRANULE	(256 * 1024)
+
+static int nursery_numa_nodes = 1;
+
+static int
+nursery_numa_node_for_address (char *addr)
+{
+	return (int)(((mword)(addr - sgen_nursery_start) / NURSERY_NUMA_GRANULE) % nursery_numa_nodes);
+}
+
 /* freeelist of fragment structures */
 static SgenFragment *fragment_freelist = NULL;
 
@@ -93,6 +110,7 @@ static mword stat_wasted_bytes_discarded_fragments = 0;
 static guint64 stat_nursery_alloc_requests = 0;
 static guint64 stat_alloc_iterations = 0;
 static guint64 stat_alloc_retries = 0;
+static guint64 stat_alloc_quick_fits = 0;
 
 static guint64 stat_nursery_alloc_range_requests = 0;
 static guint64 stat_alloc_range_iterations = 0;
@@ -238,6 +256,97 @@ get_mark (gpointer n)
 	return (uintptr_t)n & 0x1;
 }
 
+/*
+ * Fragments are also binned by size class, so that allocation doesn't have
+ * to walk past all the small holes pinning leaves at the front of the list.
+ * The bins are just starting points into the alloc list: fragments only ever
+ * shrink between collections, so a fragment that doesn't have 2^i bytes free
+ * won't have them later either, and every walk moves the hint for its bin
+ * past the fragments that have dropped below.  Walking on from a fragment
+ * that has been removed from the list concurrently is fine, as its `next`
+ * still leads to the rest of the list.
+ *
+ * A request is first tried against the first fragment of the next larger
+ * bin, which is guaranteed to fit it if it still has that much free, before
+ * doing a first fit walk starting at its own bin.
+ */
+
+/* floor (log2 (size)), `size` must not be 0 */
+static inline int
+fragment_size_bin (size_t size)
+{
+#ifdef __GNUC__
+	return (int)(sizeof (unsigned long long) * 8 - __builtin_clzll ((unsigned long long)size) - 1);
+#else
+	int bin = -1;
+	while (size) {
+		++bin;
+		size >>= 1;
+	}
+	return bin;
+#endif
+}
+
+static inline size_t
+fragment_free_size (SgenFragment *frag)
+{
+	return frag->fragment_end - frag->fragment_next;
+}
+
+/*
+ * Returns the first fragment on the alloc list that has at least 2^bin
+ * bytes free, or NULL if there is none.
+ */
+static SgenFragment*
+fragment_bin_head (SgenFragmentAllocator *allocator, int bin)
+{
+	SgenFragment *hint, *frag;
+
+	if (bin >= SGEN_FRAGMENT_SIZE_BINS)
+		return NULL;
+
+	hint = frag = allocator->size_bins [bin];
+	while (frag && fragment_free_size (frag) < ((size_t)1 << bin))
+		frag = (SgenFragment *)unmask (frag->next);
+
+	/* Losing the race just leaves the hint further back, so no need to retry */
+	if (frag != hint)
+		mono_atomic_cas_ptr ((volatile gpointer*)&allocator->size_bins [bin], frag, hint);
+	return frag;
+}
+
+/* Returns a fragment that can satisfy a `size` request without further searching, or NULL. */
+static SgenFragment*
+fragment_quick_fit (SgenFragmentAllocator *allocator, size_t size)
+{
+	SgenFragment *frag = fragment_bin_head (allocator, size > 1 ? fragment_size_bin (size - 1) + 1 : 0);
+
+	if (!frag || frag->fragment_next >= (sgen_nursery_start + sgen_nursery_size))
+		return NULL;
+	return frag;
+}
+
+/*MUST be called with world stopped*/
+static void
+fragment_bins_rebuild (SgenFragmentAllocator *allocator)
+{
+	SgenFragment *frag;
+	int filled = -1;
+
+	memset (allocator->size_bins, 0, sizeof (allocator->size_bins));
+
+	for (frag = (SgenFragment *)unmask (allocator->alloc_head); frag; frag = (SgenFragment *)unmask (frag->next)) {
+		size_t size = fragment_free_size (frag);
+		int bin;
+
+		if (!size)
+			continue;
+		bin = fragment_size_bin (size);
+		while (filled < bin)
+			allocator->size_bins [++filled] = frag;
+	}
+}
+
 /*MUST be called with world stopped*/
 SgenFragment*
 sgen_fragment_allocator_alloc (void)
@@ -257,6 +366,7 @@ void
 sgen_fragment_allocator_add (SgenFragmentAllocator *allocator, char *start, char *end)
 {
 	SgenFragment *fragment;
+	int bin;
 
 	fragment = sgen_fragment_allocator_alloc ();
 	fragment->fragment_start = start;
@@ -266,6 +376,10 @@ sgen_fragment_allocator_add (SgenFragmentAllocator *allocator, char *start, char
 
 	allocator->region_head = allocator->alloc_head = fragment;
 	g_assert (fragment->fragment_end > fragment->fragment_start);
+
+	/* The new fragment comes first, so it's the head of every bin it is large enough for */
+	for (bin = fragment_size_bin (end - start); bin >= 0; --bin)
+		allocator->size_bins [bin] = fragment;
 }
 
 void
@@ -281,6 +395,7 @@ sgen_fragment_allocator_release (SgenFragmentAllocator *allocator)
 	last->next_in_order = fragment_freelist;
 	fragment_freelist = allocator->region_head;
 	allocator->alloc_head = allocator->region_head = NULL;
+	memset (allocator->size_bins, 0, sizeof (allocator->size_bins));
 }
 
 static SgenFragment**
@@ -443,7 +558,21 @@ sgen_fragment_allocator_par_alloc (SgenFragmentAllocator *allocator, size_t size
 #endif
 
 restart:
-	for (frag = (SgenFragment *)unmask (allocator->alloc_head); unmask (frag); frag = (SgenFragment *)unmask (frag->next)) {
+	frag = fragment_quick_fit (allocator, size);
+	if (frag) {
+		void *p = par_alloc_from_fragment (allocator, frag, size);
+		if (!p) {
+			HEAVY_STAT (++stat_alloc_retries);
+			goto restart;
+		}
+		HEAVY_STAT (++stat_alloc_quick_fits);
+#ifdef NALLOC_DEBUG
+		add_alloc_record (p, size, FIXED_ALLOC);
+#endif
+		return p;
+	}
+
+	for (frag = fragment_bin_head (allocator, fragment_size_bin (size)); frag; frag = (SgenFragment *)unmask (frag->next)) {
 		size_t frag_size = frag->fragment_end - frag->fragment_next;
 
 		if (frag->fragment_next >= (sgen_nursery_start + sgen_nursery_size))
@@ -517,8 +646,9 @@ sgen_fragment_allocator_serial_range_alloc (SgenFragmentAllocator *allocator, si
 	return NULL;
 }
 
-void*
-sgen_fragment_allocator_par_range_alloc (SgenFragmentAllocator *allocator, size_t desired_size, size_t minimum_size, size_t *out_alloc_size)
+/* A `node` of -1 means fragments on any NUMA node can be used. */
+static void*
+par_range_alloc (SgenFragmentAllocator *allocator, size_t desired_size, size_t minimum_size, size_t *out_alloc_size, int node)
 {
 	SgenFragment *frag, *min_frag;
 	size_t current_minimum;
@@ -531,12 +661,32 @@ restart:
 	mono_atomic_inc_i32 (&alloc_count);
 #endif
 
-	for (frag = (SgenFragment *)unmask (allocator->alloc_head); frag; frag = (SgenFragment *)unmask (frag->next)) {
+	frag = fragment_quick_fit (allocator, desired_size);
+	if (frag && (node < 0 || nursery_numa_node_for_address (frag->fragment_start) == node)) {
+		void *p;
+		*out_alloc_size = desired_size;
+
+		p = par_alloc_from_fragment (allocator, frag, desired_size);
+		if (!p) {
+			HEAVY_STAT (++stat_alloc_range_retries);
+			goto restart;
+		}
+		HEAVY_STAT (++stat_alloc_quick_fits);
+#ifdef NALLOC_DEBUG
+		add_alloc_record (p, desired_size, RANGE_ALLOC);
+#endif
+		return p;
+	}
+
+	for (frag = fragment_bin_head (allocator, fragment_size_bin (minimum_size)); frag; frag = (SgenFragment *)unmask (frag->next)) {
 		size_t frag_size = frag->fragment_end - frag->fragment_next;
 
 		if (frag->fragment_next >= (sgen_nursery_start + sgen_nursery_size))
 			continue;
 
+		if (node >= 0 && nursery_numa_node_for_address (frag->fragment_start) != node)
+			continue;
+
 		HEAVY_STAT (++stat_alloc_range_iterations);
 
 		if (desired_size <= frag_size) {
@@ -588,6 +738,12 @@ restart:
 	return NULL;
 }
 
+void*
+sgen_fragment_allocator_par_range_alloc (SgenFragmentAllocator *allocator, size_t desired_size, size_t minimum_size, size_t *out_alloc_size)
+{
+	return par_range_alloc (allocator, desired_size, minimum_size, out_alloc_size, -1);
+}
+
 void
 sgen_clear_allocator_fragments (SgenFragmentAllocator *allocator)
 {
@@ -702,6 +858,15 @@ add_nursery_frag_checks (SgenFragmentAllocator *allocator, char *frag_start, cha
 {
 	char *nursery_limit = sgen_nursery_start + sgen_nursery_size;
 
+	if (nursery_numa_nodes > 1) {
+		char *granule_end;
+
+		while (frag_end > (granule_end = sgen_nursery_start + SGEN_ALIGN_DOWN_TO ((mword)(frag_start - sgen_nursery_start) + NURSERY_NUMA_GRANULE, NURSERY_NUMA_GRANULE))) {
+			add_nursery_frag_checks (allocator, frag_start, granule_end);
+			frag_start = granule_end;
+		}
+	}
+
 	if (frag_start < nursery_limit && frag_end > nursery_limit) {
 		add_nursery_frag (allocator, nursery_limit - frag_start, frag_start, nursery_limit);
 		add_nursery_frag (allocator, frag_end - nursery_limit, nursery_limit, frag_end);
@@ -793,6 +958,8 @@ sgen_build_nursery_fragments (GCMemSection *nursery_section, SgenGrayQueue *unpi
 	/*The collector might want to do something with the final nursery fragment list.*/
 	sgen_minor_collector.build_fragments_finish (&mutator_allocator);
 
+	fragment_bins_rebuild (&mutator_allocator);
+
 	if (!unmask (mutator_allocator.alloc_head)) {
 		SGEN_LOG (1, "Nursery fully pinned");
 		for (pin_entry = pin_start; pin_entry < pin_end; ++pin_entry) {
@@ -820,7 +987,7 @@ sgen_can_alloc_size (size_t size)
 
 	size = SGEN_ALIGN_UP (size);
 
-	for (frag = (SgenFragment *)unmask (mutator_allocator.alloc_head); frag; frag = (SgenFragment *)unmask (frag->next)) {
+	for (frag = fragment_bin_head (&mutator_allocator, fragment_size_bin (size)); frag; frag = (SgenFragment *)unmask (frag->next)) {
 		if ((size_t)(frag->fragment_end - frag->fragment_next) >= size)
 			return TRUE;
 	}
@@ -847,6 +1014,12 @@ sgen_nursery_alloc_range (size_t desired_size, size_t minimum_size, size_t *out_
 
 	HEAVY_STAT (++stat_nursery_alloc_range_requests);
 
+	if (nursery_numa_nodes > 1) {
+		void *p = par_range_alloc (&mutator_allocator, desired_size, minimum_size, out_alloc_size, mono_numa_get_current_node ());
+		if (p)
+			return p;
+	}
+
 	return sgen_fragment_allocator_par_range_alloc (&mutator_allocator, desired_size, minimum_size, out_alloc_size);
 }
 
@@ -864,6 +1037,7 @@ sgen_nursery_allocator_init_heavy_stats (void)
 	mono_counters_register ("# nursery alloc requests", MONO_COUNTER_GC | MONO_COUNTER_ULONG, &stat_nursery_alloc_requests);
 	mono_counters_register ("# nursery alloc iterations", MONO_COUNTER_GC | MONO_COUNTER_ULONG, &stat_alloc_iterations);
 	mono_counters_register ("# nursery alloc retries", MONO_COUNTER_GC | MONO_COUNTER_ULONG, &stat_alloc_retries);
+	mono_counters_register ("# nursery alloc quick fits", MONO_COUNTER_GC | MONO_COUNTER_ULONG, &stat_alloc_quick_fits);
 
 	mono_counters_register ("# nursery alloc range requests", MONO_COUNTER_GC | MONO_COUNTER_ULONG, &stat_nursery_alloc_range_requests);
 	mono_counters_register ("# nursery alloc range iterations", MONO_COUNTER_GC | MONO_COUNTER_ULONG, &stat_alloc_range_iterations);
@@ -915,6 +1089,14 @@ sgen_nursery_allocator_set_nursery_bounds (char *start, size_t min_size, size_t
 	sgen_space_bitmap_size = (sgen_nursery_end - sgen_nursery_start + SGEN_TO_SPACE_GRANULE_IN_BYTES * 8 - 1) / (SGEN_TO_SPACE_GRANULE_IN_BYTES * 8);
 	sgen_space_bitmap = (char *)g_malloc0 (sgen_space_bitmap_size);
 
+	if (sgen_numa_enabled && max_size >= NURSERY_NUMA_GRANULE * 2) {
+		char *granule;
+
+		nursery_numa_nodes = mono_numa_get_node_count ();
+		for (granule = sgen_nursery_start; granule < sgen_nursery_end; granule += NURSERY_NUMA_GRANULE)
+			mono_numa_set_preferred_node (granule, NURSERY_NUMA_GRANULE, nursery_numa_node_for_address (granule));
+	}
+
 	/* Setup the single first large fragment */
 	sgen_minor_collector.init_nursery (&mutator_allocator, sgen_nursery_start, sgen_nursery_end);
 }
@@ -53,6 +53,9 @@ struct _BinaryProtocolBuffer {
 
 static BinaryProtocolBuffer * volatile binary_protocol_buffers = NULL;
 
+static SgenRecentEvent recent_events [SGEN_RECENT_EVENTS_SIZE];
+static volatile gint32 recent_events_next = 0;
+
 static char* filename_or_prefix = NULL;
 static int current_file_index = 0;
 static long long current_file_size = 0;
@@ -156,6 +159,47 @@ sgen_binary_protocol_is_enabled (void)
 	return binary_protocol_file != invalid_file_value;
 }
 
+/*
+ * Events are recorded by the thread doing the collection, so there is no
+ * contention on the index.  Entries are overwritten in place once the ring
+ * wraps around.
+ */
+void
+sgen_recent_event (SgenRecentEventKind kind, int generation, gint64 value)
+{
+	guint32 index = (guint32)mono_atomic_inc_i32 (&recent_events_next) - 1;
+	SgenRecentEvent *event = &recent_events [index & (SGEN_RECENT_EVENTS_SIZE - 1)];
+
+	event->timestamp = sgen_timestamp ();
+	event->value = value;
+	event->kind = kind;
+	event->generation = generation;
+}
+
+/*
+ * Copies up to `max_events` of the most recent events, oldest first, and
+ * returns how many were copied.  This doesn't take any locks, so it can be
+ * used from a crash handler, at the price of possibly seeing an event that
+ * is being written.
+ */
+int
+sgen_recent_events_copy (SgenRecentEvent *events, int max_events)
+{
+	guint32 next = (guint32)recent_events_next;
+	guint32 count = MIN (next, SGEN_RECENT_EVENTS_SIZE);
+	guint32 i;
+
+	if (max_events <= 0)
+		return 0;
+	if (count > (guint32)max_events)
+		count = (guint32)max_events;
+
+	for (i = 0; i < count; i++)
+		events [i] = recent_events [(next - count + i) & (SGEN_RECENT_EVENTS_SIZE - 1)];
+
+	return (int)count;
+}
+
 static void
 close_binary_protocol_file (void)
 {
@@ -174,6 +174,36 @@ gboolean sgen_binary_protocol_is_enabled (void);
 
 gboolean sgen_binary_protocol_flush_buffers (gboolean force);
 
+/*
+ * Unlike the binary protocol, the recent events ring is always on.  It keeps
+ * the last SGEN_RECENT_EVENTS_SIZE compact events in memory, so that latency
+ * spikes can be looked at after the fact, or after a crash.  Times are in
+ * 100ns ticks, timestamps are relative to the initialization of the GC.
+ */
+typedef enum {
+	SGEN_RECENT_PAUSE_BEGIN,
+	/* `value` is the length of the pause */
+	SGEN_RECENT_PAUSE_END,
+	/* `value` is the time spent in the phase */
+	SGEN_RECENT_PHASE_PINNING,
+	SGEN_RECENT_PHASE_SCAN_ROOTS,
+	SGEN_RECENT_PHASE_FINISH_GRAY_STACK,
+	SGEN_RECENT_PHASE_SWEEP,
+	/* `value` is a count */
+	SGEN_RECENT_BYTES_PROMOTED,
+	SGEN_RECENT_OBJECTS_PINNED
+} SgenRecentEventKind;
+
+typedef struct {
+	gint64 timestamp;
+	gint64 value;
+	gint32 kind;
+	gint32 generation;
+} SgenRecentEvent;
+
+void sgen_recent_event (SgenRecentEventKind kind, int generation, gint64 value);
+int sgen_recent_events_copy (SgenRecentEvent *events, int max_events);
+
 #define BEGIN_PROTOCOL_ENTRY0(method) \
 	void sgen_ ## method (void);
 #define BEGIN_PROTOCOL_ENTRY1(method,t1,f1) \
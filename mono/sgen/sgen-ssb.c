@@ -0,0 +1,324 @@
+/**
+ * \file
+ * Sequential store buffer remembered set.
+ *
+ * Reference stores into the old generation are recorded by appending the
+ * address of the slot to a buffer owned by the storing thread, instead of
+ * marking a shared card byte.  At the start of a nursery collection the
+ * buffers are scanned precisely, slot by slot.
+ *
+ * The card table stays in place underneath: bulk copies like value type and
+ * object copies, whose reference layout isn't known here, as well as global
+ * remsets, still mark cards, and store buffers that fill up are spilled onto
+ * the cards.  Everything that marks cards, including AOT code compiled with
+ * inline card barriers, therefore remains correct.
+ *
+ * Only slots in the major heap or LOS are ever dereferenced by the collector.
+ * Slots outside the heap boundaries, like stack slots and native memory, take
+ * the card marking path right away.  The slots within the boundaries are
+ * checked against the major blocks and LOS objects before the scan, and the
+ * ones in neither are moved onto the cards instead, where a slot whose frame
+ * or buffer is gone is harmless.
+ *
+ * The buffers are only ever appended to by their thread and consumed by the
+ * collector while the world is stopped.  The thread owns `store_remset_next`,
+ * the collector only advances `store_remset_scanned`, so no locking is needed
+ * on either side.
+ *
+ * Licensed under the MIT license. See LICENSE file in the project root for full license information.
+ */
+
+#include "config.h"
+#ifdef HAVE_SGEN_GC
+
+#include <string.h>
+
+#include "mono/sgen/sgen-gc.h"
+#include "mono/sgen/sgen-cardtable.h"
+#include "mono/sgen/sgen-ssb.h"
+#include "mono/sgen/sgen-protocol.h"
+#include "mono/sgen/sgen-client.h"
+#include "mono/utils/mono-memory-model.h"
+
+#define STORE_REMSET_BUFFER_ENTRIES	1024
+#define STORE_REMSET_BUFFER_SIZE	(STORE_REMSET_BUFFER_ENTRIES * sizeof (gpointer))
+
+static SgenRememberedSet cardtable_remset;
+
+#ifdef HEAVY_STATISTICS
+static guint64 stat_store_remset_spills = 0;
+static guint64 stat_store_remset_scanned = 0;
+#endif
+
+/*
+ * Moves the unscanned entries of the thread's buffer onto the card table
+ * and starts over at the beginning of the buffer.  The collector can stop
+ * us anywhere in here: entries it consumes in the meantime are either
+ * already on the cards or will be, so at worst they are scanned twice.
+ */
+static void
+spill_store_buffer (SgenThreadInfo *info)
+{
+	gpointer *p, *end;
+
+	if (!info->store_remset_buffer) {
+		info->store_remset_buffer = (gpointer *)sgen_alloc_internal_dynamic (STORE_REMSET_BUFFER_SIZE, INTERNAL_MEM_STORE_REMSET, TRUE);
+		info->store_remset_scanned = info->store_remset_buffer;
+		info->store_remset_next = info->store_remset_buffer;
+		mono_memory_write_barrier ();
+		info->store_remset_end = info->store_remset_buffer + STORE_REMSET_BUFFER_ENTRIES;
+		return;
+	}
+
+	HEAVY_STAT (++stat_store_remset_spills);
+
+	end = info->store_remset_next;
+	for (p = info->store_remset_scanned; p < end; ++p) {
+		if (*p)
+			sgen_card_table_mark_address ((mword)*p);
+	}
+
+	/* `next` first, so the collector never sees a range covering stale entries */
+	info->store_remset_next = info->store_remset_buffer;
+	mono_memory_write_barrier ();
+	info->store_remset_scanned = info->store_remset_buffer;
+}
+
+static inline void
+record_slot (gpointer slot)
+{
+	SgenThreadInfo *info = mono_thread_info_current ();
+	gpointer *next;
+
+	if (G_UNLIKELY (!info || !sgen_ptr_in_heap_boundaries (slot))) {
+		sgen_card_table_mark_address ((mword)slot);
+		return;
+	}
+
+	if (G_UNLIKELY (info->store_remset_next == info->store_remset_end))
+		spill_store_buffer (info);
+
+	next = info->store_remset_next;
+	*next = slot;
+	/* The entry must be visible before the collector can see it in range */
+	mono_memory_write_barrier ();
+	info->store_remset_next = next + 1;
+}
+
+static void
+sgen_ssb_wbarrier_set_field (GCObject *obj, gpointer field_ptr, GCObject* value)
+{
+	*(void**)field_ptr = value;
+	if (sgen_ptr_in_nursery (value) && !sgen_ptr_in_nursery (field_ptr))
+		record_slot (field_ptr);
+	sgen_dummy_use (value);
+}
+
+static void
+sgen_ssb_wbarrier_arrayref_copy (gpointer dest_ptr, gpointer src_ptr, int count)
+{
+	gpointer *dest = (gpointer *)dest_ptr;
+	gpointer *src = (gpointer *)src_ptr;
+	gboolean record = !sgen_ptr_in_nursery (dest);
+
+	/*overlapping that required backward copying*/
+	if (src < dest && (src + count) > dest) {
+		gpointer *start = dest;
+		dest += count - 1;
+		src += count - 1;
+
+		for (; dest >= start; --src, --dest) {
+			gpointer value = *src;
+			SGEN_UPDATE_REFERENCE_ALLOW_NULL (dest, value);
+			if (record && sgen_ptr_in_nursery (value))
+				record_slot (dest);
+			sgen_dummy_use (value);
+		}
+	} else {
+		gpointer *end = dest + count;
+		for (; dest < end; ++src, ++dest) {
+			gpointer value = *src;
+			SGEN_UPDATE_REFERENCE_ALLOW_NULL (dest, value);
+			if (record && sgen_ptr_in_nursery (value))
+				record_slot (dest);
+			sgen_dummy_use (value);
+		}
+	}
+}
+
+static void
+sgen_ssb_wbarrier_generic_nostore (gpointer ptr)
+{
+	if (sgen_ptr_in_nursery (*(gpointer*)ptr) && !sgen_ptr_in_nursery (ptr))
+		record_slot (ptr);
+}
+
+typedef struct {
+	mword start, end;
+} HeapRange;
+
+/* The major blocks and LOS objects with references, only used while the world is stopped */
+static HeapRange *heap_ranges;
+static size_t num_heap_ranges, heap_ranges_capacity;
+
+static void
+add_heap_range (mword start, mword size)
+{
+	if (num_heap_ranges == heap_ranges_capacity) {
+		size_t new_capacity = heap_ranges_capacity ? heap_ranges_capacity * 2 : 1024;
+		HeapRange *new_ranges = (HeapRange *)sgen_alloc_internal_dynamic (new_capacity * sizeof (HeapRange), INTERNAL_MEM_STORE_REMSET, TRUE);
+		if (heap_ranges) {
+			memcpy (new_ranges, heap_ranges, num_heap_ranges * sizeof (HeapRange));
+			sgen_free_internal_dynamic (heap_ranges, heap_ranges_capacity * sizeof (HeapRange), INTERNAL_MEM_STORE_REMSET);
+		}
+		heap_ranges = new_ranges;
+		heap_ranges_capacity = new_capacity;
+	}
+	heap_ranges [num_heap_ranges].start = start;
+	heap_ranges [num_heap_ranges].end = start + size;
+	++num_heap_ranges;
+}
+
+static int
+compare_heap_ranges (const void *a, const void *b)
+{
+	mword sa = ((const HeapRange *)a)->start;
+	mword sb = ((const HeapRange *)b)->start;
+	return sa < sb ? -1 : sa > sb ? 1 : 0;
+}
+
+static gboolean
+slot_in_heap_ranges (gpointer slot)
+{
+	size_t lo = 0, hi = num_heap_ranges;
+
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		if ((mword)slot < heap_ranges [mid].start)
+			hi = mid;
+		else if ((mword)slot >= heap_ranges [mid].end)
+			lo = mid + 1;
+		else
+			return TRUE;
+	}
+	return FALSE;
+}
+
+/*
+ * Moves the recorded slots that are not in a major block or LOS object onto
+ * the cards, before the card table is prepared for scanning, and clears them
+ * in the buffer so the scan never dereferences them.
+ */
+static void
+sgen_ssb_start_scan_remsets (void)
+{
+	num_heap_ranges = 0;
+	sgen_major_collector_iterate_block_ranges (add_heap_range);
+	sgen_los_iterate_live_block_ranges (add_heap_range);
+	qsort (heap_ranges, num_heap_ranges, sizeof (HeapRange), compare_heap_ranges);
+
+	FOREACH_THREAD_ALL (info) {
+		gpointer *p, *end = info->store_remset_next;
+
+		for (p = info->store_remset_scanned; p < end; ++p) {
+			if (!slot_in_heap_ranges (*p)) {
+				sgen_card_table_mark_address ((mword)*p);
+				*p = NULL;
+			}
+		}
+	} FOREACH_THREAD_END
+
+	cardtable_remset.start_scan_remsets ();
+}
+
+static void
+sgen_ssb_scan_remsets (ScanCopyContext ctx)
+{
+	ScanPtrFieldFunc scan_field_func = ctx.ops->scan_ptr_field;
+
+	FOREACH_THREAD_ALL (info) {
+		gpointer *p, *end = info->store_remset_next;
+
+		for (p = info->store_remset_scanned; p < end; ++p) {
+			GCObject **slot = (GCObject **)*p;
+			/* Cleared by sgen_ssb_start_scan_remsets (), or overwritten since */
+			if (slot && sgen_ptr_in_nursery (*slot))
+				scan_field_func (NULL, slot, ctx.queue);
+		}
+		HEAVY_STAT (stat_store_remset_scanned += end - info->store_remset_scanned);
+		info->store_remset_scanned = end;
+	} FOREACH_THREAD_END
+}
+
+static void
+sgen_ssb_clear_cards (void)
+{
+	cardtable_remset.clear_cards ();
+
+	FOREACH_THREAD_ALL (info) {
+		info->store_remset_scanned = info->store_remset_next;
+	} FOREACH_THREAD_END
+}
+
+static void
+sgen_ssb_spill_to_cards (void)
+{
+	FOREACH_THREAD_ALL (info) {
+		if (info->store_remset_buffer)
+			spill_store_buffer (info);
+	} FOREACH_THREAD_END
+}
+
+static gboolean
+sgen_ssb_find_address (char *addr)
+{
+	gboolean found = FALSE;
+
+	if (cardtable_remset.find_address (addr))
+		return TRUE;
+
+	FOREACH_THREAD_ALL (info) {
+		gpointer *p;
+		for (p = info->store_remset_scanned; p < info->store_remset_next; ++p) {
+			if (*p == addr)
+				found = TRUE;
+		}
+	} FOREACH_THREAD_END
+
+	return found;
+}
+
+void
+sgen_ssb_thread_detach (SgenThreadInfo *info)
+{
+	if (!info->store_remset_buffer)
+		return;
+
+	spill_store_buffer (info);
+	sgen_free_internal_dynamic (info->store_remset_buffer, STORE_REMSET_BUFFER_SIZE, INTERNAL_MEM_STORE_REMSET);
+	info->store_remset_buffer = info->store_remset_next = info->store_remset_scanned = info->store_remset_end = NULL;
+}
+
+void
+sgen_ssb_init (SgenRememberedSet *remset)
+{
+	sgen_card_table_init (&cardtable_remset);
+	sgen_card_table_set_inline_barriers (FALSE);
+
+	*remset = cardtable_remset;
+	remset->wbarrier_set_field = sgen_ssb_wbarrier_set_field;
+	remset->wbarrier_arrayref_copy = sgen_ssb_wbarrier_arrayref_copy;
+	remset->wbarrier_generic_nostore = sgen_ssb_wbarrier_generic_nostore;
+	remset->start_scan_remsets = sgen_ssb_start_scan_remsets;
+	remset->scan_remsets = sgen_ssb_scan_remsets;
+	remset->clear_cards = sgen_ssb_clear_cards;
+	remset->spill_to_cards = sgen_ssb_spill_to_cards;
+	remset->find_address = sgen_ssb_find_address;
+
+#ifdef HEAVY_STATISTICS
+	mono_counters_register ("Store remset spills", MONO_COUNTER_GC | MONO_COUNTER_ULONG, &stat_store_remset_spills);
+	mono_counters_register ("Store remset entries scanned", MONO_COUNTER_GC | MONO_COUNTER_ULONG, &stat_store_remset_scanned);
+#endif
+}
+
+#endif /*HAVE_SGEN_GC*/
@@ -0,0 +1,13 @@
+/**
+ * \file
+ * Sequential store buffer remembered set.
+ *
+ * Licensed under the MIT license. See LICENSE file in the project root for full license information.
+ */
+#ifndef __MONO_SGEN_SSB_H__
+#define __MONO_SGEN_SSB_H__
+
+void sgen_ssb_init (SgenRememberedSet *remset);
+void sgen_ssb_thread_detach (SgenThreadInfo *info);
+
+#endif
@@ -20,8 +20,8 @@ static mono_cond_t work_cond;
 static mono_cond_t done_cond;
 
 static int threads_num;
-static MonoNativeThreadId threads [SGEN_THREADPOOL_MAX_NUM_THREADS];
-static int threads_context [SGEN_THREADPOOL_MAX_NUM_THREADS];
+static MonoNativeThreadId threads [SGEN_THREADPOOL_MAX_NUM_THREADS + SGEN_THREADPOOL_MAX_NUM_DEDICATED_THREADS];
+static int threads_context [SGEN_THREADPOOL_MAX_NUM_THREADS + SGEN_THREADPOOL_MAX_NUM_DEDICATED_THREADS];
 
 static volatile gboolean threadpool_shutdown;
 static volatile int threads_finished;
@@ -73,6 +73,18 @@ remove_job (SgenThreadPoolContext *context, SgenThreadPoolJob *job)
 	sgen_thread_pool_job_free (job);
 }
 
+static gboolean
+context_has_thread (SgenThreadPoolContext *context, int worker_index)
+{
+	return worker_index >= context->first_thread && worker_index < context->first_thread + context->num_threads;
+}
+
+static void*
+context_thread_data (SgenThreadPoolContext *context, int worker_index)
+{
+	return (context->thread_datas) ? context->thread_datas [worker_index - context->first_thread] : NULL;
+}
+
 static gboolean
 continue_idle_job (SgenThreadPoolContext *context, void *thread_data)
 {
@@ -102,9 +114,9 @@ has_priority_work (int worker_index, int current_context)
 		SgenThreadPoolContext *context = &pool_contexts [i];
 		void *thread_data;
 
-		if (worker_index >= context->num_threads)
+		if (!context_has_thread (context, worker_index))
 			continue;
-		thread_data = (context->thread_datas) ? context->thread_datas [worker_index] : NULL;
+		thread_data = context_thread_data (context, worker_index);
 		if (!should_work (context, thread_data))
 			continue;
 		if (context->job_queue.next_slot > 0)
@@ -134,9 +146,9 @@ get_work (int worker_index, int *work_context, int *do_idle, SgenThreadPoolJob *
 			SgenThreadPoolContext *context = &pool_contexts [i];
 			void *thread_data;
 
-			if (worker_index >= context->num_threads)
+			if (!context_has_thread (context, worker_index))
 				continue;
-			thread_data = (context->thread_datas) ? context->thread_datas [worker_index] : NULL;
+			thread_data = context_thread_data (context, worker_index);
 
 			if (!should_work (context, thread_data))
 				continue;
@@ -176,11 +188,11 @@ thread_func (void *data)
 	sgen_client_thread_register_worker ();
 
 	for (current_context = 0; current_context < contexts_num; current_context++) {
-		if (worker_index >= pool_contexts [current_context].num_threads ||
+		if (!context_has_thread (&pool_contexts [current_context], worker_index) ||
 				!pool_contexts [current_context].thread_init_func)
-			break;
+			continue;
 
-		thread_data = (pool_contexts [current_context].thread_datas) ? pool_contexts [current_context].thread_datas [worker_index] : NULL;
+		thread_data = context_thread_data (&pool_contexts [current_context], worker_index);
 		pool_contexts [current_context].thread_init_func (thread_data);
 	}
 
@@ -198,7 +210,7 @@ thread_func (void *data)
 
 		if (!threadpool_shutdown) {
 			context = &pool_contexts [current_context];
-			thread_data = (context->thread_datas) ? context->thread_datas [worker_index] : NULL;
+			thread_data = context_thread_data (context, worker_index);
 		}
 
 		mono_os_mutex_unlock (&lock);
@@ -256,6 +268,8 @@ sgen_thread_pool_create_context (int num_threads, SgenThreadPoolThreadInitFunc i
 	SGEN_ASSERT (0, num_threads <= SGEN_THREADPOOL_MAX_NUM_THREADS, "Maximum sgen thread pool threads exceeded");
 
 	pool_contexts [context_id].num_threads = num_threads;
+	pool_contexts [context_id].first_thread = 0;
+	pool_contexts [context_id].dedicated = FALSE;
 
 	sgen_pointer_queue_init (&pool_contexts [contexts_num].job_queue, 0);
 
@@ -264,15 +278,33 @@ sgen_thread_pool_create_context (int num_threads, SgenThreadPoolThreadInitFunc i
 	return context_id;
 }
 
+int
+sgen_thread_pool_create_dedicated_context (void)
+{
+	int context_id = sgen_thread_pool_create_context (1, NULL, NULL, NULL, NULL, NULL);
+
+	/* Its thread is allocated after the shared ones, in sgen_thread_pool_start () */
+	pool_contexts [context_id].dedicated = TRUE;
+
+	return context_id;
+}
+
 void
 sgen_thread_pool_start (void)
 {
 	int i;
 
 	for (i = 0; i < contexts_num; i++) {
-		if (threads_num < pool_contexts [i].num_threads)
+		if (!pool_contexts [i].dedicated && threads_num < pool_contexts [i].num_threads)
 			threads_num = pool_contexts [i].num_threads;
 	}
+	for (i = 0; i < contexts_num; i++) {
+		if (!pool_contexts [i].dedicated)
+			continue;
+		SGEN_ASSERT (0, threads_num + pool_contexts [i].num_threads <= SGEN_THREADPOOL_MAX_NUM_THREADS + SGEN_THREADPOOL_MAX_NUM_DEDICATED_THREADS, "Maximum sgen thread pool dedicated threads exceeded");
+		pool_contexts [i].first_thread = threads_num;
+		threads_num += pool_contexts [i].num_threads;
+	}
 
 	if (!threads_num)
 		return;
@@ -14,7 +14,9 @@
 #include "mono/utils/mono-threads.h"
 
 #define SGEN_THREADPOOL_MAX_NUM_THREADS 8
-#define SGEN_THREADPOOL_MAX_NUM_CONTEXTS 3
+/* Threads of the contexts which don't share them with the other contexts */
+#define SGEN_THREADPOOL_MAX_NUM_DEDICATED_THREADS 2
+#define SGEN_THREADPOOL_MAX_NUM_CONTEXTS 4
 
 typedef struct _SgenThreadPoolJob SgenThreadPoolJob;
 typedef struct _SgenThreadPoolContext SgenThreadPoolContext;
@@ -44,10 +46,15 @@ struct _SgenThreadPoolContext {
 
 	void **thread_datas;
 	int num_threads;
+	/* The threads of the context are `first_thread` to `first_thread + num_threads - 1` */
+	int first_thread;
+	gboolean dedicated;
 };
 
 
 int sgen_thread_pool_create_context (int num_threads, SgenThreadPoolThreadInitFunc init_func, SgenThreadPoolIdleJobFunc idle_func, SgenThreadPoolContinueIdleJobFunc continue_idle_func, SgenThreadPoolShouldWorkFunc should_work_func, void **thread_datas);
+/* A context for jobs only, whose thread doesn't run the jobs of other contexts */
+int sgen_thread_pool_create_dedicated_context (void);
 void sgen_thread_pool_start (void);
 
 void sgen_thread_pool_shutdown (void);
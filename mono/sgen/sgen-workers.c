@@ -19,6 +19,7 @@
 #include "mono/sgen/sgen-workers.h"
 #include "mono/sgen/sgen-thread-pool.h"
 #include "mono/utils/mono-membar.h"
+#include "mono/utils/mono-numa.h"
 #include "mono/sgen/sgen-client.h"
 
 #ifndef DISABLE_SGEN_MAJOR_MARKSWEEP_CONC
@@ -218,7 +219,7 @@ workers_steal_work (WorkerData *data)
 	int generation = sgen_get_current_collection_generation ();
 	GrayQueueSection *section = NULL;
 	WorkerContext *context = data->context;
-	int i, current_worker;
+	int i, current_worker, busiest_worker, busiest_sections;
 
 	if ((generation == GENERATION_OLD && !major->is_parallel) ||
 			(generation == GENERATION_NURSERY && !minor->is_parallel))
@@ -229,6 +230,27 @@ workers_steal_work (WorkerData *data)
 
 	current_worker = (int) (data - context->workers_data);
 
+	/*
+	 * Try the worker with the longest queue first, it is the one most likely
+	 * to hold up the end of the collection. The section counts are read racily,
+	 * which is fine since this is only a hint.
+	 */
+	busiest_worker = -1;
+	busiest_sections = 1;
+	for (i = 1; i < context->active_workers_num; i++) {
+		int steal_worker = (current_worker + i) % context->active_workers_num;
+		int num_sections;
+		if (!state_is_working_or_enqueued (context->workers_data [steal_worker].state))
+			continue;
+		num_sections = context->workers_data [steal_worker].private_gray_queue.num_sections;
+		if (num_sections > busiest_sections) {
+			busiest_worker = steal_worker;
+			busiest_sections = num_sections;
+		}
+	}
+	if (busiest_worker >= 0)
+		section = sgen_gray_object_steal_section (&context->workers_data [busiest_worker].private_gray_queue);
+
 	for (i = 1; i < context->active_workers_num && !section; i++) {
 		int steal_worker = (current_worker + i) % context->active_workers_num;
 		if (state_is_working_or_enqueued (context->workers_data [steal_worker].state))
@@ -273,6 +295,14 @@ thread_pool_init_func (void *data_untyped)
 
 	init_private_gray_queue (data);
 
+	/*
+	 * Spread the workers over the NUMA nodes. Together with the per worker
+	 * free block lists this keeps the major blocks a worker promotes into
+	 * local to it.
+	 */
+	if (sgen_numa_enabled)
+		mono_numa_bind_current_thread ((int)(data - data->context->workers_data) % mono_numa_get_node_count ());
+
 	/* Separate WorkerData for same thread share free_block_lists */
 	if (major->is_parallel || minor->is_parallel)
 		major->init_block_free_lists (&data->free_block_lists);
@@ -496,6 +526,26 @@ sgen_workers_start_all_workers (int generation, SgenObjectOperations *object_ops
 	mono_os_mutex_unlock (&context->finished_lock);
 }
 
+/*
+ * Wakes up the workers of a started cycle that have run out of work, so
+ * that `callback` gets to enqueue more work when they finish again.  This
+ * must be called with the world stopped.
+ */
+void
+sgen_workers_restart_finished_workers (int generation, SgenWorkersFinishCallback callback)
+{
+	WorkerContext *context = &worker_contexts [generation];
+
+	SGEN_ASSERT (0, context->started, "Why are we restarting workers that were never started?");
+	SGEN_ASSERT (0, !sgen_workers_are_working (context), "Why are we restarting workers that are still working?");
+
+	mono_os_mutex_lock (&context->finished_lock);
+	context->finish_callback = callback;
+	context->worker_awakenings = 0;
+	sgen_workers_ensure_awake (context);
+	mono_os_mutex_unlock (&context->finished_lock);
+}
+
 void
 sgen_workers_join (int generation)
 {
@@ -593,6 +643,12 @@ sgen_workers_get_job_split_count (int generation)
 	return (worker_contexts [generation].active_workers_num > 1) ? worker_contexts [generation].active_workers_num * 4 : 1;
 }
 
+int
+sgen_workers_get_num_workers (int generation)
+{
+	return worker_contexts [generation].workers_num;
+}
+
 void
 sgen_workers_foreach (int generation, SgenWorkerCallback callback)
 {
@@ -651,6 +707,12 @@ sgen_workers_get_job_split_count (int generation)
 	return 1;
 }
 
+int
+sgen_workers_get_num_workers (int generation)
+{
+	return 0;
+}
+
 gboolean
 sgen_workers_have_idle_work (int generation)
 {
@@ -683,6 +745,11 @@ sgen_workers_stop_all_workers (int generation)
 {
 }
 
+void
+sgen_workers_restart_finished_workers (int generation, SgenWorkersFinishCallback callback)
+{
+}
+
 void
 sgen_workers_take_from_queue (int generation, SgenGrayQueue *queue)
 {
@@ -79,6 +79,7 @@ void sgen_workers_create_context (int generation, int num_workers);
 void sgen_workers_stop_all_workers (int generation);
 void sgen_workers_set_num_active_workers (int generation, int num_workers);
 void sgen_workers_start_all_workers (int generation, SgenObjectOperations *object_ops_nopar, SgenObjectOperations *object_ops_par, SgenWorkersFinishCallback finish_job);
+void sgen_workers_restart_finished_workers (int generation, SgenWorkersFinishCallback callback);
 void sgen_workers_enqueue_job (int generation, SgenThreadPoolJob *job, gboolean enqueue);
 void sgen_workers_join (int generation);
 gboolean sgen_workers_have_idle_work (int generation);
@@ -87,6 +88,7 @@ void sgen_workers_assert_gray_queue_is_empty (int generation);
 void sgen_workers_take_from_queue (int generation, SgenGrayQueue *queue);
 SgenObjectOperations* sgen_workers_get_idle_func_object_ops (WorkerData *worker);
 int sgen_workers_get_job_split_count (int generation);
+int sgen_workers_get_num_workers (int generation);
 void sgen_workers_foreach (int generation, SgenWorkerCallback callback);
 gboolean sgen_workers_is_worker_thread (MonoNativeThreadId id);
 
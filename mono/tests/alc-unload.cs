@@ -0,0 +1,65 @@
+using System;
+using System.Reflection;
+using System.Runtime.CompilerServices;
+using System.Threading;
+
+//
+// Loads this assembly into a collectible AssemblyLoadContext, runs code from
+// it, unloads the context and checks that it goes away, and that the code of
+// the default context keeps working once the code of the collectible one is
+// released.  Skipped on profiles without AssemblyLoadContext.
+//
+
+class Tests {
+	static int calls;
+
+	public static int Work (int n) {
+		int sum = 0;
+		for (int i = 0; i < n; ++i)
+			sum += i;
+		Interlocked.Increment (ref calls);
+		return sum;
+	}
+
+	[MethodImpl (MethodImplOptions.NoInlining)]
+	static WeakReference LoadAndUnload (Type alc_type) {
+		object alc = Activator.CreateInstance (alc_type, new object [] { "alc-unload", true });
+		var asm = (Assembly) alc_type.GetMethod ("LoadFromAssemblyPath").Invoke (alc, new object [] { typeof (Tests).Assembly.Location });
+
+		MethodInfo work = asm.GetType ("Tests").GetMethod ("Work");
+		for (int i = 0; i < 100; ++i) {
+			if ((int) work.Invoke (null, new object [] { 10 }) != 45)
+				throw new Exception ("Work () in the collectible context failed");
+		}
+
+		alc_type.GetMethod ("Unload").Invoke (alc, null);
+		return new WeakReference (alc);
+	}
+
+	static int Main () {
+		Type alc_type = Type.GetType ("System.Runtime.Loader.AssemblyLoadContext");
+		if (alc_type == null || alc_type.GetConstructor (new Type [] { typeof (string), typeof (bool) }) == null)
+			return 0;
+
+		// Done on another thread so no stale stack slot keeps the context alive
+		WeakReference wr = null;
+		var t = new Thread (() => { wr = LoadAndUnload (alc_type); });
+		t.Start ();
+		t.Join ();
+
+		// The code is released over several collections, see mono_alc_check_unused ()
+		for (int gc = 0; gc < 10; ++gc) {
+			GC.Collect ();
+			GC.WaitForPendingFinalizers ();
+		}
+
+		if (wr.IsAlive) {
+			Console.WriteLine ("The collectible context wasn't collected");
+			return 1;
+		}
+
+		if (Work (10) != 45)
+			return 2;
+		return 0;
+	}
+}
@@ -0,0 +1,52 @@
+using System;
+
+//
+// Clones of large arrays of primitive types are allocated without clearing
+// their elements first, check that every element is copied even when the
+// memory previously held other data.
+//
+
+struct WithRef {
+	public int i;
+	public object o;
+}
+
+class Tests {
+	static int Main () {
+		for (int iter = 0; iter < 20; ++iter) {
+			// Fill the large object space with garbage the clones can reuse
+			byte[] garbage = new byte [100000];
+			for (int i = 0; i < garbage.Length; ++i)
+				garbage [i] = 0xff;
+			garbage = null;
+			GC.Collect ();
+
+			byte[] bytes = new byte [70000];
+			bytes [1] = 1;
+			bytes [bytes.Length - 1] = 2;
+			byte[] bytes_clone = (byte[]) bytes.Clone ();
+			for (int i = 0; i < bytes.Length; ++i) {
+				if (bytes_clone [i] != bytes [i])
+					return 1;
+			}
+
+			double[] doubles = new double [10000];
+			for (int i = 0; i < doubles.Length; ++i)
+				doubles [i] = i * 0.5;
+			double[] doubles_clone = (double[]) doubles.Clone ();
+			for (int i = 0; i < doubles.Length; ++i) {
+				if (doubles_clone [i] != i * 0.5)
+					return 2;
+			}
+
+			// Elements with references are always cleared
+			WithRef[] refs = new WithRef [5000];
+			refs [10].o = "a";
+			WithRef[] refs_clone = (WithRef[]) refs.Clone ();
+			if ((string) refs_clone [10].o != "a" || refs_clone [11].o != null)
+				return 3;
+		}
+
+		return 0;
+	}
+}
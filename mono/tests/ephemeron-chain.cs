@@ -0,0 +1,55 @@
+using System;
+using System.Runtime.CompilerServices;
+using System.Threading;
+
+//
+// ConditionalWeakTable entries whose keys only become reachable through the
+// values of other entries, which the GC has to find in several ephemeron rounds.
+//
+
+class Node {
+	public int id;
+	public Node (int id) { this.id = id; }
+}
+
+class Tests {
+	const int count = 20000;
+
+	static ConditionalWeakTable<Node, Node> table = new ConditionalWeakTable<Node, Node> ();
+	static Node root;
+
+	static void Fill () {
+		Node[] nodes = new Node [count + 1];
+		for (int i = 0; i <= count; ++i)
+			nodes [i] = new Node (i);
+
+		// Added in reverse so each GC ephemeron round uncovers a single key
+		for (int i = count - 1; i >= 0; --i)
+			table.Add (nodes [i], nodes [i + 1]);
+		root = nodes [0];
+	}
+
+	static int Main () {
+		// Done on another thread so no stale stack slot keeps the keys alive
+		var t = new Thread (Fill);
+		t.Start ();
+		t.Join ();
+
+		for (int gc = 0; gc < 3; ++gc) {
+			GC.Collect ();
+			GC.WaitForPendingFinalizers ();
+
+			Node node = root;
+			for (int i = 0; i < count; ++i) {
+				Node next;
+				if (!table.TryGetValue (node, out next))
+					return 1;
+				if (next.id != i + 1)
+					return 2;
+				node = next;
+			}
+		}
+
+		return 0;
+	}
+}
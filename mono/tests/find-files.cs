@@ -0,0 +1,70 @@
+using System;
+using System.IO;
+using System.Linq;
+
+//
+// Directory enumeration, which reads the directory as the entries are
+// consumed instead of collecting and sorting them up front.
+//
+
+class Tests {
+	static string[] Names (string[] paths) {
+		return paths.Select (p => Path.GetFileName (p)).OrderBy (n => n, StringComparer.Ordinal).ToArray ();
+	}
+
+	static bool Same (string[] a, params string[] b) {
+		return a.SequenceEqual (b);
+	}
+
+	static int Main () {
+		string dir = Path.Combine (Path.GetTempPath (), "find-files-" + Guid.NewGuid ().ToString ("N"));
+		Directory.CreateDirectory (dir);
+
+		try {
+			foreach (string name in new string [] { "a.cs", "b.cs", "c.txt", "noext", ".hidden" })
+				File.WriteAllText (Path.Combine (dir, name), name);
+			Directory.CreateDirectory (Path.Combine (dir, "sub.d"));
+
+			if (!Same (Names (Directory.GetFiles (dir, "*.cs")), "a.cs", "b.cs"))
+				return 1;
+			if (!Same (Names (Directory.GetFiles (dir, "?.txt")), "c.txt"))
+				return 2;
+			// '*.*' also matches the entries without an extension
+			if (!Same (Names (Directory.GetFiles (dir, "*.*")), ".hidden", "a.cs", "b.cs", "c.txt", "noext"))
+				return 3;
+			if (!Same (Names (Directory.GetDirectories (dir)), "sub.d"))
+				return 4;
+			if (Directory.GetFiles (dir, "*.none").Length != 0)
+				return 5;
+
+			var info = new DirectoryInfo (dir);
+			foreach (FileSystemInfo entry in info.EnumerateFileSystemInfos ()) {
+				bool is_dir = (entry.Attributes & FileAttributes.Directory) != 0;
+				if (is_dir != (entry.Name == "sub.d"))
+					return 6;
+				if (((entry.Attributes & FileAttributes.Hidden) != 0) != (entry.Name == ".hidden"))
+					return 7;
+			}
+
+			// A large directory, enumerated lazily
+			string big = Path.Combine (dir, "big");
+			Directory.CreateDirectory (big);
+			for (int i = 0; i < 5000; ++i)
+				File.WriteAllText (Path.Combine (big, i + ".dat"), "");
+			if (Directory.EnumerateFiles (big, "*.dat").Count () != 5000)
+				return 8;
+			if (Directory.EnumerateFiles (big).First () == null)
+				return 9;
+		} finally {
+			Directory.Delete (dir, true);
+		}
+
+		try {
+			Directory.GetFiles (Path.Combine (dir, "missing"));
+			return 10;
+		} catch (DirectoryNotFoundException) {
+		}
+
+		return 0;
+	}
+}
@@ -0,0 +1,119 @@
+using System;
+using System.Reflection;
+
+//
+// MethodInfo.Invoke () on the methods which are called through the cached
+// reflection invoke wrappers instead of mono_runtime_invoke_array ().
+//
+
+struct Counter {
+	public int count;
+
+	public int Increment (int by) {
+		count += by;
+		return count;
+	}
+}
+
+class Base {
+	public virtual string Name () {
+		return "base";
+	}
+}
+
+class Derived : Base {
+	public override string Name () {
+		return "derived";
+	}
+}
+
+class Tests {
+	static int Add (int a, long b) {
+		return (int) (a + b);
+	}
+
+	static void Swap (ref int a, ref string b, out double c) {
+		a = a * 2;
+		b = b + "!";
+		c = 1.5;
+	}
+
+	static int OrDefault (int? val) {
+		return val ?? -1;
+	}
+
+	static Counter MakeCounter (int count) {
+		return new Counter { count = count };
+	}
+
+	static T Identity<T> (T val) {
+		return val;
+	}
+
+	static void Throw () {
+		throw new InvalidOperationException ();
+	}
+
+	static int Main () {
+		Type t = typeof (Tests);
+		BindingFlags flags = BindingFlags.Static | BindingFlags.NonPublic;
+
+		// Called more than once so the cached wrapper is used too
+		for (int i = 0; i < 2; ++i) {
+			if ((int) t.GetMethod ("Add", flags).Invoke (null, new object [] { 1, 2L }) != 3)
+				return 1;
+
+			// null value type arguments are passed as zero
+			if ((int) t.GetMethod ("Add", flags).Invoke (null, new object [] { null, 5L }) != 5)
+				return 2;
+		}
+
+		object[] args = new object [] { 21, "a", null };
+		t.GetMethod ("Swap", flags).Invoke (null, args);
+		if ((int) args [0] != 42 || (string) args [1] != "a!" || (double) args [2] != 1.5)
+			return 3;
+
+		MethodInfo or_default = t.GetMethod ("OrDefault", flags);
+		if ((int) or_default.Invoke (null, new object [] { null }) != -1)
+			return 4;
+		if ((int) or_default.Invoke (null, new object [] { 7 }) != 7)
+			return 5;
+
+		object counter = new Counter ();
+		MethodInfo increment = typeof (Counter).GetMethod ("Increment");
+		increment.Invoke (counter, new object [] { 2 });
+		if ((int) increment.Invoke (counter, new object [] { 3 }) != 5 || ((Counter) counter).count != 5)
+			return 6;
+
+		if (((Counter) t.GetMethod ("MakeCounter", flags).Invoke (null, new object [] { 9 })).count != 9)
+			return 7;
+
+		if ((string) typeof (Base).GetMethod ("Name").Invoke (new Derived (), null) != "derived")
+			return 8;
+
+		if ((string) t.GetMethod ("Identity", flags).MakeGenericMethod (typeof (string)).Invoke (null, new object [] { "x" }) != "x")
+			return 9;
+
+		try {
+			t.GetMethod ("Throw", flags).Invoke (null, null);
+			return 10;
+		} catch (TargetInvocationException e) {
+			if (!(e.InnerException is InvalidOperationException))
+				return 11;
+		}
+
+		try {
+			t.GetMethod ("Add", flags).Invoke (null, new object [] { 1 });
+			return 12;
+		} catch (TargetParameterCountException) {
+		}
+
+		try {
+			increment.Invoke (null, new object [] { 1 });
+			return 13;
+		} catch (TargetException) {
+		}
+
+		return 0;
+	}
+}
@@ -0,0 +1,49 @@
+using System;
+using System.Runtime.InteropServices;
+
+//
+// Large strings created by the runtime from native text, which are
+// allocated without clearing the characters first.
+//
+
+class Tests {
+	static bool Check (string s, int length, char first) {
+		if (s.Length != length)
+			return false;
+		for (int i = 0; i < length; ++i) {
+			if (s [i] != (char) (first + i % 26))
+				return false;
+		}
+		return true;
+	}
+
+	static int Main () {
+		foreach (int length in new int [] { 10, 5000, 100000 }) {
+			IntPtr uni = Marshal.AllocHGlobal ((length + 1) * 2);
+			IntPtr ansi = Marshal.AllocHGlobal (length + 1);
+			try {
+				for (int i = 0; i < length; ++i) {
+					Marshal.WriteInt16 (uni, i * 2, (short) ('a' + i % 26));
+					Marshal.WriteByte (ansi, i, (byte) ('A' + i % 26));
+				}
+				Marshal.WriteInt16 (uni, length * 2, 0);
+				Marshal.WriteByte (ansi, length, 0);
+
+				// Allocated repeatedly so the memory of the previous ones gets reused
+				for (int n = 0; n < 3; ++n) {
+					if (!Check (Marshal.PtrToStringUni (uni), length, 'a'))
+						return 1;
+					if (!Check (Marshal.PtrToStringUni (uni, length), length, 'a'))
+						return 2;
+					if (!Check (Marshal.PtrToStringAnsi (ansi), length, 'A'))
+						return 3;
+					GC.Collect ();
+				}
+			} finally {
+				Marshal.FreeHGlobal (uni);
+				Marshal.FreeHGlobal (ansi);
+			}
+		}
+		return 0;
+	}
+}
@@ -0,0 +1,75 @@
+using System;
+using System.Runtime.CompilerServices;
+
+/*
+ * Run with --tiered so that calls and loop back edges tier methods up while
+ * they are running, the results must not change across the switch.
+ */
+class Base {
+	public virtual int Get (int i) {
+		return i;
+	}
+}
+
+class Derived : Base {
+	public override int Get (int i) {
+		return i * 2;
+	}
+}
+
+class Tests {
+	[MethodImplAttribute (MethodImplOptions.NoInlining)]
+	static int Add (int a, int b) {
+		return a + b;
+	}
+
+	[MethodImplAttribute (MethodImplOptions.NoInlining)]
+	static long Loop (int n) {
+		long sum = 0;
+		for (int i = 0; i < n; ++i)
+			sum += i;
+		return sum;
+	}
+
+	[MethodImplAttribute (MethodImplOptions.NoInlining)]
+	static int LoopWithFinally (int n) {
+		int count = 0, finallies = 0;
+		for (int i = 0; i < n; ++i) {
+			try {
+				count ++;
+			} finally {
+				finallies ++;
+			}
+		}
+		return count == finallies ? count : -1;
+	}
+
+	[MethodImplAttribute (MethodImplOptions.NoInlining)]
+	static int Virtual (Base b, int n) {
+		int sum = 0;
+		for (int i = 0; i < n; ++i)
+			sum += b.Get (1);
+		return sum;
+	}
+
+	public static int Main () {
+		int sum = 0;
+		for (int i = 0; i < 10000; ++i)
+			sum = Add (sum, 1);
+		if (sum != 10000)
+			return 1;
+
+		if (Loop (100000) != 4999950000L)
+			return 2;
+
+		if (LoopWithFinally (100000) != 100000)
+			return 3;
+
+		if (Virtual (new Base (), 1000) != 1000)
+			return 4;
+		if (Virtual (new Derived (), 1000) != 2000)
+			return 5;
+
+		return 0;
+	}
+}
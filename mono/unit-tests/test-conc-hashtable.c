@@ -11,6 +11,7 @@
 #include "utils/mono-threads.h"
 #include "utils/mono-conc-hashtable.h"
 #include "utils/checked-build.h"
+#include "utils/atomic.h"
 #include "metadata/w32handle.h"
 
 #include <stdlib.h>
@@ -279,6 +280,124 @@ parallel_writer_parallel_reader (void)
 	return res;
 }
 
+#define STRESS_THREADS 4
+#define STRESS_KEYS 5000
+
+static gpointer stress_winners [STRESS_KEYS + 1];
+static volatile int stress_running;
+
+/* Every thread inserts the same keys without external locking, exactly one insert must win each key */
+static void*
+pw_same_keys_thread (void *arg)
+{
+	int i, fails = 0;
+	mono_thread_info_attach ();
+
+	for (i = 1; i <= STRESS_KEYS; ++i) {
+		gpointer value = GINT_TO_POINTER (i * 16 + GPOINTER_TO_INT (arg));
+		gpointer old = mono_conc_hashtable_insert (hash, GINT_TO_POINTER (i), value);
+
+		if (!old) {
+			if (mono_atomic_cas_ptr (&stress_winners [i], value, NULL) != NULL)
+				++fails;
+		} else if (GPOINTER_TO_INT (old) / 16 != i) {
+			++fails;
+		}
+	}
+	return GINT_TO_POINTER (fails);
+}
+
+/* Inserts and removes its own range of keys while the others force resizes */
+static void*
+pw_insert_remove_thread (void *arg)
+{
+	int i, round, fails = 0, idx = 100000 * GPOINTER_TO_INT (arg);
+	mono_thread_info_attach ();
+
+	for (round = 0; round < 10; ++round) {
+		for (i = idx; i < idx + 1000; ++i) {
+			if (mono_conc_hashtable_insert (hash, GINT_TO_POINTER (i), GINT_TO_POINTER (i)))
+				++fails;
+			if (mono_conc_hashtable_lookup (hash, GINT_TO_POINTER (i)) != GINT_TO_POINTER (i))
+				++fails;
+		}
+		for (i = idx; i < idx + 1000; ++i) {
+			if (mono_conc_hashtable_remove (hash, GINT_TO_POINTER (i)) != GINT_TO_POINTER (i))
+				++fails;
+			if (mono_conc_hashtable_lookup (hash, GINT_TO_POINTER (i)))
+				++fails;
+		}
+	}
+	return GINT_TO_POINTER (fails);
+}
+
+static void*
+pw_stress_reader_thread (void *arg)
+{
+	int i, fails = 0;
+	mono_thread_info_attach ();
+
+	while (stress_running) {
+		for (i = 1; i <= STRESS_KEYS; ++i) {
+			gpointer value = mono_conc_hashtable_lookup (hash, GINT_TO_POINTER (i));
+			if (value && GPOINTER_TO_INT (value) / 16 != i)
+				++fails;
+		}
+	}
+	return GINT_TO_POINTER (fails);
+}
+
+static gboolean
+stress_equal (gconstpointer a, gconstpointer b)
+{
+	return a == b;
+}
+
+static int
+unlocked_parallel_writer_parallel_reader (GEqualFunc equal_func)
+{
+	pthread_t writers [STRESS_THREADS], readers [2];
+	gpointer ret;
+	int i, res = 0;
+
+	memset (stress_winners, 0, sizeof (stress_winners));
+	hash = mono_conc_hashtable_new (NULL, equal_func);
+	stress_running = 1;
+
+	for (i = 0; i < 2; ++i)
+		pthread_create (&readers [i], NULL, pw_stress_reader_thread, NULL);
+
+	for (i = 0; i < STRESS_THREADS; ++i)
+		pthread_create (&writers [i], NULL, pw_same_keys_thread, GINT_TO_POINTER (i));
+	for (i = 0; i < STRESS_THREADS; ++i) {
+		pthread_join (writers [i], &ret);
+		res += GPOINTER_TO_INT (ret);
+	}
+
+	for (i = 0; i < STRESS_THREADS; ++i)
+		pthread_create (&writers [i], NULL, pw_insert_remove_thread, GINT_TO_POINTER (i + 1));
+	for (i = 0; i < STRESS_THREADS; ++i) {
+		pthread_join (writers [i], &ret);
+		res += GPOINTER_TO_INT (ret);
+	}
+
+	stress_running = 0;
+	for (i = 0; i < 2; ++i) {
+		pthread_join (readers [i], &ret);
+		res += GPOINTER_TO_INT (ret);
+	}
+
+	for (i = 1; i <= STRESS_KEYS; ++i) {
+		if (mono_conc_hashtable_lookup (hash, GINT_TO_POINTER (i)) != stress_winners [i])
+			++res;
+	}
+
+	mono_conc_hashtable_destroy (hash);
+	if (res)
+		printf ("UNLOCKED_PAR_WRITER_PAR_READER TEST FAILED %d\n", res);
+	return res;
+}
+
 static void G_GNUC_UNUSED
 benchmark_conc (void)
 {
@@ -353,6 +472,8 @@ test_conc_hashtable_main (void)
 	res += parallel_writer_single_reader ();
 	res += single_writer_parallel_reader ();
 	res += parallel_writer_parallel_reader ();
+	res += unlocked_parallel_writer_parallel_reader (NULL);
+	res += unlocked_parallel_writer_parallel_reader (stress_equal);
 
 	return res;
 }
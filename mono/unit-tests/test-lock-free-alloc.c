@@ -0,0 +1,191 @@
+/*
+ * test-lock-free-alloc.c: Unit test and benchmark for the lock free allocator.
+ *
+ * Licensed under the MIT license. See LICENSE file in the project root for full license information.
+ */
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <config.h>
+#include <mono/metadata/metadata.h>
+#include <mono/utils/mono-threads.h>
+#include <mono/utils/hazard-pointer.h>
+#include <mono/utils/lock-free-alloc.h>
+#include <mono/utils/mono-time.h>
+#include <mono/utils/mono-jemalloc.h>
+
+#define NUM_THREADS 8
+#define NUM_ITERS 2000
+#define BATCH 200
+#define NUM_SIZE_CLASSES 2
+
+static MonoLockFreeAllocSizeClass size_classes [NUM_SIZE_CLASSES];
+static MonoLockFreeAllocator allocators [NUM_SIZE_CLASSES];
+static const unsigned int slot_sizes [NUM_SIZE_CLASSES] = { 24, 136 };
+static const unsigned int block_sizes [NUM_SIZE_CLASSES] = { 4096, 16384 };
+
+static void*
+worker (void *arg)
+{
+	int tag = GPOINTER_TO_INT (arg) + 1;
+	gpointer ptrs [BATCH];
+	int i, j, iter;
+
+	mono_thread_info_register_small_id ();
+
+	for (iter = 0; iter < NUM_ITERS; ++iter) {
+		int k = (iter + tag) % NUM_SIZE_CLASSES;
+
+		for (i = 0; i < BATCH; ++i) {
+			ptrs [i] = mono_lock_free_alloc (&allocators [k]);
+			memset (ptrs [i], tag, slot_sizes [k]);
+		}
+
+		/* Nobody else may have been handed our slots */
+		for (i = 0; i < BATCH; ++i) {
+			for (j = 0; j < slot_sizes [k]; ++j)
+				assert (((unsigned char*)ptrs [i]) [j] == tag);
+		}
+
+		if (iter & 2) {
+			mono_lock_free_free_batch (ptrs, BATCH, block_sizes [k]);
+		} else {
+			for (i = 0; i < BATCH; ++i)
+				mono_lock_free_free (ptrs [i], block_sizes [k]);
+		}
+	}
+
+	return NULL;
+}
+
+typedef enum {
+	BENCH_LOCK_FREE,
+	BENCH_LOCK_FREE_BATCH,
+	BENCH_MALLOC,
+#ifdef MONO_JEMALLOC_ENABLED
+	BENCH_JEMALLOC,
+#endif
+	BENCH_NUM
+} BenchKind;
+
+static const char *bench_names [] = {
+	"lock free",
+	"lock free, batched frees",
+	"malloc",
+#ifdef MONO_JEMALLOC_ENABLED
+	"jemalloc",
+#endif
+};
+
+static void*
+bench_worker (void *arg)
+{
+	BenchKind kind = (BenchKind)GPOINTER_TO_INT (arg);
+	gpointer ptrs [BATCH];
+	int i, iter;
+
+	mono_thread_info_register_small_id ();
+
+	for (iter = 0; iter < NUM_ITERS * 10; ++iter) {
+		switch (kind) {
+		case BENCH_LOCK_FREE:
+		case BENCH_LOCK_FREE_BATCH:
+			for (i = 0; i < BATCH; ++i)
+				ptrs [i] = mono_lock_free_alloc (&allocators [0]);
+			if (kind == BENCH_LOCK_FREE_BATCH) {
+				mono_lock_free_free_batch (ptrs, BATCH, block_sizes [0]);
+			} else {
+				for (i = 0; i < BATCH; ++i)
+					mono_lock_free_free (ptrs [i], block_sizes [0]);
+			}
+			break;
+		case BENCH_MALLOC:
+			for (i = 0; i < BATCH; ++i)
+				ptrs [i] = malloc (slot_sizes [0]);
+			for (i = 0; i < BATCH; ++i)
+				free (ptrs [i]);
+			break;
+#ifdef MONO_JEMALLOC_ENABLED
+		case BENCH_JEMALLOC:
+			for (i = 0; i < BATCH; ++i)
+				ptrs [i] = MONO_JEMALLOC_MALLOC (slot_sizes [0]);
+			for (i = 0; i < BATCH; ++i)
+				MONO_JEMALLOC_FREE (ptrs [i]);
+			break;
+#endif
+		default:
+			g_assert_not_reached ();
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * Compare the lock free allocator with the system malloc and, if the runtime was
+ * built with it, jemalloc, for small internal allocations done from several threads.
+ * Only run when the BENCH environment variable is set.
+ */
+static void
+benchmark_allocators (void)
+{
+	pthread_t threads [NUM_THREADS];
+	int kind, i;
+
+	for (kind = 0; kind < BENCH_NUM; ++kind) {
+		gint64 start = mono_100ns_ticks ();
+
+		for (i = 0; i < NUM_THREADS; ++i)
+			pthread_create (&threads [i], NULL, bench_worker, GINT_TO_POINTER (kind));
+		for (i = 0; i < NUM_THREADS; ++i)
+			pthread_join (threads [i], NULL);
+
+		printf ("%-26s %8.2f ms\n", bench_names [kind], (mono_100ns_ticks () - start) / 10000.0);
+	}
+}
+
+#ifdef __cplusplus
+extern "C"
+#endif
+int
+test_lock_free_alloc_main (void);
+
+int
+test_lock_free_alloc_main (void)
+{
+	pthread_t threads [NUM_THREADS];
+	int i;
+
+	mono_metadata_init ();
+
+	mono_thread_info_init (0);
+
+	for (i = 0; i < NUM_SIZE_CLASSES; ++i) {
+		mono_lock_free_allocator_init_size_class (&size_classes [i], slot_sizes [i], block_sizes [i]);
+		mono_lock_free_allocator_init_allocator (&allocators [i], &size_classes [i], MONO_MEM_ACCOUNT_OTHER);
+	}
+
+	for (i = 0; i < NUM_THREADS; ++i) {
+		int result = pthread_create (&threads [i], NULL, worker, GINT_TO_POINTER (i));
+		assert (!result);
+	}
+
+	for (i = 0; i < NUM_THREADS; ++i) {
+		int result = pthread_join (threads [i], NULL);
+		assert (!result);
+	}
+
+	mono_thread_hazardous_try_free_all ();
+
+	for (i = 0; i < NUM_SIZE_CLASSES; ++i)
+		assert (mono_lock_free_allocator_check_consistency (&allocators [i]));
+
+	if (getenv ("BENCH"))
+		benchmark_allocators ();
+
+	return 0;
+}
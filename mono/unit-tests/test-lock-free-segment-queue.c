@@ -0,0 +1,129 @@
+/*
+ * test-lock-free-segment-queue.c: Unit test for the lock free segment queue.
+ *
+ * Licensed under the MIT license. See LICENSE file in the project root for full license information.
+ */
+
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <config.h>
+#include <glib.h>
+#include <mono/utils/lock-free-segment-queue.h>
+
+#define NUM_PRODUCERS 4
+#define NUM_CONSUMERS 4
+#define NUM_ITEMS 100000
+#define BATCH 16
+
+static MonoLockFreeSegmentQueue queue;
+static volatile gint32 producers_done;
+static volatile gint32 seen [NUM_PRODUCERS][NUM_ITEMS];
+
+/* An entry is the producer index shifted left by 24, or'd with the item index */
+static void*
+producer (void *arg)
+{
+	gsize id = GPOINTER_TO_UINT (arg);
+	gsize entries [BATCH];
+	int i = 0;
+
+	while (i < NUM_ITEMS) {
+		/* Mix single and batched enqueues */
+		int n = (i & 1) ? 1 : MIN (BATCH, NUM_ITEMS - i);
+		int j, added;
+
+		for (j = 0; j < n; ++j)
+			entries [j] = (id << 24) | (i + j);
+
+		added = mono_lock_free_segment_queue_enqueue_batch (&queue, entries, n);
+		if (!added)
+			sched_yield ();
+		i += added;
+	}
+
+	__sync_fetch_and_add (&producers_done, 1);
+
+	return NULL;
+}
+
+static void*
+consumer (void *arg)
+{
+	int batch = (GPOINTER_TO_INT (arg) & 1) ? BATCH : 1;
+	gsize entries [BATCH];
+
+	for (;;) {
+		int n = mono_lock_free_segment_queue_dequeue_batch (&queue, entries, batch);
+		int j;
+
+		for (j = 0; j < n; ++j) {
+			gsize id = entries [j] >> 24;
+			gsize index = entries [j] & 0xffffff;
+
+			assert (id < NUM_PRODUCERS && index < NUM_ITEMS);
+			/* Every entry is dequeued exactly once */
+			assert (__sync_fetch_and_add (&seen [id][index], 1) == 0);
+		}
+
+		if (!n) {
+			if (producers_done == NUM_PRODUCERS && !mono_lock_free_segment_queue_count (&queue))
+				break;
+			sched_yield ();
+		}
+	}
+
+	return NULL;
+}
+
+static void
+run (gint32 capacity)
+{
+	pthread_t threads [NUM_PRODUCERS + NUM_CONSUMERS];
+	int i, j;
+
+	mono_lock_free_segment_queue_init (&queue, sizeof (gsize), capacity, MONO_MEM_ACCOUNT_OTHER);
+	producers_done = 0;
+	memset ((void*)seen, 0, sizeof (seen));
+
+	for (i = 0; i < NUM_PRODUCERS; ++i) {
+		int result = pthread_create (&threads [i], NULL, producer, GUINT_TO_POINTER (i));
+		assert (!result);
+	}
+	for (i = 0; i < NUM_CONSUMERS; ++i) {
+		int result = pthread_create (&threads [NUM_PRODUCERS + i], NULL, consumer, GINT_TO_POINTER (i));
+		assert (!result);
+	}
+
+	for (i = 0; i < NUM_PRODUCERS + NUM_CONSUMERS; ++i) {
+		int result = pthread_join (threads [i], NULL);
+		assert (!result);
+	}
+
+	for (i = 0; i < NUM_PRODUCERS; ++i) {
+		for (j = 0; j < NUM_ITEMS; ++j)
+			assert (seen [i][j] == 1);
+	}
+
+	mono_lock_free_segment_queue_cleanup (&queue);
+}
+
+#ifdef __cplusplus
+extern "C"
+#endif
+int
+test_lock_free_segment_queue_main (void);
+
+int
+test_lock_free_segment_queue_main (void)
+{
+	/* Unbounded, then bounded below and above the size of a segment */
+	run (0);
+	run (100);
+	run (5000);
+
+	return 0;
+}
@@ -8,13 +8,14 @@
 
 #include <config.h>
 
+#include <stdlib.h>
 #include <string.h>
 
 #include <mono/utils/hazard-pointer.h>
 #include <mono/utils/mono-membar.h>
 #include <mono/utils/mono-memory-model.h>
 #include <mono/utils/monobitset.h>
-#include <mono/utils/lock-free-array-queue.h>
+#include <mono/utils/lock-free-segment-queue.h>
 #include <mono/utils/atomic.h>
 #include <mono/utils/mono-os-mutex.h>
 #ifdef SGEN_WITHOUT_MONO
@@ -32,11 +33,10 @@ typedef struct {
 } DelayedFreeItem;
 
 /* The hazard table */
+#define HAZARD_TABLE_MAX_SIZE	MONO_SMALL_ID_MAX
 #if MONO_SMALL_CONFIG
-#define HAZARD_TABLE_MAX_SIZE	256
 #define HAZARD_TABLE_OVERFLOW	4
 #else
-#define HAZARD_TABLE_MAX_SIZE	16384 /* There cannot be more threads than this number. */
 #define HAZARD_TABLE_OVERFLOW	64
 #endif
 
@@ -52,7 +52,7 @@ static volatile gint32 overflow_busy [HAZARD_TABLE_OVERFLOW];
 
 /* The table where we keep pointers to blocks to be freed but that
    have to wait because they're guarded by a hazard pointer. */
-static MonoLockFreeArrayQueue delayed_free_queue = MONO_LOCK_FREE_ARRAY_QUEUE_INIT (sizeof (DelayedFreeItem), MONO_MEM_ACCOUNT_HAZARD_POINTERS);
+static MonoLockFreeSegmentQueue delayed_free_queue = MONO_LOCK_FREE_SEGMENT_QUEUE_INIT (sizeof (DelayedFreeItem), 0, MONO_MEM_ACCOUNT_HAZARD_POINTERS);
 
 /* The table for small ID assignment */
 static mono_mutex_t small_id_mutex;
@@ -338,9 +338,9 @@ mono_thread_hazardous_queue_free (gpointer p, MonoHazardousFreeFunc free_func)
 
 	mono_atomic_inc_i32 (&hazardous_pointer_count);
 
-	mono_lock_free_array_queue_push (&delayed_free_queue, &item);
+	mono_lock_free_segment_queue_enqueue (&delayed_free_queue, &item);
 
-	guint32 queue_size = delayed_free_queue.num_used_entries;
+	guint32 queue_size = mono_lock_free_segment_queue_count (&delayed_free_queue);
 	if (queue_size && queue_size_cb)
 		queue_size_cb (queue_size);
 }
@@ -352,42 +352,107 @@ mono_hazard_pointer_install_free_queue_size_callback (MonoHazardFreeQueueSizeCal
 	queue_size_cb = cb;
 }
 
-static void
-try_free_delayed_free_items (guint32 limit)
+static int
+compare_pointers (const void *a, const void *b)
 {
-	GArray *hazardous = NULL;
-	DelayedFreeItem item;
-	guint32 freed = 0;
+	gsize pa = (gsize)*(const gpointer*)a;
+	gsize pb = (gsize)*(const gpointer*)b;
 
-	// Free all the items we can and re-add the ones we can't to the queue.
-	while (mono_lock_free_array_queue_pop (&delayed_free_queue, &item)) {
-		if (is_pointer_hazardous (item.p)) {
-			if (!hazardous)
-				hazardous = g_array_sized_new (FALSE, FALSE, sizeof (DelayedFreeItem), delayed_free_queue.num_used_entries);
+	return pa < pb ? -1 : pa > pb ? 1 : 0;
+}
 
-			g_array_append_val (hazardous, item);
-			continue;
+/*
+ * Collect the hazard pointers of all threads into a sorted array, so checking a
+ * batch of items costs a binary search each instead of a scan of the hazard table.
+ */
+static GArray*
+hazard_pointers_snapshot (void)
+{
+	int i, j;
+	int highest = highest_small_id;
+	GArray *snapshot;
+
+	g_assert (highest < hazard_table_size);
+
+	snapshot = g_array_sized_new (FALSE, FALSE, sizeof (gpointer), 16);
+
+	for (i = 0; i <= highest; ++i) {
+		for (j = 0; j < HAZARD_POINTER_COUNT; ++j) {
+			gpointer p = hazard_table [i].hazard_pointers [j];
+			if (p)
+				g_array_append_val (snapshot, p);
+			LOAD_LOAD_FENCE;
 		}
+	}
 
-		item.free_func (item.p);
-		freed++;
+	qsort (snapshot->data, snapshot->len, sizeof (gpointer), compare_pointers);
 
-		if (limit && freed == limit)
-			break;
+	return snapshot;
+}
+
+static gboolean
+is_pointer_in_snapshot (GArray *snapshot, gpointer p)
+{
+	return snapshot->len && bsearch (&p, snapshot->data, snapshot->len, sizeof (gpointer), compare_pointers);
+}
+
+/* Returns the number of items freed */
+static guint32
+try_free_delayed_free_items (guint32 limit)
+{
+	GArray *batch, *snapshot;
+	DelayedFreeItem *items;
+	guint32 i, max, kept = 0, freed = 0;
+
+	/*
+	 * Take the items out of the queue before taking the snapshot: they were all
+	 * retired by then, so a hazard pointer set to one of them after the snapshot
+	 * will fail its validation. Items queued meanwhile wait for the next round.
+	 */
+	max = mono_lock_free_segment_queue_count (&delayed_free_queue);
+	if (limit && limit < max)
+		max = limit;
+	if (!max)
+		return 0;
+
+	batch = g_array_sized_new (FALSE, FALSE, sizeof (DelayedFreeItem), max);
+	g_array_set_size (batch, mono_lock_free_segment_queue_dequeue_batch (&delayed_free_queue, batch->data, max));
+
+	if (!batch->len) {
+		g_array_free (batch, TRUE);
+		return 0;
 	}
 
-	if (hazardous) {
-		for (gint i = 0; i < hazardous->len; i++)
-			mono_lock_free_array_queue_push (&delayed_free_queue, &g_array_index (hazardous, DelayedFreeItem, i));
+	mono_memory_barrier ();
 
-		g_array_free (hazardous, TRUE);
+	snapshot = hazard_pointers_snapshot ();
+
+	// Free all the items we can and re-add the ones we can't to the queue.
+	items = (DelayedFreeItem *) batch->data;
+	for (i = 0; i < batch->len; ++i) {
+		if (is_pointer_in_snapshot (snapshot, items [i].p)) {
+			items [kept++] = items [i];
+		} else {
+			items [i].free_func (items [i].p);
+			freed++;
+		}
 	}
+
+	if (kept)
+		mono_lock_free_segment_queue_enqueue_batch (&delayed_free_queue, items, kept);
+
+	g_array_free (snapshot, TRUE);
+	g_array_free (batch, TRUE);
+
+	return freed;
 }
 
 void
 mono_thread_hazardous_try_free_all (void)
 {
-	try_free_delayed_free_items (0);
+	/* Freeing an item can queue more of them */
+	while (try_free_delayed_free_items (0))
+		;
 }
 
 void
@@ -415,7 +480,7 @@ mono_thread_smr_cleanup (void)
 {
 	mono_thread_hazardous_try_free_all ();
 
-	mono_lock_free_array_queue_cleanup (&delayed_free_queue);
+	mono_lock_free_segment_queue_cleanup (&delayed_free_queue);
 
 	/*FIXME, can't we release the small id table here?*/
 }
@@ -15,6 +15,13 @@
 
 #define HAZARD_POINTER_COUNT 3
 
+/* Small ids are below this, so there cannot be more threads than this number. */
+#if MONO_SMALL_CONFIG
+#define MONO_SMALL_ID_MAX	256
+#else
+#define MONO_SMALL_ID_MAX	16384
+#endif
+
 typedef struct {
 	gpointer hazard_pointers [HAZARD_POINTER_COUNT];
 } MonoThreadHazardPointers;
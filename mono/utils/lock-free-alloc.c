@@ -53,6 +53,19 @@
  * happen, descriptors are still retired.  This is analogous to what
  * Michael's allocator does.
  *
+ * Unlike Michael's allocator, an allocator has one active field and
+ * one partial queue per shard, and each thread uses the ones of its
+ * shard, so allocations on different cores don't fight over the same
+ * descriptor.  A descriptor remembers the shard it was last made
+ * active in and frees use that as a hint: since they only ever CAS the
+ * active field expecting that descriptor, a stale hint just means they
+ * take the path for a descriptor which isn't active.  Allocating
+ * threads whose partial queue is empty take descriptors from the other
+ * shards before allocating new superblocks.
+ *
+ * Frees of several slots from the same superblock can be done with a
+ * single anchor update, see mono_lock_free_free_batch ().
+ *
  * Another difference to Michael's allocator is not related to
  * concurrency, however: We don't point from slots to descriptors.
  * Instead we allocate superblocks aligned and point from the start of
@@ -76,6 +89,9 @@
 #include <mono/utils/mono-membar.h>
 #include <mono/utils/hazard-pointer.h>
 #include <mono/utils/lock-free-queue.h>
+#ifndef SGEN_WITHOUT_MONO
+#include <mono/utils/mono-threads.h>
+#endif
 
 #include <mono/utils/lock-free-alloc.h>
 
@@ -104,6 +120,7 @@ struct _MonoLockFreeAllocDescriptor {
 	unsigned int slot_size;
 	unsigned int block_size;
 	unsigned int max_count;
+	int shard;	/* where the descriptor was last active, only a hint */
 	gpointer sb;
 #ifndef DESC_AVAIL_DUMMY
 	Descriptor * volatile next;
@@ -113,6 +130,19 @@ struct _MonoLockFreeAllocDescriptor {
 
 #define NUM_DESC_BATCH	64
 
+static MONO_ALWAYS_INLINE int
+get_shard (void)
+{
+#ifdef SGEN_WITHOUT_MONO
+	/* Threads run on different stacks */
+	int dummy;
+	return ((gsize) &dummy >> 16) & (LOCK_FREE_ALLOC_SHARDS - 1);
+#else
+	/* Threads without a small id all share shard 0 */
+	return MAX (mono_thread_info_get_small_id (), 0) & (LOCK_FREE_ALLOC_SHARDS - 1);
+#endif
+}
+
 static MONO_ALWAYS_INLINE gpointer
 sb_header_for_addr (gpointer addr, size_t block_size)
 {
@@ -261,10 +291,10 @@ desc_retire (Descriptor *desc)
 #endif
 
 static Descriptor*
-list_get_partial (MonoLockFreeAllocSizeClass *sc)
+list_get_partial (MonoLockFreeAllocSizeClass *sc, int shard)
 {
 	for (;;) {
-		Descriptor *desc = (Descriptor*) mono_lock_free_queue_dequeue (&sc->partial);
+		Descriptor *desc = (Descriptor*) mono_lock_free_queue_dequeue (&sc->partial [shard].queue);
 		if (!desc)
 			return NULL;
 		if (desc->anchor.data.state != STATE_EMPTY)
@@ -281,7 +311,7 @@ desc_put_partial (gpointer _desc)
 	g_assert (desc->anchor.data.state != STATE_FULL);
 
 	mono_lock_free_queue_node_unpoison (&desc->node);
-	mono_lock_free_queue_enqueue (&desc->heap->sc->partial, &desc->node);
+	mono_lock_free_queue_enqueue (&desc->heap->sc->partial [desc->shard].queue, &desc->node);
 }
 
 static void
@@ -292,11 +322,11 @@ list_put_partial (Descriptor *desc)
 }
 
 static void
-list_remove_empty_desc (MonoLockFreeAllocSizeClass *sc)
+list_remove_empty_desc (MonoLockFreeAllocSizeClass *sc, int shard)
 {
 	int num_non_empty = 0;
 	for (;;) {
-		Descriptor *desc = (Descriptor*) mono_lock_free_queue_dequeue (&sc->partial);
+		Descriptor *desc = (Descriptor*) mono_lock_free_queue_dequeue (&sc->partial [shard].queue);
 		if (!desc)
 			return;
 		/*
@@ -315,9 +345,20 @@ list_remove_empty_desc (MonoLockFreeAllocSizeClass *sc)
 }
 
 static Descriptor*
-heap_get_partial (MonoLockFreeAllocator *heap)
+heap_get_partial (MonoLockFreeAllocator *heap, int shard)
 {
-	return list_get_partial (heap->sc);
+	Descriptor *desc;
+	int i;
+
+	for (i = 0; i < LOCK_FREE_ALLOC_SHARDS; ++i) {
+		desc = list_get_partial (heap->sc, (shard + i) & (LOCK_FREE_ALLOC_SHARDS - 1));
+		if (desc) {
+			/* It's ours now, so it goes back to our shard */
+			desc->shard = shard;
+			return desc;
+		}
+	}
+	return NULL;
 }
 
 static void
@@ -336,19 +377,20 @@ set_anchor (Descriptor *desc, Anchor old_anchor, Anchor new_anchor)
 }
 
 static gpointer
-alloc_from_active_or_partial (MonoLockFreeAllocator *heap)
+alloc_from_active_or_partial (MonoLockFreeAllocator *heap, int shard)
 {
 	Descriptor *desc;
 	Anchor old_anchor, new_anchor;
 	gpointer addr;
 
  retry:
-	desc = heap->active;
+	desc = heap->active [shard].desc;
 	if (desc) {
-		if (mono_atomic_cas_ptr ((volatile gpointer *)&heap->active, NULL, desc) != desc)
+		if (mono_atomic_cas_ptr ((volatile gpointer *)&heap->active [shard].desc, NULL, desc) != desc)
 			goto retry;
+		desc->shard = shard;
 	} else {
-		desc = heap_get_partial (heap);
+		desc = heap_get_partial (heap, shard);
 		if (!desc)
 			return NULL;
 	}
@@ -382,7 +424,7 @@ alloc_from_active_or_partial (MonoLockFreeAllocator *heap)
 
 	/* If the desc is partial we have to give it back. */
 	if (new_anchor.data.state == STATE_PARTIAL) {
-		if (mono_atomic_cas_ptr ((volatile gpointer *)&heap->active, desc, NULL) != NULL)
+		if (mono_atomic_cas_ptr ((volatile gpointer *)&heap->active [shard].desc, desc, NULL) != NULL)
 			heap_put_partial (desc);
 	}
 
@@ -390,7 +432,7 @@ alloc_from_active_or_partial (MonoLockFreeAllocator *heap)
 }
 
 static gpointer
-alloc_from_new_sb (MonoLockFreeAllocator *heap)
+alloc_from_new_sb (MonoLockFreeAllocator *heap, int shard)
 {
 	unsigned int slot_size, block_size, count, i;
 	Descriptor *desc = desc_alloc (heap->account_type);
@@ -400,6 +442,7 @@ alloc_from_new_sb (MonoLockFreeAllocator *heap)
 	count = LOCK_FREE_ALLOC_SB_USABLE_SIZE (block_size) / slot_size;
 
 	desc->heap = heap;
+	desc->shard = shard;
 	/*
 	 * Setting avail to 1 because 0 is the block we're allocating
 	 * right away.
@@ -422,7 +465,7 @@ alloc_from_new_sb (MonoLockFreeAllocator *heap)
 	mono_memory_write_barrier ();
 
 	/* Make it active or free it again. */
-	if (mono_atomic_cas_ptr ((volatile gpointer *)&heap->active, desc, NULL) == NULL) {
+	if (mono_atomic_cas_ptr ((volatile gpointer *)&heap->active [shard].desc, desc, NULL) == NULL) {
 		return desc->sb;
 	} else {
 		desc->anchor.data.state = STATE_EMPTY;
@@ -435,14 +478,15 @@ gpointer
 mono_lock_free_alloc (MonoLockFreeAllocator *heap)
 {
 	gpointer addr;
+	int shard = get_shard ();
 
 	for (;;) {
 
-		addr = alloc_from_active_or_partial (heap);
+		addr = alloc_from_active_or_partial (heap, shard);
 		if (addr)
 			break;
 
-		addr = alloc_from_new_sb (heap);
+		addr = alloc_from_new_sb (heap, shard);
 		if (addr)
 			break;
 	}
@@ -450,38 +494,47 @@ mono_lock_free_alloc (MonoLockFreeAllocator *heap)
 	return addr;
 }
 
-void
-mono_lock_free_free (gpointer ptr, size_t block_size)
+/*
+ * Give COUNT slots of DESC back with a single anchor update. The slots are chained through
+ * their first word, in the order given, in front of the slots which were already available.
+ */
+static void
+free_slots (Descriptor *desc, gpointer *ptrs, unsigned int count)
 {
 	Anchor old_anchor, new_anchor;
-	Descriptor *desc;
-	gpointer sb;
 	MonoLockFreeAllocator *heap = NULL;
+	gpointer sb = desc->sb;
+	gpointer last = ptrs [count - 1];
+	unsigned int i, max_index = LOCK_FREE_ALLOC_SB_USABLE_SIZE (desc->block_size) / desc->slot_size;
 
-	desc = *(Descriptor**) sb_header_for_addr (ptr, block_size);
-	g_assert (block_size == desc->block_size);
-
-	sb = desc->sb;
+	for (i = 0; i + 1 < count; ++i) {
+		*(unsigned int*)ptrs [i] = ((char*)ptrs [i + 1] - (char*)sb) / desc->slot_size;
+		g_assert (*(unsigned int*)ptrs [i] < max_index);
+	}
 
 	do {
 		new_anchor.value = old_anchor.value = ((volatile Anchor*)&desc->anchor)->value;
-		*(unsigned int*)ptr = old_anchor.data.avail;
-		new_anchor.data.avail = ((char*)ptr - (char*)sb) / desc->slot_size;
-		g_assert (new_anchor.data.avail < LOCK_FREE_ALLOC_SB_USABLE_SIZE (block_size) / desc->slot_size);
+		*(unsigned int*)last = old_anchor.data.avail;
+		new_anchor.data.avail = ((char*)ptrs [0] - (char*)sb) / desc->slot_size;
+		g_assert (new_anchor.data.avail < max_index);
 
 		if (old_anchor.data.state == STATE_FULL)
 			new_anchor.data.state = STATE_PARTIAL;
 
-		if (++new_anchor.data.count == desc->max_count) {
+		new_anchor.data.count += count;
+		g_assert (new_anchor.data.count <= desc->max_count);
+		if (new_anchor.data.count == desc->max_count) {
 			heap = desc->heap;
 			new_anchor.data.state = STATE_EMPTY;
 		}
 	} while (!set_anchor (desc, old_anchor, new_anchor));
 
 	if (new_anchor.data.state == STATE_EMPTY) {
+		int shard = desc->shard;
+
 		g_assert (old_anchor.data.state != STATE_EMPTY);
 
-		if (mono_atomic_cas_ptr ((volatile gpointer *)&heap->active, NULL, desc) == desc) {
+		if (mono_atomic_cas_ptr ((volatile gpointer *)&heap->active [shard].desc, NULL, desc) == desc) {
 			/*
 			 * We own desc, check if it's still empty, in which case we retire it.
 			 * If it's partial we need to put it back either on the active slot or
@@ -490,7 +543,7 @@ mono_lock_free_free (gpointer ptr, size_t block_size)
 			if (desc->anchor.data.state == STATE_EMPTY) {
 				desc_retire (desc);
 			} else if (desc->anchor.data.state == STATE_PARTIAL) {
-				if (mono_atomic_cas_ptr ((volatile gpointer *)&heap->active, desc, NULL) != NULL)
+				if (mono_atomic_cas_ptr ((volatile gpointer *)&heap->active [shard].desc, desc, NULL) != NULL)
 					heap_put_partial (desc);
 
 			}
@@ -499,7 +552,7 @@ mono_lock_free_free (gpointer ptr, size_t block_size)
 			 * Somebody else must free it, so we do some
 			 * freeing for others.
 			 */
-			list_remove_empty_desc (heap->sc);
+			list_remove_empty_desc (heap->sc, shard);
 		}
 	} else if (old_anchor.data.state == STATE_FULL) {
 		/*
@@ -509,11 +562,46 @@ mono_lock_free_free (gpointer ptr, size_t block_size)
 
 		g_assert (new_anchor.data.state == STATE_PARTIAL);
 
-		if (mono_atomic_cas_ptr ((volatile gpointer *)&desc->heap->active, desc, NULL) != NULL)
+		if (mono_atomic_cas_ptr ((volatile gpointer *)&desc->heap->active [desc->shard].desc, desc, NULL) != NULL)
 			heap_put_partial (desc);
 	}
 }
 
+void
+mono_lock_free_free (gpointer ptr, size_t block_size)
+{
+	Descriptor *desc;
+
+	desc = *(Descriptor**) sb_header_for_addr (ptr, block_size);
+	g_assert (block_size == desc->block_size);
+
+	free_slots (desc, &ptr, 1);
+}
+
+/**
+ * mono_lock_free_free_batch:
+ *
+ * Same as calling \c mono_lock_free_free on each of the \p count slots in \p ptrs,
+ * but consecutive slots from the same superblock are given back at once.
+ */
+void
+mono_lock_free_free_batch (gpointer *ptrs, int count, size_t block_size)
+{
+	int i, start = 0;
+
+	while (start < count) {
+		Descriptor *desc = *(Descriptor**) sb_header_for_addr (ptrs [start], block_size);
+		g_assert (block_size == desc->block_size);
+
+		for (i = start + 1; i < count; ++i) {
+			if (sb_header_for_addr (ptrs [i], block_size) != sb_header_for_addr (ptrs [start], block_size))
+				break;
+		}
+		free_slots (desc, ptrs + start, i - start);
+		start = i;
+	}
+}
+
 #define g_assert_OR_PRINT(c, format, ...)	do {				\
 		if (!(c)) {						\
 			if (print)					\
@@ -586,15 +674,21 @@ descriptor_check_consistency (Descriptor *desc, gboolean print)
 gboolean
 mono_lock_free_allocator_check_consistency (MonoLockFreeAllocator *heap)
 {
-	Descriptor *active = heap->active;
 	Descriptor *desc;
-	if (active) {
-		g_assert (active->anchor.data.state == STATE_PARTIAL);
-		descriptor_check_consistency (active, FALSE);
+	int i;
+
+	for (i = 0; i < LOCK_FREE_ALLOC_SHARDS; ++i) {
+		Descriptor *active = heap->active [i].desc;
+		if (active) {
+			g_assert (active->anchor.data.state == STATE_PARTIAL);
+			descriptor_check_consistency (active, FALSE);
+		}
 	}
-	while ((desc = (Descriptor*)mono_lock_free_queue_dequeue (&heap->sc->partial))) {
-		g_assert (desc->anchor.data.state == STATE_PARTIAL || desc->anchor.data.state == STATE_EMPTY);
-		descriptor_check_consistency (desc, FALSE);
+	for (i = 0; i < LOCK_FREE_ALLOC_SHARDS; ++i) {
+		while ((desc = (Descriptor*)mono_lock_free_queue_dequeue (&heap->sc->partial [i].queue))) {
+			g_assert (desc->anchor.data.state == STATE_PARTIAL || desc->anchor.data.state == STATE_EMPTY);
+			descriptor_check_consistency (desc, FALSE);
+		}
 	}
 	return TRUE;
 }
@@ -602,11 +696,14 @@ mono_lock_free_allocator_check_consistency (MonoLockFreeAllocator *heap)
 void
 mono_lock_free_allocator_init_size_class (MonoLockFreeAllocSizeClass *sc, unsigned int slot_size, unsigned int block_size)
 {
+	int i;
+
 	g_assert (block_size > 0);
 	g_assert ((block_size & (block_size - 1)) == 0); /* check if power of 2 */
 	g_assert (slot_size * 2 <= LOCK_FREE_ALLOC_SB_USABLE_SIZE (block_size));
 
-	mono_lock_free_queue_init (&sc->partial);
+	for (i = 0; i < LOCK_FREE_ALLOC_SHARDS; ++i)
+		mono_lock_free_queue_init (&sc->partial [i].queue);
 	sc->slot_size = slot_size;
 	sc->block_size = block_size;
 }
@@ -614,7 +711,10 @@ mono_lock_free_allocator_init_size_class (MonoLockFreeAllocSizeClass *sc, unsign
 void
 mono_lock_free_allocator_init_allocator (MonoLockFreeAllocator *heap, MonoLockFreeAllocSizeClass *sc, MonoMemAccountType account_type)
 {
+	int i;
+
 	heap->sc = sc;
-	heap->active = NULL;
+	for (i = 0; i < LOCK_FREE_ALLOC_SHARDS; ++i)
+		heap->active [i].desc = NULL;
 	heap->account_type = account_type;
 }
@@ -31,16 +31,33 @@
 #include <mono/utils/lock-free-queue.h>
 #include <mono/utils/mono-mmap.h>
 
+/*
+ * Threads are spread over this many active descriptors and partial queues,
+ * picked by their small id, so they don't all CAS the same words.
+ */
+#define LOCK_FREE_ALLOC_SHARDS			8
+#define LOCK_FREE_ALLOC_CACHE_LINE_SIZE		64
+
+typedef union {
+	MonoLockFreeQueue queue;
+	char pad [LOCK_FREE_ALLOC_CACHE_LINE_SIZE];
+} MonoLockFreeAllocPartialQueue;
+
 typedef struct {
-	MonoLockFreeQueue partial;
+	MonoLockFreeAllocPartialQueue partial [LOCK_FREE_ALLOC_SHARDS];
 	unsigned int slot_size;
 	unsigned int block_size;
 } MonoLockFreeAllocSizeClass;
 
 struct _MonoLockFreeAllocDescriptor;
 
+typedef union {
+	struct _MonoLockFreeAllocDescriptor * volatile desc;
+	char pad [LOCK_FREE_ALLOC_CACHE_LINE_SIZE];
+} MonoLockFreeAllocActive;
+
 typedef struct {
-	struct _MonoLockFreeAllocDescriptor *active;
+	MonoLockFreeAllocActive active [LOCK_FREE_ALLOC_SHARDS];
 	MonoLockFreeAllocSizeClass *sc;
 	MonoMemAccountType account_type;
 } MonoLockFreeAllocator;
@@ -55,6 +72,7 @@ MONO_API void mono_lock_free_allocator_init_allocator (MonoLockFreeAllocator *he
 MONO_API gpointer mono_lock_free_alloc (MonoLockFreeAllocator *heap);
 
 MONO_API void mono_lock_free_free (gpointer ptr, size_t block_size);
+MONO_API void mono_lock_free_free_batch (gpointer *ptrs, int count, size_t block_size);
 
 MONO_API gboolean mono_lock_free_allocator_check_consistency (MonoLockFreeAllocator *heap);
 
@@ -0,0 +1,410 @@
+/**
+ * \file
+ * A lock-free multi producer, multi consumer queue of fixed size
+ * entries, stored in segments of many entries each.
+ *
+ * Licensed under the MIT license. See LICENSE file in the project root for full license information.
+ */
+
+/*
+ * The queue is a linked list of segments, each an array of slots which
+ * are used only once.  Producers reserve slots in the tail segment by
+ * incrementing its enqueue_pos, consumers by advancing the head segment's
+ * dequeue_pos with a CAS, so a batch of entries costs one atomic operation
+ * on the shared positions.  Once a segment is full producers append a new
+ * one, and once it is consumed the consumers unlink it.
+ *
+ * A consumer can reserve a slot whose producer hasn't written it yet.
+ * Instead of waiting for it, the consumer marks the slot ABANDONED, and
+ * the producer, whose CAS from EMPTY to READY then fails, puts the entry
+ * into another slot.  Nobody ever waits on another thread.
+ *
+ * Unlinked segments can still be used by threads which loaded them before
+ * they were unlinked.  Every operation is counted in the active counter of
+ * the current epoch, and the epoch only advances once everybody who
+ * entered in the previous one has left.  A segment retired in epoch E is
+ * thus unreachable once the epoch is E + 2.  This doesn't need hazard
+ * pointers, so the hazard pointer free queue can be built on it.
+ */
+
+#include <string.h>
+
+#include <mono/utils/atomic.h>
+#include <mono/utils/mono-membar.h>
+#include <mono/utils/mono-memory-model.h>
+#ifdef SGEN_WITHOUT_MONO
+#include <mono/sgen/sgen-gc.h>
+#include <mono/sgen/sgen-client.h>
+#else
+#include <mono/utils/mono-mmap.h>
+#endif
+
+#include <mono/utils/lock-free-segment-queue.h>
+
+#define SEGMENT_BYTES	(16 * 1024)
+
+/* How often a consumer rechecks a slot which is being written before abandoning it */
+#define SLOT_SPIN_COUNT	64
+
+enum {
+	STATE_EMPTY,
+	STATE_READY,
+	STATE_ABANDONED
+};
+
+typedef struct {
+	volatile gint32 state;
+	gpointer data [MONO_ZERO_LEN_ARRAY];
+} Slot;
+
+struct _MonoLockFreeSegment {
+	MonoLockFreeSegment * volatile next;
+	volatile gint32 enqueue_pos;
+	volatile gint32 dequeue_pos;
+	gint32 size;
+
+	gint32 retire_epoch;
+	MonoLockFreeSegment *retired_next;
+
+	char slots [MONO_ZERO_LEN_ARRAY];
+};
+
+typedef MonoLockFreeSegment Segment;
+typedef MonoLockFreeSegmentQueue Queue;
+
+#define SLOT_SIZE(q)	(sizeof (Slot) + (((q)->entry_size + sizeof (gpointer) - 1) & ~(sizeof (gpointer) - 1)))
+#define SEGMENT_NTH(q,seg,index)	((Slot *) ((seg)->slots + (index) * SLOT_SIZE (q)))
+
+static Segment*
+alloc_segment (Queue *q)
+{
+	/* Cleared by free_segment () */
+	Segment *seg = (Segment *) mono_atomic_xchg_ptr ((volatile gpointer *) &q->spare, NULL);
+
+	if (seg)
+		return seg;
+
+	seg = (Segment *) mono_valloc (NULL, SEGMENT_BYTES, MONO_MMAP_READ | MONO_MMAP_WRITE, q->account_type);
+	g_assert (seg);
+	seg->size = (SEGMENT_BYTES - (sizeof (Segment) - MONO_ZERO_LEN_ARRAY)) / SLOT_SIZE (q);
+	g_assert (seg->size > 0);
+	return seg;
+}
+
+static void
+free_segment (Queue *q, Segment *seg)
+{
+	gint32 size = seg->size;
+
+	/* Keep one around to save the next allocation */
+	if (!q->spare) {
+		memset (seg, 0, SEGMENT_BYTES);
+		seg->size = size;
+		mono_memory_write_barrier ();
+		if (mono_atomic_cas_ptr ((volatile gpointer *) &q->spare, seg, NULL) == NULL)
+			return;
+	}
+	mono_vfree (seg, SEGMENT_BYTES, q->account_type);
+}
+
+static gint32
+enter (Queue *q)
+{
+	gint32 epoch;
+
+	for (;;) {
+		epoch = q->epoch;
+		mono_atomic_inc_i32 (&q->active [epoch & 1]);
+		if (mono_atomic_load_i32 (&q->epoch) == epoch)
+			return epoch;
+		mono_atomic_dec_i32 (&q->active [epoch & 1]);
+	}
+}
+
+static void
+leave (Queue *q, gint32 epoch)
+{
+	mono_atomic_dec_i32 (&q->active [epoch & 1]);
+}
+
+static void
+try_reclaim (Queue *q)
+{
+	Segment *list, *seg, *next;
+	gint32 epoch;
+
+	if (!q->retired)
+		return;
+	if (mono_atomic_cas_i32 (&q->reclaim_lock, 1, 0) != 0)
+		return;
+
+	/* Everybody who entered in the previous epoch has left */
+	epoch = q->epoch;
+	if (!mono_atomic_load_i32 (&q->active [(epoch + 1) & 1])) {
+		++epoch;
+		mono_atomic_store_i32 (&q->epoch, epoch);
+	}
+
+	list = (Segment *) mono_atomic_xchg_ptr ((volatile gpointer *) &q->retired, NULL);
+	for (seg = list; seg; seg = next) {
+		next = seg->retired_next;
+		if (epoch - seg->retire_epoch >= 2) {
+			free_segment (q, seg);
+		} else {
+			Segment *head;
+			do {
+				head = q->retired;
+				seg->retired_next = head;
+			} while (mono_atomic_cas_ptr ((volatile gpointer *) &q->retired, seg, head) != head);
+		}
+	}
+
+	mono_atomic_store_release (&q->reclaim_lock, 0);
+}
+
+static void
+retire_segment (Queue *q, Segment *seg)
+{
+	Segment *head;
+
+	mono_memory_barrier ();
+	seg->retire_epoch = mono_atomic_load_i32 (&q->epoch);
+	do {
+		head = q->retired;
+		seg->retired_next = head;
+	} while (mono_atomic_cas_ptr ((volatile gpointer *) &q->retired, seg, head) != head);
+
+	try_reclaim (q);
+}
+
+static Segment*
+get_tail (Queue *q)
+{
+	Segment *seg = q->tail;
+
+	if (G_LIKELY (seg))
+		return seg;
+
+	if (!q->head) {
+		seg = alloc_segment (q);
+		mono_memory_write_barrier ();
+		if (mono_atomic_cas_ptr ((volatile gpointer *) &q->head, seg, NULL) != NULL)
+			free_segment (q, seg);
+	}
+	mono_atomic_cas_ptr ((volatile gpointer *) &q->tail, q->head, NULL);
+	return q->tail;
+}
+
+static void
+advance_tail (Queue *q, Segment *seg)
+{
+	Segment *next = seg->next;
+
+	if (!next) {
+		next = alloc_segment (q);
+		mono_memory_write_barrier ();
+		if (mono_atomic_cas_ptr ((volatile gpointer *) &seg->next, next, NULL) != NULL) {
+			free_segment (q, next);
+			next = seg->next;
+		}
+	}
+	mono_atomic_cas_ptr ((volatile gpointer *) &q->tail, next, seg);
+}
+
+static void
+enqueue_entries (Queue *q, const char *entries, int count)
+{
+	while (count > 0) {
+		Segment *seg = get_tail (q);
+		gint32 index = mono_atomic_fetch_add_i32 (&seg->enqueue_pos, count);
+		gint32 end = index + count;
+		gint32 i;
+
+		if (end > seg->size)
+			end = seg->size;
+
+		/* An abandoned slot is skipped, the entry goes into the next one */
+		for (i = index; i < end; ++i) {
+			Slot *slot = SEGMENT_NTH (q, seg, i);
+
+			memcpy (slot->data, entries, q->entry_size);
+			if (mono_atomic_cas_i32 (&slot->state, STATE_READY, STATE_EMPTY) == STATE_EMPTY) {
+				entries += q->entry_size;
+				--count;
+			}
+		}
+
+		if (count > 0 && end >= seg->size)
+			advance_tail (q, seg);
+	}
+}
+
+static int
+dequeue_entries (Queue *q, char *entries, int count)
+{
+	int taken = 0;
+
+	while (taken < count) {
+		Segment *seg = q->head;
+		gint32 index, limit, n, i;
+
+		if (!seg)
+			break;
+
+		index = seg->dequeue_pos;
+		mono_memory_read_barrier ();
+		limit = seg->enqueue_pos;
+		if (limit > seg->size)
+			limit = seg->size;
+
+		if (index >= seg->size) {
+			Segment *next = seg->next;
+			if (!next)
+				break;
+			/* The tail must not be left behind on a retired segment */
+			mono_atomic_cas_ptr ((volatile gpointer *) &q->tail, next, seg);
+			if (mono_atomic_cas_ptr ((volatile gpointer *) &q->head, next, seg) == seg)
+				retire_segment (q, seg);
+			continue;
+		}
+
+		if (index >= limit)
+			break;
+
+		n = MIN (count - taken, limit - index);
+		if (mono_atomic_cas_i32 (&seg->dequeue_pos, index + n, index) != index)
+			continue;
+
+		for (i = index; i < index + n; ++i) {
+			Slot *slot = SEGMENT_NTH (q, seg, i);
+			int spin;
+
+			for (spin = 0; spin < SLOT_SPIN_COUNT && slot->state == STATE_EMPTY; ++spin)
+				mono_memory_read_barrier ();
+
+			if (slot->state == STATE_EMPTY && mono_atomic_cas_i32 (&slot->state, STATE_ABANDONED, STATE_EMPTY) == STATE_EMPTY)
+				continue;
+
+			/* Reading the entry must happen after seeing it READY */
+			mono_memory_read_barrier ();
+			memcpy (entries + taken * q->entry_size, slot->data, q->entry_size);
+			++taken;
+		}
+	}
+
+	return taken;
+}
+
+void
+mono_lock_free_segment_queue_init (MonoLockFreeSegmentQueue *q, size_t entry_size, gint32 capacity, MonoMemAccountType account_type)
+{
+	memset (q, 0, sizeof (MonoLockFreeSegmentQueue));
+	q->entry_size = entry_size;
+	q->capacity = capacity;
+	q->account_type = account_type;
+}
+
+/**
+ * mono_lock_free_segment_queue_enqueue_batch:
+ *
+ * Append the \p count entries at \p entries, which are laid out consecutively.
+ * \returns the number of entries added, which is less than \p count only if
+ * the queue is bounded and became full.
+ */
+int
+mono_lock_free_segment_queue_enqueue_batch (MonoLockFreeSegmentQueue *q, gconstpointer entries, int count)
+{
+	gint32 epoch;
+
+	if (count <= 0)
+		return 0;
+
+	if (q->capacity) {
+		gint32 used;
+		do {
+			used = q->num_used_entries;
+			if (used >= q->capacity)
+				return 0;
+			count = MIN (count, q->capacity - used);
+		} while (mono_atomic_cas_i32 (&q->num_used_entries, used + count, used) != used);
+	} else {
+		mono_atomic_add_i32 (&q->num_used_entries, count);
+	}
+
+	epoch = enter (q);
+	enqueue_entries (q, (const char *) entries, count);
+	leave (q, epoch);
+
+	return count;
+}
+
+gboolean
+mono_lock_free_segment_queue_enqueue (MonoLockFreeSegmentQueue *q, gconstpointer entry_data_ptr)
+{
+	return mono_lock_free_segment_queue_enqueue_batch (q, entry_data_ptr, 1) == 1;
+}
+
+/**
+ * mono_lock_free_segment_queue_dequeue_batch:
+ *
+ * Take up to \p count entries from the queue and store them consecutively at
+ * \p entries. Entries are returned in queue order within a segment.
+ * \returns the number of entries taken, 0 if the queue is empty.
+ */
+int
+mono_lock_free_segment_queue_dequeue_batch (MonoLockFreeSegmentQueue *q, gpointer entries, int count)
+{
+	gint32 epoch;
+	int taken;
+
+	if (count <= 0 || !q->num_used_entries)
+		return 0;
+
+	epoch = enter (q);
+	taken = dequeue_entries (q, (char *) entries, count);
+	leave (q, epoch);
+
+	if (taken)
+		mono_atomic_add_i32 (&q->num_used_entries, -taken);
+
+	return taken;
+}
+
+gboolean
+mono_lock_free_segment_queue_dequeue (MonoLockFreeSegmentQueue *q, gpointer entry_data_ptr)
+{
+	return mono_lock_free_segment_queue_dequeue_batch (q, entry_data_ptr, 1) == 1;
+}
+
+/**
+ * mono_lock_free_segment_queue_count:
+ *
+ * The number of entries in the queue. Entries being added are counted
+ * before they can be dequeued.
+ */
+gint32
+mono_lock_free_segment_queue_count (MonoLockFreeSegmentQueue *q)
+{
+	return q->num_used_entries;
+}
+
+/* Must only be called when no other thread uses the queue */
+void
+mono_lock_free_segment_queue_cleanup (MonoLockFreeSegmentQueue *q)
+{
+	Segment *seg, *next;
+
+	for (seg = q->head; seg; seg = next) {
+		next = seg->next;
+		mono_vfree (seg, SEGMENT_BYTES, q->account_type);
+	}
+	for (seg = q->retired; seg; seg = next) {
+		next = seg->retired_next;
+		mono_vfree (seg, SEGMENT_BYTES, q->account_type);
+	}
+	if (q->spare)
+		mono_vfree (q->spare, SEGMENT_BYTES, q->account_type);
+
+	q->head = q->tail = q->retired = q->spare = NULL;
+	q->num_used_entries = 0;
+}
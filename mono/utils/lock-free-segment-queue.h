@@ -0,0 +1,49 @@
+/**
+ * \file
+ * A lock-free multi producer, multi consumer queue of fixed size
+ * entries, stored in segments of many entries each.
+ *
+ * Licensed under the MIT license. See LICENSE file in the project root for full license information.
+ */
+#ifndef __MONO_LOCK_FREE_SEGMENT_QUEUE_H__
+#define __MONO_LOCK_FREE_SEGMENT_QUEUE_H__
+
+#include <glib.h>
+#include <mono/utils/mono-compiler.h>
+#include <mono/utils/mono-mmap.h>
+
+typedef struct _MonoLockFreeSegment MonoLockFreeSegment;
+
+typedef struct {
+	size_t entry_size;
+	/* Maximum number of entries, or 0 if unbounded */
+	gint32 capacity;
+	MonoMemAccountType account_type;
+
+	MonoLockFreeSegment * volatile head;
+	MonoLockFreeSegment * volatile tail;
+	volatile gint32 num_used_entries;
+
+	/* Reclamation of consumed segments, see lock-free-segment-queue.c */
+	volatile gint32 epoch;
+	volatile gint32 active [2];
+	volatile gint32 reclaim_lock;
+	MonoLockFreeSegment * volatile retired;
+	MonoLockFreeSegment * volatile spare;
+} MonoLockFreeSegmentQueue;
+
+#define MONO_LOCK_FREE_SEGMENT_QUEUE_INIT(entry_size, capacity, account_type)	{ (entry_size), (capacity), (account_type) }
+
+void mono_lock_free_segment_queue_init (MonoLockFreeSegmentQueue *q, size_t entry_size, gint32 capacity, MonoMemAccountType account_type);
+
+gboolean mono_lock_free_segment_queue_enqueue (MonoLockFreeSegmentQueue *q, gconstpointer entry_data_ptr);
+int mono_lock_free_segment_queue_enqueue_batch (MonoLockFreeSegmentQueue *q, gconstpointer entries, int count);
+
+gboolean mono_lock_free_segment_queue_dequeue (MonoLockFreeSegmentQueue *q, gpointer entry_data_ptr);
+int mono_lock_free_segment_queue_dequeue_batch (MonoLockFreeSegmentQueue *q, gpointer entries, int count);
+
+gint32 mono_lock_free_segment_queue_count (MonoLockFreeSegmentQueue *q);
+
+void mono_lock_free_segment_queue_cleanup (MonoLockFreeSegmentQueue *q);
+
+#endif
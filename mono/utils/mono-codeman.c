@@ -32,6 +32,8 @@ static size_t dynamic_code_alloc_count;
 static size_t dynamic_code_bytes_count;
 static size_t dynamic_code_frees_count;
 static const MonoCodeManagerCallbacks *code_manager_callbacks;
+/* Whenever code chunks are backed by huge pages, set by MONO_CODE_HUGE_PAGES */
+static gboolean use_huge_pages;
 
 /*
  * AMD64 processors maintain icache coherency only for pages which are 
@@ -43,6 +45,9 @@ static const MonoCodeManagerCallbacks *code_manager_callbacks;
 
 #define MIN_PAGES 16
 
+/* The size and alignment of code chunks when they are backed by huge pages */
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
 #if defined(__x86_64__) || defined (_WIN64)
 /*
  * We require 16 byte alignment on amd64 so the fp literals embedded in the code are 
@@ -102,6 +107,7 @@ codechunk_valloc (void *preferred, guint32 size)
 {
 	void *ptr;
 	GSList *freelist;
+	int flags = MONO_PROT_RWX | ARCH_MAP_FLAGS;
 
 	if (!valloc_freelists) {
 		mono_os_mutex_init_recursive (&valloc_mutex);
@@ -118,10 +124,13 @@ codechunk_valloc (void *preferred, guint32 size)
 		memset (ptr, 0, size);
 		freelist = g_slist_delete_link (freelist, freelist);
 		g_hash_table_insert (valloc_freelists, GUINT_TO_POINTER (size), freelist);
+	} else if (use_huge_pages) {
+		/* The hint could give an unaligned address, and the chunks are big enough anyway */
+		ptr = mono_valloc_aligned (size, HUGE_PAGE_SIZE, flags | MONO_MMAP_HUGEPAGES, MONO_MEM_ACCOUNT_CODE);
 	} else {
-		ptr = mono_valloc (preferred, size, MONO_PROT_RWX | ARCH_MAP_FLAGS, MONO_MEM_ACCOUNT_CODE);
+		ptr = mono_valloc (preferred, size, flags, MONO_MEM_ACCOUNT_CODE);
 		if (!ptr && preferred)
-			ptr = mono_valloc (NULL, size, MONO_PROT_RWX | ARCH_MAP_FLAGS, MONO_MEM_ACCOUNT_CODE);
+			ptr = mono_valloc (NULL, size, flags, MONO_MEM_ACCOUNT_CODE);
 	}
 	mono_os_mutex_unlock (&valloc_mutex);
 	return ptr;
@@ -167,6 +176,8 @@ codechunk_cleanup (void)
 void
 mono_code_manager_init (void)
 {
+	use_huge_pages = g_hasenv ("MONO_CODE_HUGE_PAGES");
+
 	mono_counters_register ("Dynamic code allocs", MONO_COUNTER_JIT | MONO_COUNTER_ULONG, &dynamic_code_alloc_count);
 	mono_counters_register ("Dynamic code bytes", MONO_COUNTER_JIT | MONO_COUNTER_ULONG, &dynamic_code_bytes_count);
 	mono_counters_register ("Dynamic code frees", MONO_COUNTER_JIT | MONO_COUNTER_ULONG, &dynamic_code_frees_count);
@@ -353,6 +364,11 @@ new_codechunk (CodeChunk *last, int dynamic, int size)
 		flags = CODE_FLAG_MALLOC;
 	} else {
 		minsize = MAX (pagesize * MIN_PAGES, valloc_granule);
+		if (use_huge_pages) {
+			/* Fewer, bigger chunks cover the code with fewer iTLB entries */
+			minsize = MAX (minsize, HUGE_PAGE_SIZE);
+			valloc_granule = MAX (valloc_granule, HUGE_PAGE_SIZE);
+		}
 		if (size < minsize)
 			chunk_size = minsize;
 		else {
@@ -10,39 +10,62 @@
 
 #include "mono-conc-hashtable.h"
 #include <mono/utils/hazard-pointer.h>
+#include <mono/utils/atomic.h>
+#include <mono/utils/mono-threads.h>
 
 /* Configuration knobs. */
 
 #define INITIAL_SIZE 32
 #define LOAD_FACTOR 0.75f
+#define LOCK_STRIPES 16
+#define MIGRATION_CHUNK 64
 #define TOMBSTONE ((gpointer)(ssize_t)-1)
+/* As a key: free slot sealed by a resize. As a value: entry copied to the next table. */
+#define MOVED ((gpointer)(ssize_t)-2)
 
 typedef struct {
 	gpointer key;
 	gpointer value;
 } key_value_pair;
 
-typedef struct {
+typedef struct _conc_table conc_table;
+
+struct _conc_table {
 	int table_size;
+	int overflow_count;
+	gint32 element_count; //KVP + tombstones
+	gint32 tombstone_count; //just tombstones
+	conc_table * volatile next; /* table we are being resized into, goes to HP1 */
+	gint32 migrate_index; /* first slot not yet claimed by a migrating thread */
+	gint32 migrated_count;
 	key_value_pair *kvs;
-} conc_table;
+};
 
 /*
 Design notes:
 
-This is a single-writer, lock-free reader hash table. It's implemented using classical linear open addressing.
+This is a lock-free reader, striped-lock writer hash table. It's implemented using classical linear open addressing.
 
 Reads are made concurrent by employing hazzard pointers to avoid dangling pointer and by carefully coordinating
-table access between writer and readers - writer stores value before key and readers checks keys before values.
+table access between writers and readers - writers claim a slot by CAS'ing its key and only then store the value,
+readers check keys before values and treat a NULL value as a missing entry.
 
-External locking/synchronization is required by all write operations. Additionally, this DS don't try to provide
-any coordination/guarantee of key/values liveness outside of this DS. This means that a search will see dangling
-memory if a concurrent thread removes&free after the search succeeded.
+Writers take the lock stripe selected by the hash of the key, so all operations on a given key are serialized
+while writers of unrelated keys only race for free slots, which the CAS settles. Additionally, this DS don't try
+to provide any coordination/guarantee of key/values liveness outside of this DS. This means that a search will
+see dangling memory if a concurrent thread removes&free after the search succeeded.
 
 Deletion is done using tombstones, which increase the number of non-null elements and can lead to slow or infinite
 searches as null keys are the termination condition used by lookup. We handle it by rehashing in case the number of
 null values drops below what the load factor allows.
 
+Rehashing is incremental and cooperative: the writer which finds the table full hangs a bigger table off
+table->next and every writer which comes along moves MIGRATION_CHUNK slots over before doing its own work.
+Free slots are sealed with MOVED so late inserts go to the new table, live entries are copied under the lock
+stripe of their key and then have their value replaced with MOVED. An operation on a key first moves that
+key out of the old table, so a key is live in at most one table. Lookups which hit a sealed slot or miss
+continue into table->next. The last thread to finish a chunk publishes the new table.
+
 Possible improvements:
 
 Experiment with KVM relocation during lookup as would reduce search length. The trick is coordinate which thread
@@ -53,18 +76,17 @@ struct _MonoConcurrentHashTable {
 	volatile conc_table *table; /* goes to HP0 */
 	GHashFunc hash_func;
 	GEqualFunc equal_func;
-	int element_count; //KVP + tombstones
-	int tombstone_count; //just tombstones
-	int overflow_count;
 	GDestroyNotify key_destroy_func;
 	GDestroyNotify value_destroy_func;
+	mono_mutex_t locks [LOCK_STRIPES];
 };
 
 static conc_table*
 conc_table_new (int size)
 {
-	conc_table *res = g_new (conc_table, 1);
+	conc_table *res = g_new0 (conc_table, 1);
 	res->table_size = size;
+	res->overflow_count = (int)(size * LOAD_FACTOR);
 	res->kvs = g_new0 (key_value_pair, size);
 	return res;
 }
@@ -98,66 +120,282 @@ mix_hash (int hash)
 	return ((hash * 215497) >> 16) ^ (hash * 1823231 + hash);
 }
 
-static MONO_ALWAYS_INLINE void
-insert_one_local (conc_table *table, GHashFunc hash_func, gpointer key, gpointer value)
+static MONO_ALWAYS_INLINE mono_mutex_t*
+key_lock (MonoConcurrentHashTable *hash_table, int hash)
+{
+	return &hash_table->locks [(hash >> 8) & (LOCK_STRIPES - 1)];
+}
+
+static MONO_ALWAYS_INLINE gboolean
+key_matches (MonoConcurrentHashTable *hash_table, gpointer key, gpointer slot_key)
+{
+	if (key == slot_key)
+		return TRUE;
+	return hash_table->equal_func && slot_key != TOMBSTONE && slot_key != MOVED && hash_table->equal_func (key, slot_key);
+}
+
+/*
+ * Protect NEXT, the table TABLE is being resized into, with hazard pointer HP_INDEX.
+ * Returns FALSE if NEXT might have been freed already.
+ */
+static gboolean
+protect_next_table (MonoConcurrentHashTable *hash_table, conc_table *table, conc_table *next, MonoThreadHazardPointers *hp, int hp_index)
+{
+	conc_table *current;
+
+	mono_hazard_pointer_set (hp, hp_index, next);
+	mono_memory_barrier ();
+	current = (conc_table*)hash_table->table;
+	/* A table is only freed after the one it was resized into was replaced too */
+	return current == table || current == next;
+}
+
+/*
+ * Insert KEY into TABLE unless it's already there, in which case its value is returned in OLD_VALUE.
+ * Returns FALSE if TABLE is being resized or has no room left.
+ * LOCKING: Must be called holding the lock stripe of KEY.
+ */
+static gboolean
+insert_locked (MonoConcurrentHashTable *hash_table, conc_table *table, gpointer key, gpointer value, int hash, gpointer *old_value)
+{
+	key_value_pair *kvs = table->kvs;
+	key_value_pair *free_slot;
+	gpointer free_key;
+	int i, probes, table_mask = table->table_size - 1;
+
+retry:
+	free_slot = NULL;
+	free_key = NULL;
+	i = hash & table_mask;
+	for (probes = 0; probes < table->table_size; ++probes) {
+		gpointer k = kvs [i].key;
+
+		if (k == MOVED)
+			return FALSE;
+		if (!k || k == TOMBSTONE) {
+			if (!free_slot) {
+				free_slot = &kvs [i];
+				free_key = k;
+			}
+			if (!k)
+				break;
+		} else if (key_matches (hash_table, key, k)) {
+			*old_value = kvs [i].value;
+			return TRUE;
+		}
+		i = (i + 1) & table_mask;
+	}
+
+	if (!free_slot)
+		return FALSE;
+	/* Another writer or a resize got to the slot first */
+	if (mono_atomic_cas_ptr (&free_slot->key, key, free_key) != free_key)
+		goto retry;
+
+	if (free_key == TOMBSTONE)
+		mono_atomic_dec_i32 (&table->tombstone_count);
+	else
+		mono_atomic_inc_i32 (&table->element_count);
+	/* Readers take a NULL value to mean the key is not there yet */
+	mono_atomic_store_ptr (&free_slot->value, value);
+	*old_value = NULL;
+	return TRUE;
+}
+
+/*
+ * Copy the entry in SLOT into NEXT and mark it as moved.
+ * LOCKING: Must be called holding the lock stripe of KEY.
+ */
+static void
+migrate_entry_locked (MonoConcurrentHashTable *hash_table, conc_table *next, key_value_pair *slot, gpointer key, int hash)
+{
+	gpointer value = slot->value;
+	gpointer old_value;
+
+	if (!value || value == MOVED)
+		return;
+
+	/* NEXT can't be resized before this table is fully moved into it */
+	if (!insert_locked (hash_table, next, key, value, hash, &old_value))
+		g_error ("Concurrent hashtable ran out of space while resizing");
+	g_assert (!old_value);
+
+	/* The copy must be visible before readers are sent to it */
+	mono_memory_barrier ();
+	slot->value = MOVED;
+}
+
+/* Move KEY from TABLE into NEXT. LOCKING: Must be called holding the lock stripe of KEY. */
+static void
+migrate_key_locked (MonoConcurrentHashTable *hash_table, conc_table *table, conc_table *next, gpointer key, int hash)
 {
 	key_value_pair *kvs = table->kvs;
 	int table_mask = table->table_size - 1;
-	int hash = mix_hash (hash_func (key));
 	int i = hash & table_mask;
 
-	while (table->kvs [i].key)
+	for (;;) {
+		gpointer k = kvs [i].key;
+
+		if (!k || k == MOVED)
+			return;
+		if (key_matches (hash_table, key, k)) {
+			migrate_entry_locked (hash_table, next, &kvs [i], k, hash);
+			return;
+		}
 		i = (i + 1) & table_mask;
+	}
+}
+
+static void
+migrate_slot (MonoConcurrentHashTable *hash_table, conc_table *next, key_value_pair *slot)
+{
+	for (;;) {
+		gpointer key = slot->key;
+		mono_mutex_t *lock;
+		int hash;
+
+		if (key == MOVED)
+			return;
+		if (!key || key == TOMBSTONE) {
+			/* Seal it so no insert can land here after we moved past it */
+			if (mono_atomic_cas_ptr (&slot->key, MOVED, key) == key)
+				return;
+			continue;
+		}
 
-	kvs [i].key = key;
-	kvs [i].value = value;
+		hash = mix_hash (hash_table->hash_func (key));
+		lock = key_lock (hash_table, hash);
+		mono_os_mutex_lock (lock);
+		/* The slot might have been removed and reused for another key */
+		if (slot->key == key) {
+			migrate_entry_locked (hash_table, next, slot, key, hash);
+			if (slot->value == MOVED) {
+				mono_os_mutex_unlock (lock);
+				return;
+			}
+		}
+		mono_os_mutex_unlock (lock);
+	}
+}
+
+/*
+ * Move the next chunk of TABLE into NEXT and publish NEXT if that was the last one.
+ * Returns FALSE if there was nothing left to claim.
+ */
+static gboolean
+migrate_chunk (MonoConcurrentHashTable *hash_table, conc_table *table, conc_table *next)
+{
+	int start, end, i;
+
+	if (table->migrate_index >= table->table_size)
+		return FALSE;
+	start = mono_atomic_fetch_add_i32 (&table->migrate_index, MIGRATION_CHUNK);
+	if (start >= table->table_size)
+		return FALSE;
+	end = MIN (start + MIGRATION_CHUNK, table->table_size);
+
+	for (i = start; i < end; ++i)
+		migrate_slot (hash_table, next, &table->kvs [i]);
+
+	if (mono_atomic_add_i32 (&table->migrated_count, end - start) == table->table_size) {
+		mono_memory_barrier ();
+		hash_table->table = next;
+		conc_table_lf_free (table);
+	}
+	return TRUE;
 }
 
-/* LOCKING: Must be called holding hash_table->mutex */
 static void
-rehash_table (MonoConcurrentHashTable *hash_table, int multiplier)
+start_resize (conc_table *table)
 {
-	conc_table *old_table = (conc_table*)hash_table->table;
-	conc_table *new_table = conc_table_new (old_table->table_size * multiplier);
-	key_value_pair *kvs = old_table->kvs;
-	int i;
+	conc_table *next;
+
+	//if we have more tombstones than KVP we rehash to the same size
+	if (table->tombstone_count > table->element_count / 2)
+		next = conc_table_new (table->table_size);
+	else
+		next = conc_table_new (table->table_size * 2);
 
-	for (i = 0; i < old_table->table_size; ++i) {
-		if (kvs [i].key && kvs [i].key != TOMBSTONE)
-			insert_one_local (new_table, hash_table->hash_func, kvs [i].key, kvs [i].value);
+	if (mono_atomic_cas_ptr ((gpointer volatile*)&table->next, next, NULL) != NULL)
+		conc_table_free (next);
+}
+
+/*
+ * Do our share of an ongoing resize. If FINISH is TRUE, don't return before it's done.
+ */
+static void
+help_resize (MonoConcurrentHashTable *hash_table, MonoThreadHazardPointers *hp, gboolean finish)
+{
+	conc_table *table, *next;
+
+	table = (conc_table *)mono_get_hazardous_pointer ((gpointer volatile*)&hash_table->table, hp, 0);
+	next = table->next;
+	if (next && protect_next_table (hash_table, table, next, hp, 1)) {
+		do {
+			/* Other threads are still moving the chunks they claimed */
+			if (!migrate_chunk (hash_table, table, next) && finish)
+				mono_thread_info_yield ();
+		} while (finish && hash_table->table == table);
 	}
-	mono_memory_barrier ();
-	hash_table->table = new_table;
-	hash_table->overflow_count = (int)(new_table->table_size * LOAD_FACTOR);
-	hash_table->element_count -= hash_table->tombstone_count;
-	hash_table->tombstone_count = 0;
-	conc_table_lf_free (old_table);
+	mono_hazard_pointer_clear (hp, 0);
+	mono_hazard_pointer_clear (hp, 1);
 }
 
 static void
-check_table_size (MonoConcurrentHashTable *hash_table)
+check_table_size (MonoConcurrentHashTable *hash_table, MonoThreadHazardPointers *hp)
 {
-	if (hash_table->element_count >= hash_table->overflow_count) {
-		//if we have more tombstones than KVP we rehash to the same size
-		if (hash_table->tombstone_count > hash_table->element_count / 2)
-			rehash_table (hash_table, 1);
-		else
-			rehash_table (hash_table, 2);
+	conc_table *table, *next;
+
+retry:
+	table = (conc_table *)mono_get_hazardous_pointer ((gpointer volatile*)&hash_table->table, hp, 0);
+	next = table->next;
+	if (!next) {
+		if (table->element_count >= table->overflow_count)
+			start_resize (table);
+	} else if (protect_next_table (hash_table, table, next, hp, 1) && next->element_count >= next->overflow_count) {
+		/* The table we are moving into is already full, it must be published before it can grow */
+		help_resize (hash_table, hp, TRUE);
+		goto retry;
 	}
+	mono_hazard_pointer_clear (hp, 0);
+	mono_hazard_pointer_clear (hp, 1);
 }
 
+/*
+ * Return the newest table, moving KEY out of the tables being resized on the way.
+ * LOCKING: Must be called holding the lock stripe of KEY.
+ */
+static conc_table*
+get_write_table_locked (MonoConcurrentHashTable *hash_table, MonoThreadHazardPointers *hp, gpointer key, int hash)
+{
+	conc_table *table, *next;
+	int hp_index;
 
+retry:
+	hp_index = 0;
+	table = (conc_table *)mono_get_hazardous_pointer ((gpointer volatile*)&hash_table->table, hp, 0);
+	while ((next = table->next)) {
+		if (!protect_next_table (hash_table, table, next, hp, 1 - hp_index))
+			goto retry;
+		migrate_key_locked (hash_table, table, next, key, hash);
+		table = next;
+		hp_index = 1 - hp_index;
+	}
+	return table;
+}
 
 MonoConcurrentHashTable*
 mono_conc_hashtable_new (GHashFunc hash_func, GEqualFunc key_equal_func)
 {
 	MonoConcurrentHashTable *res = g_new0 (MonoConcurrentHashTable, 1);
+	int i;
+
 	res->hash_func = hash_func ? hash_func : g_direct_hash;
 	res->equal_func = key_equal_func;
 	// res->equal_func = g_direct_equal;
 	res->table = conc_table_new (INITIAL_SIZE);
-	res->element_count = 0;
-	res->overflow_count = (int)(INITIAL_SIZE * LOAD_FACTOR);
+	for (i = 0; i < LOCK_STRIPES; ++i)
+		mono_os_mutex_init (&res->locks [i]);
 	return res;
 }
 
@@ -174,21 +412,28 @@ mono_conc_hashtable_new_full (GHashFunc hash_func, GEqualFunc key_equal_func, GD
 void
 mono_conc_hashtable_destroy (MonoConcurrentHashTable *hash_table)
 {
-	if (hash_table->key_destroy_func || hash_table->value_destroy_func) {
-		int i;
-		conc_table *table = (conc_table*)hash_table->table;
+	conc_table *table = (conc_table*)hash_table->table;
+	int i;
+
+	while (table) {
+		conc_table *next = table->next;
 		key_value_pair *kvs = table->kvs;
 
-		for (i = 0; i < table->table_size; ++i) {
-			if (kvs [i].key && kvs [i].key != TOMBSTONE) {
-				if (hash_table->key_destroy_func)
-					(hash_table->key_destroy_func) (kvs [i].key);
-				if (hash_table->value_destroy_func)
-					(hash_table->value_destroy_func) (kvs [i].value);
+		if (hash_table->key_destroy_func || hash_table->value_destroy_func) {
+			for (i = 0; i < table->table_size; ++i) {
+				if (kvs [i].key && kvs [i].key != TOMBSTONE && kvs [i].key != MOVED && kvs [i].value && kvs [i].value != MOVED) {
+					if (hash_table->key_destroy_func)
+						(hash_table->key_destroy_func) (kvs [i].key);
+					if (hash_table->value_destroy_func)
+						(hash_table->value_destroy_func) (kvs [i].value);
+				}
 			}
 		}
+		conc_table_free (table);
+		table = next;
 	}
-	conc_table_free ((gpointer)hash_table->table);
+	for (i = 0; i < LOCK_STRIPES; ++i)
+		mono_os_mutex_destroy (&hash_table->locks [i]);
 	g_free (hash_table);
 }
 
@@ -196,197 +441,169 @@ gpointer
 mono_conc_hashtable_lookup (MonoConcurrentHashTable *hash_table, gpointer key)
 {
 	MonoThreadHazardPointers* hp;
-	conc_table *table;
-	int hash, i, table_mask;
+	conc_table *table, *next;
+	int hash, i, table_mask, hp_index;
 	key_value_pair *kvs;
+	gpointer value;
 	hash = mix_hash (hash_table->hash_func (key));
 	hp = mono_hazard_pointer_get ();
 
 retry:
+	hp_index = 0;
 	table = (conc_table *)mono_get_hazardous_pointer ((gpointer volatile*)&hash_table->table, hp, 0);
-	table_mask = table->table_size - 1;
-	kvs = table->kvs;
-	i = hash & table_mask;
 
-	if (G_LIKELY (!hash_table->equal_func)) {
-		while (kvs [i].key) {
-			if (key == kvs [i].key) {
-				gpointer value;
-				/* The read of keys must happen before the read of values */
-				mono_memory_barrier ();
-				value = kvs [i].value;
-				/* FIXME check for NULL if we add suppport for removal */
-				mono_hazard_pointer_clear (hp, 0);
-				return value;
-			}
-			i = (i + 1) & table_mask;
-		}
-	} else {
-		GEqualFunc equal = hash_table->equal_func;
+	for (;;) {
+		table_mask = table->table_size - 1;
+		kvs = table->kvs;
+		i = hash & table_mask;
+
+		for (;;) {
+			gpointer k = kvs [i].key;
 
-		while (kvs [i].key) {
-			if (kvs [i].key != TOMBSTONE && equal (key, kvs [i].key)) {
-				gpointer value;
+			/* Inserts never go past a sealed slot */
+			if (!k || k == MOVED)
+				break;
+			if (key_matches (hash_table, key, k)) {
 				/* The read of keys must happen before the read of values */
 				mono_memory_barrier ();
 				value = kvs [i].value;
-
-				/* We just read a value been deleted, try again. */
-				if (G_UNLIKELY (!value))
+				/* The slot might have been removed and reused for another key in between */
+				mono_memory_read_barrier ();
+				if (G_UNLIKELY (kvs [i].key != k))
 					goto retry;
+				if (value == MOVED)
+					break;
 
-				mono_hazard_pointer_clear (hp, 0);
-				return value;
+				/* A NULL value is an insert or a remove in progress */
+				goto done;
 			}
 			i = (i + 1) & table_mask;
 		}
-	}
 
-	/* The table might have expanded and the value is now on the newer table */
-	mono_memory_barrier ();
-	if (hash_table->table != table)
-		goto retry;
+		/* The key might be in the table we are being resized into */
+		mono_memory_barrier ();
+		next = table->next;
+		if (!next) {
+			value = NULL;
+			goto done;
+		}
+		hp_index = 1 - hp_index;
+		if (!protect_next_table (hash_table, table, next, hp, hp_index))
+			goto retry;
+		table = next;
+	}
 
+done:
 	mono_hazard_pointer_clear (hp, 0);
-	return NULL;
+	mono_hazard_pointer_clear (hp, 1);
+	return value;
 }
 
 /**
  * mono_conc_hashtable_remove:
- * Remove a value from the hashtable. Requires external locking
+ * Remove a value from the hashtable. Can be called concurrently with other writers.
  * \returns the old value if \p key is already present or NULL
  */
 gpointer
 mono_conc_hashtable_remove (MonoConcurrentHashTable *hash_table, gpointer key)
 {
+	MonoThreadHazardPointers* hp;
+	mono_mutex_t *lock;
 	conc_table *table;
 	key_value_pair *kvs;
+	gpointer old_key = NULL, value = NULL;
 	int hash, i, table_mask;
 
-	g_assert (key != NULL && key != TOMBSTONE);
+	g_assert (key != NULL && key != TOMBSTONE && key != MOVED);
 
 	hash = mix_hash (hash_table->hash_func (key));
+	hp = mono_hazard_pointer_get ();
+	lock = key_lock (hash_table, hash);
+
+	help_resize (hash_table, hp, FALSE);
 
-	table = (conc_table*)hash_table->table;
+	mono_os_mutex_lock (lock);
+	table = get_write_table_locked (hash_table, hp, key, hash);
 	kvs = table->kvs;
 	table_mask = table->table_size - 1;
 	i = hash & table_mask;
 
-	if (!hash_table->equal_func) {
-		for (;;) {
-			if (!kvs [i].key) {
-				return NULL; /*key not found*/
-			}
+	for (;;) {
+		gpointer k = kvs [i].key;
 
-			if (key == kvs [i].key) {
-				gpointer value = kvs [i].value;
-				kvs [i].value = NULL;
-				mono_memory_barrier ();
-				kvs [i].key = TOMBSTONE;
-				++hash_table->tombstone_count;
-
-				if (hash_table->key_destroy_func != NULL)
-					(*hash_table->key_destroy_func) (key);
-				if (hash_table->value_destroy_func != NULL)
-					(*hash_table->value_destroy_func) (value);
+		if (!k || k == MOVED)
+			break; /*key not found*/
 
-				check_table_size (hash_table);
-				return value;
-			}
-			i = (i + 1) & table_mask;
+		if (key_matches (hash_table, key, k)) {
+			old_key = k;
+			value = kvs [i].value;
+			kvs [i].value = NULL;
+			mono_memory_barrier ();
+			kvs [i].key = TOMBSTONE;
+			mono_atomic_inc_i32 (&table->tombstone_count);
+			break;
 		}
-	} else {
-		GEqualFunc equal = hash_table->equal_func;
-		for (;;) {
-			if (!kvs [i].key) {
-				return NULL; /*key not found*/
-			}
-
-			if (kvs [i].key != TOMBSTONE && equal (key, kvs [i].key)) {
-				gpointer old_key = kvs [i].key;
-				gpointer value = kvs [i].value;
-				kvs [i].value = NULL;
-				mono_memory_barrier ();
-				kvs [i].key = TOMBSTONE;
-				++hash_table->tombstone_count;
+		i = (i + 1) & table_mask;
+	}
+	mono_os_mutex_unlock (lock);
+	mono_hazard_pointer_clear (hp, 0);
+	mono_hazard_pointer_clear (hp, 1);
 
-				if (hash_table->key_destroy_func != NULL)
-					(*hash_table->key_destroy_func) (old_key);
-				if (hash_table->value_destroy_func != NULL)
-					(*hash_table->value_destroy_func) (value);
+	if (!value)
+		return NULL;
 
-				check_table_size (hash_table);
-				return value;
-			}
+	if (hash_table->key_destroy_func != NULL)
+		(*hash_table->key_destroy_func) (old_key);
+	if (hash_table->value_destroy_func != NULL)
+		(*hash_table->value_destroy_func) (value);
 
-			i = (i + 1) & table_mask;
-		}
-	}
+	check_table_size (hash_table, hp);
+	return value;
 }
 /**
  * mono_conc_hashtable_insert:
- * Insert a value into the hashtable. Requires external locking.
+ * Insert a value into the hashtable. Can be called concurrently with other writers.
  * \returns the old value if \p key is already present or NULL
  */
 gpointer
 mono_conc_hashtable_insert (MonoConcurrentHashTable *hash_table, gpointer key, gpointer value)
 {
+	MonoThreadHazardPointers* hp;
+	mono_mutex_t *lock;
 	conc_table *table;
-	key_value_pair *kvs;
-	int hash, i, table_mask;
+	gpointer old_value;
+	int hash;
 
-	g_assert (key != NULL && key != TOMBSTONE);
-	g_assert (value != NULL);
+	g_assert (key != NULL && key != TOMBSTONE && key != MOVED);
+	g_assert (value != NULL && value != MOVED);
 
 	hash = mix_hash (hash_table->hash_func (key));
-
-	check_table_size (hash_table);
-
-	table = (conc_table*)hash_table->table;
-	kvs = table->kvs;
-	table_mask = table->table_size - 1;
-	i = hash & table_mask;
-
-	if (!hash_table->equal_func) {
-		for (;;) {
-			if (!kvs [i].key || kvs [i].key == TOMBSTONE) {
-				kvs [i].value = value;
-				/* The write to values must happen after the write to keys */
-				mono_memory_barrier ();
-				if (kvs [i].key == TOMBSTONE)
-					--hash_table->tombstone_count;
-				else
-					++hash_table->element_count;	
-				kvs [i].key = key;
-				return NULL;
-			}
-			if (key == kvs [i].key) {
-				gpointer value = kvs [i].value;
-				return value;
-			}
-			i = (i + 1) & table_mask;
-		}
-	} else {
-		GEqualFunc equal = hash_table->equal_func;
-		for (;;) {
-			if (!kvs [i].key || kvs [i].key == TOMBSTONE) {
-				kvs [i].value = value;
-				/* The write to values must happen after the write to keys */
-				mono_memory_barrier ();
-				if (kvs [i].key == TOMBSTONE)
-					--hash_table->tombstone_count;
-				else
-					++hash_table->element_count;
-				kvs [i].key = key;
-				return NULL;
-			}
-			if (equal (key, kvs [i].key)) {
-				gpointer value = kvs [i].value;
-				return value;
-			}
-			i = (i + 1) & table_mask;
-		}
+	hp = mono_hazard_pointer_get ();
+	lock = key_lock (hash_table, hash);
+
+	help_resize (hash_table, hp, FALSE);
+
+	mono_os_mutex_lock (lock);
+	for (;;) {
+		table = get_write_table_locked (hash_table, hp, key, hash);
+		if (insert_locked (hash_table, table, key, value, hash, &old_value))
+			break;
+
+		/* The table is being resized or is full, we can't move other keys while holding our stripe */
+		mono_os_mutex_unlock (lock);
+		mono_hazard_pointer_clear (hp, 0);
+		mono_hazard_pointer_clear (hp, 1);
+		check_table_size (hash_table, hp);
+		help_resize (hash_table, hp, TRUE);
+		mono_os_mutex_lock (lock);
 	}
+	mono_os_mutex_unlock (lock);
+	mono_hazard_pointer_clear (hp, 0);
+	mono_hazard_pointer_clear (hp, 1);
+
+	if (!old_value)
+		check_table_size (hash_table, hp);
+	return old_value;
 }
 
 /**
@@ -397,12 +614,15 @@ void
 mono_conc_hashtable_foreach (MonoConcurrentHashTable *hash_table, GHFunc func, gpointer userdata)
 {
 	int i;
-	conc_table *table = (conc_table*)hash_table->table;
-	key_value_pair *kvs = table->kvs;
+	conc_table *table;
 
-	for (i = 0; i < table->table_size; ++i) {
-		if (kvs [i].key && kvs [i].key != TOMBSTONE) {
-			func (kvs [i].key, kvs [i].value, userdata);
+	for (table = (conc_table*)hash_table->table; table; table = table->next) {
+		key_value_pair *kvs = table->kvs;
+
+		for (i = 0; i < table->table_size; ++i) {
+			if (kvs [i].key && kvs [i].key != TOMBSTONE && kvs [i].key != MOVED && kvs [i].value && kvs [i].value != MOVED) {
+				func (kvs [i].key, kvs [i].value, userdata);
+			}
 		}
 	}
 }
@@ -417,18 +637,21 @@ void
 mono_conc_hashtable_foreach_steal (MonoConcurrentHashTable *hash_table, GHRFunc func, gpointer userdata)
 {
 	int i;
-	conc_table *table = (conc_table*)hash_table->table;
-	key_value_pair *kvs = table->kvs;
+	conc_table *table;
 
-	for (i = 0; i < table->table_size; ++i) {
-		if (kvs [i].key && kvs [i].key != TOMBSTONE) {
-			if (func (kvs [i].key, kvs [i].value, userdata)) {
-				kvs [i].value = NULL;
-				mono_memory_barrier ();
-				kvs [i].key = TOMBSTONE;
-				++hash_table->tombstone_count;
+	for (table = (conc_table*)hash_table->table; table; table = table->next) {
+		key_value_pair *kvs = table->kvs;
+
+		for (i = 0; i < table->table_size; ++i) {
+			if (kvs [i].key && kvs [i].key != TOMBSTONE && kvs [i].key != MOVED && kvs [i].value && kvs [i].value != MOVED) {
+				if (func (kvs [i].key, kvs [i].value, userdata)) {
+					kvs [i].value = NULL;
+					mono_memory_barrier ();
+					kvs [i].key = TOMBSTONE;
+					mono_atomic_inc_i32 (&table->tombstone_count);
+				}
 			}
 		}
 	}
-	check_table_size (hash_table);
+	check_table_size (hash_table, mono_hazard_pointer_get ());
 }
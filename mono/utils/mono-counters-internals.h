@@ -0,0 +1,51 @@
+/**
+ * \file
+ * Runtime internal counter storage
+ *
+ * Licensed under the MIT license. See LICENSE file in the project root for full license information.
+ */
+
+#ifndef __MONO_COUNTERS_INTERNALS_H__
+#define __MONO_COUNTERS_INTERNALS_H__
+
+#include <glib.h>
+#include <mono/utils/mono-counters.h>
+#include <mono/utils/atomic.h>
+
+/* Power of 2 */
+#define MONO_COUNTER_SHARDS 32
+#define MONO_COUNTER_SHARD_SIZE 64
+
+typedef struct {
+	gint64 value;
+	char padding [MONO_COUNTER_SHARD_SIZE - sizeof (gint64)];
+} MonoCounterShard;
+
+/*
+ * A 64 bit counter for hot paths. Every thread updates its own cache line, and
+ * the shards are only summed up when the counter is sampled. Register it with
+ * MONO_COUNTER_LONG | MONO_COUNTER_SHARDED.
+ */
+typedef struct {
+	MonoCounterShard shards [MONO_COUNTER_SHARDS];
+} MonoShardedCounter;
+
+int
+mono_counters_get_shard (void);
+
+gint64
+mono_sharded_counter_get (MonoShardedCounter *counter);
+
+static inline void
+mono_sharded_counter_add (MonoShardedCounter *counter, gint64 value)
+{
+	mono_atomic_add_i64 (&counter->shards [mono_counters_get_shard ()].value, value);
+}
+
+static inline void
+mono_sharded_counter_inc (MonoShardedCounter *counter)
+{
+	mono_sharded_counter_add (counter, 1);
+}
+
+#endif /* __MONO_COUNTERS_INTERNALS_H__ */
@@ -9,6 +9,7 @@
 #include <glib.h>
 #include "config.h"
 #include "mono-counters.h"
+#include "mono-counters-internals.h"
 #include "mono-proclib.h"
 #include "mono-os-mutex.h"
 
@@ -36,6 +37,49 @@ static GSList *register_callbacks = NULL;
 
 static void initialize_system_counters (void);
 
+static gint32 next_shard;
+
+#ifdef MONO_KEYWORD_THREAD
+static MONO_KEYWORD_THREAD int current_shard = -1;
+#endif
+
+/**
+ * mono_counters_get_shard:
+ *
+ * \returns the index of the shard of \c MonoShardedCounter the current thread updates.
+ */
+int
+mono_counters_get_shard (void)
+{
+#ifdef MONO_KEYWORD_THREAD
+	if (G_UNLIKELY (current_shard == -1))
+		current_shard = mono_atomic_inc_i32 (&next_shard) & (MONO_COUNTER_SHARDS - 1);
+	return current_shard;
+#else
+	/* Threads run on different stacks */
+	int dummy;
+	return ((gsize) &dummy >> 16) & (MONO_COUNTER_SHARDS - 1);
+#endif
+}
+
+/**
+ * mono_sharded_counter_get:
+ *
+ * \returns the sum of the shards of \p counter. Updates racing with the call
+ * might or might not be included.
+ */
+gint64
+mono_sharded_counter_get (MonoShardedCounter *counter)
+{
+	gint64 sum = 0;
+	int i;
+
+	for (i = 0; i < MONO_COUNTER_SHARDS; ++i)
+		sum += mono_atomic_load_i64 (&counter->shards [i].value);
+
+	return sum;
+}
+
 /**
  * mono_counter_get_variance:
  * \param counter counter to get the variance
@@ -476,6 +520,14 @@ sample_internal (MonoCounter *counter, void *buffer, int buffer_size)
 		break;
 	case MONO_COUNTER_LONG:
 	case MONO_COUNTER_TIME_INTERVAL:
+		if (counter->type & MONO_COUNTER_SHARDED) {
+			size = sizeof (gint64);
+			if (buffer_size < size)
+				size = -1;
+			else
+				*(gint64*)buffer = mono_sharded_counter_get ((MonoShardedCounter *) counter->addr);
+			break;
+		}
 		COPY_COUNTER (gint64, LongFunc);
 		break;
 	case MONO_COUNTER_ULONG:
@@ -628,6 +680,120 @@ mono_counters_dump (int section_mask, FILE *outfile)
 	mono_os_mutex_unlock (&counters_mutex);
 }
 
+static void
+dump_counter_prometheus (MonoCounter *counter, const char *section, FILE *outfile)
+{
+	GString *name;
+	const char *p, *suffix = "";
+	double scale = 1, value;
+	int size, unit = mono_counter_get_unit (counter);
+	void *buffer;
+
+	if (mono_counter_get_type (counter) == MONO_COUNTER_STRING)
+		return;
+
+	buffer = g_malloc0 (counter->size);
+	size = sample_internal (counter, buffer, counter->size);
+	if (size <= 0) {
+		g_free (buffer);
+		return;
+	}
+
+	switch (mono_counter_get_type (counter)) {
+	case MONO_COUNTER_INT:
+		value = *(int*)buffer;
+		break;
+	case MONO_COUNTER_UINT:
+		value = *(guint*)buffer;
+		break;
+	case MONO_COUNTER_LONG:
+		value = (double)*(gint64*)buffer;
+		break;
+	case MONO_COUNTER_ULONG:
+		value = (double)*(guint64*)buffer;
+		break;
+	case MONO_COUNTER_WORD:
+		value = (double)*(gssize*)buffer;
+		break;
+	case MONO_COUNTER_DOUBLE:
+		value = *(double*)buffer;
+		break;
+	case MONO_COUNTER_TIME_INTERVAL:
+		/* usecs */
+		value = (double)*(gint64*)buffer;
+		scale = 1e-6;
+		suffix = "_seconds";
+		break;
+	default:
+		g_free (buffer);
+		return;
+	}
+	g_free (buffer);
+
+	if (unit == MONO_COUNTER_TIME && mono_counter_get_type (counter) != MONO_COUNTER_TIME_INTERVAL) {
+		/* 100ns units */
+		scale = 1e-7;
+		suffix = "_seconds";
+	} else if (unit == MONO_COUNTER_BYTES) {
+		suffix = "_bytes";
+	}
+
+	/* Metric names only allow [a-zA-Z0-9_:] */
+	name = g_string_new ("mono_");
+	for (p = section; *p; ++p)
+		g_string_append_c (name, g_ascii_isalnum (*p) ? g_ascii_tolower (*p) : '_');
+	g_string_append_c (name, '_');
+	for (p = counter->name; *p; ++p) {
+		char c = g_ascii_isalnum (*p) ? g_ascii_tolower (*p) : '_';
+		if (c != '_' || name->str [name->len - 1] != '_')
+			g_string_append_c (name, c);
+	}
+	while (name->str [name->len - 1] == '_')
+		g_string_truncate (name, name->len - 1);
+	g_string_append (name, suffix);
+
+	fprintf (outfile, "# HELP %s %s\n", name->str, counter->name);
+	fprintf (outfile, "# TYPE %s %s\n", name->str, mono_counter_get_variance (counter) == MONO_COUNTER_MONOTONIC ? "counter" : "gauge");
+	fprintf (outfile, "%s %.17g\n", name->str, value * scale);
+
+	g_string_free (name, TRUE);
+}
+
+/**
+ * mono_counters_dump_prometheus:
+ * \param section_mask The sections to dump counters for
+ * \param outfile a FILE to dump the results to
+ * Writes the values of all the enabled counters registered in the Prometheus text
+ * exposition format, so they can be served to a scraper. String counters are skipped,
+ * times are converted to seconds.
+ */
+void
+mono_counters_dump_prometheus (int section_mask, FILE *outfile)
+{
+	MonoCounter *counter;
+	int i, j;
+
+	section_mask &= valid_mask;
+
+	if (!initialized)
+		return;
+
+	mono_os_mutex_lock (&counters_mutex);
+
+	for (j = 0, i = MONO_COUNTER_JIT; i < MONO_COUNTER_LAST_SECTION; j++, i <<= 1) {
+		if (!(section_mask & i) || !(set_mask & i))
+			continue;
+
+		for (counter = counters; counter; counter = counter->next) {
+			if (counter->type & i)
+				dump_counter_prometheus (counter, section_names [j], outfile);
+		}
+	}
+
+	fflush (outfile);
+	mono_os_mutex_unlock (&counters_mutex);
+}
+
 /**
  * mono_counters_cleanup:
  *
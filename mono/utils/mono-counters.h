@@ -19,6 +19,7 @@ enum {
 	MONO_COUNTER_STRING, /* char* */
 	MONO_COUNTER_TIME_INTERVAL, /* 64 bits signed int holding usecs. */
 	MONO_COUNTER_TYPE_MASK = 0xf,
+	MONO_COUNTER_SHARDED = 64, /* ORed with MONO_COUNTER_LONG, runtime internal per-thread storage */
 	MONO_COUNTER_CALLBACK = 128, /* ORed with the other values */
 	MONO_COUNTER_SECTION_MASK = 0x00ffff00,
 	/* Sections, bits 8-23 (16 bits) */
@@ -72,6 +73,11 @@ MONO_API void mono_counters_on_register (MonoCounterRegisterCallback callback);
  */
 MONO_API void mono_counters_dump (int section_mask, FILE *outfile);
 
+/*
+ * Same as mono_counters_dump, in the Prometheus text exposition format
+ */
+MONO_API void mono_counters_dump_prometheus (int section_mask, FILE *outfile);
+
 MONO_API void mono_counters_cleanup (void);
 
 typedef mono_bool (*CountersEnumCallback) (MonoCounter *counter, void *user_data);
@@ -8,7 +8,29 @@
 
 #include "mono/utils/mono-hwcap.h"
 
+#if defined(HAVE_SYS_AUXV_H) && defined(__linux__)
+#include <sys/auxv.h>
+#elif defined(__APPLE__)
+#include <sys/sysctl.h>
+#include <sys/types.h>
+#endif
+
 void
 mono_hwcap_arch_init (void)
 {
+#if defined(HAVE_SYS_AUXV_H) && defined(__linux__)
+	unsigned long hwcap;
+
+	if ((hwcap = getauxval(AT_HWCAP))) {
+		/* HWCAP_ATOMICS, ARMv8.1 LSE */
+		if (hwcap & 0x00000100)
+			mono_hwcap_arm64_has_lse = TRUE;
+	}
+#elif defined(__APPLE__)
+	int value = 0;
+	size_t length = sizeof (value);
+
+	if (sysctlbyname ("hw.optional.armv8_1_atomics", &value, &length, NULL, 0) == 0 && value)
+		mono_hwcap_arm64_has_lse = TRUE;
+#endif
 }
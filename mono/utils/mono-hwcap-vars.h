@@ -17,7 +17,7 @@ MONO_HWCAP_VAR(arm_has_thumb2)
 
 #elif defined (TARGET_ARM64)
 
-// Nothing here yet.
+MONO_HWCAP_VAR(arm64_has_lse)
 
 #elif defined (TARGET_MIPS)
 
@@ -74,5 +74,7 @@ MONO_HWCAP_VAR(x86_has_ssse3)
 MONO_HWCAP_VAR(x86_has_sse41)
 MONO_HWCAP_VAR(x86_has_sse42)
 MONO_HWCAP_VAR(x86_has_sse4a)
+MONO_HWCAP_VAR(x86_has_popcnt)
+MONO_HWCAP_VAR(x86_has_lzcnt)
 
 #endif
@@ -136,14 +136,21 @@ mono_hwcap_arch_init (void)
 
 		if (ecx & (1 << 20))
 			mono_hwcap_x86_has_sse42 = TRUE;
+
+		if (ecx & (1 << 23))
+			mono_hwcap_x86_has_popcnt = TRUE;
 	}
 
 	if (cpuid (0x80000000, &eax, &ebx, &ecx, &edx)) {
-		if ((unsigned int) eax >= 0x80000001 && ebx == 0x68747541 && ecx == 0x444D4163 && edx == 0x69746E65) {
-			if (cpuid (0x80000001, &eax, &ebx, &ecx, &edx)) {
-				if (ecx & (1 << 6))
-					mono_hwcap_x86_has_sse4a = TRUE;
-			}
+		gboolean is_amd = ebx == 0x68747541 && ecx == 0x444D4163 && edx == 0x69746E65;
+
+		if ((unsigned int) eax >= 0x80000001 && cpuid (0x80000001, &eax, &ebx, &ecx, &edx)) {
+			if (is_amd && (ecx & (1 << 6)))
+				mono_hwcap_x86_has_sse4a = TRUE;
+
+			/* ABM on AMD, LZCNT on Intel */
+			if (ecx & (1 << 5))
+				mono_hwcap_x86_has_lzcnt = TRUE;
 		}
 	}
 
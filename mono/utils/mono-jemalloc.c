@@ -9,11 +9,229 @@
 
 #ifdef MONO_JEMALLOC_ENABLED
 
+#include <mono/utils/mono-counters.h>
+
+/*
+ * Purge unused dirty pages of all arenas after this many milliseconds, and
+ * give lazily purged (muzzy) pages back after as long again. Long running servers
+ * reuse most of this memory soon, so this mostly trims RSS after startup and after
+ * assembly unloading. Ignored when the user configured jemalloc through
+ * MONO_JEMALLOC_CONF.
+ */
+#define MONO_JEMALLOC_DECAY_MS 5000
+
+static unsigned arena_index [MONO_JEMALLOC_ARENA_NUM];
+static int arenas_enabled;
+
+static void
+set_ssize (const char *name, ssize_t value)
+{
+	MONO_JEMALLOC_MALLCTL (name, NULL, NULL, &value, sizeof (value));
+}
+
+static void
+init_arenas (void)
+{
+	gboolean tune = !g_hasenv ("MONO_JEMALLOC_CONF");
+	unsigned i;
+
+	if (tune) {
+		bool background = true;
+
+		/* Purge from jemalloc's own threads instead of on the allocation path */
+		MONO_JEMALLOC_MALLCTL ("background_thread", NULL, NULL, &background, sizeof (background));
+		/* Default for arenas created from now on */
+		set_ssize ("arenas.dirty_decay_ms", MONO_JEMALLOC_DECAY_MS);
+		set_ssize ("arenas.muzzy_decay_ms", MONO_JEMALLOC_DECAY_MS);
+
+		/* The automatic arenas, only the ones already in use accept this */
+		unsigned narenas = 0;
+		size_t size = sizeof (narenas);
+		MONO_JEMALLOC_MALLCTL ("arenas.narenas", &narenas, &size, NULL, 0);
+		for (i = 0; i < narenas; ++i) {
+			char name [64];
+			g_snprintf (name, sizeof (name), "arena.%u.dirty_decay_ms", i);
+			set_ssize (name, MONO_JEMALLOC_DECAY_MS);
+			g_snprintf (name, sizeof (name), "arena.%u.muzzy_decay_ms", i);
+			set_ssize (name, MONO_JEMALLOC_DECAY_MS);
+		}
+	}
+
+	for (i = MONO_JEMALLOC_ARENA_NONE + 1; i < MONO_JEMALLOC_ARENA_NUM; ++i) {
+		unsigned index;
+		size_t size = sizeof (index);
+
+		if (MONO_JEMALLOC_MALLCTL ("arenas.create", &index, &size, NULL, 0) != 0) {
+			g_warning ("jemalloc: could not create runtime arenas, using the default arena.");
+			return;
+		}
+		arena_index [i] = index;
+	}
+
+	arenas_enabled = 1;
+}
+
 void 
 mono_init_jemalloc (void)
 {
 	GMemVTable g_mem_vtable = { MONO_JEMALLOC_MALLOC, MONO_JEMALLOC_REALLOC, MONO_JEMALLOC_FREE, MONO_JEMALLOC_CALLOC};
 	g_mem_set_vtable (&g_mem_vtable);
+
+	init_arenas ();
+}
+
+/**
+ * mono_jemalloc_arenas_enabled:
+ *
+ * Whether the runtime arenas are in use. This is decided by mono_init_jemalloc (),
+ * which must run before the runtime is initialized, so it never changes afterwards.
+ */
+int
+mono_jemalloc_arenas_enabled (void)
+{
+	return arenas_enabled;
+}
+
+/*
+ * The runtime arenas bypass the thread caches: they serve block sized, mostly long
+ * lived allocations, and a thread cache is shared by all arenas, so objects from
+ * it would end up mixed with the default arena. g_malloc () keeps using the thread
+ * caches.
+ */
+static int
+arena_flags (MonoJemallocArena arena)
+{
+	if (!arenas_enabled || arena == MONO_JEMALLOC_ARENA_NONE)
+		return 0;
+	return MALLOCX_ARENA (arena_index [arena]) | MALLOCX_TCACHE_NONE;
+}
+
+/**
+ * mono_jemalloc_arena_malloc:
+ *
+ * Allocate \p size bytes from \p arena, or from g_malloc () if the runtime arenas
+ * are not in use. Aborts on failure, like g_malloc (). The result is released with
+ * mono_jemalloc_arena_free ().
+ */
+void *
+mono_jemalloc_arena_malloc (MonoJemallocArena arena, size_t size)
+{
+	void *res;
+
+	if (!arenas_enabled)
+		return g_malloc (size);
+
+	res = MONO_JEMALLOC_MALLOCX (size ? size : 1, arena_flags (arena));
+	if (!res)
+		g_error ("%s: failed to allocate %lu bytes", __func__, (unsigned long)size);
+	return res;
+}
+
+/**
+ * mono_jemalloc_arena_free:
+ *
+ * Release \p p, allocated by mono_jemalloc_arena_malloc () from \p arena. Going
+ * through g_free () would put it into the thread cache, mixing it with the
+ * allocations of the default arena.
+ */
+void
+mono_jemalloc_arena_free (MonoJemallocArena arena, void *p)
+{
+	int flags = arena_flags (arena);
+
+	if (!flags) {
+		g_free (p);
+		return;
+	}
+	if (p)
+		MONO_JEMALLOC_DALLOCX (p, MALLOCX_TCACHE_NONE);
+}
+
+/* Statistics are cached by jemalloc until the epoch is advanced */
+static gint64
+read_stat (const char *name)
+{
+	guint64 epoch = 1;
+	size_t value = 0;
+	size_t size = sizeof (epoch);
+
+	MONO_JEMALLOC_MALLCTL ("epoch", &epoch, &size, &epoch, sizeof (epoch));
+	size = sizeof (value);
+	if (MONO_JEMALLOC_MALLCTL (name, &value, &size, NULL, 0) != 0)
+		return 0;
+	return value;
+}
+
+static gint64
+read_arena_stat (MonoJemallocArena arena)
+{
+	char name [64];
+
+	if (!arenas_enabled)
+		return 0;
+	/* Small and large allocations are accounted apart */
+	g_snprintf (name, sizeof (name), "stats.arenas.%u.small.allocated", arena_index [arena]);
+	gint64 res = read_stat (name);
+	g_snprintf (name, sizeof (name), "stats.arenas.%u.large.allocated", arena_index [arena]);
+	return res + read_stat (name);
+}
+
+static gint64
+stat_allocated (void)
+{
+	return read_stat ("stats.allocated");
+}
+
+static gint64
+stat_active (void)
+{
+	return read_stat ("stats.active");
+}
+
+static gint64
+stat_resident (void)
+{
+	return read_stat ("stats.resident");
+}
+
+static gint64
+stat_retained (void)
+{
+	return read_stat ("stats.retained");
+}
+
+static gint64
+stat_jit_allocated (void)
+{
+	return read_arena_stat (MONO_JEMALLOC_ARENA_JIT);
+}
+
+static gint64
+stat_metadata_allocated (void)
+{
+	return read_arena_stat (MONO_JEMALLOC_ARENA_METADATA);
+}
+
+#define JEMALLOC_COUNTER (MONO_COUNTER_LONG | MONO_COUNTER_BYTES | MONO_COUNTER_VARIABLE | MONO_COUNTER_CALLBACK)
+
+/**
+ * mono_jemalloc_register_counters:
+ *
+ * Export the jemalloc heap statistics through mono-counters. Does nothing unless
+ * mono_init_jemalloc () was called.
+ */
+void
+mono_jemalloc_register_counters (void)
+{
+	if (!arenas_enabled)
+		return;
+
+	mono_counters_register ("jemalloc allocated", MONO_COUNTER_RUNTIME | JEMALLOC_COUNTER, (gpointer)&stat_allocated);
+	mono_counters_register ("jemalloc active", MONO_COUNTER_RUNTIME | JEMALLOC_COUNTER, (gpointer)&stat_active);
+	mono_counters_register ("jemalloc resident", MONO_COUNTER_RUNTIME | JEMALLOC_COUNTER, (gpointer)&stat_resident);
+	mono_counters_register ("jemalloc retained", MONO_COUNTER_RUNTIME | JEMALLOC_COUNTER, (gpointer)&stat_retained);
+	mono_counters_register ("jemalloc JIT arena allocated", MONO_COUNTER_JIT | JEMALLOC_COUNTER, (gpointer)&stat_jit_allocated);
+	mono_counters_register ("jemalloc metadata arena allocated", MONO_COUNTER_METADATA | JEMALLOC_COUNTER, (gpointer)&stat_metadata_allocated);
 }
 
 #endif
@@ -7,6 +7,23 @@
 #ifndef __MONO_JEMALLOC_H__
 #define __MONO_JEMALLOC_H__
 
+#include <stddef.h>
+
+/*
+ * Dedicated arenas for the runtime's own long lived allocations. Keeping them apart
+ * from the default arena, which serves g_malloc, means the memory of freed mempools
+ * isn't pinned by unrelated small objects. MONO_JEMALLOC_ARENA_NONE means the
+ * default arena.
+ * SGen internal memory stays on mmap: it is allocated while the world is stopped,
+ * when a suspended thread might hold a jemalloc lock.
+ */
+typedef enum {
+	MONO_JEMALLOC_ARENA_NONE,
+	MONO_JEMALLOC_ARENA_JIT,
+	MONO_JEMALLOC_ARENA_METADATA,
+	MONO_JEMALLOC_ARENA_NUM
+} MonoJemallocArena;
+
 #if defined(MONO_JEMALLOC_ENABLED)
 
 #include <jemalloc/jemalloc.h>
@@ -27,10 +44,20 @@
 #define MONO_JEMALLOC_REALLOC mono_jerealloc
 #define MONO_JEMALLOC_FREE mono_jefree
 #define MONO_JEMALLOC_CALLOC mono_jecalloc
+#define MONO_JEMALLOC_MALLOCX mono_jemallocx
+#define MONO_JEMALLOC_DALLOCX mono_jedallocx
+#define MONO_JEMALLOC_MALLCTL mono_jemallctl
 
 void mono_init_jemalloc (void);
 
-#endif
+int mono_jemalloc_arenas_enabled (void);
+
+void *mono_jemalloc_arena_malloc (MonoJemallocArena arena, size_t size);
+
+void mono_jemalloc_arena_free (MonoJemallocArena arena, void *p);
+
+void mono_jemalloc_register_counters (void);
 
 #endif
 
+#endif
@@ -213,6 +213,50 @@ prot_from_flags (int flags)
 	return prot;
 }
 
+/* Apply the access hints in \p flags to a new mapping */
+static void
+advise_from_flags (void *addr, size_t length, int flags)
+{
+#ifdef HAVE_MADVISE
+#ifdef MADV_HUGEPAGE
+	/* Transparent huge pages only back the huge page aligned parts of the mapping */
+	if (flags & (MONO_MMAP_HUGEPAGES | MONO_MMAP_HUGETLB))
+		madvise (addr, length, MADV_HUGEPAGE);
+#endif
+	if (flags & MONO_MMAP_SEQUENTIAL)
+		madvise (addr, length, MADV_SEQUENTIAL);
+	else if (flags & MONO_MMAP_RANDOM)
+		madvise (addr, length, MADV_RANDOM);
+#if !defined(MAP_POPULATE) && defined(MADV_WILLNEED)
+	if (flags & MONO_MMAP_POPULATE)
+		madvise (addr, length, MADV_WILLNEED);
+#endif
+#endif
+}
+
+#ifdef MAP_HUGETLB
+/* The size of the pages in the default huge page pool, 0 if there is none */
+static size_t
+hugetlb_page_size (void)
+{
+	static size_t page_size = (size_t)-1;
+
+	if (page_size == (size_t)-1) {
+		size_t size = 0;
+		char *contents, *line;
+
+		if (g_file_get_contents ("/proc/meminfo", &contents, NULL, NULL)) {
+			line = strstr (contents, "Hugepagesize:");
+			if (line)
+				size = (size_t)strtoul (line + strlen ("Hugepagesize:"), NULL, 10) * 1024;
+			g_free (contents);
+		}
+		page_size = size;
+	}
+	return page_size;
+}
+#endif
+
 #if defined(__APPLE__)
 
 #define DARWIN_VERSION_MOJAVE 18
@@ -270,6 +314,7 @@ mono_valloc (void *addr, size_t length, int flags, MonoMemAccountType type)
 	void *ptr;
 	int mflags = 0;
 	int prot = prot_from_flags (flags);
+	gboolean use_hugetlb G_GNUC_UNUSED = FALSE;
 
 	if (!mono_valloc_can_alloc (length))
 		return NULL;
@@ -307,9 +352,30 @@ mono_valloc (void *addr, size_t length, int flags, MonoMemAccountType type)
 
 	mflags |= MAP_ANONYMOUS;
 	mflags |= MAP_PRIVATE;
+#ifdef MAP_POPULATE
+	if (flags & MONO_MMAP_POPULATE)
+		mflags |= MAP_POPULATE;
+#endif
+
+#ifdef MAP_HUGETLB
+	/* Huge pages can only be unmapped whole, mono_vfree () has no other length to go by */
+	if ((flags & MONO_MMAP_HUGETLB) && hugetlb_page_size () && !(length % hugetlb_page_size ()))
+		use_hugetlb = TRUE;
+#endif
 
 	BEGIN_CRITICAL_SECTION;
-	ptr = mmap (addr, length, prot, mflags, -1, 0);
+	ptr = MAP_FAILED;
+#ifdef MAP_HUGETLB
+	if (use_hugetlb) {
+		ptr = mmap (addr, length, prot, mflags | MAP_HUGETLB, -1, 0);
+		/* These are huge already, the transparent huge page hint would fail */
+		if (ptr != MAP_FAILED)
+			flags &= ~(MONO_MMAP_HUGEPAGES | MONO_MMAP_HUGETLB);
+	}
+#endif
+	/* Without a reserved huge page pool the hint is all we can do */
+	if (ptr == MAP_FAILED)
+		ptr = mmap (addr, length, prot, mflags, -1, 0);
 	if (ptr == MAP_FAILED) {
 		int fd = open ("/dev/zero", O_RDONLY);
 		if (fd != -1) {
@@ -322,6 +388,8 @@ mono_valloc (void *addr, size_t length, int flags, MonoMemAccountType type)
 	if (ptr == MAP_FAILED)
 		return NULL;
 
+	advise_from_flags (ptr, length, flags);
+
 	mono_account_mem (type, (ssize_t)length);
 
 	return ptr;
@@ -383,6 +451,10 @@ mono_file_map_error (size_t length, int flags, int fd, guint64 offset, void **re
 		mflags |= MAP_FIXED;
 	if (flags & MONO_MMAP_32BIT)
 		mflags |= MAP_32BIT;
+#ifdef MAP_POPULATE
+	if (flags & MONO_MMAP_POPULATE)
+		mflags |= MAP_POPULATE;
+#endif
 
 #ifdef HOST_WASM
 	if (length == 0)
@@ -403,6 +475,8 @@ mono_file_map_error (size_t length, int flags, int fd, guint64 offset, void **re
 		}
 		return NULL;
 	}
+	/* Huge pages for files come from the page cache, there is no pool to take them from */
+	advise_from_flags (ptr, length, flags & ~MONO_MMAP_HUGETLB);
 	*ret_handle = (void*)length;
 	return ptr;
 }
@@ -22,7 +22,16 @@ enum {
 	MONO_MMAP_ANON    = 1 << 6,
 	MONO_MMAP_FIXED   = 1 << 7,
 	MONO_MMAP_32BIT   = 1 << 8,
-	MONO_MMAP_JIT     = 1 << 9
+	MONO_MMAP_JIT     = 1 << 9,
+	/* back the mapping with huge pages if the OS supports it, only a hint */
+	MONO_MMAP_HUGEPAGES = 1 << 10,
+	/* fault in the whole mapping when it is created */
+	MONO_MMAP_POPULATE = 1 << 11,
+	/* expected access pattern, only hints */
+	MONO_MMAP_SEQUENTIAL = 1 << 12,
+	MONO_MMAP_RANDOM = 1 << 13,
+	/* take anonymous memory from the reserved huge page pool, or fall back to MONO_MMAP_HUGEPAGES */
+	MONO_MMAP_HUGETLB = 1 << 14
 };
 
 typedef enum {
@@ -0,0 +1,191 @@
+/**
+ * \file
+ * NUMA topology and placement helpers.
+ *
+ * On Linux the topology is read from sysfs and placement is done with
+ * sched_setaffinity () and the mbind () system call, so we don't depend on
+ * libnuma.  Everywhere else we report a single node.
+ *
+ * Licensed under the MIT license. See LICENSE file in the project root for full license information.
+ */
+
+#include <config.h>
+#include <glib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <mono/utils/mono-numa.h>
+#include <mono/utils/mono-memory-model.h>
+
+#if defined(__linux__) && defined(HAVE_SCHED_SETAFFINITY) && defined(HAVE_SCHED_GETCPU)
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#define MONO_NUMA_LINUX 1
+#endif
+
+#ifdef MONO_NUMA_LINUX
+
+#ifndef MPOL_PREFERRED
+#define MPOL_PREFERRED 1
+#endif
+
+static gboolean topology_inited;
+static int node_count = 1;
+static cpu_set_t node_cpus [MONO_NUMA_MAX_NODES];
+/* Node of each cpu, -1 if we don't know */
+static gint8 cpu_nodes [CPU_SETSIZE];
+
+/*
+ * Parses a sysfs cpu list like "0-7,16-23" into `set`.  Returns FALSE if
+ * the file can't be read or is malformed.
+ */
+static gboolean
+read_cpu_list (const char *path, cpu_set_t *set)
+{
+	FILE *file;
+	char buf [1024];
+	char *p;
+
+	file = fopen (path, "r");
+	if (!file)
+		return FALSE;
+	p = fgets (buf, sizeof (buf), file);
+	fclose (file);
+	if (!p)
+		return FALSE;
+
+	CPU_ZERO (set);
+	while (*p && *p != '\n') {
+		char *end;
+		long first, last;
+
+		first = last = strtol (p, &end, 10);
+		if (end == p)
+			return FALSE;
+		p = end;
+		if (*p == '-') {
+			last = strtol (p + 1, &end, 10);
+			if (end == p + 1)
+				return FALSE;
+			p = end;
+		}
+		for (; first <= last && first < CPU_SETSIZE; first++)
+			CPU_SET (first, set);
+		if (*p == ',')
+			p++;
+	}
+	return TRUE;
+}
+
+static void
+init_topology (void)
+{
+	int node, cpu;
+
+	if (topology_inited)
+		return;
+
+	memset (cpu_nodes, -1, sizeof (cpu_nodes));
+
+	for (node = 0; node < MONO_NUMA_MAX_NODES; node++) {
+		char path [64];
+
+		g_snprintf (path, sizeof (path), "/sys/devices/system/node/node%d/cpulist", node);
+		if (!read_cpu_list (path, &node_cpus [node]))
+			break;
+		for (cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+			if (CPU_ISSET (cpu, &node_cpus [node]))
+				cpu_nodes [cpu] = (gint8)node;
+		}
+	}
+	node_count = MAX (node, 1);
+
+	mono_memory_barrier ();
+	topology_inited = TRUE;
+}
+
+int
+mono_numa_get_node_count (void)
+{
+	init_topology ();
+	return node_count;
+}
+
+int
+mono_numa_get_current_node (void)
+{
+	int cpu;
+
+	init_topology ();
+	if (node_count == 1)
+		return 0;
+
+	cpu = sched_getcpu ();
+	if (cpu < 0 || cpu >= CPU_SETSIZE || cpu_nodes [cpu] < 0)
+		return 0;
+	return cpu_nodes [cpu];
+}
+
+gboolean
+mono_numa_bind_current_thread (int node)
+{
+	init_topology ();
+	if (node < 0 || node >= node_count || node_count == 1)
+		return FALSE;
+
+	return sched_setaffinity (0, sizeof (cpu_set_t), &node_cpus [node]) == 0;
+}
+
+/*
+ * Ask the kernel to back the pages in [addr, addr + size) with memory from
+ * `node` once they are first touched, falling back to other nodes if it is
+ * out of memory.  `addr` and `size` must be page aligned.
+ */
+gboolean
+mono_numa_set_preferred_node (void *addr, size_t size, int node)
+{
+#ifdef __NR_mbind
+	unsigned long mask [(MONO_NUMA_MAX_NODES + 8 * sizeof (unsigned long) - 1) / (8 * sizeof (unsigned long))];
+
+	init_topology ();
+	if (node < 0 || node >= node_count || node_count == 1)
+		return FALSE;
+
+	memset (mask, 0, sizeof (mask));
+	mask [node / (8 * sizeof (unsigned long))] |= 1UL << (node % (8 * sizeof (unsigned long)));
+
+	return syscall (__NR_mbind, addr, size, MPOL_PREFERRED, mask, (unsigned long)MONO_NUMA_MAX_NODES + 1, 0) == 0;
+#else
+	return FALSE;
+#endif
+}
+
+#else
+
+int
+mono_numa_get_node_count (void)
+{
+	return 1;
+}
+
+int
+mono_numa_get_current_node (void)
+{
+	return 0;
+}
+
+gboolean
+mono_numa_bind_current_thread (int node)
+{
+	return FALSE;
+}
+
+gboolean
+mono_numa_set_preferred_node (void *addr, size_t size, int node)
+{
+	return FALSE;
+}
+
+#endif
@@ -0,0 +1,31 @@
+/**
+ * \file
+ * NUMA topology and placement helpers.
+ *
+ * Licensed under the MIT license. See LICENSE file in the project root for full license information.
+ */
+
+#ifndef __MONO_UTILS_NUMA_H__
+#define __MONO_UTILS_NUMA_H__
+
+#include <glib.h>
+
+#define MONO_NUMA_MAX_NODES 64
+
+/*
+ * All of these degrade gracefully when the platform doesn't expose NUMA
+ * information: there is a single node 0, and binding calls return FALSE.
+ */
+int
+mono_numa_get_node_count (void);
+
+int
+mono_numa_get_current_node (void);
+
+gboolean
+mono_numa_bind_current_thread (int node);
+
+gboolean
+mono_numa_set_preferred_node (void *addr, size_t size, int node);
+
+#endif /* __MONO_UTILS_NUMA_H__ */
@@ -15,9 +15,12 @@
 #include <mono/utils/mono-state.h>
 #include <mono/utils/mono-threads-coop.h>
 #include <mono/metadata/object-internals.h>
+#include <mono/metadata/mono-gc.h>
 
 #include <sys/param.h>
 #include <fcntl.h>
+#include <errno.h>
+#include <time.h>
 #ifdef HAVE_SYS_STAT_H
 #include <sys/stat.h>
 #endif
@@ -927,6 +930,35 @@ mono_native_state_add_memory (MonoStateWriter *writer)
 	mono_state_writer_printf(writer, "},\n");
 }
 
+#define MONO_CRASH_REPORTING_GC_EVENT_LIMIT 32
+
+static void
+mono_native_state_add_gc_events (MonoStateWriter *writer)
+{
+	MonoGCRecentEvent events [MONO_CRASH_REPORTING_GC_EVENT_LIMIT];
+	int count = mono_gc_get_recent_events (events, MONO_CRASH_REPORTING_GC_EVENT_LIMIT);
+
+	if (count == 0)
+		return;
+
+	assert_has_space (writer);
+	mono_state_writer_indent (writer);
+	mono_state_writer_object_key (writer, "gc_events");
+	mono_state_writer_printf(writer, "[\n");
+	writer->indent++;
+
+	for (int i = 0; i < count; ++i) {
+		assert_has_space (writer);
+		mono_state_writer_indent (writer);
+		mono_state_writer_printf(writer, "{ \"kind\" : \"%d\", \"generation\" : \"%d\", ", events [i].kind, events [i].generation);
+		mono_state_writer_printf(writer, "\"timestamp\" : \"%lld\", \"value\" : \"%lld\" }%s\n", (long long)events [i].timestamp, (long long)events [i].value, i + 1 < count ? "," : "");
+	}
+
+	writer->indent--;
+	mono_state_writer_indent (writer);
+	mono_state_writer_printf(writer, "],\n");
+}
+
 #define MONO_CRASH_REPORTING_MAPPING_LINE_LIMIT 30
 
 static void
@@ -1001,6 +1033,8 @@ mono_native_state_add_prologue (MonoStateWriter *writer)
 
 	mono_native_state_add_memory (writer);
 
+	mono_native_state_add_gc_events (writer);
+
 	const char *assertion_msg = g_get_assertion_message ();
 	if (assertion_msg != NULL) {
 		assert_has_space (writer);
@@ -1136,4 +1170,485 @@ mono_crash_dump (const char *jsonFile, MonoStackHash *hashes)
 	return;
 }
 
+#define RAW_SUMMARY_MAGIC "MONORAW1"
+#define RAW_SUMMARY_MAGIC_LEN 8
+#define RAW_SUMMARY_JSON_LEN 500000
+#define RAW_SUMMARY_MAX_THREADS 128
+
+static int raw_summary_budget_ms;
+
+void
+mono_summarize_set_raw_mode (int budget_ms)
+{
+	raw_summary_budget_ms = budget_ms > 0 ? budget_ms : 0;
+}
+
+int
+mono_summarize_raw_budget (void)
+{
+	return raw_summary_budget_ms;
+}
+
+static void
+raw_file_name (pid_t pid, char *name, size_t limit)
+{
+	name [0] = '\0';
+	g_snprintf (name, limit, "mono_crash.%d.raw", pid);
+}
+
+/*
+ * Buffered writer for the raw summary file, only does write () syscalls so it
+ * can be used from the crashing thread's signal handler.
+ */
+typedef struct {
+	int handle;
+	int len;
+	gboolean failed;
+	char buf [4096];
+} RawSummaryWriter;
+
+static void
+raw_writer_flush (RawSummaryWriter *writer)
+{
+	int written = 0;
+
+	while (!writer->failed && written < writer->len) {
+		int res = g_write (writer->handle, writer->buf + written, writer->len - written);
+		if (res == -1 && errno == EINTR)
+			continue;
+		if (res <= 0)
+			writer->failed = TRUE;
+		else
+			written += res;
+	}
+	writer->len = 0;
+}
+
+static void
+raw_writer_put (RawSummaryWriter *writer, gconstpointer data, int size)
+{
+	const char *p = (const char *) data;
+
+	while (size > 0) {
+		int n = MIN (size, (int) sizeof (writer->buf) - writer->len);
+
+		memcpy (writer->buf + writer->len, p, n);
+		writer->len += n;
+		p += n;
+		size -= n;
+		if (writer->len == sizeof (writer->buf))
+			raw_writer_flush (writer);
+	}
+}
+
+static void
+raw_writer_put_u32 (RawSummaryWriter *writer, guint32 val)
+{
+	raw_writer_put (writer, &val, sizeof (val));
+}
+
+static void
+raw_writer_put_u64 (RawSummaryWriter *writer, guint64 val)
+{
+	raw_writer_put (writer, &val, sizeof (val));
+}
+
+// Strings are stored as a length followed by the characters and a terminator
+static void
+raw_writer_put_str (RawSummaryWriter *writer, const char *str)
+{
+	guint32 len = str ? (guint32) strnlen (str, MONO_MAX_SUMMARY_NAME_LEN) : 0;
+
+	raw_writer_put_u32 (writer, len);
+	if (len)
+		raw_writer_put (writer, str, len);
+	raw_writer_put (writer, "", 1);
+}
+
+static void
+raw_writer_put_thread (RawSummaryWriter *writer, MonoThreadSummary *thread, gboolean crashing_thread)
+{
+	raw_writer_put_u64 (writer, (guint64) thread->native_thread_id);
+	raw_writer_put_u64 (writer, (guint64) thread->info_addr);
+	raw_writer_put_u32 (writer, crashing_thread);
+	raw_writer_put_u64 (writer, thread->hashes.offset_free_hash);
+	raw_writer_put_u64 (writer, thread->hashes.offset_rich_hash);
+	raw_writer_put_str (writer, thread->name);
+	raw_writer_put_str (writer, thread->error_msg);
+
+	raw_writer_put_u32 (writer, thread->num_managed_frames);
+	for (int i = 0; i < thread->num_managed_frames; ++i) {
+		MonoFrameSummary *frame = &thread->managed_frames [i];
+
+		raw_writer_put_u32 (writer, frame->is_managed);
+		raw_writer_put_u64 (writer, (guint64) frame->unmanaged_data.ip);
+		raw_writer_put_u32 (writer, frame->managed_data.token);
+		raw_writer_put_u32 (writer, frame->managed_data.native_offset);
+		raw_writer_put_u32 (writer, frame->managed_data.image_size);
+		raw_writer_put_u32 (writer, frame->managed_data.time_date_stamp);
+		raw_writer_put_str (writer, frame->managed_data.guid);
+		raw_writer_put_str (writer, frame->managed_data.filename);
+		raw_writer_put_str (writer, frame->str_descr);
+	}
+
+	raw_writer_put_u32 (writer, thread->num_unmanaged_frames);
+	for (int i = 0; i < thread->num_unmanaged_frames; ++i)
+		raw_writer_put_u64 (writer, (guint64) thread->unmanaged_frames [i].unmanaged_data.ip);
+}
+
+/*
+ * mono_summarize_raw_write:
+ *
+ *   Write the frames the threads recorded for themselves to mono_crash.<pid>.raw,
+ * followed by the process map needed to make the native addresses portable.
+ * Async signal safe, there is no symbolication, json formatting or allocation.
+ */
+gboolean
+mono_summarize_raw_write (MonoThreadSummary **threads, int nthreads, MonoThreadSummary *crashing_thread)
+{
+	RawSummaryWriter writer;
+	char name [100];
+	guint32 count = 0;
+
+	if (g_hasenv ("MONO_CRASH_NOFILE"))
+		return FALSE;
+
+	raw_file_name (getpid (), name, sizeof (name));
+
+	writer.len = 0;
+	writer.failed = FALSE;
+	writer.handle = g_open (name, O_WRONLY | O_CREAT | O_TRUNC, S_IWUSR | S_IRUSR | S_IRGRP | S_IROTH);
+	if (writer.handle == -1)
+		return FALSE;
+
+	for (int i = 0; i < nthreads; ++i) {
+		if (threads [i] && threads [i] != crashing_thread)
+			count++;
+	}
+	if (crashing_thread)
+		count++;
+
+	raw_writer_put (&writer, RAW_SUMMARY_MAGIC, RAW_SUMMARY_MAGIC_LEN);
+	raw_writer_put_u32 (&writer, (guint32) getpid ());
+	raw_writer_put_u64 (&writer, (guint64) time (NULL));
+	raw_writer_put_u32 (&writer, count);
+
+	// The crashing thread goes first so a truncated file still has it
+	if (crashing_thread)
+		raw_writer_put_thread (&writer, crashing_thread, TRUE);
+	for (int i = 0; i < nthreads; ++i) {
+		if (threads [i] && threads [i] != crashing_thread)
+			raw_writer_put_thread (&writer, threads [i], FALSE);
+	}
+
+	// The rest of the file is the process map
+#if defined(__linux__) && !defined(HOST_ANDROID)
+	int maps = g_open ("/proc/self/maps", O_RDONLY, 0);
+	if (maps != -1) {
+		raw_writer_flush (&writer);
+		while (!writer.failed) {
+			int res = read (maps, writer.buf, sizeof (writer.buf));
+			if (res == -1 && errno == EINTR)
+				continue;
+			if (res <= 0)
+				break;
+			writer.len = res;
+			raw_writer_flush (&writer);
+		}
+		close (maps);
+	}
+#endif
+
+	raw_writer_flush (&writer);
+	close (writer.handle);
+
+	return !writer.failed;
+}
+
+typedef struct {
+	const char *pos;
+	const char *end;
+	gboolean failed;
+} RawSummaryReader;
+
+typedef struct {
+	guint64 start;
+	guint64 end;
+	guint64 offset;
+	const char *path;
+} RawSummaryMapping;
+
+static void
+raw_reader_get (RawSummaryReader *reader, gpointer out, int size)
+{
+	if (reader->failed || reader->end - reader->pos < size) {
+		reader->failed = TRUE;
+		memset (out, 0, size);
+		return;
+	}
+	memcpy (out, reader->pos, size);
+	reader->pos += size;
+}
+
+static guint32
+raw_reader_get_u32 (RawSummaryReader *reader)
+{
+	guint32 val;
+	raw_reader_get (reader, &val, sizeof (val));
+	return val;
+}
+
+static guint64
+raw_reader_get_u64 (RawSummaryReader *reader)
+{
+	guint64 val;
+	raw_reader_get (reader, &val, sizeof (val));
+	return val;
+}
+
+// Returns a pointer into the file contents, or NULL for empty strings
+static const char *
+raw_reader_get_str (RawSummaryReader *reader)
+{
+	guint32 len = raw_reader_get_u32 (reader);
+	const char *str = reader->pos;
+
+	if (reader->failed || len > MONO_MAX_SUMMARY_NAME_LEN || reader->end - reader->pos < len + 1 || str [len] != '\0') {
+		reader->failed = TRUE;
+		return NULL;
+	}
+	reader->pos += len + 1;
+	return len ? str : NULL;
+}
+
+static GArray *
+raw_summary_parse_maps (gchar **lines)
+{
+	GArray *maps = g_array_new (FALSE, TRUE, sizeof (RawSummaryMapping));
+
+	for (int i = 0; lines [i]; ++i) {
+		RawSummaryMapping mapping;
+		int path_start = 0;
+
+		if (sscanf (lines [i], "%" SCNx64 "-%" SCNx64 " %*s %" SCNx64 " %*s %*s %n", &mapping.start, &mapping.end, &mapping.offset, &path_start) < 3 || !path_start)
+			continue;
+		mapping.path = g_strstrip (lines [i] + path_start);
+		if (mapping.path [0] != '/')
+			continue;
+		g_array_append_val (maps, mapping);
+	}
+	return maps;
+}
+
+/*
+ * Native addresses are made portable the same way as mono_get_portable_ip () does,
+ * relative to the base of the module containing them.
+ */
+static void
+raw_summary_set_native_ip (GArray *maps, MonoFrameSummary *frame, guint64 ip)
+{
+	frame->unmanaged_data.ip = 0;
+
+	for (guint i = 0; maps && i < maps->len; ++i) {
+		RawSummaryMapping *mapping = &g_array_index (maps, RawSummaryMapping, i);
+
+		if (ip < mapping->start || ip >= mapping->end)
+			continue;
+
+		frame->unmanaged_data.ip = (intptr_t) (ip - (mapping->start - mapping->offset) + 0x100000000);
+#ifndef MONO_PRIVATE_CRASHES
+		const char *module = strrchr (mapping->path, '/');
+		frame->unmanaged_data.module = module ? module + 1 : mapping->path;
+#endif
+		return;
+	}
+}
+
+static void
+raw_reader_get_thread (RawSummaryReader *reader, GArray *maps, MonoThreadSummary *thread, gboolean *crashing_thread)
+{
+	const char *str;
+
+	memset (thread, 0, sizeof (*thread));
+
+	thread->native_thread_id = (intptr_t) raw_reader_get_u64 (reader);
+	thread->info_addr = (intptr_t) raw_reader_get_u64 (reader);
+	*crashing_thread = raw_reader_get_u32 (reader);
+	thread->hashes.offset_free_hash = raw_reader_get_u64 (reader);
+	thread->hashes.offset_rich_hash = raw_reader_get_u64 (reader);
+	if ((str = raw_reader_get_str (reader)))
+		g_strlcpy (thread->name, str, sizeof (thread->name));
+	thread->error_msg = raw_reader_get_str (reader);
+
+	thread->num_managed_frames = raw_reader_get_u32 (reader);
+	if (thread->num_managed_frames > MONO_MAX_SUMMARY_FRAMES)
+		reader->failed = TRUE;
+	for (int i = 0; !reader->failed && i < thread->num_managed_frames; ++i) {
+		MonoFrameSummary *frame = &thread->managed_frames [i];
+
+		frame->is_managed = raw_reader_get_u32 (reader);
+		guint64 ip = raw_reader_get_u64 (reader);
+		frame->managed_data.token = raw_reader_get_u32 (reader);
+		frame->managed_data.native_offset = raw_reader_get_u32 (reader);
+		frame->managed_data.image_size = raw_reader_get_u32 (reader);
+		frame->managed_data.time_date_stamp = raw_reader_get_u32 (reader);
+		frame->managed_data.guid = raw_reader_get_str (reader);
+		frame->managed_data.filename = raw_reader_get_str (reader);
+		if ((str = raw_reader_get_str (reader)))
+			g_strlcpy (frame->str_descr, str, sizeof (frame->str_descr));
+
+		// The IL offset needs the debug info of the crashed process
+		frame->managed_data.il_offset = -1;
+		if (!frame->is_managed) {
+			raw_summary_set_native_ip (maps, frame, ip);
+			frame->unmanaged_data.has_name = frame->str_descr [0] != '\0';
+		}
+	}
+	thread->is_managed = thread->num_managed_frames != 0;
+
+	thread->num_unmanaged_frames = raw_reader_get_u32 (reader);
+	if (thread->num_unmanaged_frames > MONO_MAX_SUMMARY_FRAMES)
+		reader->failed = TRUE;
+	for (int i = 0; !reader->failed && i < thread->num_unmanaged_frames; ++i)
+		raw_summary_set_native_ip (maps, &thread->unmanaged_frames [i], raw_reader_get_u64 (reader));
+}
+
+/*
+ * mono_summarize_raw_symbolize:
+ *
+ *   Turn a file written by mono_summarize_raw_write () into the json report,
+ * in a later process. Managed frames are identified by image guid, token and
+ * native offset, native frames by their offset in the module, so none of the
+ * crashed process' state is needed.
+ */
+gboolean
+mono_summarize_raw_symbolize (const char *raw_file, gchar **out, MonoStackHash *hashes)
+{
+	RawSummaryReader reader;
+	MonoThreadSummary *thread;
+	MonoStateWriter writer;
+	gchar *contents, *maps_text;
+	gchar **map_lines;
+	GArray *maps;
+	gsize length;
+	gboolean crashing_thread;
+	const char *threads_start;
+	guint32 pid, count;
+	guint64 crash_time;
+
+	*out = NULL;
+	memset (hashes, 0, sizeof (*hashes));
+
+	if (!g_file_get_contents (raw_file, &contents, &length, NULL))
+		return FALSE;
+
+	reader.pos = contents;
+	reader.end = contents + length;
+	reader.failed = FALSE;
+
+	if (length < RAW_SUMMARY_MAGIC_LEN || memcmp (contents, RAW_SUMMARY_MAGIC, RAW_SUMMARY_MAGIC_LEN)) {
+		g_free (contents);
+		return FALSE;
+	}
+	reader.pos += RAW_SUMMARY_MAGIC_LEN;
+
+	pid = raw_reader_get_u32 (&reader);
+	crash_time = raw_reader_get_u64 (&reader);
+	count = raw_reader_get_u32 (&reader);
+	if (count > RAW_SUMMARY_MAX_THREADS)
+		reader.failed = TRUE;
+
+	thread = g_new0 (MonoThreadSummary, 1);
+
+	// The process map follows the threads
+	threads_start = reader.pos;
+	for (guint32 i = 0; !reader.failed && i < count; ++i)
+		raw_reader_get_thread (&reader, NULL, thread, &crashing_thread);
+
+	if (reader.failed) {
+		g_free (thread);
+		g_free (contents);
+		return FALSE;
+	}
+
+	maps_text = g_strndup (reader.pos, reader.end - reader.pos);
+	map_lines = g_strsplit (maps_text, "\n", -1);
+	maps = raw_summary_parse_maps (map_lines);
+
+	mono_state_writer_init (&writer, (gchar *) g_malloc (RAW_SUMMARY_JSON_LEN), RAW_SUMMARY_JSON_LEN);
+	mono_state_writer_printf(&writer, "{\n");
+	writer.indent++;
+
+	assert_has_space (&writer);
+	mono_state_writer_indent (&writer);
+	mono_state_writer_object_key (&writer, "protocol_version");
+	mono_state_writer_printf(&writer, "\"%s\",\n", MONO_NATIVE_STATE_PROTOCOL_VERSION);
+
+	assert_has_space (&writer);
+	mono_state_writer_indent (&writer);
+	mono_state_writer_object_key (&writer, "raw_summary_pid");
+	mono_state_writer_printf(&writer, "\"%u\",\n", pid);
+
+	assert_has_space (&writer);
+	mono_state_writer_indent (&writer);
+	mono_state_writer_object_key (&writer, "raw_summary_time");
+	mono_state_writer_printf(&writer, "\"%" PRIu64 "\",\n", crash_time);
+
+	assert_has_space (&writer);
+	mono_state_writer_indent (&writer);
+	mono_state_writer_object_key (&writer, "threads");
+	mono_state_writer_printf(&writer, "[\n");
+
+	reader.pos = threads_start;
+	for (guint32 i = 0; i < count; ++i) {
+		raw_reader_get_thread (&reader, maps, thread, &crashing_thread);
+		if (i == 0 || crashing_thread)
+			*hashes = thread->hashes;
+		mono_native_state_add_thread (&writer, thread, NULL, i == 0, crashing_thread);
+	}
+
+	*out = mono_native_state_emit (&writer);
+
+	g_array_free (maps, TRUE);
+	g_strfreev (map_lines);
+	g_free (maps_text);
+	g_free (thread);
+	g_free (contents);
+	return TRUE;
+}
+
+/*
+ * mono_summarize_raw_process_pending:
+ *
+ *   Symbolize the raw summaries left in the working directory by crashed
+ * processes and write them out as json reports.
+ */
+void
+mono_summarize_raw_process_pending (void)
+{
+	GDir *dir = g_dir_open (".", 0, NULL);
+	const char *name;
+
+	if (!dir)
+		return;
+
+	while ((name = g_dir_read_name (dir))) {
+		gchar *output;
+		MonoStackHash hashes;
+
+		if (!g_str_has_prefix (name, "mono_crash.") || !g_str_has_suffix (name, ".raw"))
+			continue;
+
+		if (mono_summarize_raw_symbolize (name, &output, &hashes))
+			mono_crash_dump (output, &hashes);
+		else
+			g_warning ("Couldn't read raw crash summary %s", name);
+
+		g_free (output);
+		g_unlink (name);
+	}
+
+	g_dir_close (dir);
+}
+
 #endif // DISABLE_CRASH_REPORTING
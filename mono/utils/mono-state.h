@@ -109,6 +109,30 @@ mono_native_state_add_thread (MonoStateWriter *writer, MonoThreadSummary *thread
 void
 mono_crash_dump (const char *jsonFile, MonoStackHash *hashes);
 
+// Raw summaries
+//
+// A bounded-time alternative to the json summary for processes that get
+// killed by a watchdog before the full walk finishes. Threads only record raw
+// frames from their signal handler, the crashing thread writes whatever came
+// in within the budget using async-signal-safe writes, and the next run of the
+// process turns the file into the usual json report.
+
+void
+mono_summarize_set_raw_mode (int budget_ms);
+
+// The time budget in milliseconds, 0 when raw summaries are disabled
+int
+mono_summarize_raw_budget (void);
+
+gboolean
+mono_summarize_raw_write (MonoThreadSummary **threads, int nthreads, MonoThreadSummary *crashing_thread);
+
+gboolean
+mono_summarize_raw_symbolize (const char *raw_file, gchar **out, MonoStackHash *hashes);
+
+void
+mono_summarize_raw_process_pending (void);
+
 // Signal-safe file allocators
 
 gboolean
@@ -56,6 +56,9 @@
 
 volatile size_t mono_polling_required;
 
+/* Readable unless a global suspend is in progress, see mono_threads_get_safepoint_page () */
+static gpointer safepoint_page;
+
 // FIXME: This would be more efficient if instead of instantiating the stack it just pushed a simple depth counter up and down,
 // perhaps with a per-thread cookie in the high bits.
 #ifdef ENABLE_CHECKED_BUILD_GC
@@ -591,7 +594,8 @@ mono_threads_assert_gc_unsafe_region (void)
 static int
 threads_suspend_policy_default (void)
 {
-#if defined (ENABLE_COOP_SUSPEND)
+#if defined (ENABLE_COOP_SUSPEND) || (defined (HOST_WASM) && defined (ENABLE_WASM_THREADPOOL))
+	/* Web workers can't be preemptively suspended */
 	return MONO_THREADS_SUSPEND_FULL_COOP;
 #elif defined (ENABLE_HYBRID_SUSPEND)
 	return MONO_THREADS_SUSPEND_HYBRID;
@@ -750,20 +754,51 @@ mono_threads_coop_init (void)
 #ifdef ENABLE_CHECKED_BUILD_GC
 	mono_native_tls_alloc (&coop_reset_count_stack_key, NULL);
 #endif
+
+#if !defined(HOST_WASM) && !defined(HOST_WIN32)
+	if (mono_threads_are_safepoints_enabled ())
+		safepoint_page = mono_valloc (NULL, mono_pagesize (), MONO_MMAP_READ, MONO_MEM_ACCOUNT_OTHER);
+#endif
+}
+
+/*
+ * mono_threads_get_safepoint_page:
+ *
+ *   Return a page which JIT code can poll with a single load instead of checking
+ * mono_polling_required. The page is protected while a global suspend is in progress,
+ * so the load faults and the signal handler calls mono_threads_state_poll (). Returns
+ * NULL if page polling is not available.
+ */
+gpointer
+mono_threads_get_safepoint_page (void)
+{
+	return safepoint_page;
+}
+
+gboolean
+mono_threads_is_safepoint_page (gpointer addr)
+{
+	return safepoint_page && (guint8*)addr >= (guint8*)safepoint_page && (guint8*)addr < (guint8*)safepoint_page + mono_pagesize ();
 }
 
 void
 mono_threads_coop_begin_global_suspend (void)
 {
-	if (mono_threads_are_safepoints_enabled ())
+	if (mono_threads_are_safepoints_enabled ()) {
 		mono_polling_required = 1;
+		if (safepoint_page)
+			mono_mprotect (safepoint_page, mono_pagesize (), MONO_MMAP_NONE);
+	}
 }
 
 void
 mono_threads_coop_end_global_suspend (void)
 {
-	if (mono_threads_are_safepoints_enabled ())
+	if (mono_threads_are_safepoints_enabled ()) {
 		mono_polling_required = 0;
+		if (safepoint_page)
+			mono_mprotect (safepoint_page, mono_pagesize (), MONO_MMAP_READ);
+	}
 }
 
 void
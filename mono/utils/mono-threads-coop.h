@@ -21,6 +21,12 @@
 /* JIT specific interface */
 extern volatile size_t mono_polling_required;
 
+gpointer
+mono_threads_get_safepoint_page (void);
+
+gboolean
+mono_threads_is_safepoint_page (gpointer addr);
+
 /* Internal API */
 
 void
@@ -12,6 +12,17 @@
 #include <emscripten.h>
 #include <glib.h>
 
+#ifdef __EMSCRIPTEN_PTHREADS__
+#include <emscripten/threading.h>
+#include <sched.h>
+#include <mono/utils/mono-os-mutex.h>
+#include <mono/utils/mono-memory-model.h>
+#endif
+
+#if defined (ENABLE_WASM_THREADPOOL) && !defined (__EMSCRIPTEN_PTHREADS__)
+#error "--enable-wasm-threadpool requires the wasm threads build"
+#endif
+
 #define round_down(addr, val) ((void*)((addr) & ~((val) - 1)))
 
 EMSCRIPTEN_KEEPALIVE
@@ -50,6 +61,20 @@ mono_threads_suspend_init (void)
 {
 }
 
+#ifdef ENABLE_WASM_THREADPOOL
+/*
+ * Web workers can't be interrupted, so the threadpool build only supports full
+ * cooperative suspend, where running threads suspend themselves at safepoints
+ * and threads in blocking state count as suspended. None of the preemptive
+ * entry points below may be reached.
+ */
+static void
+preemptive_suspend_not_supported (void)
+{
+	g_error ("The wasm threadpool build only supports cooperative suspend, MONO_THREADS_SUSPEND must be 'coop'");
+}
+#endif
+
 void
 mono_threads_suspend_register (MonoThreadInfo *info)
 {
@@ -58,6 +83,9 @@ mono_threads_suspend_register (MonoThreadInfo *info)
 gboolean
 mono_threads_suspend_begin_async_resume (MonoThreadInfo *info)
 {
+#ifdef ENABLE_WASM_THREADPOOL
+	preemptive_suspend_not_supported ();
+#endif
 	return TRUE;
 }
 
@@ -69,12 +97,18 @@ mono_threads_suspend_free (MonoThreadInfo *info)
 gboolean
 mono_threads_suspend_begin_async_suspend (MonoThreadInfo *info, gboolean interrupt_kernel)
 {
+#ifdef ENABLE_WASM_THREADPOOL
+	preemptive_suspend_not_supported ();
+#endif
 	return TRUE;
 }
 
 gboolean
 mono_threads_suspend_check_suspend_result (MonoThreadInfo *info)
 {
+#ifdef ENABLE_WASM_THREADPOOL
+	preemptive_suspend_not_supported ();
+#endif
 	return TRUE;
 }
 
@@ -113,9 +147,22 @@ mono_native_thread_os_id_get (void)
 MONO_API gboolean
 mono_native_thread_create (MonoNativeThreadId *tid, gpointer func, gpointer arg)
 {
+#ifdef ENABLE_WASM_THREADPOOL
+	return pthread_create (tid, NULL, (void *(*)(void *)) func, arg) == 0;
+#else
 	g_error ("WASM doesn't support threading");
+#endif
 }
 
+#ifdef __EMSCRIPTEN_PTHREADS__
+void
+mono_native_thread_set_name (MonoNativeThreadId tid, const char *name)
+{
+	/* Only the current thread can be named, the name shows up in the browser's debugger */
+	if (tid == pthread_self ())
+		emscripten_set_thread_name (tid, name);
+}
+#else
 static const char *thread_name;
 
 void
@@ -123,6 +170,7 @@ mono_native_thread_set_name (MonoNativeThreadId tid, const char *name)
 {
 	thread_name = g_strdup (name);
 }
+#endif
 
 gboolean
 mono_native_thread_join (MonoNativeThreadId tid)
@@ -139,7 +187,11 @@ mono_native_thread_join (MonoNativeThreadId tid)
 gboolean
 mono_threads_platform_yield (void)
 {
+#ifdef __EMSCRIPTEN_PTHREADS__
+	return sched_yield () == 0;
+#else
 	return TRUE;
+#endif
 }
 
 void
@@ -280,22 +332,54 @@ extern void schedule_background_exec (void);
 
 static GSList *jobs;
 
+#ifdef __EMSCRIPTEN_PTHREADS__
+/*
+ * Background jobs (threadpool callbacks of the single threaded build, GC
+ * requests) always run on the browser's main thread, any thread can schedule
+ * them.
+ */
+static mono_mutex_t jobs_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+#define jobs_lock() mono_os_mutex_lock (&jobs_mutex)
+#define jobs_unlock() mono_os_mutex_unlock (&jobs_mutex)
+#else
+#define jobs_lock()
+#define jobs_unlock()
+#endif
+
 void
 mono_threads_schedule_background_job (background_job_cb cb)
 {
-	if (!jobs)
-		schedule_background_exec ();
+	gboolean schedule;
 
+	jobs_lock ();
+	schedule = !jobs;
 	if (!g_slist_find (jobs, (gconstpointer)cb))
 		jobs = g_slist_prepend (jobs, (gpointer)cb);
+	jobs_unlock ();
+
+	if (!schedule)
+		return;
+
+#ifdef __EMSCRIPTEN_PTHREADS__
+	if (!emscripten_is_main_runtime_thread ()) {
+		emscripten_async_run_in_main_runtime_thread (EM_FUNC_SIG_V, schedule_background_exec);
+		return;
+	}
+#endif
+	schedule_background_exec ();
 }
 
 G_EXTERN_C
 EMSCRIPTEN_KEEPALIVE void
 mono_background_exec (void)
 {
-	GSList *j = jobs, *cur;
+	GSList *j, *cur;
+
+	jobs_lock ();
+	j = jobs;
 	jobs = NULL;
+	jobs_unlock ();
 
 	for (cur = j; cur; cur = cur->next) {
 		background_job_cb cb = (background_job_cb)cur->data;
@@ -307,6 +391,14 @@ mono_background_exec (void)
 void
 mono_memory_barrier_process_wide (void)
 {
+#ifdef __EMSCRIPTEN_PTHREADS__
+	/*
+	 * There is no way to interrupt the other workers. Memory is shared through a
+	 * SharedArrayBuffer and every atomic on it is sequentially consistent, so a
+	 * full barrier on this thread is what the other threads will observe.
+	 */
+	mono_memory_barrier ();
+#endif
 }
 
 #endif
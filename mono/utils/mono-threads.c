@@ -72,11 +72,28 @@ static MONO_KEYWORD_THREAD gint32 tls_small_id = -1;
 static MonoNativeTlsKey small_id_key;
 #endif
 static MonoLinkedListSet thread_list;
+/*
+ * The registered threads again, indexed by small id, so they can be walked without
+ * chasing list nodes. Only modified under the suspend lock, entries are published
+ * before the size covers them.
+ */
+static MonoThreadInfo * volatile *thread_table;
+static volatile gint32 thread_table_size;
 static gboolean mono_threads_inited = FALSE;
 
 static MonoSemType suspend_semaphore;
 static size_t pending_suspends;
 
+/*
+ * Threads acknowledge suspend, resume and abort requests by bumping
+ * `pending_acks`.  Only the ack that completes the batch the initiator is
+ * waiting for, as published in `pending_acks_wanted`, posts to
+ * `suspend_semaphore`, so the initiator wakes up once per batch instead of
+ * once per thread.  `pending_acks_wanted` is -1 while nobody is waiting.
+ */
+static gint32 pending_acks;
+static gint32 pending_acks_wanted = -1;
+
 static mono_mutex_t join_mutex;
 
 #define mono_thread_info_run_state(info) (((MonoThreadInfo*)info)->thread_state & THREAD_STATE_MASK)
@@ -91,12 +108,22 @@ static guint32 sleepWarnDuration = SLEEP_DURATION_BEFORE_WARNING,
 
 static int suspend_posts, resume_posts, abort_posts, waits_done, pending_ops;
 
+static void
+notify_initiator (void)
+{
+	gint32 acks = mono_atomic_inc_i32 (&pending_acks);
+
+	/* Whoever of us and the initiator gets to clear `pending_acks_wanted` is responsible for the post */
+	if (acks == mono_atomic_load_i32 (&pending_acks_wanted) && mono_atomic_cas_i32 (&pending_acks_wanted, -1, acks) == acks)
+		mono_os_sem_post (&suspend_semaphore);
+}
+
 void
 mono_threads_notify_initiator_of_abort (MonoThreadInfo* info)
 {
 	THREADS_SUSPEND_DEBUG ("[INITIATOR-NOTIFY-ABORT] %p\n", mono_thread_info_get_tid (info));
 	mono_atomic_inc_i32 (&abort_posts);
-	mono_os_sem_post (&suspend_semaphore);
+	notify_initiator ();
 }
 
 void
@@ -105,8 +132,9 @@ mono_threads_notify_initiator_of_suspend (MonoThreadInfo* info)
 	THREADS_SUSPEND_DEBUG ("[INITIATOR-NOTIFY-SUSPEND] %p\n", mono_thread_info_get_tid (info));
 	// check that the thread is really in a valid suspended state.
 	g_assert (mono_thread_info_get_suspend_state (info) != NULL);
+	info->suspend_ack_time = mono_100ns_ticks ();
 	mono_atomic_inc_i32 (&suspend_posts);
-	mono_os_sem_post (&suspend_semaphore);
+	notify_initiator ();
 }
 
 void
@@ -114,7 +142,7 @@ mono_threads_notify_initiator_of_resume (MonoThreadInfo* info)
 {
 	THREADS_SUSPEND_DEBUG ("[INITIATOR-NOTIFY-RESUME] %p\n", mono_thread_info_get_tid (info));
 	mono_atomic_inc_i32 (&resume_posts);
-	mono_os_sem_post (&suspend_semaphore);
+	notify_initiator ();
 }
 
 typedef enum {
@@ -304,7 +332,6 @@ dump_threads (void)
 gboolean
 mono_threads_wait_pending_operations (void)
 {
-	int i;
 	int c = pending_suspends;
 
 	/* Wait threads to park */
@@ -312,18 +339,27 @@ mono_threads_wait_pending_operations (void)
 	if (pending_suspends) {
 		MonoStopwatch suspension_time;
 		mono_stopwatch_start (&suspension_time);
-		for (i = 0; i < pending_suspends; ++i) {
+
+		/*
+		 * Publish how many acks we want, then check whether they all arrived
+		 * already.  If they didn't, or if the last ack beat us to clearing
+		 * `pending_acks_wanted`, the last ack posts the semaphore.
+		 */
+		mono_atomic_xchg_i32 (&pending_acks_wanted, c);
+		if (!(mono_atomic_load_i32 (&pending_acks) == c && mono_atomic_cas_i32 (&pending_acks_wanted, -1, c) == c)) {
 			THREADS_SUSPEND_DEBUG ("[INITIATOR-WAIT-WAITING]\n");
-			mono_atomic_inc_i32 (&waits_done);
-			if (mono_os_sem_timedwait (&suspend_semaphore, sleepAbortDuration, MONO_SEM_FLAGS_NONE) == MONO_SEM_TIMEDWAIT_RET_SUCCESS)
-				continue;
-			mono_stopwatch_stop (&suspension_time);
+			if (mono_os_sem_timedwait (&suspend_semaphore, sleepAbortDuration, MONO_SEM_FLAGS_NONE) != MONO_SEM_TIMEDWAIT_RET_SUCCESS) {
+				mono_stopwatch_stop (&suspension_time);
 
-			dump_threads ();
+				dump_threads ();
 
-			g_async_safe_printf ("WAITING for %d threads, got %d suspended\n", (int)pending_suspends, i);
-			g_error ("suspend_thread suspend took %d ms, which is more than the allowed %d ms", (int)mono_stopwatch_elapsed_ms (&suspension_time), sleepAbortDuration);
+				g_async_safe_printf ("WAITING for %d threads, got %d suspended\n", (int)pending_suspends, (int)mono_atomic_load_i32 (&pending_acks));
+				g_error ("suspend_thread suspend took %d ms, which is more than the allowed %d ms", (int)mono_stopwatch_elapsed_ms (&suspension_time), sleepAbortDuration);
+			}
 		}
+		/* Every operation of this batch is acked, and the next batch hasn't started yet */
+		mono_atomic_store_i32 (&pending_acks, 0);
+		mono_atomic_add_i32 (&waits_done, c);
 		mono_stopwatch_stop (&suspension_time);
 		THREADS_SUSPEND_DEBUG ("Suspending %d threads took %d ms.\n", (int)pending_suspends, (int)mono_stopwatch_elapsed_ms (&suspension_time));
 
@@ -376,6 +412,12 @@ mono_thread_info_insert (MonoThreadInfo *info)
 	} 
 
 	mono_hazard_pointer_clear_all (hp, -1);
+
+	g_assert (info->small_id < MONO_SMALL_ID_MAX);
+	g_assert (!thread_table [info->small_id]);
+	mono_atomic_store_release (&thread_table [info->small_id], info);
+	if (info->small_id >= thread_table_size)
+		mono_atomic_store_i32 (&thread_table_size, info->small_id + 1);
 	return TRUE;
 }
 
@@ -388,6 +430,10 @@ mono_thread_info_remove (MonoThreadInfo *info)
 	THREADS_DEBUG ("removing info %p\n", info);
 	res = mono_lls_remove (&thread_list, hp, (MonoLinkedListSetNode*)info);
 	mono_hazard_pointer_clear_all (hp, -1);
+	if (res) {
+		g_assert (thread_table [info->small_id] == info);
+		mono_atomic_store_release (&thread_table [info->small_id], NULL);
+	}
 	return res;
 }
 
@@ -674,6 +720,32 @@ mono_thread_info_list_head (void)
 	return &thread_list;
 }
 
+/**
+ * mono_thread_info_table_get:
+ * \param size set to the number of entries that may be in use.
+ * \returns the table of registered threads, indexed by small id. Unused entries are NULL.
+ * See FOREACH_THREAD_ALL for how to walk it.
+ */
+MonoThreadInfo * volatile *
+mono_thread_info_table_get (int *size)
+{
+	*size = mono_atomic_load_i32 (&thread_table_size);
+	mono_memory_read_barrier ();
+	return thread_table;
+}
+
+/*
+ * mono_thread_info_table_get_hazardous:
+ *
+ * Returns the thread in entry \p index of the thread table, or NULL, and keeps it
+ * alive with hazard pointer \p hazard_index until that is cleared.
+ */
+MonoThreadInfo *
+mono_thread_info_table_get_hazardous (int index, MonoThreadHazardPointers *hp, int hazard_index)
+{
+	return (MonoThreadInfo *) mono_get_hazardous_pointer ((gpointer volatile *) &thread_table [index], hp, hazard_index);
+}
+
 MonoThreadInfo *
 mono_thread_info_attach (void)
 {
@@ -927,6 +999,13 @@ mono_thread_info_init (size_t info_size)
 	mono_os_mutex_init (&join_mutex);
 
 	mono_lls_init (&thread_list, NULL);
+#if MONO_SMALL_CONFIG
+	thread_table = g_new0 (MonoThreadInfo *, MONO_SMALL_ID_MAX);
+#else
+	/* Only the pages for the small ids in use get touched */
+	thread_table = (MonoThreadInfo * volatile *) mono_valloc (NULL, sizeof (MonoThreadInfo *) * MONO_SMALL_ID_MAX, MONO_MMAP_READ | MONO_MMAP_WRITE, MONO_MEM_ACCOUNT_OTHER);
+	g_assert (thread_table);
+#endif
 	mono_thread_smr_init ();
 	mono_threads_suspend_init ();
 	mono_threads_coop_init ();
@@ -1811,6 +1890,32 @@ mono_threads_signal_thread_handle (MonoThreadHandle* thread_handle)
 	mono_os_event_set (&thread_handle->event);
 }
 
+/*
+ * mono_thread_info_renew_handle:
+ *
+ *   Signal the handle of the current thread, as if it exited, and give it a fresh one.
+ * This is used by threads that are kept around to run another managed thread once the
+ * previous one finished, so joining the previous one doesn't wait for the OS thread.
+ */
+void
+mono_thread_info_renew_handle (void)
+{
+	MonoThreadInfo *info;
+	MonoThreadHandle *handle;
+
+	info = mono_thread_info_current ();
+	g_assert (info);
+
+	handle = info->handle;
+
+	info->handle = g_new0 (MonoThreadHandle, 1);
+	mono_refcount_init (info->handle, thread_handle_destroy);
+	mono_os_event_init (&info->handle->event, FALSE);
+
+	mono_threads_signal_thread_handle (handle);
+	mono_threads_close_thread_handle (handle);
+}
+
 #define INTERRUPT_STATE ((MonoThreadInfoInterruptToken*) (size_t) -1)
 
 struct _MonoThreadInfoInterruptToken {
@@ -218,6 +218,9 @@ typedef struct _MonoThreadInfo {
 
 	gboolean suspend_can_continue;
 
+	/* When this thread last acknowledged a suspend request, in 100ns ticks */
+	gint64 suspend_ack_time;
+
 	/* This memory pool is used by coop GC to save stack data roots between GC unsafe regions */
 	GByteArray *stackdata;
 
@@ -349,27 +352,64 @@ mono_threads_filter_exclude_flags (THREAD_INFO_TYPE *info, MonoThreadInfoFlags f
 	return !(mono_thread_info_get_flags (info) & flags);
 }
 
+/*
+ * These walk the thread table, which is indexed by small id, so threads are visited
+ * in small id order.
+ */
+
 /* Normal iteration; requires the world to be stopped. */
 
+#define MONO_THREAD_TABLE_FOREACH_FILTERED(type, elem, filter, ...) \
+	do { \
+		int size__; \
+		MonoThreadInfo * volatile *table__ = mono_thread_info_table_get (&size__); \
+		for (int i__ = 0; i__ < size__; ++i__) { \
+			type *elem = (type *) table__ [i__]; \
+			if (elem && filter (elem, __VA_ARGS__)) {
+
+#define MONO_THREAD_TABLE_FOREACH_END \
+			} \
+		} \
+	} while (0);
+
 #define FOREACH_THREAD_ALL(thread) \
-	MONO_LLS_FOREACH_FILTERED (mono_thread_info_list_head (), THREAD_INFO_TYPE, thread, mono_lls_filter_accept_all, NULL)
+	MONO_THREAD_TABLE_FOREACH_FILTERED (THREAD_INFO_TYPE, thread, mono_lls_filter_accept_all, NULL)
 
 #define FOREACH_THREAD_EXCLUDE(thread, not_flags) \
-	MONO_LLS_FOREACH_FILTERED (mono_thread_info_list_head (), THREAD_INFO_TYPE, thread, mono_threads_filter_exclude_flags, not_flags)
+	MONO_THREAD_TABLE_FOREACH_FILTERED (THREAD_INFO_TYPE, thread, mono_threads_filter_exclude_flags, not_flags)
 
 #define FOREACH_THREAD_END \
-	MONO_LLS_FOREACH_END
+	MONO_THREAD_TABLE_FOREACH_END
 
-/* Snapshot iteration; can be done anytime but is slower. */
+/*
+ * Snapshot iteration; can be done anytime. Each thread is kept alive with hazard
+ * pointer 1 while the body runs, so the body must not use it. Threads registered
+ * or removed during the walk may or may not be visited.
+ */
+
+#define MONO_THREAD_TABLE_FOREACH_FILTERED_SAFE(type, elem, filter, ...) \
+	do { \
+		int size__; \
+		MonoThreadHazardPointers *hp__ = mono_hazard_pointer_get (); \
+		mono_thread_info_table_get (&size__); \
+		for (int i__ = 0; i__ < size__; ++i__) { \
+			type *elem = (type *) mono_thread_info_table_get_hazardous (i__, hp__, 1); \
+			if (elem && filter (elem, __VA_ARGS__)) {
+
+#define MONO_THREAD_TABLE_FOREACH_SAFE_END \
+			} \
+		} \
+		mono_hazard_pointer_clear (hp__, 1); \
+	} while (0);
 
 #define FOREACH_THREAD_SAFE_ALL(thread) \
-	MONO_LLS_FOREACH_FILTERED_SAFE (mono_thread_info_list_head (), THREAD_INFO_TYPE, thread, mono_lls_filter_accept_all, NULL)
+	MONO_THREAD_TABLE_FOREACH_FILTERED_SAFE (THREAD_INFO_TYPE, thread, mono_lls_filter_accept_all, NULL)
 
 #define FOREACH_THREAD_SAFE_EXCLUDE(thread, not_flags) \
-	MONO_LLS_FOREACH_FILTERED_SAFE (mono_thread_info_list_head (), THREAD_INFO_TYPE, thread, mono_threads_filter_exclude_flags, not_flags)
+	MONO_THREAD_TABLE_FOREACH_FILTERED_SAFE (THREAD_INFO_TYPE, thread, mono_threads_filter_exclude_flags, not_flags)
 
 #define FOREACH_THREAD_SAFE_END \
-	MONO_LLS_FOREACH_SAFE_END
+	MONO_THREAD_TABLE_FOREACH_SAFE_END
 
 static inline MonoNativeThreadId
 mono_thread_info_get_tid (THREAD_INFO_TYPE *info)
@@ -454,6 +494,12 @@ mono_thread_info_get_small_id (void);
 MonoLinkedListSet*
 mono_thread_info_list_head (void);
 
+MonoThreadInfo * volatile *
+mono_thread_info_table_get (int *size);
+
+MonoThreadInfo *
+mono_thread_info_table_get_hazardous (int index, MonoThreadHazardPointers *hp, int hazard_index);
+
 THREAD_INFO_TYPE*
 mono_thread_info_lookup (MonoNativeThreadId id);
 
@@ -539,6 +585,9 @@ mono_threads_open_thread_handle (MonoThreadHandle *handle);
 void
 mono_threads_close_thread_handle (MonoThreadHandle *handle);
 
+void
+mono_thread_info_renew_handle (void);
+
 MonoNativeThreadHandle
 mono_threads_open_native_thread_handle (MonoNativeThreadHandle handle);
 
@@ -180,6 +180,7 @@ MONO_KEYWORD_THREAD MonoJitTlsData     *mono_tls_jit_tls MONO_TLS_FAST;
 MONO_KEYWORD_THREAD MonoDomain         *mono_tls_domain MONO_TLS_FAST;
 MONO_KEYWORD_THREAD SgenThreadInfo     *mono_tls_sgen_thread_info MONO_TLS_FAST;
 MONO_KEYWORD_THREAD MonoLMF           **mono_tls_lmf_addr MONO_TLS_FAST;
+MONO_KEYWORD_THREAD gpointer           *mono_tls_thread_static_data MONO_TLS_FAST;
 
 #else
 
@@ -196,6 +197,7 @@ static MonoNativeTlsKey mono_tls_key_jit_tls;
 static MonoNativeTlsKey mono_tls_key_domain;
 static MonoNativeTlsKey mono_tls_key_sgen_thread_info;
 static MonoNativeTlsKey mono_tls_key_lmf_addr;
+static MonoNativeTlsKey mono_tls_key_thread_static_data;
 
 #endif
 
@@ -228,6 +230,7 @@ mono_tls_init_runtime_keys (void)
 	MONO_THREAD_VAR_OFFSET (mono_tls_jit_tls, tls_offsets [TLS_KEY_JIT_TLS]);
 	MONO_THREAD_VAR_OFFSET (mono_tls_domain, tls_offsets [TLS_KEY_DOMAIN]);
 	MONO_THREAD_VAR_OFFSET (mono_tls_lmf_addr, tls_offsets [TLS_KEY_LMF_ADDR]);
+	MONO_THREAD_VAR_OFFSET (mono_tls_thread_static_data, tls_offsets [TLS_KEY_THREAD_STATIC_DATA]);
 #else
 	mono_native_tls_alloc (&mono_tls_key_thread, NULL);
 	MONO_THREAD_VAR_OFFSET (mono_tls_key_thread, tls_offsets [TLS_KEY_THREAD]);
@@ -237,6 +240,8 @@ mono_tls_init_runtime_keys (void)
 	MONO_THREAD_VAR_OFFSET (mono_tls_key_domain, tls_offsets [TLS_KEY_DOMAIN]);
 	mono_native_tls_alloc (&mono_tls_key_lmf_addr, NULL);
 	MONO_THREAD_VAR_OFFSET (mono_tls_key_lmf_addr, tls_offsets [TLS_KEY_LMF_ADDR]);
+	mono_native_tls_alloc (&mono_tls_key_thread_static_data, NULL);
+	MONO_THREAD_VAR_OFFSET (mono_tls_key_thread_static_data, tls_offsets [TLS_KEY_THREAD_STATIC_DATA]);
 #endif
 }
 
@@ -249,6 +254,7 @@ mono_tls_free_keys (void)
 	mono_native_tls_free (mono_tls_key_domain);
 	mono_native_tls_free (mono_tls_key_sgen_thread_info);
 	mono_native_tls_free (mono_tls_key_lmf_addr);
+	mono_native_tls_free (mono_tls_key_thread_static_data);
 #endif
 }
 
@@ -293,6 +299,11 @@ MonoLMF **mono_tls_get_lmf_addr (void)
 	return (MonoLMF**)MONO_TLS_GET_VALUE (mono_tls_lmf_addr, mono_tls_key_lmf_addr);
 }
 
+gpointer *mono_tls_get_thread_static_data (void)
+{
+	return (gpointer*)MONO_TLS_GET_VALUE (mono_tls_thread_static_data, mono_tls_key_thread_static_data);
+}
+
 /* Setters for each tls key */
 void mono_tls_set_thread (MonoInternalThread *value)
 {
@@ -318,3 +329,8 @@ void mono_tls_set_lmf_addr (MonoLMF **value)
 {
 	MONO_TLS_SET_VALUE (mono_tls_lmf_addr, mono_tls_key_lmf_addr, value);
 }
+
+void mono_tls_set_thread_static_data (gpointer *value)
+{
+	MONO_TLS_SET_VALUE (mono_tls_thread_static_data, mono_tls_key_thread_static_data, value);
+}
@@ -25,7 +25,8 @@ typedef enum {
 	TLS_KEY_LMF_ADDR	 = 2,
 	TLS_KEY_SGEN_THREAD_INFO = 3,
 	TLS_KEY_THREAD		 = 4, // mono_thread_internal_current ()
-	TLS_KEY_NUM		 = 5
+	TLS_KEY_THREAD_STATIC_DATA = 5, // mono_thread_internal_current ()->static_data
+	TLS_KEY_NUM		 = 6
 } MonoTlsKey;
 
 #if __cplusplus
@@ -108,11 +109,13 @@ G_EXTERN_C MonoJitTlsData     *mono_tls_get_jit_tls (void);
 G_EXTERN_C MonoDomain *mono_tls_get_domain (void);
 G_EXTERN_C SgenThreadInfo     *mono_tls_get_sgen_thread_info (void);
 G_EXTERN_C MonoLMF           **mono_tls_get_lmf_addr (void);
+G_EXTERN_C gpointer           *mono_tls_get_thread_static_data (void);
 
 void mono_tls_set_thread 	   (MonoInternalThread *value);
 void mono_tls_set_jit_tls 	   (MonoJitTlsData     *value);
 void mono_tls_set_domain 	   (MonoDomain         *value);
 void mono_tls_set_sgen_thread_info (SgenThreadInfo     *value);
 void mono_tls_set_lmf_addr 	   (MonoLMF           **value);
+void mono_tls_set_thread_static_data (gpointer        *value);
 
 #endif /* __MONO_TLS_H__ */
@@ -637,14 +637,7 @@ mono_bitset_equal (const MonoBitSet *src, const MonoBitSet *src1) {
 void
 mono_bitset_foreach (MonoBitSet *set, MonoBitSetFunc func, gpointer data)
 {
-	int i, j;
-	for (i = 0; i < set->size / BITS_PER_CHUNK; ++i) {
-		if (set->data [i]) {
-			for (j = 0; j < BITS_PER_CHUNK; ++j)
-				if (set->data [i] & ((gsize)1 << j))
-					func (j + i * BITS_PER_CHUNK, data);
-		}
-	}
+	MONO_BITSET_FOREACH (set, idx, func (idx, data));
 }
 
 gboolean
@@ -653,6 +646,62 @@ mono_bitset_test_safe (const MonoBitSet *set, guint32 pos)
 	return set && set->size > pos && mono_bitset_test (set, pos);
 }
 
+/*
+ * The loops below have no early exits and no branches on the data, so the
+ * compiler can vectorize them. Dataflow passes call them on every iteration.
+ */
+
+/**
+ * mono_bitset_union_changed:
+ * \param dest bitset ptr to hold union
+ * \param src bitset ptr to copy
+ *
+ * Same as \c mono_bitset_union, but also tells whether \p dest changed,
+ * without having to keep a copy of it around to compare with.
+ * \returns TRUE if \p src had bits which were not set in \p dest.
+ */
+gboolean
+mono_bitset_union_changed (MonoBitSet *dest, const MonoBitSet *src)
+{
+	gsize *d = dest->data;
+	const gsize *s = src->data;
+	gsize added = 0;
+	int i, size;
+
+	g_assert (src->size <= dest->size);
+
+	size = src->size / BITS_PER_CHUNK;
+	for (i = 0; i < size; ++i) {
+		added |= s [i] & ~d [i];
+		d [i] |= s [i];
+	}
+	return added != 0;
+}
+
+/**
+ * mono_bitset_sub_union:
+ * \param dest bitset ptr to hold the result
+ * \param src bitset ptr to copy
+ * \param sub bits to remove from \p src
+ * \param add bits to add afterwards
+ *
+ * Compute (\p src - \p sub) | \p add into \p dest in a single pass, ie. the
+ * copyto, sub and union sequence of the liveness transfer function.
+ */
+void
+mono_bitset_sub_union (MonoBitSet *dest, const MonoBitSet *src, const MonoBitSet *sub, const MonoBitSet *add)
+{
+	gsize *d = dest->data;
+	const gsize *s = src->data, *k = sub->data, *a = add->data;
+	int i, size;
+
+	g_assert (dest->size <= src->size && dest->size <= sub->size && dest->size <= add->size);
+
+	size = dest->size / BITS_PER_CHUNK;
+	for (i = 0; i < size; ++i)
+		d [i] = (s [i] & ~k [i]) | a [i];
+}
+
 #ifdef TEST_BITSET
 
 /*
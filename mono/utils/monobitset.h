@@ -30,18 +30,35 @@ enum {
 
 #define mono_bitset_copyto_fast(src,dest) do { memcpy (&(dest)->data, &(src)->data, (dest)->size / 8); } while (0)
 
+/* Index of the lowest set bit of \p mask, which must not be 0 */
+static inline int
+mono_bitset_chunk_lowest_bit (gsize mask)
+{
+#if defined (__GNUC__)
+	if (sizeof (gsize) == sizeof (unsigned int))
+		return __builtin_ctz (mask);
+	else
+		return __builtin_ctzll (mask);
+#else
+	int nth_bit = 0;
+
+	while (!(mask & 1)) {
+		mask >>= 1;
+		nth_bit ++;
+	}
+	return nth_bit;
+#endif
+}
+
+/* Only visits the set bits, clearing them one by one from a copy of each chunk */
 #define MONO_BITSET_FOREACH(set,idx,/*stmt*/...) \
 	do \
 	{ \
 		MonoBitSet *set__ = (set); \
 		for (int i__ = 0; i__ < set__->size / MONO_BITSET_BITS_PER_CHUNK; i__++) { \
-			if (set__->data [i__]) { \
-				for (int j__ = 0; j__ < MONO_BITSET_BITS_PER_CHUNK; j__++) { \
-					if (set__->data [i__] & ((gsize) 1 << j__)) { \
-						guint idx = j__ + i__ * MONO_BITSET_BITS_PER_CHUNK; \
-						__VA_ARGS__; \
-					} \
-				} \
+			for (gsize d__ = set__->data [i__]; d__; d__ &= d__ - 1) { \
+				guint idx = mono_bitset_chunk_lowest_bit (d__) + i__ * MONO_BITSET_BITS_PER_CHUNK; \
+				__VA_ARGS__; \
 			} \
 		} \
 	} while (0)
@@ -124,4 +141,10 @@ MONO_API void        mono_bitset_intersection_2 (MonoBitSet *dest, const MonoBit
 gboolean
 mono_bitset_test_safe (const MonoBitSet *set, guint32 pos);
 
+gboolean
+mono_bitset_union_changed (MonoBitSet *dest, const MonoBitSet *src);
+
+void
+mono_bitset_sub_union (MonoBitSet *dest, const MonoBitSet *src, const MonoBitSet *sub, const MonoBitSet *add);
+
 #endif /* __MONO_BITSET_H__ */
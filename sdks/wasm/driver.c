@@ -25,6 +25,7 @@ void core_initialize_internals ();
 // Blazor specific custom routines - see dotnet_support.js for backing code
 extern void* mono_wasm_invoke_js_marshalled (MonoString **exceptionMessage, void *asyncHandleLongPtr, MonoString *funcName, MonoString *argsJson);
 extern void* mono_wasm_invoke_js_unmarshalled (MonoString **exceptionMessage, MonoString *funcName, void* arg0, void* arg1, void* arg2);
+extern void* mono_wasm_fetch_lazy_assembly (const char *name, int *size);
 
 void mono_wasm_enable_debugging (void);
 
@@ -159,6 +160,100 @@ mono_wasm_add_assembly (const char *name, const unsigned char *data, unsigned in
 	++assembly_count;
 }
 
+static void
+register_bundled_assemblies (void)
+{
+	/* The runtime keeps a pointer to the array, so it is never freed */
+	MonoBundledAssembly **bundle_array = g_new0 (MonoBundledAssembly*, assembly_count + 1);
+	WasmAssembly *cur = assemblies;
+	int i = 0;
+	while (cur) {
+		bundle_array [i] = &cur->assembly;
+		cur = cur->next;
+		++i;
+	}
+	mono_register_bundled_assemblies ((const MonoBundledAssembly **)bundle_array);
+}
+
+typedef struct LazyAssembly_ LazyAssembly;
+
+struct LazyAssembly_ {
+	char *name;
+	LazyAssembly *next;
+};
+
+/* Assemblies deployed with the app but only fetched when first loaded */
+static LazyAssembly *lazy_assemblies;
+
+EMSCRIPTEN_KEEPALIVE void
+mono_wasm_add_lazy_assembly (const char *name)
+{
+	LazyAssembly *entry = g_new0 (LazyAssembly, 1);
+	entry->name = m_strdup (name);
+	entry->next = lazy_assemblies;
+	lazy_assemblies = entry;
+}
+
+/* Removes NAME from the lazy assemblies, so each one is only fetched once */
+static int
+lazy_assembly_take (const char *name)
+{
+	LazyAssembly **prev = &lazy_assemblies;
+	for (LazyAssembly *cur = lazy_assemblies; cur; prev = &cur->next, cur = cur->next) {
+		if (!strcmp (cur->name, name)) {
+			*prev = cur->next;
+			free (cur->name);
+			free (cur);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static int
+lazy_assembly_fetch (const char *name)
+{
+	int size = 0;
+	unsigned char *data = mono_wasm_fetch_lazy_assembly (name, &size);
+	if (!data)
+		return 0;
+	mono_wasm_add_assembly (name, data, size);
+	return 1;
+}
+
+/*
+ * Fetches the assembly from the server the first time it is referenced and adds it
+ * to the bundled assemblies.  Returning NULL lets the loader continue probing, which
+ * then finds it in the bundle like the assemblies fetched at startup.
+ */
+static MonoAssembly*
+wasm_lazy_assembly_preload (MonoAssemblyName *aname, char **assemblies_path, void *user_data)
+{
+	static const char *extensions [] = { ".dll", ".exe" };
+	const char *name = mono_assembly_name_get_name (aname);
+	char buf [256];
+
+	if (!lazy_assemblies || !name)
+		return NULL;
+
+	for (int i = 0; i < (int)(sizeof (extensions) / sizeof (extensions [0])); ++i) {
+		snprintf (buf, sizeof (buf), "%s%s", name, extensions [i]);
+		if (!lazy_assembly_take (buf))
+			continue;
+		if (!lazy_assembly_fetch (buf))
+			return NULL;
+
+		/* Symbols have to be registered before the image is opened */
+		snprintf (buf, sizeof (buf), "%s.pdb", name);
+		if (lazy_assembly_take (buf))
+			lazy_assembly_fetch (buf);
+
+		register_bundled_assemblies ();
+		return NULL;
+	}
+	return NULL;
+}
+
 EMSCRIPTEN_KEEPALIVE void
 mono_wasm_setenv (const char *name, const char *value)
 {
@@ -342,17 +437,10 @@ mono_wasm_load_runtime (const char *managed_path, int enable_debugging)
 	mono_sgen_mono_ilgen_init ();
 #endif
 
-	if (assembly_count) {
-		MonoBundledAssembly **bundle_array = g_new0 (MonoBundledAssembly*, assembly_count + 1);
-		WasmAssembly *cur = assemblies;
-		int i = 0;
-		while (cur) {
-			bundle_array [i] = &cur->assembly;
-			cur = cur->next;
-			++i;
-		}
-		mono_register_bundled_assemblies ((const MonoBundledAssembly **)bundle_array);
-	}
+	if (assembly_count)
+		register_bundled_assemblies ();
+	if (lazy_assemblies)
+		mono_install_assembly_preload_hook (wasm_lazy_assembly_preload, NULL);
 
 	mono_trace_init ();
 	mono_trace_set_log_handler (wasm_logger, NULL);
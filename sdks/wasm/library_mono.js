@@ -152,11 +152,24 @@ var MonoSupportLib = {
 			Module.ccall ('mono_wasm_load_profiler_aot', 'void', ['string'], [arg]);
 		},
 
-		mono_load_runtime_and_bcl: function (vfs_prefix, deploy_prefix, enable_debugging, file_list, loaded_cb, fetch_file_cb) {
+		//
+		// Fetches FILE_LIST and starts the runtime once all of them arrived.
+		// The assemblies in LAZY_FILE_LIST are only fetched, synchronously, when the
+		// runtime first tries to load them, see mono_wasm_fetch_lazy_assembly ().
+		//
+		mono_load_runtime_and_bcl: function (vfs_prefix, deploy_prefix, enable_debugging, file_list, loaded_cb, fetch_file_cb, lazy_file_list) {
 			var pending = file_list.length;
 			var loaded_files = [];
 			var mono_wasm_add_assembly = Module.cwrap ('mono_wasm_add_assembly', null, ['string', 'number', 'number']);
 
+			MONO.deploy_prefix = deploy_prefix;
+			if (lazy_file_list) {
+				var mono_wasm_add_lazy_assembly = Module.cwrap ('mono_wasm_add_lazy_assembly', null, ['string']);
+				lazy_file_list.forEach (function (file_name) {
+					mono_wasm_add_lazy_assembly (file_name);
+				});
+			}
+
 			if (!fetch_file_cb) {
 				if (ENVIRONMENT_IS_NODE) {
 					var fs = require('fs');
@@ -367,6 +380,68 @@ var MonoSupportLib = {
 		}
 	},
 
+	mono_wasm_fetch_lazy_assembly: function (name, size_ptr) {
+		var file_name = Module.UTF8ToString (name);
+		var url = locateFile (MONO.deploy_prefix + "/" + file_name);
+		var bytes = null;
+
+		try {
+			if (ENVIRONMENT_IS_NODE) {
+				bytes = new Uint8Array (require ('fs').readFileSync (url));
+			} else if (ENVIRONMENT_IS_SHELL) {
+				bytes = new Uint8Array (read (url, 'binary'));
+			} else {
+				// The runtime is blocked waiting for the assembly, so this has to be a synchronous request
+				var xhr = new XMLHttpRequest ();
+				xhr.open ('GET', url, false);
+				if (ENVIRONMENT_IS_WORKER)
+					xhr.responseType = 'arraybuffer';
+				else
+					xhr.overrideMimeType ('text/plain; charset=x-user-defined');
+				xhr.send (null);
+				if ((xhr.status >= 200 && xhr.status < 300) || xhr.status == 0) {
+					if (ENVIRONMENT_IS_WORKER) {
+						bytes = new Uint8Array (xhr.response);
+					} else {
+						var text = xhr.responseText;
+						bytes = new Uint8Array (text.length);
+						for (var i = 0; i < text.length; ++i)
+							bytes [i] = text.charCodeAt (i) & 0xff;
+					}
+				}
+			}
+		} catch (e) {
+			console.log ("failed to load '" + file_name + "': " + e);
+		}
+
+		if (!bytes)
+			return 0;
+
+		var memory = Module._malloc (bytes.length);
+		Module.HEAPU8.set (bytes, memory);
+		Module.setValue (size_ptr, bytes.length, "i32");
+		console.log ("Loaded on demand: " + file_name);
+		return memory;
+	},
+
+	// Instantiates a trace compiled by the interpreter, see mono/mini/interp/jiterpreter.c
+	mono_wasm_jiterp_instantiate: function (bytes, len) {
+		try {
+			if (!MONO.jiterp_imports) {
+				var memory = Module ['wasmMemory'] || (typeof wasmMemory !== 'undefined' ? wasmMemory : Module ['asm'] ['memory']);
+				MONO.jiterp_imports = { m: { h: memory } };
+			}
+			// Modules below 4KB, which traces are limited to, can be compiled synchronously on the main thread
+			var module = new WebAssembly.Module (Module.HEAPU8.slice (bytes, bytes + len));
+			var instance = new WebAssembly.Instance (module, MONO.jiterp_imports);
+			return Module.addFunction (instance.exports.f, 'iii');
+		} catch (e) {
+			// Also happens once the reserved function table slots are used up
+			console.log ("failed to compile interpreter trace: " + e);
+			return 0;
+		}
+	},
+
 	mono_wasm_fire_bp: function () {
 		console.log ("mono_wasm_fire_bp");
 		debugger;
@@ -132,6 +132,7 @@ class Driver {
 		Console.WriteLine ("\t\t              'ifnewer' copies or overwrites the file if modified or size is different.");
 		Console.WriteLine ("\t--profile=x     Enable the 'x' mono profiler.");
 		Console.WriteLine ("\t--aot-assemblies=x List of assemblies to AOT in AOT+INTERP mode.");
+		Console.WriteLine ("\t--lazy-assemblies=x List of assemblies to fetch only when the app first references them.");
 		Console.WriteLine ("\t--link-mode=sdkonly|all        Set the link type used for AOT. (EXPERIMENTAL)");
 		Console.WriteLine ("\t--pinvoke-libs=x DllImport libraries used.");
 		Console.WriteLine ("\t\t              'sdkonly' only link the Core libraries.");
@@ -345,6 +346,7 @@ class Driver {
 		string sdkdir = null;
 		string emscripten_sdkdir = null;
 		var aot_assemblies = "";
+		var lazy_assemblies = "";
 		out_prefix = Environment.CurrentDirectory;
 		app_prefix = Environment.CurrentDirectory;
 		var deploy_prefix = "managed";
@@ -402,6 +404,7 @@ class Driver {
 				{ "profile=", s => profilers.Add (s) },
 				{ "copy=", s => copyTypeParm = s },
 				{ "aot-assemblies=", s => aot_assemblies = s },
+				{ "lazy-assemblies=", s => lazy_assemblies = s },
 				{ "link-mode=", s => linkModeParm = s },
 				{ "link-descriptor=", s => linkDescriptor = s },
 				{ "pinvoke-libs=", s => pinvoke_libs = s },
@@ -584,7 +587,61 @@ class Driver {
 				if (File.Exists(runtimeTemplate))
 					CopyFile (runtimeTemplate, runtime_js, CopyType.IfNewer, $"runtime template <{runtimeTemplate}> ");
 				else {
-					var runtime_gen = "\nvar Module = {\n\tonRuntimeInitialized: function () {\n\t\tMONO.mono_load_runtime_and_bcl (\n\t\tconfig.vfs_prefix,\n\t\tconfig.deploy_prefix,\n\t\tconfig.enable_debugging,\n\t\tconfig.file_list,\n\t\tfunction () {\n\t\t\tApp.init ();\n\t\t}\n\t)\n\t},\n};";
+					var runtime_gen = @"
+// Start downloading the assemblies right away, so they arrive while mono.wasm is compiling
+var prefetched_files = null;
+if (typeof fetch === 'function' && typeof window !== 'undefined') {
+	prefetched_files = {};
+	config.file_list.forEach (function (file_name) {
+		prefetched_files [file_name] = fetch (config.deploy_prefix + ""/"" + file_name, { credentials: 'same-origin' });
+	});
+}
+
+var Module = {
+	instantiateWasm: prefetched_files && function (imports, successCallback) {
+		var wasm_url = Module.locateFile ? Module.locateFile (""mono.wasm"") : ""mono.wasm"";
+		var instantiate = function () {
+			return fetch (wasm_url, { credentials: 'same-origin' }).then (function (response) {
+				return response ['arrayBuffer'] ();
+			}).then (function (bytes) {
+				return WebAssembly.instantiate (bytes, imports);
+			});
+		};
+		var result;
+		// instantiateStreaming needs the server to send mono.wasm as application/wasm
+		if (typeof WebAssembly.instantiateStreaming === 'function' && typeof fetch === 'function')
+			result = WebAssembly.instantiateStreaming (fetch (wasm_url, { credentials: 'same-origin' }), imports).catch (function (e) {
+				console.log (""streaming compilation of mono.wasm failed, falling back: "" + e);
+				return instantiate ();
+			});
+		else
+			result = instantiate ();
+		result.then (function (output) {
+			successCallback (output.instance, output.module);
+		});
+		return {};
+	},
+
+	onRuntimeInitialized: function () {
+		MONO.mono_load_runtime_and_bcl (
+			config.vfs_prefix,
+			config.deploy_prefix,
+			config.enable_debugging,
+			config.file_list,
+			function () {
+				App.init ();
+			},
+			prefetched_files && function (asset) {
+				var file_name = asset.substring (asset.lastIndexOf (""/"") + 1);
+				var prefetched = prefetched_files [file_name];
+				delete prefetched_files [file_name];
+				return prefetched || fetch (asset, { credentials: 'same-origin' });
+			},
+			config.lazy_file_list
+		)
+	},
+};
+";
 					File.Delete (runtime_js);
 					File.WriteAllText (runtime_js, runtime_gen);
 				}
@@ -606,8 +663,20 @@ class Driver {
 			file_list.Add ("aot-dummy.dll");
 		}
 
-		var file_list_str = string.Join (",", file_list.Select (f => $"\"{Path.GetFileName (f)}\"").Distinct());
-		var config = String.Format ("config = {{\n \tvfs_prefix: \"{0}\",\n \tdeploy_prefix: \"{1}\",\n \tenable_debugging: {2},\n \tfile_list: [ {3} ],\n", vfs_prefix, deploy_prefix, enable_debug ? "1" : "0", file_list_str);
+		// Lazy assemblies are deployed like the others, but the runtime only fetches them on first use
+		var lazy = new HashSet<string> ();
+		foreach (var s in lazy_assemblies.Split (new char [] { ',' }, StringSplitOptions.RemoveEmptyEntries)) {
+			if (s == "mscorlib") {
+				Console.Error.WriteLine ("mscorlib can't be loaded lazily.");
+				return 1;
+			}
+			lazy.Add (s);
+		}
+		var startup_files = file_list.Where (f => !lazy.Contains (Path.GetFileNameWithoutExtension (f)));
+		var lazy_files = file_list.Where (f => lazy.Contains (Path.GetFileNameWithoutExtension (f)));
+		var file_list_str = string.Join (",", startup_files.Select (f => $"\"{Path.GetFileName (f)}\"").Distinct());
+		var lazy_file_list_str = string.Join (",", lazy_files.Select (f => $"\"{Path.GetFileName (f)}\"").Distinct());
+		var config = String.Format ("config = {{\n \tvfs_prefix: \"{0}\",\n \tdeploy_prefix: \"{1}\",\n \tenable_debugging: {2},\n \tfile_list: [ {3} ],\n \tlazy_file_list: [ {4} ],\n", vfs_prefix, deploy_prefix, enable_debug ? "1" : "0", file_list_str, lazy_file_list_str);
 		config += "}\n";
 		var config_js = Path.Combine (emit_ninja ? builddir : out_prefix, "mono-config.js");
 		File.Delete (config_js);
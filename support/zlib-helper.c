@@ -39,6 +39,7 @@ struct _ZStream {
 	guchar *buffer;
 	read_write_func func;
 	void *gchandle;
+	gint buffer_size;
 	guchar compress;
 	guchar eof;
 	guint32 total_in;
@@ -47,6 +48,8 @@ typedef struct _ZStream ZStream;
 
 // FIXME? Names should start "mono"?
 MONO_API ZStream *CreateZStream (gint compress, guchar gzip, read_write_func func, void *gchandle);
+MONO_API ZStream *CreateZStreamEx (gint compress, guchar gzip, gint level, gint window_bits, gint buffer_size, read_write_func func, void *gchandle);
+MONO_API gint ProcessZStream (ZStream *stream, guchar *in, gint in_length, guchar *out, gint out_length, gint flush, gint *consumed, gint *produced);
 MONO_API gint CloseZStream (ZStream *zstream);
 MONO_API gint Flush (ZStream *stream);
 MONO_API gint ReadZStream (ZStream *stream, guchar *buffer, gint length);
@@ -67,19 +70,42 @@ z_free (void *opaque, void *ptr)
 
 ZStream *
 CreateZStream (gint compress, guchar gzip, read_write_func func, void *gchandle)
+{
+	if (func == NULL)
+		return NULL;
+
+	return CreateZStreamEx (compress, gzip, Z_DEFAULT_COMPRESSION, 15, BUFFER_SIZE, func, gchandle);
+}
+
+/*
+ * Like CreateZStream, but with the compression level, the window size (log2, 9 to 15)
+ * and the size of the buffer used to talk to @func picked by the caller.
+ * A NULL @func creates a stream that can only be used with ProcessZStream.
+ */
+ZStream *
+CreateZStreamEx (gint compress, guchar gzip, gint level, gint window_bits, gint buffer_size, read_write_func func, void *gchandle)
 {
 	z_stream *z;
 	gint retval;
 	ZStream *result;
 
-	if (func == NULL)
+	if (window_bits < 9 || window_bits > 15 || buffer_size < 0)
+		return NULL;
+	if (level < Z_DEFAULT_COMPRESSION || level > Z_BEST_COMPRESSION)
 		return NULL;
 
+	if (buffer_size == 0)
+		buffer_size = BUFFER_SIZE;
+	if (gzip)
+		window_bits += 16;
+	else
+		window_bits = -window_bits;
+
 	z = z_new0 (z_stream);
 	if (compress) {
-		retval = deflateInit2 (z, Z_DEFAULT_COMPRESSION, Z_DEFLATED, gzip ? 31 : -15, 8, Z_DEFAULT_STRATEGY);
+		retval = deflateInit2 (z, level, Z_DEFLATED, window_bits, 8, Z_DEFAULT_STRATEGY);
 	} else {
-		retval = inflateInit2 (z, gzip ? 31 : -15);
+		retval = inflateInit2 (z, window_bits);
 	}
 
 	if (retval != Z_OK) {
@@ -93,9 +119,12 @@ CreateZStream (gint compress, guchar gzip, read_write_func func, void *gchandle)
 	result->func = func;
 	result->gchandle = gchandle;
 	result->compress = compress;
-	result->buffer = (guchar*)malloc (BUFFER_SIZE);
-	result->stream->next_out = result->buffer;
-	result->stream->avail_out = BUFFER_SIZE;
+	result->buffer_size = buffer_size;
+	if (func) {
+		result->buffer = (guchar*)malloc (buffer_size);
+		result->stream->next_out = result->buffer;
+		result->stream->avail_out = buffer_size;
+	}
 	result->stream->total_in = 0;
 	return result;
 }
@@ -111,7 +140,8 @@ CloseZStream (ZStream *zstream)
 
 	status = 0;
 	if (zstream->compress) {
-		if (zstream->stream->total_in > 0) {
+		/* Streams without a callback are finished by the caller through ProcessZStream */
+		if (zstream->func && zstream->stream->total_in > 0) {
 			do {
 				status = deflate (zstream->stream, Z_FINISH);
 				flush_status = flush_internal (zstream, TRUE);
@@ -141,10 +171,10 @@ write_to_managed (ZStream *stream)
 	z_stream *zs;
 
 	zs = stream->stream;
-	if (zs->avail_out != BUFFER_SIZE) {
-		n = stream->func (stream->buffer, BUFFER_SIZE - zs->avail_out, stream->gchandle);
+	if (zs->avail_out != stream->buffer_size) {
+		n = stream->func (stream->buffer, stream->buffer_size - zs->avail_out, stream->gchandle);
 		zs->next_out = stream->buffer;
-		zs->avail_out = BUFFER_SIZE;
+		zs->avail_out = stream->buffer_size;
 		if (n == MONO_EXCEPTION)
 			return n;
 		if (n < 0)
@@ -158,7 +188,7 @@ flush_internal (ZStream *stream, gboolean is_final)
 {
 	gint status;
 
-	if (!stream->compress)
+	if (!stream->compress || !stream->func)
 		return 0;
 
 	if (!is_final && stream->stream->avail_in != 0) {
@@ -185,6 +215,9 @@ ReadZStream (ZStream *stream, guchar *buffer, gint length)
 	if (stream == NULL || buffer == NULL || length < 0)
 		return ARGUMENT_ERROR;
 
+	if (stream->func == NULL)
+		return ARGUMENT_ERROR;
+
 	if (stream->eof)
 		return 0;
 
@@ -193,7 +226,7 @@ ReadZStream (ZStream *stream, guchar *buffer, gint length)
 	zs->avail_out = length;
 	while (zs->avail_out > 0) {
 		if (zs->avail_in == 0) {
-			n = stream->func (stream->buffer, BUFFER_SIZE, stream->gchandle);
+			n = stream->func (stream->buffer, stream->buffer_size, stream->gchandle);
 			n = n < 0 ? 0 : n;
 			stream->total_in += n;
 			zs->next_in = stream->buffer;
@@ -229,6 +262,9 @@ WriteZStream (ZStream *stream, guchar *buffer, gint length)
 	if (stream == NULL || buffer == NULL || length < 0)
 		return ARGUMENT_ERROR;
 
+	if (stream->func == NULL)
+		return ARGUMENT_ERROR;
+
 	if (stream->eof)
 		return IO_ERROR;
 
@@ -238,7 +274,7 @@ WriteZStream (ZStream *stream, guchar *buffer, gint length)
 	while (zs->avail_in > 0) {
 		if (zs->avail_out == 0) {
 			zs->next_out = stream->buffer;
-			zs->avail_out = BUFFER_SIZE;
+			zs->avail_out = stream->buffer_size;
 		}
 		status = deflate (stream->stream, Z_NO_FLUSH);
 		if (status != Z_OK && status != Z_STREAM_END)
@@ -253,3 +289,47 @@ WriteZStream (ZStream *stream, guchar *buffer, gint length)
 	return length;
 }
 
+
+/*
+ * Runs the stream over the caller's (pinned) buffers without any callbacks or
+ * intermediate copies: compresses or decompresses as much of @in into @out as
+ * fits and reports how much of each was used.  @flush is one of the zlib flush
+ * values, Z_FINISH ends a compressed stream.  Returns Z_OK, Z_STREAM_END once
+ * the end of the stream was written or read, Z_BUF_ERROR when no progress was
+ * possible, or another zlib error.
+ */
+gint
+ProcessZStream (ZStream *stream, guchar *in, gint in_length, guchar *out, gint out_length, gint flush, gint *consumed, gint *produced)
+{
+	gint status;
+	z_stream *zs;
+
+	if (stream == NULL || stream->func != NULL || consumed == NULL || produced == NULL)
+		return ARGUMENT_ERROR;
+	if ((in == NULL && in_length != 0) || in_length < 0 || out == NULL || out_length < 0)
+		return ARGUMENT_ERROR;
+	if (flush < Z_NO_FLUSH || flush > Z_BLOCK)
+		return ARGUMENT_ERROR;
+
+	zs = stream->stream;
+	zs->next_in = in;
+	zs->avail_in = in_length;
+	zs->next_out = out;
+	zs->avail_out = out_length;
+
+	if (stream->eof) {
+		status = Z_STREAM_END;
+	} else if (stream->compress) {
+		status = deflate (zs, flush);
+	} else {
+		status = inflate (zs, flush == Z_FINISH ? Z_FINISH : Z_SYNC_FLUSH);
+		if (status == Z_STREAM_END)
+			stream->eof = TRUE;
+	}
+
+	*consumed = in_length - zs->avail_in;
+	*produced = out_length - zs->avail_out;
+	zs->next_in = NULL;
+	zs->next_out = NULL;
+	return status;
+}
@@ -13,6 +13,7 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include "sgen-entry-stream.h"
+#include "sgen-replay-export.h"
 #include "sgen-grep-binprot.h"
 
 /* FIXME Add grepers for specific endianness */
@@ -34,6 +35,8 @@ main (int argc, char *argv[])
 	gboolean dump_all = FALSE;
 	gboolean color_output = FALSE;
 	gboolean pause_times = FALSE;
+	gboolean export_replay = FALSE;
+	ReplayExport *replay_export = NULL;
 	const char *input_path = NULL;
 	int input_file;
 	EntryStream stream;
@@ -46,6 +49,8 @@ main (int argc, char *argv[])
 			dump_all = TRUE;
 		} else if (!strcmp (arg, "--pause-times")) {
 			pause_times = TRUE;
+		} else if (!strcmp (arg, "--export-replay")) {
+			export_replay = TRUE;
 		} else if (!strcmp (arg, "-v") || !strcmp (arg, "--vtable")) {
 			vtables [num_vtables++] = strtoul (next_arg, NULL, 16);
 			++i;
@@ -68,11 +73,13 @@ main (int argc, char *argv[])
 				"\n"
 				"\tsgen-grep-binprot --all </tmp/binprot\n"
 				"\tsgen-grep-binprot --input /tmp/binprot --color 0xdeadbeef\n"
+				"\tsgen-grep-binprot --export-replay </tmp/binprot >/tmp/trace.replay\n"
 				"\n"
 				"Options:\n"
 				"\n"
 				"\t--all                    Print all entries.\n"
 				"\t--color, -c              Highlight matches in color.\n"
+				"\t--export-replay          Write a replay trace for gc-replay.exe, see sgen-replay.py.\n"
 				"\t--help                   You're looking at it.\n"
 				"\t--input FILE, -i FILE    Read input from FILE instead of standard input.\n"
 				"\t--pause-times            Print GC pause times.\n"
@@ -89,12 +96,16 @@ main (int argc, char *argv[])
 		assert (!pause_times);
 	if (pause_times)
 		assert (!dump_all);
+	if (export_replay) {
+		assert (!dump_all && !pause_times);
+		replay_export = replay_export_new ();
+	}
 
 	input_file = input_path ? open (input_path, O_RDONLY) : STDIN_FILENO;
 	init_stream (&stream, input_file);
 	for (i = 0; i < sizeof (grepers) / sizeof (GrepEntriesFunction); i++) {
 		if (grepers [i] (&stream, num_nums, nums, num_vtables, vtables, dump_all,
-				pause_times, color_output, first_entry_to_consider)) {
+				pause_times, color_output, first_entry_to_consider, replay_export)) {
 			/* Success */
 			break;
 		}
@@ -104,5 +115,12 @@ main (int argc, char *argv[])
 	if (input_path)
 		close (input_file);
 
+	if (replay_export) {
+		gboolean written = replay_export_write (replay_export, stdout);
+		replay_export_free (replay_export);
+		if (!written)
+			return 1;
+	}
+
 	return 0;
 }
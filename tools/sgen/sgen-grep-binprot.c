@@ -16,6 +16,7 @@
 #include <inttypes.h>
 #include <config.h>
 #include "sgen-entry-stream.h"
+#include "sgen-replay-export.h"
 #include "sgen-grep-binprot.h"
 
 static int file_version = 0;
@@ -34,6 +35,7 @@ static int file_version = 0;
 
 #if BINPROT_SIZEOF_VOID_P == 4
 typedef int32_t mword;
+typedef uint32_t umword;
 #define MWORD_FORMAT_SPEC_D PRId32
 #define MWORD_FORMAT_SPEC_P PRIx32
 #ifndef ARCH_SUFFIX
@@ -41,6 +43,7 @@ typedef int32_t mword;
 #endif
 #else
 typedef int64_t mword;
+typedef uint64_t umword;
 #define MWORD_FORMAT_SPEC_D PRId64
 #define MWORD_FORMAT_SPEC_P PRIx64
 #ifndef ARCH_SUFFIX
@@ -575,6 +578,56 @@ is_vtable_match (mword ptr, int type, void *data)
 	}
 }
 
+/* Feeds the entries a replay trace is built from to the exporter */
+static void
+export_entry (ReplayExport *ex, int type, void *data)
+{
+	switch (TYPE (type)) {
+	case PROTOCOL_ID (binary_protocol_alloc): {
+		PROTOCOL_STRUCT (binary_protocol_alloc) *entry = (PROTOCOL_STRUCT (binary_protocol_alloc)*)data;
+		replay_export_alloc (ex, (umword) entry->obj, (umword) entry->size, FALSE);
+		break;
+	}
+	case PROTOCOL_ID (binary_protocol_alloc_degraded): {
+		PROTOCOL_STRUCT (binary_protocol_alloc_degraded) *entry = (PROTOCOL_STRUCT (binary_protocol_alloc_degraded)*)data;
+		replay_export_alloc (ex, (umword) entry->obj, (umword) entry->size, FALSE);
+		break;
+	}
+	case PROTOCOL_ID (binary_protocol_alloc_pinned): {
+		PROTOCOL_STRUCT (binary_protocol_alloc_pinned) *entry = (PROTOCOL_STRUCT (binary_protocol_alloc_pinned)*)data;
+		replay_export_alloc (ex, (umword) entry->obj, (umword) entry->size, TRUE);
+		break;
+	}
+	case PROTOCOL_ID (binary_protocol_copy): {
+		PROTOCOL_STRUCT (binary_protocol_copy) *entry = (PROTOCOL_STRUCT (binary_protocol_copy)*)data;
+		replay_export_copy (ex, (umword) entry->from, (umword) entry->to);
+		break;
+	}
+	case PROTOCOL_ID (binary_protocol_wbarrier): {
+		PROTOCOL_STRUCT (binary_protocol_wbarrier) *entry = (PROTOCOL_STRUCT (binary_protocol_wbarrier)*)data;
+		replay_export_store (ex, (umword) entry->ptr, (umword) entry->value);
+		break;
+	}
+	case PROTOCOL_ID (binary_protocol_mark): {
+		PROTOCOL_STRUCT (binary_protocol_mark) *entry = (PROTOCOL_STRUCT (binary_protocol_mark)*)data;
+		replay_export_touch (ex, (umword) entry->obj);
+		break;
+	}
+	case PROTOCOL_ID (binary_protocol_pin): {
+		PROTOCOL_STRUCT (binary_protocol_pin) *entry = (PROTOCOL_STRUCT (binary_protocol_pin)*)data;
+		replay_export_touch (ex, (umword) entry->obj);
+		break;
+	}
+	case PROTOCOL_ID (binary_protocol_collection_requested): {
+		PROTOCOL_STRUCT (binary_protocol_collection_requested) *entry = (PROTOCOL_STRUCT (binary_protocol_collection_requested)*)data;
+		/* Only the program's own GC.Collect () calls, the rest is up to the replaying collector */
+		if (entry->force)
+			replay_export_collect (ex, entry->generation);
+		break;
+	}
+	}
+}
+
 #undef TYPE_INT
 #undef TYPE_LONGLONG
 #undef TYPE_SIZE
@@ -617,7 +670,8 @@ sgen_binary_protocol_read_header (EntryStream *stream)
 
 gboolean
 GREP_ENTRIES_FUNCTION_NAME (EntryStream *stream, int num_nums, long nums [], int num_vtables, long vtables [],
-			gboolean dump_all, gboolean pause_times, gboolean color_output, unsigned long long first_entry_to_consider)
+			gboolean dump_all, gboolean pause_times, gboolean color_output, unsigned long long first_entry_to_consider,
+			ReplayExport *replay_export)
 {
 	int type;
 	unsigned char worker_index;
@@ -632,11 +686,16 @@ GREP_ENTRIES_FUNCTION_NAME (EntryStream *stream, int num_nums, long nums [], int
 	if (!sgen_binary_protocol_read_header (stream))
 		return FALSE;
 
+	if (replay_export)
+		replay_export_set_ptr_size (replay_export, BINPROT_SIZEOF_VOID_P);
+
 	entry_index = 0;
 	while ((type = read_entry (stream, data, &worker_index)) != SGEN_PROTOCOL_EOF) {
 		if (entry_index < first_entry_to_consider)
 			goto next_entry;
-		if (pause_times) {
+		if (replay_export) {
+			export_entry (replay_export, type, data);
+		} else if (pause_times) {
 			switch (type) {
 			case PROTOCOL_ID (binary_protocol_world_stopping): {
 				PROTOCOL_STRUCT (binary_protocol_world_stopping) *entry = (PROTOCOL_STRUCT (binary_protocol_world_stopping)*)data;
@@ -0,0 +1,340 @@
+/*
+ * sgen-replay-export.c: Conversion of binary protocol traces to replay traces
+ *
+ * Licensed under the MIT license. See LICENSE file in the project root for full license information.
+ */
+
+/*
+ * A replay trace is the allocation and pointer store history of a program
+ * with the addresses replaced by object indices, so it can be re-executed
+ * by mono/benchmark/gc-replay.exe under any collector configuration.  It's
+ * a text file:
+ *
+ *	sgen-replay 1 <pointer size> <number of objects>
+ *	a <object> <size> <r|b|p>		allocation of an object with references, without, or pinned
+ *	s <object> <offset> <object|->		store of a reference, or null, into a field
+ *	c <generation>				explicitly requested collection
+ *	f <object>				the object is not referenced from roots anymore
+ *
+ * The binary protocol doesn't record roots, so an object is considered rooted
+ * from its allocation up to the last entry that mentions it, which is where
+ * the 'f' is written.  Objects reachable from other objects stay alive after
+ * that through the replayed stores.
+ *
+ * Allocations and stores are heavy entries, the trace has to be captured with a
+ * runtime built with SGEN_HEAVY_BINARY_PROTOCOL.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <glib.h>
+#include "sgen-replay-export.h"
+
+/* Objects are indexed by the 4k chunks of address space they overlap */
+#define CHUNK_BITS 12
+
+#define NO_OBJECT G_MAXUINT32
+
+typedef struct {
+	guint64 addr;
+	guint64 size;
+	/* Index of the last event emitted while the object was mentioned */
+	guint32 last_use;
+	guint8 has_refs;
+	guint8 pinned;
+} ReplayObject;
+
+typedef struct {
+	char kind;
+	guint32 obj;
+	guint64 arg;
+	guint32 value;
+} ReplayEvent;
+
+struct _ReplayExport {
+	int ptr_size;
+	GArray *objects;
+	GArray *events;
+	GHashTable *chunks;
+};
+
+ReplayExport *
+replay_export_new (void)
+{
+	ReplayExport *ex = g_new0 (ReplayExport, 1);
+
+	ex->ptr_size = sizeof (gpointer);
+	ex->objects = g_array_new (FALSE, FALSE, sizeof (ReplayObject));
+	ex->events = g_array_new (FALSE, FALSE, sizeof (ReplayEvent));
+	ex->chunks = g_hash_table_new (NULL, NULL);
+	return ex;
+}
+
+static void
+free_chunk (gpointer key, gpointer value, gpointer user_data)
+{
+	g_slist_free ((GSList *) value);
+}
+
+void
+replay_export_free (ReplayExport *ex)
+{
+	g_hash_table_foreach (ex->chunks, free_chunk, NULL);
+	g_hash_table_destroy (ex->chunks);
+	g_array_free (ex->objects, TRUE);
+	g_array_free (ex->events, TRUE);
+	g_free (ex);
+}
+
+void
+replay_export_set_ptr_size (ReplayExport *ex, int ptr_size)
+{
+	ex->ptr_size = ptr_size;
+}
+
+static ReplayObject *
+get_object (ReplayExport *ex, guint32 id)
+{
+	return &g_array_index (ex->objects, ReplayObject, id);
+}
+
+/* Keys are truncated on 32 bit hosts, which only costs some list walking */
+static gpointer
+chunk_key (guint64 addr)
+{
+	return GUINT_TO_POINTER (addr >> CHUNK_BITS);
+}
+
+static guint64
+last_chunk (ReplayObject *obj)
+{
+	return (obj->addr + MAX (obj->size, 1) - 1) >> CHUNK_BITS;
+}
+
+static void
+index_insert (ReplayExport *ex, guint32 id)
+{
+	ReplayObject *obj = get_object (ex, id);
+	guint64 c;
+
+	for (c = obj->addr >> CHUNK_BITS; c <= last_chunk (obj); ++c) {
+		gpointer key = GUINT_TO_POINTER (c);
+		GSList *list = (GSList *) g_hash_table_lookup (ex->chunks, key);
+		g_hash_table_insert (ex->chunks, key, g_slist_prepend (list, GUINT_TO_POINTER (id)));
+	}
+}
+
+static void
+index_remove (ReplayExport *ex, guint32 id)
+{
+	ReplayObject *obj = get_object (ex, id);
+	guint64 c;
+
+	for (c = obj->addr >> CHUNK_BITS; c <= last_chunk (obj); ++c) {
+		gpointer key = GUINT_TO_POINTER (c);
+		GSList *list = (GSList *) g_hash_table_lookup (ex->chunks, key);
+
+		list = g_slist_remove (list, GUINT_TO_POINTER (id));
+		if (list)
+			g_hash_table_insert (ex->chunks, key, list);
+		else
+			g_hash_table_remove (ex->chunks, key);
+	}
+}
+
+/* Returns the object containing ADDR, or NO_OBJECT */
+static guint32
+index_find (ReplayExport *ex, guint64 addr)
+{
+	GSList *l;
+
+	for (l = (GSList *) g_hash_table_lookup (ex->chunks, chunk_key (addr)); l; l = l->next) {
+		guint32 id = GPOINTER_TO_UINT (l->data);
+		ReplayObject *obj = get_object (ex, id);
+
+		if (addr >= obj->addr && addr < obj->addr + obj->size)
+			return id;
+	}
+	return NO_OBJECT;
+}
+
+static guint32
+index_find_start (ReplayExport *ex, guint64 addr)
+{
+	guint32 id = addr ? index_find (ex, addr) : NO_OBJECT;
+
+	if (id != NO_OBJECT && get_object (ex, id)->addr != addr)
+		return NO_OBJECT;
+	return id;
+}
+
+/*
+ * Nursery objects die without an entry, their memory is just reused.  Anything
+ * still indexed where a new object is placed must be dead by now.
+ */
+static void
+index_evict (ReplayExport *ex, guint64 addr, guint64 size)
+{
+	guint64 c;
+
+	for (c = addr >> CHUNK_BITS; c <= (addr + MAX (size, 1) - 1) >> CHUNK_BITS; ++c) {
+		GSList *l = (GSList *) g_hash_table_lookup (ex->chunks, GUINT_TO_POINTER (c));
+
+		while (l) {
+			guint32 id = GPOINTER_TO_UINT (l->data);
+			ReplayObject *obj = get_object (ex, id);
+
+			/* Only the node of the removed object is freed */
+			l = l->next;
+			if (obj->addr < addr + size && addr < obj->addr + obj->size)
+				index_remove (ex, id);
+		}
+	}
+}
+
+static void
+touch_object (ReplayExport *ex, guint32 id)
+{
+	if (id != NO_OBJECT && ex->events->len)
+		get_object (ex, id)->last_use = ex->events->len - 1;
+}
+
+static void
+add_event (ReplayExport *ex, char kind, guint32 obj, guint64 arg, guint32 value)
+{
+	ReplayEvent ev;
+
+	ev.kind = kind;
+	ev.obj = obj;
+	ev.arg = arg;
+	ev.value = value;
+	g_array_append_val (ex->events, ev);
+}
+
+void
+replay_export_alloc (ReplayExport *ex, guint64 addr, guint64 size, gboolean pinned)
+{
+	ReplayObject obj;
+	guint32 id = ex->objects->len;
+
+	index_evict (ex, addr, size);
+
+	obj.addr = addr;
+	obj.size = size;
+	obj.last_use = 0;
+	obj.has_refs = FALSE;
+	obj.pinned = pinned;
+	g_array_append_val (ex->objects, obj);
+	index_insert (ex, id);
+
+	add_event (ex, 'a', id, size, NO_OBJECT);
+	touch_object (ex, id);
+}
+
+void
+replay_export_copy (ReplayExport *ex, guint64 from, guint64 to)
+{
+	guint32 id = index_find_start (ex, from);
+	ReplayObject *obj;
+
+	if (id == NO_OBJECT)
+		return;
+
+	obj = get_object (ex, id);
+	index_remove (ex, id);
+	index_evict (ex, to, obj->size);
+	obj->addr = to;
+	index_insert (ex, id);
+	touch_object (ex, id);
+}
+
+void
+replay_export_touch (ReplayExport *ex, guint64 addr)
+{
+	touch_object (ex, index_find_start (ex, addr));
+}
+
+void
+replay_export_store (ReplayExport *ex, guint64 ptr, guint64 value)
+{
+	guint32 id = index_find (ex, ptr);
+	guint32 value_id = index_find_start (ex, value);
+	ReplayObject *obj;
+
+	/* Stores into roots or objects allocated before the trace started */
+	if (id == NO_OBJECT) {
+		touch_object (ex, value_id);
+		return;
+	}
+
+	obj = get_object (ex, id);
+	obj->has_refs = TRUE;
+	add_event (ex, 's', id, ptr - obj->addr, value_id);
+	touch_object (ex, id);
+	touch_object (ex, value_id);
+}
+
+void
+replay_export_collect (ReplayExport *ex, int generation)
+{
+	add_event (ex, 'c', NO_OBJECT, generation, NO_OBJECT);
+}
+
+static int
+compare_last_use (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+	ReplayExport *ex = (ReplayExport *) user_data;
+	guint32 ua = get_object (ex, *(const guint32 *) a)->last_use;
+	guint32 ub = get_object (ex, *(const guint32 *) b)->last_use;
+
+	return ua < ub ? -1 : ua > ub ? 1 : 0;
+}
+
+gboolean
+replay_export_write (ReplayExport *ex, FILE *out)
+{
+	guint32 *by_last_use;
+	guint32 i, next_free = 0;
+	guint32 num_objects = ex->objects->len;
+
+	if (!num_objects) {
+		fprintf (stderr, "No allocations in the trace. The runtime has to be built with SGEN_HEAVY_BINARY_PROTOCOL.\n");
+		return FALSE;
+	}
+
+	by_last_use = g_new (guint32, num_objects);
+	for (i = 0; i < num_objects; ++i)
+		by_last_use [i] = i;
+	g_qsort_with_data (by_last_use, num_objects, sizeof (guint32), compare_last_use, ex);
+
+	fprintf (out, "sgen-replay 1 %d %u\n", ex->ptr_size, num_objects);
+	for (i = 0; i < ex->events->len; ++i) {
+		ReplayEvent *ev = &g_array_index (ex->events, ReplayEvent, i);
+
+		switch (ev->kind) {
+		case 'a': {
+			ReplayObject *obj = get_object (ex, ev->obj);
+			fprintf (out, "a %u %llu %c\n", ev->obj, (unsigned long long) ev->arg,
+				obj->pinned ? 'p' : obj->has_refs ? 'r' : 'b');
+			break;
+		}
+		case 's':
+			if (ev->value == NO_OBJECT)
+				fprintf (out, "s %u %llu -\n", ev->obj, (unsigned long long) ev->arg);
+			else
+				fprintf (out, "s %u %llu %u\n", ev->obj, (unsigned long long) ev->arg, ev->value);
+			break;
+		case 'c':
+			fprintf (out, "c %llu\n", (unsigned long long) ev->arg);
+			break;
+		default:
+			g_assert_not_reached ();
+		}
+
+		while (next_free < num_objects && get_object (ex, by_last_use [next_free])->last_use == i)
+			fprintf (out, "f %u\n", by_last_use [next_free++]);
+	}
+
+	g_free (by_last_use);
+	return TRUE;
+}
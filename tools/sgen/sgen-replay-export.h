@@ -0,0 +1,19 @@
+/*
+ * sgen-replay-export.h: Conversion of binary protocol traces to replay traces
+ *
+ * Licensed under the MIT license. See LICENSE file in the project root for full license information.
+ */
+
+typedef struct _ReplayExport ReplayExport;
+
+ReplayExport *replay_export_new (void);
+void replay_export_free (ReplayExport *ex);
+
+void replay_export_set_ptr_size (ReplayExport *ex, int ptr_size);
+void replay_export_alloc (ReplayExport *ex, guint64 addr, guint64 size, gboolean pinned);
+void replay_export_copy (ReplayExport *ex, guint64 from, guint64 to);
+void replay_export_touch (ReplayExport *ex, guint64 addr);
+void replay_export_store (ReplayExport *ex, guint64 ptr, guint64 value);
+void replay_export_collect (ReplayExport *ex, int generation);
+
+gboolean replay_export_write (ReplayExport *ex, FILE *out);
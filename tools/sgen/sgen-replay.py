@@ -0,0 +1,121 @@
+#!/usr/bin/env python
+#
+# Replays a heap trace under a set of sgen configurations and compares their
+# pause times.
+#
+# The trace is captured from the real program with a runtime built with
+# SGEN_HEAVY_BINARY_PROTOCOL:
+#
+#   MONO_GC_DEBUG=binary-protocol=/tmp/app.binprot mono app.exe
+#   sgen-grep-binprot --export-replay -i /tmp/app.binprot > app.replay
+#
+# and then replayed by mono/benchmark/gc-replay.exe, which only needs a
+# regular runtime:
+#
+#   sgen-replay.py --config nursery-size=4m --config nursery-size=32m --workers 1 --workers 4 app.replay
+#
+from __future__ import print_function
+import json
+import os
+import subprocess
+import sys
+import tempfile
+from optparse import OptionParser
+
+DEFAULT_CONFIGS = [
+    '',
+    'nursery-size=16m',
+    'nursery-size=64m',
+    'major=marksweep-conc',
+    'major=marksweep-conc-par,minor=simple-par',
+]
+
+parser = OptionParser (usage = "Usage: %prog [options] TRACE")
+parser.add_option ('--mono', dest = 'mono', default = 'mono', help = "runtime to replay with")
+parser.add_option ('--replayer', dest = 'replayer', help = "path of gc-replay.exe")
+parser.add_option ('--config', action = 'append', dest = 'configs', help = "MONO_GC_PARAMS to replay with, can be repeated")
+parser.add_option ('--workers', action = 'append', type = 'int', dest = 'workers', help = "restrict the runtime to N cpus, which bounds the number of GC workers, can be repeated")
+parser.add_option ('--iterations', type = 'int', dest = 'iterations', default = 5, help = "replays of the trace per configuration")
+parser.add_option ('--json', action = 'store_true', dest = 'json', help = "print one JSON object per configuration")
+(options, files) = parser.parse_args ()
+
+if len (files) != 1:
+    parser.print_help ()
+    sys.exit (1)
+
+script_dir = os.path.dirname (os.path.realpath (__file__))
+sgen_grep_path = os.path.join (script_dir, 'sgen-grep-binprot')
+replayer = options.replayer or os.path.join (script_dir, '..', '..', 'mono', 'benchmark', 'gc-replay.exe')
+
+for path in [sgen_grep_path, replayer]:
+    if not os.path.isfile (path):
+        sys.stderr.write ('Error: `%s` does not exist.\n' % path)
+        sys.exit (1)
+
+configs = options.configs or DEFAULT_CONFIGS
+workers = options.workers or [None]
+
+def percentile (values, p):
+    if not values:
+        return 0
+    values = sorted (values)
+    return values [max (int (-(-p * len (values) // 100)), 1) - 1]
+
+def pause_times (binprot):
+    minor = []
+    major = []
+    proc = subprocess.Popen ([sgen_grep_path, '--pause-times', '-i', binprot], stdout = subprocess.PIPE, universal_newlines = True)
+    for line in proc.stdout:
+        fields = line.split ()
+        if len (fields) != 6 or fields [0] != 'pause-time':
+            continue
+        # Timestamps are in 100ns ticks
+        msecs = int (fields [4]) / 10000.0
+        (major if int (fields [1]) else minor).append (msecs)
+    proc.wait ()
+    return (minor, major)
+
+def replay (config, cpus):
+    (fd, binprot) = tempfile.mkstemp (suffix = '.binprot')
+    os.close (fd)
+    env = dict (os.environ)
+    env ['MONO_GC_PARAMS'] = config
+    env ['MONO_GC_DEBUG'] = 'binary-protocol=' + binprot
+    cmd = [options.mono, replayer, files [0], '--warmup', '0', '--iterations', str (options.iterations), '--mode', config or 'default']
+    if cpus:
+        # mono_cpu_count () respects the affinity mask
+        cmd = ['taskset', '-c', '0-%d' % (cpus - 1)] + cmd
+    try:
+        output = subprocess.check_output (cmd, env = env, universal_newlines = True)
+        result = json.loads (output.strip ().splitlines () [-1])
+        (minor, major) = pause_times (binprot)
+    finally:
+        os.remove (binprot)
+
+    return {
+        'config': config,
+        'cpus': cpus,
+        'replay_p50_ms': result ['p50_ns'] / 1e6,
+        'minor_count': len (minor),
+        'minor_p50_ms': percentile (minor, 50),
+        'minor_p99_ms': percentile (minor, 99),
+        'minor_max_ms': max (minor or [0]),
+        'major_count': len (major),
+        'major_p50_ms': percentile (major, 50),
+        'major_max_ms': max (major or [0]),
+        'total_pause_ms': sum (minor) + sum (major),
+    }
+
+if not options.json:
+    print ('%-45s %5s %10s %6s %8s %8s %8s %6s %8s %8s %10s' % ('config', 'cpus', 'replay ms', 'minor', 'p50', 'p99', 'max', 'major', 'p50', 'max', 'total ms'))
+
+for config in configs:
+    for cpus in workers:
+        r = replay (config, cpus)
+        if options.json:
+            print (json.dumps (r, sort_keys = True))
+        else:
+            print ('%-45s %5s %10.1f %6d %8.2f %8.2f %8.2f %6d %8.2f %8.2f %10.1f' % (
+                config or '(default)', cpus or '-', r ['replay_p50_ms'],
+                r ['minor_count'], r ['minor_p50_ms'], r ['minor_p99_ms'], r ['minor_max_ms'],
+                r ['major_count'], r ['major_p50_ms'], r ['major_max_ms'], r ['total_pause_ms']))